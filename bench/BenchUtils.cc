@@ -9,14 +9,26 @@
 #include "./BenchUtils.h"
 
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
 #include <cstring>
+#include <fstream>
 #include <random>
+#include <sstream>
 #include <type_traits>
 
 #ifdef _OPENMP
 #include <omp.h>
 #endif
 
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 namespace fbgemm {
 
 std::default_random_engine eng;
@@ -123,6 +135,594 @@ bool parseArgumentBool(
   return def_val;
 }
 
+std::string parseArgumentString(
+    int argc,
+    const char* argv[],
+    const char* arg,
+    const std::string& def_val) {
+  const int arg_len = strlen(arg);
+  for (auto i = 1; i < argc; ++i) {
+    if (strncmp(argv[i], arg, arg_len) == 0) {
+      return argv[i] + arg_len;
+    }
+  }
+  return def_val;
+}
+
+std::vector<std::vector<int>> readShapesFromFile(
+    const std::string& path,
+    int num_dims) {
+  std::ifstream in(path);
+  if (!in) {
+    fprintf(stderr, "Cannot read shapes from %s\n", path.c_str());
+    exit(1);
+  }
+  std::vector<std::vector<int>> shapes;
+  std::string line;
+  for (int line_num = 1; std::getline(in, line); ++line_num) {
+    const auto first = line.find_first_not_of(" \t\r");
+    if (first == std::string::npos || line[first] == '#') {
+      continue;
+    }
+    std::replace(line.begin(), line.end(), ',', ' ');
+    std::istringstream fields(line);
+    std::vector<int> shape;
+    int dim = 0;
+    while (fields >> dim) {
+      shape.push_back(dim);
+    }
+    if (!fields.eof() || static_cast<int>(shape.size()) != num_dims) {
+      fprintf(
+          stderr,
+          "%s:%d: expected %d integers per shape\n",
+          path.c_str(),
+          line_num,
+          num_dims);
+      exit(1);
+    }
+    shapes.push_back(std::move(shape));
+  }
+  return shapes;
+}
+
+std::vector<std::vector<int>> parseArgumentShapes(
+    int argc,
+    const char* argv[],
+    int num_dims,
+    const std::vector<std::vector<int>>& def_shapes) {
+  const std::string path = parseArgumentString(argc, argv, "--shapes=", "");
+  return path.empty() ? def_shapes : readShapesFromFile(path, num_dims);
+}
+
+const char* instSetName(inst_set_t isa) {
+  switch (isa) {
+    case inst_set_t::avx2:
+      return "AVX2";
+    case inst_set_t::avx512:
+      return "AVX512";
+    case inst_set_t::avx512_ymm:
+      return "AVX512_256";
+    case inst_set_t::avx512_vnni:
+      return "AVX512_E1";
+    case inst_set_t::avx512_vnni_ymm:
+      return "AVX512_E1_256";
+    default:
+      return "ANYARCH";
+  }
+}
+
+namespace {
+
+std::string jsonString(const std::string& s) {
+  std::string res = "\"";
+  for (const char c : s) {
+    if (c == '"' || c == '\\') {
+      res += '\\';
+    }
+    res += c;
+  }
+  return res + "\"";
+}
+
+// Nearest-rank percentile of sorted samples
+double percentile(const std::vector<double>& sorted, double p) {
+  const auto rank = static_cast<size_t>(std::ceil(p / 100.0 * sorted.size()));
+  return sorted[std::max<size_t>(rank, 1) - 1];
+}
+
+} // namespace
+
+#ifdef __linux__
+namespace {
+
+int openPerfEvent(std::uint32_t type, std::uint64_t config) {
+  perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = type;
+  attr.config = config;
+  attr.disabled = 1;
+  attr.inherit = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  return static_cast<int>(syscall(
+      __NR_perf_event_open, &attr, /*pid=*/0, /*cpu=*/-1, /*group_fd=*/-1, 0));
+}
+
+constexpr std::uint64_t cacheReadMiss(std::uint64_t cache) {
+  return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+}
+
+} // namespace
+#endif
+
+PerfCounters::PerfCounters(bool enabled) {
+  if (!enabled) {
+    return;
+  }
+#ifdef __linux__
+  const std::pair<const char*, std::pair<std::uint32_t, std::uint64_t>>
+      events[] = {
+          {"cycles", {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES}},
+          {"instructions", {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS}},
+          {"llc_load_misses",
+           {PERF_TYPE_HW_CACHE, cacheReadMiss(PERF_COUNT_HW_CACHE_LL)}},
+          {"dtlb_load_misses",
+           {PERF_TYPE_HW_CACHE, cacheReadMiss(PERF_COUNT_HW_CACHE_DTLB)}},
+      };
+  for (const auto& [name, event] : events) {
+    const int fd = openPerfEvent(event.first, event.second);
+    if (fd >= 0) {
+      fds_.emplace_back(name, fd);
+    } else {
+      fprintf(stderr, "perf counter %s is not available\n", name);
+    }
+  }
+#else
+  fprintf(stderr, "perf counters are only available on Linux\n");
+#endif
+}
+
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+  for (const auto& fd : fds_) {
+    close(fd.second);
+  }
+#endif
+}
+
+bool PerfCounters::enabled() const {
+  return !fds_.empty();
+}
+
+void PerfCounters::start() {
+#ifdef __linux__
+  for (const auto& fd : fds_) {
+    ioctl(fd.second, PERF_EVENT_IOC_ENABLE, 0);
+  }
+#endif
+}
+
+void PerfCounters::stop() {
+#ifdef __linux__
+  for (const auto& fd : fds_) {
+    ioctl(fd.second, PERF_EVENT_IOC_DISABLE, 0);
+  }
+#endif
+}
+
+void PerfCounters::reset() {
+#ifdef __linux__
+  for (const auto& fd : fds_) {
+    ioctl(fd.second, PERF_EVENT_IOC_RESET, 0);
+  }
+#endif
+}
+
+std::vector<std::pair<std::string, double>> PerfCounters::read() const {
+  std::vector<std::pair<std::string, double>> counts;
+#ifdef __linux__
+  for (const auto& [name, fd] : fds_) {
+    std::uint64_t count = 0;
+    if (::read(fd, &count, sizeof(count)) == sizeof(count)) {
+      counts.emplace_back(name, static_cast<double>(count));
+    }
+  }
+#endif
+  return counts;
+}
+
+BenchmarkReporter::BenchmarkReporter(
+    std::string benchmark,
+    int argc,
+    const char* argv[])
+    : benchmark_(std::move(benchmark)) {
+  const std::string path = parseArgumentString(argc, argv, "--json=", "");
+  if (path == "-") {
+    out_ = stdout;
+  } else if (!path.empty()) {
+    out_ = fopen(path.c_str(), "a");
+    if (out_ == nullptr) {
+      fprintf(stderr, "Cannot open %s\n", path.c_str());
+      exit(1);
+    }
+  }
+}
+
+BenchmarkReporter::~BenchmarkReporter() {
+  if (out_ != nullptr && out_ != stdout) {
+    fclose(out_);
+  }
+}
+
+void BenchmarkReporter::report(const BenchmarkRecord& record) {
+  if (out_ == nullptr || record.seconds.empty()) {
+    return;
+  }
+  std::vector<double> sorted = record.seconds;
+  std::sort(sorted.begin(), sorted.end());
+  double mean = 0.0;
+  for (const double t : sorted) {
+    mean += t;
+  }
+  mean /= sorted.size();
+
+  std::ostringstream json;
+  json << "{\"benchmark\":" << jsonString(benchmark_)
+       << ",\"kernel\":" << jsonString(record.kernel) << ",\"shape\":{";
+  for (size_t i = 0; i < record.shape.size(); ++i) {
+    json << (i ? "," : "") << jsonString(record.shape[i].first) << ":"
+         << record.shape[i].second;
+  }
+  json << "},\"isa\":" << jsonString(instSetName(fbgemmInstructionSet()))
+       << ",\"threads\":" << record.threads
+       << ",\"iterations\":" << sorted.size() << ",\"mean_us\":" << mean * 1e6
+       << ",\"p50_us\":" << percentile(sorted, 50) * 1e6
+       << ",\"p90_us\":" << percentile(sorted, 90) * 1e6
+       << ",\"p99_us\":" << percentile(sorted, 99) * 1e6
+       << ",\"min_us\":" << sorted.front() * 1e6
+       << ",\"max_us\":" << sorted.back() * 1e6;
+  if (record.flops > 0.0) {
+    json << ",\"gflops\":" << record.flops / mean / 1e9;
+  }
+  if (record.bytes > 0.0) {
+    json << ",\"gbs\":" << record.bytes / mean / 1e9;
+  }
+  if (record.attainable_gflops > 0.0) {
+    json << ",\"attainable_gflops\":" << record.attainable_gflops;
+    if (record.flops > 0.0) {
+      json << ",\"roofline_fraction\":"
+           << record.flops / mean / 1e9 / record.attainable_gflops;
+    }
+  }
+  if (!record.counters.empty()) {
+    json << ",\"counters\":{";
+    double cycles = 0.0, instructions = 0.0, llc_misses = -1.0;
+    for (size_t i = 0; i < record.counters.size(); ++i) {
+      const auto& [name, count] = record.counters[i];
+      json << (i ? "," : "") << jsonString(name) << ":"
+           << count / sorted.size();
+      if (name == "cycles") {
+        cycles = count;
+      } else if (name == "instructions") {
+        instructions = count;
+      } else if (name == "llc_load_misses") {
+        llc_misses = count;
+      }
+    }
+    json << "}";
+    if (cycles > 0.0 && instructions > 0.0) {
+      json << ",\"ipc\":" << instructions / cycles;
+    }
+    if (llc_misses >= 0.0) {
+      json << ",\"llc_miss_gbs\":"
+           << llc_misses / sorted.size() * 64.0 / mean / 1e9;
+    }
+  }
+  json << "}\n";
+  fputs(json.str().c_str(), out_);
+  fflush(out_);
+}
+
+namespace {
+
+#if defined(__GNUC__) && defined(__AVX2__) && defined(__FMA__)
+#define FBGEMM_BENCH_PEAKS
+
+// The benchmarks are built for AVX2, so the AVX512 code is enabled per
+// function
+#define FBGEMM_BENCH_TARGET_AVX512 __attribute__((target("avx512f,avx512bw")))
+#define FBGEMM_BENCH_TARGET_AVX512_VNNI \
+  __attribute__((target("avx512f,avx512bw,avx512vl,avx512vnni")))
+
+// Iterations of a peak kernel per thread and run, tens of ms
+constexpr std::int64_t kPeakIters = std::int64_t(1) << 22;
+// Independent accumulators, enough to hide the latency of multiply-adds
+// issued on two ports
+constexpr int kFmaChains = 12;
+// The int8 sequences without VNNI only depend on the previous iteration
+// through a 1-cycle add
+constexpr int kInt8Chains = 4;
+
+// The loops over chains below are unrolled to keep the accumulators in
+// registers.
+// Keeps the compiler from hoisting loop-invariant computations on v
+template <typename T>
+inline void opaque(T& v) {
+  asm volatile("" : "+x"(v));
+}
+
+float fp32PeakAvx2(std::int64_t iters) {
+  const __m256 a = _mm256_set1_ps(0.999f);
+  const __m256 b = _mm256_set1_ps(0.001f);
+  __m256 acc[kFmaChains];
+  for (int c = 0; c < kFmaChains; ++c) {
+    acc[c] = _mm256_set1_ps(c);
+  }
+  for (std::int64_t i = 0; i < iters; ++i) {
+#pragma GCC unroll 16
+    for (int c = 0; c < kFmaChains; ++c) {
+      acc[c] = _mm256_fmadd_ps(acc[c], a, b);
+    }
+  }
+  float sum = 0.0f;
+  for (int c = 0; c < kFmaChains; ++c) {
+    sum += _mm256_cvtss_f32(acc[c]);
+  }
+  return sum;
+}
+
+FBGEMM_BENCH_TARGET_AVX512 float fp32PeakAvx512(std::int64_t iters) {
+  const __m512 a = _mm512_set1_ps(0.999f);
+  const __m512 b = _mm512_set1_ps(0.001f);
+  __m512 acc[kFmaChains];
+  for (int c = 0; c < kFmaChains; ++c) {
+    acc[c] = _mm512_set1_ps(c);
+  }
+  for (std::int64_t i = 0; i < iters; ++i) {
+#pragma GCC unroll 16
+    for (int c = 0; c < kFmaChains; ++c) {
+      acc[c] = _mm512_fmadd_ps(acc[c], a, b);
+    }
+  }
+  float sum = 0.0f;
+  for (int c = 0; c < kFmaChains; ++c) {
+    sum += _mm512_cvtss_f32(acc[c]);
+  }
+  return sum;
+}
+
+float int8PeakAvx2(std::int64_t iters) {
+  const __m256i b = _mm256_set1_epi8(1);
+  const __m256i ones = _mm256_set1_epi16(1);
+  __m256i a[kInt8Chains], acc[kInt8Chains];
+  for (int c = 0; c < kInt8Chains; ++c) {
+    a[c] = _mm256_set1_epi8(c);
+    acc[c] = _mm256_setzero_si256();
+  }
+  for (std::int64_t i = 0; i < iters; ++i) {
+#pragma GCC unroll 16
+    for (int c = 0; c < kInt8Chains; ++c) {
+      opaque(a[c]);
+      acc[c] = _mm256_add_epi32(
+          acc[c], _mm256_madd_epi16(_mm256_maddubs_epi16(a[c], b), ones));
+    }
+  }
+  int sum = 0;
+  for (int c = 0; c < kInt8Chains; ++c) {
+    sum += _mm256_cvtsi256_si32(acc[c]);
+  }
+  return sum;
+}
+
+FBGEMM_BENCH_TARGET_AVX512 float int8PeakAvx512(std::int64_t iters) {
+  const __m512i b = _mm512_set1_epi8(1);
+  const __m512i ones = _mm512_set1_epi16(1);
+  __m512i a[kInt8Chains], acc[kInt8Chains];
+  for (int c = 0; c < kInt8Chains; ++c) {
+    a[c] = _mm512_set1_epi8(c);
+    acc[c] = _mm512_setzero_si512();
+  }
+  for (std::int64_t i = 0; i < iters; ++i) {
+#pragma GCC unroll 16
+    for (int c = 0; c < kInt8Chains; ++c) {
+      opaque(a[c]);
+      acc[c] = _mm512_add_epi32(
+          acc[c], _mm512_madd_epi16(_mm512_maddubs_epi16(a[c], b), ones));
+    }
+  }
+  int sum = 0;
+  for (int c = 0; c < kInt8Chains; ++c) {
+    sum += _mm512_cvtsi512_si32(acc[c]);
+  }
+  return sum;
+}
+
+FBGEMM_BENCH_TARGET_AVX512_VNNI float int8PeakVnniYmm(std::int64_t iters) {
+  const __m256i a = _mm256_set1_epi8(1);
+  const __m256i b = _mm256_set1_epi8(1);
+  __m256i acc[kFmaChains];
+  for (int c = 0; c < kFmaChains; ++c) {
+    acc[c] = _mm256_set1_epi32(c);
+  }
+  for (std::int64_t i = 0; i < iters; ++i) {
+#pragma GCC unroll 16
+    for (int c = 0; c < kFmaChains; ++c) {
+      acc[c] = _mm256_dpbusd_epi32(acc[c], a, b);
+    }
+  }
+  int sum = 0;
+  for (int c = 0; c < kFmaChains; ++c) {
+    sum += _mm256_cvtsi256_si32(acc[c]);
+  }
+  return sum;
+}
+
+FBGEMM_BENCH_TARGET_AVX512_VNNI float int8PeakVnni(std::int64_t iters) {
+  const __m512i a = _mm512_set1_epi8(1);
+  const __m512i b = _mm512_set1_epi8(1);
+  __m512i acc[kFmaChains];
+  for (int c = 0; c < kFmaChains; ++c) {
+    acc[c] = _mm512_set1_epi32(c);
+  }
+  for (std::int64_t i = 0; i < iters; ++i) {
+#pragma GCC unroll 16
+    for (int c = 0; c < kFmaChains; ++c) {
+      acc[c] = _mm512_dpbusd_epi32(acc[c], a, b);
+    }
+  }
+  int sum = 0;
+  for (int c = 0; c < kFmaChains; ++c) {
+    sum += _mm512_cvtsi512_si32(acc[c]);
+  }
+  return sum;
+}
+
+// G ops/s of kernel on num_threads threads, best of a few runs
+double measurePeakGops(
+    float (*kernel)(std::int64_t),
+    double ops_per_iter,
+    int num_threads) {
+  double best = 0.0;
+  volatile float sink = 0.0f;
+  for (int run = 0; run < 3; ++run) {
+    float checksum = 0.0f;
+    const auto start = std::chrono::steady_clock::now();
+#ifdef _OPENMP
+#pragma omp parallel num_threads(num_threads) reduction(+ : checksum)
+#endif
+    checksum += kernel(kPeakIters);
+    const std::chrono::duration<double> dur =
+        std::chrono::steady_clock::now() - start;
+    sink = sink + checksum;
+    best = std::max(
+        best, ops_per_iter * kPeakIters * num_threads / dur.count() / 1e9);
+  }
+  return best;
+}
+#endif // __GNUC__ && __AVX2__ && __FMA__
+
+// STREAM triad a = b + s * c in GB/s on num_threads threads, counting the
+// bytes read and written by the loop (not the write allocation of a)
+double measureTriadGbs(int num_threads) {
+  // 3 x 128 MB, well beyond the LLC of current servers
+  constexpr std::int64_t n = std::int64_t(1) << 25;
+  float* a = static_cast<float*>(fbgemmAlignedAlloc(64, n * sizeof(float)));
+  float* b = static_cast<float*>(fbgemmAlignedAlloc(64, n * sizeof(float)));
+  float* c = static_cast<float*>(fbgemmAlignedAlloc(64, n * sizeof(float)));
+  // First touch by the threads using the pages, on their NUMA nodes
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads) schedule(static)
+#endif
+  for (std::int64_t i = 0; i < n; ++i) {
+    a[i] = 0.0f;
+    b[i] = 1.0f;
+    c[i] = 2.0f;
+  }
+  double best = 0.0;
+  for (int run = 0; run < 5; ++run) {
+    const auto start = std::chrono::steady_clock::now();
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads) schedule(static)
+#endif
+    for (std::int64_t i = 0; i < n; ++i) {
+      a[i] = b[i] + 3.0f * c[i];
+    }
+    const std::chrono::duration<double> dur =
+        std::chrono::steady_clock::now() - start;
+    best = std::max(best, 3.0 * n * sizeof(float) / dur.count() / 1e9);
+  }
+  volatile float sink = a[n / 2];
+  (void)sink;
+  fbgemmAlignedFree(a);
+  fbgemmAlignedFree(b);
+  fbgemmAlignedFree(c);
+  return best;
+}
+
+} // namespace
+
+MachinePeaks measureMachinePeaks(int num_threads) {
+#ifndef _OPENMP
+  num_threads = 1;
+#endif
+  MachinePeaks peaks;
+  peaks.threads = num_threads;
+#ifdef FBGEMM_BENCH_PEAKS
+  const inst_set_t isa = fbgemmInstructionSet();
+  if (isa == inst_set_t::avx512 || isa == inst_set_t::avx512_vnni) {
+    peaks.fp32_gflops = measurePeakGops(
+        fp32PeakAvx512, kFmaChains * 16 * 2.0, num_threads);
+  } else if (fbgemmHasAvx2Support()) {
+    peaks.fp32_gflops =
+        measurePeakGops(fp32PeakAvx2, kFmaChains * 8 * 2.0, num_threads);
+  }
+  if (isa == inst_set_t::avx512_vnni) {
+    peaks.int8_gops =
+        measurePeakGops(int8PeakVnni, kFmaChains * 64 * 2.0, num_threads);
+  } else if (isa == inst_set_t::avx512_vnni_ymm) {
+    peaks.int8_gops =
+        measurePeakGops(int8PeakVnniYmm, kFmaChains * 32 * 2.0, num_threads);
+  } else if (isa == inst_set_t::avx512) {
+    peaks.int8_gops =
+        measurePeakGops(int8PeakAvx512, kInt8Chains * 64 * 2.0, num_threads);
+  } else if (fbgemmHasAvx2Support()) {
+    peaks.int8_gops =
+        measurePeakGops(int8PeakAvx2, kInt8Chains * 32 * 2.0, num_threads);
+  }
+#endif
+  peaks.bandwidth_gbs = measureTriadGbs(num_threads);
+  return peaks;
+}
+
+void printMachinePeaks(const MachinePeaks& peaks) {
+  printf(
+      "Roofline peaks (%s, %d threads): fp32 %.1f GFLOPS, int8 %.1f GOPS, "
+      "triad %.1f GB/s\n",
+      instSetName(fbgemmInstructionSet()),
+      peaks.threads,
+      peaks.fp32_gflops,
+      peaks.int8_gops,
+      peaks.bandwidth_gbs);
+}
+
+RooflineBound rooflineBound(
+    double ops,
+    double bytes,
+    double peak_gops,
+    double bandwidth_gbs) {
+  RooflineBound bound;
+  if (bytes <= 0.0 || peak_gops <= 0.0 || bandwidth_gbs <= 0.0) {
+    return bound;
+  }
+  bound.intensity = ops / bytes;
+  const double memory_gops = bound.intensity * bandwidth_gbs;
+  bound.memory_bound = memory_gops < peak_gops;
+  bound.attainable_gops = std::min(memory_gops, peak_gops);
+  return bound;
+}
+
+const char* rooflineHeader() {
+  return ", AI (ops/B), Roofline GOPS, % of roofline, Bound";
+}
+
+std::string formatRooflineColumns(const RooflineBound& bound, double gops) {
+  if (bound.attainable_gops <= 0.0) {
+    return ", n/a, n/a, n/a, n/a";
+  }
+  char buf[128];
+  snprintf(
+      buf,
+      sizeof(buf),
+      ", %.2f, %.1f, %.1f, %s",
+      bound.intensity,
+      bound.attainable_gops,
+      100.0 * gops / bound.attainable_gops,
+      bound.memory_bound ? "memory" : "compute");
+  return buf;
+}
+
 #if defined(USE_MKL)
 void test_xerbla(char* srname, const int* info, int) {
   // srname - name of the function that called xerbla
@@ -8,7 +8,11 @@
 
 #pragma once
 #include <chrono>
+#include <cstdint>
+#include <cstdio>
 #include <functional>
+#include <string>
+#include <utility>
 #include <vector>
 
 #if defined(__x86_64__) || defined(__i386__) || \
@@ -37,6 +41,7 @@
 #include "./AlignedVec.h"
 #include "fbgemm/FbgemmBuild.h"
 #include "fbgemm/FbgemmPackMatrixB.h"
+#include "fbgemm/Utils.h"
 #include "src/RefImplementations.h"
 
 namespace fbgemm {
@@ -104,6 +109,173 @@ bool parseArgumentBool(
     const char* arg,
     bool def_val);
 
+/**
+ * Value of a --name=value argument, def_val if absent
+ */
+std::string parseArgumentString(
+    int argc,
+    const char* argv[],
+    const char* arg,
+    const std::string& def_val);
+
+/**
+ * Reads a list of shapes from a text file with one shape per line, given as
+ * integers separated by commas or spaces. Empty lines and lines starting with
+ * '#' are skipped. Exits with an error if the file cannot be read, a line is
+ * not a list of integers or it has not num_dims of them.
+ */
+std::vector<std::vector<int>> readShapesFromFile(
+    const std::string& path,
+    int num_dims);
+
+/**
+ * The shapes of --shapes=<file> if given (see readShapesFromFile), otherwise
+ * def_shapes
+ */
+std::vector<std::vector<int>> parseArgumentShapes(
+    int argc,
+    const char* argv[],
+    int num_dims,
+    const std::vector<std::vector<int>>& def_shapes);
+
+/**
+ * Name of an instruction set as in FBGEMM_ENABLE_INSTRUCTIONS
+ */
+const char* instSetName(inst_set_t isa);
+
+/**
+ * Hardware performance counters read around the measured iterations of a
+ * benchmark, with perf_event_open on Linux: cycles, instructions, LLC load
+ * misses and dTLB load misses of user space. They count the calling thread
+ * and the threads it creates once the counters are open, so OpenMP benchmarks
+ * should open them before their first parallel region. Counters that the
+ * machine or perf_event_paranoid does not allow are left out, and none are
+ * available on other systems.
+ */
+class PerfCounters {
+ public:
+  // Opens the counters if enabled, e.g. from parseArgumentBool("--perf")
+  explicit PerfCounters(bool enabled);
+  ~PerfCounters();
+  PerfCounters(const PerfCounters&) = delete;
+  PerfCounters& operator=(const PerfCounters&) = delete;
+
+  // Whether at least one counter could be opened
+  bool enabled() const;
+
+  // Counting happens between start and stop, accumulated until reset
+  void start();
+  void stop();
+  void reset();
+
+  // Accumulated counts as {name, count}
+  std::vector<std::pair<std::string, double>> read() const;
+
+ private:
+  std::vector<std::pair<std::string, int>> fds_;
+};
+
+/**
+ * Peak throughput of the host, for a roofline view of benchmark results
+ * (--roofline). Multiply-adds count as 2 ops, as in the GOPS of the
+ * benchmarks.
+ */
+struct MachinePeaks {
+  // fp32 FMA of the widest vectors of fbgemmInstructionSet()
+  double fp32_gflops = 0.0;
+  // u8 x s8 multiply-adds accumulated in 32 bits, with the instructions the
+  // int8 GEMM kernels of fbgemmInstructionSet() use (vpdpbusd with VNNI,
+  // otherwise vpmaddubsw + vpmaddwd + vpaddd)
+  double int8_gops = 0.0;
+  // STREAM triad bandwidth of arrays much larger than the LLC
+  double bandwidth_gbs = 0.0;
+  int threads = 1;
+};
+
+/**
+ * Measures the peaks of the host on num_threads OpenMP threads with
+ * microbenchmarks of about a second in total. Compute peaks are 0 without
+ * AVX2 and FMA.
+ */
+MachinePeaks measureMachinePeaks(int num_threads);
+
+void printMachinePeaks(const MachinePeaks& peaks);
+
+/**
+ * Roofline bound of a problem doing ops operations with bytes of memory
+ * traffic: min(peak_gops, ops / bytes * bandwidth_gbs) G ops/s
+ */
+struct RooflineBound {
+  // ops per byte
+  double intensity = 0.0;
+  double attainable_gops = 0.0;
+  bool memory_bound = false;
+};
+
+RooflineBound rooflineBound(
+    double ops,
+    double bytes,
+    double peak_gops,
+    double bandwidth_gbs);
+
+// Column names of formatRooflineColumns, starting with a separator
+const char* rooflineHeader();
+
+// Intensity, attainable GOPS, fraction of it reached by gops and the bound,
+// starting with a separator
+std::string formatRooflineColumns(const RooflineBound& bound, double gops);
+
+/**
+ * One measurement of a kernel on one shape
+ */
+struct BenchmarkRecord {
+  // Kernel or variant measured, e.g. "FBGEMM_i8_acc32"
+  std::string kernel;
+  // Named dimensions of the problem, e.g. {{"M", 64}, {"N", 800}}
+  std::vector<std::pair<std::string, std::int64_t>> shape;
+  // Time of each measured iteration, in seconds
+  std::vector<double> seconds;
+  // Work done and bytes moved by one iteration, 0 if not meaningful
+  double flops = 0.0;
+  double bytes = 0.0;
+  int threads = 1;
+  // Roofline bound of the kernel on the host, 0 if not measured, see
+  // rooflineBound
+  double attainable_gflops = 0.0;
+  // Hardware counters summed over the measured iterations, see PerfCounters
+  std::vector<std::pair<std::string, double>> counters;
+};
+
+/**
+ * Writes benchmark records as JSON lines, one object per record, for
+ * dashboards to track performance across versions. Enabled with
+ * --json=<path>, where records are appended to path, or --json=- for stdout.
+ * Every record has the benchmark name, the kernel, the shape, the ISA in use,
+ * the thread count, the mean and the p50/p90/p99/min/max of the iteration
+ * times in us, and the GFLOPS and GB/s of the mean time when known, along
+ * with the attainable GFLOPS and the fraction of it reached in roofline
+ * mode. Hardware counters are reported per iteration, along with the IPC and
+ * the DRAM bandwidth estimated from the LLC misses (64 bytes each) when
+ * available.
+ */
+class BenchmarkReporter {
+ public:
+  BenchmarkReporter(std::string benchmark, int argc, const char* argv[]);
+  ~BenchmarkReporter();
+  BenchmarkReporter(const BenchmarkReporter&) = delete;
+  BenchmarkReporter& operator=(const BenchmarkReporter&) = delete;
+
+  bool enabled() const {
+    return out_ != nullptr;
+  }
+
+  void report(const BenchmarkRecord& record);
+
+ private:
+  std::string benchmark_;
+  std::FILE* out_{nullptr};
+};
+
 namespace {
 struct empty_flush {
   void operator()() const {}
@@ -173,6 +345,43 @@ double measureWithWarmup(
   return ttot / 1e9 / measuredIterations;
 }
 
+/**
+ * Same as measureWithWarmup on a single thread, but returns the time of each
+ * measured iteration, in seconds, e.g. for BenchmarkRecord::seconds. If
+ * counters is not null, it is reset and counts the measured iterations,
+ * without the data eviction.
+ */
+template <class Fn, class Fe = std::function<void()>>
+std::vector<double> measureSamplesWithWarmup(
+    Fn&& fn,
+    int warmupIterations,
+    int measuredIterations,
+    const Fe& fe = empty_flush(),
+    PerfCounters* counters = nullptr) {
+  for (int i = 0; i < warmupIterations; ++i) {
+    fe();
+    fn();
+  }
+  if (counters) {
+    counters->reset();
+  }
+  std::vector<double> samples(measuredIterations);
+  for (auto& sample : samples) {
+    fe();
+    if (counters) {
+      counters->start();
+    }
+    const auto start = std::chrono::high_resolution_clock::now();
+    fn();
+    const auto end = std::chrono::high_resolution_clock::now();
+    if (counters) {
+      counters->stop();
+    }
+    sample = std::chrono::duration<double>(end - start).count();
+  }
+  return samples;
+}
+
 /*
  * @brief Out-of-place transposition for M*N matrix ref.
  * @param M number of rows in input
@@ -0,0 +1,346 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Contention on the JIT code caches when many threads fetch kernels at once,
+// as at the startup of a service. For 1, 2, 4, ... threads, each thread
+// issues a shuffled mix of GenerateEmbeddingSpMDMWithStrides (fp32 rows),
+// GenerateEmbeddingSpMDMNBitWithStrides (4-bit rows) and small fbgemmPacked
+// (int8, 32-bit accumulation) requests:
+//   cold: every request needs a kernel no earlier request generated. A
+//         fraction of the kernels (--shared=, in %) is requested by all
+//         threads, which then wait on a single generation; the other ones are
+//         private to a thread.
+//   warm: the same requests again, --warm_iters= times, now all hits.
+// The latency of every request is reported per kind, cold and warm (the
+// fbgemmPacked ones include the tiny GEMM). The serialization of the code
+// generation shows in the cold phase: its kernels/s are compared with those
+// of one thread, and the serial fraction is the one of Amdahl's law giving
+// the measured speedup.
+//
+// The caches are never emptied: the keys of each phase are new because the
+// embedding requests use a new output stride and the GEMM ones a new
+// (M, N) of at most 48 x 8, of which there are 384. The kernels generated,
+// from getCodeCacheStats(), show when those run out.
+//
+// Flags: --max_threads= (default the hardware threads), --requests= per thread
+// and phase (default 30), --shared= (default 50), --warm_iters= (default 100),
+// --json=<file> as in BenchUtils.h.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "./BenchUtils.h"
+#include "fbgemm/Fbgemm.h"
+#include "fbgemm/FbgemmEmbedding.h"
+#include "fbgemm/Utils.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+using Clock = chrono::steady_clock;
+
+enum class RequestKind { Embedding, EmbeddingNBit, Gemm };
+constexpr int kNumKinds = 3;
+constexpr const char* kKindNames[kNumKinds] = {
+    "GenerateEmbeddingSpMDM_fp32",
+    "GenerateEmbeddingSpMDMNBit_4bit",
+    "fbgemmPacked_i8_acc32"};
+
+constexpr int kEmbeddingDim = 64;
+constexpr int kGemmK = 64;
+constexpr int kGemmMaxM = 48;
+constexpr int kGemmMaxN = 8;
+
+/**
+ * One request of a phase. key selects the kernel: the output stride of the
+ * embedding kernels, the (M, N) of the GEMMs.
+ */
+struct Request {
+  RequestKind kind;
+  int64_t key;
+};
+
+/**
+ * Operands of a GEMM request, prepared before the phase so that only the
+ * packing of A, the kernel lookup and the multiplication are timed.
+ */
+struct GemmOperands {
+  int m, n;
+  aligned_vector<uint8_t> A;
+  unique_ptr<PackBMatrix<int8_t>> packedB;
+};
+
+class RequestRunner {
+ public:
+  explicit RequestRunner(int num_gemm_keys) : gemms_(num_gemm_keys) {
+    for (int key = 0; key < num_gemm_keys; ++key) {
+      auto& gemm = gemms_[key];
+      gemm.m = 1 + key % kGemmMaxM;
+      gemm.n = 1 + (key / kGemmMaxM) % kGemmMaxN;
+      gemm.A.resize(gemm.m * kGemmK);
+      randFill<uint8_t>(gemm.A, 0, 5);
+      aligned_vector<int8_t> B(kGemmK * gemm.n);
+      randFill<int8_t>(B, -4, 4);
+      gemm.packedB = make_unique<PackBMatrix<int8_t>>(
+          matrix_op_t::NoTranspose, kGemmK, gemm.n, B.data(), gemm.n);
+    }
+  }
+
+  // Output strides of the embedding kernels, never reused
+  int64_t newEmbeddingKey() {
+    return kEmbeddingDim + next_embedding_key_++;
+  }
+
+  // (M, N) of the GEMMs, reused once the 384 of them have been used
+  int64_t newGemmKey() {
+    return next_gemm_key_++ % gemms_.size();
+  }
+
+  void run(const Request& request) {
+    switch (request.kind) {
+      case RequestKind::Embedding: {
+        const auto kernel =
+            GenerateEmbeddingSpMDMWithStrides<float, int64_t, int32_t, float>(
+                kEmbeddingDim,
+                /*has_weight=*/false,
+                /*normalize_by_lengths=*/false,
+                /*prefetch=*/16,
+                /*is_weight_positional=*/false,
+                /*use_offsets=*/true,
+                /*output_stride=*/request.key);
+        (void)kernel;
+        break;
+      }
+      case RequestKind::EmbeddingNBit: {
+        const auto kernel =
+            GenerateEmbeddingSpMDMNBitWithStrides<int64_t, int32_t, float>(
+                /*bit_rate=*/4,
+                kEmbeddingDim,
+                /*has_weight=*/false,
+                /*normalize_by_lengths=*/false,
+                /*prefetch=*/16,
+                /*is_weight_positional=*/false,
+                /*use_offsets=*/true,
+                /*output_stride=*/request.key);
+        (void)kernel;
+        break;
+      }
+      case RequestKind::Gemm: {
+        // Each thread multiplies into its own output
+        thread_local aligned_vector<int32_t> C;
+        auto& gemm = gemms_[request.key];
+        C.resize(gemm.m * gemm.n);
+        PackAMatrix<uint8_t> packA(
+            matrix_op_t::NoTranspose, gemm.m, kGemmK, gemm.A.data(), kGemmK);
+        DoNothing<int32_t, int32_t> doNothingObj;
+        memCopy<> memcopyObj(doNothingObj);
+        fbgemmPacked(
+            packA, *gemm.packedB, C.data(), C.data(), gemm.n, memcopyObj, 0, 1);
+        break;
+      }
+    }
+  }
+
+ private:
+  vector<GemmOperands> gemms_;
+  atomic<int64_t> next_embedding_key_{0};
+  atomic<int64_t> next_gemm_key_{0};
+};
+
+uint64_t generatedKernels() {
+  uint64_t misses = 0;
+  for (const auto& stats : getCodeCacheStats()) {
+    misses += stats.misses;
+  }
+  return misses;
+}
+
+/**
+ * Runs the requests of every thread on its own std::thread, all released at
+ * once, and returns the latency of each request in seconds, by kind.
+ */
+vector<vector<double>> runPhase(
+    RequestRunner& runner,
+    const vector<vector<Request>>& requests,
+    int iters,
+    double& wall_seconds) {
+  const int num_threads = requests.size();
+  vector<vector<vector<double>>> latencies(
+      num_threads, vector<vector<double>>(kNumKinds));
+  atomic<int> ready{0};
+  atomic<bool> go{false};
+  vector<thread> threads;
+  for (int t = 0; t < num_threads; ++t) {
+    threads.emplace_back([&, t]() {
+      ready.fetch_add(1);
+      while (!go.load(memory_order_acquire)) {
+        this_thread::yield();
+      }
+      for (int it = 0; it < iters; ++it) {
+        for (const auto& request : requests[t]) {
+          const auto start = Clock::now();
+          runner.run(request);
+          latencies[t][static_cast<int>(request.kind)].push_back(
+              chrono::duration<double>(Clock::now() - start).count());
+        }
+      }
+    });
+  }
+  while (ready.load() < num_threads) {
+    this_thread::yield();
+  }
+  const auto start = Clock::now();
+  go.store(true, memory_order_release);
+  for (auto& t : threads) {
+    t.join();
+  }
+  wall_seconds = chrono::duration<double>(Clock::now() - start).count();
+
+  vector<vector<double>> by_kind(kNumKinds);
+  for (const auto& thread_latencies : latencies) {
+    for (int kind = 0; kind < kNumKinds; ++kind) {
+      by_kind[kind].insert(
+          by_kind[kind].end(),
+          thread_latencies[kind].begin(),
+          thread_latencies[kind].end());
+    }
+  }
+  return by_kind;
+}
+
+// Nearest-rank percentile
+double percentile(vector<double> samples, double p) {
+  sort(samples.begin(), samples.end());
+  const auto rank = static_cast<size_t>(ceil(p / 100.0 * samples.size()));
+  return samples[max<size_t>(rank, 1) - 1];
+}
+
+vector<int> threadCounts(int max_threads) {
+  vector<int> counts;
+  for (int n = 1; n < max_threads; n *= 2) {
+    counts.push_back(n);
+  }
+  counts.push_back(max_threads);
+  return counts;
+}
+
+} // namespace
+
+int main(int argc, const char* argv[]) {
+  const int hardware_threads = max<int>(thread::hardware_concurrency(), 1);
+  const int max_threads = parseArgumentInt(
+      argc, argv, "--max_threads=", hardware_threads, hardware_threads);
+  const int num_requests = parseArgumentInt(argc, argv, "--requests=", 30, 30);
+  const int shared_percent = parseArgumentInt(argc, argv, "--shared=", 50, 50);
+  const int warm_iters =
+      parseArgumentInt(argc, argv, "--warm_iters=", 100, 100);
+  BenchmarkReporter reporter("CodeCacheContention", argc, argv);
+  cout << "ISA: " << instSetName(fbgemmInstructionSet()) << endl;
+
+  RequestRunner runner(kGemmMaxM * kGemmMaxN);
+  default_random_engine generator;
+  const auto newRequest = [&](int i) {
+    const auto kind = static_cast<RequestKind>(i % kNumKinds);
+    return Request{
+        kind,
+        kind == RequestKind::Gemm ? runner.newGemmKey()
+                                  : runner.newEmbeddingKey()};
+  };
+
+  cout << setw(8) << "Threads, " << setw(34) << "Kind, " << setw(7)
+       << "Phase, " << setw(10) << "p50 (us), " << setw(10) << "p90 (us), "
+       << setw(10) << "p99 (us), " << setw(10) << "max (us)" << endl;
+  // Cold kernels generated per second by one thread
+  double base_rate = 0.0;
+  vector<string> summaries;
+  for (const int num_threads : threadCounts(max_threads)) {
+    const int num_shared = num_requests * shared_percent / 100;
+    vector<Request> shared;
+    for (int i = 0; i < num_shared; ++i) {
+      shared.push_back(newRequest(i));
+    }
+    vector<vector<Request>> requests(num_threads);
+    for (auto& thread_requests : requests) {
+      thread_requests = shared;
+      for (int i = num_shared; i < num_requests; ++i) {
+        thread_requests.push_back(newRequest(i));
+      }
+      shuffle(thread_requests.begin(), thread_requests.end(), generator);
+    }
+
+    const uint64_t generated_before = generatedKernels();
+    double cold_seconds, warm_seconds;
+    const auto cold = runPhase(runner, requests, 1, cold_seconds);
+    const uint64_t generated = generatedKernels() - generated_before;
+    const auto warm = runPhase(runner, requests, warm_iters, warm_seconds);
+
+    for (const auto& [phase, latencies] :
+         {make_pair("cold", cold), make_pair("warm", warm)}) {
+      for (int kind = 0; kind < kNumKinds; ++kind) {
+        if (latencies[kind].empty()) {
+          continue;
+        }
+        BenchmarkRecord record;
+        record.kernel = string(kKindNames[kind]) + "/" + phase;
+        record.shape = {{"requests", num_requests}, {"shared", shared_percent}};
+        record.threads = num_threads;
+        record.seconds = latencies[kind];
+        reporter.report(record);
+
+        cout << setw(6) << num_threads << ", " << setw(32) << kKindNames[kind]
+             << ", " << setw(5) << phase << ", " << fixed << setprecision(2)
+             << setw(8) << percentile(latencies[kind], 50) * 1e6 << ", "
+             << setw(8) << percentile(latencies[kind], 90) * 1e6 << ", "
+             << setw(8) << percentile(latencies[kind], 99) * 1e6 << ", "
+             << setw(8) << percentile(latencies[kind], 100) * 1e6 << endl;
+      }
+    }
+
+    // Amdahl's law: speedup = n / (1 + s * (n - 1))
+    const double rate = generated / cold_seconds;
+    if (base_rate == 0.0) {
+      base_rate = rate;
+    }
+    const double speedup = rate / base_rate;
+    stringstream summary;
+    summary << setw(6) << num_threads << ", " << setw(9) << generated << ", "
+            << fixed << setprecision(2) << setw(13) << cold_seconds * 1e3
+            << ", " << setw(12) << rate << ", " << setw(8) << speedup << ", ";
+    if (num_threads > 1) {
+      summary << setw(15)
+              << clamp(
+                     (num_threads / speedup - 1) / (num_threads - 1), 0.0, 1.0);
+    } else {
+      summary << setw(15) << "-";
+    }
+    summaries.push_back(summary.str());
+  }
+
+  cout << endl
+       << "Code generation in the cold phases" << endl
+       << setw(8) << "Threads, " << setw(11) << "Generated, " << setw(15)
+       << "Wall time (ms), " << setw(14) << "Kernels/s, " << setw(10)
+       << "Speedup, " << "Serial fraction" << endl;
+  for (const auto& summary : summaries) {
+    cout << summary << endl;
+  }
+  return 0;
+}
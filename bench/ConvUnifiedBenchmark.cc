@@ -219,7 +219,8 @@ template <int SPATIAL_DIM, typename Acc_t>
 void performance_test(
     const vector<conv_param_t<SPATIAL_DIM>>& shapes,
     bool flush,
-    int repetitions) {
+    int repetitions,
+    const MachinePeaks* peaks) {
   std::vector<char> llc;
 
   if (flush) {
@@ -283,9 +284,10 @@ void performance_test(
        << endl;
   cout << header << "Im2Col (ms), " << "Packing (ms), " << "Kernel (ms), "
        << "Postprocessing (ms), " << "fbgemmPacked (ms), " << "Total (ms), "
-       << "GOPS" << endl;
+       << "GOPS" << (peaks ? rooflineHeader() : "") << endl;
 #else
-  cout << setw(6) << header << setw(5) << "GOPS" << endl;
+  cout << setw(6) << header << setw(5) << "GOPS"
+       << (peaks ? rooflineHeader() : "") << endl;
 #endif
 
   chrono::time_point<chrono::high_resolution_clock> begin, end;
@@ -493,7 +495,17 @@ void performance_test(
          << total_run_time / (double)NITER / 1e6 << ", "
          << ttot / (double)NITER / 1e6 << ", ";
 #endif
-    cout << setprecision(2) << nops / ttot << endl;
+    cout << setprecision(2) << nops / ttot;
+    if (peaks) {
+      // Reads the input and the weights and writes the uint8 output once
+      const double bytes = static_cast<double>(Aint8.size()) + Bint8.size() +
+          Cint8_fb.size();
+      cout << formatRooflineColumns(
+          rooflineBound(
+              nops / NITER, bytes, peaks->int8_gops, peaks->bandwidth_gbs),
+          nops / ttot);
+    }
+    cout << endl;
 
     compare_buffers(
         Cint8_ref.data(),
@@ -512,6 +524,8 @@ typedef struct {
                                default set */
   int benchmark_repetitions; /* specified number of timed benchmark iterations
                               */
+  bool roofline; /* if true, reports the fraction of the roofline of the host
+                    reached by each shape */
 } user_args_t;
 
 int main(int argc, const char* argv[]) {
@@ -521,6 +535,7 @@ int main(int argc, const char* argv[]) {
   user_args.no_flush = parseArgumentBool(argc, argv, "--no-flush", false);
   user_args.run_extended_shapes =
       parseArgumentBool(argc, argv, "--run-extn-shapes", false);
+  user_args.roofline = parseArgumentBool(argc, argv, "--roofline", false);
 
 #ifdef _OPENMP
   // Use 1 thread unless OMP_NUM_THREADS is explicit set.
@@ -537,13 +552,29 @@ int main(int argc, const char* argv[]) {
         shapes_2d_resnext_101.begin(),
         shapes_2d_resnext_101.end());
   }
+  MachinePeaks peaks;
+  if (user_args.roofline) {
+    peaks = measureMachinePeaks(fbgemm_get_max_threads());
+    printMachinePeaks(peaks);
+  }
+  const MachinePeaks* roofline = user_args.roofline ? &peaks : nullptr;
+
   // performance_test<int16_t>();
   performance_test<1, int32_t>(
-      shapes_1d, !user_args.no_flush, user_args.benchmark_repetitions);
+      shapes_1d,
+      !user_args.no_flush,
+      user_args.benchmark_repetitions,
+      roofline);
 
   performance_test<2, int32_t>(
-      shapes_2d, !user_args.no_flush, user_args.benchmark_repetitions);
+      shapes_2d,
+      !user_args.no_flush,
+      user_args.benchmark_repetitions,
+      roofline);
   performance_test<3, int32_t>(
-      shapes_3d, !user_args.no_flush, user_args.benchmark_repetitions);
+      shapes_3d,
+      !user_args.no_flush,
+      user_args.benchmark_repetitions,
+      roofline);
   return 0;
 }
@@ -65,7 +65,89 @@ void performance_test() {
   } // M
 } // performance_test
 
+void performance_test_fp8() {
+  constexpr int NWARMUP = 4;
+  constexpr int NITER = 64;
+  constexpr int exponent_bits = 4;
+  constexpr int exponent_bias = 7;
+
+  normal_distribution<float> dist;
+  default_random_engine engine;
+
+  cout << "fp8 e4m3" << endl;
+  cout << setw(8) << "M" << " elements_per_sec_ref"
+       << " elements_per_sec_simd" << " elements_per_sec_simd_mt" << endl;
+
+  array<int, 5> dims{32, 1024, 8000, 1 << 20, 1 << 24};
+
+  for (int M : dims) {
+    vector<float> a(M);
+    vector<float> b(M), b_ref(M);
+    vector<uint8_t> t(M);
+
+    generate(a.begin(), a.end(), [&dist, &engine] { return dist(engine); });
+
+    double duration_ref = measureWithWarmup(
+        [&]() {
+          for (int i = 0; i < M; ++i) {
+            FloatToFloat8_ref(a[i], &t[i], exponent_bits, exponent_bias);
+          }
+          for (int i = 0; i < M; ++i) {
+            Float8ToFloat_ref(t[i], &b_ref[i], exponent_bits, exponent_bias);
+          }
+        },
+        NWARMUP,
+        NITER);
+    duration_ref *= 1e9; // convert to ns
+
+    double duration_simd = measureWithWarmup(
+        [&]() {
+          FloatToFloat8_simd(
+              a.data(), t.data(), M, exponent_bits, exponent_bias);
+          Float8ToFloat_simd(
+              t.data(), b.data(), M, exponent_bits, exponent_bias);
+        },
+        NWARMUP,
+        NITER);
+    duration_simd *= 1e9; // convert to ns
+
+    double duration_simd_mt = measureWithWarmup(
+        [&]() {
+          int num_threads = fbgemm_get_num_threads();
+          int tid = fbgemm_get_thread_num();
+          FloatToFloat8_simd(
+              a.data(),
+              t.data(),
+              M,
+              exponent_bits,
+              exponent_bias,
+              tid,
+              num_threads);
+          Float8ToFloat_simd(
+              t.data(),
+              b.data(),
+              M,
+              exponent_bits,
+              exponent_bias,
+              tid,
+              num_threads);
+        },
+        NWARMUP,
+        NITER,
+        []() {},
+        true /*useOpenMP*/);
+    duration_simd_mt *= 1e9; // convert to ns
+
+    cout << setw(8) << M << setw(10) << setprecision(3) << M / duration_ref
+         << setw(10) << setprecision(3) << M / duration_simd << setw(10)
+         << setprecision(3) << M / duration_simd_mt << endl;
+
+    compare_buffers(b_ref.data(), b.data(), M, 1, 1, 5);
+  } // M
+} // performance_test_fp8
+
 int main() {
   performance_test();
+  performance_test_fp8();
   return 0;
 }
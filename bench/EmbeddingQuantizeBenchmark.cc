@@ -97,6 +97,58 @@ void performance_test() {
   } // for each bit_rate
 } // performance_test
 
+// Quantization of a large table split across the OpenMP threads
+void parallel_performance_test() {
+  constexpr int NWARMUP = 1;
+  constexpr int NITER = 5;
+  constexpr int rowSize = 1 << 20;
+#ifdef _OPENMP
+  const int num_threads = omp_get_max_threads();
+#else
+  const int num_threads = 1;
+#endif
+
+  cout << "Parallel with " << num_threads << " threads" << endl;
+  cout << setw(8) << "bit_rate" << "," << setw(6) << "cols" << ","
+       << setw(16) << "serial_GB/Sec" << "," << setw(16) << "parallel_GB/Sec"
+       << endl;
+  for (int bit_rate : {4, 8}) {
+    for (int colSize : {64, 256}) {
+      aligned_vector<float> inpVec(static_cast<size_t>(rowSize) * colSize);
+      randFill<float>(inpVec, -10.0f, 10.0f);
+      aligned_vector<uint8_t> outVec(
+          static_cast<size_t>(rowSize) * (colSize + 2 * sizeof(float16)));
+
+      double serial = measureWithWarmup(
+          [&]() {
+            FloatOrHalfToFusedNBitRowwiseQuantizedSBHalf<float>(
+                bit_rate, inpVec.data(), rowSize, colSize, outVec.data());
+          },
+          NWARMUP,
+          NITER);
+      double parallel = measureWithWarmup(
+          [&]() {
+            FloatOrHalfToFusedNBitRowwiseQuantizedSBHalfParallel<float>(
+                bit_rate,
+                inpVec.data(),
+                rowSize,
+                colSize,
+                outVec.data(),
+                num_threads);
+          },
+          NWARMUP,
+          NITER);
+
+      const double bytes_read =
+          static_cast<double>(rowSize) * colSize * sizeof(float);
+      cout << setw(8) << bit_rate << "," << setw(6) << colSize << ","
+           << setw(16) << std::fixed << std::setprecision(2)
+           << bytes_read / serial / 1e9 << "," << setw(16)
+           << bytes_read / parallel / 1e9 << endl;
+    }
+  }
+}
+
 int main() {
 #ifdef _OPENMP
   // Use 1 thread unless OMP_NUM_THREADS is explicit set.
@@ -107,5 +159,6 @@ int main() {
 #endif
   performance_test<float16>();
   performance_test<float>();
+  parallel_performance_test();
   return 0;
 }
@@ -384,6 +384,82 @@ void run_benchmark(
   } // has_weight
 }
 
+// Times the fp32 kernel on the indices as generated and sorted within bags
+// by EmbeddingSortIndicesWithinBags, with the time of the sort itself.
+void run_sorted_indices_benchmark(
+    int batch_size,
+    int num_rows,
+    int embedding_dim,
+    int average_len) {
+  default_random_engine generator;
+  vector<float> embedding_table(int64_t(num_rows) * embedding_dim);
+  normal_distribution<float> embedding_distribution;
+  for (auto& v : embedding_table) {
+    v = embedding_distribution(generator);
+  }
+
+  uniform_int_distribution<int> length_distribution(1, 2 * average_len + 1);
+  vector<int> offsets(batch_size + 1);
+  for (int i = 0; i < batch_size; ++i) {
+    offsets[i + 1] = offsets[i] + length_distribution(generator);
+  }
+  const int lengths_sum = offsets[batch_size];
+  uniform_int_distribution<int64_t> index_distribution(0, num_rows - 1);
+  vector<int64_t> indices(lengths_sum);
+  for (auto& index : indices) {
+    index = index_distribution(generator);
+  }
+  vector<int64_t> sorted_indices(lengths_sum);
+
+  constexpr int NUM_WARMUP = 4;
+  constexpr int NUM_ITER = 10;
+  auto kernel = GenerateEmbeddingSpMDM<float, int64_t>(
+      embedding_dim, /*has_weight=*/false, /*normalize_by_lengths=*/false);
+  vector<float> output(batch_size * embedding_dim);
+  const auto time_kernel = [&](const vector<int64_t>& kernel_indices) {
+    return measureWithWarmup(
+        [&]() {
+          kernel(
+              batch_size,
+              lengths_sum,
+              num_rows,
+              embedding_table.data(),
+              kernel_indices.data(),
+              offsets.data(),
+              nullptr,
+              output.data());
+        },
+        NUM_WARMUP,
+        NUM_ITER,
+        [&]() {
+          cache_evict(embedding_table);
+          cache_evict(kernel_indices);
+          cache_evict(output);
+        });
+  };
+  const double t_sort = measureWithWarmup(
+      [&]() {
+        EmbeddingSortIndicesWithinBags<int64_t, int>(
+            batch_size,
+            lengths_sum,
+            indices.data(),
+            offsets.data(),
+            nullptr,
+            sorted_indices.data(),
+            nullptr);
+      },
+      NUM_WARMUP,
+      NUM_ITER);
+  const double t = time_kernel(indices);
+  const double t_sorted = time_kernel(sorted_indices);
+
+  cout << "emb dim" << setw(6) << embedding_dim << setw(16) << "avg length"
+       << setw(6) << average_len << setw(10) << " time " << setw(16) << t
+       << setw(16) << " sorted time " << setw(16) << t_sorted << setw(10)
+       << " sort " << setw(16) << t_sort << setw(12) << " speedup "
+       << setw(8) << t / (t_sorted + t_sort) << endl;
+}
+
 int main() {
   vector<vector<int>> inputs(GetInputs_());
 
@@ -431,5 +507,12 @@ int main() {
       } // use_fp16_inputs
     } // normalize_by_length
   } // for each input
+
+  cout << "FP32 SLS with indices sorted within bags, cache flushed" << endl;
+  for (int embedding_dim : {64, 128}) {
+    for (int average_len : {1, 10, 40, 100, 200}) {
+      run_sorted_indices_benchmark(100, 4000000, embedding_dim, average_len);
+    }
+  }
   return 0;
 }
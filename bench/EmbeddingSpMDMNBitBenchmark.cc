@@ -61,7 +61,25 @@ static vector<vector<int>> GetInputs_() {
   return input_dims;
 }
 
+// Reports the iteration times and the counters of kernel and returns the mean
+// time
+double reportSamples(
+    BenchmarkReporter& reporter,
+    BenchmarkRecord& record,
+    const string& kernel,
+    vector<double> samples,
+    const PerfCounters& counters) {
+  record.kernel = kernel;
+  record.seconds = std::move(samples);
+  record.counters = counters.read();
+  reporter.report(record);
+  return accumulate(record.seconds.begin(), record.seconds.end(), 0.0) /
+      record.seconds.size();
+}
+
 int run_benchmark(
+    BenchmarkReporter& reporter,
+    PerfCounters& counters,
     int bit_rate,
     int batch_size,
     int num_rows,
@@ -168,8 +186,21 @@ int run_benchmark(
 
     vector<float>& output = has_weight ? output_slws : output_sls;
     for (bool flush_cache : {false, true}) {
+      BenchmarkRecord record;
+      record.shape = {
+          {"bit_rate", bit_rate},
+          {"batch_size", batch_size},
+          {"num_rows", num_rows},
+          {"embedding_dim", embedding_dim},
+          {"average_len", average_len},
+          {"index_bits", use_32_bit_indices ? 32 : 64},
+          {"weighted", has_weight},
+          {"prefetch", prefetch},
+          {"flush_cache", flush_cache}};
+      record.bytes = bytes;
+
       // Reference implementation
-      double t_ref = measureWithWarmup(
+      auto samples_ref = measureSamplesWithWarmup(
           [&]() {
             if (use_32_bit_indices) {
               success_ref = EmbeddingSpMDMNBit_ref(
@@ -210,10 +241,14 @@ int run_benchmark(
               cache_evict(weights);
               cache_evict(output);
             }
-          });
+          },
+          &counters);
+
+      const double t_ref = reportSamples(
+          reporter, record, "ref", std::move(samples_ref), counters);
 
       // Auto-vectorization implementation
-      double t_autovec = measureWithWarmup(
+      auto samples_autovec = measureSamplesWithWarmup(
           [&]() {
             if (use_32_bit_indices) {
               success_autovec = EmbeddingSpMDMNBit_autovec(
@@ -254,10 +289,14 @@ int run_benchmark(
               cache_evict(weights);
               cache_evict(output);
             }
-          });
+          },
+          &counters);
+
+      const double t_autovec = reportSamples(
+          reporter, record, "autovec", std::move(samples_autovec), counters);
 
       // Hand-written AVX2/AVX512 implementation
-      double t = measureWithWarmup(
+      auto samples = measureSamplesWithWarmup(
           [&]() {
             if (use_32_bit_indices) {
               success = kernel_32(
@@ -292,7 +331,11 @@ int run_benchmark(
               cache_evict(weights);
               cache_evict(output);
             }
-          });
+          },
+          &counters);
+
+      const double t = reportSamples(
+          reporter, record, "asmjit", std::move(samples), counters);
 
       // printMatrix(
       //     matrix_op_t::NoTranspose,
@@ -366,13 +409,16 @@ int run_benchmark(
   return 0;
 }
 
-int main() {
+int main(int argc, const char* argv[]) {
   int batch_size;
   int num_rows;
   int embedding_dim;
   int average_len;
 
-  vector<vector<int>> inputs(GetInputs_());
+  // batch size, number of rows of table, emb dim, avg length
+  vector<vector<int>> inputs(parseArgumentShapes(argc, argv, 4, GetInputs_()));
+  BenchmarkReporter reporter("EmbeddingSpMDMNBit", argc, argv);
+  PerfCounters counters(parseArgumentBool(argc, argv, "--perf", false));
 
   for (int bit_rate : {4, 2}) {
     for (auto& input : inputs) {
@@ -389,6 +435,8 @@ int main() {
       // prefetch
       cout << "64 bit indices, ";
       run_benchmark(
+          reporter,
+          counters,
           bit_rate,
           batch_size,
           num_rows,
@@ -398,6 +446,8 @@ int main() {
 
       cout << "64 bit indices with prefetching, ";
       run_benchmark(
+          reporter,
+          counters,
           bit_rate,
           batch_size,
           num_rows,
@@ -409,6 +459,8 @@ int main() {
 
       cout << "32 bit indices, ";
       run_benchmark(
+          reporter,
+          counters,
           bit_rate,
           batch_size,
           num_rows,
@@ -419,6 +471,8 @@ int main() {
 
       cout << "32 bit indices with prefetching, ";
       run_benchmark(
+          reporter,
+          counters,
           bit_rate,
           batch_size,
           num_rows,
@@ -0,0 +1,482 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Replays recorded embedding lookups against the EmbeddingSpMDM kernels, so
+// that the Zipfian reuse of rows and the skew of the pooling factors are those
+// of production traffic rather than uniform random indices.
+//
+// --trace=<file> replays the tables of a trace file, laid out as (native
+// endianness):
+//   char     magic[8] = "FBGEMMTR"
+//   uint32_t version = 1
+//   uint32_t num_tables
+//   then for each table:
+//     int64_t num_rows, embedding_dim, batch_size, num_indices
+//     int64_t offsets[batch_size + 1]
+//     int64_t indices[num_indices]
+// Without --trace, tables of --shapes=<file> (batch size, number of rows,
+// embedding dim, average pooling factor) or of the default shapes get indices
+// drawn as the zipf_cuda op of FBGEMM_GPU (exponent --alpha=<x100>, default
+// 115) and uniform pooling factors. --write_trace=<file> saves them in the
+// trace format.
+//
+// Other flags: --bit_rate=32|8|4|2 for float, fused 8-bit or fused n-bit rows
+// (default 8), --flush to evict the caches between iterations, --json=<file>
+// and --perf as in BenchUtils.h.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <fstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "./BenchUtils.h"
+#include "fbgemm/Fbgemm.h"
+#include "fbgemm/FbgemmEmbedding.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+constexpr char kTraceMagic[8] = {'F', 'B', 'G', 'E', 'M', 'M', 'T', 'R'};
+constexpr uint32_t kTraceVersion = 1;
+
+// Lookups of one table, pointing into the mapped trace or into owned storage
+struct TraceTable {
+  int64_t num_rows;
+  int64_t embedding_dim;
+  int64_t batch_size;
+  int64_t num_indices;
+  const int64_t* offsets;
+  const int64_t* indices;
+};
+
+// Read-only mapping of a whole file
+class MappedFile {
+ public:
+  explicit MappedFile(const string& path) {
+#ifdef _WIN32
+    ifstream in(path, ios::binary);
+    buffer_.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    if (!in.good() && !in.eof()) {
+      fail(path);
+    }
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+#else
+    const int fd = open(path.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+      fail(path);
+    }
+    size_ = st.st_size;
+    if (size_ > 0) {
+      void* addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr == MAP_FAILED) {
+        fail(path);
+      }
+      data_ = static_cast<const char*>(addr);
+    }
+    close(fd);
+#endif
+  }
+
+  ~MappedFile() {
+#ifndef _WIN32
+    if (data_ != nullptr) {
+      munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  const char* data() const {
+    return data_;
+  }
+  size_t size() const {
+    return size_;
+  }
+
+ private:
+  [[noreturn]] static void fail(const string& path) {
+    fprintf(stderr, "Cannot map %s\n", path.c_str());
+    exit(1);
+  }
+
+  const char* data_{nullptr};
+  size_t size_{0};
+#ifdef _WIN32
+  vector<char> buffer_;
+#endif
+};
+
+[[noreturn]] void badTrace(const string& path, const string& what) {
+  fprintf(stderr, "%s: %s\n", path.c_str(), what.c_str());
+  exit(1);
+}
+
+// Parses the tables of a trace, which keep pointing into file
+vector<TraceTable> parseTrace(const MappedFile& file, const string& path) {
+  size_t pos = 0;
+  auto take = [&](size_t bytes) {
+    if (file.size() - pos < bytes) {
+      badTrace(path, "truncated trace");
+    }
+    const char* p = file.data() + pos;
+    pos += bytes;
+    return p;
+  };
+  auto takeInt64 = [&]() {
+    int64_t v;
+    memcpy(&v, take(sizeof(v)), sizeof(v));
+    return v;
+  };
+
+  if (memcmp(take(sizeof(kTraceMagic)), kTraceMagic, sizeof(kTraceMagic))) {
+    badTrace(path, "not an embedding trace");
+  }
+  uint32_t version, num_tables;
+  memcpy(&version, take(sizeof(version)), sizeof(version));
+  memcpy(&num_tables, take(sizeof(num_tables)), sizeof(num_tables));
+  if (version != kTraceVersion) {
+    badTrace(path, "unsupported trace version " + to_string(version));
+  }
+
+  vector<TraceTable> tables;
+  for (uint32_t t = 0; t < num_tables; ++t) {
+    TraceTable table;
+    table.num_rows = takeInt64();
+    table.embedding_dim = takeInt64();
+    table.batch_size = takeInt64();
+    table.num_indices = takeInt64();
+    if (table.num_rows <= 0 || table.embedding_dim <= 0 ||
+        table.batch_size < 0 || table.num_indices < 0) {
+      badTrace(path, "invalid sizes of table " + to_string(t));
+    }
+    // The header is 16 bytes and every table a multiple of 8 bytes, so the
+    // arrays are 8-byte aligned in the page-aligned mapping.
+    table.offsets = reinterpret_cast<const int64_t*>(
+        take((table.batch_size + 1) * sizeof(int64_t)));
+    table.indices = reinterpret_cast<const int64_t*>(
+        take(table.num_indices * sizeof(int64_t)));
+    if (table.offsets[0] != 0 ||
+        table.offsets[table.batch_size] != table.num_indices ||
+        !is_sorted(table.offsets, table.offsets + table.batch_size + 1)) {
+      badTrace(path, "invalid offsets of table " + to_string(t));
+    }
+    tables.push_back(table);
+  }
+  return tables;
+}
+
+void writeTrace(const string& path, const vector<TraceTable>& tables) {
+  FILE* out = fopen(path.c_str(), "wb");
+  if (out == nullptr) {
+    fprintf(stderr, "Cannot write %s\n", path.c_str());
+    exit(1);
+  }
+  const uint32_t header[2] = {kTraceVersion, uint32_t(tables.size())};
+  fwrite(kTraceMagic, sizeof(kTraceMagic), 1, out);
+  fwrite(header, sizeof(header), 1, out);
+  for (const auto& table : tables) {
+    const int64_t sizes[4] = {
+        table.num_rows,
+        table.embedding_dim,
+        table.batch_size,
+        table.num_indices};
+    fwrite(sizes, sizeof(sizes), 1, out);
+    fwrite(table.offsets, sizeof(int64_t), table.batch_size + 1, out);
+    fwrite(table.indices, sizeof(int64_t), table.num_indices, out);
+  }
+  fclose(out);
+}
+
+// Same generator as the zipf_cuda op of FBGEMM_GPU (rk_zipf of cupy), so that
+// the synthetic tables follow the distribution of its TBE benchmarks.
+class ZipfGenerator {
+ public:
+  ZipfGenerator(double a, uint64_t seed) : a_(a) {
+    for (int i = 1; i <= 4; ++i) {
+      seed = 1812433253U * (seed ^ (seed >> 30)) + i;
+      xor128_[i - 1] = static_cast<uint32_t>(seed);
+    }
+  }
+
+  int64_t operator()() {
+    const double am1 = a_ - 1.0;
+    const double b = pow(2.0, am1);
+    while (true) {
+      const double U = 1.0 - nextDouble();
+      const double V = nextDouble();
+      const double X = floor(pow(U, -1.0 / am1));
+      if (X < 1.0) {
+        continue;
+      }
+      const double T = pow(1.0 + 1.0 / X, am1);
+      if (V * X * (T - 1.0) / (b - 1.0) <= T / b) {
+        // Saturate instead of overflowing on huge samples
+        return X < 9.0e18 ? static_cast<int64_t>(X)
+                          : numeric_limits<int64_t>::max();
+      }
+    }
+  }
+
+ private:
+  uint32_t nextRandom() {
+    const uint32_t t = xor128_[0] ^ (xor128_[0] << 11);
+    xor128_[0] = xor128_[1];
+    xor128_[1] = xor128_[2];
+    xor128_[2] = xor128_[3];
+    return xor128_[3] ^= (xor128_[3] >> 19) ^ t ^ (t >> 8);
+  }
+
+  double nextDouble() {
+    const uint32_t a = nextRandom() >> 5, b = nextRandom() >> 6;
+    return (a * 67108864.0 + b) / 9007199254740992.0;
+  }
+
+  double a_;
+  uint32_t xor128_[4];
+};
+
+// Synthetic table with Zipf distributed rows, scattered over the table by a
+// random permutation as generate_indices_zipf of FBGEMM_GPU does
+void generateTable(
+    const vector<int>& shape,
+    double alpha,
+    uint64_t seed,
+    vector<int64_t>& offsets,
+    vector<int64_t>& indices,
+    TraceTable& table) {
+  table.batch_size = shape[0];
+  table.num_rows = shape[1];
+  table.embedding_dim = shape[2];
+  const int average_len = shape[3];
+
+  default_random_engine generator(seed);
+  uniform_int_distribution<int> length_distribution(
+      1, max(2 * average_len - 1, 1));
+  offsets.assign(table.batch_size + 1, 0);
+  for (int64_t b = 0; b < table.batch_size; ++b) {
+    offsets[b + 1] = offsets[b] + length_distribution(generator);
+  }
+  table.num_indices = offsets.back();
+
+  vector<int64_t> permutation(table.num_rows);
+  iota(permutation.begin(), permutation.end(), 0);
+  shuffle(permutation.begin(), permutation.end(), generator);
+  indices.resize(table.num_indices);
+  for (int64_t i = 0; i < table.num_indices; ++i) {
+    ZipfGenerator zipf(alpha, seed + i);
+    indices[i] = permutation[(zipf() - 1) % table.num_rows];
+  }
+  table.offsets = offsets.data();
+  table.indices = indices.data();
+}
+
+int64_t rowBytes(int bit_rate, int64_t embedding_dim) {
+  if (bit_rate == 32) {
+    return embedding_dim * sizeof(float);
+  }
+  if (bit_rate == 8) {
+    return embedding_dim + 2 * sizeof(float);
+  }
+  return (embedding_dim * bit_rate + 7) / 8 + 2 * sizeof(float16);
+}
+
+using TraceKernel = function<bool(const TraceTable&, const uint8_t*, float*)>;
+
+TraceKernel generateKernel(int bit_rate, int64_t embedding_dim, int prefetch) {
+  if (bit_rate == 32 || bit_rate == 8) {
+    auto run = [](auto kernel, auto in_type) -> TraceKernel {
+      using InType = decltype(in_type);
+      return [kernel](
+                 const TraceTable& t, const uint8_t* table, float* out) {
+        return kernel(
+            t.batch_size,
+            t.num_indices,
+            t.num_rows,
+            reinterpret_cast<const InType*>(table),
+            t.indices,
+            t.offsets,
+            nullptr,
+            out);
+      };
+    };
+    if (bit_rate == 32) {
+      return run(
+          GenerateEmbeddingSpMDM<float, int64_t, int64_t>(
+              embedding_dim, false, false, prefetch),
+          float());
+    }
+    return run(
+        GenerateEmbeddingSpMDM<uint8_t, int64_t, int64_t>(
+            embedding_dim, false, false, prefetch),
+        uint8_t());
+  }
+  auto kernel = GenerateEmbeddingSpMDMNBit<int64_t, int64_t>(
+      bit_rate, embedding_dim, false, false, prefetch);
+  return [kernel](const TraceTable& t, const uint8_t* table, float* out) {
+    return kernel(
+        t.batch_size,
+        t.num_indices,
+        t.num_rows,
+        table,
+        t.indices,
+        t.offsets,
+        nullptr,
+        out);
+  };
+}
+
+vector<vector<int>> defaultShapes() {
+  return {
+      // batch size, number of rows, embedding dim, average pooling factor
+      {64, 4000000, 64, 20},
+      {64, 4000000, 128, 20},
+      {64, 1000000, 128, 100},
+      {512, 100000, 32, 5},
+  };
+}
+
+} // namespace
+
+int main(int argc, const char* argv[]) {
+  const string trace_path = parseArgumentString(argc, argv, "--trace=", "");
+  const string write_path =
+      parseArgumentString(argc, argv, "--write_trace=", "");
+  const int bit_rate = parseArgumentInt(argc, argv, "--bit_rate=", 8, 8);
+  const double alpha =
+      parseArgumentInt(argc, argv, "--alpha=", 115, 115) / 100.0;
+  const bool flush = parseArgumentBool(argc, argv, "--flush", false);
+  if (bit_rate != 32 && bit_rate != 8 && bit_rate != 4 && bit_rate != 2) {
+    fprintf(stderr, "--bit_rate must be 32, 8, 4 or 2\n");
+    return 1;
+  }
+  if (alpha <= 1.0) {
+    fprintf(stderr, "--alpha must be above 100\n");
+    return 1;
+  }
+  BenchmarkReporter reporter("EmbeddingSpMDMTrace", argc, argv);
+  PerfCounters counters(parseArgumentBool(argc, argv, "--perf", false));
+
+  unique_ptr<MappedFile> trace;
+  vector<TraceTable> tables;
+  vector<vector<int64_t>> storage;
+  if (!trace_path.empty()) {
+    trace = make_unique<MappedFile>(trace_path);
+    tables = parseTrace(*trace, trace_path);
+  } else {
+    const auto shapes = parseArgumentShapes(argc, argv, 4, defaultShapes());
+    tables.resize(shapes.size());
+    storage.resize(2 * shapes.size());
+    for (size_t t = 0; t < shapes.size(); ++t) {
+      generateTable(
+          shapes[t], alpha, t, storage[2 * t], storage[2 * t + 1], tables[t]);
+    }
+    if (!write_path.empty()) {
+      writeTrace(write_path, tables);
+    }
+  }
+
+  std::vector<char> llc;
+  if (flush) {
+    llc.resize(128 * 1024 * 1024, 1.0);
+  }
+  constexpr int NUM_WARMUP = 5;
+  constexpr int NUM_ITER = 20;
+
+  cout << setw(6) << "table" << setw(10) << "rows" << setw(6) << "dim"
+       << setw(8) << "batch" << setw(10) << "indices" << setw(10)
+       << "unique" << setw(10) << "prefetch" << setw(12) << "time (us)"
+       << setw(10) << "GB/s" << setw(14) << "Mlookups/s" << endl;
+  for (size_t t = 0; t < tables.size(); ++t) {
+    const TraceTable& table = tables[t];
+    const int64_t row_bytes = rowBytes(bit_rate, table.embedding_dim);
+    // 0x3c bytes are normal float and float16 values (also as scale and
+    // bias), so no row is slowed down by denormals.
+    vector<uint8_t> embedding_table(table.num_rows * row_bytes, 0x3c);
+    vector<float> output(table.batch_size * table.embedding_dim);
+
+    vector<int64_t> sorted(table.indices, table.indices + table.num_indices);
+    sort(sorted.begin(), sorted.end());
+    const int64_t num_unique =
+        unique(sorted.begin(), sorted.end()) - sorted.begin();
+
+    for (int prefetch : {0, kEmbeddingPrefetchTuned}) {
+      const auto kernel =
+          generateKernel(bit_rate, table.embedding_dim, prefetch);
+      bool success = true;
+      BenchmarkRecord record;
+      record.kernel =
+          prefetch == 0 ? "asmjit_no_prefetch" : "asmjit_tuned_prefetch";
+      record.shape = {
+          {"table", t},
+          {"bit_rate", bit_rate},
+          {"num_rows", table.num_rows},
+          {"embedding_dim", table.embedding_dim},
+          {"batch_size", table.batch_size},
+          {"num_indices", table.num_indices},
+          {"num_unique", num_unique},
+          {"flush_cache", flush}};
+      // Rows read, indices and offsets
+      record.bytes = table.num_indices * (row_bytes + sizeof(int64_t)) +
+          (table.batch_size + 1) * sizeof(int64_t);
+      record.seconds = measureSamplesWithWarmup(
+          [&]() {
+            success = kernel(table, embedding_table.data(), output.data()) &&
+                success;
+          },
+          NUM_WARMUP,
+          NUM_ITER,
+          [&]() {
+            if (flush) {
+              llc_flush(llc);
+            }
+          },
+          &counters);
+      if (!success) {
+        fprintf(stderr, "Table %zu has indices out of bounds\n", t);
+        return 1;
+      }
+      record.counters = counters.read();
+      reporter.report(record);
+
+      const double time =
+          accumulate(record.seconds.begin(), record.seconds.end(), 0.0) /
+          record.seconds.size();
+      cout << setw(6) << t << setw(10) << table.num_rows << setw(6)
+           << table.embedding_dim << setw(8) << table.batch_size << setw(10)
+           << table.num_indices << setw(10) << num_unique << setw(10)
+           << (prefetch == 0 ? "off" : "tuned") << setw(12) << fixed
+           << setprecision(2) << time * 1e6 << setw(10)
+           << record.bytes / time / 1e9
+           << setw(14) << table.num_indices / time / 1e6 << endl;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Finds the best software prefetch distance of the embedding kernels for each
+// (bit_rate, block_size) on the current instruction set. The output can be
+// loaded with loadEmbeddingPrefetchTable() or through the
+// FBGEMM_EMBEDDING_PREFETCH_TABLE environment variable.
+//
+// Usage: EmbeddingSpMDMTunableBenchmark [output_file]
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "./BenchUtils.h"
+#include "fbgemm/Fbgemm.h"
+#include "fbgemm/FbgemmEmbedding.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+constexpr int kBatchSize = 64;
+constexpr int kAverageLen = 100;
+// Large enough for the tables to be far out of the last level cache.
+constexpr int64_t kTableBytes = 512 * 1024 * 1024;
+
+int64_t rowBytes(int bit_rate, int64_t block_size) {
+  const int64_t data_bytes = (block_size * bit_rate + 7) / 8;
+  if (bit_rate == 8) {
+    return data_bytes + 2 * sizeof(float);
+  }
+  return bit_rate < 8 ? data_bytes + 2 * sizeof(float16) : data_bytes;
+}
+
+template <typename InType>
+typename EmbeddingSpMDMKernelSignature<InType, int64_t, int32_t>::Type
+generateKernel(int bit_rate, int64_t block_size, int prefetch) {
+  if constexpr (is_same_v<InType, uint8_t>) {
+    if (bit_rate != 8) {
+      return GenerateEmbeddingSpMDMNBit<int64_t>(
+          bit_rate,
+          block_size,
+          /*has_weight=*/false,
+          /*normalize_by_lengths=*/false,
+          prefetch);
+    }
+  }
+  return GenerateEmbeddingSpMDM<InType, int64_t>(
+      block_size,
+      /*has_weight=*/false,
+      /*normalize_by_lengths=*/false,
+      prefetch);
+}
+
+// Returns the fastest prefetch distance among the candidates.
+template <typename InType>
+int tunePrefetch(int bit_rate, int64_t block_size) {
+  const int64_t row_bytes = rowBytes(bit_rate, block_size);
+  const int64_t num_rows = kTableBytes / row_bytes;
+
+  // 0x3c bytes are normal float and float16 values (also as scale and
+  // bias), so no row is slowed down by denormals.
+  vector<uint8_t> table(num_rows * row_bytes, 0x3c);
+  default_random_engine generator;
+
+  uniform_int_distribution<int> length_distribution(1, 2 * kAverageLen - 1);
+  vector<int32_t> offsets(kBatchSize + 1, 0);
+  for (int i = 0; i < kBatchSize; ++i) {
+    offsets[i + 1] = offsets[i] + length_distribution(generator);
+  }
+  uniform_int_distribution<int64_t> index_distribution(0, num_rows - 1);
+  vector<int64_t> indices(offsets.back());
+  for (auto& v : indices) {
+    v = index_distribution(generator);
+  }
+  vector<float> output(kBatchSize * block_size);
+
+  int best_prefetch = 0;
+  double best_time = 0.0;
+  for (int prefetch : {0, 1, 2, 4, 8, 16, 32, 64}) {
+    auto kernel = generateKernel<InType>(bit_rate, block_size, prefetch);
+    double t = measureWithWarmup(
+        [&]() {
+          kernel(
+              kBatchSize,
+              offsets.back(),
+              num_rows,
+              reinterpret_cast<const InType*>(table.data()),
+              indices.data(),
+              offsets.data(),
+              nullptr,
+              output.data());
+        },
+        /*warmupIterations=*/10,
+        /*measuredIterations=*/100);
+    cout << setw(8) << bit_rate << setw(12) << block_size << setw(10)
+         << prefetch << setw(14) << fixed << setprecision(2) << t * 1e6
+         << endl;
+    if (prefetch == 0 || t < best_time) {
+      best_prefetch = prefetch;
+      best_time = t;
+    }
+  }
+  return best_prefetch;
+}
+
+} // namespace
+
+int main(int argc, const char* argv[]) {
+  const inst_set_t isa = fbgemmInstructionSet();
+  if (isa == inst_set_t::anyarch) {
+    cout << "No JIT embedding kernels on this CPU" << endl;
+    return 0;
+  }
+
+  cout << setw(8) << "bit_rate" << setw(12) << "block_size" << setw(10)
+       << "prefetch" << setw(14) << "time (us)" << endl;
+  vector<string> entries;
+  for (int bit_rate : {32, 16, 8, 4, 2}) {
+    for (int64_t block_size : {16, 32, 64, 128, 256, 512}) {
+      int prefetch;
+      if (bit_rate == 32) {
+        prefetch = tunePrefetch<float>(bit_rate, block_size);
+      } else if (bit_rate == 16) {
+        prefetch = tunePrefetch<float16>(bit_rate, block_size);
+      } else {
+        prefetch = tunePrefetch<uint8_t>(bit_rate, block_size);
+      }
+      entries.push_back(
+          string(instSetName(isa)) + " " + to_string(bit_rate) + " " +
+          to_string(block_size) + " " + to_string(prefetch));
+    }
+  }
+
+  cout << endl << "# ISA bit_rate block_size prefetch" << endl;
+  for (const auto& entry : entries) {
+    cout << entry << endl;
+  }
+  if (argc > 1) {
+    ofstream out(argv[1], ios::app);
+    for (const auto& entry : entries) {
+      out << entry << endl;
+    }
+    if (!out) {
+      cerr << "Failed to write " << argv[1] << endl;
+      return 1;
+    }
+  }
+  return 0;
+}
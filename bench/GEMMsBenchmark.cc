@@ -29,13 +29,9 @@
 using namespace std;
 using namespace fbgemm;
 
-void performance_test(
-    const int M,
-    const int N,
-    const int K,
-    const bool timebreak) {
+vector<vector<int>> default_shapes(const int M, const int N, const int K) {
   // clang-format off
-  const vector<vector<int>> shapes = {
+  return {
     // NOTE: clang-format wants to use a different formatting but the current
     // formatting should be easier to read.
     // m, n, k
@@ -46,8 +42,15 @@ void performance_test(
     {M?M:256, N?N:512, K?K:256},
     {M?M:1024, N?N:1024, K?K:1024},
   };
-
   // clang-format on
+}
+
+void performance_test(
+    const vector<vector<int>>& shapes,
+    const bool timebreak,
+    BenchmarkReporter& reporter,
+    PerfCounters& counters,
+    const MachinePeaks* peaks) {
   bool flush = true;
   std::vector<char> llc;
 
@@ -66,10 +69,11 @@ void performance_test(
          << "Type, " << setw(18) << "Packing (us), " << setw(18)
          << "Kernel (us), " << setw(18) << "Postproc (us), " << setw(18)
          << "Computation (us)," << setw(18) << "Total (us), " << setw(5)
-         << "GOPs" << endl;
+         << "GOPs" << (peaks ? rooflineHeader() : "") << endl;
   } else {
     cout << setw(8) << "M, " << setw(8) << "N, " << setw(8) << "K, " << setw(18)
-         << "Type, " << setw(5) << "GOPS" << endl;
+         << "Type, " << setw(5) << "GOPS" << (peaks ? rooflineHeader() : "")
+         << endl;
   }
 
   chrono::time_point<chrono::high_resolution_clock> start, end;
@@ -100,11 +104,27 @@ void performance_test(
     double nops = 2.0 * m * n * k;
     double ttot = 0.0;
     string runType;
+    BenchmarkRecord record;
+    record.shape = {{"M", m}, {"N", n}, {"K", k}};
+    record.flops = nops;
+    RooflineBound bound;
+    // Sets the memory traffic of the next kernel, reading A and B and writing
+    // C once, and its roofline bound with the given compute peak
+    auto setTraffic = [&](double bytes, double peak_gops) {
+      record.bytes = bytes;
+      if (peaks) {
+        bound = rooflineBound(nops, bytes, peak_gops, peaks->bandwidth_gbs);
+        record.attainable_gflops = bound.attainable_gops;
+      }
+    };
 #ifdef USE_MKL
     const float alpha = 1.f;
     const float beta = 0.f;
     runType = "MKL_fp32";
-    ttot = measureWithWarmup(
+    record.kernel = runType;
+    setTraffic(
+        4.0 * (m * k + k * n + m * n), peaks ? peaks->fp32_gflops : 0.0);
+    record.seconds = measureSamplesWithWarmup(
         [&]() {
           cblas_sgemm(
               CblasRowMajor,
@@ -128,8 +148,15 @@ void performance_test(
           if (flush) {
             llc_flush(llc);
           }
-        });
-    ttot *= 1e9; // convert to ns
+        },
+        &counters);
+    record.counters = counters.read();
+    reporter.report(record);
+    ttot = 0.0;
+    for (const double t : record.seconds) {
+      ttot += t;
+    }
+    ttot *= 1e9 / NITER; // convert to ns
 
     ((volatile char*)(llc.data()));
 
@@ -141,8 +168,11 @@ void performance_test(
            << ", " << setw(16) << ttot / 1e3 << ", ";
     }
 
-    cout << setw(5) << fixed << setw(5) << setprecision(1) << nops / ttot
-         << endl;
+    cout << setw(5) << fixed << setw(5) << setprecision(1) << nops / ttot;
+    if (peaks) {
+      cout << formatRooflineColumns(bound, nops / ttot);
+    }
+    cout << endl;
 
     for (size_t i = 0; i < Cfp32_mkl.size(); ++i) {
       Cint32_mkl[i] = (int32_t)Cfp32_mkl[i];
@@ -166,6 +196,12 @@ void performance_test(
 
     ttot = 0.0;
     runType = "FBGEMM_i8_acc32";
+    record.kernel = runType;
+    setTraffic(
+        m * k + k * n + 4.0 * m * n, peaks ? peaks->int8_gops : 0.0);
+    record.seconds.clear();
+    record.threads = fbgemm_get_max_threads();
+    counters.reset();
 
     double packing_time = 0.0, total_packing_time = 0.0;
     double computing_time = 0.0, total_computing_time = 0.0;
@@ -186,6 +222,9 @@ void performance_test(
         run_time = 0.0;
       }
       llc_flush(llc);
+      if (i >= NWARMUP) {
+        counters.start();
+      }
       start = chrono::high_resolution_clock::now();
 
 #ifdef _OPENMP
@@ -214,8 +253,10 @@ void performance_test(
       end = chrono::high_resolution_clock::now();
 
       if (i >= NWARMUP) {
+        counters.stop();
         auto dur = chrono::duration_cast<chrono::nanoseconds>(end - start);
         ttot += dur.count();
+        record.seconds.push_back(dur.count() / 1e9);
         run_time = dur.count();
         if (timebreak) {
           total_packing_time += packing_time;
@@ -246,8 +287,14 @@ void performance_test(
     }
 
     cout << ", " << setw(5) << fixed << setw(5) << setprecision(1)
-         << NITER * nops / ttot << endl;
+         << NITER * nops / ttot;
+    if (peaks) {
+      cout << formatRooflineColumns(bound, NITER * nops / ttot);
+    }
+    cout << endl;
 
+    record.counters = counters.read();
+    reporter.report(record);
     compare_buffers(Cint32_ref.data(), Cint32_fb_acc32.data(), m, n, n, 5);
 
     PackBMatrix<int8_t, int16_t> packedB_int16(
@@ -255,6 +302,12 @@ void performance_test(
 
     ttot = 0.0;
     runType = "FBGEMM_i8_acc16";
+    record.kernel = runType;
+    setTraffic(
+        m * k + k * n + 4.0 * m * n, peaks ? peaks->int8_gops : 0.0);
+    record.seconds.clear();
+    record.threads = fbgemm_get_max_threads();
+    counters.reset();
     if (timebreak) {
       total_packing_time = 0.0;
       total_computing_time = 0.0;
@@ -274,6 +327,9 @@ void performance_test(
         run_time = 0.0;
       }
       llc_flush(llc);
+      if (i >= NWARMUP) {
+        counters.start();
+      }
       start = chrono::high_resolution_clock::now();
 
 #ifdef _OPENMP
@@ -302,8 +358,10 @@ void performance_test(
       end = chrono::high_resolution_clock::now();
 
       if (i >= NWARMUP) {
+        counters.stop();
         auto dur = chrono::duration_cast<chrono::nanoseconds>(end - start);
         ttot += dur.count();
+        record.seconds.push_back(dur.count() / 1e9);
         run_time = dur.count();
         if (timebreak) {
           total_packing_time += packing_time;
@@ -336,9 +394,15 @@ void performance_test(
     }
 
     cout << ", " << setw(5) << fixed << setw(5) << setprecision(1)
-         << NITER * nops / ttot << endl;
+         << NITER * nops / ttot;
+    if (peaks) {
+      cout << formatRooflineColumns(bound, NITER * nops / ttot);
+    }
+    cout << endl;
     cout << endl;
 
+    record.counters = counters.read();
+    reporter.report(record);
     compare_buffers(Cint32_ref.data(), Cint32_fb_acc16.data(), m, n, n, 5);
   }
 }
@@ -355,7 +419,21 @@ int main(int argc, const char** argv) {
   const int N = parseArgumentInt(argc, argv, "--N=", 0, 0);
   const int K = parseArgumentInt(argc, argv, "--K=", 0, 0);
   const bool timebreak = parseArgumentBool(argc, argv, "--timebreak", false);
+  const auto shapes =
+      parseArgumentShapes(argc, argv, 3, default_shapes(M, N, K));
+  BenchmarkReporter reporter("GEMMs", argc, argv);
+  // Opened before the first parallel region so that the OpenMP threads are
+  // counted too
+  PerfCounters counters(parseArgumentBool(argc, argv, "--perf", false));
+  // Fraction of the roofline of the host reached by each kernel
+  const bool roofline = parseArgumentBool(argc, argv, "--roofline", false);
+  MachinePeaks peaks;
+  if (roofline) {
+    peaks = measureMachinePeaks(fbgemm_get_max_threads());
+    printMachinePeaks(peaks);
+  }
 
-  performance_test(M, N, K, timebreak);
+  performance_test(
+      shapes, timebreak, reporter, counters, roofline ? &peaks : nullptr);
   return 0;
 }
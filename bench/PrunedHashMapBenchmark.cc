@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "./BenchUtils.h"
+#include "fbgemm/FbgemmEmbedding.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+uint32_t murmurMix(uint32_t h) {
+  h ^= h >> 16;
+  h *= 0x85ebca6b;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35;
+  h ^= h >> 16;
+  return h;
+}
+
+// Scalar linear probing over the [capacity, 2] table, as done by fbgemm_gpu
+// pruned_hashmap_lookup
+void linearProbingLookup(
+    const vector<int32_t>& queries,
+    const vector<int32_t>& table,
+    int64_t capacity,
+    vector<int32_t>& dense_indices) {
+  for (size_t i = 0; i < queries.size(); ++i) {
+    const int32_t idx = queries[i];
+    int64_t slot = murmurMix(idx) % capacity;
+    while (true) {
+      const int32_t key = table[2 * slot];
+      if (key == -1) {
+        dense_indices[i] = -1;
+        break;
+      }
+      if (key == idx) {
+        dense_indices[i] = table[2 * slot + 1];
+        break;
+      }
+      slot = (slot + 1) % capacity;
+    }
+  }
+}
+
+void run_benchmark(int num_rows, float load_factor, int num_queries) {
+  constexpr int NWARMUP = 2;
+  constexpr int NITER = 10;
+  default_random_engine generator(num_rows);
+  uniform_int_distribution<int32_t> index_dist(
+      0, numeric_limits<int32_t>::max() / 2);
+
+  // Rows of even ids are kept, queries hit them 90% of the time
+  vector<int32_t> indices(num_rows), dense_indices(num_rows);
+  for (int i = 0; i < num_rows; ++i) {
+    indices[i] = 2 * index_dist(generator);
+    dense_indices[i] = i;
+  }
+  const int64_t capacity = static_cast<int64_t>(num_rows / load_factor) + 1;
+
+  vector<int32_t> table(2 * capacity, -1);
+  for (int i = 0; i < num_rows; ++i) {
+    int64_t slot = murmurMix(indices[i]) % capacity;
+    while (table[2 * slot] != -1 && table[2 * slot] != indices[i]) {
+      slot = (slot + 1) % capacity;
+    }
+    table[2 * slot] = indices[i];
+    table[2 * slot + 1] = dense_indices[i];
+  }
+
+  const vector<int64_t> hash_table_offsets = {0, capacity};
+  vector<int64_t> group_offsets(2);
+  pruned_hashmap_grouped_offsets(
+      1, hash_table_offsets.data(), group_offsets.data());
+  vector<int32_t> groups(group_offsets[1] * 2 * kPrunedHashMapGroupSize);
+  const vector<int32_t> offsets = {0, num_rows};
+  if (!pruned_hashmap_grouped_build(
+          1,
+          1,
+          indices.data(),
+          dense_indices.data(),
+          offsets.data(),
+          group_offsets.data(),
+          groups.data())) {
+    cerr << "grouped map build failed" << endl;
+    return;
+  }
+
+  uniform_int_distribution<int> row_dist(0, num_rows - 1);
+  bernoulli_distribution hit_dist(0.9);
+  vector<int32_t> queries(num_queries);
+  for (auto& q : queries) {
+    q = hit_dist(generator) ? indices[row_dist(generator)]
+                            : 2 * index_dist(generator) + 1;
+  }
+  const vector<int32_t> query_offsets = {0, num_queries};
+  vector<int32_t> out_ref(num_queries), out(num_queries);
+
+  const double duration_ref = measureWithWarmup(
+      [&]() { linearProbingLookup(queries, table, capacity, out_ref); },
+      NWARMUP,
+      NITER);
+  const double duration = measureWithWarmup(
+      [&]() {
+        pruned_hashmap_grouped_lookup(
+            1,
+            1,
+            queries.data(),
+            query_offsets.data(),
+            groups.data(),
+            group_offsets.data(),
+            out.data());
+      },
+      NWARMUP,
+      NITER);
+
+  if (out != out_ref) {
+    cerr << "grouped lookup does not match linear probing" << endl;
+  }
+  cout << fixed << setprecision(2) << "num rows" << setw(10) << num_rows
+       << " load factor" << setw(5) << load_factor << " linear: " << setw(6)
+       << duration_ref * 1e9 / num_queries << " ns/index, grouped: "
+       << setw(6) << duration * 1e9 / num_queries << " ns/index, speedup "
+       << duration_ref / duration << endl;
+}
+
+} // namespace
+
+int main() {
+  constexpr int num_queries = 1 << 20;
+  for (int num_rows : {1 << 14, 1 << 18, 1 << 22, 1 << 24}) {
+    for (float load_factor : {0.5f, 0.8f}) {
+      run_benchmark(num_rows, load_factor, num_queries);
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "./BenchUtils.h"
+#include "fbgemm/Fbgemm.h"
+#include "fbgemm/FbgemmSparse.h"
+#include "src/RefImplementations.h"
+
+using namespace std;
+using namespace fbgemm;
+
+// Compares the 2:4 structured sparse GEMM against dense fbgemmPacked on the
+// same weights, both requantizing to uint8. GOPS count the dense operations
+// so the numbers are directly comparable.
+int main() {
+  // clang-format off
+  vector<vector<int>> shapes = {
+    // m, n, k
+    {1, 1024, 1024},
+    {1, 4096, 1024},
+    {16, 1024, 1024},
+    {16, 4096, 1024},
+    {64, 1024, 4096},
+    {128, 768, 768},
+    {128, 3072, 768},
+    {256, 1024, 1024},
+    {1024, 512, 512},
+  };
+  // clang-format on
+
+  constexpr int NWARMUP = 4;
+  constexpr int NITER = 20;
+  std::vector<char> llc(128 * 1024 * 1024, 1.0);
+
+  cout << setw(8) << "M, " << setw(8) << "N, " << setw(8) << "K, " << setw(18)
+       << "dense GOPS, " << setw(18) << "2:4 GOPS, " << setw(10) << "speedup"
+       << endl;
+
+  default_random_engine generator;
+  for (auto shape : shapes) {
+    int m = shape[0];
+    int n = shape[1];
+    int k = shape[2];
+
+    aligned_vector<uint8_t> Aint8(m * k);
+    randFill<uint8_t>(Aint8, 0, 255);
+    int32_t Aint8_zero_point = 43;
+
+    // Keep 2 random values of every group of 4 rows of each column
+    aligned_vector<int8_t> Bint8(k * n);
+    randFill<int8_t>(Bint8, -128, 127);
+    for (int j = 0; j < n; ++j) {
+      for (int g = 0; g < k; g += 4) {
+        int pos[4] = {0, 1, 2, 3};
+        shuffle(pos, pos + 4, generator);
+        for (int e = 2; e < 4; ++e) {
+          if (g + pos[e] < k) {
+            Bint8[(g + pos[e]) * n + j] = 0;
+          }
+        }
+      }
+    }
+    int32_t Bint8_zero_point = 0;
+    vector<int32_t> col_offsets(n);
+    col_offsets_with_zero_pt_s8acc32_ref(
+        k, n, n, Bint8.data(), &Bint8_zero_point, col_offsets.data(), n);
+
+    float C_multiplier = 0.001234f;
+    int32_t C_zero_pt = 5;
+
+    aligned_vector<int32_t> Cint32_buffer(m * n);
+    aligned_vector<uint8_t> Cint8_dense(m * n);
+    aligned_vector<uint8_t> Cint8_sparse(m * n);
+
+    PackBMatrix<int8_t> packedBN(
+        matrix_op_t::NoTranspose, k, n, Bint8.data(), n, nullptr, 1);
+    PackBMatrixSparse24 packedB24(
+        matrix_op_t::NoTranspose, k, n, Bint8.data(), n);
+
+    double nops = 2.0 * m * n * k;
+
+    double dense_secs = measureWithWarmup(
+        [&]() {
+          PackAMatrix<uint8_t> packA(
+              matrix_op_t::NoTranspose, m, k, Aint8.data(), k, nullptr, 1);
+          DoNothing<> doNothingObj{};
+          ReQuantizeOutput<false> outputProcObj(
+              doNothingObj,
+              &C_multiplier,
+              C_zero_pt,
+              Aint8_zero_point,
+              &Bint8_zero_point,
+              nullptr,
+              col_offsets.data(),
+              nullptr,
+              n);
+          fbgemmPacked(
+              packA,
+              packedBN,
+              Cint8_dense.data(),
+              Cint32_buffer.data(),
+              n,
+              outputProcObj,
+              fbgemm_get_thread_num(),
+              fbgemm_get_num_threads());
+        },
+        NWARMUP,
+        NITER,
+        [&]() { llc_flush(llc); },
+        true /*useOpenMP*/);
+
+    double sparse_secs = measureWithWarmup(
+        [&]() {
+          DoNothing<> doNothingObj{};
+          ReQuantizeOutput<false> outputProcObj(
+              doNothingObj,
+              &C_multiplier,
+              C_zero_pt,
+              Aint8_zero_point,
+              &Bint8_zero_point,
+              nullptr,
+              packedB24.colOffsets(),
+              nullptr,
+              n);
+          fbgemmU8S8Sparse24Gemm(
+              m,
+              Aint8.data(),
+              k,
+              packedB24,
+              Cint8_sparse.data(),
+              Cint32_buffer.data(),
+              n,
+              outputProcObj,
+              fbgemm_get_thread_num(),
+              fbgemm_get_num_threads());
+        },
+        NWARMUP,
+        NITER,
+        [&]() { llc_flush(llc); },
+        true /*useOpenMP*/);
+
+    if (Cint8_dense != Cint8_sparse) {
+      cerr << "Results differ for m " << m << " n " << n << " k " << k
+           << endl;
+      return 1;
+    }
+
+    cout << setw(6) << m << ", " << setw(6) << n << ", " << setw(6) << k
+         << ", " << setw(16) << fixed << setprecision(1)
+         << nops / dense_secs / 1e9 << ", " << setw(16)
+         << nops / sparse_secs / 1e9 << ", " << setw(10) << setprecision(2)
+         << dense_secs / sparse_secs << endl;
+  }
+  return 0;
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "./BenchUtils.h"
+#include "fbgemm/Fbgemm.h"
+
+using namespace std;
+using namespace fbgemm;
+
+static vector<vector<int>> GetInputs_() {
+  vector<vector<int>> input_dims = {
+      // batch size, number of rows of table, emb dim , avg length
+      {10, 500000, 32, 100},
+      {10, 500000, 64, 100},
+      {10, 500000, 128, 100},
+      {10, 500000, 256, 100},
+  };
+  return input_dims;
+}
+
+// Compares the fused element-wise SparseAdaGrad with expanding the SLS
+// gradient per index and running SparseAdaGrad on it.
+void run_benchmark(
+    int batch_size,
+    int num_rows,
+    int embedding_dim,
+    int average_len,
+    bool prefetch) {
+  vector<char> llc(64L * 1024L * 1024L, 1.0);
+  vector<float> g(batch_size * embedding_dim);
+  vector<float> h(static_cast<size_t>(num_rows) * embedding_dim);
+  vector<float> w(static_cast<size_t>(num_rows) * embedding_dim);
+
+  default_random_engine generator;
+  uniform_real_distribution<float> values_gen(0, 2);
+  for (auto& v : g) {
+    v = values_gen(generator);
+  }
+  for (auto& v : h) {
+    v = values_gen(generator);
+  }
+  for (auto& v : w) {
+    v = values_gen(generator);
+  }
+
+  uniform_int_distribution<int> length_distribution(
+      1, std::min(2 * average_len + 1, num_rows));
+  vector<int> offsets(batch_size + 1);
+  offsets[0] = 0;
+  for (int i = 0; i < batch_size; ++i) {
+    offsets[i + 1] = offsets[i] + length_distribution(generator);
+  }
+  int lengths_sum = offsets[batch_size];
+
+  // Unique indices within each bag
+  vector<int64_t> indices;
+  vector<int> container(num_rows);
+  for (int i = 0; i < batch_size; ++i) {
+    iota(container.begin(), container.end(), 0);
+    shuffle(container.begin(), container.end(), generator);
+    copy(
+        container.begin(),
+        container.begin() + (offsets[i + 1] - offsets[i]),
+        back_inserter(indices));
+  }
+
+  float epsilon = 1e-5;
+  float lr = 0.5;
+
+  constexpr int NUM_WARMUP = 4;
+  constexpr int NUM_ITER = 10;
+  // Reading and writing w and h of every index
+  double bytes = lengths_sum *
+      (embedding_dim * sizeof(float) * 4 + sizeof(int64_t));
+
+  auto fused = GenerateSparseAdaGradFused<int64_t>(
+      embedding_dim, prefetch ? 16 : 0);
+  auto unfused = GenerateSparseAdaGrad<int64_t>(
+      embedding_dim, false /* rowwise */, prefetch ? 16 : 0);
+  vector<float> g_expanded(static_cast<size_t>(lengths_sum) * embedding_dim);
+
+  double t_fused = measureWithWarmup(
+      [&]() {
+        fused(
+            batch_size,
+            lengths_sum,
+            num_rows,
+            w.data(),
+            g.data(),
+            h.data(),
+            indices.data(),
+            offsets.data(),
+            epsilon,
+            lr);
+      },
+      NUM_WARMUP,
+      NUM_ITER,
+      [&]() { llc_flush(llc); });
+
+  double t_unfused = measureWithWarmup(
+      [&]() {
+        for (int m = 0; m < batch_size; ++m) {
+          for (int i = offsets[m]; i < offsets[m + 1]; ++i) {
+            copy(
+                g.begin() + m * embedding_dim,
+                g.begin() + (m + 1) * embedding_dim,
+                g_expanded.begin() + static_cast<size_t>(i) * embedding_dim);
+          }
+        }
+        unfused(
+            lengths_sum,
+            w.size(),
+            w.data(),
+            g_expanded.data(),
+            h.data(),
+            indices.data(),
+            epsilon,
+            lr,
+            0.0f,
+            nullptr,
+            0);
+      },
+      NUM_WARMUP,
+      NUM_ITER,
+      [&]() { llc_flush(llc); });
+
+  cout << setw(16) << (prefetch ? "prefetch on" : "prefetch off")
+       << setw(8) << "fused" << setw(10) << bytes / 1e9 / t_fused << " GB/s"
+       << setw(10) << "unfused" << setw(10) << bytes / 1e9 / t_unfused
+       << " GB/s" << setw(10) << "speedup" << setw(8) << setprecision(3)
+       << t_unfused / t_fused << endl;
+}
+
+int main() {
+  for (auto& input : GetInputs_()) {
+    int batch_size = input[0];
+    int num_rows = input[1];
+    int embedding_dim = input[2];
+    int average_len = input[3];
+
+    cout << "batch size" << setw(6) << batch_size << setw(10) << "num rows"
+         << setw(16) << num_rows << setw(10) << "emb dim" << setw(6)
+         << embedding_dim << setw(16) << "avg length" << setw(6) << average_len
+         << endl;
+    for (bool prefetch : {false, true}) {
+      run_benchmark(
+          batch_size, num_rows, embedding_dim, average_len, prefetch);
+    }
+  }
+  return 0;
+}
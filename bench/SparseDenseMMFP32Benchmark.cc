@@ -73,7 +73,10 @@ int main(int, char**) {
                 atData.data(),
                 ldat,
                 ctDataIntrin.data(),
-                ldct);
+                ldct,
+                false /* accum */,
+                fbgemm_get_thread_num(),
+                fbgemm_get_num_threads());
           },
           NWARMUP,
           NITER,
@@ -83,7 +86,8 @@ int main(int, char**) {
             cache_evict(csr->colIdx);
             cache_evict(csr->values);
             cache_evict(ctDataIntrin);
-          });
+          },
+          true /*useOpenMP*/);
 
       // printMatrix(matrix_op_t::NoTranspose, btData.data(), n, k, k,
       // "btData");
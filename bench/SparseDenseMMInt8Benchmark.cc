@@ -12,6 +12,7 @@
 #include "fbgemm/spmmUtils.h"
 #include "src/RefImplementations.h"
 
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 
@@ -27,7 +28,8 @@ int main(int, char**) {
 
   cout << setw(7) << "index" << setw(7) << "m" << setw(7) << "n" << setw(7)
        << "k" << setw(7) << "fnz" << setw(15) << "eff_GFLOPS" << setw(15)
-       << "real_GFLOPS" << endl;
+       << "real_GFLOPS" << setw(10) << "colTile" << setw(10) << "rowTile"
+       << setw(15) << "tuned_GFLOPS" << endl;
 
   int index = 0;
   for (auto const& s : shapes) {
@@ -111,28 +113,36 @@ int main(int, char**) {
       constexpr int NWARMUP = 20;
       constexpr int NITER = 100;
 
-      auto secs_intrin = measureWithWarmup(
-          [&]() {
-            fbgemmSparseDenseInt8MM<false, QuantizationGranularity::TENSOR>(
-                m,
-                bcsr,
-                atData.data(),
-                ldat,
-                ctDataIntrin_i32.data(),
-                ctDataIntrin_u8.data(),
-                ldct,
-                reqParams);
-          },
-          NWARMUP,
-          NITER,
-          [&]() {
-            cache_evict(atData);
-            cache_evict(bcsr->rowBPtr);
-            cache_evict(bcsr->colBIdx);
-            cache_evict(bcsr->values);
-            cache_evict(ctDataIntrin_i32);
-            cache_evict(ctDataIntrin_u8);
-          });
+      auto measureMM = [&](const unique_ptr<BCSRMatrix<>>& mat) {
+        return measureWithWarmup(
+            [&]() {
+              fbgemmSparseDenseInt8MM<false, QuantizationGranularity::TENSOR>(
+                  m,
+                  mat,
+                  atData.data(),
+                  ldat,
+                  ctDataIntrin_i32.data(),
+                  ctDataIntrin_u8.data(),
+                  ldct,
+                  reqParams,
+                  false /* accum */,
+                  fbgemm_get_thread_num(),
+                  fbgemm_get_num_threads());
+            },
+            NWARMUP,
+            NITER,
+            [&]() {
+              cache_evict(atData);
+              cache_evict(mat->rowBPtr);
+              cache_evict(mat->colBIdx);
+              cache_evict(mat->values);
+              cache_evict(ctDataIntrin_i32);
+              cache_evict(ctDataIntrin_u8);
+            },
+            true /*useOpenMP*/);
+      };
+
+      auto secs_intrin = measureMM(bcsr);
 
       // printMatrix(matrix_op_t::NoTranspose, btData.data(), n, k, k,
       // "btData");
@@ -162,23 +172,65 @@ int main(int, char**) {
       // "ctDataIntrin_u8");
       //
       // Compare results
-      for (size_t i = 0; i < ctDataRef.size(); i++) {
-        if (std::abs(ctDataRef_u8[i] - ctDataIntrin_u8[i]) > 0) {
-          fprintf(
-              stderr,
-              "Error: Results differ ref %d and test %d at %ld\n",
-              ctDataRef_u8[i],
-              ctDataIntrin_u8[i],
-              i);
-          return 1;
+      auto matchesRef = [&]() {
+        for (size_t i = 0; i < ctDataRef.size(); i++) {
+          if (std::abs(ctDataRef_u8[i] - ctDataIntrin_u8[i]) > 0) {
+            fprintf(
+                stderr,
+                "Error: Results differ ref %d and test %d at %ld\n",
+                ctDataRef_u8[i],
+                ctDataIntrin_u8[i],
+                i);
+            return false;
+          }
+        }
+        return true;
+      };
+      if (!matchesRef()) {
+        return 1;
+      }
+
+      // Autotune the column and row tile sizes. Column tiles larger than k
+      // all pack to the same single tile so only the first one is tried.
+      constexpr int CB = BCSRMatrix<>::CB;
+      vector<int> colTiles;
+      for (int t : {256, 512, 1024, 2000, BCSRMatrix<>::COLTILE}) {
+        int colTile = min(t, (k + CB - 1) / CB * CB);
+        if (find(colTiles.begin(), colTiles.end(), colTile) == colTiles.end()) {
+          colTiles.push_back(colTile);
+        }
+      }
+      int best_col_tile = bcsr->colTile;
+      int best_row_tile = bcsr->rowTile;
+      double best_secs = secs_intrin;
+      for (int colTile : colTiles) {
+        unique_ptr<BCSRMatrix<>> tuned =
+            fbgemmDenseToBCSR(n, k, btData.data(), k, colTile);
+        for (int rowTile : {0, 64, 256, 1024}) {
+          if (rowTile >= n) {
+            continue;
+          }
+          tuned->rowTile = rowTile;
+          double secs = measureMM(tuned);
+          if (!matchesRef()) {
+            return 1;
+          }
+          if (secs < best_secs) {
+            best_secs = secs;
+            best_col_tile = colTile;
+            best_row_tile = rowTile;
+          }
         }
       }
 
       double effective_gflops_intrin = effective_flop / secs_intrin / 1e9;
+      double effective_gflops_tuned = effective_flop / best_secs / 1e9;
       cout << "[" << setw(5) << index << "]" << setw(7) << m << setw(7) << n
            << setw(7) << k << fixed << setw(7) << setprecision(2) << fnz
            << setw(15) << setprecision(5) << effective_gflops_intrin << setw(15)
-           << setprecision(5) << fnz * effective_gflops_intrin << endl;
+           << setprecision(5) << fnz * effective_gflops_intrin << setw(10)
+           << best_col_tile << setw(10) << best_row_tile << setw(15)
+           << setprecision(5) << effective_gflops_tuned << endl;
       ++index;
     }
   }
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "bench/BenchUtils.h"
+#include "fbgemm/FbgemmSparse.h"
+
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace std;
+using namespace fbgemm;
+
+// Times packing dense weights to BCSR and CSR, serially and with all threads,
+// and repacking after 1% of the row blocks changed.
+int main(int, char**) {
+  // clang-format off
+  // {N, K, fraction of non-zeros}
+  vector<vector<float>> shapes = {
+    {1024, 1024, 0.1f},
+    {4096, 4096, 0.05f},
+    {8192, 2048, 0.01f},
+    {1024, 16384, 0.2f},
+  };
+  // clang-format on
+
+  cout << setw(7) << "n" << setw(7) << "k" << setw(6) << "fnz" << setw(14)
+       << "BCSR_ms" << setw(14) << "BCSR_mt_ms" << setw(14) << "repack_ms"
+       << setw(14) << "CSR_ms" << setw(14) << "CSR_mt_ms" << endl;
+
+  constexpr int NWARMUP = 2;
+  constexpr int NITER = 10;
+  for (const auto& s : shapes) {
+    const int n = static_cast<int>(s[0]);
+    const int k = static_cast<int>(s[1]);
+    const float fnz = s[2];
+    aligned_vector<int8_t> wData =
+        getRandomBlockSparseMatrix<int8_t>(n, k, fnz, 1, 4);
+    aligned_vector<float> fData = getRandomSparseVector(n * k, fnz);
+
+    auto timeBCSR = [&](int num_threads) {
+      return measureWithWarmup(
+          [&]() {
+            BCSRMatrix<> bcsr(n, k);
+            bcsr.pack(wData.data(), k, num_threads);
+          },
+          NWARMUP,
+          NITER);
+    };
+    double secs_bcsr = timeBCSR(1);
+    double secs_bcsr_mt = timeBCSR(0);
+
+    BCSRMatrix<> bcsr(n, k);
+    bcsr.pack(wData.data(), k, 0);
+    vector<int> changed(max(1, n / 100));
+    iota(changed.begin(), changed.end(), 0);
+    for (int i : changed) {
+      // Moves the blocks of the row, which forces a new layout
+      wData[i * k] = wData[i * k] ? 0 : 1;
+    }
+    double secs_repack = measureWithWarmup(
+        [&]() {
+          for (int i : changed) {
+            wData[i * k] = wData[i * k] ? 0 : 1;
+          }
+          bcsr.repack(wData.data(), k, changed, 0);
+        },
+        NWARMUP,
+        NITER);
+
+    auto timeCSR = [&](int num_threads) {
+      return measureWithWarmup(
+          [&]() { fbgemmDenseToCSR(n, k, fData.data(), k, num_threads); },
+          NWARMUP,
+          NITER);
+    };
+    double secs_csr = timeCSR(1);
+    double secs_csr_mt = timeCSR(0);
+
+    cout << setw(7) << n << setw(7) << k << setw(6) << fixed
+         << setprecision(2) << fnz << setw(14) << setprecision(3)
+         << secs_bcsr * 1e3 << setw(14) << secs_bcsr_mt * 1e3 << setw(14)
+         << secs_repack * 1e3 << setw(14) << secs_csr * 1e3 << setw(14)
+         << secs_csr_mt * 1e3 << endl;
+  }
+  return 0;
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "bench/BenchUtils.h"
+#include "fbgemm/FbgemmSparse.h"
+
+#include <iomanip>
+#include <iostream>
+#include <tuple>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+using namespace std;
+using namespace fbgemm;
+
+// Compares the CSR x CSR product with the sparse x dense product on B
+// densified, which is what computing the crosses densely costs.
+int main(int, char**) {
+  // clang-format off
+  // {M, N, K, fraction of non-zeros of A, fraction of non-zeros of B}
+  vector<tuple<int, int, int, float, float>> shapes = {
+    {1024, 4096, 4096, 0.001f, 0.001f},
+    {1024, 4096, 4096, 0.01f, 0.01f},
+    {4096, 16384, 1024, 0.005f, 0.002f},
+    {256, 1024, 1024, 0.05f, 0.05f},
+  };
+  // clang-format on
+
+  int num_threads = 1;
+#ifdef _OPENMP
+  num_threads = omp_get_max_threads();
+#endif
+
+  cout << setw(7) << "m" << setw(7) << "n" << setw(7) << "k" << setw(8)
+       << "fnzA" << setw(8) << "fnzB" << setw(12) << "nnz(C)" << setw(15)
+       << "SpGEMM_ms" << setw(15) << "densified_ms" << endl;
+
+  constexpr int NWARMUP = 2;
+  constexpr int NITER = 10;
+  for (const auto& s : shapes) {
+    const auto [m, n, k, fnzA, fnzB] = s;
+    aligned_vector<float> aData = getRandomSparseVector(m * k, fnzA);
+    aligned_vector<float> bData = getRandomSparseVector(k * n, fnzB);
+    unique_ptr<CSRMatrix<float>> A = fbgemmDenseToCSR(m, k, aData.data());
+    unique_ptr<CSRMatrix<float>> B = fbgemmDenseToCSR(k, n, bData.data());
+
+    unique_ptr<CSRMatrix<float>> C;
+    double secs_spgemm = measureWithWarmup(
+        [&]() { C = fbgemmSparseSparseMM(m, n, *A, *B, num_threads); },
+        NWARMUP,
+        NITER);
+
+    aligned_vector<float> cData(m * n);
+    double secs_dense = measureWithWarmup(
+        [&]() {
+          SparseDenseMM(
+              m,
+              n,
+              A->rowPtr.data(),
+              A->colIdx.data(),
+              A->values.data(),
+              bData.data(),
+              n,
+              cData.data(),
+              n,
+              false /* accum */,
+              fbgemm_get_thread_num(),
+              fbgemm_get_num_threads());
+        },
+        NWARMUP,
+        NITER,
+        empty_flush(),
+        true /*useOpenMP*/);
+
+    cout << setw(7) << m << setw(7) << n << setw(7) << k << setw(8)
+         << fixed << setprecision(3) << fnzA << setw(8) << fnzB << setw(12)
+         << C->rowPtr[m] << setw(15) << secs_spgemm * 1e3 << setw(15)
+         << secs_dense * 1e3 << endl;
+  }
+  return 0;
+}
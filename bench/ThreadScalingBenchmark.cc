@@ -0,0 +1,511 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+// Strong scaling of fbgemmPacked (int8, 32-bit accumulation),
+// cblas_gemm_compute (fp16 weights) and EmbeddingSpMDMParallel (fp32 rows):
+// each problem is run on 1, 2, 4, ... threads pinned to the cores of the
+// host along placements:
+//   compact: one thread per physical core, filling a NUMA node first
+//   spread:  one thread per physical core, alternating between NUMA nodes
+//   smt:     every hardware thread of a core before the next core, filling a
+//            NUMA node first
+// and the speedup over one thread and the per-core efficiency (speedup over
+// the number of physical cores used) are reported. Operands are allocated
+// and initialized by the main thread, so they live on its NUMA node, as
+// usual for weights loaded at startup.
+//
+// Only the CPUs of the affinity mask of the process are used, so
+// `taskset`/`numactl --physcpubind` restrict the study to a part of the host.
+// Threads are pinned on Linux only.
+//
+// Flags: --M=, --N=, --K= of the GEMMs (default 1024 each), --batch_size=,
+// --num_rows=, --embedding_dim=, --average_len= of the embedding lookups
+// (default 10000, 1000000, 64, 50), --placements=<comma separated list>
+// (default compact,spread,smt), --max_threads=, --iters= (default 10),
+// --json=<file> as in BenchUtils.h.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#include "./BenchUtils.h"
+#include "fbgemm/Fbgemm.h"
+#include "fbgemm/FbgemmEmbedding.h"
+#include "fbgemm/FbgemmFP16.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+struct Cpu {
+  int id;
+  // Physical core, unique across packages
+  int core;
+  int node;
+};
+
+int readSysfsInt(const string& path, int def_val) {
+  ifstream in(path);
+  int value;
+  return in >> value ? value : def_val;
+}
+
+// CPUs of a list of ranges such as "0-3,8"
+vector<int> parseCpuList(const string& list) {
+  vector<int> cpus;
+  stringstream ss(list);
+  string range;
+  while (getline(ss, range, ',')) {
+    const auto dash = range.find('-');
+    try {
+      const int first = stoi(range.substr(0, dash));
+      const int last =
+          dash == string::npos ? first : stoi(range.substr(dash + 1));
+      for (int cpu = first; cpu <= last; ++cpu) {
+        cpus.push_back(cpu);
+      }
+    } catch (const exception&) {
+      return {};
+    }
+  }
+  return cpus;
+}
+
+// CPUs the process may run on, with their core and NUMA node
+vector<Cpu> readTopology() {
+  vector<Cpu> cpus;
+#ifdef __linux__
+  cpu_set_t mask;
+  CPU_ZERO(&mask);
+  if (sched_getaffinity(0, sizeof(mask), &mask) == 0) {
+    map<int, int> node_of_cpu;
+    for (int node = 0; node < fbgemmNumaNodeCount(); ++node) {
+      ifstream in(
+          "/sys/devices/system/node/node" + to_string(node) + "/cpulist");
+      string list;
+      getline(in, list);
+      for (const int cpu : parseCpuList(list)) {
+        node_of_cpu[cpu] = node;
+      }
+    }
+    map<pair<int, int>, int> core_ids;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (!CPU_ISSET(cpu, &mask)) {
+        continue;
+      }
+      const string topology =
+          "/sys/devices/system/cpu/cpu" + to_string(cpu) + "/topology/";
+      const pair<int, int> package_core = {
+          readSysfsInt(topology + "physical_package_id", 0),
+          readSysfsInt(topology + "core_id", cpu)};
+      const auto it = core_ids.emplace(package_core, core_ids.size()).first;
+      cpus.push_back({cpu, it->second, node_of_cpu[cpu]});
+    }
+  }
+#endif
+  if (cpus.empty()) {
+    const int n = max<int>(thread::hardware_concurrency(), 1);
+    for (int cpu = 0; cpu < n; ++cpu) {
+      cpus.push_back({cpu, cpu, 0});
+    }
+  }
+  return cpus;
+}
+
+/**
+ * CPUs in the order threads are placed on them by placement (see the top of
+ * the file); the first n are those of n threads.
+ */
+vector<int> placementOrder(const vector<Cpu>& cpus, const string& placement) {
+  // Hardware threads of each physical core of each node, in CPU order
+  map<int, map<int, vector<int>>> nodes;
+  for (const auto& cpu : cpus) {
+    nodes[cpu.node][cpu.core].push_back(cpu.id);
+  }
+  vector<int> placed;
+  if (placement == "compact" || placement == "smt") {
+    for (const auto& [node, cores] : nodes) {
+      for (const auto& [core, threads] : cores) {
+        if (placement == "smt") {
+          placed.insert(placed.end(), threads.begin(), threads.end());
+        } else {
+          placed.push_back(threads.front());
+        }
+      }
+    }
+  } else if (placement == "spread") {
+    vector<vector<int>> node_cores;
+    for (const auto& [node, cores] : nodes) {
+      node_cores.emplace_back();
+      for (const auto& [core, threads] : cores) {
+        node_cores.back().push_back(threads.front());
+      }
+    }
+    for (size_t i = 0; placed.size() < cpus.size(); ++i) {
+      bool any = false;
+      for (const auto& cores : node_cores) {
+        if (i < cores.size()) {
+          placed.push_back(cores[i]);
+          any = true;
+        }
+      }
+      if (!any) {
+        break;
+      }
+    }
+  } else {
+    cerr << "Unknown placement " << placement << endl;
+    exit(1);
+  }
+  return placed;
+}
+
+// Number of distinct physical cores and NUMA nodes of a list of CPUs
+pair<int, int> countCoresAndNodes(
+    const vector<Cpu>& cpus,
+    const vector<int>& placed) {
+  set<int> cores, nodes;
+  for (const int id : placed) {
+    for (const auto& cpu : cpus) {
+      if (cpu.id == id) {
+        cores.insert(cpu.core);
+        nodes.insert(cpu.node);
+      }
+    }
+  }
+  return {static_cast<int>(cores.size()), static_cast<int>(nodes.size())};
+}
+
+/**
+ * Runs work(thread_id, num_threads) on an OpenMP team with a thread per CPU
+ * of placed. The team is pinned before the measurements by pin(); the
+ * OpenMP runtime keeps reusing the same threads for teams of the same size.
+ */
+class PinnedTeam {
+ public:
+  explicit PinnedTeam(vector<int> placed) : placed_(std::move(placed)) {}
+
+  int size() const {
+    return placed_.size();
+  }
+
+  void pin() const {
+#if defined(__linux__) && defined(_OPENMP)
+#pragma omp parallel num_threads(size())
+    {
+      cpu_set_t mask;
+      CPU_ZERO(&mask);
+      CPU_SET(placed_[omp_get_thread_num()], &mask);
+      if (sched_setaffinity(0, sizeof(mask), &mask) != 0) {
+#pragma omp critical
+        cerr << "Cannot pin a thread to CPU " << placed_[omp_get_thread_num()]
+             << endl;
+      }
+    }
+#endif
+  }
+
+  template <typename Work>
+  void run(const Work& work) const {
+#ifdef _OPENMP
+#pragma omp parallel num_threads(size())
+    work(omp_get_thread_num(), omp_get_num_threads());
+#else
+    work(0, 1);
+#endif
+  }
+
+  // Allows the main thread to run anywhere again
+  static void unpin(const vector<Cpu>& cpus) {
+#ifdef __linux__
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    for (const auto& cpu : cpus) {
+      CPU_SET(cpu.id, &mask);
+    }
+    sched_setaffinity(0, sizeof(mask), &mask);
+#else
+    (void)cpus;
+#endif
+  }
+
+ private:
+  vector<int> placed_;
+};
+
+/**
+ * A problem measured at every point of the sweep: run executes one
+ * iteration on a team, flops and bytes are those of one iteration.
+ */
+struct Problem {
+  string kernel;
+  vector<pair<string, int64_t>> shape;
+  double flops;
+  double bytes;
+  // Reported as GB/s rather than GOPS
+  bool memory_bound;
+  function<void(const PinnedTeam& team)> run;
+};
+
+Problem int8GemmProblem(int m, int n, int k) {
+  auto A = make_shared<aligned_vector<uint8_t>>(m * k);
+  aligned_vector<int8_t> B(k * n);
+  auto C = make_shared<aligned_vector<int32_t>>(m * n);
+  randFill<uint8_t>(*A, 0, 5);
+  randFill<int8_t>(B, -4, 4);
+  auto packedB = make_shared<PackBMatrix<int8_t>>(
+      matrix_op_t::NoTranspose, k, n, B.data(), n, nullptr, 1);
+  return {
+      "fbgemmPacked_i8_acc32",
+      {{"M", m}, {"N", n}, {"K", k}},
+      2.0 * m * n * k,
+      m * k + k * n + 4.0 * m * n,
+      false,
+      [=](const PinnedTeam& team) {
+        team.run([&](int thread_id, int num_threads) {
+          PackAMatrix<uint8_t> packA(
+              matrix_op_t::NoTranspose, m, k, A->data(), k, nullptr, 1);
+          DoNothing<int32_t, int32_t> doNothingObj;
+          memCopy<> memcopyObj(doNothingObj);
+          fbgemmPacked(
+              packA,
+              *packedB,
+              C->data(),
+              C->data(),
+              n,
+              memcopyObj,
+              thread_id,
+              num_threads);
+        });
+      }};
+}
+
+Problem fp16GemmProblem(int m, int n, int k) {
+  auto A = make_shared<aligned_vector<float>>(m * k);
+  aligned_vector<float> B(k * n);
+  auto C = make_shared<aligned_vector<float>>(m * n);
+  randFill(*A, 0.0f, 4.0f);
+  randFill(B, 0.0f, 4.0f);
+  auto packedB = make_shared<PackedGemmMatrixFP16>(
+      matrix_op_t::NoTranspose, k, n, 1.0f, B.data());
+  return {
+      "cblas_gemm_compute_fp16",
+      {{"M", m}, {"N", n}, {"K", k}},
+      2.0 * m * n * k,
+      4.0 * m * k + 2.0 * k * n + 4.0 * m * n,
+      false,
+      [=](const PinnedTeam& team) {
+        team.run([&](int thread_id, int num_threads) {
+          cblas_gemm_compute(
+              matrix_op_t::NoTranspose,
+              m,
+              A->data(),
+              *packedB,
+              0.0f,
+              C->data(),
+              thread_id,
+              num_threads);
+        });
+      }};
+}
+
+Problem embeddingProblem(
+    int batch_size,
+    int num_rows,
+    int embedding_dim,
+    int average_len) {
+  auto table = make_shared<vector<float>>(
+      static_cast<size_t>(num_rows) * embedding_dim);
+  default_random_engine generator;
+  uniform_real_distribution<float> value_distribution(-1.0f, 1.0f);
+  for (auto& v : *table) {
+    v = value_distribution(generator);
+  }
+  auto offsets = make_shared<vector<int64_t>>(batch_size + 1, 0);
+  uniform_int_distribution<int> length_distribution(1, 2 * average_len - 1);
+  for (int b = 0; b < batch_size; ++b) {
+    (*offsets)[b + 1] = (*offsets)[b] + length_distribution(generator);
+  }
+  const int64_t index_size = offsets->back();
+  auto indices = make_shared<vector<int64_t>>(index_size);
+  uniform_int_distribution<int64_t> index_distribution(0, num_rows - 1);
+  for (auto& v : *indices) {
+    v = index_distribution(generator);
+  }
+  auto output = make_shared<vector<float>>(
+      static_cast<size_t>(batch_size) * embedding_dim);
+  const auto kernel = GenerateEmbeddingSpMDM<float, int64_t, int64_t>(
+      embedding_dim, /*has_weight=*/false, /*normalize_by_lengths=*/false);
+  return {
+      "EmbeddingSpMDMParallel_fp32",
+      {{"batch_size", batch_size},
+       {"num_rows", num_rows},
+       {"embedding_dim", embedding_dim},
+       {"average_len", average_len}},
+      0.0,
+      index_size * (embedding_dim * 4.0 + 8) +
+          batch_size * (embedding_dim * 4.0 + 8),
+      true,
+      [=](const PinnedTeam& team) {
+        // One range of bags per thread of the team
+        const ParallelTasksExecutor parallel_for =
+            [&](int num_tasks, const function<void(int)>& task) {
+              team.run([&](int thread_id, int num_threads) {
+                for (int t = thread_id; t < num_tasks; t += num_threads) {
+                  task(t);
+                }
+              });
+            };
+        if (!EmbeddingSpMDMParallel(
+                kernel,
+                embedding_dim,
+                batch_size,
+                index_size,
+                num_rows,
+                table->data(),
+                indices->data(),
+                offsets->data(),
+                nullptr,
+                output->data(),
+                team.size(),
+                parallel_for)) {
+          cerr << "EmbeddingSpMDMParallel failed" << endl;
+          exit(1);
+        }
+      }};
+}
+
+// Thread counts of the sweep: powers of 2 and max_threads
+vector<int> threadCounts(int max_threads) {
+  vector<int> counts;
+  for (int n = 1; n < max_threads; n *= 2) {
+    counts.push_back(n);
+  }
+  counts.push_back(max_threads);
+  return counts;
+}
+
+double mean(const vector<double>& samples) {
+  double sum = 0.0;
+  for (const double s : samples) {
+    sum += s;
+  }
+  return sum / samples.size();
+}
+
+} // namespace
+
+int main(int argc, const char* argv[]) {
+  const int m = parseArgumentInt(argc, argv, "--M=", 1024, 1024);
+  const int n = parseArgumentInt(argc, argv, "--N=", 1024, 1024);
+  const int k = parseArgumentInt(argc, argv, "--K=", 1024, 1024);
+  const int batch_size =
+      parseArgumentInt(argc, argv, "--batch_size=", 10000, 10000);
+  const int num_rows =
+      parseArgumentInt(argc, argv, "--num_rows=", 1000000, 1000000);
+  const int embedding_dim =
+      parseArgumentInt(argc, argv, "--embedding_dim=", 64, 64);
+  const int average_len =
+      parseArgumentInt(argc, argv, "--average_len=", 50, 50);
+  const int iters = parseArgumentInt(argc, argv, "--iters=", 10, 10);
+  const string placements =
+      parseArgumentString(argc, argv, "--placements=", "compact,spread,smt");
+  BenchmarkReporter reporter("ThreadScaling", argc, argv);
+
+  const vector<Cpu> cpus = readTopology();
+  int max_threads = cpus.size();
+#ifndef _OPENMP
+  max_threads = 1;
+#endif
+  max_threads =
+      parseArgumentInt(argc, argv, "--max_threads=", max_threads, max_threads);
+  const auto [num_cores, num_nodes] =
+      countCoresAndNodes(cpus, placementOrder(cpus, "smt"));
+  cout << "Host: " << cpus.size() << " hardware threads, " << num_cores
+       << " cores, " << num_nodes << " NUMA nodes, "
+       << instSetName(fbgemmInstructionSet()) << endl;
+
+  vector<Problem> problems;
+  problems.push_back(int8GemmProblem(m, n, k));
+  problems.push_back(fp16GemmProblem(m, n, k));
+  problems.push_back(
+      embeddingProblem(batch_size, num_rows, embedding_dim, average_len));
+
+  constexpr int NWARMUP = 2;
+  cout << setw(28) << "Kernel, " << setw(10) << "Placement, " << setw(9)
+       << "Threads, " << setw(7) << "Cores, " << setw(7) << "Nodes, "
+       << setw(12) << "Time (us), " << setw(12) << "GOPS|GB/s, " << setw(10)
+       << "Speedup, " << "Per-core eff (%)" << endl;
+  for (const auto& problem : problems) {
+    // Time of the problem on one thread, the base of the speedups
+    double base_seconds = 0.0;
+    stringstream placement_list(placements);
+    string placement;
+    while (getline(placement_list, placement, ',')) {
+      const vector<int> order = placementOrder(cpus, placement);
+      for (const int num_threads :
+           threadCounts(min<int>(max_threads, order.size()))) {
+        const vector<int> placed(order.begin(), order.begin() + num_threads);
+        const auto [cores, nodes] = countCoresAndNodes(cpus, placed);
+        const PinnedTeam team(placed);
+        team.pin();
+
+        BenchmarkRecord record;
+        record.kernel = problem.kernel + "/" + placement;
+        record.shape = problem.shape;
+        record.shape.emplace_back("cores", cores);
+        record.shape.emplace_back("nodes", nodes);
+        record.flops = problem.flops;
+        record.bytes = problem.bytes;
+        record.threads = num_threads;
+        record.seconds = measureSamplesWithWarmup(
+            [&]() { problem.run(team); }, NWARMUP, iters);
+        reporter.report(record);
+
+        const double seconds = mean(record.seconds);
+        if (base_seconds == 0.0) {
+          base_seconds = seconds;
+        }
+        const double speedup = base_seconds / seconds;
+        const double rate = problem.memory_bound
+            ? problem.bytes / seconds / 1e9
+            : problem.flops / seconds / 1e9;
+        cout << setw(26) << problem.kernel << ", " << setw(8) << placement
+             << ", " << setw(7) << num_threads << ", " << setw(5) << cores
+             << ", " << setw(5) << nodes << ", " << fixed << setprecision(1)
+             << setw(10) << seconds * 1e6 << ", " << setw(10) << rate << ", "
+             << setprecision(2) << setw(8) << speedup << ", "
+             << setprecision(1) << 100.0 * speedup / cores << endl;
+      }
+    }
+    cout << endl;
+  }
+  PinnedTeam::unpin(cpus);
+  return 0;
+}
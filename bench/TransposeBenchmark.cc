@@ -62,8 +62,104 @@ void performance_test() {
   } // M
 } // performance_test
 
+// Large matrices with transpose_simd_parallel, one partition per thread
+template <typename T>
+void performance_test_parallel() {
+  constexpr int NWARMUP = 2;
+  constexpr int NITER = 10;
+
+  uniform_int_distribution<int> dist(0, 10);
+  default_random_engine engine;
+
+  string runType = is_same<T, float>::value ? "float" : "i8";
+  cout << setw(8) << "dtype" << setw(6) << "M" << setw(6) << "N"
+       << " GB_per_sec" << endl;
+
+  for (int M : {1024, 4096, 8192}) {
+    const int N = M;
+    vector<T> a(static_cast<size_t>(M) * N);
+    vector<T> b(a.size()), b_ref(a.size());
+
+    generate(a.begin(), a.end(), [&dist, &engine] { return dist(engine); });
+    transpose_ref(M, N, a.data(), N, b_ref.data(), M);
+
+    double duration = measureWithWarmup(
+        [&]() {
+          transpose_simd_parallel(
+              M,
+              N,
+              a.data(),
+              N,
+              b.data(),
+              M,
+              fbgemm_get_thread_num(),
+              fbgemm_get_num_threads());
+        },
+        NWARMUP,
+        NITER,
+        empty_flush(),
+        /*useOpenMP=*/true);
+
+    // Bytes read and written
+    cout << setw(8) << runType << setw(6) << M << setw(6) << N << setw(10)
+         << setprecision(3) << 2.0 * sizeof(T) * M * N / duration / 1e9
+         << endl;
+
+    compare_buffers(b_ref.data(), b.data(), M, N, N, 5);
+  }
+}
+
+// Many small matrices: a loop of transpose_simd against transpose_simd_batched
+template <typename T>
+void performance_test_batched() {
+  constexpr int NWARMUP = 4;
+  constexpr int NITER = 64;
+  constexpr int batch_size = 1024;
+
+  uniform_int_distribution<int> dist(0, 10);
+  default_random_engine engine;
+
+  string runType = is_same<T, float>::value ? "float" : "i8";
+  cout << setw(8) << "dtype" << setw(4) << "M" << setw(4) << "N"
+       << " loop_B_elements_per_sec batched_B_elements_per_sec" << endl;
+
+  for (auto [M, N] : {make_pair(8, 8), make_pair(32, 64), make_pair(64, 32)}) {
+    const size_t size = static_cast<size_t>(M) * N;
+    vector<T> a(batch_size * size);
+    vector<T> b(a.size()), b_ref(a.size());
+    generate(a.begin(), a.end(), [&dist, &engine] { return dist(engine); });
+
+    double duration_loop = measureWithWarmup(
+        [&]() {
+          for (int i = 0; i < batch_size; ++i) {
+            transpose_simd(
+                M, N, a.data() + i * size, N, b_ref.data() + i * size, M);
+          }
+        },
+        NWARMUP,
+        NITER);
+    double duration_batched = measureWithWarmup(
+        [&]() {
+          transpose_simd_batched(
+              batch_size, M, N, a.data(), N, size, b.data(), M, size);
+        },
+        NWARMUP,
+        NITER);
+
+    cout << setw(8) << runType << setw(4) << M << setw(4) << N << setw(10)
+         << setprecision(3) << batch_size * size / duration_loop / 1e9
+         << setw(10) << batch_size * size / duration_batched / 1e9 << endl;
+
+    compare_buffers(b_ref.data(), b.data(), batch_size * N, M, M, 5);
+  }
+}
+
 int main() {
   performance_test<float>();
   performance_test<uint8_t>();
+  performance_test_parallel<float>();
+  performance_test_parallel<uint8_t>();
+  performance_test_batched<float>();
+  performance_test_batched<uint8_t>();
   return 0;
 }
@@ -0,0 +1,29 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+################################################################################
+# JIT Cache Build ID
+################################################################################
+
+# Run with cmake -P: writes to OUTPUT a header defining
+# FBGEMM_JIT_CACHE_BUILD_ID as the hash of all the sources and headers under
+# SOURCE_DIR/src and SOURCE_DIR/include, so that a rebuild changing any kernel
+# generator does not load the kernels persisted by the previous build.
+
+file(GLOB_RECURSE FBGEMM_JIT_SOURCES
+  "${SOURCE_DIR}/src/*"
+  "${SOURCE_DIR}/include/fbgemm/*")
+list(SORT FBGEMM_JIT_SOURCES)
+
+set(FBGEMM_JIT_SOURCE_HASHES "")
+foreach(source IN LISTS FBGEMM_JIT_SOURCES)
+  file(SHA256 "${source}" source_hash)
+  string(APPEND FBGEMM_JIT_SOURCE_HASHES "${source_hash}")
+endforeach()
+string(SHA256 FBGEMM_JIT_CACHE_BUILD_ID "${FBGEMM_JIT_SOURCE_HASHES}")
+
+file(WRITE "${OUTPUT}"
+  "#define FBGEMM_JIT_CACHE_BUILD_ID \"${FBGEMM_JIT_CACHE_BUILD_ID}\"\n")
@@ -5,6 +5,11 @@
 
 def get_fbgemm_base_srcs():
     return [
+        "src/Allocator.cc",
+        "src/CodeCache.cc",
+        "src/CodeStorage.cc",
+        "src/ColumnSoftmax.cc",
+        "src/FbgemmTrace.cc",
         "src/GenerateI8Depthwise.cc",
         "src/RefImplementations.cc",
         "src/Utils.cc",
@@ -13,18 +18,33 @@ def get_fbgemm_base_srcs():
 def get_fbgemm_generic_srcs(with_base = False):
     return [
         "src/EmbeddingSpMDM.cc",
+        "src/EmbeddingSpMDMDedup.cc",
+        "src/EmbeddingPrefetchTable.cc",
         "src/EmbeddingSpMDMNBit.cc",
+        "src/EmbeddingSpMDMParallel.cc",
+        "src/EmbeddingSpMDMRowwiseQuantizedOut.cc",
+        "src/EmbeddingSpMDMTableBatched.cc",
         "src/ExecuteKernel.cc",
         "src/ExecuteKernelU8S8.cc",
         "src/Fbgemm.cc",
+        "src/FbgemmAcc16Outliers.cc",
+        "src/FbgemmBF16.cc",
         "src/FbgemmBfloat16Convert.cc",
         "src/FbgemmConv.cc",
+        "src/FbgemmDepthwiseSeparableConv.cc",
+        "src/FbgemmDynamicQuantFC.cc",
         "src/FbgemmFPCommon.cc",
         "src/FbgemmFP16.cc",
         "src/FbgemmFloat16Convert.cc",
+        "src/FbgemmFloat8Convert.cc",
+        "src/FbgemmI4.cc",
         "src/FbgemmI64.cc",
+        "src/FbgemmSparse24.cc",
         "src/FbgemmSparseDense.cc",
+        "src/FbgemmSparseSparse.cc",
+        "src/FbgemmI8Neon.cc",
         "src/FbgemmI8Spmdm.cc",
+        "src/FbgemmWarmup.cc",
         "src/GenerateKernelDirectConvU8S8S32ACC32.cc",
         "src/GenerateKernel.cc",
         "src/GenerateKernelU8S8S32ACC16.cc",
@@ -44,28 +64,38 @@ def get_fbgemm_generic_srcs(with_base = False):
         "src/PackWeightMatrixForGConv.cc",
         "src/PackWeightsForConv.cc",
         "src/PackWeightsForDirectConv.cc",
+        "src/PrefixSum.cc",
+        "src/PrunedHashMap.cc",
         "src/QuantUtils.cc",
         "src/RowWiseSparseAdagradFused.cc",
         "src/SparseAdagrad.cc",
+        "src/SparseOptimizersFused.cc",
         "src/spmmUtils.cc",
         "src/TransposeUtils.cc",
+        "src/TransposedConv.cc",
+        "src/WinogradConv.cc",
     ] + (get_fbgemm_base_srcs() if with_base else [])
 
 def get_fbgemm_public_headers():
     return [
         "include/fbgemm/ConvUtils.h",
         "include/fbgemm/Fbgemm.h",
+        "include/fbgemm/FbgemmBF16.h",
         "include/fbgemm/FbgemmBuild.h",
         "include/fbgemm/FbgemmConvert.h",
         "include/fbgemm/FbgemmEmbedding.h",
         "include/fbgemm/FbgemmFP16.h",
         "include/fbgemm/FbgemmFPCommon.h",
+        "include/fbgemm/FbgemmI4.h",
         "include/fbgemm/FbgemmI64.h",
         "include/fbgemm/FbgemmI8DepthwiseAvx2.h",
         "include/fbgemm/FbgemmI8DirectconvAvx2.h",
         "include/fbgemm/FbgemmI8Spmdm.h",
+        "include/fbgemm/FbgemmI8Winograd.h",
         "include/fbgemm/FbgemmPackMatrixB.h",
         "include/fbgemm/FbgemmSparse.h",
+        "include/fbgemm/FbgemmTrace.h",
+        "include/fbgemm/FbgemmWarmup.h",
         "include/fbgemm/OutputProcessing-inl.h",
         "include/fbgemm/PackingTraits-inl.h",
         "include/fbgemm/QuantUtils.h",
@@ -83,19 +113,30 @@ def get_fbgemm_public_headers():
 def get_fbgemm_avx2_srcs(msvc = False):
     return [
         #All the source files that either use avx2 instructions statically
+        "src/ColumnSoftmaxAvx2.cc",
         "src/EmbeddingSpMDMAvx2.cc",
+        "src/EmbeddingSpMDMPrecompiledAvx2.cc",
+        "src/FbgemmBF16UKernelsAvx2.cc",
         "src/FbgemmBfloat16ConvertAvx2.cc",
+        "src/FbgemmFP16GemvAvx2.cc",
         "src/FbgemmFloat16ConvertAvx2.cc",
+        "src/FbgemmFloat8ConvertAvx2.cc",
         "src/FbgemmI8Depthwise3DAvx2.cc",
         "src/FbgemmI8DepthwiseAvx2.cc",
         "src/FbgemmI8DepthwisePerChannelQuantAvx2.cc",
+        "src/FbgemmI8DirectconvAvx2.cc",
         "src/FbgemmSparseDenseAvx2.cc",
         "src/FbgemmSparseDenseInt8Avx2.cc",
         "src/OptimizedKernelsAvx2.cc",
         "src/PackDepthwiseConvMatrixAvx2.cc",
+        "src/PrefixSumAvx2.cc",
+        "src/PrunedHashMapAvx2.cc",
         "src/QuantUtilsAvx2.cc",
+        "src/SparseAdagradAvx2.cc",
+        "src/SparseOptimizersFusedAvx2.cc",
         "src/spmmUtilsAvx2.cc",
         "src/UtilsAvx2.cc",
+        "src/WinogradConvAvx2.cc",
     ]
 
 def get_fbgemm_inline_avx2_srcs(msvc = False, buck = False):
@@ -114,12 +155,23 @@ def get_fbgemm_inline_avx2_srcs(msvc = False, buck = False):
 def get_fbgemm_avx512_srcs(msvc = False):
     return [
         #All the source files that use avx512 instructions statically
+        "src/ColumnSoftmaxAvx512.cc",
         "src/FbgemmBfloat16ConvertAvx512.cc",
         "src/EmbeddingSpMDMAvx512.cc",
+        "src/EmbeddingSpMDMAvx512Bf16.cc",
+        "src/EmbeddingSpMDMAvx512FP8.cc",
+        "src/FbgemmBF16UKernelsAvx512.cc",
+        "src/FbgemmFP16GemvAvx512.cc",
+        "src/FbgemmFP16UKernelsAvx512Fp16.cc",
         "src/FbgemmFloat16ConvertAvx512.cc",
+        "src/FbgemmFloat8ConvertAvx512.cc",
+        "src/FbgemmI4Avx512Vnni.cc",
+        "src/FbgemmI8Amx.cc",
+        "src/FbgemmSparse24Avx512Vnni.cc",
         "src/FbgemmSparseDenseAvx512.cc",
         "src/FbgemmSparseDenseInt8Avx512.cc",
         "src/FbgemmSparseDenseVectorInt8Avx512.cc",
+        "src/PrefixSumAvx512.cc",
         "src/QuantUtilsAvx512.cc",
         "src/UtilsAvx512.cc",
     ]
@@ -341,9 +341,14 @@ endif()
 ################################################################################
 
 set(fbgemm_sources_normal
+  "${FBGEMM}/src/Allocator.cc"
+  "${FBGEMM}/src/CodeCache.cc"
+  "${FBGEMM}/src/CodeStorage.cc"
+  "${FBGEMM}/src/EmbeddingPrefetchTable.cc"
   "${FBGEMM}/src/EmbeddingSpMDM.cc"
   "${FBGEMM}/src/EmbeddingSpMDMAutovec.cc"
   "${FBGEMM}/src/EmbeddingSpMDMNBit.cc"
+  "${FBGEMM}/src/FbgemmTrace.cc"
   "${FBGEMM}/src/QuantUtils.cc"
   "${FBGEMM}/src/RefImplementations.cc"
   "${FBGEMM}/src/RowWiseSparseAdagradFused.cc"
@@ -355,7 +360,8 @@ set(fbgemm_sources_avx2
   "${FBGEMM}/src/QuantUtilsAvx2.cc")
 
 set(fbgemm_sources_avx512
-  "${FBGEMM}/src/EmbeddingSpMDMAvx512.cc")
+  "${FBGEMM}/src/EmbeddingSpMDMAvx512.cc"
+  "${FBGEMM}/src/EmbeddingSpMDMAvx512Bf16.cc")
 
 if(CXX_AVX2_FOUND)
   set_source_files_properties(${fbgemm_sources_avx2}
@@ -399,6 +405,7 @@ set(fbgemm_gpu_sources_static_cpu
     codegen/training/backward/embedding_backward_dense_host_cpu.cpp
     codegen/utils/embedding_bounds_check_host_cpu.cpp
     src/merge_pooled_embedding_ops/merge_pooled_embedding_ops_cpu.cpp
+    src/metric_ops/metric_ops_cpu.cpp
     src/permute_pooled_embedding_ops/permute_pooled_embedding_function.cpp
     src/permute_pooled_embedding_ops/permute_pooled_embedding_ops_cpu.cpp
     src/permute_pooled_embedding_ops/permute_pooled_embedding_ops_split_cpu.cpp
@@ -496,6 +503,7 @@ if(NOT FBGEMM_CPU_ONLY)
       src/quantize_ops/quantize_fused_nbit_rowwise.cu
       src/quantize_ops/quantize_hfp8.cu
       src/quantize_ops/quantize_msfp.cu
+      src/quantize_ops/quantize_mx.cu
       src/quantize_ops/quantize_padded_fp8_rowwise.cu
       src/sparse_ops/sparse_async_cumsum.cu
       src/sparse_ops/sparse_block_bucketize_features.cu
@@ -529,6 +537,8 @@ if(NOT FBGEMM_CPU_ONLY)
       src/split_embeddings_utils/generate_vbe_metadata.cu
       src/split_embeddings_utils/get_infos_metadata.cu
       src/split_embeddings_utils/radix_sort_pairs.cu
+      src/split_embeddings_utils/segment_length_histogram.cu
+      src/split_embeddings_utils/sparse_embedding_grad.cu
       src/split_embeddings_utils/transpose_embedding_input.cu)
 
   set_source_files_properties(${fbgemm_gpu_sources_static_gpu}
@@ -0,0 +1,317 @@
+#!/usr/bin/env python3
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+# pyre-strict
+
+# End-to-end benchmark of a DLRM-style CPU inference request: the sparse
+# features go through input combine, bucketize and the int_nbit TBE, the dense
+# features through the FP16 bottom MLP, and both through the feature
+# interaction and the int8 top MLP. The kernel benchmarks run each op alone,
+# which hides the cache pollution between the TBE and the FCs and the
+# contention between concurrent requests; this one reports the latency
+# percentiles of every stage and of the whole request under concurrent load.
+
+import logging
+import threading
+import time
+from concurrent.futures import ThreadPoolExecutor
+from dataclasses import dataclass
+from typing import Callable, Dict, List, Tuple
+
+import click
+import fbgemm_gpu
+import numpy as np
+import tabulate
+import torch
+
+from fbgemm_gpu.split_embedding_configs import SparseType
+from fbgemm_gpu.split_table_batched_embeddings_ops_common import (
+    EmbeddingLocation,
+    PoolingMode,
+)
+from fbgemm_gpu.split_table_batched_embeddings_ops_inference import (
+    IntNBitTableBatchedEmbeddingBagsCodegen,
+)
+from torch import Tensor
+
+logging.basicConfig(level=logging.DEBUG)
+
+# pyre-fixme[16]: Module `fbgemm_gpu` has no attribute `open_source`.
+open_source: bool = getattr(fbgemm_gpu, "open_source", False)
+
+if open_source:
+    # pyre-ignore[21]
+    from bench_utils import fill_random_scale_bias
+else:
+    from fbgemm_gpu.bench.bench_utils import fill_random_scale_bias
+
+    torch.ops.load_library("//deeplearning/fbgemm/fbgemm_gpu:sparse_ops")
+    torch.ops.load_library("//deeplearning/fbgemm/fbgemm_gpu:sparse_ops_cpu")
+    torch.ops.load_library("//deeplearning/fbgemm/fbgemm_gpu:input_combine_cpu")
+
+
+STAGES: List[str] = [
+    "input_combine",
+    "bucketize",
+    "tbe",
+    "bottom_mlp",
+    "interaction",
+    "top_mlp",
+]
+
+
+@dataclass
+class DLRMRequest:
+    # Per-feature ids and lengths, as they come from the request
+    indices: List[Tensor]
+    lengths: List[Tensor]
+    dense: Tensor
+
+
+class FP16Linear:
+    """A linear layer running fbgemm's FP16 GEMM on packed weights."""
+
+    def __init__(self, in_features: int, out_features: int) -> None:
+        weight = torch.randn(out_features, in_features) / in_features**0.5
+        self.packed_weight: Tensor = torch.fbgemm_pack_gemm_matrix_fp16(weight)
+        self.bias: Tensor = torch.randn(out_features)
+
+    def __call__(self, x: Tensor) -> Tensor:
+        return torch.fbgemm_linear_fp16_weight_fp32_activation(
+            x, self.packed_weight, self.bias
+        )
+
+
+class Int8Linear:
+    """A linear layer running fbgemm's int8 GEMM on packed weights, with the
+    activation quantized dynamically."""
+
+    def __init__(self, in_features: int, out_features: int) -> None:
+        weight = torch.randn(out_features, in_features) / in_features**0.5
+        (
+            self.weight,
+            self.col_offsets,
+            self.scale,
+            self.zero_point,
+        ) = torch.fbgemm_linear_quantize_weight(weight)
+        self.packed_weight: Tensor = torch.fbgemm_pack_quantized_matrix(self.weight)
+        self.bias: Tensor = torch.randn(out_features)
+
+    def __call__(self, x: Tensor) -> Tensor:
+        return torch.fbgemm_linear_int8_weight_fp32_activation(
+            x,
+            self.weight,
+            self.packed_weight,
+            self.col_offsets,
+            self.scale,
+            self.zero_point,
+            self.bias,
+        )
+
+
+def mlp(
+    layer: Callable[[int, int], Callable[[Tensor], Tensor]], sizes: List[int]
+) -> Callable[[Tensor], Tensor]:
+    layers = [layer(m, n) for m, n in zip(sizes[:-1], sizes[1:])]
+
+    def forward(x: Tensor) -> Tensor:
+        for i, f in enumerate(layers):
+            x = f(x)
+            x = torch.relu(x) if i < len(layers) - 1 else x
+        return x
+
+    return forward
+
+
+def generate_dlrm_requests(
+    num_requests: int,
+    batch_size: int,
+    num_features: int,
+    bag_size: int,
+    num_ids: int,
+    num_dense_features: int,
+    alpha: float,
+) -> List[DLRMRequest]:
+    requests = []
+    for _ in range(num_requests):
+        lengths = [
+            torch.from_numpy(
+                np.random.poisson(bag_size, size=batch_size).astype(np.int32)
+            )
+            for _ in range(num_features)
+        ]
+        indices = []
+        for length in lengths:
+            n = int(length.sum())
+            if alpha > 1.0:
+                ids = (np.random.zipf(alpha, size=n) - 1) % num_ids
+            else:
+                ids = np.random.randint(0, num_ids, size=n)
+            indices.append(torch.from_numpy(ids.astype(np.int32)))
+        dense = torch.randn(batch_size, num_dense_features)
+        requests.append(DLRMRequest(indices, lengths, dense))
+    return requests
+
+
+def parse_sizes(sizes: str) -> List[int]:
+    return [int(s) for s in sizes.split(",")]
+
+
+@click.group()
+def cli() -> None:
+    pass
+
+
+@cli.command()
+@click.option("--alpha", default=1.15, help="Zipf exponent of the ids, <= 1 is uniform")
+@click.option("--bag-size", default=20)
+@click.option("--batch-size", default=128)
+@click.option("--embedding-dim", default=128)
+@click.option("--weights-precision", type=SparseType, default=SparseType.INT4)
+@click.option("--num-features", default=32)
+@click.option("--num-shards", default=2, help="Row-wise shards of each table")
+@click.option("--num-embeddings", default=int(1e5), help="Rows of each shard")
+@click.option("--num-dense-features", default=256)
+@click.option("--bottom-mlp", default="512,256", help="Hidden sizes")
+@click.option("--top-mlp", default="1024,512,256", help="Hidden sizes")
+@click.option("--num-requests", default=200)
+@click.option("--warmup-requests", default=20)
+@click.option("--num-workers", default=4, help="Requests run concurrently")
+@click.option("--intra-op-threads", default=1)
+def cpu(  # noqa C901
+    alpha: float,
+    bag_size: int,
+    batch_size: int,
+    embedding_dim: int,
+    weights_precision: SparseType,
+    num_features: int,
+    num_shards: int,
+    num_embeddings: int,
+    num_dense_features: int,
+    bottom_mlp: str,
+    top_mlp: str,
+    num_requests: int,
+    warmup_requests: int,
+    num_workers: int,
+    intra_op_threads: int,
+) -> None:
+    np.random.seed(42)
+    torch.manual_seed(42)
+    torch.set_num_threads(intra_op_threads)
+    B = batch_size
+    D = embedding_dim
+    T = num_features
+    S = num_shards
+    E = num_embeddings
+
+    # Every shard of every feature is a table of the TBE, bucket major as
+    # block_bucketize_sparse_features lays out its output.
+    emb = IntNBitTableBatchedEmbeddingBagsCodegen(
+        [("", E, D, weights_precision, EmbeddingLocation.HOST) for _ in range(S * T)],
+        device="cpu",
+        output_dtype=SparseType.FP32,
+        pooling_mode=PoolingMode.SUM,
+    ).cpu()
+    emb.fill_random_weights()
+    fill_random_scale_bias(emb, S * T, weights_precision)
+    block_sizes = torch.full((T,), E, dtype=torch.int32)
+
+    bottom = mlp(FP16Linear, [num_dense_features] + parse_sizes(bottom_mlp) + [D])
+    # The pairwise dot products of the T pooled embeddings and the bottom MLP
+    # output, followed by that output
+    num_interactions = (T + 1) * T // 2
+    top = mlp(Int8Linear, [num_interactions + D] + parse_sizes(top_mlp) + [1])
+    tri_i, tri_j = torch.tril_indices(T + 1, T + 1, offset=-1)
+
+    def run(request: DLRMRequest) -> Dict[str, float]:
+        times: List[int] = [time.perf_counter_ns()]
+
+        indices, lengths, _ = torch.ops.fbgemm.tbe_input_combine_with_length(
+            request.indices, request.lengths, [torch.empty(0)] * T
+        )
+        times.append(time.perf_counter_ns())
+
+        (
+            bucketized_lengths,
+            bucketized_indices,
+            _,
+            _,
+            _,
+            _,
+        ) = torch.ops.fbgemm.block_bucketize_sparse_features_inference(
+            lengths, indices, False, False, block_sizes, S
+        )
+        offsets = torch.ops.fbgemm.asynchronous_complete_cumsum(bucketized_lengths)
+        times.append(time.perf_counter_ns())
+
+        # The shards of a feature hold disjoint rows, so their pooled
+        # embeddings add up to the pooled embedding of the feature
+        pooled = emb.forward(bucketized_indices, offsets)
+        pooled = pooled.view(B, S, T, D).sum(dim=1)
+        times.append(time.perf_counter_ns())
+
+        x = bottom(request.dense)
+        times.append(time.perf_counter_ns())
+
+        features = torch.cat([x.unsqueeze(1), pooled], dim=1)
+        z = torch.bmm(features, features.transpose(1, 2))
+        interactions = torch.cat([z[:, tri_i, tri_j], x], dim=1)
+        times.append(time.perf_counter_ns())
+
+        torch.sigmoid(top(interactions))
+        times.append(time.perf_counter_ns())
+
+        stage_times = {
+            stage: (end - start) / 1.0e6
+            for stage, start, end in zip(STAGES, times[:-1], times[1:])
+        }
+        stage_times["end_to_end"] = (times[-1] - times[0]) / 1.0e6
+        return stage_times
+
+    requests = generate_dlrm_requests(
+        num_requests, B, T, bag_size, S * E, num_dense_features, alpha
+    )
+    logging.info(
+        f"{weights_precision} TBE: {S * T} tables of {E} rows, D: {D}, B: {B}, "
+        f"L: {bag_size}, bottom MLP: {bottom_mlp}, top MLP: {top_mlp}"
+    )
+    for request in requests[:warmup_requests]:
+        run(request)
+
+    results: List[Dict[str, float]] = []
+    lock = threading.Lock()
+
+    def run_and_record(request: DLRMRequest) -> None:
+        stage_times = run(request)
+        with lock:
+            results.append(stage_times)
+
+    start_time = time.perf_counter()
+    with ThreadPoolExecutor(max_workers=num_workers) as executor:
+        # Rethrows the exceptions of the workers
+        list(executor.map(run_and_record, requests))
+    elapsed_time = time.perf_counter() - start_time
+
+    rows: List[Tuple[str, float, float, float, float]] = []
+    for stage in STAGES + ["end_to_end"]:
+        samples = np.array([r[stage] for r in results])
+        p50, p90, p99 = np.percentile(samples, [50, 90, 99])
+        rows.append((stage, samples.mean(), p50, p90, p99))
+    logging.info(
+        f"{num_requests} requests, {num_workers} workers, "
+        f"{intra_op_threads} intra-op threads: "
+        f"{num_requests / elapsed_time:.2f} requests/s\n"
+        + tabulate.tabulate(
+            rows,
+            headers=["stage", "mean ms", "p50 ms", "p90 ms", "p99 ms"],
+            floatfmt=".3f",
+        )
+    )
+
+
+if __name__ == "__main__":
+    cli()
@@ -136,6 +136,9 @@ def benchmark_read_write(
             -0.01,  # ssd_uniform_init_lower
             0.01,  # ssd_uniform_init_upper
             32,  # row_storage_bitwidth
+            0,  # dram_cache_rows
+            1,  # init_threads_per_shard
+            0,  # row_compression_bit_rate
         )
 
         total_indices = (warmup_iters + iters) * batch_size * bag_size
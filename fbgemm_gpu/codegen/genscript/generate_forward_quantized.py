@@ -25,6 +25,10 @@ class TemplateParams:
     input_rows_in_flight: int
     min_128b_rows: int
     max_128b_rows: int
+    # Number of cp.async buffers the rows go through (1 = no pipelining).  The
+    # params must match the Y(...) dispatch in
+    # embedding_forward_quantized_split_nbit_host_template.cu
+    num_stages: int = 1
 
 
 @dataclass
@@ -82,9 +86,11 @@ ELEM_TYPES = [
         [
             TemplateParams(2, 8, 0, 1),
             TemplateParams(2, 4, 1, 2),
-            TemplateParams(2, 4, 2, 4),
-            TemplateParams(2, 4, 4, 8),
-            TemplateParams(2, 2, 8, 16),
+            # Large-D rows are double buffered, with rows in flight halved
+            # where needed to stay within 48 KB of static shared memory
+            TemplateParams(2, 4, 2, 4, num_stages=2),
+            TemplateParams(2, 2, 4, 8, num_stages=2),
+            TemplateParams(2, 1, 8, 16, num_stages=2),
         ],
     ),
     ElemType(
@@ -94,8 +100,8 @@ ELEM_TYPES = [
         [
             TemplateParams(4, 8, 0, 1),
             TemplateParams(2, 8, 1, 2),
-            TemplateParams(1, 4, 2, 4),
-            TemplateParams(1, 4, 4, 8),
+            TemplateParams(1, 4, 2, 4, num_stages=2),
+            TemplateParams(1, 4, 4, 8, num_stages=2),
         ],
     ),
     ElemType(
@@ -72,6 +72,10 @@ env.globals["items_per_warp"] = 128 if args.is_rocm is False else 256
 # derived from empirical studies
 env.globals["fixed_max_vecs_per_thread"] = {"backward": 2, "backward_indice_weights": 6}
 
+# The smallest sub-warp group size of the pooled forward kernel. A group of 2
+# threads covers D <= 8, so tiny-D tables pack 16 bags per warp
+env.globals["forward_min_thread_group_size"] = 2
+
 env.globals["dense"] = False
 env.globals["is_rocm"] = args.is_rocm
 
@@ -148,10 +152,15 @@ def get_max_vecs_template_configs(
     fixed_max_vecs_per_thread: int,
     use_subwarp_shuffle: bool,
     use_vec_blocking: bool,
+    min_group_size: int = 8,
 ) -> List[Tuple[int, int, str]]:
     """
     Generate the template configs for each kFixedMaxVecsPerThread,
     kThreadGroupSize, and kUseVecBlocking
+
+    `min_group_size` is the smallest sub-warp group size to generate. Kernels
+    that can pack more than four rows per warp (e.g., the pooled forward for
+    D <= 8) can lower it from the default of 8.
     """
     warp_size = items_per_warp // 4
     configs: List[Tuple[int, int, str]] = []
@@ -166,7 +175,7 @@ def get_max_vecs_template_configs(
     # thread-local buffer (i.e., shared memory is not need for grad_sum)
     if use_subwarp_shuffle:
         # Generate configs for sub-warp templates
-        group_size = 8  # Smallest group size that TBE supports
+        group_size = min_group_size
         while group_size < warp_size:
             # kFixedMaxVecsPerThread = 1
             # kThreadGroupSize = group_size
@@ -185,6 +194,7 @@ def dispatch_non_vec_blocking_kernel(
     items_per_warp: int,
     fixed_max_vecs_per_thread: int,
     use_subwarp_shuffle: bool,
+    min_group_size: int = 8,
 ) -> str:
     """
     Generate code for kernel dispatching for kernels that do not use vector
@@ -201,6 +211,7 @@ def dispatch_non_vec_blocking_kernel(
         fixed_max_vecs_per_thread,
         use_subwarp_shuffle,
         use_vec_blocking=False,
+        min_group_size=min_group_size,
     ):
         formats = {
             "max_D_val": kFixedMaxVecsPerThread * kThreadGroupSize * 4,
@@ -1004,8 +1004,36 @@ def adam() -> Dict[str, Any]:
 
 
 def partial_rowwise_adam() -> Dict[str, Any]:
+    # momentum1 is either stored in full precision or rowwise quantized to
+    # uint8, in which case each row holds D + kINT8QparamsBytes bytes and ends
+    # with its (scale, bias) qparams, in the same layout as INT8 weights.  The
+    # qparams of the updated row are found by a first pass over the gradient,
+    # so that the second pass can requantize with stochastic rounding.
     split_precomputation = """
     at::acc_type<cache_t, true> g_local_sum_square = 0.0;
+
+    constexpr auto kIsInt8Momentum1 = std::is_same<momentum1_ph_t, uint8_t>::value;
+    const int32_t D_momentum1 = kIsInt8Momentum1 ? D + kINT8QparamsBytes : D;
+    StochasticRoundingRNGState momentum1_state;
+    auto momentum1_row_template =
+        WeightRow<momentum1_ph_t, momentum1_ph_t, at::acc_type<cache_t, true>>(
+            &momentum1[idx * D_momentum1],
+            nullptr,
+            D,
+            stochastic_rounding ? &momentum1_state : nullptr,
+            &stochastic_rounding_philox_args,
+            // Salt differently from the weight row to decorrelate the noise
+            ~static_cast<uint64_t>(threadIdx.x + run_id * blockDim.x));
+
+    float2 momentum1_qparams;
+    float2 momentum1_qparams_new;
+    at::acc_type<cache_t, true> m_local_min =
+        std::numeric_limits<at::acc_type<cache_t, true>>::max();
+    at::acc_type<cache_t, true> m_local_max =
+        std::numeric_limits<at::acc_type<cache_t, true>>::lowest();
+    if (kIsInt8Momentum1) {
+        momentum1_qparams = momentum1_row_template.load_qparams();
+    }
     """
     split_precomputation += generate_optimized_grad_sum_loop_access(
         """
@@ -1014,12 +1042,27 @@ def partial_rowwise_adam() -> Dict[str, Any]:
             grad->y * grad->y +
             grad->z * grad->z +
             grad->w * grad->w;
+        if (kIsInt8Momentum1) {
+            auto m_t = momentum1_row_template.load(d, momentum1_qparams);
+            m_t.mul_(beta1);
+            m_t.fma_({grad_vec}, 1.0 - beta1);
+            m_local_min = min(m_local_min, vec4_min(m_t));
+            m_local_max = max(m_local_max, vec4_max(m_t));
+        }
     """
     )
     split_precomputation += """
     const at::acc_type<cache_t, true> g_avg_square =
         GROUP_REDUCE_ALL_SUM(g_local_sum_square, at::acc_type<cache_t, true>) / D;
 
+    if (kIsInt8Momentum1) {
+        const auto m_min =
+            GROUP_REDUCE_ALL_MIN(m_local_min, at::acc_type<cache_t, true>);
+        const auto m_max =
+            GROUP_REDUCE_ALL_MAX(m_local_max, at::acc_type<cache_t, true>);
+        momentum1_qparams_new = make_float2((m_max - m_min) / 255.0f, m_min);
+    }
+
     at::acc_type<cache_t, true> v_hat_t;
     if (threadIdx.x == 0) {
         at::acc_type<cache_t, true> v_t = momentum2[idx] * beta2 + g_avg_square * (1.0 - beta2);
@@ -1030,19 +1073,25 @@ def partial_rowwise_adam() -> Dict[str, Any]:
     """
 
     split_weight_update = """
-      Vec4T<momentum1_ph_t> m_t(&momentum1[idx * D + d]);
-      m_t.acc.x *= beta1;
-      m_t.acc.y *= beta1;
-      m_t.acc.z *= beta1;
-      m_t.acc.w *= beta1;
+      auto m_t = momentum1_row_template.load(d, momentum1_qparams);
+      m_t.mul_(beta1);
       m_t.fma_(grad, 1.0 - beta1);
-      m_t.store(&momentum1[idx * D + d]);
+      // momentum1_qparams_new is not used if momentum1 is not int8
+      momentum1_row_template.store(m_t, d, momentum1_qparams_new);
 
       weight_new.acc.x -= learning_rate * (m_t.acc.x / (1.0 - powf(beta1, iter)) / (sqrtf(v_hat_t) + eps) + weight_decay * weight_new.acc.x);
       weight_new.acc.y -= learning_rate * (m_t.acc.y / (1.0 - powf(beta1, iter)) / (sqrtf(v_hat_t) + eps) + weight_decay * weight_new.acc.y);
       weight_new.acc.z -= learning_rate * (m_t.acc.z / (1.0 - powf(beta1, iter)) / (sqrtf(v_hat_t) + eps) + weight_decay * weight_new.acc.z);
       weight_new.acc.w -= learning_rate * (m_t.acc.w / (1.0 - powf(beta1, iter)) / (sqrtf(v_hat_t) + eps) + weight_decay * weight_new.acc.w);
     """
+    # The old qparams have been read by every thread of the group before the
+    # reductions above, so they can be overwritten once the row is rewritten
+    split_post_update = """
+    if (kIsInt8Momentum1 && threadIdx.x == 0) {
+        momentum1_row_template.store_qparams(momentum1_qparams_new);
+    }
+    """
+
     split_weight_update_cpu = ""  # TODO
 
     return {
@@ -1052,7 +1101,11 @@ def partial_rowwise_adam() -> Dict[str, Any]:
                 OptimItem(
                     ArgType.PLACEHOLDER_TENSOR,
                     "momentum1",
-                    ph_tys=[ArgType.FLOAT_TENSOR, ArgType.BFLOAT16_TENSOR],
+                    ph_tys=[
+                        ArgType.FLOAT_TENSOR,
+                        ArgType.BFLOAT16_TENSOR,
+                        ArgType.BYTE_TENSOR,
+                    ],
                 ),
                 OptimItem(
                     ArgType.PLACEHOLDER_TENSOR,
@@ -1069,7 +1122,7 @@ def partial_rowwise_adam() -> Dict[str, Any]:
         ),
         "split_precomputation": split_precomputation,
         "split_weight_update": split_weight_update,
-        "split_post_update": "",
+        "split_post_update": split_post_update,
         "split_weight_update_cpu": split_weight_update_cpu,
         "has_cpu_support": False,
         "has_gpu_support": True,
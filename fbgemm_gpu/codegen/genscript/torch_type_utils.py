@@ -25,6 +25,7 @@ class ArgType(IntEnum):
     PLACEHOLDER_TENSOR = 6
     INT = 7
     FLOAT = 8
+    BYTE_TENSOR = 9
 
 
 @dataclass
@@ -39,4 +40,5 @@ arg_type_to_tensor_type: Dict[ArgType, TensorType] = {
     ArgType.FLOAT_TENSOR: TensorType("float", "at::ScalarType::Float"),
     ArgType.HALF_TENSOR: TensorType("at::Half", "at::ScalarType::Half"),
     ArgType.BFLOAT16_TENSOR: TensorType("at::BFloat16", "at::ScalarType::BFloat16"),
+    ArgType.BYTE_TENSOR: TensorType("uint8_t", "at::ScalarType::Byte"),
 }
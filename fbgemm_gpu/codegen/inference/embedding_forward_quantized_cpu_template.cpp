@@ -23,7 +23,11 @@
 #include <immintrin.h>
 #include <emmintrin.h>
 #endif
+#include <algorithm>
+#include <array>
 #include <cstring>
+#include <tuple>
+#include <vector>
 
 using namespace fbgemm_gpu;
 
@@ -129,7 +133,17 @@ Tensor int_nbit_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{
     {% endif %}
     int64_t output_dtype,
     int64_t fp8_exponent_bits,
-    int64_t fp8_exponent_bias
+    int64_t fp8_exponent_bias,
+    const c10::optional<Tensor>& index_remappings,
+    const c10::optional<Tensor>& index_remappings_offsets,
+    const c10::optional<Tensor>& index_remapping_groups,
+    const c10::optional<Tensor>& index_remapping_group_offsets,
+    {% if nobag %}
+    const c10::optional<Tensor>& output_buffer,
+    const c10::optional<Tensor>& output_row_offsets
+    {% else %}
+    const c10::optional<Tensor>& output_D_offsets
+    {% endif %}
 ) {
     TENSOR_ON_CPU(dev_weights);
     TENSOR_ON_CPU(uvm_weights);
@@ -176,6 +190,26 @@ Tensor int_nbit_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{
     if (o_dtype == SparseType::INT8) {
       total_adjusted_D += T * kINT8QparamsBytes;
     }
+    // The slice of table t can instead start at column output_D_offsets[t]
+    // of a [B, output_D_offsets[T]] output, e.g. to align the slices of
+    // tables of mixed D. The columns between the slices are not written.
+    Tensor output_D_offsets_value;
+    if (output_D_offsets.has_value()) {
+      TORCH_CHECK(!output_is_int8, "output_D_offsets does not support int8 output");
+      TORCH_CHECK(output_D_offsets->numel() == T + 1, "output_D_offsets must have T + 1 offsets");
+      output_D_offsets_value = output_D_offsets->to(at::kInt).contiguous();
+      const auto* output_D_offsets_acc = output_D_offsets_value.data_ptr<int32_t>();
+      const auto* D_offsets_acc = D_offsets.data_ptr<int32_t>();
+      TORCH_CHECK(output_D_offsets_acc[0] >= 0);
+      for (const auto t : c10::irange(T)) {
+        TORCH_CHECK(
+            output_D_offsets_acc[t + 1] - output_D_offsets_acc[t] >= D_offsets_acc[t + 1] - D_offsets_acc[t],
+            "The output slice of table ",
+            t,
+            " is narrower than its embedding dimension");
+      }
+      total_adjusted_D = output_D_offsets_acc[T];
+    }
     output = at::empty({B, total_adjusted_D}, dev_weights.options().dtype(getScalarType(o_dtype)).pinned_memory(pinned_memory));
     {% else %}
     const int kINT8QparamsBytes = 4; // no bag int8 output aligns with fbgemm weights storage size and layout
@@ -183,7 +217,20 @@ Tensor int_nbit_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{
     if (o_dtype == SparseType::INT8) {
       adjusted_D += kINT8QparamsBytes;
     }
-    output = at::empty({total_L, adjusted_D}, dev_weights.options().dtype(getScalarType(o_dtype)).pinned_memory(pinned_memory));
+    // The rows of table t can instead be written into the caller's output
+    // from row output_row_offsets[t], e.g. in the permuted feature order of
+    // permute_sequence_embeddings or at the jagged offsets of the features
+    Tensor output_row_offsets_value;
+    if (output_buffer.has_value()) {
+      TENSOR_ON_CPU(*output_buffer);
+      TORCH_CHECK(output_row_offsets.has_value() && output_row_offsets->numel() == T, "output_row_offsets must have one row offset per table");
+      TORCH_CHECK(output_buffer->dim() == 2 && output_buffer->size(1) == adjusted_D && output_buffer->is_contiguous(), "output must be a contiguous [num_rows, ", adjusted_D, "] tensor");
+      TORCH_CHECK(output_buffer->scalar_type() == getScalarType(o_dtype), "output does not match output_dtype");
+      output = *output_buffer;
+      output_row_offsets_value = output_row_offsets->to(at::kLong).contiguous();
+    } else {
+      output = at::empty({total_L, adjusted_D}, dev_weights.options().dtype(getScalarType(o_dtype)).pinned_memory(pinned_memory));
+    }
 
     {% endif %}
 
@@ -192,8 +239,35 @@ Tensor int_nbit_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{
         return output;
     }
 
+    // Indices of pruned tables are remapped chunk by chunk right before
+    // pooling, instead of into a whole remapped index tensor first: with an
+    // array per table like pruned_array_lookup, or with a grouped hash map
+    // like pruned_hashmap_grouped_lookup. Tables with an empty array or no
+    // group are not remapped.
+    const bool remap_array = index_remappings_offsets.has_value() && index_remappings_offsets->numel() > 0;
+    const bool remap_groups = index_remapping_group_offsets.has_value() && index_remapping_group_offsets->numel() > 0;
+    TORCH_CHECK(!(remap_array && remap_groups), "index_remappings and index_remapping_groups are exclusive");
+    Tensor remap_values;
+    Tensor remap_offsets;
+    if (remap_array) {
+        TORCH_CHECK(index_remappings.has_value());
+        remap_values = index_remappings->contiguous();
+        remap_offsets = index_remappings_offsets->contiguous();
+    } else if (remap_groups) {
+        TORCH_CHECK(index_remapping_groups.has_value());
+        TORCH_CHECK(indices.scalar_type() == at::kInt, "index_remapping_groups requires int32 indices");
+        remap_values = index_remapping_groups->contiguous();
+        remap_offsets = index_remapping_group_offsets->contiguous();
+    }
+    if (remap_array || remap_groups) {
+        TENSOR_ON_CPU(remap_values);
+        TENSOR_ON_CPU(remap_offsets);
+        TORCH_CHECK(remap_offsets.numel() == T + 1);
+    }
+    const int32_t* remap_values_acc = remap_array || remap_groups ? remap_values.data_ptr<int32_t>() : nullptr;
+    const int64_t* remap_offsets_acc = remap_array || remap_groups ? remap_offsets.data_ptr<int64_t>() : nullptr;
+
     const int32_t* weights_placements_ptr = weights_placements.data_ptr<int32_t>();
-    const uint8_t* weights_acc;
 
     const auto* weights_tys_acc = weights_tys.data_ptr<uint8_t>();
 
@@ -223,21 +297,80 @@ Tensor int_nbit_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{
             int32_t num_indices_m_1 = indices.numel() - 1;
             int32_t D_start_ = 0;
 
-            for (const auto t : c10::irange(T)) {
+            {% if not nobag %}
+            const auto* D_offsets_acc = D_offsets.data_ptr<int32_t>();
+            const int32_t* output_D_offsets_acc = output_D_offsets_value.defined() ? output_D_offsets_value.data_ptr<int32_t>() : nullptr;
+            const int32_t output_stride = output_D_offsets_acc != nullptr ? output_D_offsets_acc[T] : total_D;
+            {% else %}
+            const int64_t* output_row_offsets_acc = output_row_offsets_value.defined() ? output_row_offsets_value.data_ptr<int64_t>() : nullptr;
+            if (output_row_offsets_acc != nullptr) {
+                for (const auto t : c10::irange(T)) {
+                    const int64_t table_rows = offsets_acc[(t + 1) * B] - offsets_acc[t * B];
+                    TORCH_CHECK(
+                        output_row_offsets_acc[t] >= 0 && output_row_offsets_acc[t] + table_rows <= output.size(0),
+                        "The ",
+                        table_rows,
+                        " output rows of table ",
+                        t,
+                        " from row ",
+                        output_row_offsets_acc[t],
+                        " do not fit in the output");
+                }
+            }
+            {% endif %}
+
+            // Rows of D_bytes bytes of table t in weight_tensor
+            const auto table_num_rows = [&](const int32_t t, const Tensor& weight_tensor, const int32_t D_bytes) {
+                int tt;
+                for (tt = t + 1; tt < T && weights_offsets_acc[tt] == weights_offsets_acc[t]; ++tt);
+                return static_cast<size_t>(((tt == T ? weight_tensor.numel() : weights_offsets_acc[tt]) - weights_offsets_acc[t]) / D_bytes);
+            };
+
+            // Prefetches the rows of the first indices of table t, so that they
+            // load while the previous table is pooled. Indices of pruned tables
+            // are not rows until they are remapped.
+            const int32_t cross_table_prefetch = fbgemm::getEmbeddingCrossTablePrefetch();
+            const auto prefetch_table = [&](const int32_t t) {
+                if ((remap_array || remap_groups) && remap_offsets_acc[t + 1] > remap_offsets_acc[t]) {
+                    return;
+                }
+                const auto placement = static_cast<PlacementType>(weights_placements_ptr[t]);
+                if (placement == PlacementType::DEVICE) {
+                    return;
+                }
+                {% if not nobag %}
+                const int32_t D = D_offsets_acc[t + 1] - D_offsets_acc[t];
+                {% endif %}
+                const auto& weight_tensor = (placement == PlacementType::HOST) ? dev_weights : uvm_weights;
+                const int32_t D_bytes = nbit::padded_row_size_in_bytes(D, static_cast<SparseType>(weights_tys_acc[t]), row_alignment);
+                const index_t begin = offsets_acc[t * B];
+                fbgemm::prefetchEmbeddingRows(
+                    weight_tensor.data_ptr<uint8_t>() + weights_offsets_acc[t],
+                    table_num_rows(t, weight_tensor, D_bytes),
+                    D_bytes,
+                    indices_acc + begin,
+                    std::min<int64_t>(cross_table_prefetch, offsets_acc[(t + 1) * B] - begin));
+            };
+
+            // Pools bags [b_begin, b_end) of table t.
+            const auto run_bags = [&](const int32_t t, const int32_t b_begin, const int32_t b_end) {
                 {% if not nobag %}
-                const auto* D_offsets_acc = D_offsets.data_ptr<int32_t>();
                 const int32_t D_start = D_offsets_acc[t];
                 const int32_t D_end = D_offsets_acc[t + 1];
                 const int32_t D = D_end - D_start;
+                const int32_t output_D_start = output_D_offsets_acc != nullptr ? output_D_offsets_acc[t] : D_start;
+                const int64_t output_offset = output_D_start + static_cast<int64_t>(b_begin) * output_stride;
                 {% else %}
-                const int32_t D_start = offsets_acc[t * B] * adjusted_D;
+                const int64_t output_row = output_row_offsets_acc != nullptr
+                    ? output_row_offsets_acc[t] + offsets_acc[t * B + b_begin] - offsets_acc[t * B]
+                    : static_cast<int64_t>(offsets_acc[t * B + b_begin]);
+                const int64_t output_offset = output_row * adjusted_D;
                 {% endif %}
 
                 const auto placement = static_cast<PlacementType>(weights_placements_ptr[t]);
                 TORCH_CHECK(placement != PlacementType::DEVICE);
                 const auto& weight_tensor = (placement == PlacementType::HOST) ? dev_weights : uvm_weights;
-                weights_acc = weight_tensor.data_ptr<uint8_t>();
-                const uint8_t* weights = &weights_acc[weights_offsets_acc[t]];
+                const uint8_t* weights = weight_tensor.data_ptr<uint8_t>() + weights_offsets_acc[t];
                 const auto weight_ty = static_cast<SparseType>(weights_tys_acc[t]);
                 if (output_is_int8) {
                     TORCH_CHECK(weight_ty == SparseType::INT8, "int8 output are only supported for int8 weights");
@@ -245,21 +378,45 @@ Tensor int_nbit_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{
                 // default to 1 byte alignment for CPU TBE
                 const int32_t D_bytes = nbit::padded_row_size_in_bytes(D, weight_ty, row_alignment);
 
-                int tt;
-                for (tt = t + 1; tt < T && weights_offsets_acc[tt] == weights_offsets_acc[t]; ++tt);
-                const size_t num_rows = ((tt == T ? weight_tensor.numel() : weights_offsets_acc[tt]) - weights_offsets_acc[t]) / D_bytes;
-                const index_t* offsets_begin_ptr = offsets_acc + t * B;
+                const size_t num_rows = table_num_rows(t, weight_tensor, D_bytes);
+                const index_t* offsets_begin_ptr = offsets_acc + t * B + b_begin;
 
                 bool success = true;
                 const bool has_weight = {{ "true" if weighted else "false" }};
                 const bool normalize_by_lengths = static_cast<PoolingMode>(pooling_mode) == PoolingMode::MEAN;
 
-                const index_t index_size = offsets_acc[(t + 1) * B] - *offsets_begin_ptr;
-                const int32_t output_stride = {{ "total_D" if not nobag else "adjusted_D" }};
+                const index_t index_size = offsets_acc[t * B + b_end] - *offsets_begin_ptr;
+                {% if nobag %}
+                const int32_t output_stride = adjusted_D;
+                {% endif %}
+
+                const index_t* indices_begin_ptr = indices_acc + *offsets_begin_ptr;
+                std::vector<index_t> remapped_indices;
+                if ((remap_array || remap_groups) && remap_offsets_acc[t + 1] > remap_offsets_acc[t]) {
+                    remapped_indices.resize(index_size);
+                    if (remap_array) {
+                        const int32_t* table_remapping = remap_values_acc + remap_offsets_acc[t];
+                        for (const auto i : c10::irange(index_size)) {
+                            remapped_indices[i] = table_remapping[indices_begin_ptr[i]];
+                        }
+                    } else {
+                        // Indices are int32, checked above
+                        const std::array<int32_t, 2> chunk_offsets = {0, static_cast<int32_t>(index_size)};
+                        fbgemm::pruned_hashmap_grouped_lookup(
+                            1,
+                            1,
+                            reinterpret_cast<const int32_t*>(indices_begin_ptr),
+                            chunk_offsets.data(),
+                            remap_values_acc,
+                            remap_offsets_acc + t,
+                            reinterpret_cast<int32_t*>(remapped_indices.data()));
+                    }
+                    indices_begin_ptr = remapped_indices.data();
+                }
 
                 {% if nobag %}
                 // Create virtual offsets for the nobag case. Lengths are all ones.
-                const auto offsets_nobag = at::arange(*offsets_begin_ptr, offsets_acc[(t + 1) * B] + 1, offsets.options());
+                const auto offsets_nobag = at::arange(*offsets_begin_ptr, offsets_acc[t * B + b_end] + 1, offsets.options());
                 const index_t* offsets_nobag_ptr = offsets_nobag.data_ptr<index_t>();
                 TORCH_CHECK(offsets_nobag.numel() == index_size + 1);
                 TORCH_CHECK(offsets_nobag_ptr[index_size] - offsets_nobag_ptr[0] == index_size);
@@ -326,14 +483,14 @@ Tensor int_nbit_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{
                     /*is_bf16_out=*/output_is_bf16
                 );
                 success = kernel(
-                    {{ "B" if not nobag else "index_size"}},
+                    {{ "b_end - b_begin" if not nobag else "index_size"}},
                     index_size,
                     num_rows,
                     reinterpret_cast<const {{ weight_type }}*>(weights),
-                    indices_acc + *offsets_begin_ptr,
+                    indices_begin_ptr,
                     offset_ptr,
                     indice_weights_ptr,
-                    reinterpret_cast<fbgemm_out_t*>(output_acc + D_start));
+                    reinterpret_cast<fbgemm_out_t*>(output_acc + output_offset));
                 {% endmacro %}
 
                 if (weight_ty == SparseType::FP32) {
@@ -363,18 +520,100 @@ Tensor int_nbit_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{
                     throw std::logic_error(
                         "Unsupported SparseType: " + std::to_string(static_cast<int>(weight_ty)));
                 }
+                if (!success && !remapped_indices.empty()) {
+                    for (const auto i : c10::irange(index_size)) {
+                        TORCH_CHECK(
+                            -1 <= remapped_indices[i] && remapped_indices[i] < static_cast<int64_t>(num_rows),
+                            "Remapped index ",
+                            *offsets_begin_ptr + i,
+                            " of table ",
+                            t,
+                            " is out of bounds: ",
+                            remapped_indices[i],
+                            ", range -1 to ",
+                            num_rows);
+                    }
+                }
                 if (!success) {
                     fbgemm_gpu::report_embedding_error(
                         t,
                         B,
-                        0,
-                        B,
+                        b_begin,
+                        b_end,
                         offsets_acc,
                         indices_acc,
                         num_rows,
                         /*allow_minus_one=*/true);
                 }
+            };
+
+            // The bags of all tables, enumerated table by table (bag b of
+            // table t at position t * B + b), are split into chunks of similar
+            // memory traffic estimated from the offsets: the rows read per
+            // index plus the output written per bag. A request with many small
+            // tables or a few large ones then runs on all intra-op threads.
+            std::vector<int64_t> index_cost(T), bag_cost(T), table_cost(T + 1, 0);
+            for (const auto t : c10::irange(T)) {
+                {% if not nobag %}
+                const int64_t D_t = D_offsets_acc[t + 1] - D_offsets_acc[t];
+                {% else %}
+                const int64_t D_t = D;
+                {% endif %}
+                const auto weight_ty = static_cast<SparseType>(weights_tys_acc[t]);
+                const int64_t row_bytes = nbit::padded_row_size_in_bytes(D_t, weight_ty, row_alignment);
+                const int64_t output_row_bytes = D_t * sizeof(output_t);
+                {% if not nobag %}
+                index_cost[t] = row_bytes;
+                // Never 0, so that positions of bags have strictly increasing costs
+                bag_cost[t] = std::max<int64_t>(output_row_bytes, 1);
+                {% else %}
+                index_cost[t] = row_bytes + output_row_bytes;
+                bag_cost[t] = 1;
+                {% endif %}
+                table_cost[t + 1] = table_cost[t] +
+                    (offsets_acc[(t + 1) * B] - offsets_acc[t * B]) * index_cost[t] + B * bag_cost[t];
             }
+            // First bag position whose cost prefix is at least c
+            const auto locate = [&](const int64_t c) -> int64_t {
+                const int32_t t = std::upper_bound(table_cost.begin(), table_cost.end(), c) - table_cost.begin() - 1;
+                if (t >= T) {
+                    return static_cast<int64_t>(T) * B;
+                }
+                const index_t* table_offsets = offsets_acc + t * B;
+                int64_t lo = 0, hi = B;
+                while (lo < hi) {
+                    const int64_t mid = lo + (hi - lo) / 2;
+                    const int64_t cost = table_cost[t] +
+                        (table_offsets[mid] - table_offsets[0]) * index_cost[t] + mid * bag_cost[t];
+                    if (cost >= c) {
+                        hi = mid;
+                    } else {
+                        lo = mid + 1;
+                    }
+                }
+                return static_cast<int64_t>(t) * B + lo;
+            };
+
+            // Bytes of traffic per chunk below which a chunk is not worth a task
+            constexpr int64_t kMinChunkCost = 64 * 1024;
+            const int64_t total_cost = table_cost[T];
+            const int64_t num_chunks = std::max<int64_t>(
+                1, std::min<int64_t>(at::get_num_threads(), total_cost / kMinChunkCost));
+            at::parallel_for(0, num_chunks, 1, [&](int64_t chunk_begin, int64_t chunk_end) {
+                for (const auto chunk : c10::irange(chunk_begin, chunk_end)) {
+                    const int64_t begin = locate(total_cost * chunk / num_chunks);
+                    const int64_t end = locate(total_cost * (chunk + 1) / num_chunks);
+                    for (int64_t pos = begin; pos < end;) {
+                        const int32_t t = pos / B;
+                        const int64_t table_end = std::min<int64_t>(end, static_cast<int64_t>(t + 1) * B);
+                        if (cross_table_prefetch > 0 && table_end < end) {
+                            prefetch_table(t + 1);
+                        }
+                        run_bags(t, pos - static_cast<int64_t>(t) * B, table_end - static_cast<int64_t>(t) * B);
+                        pos = table_end;
+                    }
+                }
+            });
             return;
         });
     });
@@ -444,6 +683,76 @@ for (const auto l : c10::irange(L)) {
 }
 
 {% if not weighted %}
+std::tuple<Tensor, Tensor> pruned_hashmap_grouped_build_cpu(
+    Tensor indices,
+    Tensor dense_indices,
+    Tensor offsets,
+    Tensor hash_table_offsets) {
+    TENSOR_ON_CPU(indices);
+    TENSOR_ON_CPU(dense_indices);
+    TENSOR_ON_CPU(offsets);
+    TENSOR_ON_CPU(hash_table_offsets);
+
+    int32_t T = hash_table_offsets.size(0) - 1;
+    int32_t B = (offsets.size(0) - 1) / T;
+    TORCH_CHECK(B > 0);
+    const auto hash_table_offsets_contig = hash_table_offsets.contiguous();
+    auto group_offsets = at::empty({T + 1}, hash_table_offsets.options().dtype(at::kLong));
+    fbgemm::pruned_hashmap_grouped_offsets(
+        T,
+        hash_table_offsets_contig.data_ptr<int64_t>(),
+        group_offsets.data_ptr<int64_t>());
+    auto groups = at::empty(
+        {group_offsets[T].item<int64_t>(), 2 * fbgemm::kPrunedHashMapGroupSize},
+        indices.options().dtype(at::kInt));
+    const bool success = fbgemm::pruned_hashmap_grouped_build(
+        T,
+        B,
+        indices.contiguous().data_ptr<int32_t>(),
+        dense_indices.contiguous().data_ptr<int32_t>(),
+        offsets.contiguous().data_ptr<int32_t>(),
+        group_offsets.data_ptr<int64_t>(),
+        groups.data_ptr<int32_t>());
+    TORCH_CHECK(success, "pruned_hashmap_grouped_build: more indices than slots in a table");
+    return {groups, group_offsets};
+}
+
+Tensor pruned_hashmap_grouped_lookup_cpu(
+    Tensor indices,
+    Tensor offsets,
+    Tensor groups,
+    Tensor group_offsets) {
+    TENSOR_ON_CPU(indices);
+    TENSOR_ON_CPU(offsets);
+    TENSOR_ON_CPU(groups);
+    TENSOR_ON_CPU(group_offsets);
+
+    int32_t T = group_offsets.size(0) - 1;
+    int32_t B = (offsets.size(0) - 1) / T;
+    TORCH_CHECK(B > 0);
+    const auto indices_contig = indices.contiguous();
+    const auto offsets_contig = offsets.contiguous();
+    const auto groups_contig = groups.contiguous();
+    const auto group_offsets_contig = group_offsets.contiguous();
+    auto dense_indices = empty_like(indices_contig);
+    const auto* indices_acc = indices_contig.data_ptr<int32_t>();
+    auto* dense_indices_acc = dense_indices.data_ptr<int32_t>();
+    const auto* offsets_acc = offsets_contig.data_ptr<int32_t>();
+    const auto* groups_acc = groups_contig.data_ptr<int32_t>();
+    const auto* group_offsets_acc = group_offsets_contig.data_ptr<int64_t>();
+    at::parallel_for(0, T, 1, [&](int64_t begin, int64_t end) {
+        fbgemm::pruned_hashmap_grouped_lookup(
+            end - begin,
+            B,
+            indices_acc,
+            offsets_acc + begin * B,
+            groups_acc,
+            group_offsets_acc + begin,
+            dense_indices_acc);
+    });
+    return dense_indices;
+}
+
 Tensor pruned_array_lookup_cpu(
     Tensor indices,
     Tensor offsets,
@@ -487,5 +796,111 @@ Tensor pruned_array_lookup_cpu(
     return dense_indices;
 }
 
+std::tuple<Tensor, Tensor, Tensor> pruned_bitmap_build_cpu(
+    Tensor index_remappings,
+    Tensor index_remappings_offsets) {
+    TENSOR_ON_CPU(index_remappings);
+    TENSOR_ON_CPU(index_remappings_offsets);
+
+    const int32_t T = index_remappings_offsets.size(0) - 1;
+    const auto index_remappings_contig = index_remappings.contiguous();
+    const auto index_remappings_offsets_contig = index_remappings_offsets.contiguous();
+    const auto* index_remappings_acc = index_remappings_contig.data_ptr<int32_t>();
+    const auto* index_remappings_offsets_acc = index_remappings_offsets_contig.data_ptr<int64_t>();
+
+    // Tables are padded to whole blocks; unpruned tables take no words
+    auto bitmap_offsets = at::empty({T + 1}, index_remappings_offsets.options());
+    auto* bitmap_offsets_acc = bitmap_offsets.data_ptr<int64_t>();
+    bitmap_offsets_acc[0] = 0;
+    for (const auto t : c10::irange(T)) {
+        const int64_t capacity = index_remappings_offsets_acc[t + 1] - index_remappings_offsets_acc[t];
+        constexpr int64_t kBlockIndices = 32 * nbit::kPrunedBitmapBlockWords;
+        const int64_t num_blocks = (capacity + kBlockIndices - 1) / kBlockIndices;
+        bitmap_offsets_acc[t + 1] = bitmap_offsets_acc[t] + num_blocks * nbit::kPrunedBitmapBlockWords;
+    }
+    auto bitmap = at::zeros({bitmap_offsets_acc[T]}, index_remappings.options());
+    auto ranks = at::empty({bitmap_offsets_acc[T] / nbit::kPrunedBitmapBlockWords}, index_remappings.options());
+    auto* bitmap_acc = bitmap.data_ptr<int32_t>();
+    auto* ranks_acc = ranks.data_ptr<int32_t>();
+
+    at::parallel_for(0, T, 1, [&](int64_t begin, int64_t end) {
+        for (const auto t : c10::irange(begin, end)) {
+            const int64_t index_remappings_start = index_remappings_offsets_acc[t];
+            const int64_t capacity = index_remappings_offsets_acc[t + 1] - index_remappings_start;
+            auto* table_bitmap = reinterpret_cast<uint32_t*>(bitmap_acc + bitmap_offsets_acc[t]);
+            auto* table_ranks = ranks_acc + bitmap_offsets_acc[t] / nbit::kPrunedBitmapBlockWords;
+            int32_t rank = 0;
+            for (const auto idx : c10::irange(capacity)) {
+                if (idx % (32 * nbit::kPrunedBitmapBlockWords) == 0) {
+                    table_ranks[idx / (32 * nbit::kPrunedBitmapBlockWords)] = rank;
+                }
+                const int32_t dense_idx = index_remappings_acc[index_remappings_start + idx];
+                if (dense_idx < 0) {
+                    continue;
+                }
+                TORCH_CHECK(
+                    dense_idx == rank,
+                    "pruned_bitmap_build: table ", t,
+                    " does not map its kept indices in increasing order to 0, 1, ...");
+                table_bitmap[idx / 32] |= 1u << (idx % 32);
+                ++rank;
+            }
+        }
+    });
+    return {bitmap, ranks, bitmap_offsets};
+}
+
+Tensor pruned_bitmap_lookup_cpu(
+    Tensor indices,
+    Tensor offsets,
+    Tensor bitmap,
+    Tensor ranks,
+    Tensor bitmap_offsets) {
+    TENSOR_ON_CPU(indices);
+    TENSOR_ON_CPU(offsets);
+    TENSOR_ON_CPU(bitmap);
+    TENSOR_ON_CPU(ranks);
+    TENSOR_ON_CPU(bitmap_offsets);
+
+    int32_t T = bitmap_offsets.size(0) - 1;
+    int32_t B = (offsets.size(0) - 1) / T;
+    TORCH_CHECK(B > 0);
+    const auto indices_contig = indices.contiguous();
+    const auto offsets_contig = offsets.contiguous();
+    const auto bitmap_contig = bitmap.contiguous();
+    const auto ranks_contig = ranks.contiguous();
+    const auto bitmap_offsets_contig = bitmap_offsets.contiguous();
+    auto dense_indices = empty_like(indices_contig);
+    const auto* indices_acc = indices_contig.data_ptr<int32_t>();
+    auto* dense_indices_acc = dense_indices.data_ptr<int32_t>();
+    const auto* offsets_acc = offsets_contig.data_ptr<int32_t>();
+    const auto* bitmap_acc = bitmap_contig.data_ptr<int32_t>();
+    const auto* ranks_acc = ranks_contig.data_ptr<int32_t>();
+    const auto* bitmap_offsets_acc = bitmap_offsets_contig.data_ptr<int64_t>();
+
+    at::parallel_for(0, T, 1, [&](int64_t begin, int64_t end) {
+      for (const auto t : c10::irange(begin, end)) {
+          const int64_t bitmap_start = bitmap_offsets_acc[t];
+          const int64_t num_words = bitmap_offsets_acc[t + 1] - bitmap_start;
+          int32_t indices_start = offsets_acc[t * B];
+          int32_t indices_end = offsets_acc[(t + 1) * B];
+          if (num_words > 0) {
+              const auto* table_bitmap = bitmap_acc + bitmap_start;
+              const auto* table_ranks = ranks_acc + bitmap_start / nbit::kPrunedBitmapBlockWords;
+              for (const auto i : c10::irange(indices_start, indices_end)) {
+                  dense_indices_acc[i] = nbit::pruned_bitmap_dense_index(
+                      table_bitmap, table_ranks, num_words, indices_acc[i]);
+              }
+          } else {
+              std::memcpy(
+                  dense_indices_acc + indices_start,
+                  indices_acc + indices_start,
+                  (indices_end - indices_start) * sizeof(int32_t));
+          }
+      }
+    });
+    return dense_indices;
+}
+
 {% endif %}
 // clang-format on
@@ -571,6 +571,14 @@ Tensor pruned_array_lookup_cuda(
     Tensor index_remappings,
     Tensor index_remappings_offsets);
 
+///@ingroup embedding-cuda
+Tensor pruned_bitmap_lookup_cuda(
+    Tensor indices,
+    Tensor offsets,
+    Tensor bitmap,
+    Tensor ranks,
+    Tensor bitmap_offsets);
+
 TORCH_LIBRARY_FRAGMENT(fbgemm, m) {
   DISPATCH_TO_CUDA(
       "int_nbit_split_embedding_codegen_lookup_function",
@@ -580,4 +588,5 @@ TORCH_LIBRARY_FRAGMENT(fbgemm, m) {
       int_nbit_split_embedding_uvm_caching_codegen_lookup_function);
   DISPATCH_TO_CUDA("pruned_hashmap_lookup", pruned_hashmap_lookup_cuda);
   DISPATCH_TO_CUDA("pruned_array_lookup", pruned_array_lookup_cuda);
+  DISPATCH_TO_CUDA("pruned_bitmap_lookup", pruned_bitmap_lookup_cuda);
 }
@@ -42,7 +42,12 @@ Tensor int_nbit_split_embedding_codegen_forward_unweighted_cpu(
     int64_t row_alignment,
     int64_t output_dtype,
     int64_t fp8_exponent_bits,
-    int64_t fp8_exponent_bias);
+    int64_t fp8_exponent_bias,
+    const c10::optional<Tensor>& index_remappings,
+    const c10::optional<Tensor>& index_remappings_offsets,
+    const c10::optional<Tensor>& index_remapping_groups,
+    const c10::optional<Tensor>& index_remapping_group_offsets,
+    const c10::optional<Tensor>& output_D_offsets);
 
 Tensor int_nbit_split_embedding_codegen_forward_weighted_cpu(
     Tensor dev_weights,
@@ -59,7 +64,12 @@ Tensor int_nbit_split_embedding_codegen_forward_weighted_cpu(
     Tensor indice_weights,
     int64_t output_dtype,
     int64_t fp8_exponent_bits,
-    int64_t fp8_exponent_bias);
+    int64_t fp8_exponent_bias,
+    const c10::optional<Tensor>& index_remappings,
+    const c10::optional<Tensor>& index_remappings_offsets,
+    const c10::optional<Tensor>& index_remapping_groups,
+    const c10::optional<Tensor>& index_remapping_group_offsets,
+    const c10::optional<Tensor>& output_D_offsets);
 
 Tensor int_nbit_split_embedding_nobag_codegen_forward_unweighted_cpu(
     Tensor dev_weights,
@@ -74,13 +84,24 @@ Tensor int_nbit_split_embedding_nobag_codegen_forward_unweighted_cpu(
     int64_t row_alignment,
     int64_t output_dtype,
     int64_t fp8_exponent_bits,
-    int64_t fp8_exponent_bias);
+    int64_t fp8_exponent_bias,
+    const c10::optional<Tensor>& index_remappings,
+    const c10::optional<Tensor>& index_remappings_offsets,
+    const c10::optional<Tensor>& index_remapping_groups,
+    const c10::optional<Tensor>& index_remapping_group_offsets,
+    const c10::optional<Tensor>& output_buffer,
+    const c10::optional<Tensor>& output_row_offsets);
 
 ///@ingroup embedding-cpu
-Tensor int_nbit_split_embedding_codegen_lookup_function_cpu(
+/// Same as int_nbit_split_embedding_codegen_lookup_function_cpu on raw indices
+/// of pruned tables, remapped during the lookup either with the arrays of
+/// pruned_array_lookup (index_remappings, index_remappings_offsets) or with
+/// the grouped hash maps of pruned_hashmap_grouped_build
+/// (index_remapping_groups, index_remapping_group_offsets).
+Tensor int_nbit_split_embedding_codegen_lookup_function_remapped_cpu(
     Tensor dev_weights,
-    Tensor uvm_weights, // to match the interface of CUDA op using UVM
-    Tensor weights_placements, // to match the interface of CUDA op using UVM
+    Tensor uvm_weights,
+    Tensor weights_placements,
     Tensor weights_offsets,
     Tensor weights_tys,
     Tensor D_offsets,
@@ -95,14 +116,14 @@ Tensor int_nbit_split_embedding_codegen_lookup_function_cpu(
     int64_t pooling_mode,
     c10::optional<Tensor> indice_weights,
     int64_t output_dtype,
-    c10::optional<Tensor>
-        lxu_cache_weights, // Not used, to match cache interface for CUDA op
-    c10::optional<Tensor>
-        lxu_cache_locations, // Not used, to match cache interface for CUDA op
     c10::optional<int64_t> row_alignment,
     c10::optional<int64_t> max_float8_D,
     c10::optional<int64_t> fp8_exponent_bits,
-    c10::optional<int64_t> fp8_exponent_bias) {
+    c10::optional<int64_t> fp8_exponent_bias,
+    const c10::optional<Tensor>& index_remappings,
+    const c10::optional<Tensor>& index_remappings_offsets,
+    const c10::optional<Tensor>& index_remapping_groups,
+    const c10::optional<Tensor>& index_remapping_group_offsets) {
   if (static_cast<PoolingMode>(pooling_mode) == PoolingMode::NONE) {
     std::vector<int64_t> max_D_list{
         max_int2_D,
@@ -125,7 +146,13 @@ Tensor int_nbit_split_embedding_codegen_lookup_function_cpu(
         row_alignment ? *row_alignment : 1,
         output_dtype,
         fp8_exponent_bits ? *fp8_exponent_bits : -1,
-        fp8_exponent_bias ? *fp8_exponent_bias : -1);
+        fp8_exponent_bias ? *fp8_exponent_bias : -1,
+        index_remappings,
+        index_remappings_offsets,
+        index_remapping_groups,
+        index_remapping_group_offsets,
+        c10::nullopt,
+        c10::nullopt);
   }
   if (!indice_weights || indice_weights->numel() == 0) {
     return int_nbit_split_embedding_codegen_forward_unweighted_cpu(
@@ -142,7 +169,12 @@ Tensor int_nbit_split_embedding_codegen_lookup_function_cpu(
         row_alignment ? *row_alignment : 1,
         output_dtype,
         fp8_exponent_bits ? *fp8_exponent_bits : -1,
-        fp8_exponent_bias ? *fp8_exponent_bias : -1);
+        fp8_exponent_bias ? *fp8_exponent_bias : -1,
+        index_remappings,
+        index_remappings_offsets,
+        index_remapping_groups,
+        index_remapping_group_offsets,
+        c10::nullopt);
   }
   return int_nbit_split_embedding_codegen_forward_weighted_cpu(
       dev_weights,
@@ -159,7 +191,215 @@ Tensor int_nbit_split_embedding_codegen_lookup_function_cpu(
       *indice_weights,
       output_dtype,
       fp8_exponent_bits ? *fp8_exponent_bits : -1,
-      fp8_exponent_bias ? *fp8_exponent_bias : -1);
+      fp8_exponent_bias ? *fp8_exponent_bias : -1,
+      index_remappings,
+      index_remappings_offsets,
+      index_remapping_groups,
+      index_remapping_group_offsets,
+      c10::nullopt);
+}
+
+///@ingroup embedding-cpu
+/// Same as int_nbit_split_embedding_codegen_lookup_function_remapped_cpu for
+/// pooled tables, with the output slice of every table padded to a multiple
+/// of a cache line, so that tables of mixed D are written with aligned rows.
+/// Returns the [B, output_D_offsets[T]] output and output_D_offsets, table t
+/// being output[:, output_D_offsets[t]:output_D_offsets[t] + D_t]. The
+/// padding columns are not written.
+std::tuple<Tensor, Tensor>
+int_nbit_split_embedding_codegen_lookup_function_padded_cpu(
+    Tensor dev_weights,
+    Tensor uvm_weights,
+    Tensor weights_placements,
+    Tensor weights_offsets,
+    Tensor weights_tys,
+    Tensor D_offsets,
+    int64_t total_D,
+    Tensor indices,
+    Tensor offsets,
+    int64_t pooling_mode,
+    c10::optional<Tensor> indice_weights,
+    int64_t output_dtype,
+    c10::optional<int64_t> row_alignment,
+    c10::optional<int64_t> fp8_exponent_bits,
+    c10::optional<int64_t> fp8_exponent_bias,
+    const c10::optional<Tensor>& index_remappings,
+    const c10::optional<Tensor>& index_remappings_offsets,
+    const c10::optional<Tensor>& index_remapping_groups,
+    const c10::optional<Tensor>& index_remapping_group_offsets) {
+  TORCH_CHECK(
+      static_cast<PoolingMode>(pooling_mode) != PoolingMode::NONE,
+      "The padded output layout is for pooled tables");
+  const auto o_dtype = static_cast<SparseType>(output_dtype);
+  TORCH_CHECK(
+      o_dtype == SparseType::FP32 || o_dtype == SparseType::FP16 ||
+          o_dtype == SparseType::BF16,
+      "The padded output layout supports FP32, FP16 and BF16 output");
+  constexpr int64_t kCacheLineBytes = 64;
+  const int64_t D_alignment =
+      kCacheLineBytes / c10::elementSize(getScalarType(o_dtype));
+
+  const int32_t T = D_offsets.numel() - 1;
+  TORCH_CHECK(T > 0);
+  const auto D_offsets_cpu = D_offsets.to(at::kInt).contiguous();
+  const auto* D_offsets_acc = D_offsets_cpu.data_ptr<int32_t>();
+  auto output_D_offsets = at::empty({T + 1}, D_offsets_cpu.options());
+  auto* output_D_offsets_acc = output_D_offsets.data_ptr<int32_t>();
+  output_D_offsets_acc[0] = 0;
+  for (const auto t : c10::irange(T)) {
+    const int64_t D = D_offsets_acc[t + 1] - D_offsets_acc[t];
+    output_D_offsets_acc[t + 1] = output_D_offsets_acc[t] +
+        (D + D_alignment - 1) / D_alignment * D_alignment;
+  }
+
+  Tensor output;
+  if (!indice_weights || indice_weights->numel() == 0) {
+    output = int_nbit_split_embedding_codegen_forward_unweighted_cpu(
+        dev_weights,
+        uvm_weights,
+        weights_placements,
+        weights_offsets,
+        weights_tys,
+        D_offsets,
+        total_D,
+        indices,
+        offsets,
+        pooling_mode,
+        row_alignment ? *row_alignment : 1,
+        output_dtype,
+        fp8_exponent_bits ? *fp8_exponent_bits : -1,
+        fp8_exponent_bias ? *fp8_exponent_bias : -1,
+        index_remappings,
+        index_remappings_offsets,
+        index_remapping_groups,
+        index_remapping_group_offsets,
+        output_D_offsets);
+  } else {
+    output = int_nbit_split_embedding_codegen_forward_weighted_cpu(
+        dev_weights,
+        uvm_weights,
+        weights_placements,
+        weights_offsets,
+        weights_tys,
+        D_offsets,
+        total_D,
+        indices,
+        offsets,
+        pooling_mode,
+        row_alignment ? *row_alignment : 1,
+        *indice_weights,
+        output_dtype,
+        fp8_exponent_bits ? *fp8_exponent_bits : -1,
+        fp8_exponent_bias ? *fp8_exponent_bias : -1,
+        index_remappings,
+        index_remappings_offsets,
+        index_remapping_groups,
+        index_remapping_group_offsets,
+        output_D_offsets);
+  }
+  return {output, output_D_offsets};
+}
+
+///@ingroup embedding-cpu
+/// No bag (sequence) lookup writing the [L, D] rows of the indices of table t
+/// into output from row output_row_offsets[t], instead of into a new
+/// [total_L, D] output to reorder afterwards. With output_row_offsets of the
+/// features in permuted order, the output is the permuted embeddings of
+/// permute_sequence_embeddings.
+void int_nbit_split_embedding_nobag_codegen_lookup_function_out_cpu(
+    Tensor dev_weights,
+    Tensor uvm_weights,
+    Tensor weights_placements,
+    Tensor weights_offsets,
+    Tensor weights_tys,
+    int64_t D,
+    Tensor indices,
+    Tensor offsets,
+    Tensor output,
+    Tensor output_row_offsets,
+    int64_t output_dtype,
+    c10::optional<int64_t> row_alignment,
+    c10::optional<int64_t> fp8_exponent_bits,
+    c10::optional<int64_t> fp8_exponent_bias,
+    const c10::optional<Tensor>& index_remappings,
+    const c10::optional<Tensor>& index_remappings_offsets,
+    const c10::optional<Tensor>& index_remapping_groups,
+    const c10::optional<Tensor>& index_remapping_group_offsets) {
+  int_nbit_split_embedding_nobag_codegen_forward_unweighted_cpu(
+      dev_weights,
+      uvm_weights,
+      weights_placements,
+      weights_offsets,
+      weights_tys,
+      D,
+      indices,
+      offsets,
+      static_cast<int64_t>(PoolingMode::NONE),
+      row_alignment ? *row_alignment : 1,
+      output_dtype,
+      fp8_exponent_bits ? *fp8_exponent_bits : -1,
+      fp8_exponent_bias ? *fp8_exponent_bias : -1,
+      index_remappings,
+      index_remappings_offsets,
+      index_remapping_groups,
+      index_remapping_group_offsets,
+      output,
+      output_row_offsets);
+}
+
+///@ingroup embedding-cpu
+Tensor int_nbit_split_embedding_codegen_lookup_function_cpu(
+    Tensor dev_weights,
+    Tensor uvm_weights, // to match the interface of CUDA op using UVM
+    Tensor weights_placements, // to match the interface of CUDA op using UVM
+    Tensor weights_offsets,
+    Tensor weights_tys,
+    Tensor D_offsets,
+    int64_t total_D,
+    int64_t max_int2_D,
+    int64_t max_int4_D,
+    int64_t max_int8_D,
+    int64_t max_float16_D,
+    int64_t max_float32_D,
+    Tensor indices,
+    Tensor offsets,
+    int64_t pooling_mode,
+    c10::optional<Tensor> indice_weights,
+    int64_t output_dtype,
+    c10::optional<Tensor>
+        lxu_cache_weights, // Not used, to match cache interface for CUDA op
+    c10::optional<Tensor>
+        lxu_cache_locations, // Not used, to match cache interface for CUDA op
+    c10::optional<int64_t> row_alignment,
+    c10::optional<int64_t> max_float8_D,
+    c10::optional<int64_t> fp8_exponent_bits,
+    c10::optional<int64_t> fp8_exponent_bias) {
+  return int_nbit_split_embedding_codegen_lookup_function_remapped_cpu(
+      dev_weights,
+      uvm_weights,
+      weights_placements,
+      weights_offsets,
+      weights_tys,
+      D_offsets,
+      total_D,
+      max_int2_D,
+      max_int4_D,
+      max_int8_D,
+      max_float16_D,
+      max_float32_D,
+      indices,
+      offsets,
+      pooling_mode,
+      indice_weights,
+      output_dtype,
+      row_alignment,
+      max_float8_D,
+      fp8_exponent_bits,
+      fp8_exponent_bias,
+      c10::nullopt,
+      c10::nullopt,
+      c10::nullopt,
+      c10::nullopt);
 }
 
 ///@ingroup embedding-cpu
@@ -236,6 +476,20 @@ Tensor pruned_hashmap_lookup_unweighted_cpu(
     Tensor hash_table,
     Tensor hash_table_offsets);
 
+///@ingroup embedding-cpu
+std::tuple<Tensor, Tensor> pruned_hashmap_grouped_build_cpu(
+    Tensor indices,
+    Tensor dense_indices,
+    Tensor offsets,
+    Tensor hash_table_offsets);
+
+///@ingroup embedding-cpu
+Tensor pruned_hashmap_grouped_lookup_cpu(
+    Tensor indices,
+    Tensor offsets,
+    Tensor groups,
+    Tensor group_offsets);
+
 ///@ingroup embedding-cpu
 Tensor pruned_array_lookup_cpu(
     Tensor indices,
@@ -243,6 +497,19 @@ Tensor pruned_array_lookup_cpu(
     Tensor index_remappings,
     Tensor index_remappings_offsets);
 
+///@ingroup embedding-cpu
+std::tuple<Tensor, Tensor, Tensor> pruned_bitmap_build_cpu(
+    Tensor index_remappings,
+    Tensor index_remappings_offsets);
+
+///@ingroup embedding-cpu
+Tensor pruned_bitmap_lookup_cpu(
+    Tensor indices,
+    Tensor offsets,
+    Tensor bitmap,
+    Tensor ranks,
+    Tensor bitmap_offsets);
+
 TORCH_LIBRARY_FRAGMENT(fbgemm, m) {
 #ifdef HAS_IMPL_ABSTRACT_PYSTUB
   m.impl_abstract_pystub(
@@ -262,6 +529,29 @@ TORCH_LIBRARY_FRAGMENT(fbgemm, m) {
       "int_nbit_split_embedding_uvm_caching_codegen_lookup_function",
       int_nbit_split_embedding_uvm_caching_codegen_lookup_function_cpu);
 
+  // CPU only: lookup with the index remapping of pruned tables fused in
+  m.def(
+      "int_nbit_split_embedding_codegen_lookup_function_remapped(Tensor dev_weights, Tensor uvm_weights, Tensor weights_placements, Tensor weights_offsets, Tensor weights_tys, Tensor D_offsets, SymInt total_D, int max_int2_D, int max_int4_D, int max_int8_D, int max_float16_D, int max_float32_D, Tensor indices, Tensor offsets, int pooling_mode, Tensor? indice_weights, int output_dtype=1, int? row_alignment = None, int? max_float8_D=0, int? fp8_exponent_bits=-1, int? fp8_exponent_bias=-1, Tensor? index_remappings=None, Tensor? index_remappings_offsets=None, Tensor? index_remapping_groups=None, Tensor? index_remapping_group_offsets=None) -> Tensor");
+  DISPATCH_TO_CPU(
+      "int_nbit_split_embedding_codegen_lookup_function_remapped",
+      int_nbit_split_embedding_codegen_lookup_function_remapped_cpu);
+
+  // CPU only: pooled lookup with the output slice of every table padded to
+  // a multiple of a cache line, returns the output and its column offsets
+  m.def(
+      "int_nbit_split_embedding_codegen_lookup_function_padded(Tensor dev_weights, Tensor uvm_weights, Tensor weights_placements, Tensor weights_offsets, Tensor weights_tys, Tensor D_offsets, SymInt total_D, Tensor indices, Tensor offsets, int pooling_mode, Tensor? indice_weights, int output_dtype=1, int? row_alignment=None, int? fp8_exponent_bits=-1, int? fp8_exponent_bias=-1, Tensor? index_remappings=None, Tensor? index_remappings_offsets=None, Tensor? index_remapping_groups=None, Tensor? index_remapping_group_offsets=None) -> (Tensor, Tensor)");
+  DISPATCH_TO_CPU(
+      "int_nbit_split_embedding_codegen_lookup_function_padded",
+      int_nbit_split_embedding_codegen_lookup_function_padded_cpu);
+
+  // CPU only: no bag lookup into the caller's output, table t from row
+  // output_row_offsets[t]
+  m.def(
+      "int_nbit_split_embedding_nobag_codegen_lookup_function_out(Tensor dev_weights, Tensor uvm_weights, Tensor weights_placements, Tensor weights_offsets, Tensor weights_tys, int D, Tensor indices, Tensor offsets, Tensor(a!) output, Tensor output_row_offsets, int output_dtype=1, int? row_alignment=None, int? fp8_exponent_bits=-1, int? fp8_exponent_bias=-1, Tensor? index_remappings=None, Tensor? index_remappings_offsets=None, Tensor? index_remapping_groups=None, Tensor? index_remapping_group_offsets=None) -> ()");
+  DISPATCH_TO_CPU(
+      "int_nbit_split_embedding_nobag_codegen_lookup_function_out",
+      int_nbit_split_embedding_nobag_codegen_lookup_function_out_cpu);
+
   // GPU version of pruned_hashmap needs to use CPU version of
   // pruned_hashmap_insert
   m.def(
@@ -276,10 +566,31 @@ TORCH_LIBRARY_FRAGMENT(fbgemm, m) {
   DISPATCH_TO_CPU(
       "pruned_hashmap_lookup", pruned_hashmap_lookup_unweighted_cpu);
 
+  // Grouped layout of the pruned_hashmap_insert table probed with SIMD, built
+  // from the same inputs; the lookup output matches pruned_hashmap_lookup.
+  m.def(
+      "pruned_hashmap_grouped_build(Tensor indices, Tensor dense_indices, Tensor offsets, Tensor hash_table_offsets) -> (Tensor, Tensor)");
+  DISPATCH_TO_CPU(
+      "pruned_hashmap_grouped_build", pruned_hashmap_grouped_build_cpu);
+  m.def(
+      "pruned_hashmap_grouped_lookup(Tensor indices, Tensor offsets, Tensor groups, Tensor group_offsets) -> Tensor");
+  DISPATCH_TO_CPU(
+      "pruned_hashmap_grouped_lookup", pruned_hashmap_grouped_lookup_cpu);
+
   // CPU version of array lookup.
   m.def(
       "pruned_array_lookup(Tensor indices, Tensor offsets, Tensor index_remappings, Tensor index_remappings_offsets) -> Tensor");
   DISPATCH_TO_CPU("pruned_array_lookup", pruned_array_lookup_cpu);
+
+  // Bitmap layout of a pruned_array_lookup remapping that maps the kept
+  // indices of every table in increasing order to 0, 1, ...; the lookup
+  // output matches pruned_array_lookup at ~1 bit per original index.
+  m.def(
+      "pruned_bitmap_build(Tensor index_remappings, Tensor index_remappings_offsets) -> (Tensor, Tensor, Tensor)");
+  DISPATCH_TO_CPU("pruned_bitmap_build", pruned_bitmap_build_cpu);
+  m.def(
+      "pruned_bitmap_lookup(Tensor indices, Tensor offsets, Tensor bitmap, Tensor ranks, Tensor bitmap_offsets) -> Tensor");
+  DISPATCH_TO_CPU("pruned_bitmap_lookup", pruned_bitmap_lookup_cpu);
 }
 
 class PrunedMapCPU : public torch::jit::CustomClassHolder {
@@ -130,6 +130,49 @@ __launch_bounds__(kMaxThreads) void int_nbit_split_embedding_codegen_forward_pru
   }
 }
 
+__global__
+__launch_bounds__(kMaxThreads) void int_nbit_split_embedding_codegen_forward_pruned_bitmap_lookup_kernel(
+    const pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits>
+        indices,
+    const pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits>
+        offsets,
+    const pta::PackedTensorAccessor64<int32_t, 1, at::RestrictPtrTraits> bitmap,
+    const pta::PackedTensorAccessor64<int32_t, 1, at::RestrictPtrTraits> ranks,
+    const pta::PackedTensorAccessor32<int64_t, 1, at::RestrictPtrTraits>
+        bitmap_offsets,
+    const int32_t B,
+    const int32_t T,
+    pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits>
+        dense_indices) {
+  const int32_t b_t = blockIdx.x * blockDim.y + threadIdx.y;
+  const int32_t t = b_t / B;
+  const int32_t b = b_t % B;
+  if (b_t >= B * T) {
+    return;
+  }
+  const int32_t indices_start = offsets[t * B + b];
+  const int32_t indices_end = offsets[t * B + b + 1];
+  const int32_t L = indices_end - indices_start;
+
+  const int64_t bitmap_start = bitmap_offsets[t];
+  const int64_t num_words = bitmap_offsets[t + 1] - bitmap_start;
+
+  if (num_words > 0) {
+    // The bitmap of a table is ~1/32 of its remapping array, so its words and
+    // ranks mostly hit in L2 where the array would not
+    const auto* table_bitmap = &bitmap[bitmap_start];
+    const auto* table_ranks = &ranks[bitmap_start / kPrunedBitmapBlockWords];
+    for (int32_t l = threadIdx.x; l < L; l += blockDim.x) {
+      dense_indices[indices_start + l] = pruned_bitmap_dense_index(
+          table_bitmap, table_ranks, num_words, indices[indices_start + l]);
+    }
+  } else {
+    for (int32_t l = threadIdx.x; l < L; l += blockDim.x) {
+      dense_indices[indices_start + l] = indices[indices_start + l];
+    }
+  }
+}
+
 } // namespace nbit
 
 Tensor pruned_hashmap_lookup_cuda(
@@ -224,3 +267,55 @@ Tensor pruned_array_lookup_cuda(
   C10_CUDA_KERNEL_LAUNCH_CHECK();
   return dense_indices;
 }
+
+Tensor pruned_bitmap_lookup_cuda(
+    Tensor indices,
+    Tensor offsets,
+    Tensor bitmap,
+    Tensor ranks,
+    Tensor bitmap_offsets) {
+  TENSORS_ON_SAME_CUDA_GPU_IF_NOT_OPTIONAL(
+      indices, offsets, bitmap, ranks, bitmap_offsets);
+
+  CUDA_DEVICE_GUARD(indices);
+
+  auto dense_indices = at::empty_like(indices);
+  const int32_t T = bitmap_offsets.size(0) - 1;
+  TORCH_CHECK(
+      (offsets.size(0) - 1) % T == 0,
+      "offsets.size() - 1 is not divisible by T! offsets.size: ",
+      offsets.size(0),
+      "T: ",
+      T);
+  const int32_t B = (offsets.size(0) - 1) / T;
+  TORCH_CHECK(
+      B > 0, "offsets.size(): ", offsets.size(0), ", T: ", T, ", B: ", B);
+  TORCH_CHECK(indices.dim() == 1, "Tensor dim: ", indices.dim());
+  TORCH_CHECK(offsets.dim() == 1, "Tensor dim: ", offsets.dim());
+  TORCH_CHECK(bitmap.dim() == 1, "Tensor dim: ", bitmap.dim());
+  TORCH_CHECK(ranks.dim() == 1, "Tensor dim: ", ranks.dim());
+  TORCH_CHECK(
+      bitmap_offsets.dim() == 1, "Tensor dim: ", bitmap_offsets.dim());
+  constexpr size_t kForwardMaxThreads = 256;
+
+#ifdef FBGEMM_GPU_MEMCHECK
+  const auto func_name =
+      "int_nbit_split_embedding_codegen_forward_pruned_bitmap_lookup_kernel";
+#endif
+
+  nbit::int_nbit_split_embedding_codegen_forward_pruned_bitmap_lookup_kernel<<<
+      nbit::div_round_up(offsets.size(0), kForwardMaxThreads / kWarpSize),
+      dim3(kWarpSize, kForwardMaxThreads / kWarpSize),
+      0,
+      at::cuda::getCurrentCUDAStream()>>>(
+      MAKE_PTA_WITH_NAME(func_name, indices, int32_t, 1, 32),
+      MAKE_PTA_WITH_NAME(func_name, offsets, int32_t, 1, 32),
+      MAKE_PTA_WITH_NAME(func_name, bitmap, int32_t, 1, 64),
+      MAKE_PTA_WITH_NAME(func_name, ranks, int32_t, 1, 64),
+      MAKE_PTA_WITH_NAME(func_name, bitmap_offsets, int64_t, 1, 32),
+      B,
+      T,
+      MAKE_PTA_WITH_NAME(func_name, dense_indices, int32_t, 1, 32));
+  C10_CUDA_KERNEL_LAUNCH_CHECK();
+  return dense_indices;
+}
@@ -23,7 +23,7 @@ namespace nbit {
   same generated source file.
 */
 {% for emb_weight_type in ["FP32", "FP16", "FP8", "INT8", "INT4", "INT2"] %}
-template<typename index_t, typename output_t, size_t OutputRowsPerThread, size_t WarpsPerBlock, size_t InputRowsInFlight, size_t MinNum128BRows, size_t MaxNum128BRows, bool DeviceOnly>
+template<typename index_t, typename output_t, size_t OutputRowsPerThread, size_t WarpsPerBlock, size_t InputRowsInFlight, size_t MinNum128BRows, size_t MaxNum128BRows, size_t NumStages, bool DeviceOnly>
 __launch_bounds__(WarpsPerBlock * kWarpSize)
 __global__ void {{ type_map[emb_weight_type].enum_name }}_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{{ wdesc }}_kernel_small_L(
   const pta::PackedTensorAccessor64<uint8_t, 1, at::RestrictPtrTraits> dev_weights,
@@ -165,6 +165,11 @@ Tensor int_nbit_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{
     using index_t = int32_t;
 
     constexpr int32_t kWarpsPerBlock = 4;
+    // The kernels are persistent and pick the tables of their weight type and
+    // row size themselves, so launch at most one wave of resident blocks
+    const auto* device_prop = at::cuda::getCurrentDeviceProperties();
+    const int64_t max_resident_blocks = static_cast<int64_t>(device_prop->multiProcessorCount) *
+        (device_prop->maxThreadsPerMultiProcessor / (kWarpsPerBlock * kWarpSize));
 
     const auto device_only = lxu_cache_weights.numel() == 0 && uvm_weights.numel() == 0;
     #define Y(...) \
@@ -183,9 +188,9 @@ Tensor int_nbit_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{
     const auto func_name1 = "nbit::INT2_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{{ wdesc }}_kernel_small_L";
 #endif
 
-    #define X(DeviceOnly, OutputRowsPerThread, InputRowsInFlight, MinNum128BRows, MaxNum128BRows) \
-    nbit::INT2_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{{ wdesc }}_kernel_small_L<index_t, output_t, OutputRowsPerThread, kWarpsPerBlock, InputRowsInFlight, MinNum128BRows, MaxNum128BRows, DeviceOnly><<< \
-        nbit::div_round_up(T * nbit::div_round_up(B, OutputRowsPerThread), kWarpsPerBlock), \
+    #define X(DeviceOnly, OutputRowsPerThread, InputRowsInFlight, MinNum128BRows, MaxNum128BRows, NumStages) \
+    nbit::INT2_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{{ wdesc }}_kernel_small_L<index_t, output_t, OutputRowsPerThread, kWarpsPerBlock, InputRowsInFlight, MinNum128BRows, MaxNum128BRows, NumStages, DeviceOnly><<< \
+        std::min<int64_t>(nbit::div_round_up(T * nbit::div_round_up(B, OutputRowsPerThread), kWarpsPerBlock), max_resident_blocks), \
         dim3(kWarpSize, kWarpsPerBlock), \
         0, \
         at::cuda::getCurrentCUDAStream()>>>( \
@@ -218,13 +223,13 @@ Tensor int_nbit_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{
         auto max_int2_128b_rows = nbit::div_round_up(nbit::padded_row_size_in_bytes(max_int2_D, SparseType::INT2, row_alignment), 128);
         TORCH_CHECK(max_int2_128b_rows <= 4);
         if (max_int2_128b_rows > 0) {
-          Y(2, 16, 0, 1);
+          Y(2, 16, 0, 1, 1);
         }
         if (max_int2_128b_rows > 1) {
-          Y(2, 8, 1, 2);
+          Y(2, 8, 1, 2, 1);
         }
         if (max_int2_128b_rows > 2) {
-          Y(2, 8, 2, 4);
+          Y(2, 8, 2, 4, 1);
         }
       }
     }));
@@ -239,9 +244,9 @@ Tensor int_nbit_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{
     const auto func_name2 = "nbit::INT4_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{{ wdesc }}_kernel_small_L";
 #endif
 
-    #define X(DeviceOnly, OutputRowsPerThread, InputRowsInFlight, MinNum128BRows, MaxNum128BRows) \
-    nbit::INT4_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{{ wdesc }}_kernel_small_L<index_t, output_t, OutputRowsPerThread, kWarpsPerBlock, InputRowsInFlight, MinNum128BRows, MaxNum128BRows, DeviceOnly><<< \
-        nbit::div_round_up(T * nbit::div_round_up(B, OutputRowsPerThread), kWarpsPerBlock), \
+    #define X(DeviceOnly, OutputRowsPerThread, InputRowsInFlight, MinNum128BRows, MaxNum128BRows, NumStages) \
+    nbit::INT4_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{{ wdesc }}_kernel_small_L<index_t, output_t, OutputRowsPerThread, kWarpsPerBlock, InputRowsInFlight, MinNum128BRows, MaxNum128BRows, NumStages, DeviceOnly><<< \
+        std::min<int64_t>(nbit::div_round_up(T * nbit::div_round_up(B, OutputRowsPerThread), kWarpsPerBlock), max_resident_blocks), \
         dim3(kWarpSize, kWarpsPerBlock), \
         0, \
         at::cuda::getCurrentCUDAStream()>>>( \
@@ -274,16 +279,16 @@ Tensor int_nbit_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{
         auto max_int4_128b_rows = nbit::div_round_up(nbit::padded_row_size_in_bytes(max_int4_D, SparseType::INT4, row_alignment), 128);
         TORCH_CHECK(max_int4_128b_rows <= 8);
         if (max_int4_128b_rows > 0) {
-          Y(4, 8, 0, 1);
+          Y(4, 8, 0, 1, 1);
         }
         if (max_int4_128b_rows > 1) {
-          Y(2, 8, 1, 2);
+          Y(2, 8, 1, 2, 1);
         }
         if (max_int4_128b_rows > 2) {
-          Y(1, 4, 2, 4);
+          Y(1, 4, 2, 4, 2);
         }
         if (max_int4_128b_rows > 4) {
-          Y(1, 4, 4, 8);
+          Y(1, 4, 4, 8, 2);
         }
       }
     }));
@@ -298,9 +303,9 @@ Tensor int_nbit_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{
     const auto func_name3 = "nbit::INT8_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{{ wdesc }}_kernel_small_L";
 #endif
 
-    #define X(DeviceOnly, OutputRowsPerThread, InputRowsInFlight, MinNum128BRows, MaxNum128BRows) \
-    nbit::INT8_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{{ wdesc }}_kernel_small_L<index_t, output_t, OutputRowsPerThread, kWarpsPerBlock, InputRowsInFlight, MinNum128BRows, MaxNum128BRows, DeviceOnly><<< \
-        nbit::div_round_up(T * nbit::div_round_up(B, OutputRowsPerThread), kWarpsPerBlock), \
+    #define X(DeviceOnly, OutputRowsPerThread, InputRowsInFlight, MinNum128BRows, MaxNum128BRows, NumStages) \
+    nbit::INT8_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{{ wdesc }}_kernel_small_L<index_t, output_t, OutputRowsPerThread, kWarpsPerBlock, InputRowsInFlight, MinNum128BRows, MaxNum128BRows, NumStages, DeviceOnly><<< \
+        std::min<int64_t>(nbit::div_round_up(T * nbit::div_round_up(B, OutputRowsPerThread), kWarpsPerBlock), max_resident_blocks), \
         dim3(kWarpSize, kWarpsPerBlock), \
         0, \
         at::cuda::getCurrentCUDAStream()>>>( \
@@ -333,19 +338,19 @@ Tensor int_nbit_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{
         auto max_int8_128b_rows = nbit::div_round_up(nbit::padded_row_size_in_bytes(max_int8_D, SparseType::INT8, row_alignment), 128);
         TORCH_CHECK(max_int8_128b_rows <= 16);
         if (max_int8_128b_rows > 0) {
-          Y(2, 8, 0, 1);
+          Y(2, 8, 0, 1, 1);
         }
         if (max_int8_128b_rows > 1) {
-          Y(2, 4, 1, 2);
+          Y(2, 4, 1, 2, 1);
         }
         if (max_int8_128b_rows > 2) {
-          Y(2, 4, 2, 4);
+          Y(2, 4, 2, 4, 2);
         }
         if (max_int8_128b_rows > 4) {
-          Y(2, 4, 4, 8);
+          Y(2, 2, 4, 8, 2);
         }
         if (max_int8_128b_rows > 8) {
-          Y(2, 2, 8, 16);
+          Y(2, 1, 8, 16, 2);
         }
       }
     }));
@@ -360,9 +365,9 @@ Tensor int_nbit_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{
     const auto func_name4 = "nbit::FP8_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{{ wdesc }}_kernel_small_L";
 #endif
 
-    #define X(DeviceOnly, OutputRowsPerThread, InputRowsInFlight, MinNum128BRows, MaxNum128BRows) \
-    nbit::FP8_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{{ wdesc }}_kernel_small_L<index_t, output_t, OutputRowsPerThread, kWarpsPerBlock, InputRowsInFlight, MinNum128BRows, MaxNum128BRows, DeviceOnly><<< \
-        nbit::div_round_up(T * nbit::div_round_up(B, OutputRowsPerThread), kWarpsPerBlock), \
+    #define X(DeviceOnly, OutputRowsPerThread, InputRowsInFlight, MinNum128BRows, MaxNum128BRows, NumStages) \
+    nbit::FP8_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{{ wdesc }}_kernel_small_L<index_t, output_t, OutputRowsPerThread, kWarpsPerBlock, InputRowsInFlight, MinNum128BRows, MaxNum128BRows, NumStages, DeviceOnly><<< \
+        std::min<int64_t>(nbit::div_round_up(T * nbit::div_round_up(B, OutputRowsPerThread), kWarpsPerBlock), max_resident_blocks), \
         dim3(kWarpSize, kWarpsPerBlock), \
         0, \
         at::cuda::getCurrentCUDAStream()>>>( \
@@ -397,19 +402,19 @@ Tensor int_nbit_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{
         auto max_fp8_128b_rows = nbit::div_round_up(nbit::padded_row_size_in_bytes(max_float8_D, SparseType::FP8, row_alignment), 128);
         TORCH_CHECK(max_fp8_128b_rows <= 16);
         if (max_fp8_128b_rows > 0) {
-          Y(2, 8, 0, 1);
+          Y(2, 8, 0, 1, 1);
         }
         if (max_fp8_128b_rows > 1) {
-          Y(2, 4, 1, 2);
+          Y(2, 4, 1, 2, 1);
         }
         if (max_fp8_128b_rows > 2) {
-          Y(2, 4, 2, 4);
+          Y(2, 4, 2, 4, 1);
         }
         if (max_fp8_128b_rows > 4) {
-          Y(2, 4, 4, 8);
+          Y(2, 4, 4, 8, 1);
         }
         if (max_fp8_128b_rows > 8) {
-          Y(2, 2, 8, 16);
+          Y(2, 2, 8, 16, 1);
         }
       }
     }));
@@ -424,9 +429,9 @@ Tensor int_nbit_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{
     const auto func_name5 = "nbit::FP16_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{{ wdesc }}_kernel_small_L";
 #endif
 
-    #define X(DeviceOnly, OutputRowsPerThread, InputRowsInFlight, MinNum128BRows, MaxNum128BRows) \
-    nbit::FP16_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{{ wdesc }}_kernel_small_L<index_t, output_t, OutputRowsPerThread, kWarpsPerBlock, InputRowsInFlight, MinNum128BRows, MaxNum128BRows, DeviceOnly><<< \
-        nbit::div_round_up(T * nbit::div_round_up(B, OutputRowsPerThread), kWarpsPerBlock), \
+    #define X(DeviceOnly, OutputRowsPerThread, InputRowsInFlight, MinNum128BRows, MaxNum128BRows, NumStages) \
+    nbit::FP16_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{{ wdesc }}_kernel_small_L<index_t, output_t, OutputRowsPerThread, kWarpsPerBlock, InputRowsInFlight, MinNum128BRows, MaxNum128BRows, NumStages, DeviceOnly><<< \
+        std::min<int64_t>(nbit::div_round_up(T * nbit::div_round_up(B, OutputRowsPerThread), kWarpsPerBlock), max_resident_blocks), \
         dim3(kWarpSize, kWarpsPerBlock), \
         0, \
         at::cuda::getCurrentCUDAStream()>>>( \
@@ -459,19 +464,19 @@ Tensor int_nbit_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{
         auto max_fp16_128b_rows = nbit::div_round_up(nbit::padded_row_size_in_bytes(max_float16_D, SparseType::FP16, row_alignment), 128);
         TORCH_CHECK(max_fp16_128b_rows <= 32);
         if (max_fp16_128b_rows > 0) {
-          Y(2, 8, 0, 2);
+          Y(2, 8, 0, 2, 1);
         }
         if (max_fp16_128b_rows > 2) {
-          Y(2, 8, 2, 4);
+          Y(2, 8, 2, 4, 1);
         }
         if (max_fp16_128b_rows > 4) {
-          Y(2, 4, 4, 8);
+          Y(2, 4, 4, 8, 1);
         }
         if (max_fp16_128b_rows > 8) {
-          Y(2, 2, 8, 16);
+          Y(2, 2, 8, 16, 1);
         }
         if (max_fp16_128b_rows > 16) {
-          Y(2, 1, 16, 32);
+          Y(2, 1, 16, 32, 1);
         }
       }
     }));
@@ -486,9 +491,9 @@ Tensor int_nbit_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{
     const auto func_name6 = "nbit::FP32_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{{ wdesc }}_kernel_small_L";
 #endif
 
-    #define X(DeviceOnly, OutputRowsPerThread, InputRowsInFlight, MinNum128BRows, MaxNum128BRows) \
-    nbit::FP32_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{{ wdesc }}_kernel_small_L<index_t, output_t, OutputRowsPerThread, kWarpsPerBlock, InputRowsInFlight, MinNum128BRows, MaxNum128BRows, DeviceOnly><<< \
-        nbit::div_round_up(T * nbit::div_round_up(B, OutputRowsPerThread), kWarpsPerBlock), \
+    #define X(DeviceOnly, OutputRowsPerThread, InputRowsInFlight, MinNum128BRows, MaxNum128BRows, NumStages) \
+    nbit::FP32_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{{ wdesc }}_kernel_small_L<index_t, output_t, OutputRowsPerThread, kWarpsPerBlock, InputRowsInFlight, MinNum128BRows, MaxNum128BRows, NumStages, DeviceOnly><<< \
+        std::min<int64_t>(nbit::div_round_up(T * nbit::div_round_up(B, OutputRowsPerThread), kWarpsPerBlock), max_resident_blocks), \
         dim3(kWarpSize, kWarpsPerBlock), \
         0, \
         at::cuda::getCurrentCUDAStream()>>>( \
@@ -521,16 +526,16 @@ Tensor int_nbit_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{
         auto max_fp32_128b_rows = nbit::div_round_up(nbit::padded_row_size_in_bytes(max_float32_D, SparseType::FP32, row_alignment), 128);
         TORCH_CHECK(max_fp32_128b_rows <= 64);
         if (max_fp32_128b_rows > 0) {
-          Y(2, 4, 0, 4);
+          Y(2, 4, 0, 4, 1);
         }
         if (max_fp32_128b_rows > 4) {
-          Y(2, 2, 4, 16);
+          Y(2, 2, 4, 16, 1);
         }
         if (max_fp32_128b_rows > 16) {
-          Y(1, 1, 16, 32);
+          Y(1, 1, 16, 32, 1);
         }
         if (max_fp32_128b_rows > 32) {
-          Y(1, 1, 32, 64);
+          Y(1, 1, 32, 64, 1);
         }
       }
     }));
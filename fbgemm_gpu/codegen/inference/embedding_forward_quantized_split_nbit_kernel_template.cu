@@ -17,7 +17,7 @@ using Tensor = at::Tensor;
 namespace nbit {
 
 // TODO: increase code sharing (templates for accumulator_ty, accumulation, outputs per thread, etc?)
-template<typename index_t, typename output_t, size_t OutputRowsPerThread, size_t WarpsPerBlock, size_t InputRowsInFlight, size_t MinNum128BRows, size_t MaxNum128BRows, bool DeviceOnly>
+template<typename index_t, typename output_t, size_t OutputRowsPerThread, size_t WarpsPerBlock, size_t InputRowsInFlight, size_t MinNum128BRows, size_t MaxNum128BRows, size_t NumStages, bool DeviceOnly>
 __launch_bounds__(WarpsPerBlock * kWarpSize)
 __global__ void {{ emb_weight_type.enum_name }}_split_embedding{{ "_nobag" if nobag else "" }}_codegen_forward_{{ wdesc }}_kernel_small_L(
   const pta::PackedTensorAccessor64<uint8_t, 1, at::RestrictPtrTraits> dev_weights,
@@ -55,249 +55,312 @@ __global__ void {{ emb_weight_type.enum_name }}_split_embedding{{ "_nobag" if no
   {% else %}
   const int32_t B = (offsets.size(0) - 1) / T;
   {% endif %}
-  const int32_t bb_t = blockIdx.x * blockDim.y + threadIdx.y;
-  if (bb_t >= fd_B.D() * T) {
-    return;
-  }
   static_assert(
     std::is_same_v<output_t, float> || std::is_same_v<output_t, at::BFloat16> || std::is_same_v<output_t, at::Half> || std::is_same_v<output_t, uint8_t>,
     "output_t can only be float or half or bytes now"
   );
 
-  int32_t t;
-  int32_t bb;
-  fd_B.DivMod(bb_t, &t, &bb);
-
-  {% if not nobag %}
-  const int32_t D_start = D_offsets[t];
-  const int32_t D_end = D_offsets[t + 1];
-  const int32_t D = D_end - D_start;
-  {% endif %}
-  SparseType weight_ty = static_cast<SparseType>(weights_tys[t]);
-  if (weight_ty != SparseType::{{ emb_weight_type.enum_name }}) {
-      return;
-  }
-
-  // default to 16 byte alignment for GPU TBE
-  const int32_t D_bytes = padded_row_size_in_bytes(D, weight_ty, row_alignment);
-
-  if (D_bytes <= MinNum128BRows * 128 || D_bytes > MaxNum128BRows * 128) {
-    return;
-  }
-
-
-  const int64_t weights_offset = weights_offsets[t];
-  const int32_t D_total = padded_D(D, weight_ty);
-  const int32_t D_padding = D_total - D;
+  // The kernel is persistent (the grid is sized to the GPU, not to T * B).
+  // Each block walks the tables in chunks and compacts the tables of this
+  // kernel's weight type and row size into group_ts.  The warps of the grid
+  // then take the (table, bb) items of the chunk round robin, continuing
+  // where the previous chunk stopped, so the work of a group is spread evenly
+  // over all SMs however its tables are interleaved with other groups.
+  constexpr int32_t kTablesPerChunk = WarpsPerBlock * kWarpSize;
+  __shared__ int32_t group_ts[kTablesPerChunk];
+  __shared__ int32_t num_group_ts_per_warp[WarpsPerBlock];
 
   uint32_t warp_idx = threadIdx.y;
-  int32_t indices_starts[OutputRowsPerThread];
-  int32_t Ls[OutputRowsPerThread];
-  int32_t max_Ls = 0;
-
-  for (uint32_t i = 0; i < OutputRowsPerThread; ++i) {
-    uint32_t b = min(static_cast<uint32_t>(bb * OutputRowsPerThread + i), static_cast<uint32_t>(B - 1));
-    int32_t indices_start = offsets[t * B + b];
-    int32_t indices_end = offsets[t * B + b + 1];
-    indices_starts[i] = indices_start;
-    Ls[i] = indices_end - indices_start;
-    max_Ls = max(max_Ls, Ls[i]);
-  }
-  const index_t* indices_ = &indices[0];
-
-  const uint8_t* __restrict__ weights;
-  const auto placement = DeviceOnly ? PlacementType::DEVICE : static_cast<PlacementType>(weights_placements[t]);
-  if (placement == PlacementType::DEVICE) {
-      weights = &dev_weights[weights_offset];
-  } else {
-      weights = &uvm_weights[weights_offset];
-  }
-  constexpr size_t kOutputsPerThread = {{ (32 // emb_weight_type.bit_width) }};
-
-  constexpr uint32_t NumUint4LoadsPerRow = MaxNum128BRows * 128 / sizeof(uint4);
-  const uint32_t uint4_loads_per_row = div_round_up(D_bytes, sizeof(uint4));
-
-  {% if not nobag %}
-  VecNT<{{ (32 // emb_weight_type.bit_width) }}, PrimitiveType::{{ emb_weight_type.primitive_type }}> accumulators[OutputRowsPerThread][MaxNum128BRows];
-  {% endif %}
-
-  for (uint32_t L_start = 0; L_start < max_Ls; L_start += InputRowsInFlight) {
-    uint32_t input_rows_in_flight = min(static_cast<uint32_t>(InputRowsInFlight), max_Ls - L_start);
-
-    typedef uint4 AllBuffers[WarpsPerBlock][OutputRowsPerThread][InputRowsInFlight][NumUint4LoadsPerRow];
-    __shared__ AllBuffers buffers;
-
-    {% if weighted %}
-    typedef float AllIndiceWeights[WarpsPerBlock][OutputRowsPerThread][InputRowsInFlight];
-    __shared__ AllIndiceWeights buffers_indice_weights;
-    {% endif %}
-
-    for (uint32_t load_idx = threadIdx.x; load_idx < input_rows_in_flight * NumUint4LoadsPerRow; load_idx += kWarpSize) {
-      uint32_t row_load_idx = load_idx % NumUint4LoadsPerRow;
-      uint32_t input_row_idx = (load_idx / NumUint4LoadsPerRow);
-      bool load_idx_valid = row_load_idx < uint4_loads_per_row;
-      #pragma unroll OutputRowsPerThread
-      for (uint32_t i = 0; i < OutputRowsPerThread; ++i) {
-        bool valid = load_idx_valid && L_start + input_row_idx < Ls[i];
-        bool cache_valid = !DeviceOnly && (placement == PlacementType::MANAGED_CACHING && valid);
-        int32_t idx = valid ? indices_[indices_starts[i] + L_start + input_row_idx] : -1;
-        int32_t cache_idx = (!DeviceOnly && cache_valid) ? lxu_cache_locations[indices_starts[i] + L_start + input_row_idx] : -1;
-        valid = valid && (idx != -1);
-        const uint4* row;
-        if (!DeviceOnly && cache_valid && cache_idx != kCacheLocationMissing) {
-          row = reinterpret_cast<const uint4*>(&lxu_cache_weights[static_cast<int64_t>(cache_idx)][0]);
-        } else if (valid) {
-          row = reinterpret_cast<const uint4*>(&weights[static_cast<int64_t>(idx) * D_bytes]);
-        } else {
-          row = reinterpret_cast<const uint4*>(&weights[0]);
-        }
-        cp_async_zfill_cg<sizeof(uint4)>(&buffers[warp_idx][i][input_row_idx][row_load_idx], &row[row_load_idx], valid);
-
-        {% if weighted %}
-        buffers_indice_weights[warp_idx][i][input_row_idx] = valid ? indice_weights[indices_starts[i] + L_start + input_row_idx] : 0.0;
+  const int32_t num_bb = fd_B.D();
+  const int64_t global_warp_idx = blockIdx.x * WarpsPerBlock + warp_idx;
+  const int64_t num_warps = gridDim.x * WarpsPerBlock;
+  // Number of items of this group in the chunks that were already processed
+  int64_t item_offset = 0;
+
+  for (int32_t t_start = 0; t_start < T; t_start += kTablesPerChunk) {
+    const int32_t chunk_t = t_start + warp_idx * kWarpSize + threadIdx.x;
+    bool in_group = false;
+    if (chunk_t < T) {
+      const auto weight_ty = static_cast<SparseType>(weights_tys[chunk_t]);
+      if (weight_ty == SparseType::{{ emb_weight_type.enum_name }}) {
+        {% if not nobag %}
+        const int32_t D = D_offsets[chunk_t + 1] - D_offsets[chunk_t];
         {% endif %}
+        // default to 16 byte alignment for GPU TBE
+        const int32_t D_bytes = padded_row_size_in_bytes(D, weight_ty, row_alignment);
+        in_group = D_bytes > MinNum128BRows * 128 && D_bytes <= MaxNum128BRows * 128;
       }
     }
-    // equivalent to fence + wait.
-    cp_async_wait<0>();
-    syncwarp();
-    for (uint32_t input_row_idx = 0; input_row_idx < input_rows_in_flight; ++input_row_idx) {
-      #pragma unroll OutputRowsPerThread
+    const auto group_mask = ballot_sync(in_group);
+    if (threadIdx.x == 0) {
+      num_group_ts_per_warp[warp_idx] = __popcll(group_mask);
+    }
+    __syncthreads();
+    int32_t group_t_idx = 0;
+    int32_t num_group_ts = 0;
+    for (uint32_t w = 0; w < WarpsPerBlock; ++w) {
+      group_t_idx += w < warp_idx ? num_group_ts_per_warp[w] : 0;
+      num_group_ts += num_group_ts_per_warp[w];
+    }
+    if (in_group) {
+      const auto lanes_before = (static_cast<decltype(group_mask)>(1) << threadIdx.x) - 1;
+      group_ts[group_t_idx + __popcll(group_mask & lanes_before)] = chunk_t;
+    }
+    __syncthreads();
+
+    const int32_t num_chunk_items = num_group_ts * num_bb;
+    const int32_t first_item =
+        ((global_warp_idx - item_offset) % num_warps + num_warps) % num_warps;
+    for (int32_t item = first_item; item < num_chunk_items; item += num_warps) {
+      int32_t t_idx;
+      int32_t bb;
+      fd_B.DivMod(item, &t_idx, &bb);
+      const int32_t t = group_ts[t_idx];
+      {% if not nobag %}
+      const int32_t D_start = D_offsets[t];
+      const int32_t D_end = D_offsets[t + 1];
+      const int32_t D = D_end - D_start;
+      {% endif %}
+      const SparseType weight_ty = SparseType::{{ emb_weight_type.enum_name }};
+      const int32_t D_bytes = padded_row_size_in_bytes(D, weight_ty, row_alignment);
+
+      const int64_t weights_offset = weights_offsets[t];
+      const int32_t D_total = padded_D(D, weight_ty);
+      const int32_t D_padding = D_total - D;
+
+      int32_t indices_starts[OutputRowsPerThread];
+      int32_t Ls[OutputRowsPerThread];
+      int32_t max_Ls = 0;
+
       for (uint32_t i = 0; i < OutputRowsPerThread; ++i) {
-        bool valid = L_start + input_row_idx < Ls[i];
-        if (!valid) {
+        uint32_t b = min(static_cast<uint32_t>(bb * OutputRowsPerThread + i), static_cast<uint32_t>(B - 1));
+        int32_t indices_start = offsets[t * B + b];
+        int32_t indices_end = offsets[t * B + b + 1];
+        indices_starts[i] = indices_start;
+        Ls[i] = indices_end - indices_start;
+        max_Ls = max(max_Ls, Ls[i]);
+      }
+      const index_t* indices_ = &indices[0];
+
+      const uint8_t* __restrict__ weights;
+      const auto placement = DeviceOnly ? PlacementType::DEVICE : static_cast<PlacementType>(weights_placements[t]);
+      if (placement == PlacementType::DEVICE) {
+          weights = &dev_weights[weights_offset];
+      } else {
+          weights = &uvm_weights[weights_offset];
+      }
+      constexpr size_t kOutputsPerThread = {{ (32 // emb_weight_type.bit_width) }};
+
+      constexpr uint32_t NumUint4LoadsPerRow = MaxNum128BRows * 128 / sizeof(uint4);
+      const uint32_t uint4_loads_per_row = div_round_up(D_bytes, sizeof(uint4));
+
+      {% if not nobag %}
+      VecNT<{{ (32 // emb_weight_type.bit_width) }}, PrimitiveType::{{ emb_weight_type.primitive_type }}> accumulators[OutputRowsPerThread][MaxNum128BRows];
+      {% endif %}
+
+      // The rows are loaded with cp.async in chunks of InputRowsInFlight rows
+      // through NumStages buffers: chunk `step` is issued while chunk
+      // `step - (NumStages - 1)` is accumulated, which hides the HBM latency
+      // of the large-D buckets.  NumStages = 1 waits for every chunk.
+      typedef uint4 AllBuffers[WarpsPerBlock][NumStages][OutputRowsPerThread][InputRowsInFlight][NumUint4LoadsPerRow];
+      __shared__ AllBuffers buffers;
+
+      {% if weighted %}
+      typedef float AllIndiceWeights[WarpsPerBlock][NumStages][OutputRowsPerThread][InputRowsInFlight];
+      __shared__ AllIndiceWeights buffers_indice_weights;
+      {% endif %}
+
+      const uint32_t num_L_chunks = div_round_up(max_Ls, InputRowsInFlight);
+      for (uint32_t step = 0; step < num_L_chunks + NumStages - 1; ++step) {
+        {
+          // Issue the loads of chunk `step` into its stage
+          const uint32_t L_start = step * InputRowsInFlight;
+          const uint32_t stage = step % NumStages;
+          const uint32_t input_rows_in_flight = L_start < max_Ls ? min(static_cast<uint32_t>(InputRowsInFlight), max_Ls - L_start) : 0;
+
+          for (uint32_t load_idx = threadIdx.x; load_idx < input_rows_in_flight * NumUint4LoadsPerRow; load_idx += kWarpSize) {
+            uint32_t row_load_idx = load_idx % NumUint4LoadsPerRow;
+            uint32_t input_row_idx = (load_idx / NumUint4LoadsPerRow);
+            bool load_idx_valid = row_load_idx < uint4_loads_per_row;
+            #pragma unroll OutputRowsPerThread
+            for (uint32_t i = 0; i < OutputRowsPerThread; ++i) {
+              bool valid = load_idx_valid && L_start + input_row_idx < Ls[i];
+              bool cache_valid = !DeviceOnly && (placement == PlacementType::MANAGED_CACHING && valid);
+              int32_t idx = valid ? indices_[indices_starts[i] + L_start + input_row_idx] : -1;
+              int32_t cache_idx = (!DeviceOnly && cache_valid) ? lxu_cache_locations[indices_starts[i] + L_start + input_row_idx] : -1;
+              valid = valid && (idx != -1);
+              const uint4* row;
+              if (!DeviceOnly && cache_valid && cache_idx != kCacheLocationMissing) {
+                row = reinterpret_cast<const uint4*>(&lxu_cache_weights[static_cast<int64_t>(cache_idx)][0]);
+              } else if (valid) {
+                row = reinterpret_cast<const uint4*>(&weights[static_cast<int64_t>(idx) * D_bytes]);
+              } else {
+                row = reinterpret_cast<const uint4*>(&weights[0]);
+              }
+              cp_async_zfill_cg<sizeof(uint4)>(&buffers[warp_idx][stage][i][input_row_idx][row_load_idx], &row[row_load_idx], valid);
+
+              {% if weighted %}
+              buffers_indice_weights[warp_idx][stage][i][input_row_idx] = valid ? indice_weights[indices_starts[i] + L_start + input_row_idx] : 0.0;
+              {% endif %}
+            }
+          }
+        }
+        // Every step commits a group, possibly empty, so that the wait below
+        // always leaves exactly the NumStages - 1 newest chunks in flight
+        cp_async_fence();
+        if (step < NumStages - 1) {
           continue;
         }
-        const uint32_t* row = reinterpret_cast<const uint32_t*>(&buffers[warp_idx][i][input_row_idx][0]);
-        // scale and bias are at the beginning of each row.
-        // rationale: have scale/shift at start since these get loaded first
-        // and then broadcasted around so it might speed up the first cache miss.
-        {% if emb_weight_type.primitive_type == "INT" %}
-        half2 shift_scale = reinterpret_cast<const half2*>(row)[0];
-        {% endif %}
-
-        {% if weighted %}
-        float row_weight = buffers_indice_weights[warp_idx][i][input_row_idx];
-        {% endif %}
+        cp_async_wait<NumStages - 1>();
+        syncwarp();
+
+        const uint32_t L_start = (step - (NumStages - 1)) * InputRowsInFlight;
+        const uint32_t stage = (step - (NumStages - 1)) % NumStages;
+        const uint32_t input_rows_in_flight = min(static_cast<uint32_t>(InputRowsInFlight), max_Ls - L_start);
+        for (uint32_t input_row_idx = 0; input_row_idx < input_rows_in_flight; ++input_row_idx) {
+          #pragma unroll OutputRowsPerThread
+          for (uint32_t i = 0; i < OutputRowsPerThread; ++i) {
+            bool valid = L_start + input_row_idx < Ls[i];
+            if (!valid) {
+              continue;
+            }
+            const uint32_t* row = reinterpret_cast<const uint32_t*>(&buffers[warp_idx][stage][i][input_row_idx][0]);
+            // scale and bias are at the beginning of each row.
+            // rationale: have scale/shift at start since these get loaded first
+            // and then broadcasted around so it might speed up the first cache miss.
+            {% if emb_weight_type.primitive_type == "INT" %}
+            half2 shift_scale = reinterpret_cast<const half2*>(row)[0];
+            {% endif %}
+
+            {% if weighted %}
+            float row_weight = buffers_indice_weights[warp_idx][stage][i][input_row_idx];
+            {% endif %}
+
+            using scalar_t = {{ emb_weight_type.cpp_type_name }};
+
+            {% if not nobag %}
+            #pragma unroll MaxNum128BRows
+            for (uint32_t j = 0; j < MaxNum128BRows; ++j) {
+              scalar_t v = reinterpret_cast<const scalar_t*>(row)[kWarpSize * j + threadIdx.x];
+              {% if weighted %}
+              accumulators[i][j].fma(v, {% if emb_weight_type.primitive_type == "INT" %} shift_scale, {% elif emb_weight_type.enum_name == "FP8" %} exponent_bits, exponent_bias, {% endif %} row_weight);
+              {% else %}
+              accumulators[i][j].add(v{% if emb_weight_type.primitive_type == "INT" %}, shift_scale {% elif emb_weight_type.enum_name == "FP8" %}, exponent_bits, exponent_bias {% endif %});
+              {% endif %}
+            }
+            {% else %}
+            const int32_t output_j = indices_starts[i] + L_start + input_row_idx;
+            if constexpr (std::is_same_v<output_t, float> || std::is_same_v<output_t, at::Half> || std::is_same_v<output_t, at::BFloat16>) {
+              #pragma unroll MaxNum128BRows
+              for (uint32_t j = 0; j < MaxNum128BRows; ++j) {
+                // Read the uint8/4/2 values: note that first 4 Bytes will be ditched later:
+                // We shift back by 4/8/16 elements to remove the first 4 Bytes (which is garbage due to
+                // the scale/shift handling).
+                // Reason: to avoid divergence the first thread in the warp computes garbage.
+                const int32_t output_d = kWarpSize * j * kOutputsPerThread + threadIdx.x * kOutputsPerThread - D_padding;
+                scalar_t v = reinterpret_cast<const scalar_t*>(row)[kWarpSize * j + threadIdx.x];
+                if (output_d >= 0 && output_d < D) {
+                  const int num_valid_outputs = min(static_cast<int>(D - output_d), static_cast<int>({{ (32 // emb_weight_type.bit_width) }}));
+                  VecNT<{{ (32 // emb_weight_type.bit_width) }}, PrimitiveType::{{ emb_weight_type.primitive_type }}> acc(v{% if emb_weight_type.primitive_type == "INT" %}, shift_scale {% elif emb_weight_type.enum_name == "FP8" %}, exponent_bits, exponent_bias {% endif %});
+                  acc.store(&output[output_j][output_d], num_valid_outputs);
+                }
+              }
+            } else if constexpr (std::is_same_v<output_t, uint8_t>) {
+              // INT8:
+              // apply per feature row-wise int8
+              auto thread_local_min = std::numeric_limits<float>::max();
+              auto thread_local_max = std::numeric_limits<float>::lowest();
+              float2 qparams;
+              #pragma unroll MaxNum128BRows
+              for (uint32_t j = 0; j < MaxNum128BRows; ++j) {
+                int32_t output_d = kWarpSize * j * kOutputsPerThread + threadIdx.x * kOutputsPerThread - D_padding;
+                scalar_t v = reinterpret_cast<const scalar_t*>(row)[kWarpSize * j + threadIdx.x];
+                VecNT<{{ (32 // emb_weight_type.bit_width) }}, PrimitiveType::{{ emb_weight_type.primitive_type }}> acc(v{% if emb_weight_type.primitive_type == "INT" %}, shift_scale {% elif emb_weight_type.enum_name == "FP8" %}, exponent_bits, exponent_bias {% endif %});
+                if (output_d >= 0 && output_d < D) {
+                  thread_local_max = max(thread_local_max, float{{ (32 // emb_weight_type.bit_width) }}_max(acc.acc));
+                  thread_local_min = min(thread_local_min, float{{ (32 // emb_weight_type.bit_width) }}_min(acc.acc));
+                }
+              }
+              qparams = warp_find_qparams(thread_local_min, thread_local_max);
+              #pragma unroll MaxNum128BRows
+              for (uint32_t j = 0; j < MaxNum128BRows; ++j) {
+                const int32_t output_d = kWarpSize * j * kOutputsPerThread + threadIdx.x * kOutputsPerThread - D_padding;
+                scalar_t v = reinterpret_cast<const scalar_t*>(row)[kWarpSize * j + threadIdx.x];
+                if (output_d >= 0 && output_d < D) {
+                  const int num_valid_outputs = min(static_cast<int>(D - output_d), static_cast<int>({{ (32 // emb_weight_type.bit_width) }}));
+                  VecNT<{{ (32 // emb_weight_type.bit_width) }}, PrimitiveType::{{ emb_weight_type.primitive_type }}> acc(v{% if emb_weight_type.primitive_type == "INT" %}, shift_scale {% elif emb_weight_type.enum_name == "FP8" %}, exponent_bits, exponent_bias {% endif %});
+                  acc.store(&output[output_j][output_d], qparams, num_valid_outputs);
+                }
+              }
+              if (threadIdx.x == 0) {
+                store_qparams_to_row(&output[output_j][D], qparams);
+              }
+            }
+            {% endif %}
+          }
+        }
+        // The next step loads into the stage that was just consumed
+        syncwarp();
+      }
 
-        using scalar_t = {{ emb_weight_type.cpp_type_name }};
+      {% if not nobag %}
+      #pragma unroll OutputRowsPerThread
+      for (uint32_t i = 0; i < OutputRowsPerThread; ++i) {
+        const uint32_t b = min(static_cast<uint32_t>(bb * OutputRowsPerThread + i), static_cast<uint32_t>(B - 1));
+        const float inv_L = (mean_pooling && Ls[i] != 0) ? static_cast<float>(1.0) / Ls[i]: static_cast<float>(1.0);
 
-        {% if not nobag %}
-        #pragma unroll MaxNum128BRows
-        for (uint32_t j = 0; j < MaxNum128BRows; ++j) {
-          scalar_t v = reinterpret_cast<const scalar_t*>(row)[kWarpSize * j + threadIdx.x];
-          {% if weighted %}
-          accumulators[i][j].fma(v, {% if emb_weight_type.primitive_type == "INT" %} shift_scale, {% elif emb_weight_type.enum_name == "FP8" %} exponent_bits, exponent_bias, {% endif %} row_weight);
-          {% else %}
-          accumulators[i][j].add(v{% if emb_weight_type.primitive_type == "INT" %}, shift_scale {% elif emb_weight_type.enum_name == "FP8" %}, exponent_bits, exponent_bias {% endif %});
-          {% endif %}
-        }
-        {% else %}
-        const int32_t output_j = indices_starts[i] + L_start + input_row_idx;
         if constexpr (std::is_same_v<output_t, float> || std::is_same_v<output_t, at::Half> || std::is_same_v<output_t, at::BFloat16>) {
           #pragma unroll MaxNum128BRows
           for (uint32_t j = 0; j < MaxNum128BRows; ++j) {
-            // Read the uint8/4/2 values: note that first 4 Bytes will be ditched later:
-            // We shift back by 4/8/16 elements to remove the first 4 Bytes (which is garbage due to
-            // the scale/shift handling).
-            // Reason: to avoid divergence the first thread in the warp computes garbage.
             const int32_t output_d = kWarpSize * j * kOutputsPerThread + threadIdx.x * kOutputsPerThread - D_padding;
-            scalar_t v = reinterpret_cast<const scalar_t*>(row)[kWarpSize * j + threadIdx.x];
+            accumulators[i][j].mul(inv_L);
+
             if (output_d >= 0 && output_d < D) {
               const int num_valid_outputs = min(static_cast<int>(D - output_d), static_cast<int>({{ (32 // emb_weight_type.bit_width) }}));
-              VecNT<{{ (32 // emb_weight_type.bit_width) }}, PrimitiveType::{{ emb_weight_type.primitive_type }}> acc(v{% if emb_weight_type.primitive_type == "INT" %}, shift_scale {% elif emb_weight_type.enum_name == "FP8" %}, exponent_bits, exponent_bias {% endif %});
-              acc.store(&output[output_j][output_d], num_valid_outputs);
+              accumulators[i][j].store(&output[b][D_start + output_d], num_valid_outputs);
             }
+
           }
         } else if constexpr (std::is_same_v<output_t, uint8_t>) {
           // INT8:
           // apply per feature row-wise int8
-          auto thread_local_min = std::numeric_limits<float>::max();
-          auto thread_local_max = std::numeric_limits<float>::lowest();
+          float thread_local_min = std::numeric_limits<float>::max();
+          float thread_local_max = std::numeric_limits<float>::lowest();
           float2 qparams;
           #pragma unroll MaxNum128BRows
           for (uint32_t j = 0; j < MaxNum128BRows; ++j) {
             int32_t output_d = kWarpSize * j * kOutputsPerThread + threadIdx.x * kOutputsPerThread - D_padding;
-            scalar_t v = reinterpret_cast<const scalar_t*>(row)[kWarpSize * j + threadIdx.x];
-            VecNT<{{ (32 // emb_weight_type.bit_width) }}, PrimitiveType::{{ emb_weight_type.primitive_type }}> acc(v{% if emb_weight_type.primitive_type == "INT" %}, shift_scale {% elif emb_weight_type.enum_name == "FP8" %}, exponent_bits, exponent_bias {% endif %});
+            accumulators[i][j].mul(inv_L);
             if (output_d >= 0 && output_d < D) {
-              thread_local_max = max(thread_local_max, float{{ (32 // emb_weight_type.bit_width) }}_max(acc.acc));
-              thread_local_min = min(thread_local_min, float{{ (32 // emb_weight_type.bit_width) }}_min(acc.acc));
+              thread_local_max = max(thread_local_max, float{{ (32 // emb_weight_type.bit_width) }}_max(accumulators[i][j].acc));
+              thread_local_min = min(thread_local_min, float{{ (32 // emb_weight_type.bit_width) }}_min(accumulators[i][j].acc));
             }
           }
+
           qparams = warp_find_qparams(thread_local_min, thread_local_max);
+          const int output_D_start = D_start + t * 8;
+          const int output_D_end = output_D_start + D;
           #pragma unroll MaxNum128BRows
           for (uint32_t j = 0; j < MaxNum128BRows; ++j) {
             const int32_t output_d = kWarpSize * j * kOutputsPerThread + threadIdx.x * kOutputsPerThread - D_padding;
-            scalar_t v = reinterpret_cast<const scalar_t*>(row)[kWarpSize * j + threadIdx.x];
             if (output_d >= 0 && output_d < D) {
               const int num_valid_outputs = min(static_cast<int>(D - output_d), static_cast<int>({{ (32 // emb_weight_type.bit_width) }}));
-              VecNT<{{ (32 // emb_weight_type.bit_width) }}, PrimitiveType::{{ emb_weight_type.primitive_type }}> acc(v{% if emb_weight_type.primitive_type == "INT" %}, shift_scale {% elif emb_weight_type.enum_name == "FP8" %}, exponent_bits, exponent_bias {% endif %});
-              acc.store(&output[output_j][output_d], qparams, num_valid_outputs);
+              accumulators[i][j].store(&output[b][output_D_start + output_d], qparams, num_valid_outputs);
             }
           }
           if (threadIdx.x == 0) {
-            store_qparams_to_row(&output[output_j][D], qparams);
+            store_qparams_to_row(&output[b][output_D_end], qparams);
           }
-        }
-        {% endif %}
-      }
-    }
-  }
-
-  {% if not nobag %}
-  #pragma unroll OutputRowsPerThread
-  for (uint32_t i = 0; i < OutputRowsPerThread; ++i) {
-    const uint32_t b = min(static_cast<uint32_t>(bb * OutputRowsPerThread + i), static_cast<uint32_t>(B - 1));
-    const float inv_L = (mean_pooling && Ls[i] != 0) ? static_cast<float>(1.0) / Ls[i]: static_cast<float>(1.0);
-
-    if constexpr (std::is_same_v<output_t, float> || std::is_same_v<output_t, at::Half> || std::is_same_v<output_t, at::BFloat16>) {
-      #pragma unroll MaxNum128BRows
-      for (uint32_t j = 0; j < MaxNum128BRows; ++j) {
-        const int32_t output_d = kWarpSize * j * kOutputsPerThread + threadIdx.x * kOutputsPerThread - D_padding;
-        accumulators[i][j].mul(inv_L);
-
-        if (output_d >= 0 && output_d < D) {
-          const int num_valid_outputs = min(static_cast<int>(D - output_d), static_cast<int>({{ (32 // emb_weight_type.bit_width) }}));
-          accumulators[i][j].store(&output[b][D_start + output_d], num_valid_outputs);
-        }
-
-      }
-    } else if constexpr (std::is_same_v<output_t, uint8_t>) {
-      // INT8:
-      // apply per feature row-wise int8
-      float thread_local_min = std::numeric_limits<float>::max();
-      float thread_local_max = std::numeric_limits<float>::lowest();
-      float2 qparams;
-      #pragma unroll MaxNum128BRows
-      for (uint32_t j = 0; j < MaxNum128BRows; ++j) {
-        int32_t output_d = kWarpSize * j * kOutputsPerThread + threadIdx.x * kOutputsPerThread - D_padding;
-        accumulators[i][j].mul(inv_L);
-        if (output_d >= 0 && output_d < D) {
-          thread_local_max = max(thread_local_max, float{{ (32 // emb_weight_type.bit_width) }}_max(accumulators[i][j].acc));
-          thread_local_min = min(thread_local_min, float{{ (32 // emb_weight_type.bit_width) }}_min(accumulators[i][j].acc));
-        }
-      }
-
-      qparams = warp_find_qparams(thread_local_min, thread_local_max);
-      const int output_D_start = D_start + t * 8;
-      const int output_D_end = output_D_start + D;
-      #pragma unroll MaxNum128BRows
-      for (uint32_t j = 0; j < MaxNum128BRows; ++j) {
-        const int32_t output_d = kWarpSize * j * kOutputsPerThread + threadIdx.x * kOutputsPerThread - D_padding;
-        if (output_d >= 0 && output_d < D) {
-          const int num_valid_outputs = min(static_cast<int>(D - output_d), static_cast<int>({{ (32 // emb_weight_type.bit_width) }}));
-          accumulators[i][j].store(&output[b][output_D_start + output_d], qparams, num_valid_outputs);
+        } else {
+          // INT4: not implemented yet
         }
       }
-      if (threadIdx.x == 0) {
-        store_qparams_to_row(&output[b][output_D_end], qparams);
-      }
-    } else {
-      // INT4: not implemented yet
-    }
-  }
-  {% endif %}
+      {% endif %}
+    } // for each item of the chunk
+    item_offset += num_chunk_items;
+    // group_ts of the chunk is still in use by the other warps
+    __syncthreads();
+  } // for each chunk of tables
 }
 
 // kWarpsPerBlock is defined in embedding_forward_quantized_split_nbit_host_template.cu
@@ -323,6 +386,7 @@ void {{ emb_weight_type.enum_name }}_split_embedding{{ "_nobag" if nobag else ""
   {{ params.input_rows_in_flight }},
   {{ params.min_128b_rows }},
   {{ params.max_128b_rows }},
+  {{ params.num_stages }},
   {{ device_only }} > (
   const pta::PackedTensorAccessor64<uint8_t, 1, at::RestrictPtrTraits> dev_weights,
   const pta::PackedTensorAccessor64<uint8_t, 1, at::RestrictPtrTraits> uvm_weights,
@@ -7,9 +7,11 @@
  */
 
 // clang-format off
+#include <algorithm>
 #include <map>
 #include <tuple>
 #include <utility>
+#include <vector>
 
 #include <ATen/ATen.h>
 #include <ATen/AccumulateType.h>
@@ -54,6 +56,7 @@ void split_embedding_backward_exact_cpu_kernel(
     int num_tables,
     int B,
     const int* table_to_feature_offset,
+    at::TensorList csc_plan,
     {% if "momentum1_offsets" in args.split_function_arg_names %}
     const at::TensorAccessor<int64_t, 1> momentum1_offsets_data,
     {% endif %}
@@ -68,7 +71,11 @@ void split_embedding_backward_exact_cpu_kernel(
   const bool has_weights = indice_weights.defined();
   auto grad_stride = grad_output.size(1);
 
-  std::vector<::internal::HyperCompressedSparseColumn> cscs(num_tables);
+  // The columns of the tables are sorted here unless the forward pass
+  // already did so in csc_plan
+  std::vector<::internal::HyperCompressedSparseColumn> sorted_cscs(
+      csc_plan.empty() ? num_tables : 0);
+  std::vector<::internal::CompressedSparseColumnView> cscs;
 
   auto get_hash_size = [&hash_size_cumsum_data](int feature_begin) {
     int64_t hash_size;
@@ -84,12 +91,13 @@ void split_embedding_backward_exact_cpu_kernel(
         "with more than 2B rows");
     return hash_size;
   };
+  if (csc_plan.empty()) {
 for (const auto t : c10::irange(num_tables)) {
     int feature_begin = table_to_feature_offset[t];
     int64_t hash_size = get_hash_size(feature_begin);
 
     ::internal::csr2csc(
-        cscs[t],
+        sorted_cscs[t],
         B,
         offsets.accessor<int64_t, 1>(),
         indices.accessor<int64_t, 1>(),
@@ -99,6 +107,10 @@ for (const auto t : c10::irange(num_tables)) {
         pooling_mode,
         table_to_feature_offset + t,
         hash_size);
+    cscs.emplace_back(sorted_cscs[t]);
+  }
+  } else {
+    cscs = ::internal::csc_plan_views(csc_plan, num_tables);
   }
 for (const auto t : c10::irange(num_tables)) {
     int feature_begin = table_to_feature_offset[t];
@@ -225,6 +237,129 @@ for (const auto d : c10::irange(D)) {
   } // for each table
 }
 
+// Rows of the gradient buffer of a thread in the hogwild backward pass
+constexpr int kHogwildGradBufferRows = 256;
+// Slots probed for a row before the buffer is flushed
+constexpr int kHogwildGradBufferProbes = 16;
+
+// Each thread sums the gradients of the rows of its bags in a small hash
+// table, and updates these rows when the table is full and at the end. Rows
+// updated by several threads are updated without synchronization, so the
+// result depends on the order of the updates.
+template <typename scalar_t, typename grad_t>
+void split_embedding_backward_hogwild_cpu_kernel(
+    Tensor grad_output,
+    Tensor host_weights,
+    const at::TensorAccessor<int64_t, 1> weights_offsets_data,
+    const at::TensorAccessor<int, 1> D_offsets_data,
+    Tensor hash_size_cumsum,
+    Tensor indices,
+    Tensor offsets,
+    int64_t pooling_mode,
+    Tensor indice_weights,
+    int num_tables,
+    int B,
+    const int* table_to_feature_offset,
+    {% if "momentum1_offsets" in args.split_function_arg_names %}
+    const at::TensorAccessor<int64_t, 1> momentum1_offsets_data,
+    {% endif %}
+    {% if "momentum2_offsets" in args.split_function_arg_names %}
+    const at::TensorAccessor<int64_t, 1> momentum2_offsets_data,
+    {% endif %}
+    {{ args.split_cpu_kernel_args | join(", ") }}) {
+  using acc_t = at::acc_type<grad_t, true>;
+  const grad_t* grad_output_data = grad_output.data_ptr<grad_t>();
+  auto host_weights_data = host_weights.accessor<scalar_t, 1>();
+  const auto hash_size_cumsum_data = hash_size_cumsum.accessor<int64_t, 1>();
+  const auto indices_data = indices.accessor<int64_t, 1>();
+  const auto offsets_data = offsets.accessor<int64_t, 1>();
+  const bool has_weights = indice_weights.defined();
+  // If indice_weights are not defined, then this accessor won't be used
+  const auto indice_weights_data = has_weights
+      ? indice_weights.accessor<at::acc_type<scalar_t, true>, 1>()
+      : at::TensorAccessor<at::acc_type<scalar_t, true>, 1>(nullptr, nullptr, nullptr);
+  const auto grad_stride = grad_output.size(1);
+
+for (const auto t : c10::irange(num_tables)) {
+    const int feature_begin = table_to_feature_offset[t];
+    const int feature_end = table_to_feature_offset[t + 1];
+    const int64_t hash_size =
+        hash_size_cumsum_data[feature_end] - hash_size_cumsum_data[feature_begin];
+    const auto D =
+        D_offsets_data[feature_begin + 1] - D_offsets_data[feature_begin];
+    const auto table_begin = weights_offsets_data[feature_begin];
+    const int64_t bags_begin = static_cast<int64_t>(feature_begin) * B;
+
+    at::parallel_for(
+        0, static_cast<int64_t>(feature_end - feature_begin) * B, 0,
+        [&](int64_t bag_begin, int64_t bag_end) {
+      std::vector<int64_t> rows(kHogwildGradBufferRows, -1);
+      std::vector<acc_t> grads(kHogwildGradBufferRows * D);
+      const auto flush = [&]() {
+for (const auto slot : c10::irange(kHogwildGradBufferRows)) {
+          const int64_t idx = rows[slot];
+          if (idx == -1) {
+            continue;
+          }
+          const int64_t embedding_begin = table_begin + idx * D;
+          const acc_t* grad_buffer = grads.data() + slot * D;
+          {
+            {{ split_weight_update_cpu }}
+          }
+          rows[slot] = -1;
+        }
+      };
+
+for (const auto bag : c10::irange(bag_begin, bag_end)) {
+        const int b = bag % B;
+        const auto D_offset = D_offsets_data[feature_begin + bag / B];
+        const grad_t* grad_row = grad_output_data + b * grad_stride + D_offset;
+        const auto pool_begin = offsets_data[bags_begin + bag];
+        const auto pool_end = offsets_data[bags_begin + bag + 1];
+        const auto L = pool_end - pool_begin;
+        const acc_t scale_factor =
+            // NOTE: MEAN pooling will not work with indice_weights!
+            (static_cast<PoolingMode>(pooling_mode) == PoolingMode::MEAN && !has_weights && L > 0)
+            ? 1.0 / L
+            : 1.0;
+for (const auto p : c10::irange(pool_begin, pool_end)) {
+          const int64_t idx = indices_data[p];
+          TORCH_CHECK(
+              idx >= 0 && idx < hash_size,
+              "Index ", idx, " of table ", t, " is out of bounds [0, ",
+              hash_size, ")");
+          const acc_t weight =
+              has_weights ? scale_factor * indice_weights_data[p] : scale_factor;
+
+          const int hash = static_cast<int>(
+              (static_cast<uint64_t>(idx) * 0x9E3779B97F4A7C15ULL) >> 56);
+          int slot = -1;
+for (const auto probe : c10::irange(kHogwildGradBufferProbes)) {
+            const int s = (hash + probe) & (kHogwildGradBufferRows - 1);
+            if (rows[s] == idx || rows[s] == -1) {
+              slot = s;
+              break;
+            }
+          }
+          if (slot == -1) {
+            flush();
+            slot = hash;
+          }
+          acc_t* grad_buffer = grads.data() + slot * D;
+          if (rows[slot] == -1) {
+            rows[slot] = idx;
+            std::fill_n(grad_buffer, D, acc_t(0));
+          }
+for (const auto d : c10::irange(D)) {
+            grad_buffer[d] += grad_row[d] * weight;
+          }
+        }
+      }
+      flush();
+    }); // parallel_for
+  } // for each table
+}
+
 template <typename scalar_t>
 void split_embedding_backward_exact_cpu_dense_kernel(
     Tensor grad,
@@ -285,7 +420,12 @@ for (const auto d : c10::irange(D)) {
 } // namespace
 
 // The template for exact optimizers
-{{ "void" if not dense else "Tensor" }}  split_embedding_backward_codegen_{{ optimizer }}_cpu(
+{% if not dense %}
+namespace {
+void split_embedding_backward_codegen_{{ optimizer }}_cpu_impl(
+{% else %}
+Tensor split_embedding_backward_codegen_{{ optimizer }}_cpu(
+{% endif %}
     Tensor grad_output,
     Tensor host_weights,
     {% if not dense %}
@@ -303,7 +443,9 @@ for (const auto d : c10::irange(D)) {
     {% if not dense %}
     bool stochastic_rounding,
     {{ args.split_function_args | join(", ") }},
-    int64_t output_dtype = static_cast<int64_t>(SparseType::FP32)
+    int64_t output_dtype,
+    at::TensorList csc_plan,
+    bool hogwild
     {% else %}
     {{ args.split_function_args | join(", ") }}
     {% endif %}
@@ -351,6 +493,29 @@ for (const auto d : c10::irange(D)) {
         using grad_t = scalar_t;
       FBGEMM_DISPATCH_FLOAT_AND_HALF(
           host_weights.scalar_type(), "split_embedding_backward_exact_cpu", [&] {
+            if (hogwild) {
+              split_embedding_backward_hogwild_cpu_kernel<scalar_t, grad_t>(
+                  grad_output,
+                  host_weights,
+                  weights_offsets_data,
+                  D_offsets_data,
+                  hash_size_cumsum,
+                  indices,
+                  offsets,
+                  pooling_mode,
+                  indice_weights,
+                  num_tables,
+                  B,
+                  table_to_feature_offset,
+                  {% if "momentum1_offsets" in args.split_function_arg_names %}
+                  momentum1_offsets_data,
+                  {% endif %}
+                  {% if "momentum2_offsets" in args.split_function_arg_names %}
+                  momentum2_offsets_data,
+                  {% endif %}
+                  {{ args.split_cpu_kernel_arg_constructors | join(", ") }});
+              return;
+            }
             split_embedding_backward_exact_cpu_kernel<scalar_t, grad_t>(
                 grad_output,
                 host_weights,
@@ -364,6 +529,7 @@ for (const auto d : c10::irange(D)) {
                 num_tables,
                 B,
                 table_to_feature_offset,
+                csc_plan,
                 {% if "momentum1_offsets" in args.split_function_arg_names %}
                 momentum1_offsets_data,
                 {% endif %}
@@ -401,6 +567,122 @@ for (const auto d : c10::irange(D)) {
   {% endif %}
 }
 
+{% if not dense %}
+} // namespace
+
+void split_embedding_backward_codegen_{{ optimizer }}_cpu(
+    Tensor grad_output,
+    Tensor host_weights,
+    Tensor weights_placements,
+    Tensor weights_offsets,
+    Tensor D_offsets,
+    int64_t max_D,
+    Tensor hash_size_cumsum,
+    int64_t total_hash_size_bits,
+    Tensor indices,
+    Tensor offsets,
+    int64_t pooling_mode,
+    Tensor indice_weights,
+    bool stochastic_rounding,
+    {{ args.split_function_args | join(", ") }},
+    int64_t output_dtype = static_cast<int64_t>(SparseType::FP32)
+) {
+  split_embedding_backward_codegen_{{ optimizer }}_cpu_impl(
+      grad_output,
+      host_weights,
+      weights_placements,
+      weights_offsets,
+      D_offsets,
+      max_D,
+      hash_size_cumsum,
+      total_hash_size_bits,
+      indices,
+      offsets,
+      pooling_mode,
+      indice_weights,
+      stochastic_rounding,
+      {{ args.split_function_arg_names | join(", ") }},
+      output_dtype,
+      /*csc_plan=*/{},
+      /*hogwild=*/false);
+}
+
+void split_embedding_backward_codegen_{{ optimizer }}_with_csc_plan_cpu(
+    Tensor grad_output,
+    Tensor host_weights,
+    Tensor weights_placements,
+    Tensor weights_offsets,
+    Tensor D_offsets,
+    int64_t max_D,
+    Tensor hash_size_cumsum,
+    int64_t total_hash_size_bits,
+    Tensor indices,
+    Tensor offsets,
+    int64_t pooling_mode,
+    Tensor indice_weights,
+    bool stochastic_rounding,
+    {{ args.split_function_args | join(", ") }},
+    int64_t output_dtype,
+    at::TensorList csc_plan
+) {
+  split_embedding_backward_codegen_{{ optimizer }}_cpu_impl(
+      grad_output,
+      host_weights,
+      weights_placements,
+      weights_offsets,
+      D_offsets,
+      max_D,
+      hash_size_cumsum,
+      total_hash_size_bits,
+      indices,
+      offsets,
+      pooling_mode,
+      indice_weights,
+      stochastic_rounding,
+      {{ args.split_function_arg_names | join(", ") }},
+      output_dtype,
+      csc_plan,
+      /*hogwild=*/false);
+}
+
+void split_embedding_backward_codegen_{{ optimizer }}_hogwild_cpu(
+    Tensor grad_output,
+    Tensor host_weights,
+    Tensor weights_placements,
+    Tensor weights_offsets,
+    Tensor D_offsets,
+    int64_t max_D,
+    Tensor hash_size_cumsum,
+    int64_t total_hash_size_bits,
+    Tensor indices,
+    Tensor offsets,
+    int64_t pooling_mode,
+    Tensor indice_weights,
+    bool stochastic_rounding,
+    {{ args.split_function_args | join(", ") }},
+    int64_t output_dtype = static_cast<int64_t>(SparseType::FP32)
+) {
+  split_embedding_backward_codegen_{{ optimizer }}_cpu_impl(
+      grad_output,
+      host_weights,
+      weights_placements,
+      weights_offsets,
+      D_offsets,
+      max_D,
+      hash_size_cumsum,
+      total_hash_size_bits,
+      indices,
+      offsets,
+      pooling_mode,
+      indice_weights,
+      stochastic_rounding,
+      {{ args.split_function_arg_names | join(", ") }},
+      output_dtype,
+      /*csc_plan=*/{},
+      /*hogwild=*/true);
+}
+{% endif %}
+
 TORCH_LIBRARY_FRAGMENT(fbgemm, m) {
   {% if not dense %}
   m.def("split_embedding_backward_codegen_{{ optimizer }}_cpu(Tensor grad_output, Tensor(a!) host_weights, Tensor weights_placements, Tensor weights_offsets, Tensor D_offsets, int max_D, Tensor hash_size_cumsum, int total_hash_size_bits, Tensor indices, Tensor offsets,int pooling_mode, Tensor indice_weights, bool stochastic_rounding, {{ (args.split_function_args | join(", ")).replace("double", "float").replace("int64_t", "int").replace("Tensor momentum1_host", "Tensor(b!) momentum1_host")}}, int output_dtype = 0) -> ()");
@@ -408,6 +690,12 @@ TORCH_LIBRARY_FRAGMENT(fbgemm, m) {
   m.def("split_embedding_backward_codegen_{{ optimizer }}_cpu(Tensor grad_output, Tensor(a!) host_weights, Tensor weights_offsets, Tensor D_offsets, int max_D, Tensor hash_size_cumsum, int total_hash_size_bits, Tensor indices, Tensor offsets,int pooling_mode, Tensor indice_weights, {{ (args.split_function_args | join(", ")).replace("double", "float").replace("int64_t", "int").replace("Tensor momentum1_host", "Tensor(b!) momentum1_host")}}) -> Tensor");
   {% endif %}
   DISPATCH_TO_CPU("split_embedding_backward_codegen_{{ optimizer }}_cpu", split_embedding_backward_codegen_{{ optimizer }}_cpu);
+  {% if not dense %}
+  m.def("split_embedding_backward_codegen_{{ optimizer }}_with_csc_plan_cpu(Tensor grad_output, Tensor(a!) host_weights, Tensor weights_placements, Tensor weights_offsets, Tensor D_offsets, int max_D, Tensor hash_size_cumsum, int total_hash_size_bits, Tensor indices, Tensor offsets,int pooling_mode, Tensor indice_weights, bool stochastic_rounding, {{ (args.split_function_args | join(", ")).replace("double", "float").replace("int64_t", "int").replace("Tensor momentum1_host", "Tensor(b!) momentum1_host")}}, int output_dtype, Tensor[] csc_plan) -> ()");
+  DISPATCH_TO_CPU("split_embedding_backward_codegen_{{ optimizer }}_with_csc_plan_cpu", split_embedding_backward_codegen_{{ optimizer }}_with_csc_plan_cpu);
+  m.def("split_embedding_backward_codegen_{{ optimizer }}_hogwild_cpu(Tensor grad_output, Tensor(a!) host_weights, Tensor weights_placements, Tensor weights_offsets, Tensor D_offsets, int max_D, Tensor hash_size_cumsum, int total_hash_size_bits, Tensor indices, Tensor offsets,int pooling_mode, Tensor indice_weights, bool stochastic_rounding, {{ (args.split_function_args | join(", ")).replace("double", "float").replace("int64_t", "int").replace("Tensor momentum1_host", "Tensor(b!) momentum1_host")}}, int output_dtype = 0) -> ()");
+  DISPATCH_TO_CPU("split_embedding_backward_codegen_{{ optimizer }}_hogwild_cpu", split_embedding_backward_codegen_{{ optimizer }}_hogwild_cpu);
+  {% endif %}
 }
 
 // clang-format on
@@ -22,12 +22,17 @@ namespace embedding_ops {
 {% endif %}
 
 
+template <typename info_pta_t, typename info_t, bool nobag>
 __global__ __launch_bounds__(kMaxThreads) void
 split_embedding_backward_codegen_find_long_segments(
     const pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits>
         sorted_linear_indices_num_runs,
     const pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits>
         sorted_linear_indices_run_lengths,
+    const pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits>
+        sorted_linear_indices_cumulative_run_lengths,
+    const pta::PackedTensorAccessor32<info_pta_t, 1, at::RestrictPtrTraits>
+        sorted_infos,
     pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits>
         long_run_ids,
     pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits>
@@ -38,15 +43,22 @@ split_embedding_backward_codegen_find_long_segments(
         num_really_long_run_ids,
     pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits>
         grad_accum_counter,
-    const int32_t max_segment_length_per_warp,
+    const pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits>
+        max_segment_length_per_warp,
     const int32_t max_segment_length_per_cta,
-    const bool use_deterministic_algorithms) {
+    const bool use_deterministic_algorithms,
+    const int32_t info_B_num_bits) {
   const int32_t num_runs = sorted_linear_indices_num_runs[0];
+  const auto T = max_segment_length_per_warp.size(0);
   for (auto run_id = blockIdx.x * blockDim.x + threadIdx.x; run_id < num_runs; run_id += blockDim.x * gridDim.x) {
-    if (sorted_linear_indices_run_lengths[run_id] >= max_segment_length_per_warp) {
+    // The threshold is per feature, which must match the warp per row kernel
+    const auto segment_start = sorted_linear_indices_cumulative_run_lengths[run_id];
+    const auto info = reinterpret_cast<const info_t*>(&sorted_infos[0])[segment_start];
+    const auto t = nobag ? (info % T) : (info >> info_B_num_bits);
+    if (sorted_linear_indices_run_lengths[run_id] >= max_segment_length_per_warp[t]) {
         // A segment with length > max_segment_length_per_cta is handled by more than 1 thread block.
         const int num_ctas_for_run =
-            use_deterministic_algorithms ? 1 : div_round_up(sorted_linear_indices_run_lengths[run_id], max_segment_length_per_cta);
+            div_round_up(sorted_linear_indices_run_lengths[run_id], max_segment_length_per_cta);
         const auto long_run_idx = gpuAtomicAdd(&num_long_run_ids[0], num_ctas_for_run);
         // The first thread block in the really long run gets run_id in long_run_ids
         // and the rest get the negative of its offset.
@@ -54,7 +66,16 @@ split_embedding_backward_codegen_find_long_segments(
         for (int i = 1; i < num_ctas_for_run; ++i) {
             long_run_ids[long_run_idx + i] = -i;
         }
-        if (num_ctas_for_run > 1) {
+        if (num_ctas_for_run > 1 && use_deterministic_algorithms) {
+            // Give every thread block its own partial sum slot so that the
+            // slots can be reduced in a fixed order. The counter of the run is
+            // kept at its first slot.
+            const auto first_partial_idx = gpuAtomicAdd(&num_really_long_run_ids[0], num_ctas_for_run);
+            grad_accum_counter[first_partial_idx] = num_ctas_for_run;
+            for (int i = 0; i < num_ctas_for_run; ++i) {
+                long_run_id_to_really_long_run_ids[long_run_idx + i] = first_partial_idx + i;
+            }
+        } else if (num_ctas_for_run > 1) {
             const auto really_long_run_idx = gpuAtomicAdd(&num_really_long_run_ids[0], 1);
             grad_accum_counter[really_long_run_idx] = num_ctas_for_run;
             for (int i = 0; i < num_ctas_for_run; ++i) {
@@ -117,6 +138,38 @@ void split_embedding_backward_count_unique_indices_kernel(
 
 {% for nobag in [True, False] %}
 {% set info_pta_t = "int64_t" if nobag else "int32_t" %}
+template __global__ __launch_bounds__(kMaxThreads) void
+split_embedding_backward_codegen_find_long_segments
+<
+  {{ info_pta_t }},
+  {{ "int64_t" if nobag else "uint32_t" }},
+  {{ "true" if nobag else "false" }}
+> (
+    const pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits>
+        sorted_linear_indices_num_runs,
+    const pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits>
+        sorted_linear_indices_run_lengths,
+    const pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits>
+        sorted_linear_indices_cumulative_run_lengths,
+    const pta::PackedTensorAccessor32<{{ info_pta_t }}, 1, at::RestrictPtrTraits>
+        sorted_infos,
+    pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits>
+        long_run_ids,
+    pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits>
+        num_long_run_ids,
+    pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits>
+        long_run_id_to_really_long_run_ids,
+    pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits>
+        num_really_long_run_ids,
+    pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits>
+        grad_accum_counter,
+    const pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits>
+        max_segment_length_per_warp,
+    const int32_t max_segment_length_per_cta,
+    const bool use_deterministic_algorithms,
+    const int32_t info_B_num_bits
+);
+
 template __global__ __launch_bounds__(kMaxThreads)
 void split_embedding_backward_count_unique_indices_kernel
 <
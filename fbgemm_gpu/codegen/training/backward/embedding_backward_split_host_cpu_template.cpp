@@ -37,6 +37,43 @@ void split_embedding_backward_codegen_{{ optimizer }}_cpu(
     bool stochastic_rounding,
     {{ args.split_function_args | join(", ") }},
     int64_t output_dtype = static_cast<int64_t>(SparseType::FP32));
+
+{% if "approx" not in optimizer %}
+void split_embedding_backward_codegen_{{ optimizer }}_with_csc_plan_cpu(
+    Tensor grad_output,
+    Tensor host_weights,
+    Tensor weights_placements,
+    Tensor weights_offsets,
+    Tensor D_offsets,
+    int64_t max_D,
+    Tensor hash_size_cumsum,
+    int64_t total_hash_size_bits,
+    Tensor indices,
+    Tensor offsets,
+    int64_t pooling_mode,
+    Tensor indice_weights,
+    bool stochastic_rounding,
+    {{ args.split_function_args | join(", ") }},
+    int64_t output_dtype,
+    at::TensorList csc_plan);
+
+void split_embedding_backward_codegen_{{ optimizer }}_hogwild_cpu(
+    Tensor grad_output,
+    Tensor host_weights,
+    Tensor weights_placements,
+    Tensor weights_offsets,
+    Tensor D_offsets,
+    int64_t max_D,
+    Tensor hash_size_cumsum,
+    int64_t total_hash_size_bits,
+    Tensor indices,
+    Tensor offsets,
+    int64_t pooling_mode,
+    Tensor indice_weights,
+    bool stochastic_rounding,
+    {{ args.split_function_args | join(", ") }},
+    int64_t output_dtype = static_cast<int64_t>(SparseType::FP32));
+{% endif %}
 {% endif %}
 
 namespace {
@@ -63,13 +100,47 @@ class SplitLookupFunction_{{ optimizer }}_Op : public torch::autograd::Function<
     double max_gradient,
     bool stochastic_rounding,
     {{ args.split_function_args | join(", ") }},
-    int64_t output_dtype = static_cast<int64_t>(SparseType::FP32)) {
+    int64_t output_dtype = static_cast<int64_t>(SparseType::FP32),
+    bool cache_csc_plan = false,
+    bool hogwild_backward = false,
+    c10::optional<Tensor> B_offsets = c10::nullopt,
+    c10::optional<Tensor> vbe_output_offsets_feature_rank = c10::nullopt,
+    c10::optional<Tensor> vbe_B_offsets_rank_per_feature = c10::nullopt,
+    c10::SymInt max_B = -1,
+    c10::SymInt vbe_output_size = -1) {
+    TORCH_CHECK(
+        !cache_csc_plan || !hogwild_backward,
+        "The hogwild backward pass does not sort the indices, "
+        "cache_csc_plan must be false");
     Tensor indice_weights_value = indice_weights.value_or(Tensor());
     Tensor feature_requires_grad_value =
         feature_requires_grad.value_or(Tensor());
+
+    // With variable batch sizes (VBE), the backward pass runs on the bags
+    // padded to max_B per feature, the padded bags being empty
+    const bool vbe = B_offsets.has_value();
+    std::vector<Tensor> vbe_metadata;
+    Tensor bwd_offsets = offsets;
+    if (vbe) {
+      TORCH_CHECK(
+          vbe_output_offsets_feature_rank.has_value() &&
+              vbe_B_offsets_rank_per_feature.has_value(),
+          "The VBE metadata must all be defined");
+      vbe_metadata = {
+          *B_offsets,
+          *vbe_output_offsets_feature_rank,
+          *vbe_B_offsets_rank_per_feature};
+      static auto padded_offsets_op =
+          torch::Dispatcher::singleton()
+              .findSchemaOrThrow("fbgemm::split_embedding_vbe_padded_offsets_cpu", "")
+              .typed<decltype(split_embedding_vbe_padded_offsets_cpu)>();
+      bwd_offsets = padded_offsets_op.call(
+          offsets, *B_offsets, max_B.guard_int(__FILE__, __LINE__));
+    }
+
     ctx->save_for_backward({
         host_weights, weights_placements, weights_offsets, D_offsets, hash_size_cumsum,
-        indices, offsets, indice_weights_value, feature_requires_grad_value, {{ args.split_saved_tensors | join(", ") }} });
+        indices, bwd_offsets, indice_weights_value, feature_requires_grad_value, {{ args.split_saved_tensors | join(", ") }} });
 
     ctx->saved_data["total_D"] = total_D;
     ctx->saved_data["max_D"] = max_D;
@@ -83,6 +154,50 @@ class SplitLookupFunction_{{ optimizer }}_Op : public torch::autograd::Function<
     {% for (var, _) in args.saved_data %}
     ctx->saved_data["{{ var }}"] = {{ var }};
     {% endfor %}
+
+    // Sort the indices for the backward pass and the optimizer update now,
+    // the approximate optimizers do not sort them
+    std::vector<Tensor> csc_plan;
+    {% if "approx" not in optimizer %}
+    if (cache_csc_plan) {
+      static auto plan_op =
+          torch::Dispatcher::singleton()
+              .findSchemaOrThrow("fbgemm::split_embedding_backward_csc_plan_cpu", "")
+              .typed<decltype(split_embedding_backward_csc_plan_cpu)>();
+      csc_plan = plan_op.call(
+          hash_size_cumsum,
+          indices,
+          bwd_offsets,
+          pooling_mode,
+          indice_weights_value);
+    }
+    {% endif %}
+    ctx->saved_data["csc_plan"] = csc_plan;
+    ctx->saved_data["hogwild_backward"] = hogwild_backward;
+    ctx->saved_data["vbe_metadata"] = vbe_metadata;
+    ctx->saved_data["max_B"] = max_B;
+
+    if (vbe) {
+      static auto vbe_op =
+          torch::Dispatcher::singleton()
+              .findSchemaOrThrow("fbgemm::split_embedding_codegen_forward_vbe_cpu", "")
+              .typed<decltype(split_embedding_codegen_forward_vbe_cpu)>();
+      return {vbe_op.call(
+          host_weights,
+          weights_offsets,
+          D_offsets,
+          hash_size_cumsum,
+          indices,
+          offsets,
+          pooling_mode,
+          indice_weights_value,
+          *B_offsets,
+          *vbe_output_offsets_feature_rank,
+          *vbe_B_offsets_rank_per_feature,
+          vbe_output_size.guard_int(__FILE__, __LINE__),
+          output_dtype)};
+    }
+
     static auto op =
         torch::Dispatcher::singleton()
             .findSchemaOrThrow("fbgemm::split_embedding_codegen_forward_cpu", "")
@@ -139,23 +254,89 @@ class SplitLookupFunction_{{ optimizer }}_Op : public torch::autograd::Function<
         torch::Dispatcher::singleton()
             .findSchemaOrThrow("fbgemm::split_embedding_backward_codegen_{{ optimizer }}_cpu", "")
             .typed<decltype(split_embedding_backward_codegen_{{ optimizer }}_cpu)>();
-    auto grad_output = gradient_clipping ? clamp(grad_outputs[0], -max_gradient, max_gradient) : grad_outputs[0];
-    op1.call(
-        grad_output,
-        host_weights,
-        weights_placements,
-        weights_offsets,
-        D_offsets,
-        max_D,
-        hash_size_cumsum,
-        total_hash_size_bits,
-        indices,
-        offsets,
-        pooling_mode,
-        indice_weights,
-        stochastic_rounding,
-        {{ args.split_function_arg_names | join(", ") }},
-        output_dtype);
+    // The VBE gradient is padded like the offsets saved by the forward pass
+    Tensor grad_output_value = grad_outputs[0];
+    const auto vbe_metadata = ctx->saved_data["vbe_metadata"].toTensorVector();
+    if (!vbe_metadata.empty()) {
+      static auto padded_grad_op =
+          torch::Dispatcher::singleton()
+              .findSchemaOrThrow("fbgemm::split_embedding_vbe_padded_grad_cpu", "")
+              .typed<decltype(split_embedding_vbe_padded_grad_cpu)>();
+      grad_output_value = padded_grad_op.call(
+          grad_output_value,
+          D_offsets,
+          total_D.guard_int(__FILE__, __LINE__),
+          vbe_metadata[0],
+          vbe_metadata[1],
+          vbe_metadata[2],
+          ctx->saved_data["max_B"].toSymInt().guard_int(__FILE__, __LINE__));
+    }
+    auto grad_output = gradient_clipping ? clamp(grad_output_value, -max_gradient, max_gradient) : grad_output_value;
+    {% if "approx" not in optimizer %}
+    const auto csc_plan = ctx->saved_data["csc_plan"].toTensorVector();
+    if (ctx->saved_data["hogwild_backward"].toBool()) {
+      static auto op1_hogwild =
+          torch::Dispatcher::singleton()
+              .findSchemaOrThrow("fbgemm::split_embedding_backward_codegen_{{ optimizer }}_hogwild_cpu", "")
+              .typed<decltype(split_embedding_backward_codegen_{{ optimizer }}_hogwild_cpu)>();
+      op1_hogwild.call(
+          grad_output,
+          host_weights,
+          weights_placements,
+          weights_offsets,
+          D_offsets,
+          max_D,
+          hash_size_cumsum,
+          total_hash_size_bits,
+          indices,
+          offsets,
+          pooling_mode,
+          indice_weights,
+          stochastic_rounding,
+          {{ args.split_function_arg_names | join(", ") }},
+          output_dtype);
+    } else if (!csc_plan.empty()) {
+      static auto op1_with_csc_plan =
+          torch::Dispatcher::singleton()
+              .findSchemaOrThrow("fbgemm::split_embedding_backward_codegen_{{ optimizer }}_with_csc_plan_cpu", "")
+              .typed<decltype(split_embedding_backward_codegen_{{ optimizer }}_with_csc_plan_cpu)>();
+      op1_with_csc_plan.call(
+          grad_output,
+          host_weights,
+          weights_placements,
+          weights_offsets,
+          D_offsets,
+          max_D,
+          hash_size_cumsum,
+          total_hash_size_bits,
+          indices,
+          offsets,
+          pooling_mode,
+          indice_weights,
+          stochastic_rounding,
+          {{ args.split_function_arg_names | join(", ") }},
+          output_dtype,
+          csc_plan);
+    } else
+    {% endif %}
+    {
+      op1.call(
+          grad_output,
+          host_weights,
+          weights_placements,
+          weights_offsets,
+          D_offsets,
+          max_D,
+          hash_size_cumsum,
+          total_hash_size_bits,
+          indices,
+          offsets,
+          pooling_mode,
+          indice_weights,
+          stochastic_rounding,
+          {{ args.split_function_arg_names | join(", ") }},
+          output_dtype);
+    }
     static auto op2 =
         torch::Dispatcher::singleton()
             .findSchemaOrThrow("fbgemm::split_embedding_codegen_grad_indice_weights_cpu", "")
@@ -163,7 +344,7 @@ class SplitLookupFunction_{{ optimizer }}_Op : public torch::autograd::Function<
     // NOTE: MEAN pooling will not work with indice_weights!
     auto grad_indice_weights = indice_weights.defined()
         ? op2.call(
-              grad_outputs[0],
+              grad_output_value,
               host_weights,
               weights_offsets,
               D_offsets,
@@ -190,6 +371,13 @@ class SplitLookupFunction_{{ optimizer }}_Op : public torch::autograd::Function<
         Variable(), // stochastic_rounding
         {{ args.split_variables | join(", ") }},
         Variable(), // output_dtype
+        Variable(), // cache_csc_plan
+        Variable(), // hogwild_backward
+        Variable(), // B_offsets
+        Variable(), // vbe_output_offsets_feature_rank
+        Variable(), // vbe_B_offsets_rank_per_feature
+        Variable(), // max_B
+        Variable(), // vbe_output_size
     };
   }
 };
@@ -214,7 +402,14 @@ Tensor split_embedding_codegen_lookup_{{ optimizer }}_function_cpu(
     double max_gradient,
     bool stochastic_rounding,
     {{ args.split_function_args | join(", ") }},
-    int64_t output_dtype = static_cast<int64_t>(SparseType::FP32)) {
+    int64_t output_dtype = static_cast<int64_t>(SparseType::FP32),
+    bool cache_csc_plan = false,
+    bool hogwild_backward = false,
+    c10::optional<Tensor> B_offsets = c10::nullopt,
+    c10::optional<Tensor> vbe_output_offsets_feature_rank = c10::nullopt,
+    c10::optional<Tensor> vbe_B_offsets_rank_per_feature = c10::nullopt,
+    c10::SymInt max_B = -1,
+    c10::SymInt vbe_output_size = -1) {
   {% if has_cpu_support %}
   return SplitLookupFunction_{{ optimizer }}_Op::apply(
       host_weights,
@@ -234,7 +429,14 @@ Tensor split_embedding_codegen_lookup_{{ optimizer }}_function_cpu(
       max_gradient,
       stochastic_rounding,
       {{ args.split_function_arg_names | join(", ") }},
-      output_dtype)[0];
+      output_dtype,
+      cache_csc_plan,
+      hogwild_backward,
+      B_offsets,
+      vbe_output_offsets_feature_rank,
+      vbe_B_offsets_rank_per_feature,
+      max_B,
+      vbe_output_size)[0];
   {% else %}
   TORCH_CHECK(false, "split_embedding_codegen_lookup_{{ optimizer }}_function_cpu is deprecated. Please see https://github.com/pytorch/FBGEMM/discussions/1727 for more detail.");
   return Tensor();
@@ -243,7 +445,7 @@ Tensor split_embedding_codegen_lookup_{{ optimizer }}_function_cpu(
 
 // Deprecated for fb namespace! Please use fbgemm namespace instead!
 TORCH_LIBRARY_FRAGMENT(fb, m) {
-    m.def("split_embedding_codegen_lookup_{{ optimizer }}_function_cpu(Tensor(a!) host_weights, Tensor weights_placements, Tensor weights_offsets, Tensor D_offsets, SymInt total_D, SymInt max_D, Tensor hash_size_cumsum, int total_hash_size_bits, Tensor indices, Tensor offsets, int pooling_mode, Tensor? indice_weights, Tensor? feature_requires_grad, bool gradient_clipping, float max_gradient, bool stochastic_rounding, {{ args.split_function_schemas | join(", ") }}, int output_dtype=0) -> Tensor");
+    m.def("split_embedding_codegen_lookup_{{ optimizer }}_function_cpu(Tensor(a!) host_weights, Tensor weights_placements, Tensor weights_offsets, Tensor D_offsets, SymInt total_D, SymInt max_D, Tensor hash_size_cumsum, int total_hash_size_bits, Tensor indices, Tensor offsets, int pooling_mode, Tensor? indice_weights, Tensor? feature_requires_grad, bool gradient_clipping, float max_gradient, bool stochastic_rounding, {{ args.split_function_schemas | join(", ") }}, int output_dtype=0, bool cache_csc_plan=False, bool hogwild_backward=False, Tensor? B_offsets=None, Tensor? vbe_output_offsets_feature_rank=None, Tensor? vbe_B_offsets_rank_per_feature=None, SymInt max_B=-1, SymInt vbe_output_size=-1) -> Tensor");
     m.impl(
       "split_embedding_codegen_lookup_{{ optimizer }}_function_cpu",
       torch::dispatch(
@@ -252,7 +454,7 @@ TORCH_LIBRARY_FRAGMENT(fb, m) {
 }
 
 TORCH_LIBRARY_FRAGMENT(fbgemm, m) {
-    m.def("split_embedding_codegen_lookup_{{ optimizer }}_function_cpu(Tensor(a!) host_weights, Tensor weights_placements, Tensor weights_offsets, Tensor D_offsets, SymInt total_D, SymInt max_D, Tensor hash_size_cumsum, int total_hash_size_bits, Tensor indices, Tensor offsets, int pooling_mode, Tensor? indice_weights, Tensor? feature_requires_grad, bool gradient_clipping, float max_gradient, bool stochastic_rounding, {{ args.split_function_schemas | join(", ") }}, int output_dtype=0) -> Tensor");
+    m.def("split_embedding_codegen_lookup_{{ optimizer }}_function_cpu(Tensor(a!) host_weights, Tensor weights_placements, Tensor weights_offsets, Tensor D_offsets, SymInt total_D, SymInt max_D, Tensor hash_size_cumsum, int total_hash_size_bits, Tensor indices, Tensor offsets, int pooling_mode, Tensor? indice_weights, Tensor? feature_requires_grad, bool gradient_clipping, float max_gradient, bool stochastic_rounding, {{ args.split_function_schemas | join(", ") }}, int output_dtype=0, bool cache_csc_plan=False, bool hogwild_backward=False, Tensor? B_offsets=None, Tensor? vbe_output_offsets_feature_rank=None, Tensor? vbe_B_offsets_rank_per_feature=None, SymInt max_B=-1, SymInt vbe_output_size=-1) -> Tensor");
     m.impl(
       "split_embedding_codegen_lookup_{{ optimizer }}_function_cpu",
       torch::dispatch(
@@ -193,7 +193,7 @@ split_embedding{{ ndesc }}_backward_codegen_{{ optimizer }}_{{ wdesc }}{{ vdesc
         // This computation must agree with how we compute num_ctas_for_run in
         // find_long_segments kernel!
         const int32_t num_ctas_on_current_run =
-            use_deterministic_algorithms ? 1 : div_round_up(run_length, max_segment_length_per_cta);
+            div_round_up(run_length, max_segment_length_per_cta);
 
 
         const int64_t linear_index = sorted_linear_indices_run[current_run_id];
@@ -201,7 +201,7 @@ split_embedding{{ ndesc }}_backward_codegen_{{ optimizer }}_{{ wdesc }}{{ vdesc
             sorted_linear_indices_cumulative_run_lengths[current_run_id] +
             cta_rank_on_current_run * max_segment_length_per_cta;
         const int32_t segment_end = std::min(
-            use_deterministic_algorithms ? INT_MAX : segment_start + max_segment_length_per_cta,
+            segment_start + max_segment_length_per_cta,
             sorted_linear_indices_cumulative_run_lengths[current_run_id + 1]);
         const int32_t SL = segment_end - segment_start;
 
@@ -303,7 +303,53 @@ split_embedding{{ ndesc }}_backward_codegen_{{ optimizer }}_{{ wdesc }}{{ vdesc
             continue;
         }
 
-        if (num_ctas_on_current_run > 1) {
+        if (num_ctas_on_current_run > 1 && use_deterministic_algorithms) {
+            // Each thread block of the run stores its partial sum in its own
+            // row of temp_grad_accum, and the counter of the run lives at the
+            // row of the first thread block (see find_long_segments kernel).
+            const int32_t partial_id = long_run_id_to_really_long_run_ids[long_run_id];
+            const int32_t first_partial_id = partial_id - cta_rank_on_current_run;
+            Vec4TAcc<cache_t> *partial_ptr =
+                reinterpret_cast<Vec4TAcc<cache_t>*>(&temp_grad_accum[partial_id][0]);
+            {{
+                generate_optimized_grad_sum_loop_access(
+                    """
+                    partial_ptr[d_vec] = {grad_vec};
+                    """
+                )
+            }}
+
+            int counter;
+            __threadfence();
+            if (threadIdx.x == 0) {
+                counter = gpuAtomicAdd(&grad_accum_counter[first_partial_id], -1);
+            }
+            counter = SHFL_SYNC(counter, 0);
+            // Only the thread block that finished last reduces the partial sums.
+            if (counter > 1) {
+                continue;
+            }
+            CUDA_KERNEL_ASSERT(counter == 1 && "Invalid grad_accum_counter. Race condition?");
+            // Pairwise tree reduction in the order of the thread block ranks,
+            // so the sum does not depend on the order the blocks finished in.
+            {{
+                generate_optimized_grad_sum_loop_access(
+                    """
+                    for (int32_t stride = 1; stride < num_ctas_on_current_run; stride *= 2) {
+                        for (int32_t i = 0; i + stride < num_ctas_on_current_run; i += 2 * stride) {
+                            auto* lhs = reinterpret_cast<Vec4TAcc<cache_t>*>(
+                                &temp_grad_accum[first_partial_id + i][0]);
+                            const auto* rhs = reinterpret_cast<const Vec4TAcc<cache_t>*>(
+                                &temp_grad_accum[first_partial_id + i + stride][0]);
+                            lhs[d_vec] = vec4_acc(lhs[d_vec], rhs[d_vec]);
+                        }
+                    }
+                    {grad_vec} = reinterpret_cast<const Vec4TAcc<cache_t>*>(
+                        &temp_grad_accum[first_partial_id][0])[d_vec];
+                    """
+                )
+            }}
+        } else if (num_ctas_on_current_run > 1) {
             int really_long_run_id = long_run_id_to_really_long_run_ids[long_run_id];
             Vec4TAcc<cache_t> *temp_grad_accum_ptr =
                 reinterpret_cast<Vec4TAcc<cache_t>*>(&temp_grad_accum[really_long_run_id][0]);
@@ -173,7 +173,7 @@ split_embedding{{ ndesc }}_backward_codegen_{{ optimizer }}_{{ wdesc }}{{ vdesc
     const pta::PackedTensorAccessor32<at::acc_type<cache_t, true>, 1, at::RestrictPtrTraits> sorted_indice_weights,
     {%- endif %}
     const pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits> sorted_linear_indices_num_runs,
-    int32_t max_segment_length_per_warp,
+    const pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits> max_segment_length_per_warp,
     {%- if not dense and optimizer != "none" %}
     bool stochastic_rounding,
     at::PhiloxCudaState stochastic_rounding_philox_args,
@@ -212,18 +212,22 @@ namespace embedding_ops {
 {% endif %}
 
 
+template <typename info_pta_t, typename info_t, bool nobag>
 __global__ __launch_bounds__(kMaxThreads) void
 split_embedding_backward_codegen_find_long_segments(
     const pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits> sorted_linear_indices_num_runs,
     const pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits> sorted_linear_indices_run_lengths,
+    const pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits> sorted_linear_indices_cumulative_run_lengths,
+    const pta::PackedTensorAccessor32<info_pta_t, 1, at::RestrictPtrTraits> sorted_infos,
     pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits> long_run_ids,
     pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits> num_long_run_ids,
     pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits> long_run_id_to_really_long_run_ids,
     pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits> num_really_long_run_ids,
     pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits> grad_accum_counter,
-    const int32_t max_segment_length_per_warp,
+    const pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits> max_segment_length_per_warp,
     const int32_t max_segment_length_per_cta,
-    const bool use_deterministic_algorithms);
+    const bool use_deterministic_algorithms,
+    const int32_t info_B_num_bits);
 
 
 template <typename grad_t>
@@ -876,28 +880,47 @@ Tensor split_embedding{{ ndesc }}_backward_codegen_{{ optimizer }}_{{ wdesc }}_e
                 auto num_long_run_ids = at::zeros({1}, indices.options().dtype(at::kInt));
 
                 const bool use_deterministic_algorithms = at::globalContext().deterministicAlgorithms();
-                const int max_segment_length_per_cta = use_deterministic_algorithms ? INT_MAX : 1024;
-
-                Tensor long_run_id_to_really_long_run_ids;
-                if (use_deterministic_algorithms) {
-                    long_run_id_to_really_long_run_ids =
-                        at::empty(0, sorted_linear_indices_run_lengths.options());
-                } else {
-                    long_run_id_to_really_long_run_ids =
-                        at::empty({indices.numel()}, sorted_linear_indices_run_lengths.options());
-                }
+                // Runs longer than max_segment_length_per_cta are split across
+                // thread blocks. The non-deterministic mode sums the blocks
+                // with atomics. The deterministic mode gives each block its
+                // own partial sum row and tree reduces the rows in a fixed
+                // order, so it uses longer chunks to bound the extra memory.
+                const int max_segment_length_per_cta = use_deterministic_algorithms ? 16384 : 1024;
 
+                auto long_run_id_to_really_long_run_ids =
+                    at::empty({indices.numel()}, sorted_linear_indices_run_lengths.options());
 
                 auto num_really_long_run_ids = at::zeros({1}, indices.options().dtype(at::kInt));
+                // The deterministic mode needs one row per thread block. A run
+                // of L > max_segment_length_per_cta lookups takes at most
+                // 2 * L / max_segment_length_per_cta blocks
                 auto grad_accum_counter = at::empty(
-                    use_deterministic_algorithms ? 0 : (indices.numel() / max_segment_length_per_cta),
+                    (use_deterministic_algorithms ? 2 : 1) * (indices.numel() / max_segment_length_per_cta),
                     indices.options().dtype(at::kInt));
 
+                // Decide per feature which runs are long enough for the CTA
+                // per row kernel from the segment length histogram of the
+                // batch, as a fixed threshold misroutes power-law features
+                const auto max_segment_length_per_warp_per_feature =
+                    adaptive_max_segment_length_per_warp(
+                        segment_length_histogram(
+                            sorted_linear_indices_num_runs,
+                            sorted_linear_indices_cumulative_run_lengths,
+                            infos_sorted,
+                            T,
+                            info_B_num_bits),
+                        max_segment_length_per_warp,
+                        kMaxThreads / kWarpSize);
+
 #ifdef FBGEMM_GPU_MEMCHECK
                 const auto func_name2 = "split_embedding_backward_codegen_find_long_segments";
 #endif
 
-                split_embedding_backward_codegen_find_long_segments<<<
+                split_embedding_backward_codegen_find_long_segments<
+                {{ "int64_t" if nobag else "int32_t" }},
+                {{ "int64_t" if nobag else "uint32_t" }},
+                {{ "true" if nobag else "false" }}
+                ><<<
                     div_round_up(total_unique_indices, kMaxThreads),
                     kMaxThreads,
                     0,
@@ -905,19 +928,22 @@ Tensor split_embedding{{ ndesc }}_backward_codegen_{{ optimizer }}_{{ wdesc }}_e
                 >>>(
                     MAKE_PTA_WITH_NAME(func_name2, sorted_linear_indices_num_runs, int32_t, 1, 32),
                     MAKE_PTA_WITH_NAME(func_name2, sorted_linear_indices_run_lengths, int32_t, 1, 32),
+                    MAKE_PTA_WITH_NAME(func_name2, sorted_linear_indices_cumulative_run_lengths, int32_t, 1, 32),
+                    MAKE_PTA_WITH_NAME(func_name2, infos_sorted, {{ "int64_t" if nobag else "int32_t" }}, 1, 32),
                     MAKE_PTA_WITH_NAME(func_name2, long_run_ids, int32_t, 1, 32),
                     MAKE_PTA_WITH_NAME(func_name2, num_long_run_ids, int32_t, 1, 32),
                     MAKE_PTA_WITH_NAME(func_name2, long_run_id_to_really_long_run_ids, int32_t, 1, 32),
                     MAKE_PTA_WITH_NAME(func_name2, num_really_long_run_ids, int32_t, 1, 32),
                     MAKE_PTA_WITH_NAME(func_name2, grad_accum_counter, int32_t, 1, 32),
-                    max_segment_length_per_warp,
+                    MAKE_PTA_WITH_NAME(func_name2, max_segment_length_per_warp_per_feature, int32_t, 1, 32),
                     max_segment_length_per_cta,
-                    use_deterministic_algorithms);
+                    use_deterministic_algorithms,
+                    info_B_num_bits);
                 C10_CUDA_KERNEL_LAUNCH_CHECK();
 
                 // A temp buffer to accumulate gradients with atomics.
                 auto temp_grad_accum = at::zeros(
-                    {use_deterministic_algorithms ? 0 : grad_accum_counter.numel(), max_D},
+                    {grad_accum_counter.numel(), max_D},
                     aligned_grad_output.options().dtype(std::is_same<cache_t, double>::value ? at::kDouble : at::kFloat));
 
                 DISPATCH_PLACEHOLDER_TYPES(
@@ -1133,7 +1159,7 @@ Tensor split_embedding{{ ndesc }}_backward_codegen_{{ optimizer }}_{{ wdesc }}_e
                             MAKE_PTA_ACC_WITH_NAME(func_name4, indice_weights_sorted, cache_t, 1, 32),
                             {%- endif %}
                             MAKE_PTA_WITH_NAME(func_name4, sorted_linear_indices_num_runs, int32_t, 1, 32),
-                            max_segment_length_per_warp,
+                            MAKE_PTA_WITH_NAME(func_name4, max_segment_length_per_warp_per_feature, int32_t, 1, 32),
                             {%- if not dense and optimizer != "none" %}
                             stochastic_rounding,
                             rng_engine_inputs,
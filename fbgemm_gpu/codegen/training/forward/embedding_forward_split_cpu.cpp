@@ -21,6 +21,9 @@
 #include <omp.h>
 #endif
 
+#include <algorithm>
+#include <cstring>
+
 #include <ATen/ATen.h>
 #include <ATen/AccumulateType.h>
 #include <ATen/core/op_registration/op_registration.h>
@@ -29,6 +32,128 @@
 using Tensor = at::Tensor;
 using namespace fbgemm_gpu;
 
+namespace {
+
+int64_t table_hash_size(
+    const at::TensorAccessor<int64_t, 1>& hash_size_cumsum_data,
+    int64_t t) {
+  int64_t hash_size;
+  int t_temp = t + 1;
+  do {
+    hash_size = hash_size_cumsum_data[t_temp] - hash_size_cumsum_data[t];
+    ++t_temp;
+  } while (hash_size == 0);
+  return hash_size;
+}
+
+// Pools num_bags consecutive bags of a table into output rows output_stride
+// apart, returns false on an out of bounds index
+template <typename weights_t, typename ind_weights_t, typename output_t>
+bool split_embedding_forward_cpu_bags(
+    const weights_t* table_weights,
+    int64_t hash_size,
+    int D,
+    const int64_t* indices_data,
+    const int64_t* offsets_begin_ptr,
+    int64_t num_bags,
+    const ind_weights_t* indice_weights_data,
+    int64_t pooling_mode,
+    output_t* output,
+    int64_t output_stride) {
+  constexpr bool use_fbgemm = (std::is_same<weights_t, float>::value ||
+                               std::is_same<weights_t, at::Half>::value ||
+                               std::is_same<weights_t, uint8_t>::value) &&
+      std::is_same<output_t, float>::value &&
+      std::is_same<ind_weights_t, float>::value;
+
+  bool success = true;
+  if (use_fbgemm) {
+    using fbgemm_weight_t = typename std::conditional<
+        std::is_same<weights_t, at::Half>::value,
+        fbgemm::float16,
+        weights_t>::type;
+    auto kernel = fbgemm::GenerateEmbeddingSpMDMWithStrides<
+        fbgemm_weight_t,
+        /*IndexType=*/int64_t,
+        /*OffsetType=*/int64_t>(
+        D,
+        indice_weights_data != nullptr,
+        static_cast<PoolingMode>(pooling_mode) == PoolingMode::MEAN,
+        /*prefetch=*/16,
+        /*is_weight_positional=*/false,
+        /*use_offsets=*/true,
+        output_stride);
+    auto indices_size = offsets_begin_ptr[num_bags] - *offsets_begin_ptr;
+    success = kernel(
+        num_bags,
+        indices_size,
+        hash_size,
+        reinterpret_cast<const fbgemm_weight_t*>(table_weights),
+        indices_data + *offsets_begin_ptr,
+        offsets_begin_ptr,
+        indice_weights_data != nullptr
+            ? reinterpret_cast<const float*>(
+                  indice_weights_data + *offsets_begin_ptr)
+            : nullptr,
+        reinterpret_cast<float*>(output));
+  } else {
+    at::acc_type<output_t, true> output_buf[D];
+    for (const auto b : c10::irange(num_bags)) {
+      const auto pool_begin = offsets_begin_ptr[b];
+      const auto pool_end = offsets_begin_ptr[b + 1];
+      const auto L = pool_end - pool_begin;
+      memset(output_buf, 0, D * sizeof(at::acc_type<output_t, true>));
+      for (const auto p : c10::irange(pool_begin, pool_end)) {
+        int64_t idx = indices_data[p];
+        if (idx < 0 || idx >= hash_size) {
+          success = false;
+          break;
+        }
+        const int64_t embedding_begin = idx * D;
+        for (const auto d : c10::irange(D)) {
+          output_buf[d] +=
+              (indice_weights_data != nullptr
+                   ? static_cast<at::acc_type<output_t, true>>(
+                         table_weights[embedding_begin + d]) *
+                       static_cast<at::acc_type<output_t, true>>(
+                           indice_weights_data[p])
+                   : static_cast<at::acc_type<output_t, true>>(
+                         table_weights[embedding_begin + d]));
+        }
+      }
+      const double scale_factor =
+          // NOTE: MEAN pooling will not work with indice_weights!
+          (static_cast<PoolingMode>(pooling_mode) == PoolingMode::MEAN &&
+           indice_weights_data == nullptr && L > 0)
+          ? 1.0 / L
+          : 1.0;
+      for (const auto d : c10::irange(D)) {
+        output[b * output_stride + d] = scale_factor * output_buf[d];
+      }
+      if (!success) {
+        break;
+      }
+    } // for each b
+  } // !use_fbgemm
+  return success;
+}
+
+Tensor empty_forward_output(
+    const Tensor& weights,
+    at::IntArrayRef sizes,
+    int64_t output_dtype) {
+  if (output_dtype == static_cast<int64_t>(SparseType::FP32)) {
+    return at::empty(sizes, weights.options().dtype(at::kFloat));
+  } else if (output_dtype == static_cast<int64_t>(SparseType::FP16)) {
+    return at::empty(sizes, weights.options().dtype(at::kHalf));
+  } else if (output_dtype == static_cast<int64_t>(SparseType::BF16)) {
+    return at::empty(sizes, weights.options().dtype(at::kBFloat16));
+  }
+  return at::empty(sizes, weights.options());
+}
+
+} // namespace
+
 template <typename weights_t, typename ind_weights_t, typename output_t>
 void split_embedding_forward_cpu_kernel(
     Tensor weights,
@@ -69,99 +194,41 @@ void split_embedding_forward_cpu_kernel(
 
   auto output_data = output.data_ptr<output_t>();
   auto output_stride = output.size(1);
-
-  constexpr bool use_fbgemm = (std::is_same<weights_t, float>::value ||
-                               std::is_same<weights_t, at::Half>::value ||
-                               std::is_same<weights_t, uint8_t>::value) &&
-      std::is_same<output_t, float>::value &&
-      std::is_same<ind_weights_t, float>::value;
+  const int cross_table_prefetch = fbgemm::getEmbeddingCrossTablePrefetch();
 
   at::parallel_for(0, B, 0, [&](int64_t b_begin, int64_t b_end) {
     for (const auto t : c10::irange(T)) {
+      // Rows of the first indices of the next table load while this one is
+      // pooled
+      if (cross_table_prefetch > 0 && t + 1 < T) {
+        const auto next_begin = offsets_data[(t + 1) * B + b_begin];
+        fbgemm::prefetchEmbeddingRows(
+            reinterpret_cast<const uint8_t*>(
+                weights_data + weights_offsets_data[t + 1]),
+            table_hash_size(hash_size_cumsum_data, t + 1),
+            (D_offsets_data[t + 2] - D_offsets_data[t + 1]) *
+                static_cast<int64_t>(sizeof(weights_t)),
+            indices_data + next_begin,
+            std::min<int64_t>(
+                cross_table_prefetch,
+                offsets_data[(t + 1) * B + b_end] - next_begin));
+      }
       const auto D_begin = D_offsets_data[t];
       const auto D = D_offsets_data[t + 1] - D_offsets_data[t];
       const auto table_begin = weights_offsets_data[t];
+      const auto hash_size = table_hash_size(hash_size_cumsum_data, t);
 
-      int64_t hash_size;
-      int t_temp = t + 1;
-      do {
-        hash_size = hash_size_cumsum_data[t_temp] - hash_size_cumsum_data[t];
-        ++t_temp;
-      } while (hash_size == 0);
-
-      bool success = true;
-      if (use_fbgemm) {
-        using fbgemm_weight_t = typename std::conditional<
-            std::is_same<weights_t, at::Half>::value,
-            fbgemm::float16,
-            weights_t>::type;
-        auto kernel = fbgemm::GenerateEmbeddingSpMDMWithStrides<
-            fbgemm_weight_t,
-            /*IndexType=*/int64_t,
-            /*OffsetType=*/int64_t>(
-            D,
-            indice_weights.defined(),
-            static_cast<PoolingMode>(pooling_mode) == PoolingMode::MEAN,
-            /*prefetch=*/16,
-            /*is_weight_positional=*/false,
-            /*use_offsets=*/true,
-            output_stride);
-        auto offsets_begin_ptr = offsets_data + t * B + b_begin;
-        auto indices_size = offsets_data[t * B + b_end] - *offsets_begin_ptr;
-        success = kernel(
-            b_end - b_begin,
-            indices_size,
-            hash_size,
-            reinterpret_cast<const fbgemm_weight_t*>(
-                weights_data + table_begin),
-            indices_data + *offsets_begin_ptr,
-            offsets_begin_ptr,
-            indice_weights.defined()
-                ? reinterpret_cast<const float*>(
-                      indice_weights_data + *offsets_begin_ptr)
-                : nullptr,
-            reinterpret_cast<float*>(
-                output_data + b_begin * output_stride + D_begin));
-      } else {
-        at::acc_type<output_t, true> output_buf[D];
-        for (const auto b : c10::irange(b_begin, b_end)) {
-          const auto pool_begin = offsets_data[t * B + b];
-          const auto pool_end = offsets_data[t * B + b + 1];
-          const auto L = pool_end - pool_begin;
-          memset(output_buf, 0, D * sizeof(at::acc_type<output_t, true>));
-          for (const auto p : c10::irange(pool_begin, pool_end)) {
-            int64_t idx = indices_data[p];
-            if (idx < 0 || idx >= hash_size) {
-              success = false;
-              break;
-            }
-            const int64_t embedding_begin = table_begin + idx * D;
-            for (const auto d : c10::irange(D)) {
-              output_buf[d] +=
-                  (indice_weights.defined()
-                       ? static_cast<at::acc_type<output_t, true>>(
-                             weights_data[embedding_begin + d]) *
-                           static_cast<at::acc_type<output_t, true>>(
-                               indice_weights_data[p])
-                       : static_cast<at::acc_type<output_t, true>>(
-                             weights_data[embedding_begin + d]));
-            }
-          }
-          const double scale_factor =
-              // NOTE: MEAN pooling will not work with indice_weights!
-              (static_cast<PoolingMode>(pooling_mode) == PoolingMode::MEAN &&
-               !indice_weights.defined() && L > 0)
-              ? 1.0 / L
-              : 1.0;
-          for (const auto d : c10::irange(D)) {
-            output_data[b * output_stride + D_begin + d] =
-                scale_factor * output_buf[d];
-          }
-          if (!success) {
-            break;
-          }
-        } // for each b
-      } // !use_fbgemm
+      const bool success = split_embedding_forward_cpu_bags(
+          weights_data + table_begin,
+          hash_size,
+          D,
+          indices_data,
+          offsets_data + t * B + b_begin,
+          b_end - b_begin,
+          indice_weights_data,
+          pooling_mode,
+          output_data + b_begin * output_stride + D_begin,
+          output_stride);
 
       if (!success) {
         fbgemm_gpu::report_embedding_error(
@@ -171,6 +238,94 @@ void split_embedding_forward_cpu_kernel(
   }); // parallel for
 }
 
+template <typename weights_t, typename ind_weights_t, typename output_t>
+void split_embedding_forward_vbe_cpu_kernel(
+    Tensor weights,
+    Tensor weights_offsets,
+    Tensor D_offsets,
+    Tensor hash_size_cumsum,
+    Tensor indices,
+    Tensor offsets,
+    int64_t pooling_mode,
+    Tensor indice_weights,
+    Tensor B_offsets,
+    Tensor vbe_output_offsets_feature_rank,
+    Tensor vbe_B_offsets_rank_per_feature,
+    Tensor output) {
+  const int64_t T = D_offsets.numel() - 1;
+  TORCH_CHECK_GT(T, 0);
+  const int64_t R = vbe_B_offsets_rank_per_feature.size(1) - 1;
+  TORCH_CHECK_GT(R, 0);
+
+  TORCH_CHECK(weights.is_contiguous());
+  indices = indices.contiguous();
+  offsets = offsets.contiguous();
+  if (indice_weights.defined()) {
+    indice_weights = indice_weights.contiguous();
+  }
+  B_offsets = B_offsets.contiguous();
+  vbe_B_offsets_rank_per_feature = vbe_B_offsets_rank_per_feature.contiguous();
+
+  const auto D_offsets_data = D_offsets.accessor<int, 1>();
+  const auto weights_offsets_data = weights_offsets.accessor<int64_t, 1>();
+  const auto indices_data = indices.data_ptr<int64_t>();
+  const auto offsets_data = offsets.data_ptr<int64_t>();
+  const auto hash_size_cumsum_data = hash_size_cumsum.accessor<int64_t, 1>();
+  const auto B_offsets_data = B_offsets.data_ptr<int>();
+  const auto output_offsets_data =
+      vbe_output_offsets_feature_rank.accessor<int64_t, 1>();
+  const auto B_offsets_rank_data =
+      vbe_B_offsets_rank_per_feature.data_ptr<int>();
+
+  const auto weights_data = weights.data_ptr<weights_t>();
+  const auto indice_weights_data = indice_weights.defined()
+      ? indice_weights.data_ptr<ind_weights_t>()
+      : nullptr;
+  auto output_data = output.data_ptr<output_t>();
+
+  // Bags are split over the threads regardless of their feature, a thread
+  // pools the runs of bags of a same feature and rank of its range, which
+  // are contiguous in the output
+  const int64_t total_B = B_offsets_data[T];
+  at::parallel_for(0, total_B, 0, [&](int64_t bag_begin, int64_t bag_end) {
+    int64_t t = std::upper_bound(
+                    B_offsets_data, B_offsets_data + T + 1, bag_begin) -
+        B_offsets_data - 1;
+    for (int64_t bag = bag_begin; bag < bag_end;) {
+      while (B_offsets_data[t + 1] <= bag) {
+        ++t;
+      }
+      const int* rank_offsets = B_offsets_rank_data + t * (R + 1);
+      const int64_t b = bag - B_offsets_data[t];
+      const int64_t r =
+          std::upper_bound(rank_offsets, rank_offsets + R + 1, b) -
+          rank_offsets - 1;
+      const int64_t run_end =
+          std::min<int64_t>(bag_end, B_offsets_data[t] + rank_offsets[r + 1]);
+
+      const auto D = D_offsets_data[t + 1] - D_offsets_data[t];
+      const auto hash_size = table_hash_size(hash_size_cumsum_data, t);
+      const bool success = split_embedding_forward_cpu_bags(
+          weights_data + weights_offsets_data[t],
+          hash_size,
+          D,
+          indices_data,
+          offsets_data + bag,
+          run_end - bag,
+          indice_weights_data,
+          pooling_mode,
+          output_data + output_offsets_data[r * T + t] +
+              (b - rank_offsets[r]) * D,
+          D);
+      if (!success) {
+        fbgemm_gpu::report_embedding_error(
+            0, 0, bag, run_end, offsets_data, indices_data, hash_size);
+      }
+      bag = run_end;
+    }
+  }); // parallel for
+}
+
 Tensor split_embedding_codegen_forward_cpu(
     Tensor weights,
     Tensor weights_offsets,
@@ -189,16 +344,7 @@ Tensor split_embedding_codegen_forward_cpu(
   int64_t B = (offsets.size(0) - 1) / T;
   TORCH_CHECK_GE(B, 0);
 
-  Tensor output;
-  if (output_dtype == static_cast<int64_t>(SparseType::FP32)) {
-    output = at::empty({B, total_D}, weights.options().dtype(at::kFloat));
-  } else if (output_dtype == static_cast<int64_t>(SparseType::FP16)) {
-    output = at::empty({B, total_D}, weights.options().dtype(at::kHalf));
-  } else if (output_dtype == static_cast<int64_t>(SparseType::BF16)) {
-    output = at::empty({B, total_D}, weights.options().dtype(at::kBFloat16));
-  } else {
-    output = at::empty({B, total_D}, weights.options());
-  }
+  Tensor output = empty_forward_output(weights, {B, total_D}, output_dtype);
 
   // It is assumed that the indice_weights will always be float
   TORCH_CHECK(
@@ -231,6 +377,137 @@ Tensor split_embedding_codegen_forward_cpu(
   return output;
 }
 
+Tensor split_embedding_codegen_forward_vbe_cpu(
+    Tensor weights,
+    Tensor weights_offsets,
+    Tensor D_offsets,
+    Tensor hash_size_cumsum,
+    Tensor indices,
+    Tensor offsets,
+    int64_t pooling_mode,
+    Tensor indice_weights,
+    Tensor B_offsets,
+    Tensor vbe_output_offsets_feature_rank,
+    Tensor vbe_B_offsets_rank_per_feature,
+    int64_t vbe_output_size,
+    int64_t output_dtype) {
+  const int64_t T = D_offsets.numel() - 1;
+  TORCH_CHECK_GT(T, 0);
+  TORCH_CHECK_EQ(B_offsets.numel(), T + 1);
+  TORCH_CHECK_EQ(vbe_B_offsets_rank_per_feature.dim(), 2);
+  TORCH_CHECK_EQ(vbe_B_offsets_rank_per_feature.size(0), T);
+  const int64_t R = vbe_B_offsets_rank_per_feature.size(1) - 1;
+  TORCH_CHECK_EQ(vbe_output_offsets_feature_rank.numel(), R * T + 1);
+  // offsets = [B_offsets[T] + 1]
+  TORCH_CHECK_EQ(offsets.numel(), B_offsets[T].item<int64_t>() + 1);
+  TORCH_CHECK_GE(vbe_output_size, 0);
+
+  Tensor output =
+      empty_forward_output(weights, {1, vbe_output_size}, output_dtype);
+
+  // It is assumed that the indice_weights will always be float
+  TORCH_CHECK(
+      !indice_weights.defined() || indice_weights.scalar_type() != at::kHalf);
+  FBGEMM_DISPATCH_FLOAT_AND_HALF(
+      output.scalar_type(), "split_embedding_cpu_forward_vbe", [&]() {
+        using output_t = scalar_t;
+        FBGEMM_DISPATCH_FLOAT_HALF_AND_BYTE(
+            weights.scalar_type(), "split_embedding_cpu_forward_vbe", [&] {
+              using ind_weights_t = std::conditional<
+                  std::is_same<scalar_t, double>::value,
+                  double,
+                  float>::type;
+              split_embedding_forward_vbe_cpu_kernel<
+                  scalar_t,
+                  ind_weights_t,
+                  output_t>(
+                  weights,
+                  weights_offsets,
+                  D_offsets,
+                  hash_size_cumsum,
+                  indices,
+                  offsets,
+                  pooling_mode,
+                  indice_weights,
+                  B_offsets,
+                  vbe_output_offsets_feature_rank,
+                  vbe_B_offsets_rank_per_feature,
+                  output);
+            });
+      });
+  return output;
+}
+
+Tensor split_embedding_vbe_padded_offsets_cpu(
+    Tensor offsets,
+    Tensor B_offsets,
+    int64_t max_B) {
+  const int64_t T = B_offsets.numel() - 1;
+  TORCH_CHECK_GT(T, 0);
+  offsets = offsets.contiguous();
+  const auto B_offsets_data = B_offsets.accessor<int, 1>();
+  TORCH_CHECK_EQ(offsets.numel(), B_offsets_data[T] + 1);
+
+  auto padded_offsets = at::empty({T * max_B + 1}, offsets.options());
+  const auto offsets_data = offsets.data_ptr<int64_t>();
+  auto padded_offsets_data = padded_offsets.data_ptr<int64_t>();
+  for (const auto t : c10::irange(T)) {
+    const int64_t B = B_offsets_data[t + 1] - B_offsets_data[t];
+    TORCH_CHECK_LE(B, max_B);
+    std::memcpy(
+        padded_offsets_data + t * max_B,
+        offsets_data + B_offsets_data[t],
+        B * sizeof(int64_t));
+    // The padded bags are empty
+    std::fill_n(
+        padded_offsets_data + t * max_B + B,
+        max_B - B,
+        offsets_data[B_offsets_data[t + 1]]);
+  }
+  padded_offsets_data[T * max_B] = offsets_data[B_offsets_data[T]];
+  return padded_offsets;
+}
+
+Tensor split_embedding_vbe_padded_grad_cpu(
+    Tensor grad_output,
+    Tensor D_offsets,
+    int64_t total_D,
+    Tensor B_offsets,
+    Tensor vbe_output_offsets_feature_rank,
+    Tensor vbe_B_offsets_rank_per_feature,
+    int64_t max_B) {
+  const int64_t T = D_offsets.numel() - 1;
+  TORCH_CHECK_GT(T, 0);
+  const int64_t R = vbe_B_offsets_rank_per_feature.size(1) - 1;
+  const auto D_offsets_data = D_offsets.accessor<int, 1>();
+  const auto output_offsets_data =
+      vbe_output_offsets_feature_rank.accessor<int64_t, 1>();
+  const auto B_offsets_rank_data =
+      vbe_B_offsets_rank_per_feature.accessor<int, 2>();
+
+  const auto grad = grad_output.reshape({-1});
+  TORCH_CHECK_EQ(grad.numel(), output_offsets_data[R * T]);
+  auto padded_grad = at::zeros({max_B, total_D}, grad_output.options());
+  at::parallel_for(0, T, 1, [&](int64_t t_begin, int64_t t_end) {
+    for (const auto t : c10::irange(t_begin, t_end)) {
+      const auto D_begin = D_offsets_data[t];
+      const auto D = D_offsets_data[t + 1] - D_begin;
+      for (const auto r : c10::irange(R)) {
+        const int64_t b_begin = B_offsets_rank_data[t][r];
+        const int64_t num_bags = B_offsets_rank_data[t][r + 1] - b_begin;
+        if (num_bags == 0) {
+          continue;
+        }
+        padded_grad.narrow(0, b_begin, num_bags)
+            .narrow(1, D_begin, D)
+            .copy_(grad.narrow(0, output_offsets_data[r * T + t], num_bags * D)
+                       .view({num_bags, D}));
+      }
+    }
+  });
+  return padded_grad;
+}
+
 Tensor split_embedding_codegen_forward_cpu_meta(
     Tensor weights,
     Tensor weights_offsets,
@@ -361,6 +638,149 @@ namespace internal {
 
 namespace {
 
+// Tables whose rows times the number of threads are at most this many, or at
+// most the number of indices, are transposed by counting the indices of every
+// row instead of radix sorting them
+constexpr int64_t kCsr2CscCountingMinSize = 1 << 16;
+
+// Stable counting sort of the indices of the table by row: every task counts
+// the indices of a contiguous range of bags per row, the counts are turned
+// into the first position of every (row, task) pair, and every task scatters
+// its bags to these positions. The output matches the radix sort path.
+template <typename scalar_t, bool IS_VALUE_PAIR>
+void csr2csc_counting_(
+    HyperCompressedSparseColumn& csc,
+    int B,
+    const at::TensorAccessor<int64_t, 1>& csr_offsets,
+    const at::TensorAccessor<int64_t, 1>& csr_indices,
+    const at::TensorAccessor<scalar_t, 1>& csr_weights,
+    int64_t pooling_mode,
+    const int* table_to_feature_offset,
+    int64_t num_embeddings,
+    int num_tasks) {
+  const bool has_weights = csr_weights.data() != nullptr;
+  // MEAN pooling will not work with indice_weights!
+  const bool is_mean =
+      static_cast<PoolingMode>(pooling_mode) == PoolingMode::MEAN &&
+      !has_weights;
+  const int64_t num_bags = static_cast<int64_t>(
+                               table_to_feature_offset[1] -
+                               table_to_feature_offset[0]) *
+      B;
+  const int64_t* bag_offsets =
+      csr_offsets.data() + static_cast<int64_t>(table_to_feature_offset[0]) * B;
+  const int64_t FBo = bag_offsets[0];
+  const int64_t NS = bag_offsets[num_bags] - FBo;
+
+  // Bags of similar numbers of indices per task
+  std::vector<int64_t> task_bags(num_tasks + 1, num_bags);
+  for (const auto i : c10::irange(num_tasks)) {
+    task_bags[i] =
+        std::lower_bound(
+            bag_offsets, bag_offsets + num_bags, FBo + NS * i / num_tasks) -
+        bag_offsets;
+  }
+  task_bags[0] = 0;
+
+  const auto run_tasks = [num_tasks](const std::function<void(int)>& task) {
+    at::parallel_for(0, num_tasks, 1, [&](int64_t begin, int64_t end) {
+      for (const auto i : c10::irange(begin, end)) {
+        task(i);
+      }
+    });
+  };
+
+  // counts[i * num_embeddings + r]: indices of row r in the bags of task i,
+  // then first position of these indices in the output
+  std::vector<int> counts(num_tasks * num_embeddings, 0);
+  run_tasks([&](int i) {
+    int* task_counts = counts.data() + i * num_embeddings;
+    for (const auto p : c10::irange(
+             bag_offsets[task_bags[i]], bag_offsets[task_bags[i + 1]])) {
+      const auto idx = csr_indices[p];
+      TORCH_CHECK(
+          idx >= 0 && idx < num_embeddings,
+          "Index ",
+          p,
+          " is out of bounds: ",
+          idx,
+          ", range 0 to ",
+          num_embeddings);
+      ++task_counts[idx];
+    }
+  });
+
+  // Rows are split in blocks of the tasks; block_sizes[j + 1] and
+  // block_columns[j + 1] are the indices and nonempty rows of block j, and
+  // their exclusive prefix sums once scanned
+  std::vector<int64_t> block_sizes(num_tasks + 1, 0);
+  std::vector<int> block_columns(num_tasks + 1, 0);
+  const auto block_begin = [&](int j) {
+    return num_embeddings * j / num_tasks;
+  };
+  run_tasks([&](int j) {
+    int64_t size = 0;
+    int columns = 0;
+    for (int64_t r = block_begin(j); r < block_begin(j + 1); ++r) {
+      int64_t row_size = 0;
+      for (const auto i : c10::irange(num_tasks)) {
+        row_size += counts[i * num_embeddings + r];
+      }
+      size += row_size;
+      columns += row_size > 0;
+    }
+    block_sizes[j + 1] = size;
+    block_columns[j + 1] = columns;
+  });
+  for (const auto j : c10::irange(num_tasks)) {
+    block_sizes[j + 1] += block_sizes[j];
+    block_columns[j + 1] += block_columns[j];
+  }
+  run_tasks([&](int j) {
+    int position = block_sizes[j];
+    int column = block_columns[j];
+    for (int64_t r = block_begin(j); r < block_begin(j + 1); ++r) {
+      const int row_begin = position;
+      for (const auto i : c10::irange(num_tasks)) {
+        int& count = counts[i * num_embeddings + r];
+        const int task_count = count;
+        count = position;
+        position += task_count;
+      }
+      if (position > row_begin) {
+        csc.column_segment_indices[column] = r;
+        csc.column_segment_ptr[column] = row_begin;
+        ++column;
+      }
+    }
+  });
+  const int U = block_columns[num_tasks];
+  csc.num_non_zero_columns = U;
+  csc.column_segment_ptr[U] = NS;
+
+  run_tasks([&](int i) {
+    int* task_positions = counts.data() + i * num_embeddings;
+    for (int64_t bag = task_bags[i]; bag < task_bags[i + 1]; ++bag) {
+      const int64_t pool_begin = bag_offsets[bag];
+      const int64_t pool_end = bag_offsets[bag + 1];
+      const int64_t L = pool_end - pool_begin;
+      const double scale_factor = is_mean && L > 0 ? 1.0 / L : 1.0;
+      const int segment_id = bag / B;
+      const int b = bag - static_cast<int64_t>(segment_id) * B;
+      for (const auto p : c10::irange(pool_begin, pool_end)) {
+        const int position = task_positions[csr_indices[p]]++;
+        csc.row_indices[position] = b;
+        csc.column_segment_ids[position] = segment_id;
+        if (IS_VALUE_PAIR) {
+          const scalar_t weight =
+              scale_factor * (has_weights ? csr_weights[p] : 1.0f);
+          csc.weights[position] = weight;
+        }
+      }
+    }
+  });
+}
+
 template <typename scalar_t, bool IS_VALUE_PAIR>
 void csr2csc_template_(
     HyperCompressedSparseColumn& csc,
@@ -392,6 +812,28 @@ void csr2csc_template_(
       csr_offsets[table_to_feature_offset[0] * B];
   int num_non_empty_segments = 0;
 
+  const int num_tasks = at::get_num_threads();
+  if (num_embeddings * num_tasks <=
+      std::max<int64_t>(NS, kCsr2CscCountingMinSize)) {
+    csc.column_segment_ids =
+        static_cast<int*>(fbgemm::fbgemmAlignedAlloc(64, nnz * sizeof(int)));
+    csc.column_segment_ptr = static_cast<int*>(
+        fbgemm::fbgemmAlignedAlloc(64, (NS + 1) * sizeof(int)));
+    csc.column_segment_indices =
+        static_cast<int*>(fbgemm::fbgemmAlignedAlloc(64, NS * sizeof(int)));
+    csr2csc_counting_<scalar_t, IS_VALUE_PAIR>(
+        csc,
+        B,
+        csr_offsets,
+        csr_indices,
+        csr_weights,
+        pooling_mode,
+        table_to_feature_offset,
+        num_embeddings,
+        num_tasks);
+    return;
+  }
+
   using pair_t = std::pair<int, scalar_t>;
   using value_t = typename std::conditional<IS_VALUE_PAIR, pair_t, int>::type;
 
@@ -444,7 +886,18 @@ void csr2csc_template_(
           tmpBuf1Keys,
           tmpBuf1Values,
           NS,
-          num_embeddings);
+          num_embeddings,
+          /*maybe_with_neg_vals=*/false,
+          at::get_num_threads(),
+          // Run on the ATen thread pool so that the sort is parallel in
+          // builds without OpenMP too
+          [](int num_tasks, const std::function<void(int)>& task) {
+            at::parallel_for(0, num_tasks, 1, [&](int64_t begin, int64_t end) {
+              for (const auto t : c10::irange(begin, end)) {
+                task(t);
+              }
+            });
+          });
 
   int max_thds = omp_get_max_threads();
   int num_uniq[max_thds][64];
@@ -645,10 +1098,150 @@ template void csr2csc<double>(
     const int* table_to_feature_offset,
     int64_t num_embeddings);
 
+std::vector<CompressedSparseColumnView> csc_plan_views(
+    at::TensorList csc_plan,
+    int num_tables) {
+  TORCH_CHECK_EQ(csc_plan.size(), 7);
+  const auto& table_offsets = csc_plan[0];
+  const auto& num_non_zero_columns = csc_plan[1];
+  TORCH_CHECK_EQ(table_offsets.numel(), num_tables + 1);
+  TORCH_CHECK_EQ(num_non_zero_columns.numel(), num_tables);
+  const auto table_offsets_data = table_offsets.accessor<int64_t, 1>();
+  const auto num_non_zero_columns_data =
+      num_non_zero_columns.accessor<int64_t, 1>();
+  const bool has_weights = csc_plan[6].numel() > 0;
+
+  std::vector<CompressedSparseColumnView> views(num_tables);
+  for (const auto t : c10::irange(num_tables)) {
+    const auto begin = table_offsets_data[t];
+    auto& view = views[t];
+    view.num_non_zero_columns = num_non_zero_columns_data[t];
+    view.column_segment_ptr = csc_plan[2].data_ptr<int>() + begin + t;
+    view.column_segment_indices = csc_plan[3].data_ptr<int>() + begin;
+    view.column_segment_ids = csc_plan[4].data_ptr<int>() + begin;
+    view.row_indices = csc_plan[5].data_ptr<int>() + begin;
+    view.weights =
+        has_weights ? csc_plan[6].data_ptr<float>() + begin : nullptr;
+  }
+  return views;
+}
+
 } // namespace internal
 
+std::vector<Tensor> split_embedding_backward_csc_plan_cpu(
+    Tensor hash_size_cumsum,
+    Tensor indices,
+    Tensor offsets,
+    int64_t pooling_mode,
+    Tensor indice_weights) {
+  int64_t T = hash_size_cumsum.numel() - 1;
+  TORCH_CHECK_GT(T, 0);
+  // offsets = [T x B  + 1]
+  int64_t B = (offsets.size(0) - 1) / T;
+  TORCH_CHECK_GE(B, 0);
+
+  // Physical tables as in the backward pass
+  const auto hash_size_cumsum_data = hash_size_cumsum.accessor<int64_t, 1>();
+  std::vector<int> table_to_feature_offset = {0};
+  for (const auto feature : c10::irange(T - 1)) {
+    if (hash_size_cumsum_data[feature + 1] != hash_size_cumsum_data[feature]) {
+      table_to_feature_offset.push_back(feature + 1);
+    }
+  }
+  table_to_feature_offset.push_back(T);
+  const int num_tables = table_to_feature_offset.size() - 1;
+
+  const auto offsets_data = offsets.accessor<int64_t, 1>();
+  const int64_t nnz = offsets_data[T * B];
+  const bool has_weights = indice_weights.defined() ||
+      static_cast<PoolingMode>(pooling_mode) == PoolingMode::MEAN;
+  const auto int_options = indices.options().dtype(at::kInt);
+  auto table_offsets = at::empty({num_tables + 1}, indices.options());
+  auto num_non_zero_columns = at::zeros({num_tables}, indices.options());
+  auto column_segment_ptr = at::empty({nnz + num_tables}, int_options);
+  auto column_segment_indices = at::empty({nnz}, int_options);
+  auto column_segment_ids = at::empty({nnz}, int_options);
+  auto row_indices = at::empty({nnz}, int_options);
+  auto weights =
+      at::empty({has_weights ? nnz : 0}, indices.options().dtype(at::kFloat));
+  auto table_offsets_data = table_offsets.accessor<int64_t, 1>();
+  auto num_non_zero_columns_data = num_non_zero_columns.accessor<int64_t, 1>();
+  table_offsets_data[num_tables] = nnz;
+
+  for (const auto t : c10::irange(num_tables)) {
+    const int feature_begin = table_to_feature_offset[t];
+    const int feature_end = table_to_feature_offset[t + 1];
+    const int64_t hash_size = hash_size_cumsum_data[feature_end] -
+        hash_size_cumsum_data[feature_begin];
+    TORCH_CHECK(
+        hash_size < ((1L << 31) - 1),
+        "CPU exact rowwise adagrad currently doesn't support embedding tables "
+        "with more than 2B rows");
+    const int64_t begin = offsets_data[feature_begin * B];
+    const int64_t table_nnz = offsets_data[feature_end * B] - begin;
+    table_offsets_data[t] = begin;
+
+    ::internal::HyperCompressedSparseColumn csc;
+    ::internal::csr2csc(
+        csc,
+        B,
+        offsets_data,
+        indices.accessor<int64_t, 1>(),
+        indice_weights.defined()
+            ? indice_weights.accessor<float, 1>()
+            : at::TensorAccessor<float, 1>(nullptr, nullptr, nullptr),
+        pooling_mode,
+        table_to_feature_offset.data() + t,
+        hash_size);
+    if (table_nnz == 0) {
+      continue;
+    }
+    const int U = csc.num_non_zero_columns;
+    num_non_zero_columns_data[t] = U;
+    std::memcpy(
+        column_segment_ptr.data_ptr<int>() + begin + t,
+        csc.column_segment_ptr,
+        (U + 1) * sizeof(int));
+    std::memcpy(
+        column_segment_indices.data_ptr<int>() + begin,
+        csc.column_segment_indices,
+        U * sizeof(int));
+    std::memcpy(
+        column_segment_ids.data_ptr<int>() + begin,
+        csc.column_segment_ids,
+        table_nnz * sizeof(int));
+    std::memcpy(
+        row_indices.data_ptr<int>() + begin,
+        csc.row_indices,
+        table_nnz * sizeof(int));
+    if (has_weights) {
+      std::memcpy(
+          weights.data_ptr<float>() + begin,
+          csc.weights,
+          table_nnz * sizeof(float));
+    }
+  }
+
+  return {
+      table_offsets,
+      num_non_zero_columns,
+      column_segment_ptr,
+      column_segment_indices,
+      column_segment_ids,
+      row_indices,
+      weights};
+}
+
 namespace {
 
+TORCH_LIBRARY_FRAGMENT(fbgemm, m) {
+  m.def(
+      "split_embedding_backward_csc_plan_cpu(Tensor hash_size_cumsum, Tensor indices, Tensor offsets, int pooling_mode, Tensor indice_weights) -> Tensor[]");
+  DISPATCH_TO_CPU(
+      "split_embedding_backward_csc_plan_cpu",
+      split_embedding_backward_csc_plan_cpu);
+}
+
 TORCH_LIBRARY_FRAGMENT(fbgemm, m) {
   m.def(
       "split_embedding_codegen_grad_indice_weights_cpu(Tensor grad_output, Tensor weights, Tensor weights_offsets, Tensor D_offsets, Tensor indices, Tensor offsets, Tensor feature_requires_grad) -> Tensor");
@@ -665,6 +1258,30 @@ TORCH_LIBRARY_FRAGMENT(fbgemm, m) {
       split_embedding_codegen_forward_cpu);
 }
 
+TORCH_LIBRARY_FRAGMENT(fbgemm, m) {
+  m.def(
+      "split_embedding_codegen_forward_vbe_cpu(Tensor weights, Tensor weights_offsets, Tensor D_offsets, Tensor hash_size_cumsum, Tensor indices, Tensor offsets, int pooling_mode, Tensor indice_weights, Tensor B_offsets, Tensor vbe_output_offsets_feature_rank, Tensor vbe_B_offsets_rank_per_feature, int vbe_output_size, int output_dtype) -> Tensor");
+  DISPATCH_TO_CPU(
+      "split_embedding_codegen_forward_vbe_cpu",
+      split_embedding_codegen_forward_vbe_cpu);
+}
+
+TORCH_LIBRARY_FRAGMENT(fbgemm, m) {
+  m.def(
+      "split_embedding_vbe_padded_offsets_cpu(Tensor offsets, Tensor B_offsets, int max_B) -> Tensor");
+  DISPATCH_TO_CPU(
+      "split_embedding_vbe_padded_offsets_cpu",
+      split_embedding_vbe_padded_offsets_cpu);
+}
+
+TORCH_LIBRARY_FRAGMENT(fbgemm, m) {
+  m.def(
+      "split_embedding_vbe_padded_grad_cpu(Tensor grad_output, Tensor D_offsets, int total_D, Tensor B_offsets, Tensor vbe_output_offsets_feature_rank, Tensor vbe_B_offsets_rank_per_feature, int max_B) -> Tensor");
+  DISPATCH_TO_CPU(
+      "split_embedding_vbe_padded_grad_cpu",
+      split_embedding_vbe_padded_grad_cpu);
+}
+
 TORCH_LIBRARY_IMPL(fbgemm, Meta, m) {
   m.impl(
       "split_embedding_codegen_forward_cpu",
@@ -628,6 +628,7 @@ batch_index_select_dim0_codegen_forward_kernel
         fixed_max_vecs_per_thread=max_forward_embedding_dim // items_per_warp,
         use_subwarp_shuffle=use_subwarp_shuffle,
         use_vec_blocking=False,
+        min_group_size=(8 if nobag else forward_min_thread_group_size),
     )
 %}
     {#-/* nobag does not have kMaxVecsPerThread as a template arg */#}
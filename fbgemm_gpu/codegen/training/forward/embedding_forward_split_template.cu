@@ -206,7 +206,9 @@ batch_index_select_dim0_codegen_forward_kernel(
 /*
   The macro definition for both cases are almost the same except for the
   definition of kThreadGroupSize.  In the FBGEMM_USE_SUBWARP_SHUFFLE case, if
-  MAX_D is small, then we use fewer number of threads than kWarpSize.
+  MAX_D is small, then we use fewer number of threads than kWarpSize.  Groups
+  go down to forward_min_thread_group_size threads so that tiny-D tables
+  (D <= 8) do not leave most lanes of an 8-thread group idle.
 
   NOTE: kMaxVecsPerThread is computed using the ternary operator because HIPCC
   is unable to use std::max in constexpr context.
@@ -224,7 +226,8 @@ batch_index_select_dim0_codegen_forward_kernel(
        dispatch_non_vec_blocking_kernel(
            items_per_warp,
            fixed_max_vecs_per_thread,
-           use_subwarp_shuffle=True)
+           use_subwarp_shuffle=True,
+           min_group_size=forward_min_thread_group_size)
     -}}
     return;                                    \
   }()
@@ -14,6 +14,12 @@
 #define GROUP_REDUCE_ALL_SUM(val, ...) \
   warpReduceAllSum<__VA_ARGS__, kThreadGroupSize>(val, shfl_sync_mask)
 
+#define GROUP_REDUCE_ALL_MAX(val, ...) \
+  warpReduceAllMax<__VA_ARGS__, kThreadGroupSize>(val, shfl_sync_mask)
+
+#define GROUP_REDUCE_ALL_MIN(val, ...) \
+  warpReduceAllMin<__VA_ARGS__, kThreadGroupSize>(val, shfl_sync_mask)
+
 using namespace fbgemm_gpu;
 
 template <
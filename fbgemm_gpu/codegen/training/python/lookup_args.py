@@ -46,6 +46,10 @@ class CommonArgs(NamedTuple):
     is_experimental: bool
     use_uniq_cache_locations_bwd: bool
     use_homogeneous_placements: bool
+    # CPU only: sort the indices for the backward pass in the forward pass
+    cache_csc_plan: bool = False
+    # CPU only: update the rows from per-thread gradient sums, without sorting
+    hogwild_backward: bool = False
 
 
 class OptimizerArgs(NamedTuple):
@@ -48,16 +48,24 @@ void bounds_check_indices_cpu(
     const c10::optional<Tensor>& weights,
     const c10::optional<Tensor>& B_offsets,
     const int64_t /*max_B*/) {
-  TORCH_CHECK(
-      !B_offsets.has_value(),
-      "bounds_check_indices on CPU does not support variable length (batch size)");
   auto bounds_check_mode = static_cast<BoundsCheckMode>(bounds_check_mode_);
   if (bounds_check_mode == BoundsCheckMode::WARNING) {
     warning.zero_();
   }
 
   int32_t T = rows_per_table.size(0);
-  int32_t B = (offsets.size(0) - 1) / T;
+  // With variable batch sizes, the bags of table t are
+  // [B_offsets[t], B_offsets[t + 1])
+  const bool vbe = B_offsets.has_value();
+  Tensor B_offsets_value;
+  if (vbe) {
+    TORCH_CHECK_EQ(B_offsets->numel(), T + 1);
+    B_offsets_value = B_offsets->to(at::kInt).contiguous();
+  }
+  const int32_t* B_offsets_data =
+      vbe ? B_offsets_value.data_ptr<int32_t>() : nullptr;
+  int32_t B = vbe ? 0 : (offsets.size(0) - 1) / T;
+  const int64_t total_B = vbe ? B_offsets_data[T] : B * T;
   const auto rows_per_table_acc = rows_per_table.accessor<int64_t, 1>();
   auto warning_acc = warning.data_ptr<int64_t>();
 
@@ -66,11 +74,19 @@ void bounds_check_indices_cpu(
     auto indices_acc = indices.accessor<index_t, 1>();
     auto num_indices = indices.numel();
 
-    TORCH_CHECK(
-        offsets.size(0) == B * T + 1,
-        "offsets size " + std::to_string(offsets.size(0)) +
-            " is not equal to B (" + std::to_string(B) + ") * T (" +
-            std::to_string(T) + ") + 1");
+    if (vbe) {
+      TORCH_CHECK(
+          offsets.size(0) == total_B + 1,
+          "offsets size " + std::to_string(offsets.size(0)) +
+              " is not equal to the total batch size (" +
+              std::to_string(total_B) + ") + 1");
+    } else {
+      TORCH_CHECK(
+          offsets.size(0) == B * T + 1,
+          "offsets size " + std::to_string(offsets.size(0)) +
+              " is not equal to B (" + std::to_string(B) + ") * T (" +
+              std::to_string(T) + ") + 1");
+    }
     if (weights.has_value()) {
       TORCH_CHECK(
           weights.value().size(0) == num_indices,
@@ -79,29 +95,31 @@ void bounds_check_indices_cpu(
     }
 
     if (bounds_check_mode == BoundsCheckMode::FATAL) {
-      TORCH_CHECK(num_indices == offsets_acc[B * T]);
+      TORCH_CHECK(num_indices == offsets_acc[total_B]);
     } else if (bounds_check_mode == BoundsCheckMode::WARNING) {
-      if (num_indices != offsets_acc[B * T]) {
+      if (num_indices != offsets_acc[total_B]) {
         if (__sync_fetch_and_add(&warning_acc[0], 1) == 0) {
           LOG(ERROR)
               << "The last element in offsets is incorrect for "
-              << "total batch size B: " << B << ", total table num T: " << T
-              << ", last element in offsets: " << offsets_acc[B * T]
+              << "total batch size: " << total_B << ", total table num T: " << T
+              << ", last element in offsets: " << offsets_acc[total_B]
               << ", indices size: " << num_indices
               << ". Setting the last element in offsets to be indices size.";
         }
-        offsets_acc[B * T] = num_indices;
+        offsets_acc[total_B] = num_indices;
       }
     } else if (bounds_check_mode == BoundsCheckMode::IGNORE) {
-      if (num_indices != offsets_acc[B * T]) {
-        offsets_acc[B * T] = num_indices;
+      if (num_indices != offsets_acc[total_B]) {
+        offsets_acc[total_B] = num_indices;
       }
     }
     for (const auto t : c10::irange(T)) {
       auto num_rows = rows_per_table_acc[t];
-      for (const auto b : c10::irange(B)) {
-        auto indices_start = offsets_acc[t * B + b];
-        auto indices_end = offsets_acc[t * B + b + 1];
+      const int64_t bag_begin = vbe ? B_offsets_data[t] : t * B;
+      const int64_t B_t = vbe ? B_offsets_data[t + 1] - bag_begin : B;
+      for (const auto b : c10::irange(B_t)) {
+        auto indices_start = offsets_acc[bag_begin + b];
+        auto indices_end = offsets_acc[bag_begin + b + 1];
         if (bounds_check_mode == BoundsCheckMode::FATAL) {
           TORCH_CHECK(indices_start >= 0);
           TORCH_CHECK(indices_start <= indices_end);
@@ -121,16 +139,16 @@ void bounds_check_indices_cpu(
                 indices_start,
                 indices_end,
                 num_indices,
-                &offsets_acc[t * B + b],
-                &offsets_acc[t * B + b + 1]);
+                &offsets_acc[bag_begin + b],
+                &offsets_acc[bag_begin + b + 1]);
           }
         } else if (bounds_check_mode == BoundsCheckMode::IGNORE) {
           adjust_offset_cpu(
               indices_start,
               indices_end,
               num_indices,
-              &offsets_acc[t * B + b],
-              &offsets_acc[t * B + b + 1]);
+              &offsets_acc[bag_begin + b],
+              &offsets_acc[bag_begin + b + 1]);
         }
 
         auto L = indices_end - indices_start;
@@ -6,16 +6,21 @@
 
 # pyre-strict
 
+import os
+import tempfile
 import unittest
 from typing import Optional, Tuple
 
 import torch
 
 from fbgemm_gpu.experimental.gemm.triton_gemm.fp8_gemm import (
+    _kernel_matmul_fp8_row,
+    load_fp8_gemm_autotune_cache,
     matmul_fp8_block,
     matmul_fp8_row,
     quantize_fp8_block,
     quantize_fp8_row,
+    save_fp8_gemm_autotune_cache,
 )
 
 
@@ -81,6 +86,28 @@ class TestFp8Matmul(unittest.TestCase):
         _test_matmul_fp8_row((3, 4, 5), torch.device("cuda"), False)
         _test_matmul_fp8_row((3, 4, 5), torch.device("cpu"), False)
 
+    def test_autotune_cache(self) -> None:
+        a = torch.randn(64, 128, dtype=torch.bfloat16, device="cuda")
+        b = torch.randn(256, 128, dtype=torch.bfloat16, device="cuda")
+        a_fp8, a_scale = quantize_fp8_row(a)
+        b_fp8, b_scale = quantize_fp8_row(b)
+        expected_result = matmul_fp8_row(a_fp8, b_fp8, a_scale, b_scale)
+        tuned = dict(_kernel_matmul_fp8_row.cache)
+        self.assertTrue(len(tuned) > 0)
+
+        with tempfile.TemporaryDirectory() as cache_dir:
+            path = os.path.join(cache_dir, "fp8_gemm_autotune.json")
+            save_fp8_gemm_autotune_cache(path)
+            _kernel_matmul_fp8_row.cache.clear()
+            self.assertTrue(load_fp8_gemm_autotune_cache(path) >= len(tuned))
+
+        # Reloaded results pick the same configs without tuning again.
+        self.assertEqual(set(_kernel_matmul_fp8_row.cache.keys()), set(tuned.keys()))
+        for key, config in tuned.items():
+            self.assertEqual(_kernel_matmul_fp8_row.cache[key].kwargs, config.kwargs)
+        result = matmul_fp8_row(a_fp8, b_fp8, a_scale, b_scale)
+        self.assertTrue(torch.equal(result, expected_result))
+
     def test_quantize_fp8_block(self) -> None:
         def _test_quantize_fp8_block(
             shape: Tuple[int, int], block_shape: Tuple[int, int]
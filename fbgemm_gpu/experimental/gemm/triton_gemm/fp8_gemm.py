@@ -5,8 +5,10 @@
 # LICENSE file in the root directory of this source tree.
 
 # pyre-unsafe
+import json
 import logging
-from typing import List, Optional, Tuple
+import os
+from typing import Any, Dict, List, Optional, Tuple
 
 import torch
 import triton  # @manual
@@ -23,6 +25,10 @@ from triton.runtime.jit import reinterpret as tl_reinterpret, TensorWrapper  # @
 
 MAX_FP8 = 448.0
 
+# Path of the on-disk autotuning cache shared by all processes, see
+# load_fp8_gemm_autotune_cache.
+FP8_GEMM_AUTOTUNE_CACHE_ENV = "FBGEMM_FP8_GEMM_AUTOTUNE_CACHE"
+
 logger: logging.Logger = logging.getLogger(__name__)
 
 
@@ -365,6 +371,7 @@ def matmul_fp8_row(
             torch.matmul(a.base.to(torch.bfloat16), b.base.to(torch.bfloat16).T)
             / (a_scale[:, None] * b_scale[None, :])
         ).to(dtype=c.dtype)
+    _maybe_load_fp8_gemm_autotune_cache()
 
     def grid(META):
         return (
@@ -636,6 +643,7 @@ def matmul_fp8_block(
     assert device != torch.device(
         "cpu"
     ), "Blockwise matmul not supported on cpu, please use row-wise instead."
+    _maybe_load_fp8_gemm_autotune_cache()
 
     # noqa: E731:
     def grid(META):
@@ -992,3 +1000,129 @@ def quantize_fp8_block(
     )
 
     return x_fp8, x_scale
+
+
+def _autotuned_kernels() -> Dict[str, Any]:
+    return {
+        "matmul_fp8_row": _kernel_matmul_fp8_row,
+        "matmul_fp8_block": _kernel_matmul_fp8_block,
+        "quantize_fp8_row": _kernel_quantize_fp8_row,
+    }
+
+
+def _config_to_dict(config: Config) -> Dict[str, Any]:
+    return {
+        "kwargs": dict(config.kwargs),
+        "num_warps": config.num_warps,
+        "num_stages": config.num_stages,
+    }
+
+
+def _config_from_dict(kernel: Any, entry: Dict[str, Any]) -> Optional[Config]:
+    # Pruning may rewrite num_stages, so match the candidate configs only on
+    # kwargs and num_warps to recover their pre_hook.
+    for config in kernel.configs:
+        if (
+            dict(config.kwargs) == entry["kwargs"]
+            and config.num_warps == entry["num_warps"]
+        ):
+            return Config(
+                entry["kwargs"],
+                num_warps=entry["num_warps"],
+                num_stages=entry["num_stages"],
+                pre_hook=config.pre_hook,
+            )
+    return None
+
+
+def load_fp8_gemm_autotune_cache(path: Optional[str] = None) -> int:
+    """
+    Seeds the autotuners of the FP8 Triton kernels with persisted results so
+    that shapes tuned before do not pay for autotuning again. Results are keyed
+    by device name and by the autotuning key of each kernel, i.e. the shape
+    bucket from get_matmul_tune and the dtypes of the inputs.
+
+    Args:
+        path (str): Cache file. Defaults to $FBGEMM_FP8_GEMM_AUTOTUNE_CACHE.
+
+    Returns:
+        int: Number of loaded autotuning results.
+    """
+    path = path or os.environ.get(FP8_GEMM_AUTOTUNE_CACHE_ENV)
+    if not path or not os.path.exists(path) or not torch.cuda.is_available():
+        return 0
+    with open(path) as f:
+        cache = json.load(f)
+    device_cache = cache.get(torch.cuda.get_device_name(), {})
+    loaded = 0
+    for name, kernel in _autotuned_kernels().items():
+        for entry in device_cache.get(name, []):
+            config = _config_from_dict(kernel, entry["config"])
+            # Skip results for configs that no longer exist.
+            if config is not None:
+                kernel.cache[tuple(entry["key"])] = config
+                loaded += 1
+    logger.info(f"Loaded {loaded} FP8 GEMM autotuning results from {path}")
+    return loaded
+
+
+def save_fp8_gemm_autotune_cache(path: Optional[str] = None) -> None:
+    """
+    Merges the autotuning results of this process into the on-disk cache.
+
+    Args:
+        path (str): Cache file. Defaults to $FBGEMM_FP8_GEMM_AUTOTUNE_CACHE.
+    """
+    path = path or os.environ.get(FP8_GEMM_AUTOTUNE_CACHE_ENV)
+    assert path, f"No cache path given and {FP8_GEMM_AUTOTUNE_CACHE_ENV} is unset"
+    cache: Dict[str, Any] = {}
+    if os.path.exists(path):
+        with open(path) as f:
+            cache = json.load(f)
+    device_cache = cache.setdefault(torch.cuda.get_device_name(), {})
+    for name, kernel in _autotuned_kernels().items():
+        entries = {tuple(e["key"]): e for e in device_cache.get(name, [])}
+        for key, config in kernel.cache.items():
+            entries[tuple(key)] = {"key": list(key), "config": _config_to_dict(config)}
+        device_cache[name] = list(entries.values())
+    # Write to a temporary file first so readers never see a partial cache.
+    os.makedirs(os.path.dirname(os.path.abspath(path)), exist_ok=True)
+    tmp_path = f"{path}.{os.getpid()}.tmp"
+    with open(tmp_path, "w") as f:
+        json.dump(cache, f, indent=2)
+    os.replace(tmp_path, path)
+
+
+_fp8_gemm_autotune_cache_loaded = False
+
+
+def _maybe_load_fp8_gemm_autotune_cache() -> None:
+    global _fp8_gemm_autotune_cache_loaded
+    if not _fp8_gemm_autotune_cache_loaded:
+        _fp8_gemm_autotune_cache_loaded = True
+        load_fp8_gemm_autotune_cache()
+
+
+def tune_fp8_gemm(shapes: List[Tuple[int, int, int]], path: Optional[str] = None) -> None:
+    """
+    Offline tuning: autotunes the row-wise and block-wise FP8 matmuls for each
+    (M, N, K) in shapes and persists the results with
+    save_fp8_gemm_autotune_cache.
+
+    Args:
+        shapes (List[Tuple[int, int, int]]): Production (M, N, K) shapes.
+        path (str): Cache file. Defaults to $FBGEMM_FP8_GEMM_AUTOTUNE_CACHE.
+    """
+    _maybe_load_fp8_gemm_autotune_cache()
+    for M, N, K in shapes:
+        logger.info(f"Tuning FP8 GEMM for {M=}, {N=}, {K=}")
+        a = torch.randn(M, K, dtype=torch.bfloat16, device="cuda")
+        b = torch.randn(N, K, dtype=torch.bfloat16, device="cuda")
+        a_fp8, a_scale = quantize_fp8_row(a)
+        b_fp8, b_scale = quantize_fp8_row(b)
+        matmul_fp8_row(a_fp8, b_fp8, a_scale, b_scale)
+        a_fp8, a_scale = quantize_fp8_block(a)
+        b_fp8, b_scale = quantize_fp8_block(b)
+        matmul_fp8_block(a_fp8, b_fp8, a_scale, b_scale)
+    torch.cuda.synchronize()
+    save_fp8_gemm_autotune_cache(path)
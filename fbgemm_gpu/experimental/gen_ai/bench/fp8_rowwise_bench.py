@@ -0,0 +1,74 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+import argparse
+from typing import Any, Dict, List
+
+import fbgemm_gpu.experimental.gen_ai  # noqa: F401
+
+import pandas as pd
+
+import torch
+import triton  # @manual=//triton:triton
+
+
+@torch.no_grad()
+def evaluate_impl(M: int, N: int, K: int, use_fast_accum: bool) -> Dict[str, Any]:
+    print(f"Evaluating {M=}, {N=}, {K=}")
+    x = torch.randn(M, K, dtype=torch.bfloat16, device="cuda") * 0.1
+    w = torch.randn(N, K, dtype=torch.bfloat16, device="cuda") * 0.01
+    xq, x_scale = torch.ops.fbgemm.quantize_fp8_per_row(x)
+    wq, w_scale = torch.ops.fbgemm.quantize_fp8_per_row(w)
+
+    ms_bf16: float = triton.testing.do_bench(lambda: torch.matmul(x, w.t()))
+    ms_rowwise: float = triton.testing.do_bench(
+        lambda: torch.ops.fbgemm.f8f8bf16_rowwise(
+            xq, wq, x_scale, w_scale, use_fast_accum=use_fast_accum
+        )
+    )
+    # The FP8 GEMM of a decode shape is bound by reading the weights.
+    tbps = (M * K + N * K + 2 * M * N) / (ms_rowwise * 1e-3) / 1e12
+    print(f"BF16 runtime: {ms_bf16} ms, FP8 rowwise runtime: {ms_rowwise} ms")
+    return {
+        "M": M,
+        "N": N,
+        "K": K,
+        "ms_bf16": ms_bf16,
+        "ms_rowwise": ms_rowwise,
+        "rowwise_tbps": tbps,
+    }
+
+
+def main(args: Any) -> None:
+    benchmark_results: List[Dict[str, Any]] = []
+    # Decode shapes: a handful of tokens against large projection weights.
+    M = [1, 2, 4, 8, 16, 32, 64]
+    NK = [(1280, 8192), (8192, 1024), (7168, 8192), (8192, 3584), (13312, 16384)]
+    for m in M:
+        for n, k in NK:
+            benchmark_results.append(
+                evaluate_impl(m, n, k, use_fast_accum=not args.disable_fast_accum)
+            )
+    if args.export_csv:
+        pd.DataFrame(benchmark_results).to_csv("fp8_rowwise_bench.csv", index=False)
+
+
+def invoke_main() -> None:
+    parser = argparse.ArgumentParser()
+    parser.add_argument(
+        "--export_csv",
+        action="store_true",
+        help="Export results to a CSV file.",
+    )
+    parser.add_argument(
+        "--disable_fast_accum",
+        action="store_true",
+        help="Benchmark the kernels without FP8 fast accumulation.",
+    )
+
+    args = parser.parse_args()
+    main(args)
+
@@ -20,7 +20,33 @@ std::tuple<at::Tensor, at::Tensor, at::Tensor> gqa_attn_splitk(
     const double qk_scale,
     const int64_t num_split_ks,
     const int64_t num_int4_kv_groups,
-    const bool use_tensor_cores);
+    const bool use_tensor_cores,
+    const c10::optional<at::Tensor>& cache_K_scales,
+    const c10::optional<at::Tensor>& cache_V_scales);
+
+std::tuple<at::Tensor, at::Tensor, at::Tensor> gqa_attn_splitk_paged(
+    const at::Tensor& XQ,
+    const at::Tensor& cache_K,
+    const at::Tensor& cache_V,
+    const at::Tensor& seq_positions,
+    const at::Tensor& block_tables,
+    const double qk_scale,
+    const int64_t num_split_ks,
+    const int64_t num_int4_kv_groups,
+    const c10::optional<at::Tensor>& cache_K_scales,
+    const c10::optional<at::Tensor>& cache_V_scales);
+
+std::tuple<at::Tensor, at::Tensor, at::Tensor> gqa_attn_splitk_jagged(
+    const at::Tensor& XQ,
+    const at::Tensor& cache_K,
+    const at::Tensor& cache_V,
+    const at::Tensor& seq_offsets,
+    const int64_t max_seq_len,
+    const double qk_scale,
+    const int64_t num_split_ks,
+    const int64_t num_int4_kv_groups,
+    const c10::optional<at::Tensor>& cache_K_scales,
+    const c10::optional<at::Tensor>& cache_V_scales);
 } // namespace fbgemm_gpu::gen_ai::attention
 
 TORCH_LIBRARY_FRAGMENT(fbgemm, m) {
@@ -33,7 +59,35 @@ TORCH_LIBRARY_FRAGMENT(fbgemm, m) {
       "    float qk_scale, "
       "    int num_split_ks, "
       "    int num_int4_kv_groups=1, "
-      "    bool use_tensor_cores=True"
+      "    bool use_tensor_cores=True, "
+      "    Tensor? cache_K_scales=None, "
+      "    Tensor? cache_V_scales=None"
+      ") -> (Tensor, Tensor, Tensor)");
+  m.def(
+      "gqa_attn_splitk_paged("
+      "    Tensor XQ, "
+      "    Tensor cache_K, "
+      "    Tensor cache_V, "
+      "    Tensor seq_positions, "
+      "    Tensor block_tables, "
+      "    float qk_scale, "
+      "    int num_split_ks, "
+      "    int num_int4_kv_groups=1, "
+      "    Tensor? cache_K_scales=None, "
+      "    Tensor? cache_V_scales=None"
+      ") -> (Tensor, Tensor, Tensor)");
+  m.def(
+      "gqa_attn_splitk_jagged("
+      "    Tensor XQ, "
+      "    Tensor cache_K, "
+      "    Tensor cache_V, "
+      "    Tensor seq_offsets, "
+      "    int max_seq_len, "
+      "    float qk_scale, "
+      "    int num_split_ks, "
+      "    int num_int4_kv_groups=1, "
+      "    Tensor? cache_K_scales=None, "
+      "    Tensor? cache_V_scales=None"
       ") -> (Tensor, Tensor, Tensor)");
 }
 
@@ -43,4 +97,14 @@ TORCH_LIBRARY_IMPL(fbgemm, CUDA, m) {
       torch::dispatch(
           c10::DispatchKey::CUDA,
           TORCH_FN(fbgemm_gpu::gen_ai::attention::gqa_attn_splitk)));
+  m.impl(
+      "gqa_attn_splitk_paged",
+      torch::dispatch(
+          c10::DispatchKey::CUDA,
+          TORCH_FN(fbgemm_gpu::gen_ai::attention::gqa_attn_splitk_paged)));
+  m.impl(
+      "gqa_attn_splitk_jagged",
+      torch::dispatch(
+          c10::DispatchKey::CUDA,
+          TORCH_FN(fbgemm_gpu::gen_ai::attention::gqa_attn_splitk_jagged)));
 }
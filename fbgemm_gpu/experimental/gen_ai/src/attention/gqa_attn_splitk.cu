@@ -453,6 +453,107 @@ DEVICE_INLINE T warpReduceMax(T val, uint32_t warp_mask = FINAL_MASK) {
   return val;
 }
 
+// Addresses the rows (tokens) of the KV cache of each sequence. The cache is
+// either contiguous, with shape [B, MAX_T, 1, row_numel], or paged, with
+// shape [num_pages, page_size, 1, row_numel] and block_tables[b][t /
+// page_size] holding the page of token t of sequence b. The per-token FP8
+// scales, of shape [B, MAX_T, 1] or [num_pages, page_size, 1], are indexed by
+// row_index.
+template <typename kv_t>
+struct KVCacheRows {
+  const kv_t* data;
+  int64_t row_numel;
+  int64_t seq_len;
+  // nullptr for a contiguous cache
+  const int32_t* block_tables;
+  int32_t block_tables_stride;
+  int32_t log2_page_size;
+  // The start row of each sequence, nullptr unless the cache is jagged
+  const int64_t* seq_offsets;
+
+  DEVICE_INLINE int64_t row_index(const int32_t b, const int32_t t) const {
+    if (seq_offsets != nullptr) {
+      return seq_offsets[b] + t;
+    }
+    if (block_tables == nullptr) {
+      return b * seq_len + t;
+    }
+    const int64_t page =
+        block_tables[b * block_tables_stride + (t >> log2_page_size)];
+    return (page << log2_page_size) + (t & ((1 << log2_page_size) - 1));
+  }
+
+  DEVICE_INLINE const kv_t* row(const int32_t b, const int32_t t) const {
+    return data + row_index(b, t) * row_numel;
+  }
+};
+
+template <typename kv_t>
+KVCacheRows<kv_t> make_kv_cache_rows(
+    const at::Tensor& cache,
+    const c10::optional<at::Tensor>& block_tables,
+    const c10::optional<at::Tensor>& seq_offsets) {
+  KVCacheRows<kv_t> rows;
+  rows.data = cache.data_ptr<kv_t>();
+  rows.row_numel = cache.size(3);
+  rows.seq_len = cache.size(1);
+  rows.block_tables = nullptr;
+  rows.block_tables_stride = 0;
+  rows.log2_page_size = 0;
+  if (block_tables.has_value()) {
+    rows.block_tables = block_tables->data_ptr<int32_t>();
+    rows.block_tables_stride = block_tables->size(1);
+    rows.log2_page_size = __builtin_ctz(cache.size(1));
+  }
+  rows.seq_offsets =
+      seq_offsets.has_value() ? seq_offsets->data_ptr<int64_t>() : nullptr;
+  return rows;
+}
+
+// Dequantizes 4 FP8 (e4m3fn) values, packed in the bytes of vs, to BF16. The
+// exponent and mantissa bits are moved into an FP32 at the same position
+// (which also maps FP8 subnormals to FP32 subnormals), and the difference of
+// the exponent biases (127 - 7) is folded into the scale.
+DEVICE_INLINE bfx4 dequantize_packed_fp8(uint32_t vs, const float scale) {
+  // 2^120
+  constexpr float kFP8ExponentBiasAdjust = 1.329227995784916e+36f;
+  float vals[4];
+#pragma unroll
+  for (int i = 0; i < 4; i++) {
+    const uint32_t v = (vs >> (8 * i)) & 0xFF;
+    vals[i] = __uint_as_float(((v & 0x80) << 24) | ((v & 0x7F) << 20)) *
+        kFP8ExponentBiasAdjust;
+  }
+  bfx4 result;
+  result.vals[0] = __floats2bfloat162_rn(vals[0] * scale, vals[1] * scale);
+  result.vals[1] = __floats2bfloat162_rn(vals[2] * scale, vals[3] * scale);
+  return result;
+}
+
+// Loads elements [4 * threadIdx.x, 4 * threadIdx.x + 4) of KV row t of
+// sequence b as BF16. FP8 rows are dequantized with their scale in registers
+template <typename kv_t>
+DEVICE_INLINE bfx4 load_kv_bfx4(
+    const KVCacheRows<kv_t>& rows,
+    const float* scales,
+    const int32_t b,
+    const int32_t t) {
+  constexpr bool USE_FP8 = std::is_same<kv_t, at::Float8_e4m3fn>::value;
+  bfx4 result;
+  if (USE_FP8) {
+    const auto row_index = rows.row_index(b, t);
+    const auto vs = *(
+        reinterpret_cast<const uint32_t*>(rows.data + row_index * D_H) +
+        threadIdx.x);
+    result = dequantize_packed_fp8(vs, scales[row_index]);
+  } else {
+    *reinterpret_cast<uint2*>(&result) =
+        *(reinterpret_cast<const uint2*>(rows.row(b, t)) + threadIdx.x);
+  }
+  return result;
+}
+
+
 template <
     typename kv_t,
     int KVQuantNumGroups = 1,
@@ -1182,10 +1283,12 @@ __global__ void gqa_attn_splitk_reduce_wmma_kernel(
   O[b][0][h][d] = acc / l_sum;
 }
 
+template <typename kv_t>
 __global__ void gqa_attn_splitk_qk_kernel(
     const at::PackedTensorAccessor32<at::BFloat16, 4, at::RestrictPtrTraits> XQ,
-    const at::PackedTensorAccessor64<at::BFloat16, 4, at::RestrictPtrTraits>
-        cache_K,
+    const KVCacheRows<kv_t> cache_K,
+    // Only used for FP8 K
+    const float* cache_K_scales,
     const at::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits>
         seq_positions,
     at::PackedTensorAccessor32<float, 3, at::RestrictPtrTraits> QK_out) {
@@ -1206,8 +1309,6 @@ __global__ void gqa_attn_splitk_qk_kernel(
   // Need D_H == 128
   auto* q_ = &(XQ[b][0][h][0]);
 
-  // assume cache_K/cache_V is contiguous
-  auto* cache_K_base = &cache_K[b][0][0][0];
 
   // Load Q into registers in all warps.
   // Each thread handles 4 D dimensions
@@ -1237,10 +1338,7 @@ __global__ void gqa_attn_splitk_qk_kernel(
 #pragma unroll kTimeUnroll
     for (auto ttt = 0; ttt < kTimeUnroll; ++ttt) {
       int32_t t = tt + ttt;
-      auto* k_ = cache_K_base + t * D_H; // &(cache_K[b][t][0][0]);
-      // bfx4 k_thread;
-      *reinterpret_cast<uint2*>(&k_loads[ttt]) =
-          *(reinterpret_cast<const uint2*>(k_) + threadIdx.x);
+      k_loads[ttt] = load_kv_bfx4(cache_K, cache_K_scales, b, t);
     }
 #pragma unroll kTimeUnroll
     for (auto ttt = 0; ttt < kTimeUnroll; ++ttt) {
@@ -1263,10 +1361,7 @@ __global__ void gqa_attn_splitk_qk_kernel(
 #pragma unroll kTimeUnroll1
     for (auto ttt = 0; ttt < kTimeUnroll1; ++ttt) {
       int32_t t = tt + ttt;
-      auto* k_ = cache_K_base + t * D_H; // &(cache_K[b][t][0][0]);
-      // bfx4 k_thread;
-      *reinterpret_cast<uint2*>(&k_loads[ttt]) =
-          *(reinterpret_cast<const uint2*>(k_) + threadIdx.x);
+      k_loads[ttt] = load_kv_bfx4(cache_K, cache_K_scales, b, t);
     }
 #pragma unroll kTimeUnroll1
     for (auto ttt = 0; ttt < kTimeUnroll1; ++ttt) {
@@ -1287,7 +1382,7 @@ __global__ void gqa_attn_splitk_qk_kernel(
 template <int KVQuantNumGroups = 1>
 __global__ void gqa_attn_splitk_qk_int4_kernel(
     const at::PackedTensorAccessor32<at::BFloat16, 4, at::RestrictPtrTraits> XQ,
-    const at::PackedTensorAccessor64<uint8_t, 4, at::RestrictPtrTraits> cache_K,
+    const KVCacheRows<uint8_t> cache_K,
     const at::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits>
         seq_positions,
     at::PackedTensorAccessor32<float, 3, at::RestrictPtrTraits> QK_out) {
@@ -1308,8 +1403,6 @@ __global__ void gqa_attn_splitk_qk_int4_kernel(
   // Need D_H == 128
   auto* q_ = &(XQ[b][0][h][0]);
 
-  // assume cache_K/cache_V is contiguous
-  auto* cache_K_base = &cache_K[b][0][0][0];
 
   int32_t int4_qparam_offset = 4;
   int32_t qparam_offset = 0;
@@ -1319,7 +1412,6 @@ __global__ void gqa_attn_splitk_qk_int4_kernel(
     int32_t group_idx = threadIdx.x * 2 / group_size;
     qparam_offset = 4 * group_idx;
   }
-  int32_t D_H_bytes = D_H / 2 + int4_qparam_offset;
   // Load Q into registers in all warps.
   // Each thread handles 4 D dimensions
   bfx4 q_thread;
@@ -1349,7 +1441,7 @@ __global__ void gqa_attn_splitk_qk_int4_kernel(
 #pragma unroll kTimeUnroll
     for (auto ttt = 0; ttt < kTimeUnroll; ++ttt) {
       int32_t t = tt + ttt;
-      auto* k_ = cache_K_base + t * D_H; // &(cache_K[b][t][0][0]);
+      const auto* k_ = cache_K.row(b, t);
       // bfx4 k_thread;
       *reinterpret_cast<uint16_t*>(&k_qvals[ttt]) =
           *(reinterpret_cast<const uint16_t*>(
@@ -1379,7 +1471,7 @@ __global__ void gqa_attn_splitk_qk_int4_kernel(
 #pragma unroll kTimeUnroll1
     for (auto ttt = 0; ttt < kTimeUnroll1; ++ttt) {
       int32_t t = tt + ttt;
-      auto* k_ = cache_K_base + t * D_H_bytes; // &(cache_K[b][t][0][0]);
+      const auto* k_ = cache_K.row(b, t);
       // bfx4 k_thread;
       *reinterpret_cast<uint16_t*>(&k_qvals[ttt]) =
           *(reinterpret_cast<const uint16_t*>(
@@ -1481,9 +1573,12 @@ __global__ void gqa_attn_splitk_attn_kernel(
 }
 
 // TODO: can also fuse RoPe into this kernel. Doesn't seem worth it.
+template <typename kv_t>
 __global__ void gqa_attn_splitk_v_kernel(
     at::PackedTensorAccessor32<float, 3, at::RestrictPtrTraits> attn_out,
-    at::PackedTensorAccessor64<at::BFloat16, 4, at::RestrictPtrTraits> cache_V,
+    const KVCacheRows<kv_t> cache_V,
+    // Only used for FP8 V
+    const float* cache_V_scales,
     at::PackedTensorAccessor32<float, 5, at::RestrictPtrTraits> O,
     at::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits>
         seq_positions) {
@@ -1505,9 +1600,6 @@ __global__ void gqa_attn_splitk_v_kernel(
   // Need D_H == 128
   // auto* q_ = &(XQ[b][0][h][0]);
 
-  // assume cache_K/cache_V is contiguous
-  // auto* cache_K_base = &cache_K[b][0][0][0];
-  auto* cache_V_base = &cache_V[b][0][0][0];
 
   constexpr int32_t kTimeUnroll = 4;
 
@@ -1533,10 +1625,7 @@ __global__ void gqa_attn_splitk_v_kernel(
 #pragma unroll kTimeUnroll
     for (auto ttt = 0; ttt < kTimeUnroll; ++ttt) {
       int32_t t = tt + ttt;
-      auto* v_ = cache_V_base + t * D_H; // &(cache_V[b][t][0][0]);
-      //   bfx4 v_thread;
-      *reinterpret_cast<uint2*>(&k_loads[ttt]) =
-          *(reinterpret_cast<const uint2*>(v_) + threadIdx.x);
+      k_loads[ttt] = load_kv_bfx4(cache_V, cache_V_scales, b, t);
       ps[ttt] = attn_out[b][h][t];
     }
 
@@ -1552,10 +1641,7 @@ __global__ void gqa_attn_splitk_v_kernel(
 #pragma unroll kTimeUnroll1
     for (auto ttt = 0; ttt < kTimeUnroll1; ++ttt) {
       int32_t t = tt + ttt;
-      auto* v_ = cache_V_base + t * D_H; // &(cache_V[b][t][0][0]);
-      //   bfx4 v_thread;
-      *reinterpret_cast<uint2*>(&k_loads[ttt]) =
-          *(reinterpret_cast<const uint2*>(v_) + threadIdx.x);
+      k_loads[ttt] = load_kv_bfx4(cache_V, cache_V_scales, b, t);
       ps[ttt] = attn_out[b][h][t];
     }
 
@@ -1588,7 +1674,7 @@ __global__ void gqa_attn_splitk_v_kernel(
 template <int KVQuantNumGroups = 1>
 __global__ void gqa_attn_splitk_v_int4_kernel(
     at::PackedTensorAccessor32<float, 3, at::RestrictPtrTraits> attn_out,
-    at::PackedTensorAccessor64<uint8_t, 4, at::RestrictPtrTraits> cache_V,
+    const KVCacheRows<uint8_t> cache_V,
     at::PackedTensorAccessor32<float, 5, at::RestrictPtrTraits> O,
     at::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits>
         seq_positions) {
@@ -1610,9 +1696,6 @@ __global__ void gqa_attn_splitk_v_int4_kernel(
   // Need D_H == 128
   // auto* q_ = &(XQ[b][0][h][0]);
 
-  // assume cache_K/cache_V is contiguous
-  // auto* cache_K_base = &cache_K[b][0][0][0];
-  auto* cache_V_base = &cache_V[b][0][0][0];
   int32_t int4_qparam_offset = 4;
   int32_t qparam_idx = 0;
   if (KVQuantNumGroups > 1) {
@@ -1621,7 +1704,6 @@ __global__ void gqa_attn_splitk_v_int4_kernel(
     int32_t group_idx = threadIdx.x * 2 / group_size;
     qparam_idx = 4 * group_idx;
   }
-  int32_t D_H_bytes = D_H / 2 + int4_qparam_offset;
   constexpr int32_t kTimeUnroll = 4;
 
   // Split T across warps in a block
@@ -1647,13 +1729,13 @@ __global__ void gqa_attn_splitk_v_int4_kernel(
 #pragma unroll kTimeUnroll
     for (auto ttt = 0; ttt < kTimeUnroll; ++ttt) {
       int32_t t = tt + ttt;
-      auto* v_ = cache_V_base + t * D_H_bytes; // &(cache_V[b][t][0][0]);
+      const auto* v_ = cache_V.row(b, t);
       //   bfx4 v_thread;
       *reinterpret_cast<uint16_t*>(&k_qvals[ttt]) =
           *(reinterpret_cast<const uint16_t*>(
               &v_[threadIdx.x * 2 + int4_qparam_offset]));
       *reinterpret_cast<uint*>(&k_scales[ttt]) =
-          *(reinterpret_cast<uint*>(&v_[qparam_idx]));
+          *(reinterpret_cast<const uint*>(&v_[qparam_idx]));
       ps[ttt] = attn_out[b][h][t];
     }
 
@@ -1670,13 +1752,13 @@ __global__ void gqa_attn_splitk_v_int4_kernel(
 #pragma unroll kTimeUnroll1
     for (auto ttt = 0; ttt < kTimeUnroll1; ++ttt) {
       int32_t t = tt + ttt;
-      auto* v_ = cache_V_base + t * D_H_bytes; // &(cache_V[b][t][0][0]);
+      const auto* v_ = cache_V.row(b, t);
       //   bfx4 v_thread;
       *reinterpret_cast<uint16_t*>(&k_qvals[ttt]) =
           *(reinterpret_cast<const uint16_t*>(
               &v_[threadIdx.x * 2 + int4_qparam_offset]));
       *reinterpret_cast<uint*>(&k_scales[ttt]) =
-          *(reinterpret_cast<uint*>(&v_[qparam_idx]));
+          *(reinterpret_cast<const uint*>(&v_[qparam_idx]));
       ps[ttt] = attn_out[b][h][t];
     }
 
@@ -1831,12 +1913,25 @@ std::tuple<at::Tensor, at::Tensor, at::Tensor> gqa_attn_splitk_wmma_impl(
 
 std::tuple<at::Tensor, at::Tensor, at::Tensor> gqa_attn_splitk_impl(
     const at::Tensor& XQ, // [B, 1, H, D]
-    const at::Tensor& cache_K, // [B, MAX_T, 1, D]
-    const at::Tensor& cache_V, // [B, MAX_T, 1, D]
+    // [B, MAX_T, 1, D], [num_pages, page_size, 1, D] if paged, or
+    // [1, total_T, 1, D] if jagged
+    const at::Tensor& cache_K,
+    // Same layout as cache_K
+    const at::Tensor& cache_V,
     const at::Tensor& seq_positions, // [B]
     const double qk_scale,
     const int64_t split_k,
-    const c10::optional<int64_t>& num_groups) {
+    const c10::optional<int64_t>& num_groups,
+    // [B, max_pages_per_seq] if paged
+    const c10::optional<at::Tensor>& block_tables = c10::nullopt,
+    // The per-token scales of FP8 K/V: [B, MAX_T, 1], or
+    // [num_pages, page_size, 1] if paged
+    const c10::optional<at::Tensor>& cache_K_scales = c10::nullopt,
+    const c10::optional<at::Tensor>& cache_V_scales = c10::nullopt,
+    // [B + 1] int64 if jagged
+    const c10::optional<at::Tensor>& seq_offsets = c10::nullopt,
+    // The longest sequence of a jagged cache
+    const c10::optional<int64_t>& max_seq_len = c10::nullopt) {
   at::OptionalDeviceGuard guard(XQ.device());
   TORCH_CHECK(XQ.is_cuda());
   TORCH_CHECK(cache_K.is_cuda());
@@ -1846,25 +1941,74 @@ std::tuple<at::Tensor, at::Tensor, at::Tensor> gqa_attn_splitk_impl(
 
   TORCH_CHECK(seq_positions.is_cuda());
 
-  TORCH_CHECK(cache_K.size(1) <= MAX_T);
+  // The longest context that the KV cache can hold
+  int64_t max_context_len = cache_K.size(1);
+  if (block_tables.has_value()) {
+    const auto page_size = cache_K.size(1);
+    TORCH_CHECK(block_tables->is_cuda());
+    TORCH_CHECK(block_tables->is_contiguous());
+    TORCH_CHECK(block_tables->dtype() == at::kInt);
+    TORCH_CHECK(
+        block_tables->dim() == 2 && block_tables->size(0) == XQ.size(0),
+        "block_tables should have shape [B, max_pages_per_seq]");
+    TORCH_CHECK(
+        page_size > 0 && (page_size & (page_size - 1)) == 0,
+        "The KV cache page size should be a power of 2, got ",
+        page_size);
+    TORCH_CHECK(cache_V.sizes() == cache_K.sizes());
+    max_context_len = block_tables->size(1) * page_size;
+  }
+  if (seq_offsets.has_value()) {
+    TORCH_CHECK(!block_tables.has_value());
+    TORCH_CHECK(seq_offsets->is_cuda());
+    TORCH_CHECK(seq_offsets->is_contiguous());
+    TORCH_CHECK(seq_offsets->dtype() == at::kLong);
+    TORCH_CHECK(
+        seq_offsets->dim() == 1 && seq_offsets->size(0) == XQ.size(0) + 1,
+        "seq_offsets should have shape [B + 1]");
+    TORCH_CHECK(cache_K.size(0) == 1 && cache_V.sizes() == cache_K.sizes());
+    TORCH_CHECK(max_seq_len.has_value() && max_seq_len.value() >= 0);
+    max_context_len = max_seq_len.value();
+  }
+  TORCH_CHECK(max_context_len <= MAX_T);
   TORCH_CHECK(
       cache_K.size(2) == 1,
       "gqa_attn_splitk only supports for number of K heads 1");
   TORCH_CHECK(
       cache_V.size(2) == 1,
       "gqa_attn_splitk only supports for number of V heads 1");
-  if (cache_K.dtype() == at::kBFloat16) {
+  TORCH_CHECK(cache_V.dtype() == cache_K.dtype());
+  const bool use_fp8 = cache_K.dtype() == at::kFloat8_e4m3fn;
+  if (cache_K.dtype() == at::kBFloat16 || use_fp8) {
     TORCH_CHECK(cache_K.size(3) == D_H);
   } else {
     auto num_groups_ = num_groups ? num_groups.value() : 1;
     auto qparam_offset = 4 * num_groups_;
     TORCH_CHECK(cache_K.size(3) == D_H / 2 + qparam_offset);
   }
+  if (use_fp8) {
+    for (const auto& scales : {cache_K_scales, cache_V_scales}) {
+      TORCH_CHECK(
+          scales.has_value(),
+          "gqa_attn_splitk needs the per-token scales of the FP8 KV cache");
+      TORCH_CHECK(scales->is_cuda());
+      TORCH_CHECK(scales->is_contiguous());
+      TORCH_CHECK(scales->dtype() == at::kFloat);
+      TORCH_CHECK(
+          scales->sizes() ==
+              at::IntArrayRef({cache_K.size(0), cache_K.size(1), 1}),
+          "The FP8 KV cache scales should have shape [",
+          cache_K.size(0),
+          ", ",
+          cache_K.size(1),
+          ", 1]");
+    }
+  }
 
   auto B = XQ.size(0);
   auto H = XQ.size(2);
   auto QK_out =
-      at::empty({B, H, cache_K.size(1)}, XQ.options().dtype(at::kFloat));
+      at::empty({B, H, max_context_len}, XQ.options().dtype(at::kFloat));
 
   if (B == 0) {
     return {at::empty_like(XQ), at::empty_like(QK_out), QK_out};
@@ -1875,13 +2019,28 @@ std::tuple<at::Tensor, at::Tensor, at::Tensor> gqa_attn_splitk_impl(
     dim3 threads(kThreadsPerWarp, kWarpsPerBlock);
 
     if (cache_K.dtype() == at::kBFloat16) {
-      gqa_attn_splitk_qk_kernel<<<
+      gqa_attn_splitk_qk_kernel<at::BFloat16><<<
           blocks,
           threads,
           0,
           at::cuda::getCurrentCUDAStream()>>>(
           XQ.packed_accessor32<at::BFloat16, 4, at::RestrictPtrTraits>(),
-          cache_K.packed_accessor64<at::BFloat16, 4, at::RestrictPtrTraits>(),
+          make_kv_cache_rows<at::BFloat16>(
+              cache_K, block_tables, seq_offsets),
+          nullptr,
+          seq_positions.packed_accessor32<int32_t, 1, at::RestrictPtrTraits>(),
+          QK_out.packed_accessor32<float, 3, at::RestrictPtrTraits>());
+      C10_CUDA_KERNEL_LAUNCH_CHECK();
+    } else if (use_fp8) {
+      gqa_attn_splitk_qk_kernel<at::Float8_e4m3fn><<<
+          blocks,
+          threads,
+          0,
+          at::cuda::getCurrentCUDAStream()>>>(
+          XQ.packed_accessor32<at::BFloat16, 4, at::RestrictPtrTraits>(),
+          make_kv_cache_rows<at::Float8_e4m3fn>(
+              cache_K, block_tables, seq_offsets),
+          cache_K_scales->data_ptr<float>(),
           seq_positions.packed_accessor32<int32_t, 1, at::RestrictPtrTraits>(),
           QK_out.packed_accessor32<float, 3, at::RestrictPtrTraits>());
       C10_CUDA_KERNEL_LAUNCH_CHECK();
@@ -1890,7 +2049,8 @@ std::tuple<at::Tensor, at::Tensor, at::Tensor> gqa_attn_splitk_impl(
   gqa_attn_splitk_qk_int4_kernel<NUM_GROUPS>                              \
       <<<blocks, threads, 0, at::cuda::getCurrentCUDAStream()>>>(         \
           XQ.packed_accessor32<at::BFloat16, 4, at::RestrictPtrTraits>(), \
-          cache_K.packed_accessor64<uint8_t, 4, at::RestrictPtrTraits>(), \
+          make_kv_cache_rows<uint8_t>(                                    \
+              cache_K, block_tables, seq_offsets),                        \
           seq_positions                                                   \
               .packed_accessor32<int32_t, 1, at::RestrictPtrTraits>(),    \
           QK_out.packed_accessor32<float, 3, at::RestrictPtrTraits>());
@@ -1939,21 +2099,31 @@ std::tuple<at::Tensor, at::Tensor, at::Tensor> gqa_attn_splitk_impl(
     int32_t smem = smem_output;
     const bool set_max_dynamic_smem = smem > SMEM_ADJUST_THRESHOLD;
 
-    if (cache_K.dtype() == at::kBFloat16) {
-      if (set_max_dynamic_smem) {
-        set_gpu_max_dynamic_shared_memory(
-            gqa_attn_splitk_v_kernel, smem, device);
+    if (cache_K.dtype() == at::kBFloat16 || use_fp8) {
+#define CALL_MQA_ATTN_SPLITKV_KERNEL(CACHE_TYPE, SCALES)                  \
+  if (set_max_dynamic_smem) {                                             \
+    set_gpu_max_dynamic_shared_memory(                                    \
+        gqa_attn_splitk_v_kernel<CACHE_TYPE>, smem, device);              \
+  }                                                                       \
+  gqa_attn_splitk_v_kernel<CACHE_TYPE>                                    \
+      <<<blocks, threads, smem, at::cuda::getCurrentCUDAStream()>>>(      \
+          attn_out.packed_accessor32<float, 3, at::RestrictPtrTraits>(),  \
+          make_kv_cache_rows<CACHE_TYPE>(                                 \
+              cache_V, block_tables, seq_offsets),                        \
+          SCALES,                                                         \
+          O.packed_accessor32<float, 5, at::RestrictPtrTraits>(),         \
+          seq_positions                                                   \
+              .packed_accessor32<int32_t, 1, at::RestrictPtrTraits>());
+
+      if (use_fp8) {
+        CALL_MQA_ATTN_SPLITKV_KERNEL(
+            at::Float8_e4m3fn, cache_V_scales->data_ptr<float>());
+      } else {
+        CALL_MQA_ATTN_SPLITKV_KERNEL(at::BFloat16, nullptr);
       }
-      gqa_attn_splitk_v_kernel<<<
-          blocks,
-          threads,
-          smem,
-          at::cuda::getCurrentCUDAStream()>>>(
-          attn_out.packed_accessor32<float, 3, at::RestrictPtrTraits>(),
-          cache_V.packed_accessor64<at::BFloat16, 4, at::RestrictPtrTraits>(),
-          O.packed_accessor32<float, 5, at::RestrictPtrTraits>(),
-          seq_positions.packed_accessor32<int32_t, 1, at::RestrictPtrTraits>());
       C10_CUDA_KERNEL_LAUNCH_CHECK();
+
+#undef CALL_MQA_ATTN_SPLITKV_KERNEL
     } else {
 #define CALL_MQA_ATTN_SPLITKV_INT4_GROUPWISE_KERNEL(NUM_GROUPS, ...)      \
   if (set_max_dynamic_smem) {                                             \
@@ -1963,7 +2133,8 @@ std::tuple<at::Tensor, at::Tensor, at::Tensor> gqa_attn_splitk_impl(
   gqa_attn_splitk_v_int4_kernel<NUM_GROUPS>                               \
       <<<blocks, threads, smem, at::cuda::getCurrentCUDAStream()>>>(      \
           attn_out.packed_accessor32<float, 3, at::RestrictPtrTraits>(),  \
-          cache_V.packed_accessor64<uint8_t, 4, at::RestrictPtrTraits>(), \
+          make_kv_cache_rows<uint8_t>(                                    \
+              cache_V, block_tables, seq_offsets),                        \
           O.packed_accessor32<float, 5, at::RestrictPtrTraits>(),         \
           seq_positions                                                   \
               .packed_accessor32<int32_t, 1, at::RestrictPtrTraits>());
@@ -1982,10 +2153,10 @@ std::tuple<at::Tensor, at::Tensor, at::Tensor> gqa_attn_splitk_impl(
 
 /// @ingroup experimental-gen-ai-attention
 ///
-/// @brief Decoding Grouped Query Attention Split-K w/ BF16/INT4 KV
+/// @brief Decoding Grouped Query Attention Split-K w/ BF16/FP8/INT4 KV
 ///
 /// The CUDA implementation of decoding Grouped Query Attention (GQA)
-/// that supports BF16 and INT4 KV cache and BF16 input query.  It
+/// that supports BF16, FP8 and INT4 KV cache and BF16 input query.  It
 /// currently only supports the max context length of 16384, the fixed
 /// head dimension of 128, and only one KV cache head.  It supports an
 /// arbitrary number of query heads.
@@ -1995,7 +2166,10 @@ std::tuple<at::Tensor, at::Tensor, at::Tensor> gqa_attn_splitk_impl(
 ///           to 128)
 /// @param cache_K K cache; shape = (B, MAX_T, H_KV, D), where MAX_T =
 ///                max context length (fixed to 16384), and H_KV = num
-///                KV cache heads (fixed to 1)
+///                KV cache heads (fixed to 1).  The cache is BF16, FP8
+///                (e4m3fn, with per-token scales), or INT4 (uint8, with
+///                the group-wise scales and shifts at the start of each
+///                row)
 /// @param cache_V V cache; shape = (B, MAX_T, H_KV, D)
 /// @param seq_positions Sequence position (contains the actual
 ///                      length of each token); shape = (B)
@@ -2009,7 +2183,13 @@ std::tuple<at::Tensor, at::Tensor, at::Tensor> gqa_attn_splitk_impl(
 ///                           quantization)
 ///
 /// @param use_tensor_cores Whether to use tensor core wmma instructions
-///                           for fast implementations
+///                           for fast implementations (not supported for
+///                           FP8 KV, which always runs on CUDA cores)
+/// @param cache_K_scales The FP32 dequantization scales of the FP8 K
+///                       cache (K = cache_K * cache_K_scales); shape =
+///                       (B, MAX_T, H_KV)
+/// @param cache_V_scales The FP32 dequantization scales of the FP8 V
+///                       cache; shape = (B, MAX_T, H_KV)
 ///
 /// @return    A tuple of the combined split-K output, the
 ///            non-combined split-K output, and the split-K metadata
@@ -2022,8 +2202,11 @@ std::tuple<at::Tensor, at::Tensor, at::Tensor> gqa_attn_splitk(
     const double qk_scale,
     const int64_t num_split_ks,
     const int64_t num_int4_kv_groups,
-    const bool use_tensor_cores) {
-  if (use_tensor_cores) {
+    const bool use_tensor_cores,
+    const c10::optional<at::Tensor>& cache_K_scales,
+    const c10::optional<at::Tensor>& cache_V_scales) {
+  // The FP8 KV cache is only dequantized by the CUDA core kernels
+  if (use_tensor_cores && cache_K.dtype() != at::kFloat8_e4m3fn) {
     const auto dprops = at::cuda::getCurrentDeviceProperties();
 #ifdef USE_ROCM
     TORCH_CHECK(
@@ -2053,7 +2236,133 @@ std::tuple<at::Tensor, at::Tensor, at::Tensor> gqa_attn_splitk(
       seq_positions,
       qk_scale,
       num_split_ks,
-      num_int4_kv_groups);
+      num_int4_kv_groups,
+      /*block_tables=*/c10::nullopt,
+      cache_K_scales,
+      cache_V_scales);
+}
+
+/// @ingroup experimental-gen-ai-attention
+///
+/// @brief Decoding Grouped Query Attention Split-K w/ paged BF16/FP8/INT4 KV
+///
+/// The same as `gqa_attn_splitk` (with `use_tensor_cores=False`), but the
+/// KV cache is a pool of fixed-size pages that are shared by all sequences,
+/// so that each sequence only holds the pages of its actual length instead
+/// of a slot of the max context length.  Token `t` of sequence `b` is stored
+/// at row `t % PAGE_SIZE` of page `block_tables[b][t / PAGE_SIZE]`.
+///
+/// @param XQ Input query; shape = (B, 1, H_Q, D)
+/// @param cache_K Paged K cache; shape = (NUM_PAGES, PAGE_SIZE, H_KV, D),
+///                where PAGE_SIZE is a power of 2 and H_KV = num KV cache
+///                heads (fixed to 1)
+/// @param cache_V Paged V cache; shape = (NUM_PAGES, PAGE_SIZE, H_KV, D)
+/// @param seq_positions Sequence position (contains the actual
+///                      length of each token); shape = (B)
+/// @param block_tables The KV cache pages of each sequence; shape =
+///                     (B, MAX_PAGES_PER_SEQ), int32.  MAX_PAGES_PER_SEQ *
+///                     PAGE_SIZE is at most 16384, and the entries past the
+///                     length of a sequence are not read
+/// @param qk_scale The scale that is applied after QK^T
+/// @param num_split_ks The number of split Ks
+/// @param num_int4_kv_groups The number of groups for group-wise INT4
+///                           quantization for each KV token
+/// @param cache_K_scales The FP32 scales of the FP8 K cache; shape =
+///                       (NUM_PAGES, PAGE_SIZE, H_KV)
+/// @param cache_V_scales The FP32 scales of the FP8 V cache; shape =
+///                       (NUM_PAGES, PAGE_SIZE, H_KV)
+///
+/// @return    A tuple of the combined split-K output, softmax(QK^T), and
+///            QK^T
+std::tuple<at::Tensor, at::Tensor, at::Tensor> gqa_attn_splitk_paged(
+    const at::Tensor& XQ,
+    const at::Tensor& cache_K,
+    const at::Tensor& cache_V,
+    const at::Tensor& seq_positions,
+    const at::Tensor& block_tables,
+    const double qk_scale,
+    const int64_t num_split_ks,
+    const int64_t num_int4_kv_groups,
+    const c10::optional<at::Tensor>& cache_K_scales,
+    const c10::optional<at::Tensor>& cache_V_scales) {
+  return gqa_attn_splitk_impl(
+      XQ,
+      cache_K,
+      cache_V,
+      seq_positions,
+      qk_scale,
+      num_split_ks,
+      num_int4_kv_groups,
+      block_tables,
+      cache_K_scales,
+      cache_V_scales);
+}
+
+/// @ingroup experimental-gen-ai-attention
+///
+/// @brief Decoding Grouped Query Attention Split-K w/ jagged BF16/FP8/INT4 KV
+///
+/// The same as `gqa_attn_splitk` (with `use_tensor_cores=False`), but the
+/// KV cache of the batch is jagged: the rows of all sequences are packed
+/// back to back without padding, and sequence `b` owns rows
+/// `[seq_offsets[b], seq_offsets[b + 1])`.  The split-K partitions are cut
+/// from the actual length of each sequence, so no work is spent on padding.
+///
+/// @param XQ Input query; shape = (B, 1, H_Q, D)
+/// @param cache_K Jagged K cache; shape = (TOTAL_T, H_KV, D), where H_KV =
+///                num KV cache heads (fixed to 1)
+/// @param cache_V Jagged V cache; shape = (TOTAL_T, H_KV, D)
+/// @param seq_offsets The start row of each sequence in the KV cache, with
+///                    `seq_offsets[B] = TOTAL_T`; shape = (B + 1), int64
+/// @param max_seq_len The length of the longest sequence (at most 16384),
+///                    which sizes the softmax(QK^T) and QK^T outputs
+/// @param qk_scale The scale that is applied after QK^T
+/// @param num_split_ks The number of split Ks
+/// @param num_int4_kv_groups The number of groups for group-wise INT4
+///                           quantization for each KV token
+/// @param cache_K_scales The FP32 scales of the FP8 K cache; shape =
+///                       (TOTAL_T, H_KV)
+/// @param cache_V_scales The FP32 scales of the FP8 V cache; shape =
+///                       (TOTAL_T, H_KV)
+///
+/// @return    A tuple of the combined split-K output, softmax(QK^T), and
+///            QK^T, where the last two have shape (B, H_Q, max_seq_len)
+std::tuple<at::Tensor, at::Tensor, at::Tensor> gqa_attn_splitk_jagged(
+    const at::Tensor& XQ,
+    const at::Tensor& cache_K,
+    const at::Tensor& cache_V,
+    const at::Tensor& seq_offsets,
+    const int64_t max_seq_len,
+    const double qk_scale,
+    const int64_t num_split_ks,
+    const int64_t num_int4_kv_groups,
+    const c10::optional<at::Tensor>& cache_K_scales,
+    const c10::optional<at::Tensor>& cache_V_scales) {
+  TORCH_CHECK(
+      cache_K.dim() == 3 && cache_V.dim() == 3,
+      "The jagged KV cache should have shape [TOTAL_T, H_KV, D]");
+  TORCH_CHECK(seq_offsets.dtype() == at::kLong);
+  const auto unsqueeze_scales = [](const c10::optional<at::Tensor>& scales) {
+    return scales.has_value()
+        ? c10::optional<at::Tensor>(scales->unsqueeze(0))
+        : c10::nullopt;
+  };
+  // The kernels read the sequence lengths from seq_positions
+  const auto seq_positions =
+      (seq_offsets.slice(0, 1) - seq_offsets.slice(0, 0, -1) - 1).to(at::kInt);
+  return gqa_attn_splitk_impl(
+      XQ,
+      cache_K.unsqueeze(0),
+      cache_V.unsqueeze(0),
+      seq_positions,
+      qk_scale,
+      num_split_ks,
+      num_int4_kv_groups,
+      /*block_tables=*/c10::nullopt,
+      unsqueeze_scales(cache_K_scales),
+      unsqueeze_scales(cache_V_scales),
+      seq_offsets,
+      max_seq_len);
 }
 
 } // namespace fbgemm_gpu::gen_ai::attention
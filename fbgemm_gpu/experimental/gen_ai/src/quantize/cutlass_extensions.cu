@@ -50,6 +50,7 @@
 
 #include <cute/atom/mma_atom.hpp>
 #include <cutlass/gemm/dispatch_policy.hpp>
+#include <cutlass/gemm/group_array_problem_shape.hpp>
 #include <cutlass/gemm/kernel/gemm_universal.hpp>
 #include <cutlass/util/packed_stride.hpp>
 
@@ -1007,6 +1008,8 @@ template <
     bool PONG,
     bool FAST_ACCUM,
     bool USE_BIAS,
+    bool USE_RESIDUAL,
+    bool STREAM_K,
     typename INPUT_DTYPE,
     typename BIAS_DTYPE>
 at::Tensor f8f8bf16_rowwise_impl(
@@ -1014,7 +1017,8 @@ at::Tensor f8f8bf16_rowwise_impl(
     at::Tensor WQ, // FP8
     at::Tensor x_scale,
     at::Tensor w_scale,
-    c10::optional<at::Tensor> bias) {
+    c10::optional<at::Tensor> bias,
+    c10::optional<at::Tensor> residual) {
   int M = XQ.size(0);
   int N = WQ.size(0);
   int K = XQ.size(1);
@@ -1091,12 +1095,16 @@ at::Tensor f8f8bf16_rowwise_impl(
   using EVTCompute0 =
       cutlass::epilogue::fusion::Sm90EVT<Compute0, WScale, Accum>;
 
+  // Stages ahead of the residual add keep FP32 to round only once.
+  using ElementPreResidual =
+      cute::conditional_t<USE_RESIDUAL, ElementComputeEpilogue, ElementOutput>;
+
   using Compute1 = cutlass::epilogue::fusion::Sm90Compute<
       cutlass::multiplies,
       cute::conditional_t< // Second stage output type.
           USE_BIAS,
           ElementBias,
-          ElementOutput>,
+          ElementPreResidual>,
       ElementComputeEpilogue, // Second stage input types.
       cutlass::FloatRoundStyle::round_to_nearest>;
 
@@ -1105,16 +1113,31 @@ at::Tensor f8f8bf16_rowwise_impl(
 
   using ComputeBias = cutlass::epilogue::fusion::Sm90Compute<
       cutlass::plus,
-      ElementOutput, // Final (optional) stage output type.
+      ElementPreResidual, // Optional bias stage output type.
       ElementBias, // Final stage input types.
       cutlass::FloatRoundStyle::round_to_nearest>;
 
   using EVTComputeBias =
       cutlass::epilogue::fusion::Sm90EVT<ComputeBias, Bias, EVTCompute1>;
 
-  using EpilogueEVT =
+  using EVTScaleBias =
       cute::conditional_t<USE_BIAS, EVTComputeBias, EVTCompute1>;
 
+  // The residual is read through the epilogue's source (C) operand.
+  using Residual = cutlass::epilogue::fusion::Sm90SrcFetch<ElementOutput>;
+
+  using ComputeResidual = cutlass::epilogue::fusion::Sm90Compute<
+      cutlass::plus,
+      ElementOutput, // Final (optional) stage output type.
+      ElementComputeEpilogue, // Final stage input types.
+      cutlass::FloatRoundStyle::round_to_nearest>;
+
+  using EVTComputeResidual = cutlass::epilogue::fusion::
+      Sm90EVT<ComputeResidual, Residual, EVTScaleBias>;
+
+  using EpilogueEVT =
+      cute::conditional_t<USE_RESIDUAL, EVTComputeResidual, EVTScaleBias>;
+
   using CollectiveEpilogue =
       typename cutlass::epilogue::collective::CollectiveBuilder<
           cutlass::arch::Sm90,
@@ -1130,7 +1153,7 @@ at::Tensor f8f8bf16_rowwise_impl(
           ElementOutput,
           LayoutOutput,
           AlignmentOutput,
-          cutlass::epilogue::TmaWarpSpecialized,
+          EpilogueSchedule,
           EpilogueEVT>::CollectiveOp;
 
   using DefaultSchedule = cutlass::gemm::KernelTmaWarpSpecialized;
@@ -1142,8 +1165,19 @@ at::Tensor f8f8bf16_rowwise_impl(
   using SlowAccum = cute::conditional_t<PONG, PongSchedule, DefaultSchedule>;
   using FastAccum =
       cute::conditional_t<PONG, FastPongSchedule, FastDefaultSchedule>;
-  using MainLoopSchedule =
-      cute::conditional_t<FAST_ACCUM, FastAccum, SlowAccum>;
+  // Stream-K requires the cooperative schedule.
+  using StreamKSchedule = cute::conditional_t<
+      FAST_ACCUM,
+      cutlass::gemm::KernelTmaWarpSpecializedCooperativeFP8FastAccum,
+      cutlass::gemm::KernelTmaWarpSpecializedCooperative>;
+  using MainLoopSchedule = cute::conditional_t<
+      STREAM_K,
+      StreamKSchedule,
+      cute::conditional_t<FAST_ACCUM, FastAccum, SlowAccum>>;
+  using EpilogueSchedule = cute::conditional_t<
+      STREAM_K,
+      cutlass::epilogue::TmaWarpSpecializedCooperative,
+      cutlass::epilogue::TmaWarpSpecialized>;
 
   using CollectiveMainloop =
       typename cutlass::gemm::collective::CollectiveBuilder<
@@ -1162,10 +1196,16 @@ at::Tensor f8f8bf16_rowwise_impl(
               sizeof(typename CollectiveEpilogue::SharedStorage))>,
           MainLoopSchedule>::CollectiveOp;
 
+  using TileScheduler = cute::conditional_t<
+      STREAM_K,
+      cutlass::gemm::StreamKScheduler,
+      cutlass::gemm::PersistentScheduler>;
+
   using GemmKernel = cutlass::gemm::kernel::GemmUniversal<
       cute::Shape<int, int, int>,
       CollectiveMainloop,
-      CollectiveEpilogue>;
+      CollectiveEpilogue,
+      TileScheduler>;
 
   using Gemm = cutlass::gemm::device::GemmUniversalAdapter<GemmKernel>;
 
@@ -1180,6 +1220,10 @@ at::Tensor f8f8bf16_rowwise_impl(
   StrideOutput stride_output = cutlass::make_cute_packed_stride(
       StrideOutput{}, cute::make_shape(M, N, cute::Int<1>{}));
 
+  auto* residual_ptr = USE_RESIDUAL
+      ? reinterpret_cast<ElementOutput*>(residual.value().data_ptr())
+      : (ElementOutput*)Y.data_ptr<at::BFloat16>();
+
   typename Gemm::Arguments arguments{
       cutlass::gemm::GemmUniversalMode::kGemm,
       {M, N, K},
@@ -1188,42 +1232,53 @@ at::Tensor f8f8bf16_rowwise_impl(
        reinterpret_cast<ElementInputB*>(WQ.data_ptr()),
        stride_b},
       {{}, // Epilogue thread we populate below.
-       (ElementOutput*)Y.data_ptr<at::BFloat16>(),
+       residual_ptr,
        stride_output,
        (ElementOutput*)Y.data_ptr<at::BFloat16>(),
        stride_output}};
 
+  if constexpr (STREAM_K) {
+    // Split the K loop of the few output tiles across all SMs.
+    arguments.hw_info.device_id = XQ.get_device();
+    arguments.hw_info.sm_count =
+        cutlass::KernelHardwareInfo::query_device_multiprocessor_count(
+            arguments.hw_info.device_id);
+    arguments.scheduler.decomposition_mode = cutlass::gemm::kernel::detail::
+        PersistentTileSchedulerSm90StreamKParams::DecompositionMode::StreamK;
+  }
+
+  typename EVTCompute1::Arguments scale_args = {
+      {reinterpret_cast<ElementComputeEpilogue*>(
+          x_scale.data_ptr())}, // x_scale
+      // compute_0
+      {
+          {reinterpret_cast<ElementComputeEpilogue*>(
+              w_scale.data_ptr())}, // w_scale
+          {}, // Accumulator
+          {} // Multiplies
+      },
+      {}, // Multiplies
+  };
+
+  typename EVTScaleBias::Arguments scale_bias_args;
   if constexpr (USE_BIAS) {
-    arguments.epilogue.thread = {
+    scale_bias_args = {
         {reinterpret_cast<ElementBias*>(bias.value().data_ptr())}, // bias
-        // compute_1
-        {
-            {reinterpret_cast<ElementComputeEpilogue*>(
-                x_scale.data_ptr())}, // x_scale
-            // compute_0
-            {
-                {reinterpret_cast<ElementComputeEpilogue*>(
-                    w_scale.data_ptr())}, // w_scale
-                {}, // Accumulator
-                {} // Multiplies
-            },
-            {}, // Multiplies
-        },
+        scale_args, // compute_1
         {}, // Plus
     };
   } else {
+    scale_bias_args = scale_args;
+  }
+
+  if constexpr (USE_RESIDUAL) {
     arguments.epilogue.thread = {
-        {reinterpret_cast<ElementComputeEpilogue*>(
-            x_scale.data_ptr())}, // x_scale
-        // compute_0
-        {
-            {reinterpret_cast<ElementComputeEpilogue*>(
-                w_scale.data_ptr())}, // w_scale
-            {}, // Accumulator
-            {} // Multiplies
-        },
-        {}, // Multiplies
+        {}, // residual
+        scale_bias_args,
+        {}, // Plus
     };
+  } else {
+    arguments.epilogue.thread = scale_bias_args;
   }
 
   Gemm gemm;
@@ -1258,14 +1313,53 @@ at::Tensor f8f8bf16_rowwise_impl(
   return Y;
 }
 
+// Decode shapes (small M with large N and K) produce fewer output tiles than
+// there are SMs, leaving most of the GPU idle behind a long K loop. Those are
+// dispatched to the stream-K kernel, which splits the K loop across SMs.
+bool use_stream_k(at::Tensor XQ, at::Tensor WQ) {
+  const auto M = XQ.size(0);
+  const auto K = XQ.size(1);
+  const auto N = WQ.size(0);
+  if (M > 64 || K < 2048) {
+    return false;
+  }
+  // Output tiles of the small (64 x 128) kernel.
+  const auto num_tiles = cutlass::ceil_div(M, 64) * cutlass::ceil_div(N, 128);
+  const auto num_sms =
+      at::cuda::getCurrentDeviceProperties()->multiProcessorCount;
+  return num_tiles < num_sms;
+}
+
 // FP8 Rowwise Cutlass kernel dispatch.
-template <typename InputDType, bool FastAccum, bool UseBias, typename BiasDType>
-at::Tensor dispatch_fp8_rowwise_kernel(
+template <
+    typename InputDType,
+    bool FastAccum,
+    bool UseBias,
+    bool UseResidual,
+    typename BiasDType>
+at::Tensor dispatch_fp8_rowwise_kernel_mode(
     at::Tensor XQ,
     at::Tensor WQ,
     at::Tensor x_scale,
     at::Tensor w_scale,
-    c10::optional<at::Tensor> bias) {
+    c10::optional<at::Tensor> bias,
+    c10::optional<at::Tensor> residual) {
+  if (use_stream_k(XQ, WQ)) {
+    return f8f8bf16_rowwise_impl<
+        128,
+        128,
+        128,
+        1,
+        1,
+        1,
+        false,
+        FastAccum,
+        UseBias,
+        UseResidual,
+        true,
+        InputDType,
+        BiasDType>(XQ, WQ, x_scale, w_scale, bias, residual);
+  }
   KernelMode kernel = get_kernel_mode(XQ, WQ);
   if (kernel == KernelMode::Small) {
     return f8f8bf16_rowwise_impl<
@@ -1278,8 +1372,10 @@ at::Tensor dispatch_fp8_rowwise_kernel(
         false,
         FastAccum,
         UseBias,
+        UseResidual,
+        false,
         InputDType,
-        BiasDType>(XQ, WQ, x_scale, w_scale, bias);
+        BiasDType>(XQ, WQ, x_scale, w_scale, bias, residual);
   } else if (kernel == KernelMode::Large) {
     return f8f8bf16_rowwise_impl<
         128,
@@ -1291,8 +1387,10 @@ at::Tensor dispatch_fp8_rowwise_kernel(
         true,
         FastAccum,
         UseBias,
+        UseResidual,
+        false,
         InputDType,
-        BiasDType>(XQ, WQ, x_scale, w_scale, bias);
+        BiasDType>(XQ, WQ, x_scale, w_scale, bias, residual);
   } else {
     return f8f8bf16_rowwise_impl<
         128,
@@ -1304,18 +1402,45 @@ at::Tensor dispatch_fp8_rowwise_kernel(
         false,
         FastAccum,
         UseBias,
+        UseResidual,
+        false,
         InputDType,
-        BiasDType>(XQ, WQ, x_scale, w_scale, bias);
+        BiasDType>(XQ, WQ, x_scale, w_scale, bias, residual);
   }
 }
 
+template <typename InputDType, bool FastAccum, bool UseBias, typename BiasDType>
+at::Tensor dispatch_fp8_rowwise_kernel(
+    at::Tensor XQ,
+    at::Tensor WQ,
+    at::Tensor x_scale,
+    at::Tensor w_scale,
+    c10::optional<at::Tensor> bias,
+    c10::optional<at::Tensor> residual) {
+  if (residual.has_value()) {
+    return dispatch_fp8_rowwise_kernel_mode<
+        InputDType,
+        FastAccum,
+        UseBias,
+        true,
+        BiasDType>(XQ, WQ, x_scale, w_scale, bias, residual);
+  }
+  return dispatch_fp8_rowwise_kernel_mode<
+      InputDType,
+      FastAccum,
+      UseBias,
+      false,
+      BiasDType>(XQ, WQ, x_scale, w_scale, bias, residual);
+}
+
 at::Tensor f8f8bf16_rowwise(
     at::Tensor XQ, // FP8
     at::Tensor WQ, // FP8
     at::Tensor x_scale, // FP32
     at::Tensor w_scale, // FP32
     c10::optional<at::Tensor> bias = c10::nullopt, // BF16
-    bool use_fast_accum = true) {
+    bool use_fast_accum = true,
+    c10::optional<at::Tensor> residual = c10::nullopt) { // BF16
   // Check datatypes.
   TORCH_CHECK(
       x_scale.dtype() == at::kFloat && w_scale.dtype() == at::kFloat,
@@ -1330,6 +1455,16 @@ at::Tensor f8f8bf16_rowwise(
   auto M = XQ.size(0);
   auto K = XQ.size(1);
   auto N = WQ.size(0);
+  if (residual.has_value()) {
+    TORCH_CHECK(
+        residual.value().dtype() == at::kBFloat16 &&
+            residual.value().is_cuda() && residual.value().is_contiguous(),
+        "Residual must be a contiguous bfloat16 CUDA tensor if provided.");
+    TORCH_CHECK(
+        residual.value().dim() == 2 && residual.value().size(0) == M &&
+            residual.value().size(1) == N,
+        "Residual must have shape [M, N].");
+  }
 
   bool use_bias = bias.has_value();
   bool bf16_bias = use_bias && bias.value().dtype() == at::kBFloat16;
@@ -1345,13 +1480,13 @@ at::Tensor f8f8bf16_rowwise(
               cutlass::float_e5m2_t,
               true,
               true,
-              cutlass::bfloat16_t>(XQ, WQ, x_scale, w_scale, bias);
+              cutlass::bfloat16_t>(XQ, WQ, x_scale, w_scale, bias, residual);
         } else {
           return dispatch_fp8_rowwise_kernel<
               cutlass::float_e4m3_t,
               true,
               true,
-              cutlass::bfloat16_t>(XQ, WQ, x_scale, w_scale, bias);
+              cutlass::bfloat16_t>(XQ, WQ, x_scale, w_scale, bias, residual);
         }
       } else {
         if (use_e5m2) {
@@ -1359,13 +1494,13 @@ at::Tensor f8f8bf16_rowwise(
               cutlass::float_e5m2_t,
               false,
               true,
-              cutlass::bfloat16_t>(XQ, WQ, x_scale, w_scale, bias);
+              cutlass::bfloat16_t>(XQ, WQ, x_scale, w_scale, bias, residual);
         } else {
           return dispatch_fp8_rowwise_kernel<
               cutlass::float_e4m3_t,
               false,
               true,
-              cutlass::bfloat16_t>(XQ, WQ, x_scale, w_scale, bias);
+              cutlass::bfloat16_t>(XQ, WQ, x_scale, w_scale, bias, residual);
         }
       }
     } else {
@@ -1375,13 +1510,13 @@ at::Tensor f8f8bf16_rowwise(
               cutlass::float_e5m2_t,
               true,
               true,
-              float>(XQ, WQ, x_scale, w_scale, bias);
+              float>(XQ, WQ, x_scale, w_scale, bias, residual);
         } else {
           return dispatch_fp8_rowwise_kernel<
               cutlass::float_e4m3_t,
               true,
               true,
-              float>(XQ, WQ, x_scale, w_scale, bias);
+              float>(XQ, WQ, x_scale, w_scale, bias, residual);
         }
       } else {
         if (use_e5m2) {
@@ -1389,13 +1524,13 @@ at::Tensor f8f8bf16_rowwise(
               cutlass::float_e5m2_t,
               false,
               true,
-              float>(XQ, WQ, x_scale, w_scale, bias);
+              float>(XQ, WQ, x_scale, w_scale, bias, residual);
         } else {
           return dispatch_fp8_rowwise_kernel<
               cutlass::float_e4m3_t,
               false,
               true,
-              float>(XQ, WQ, x_scale, w_scale, bias);
+              float>(XQ, WQ, x_scale, w_scale, bias, residual);
         }
       }
     }
@@ -1406,13 +1541,13 @@ at::Tensor f8f8bf16_rowwise(
             cutlass::float_e5m2_t,
             true,
             false,
-            float>(XQ, WQ, x_scale, w_scale, bias);
+            float>(XQ, WQ, x_scale, w_scale, bias, residual);
       } else {
         return dispatch_fp8_rowwise_kernel<
             cutlass::float_e4m3_t,
             true,
             false,
-            float>(XQ, WQ, x_scale, w_scale, bias);
+            float>(XQ, WQ, x_scale, w_scale, bias, residual);
       }
     } else {
       if (use_e5m2) {
@@ -1420,18 +1555,374 @@ at::Tensor f8f8bf16_rowwise(
             cutlass::float_e5m2_t,
             false,
             false,
-            float>(XQ, WQ, x_scale, w_scale, bias);
+            float>(XQ, WQ, x_scale, w_scale, bias, residual);
       } else {
         return dispatch_fp8_rowwise_kernel<
             cutlass::float_e4m3_t,
             false,
             false,
-            float>(XQ, WQ, x_scale, w_scale, bias);
+            float>(XQ, WQ, x_scale, w_scale, bias, residual);
       }
     }
   }
 }
 
+// Builds the per-expert problem shapes, operand pointers and strides of a
+// grouped GEMM directly from the device-side m_offsets, so that launching
+// the grouped kernel never has to synchronize with the host.
+template <
+    typename ProblemShape,
+    typename ElementA,
+    typename ElementB,
+    typename ElementD,
+    typename StrideA,
+    typename StrideB,
+    typename StrideD>
+__global__ void set_grouped_gemm_args_kernel(
+    int G,
+    int N,
+    int K,
+    const int64_t* m_offsets,
+    const ElementA* XQ,
+    const ElementB* WQ,
+    ElementD* Y,
+    ProblemShape* problem_shapes,
+    const ElementA** ptr_a,
+    const ElementB** ptr_b,
+    ElementD** ptr_d,
+    StrideA* stride_a,
+    StrideB* stride_b,
+    StrideD* stride_d) {
+  const int g = blockIdx.x * blockDim.x + threadIdx.x;
+  if (g >= G) {
+    return;
+  }
+  const int64_t m_start = m_offsets[g];
+  const int M = static_cast<int>(m_offsets[g + 1] - m_start);
+  problem_shapes[g] = cute::make_shape(M, N, K);
+  ptr_a[g] = XQ + m_start * K;
+  ptr_b[g] = WQ + static_cast<int64_t>(g) * N * K;
+  ptr_d[g] = Y + m_start * N;
+  stride_a[g] =
+      cutlass::make_cute_packed_stride(StrideA{}, cute::make_shape(M, K, 1));
+  stride_b[g] =
+      cutlass::make_cute_packed_stride(StrideB{}, cute::make_shape(N, K, 1));
+  stride_d[g] =
+      cutlass::make_cute_packed_stride(StrideD{}, cute::make_shape(M, N, 1));
+}
+
+// Applies the rowwise scales of the grouped GEMM: each block handles one row
+// of the output and looks up the expert that owns it in m_offsets. Rows past
+// m_offsets[G] do not belong to any expert and are zero filled.
+__global__ void grouped_rowwise_scale_kernel(
+    const float* __restrict__ Y_acc, // [total_M, N]
+    const float* __restrict__ x_scale, // [total_M]
+    const float* __restrict__ w_scale, // [G, N]
+    const int64_t* __restrict__ m_offsets, // [G + 1]
+    int G,
+    int N,
+    at::BFloat16* __restrict__ Y) { // [total_M, N]
+  const int64_t m = blockIdx.x;
+  auto* y_row = reinterpret_cast<__nv_bfloat162*>(Y + m * N);
+  if (m >= m_offsets[G]) {
+    for (int n = threadIdx.x; n < N / 2; n += blockDim.x) {
+      y_row[n] = __float2bfloat162_rn(0.0f);
+    }
+    return;
+  }
+  // Find the last g with m_offsets[g] <= m.
+  int lo = 0;
+  int hi = G - 1;
+  while (lo < hi) {
+    const int mid = (lo + hi + 1) / 2;
+    if (m_offsets[mid] <= m) {
+      lo = mid;
+    } else {
+      hi = mid - 1;
+    }
+  }
+  const float xs = x_scale[m];
+  const auto* acc_row = reinterpret_cast<const float4*>(Y_acc + m * N);
+  const auto* ws_row =
+      reinterpret_cast<const float4*>(w_scale + static_cast<int64_t>(lo) * N);
+  for (int n = threadIdx.x; n < N / 4; n += blockDim.x) {
+    const float4 acc = acc_row[n];
+    const float4 ws = ws_row[n];
+    y_row[2 * n] = __floats2bfloat162_rn(acc.x * ws.x * xs, acc.y * ws.y * xs);
+    y_row[2 * n + 1] =
+        __floats2bfloat162_rn(acc.z * ws.z * xs, acc.w * ws.w * xs);
+  }
+}
+
+// Cutlass grouped rowwise kernel for mixture of experts. Expert g multiplies
+// rows [m_offsets[g], m_offsets[g + 1]) of XQ with WQ[g]. All experts run in
+// a single persistent launch whose tile scheduler walks the variable sized
+// problems, so there is neither a launch per expert nor padding of M.
+template <
+    int TB_M,
+    int TB_N,
+    int TB_K,
+    int TBS_M,
+    int TBS_N,
+    int TBS_K,
+    bool FAST_ACCUM>
+at::Tensor f8f8bf16_rowwise_grouped_impl(
+    at::Tensor XQ, // FP8
+    at::Tensor WQ, // FP8
+    at::Tensor x_scale,
+    at::Tensor w_scale,
+    at::Tensor m_offsets) {
+  const int64_t total_M = XQ.size(0);
+  const int G = WQ.size(0);
+  const int N = WQ.size(1);
+  const int K = WQ.size(2);
+
+  auto Y = at::empty({total_M, N}, XQ.options().dtype(at::kBFloat16));
+  if (total_M == 0 || N == 0) {
+    return Y;
+  }
+  // The grouped epilogue has no per-group broadcast operands, so the GEMM
+  // writes unscaled FP32 accumulators and the scales are applied after.
+  auto Y_acc = at::empty({total_M, N}, XQ.options().dtype(at::kFloat));
+
+  using ElementInputA = cutlass::float_e4m3_t;
+  using LayoutInputA = cutlass::layout::RowMajor;
+  constexpr int AlignmentInputA = 16 / sizeof(ElementInputA);
+
+  using ElementInputB = cutlass::float_e4m3_t;
+  using LayoutInputB = cutlass::layout::ColumnMajor;
+  constexpr int AlignmentInputB = 16 / sizeof(ElementInputB);
+
+  using ElementOutput = float;
+  using LayoutOutput = cutlass::layout::RowMajor;
+  constexpr int AlignmentOutput = 16 / sizeof(ElementOutput);
+
+  using ElementAccumulator = float;
+  using ElementComputeEpilogue = float;
+  using ArchTag = cutlass::arch::Sm90;
+  using OperatorClass = cutlass::arch::OpClassTensorOp;
+  using TileShape =
+      cute::Shape<cute::Int<TB_M>, cute::Int<TB_N>, cute::Int<TB_K>>;
+  using ClusterShape =
+      cute::Shape<cute::Int<TBS_M>, cute::Int<TBS_N>, cute::Int<TBS_K>>;
+
+  using ProblemShape =
+      cutlass::gemm::GroupProblemShape<cute::Shape<int, int, int>>;
+
+  using CollectiveEpilogue =
+      typename cutlass::epilogue::collective::CollectiveBuilder<
+          ArchTag,
+          OperatorClass,
+          TileShape,
+          ClusterShape,
+          cutlass::epilogue::collective::EpilogueTileAuto,
+          ElementAccumulator,
+          ElementComputeEpilogue,
+          ElementOutput,
+          LayoutOutput*,
+          AlignmentOutput,
+          ElementOutput,
+          LayoutOutput*,
+          AlignmentOutput,
+          cutlass::epilogue::PtrArrayTmaWarpSpecializedCooperative>::
+          CollectiveOp;
+
+  using MainLoopSchedule = cute::conditional_t<
+      FAST_ACCUM,
+      cutlass::gemm::KernelPtrArrayTmaWarpSpecializedCooperativeFP8FastAccum,
+      cutlass::gemm::KernelPtrArrayTmaWarpSpecializedCooperative>;
+
+  using CollectiveMainloop =
+      typename cutlass::gemm::collective::CollectiveBuilder<
+          ArchTag,
+          OperatorClass,
+          ElementInputA,
+          LayoutInputA*,
+          AlignmentInputA,
+          ElementInputB,
+          LayoutInputB*,
+          AlignmentInputB,
+          ElementAccumulator,
+          TileShape,
+          ClusterShape,
+          cutlass::gemm::collective::StageCountAutoCarveout<static_cast<int>(
+              sizeof(typename CollectiveEpilogue::SharedStorage))>,
+          MainLoopSchedule>::CollectiveOp;
+
+  using GemmKernel = cutlass::gemm::kernel::
+      GemmUniversal<ProblemShape, CollectiveMainloop, CollectiveEpilogue>;
+
+  using Gemm = cutlass::gemm::device::GemmUniversalAdapter<GemmKernel>;
+
+  using UnderlyingProblemShape = typename ProblemShape::UnderlyingProblemShape;
+  using StrideInputA = typename Gemm::GemmKernel::InternalStrideA;
+  using StrideInputB = typename Gemm::GemmKernel::InternalStrideB;
+  using StrideOutput = typename Gemm::GemmKernel::InternalStrideD;
+
+  // Carve all per-group kernel arguments out of a single device buffer.
+  auto align16 = [](int64_t bytes) { return (bytes + 15) / 16 * 16; };
+  const int64_t problem_shape_bytes =
+      align16(G * sizeof(UnderlyingProblemShape));
+  const int64_t ptr_bytes = align16(G * sizeof(void*));
+  const int64_t stride_a_bytes = align16(G * sizeof(StrideInputA));
+  const int64_t stride_b_bytes = align16(G * sizeof(StrideInputB));
+  const int64_t stride_output_bytes = align16(G * sizeof(StrideOutput));
+  auto kernel_args = at::empty(
+      {problem_shape_bytes + 3 * ptr_bytes + stride_a_bytes + stride_b_bytes +
+       stride_output_bytes},
+      XQ.options().dtype(at::kByte));
+  uint8_t* args_base = kernel_args.data_ptr<uint8_t>();
+
+  auto* problem_shapes = reinterpret_cast<UnderlyingProblemShape*>(args_base);
+  args_base += problem_shape_bytes;
+  auto** ptr_a = reinterpret_cast<const ElementInputA**>(args_base);
+  args_base += ptr_bytes;
+  auto** ptr_b = reinterpret_cast<const ElementInputB**>(args_base);
+  args_base += ptr_bytes;
+  auto** ptr_output = reinterpret_cast<ElementOutput**>(args_base);
+  args_base += ptr_bytes;
+  auto* stride_a = reinterpret_cast<StrideInputA*>(args_base);
+  args_base += stride_a_bytes;
+  auto* stride_b = reinterpret_cast<StrideInputB*>(args_base);
+  args_base += stride_b_bytes;
+  auto* stride_output = reinterpret_cast<StrideOutput*>(args_base);
+
+  auto stream = at::cuda::getCurrentCUDAStream();
+  constexpr int kArgsThreads = 128;
+  set_grouped_gemm_args_kernel<<<
+      cutlass::ceil_div(G, kArgsThreads),
+      kArgsThreads,
+      0,
+      stream>>>(
+      G,
+      N,
+      K,
+      m_offsets.data_ptr<int64_t>(),
+      reinterpret_cast<const ElementInputA*>(XQ.data_ptr()),
+      reinterpret_cast<const ElementInputB*>(WQ.data_ptr()),
+      Y_acc.data_ptr<float>(),
+      problem_shapes,
+      ptr_a,
+      ptr_b,
+      ptr_output,
+      stride_a,
+      stride_b,
+      stride_output);
+  C10_CUDA_KERNEL_LAUNCH_CHECK();
+
+  cutlass::KernelHardwareInfo hw_info;
+  hw_info.device_id = XQ.get_device();
+  hw_info.sm_count =
+      cutlass::KernelHardwareInfo::query_device_multiprocessor_count(
+          hw_info.device_id);
+
+  // Problem shapes only live on device; the persistent tile scheduler reads
+  // them from there.
+  typename Gemm::Arguments arguments{
+      cutlass::gemm::GemmUniversalMode::kGrouped,
+      {G, problem_shapes, nullptr},
+      {ptr_a, stride_a, ptr_b, stride_b},
+      {{}, // Epilogue thread we populate below.
+       nullptr,
+       stride_output,
+       ptr_output,
+       stride_output},
+      hw_info};
+  arguments.epilogue.thread.alpha = 1.0f;
+  arguments.epilogue.thread.beta = 0.0f;
+
+  Gemm gemm;
+
+  // Using the arguments, query for extra workspace required for matrix
+  // multiplication computation
+  size_t workspace_size = Gemm::get_workspace_size(arguments);
+
+  // Allocate workspace memory
+  cutlass::device_memory::allocation<uint8_t> workspace(workspace_size);
+
+  // Check the problem size is supported or not
+  cutlass::Status status = gemm.can_implement(arguments);
+  if (status != cutlass::Status::kSuccess) {
+    throw std::runtime_error("cutlass cannot implement");
+  }
+
+  // Initialize CUTLASS kernel with arguments and workspace pointer
+  status = gemm.initialize(arguments, workspace.get());
+  if (status != cutlass::Status::kSuccess) {
+    throw std::runtime_error("cutlass cannot initialize");
+  }
+
+  status = gemm(stream);
+  if (status != cutlass::Status::kSuccess) {
+    throw std::runtime_error(
+        std::string("cutlass cannot run") +
+        cutlass::cutlassGetStatusString(status));
+  }
+  C10_CUDA_KERNEL_LAUNCH_CHECK();
+
+  grouped_rowwise_scale_kernel<<<
+      total_M,
+      std::min(1024, std::max(32, N / 4)),
+      0,
+      stream>>>(
+      Y_acc.data_ptr<float>(),
+      x_scale.data_ptr<float>(),
+      w_scale.data_ptr<float>(),
+      m_offsets.data_ptr<int64_t>(),
+      G,
+      N,
+      Y.data_ptr<at::BFloat16>());
+  C10_CUDA_KERNEL_LAUNCH_CHECK();
+
+  return Y;
+}
+
+at::Tensor f8f8bf16_rowwise_grouped(
+    at::Tensor XQ, // FP8 [total_M, K], rows sorted by expert
+    at::Tensor WQ, // FP8 [G, N, K]
+    at::Tensor x_scale, // FP32 [total_M]
+    at::Tensor w_scale, // FP32 [G, N]
+    at::Tensor m_offsets, // INT64 [G + 1]
+    bool use_fast_accum = true) {
+  TORCH_CHECK(XQ.is_cuda() && XQ.is_contiguous());
+  TORCH_CHECK(WQ.is_cuda() && WQ.is_contiguous());
+  TORCH_CHECK(
+      XQ.dtype() == at::kFloat8_e4m3fn && WQ.dtype() == at::kFloat8_e4m3fn,
+      "XQ and WQ must be float8_e4m3fn.");
+  TORCH_CHECK(XQ.dim() == 2, "XQ must be a 2D [total_M, K] tensor.");
+  TORCH_CHECK(WQ.dim() == 3, "WQ must be a 3D [G, N, K] tensor.");
+  TORCH_CHECK(
+      x_scale.dtype() == at::kFloat && w_scale.dtype() == at::kFloat,
+      "Scale tensors must be float32.");
+  TORCH_CHECK(x_scale.is_cuda() && x_scale.is_contiguous());
+  TORCH_CHECK(w_scale.is_cuda() && w_scale.is_contiguous());
+  TORCH_CHECK(m_offsets.is_cuda() && m_offsets.is_contiguous());
+  TORCH_CHECK(
+      m_offsets.dtype() == at::kLong, "m_offsets must be an int64 tensor.");
+
+  const auto total_M = XQ.size(0);
+  const auto K = XQ.size(1);
+  const auto G = WQ.size(0);
+  const auto N = WQ.size(1);
+  TORCH_CHECK(G > 0, "WQ must hold at least one expert.");
+  TORCH_CHECK(WQ.size(2) == K, "XQ and WQ must have the same K.");
+  TORCH_CHECK(x_scale.numel() == total_M, "x_scale must have total_M entries.");
+  TORCH_CHECK(w_scale.numel() == G * N, "w_scale must have G * N entries.");
+  TORCH_CHECK(m_offsets.numel() == G + 1, "m_offsets must have G + 1 entries.");
+  TORCH_CHECK(
+      K % 16 == 0 && N % 8 == 0,
+      "K must be a multiple of 16 and N a multiple of 8.");
+
+  at::cuda::OptionalCUDAGuard device_guard(XQ.device());
+  if (use_fast_accum) {
+    return f8f8bf16_rowwise_grouped_impl<128, 128, 128, 1, 1, 1, true>(
+        XQ, WQ, x_scale, w_scale, m_offsets);
+  } else {
+    return f8f8bf16_rowwise_grouped_impl<128, 128, 128, 1, 1, 1, false>(
+        XQ, WQ, x_scale, w_scale, m_offsets);
+  }
+}
+
 template <
     int TB_M,
     int TB_N,
@@ -1926,6 +2417,17 @@ at::Tensor f8f8bf16_rowwise(
     at::Tensor x_scale,
     at::Tensor w_scale,
     c10::optional<at::Tensor> bias = c10::nullopt,
+    bool use_fast_accum = true,
+    c10::optional<at::Tensor> residual = c10::nullopt) {
+  throw std::runtime_error(
+      "CUDA version is older than 12.0"); // requires CUDA>=12
+}
+at::Tensor f8f8bf16_rowwise_grouped(
+    at::Tensor XQ, // FP8
+    at::Tensor WQ, // FP8
+    at::Tensor x_scale,
+    at::Tensor w_scale,
+    at::Tensor m_offsets,
     bool use_fast_accum = true) {
   throw std::runtime_error(
       "CUDA version is older than 12.0"); // requires CUDA>=12
@@ -49,6 +49,14 @@ at::Tensor f8f8bf16_rowwise(
     at::Tensor x_scale,
     at::Tensor w_scale,
     c10::optional<at::Tensor> bias = c10::nullopt,
+    bool use_fast_accum = true,
+    c10::optional<at::Tensor> residual = c10::nullopt);
+at::Tensor f8f8bf16_rowwise_grouped(
+    at::Tensor XQ,
+    at::Tensor WQ,
+    at::Tensor x_scale,
+    at::Tensor w_scale,
+    at::Tensor m_offsets,
     bool use_fast_accum = true);
 at::Tensor f8f8bf16_cublas(
     at::Tensor A,
@@ -78,6 +86,11 @@ std::vector<at::Tensor> quantize_fp8_per_row(
     c10::optional<at::Tensor> scale_ub, // scale upperbound
     c10::optional<c10::ScalarType> output_dtype); // output dtype
 
+std::vector<at::Tensor> silu_mul_quantize_fp8_per_row(
+    at::Tensor X1,
+    at::Tensor X2,
+    c10::optional<at::Tensor> scale_ub); // scale upperbound
+
 #if CUDART_VERSION >= 12000
 std::vector<at::Tensor> quantize_fp8_per_col(
     at::Tensor input,
@@ -106,7 +119,13 @@ TORCH_LIBRARY_FRAGMENT(fbgemm, m) {
       "f8f8bf16(Tensor XQ, Tensor WQ, Tensor scale, bool use_fast_accum=True) -> Tensor");
 
   m.def(
-      "f8f8bf16_rowwise(Tensor XQ, Tensor WQ, Tensor x_scale, Tensor w_scale, Tensor? bias=None, bool use_fast_accum=True) -> Tensor");
+      "f8f8bf16_rowwise(Tensor XQ, Tensor WQ, Tensor x_scale, Tensor w_scale, Tensor? bias=None, bool use_fast_accum=True, Tensor? residual=None) -> Tensor");
+
+  // Grouped rowwise FP8 GEMM for mixture of experts: rows
+  // [m_offsets[g], m_offsets[g + 1]) of XQ [total_M, K] are multiplied with
+  // WQ[g] of WQ [G, N, K] in a single launch.
+  m.def(
+      "f8f8bf16_rowwise_grouped(Tensor XQ, Tensor WQ, Tensor x_scale, Tensor w_scale, Tensor m_offsets, bool use_fast_accum=True) -> Tensor");
 
   m.def(
       "f8f8bf16_cublas(Tensor A, Tensor B, Tensor Ainvs, Tensor Binvs, bool use_fast_accum=True, Tensor(a!)? output=None) -> Tensor");
@@ -143,6 +162,9 @@ TORCH_LIBRARY_FRAGMENT(fbgemm, m) {
   m.def(
       "quantize_fp8_per_row(Tensor input, Tensor? bs=None, Tensor? scale_ub=None, ScalarType? output_dtype=None) -> Tensor[]");
   m.impl("quantize_fp8_per_row", quantize_fp8_per_row);
+  m.def(
+      "silu_mul_quantize_fp8_per_row(Tensor X1, Tensor X2, Tensor? scale_ub=None) -> Tensor[]");
+  m.impl("silu_mul_quantize_fp8_per_row", silu_mul_quantize_fp8_per_row);
 
 #if CUDART_VERSION >= 12000
   m.def(
@@ -167,6 +189,7 @@ TORCH_LIBRARY_IMPL(fbgemm, CUDA, m) {
 #ifndef USE_ROCM
   m.impl("i8i8bf16", i8i8bf16);
   m.impl("f8f8bf16_rowwise", f8f8bf16_rowwise);
+  m.impl("f8f8bf16_rowwise_grouped", f8f8bf16_rowwise_grouped);
   m.impl("quantize_fp8_per_tensor", quantize_fp8_per_tensor);
   m.impl("f8f8bf16", f8f8bf16);
   m.impl("f8f8bf16_cublas", f8f8bf16_cublas);
@@ -190,13 +213,27 @@ at::Tensor f8f8bf16_rowwise_meta(
     at::Tensor x_scale,
     at::Tensor w_scale,
     c10::optional<at::Tensor> bias = c10::nullopt,
-    bool use_fast_accum = true) {
+    bool use_fast_accum = true,
+    c10::optional<at::Tensor> residual = c10::nullopt) {
   int M = XQ.size(0);
   int N = WQ.size(0);
   auto Y = at::empty({M, N}, XQ.options().dtype(at::kBFloat16));
   return Y;
 }
 
+at::Tensor f8f8bf16_rowwise_grouped_meta(
+    at::Tensor XQ, // FP8
+    at::Tensor WQ, // FP8
+    at::Tensor x_scale,
+    at::Tensor w_scale,
+    at::Tensor m_offsets,
+    bool use_fast_accum = true) {
+  const at::SymInt total_M = XQ.sym_size(0);
+  const at::SymInt N = WQ.sym_size(1);
+  auto Y = at::empty_symint({total_M, N}, XQ.options().dtype(at::kBFloat16));
+  return Y;
+}
+
 std::vector<at::Tensor> quantize_fp8_per_tensor_meta(
     at::Tensor X,
     c10::optional<at::Tensor> bs,
@@ -258,6 +295,7 @@ TORCH_LIBRARY_IMPL(fbgemm, Meta, m) {
 #ifndef USE_ROCM
   m.impl("i8i8bf16", i8i8bf16_meta);
   m.impl("f8f8bf16_rowwise", f8f8bf16_rowwise_meta);
+  m.impl("f8f8bf16_rowwise_grouped", f8f8bf16_rowwise_grouped_meta);
   m.impl("quantize_fp8_per_tensor", quantize_fp8_per_tensor_meta);
   m.impl("f8f8bf16", f8f8bf16_meta);
   m.impl("f8f8bf16_cublas", f8f8bf16_cublas_meta);
@@ -812,6 +812,71 @@ __global__ void dynamicQuantizeMatrixRowwise(
   }
 }
 
+// Register resident variant of dynamicQuantizeMatrixRowwise for BF16 rows
+// with lda % 8 == 0. Each thread keeps VEC_PER_THREAD chunks of 8 elements in
+// registers using 16 byte loads, so the row is read from global memory once
+// and both the FP8 row and its scale are produced without shared memory
+// staging, regardless of how large lda is relative to the shared memory
+// budget.
+template <typename SCALE, typename T_OUT, typename T_S, int VEC_PER_THREAD>
+__global__ void dynamicQuantizeMatrixRowwiseVec(
+    T_OUT* output,
+    T_S* quant_ptr,
+    __nv_bfloat16 const* input,
+    int64_t nrows,
+    int64_t lda,
+    const float* scale_ub) {
+  constexpr int kVecSize = 8;
+  constexpr float min_scaling_factor = 1.0f / (SCALE::value * 512.f);
+  const int64_t nvecs = lda / kVecSize;
+  for (int64_t row = blockIdx.x; row < nrows; row += gridDim.x) {
+    const auto* in_row = reinterpret_cast<const uint4*>(input + row * lda);
+    uint4 vals[VEC_PER_THREAD];
+    float max = 0.f;
+#pragma unroll
+    for (int v = 0; v < VEC_PER_THREAD; ++v) {
+      const int64_t idx = threadIdx.x + v * blockDim.x;
+      if (idx < nvecs) {
+        vals[v] = in_row[idx];
+        const auto* h = reinterpret_cast<const __nv_bfloat162*>(&vals[v]);
+#pragma unroll
+        for (int j = 0; j < kVecSize / 2; ++j) {
+          const float2 f = __bfloat1622float2(h[j]);
+          max = fmaxf(max, fmaxf(fabsf(f.x), fabsf(f.y)));
+        }
+      }
+    }
+    max = blockAllReduceMax<float>(max);
+    // The next row reuses the reduction's shared memory.
+    __syncthreads();
+    auto bounded_max = max;
+    if (scale_ub != nullptr) {
+      bounded_max = std::min(max, *scale_ub);
+    }
+    const float s = std::max(bounded_max / SCALE::value, min_scaling_factor);
+    auto* out_row = reinterpret_cast<uint2*>(output + row * lda);
+#pragma unroll
+    for (int v = 0; v < VEC_PER_THREAD; ++v) {
+      const int64_t idx = threadIdx.x + v * blockDim.x;
+      if (idx < nvecs) {
+        const auto* h = reinterpret_cast<const __nv_bfloat16*>(&vals[v]);
+        union {
+          T_OUT q[kVecSize];
+          uint2 packed;
+        } out;
+#pragma unroll
+        for (int j = 0; j < kVecSize; ++j) {
+          out.q[j] = (T_OUT)scale<true>(__bfloat162float(h[j]), s);
+        }
+        out_row[idx] = out.packed;
+      }
+    }
+    if (threadIdx.x == 0) {
+      quant_ptr[row] = (T_S)s;
+    }
+  }
+}
+
 template <typename SCALE, typename T_S, typename T_W>
 __global__ void computeFP8QuantizeScaleRowwise(
     T_S* quant_ptr,
@@ -850,6 +915,34 @@ void invokeComputeScalesAndQuantizeMatrix(
     const float* scale_ub,
     cudaStream_t stream) {
   dim3 grid(numel / lda);
+  if constexpr (std::is_same_v<T_IN, __nv_bfloat16>) {
+    constexpr int64_t kVecSize = 8;
+    constexpr int64_t kMaxThreads = 1024;
+    const int64_t nvecs = lda / kVecSize;
+    if (lda % kVecSize == 0 &&
+        reinterpret_cast<uintptr_t>(input) % 16 == 0 &&
+        reinterpret_cast<uintptr_t>(output) % 8 == 0 &&
+        nvecs <= 4 * kMaxThreads) {
+      const int64_t vec_per_thread =
+          nvecs <= kMaxThreads ? 1 : (nvecs <= 2 * kMaxThreads ? 2 : 4);
+      const int64_t threads = (nvecs + vec_per_thread - 1) / vec_per_thread;
+      dim3 block(std::min((threads + 31) / 32 * 32, kMaxThreads));
+#define INVOKE_QUANTIZE_ROWWISE_VEC(VEC_PER_THREAD)                  \
+  dynamicQuantizeMatrixRowwiseVec<SCALE, T_OUT, T_S, VEC_PER_THREAD> \
+      <<<grid, block, 0, stream>>>(                                  \
+          output, quant_ptr, input, numel / lda, lda, scale_ub)
+      if (vec_per_thread == 1) {
+        INVOKE_QUANTIZE_ROWWISE_VEC(1);
+      } else if (vec_per_thread == 2) {
+        INVOKE_QUANTIZE_ROWWISE_VEC(2);
+      } else {
+        INVOKE_QUANTIZE_ROWWISE_VEC(4);
+      }
+#undef INVOKE_QUANTIZE_ROWWISE_VEC
+      C10_CUDA_KERNEL_LAUNCH_CHECK();
+      return;
+    }
+  }
   bool use_shmem = true;
   auto const shmem_size = lda * sizeof(T_IN);
   if (shmem_size >= (48 << 10)) {
@@ -967,6 +1060,123 @@ std::vector<at::Tensor> quantize_fp8_per_row(
   }
 }
 
+// Fuses the SwiGLU of an FFN up projection with the rowwise FP8 quantization
+// of the down projection's input: Y = quantize(silu(X1) * X2). X1 and X2 may
+// be the gate and up halves of a single [M, 2 * N] GEMM output. The product
+// is rounded to BF16 before quantization to match the unfused ops.
+template <typename SCALE>
+__global__ void silu_mul_quantize_fp8_per_row_kernel(
+    at::PackedTensorAccessor64<at::BFloat16, 2, at::RestrictPtrTraits> X1,
+    at::PackedTensorAccessor64<at::BFloat16, 2, at::RestrictPtrTraits> X2,
+    at::PackedTensorAccessor64<uint8_t, 2, at::RestrictPtrTraits> Y,
+    float* scales,
+    const float* scale_ub) {
+  constexpr float min_scaling_factor = 1.0f / (SCALE::value * 512.f);
+  const auto N = X1.size(1);
+  const auto silu_mul = [](const bf16x8& x1, const bf16x8& x2, int j) {
+    const auto* a = reinterpret_cast<const __nv_bfloat16*>(&x1);
+    const auto* b = reinterpret_cast<const __nv_bfloat16*>(&x2);
+    const float g = __bfloat162float(a[j]);
+    return __bfloat162float(
+        __float2bfloat16(g * __sigmoid(g) * __bfloat162float(b[j])));
+  };
+  for (int64_t row = blockIdx.x; row < X1.size(0); row += gridDim.x) {
+    float max = 0.f;
+    for (int64_t i = threadIdx.x * 8; i < N; i += 8 * blockDim.x) {
+      bf16x8 src1;
+      *reinterpret_cast<uint4*>(&src1) =
+          *reinterpret_cast<const uint4*>(&X1[row][i]);
+      bf16x8 src2;
+      *reinterpret_cast<uint4*>(&src2) =
+          *reinterpret_cast<const uint4*>(&X2[row][i]);
+#pragma unroll
+      for (int j = 0; j < 8; ++j) {
+        max = fmaxf(max, fabsf(silu_mul(src1, src2, j)));
+      }
+    }
+    max = blockAllReduceMax<float>(max);
+    // The next row reuses the reduction's shared memory.
+    __syncthreads();
+    auto bounded_max = max;
+    if (scale_ub != nullptr) {
+      bounded_max = std::min(max, *scale_ub);
+    }
+    const float s = std::max(bounded_max / SCALE::value, min_scaling_factor);
+    // The second pass recomputes the product from the (now cached) inputs
+    // instead of staging the row.
+    for (int64_t i = threadIdx.x * 8; i < N; i += 8 * blockDim.x) {
+      bf16x8 src1;
+      *reinterpret_cast<uint4*>(&src1) =
+          *reinterpret_cast<const uint4*>(&X1[row][i]);
+      bf16x8 src2;
+      *reinterpret_cast<uint4*>(&src2) =
+          *reinterpret_cast<const uint4*>(&X2[row][i]);
+      union {
+        __nv_fp8_e4m3 q[8];
+        uint2 packed;
+      } dst;
+#pragma unroll
+      for (int j = 0; j < 8; ++j) {
+        dst.q[j] = __nv_fp8_e4m3(scale<true>(silu_mul(src1, src2, j), s));
+      }
+      *reinterpret_cast<uint2*>(&Y[row][i]) = dst.packed;
+    }
+    if (threadIdx.x == 0) {
+      scales[row] = s;
+    }
+  }
+}
+
+std::vector<at::Tensor> silu_mul_quantize_fp8_per_row(
+    at::Tensor X1,
+    at::Tensor X2,
+    c10::optional<at::Tensor> scale_ub) // scale upperbound
+{
+  CUDA_DEVICE_GUARD(X1);
+  TORCH_CHECK(X1.is_cuda() && X2.is_cuda(), "Inputs must be CUDA tensors");
+  TORCH_CHECK(
+      X1.dim() == 2 && X1.sizes() == X2.sizes(),
+      "X1 and X2 must be 2D tensors of the same shape");
+  TORCH_CHECK(
+      X1.scalar_type() == torch::kBFloat16 &&
+          X2.scalar_type() == torch::kBFloat16,
+      "Invalid datatype. X1 and X2 must be BF16");
+  TORCH_CHECK(
+      X1.stride(1) == 1 && X2.stride(1) == 1 && X1.stride(0) % 8 == 0 &&
+          X2.stride(0) % 8 == 0 && X1.size(1) % 8 == 0,
+      "X1 and X2 rows must be contiguous with a multiple of 8 elements");
+  TORCH_CHECK(
+      reinterpret_cast<uintptr_t>(X1.data_ptr()) % 16 == 0 &&
+          reinterpret_cast<uintptr_t>(X2.data_ptr()) % 16 == 0,
+      "X1 and X2 must be 16 byte aligned");
+
+  at::Tensor quantized =
+      at::empty(X1.sizes(), X1.options().dtype(torch::kFloat8_e4m3fn));
+  at::Tensor scales = at::empty({X1.size(0)}, X1.options().dtype(at::kFloat));
+  if (X1.numel() == 0) {
+    return std::vector<at::Tensor>{quantized, scales};
+  }
+  constexpr int32_t kThreadsPerBlock = 1024;
+  const int32_t threads = std::min<int64_t>(
+      kThreadsPerBlock, (X1.size(1) / 8 + 31) / 32 * 32);
+  const int64_t blocks = X1.size(0);
+  auto quantized_bytes = quantized.view(at::kByte);
+  silu_mul_quantize_fp8_per_row_kernel<FP8_E4M3_MAX><<<
+      blocks,
+      threads,
+      0,
+      at::cuda::getCurrentCUDAStream()>>>(
+      X1.packed_accessor64<at::BFloat16, 2, at::RestrictPtrTraits>(),
+      X2.packed_accessor64<at::BFloat16, 2, at::RestrictPtrTraits>(),
+      quantized_bytes.packed_accessor64<uint8_t, 2, at::RestrictPtrTraits>(),
+      scales.data_ptr<float>(),
+      scale_ub.has_value()
+          ? reinterpret_cast<float*>(scale_ub.value().data_ptr())
+          : nullptr);
+  C10_CUDA_KERNEL_LAUNCH_CHECK();
+  return std::vector<at::Tensor>{quantized, scales};
+}
+
 std::vector<at::Tensor> quantize_fp8_per_col(
     at::Tensor input,
     c10::optional<at::Tensor> bs, // batch size
@@ -1029,6 +1239,14 @@ std::vector<at::Tensor> quantize_fp8_per_row(
       "CUDA version is older than 12.0"); // requires CUDA>=12
 }
 
+std::vector<at::Tensor> silu_mul_quantize_fp8_per_row(
+    at::Tensor X1,
+    at::Tensor X2,
+    c10::optional<at::Tensor> scale_ub) { // scale upperbound
+  throw std::runtime_error(
+      "CUDA version is older than 12.0"); // requires CUDA>=12
+}
+
 at::Tensor quantize_fp8_per_tensor_fixed_scale(
     at::Tensor input,
     at::Tensor scale,
@@ -76,6 +76,20 @@ def quant_int4_dequant_bf16(
     return in_quant, in_quant_dequant_bf16.view(*in_shape)
 
 
+def quant_fp8_per_token(
+    in_tensor: torch.Tensor,
+) -> Tuple[torch.Tensor, torch.Tensor]:
+    """
+    Quantizes each row (token) of a KV cache to FP8 (e4m3fn) with an FP32
+    scale, and returns the FP8 cache and its scales of shape in_tensor.shape[:-1]
+    """
+    fp8_max = torch.finfo(torch.float8_e4m3fn).max
+    in_fp32 = in_tensor.float()
+    scales = in_fp32.abs().amax(dim=-1).clamp(min=1e-12) / fp8_max
+    in_fp8 = (in_fp32 / scales.unsqueeze(-1)).to(torch.float8_e4m3fn)
+    return in_fp8, scales
+
+
 def gqa_reference(
     Q: torch.Tensor,
     K: torch.Tensor,
@@ -199,3 +213,253 @@ class Int4GQATest(unittest.TestCase):
                 atol=2.0e-2,
                 rtol=6.0e-3,
             )
+
+    @unittest.skipIf(
+        not torch.version.cuda,
+        "Skip when CUDA is not available",
+    )
+    @settings(verbosity=VERBOSITY, max_examples=40, deadline=None)
+    # pyre-ignore
+    @given(
+        int4_kv=st.booleans(),
+        num_groups=st.sampled_from([1, 4]),
+        B=st.integers(min_value=1, max_value=32),
+        MAX_T=st.integers(min_value=4, max_value=512),
+        N_H_L=st.integers(min_value=1, max_value=32),
+        PAGE_SIZE=st.sampled_from([16, 64, 256]),
+    )
+    def test_gqa_paged(
+        self,
+        int4_kv: bool,
+        num_groups: int,
+        B: int,
+        MAX_T: int,
+        N_H_L: int,
+        PAGE_SIZE: int,
+    ) -> None:
+        """
+        Test correctness of torch.ops.fbgemm.gqa_attn_splitk_paged against the
+        reference GQA implementation, with the KV cache scattered into
+        shuffled pages
+        """
+        D_H = 128
+        N_KVH_L = 1
+
+        seq_positions = torch.randint(0, MAX_T, (B,), device="cuda").int()
+        kv_seqlens = [seq_position + 1 for seq_position in seq_positions]
+        q = torch.randn((B, 1, N_H_L, D_H), dtype=torch.bfloat16, device="cuda")
+
+        cache_k = torch.randn(
+            (B, MAX_T, N_KVH_L, D_H), dtype=torch.bfloat16, device="cuda"
+        )
+        cache_v = torch.randn_like(cache_k)
+        if int4_kv:
+            cache_k, cache_k_ref = quant_int4_dequant_bf16(cache_k, num_groups)
+            cache_v, cache_v_ref = quant_int4_dequant_bf16(cache_v, num_groups)
+            cache_k_ref = cache_k_ref.cpu().float()
+            cache_v_ref = cache_v_ref.cpu().float()
+        else:
+            cache_k_ref = cache_k.cpu().float()
+            cache_v_ref = cache_v.cpu().float()
+
+        # Scatter the contiguous caches into a shuffled pool of pages
+        pages_per_seq = (MAX_T + PAGE_SIZE - 1) // PAGE_SIZE
+        padded_t = pages_per_seq * PAGE_SIZE
+        block_tables = (
+            torch.randperm(B * pages_per_seq, device="cuda")
+            .view(B, pages_per_seq)
+            .int()
+        )
+
+        def to_pages(cache: torch.Tensor) -> torch.Tensor:
+            padded = torch.zeros(
+                (B, padded_t, *cache.shape[2:]), dtype=cache.dtype, device="cuda"
+            )
+            padded[:, :MAX_T] = cache
+            pages = torch.empty(
+                (B * pages_per_seq, PAGE_SIZE, *cache.shape[2:]),
+                dtype=cache.dtype,
+                device="cuda",
+            )
+            pages[block_tables.flatten().long()] = padded.view(
+                B * pages_per_seq, PAGE_SIZE, *cache.shape[2:]
+            )
+            return pages
+
+        paged_k = to_pages(cache_k)
+        paged_v = to_pages(cache_v)
+
+        qk_scale = 1.0 / np.sqrt(D_H)
+        z_ref, _ = gqa_reference(
+            q.cpu().float(),
+            cache_k_ref,
+            cache_v_ref,
+            kv_seqlens,
+            qk_scale=qk_scale,
+        )
+
+        for split_k in [1, 2, 13]:
+            z, _, _ = torch.ops.fbgemm.gqa_attn_splitk_paged(
+                q,
+                paged_k,
+                paged_v,
+                seq_positions,
+                block_tables,
+                qk_scale=qk_scale,
+                num_split_ks=split_k,
+                num_int4_kv_groups=num_groups,
+            )
+            torch.testing.assert_close(
+                z.cpu().bfloat16(),
+                z_ref.cpu().bfloat16(),
+                atol=2.0e-2,
+                rtol=6.0e-3,
+            )
+
+    @unittest.skipIf(
+        not torch.version.cuda,
+        "Skip when CUDA is not available",
+    )
+    @settings(verbosity=VERBOSITY, max_examples=40, deadline=None)
+    # pyre-ignore
+    @given(
+        int4_kv=st.booleans(),
+        num_groups=st.sampled_from([1, 4]),
+        B=st.integers(min_value=1, max_value=32),
+        MAX_T=st.integers(min_value=4, max_value=512),
+        N_H_L=st.integers(min_value=1, max_value=32),
+    )
+    def test_gqa_jagged(
+        self,
+        int4_kv: bool,
+        num_groups: int,
+        B: int,
+        MAX_T: int,
+        N_H_L: int,
+    ) -> None:
+        """
+        Test correctness of torch.ops.fbgemm.gqa_attn_splitk_jagged against the
+        reference GQA implementation, with the KV caches of all sequences
+        packed back to back
+        """
+        D_H = 128
+        N_KVH_L = 1
+
+        seq_positions = torch.randint(0, MAX_T, (B,), device="cuda").int()
+        kv_seqlens = [seq_position + 1 for seq_position in seq_positions]
+        q = torch.randn((B, 1, N_H_L, D_H), dtype=torch.bfloat16, device="cuda")
+
+        cache_k = torch.randn(
+            (B, MAX_T, N_KVH_L, D_H), dtype=torch.bfloat16, device="cuda"
+        )
+        cache_v = torch.randn_like(cache_k)
+        if int4_kv:
+            cache_k, cache_k_ref = quant_int4_dequant_bf16(cache_k, num_groups)
+            cache_v, cache_v_ref = quant_int4_dequant_bf16(cache_v, num_groups)
+            cache_k_ref = cache_k_ref.cpu().float()
+            cache_v_ref = cache_v_ref.cpu().float()
+        else:
+            cache_k_ref = cache_k.cpu().float()
+            cache_v_ref = cache_v.cpu().float()
+
+        # Drop the padding past the length of each sequence
+        seq_offsets = torch.zeros(B + 1, dtype=torch.int64, device="cuda")
+        seq_offsets[1:] = torch.cumsum(seq_positions.long() + 1, dim=0)
+        jagged_k = torch.cat([cache_k[b, : kv_seqlens[b]] for b in range(B)])
+        jagged_v = torch.cat([cache_v[b, : kv_seqlens[b]] for b in range(B)])
+        max_seq_len = int(max(kv_seqlens))
+
+        qk_scale = 1.0 / np.sqrt(D_H)
+        z_ref, _ = gqa_reference(
+            q.cpu().float(),
+            cache_k_ref,
+            cache_v_ref,
+            kv_seqlens,
+            qk_scale=qk_scale,
+        )
+
+        for split_k in [1, 2, 13]:
+            z, attn, _ = torch.ops.fbgemm.gqa_attn_splitk_jagged(
+                q,
+                jagged_k,
+                jagged_v,
+                seq_offsets,
+                max_seq_len,
+                qk_scale=qk_scale,
+                num_split_ks=split_k,
+                num_int4_kv_groups=num_groups,
+            )
+            self.assertEqual(attn.shape, (B, N_H_L, max_seq_len))
+            torch.testing.assert_close(
+                z.cpu().bfloat16(),
+                z_ref.cpu().bfloat16(),
+                atol=2.0e-2,
+                rtol=6.0e-3,
+            )
+
+    @unittest.skipIf(
+        not torch.version.cuda,
+        "Skip when CUDA is not available",
+    )
+    @settings(verbosity=VERBOSITY, max_examples=20, deadline=None)
+    # pyre-ignore
+    @given(
+        B=st.integers(min_value=1, max_value=32),
+        MAX_T=st.integers(min_value=4, max_value=512),
+        N_H_L=st.integers(min_value=1, max_value=32),
+        use_tensor_cores=st.booleans(),
+    )
+    def test_gqa_fp8(
+        self,
+        B: int,
+        MAX_T: int,
+        N_H_L: int,
+        use_tensor_cores: bool,
+    ) -> None:
+        """
+        Test correctness of torch.ops.fbgemm.gqa_attn_splitk with a FP8 KV
+        cache against the reference GQA implementation on the dequantized
+        cache
+        """
+        D_H = 128
+        N_KVH_L = 1
+
+        seq_positions = torch.randint(0, MAX_T, (B,), device="cuda").int()
+        kv_seqlens = [seq_position + 1 for seq_position in seq_positions]
+        q = torch.randn((B, 1, N_H_L, D_H), dtype=torch.bfloat16, device="cuda")
+        cache_k, cache_k_scales = quant_fp8_per_token(
+            torch.randn((B, MAX_T, N_KVH_L, D_H), device="cuda")
+        )
+        cache_v, cache_v_scales = quant_fp8_per_token(
+            torch.randn((B, MAX_T, N_KVH_L, D_H), device="cuda")
+        )
+        cache_k_ref = (cache_k.float() * cache_k_scales.unsqueeze(-1)).cpu()
+        cache_v_ref = (cache_v.float() * cache_v_scales.unsqueeze(-1)).cpu()
+
+        qk_scale = 1.0 / np.sqrt(D_H)
+        z_ref, _ = gqa_reference(
+            q.cpu().float(),
+            cache_k_ref,
+            cache_v_ref,
+            kv_seqlens,
+            qk_scale=qk_scale,
+        )
+
+        for split_k in [1, 2, 13]:
+            z, _, _ = torch.ops.fbgemm.gqa_attn_splitk(
+                q,
+                cache_k,
+                cache_v,
+                seq_positions,
+                qk_scale=qk_scale,
+                num_split_ks=split_k,
+                use_tensor_cores=use_tensor_cores,
+                cache_K_scales=cache_k_scales,
+                cache_V_scales=cache_v_scales,
+            )
+            torch.testing.assert_close(
+                z.cpu().bfloat16(),
+                z_ref.cpu().bfloat16(),
+                atol=2.0e-2,
+                rtol=6.0e-3,
+            )
@@ -193,13 +193,51 @@ class FP8Tests(unittest.TestCase):
             zq_ref += bias
         torch.testing.assert_close(zq, zq_ref, atol=8.0e-2, rtol=8.0e-2)
 
+    @unittest.skipIf(
+        not torch.version.cuda, "Skip on AMD: built in quantize ops not yet suported."
+    )
+    @settings(deadline=None)
+    @given(
+        M=st.sampled_from([1, 16, 64]),
+        N=st.sampled_from([1024, 8192]),
+        K=st.sampled_from([2048, 8192]),
+        Bias=st.sampled_from([True, False]),
+        use_fast_accum=st.booleans(),
+    )
+    def test_f8f8bf16_rowwise_skinny(
+        self, M: int, N: int, K: int, Bias: bool, use_fast_accum: bool
+    ) -> None:
+        # Decode shapes that are dispatched to the stream-K kernel.
+        x = torch.randn(size=(M, K), dtype=torch.bfloat16, device="cuda") * 0.1
+        w = torch.randn(size=(N, K), dtype=torch.bfloat16, device="cuda") * 0.01
+        bias = (
+            torch.randn(size=(N,), dtype=torch.bfloat16, device="cuda")
+            if Bias
+            else None
+        )
+        xq, x_scale = torch.ops.fbgemm.quantize_fp8_per_row(x)
+        wq, w_scale = torch.ops.fbgemm.quantize_fp8_per_row(w)
+        zq = torch.ops.fbgemm.f8f8bf16_rowwise(
+            xq, wq, x_scale, w_scale, bias=bias, use_fast_accum=use_fast_accum
+        )
+
+        # Fake quant
+        x = xq.float() * x_scale.unsqueeze(1)
+        w = wq.float() * w_scale.unsqueeze(1)
+        zq_ref = x @ w.T
+        if bias is not None:
+            zq_ref += bias.float()
+        torch.testing.assert_close(zq.float(), zq_ref, atol=1.0e-2, rtol=1.0e-2)
+
     @unittest.skipIf(
         not torch.version.cuda, "Skip on AMD: built in quantize ops not yet suported."
     )
     @settings(deadline=None)
     @given(
         B_T=st.sampled_from([2048, 4096]),
-        D=st.sampled_from([128, 256]),
+        # Wide rows exceed the shared memory budget of the rowwise kernel and
+        # rows with D % 8 != 0 cannot use its vectorized single pass path.
+        D=st.sampled_from([128, 256, 4100, 20480]),
         Mode=st.sampled_from(["tensorwise", "rowwise", "colwise"]),
     )
     def test_quantize_fp8_per_tensor_row_col(self, B_T: int, D: int, Mode: str) -> None:
@@ -303,5 +341,103 @@ class FP8Tests(unittest.TestCase):
         torch.testing.assert_close(zq, zq_ref, atol=1.0e-3, rtol=1.0e-3)
 
 
+    @unittest.skipIf(
+        torch.version.hip is not None, "Grouped FP8 GEMM is not supported on AMD."
+    )
+    @settings(deadline=None)
+    @given(
+        G=st.sampled_from([1, 4, 8]),
+        N=st.sampled_from([256, 1024]),
+        K=st.sampled_from([128, 512]),
+        use_fast_accum=st.booleans(),
+    )
+    def test_f8f8bf16_rowwise_grouped(
+        self, G: int, N: int, K: int, use_fast_accum: bool
+    ) -> None:
+        # Uneven expert sizes, including experts that receive no tokens.
+        m_sizes = torch.randint(0, 300, (G,))
+        if G > 1:
+            m_sizes[0] = 0
+        m_offsets = torch.zeros(G + 1, dtype=torch.int64)
+        m_offsets[1:] = torch.cumsum(m_sizes, dim=0)
+        total_M = int(m_offsets[-1].item())
+        # Trailing rows that belong to no expert must come out as zeros.
+        padded_M = total_M + 7
+
+        x = torch.randn(size=(padded_M, K), dtype=torch.bfloat16, device="cuda") * 0.1
+        w = torch.randn(size=(G, N, K), dtype=torch.bfloat16, device="cuda") * 0.01
+        xq, x_scale = torch.ops.fbgemm.quantize_fp8_per_row(x)
+        wq, w_scale = torch.ops.fbgemm.quantize_fp8_per_row(w.view(G * N, K))
+
+        zq = torch.ops.fbgemm.f8f8bf16_rowwise_grouped(
+            xq,
+            wq.view(G, N, K),
+            x_scale,
+            w_scale.view(G, N),
+            m_offsets.cuda(),
+            use_fast_accum=use_fast_accum,
+        )
+
+        zq_ref = torch.zeros(size=(padded_M, N), dtype=torch.bfloat16, device="cuda")
+        for g in range(G):
+            start, end = int(m_offsets[g]), int(m_offsets[g + 1])
+            if start == end:
+                continue
+            zq_ref[start:end] = torch.ops.fbgemm.f8f8bf16_rowwise(
+                xq[start:end],
+                wq[g * N : (g + 1) * N],
+                x_scale[start:end],
+                w_scale[g * N : (g + 1) * N],
+                use_fast_accum=use_fast_accum,
+            )
+        torch.testing.assert_close(zq, zq_ref, atol=8.0e-3, rtol=8.0e-3)
+
+    @unittest.skipIf(
+        not torch.version.cuda, "Skip on AMD: built in quantize ops not yet suported."
+    )
+    @settings(deadline=None)
+    @given(
+        M=st.sampled_from([16, 2048]),
+        I=st.sampled_from([256, 1024]),
+        D=st.sampled_from([128, 512]),
+        Bias=st.sampled_from([True, False]),
+    )
+    def test_fp8_ffn_fused_epilogues(self, M: int, I: int, D: int, Bias: bool) -> None:
+        x = torch.randn(size=(M, D), dtype=torch.bfloat16, device="cuda") * 0.1
+        w13 = torch.randn(size=(2 * I, D), dtype=torch.bfloat16, device="cuda") * 0.01
+        w2 = torch.randn(size=(D, I), dtype=torch.bfloat16, device="cuda") * 0.01
+        bias = (
+            torch.randn(size=(D,), dtype=torch.bfloat16, device="cuda")
+            if Bias
+            else None
+        )
+        xq, x_scale = torch.ops.fbgemm.quantize_fp8_per_row(x)
+        w13q, w13_scale = torch.ops.fbgemm.quantize_fp8_per_row(w13)
+        w2q, w2_scale = torch.ops.fbgemm.quantize_fp8_per_row(w2)
+
+        # SwiGLU on the gate and up halves of the up projection.
+        h = torch.ops.fbgemm.f8f8bf16_rowwise(xq, w13q, x_scale, w13_scale)
+        hq, h_scale = torch.ops.fbgemm.silu_mul_quantize_fp8_per_row(
+            h[:, :I], h[:, I:]
+        )
+        hq_ref, h_scale_ref = torch.ops.fbgemm.quantize_fp8_per_row(
+            (torch.nn.functional.silu(h[:, :I]) * h[:, I:]).contiguous()
+        )
+        torch.testing.assert_close(h_scale, h_scale_ref, atol=1.0e-3, rtol=1.0e-2)
+        torch.testing.assert_close(
+            hq.float(), hq_ref.float(), atol=5.0e-2, rtol=5.0e-2
+        )
+
+        # Down projection with the residual added in the epilogue.
+        zq = torch.ops.fbgemm.f8f8bf16_rowwise(
+            hq, w2q, h_scale, w2_scale, bias=bias, residual=x
+        )
+        zq_ref = torch.ops.fbgemm.f8f8bf16_rowwise(
+            hq, w2q, h_scale, w2_scale, bias=bias
+        )
+        torch.testing.assert_close(
+            zq.float(), zq_ref.float() + x.float(), atol=2.0e-2, rtol=2.0e-2
+        )
+
 if __name__ == "__main__":
     unittest.main()
@@ -156,5 +156,68 @@ class BatchAucJiterator(torch.nn.Module):
 def auc(
     n_tasks: int, predictions: torch.Tensor, labels: torch.Tensor, weights: torch.Tensor
 ) -> torch.Tensor:
-    _, sorted_indices = torch.sort(predictions, descending=True, dim=-1)
+    if predictions.is_cpu:
+        sorted_indices = torch.ops.fbgemm.batch_auc_argsort(predictions)
+    else:
+        _, sorted_indices = torch.sort(predictions, descending=True, dim=-1)
     return torch.ops.fbgemm.batch_auc(n_tasks, sorted_indices, labels, weights)
+
+
+class StreamingAuc(torch.nn.Module):
+    """
+    Approximates the AUC of a stream of batches in O(num_bins) memory.
+
+    Every update adds the weighted negatives and positives of the batch to a
+    [n_tasks, 2, num_bins] float64 histogram over the [0, 1] range of the
+    predictions. The histograms of several modules (e.g. one per rank) can be
+    summed with `merge` or `all_reduce` before calling `compute`. Predictions
+    that fall in the same bin are treated as ties, so the result matches the
+    exact AUC up to the bin resolution.
+    """
+
+    def __init__(self, n_tasks: int, num_bins: int = 2048) -> None:
+        super().__init__()
+        self.n_tasks = n_tasks
+        self.num_bins = num_bins
+        self.register_buffer(
+            "histogram", torch.zeros(n_tasks, 2, num_bins, dtype=torch.double)
+        )
+
+    def update(
+        self,
+        predictions: torch.Tensor,
+        labels: torch.Tensor,
+        weights: torch.Tensor,
+    ) -> None:
+        torch.ops.fbgemm.auc_histogram_update(
+            self.histogram, predictions, labels, weights
+        )
+
+    def reset(self) -> None:
+        self.histogram.zero_()
+
+    def merge(self, other: "StreamingAuc") -> None:
+        self.histogram.add_(other.histogram)
+
+    def all_reduce(self, group: Any = None) -> None:
+        torch.distributed.all_reduce(self.histogram, group=group)
+
+    def compute(self) -> torch.Tensor:
+        # Walk the bins from the highest predictions down
+        histogram = self.histogram.flip(-1)
+        cum_fp = torch.cumsum(histogram[:, 0], dim=-1)
+        cum_tp = torch.cumsum(histogram[:, 1], dim=-1)
+        origin = cum_fp.new_zeros(self.n_tasks, 1)
+        cum_fp = torch.cat([origin, cum_fp], dim=-1)
+        cum_tp = torch.cat([origin, cum_tp], dim=-1)
+        fac = cum_fp[:, -1] * cum_tp[:, -1]
+        return torch.where(fac == 0, 0.5, torch.trapz(cum_tp, cum_fp, dim=-1) / fac)
+
+    def forward(
+        self,
+        predictions: torch.Tensor,
+        labels: torch.Tensor,
+        weights: torch.Tensor,
+    ) -> torch.Tensor:
+        self.update(predictions, labels, weights)
+        return self.compute()
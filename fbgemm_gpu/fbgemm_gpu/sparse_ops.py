@@ -296,6 +296,18 @@ def pruned_array_lookup_meta(
     return indices.new_empty(indices.shape)
 
 
+@impl_abstract("fbgemm::pruned_bitmap_lookup")
+def pruned_bitmap_lookup_meta(
+    indices: Tensor,
+    offsets: Tensor,
+    bitmap: Tensor,
+    ranks: Tensor,
+    bitmap_offsets: Tensor,
+) -> Tensor:
+    check_all_same_device(indices, offsets, bitmap, ranks, bitmap_offsets)
+    return indices.new_empty(indices.shape)
+
+
 @impl_abstract("fbgemm::int_nbit_split_embedding_codegen_lookup_function")
 def int_nbit_split_embedding_codegen_lookup_function_meta(
     dev_weights: torch.Tensor,
@@ -489,6 +501,21 @@ def dense_to_jagged(
     return (dense_to_jagged_forward(dense, offsets, total_L), offsets)
 
 
+@impl_abstract("fbgemm::jagged_attention_forward")
+def jagged_attention_forward_abstract(
+    q_values: Tensor,
+    k_values: Tensor,
+    v_values: Tensor,
+    x_offsets: Tensor,
+    max_L: int,
+    scale: float = 1.0,
+) -> Tensor:
+    torch._check(q_values.dim() == 2)
+    torch._check(k_values.size() == q_values.size())
+    torch._check(v_values.size(0) == q_values.size(0))
+    return v_values.new_empty([q_values.size(0), v_values.size(1)])
+
+
 @impl_abstract("fbgemm::batch_index_select_dim0")
 def batch_index_select_dim0_abstract(
     inputs: torch.Tensor,
@@ -10,8 +10,11 @@
 # pyre-ignore-all-errors[56]
 
 import enum
-from dataclasses import dataclass
-from typing import List, NamedTuple
+from dataclasses import dataclass, field
+from typing import List, NamedTuple, Optional, Tuple
+
+import torch
+from torch import Tensor
 
 
 # Maximum number of times prefetch() can be called without
@@ -129,6 +132,104 @@ def construct_cache_state(
     return s
 
 
+class UVMAdvicePolicy(NamedTuple):
+    # Bytes of UVM tables that get the device as preferred location. The
+    # tables with the most reads per byte are chosen first, the others keep
+    # the host as preferred location.
+    device_bytes_budget: int = 0
+
+    # Tables written at most this fraction of their reads are set read-mostly,
+    # which duplicates their pages on the device instead of migrating them.
+    # Writing a read-mostly page invalidates all its copies, so the default
+    # only picks the tables that are never written (e.g. frozen tables).
+    read_mostly_max_write_ratio: float = 0.0
+
+    # Row ranges are prefetched ahead of the forward at this granularity
+    prefetch_granularity_bytes: int = 2 * 1024 * 1024
+
+    # Chunks read at least this fraction of the reads of the hottest chunk of
+    # the table are prefetched
+    hot_chunk_min_fraction: float = 0.1
+
+    # Upper bound of the bytes prefetched per table and batch
+    max_prefetch_bytes_per_table: int = 64 * 1024 * 1024
+
+
+@dataclass
+class UVMTableAccessStats:
+    # [rows] number of reads of each row over the observed batches
+    row_reads: Tensor
+    # Number of row writes over the same batches
+    num_writes: int = 0
+
+
+@dataclass
+class UVMTableAdvice:
+    prefer_device: bool = False
+    read_mostly: bool = False
+    # [start, end) row ranges to prefetch ahead of the forward
+    prefetch_row_ranges: List[Tuple[int, int]] = field(default_factory=list)
+
+
+def plan_uvm_advice(
+    row_bytes: List[int],
+    access_stats: List[Optional[UVMTableAccessStats]],
+    policy: UVMAdvicePolicy,
+) -> List[Optional[UVMTableAdvice]]:
+    """
+    Plans the memory advice and prefetched row ranges of UVM tables from their
+    access statistics, row_bytes being the bytes of a row of each table. The
+    tables without statistics get no advice.
+    """
+    advice: List[Optional[UVMTableAdvice]] = [None] * len(access_stats)
+    reads_per_byte: List[Tuple[float, int]] = []
+    for t, stats in enumerate(access_stats):
+        if stats is None:
+            continue
+        rows = stats.row_reads.numel()
+        num_reads = int(stats.row_reads.sum().item())
+        table_advice = UVMTableAdvice(
+            read_mostly=num_reads > 0
+            and stats.num_writes <= policy.read_mostly_max_write_ratio * num_reads,
+        )
+        if num_reads > 0:
+            reads_per_byte.append((num_reads / max(1, rows * row_bytes[t]), t))
+
+        # Merge the hottest chunks of rows into ranges
+        chunk_rows = max(1, policy.prefetch_granularity_bytes // row_bytes[t])
+        num_chunks = (rows + chunk_rows - 1) // chunk_rows
+        if num_reads > 0 and policy.max_prefetch_bytes_per_table > 0:
+            chunk_reads = torch.zeros(num_chunks * chunk_rows, dtype=torch.int64)
+            chunk_reads[:rows] = stats.row_reads.cpu().long()
+            chunk_reads = chunk_reads.view(num_chunks, chunk_rows).sum(dim=1)
+            max_chunks = max(
+                1, policy.max_prefetch_bytes_per_table // (chunk_rows * row_bytes[t])
+            )
+            hot_reads, hot_chunks = chunk_reads.sort(descending=True)
+            hot = hot_reads >= max(
+                1, policy.hot_chunk_min_fraction * hot_reads[0].item()
+            )
+            chunks = sorted(hot_chunks[hot][:max_chunks].tolist())
+            for c in chunks:
+                ranges = table_advice.prefetch_row_ranges
+                start, end = c * chunk_rows, min(rows, (c + 1) * chunk_rows)
+                if ranges and ranges[-1][1] == start:
+                    ranges[-1] = (ranges[-1][0], end)
+                else:
+                    ranges.append((start, end))
+        advice[t] = table_advice
+
+    budget = policy.device_bytes_budget
+    for _, t in sorted(reads_per_byte, reverse=True):
+        stats, table_advice = access_stats[t], advice[t]
+        assert stats is not None and table_advice is not None
+        table_bytes = stats.row_reads.numel() * row_bytes[t]
+        if table_bytes <= budget:
+            table_advice.prefer_device = True
+            budget -= table_bytes
+    return advice
+
+
 # NOTE: This is also defined in fbgemm_gpu.split_embedding_utils, but declaring
 # target dependency on :split_embedding_utils will result in compatibility
 # breakage with Caffe2 module_factory because it will pull in numpy
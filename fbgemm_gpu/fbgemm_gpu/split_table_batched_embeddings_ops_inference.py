@@ -192,6 +192,7 @@ class IntNBitTableBatchedEmbeddingBagsCodegen(nn.Module):
         uvm_host_mapped: bool = False,  # True to use cudaHostAlloc; False to use cudaMallocManaged.
         reverse_qparam: bool = False,  # True to load qparams at end of each row; False to load qparam at begnning of each row.
         feature_names_per_table: Optional[List[List[str]]] = None,
+        use_bitmap_for_index_remapping: bool = False,  # True to store array remappings as rank bitmaps (~1 bit per original row); kept rows must map in increasing order to 0, 1, ...
     ) -> None:  # noqa C901  # tuple of (rows, dims,)
         super(IntNBitTableBatchedEmbeddingBagsCodegen, self).__init__()
 
@@ -382,6 +383,18 @@ class IntNBitTableBatchedEmbeddingBagsCodegen(nn.Module):
             "index_remapping_hash_table",
             torch.empty(0, device=self.current_device, dtype=torch.int32),
         )
+        self.register_buffer(
+            "index_remapping_bitmap_offsets",
+            torch.empty(0, device=self.current_device, dtype=torch.int64),
+        )
+        self.register_buffer(
+            "index_remapping_bitmap",
+            torch.empty(0, device=self.current_device, dtype=torch.int32),
+        )
+        self.register_buffer(
+            "index_remapping_bitmap_ranks",
+            torch.empty(0, device=self.current_device, dtype=torch.int32),
+        )
         self.register_buffer(
             "original_rows_per_table",
             torch.empty(0, device=self.current_device, dtype=torch.int64),
@@ -391,7 +404,10 @@ class IntNBitTableBatchedEmbeddingBagsCodegen(nn.Module):
 
         if index_remapping:
             self.set_index_remappings(
-                index_remapping, pruning_hash_load_factor, use_array_for_index_remapping
+                index_remapping,
+                pruning_hash_load_factor,
+                use_array_for_index_remapping,
+                use_bitmap_for_index_remapping,
             )
 
         # Currently only support cache_precision == embedding_precision.
@@ -579,6 +595,26 @@ class IntNBitTableBatchedEmbeddingBagsCodegen(nn.Module):
             raise ValueError(f"{self.cache_assoc} not in [1, 32, 64]")
 
     def prefetch_32way(self, linear_cache_indices: Tensor) -> None:
+        self._populate_cache_32way(linear_cache_indices, self.gather_uvm_cache_stats)
+
+        assert (
+            self.lxu_cache_locations_list.size() < self.max_prefetch_depth
+        ), f"self.lxu_cache_locations_list has grown to size: {self.lxu_cache_locations_list.size()}, this exceeds the maximum: {self.max_prefetch_depth}. This probably indicates an error in logic where prefetch() is being called more frequently than forward()"
+        self.lxu_cache_locations_list.push(
+            torch.ops.fbgemm.lxu_cache_lookup(
+                linear_cache_indices,
+                self.lxu_cache_state,
+                self.total_cache_hash_size,
+                self.gather_uvm_cache_stats,
+                self.local_uvm_cache_stats,
+            )
+        )
+        if self.gather_uvm_cache_stats:
+            self._accumulate_uvm_cache_stats()
+
+    def _populate_cache_32way(
+        self, linear_cache_indices: Tensor, gather_cache_stats: bool
+    ) -> None:
         if self.cache_algorithm == CacheAlgorithm.LRU:
             torch.ops.fbgemm.lru_cache_populate_byte(
                 self.weights_uvm,
@@ -594,7 +630,7 @@ class IntNBitTableBatchedEmbeddingBagsCodegen(nn.Module):
                 self.timestep_counter.get(),
                 self.lxu_state,
                 16,  # row_alignment; using default value.
-                self.gather_uvm_cache_stats,
+                gather_cache_stats,
                 self.local_uvm_cache_stats,
             )
         elif self.cache_algorithm == CacheAlgorithm.LFU:
@@ -612,11 +648,14 @@ class IntNBitTableBatchedEmbeddingBagsCodegen(nn.Module):
                 self.lxu_state,
             )
 
+    def prefetch_1way(self, linear_cache_indices: Tensor) -> None:
+        self._populate_cache_1way(linear_cache_indices, self.gather_uvm_cache_stats)
+
         assert (
             self.lxu_cache_locations_list.size() < self.max_prefetch_depth
         ), f"self.lxu_cache_locations_list has grown to size: {self.lxu_cache_locations_list.size()}, this exceeds the maximum: {self.max_prefetch_depth}. This probably indicates an error in logic where prefetch() is being called more frequently than forward()"
         self.lxu_cache_locations_list.push(
-            torch.ops.fbgemm.lxu_cache_lookup(
+            torch.ops.fbgemm.direct_mapped_lxu_cache_lookup(
                 linear_cache_indices,
                 self.lxu_cache_state,
                 self.total_cache_hash_size,
@@ -627,7 +666,9 @@ class IntNBitTableBatchedEmbeddingBagsCodegen(nn.Module):
         if self.gather_uvm_cache_stats:
             self._accumulate_uvm_cache_stats()
 
-    def prefetch_1way(self, linear_cache_indices: Tensor) -> None:
+    def _populate_cache_1way(
+        self, linear_cache_indices: Tensor, gather_cache_stats: bool
+    ) -> None:
         if self.cache_algorithm == CacheAlgorithm.LRU:
             torch.ops.fbgemm.direct_mapped_lru_cache_populate_byte(
                 self.weights_uvm,
@@ -644,26 +685,52 @@ class IntNBitTableBatchedEmbeddingBagsCodegen(nn.Module):
                 self.lxu_state,
                 self.lxu_cache_miss_timestamp,
                 16,  # row_alignment; using default value.
-                self.gather_uvm_cache_stats,
+                gather_cache_stats,
                 self.local_uvm_cache_stats,
             )
         else:
             raise ValueError("Direct Mapped for LRU only")
 
-        assert (
-            self.lxu_cache_locations_list.size() < self.max_prefetch_depth
-        ), f"self.lxu_cache_locations_list has grown to size: {self.lxu_cache_locations_list.size()}, this exceeds the maximum: {self.max_prefetch_depth}. This probably indicates an error in logic where prefetch() is being called more frequently than forward()"
-        self.lxu_cache_locations_list.push(
-            torch.ops.fbgemm.direct_mapped_lxu_cache_lookup(
-                linear_cache_indices,
-                self.lxu_cache_state,
-                self.total_cache_hash_size,
-                self.gather_uvm_cache_stats,
-                self.local_uvm_cache_stats,
-            )
+    @torch.jit.export
+    def get_cache_hot_indices(self) -> Tensor:
+        """
+        Returns the linear cache indices of the rows in the cache, the most
+        recently (LRU) or most frequently (LFU) used first. They can warm
+        start the cache of a module with the same tables, see
+        warm_start_cache().
+        """
+        if not self.lxu_cache_weights.numel():
+            return torch.empty(0, device=self.current_device, dtype=torch.int64)
+        cache_state = self.lxu_cache_state.view(-1)
+        cached = cache_state != -1
+        hot_indices = cache_state[cached]
+        if self.cache_algorithm == CacheAlgorithm.LRU:
+            scores = self.lxu_state.view(-1)[cached]
+        else:
+            scores = self.lxu_state[hot_indices]
+        return hot_indices[torch.argsort(scores, descending=True)]
+
+    @torch.jit.export
+    def warm_start_cache(self, linear_cache_indices: Tensor) -> None:
+        """
+        Loads the rows of `linear_cache_indices` into the cache with a single
+        populate, e.g. the get_cache_hot_indices() of the module this one
+        replaces, so that the first batches after a model swap do not all
+        miss the cache. The rows are read from the weights of this module;
+        with the same cache sets as the snapshotted module, all the rows fit.
+        """
+        if not self.lxu_cache_weights.numel() or linear_cache_indices.numel() == 0:
+            return
+        linear_cache_indices = linear_cache_indices.to(
+            device=self.current_device, dtype=torch.int64
         )
-        if self.gather_uvm_cache_stats:
-            self._accumulate_uvm_cache_stats()
+        self.timestep_counter.increment()
+        if self.cache_assoc in [32, 64]:
+            self._populate_cache_32way(linear_cache_indices, False)
+        elif self.cache_assoc == 1:
+            self._populate_cache_1way(linear_cache_indices, False)
+        else:
+            raise ValueError(f"{self.cache_assoc} not in [1, 32, 64]")
 
     def _accumulate_uvm_cache_stats(self) -> None:
         # Accumulate local_uvm_cache_stats (int32) into uvm_cache_stats (int64).
@@ -753,6 +820,7 @@ class IntNBitTableBatchedEmbeddingBagsCodegen(nn.Module):
             self.index_remapping_hash_table_cpu is not None
             or self.index_remapping_hash_table.numel() > 0
             or self.index_remappings_array.numel() > 0
+            or self.index_remapping_bitmap.numel() > 0
         ):
             if self.bounds_check_mode_int != BoundsCheckMode.NONE.value:
                 torch.ops.fbgemm.bounds_check_indices(
@@ -764,6 +832,45 @@ class IntNBitTableBatchedEmbeddingBagsCodegen(nn.Module):
                     per_sample_weights,
                 )
 
+        # On CPU, array remapping is done by the lookup itself while it pools,
+        # which avoids writing and reading back a remapped index tensor. Its
+        # kernels fail on out of bound remapped indices, so the second bound
+        # check is only skipped when it would not fix them.
+        if (
+            self.use_cpu
+            and self.index_remapping_hash_table_cpu is None
+            and self.index_remappings_array.numel() > 0
+            and self.index_remappings_array_offsets.numel() == self.D_offsets.numel()
+            and self.lxu_cache_weights.numel() == 0
+            and self.bounds_check_mode_int
+            in (BoundsCheckMode.NONE.value, BoundsCheckMode.FATAL.value)
+        ):
+            return torch.ops.fbgemm.int_nbit_split_embedding_codegen_lookup_function_remapped(
+                dev_weights=self.weights_host if self.host_size > 0 else self.weights_dev,
+                uvm_weights=self.weights_uvm,
+                weights_placements=self.weights_placements,
+                weights_offsets=self.weights_offsets,
+                weights_tys=self.weights_tys,
+                D_offsets=self.D_offsets,
+                total_D=self.total_D,
+                max_int2_D=self.max_int2_D,
+                max_int4_D=self.max_int4_D,
+                max_int8_D=self.max_int8_D,
+                max_float16_D=self.max_float16_D,
+                max_float32_D=self.max_float32_D,
+                indices=indices,
+                offsets=offsets,
+                pooling_mode=int(self.pooling_mode),
+                indice_weights=per_sample_weights,
+                output_dtype=self.output_dtype,
+                row_alignment=self.row_alignment,
+                max_float8_D=self.max_float8_D,
+                fp8_exponent_bits=self.fp8_exponent_bits,
+                fp8_exponent_bias=self.fp8_exponent_bias,
+                index_remappings=self.index_remappings_array,
+                index_remappings_offsets=self.index_remappings_array_offsets,
+            )
+
         # Index remapping changes input indices, and some of them becomes -1 (prunned rows).
         # Hence, remapping should be done before prefetch and emb lookup
         # so that these operations are with the remapped indices.
@@ -784,6 +891,14 @@ class IntNBitTableBatchedEmbeddingBagsCodegen(nn.Module):
                 self.index_remappings_array,
                 self.index_remappings_array_offsets,
             )
+        elif self.index_remapping_bitmap.numel() > 0:
+            indices = torch.ops.fbgemm.pruned_bitmap_lookup(
+                indices,
+                offsets,
+                self.index_remapping_bitmap,
+                self.index_remapping_bitmap_ranks,
+                self.index_remapping_bitmap_offsets,
+            )
         if self.lxu_cache_weights.numel() > 0:
             if self.timestep_prefetch_size.get() <= 0:
                 self.prefetch(indices, offsets)
@@ -955,6 +1070,15 @@ class IntNBitTableBatchedEmbeddingBagsCodegen(nn.Module):
         self.index_remappings_array_offsets = torch.empty_like(
             self.index_remappings_array_offsets, device=self.current_device
         )
+        self.index_remapping_bitmap = torch.empty_like(
+            self.index_remapping_bitmap, device=self.current_device
+        )
+        self.index_remapping_bitmap_ranks = torch.empty_like(
+            self.index_remapping_bitmap_ranks, device=self.current_device
+        )
+        self.index_remapping_bitmap_offsets = torch.empty_like(
+            self.index_remapping_bitmap_offsets, device=self.current_device
+        )
         self.lxu_cache_weights = torch.empty_like(
             self.lxu_cache_weights, device=self.current_device
         )
@@ -1499,6 +1623,7 @@ class IntNBitTableBatchedEmbeddingBagsCodegen(nn.Module):
         index_remapping: List[Tensor],
         pruning_hash_load_factor: float = 0.5,
         use_array_for_index_remapping: bool = True,
+        use_bitmap_for_index_remapping: bool = False,
     ) -> None:
         rows: List[int] = [e[1] for e in self.embedding_specs]
         T = len(self.embedding_specs)
@@ -1564,6 +1689,20 @@ class IntNBitTableBatchedEmbeddingBagsCodegen(nn.Module):
         # Array mapping pruning
         else:
             self.set_index_remappings_array(index_remapping)
+            if use_bitmap_for_index_remapping and self.index_remappings_array.numel():
+                bitmap, ranks, bitmap_offsets = torch.ops.fbgemm.pruned_bitmap_build(
+                    self.index_remappings_array.cpu(),
+                    self.index_remappings_array_offsets.cpu(),
+                )
+                self.index_remapping_bitmap = bitmap.to(self.current_device)
+                self.index_remapping_bitmap_ranks = ranks.to(self.current_device)
+                self.index_remapping_bitmap_offsets = bitmap_offsets.to(
+                    self.current_device
+                )
+                # The bitmap replaces the array, which forward() would use first
+                self.index_remappings_array = torch.empty(
+                    0, dtype=torch.int32, device=self.current_device
+                )
 
     def _embedding_inplace_update_per_table(
         self,
@@ -1645,6 +1784,7 @@ class IntNBitTableBatchedEmbeddingBagsCodegen(nn.Module):
         # Only support array based pruning for now.
         assert self.index_remapping_hash_table_cpu is None
         assert self.index_remapping_hash_table.numel() == 0
+        assert self.index_remapping_bitmap.numel() == 0
         assert self.index_remappings_array.numel() >= 0
 
         if self.index_remappings_array.numel() > 0:
@@ -39,8 +39,12 @@ from fbgemm_gpu.split_table_batched_embeddings_ops_common import (
     MAX_PREFETCH_DEPTH,
     MultiPassPrefetchConfig,
     PoolingMode,
+    plan_uvm_advice,
     RecordCacheMetrics,
     SplitState,
+    UVMAdvicePolicy,
+    UVMTableAccessStats,
+    UVMTableAdvice,
 )
 
 try:
@@ -69,6 +73,12 @@ except Exception:
 
 DEFAULT_ASSOC = 32 if torch.version.hip is None else 64
 INT8_EMB_ROW_DIM_OFFSET = 8
+# Keep in sync with kAdmissionSketchDepth in
+# fbgemm_gpu/include/fbgemm_gpu/split_embeddings_cache_cuda.cuh
+ADMISSION_SKETCH_DEPTH = 4
+# The counters of the admission sketch are halved after this many requested
+# indices per cache line
+ADMISSION_SKETCH_SAMPLES_PER_CACHE_LINE = 10
 
 
 class DoesNotHavePrefix(Exception):
@@ -141,6 +151,23 @@ class UVMCacheStatsIndex(enum.IntEnum):
     num_unique_misses = 3
     num_conflict_unique_misses = 4
     num_conflict_misses = 5
+    num_rejected_unique_misses = 6
+
+
+class CacheTelemetryIndex(enum.IntEnum):
+    # Populates sampled by cache_telemetry_sample_period
+    num_sampled_batches = 0
+    # Unique misses inserted into an empty slot
+    num_cold_misses = 1
+    # Unique misses inserted by evicting a cached row
+    num_capacity_misses = 2
+    # Unique misses not inserted, their set being full of rows in use
+    num_conflict_misses = 3
+
+
+# Bin b of the unique indices per batch histogram counts the batches of
+# [2^b, 2^(b+1)) unique indices, bin 0 including the empty batches
+CACHE_TELEMETRY_HISTOGRAM_BINS = 32
 
 
 def construct_split_state(
@@ -391,6 +418,21 @@ class SplitTableBatchedEmbeddingBagsCodegen(nn.Module):
         table_names: Optional[List[str]] = None,
         optimizer_state_dtypes: Optional[Dict[str, SparseType]] = None,
         multipass_prefetch_config: Optional[MultiPassPrefetchConfig] = None,
+        # set to True to sort the indices for the CPU backward pass and
+        # optimizer update in the forward pass
+        cache_csc_plan: bool = False,
+        # set to True to let every CPU thread sum the gradients of its rows and
+        # update them without sorting the indices. Faster on skewed indices,
+        # but not deterministic
+        hogwild_backward: bool = False,
+        # set to True to admit a row missed by the LRU cache only if it is more
+        # frequently accessed than the row it would evict (TinyLFU), the
+        # accesses being counted in a count-min sketch on device
+        cache_admission_filter: bool = False,
+        # gather the cache telemetry of one prefetch every
+        # cache_telemetry_sample_period, 0 to disable it. See
+        # get_cache_telemetry()
+        cache_telemetry_sample_period: int = 0,
     ) -> None:
         super(SplitTableBatchedEmbeddingBagsCodegen, self).__init__()
         self.uuid = str(uuid.uuid4())
@@ -402,6 +444,10 @@ class SplitTableBatchedEmbeddingBagsCodegen(nn.Module):
             not prefetch_pipeline or cache_algorithm == CacheAlgorithm.LRU
         ), "Only LRU cache policy supports prefetch_pipeline."
         self.prefetch_pipeline: bool = prefetch_pipeline
+        assert (
+            not cache_admission_filter or cache_algorithm == CacheAlgorithm.LRU
+        ), "Only LRU cache policy supports cache_admission_filter."
+        self.cache_admission_filter: bool = cache_admission_filter
         self.lock_cache_line: bool = self.prefetch_pipeline
         self.use_uniq_cache_locations_bwd: bool = self.prefetch_pipeline
         self.multipass_prefetch_config: Optional[MultiPassPrefetchConfig] = (
@@ -457,6 +503,17 @@ class SplitTableBatchedEmbeddingBagsCodegen(nn.Module):
             compute_devices[0] == ComputeDevice.CPU
             or compute_devices[0] == ComputeDevice.MTIA
         )
+        assert (
+            not cache_csc_plan or self.use_cpu
+        ), "cache_csc_plan is only supported by ComputeDevice.CPU"
+        self.cache_csc_plan: bool = cache_csc_plan
+        assert (
+            not hogwild_backward or self.use_cpu
+        ), "hogwild_backward is only supported by ComputeDevice.CPU"
+        assert not (
+            hogwild_backward and cache_csc_plan
+        ), "hogwild_backward does not sort the indices, cache_csc_plan must be False"
+        self.hogwild_backward: bool = hogwild_backward
 
         assert not self.use_cpu or all(
             loc == EmbeddingLocation.HOST for loc in locations
@@ -501,9 +558,10 @@ class SplitTableBatchedEmbeddingBagsCodegen(nn.Module):
         self.gather_uvm_cache_stats = gather_uvm_cache_stats
         # Define the size of uvm cache stats as class variable
         # to make it work with torch jit script.
-        self.uvm_cache_stats_size = 6
+        self.uvm_cache_stats_size = 7
         # 0: N_calls, 1: N_requested_indices, 2: N_unique_indices, 3: N_unique_misses,
-        # 4: N_conflict_unique_misses, 5: N_conflict_misses
+        # 4: N_conflict_unique_misses, 5: N_conflict_misses,
+        # 6: N_rejected_unique_misses
 
         # Reporter to collect runtime performance stats bottom-up. Reporter may
         # do aggregation across TBEs and publish results per training batch.
@@ -720,11 +778,17 @@ class SplitTableBatchedEmbeddingBagsCodegen(nn.Module):
             regularization_mode=weight_decay_mode.value,
         )
 
+        self.momentum1_row_dim_offset: int = 0
         if optimizer != OptimType.NONE:
             assert (
                 optimizer == OptimType.PARTIAL_ROWWISE_ADAM
                 or optimizer_state_dtypes is None
             ), "optimizer_state_dtypes option is only supported for OptimType.PARTIAL_ROWWISE_ADAM"
+            if optimizer_state_dtypes is not None:
+                # momentum2 is rowwise, so only momentum1 is worth quantizing
+                assert (
+                    optimizer_state_dtypes.get("momentum2") != SparseType.INT8
+                ), "INT8 optimizer state is only supported for momentum1"
             if optimizer in (OptimType.EXACT_SGD,):
                 # NOTE: make TorchScript work!
                 self._register_nonpersistent_buffers("momentum1")
@@ -740,11 +804,20 @@ class SplitTableBatchedEmbeddingBagsCodegen(nn.Module):
                 rowwise = optimizer in [
                     OptimType.EXACT_ROWWISE_ADAGRAD,
                 ]
+                # INT8 momentum1 rows are rowwise quantized and carry their
+                # qparams at the end of the row like INT8 weights
+                if momentum1_dtype == torch.uint8:
+                    self.momentum1_row_dim_offset = INT8_EMB_ROW_DIM_OFFSET
                 self._apply_split(
                     construct_split_state(
                         embedding_specs,
                         rowwise=rowwise,
                         cacheable=False,
+                        precision=(
+                            SparseType.INT8
+                            if momentum1_dtype == torch.uint8
+                            else SparseType.FP32
+                        ),
                         placement=(
                             EmbeddingLocation.MANAGED
                             if ((not rowwise) and uvm_non_rowwise_momentum)
@@ -888,6 +961,10 @@ class SplitTableBatchedEmbeddingBagsCodegen(nn.Module):
             cache_reserved_memory,
             dtype=cache_embedding_dtype,
         )
+        self._init_cache_telemetry(rows, locations, cache_telemetry_sample_period)
+        # [start, end) ranges of weights_uvm prefetched to the device ahead of
+        # the forward, see apply_uvm_advice()
+        self.uvm_prefetch_ranges: List[Tuple[int, int]] = []
 
         self.log(f"Contents: {table_names}")
         self.log(
@@ -1018,6 +1095,30 @@ class SplitTableBatchedEmbeddingBagsCodegen(nn.Module):
 
         return self.cache_miss_counter
 
+    @torch.jit.export
+    def get_cache_telemetry(self) -> Tuple[Tensor, Tensor, Tensor]:
+        """
+        Returns the cache telemetry gathered on device by the sampled
+        prefetches, see cache_telemetry_sample_period:
+
+        - the [num_tables, 2] requested and missed indices per table, in the
+          order of embedding_specs (zero for the tables not cached);
+        - the unique misses by kind, indexed by CacheTelemetryIndex;
+        - the CACHE_TELEMETRY_HISTOGRAM_BINS histogram of the number of
+          unique indices per batch.
+        """
+        return (
+            self.cache_telemetry_table_stats,
+            self.cache_telemetry_miss_stats,
+            self.cache_telemetry_unique_indices_histogram,
+        )
+
+    @torch.jit.export
+    def reset_cache_telemetry(self) -> None:
+        self.cache_telemetry_table_stats.zero_()
+        self.cache_telemetry_miss_stats.zero_()
+        self.cache_telemetry_unique_indices_histogram.zero_()
+
     @torch.jit.export
     def get_table_wise_cache_miss(self) -> Tensor:
         # table_wise_cache_miss contains all the cache miss count for each table in this embedding table object:
@@ -1304,6 +1405,8 @@ class SplitTableBatchedEmbeddingBagsCodegen(nn.Module):
             is_experimental=self.is_experimental,
             use_uniq_cache_locations_bwd=self.use_uniq_cache_locations_bwd,
             use_homogeneous_placements=self.use_homogeneous_placements,
+            cache_csc_plan=self.cache_csc_plan,
+            hogwild_backward=self.hogwild_backward,
         )
 
         if self.optimizer == OptimType.NONE:
@@ -1504,6 +1607,10 @@ class SplitTableBatchedEmbeddingBagsCodegen(nn.Module):
             / N,
             "conflict_misses": uvm_cache_stats[UVMCacheStatsIndex.num_conflict_misses]
             / N,
+            "rejected_unique_misses": uvm_cache_stats[
+                UVMCacheStatsIndex.num_rejected_unique_misses
+            ]
+            / N,
         }
         if uvm_cache_stats[1]:
             m.update(
@@ -1595,6 +1702,11 @@ class SplitTableBatchedEmbeddingBagsCodegen(nn.Module):
             self.timestep += 1
             self.timesteps_prefetched.append(self.timestep)
 
+        for start, end in self.uvm_prefetch_ranges:
+            torch.ops.fbgemm.cuda_mem_prefetch_async(
+                self.weights_uvm[start:end], None
+            )
+
         if not self.lxu_cache_weights.numel():
             return
 
@@ -1642,7 +1754,21 @@ class SplitTableBatchedEmbeddingBagsCodegen(nn.Module):
                         lxu_cache_locations, linear_cache_indices, offsets
                     )
 
+            sample_cache_telemetry = (
+                self.cache_telemetry_sample_period > 0
+                and self.timestep % self.cache_telemetry_sample_period == 0
+            )
+            cache_state_before_populate: Optional[Tensor] = None
+            num_unique_misses: Optional[Tensor] = None
+            if sample_cache_telemetry:
+                cache_state_before_populate = self.lxu_cache_state.clone()
+                num_unique_misses = self._gather_cache_telemetry_lookups(
+                    linear_cache_indices
+                )
+
             if self.cache_algorithm == CacheAlgorithm.LRU:
+                if self.cache_admission_filter:
+                    self._age_cache_admission_sketch(linear_cache_indices.numel())
                 torch.ops.fbgemm.lru_cache_populate(
                     self.weights_uvm,
                     self.cache_hash_size_cumsum,
@@ -1660,6 +1786,11 @@ class SplitTableBatchedEmbeddingBagsCodegen(nn.Module):
                     self.local_uvm_cache_stats,
                     self.lock_cache_line,
                     self.lxu_cache_locking_counter,
+                    (
+                        self.lxu_cache_admission_sketch
+                        if self.cache_admission_filter
+                        else None
+                    ),
                 )
             elif self.cache_algorithm == CacheAlgorithm.LFU:
                 torch.ops.fbgemm.lfu_cache_populate(
@@ -1676,6 +1807,14 @@ class SplitTableBatchedEmbeddingBagsCodegen(nn.Module):
                     self.stochastic_rounding,
                 )
 
+            if (
+                cache_state_before_populate is not None
+                and num_unique_misses is not None
+            ):
+                self._gather_cache_telemetry_populate(
+                    cache_state_before_populate, num_unique_misses
+                )
+
             torch.ops.fbgemm.lxu_cache_lookup(
                 linear_cache_indices,
                 self.lxu_cache_state,
@@ -1719,6 +1858,125 @@ class SplitTableBatchedEmbeddingBagsCodegen(nn.Module):
         for t in self.lxu_cache_locations_list:
             t.record_stream(forward_stream)
 
+    def _init_cache_telemetry(
+        self,
+        rows: List[int],
+        locations: List[EmbeddingLocation],
+        sample_period: int,
+    ) -> None:
+        self.cache_telemetry_sample_period = sample_period
+        # Linear cache index offsets of the tables, the tables not cached
+        # having no rows
+        table_offsets = [0] + list(
+            accumulate(
+                r if location == EmbeddingLocation.MANAGED_CACHING else 0
+                for r, location in zip(rows, locations)
+            )
+        )
+        self.register_buffer(
+            "cache_telemetry_table_offsets",
+            torch.tensor(table_offsets, device=self.current_device, dtype=torch.int64),
+            persistent=False,
+        )
+        self.register_buffer(
+            "cache_telemetry_table_stats",
+            torch.zeros(len(rows), 2, device=self.current_device, dtype=torch.int64),
+            persistent=False,
+        )
+        self.register_buffer(
+            "cache_telemetry_miss_stats",
+            torch.zeros(
+                len(CacheTelemetryIndex),
+                device=self.current_device,
+                dtype=torch.int64,
+            ),
+            persistent=False,
+        )
+        self.register_buffer(
+            "cache_telemetry_unique_indices_histogram",
+            torch.zeros(
+                CACHE_TELEMETRY_HISTOGRAM_BINS,
+                device=self.current_device,
+                dtype=torch.int64,
+            ),
+            persistent=False,
+        )
+
+    def _gather_cache_telemetry_lookups(self, linear_cache_indices: Tensor) -> Tensor:
+        """
+        Counts the requested and missed indices per table and the unique
+        indices of a batch before it is populated, without synchronizing
+        with the host. Returns the number of unique misses.
+        """
+        num_tables = self.cache_telemetry_table_stats.size(0)
+        # The pruned indices (total_cache_hash_size) fall in the last bucket
+        tables = torch.bucketize(
+            linear_cache_indices.long(),
+            self.cache_telemetry_table_offsets[1:],
+            right=True,
+        )
+        lxu_cache_locations = torch.ops.fbgemm.lxu_cache_lookup(
+            linear_cache_indices,
+            self.lxu_cache_state,
+            self.total_cache_hash_size,
+        )
+        self.cache_telemetry_table_stats[:, 0] += torch.bincount(
+            tables, minlength=num_tables + 1
+        )[:num_tables]
+        self.cache_telemetry_table_stats[:, 1] += torch.bincount(
+            tables[lxu_cache_locations == -1], minlength=num_tables + 1
+        )[:num_tables]
+
+        (
+            unique_indices,
+            num_unique_indices,
+            _,
+        ) = torch.ops.fbgemm.get_unique_indices(
+            linear_cache_indices,
+            self.total_cache_hash_size,
+            compute_count=False,
+        )
+        unique_lxu_cache_locations = torch.ops.fbgemm.lxu_cache_lookup(
+            unique_indices,
+            self.lxu_cache_state,
+            self.total_cache_hash_size,
+            gather_cache_stats=False,
+            num_uniq_cache_indices=num_unique_indices,
+        )
+        unique = (
+            torch.arange(unique_indices.numel(), device=self.current_device)
+            < num_unique_indices
+        ) & (unique_indices != self.total_cache_hash_size)
+        num_unique = unique.sum()
+        histogram_bin = torch.log2(num_unique.double().clamp(min=1)).long()
+        self.cache_telemetry_unique_indices_histogram[
+            histogram_bin.clamp(max=CACHE_TELEMETRY_HISTOGRAM_BINS - 1)
+        ] += 1
+        return (unique & (unique_lxu_cache_locations == -1)).sum()
+
+    def _gather_cache_telemetry_populate(
+        self, cache_state_before_populate: Tensor, num_unique_misses: Tensor
+    ) -> None:
+        """
+        Splits the unique misses of a populate by how they were inserted,
+        from the cache state before and after it.
+        """
+        inserted = self.lxu_cache_state != cache_state_before_populate
+        num_cold_misses = (inserted & (cache_state_before_populate == -1)).sum()
+        num_capacity_misses = inserted.sum() - num_cold_misses
+        self.cache_telemetry_miss_stats[
+            CacheTelemetryIndex.num_sampled_batches
+        ] += 1
+        self.cache_telemetry_miss_stats[
+            CacheTelemetryIndex.num_cold_misses
+        ] += num_cold_misses
+        self.cache_telemetry_miss_stats[
+            CacheTelemetryIndex.num_capacity_misses
+        ] += num_capacity_misses
+        self.cache_telemetry_miss_stats[CacheTelemetryIndex.num_conflict_misses] += (
+            num_unique_misses - num_cold_misses - num_capacity_misses
+        )
+
     def _update_cache_miss_counter(
         self,
         lxu_cache_locations: Tensor,
@@ -1807,6 +2065,77 @@ class SplitTableBatchedEmbeddingBagsCodegen(nn.Module):
             )
         return splits
 
+    @torch.jit.ignore
+    def apply_uvm_advice(
+        self,
+        access_stats: List[Optional[UVMTableAccessStats]],
+        policy: Optional[UVMAdvicePolicy] = None,
+    ) -> List[Optional[UVMTableAdvice]]:
+        """
+        Sets the preferred location and read-mostly advice of the UVM tables
+        (EmbeddingLocation.MANAGED and MANAGED_CACHING) from their access
+        statistics, given in the order of embedding_specs, and prefetches the
+        hot row ranges of the EmbeddingLocation.MANAGED tables to the device
+        ahead of each forward. Replaces the ranges of the previous call; the
+        tables without statistics keep their advice. Returns the applied
+        advice per table.
+        """
+        # The UVM enums are only registered by the CUDA builds
+        from fbgemm_gpu.uvm import cudaMemoryAdvise
+
+        assert len(access_stats) == len(self.embedding_specs)
+        access_stats = list(access_stats)
+        if policy is None:
+            policy = UVMAdvicePolicy()
+        if not torch.ops.fbgemm.uvm_storage(self.weights_uvm):
+            # The UVM tables were placed in HBM (enforce_hbm)
+            return [None] * len(access_stats)
+
+        uvm_placements = [
+            EmbeddingLocation.MANAGED.value,
+            EmbeddingLocation.MANAGED_CACHING.value,
+        ]
+        row_bytes: List[int] = []
+        for t, (_, dim, _, _) in enumerate(self.embedding_specs):
+            if self.weights_precision == SparseType.INT8:
+                dim += self.int8_emb_row_dim_offset
+            row_bytes.append(dim * self.weights_uvm.element_size())
+            if self.weights_physical_placements[t] not in uvm_placements:
+                access_stats[t] = None
+
+        advice = plan_uvm_advice(row_bytes, access_stats, policy)
+        self.uvm_prefetch_ranges = []
+        for t, table_advice in enumerate(advice):
+            if table_advice is None:
+                continue
+            rows = self.embedding_specs[t][0]
+            dim = row_bytes[t] // self.weights_uvm.element_size()
+            offset = self.weights_physical_offsets[t]
+            table = self.weights_uvm.detach()[offset : offset + rows * dim]
+            # The advice applies to the host when given through a CPU tensor
+            torch.ops.fbgemm.cuda_mem_advise(
+                (
+                    table
+                    if table_advice.prefer_device
+                    else torch.ops.fbgemm.uvm_to_cpu(table)
+                ),
+                cudaMemoryAdvise.cudaMemAdviseSetPreferredLocation.value,
+            )
+            torch.ops.fbgemm.cuda_mem_advise(
+                table,
+                (
+                    cudaMemoryAdvise.cudaMemAdviseSetReadMostly.value
+                    if table_advice.read_mostly
+                    else cudaMemoryAdvise.cudaMemAdviseUnsetReadMostly.value
+                ),
+            )
+            if self.weights_physical_placements[t] == EmbeddingLocation.MANAGED.value:
+                self.uvm_prefetch_ranges.extend(
+                    (offset + start * dim, offset + end * dim)
+                    for start, end in table_advice.prefetch_row_ranges
+                )
+        return advice
+
     @torch.jit.ignore
     def get_optimizer_buffer(self, state: str) -> torch.Tensor:
         if self.optimizer == OptimType.NONE:
@@ -1863,7 +2192,8 @@ class SplitTableBatchedEmbeddingBagsCodegen(nn.Module):
         self,
     ) -> List[List[torch.Tensor]]:
         """
-        Returns a list of states, split by table
+        Returns a list of states, split by table. INT8 momentum1 is returned as
+        its quantized rows, each followed by its qparams
         """
         if self.optimizer == OptimType.NONE:
             raise NotImplementedError(
@@ -1877,9 +2207,11 @@ class SplitTableBatchedEmbeddingBagsCodegen(nn.Module):
             state_offsets: Tensor,
             state_placements: Tensor,
             rowwise: bool,
+            row_dim_offset: int = 0,
         ) -> List[torch.Tensor]:
             splits = []
             for t, (rows, dim, _, _) in enumerate(self.embedding_specs):
+                dim += row_dim_offset
                 offset = state_offsets[t]
                 placement = state_placements[t]
                 if placement == EmbeddingLocation.DEVICE:
@@ -1909,6 +2241,7 @@ class SplitTableBatchedEmbeddingBagsCodegen(nn.Module):
                     in [
                         OptimType.EXACT_ROWWISE_ADAGRAD,
                     ],
+                    row_dim_offset=self.momentum1_row_dim_offset,
                 )
             )
         if self.optimizer in (
@@ -2088,6 +2421,7 @@ class SplitTableBatchedEmbeddingBagsCodegen(nn.Module):
                 persistent=False,
             )
             self._init_uvm_cache_counter(cache_sets, persistent=False)
+            self._init_cache_admission_sketch(cache_sets, persistent=False)
             return
 
         assert cache_load_factor > 0
@@ -2179,6 +2513,7 @@ class SplitTableBatchedEmbeddingBagsCodegen(nn.Module):
             torch.tensor([0, 0], device=self.current_device, dtype=torch.int64),
         )
         self._init_uvm_cache_counter(cache_sets, persistent=True)
+        self._init_cache_admission_sketch(cache_sets, persistent=True)
         if self.prefetch_pipeline:
             # using the placeholder_autograd_tensor to make sure
             # the hook is executed after the backward pass
@@ -2190,6 +2525,7 @@ class SplitTableBatchedEmbeddingBagsCodegen(nn.Module):
             self.register_full_backward_pre_hook(
                 self._update_cache_counter_and_locations
             )
+            self.register_forward_hook(self._unlock_cache_lines_without_backward)
 
         if cache_algorithm not in (CacheAlgorithm.LFU, CacheAlgorithm.LRU):
             raise ValueError(
@@ -2226,6 +2562,31 @@ class SplitTableBatchedEmbeddingBagsCodegen(nn.Module):
         if self.prefetch_stream is not None:
             self.prefetch_stream.wait_stream(torch.cuda.current_stream())
 
+    def _unlock_cache_lines_without_backward(
+        self,
+        module: nn.Module,
+        inputs: Tuple[Any, ...],
+        output: Tensor,
+    ) -> None:
+        """
+        Forward hook function when prefetch_pipeline is enabled.
+
+        The cache lines of a batch are locked by its prefetch and unlocked by
+        the backward prehook. A forward pass that records no autograd graph,
+        e.g. an evaluation under torch.no_grad(), never runs the backward
+        prehook, so its lines are unlocked here. Otherwise they would stay
+        locked and the next prefetches could not evict them.
+
+        The counter is decremented on the forward stream after the forward
+        kernels, so the lines cannot be evicted while they are still read.
+        """
+        if output.requires_grad:
+            return
+        torch.ops.fbgemm.lxu_cache_locking_counter_decrement(
+            self.lxu_cache_locking_counter,
+            self.lxu_cache_locations,
+        )
+
     def _update_cache_counter_and_locations(
         self,
         module: nn.Module,
@@ -2326,6 +2687,40 @@ class SplitTableBatchedEmbeddingBagsCodegen(nn.Module):
                 persistent=persistent,
             )
 
+    def _init_cache_admission_sketch(self, cache_sets: int, persistent: bool) -> None:
+        self.cache_admission_samples = 0
+        self.cache_admission_max_samples: int = (
+            cache_sets * DEFAULT_ASSOC * ADMISSION_SKETCH_SAMPLES_PER_CACHE_LINE
+        )
+        if self.cache_admission_filter and persistent:
+            self.register_buffer(
+                "lxu_cache_admission_sketch",
+                torch.zeros(
+                    ADMISSION_SKETCH_DEPTH,
+                    cache_sets * DEFAULT_ASSOC,
+                    device=self.current_device,
+                    dtype=torch.int32,
+                ),
+            )
+        else:
+            self.register_buffer(
+                "lxu_cache_admission_sketch",
+                torch.zeros([0, 0], dtype=torch.int32, device=self.current_device),
+                persistent=persistent,
+            )
+
+    def _age_cache_admission_sketch(self, num_indices: int) -> None:
+        """
+        Halves the counters of the admission sketch once
+        ADMISSION_SKETCH_SAMPLES_PER_CACHE_LINE indices per cache line were
+        requested since the last time, as the reset of TinyLFU. Rows that
+        used to be hot then stop outweighing the recently hot ones.
+        """
+        self.cache_admission_samples += num_indices
+        if self.cache_admission_samples >= self.cache_admission_max_samples:
+            self.lxu_cache_admission_sketch.div_(2, rounding_mode="floor")
+            self.cache_admission_samples = 0
+
     def _init_uvm_cache_stats(self) -> None:
         if not self.gather_uvm_cache_stats:
             # If uvm_cache_stats is not enabled, register stub entries via buffer to state_dict for TorchScript to JIT properly.
@@ -2373,6 +2768,8 @@ class SplitTableBatchedEmbeddingBagsCodegen(nn.Module):
             return
         self.lxu_cache_state.fill_(-1)
         self.lxu_state.fill_(0)
+        self.lxu_cache_admission_sketch.fill_(0)
+        self.cache_admission_samples = 0
         self.timestep = 1
 
     def reset_embedding_weight_momentum(
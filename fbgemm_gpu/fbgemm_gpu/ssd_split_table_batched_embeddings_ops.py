@@ -92,6 +92,21 @@ class SSDTableBatchedEmbeddingBags(nn.Module):
         ssd_cache_location: EmbeddingLocation = EmbeddingLocation.MANAGED,
         ssd_uniform_init_lower: float = -0.01,
         ssd_uniform_init_upper: float = 0.01,
+        # Rows of the host DRAM cache between the row cache and the SSD, 0
+        # to disable it
+        ssd_dram_cache_rows: int = 0,
+        # Threads initializing the rows missing from the SSD, per shard
+        ssd_init_threads_per_shard: int = 1,
+        # Store the rows in fixed-width slot files with direct I/O instead of
+        # RocksDB, the RocksDB tunables and the DRAM cache being unused
+        ssd_slot_file_backend: bool = False,
+        # Quantize the rows to this many bits (2, 4 or 8) rowwise on SSD, 0
+        # to store them as is. RocksDB backend only
+        ssd_row_compression_bit_rate: int = 0,
+        # Batches prefetched ahead of the forward call, on a side stream, so
+        # that the SSD reads of the next batches overlap the compute of the
+        # current one; 0 to prefetch on the current stream
+        ssd_prefetch_lookahead: int = 0,
         # General Optimizer args
         stochastic_rounding: bool = True,
         gradient_clipping: bool = False,
@@ -215,25 +230,48 @@ class SSDTableBatchedEmbeddingBags(nn.Module):
         ssd_directory = tempfile.mkdtemp(
             prefix="ssd_table_batched_embeddings", dir=ssd_storage_directory
         )
-        # pyre-fixme[4]: Attribute must be annotated.
-        # pyre-ignore[16]
-        self.ssd_db = torch.classes.fbgemm.EmbeddingRocksDBWrapper(
-            ssd_directory,
-            ssd_shards,
-            ssd_shards,
-            ssd_memtable_flush_period,
-            ssd_memtable_flush_offset,
-            ssd_l0_files_per_compact,
-            self.max_D,
-            ssd_rate_limit_mbps,
-            ssd_size_ratio,
-            ssd_compaction_trigger,
-            ssd_write_buffer_size,
-            ssd_max_write_buffer_num,
-            ssd_uniform_init_lower,
-            ssd_uniform_init_upper,
-            32,  # row_storage_bitwidth
-        )
+        if ssd_slot_file_backend:
+            # pyre-fixme[4]: Attribute must be annotated.
+            # pyre-ignore[16]
+            self.ssd_db = torch.classes.fbgemm.EmbeddingSlotFileWrapper(
+                ssd_directory,
+                ssd_shards,
+                self.max_D,
+                ssd_uniform_init_lower,
+                ssd_uniform_init_upper,
+                32,  # row_storage_bitwidth
+                ssd_init_threads_per_shard,
+            )
+        else:
+            # pyre-fixme[4]: Attribute must be annotated.
+            # pyre-ignore[16]
+            self.ssd_db = torch.classes.fbgemm.EmbeddingRocksDBWrapper(
+                ssd_directory,
+                ssd_shards,
+                ssd_shards,
+                ssd_memtable_flush_period,
+                ssd_memtable_flush_offset,
+                ssd_l0_files_per_compact,
+                self.max_D,
+                ssd_rate_limit_mbps,
+                ssd_size_ratio,
+                ssd_compaction_trigger,
+                ssd_write_buffer_size,
+                ssd_max_write_buffer_num,
+                ssd_uniform_init_lower,
+                ssd_uniform_init_upper,
+                32,  # row_storage_bitwidth
+                ssd_dram_cache_rows,
+                ssd_init_threads_per_shard,
+                ssd_row_compression_bit_rate,
+            )
+            # Store the rows of each table at its own dimension
+            self.ssd_db.set_table_dims(
+                torch.tensor(
+                    [0] + list(itertools.accumulate(rows)), dtype=torch.int64
+                ),
+                torch.tensor(dims, dtype=torch.int64),
+            )
         # pyre-fixme[20]: Argument `self` expected.
         (low_priority, high_priority) = torch.cuda.Stream.priority_range()
         self.ssd_stream = torch.cuda.Stream(priority=low_priority)
@@ -241,6 +279,21 @@ class SSDTableBatchedEmbeddingBags(nn.Module):
         self.ssd_set_end = torch.cuda.Event()
         self.timesteps_prefetched: List[int] = []
 
+        assert (
+            ssd_prefetch_lookahead >= 0
+        ), f"ssd_prefetch_lookahead must be non-negative, got {ssd_prefetch_lookahead}"
+        self.ssd_prefetch_lookahead = ssd_prefetch_lookahead
+        # The rows of every prefetched batch that has not run its forward yet
+        # are locked in the cache
+        self.ssd_prefetch_dist: int = ssd_prefetch_lookahead + 1
+        self.ssd_prefetch_stream: Optional[torch.cuda.Stream] = (
+            torch.cuda.Stream(priority=high_priority)
+            if ssd_prefetch_lookahead > 0
+            else None
+        )
+        # Completion of the side stream prefetches, in timestep order
+        self.ssd_prefetch_events: List[torch.cuda.Event] = []
+
         if weight_decay_mode == WeightDecayMode.COUNTER or counter_based_regularization:
             raise AssertionError(
                 "weight_decay_mode = WeightDecayMode.COUNTER is not supported for SSD TBE."
@@ -351,6 +404,24 @@ class SSDTableBatchedEmbeddingBags(nn.Module):
         )
 
     def prefetch(self, indices: Tensor, offsets: Tensor) -> Optional[Tensor]:
+        prefetch_stream = self.ssd_prefetch_stream
+        if prefetch_stream is None:
+            return self._prefetch(indices, offsets)
+
+        assert (
+            len(self.timesteps_prefetched) <= self.ssd_prefetch_lookahead
+        ), f"At most {self.ssd_prefetch_lookahead + 1} batches can be prefetched ahead of the forward calls"
+        # Order the prefetch after the forward and backward calls already
+        # enqueued, which read and update the cache rows
+        prefetch_stream.wait_stream(torch.cuda.current_stream())
+        with torch.cuda.stream(prefetch_stream):
+            linear_cache_indices = self._prefetch(indices, offsets)
+            prefetch_event = torch.cuda.Event()
+            prefetch_stream.record_event(prefetch_event)
+        self.ssd_prefetch_events.append(prefetch_event)
+        return linear_cache_indices
+
+    def _prefetch(self, indices: Tensor, offsets: Tensor) -> Optional[Tensor]:
         (indices, offsets) = indices.long(), offsets.long()
         linear_cache_indices = torch.ops.fbgemm.linearize_cache_indices(
             self.hash_size_cumsum,
@@ -373,12 +444,12 @@ class SSDTableBatchedEmbeddingBags(nn.Module):
             self.total_hash_size,
             self.lxu_cache_state,
             self.timestep,
-            1,  # for now assume prefetch_dist == 1
+            self.ssd_prefetch_dist,
             self.lru_state,
         )
 
         def to_pinned_cpu(t: torch.Tensor) -> torch.Tensor:
-            t_cpu = torch.empty(t.shape, pin_memory=True, dtype=t.dtype)
+            t_cpu = torch.ops.fbgemm.new_pooled_pinned_tensor(t, t.shape)
             t_cpu.copy_(t, non_blocking=True)
             return t_cpu
 
@@ -387,10 +458,8 @@ class SSDTableBatchedEmbeddingBags(nn.Module):
         evicted_rows = self.lxu_cache_weights[
             assigned_cache_slots.clamp_(min=0).long(), :
         ]
-        inserted_rows = torch.empty(
-            evicted_rows.shape,
-            dtype=self.lxu_cache_weights.dtype,
-            pin_memory=True,
+        inserted_rows = torch.ops.fbgemm.new_pooled_pinned_tensor(
+            self.lxu_cache_weights, evicted_rows.shape
         )
 
         current_stream = torch.cuda.current_stream()
@@ -419,12 +488,10 @@ class SSDTableBatchedEmbeddingBags(nn.Module):
             evicted_indices_cpu = to_pinned_cpu(evicted_indices)
             evicted_rows.record_stream(self.ssd_stream)
             evicted_indices.record_stream(self.ssd_stream)
+            torch.ops.fbgemm.pooled_memory_record_stream(actions_count_cpu)
             self.ssd_db.set_cuda(
                 evicted_indices_cpu, evicted_rows_cpu, actions_count_cpu, self.timestep
             )
-            # TODO: is this needed?
-            # Need a way to synchronize
-            #  actions_count_cpu.record_stream(self.ssd_stream)
             self.ssd_stream.record_event(self.ssd_set_end)
         return linear_cache_indices
 
@@ -448,6 +515,10 @@ class SSDTableBatchedEmbeddingBags(nn.Module):
                 indices,
                 offsets,
             )
+        if len(self.ssd_prefetch_events) > 0:
+            # Wait for the rows of this batch only, the prefetches of the
+            # next batches keep running on the side stream
+            torch.cuda.current_stream().wait_event(self.ssd_prefetch_events.pop(0))
         lxu_cache_locations = torch.ops.fbgemm.lxu_cache_lookup(
             linear_cache_indices,
             self.lxu_cache_state,
@@ -559,6 +630,8 @@ class SSDTableBatchedEmbeddingBags(nn.Module):
         return 0.0
 
     def flush(self) -> None:
+        if self.ssd_prefetch_stream is not None:
+            torch.cuda.current_stream().wait_stream(self.ssd_prefetch_stream)
         active_slots_mask = self.lxu_cache_state != -1
         active_weights = self.lxu_cache_weights.masked_select(
             active_slots_mask.view(-1, 1)
@@ -610,6 +683,14 @@ class SSDIntNBitTableBatchedEmbeddingBags(nn.Module):
         ssd_cache_location: EmbeddingLocation = EmbeddingLocation.MANAGED,
         ssd_uniform_init_lower: float = -0.01,
         ssd_uniform_init_upper: float = 0.01,
+        # Rows of the host DRAM cache between the row cache and the SSD, 0
+        # to disable it
+        ssd_dram_cache_rows: int = 0,
+        # Threads initializing the rows missing from the SSD, per shard
+        ssd_init_threads_per_shard: int = 1,
+        # Store the rows in fixed-width slot files with direct I/O instead of
+        # RocksDB, the RocksDB tunables and the DRAM cache being unused
+        ssd_slot_file_backend: bool = False,
     ) -> None:  # noqa C901  # tuple of (rows, dims,)
         super(SSDIntNBitTableBatchedEmbeddingBags, self).__init__()
 
@@ -782,25 +863,47 @@ class SSDIntNBitTableBatchedEmbeddingBags(nn.Module):
         ssd_directory = tempfile.mkdtemp(
             prefix="ssd_table_batched_embeddings", dir=ssd_storage_directory
         )
-        # pyre-fixme[4]: Attribute must be annotated.
-        # pyre-ignore[16]
-        self.ssd_db = torch.classes.fbgemm.EmbeddingRocksDBWrapper(
-            ssd_directory,
-            ssd_shards,
-            ssd_shards,
-            ssd_memtable_flush_period,
-            ssd_memtable_flush_offset,
-            ssd_l0_files_per_compact,
-            self.max_D_cache,
-            ssd_rate_limit_mbps,
-            ssd_size_ratio,
-            ssd_compaction_trigger,
-            ssd_write_buffer_size,
-            ssd_max_write_buffer_num,
-            ssd_uniform_init_lower,
-            ssd_uniform_init_upper,
-            8,  # row_storage_bitwidth
-        )
+        if ssd_slot_file_backend:
+            # pyre-fixme[4]: Attribute must be annotated.
+            # pyre-ignore[16]
+            self.ssd_db = torch.classes.fbgemm.EmbeddingSlotFileWrapper(
+                ssd_directory,
+                ssd_shards,
+                self.max_D_cache,
+                ssd_uniform_init_lower,
+                ssd_uniform_init_upper,
+                8,  # row_storage_bitwidth
+                ssd_init_threads_per_shard,
+            )
+        else:
+            # pyre-fixme[4]: Attribute must be annotated.
+            # pyre-ignore[16]
+            self.ssd_db = torch.classes.fbgemm.EmbeddingRocksDBWrapper(
+                ssd_directory,
+                ssd_shards,
+                ssd_shards,
+                ssd_memtable_flush_period,
+                ssd_memtable_flush_offset,
+                ssd_l0_files_per_compact,
+                self.max_D_cache,
+                ssd_rate_limit_mbps,
+                ssd_size_ratio,
+                ssd_compaction_trigger,
+                ssd_write_buffer_size,
+                ssd_max_write_buffer_num,
+                ssd_uniform_init_lower,
+                ssd_uniform_init_upper,
+                8,  # row_storage_bitwidth
+                ssd_dram_cache_rows,
+                ssd_init_threads_per_shard,
+            )
+            # Store the rows of each table at its own size in bytes
+            self.ssd_db.set_table_dims(
+                torch.tensor(
+                    [0] + list(itertools.accumulate(rows)), dtype=torch.int64
+                ),
+                torch.tensor(cached_dims, dtype=torch.int64),
+            )
         # pyre-fixme[20]: Argument `self` expected.
         (low_priority, high_priority) = torch.cuda.Stream.priority_range()
         self.ssd_stream = torch.cuda.Stream(priority=low_priority)
@@ -891,26 +994,24 @@ class SSDIntNBitTableBatchedEmbeddingBags(nn.Module):
             self.lru_state,
         )
 
-        actions_count_cpu = torch.empty(
-            actions_count_gpu.shape, pin_memory=True, dtype=actions_count_gpu.dtype
+        actions_count_cpu = torch.ops.fbgemm.new_pooled_pinned_tensor(
+            actions_count_gpu, actions_count_gpu.shape
         )
         actions_count_cpu.copy_(actions_count_gpu, non_blocking=True)
         assigned_cache_slots = assigned_cache_slots.long()
         evicted_rows = self.lxu_cache_weights[
             assigned_cache_slots.clamp_(min=0).long(), :
         ]
-        inserted_rows = torch.empty(
-            evicted_rows.shape,
-            dtype=self.lxu_cache_weights.dtype,
-            pin_memory=True,
+        inserted_rows = torch.ops.fbgemm.new_pooled_pinned_tensor(
+            self.lxu_cache_weights, evicted_rows.shape
         )
 
         current_stream = torch.cuda.current_stream()
 
         # Ensure the previous iterations l3_db.set(..) has completed.
         current_stream.wait_event(self.ssd_set_end)
-        inserted_indices_cpu = torch.empty(
-            inserted_indices.shape, pin_memory=True, dtype=inserted_indices.dtype
+        inserted_indices_cpu = torch.ops.fbgemm.new_pooled_pinned_tensor(
+            inserted_indices, inserted_indices.shape
         )
         inserted_indices_cpu.copy_(inserted_indices, non_blocking=True)
         self.ssd_db.get_cuda(
@@ -933,25 +1034,23 @@ class SSDIntNBitTableBatchedEmbeddingBags(nn.Module):
 
         with torch.cuda.stream(self.ssd_stream):
             self.ssd_stream.wait_event(self.ssd_set_start)
-            evicted_rows_cpu = torch.empty(
-                evicted_rows.shape, pin_memory=True, dtype=evicted_rows.dtype
+            evicted_rows_cpu = torch.ops.fbgemm.new_pooled_pinned_tensor(
+                evicted_rows, evicted_rows.shape
             )
             evicted_rows_cpu.copy_(evicted_rows, non_blocking=True)
-            evicted_indices_cpu = torch.empty(
-                evicted_indices.shape, pin_memory=True, dtype=evicted_indices.dtype
+            evicted_indices_cpu = torch.ops.fbgemm.new_pooled_pinned_tensor(
+                evicted_indices, evicted_indices.shape
             )
             evicted_indices_cpu.copy_(evicted_indices, non_blocking=True)
             evicted_rows.record_stream(self.ssd_stream)
             evicted_indices.record_stream(self.ssd_stream)
+            torch.ops.fbgemm.pooled_memory_record_stream(actions_count_cpu)
             self.ssd_db.set_cuda(
                 evicted_indices_cpu,
                 evicted_rows_cpu,
                 actions_count_cpu,
                 self.timestep_counter.get(),
             )
-            # TODO: is this needed?
-            # Need a way to synchronize
-            #  actions_count_cpu.record_stream(self.ssd_stream)
             self.ssd_stream.record_event(self.ssd_set_end)
         return linear_cache_indices
 
@@ -11,8 +11,15 @@
 #pragma once
 
 #include <ATen/ATen.h>
+#include <ATen/Parallel.h>
+#include <algorithm>
 #include <cstdint>
+#include <numeric>
+#include <type_traits>
 #include <utility>
+#include <vector>
+
+#include "fbgemm/Utils.h"
 
 namespace fbgemm_gpu {
 
@@ -51,4 +58,60 @@ void report_embedding_error(
   }
 }
 
+// 1D exclusive scan: output[i] = input[i-1] + input[i-2] + ... + input[0],
+// returning the sum of all the inputs. output may alias input.
+// Integer scans of the same type use the vectorized fbgemm scan, and long
+// ones outside of a parallel region are split into one block per thread:
+// the blocks are summed, then each is scanned from the sum of the blocks
+// before it.
+template <class T, class U>
+U exclusive_scan_ptrs_cpu(
+    const int64_t N,
+    const T* const input,
+    U* const output) {
+  if constexpr (
+      std::is_same_v<T, U> &&
+      (std::is_same_v<T, int32_t> || std::is_same_v<T, int64_t>)) {
+    constexpr int64_t kMinBlockSize = 1 << 16;
+    const int64_t num_blocks = at::in_parallel_region()
+        ? 1
+        : std::min<int64_t>(
+              at::get_num_threads(),
+              (N + kMinBlockSize - 1) / kMinBlockSize);
+    if (num_blocks <= 1) {
+      return fbgemm::exclusive_prefix_sum<T>(N, input, output, 0);
+    }
+
+    const int64_t block_size = (N + num_blocks - 1) / num_blocks;
+    std::vector<T> block_sums(num_blocks + 1, 0);
+    at::parallel_for(0, num_blocks, 1, [&](int64_t start, int64_t end) {
+      for (const auto b : c10::irange(start, end)) {
+        const auto begin = std::min(b * block_size, N);
+        const auto block_end = std::min(begin + block_size, N);
+        block_sums[b + 1] =
+            std::accumulate(input + begin, input + block_end, T(0));
+      }
+    });
+    for (const auto b : c10::irange(num_blocks)) {
+      block_sums[b + 1] += block_sums[b];
+    }
+    at::parallel_for(0, num_blocks, 1, [&](int64_t start, int64_t end) {
+      for (const auto b : c10::irange(start, end)) {
+        const auto begin = std::min(b * block_size, N);
+        const auto block_end = std::min(begin + block_size, N);
+        fbgemm::exclusive_prefix_sum<T>(
+            block_end - begin, input + begin, output + begin, block_sums[b]);
+      }
+    });
+    return block_sums[num_blocks];
+  } else {
+    U cumsum = 0;
+    for (const auto i : c10::irange(N)) {
+      output[i] = cumsum;
+      cumsum += input[i];
+    }
+    return cumsum;
+  }
+}
+
 } // namespace fbgemm_gpu
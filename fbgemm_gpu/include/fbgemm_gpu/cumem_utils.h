@@ -20,8 +20,9 @@ using Tensor = at::Tensor;
 /// @ingroup cumem-utils
 ///
 /// Allocate an `at::Tensor` with unified managed memory (UVM).  Then set its
-/// preferred storage location to CPU (host memory) and establish mappings
-/// on the CUDA device to the host memory.
+/// preferred storage location to CPU (host memory), on the NUMA node closest
+/// to the CUDA device when the CUDA runtime supports it (12.2+), and establish
+/// mappings on the CUDA device to the host memory.
 ///
 /// @param self The input tensor
 /// @param sizes The target tensor dimensions
@@ -45,7 +46,8 @@ Tensor new_managed_tensor_meta(
 
 /// @ingroup cumem-utils
 ///
-/// Allocate the `at::Tensor` with host-mapped memory.
+/// Allocate the `at::Tensor` with host-mapped memory.  The pages are placed
+/// on the NUMA node closest to the CUDA device.
 ///
 /// @param self The input tensor
 /// @param sizes The target tensor dimensions
@@ -84,6 +86,74 @@ Tensor new_vanilla_managed_tensor(
     const Tensor& self,
     const std::vector<std::int64_t>& sizes);
 
+/// @ingroup cumem-utils
+///
+/// Allocate an `at::Tensor` with unified managed memory (UVM) from a caching
+/// pool, with the same memory advice as `new_managed_tensor()`.  The storage
+/// returns to the pool when the tensor is released and is reused once the work
+/// queued on its streams has completed (immediately for device accesses on the
+/// same stream).
+///
+/// @param self The input tensor
+/// @param sizes The target tensor dimensions
+///
+/// @return A new tensor backed by pooled UVM
+Tensor new_pooled_managed_tensor(
+    const Tensor& self,
+    const std::vector<std::int64_t>& sizes);
+
+/// @ingroup cumem-utils
+///
+/// Allocate an `at::Tensor` with host-mapped memory from a caching pool.
+///
+/// @param self The input tensor
+/// @param sizes The target tensor dimensions
+///
+/// @return A new tensor on the device of `self` backed by pooled host-mapped
+/// memory
+Tensor new_pooled_host_mapped_tensor(
+    const Tensor& self,
+    const std::vector<std::int64_t>& sizes);
+
+/// @ingroup cumem-utils
+///
+/// Allocate a pinned CPU `at::Tensor` from the caching pool of
+/// `new_pooled_host_mapped_tensor()`, for staging host to device copies.  The
+/// storage is reused once the work queued on the current stream of the device
+/// of `self` at allocation time, and on the streams added with
+/// `pooled_memory_record_stream()`, has completed.
+///
+/// @param self The input CUDA tensor, whose device and dtype are used
+/// @param sizes The target tensor dimensions
+///
+/// @return A new pinned CPU tensor
+Tensor new_pooled_pinned_tensor(
+    const Tensor& self,
+    const std::vector<std::int64_t>& sizes);
+
+/// @ingroup cumem-utils
+///
+/// Mark a tensor allocated from the caching pool as used on the current
+/// stream, so that its storage is not reused before the work queued on that
+/// stream completes.
+///
+/// @param self The input tensor
+void pooled_memory_record_stream(const Tensor& self);
+
+/// @ingroup cumem-utils
+///
+/// Release the cached blocks of the caching pool, waiting for their pending
+/// work to complete.
+void pooled_memory_empty_cache();
+
+/// @ingroup cumem-utils
+///
+/// Get the statistics of the caching pool.
+///
+/// @return The bytes in use, the bytes cached, the number of driver
+/// allocations and the number of reused blocks
+std::vector<int64_t> pooled_memory_stats();
+
 /// @ingroup cumem-utils
 ///
 /// Check if a tensor is allocated with UVM (either CPU or GPU tensor).
@@ -129,4 +129,43 @@ C10_HOST_DEVICE C10_ALWAYS_INLINE int32_t padded_row_size_in_bytes(
   return static_cast<int32_t>(round_up(r, row_alignment));
 }
 
+// Pruned index remapping stored as a bitmap of the kept indices of a table,
+// 32 indices per int32 word, with the number of kept indices before every
+// block of kPrunedBitmapBlockWords words. A kept index maps to its rank among
+// the kept indices of its table, so this takes ~1 bit per original index
+// instead of the 32 of pruned_array_lookup.
+constexpr int32_t kPrunedBitmapBlockWords = 16;
+
+C10_HOST_DEVICE C10_ALWAYS_INLINE int32_t popcount32(uint32_t x) {
+  x = x - ((x >> 1) & 0x55555555u);
+  x = (x & 0x33333333u) + ((x >> 2) & 0x33333333u);
+  x = (x + (x >> 4)) & 0x0f0f0f0fu;
+  return static_cast<int32_t>((x * 0x01010101u) >> 24);
+}
+
+/// Dense index of idx in the bitmap and ranks of a table of num_words words,
+/// or -1 if idx is pruned or out of the table
+C10_HOST_DEVICE C10_ALWAYS_INLINE int32_t pruned_bitmap_dense_index(
+    const int32_t* __restrict__ bitmap,
+    const int32_t* __restrict__ ranks,
+    const int64_t num_words,
+    const int32_t idx) {
+  if (idx < 0 || static_cast<int64_t>(idx) >= num_words * 32) {
+    return -1;
+  }
+  const int32_t word_idx = idx / 32;
+  const uint32_t bit = idx % 32;
+  const auto word = static_cast<uint32_t>(bitmap[word_idx]);
+  if (((word >> bit) & 1u) == 0) {
+    return -1;
+  }
+  int32_t rank = ranks[word_idx / kPrunedBitmapBlockWords] +
+      popcount32(word & ((1u << bit) - 1u));
+  for (auto w = word_idx - word_idx % kPrunedBitmapBlockWords; w < word_idx;
+       ++w) {
+    rank += popcount32(static_cast<uint32_t>(bitmap[w]));
+  }
+  return rank;
+}
+
 } // namespace nbit
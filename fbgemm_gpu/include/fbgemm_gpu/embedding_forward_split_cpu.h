@@ -24,6 +24,42 @@ at::Tensor split_embedding_codegen_forward_cpu(
     at::Tensor indice_weights,
     int64_t output_dtype = 0 /* SparseType.FP32 */);
 
+// Variable batch size (VBE) forward pass: offsets are [B_offsets[T] + 1] and
+// the output is [1, vbe_output_size], the bags of feature t from rank r
+// starting at vbe_output_offsets_feature_rank[r * T + t]
+at::Tensor split_embedding_codegen_forward_vbe_cpu(
+    at::Tensor weights,
+    at::Tensor weights_offsets,
+    at::Tensor D_offsets,
+    at::Tensor hash_size_cumsum,
+    at::Tensor indices,
+    at::Tensor offsets,
+    int64_t pooling_mode,
+    at::Tensor indice_weights,
+    at::Tensor B_offsets,
+    at::Tensor vbe_output_offsets_feature_rank,
+    at::Tensor vbe_B_offsets_rank_per_feature,
+    int64_t vbe_output_size,
+    int64_t output_dtype = 0 /* SparseType.FP32 */);
+
+// Pads the VBE offsets to [T * max_B + 1] with empty bags, for the fixed
+// batch size backward pass
+at::Tensor split_embedding_vbe_padded_offsets_cpu(
+    at::Tensor offsets,
+    at::Tensor B_offsets,
+    int64_t max_B);
+
+// Scatters the [1, vbe_output_size] VBE gradient into a [max_B, total_D]
+// gradient matching the padded offsets, zero for the padded bags
+at::Tensor split_embedding_vbe_padded_grad_cpu(
+    at::Tensor grad_output,
+    at::Tensor D_offsets,
+    int64_t total_D,
+    at::Tensor B_offsets,
+    at::Tensor vbe_output_offsets_feature_rank,
+    at::Tensor vbe_B_offsets_rank_per_feature,
+    int64_t max_B);
+
 at::Tensor split_embedding_codegen_grad_indice_weights_cpu(
     at::Tensor grad_output,
     at::Tensor weights,
@@ -33,6 +69,21 @@ at::Tensor split_embedding_codegen_grad_indice_weights_cpu(
     at::Tensor offsets,
     at::Tensor feature_requires_grad);
 
+// Sorts the indices of every physical table by row for the CPU backward
+// pass, so that the forward pass can sort them once for the backward pass
+// and the optimizer update. The plan tensors are, over all the indices:
+// table_offsets (first index of each table, plus the number of indices),
+// num_non_zero_columns (per table), column_segment_ptr (num_non_zero_columns
+// + 1 per table, from table_offsets[t] + t), column_segment_indices,
+// column_segment_ids, row_indices (from table_offsets[t]) and weights (empty
+// when neither weighted nor MEAN pooled).
+std::vector<at::Tensor> split_embedding_backward_csc_plan_cpu(
+    at::Tensor hash_size_cumsum,
+    at::Tensor indices,
+    at::Tensor offsets,
+    int64_t pooling_mode,
+    at::Tensor indice_weights);
+
 at::Tensor split_embedding_codegen_forward_weighted_pt2_cpu(
     const at::Tensor& /*host_weights*/,
     const at::Tensor& /*dev_weights*/,
@@ -126,4 +177,28 @@ void csr2csc(
     int64_t pooling_mode,
     const int* table_to_feature_offset,
     int64_t num_embeddings);
+
+// Non-owning columns of a table, from a HyperCompressedSparseColumn or from
+// the tensors of split_embedding_backward_csc_plan_cpu
+struct CompressedSparseColumnView {
+  int num_non_zero_columns = 0;
+  int* column_segment_ptr = nullptr;
+  int* column_segment_indices = nullptr;
+  int* column_segment_ids = nullptr;
+  int* row_indices = nullptr;
+  float* weights = nullptr;
+
+  CompressedSparseColumnView() = default;
+  explicit CompressedSparseColumnView(const HyperCompressedSparseColumn& csc)
+      : num_non_zero_columns(csc.num_non_zero_columns),
+        column_segment_ptr(csc.column_segment_ptr),
+        column_segment_indices(csc.column_segment_indices),
+        column_segment_ids(csc.column_segment_ids),
+        row_indices(csc.row_indices),
+        weights(csc.weights) {}
+};
+
+std::vector<CompressedSparseColumnView> csc_plan_views(
+    at::TensorList csc_plan,
+    int num_tables);
 } // namespace internal
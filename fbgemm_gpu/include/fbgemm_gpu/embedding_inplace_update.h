@@ -76,6 +76,34 @@ void embedding_inplace_update_cpu(
         c10::nullopt // Not used, to match cache interface for CUDA op
 );
 
+/**
+ * Same as embedding_inplace_update_cpu, but every updated row is written
+ * under a per row seqlock so that it can be read while serving:
+ *
+ * row_versions: int64 version of every row of every table, initially even
+ * row_versions_offsets: offset of the versions of each table in row_versions
+ *
+ * The version of a row is odd while the row is copied and grows by 2 with
+ * every update. Readers bracket their reads of a row with
+ * embedding_row_read_begin and embedding_row_read_validate, from
+ * embedding_row_versions.h, and read the row again if it has been updated in
+ * between.
+ */
+void embedding_inplace_update_versioned_cpu(
+    Tensor dev_weights,
+    Tensor uvm_weights,
+    Tensor weights_placements,
+    Tensor weights_offsets,
+    Tensor weights_tys,
+    Tensor D_offsets,
+    Tensor update_weights,
+    Tensor update_table_idx,
+    Tensor update_row_idx,
+    Tensor update_offsets,
+    Tensor row_versions,
+    Tensor row_versions_offsets,
+    const int64_t row_alignment);
+
 /**
  * Index remapping function that returns the remapped indices.
  *
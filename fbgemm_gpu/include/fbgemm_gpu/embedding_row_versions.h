@@ -0,0 +1,47 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+// Readers of the row versions written by
+// embedding_inplace_update_versioned_cpu. CPU only: std::atomic_ref needs
+// C++20, which the CUDA sources are not built with.
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+
+namespace fbgemm_gpu {
+
+/**
+ * Waits until no update of the row is in progress and returns its version,
+ * to be passed to embedding_row_read_validate after reading the row.
+ */
+inline int64_t embedding_row_read_begin(int64_t* row_version) {
+  std::atomic_ref<int64_t> version(*row_version);
+  int64_t v = version.load(std::memory_order_acquire);
+  while (v & 1) {
+    std::this_thread::yield();
+    v = version.load(std::memory_order_acquire);
+  }
+  return v;
+}
+
+/**
+ * Returns true if the row has not been updated since embedding_row_read_begin
+ * returned begin_version, i.e. what was read in between is not torn.
+ */
+inline bool embedding_row_read_validate(
+    int64_t* row_version,
+    int64_t begin_version) {
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return std::atomic_ref<int64_t>(*row_version).load(
+             std::memory_order_relaxed) == begin_version;
+}
+
+} // namespace fbgemm_gpu
@@ -706,6 +706,28 @@ warpReduceAllSum(T val, unsigned shfl_sync_mask = kFullWarpMask) {
   return val;
 }
 
+/// Max-reduces a register value across all warp threads
+template <typename T, int ReduceWidth = kWarpSize>
+DEVICE_INLINE T
+warpReduceAllMax(T val, unsigned shfl_sync_mask = kFullWarpMask) {
+#pragma unroll
+  for (int mask = ReduceWidth / 2; mask > 0; mask >>= 1) {
+    val = max(val, shfl_xor(val, mask, ReduceWidth, shfl_sync_mask));
+  }
+  return val;
+}
+
+/// Min-reduces a register value across all warp threads
+template <typename T, int ReduceWidth = kWarpSize>
+DEVICE_INLINE T
+warpReduceAllMin(T val, unsigned shfl_sync_mask = kFullWarpMask) {
+#pragma unroll
+  for (int mask = ReduceWidth / 2; mask > 0; mask >>= 1) {
+    val = min(val, shfl_xor(val, mask, ReduceWidth, shfl_sync_mask));
+  }
+  return val;
+}
+
 DEVICE_INLINE void syncwarp() {
 #ifdef USE_ROCM
   // Performance - replace a block level __syncthreads with per CU
@@ -22,6 +22,28 @@ std::tuple<at::Tensor, at::Tensor, at::Tensor> tbe_input_combine_cpu(
     const std::vector<at::Tensor>& per_sample_weights,
     const at::Tensor& include_last_offsets);
 
+///@ingroup input-combine
+/// Same as tbe_input_combine_cpu, resizing the int32 indices and offsets and
+/// the float weights (which keep their storage when large enough) instead of
+/// allocating them
+std::tuple<at::Tensor, at::Tensor, at::Tensor> tbe_input_combine_cpu_out(
+    at::Tensor& combined_indices,
+    at::Tensor& combined_offsets,
+    at::Tensor& combined_weights,
+    const std::vector<at::Tensor>& indices_list,
+    const std::vector<at::Tensor>& offsets_list,
+    const std::vector<at::Tensor>& per_sample_weights,
+    const at::Tensor& include_last_offsets);
+
+///@ingroup input-combine
+/// @return The sizes of the indices, offsets and weights (0 without weights)
+/// tbe_input_combine_cpu outputs, to size reused output buffers
+std::tuple<int64_t, int64_t, int64_t> tbe_input_combine_cpu_output_sizes(
+    const std::vector<at::Tensor>& indices_list,
+    const std::vector<at::Tensor>& offsets_list,
+    const std::vector<at::Tensor>& per_sample_weights,
+    const at::Tensor& include_last_offsets);
+
 ///@ingroup input-combine
 std::tuple<at::Tensor, at::Tensor, at::Tensor>
 padding_fused_tbe_input_combine_cpu(
@@ -31,6 +53,16 @@ padding_fused_tbe_input_combine_cpu(
     const at::Tensor& include_last_offsets,
     int64_t batch_size);
 
+///@ingroup input-combine
+std::tuple<at::Tensor, at::Tensor, at::Tensor, at::Tensor>
+block_bucketize_permute_tbe_input_combine_cpu(
+    const at::Tensor& lengths,
+    const at::Tensor& indices,
+    const at::Tensor& block_sizes,
+    int64_t my_size,
+    const c10::optional<at::Tensor>& permute,
+    const c10::optional<at::Tensor>& weights);
+
 std::tuple<at::Tensor, at::Tensor, at::Tensor>
 tbe_input_combine_with_length_cuda(
     const uint64_t* const indices_addrs,
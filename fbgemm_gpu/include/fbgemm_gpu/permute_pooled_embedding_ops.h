@@ -43,6 +43,17 @@ at::Tensor permute_pooled_embs_cpu(
     const at::Tensor& inv_offset_dim_list,
     const at::Tensor& inv_permute_list);
 
+/// Writes the permuted pooled_embs into output, whose rows must be
+/// contiguous but may be strided, e.g., a column slice of the input buffer of
+/// the next interaction, instead of allocating the output.
+///@ingroup permute-pooled-embs-cpu
+void permute_pooled_embs_cpu_out(
+    const at::Tensor& pooled_embs, // [B_local][Sum_T_global(D)]
+    const at::Tensor& offset_dim_list,
+    const at::Tensor& permute_list,
+    at::Tensor& output,
+    const bool allow_duplicates);
+
 at::Tensor permute_duplicate_pooled_embs_gpu(
     const at::Tensor& pooled_embs, // [B_local][Sum_T_global(D)]
     const at::Tensor& offset_dim_list,
@@ -140,6 +140,16 @@ at::Tensor expand_into_jagged_permute_cpu(
     const at::Tensor& output_offsets,
     int64_t output_size);
 
+///@ingroup sparse-data-cpu
+/// Same as expand_into_jagged_permute_cpu, resizing output_permute (which
+/// keeps its storage when large enough) instead of allocating the output
+at::Tensor& expand_into_jagged_permute_cpu_out(
+    at::Tensor& output_permute,
+    const at::Tensor& permute,
+    const at::Tensor& input_offsets,
+    const at::Tensor& output_offsets,
+    int64_t output_size);
+
 std::tuple<
     at::Tensor,
     at::Tensor,
@@ -280,6 +290,50 @@ permute_1D_sparse_data_cpu(
     const c10::optional<at::Tensor>& weights,
     const c10::optional<int64_t>& permuted_lengths_sum);
 
+///@ingroup sparse-data-cpu
+/// Same as permute_2D_sparse_data_cpu, resizing the output tensors (which keep
+/// their storage when large enough) instead of allocating them.
+/// permuted_weights is only used with weights.
+std::tuple<at::Tensor, at::Tensor, c10::optional<at::Tensor>>
+permute_2D_sparse_data_cpu_out(
+    at::Tensor& permuted_lengths,
+    at::Tensor& permuted_indices,
+    at::Tensor& permuted_weights,
+    const at::Tensor& permute,
+    const at::Tensor& lengths,
+    const at::Tensor& indices,
+    const c10::optional<at::Tensor>& weights,
+    const c10::optional<int64_t>& permuted_lengths_sum);
+
+///@ingroup sparse-data-cpu
+/// Same as permute_1D_sparse_data_cpu, resizing the output tensors (which keep
+/// their storage when large enough) instead of allocating them.
+/// permuted_weights is only used with weights.
+std::tuple<at::Tensor, at::Tensor, c10::optional<at::Tensor>>
+permute_1D_sparse_data_cpu_out(
+    at::Tensor& permuted_lengths,
+    at::Tensor& permuted_indices,
+    at::Tensor& permuted_weights,
+    const at::Tensor& permute,
+    const at::Tensor& lengths,
+    const at::Tensor& indices,
+    const c10::optional<at::Tensor>& weights,
+    const c10::optional<int64_t>& permuted_lengths_sum);
+
+///@ingroup sparse-data-cpu
+/// @return The number of indices permute_2D_sparse_data_cpu outputs, to size
+/// reused output buffers
+int64_t permute_2D_sparse_data_cpu_output_size(
+    const at::Tensor& permute,
+    const at::Tensor& lengths);
+
+///@ingroup sparse-data-cpu
+/// @return The number of indices permute_1D_sparse_data_cpu outputs, to size
+/// reused output buffers
+int64_t permute_1D_sparse_data_cpu_output_size(
+    const at::Tensor& permute,
+    const at::Tensor& lengths);
+
 at::Tensor _float_to_fused8bitrowwise_gpu(const at::Tensor& input);
 at::Tensor _float_to_paddedFP8rowwise_gpu(
     const at::Tensor& input,
@@ -288,6 +342,12 @@ at::Tensor _float_to_paddedFP8rowwise_gpu(
 at::Tensor _float_to_FP8rowwise_gpu(
     const at::Tensor& input,
     const bool forward = true);
+at::Tensor _float_to_FP8rowwise_permuted_gpu(
+    const at::Tensor& pooled_embs,
+    const at::Tensor& offset_dim_list,
+    const at::Tensor& permute_list,
+    const at::Tensor& inv_offset_dim_list,
+    const bool forward);
 at::Tensor _half_to_fused8bitrowwise_gpu(const at::Tensor& input);
 at::Tensor _float_or_half_to_fused8bitrowwise_gpu(const at::Tensor& input);
 at::Tensor _fused8bitrowwise_to_float_gpu(const at::Tensor& input);
@@ -301,6 +361,11 @@ at::Tensor _paddedFP8rowwise_to_float_gpu(
     const int64_t row_dim = 256,
     const int64_t output_last_dim = -1,
     const int64_t output_dtype = 0);
+std::tuple<at::Tensor, at::Tensor> _paddedFP8rowwise_to_jagged_gpu(
+    const at::Tensor& input,
+    const bool forward = true,
+    const int64_t row_dim = 256,
+    const int64_t output_dtype = 0);
 at::Tensor _fused8bitrowwise_to_half_gpu(const at::Tensor& input);
 at::Tensor _fused8bitrowwise_to_float_or_half_gpu(
     const at::Tensor& input,
@@ -311,6 +376,12 @@ at::Tensor float_to_fused8bitrowwise_cpu(const at::Tensor& input);
 at::Tensor float_to_FP8rowwise_cpu(
     const at::Tensor& input,
     const bool forward = true);
+at::Tensor float_to_FP8rowwise_permuted_cpu(
+    const at::Tensor& pooled_embs,
+    const at::Tensor& offset_dim_list,
+    const at::Tensor& permute_list,
+    const at::Tensor& inv_offset_dim_list,
+    const bool forward);
 at::Tensor half_to_fused8bitrowwise_cpu(const at::Tensor& input);
 at::Tensor float_or_half_to_fused8bitrowwise_cpu(const at::Tensor& input);
 at::Tensor fused8bitrowwise_to_float_cpu(const at::Tensor& input);
@@ -328,6 +399,16 @@ at::Tensor _float_to_bfloat16_gpu(const at::Tensor&);
 at::Tensor _bfloat16_to_float_gpu(const at::Tensor&);
 at::Tensor _float_to_bfloat16_cpu(const at::Tensor&);
 at::Tensor _bfloat16_to_float_cpu(const at::Tensor&);
+at::Tensor _float_to_bfloat16_permuted_gpu(
+    const at::Tensor& pooled_embs,
+    const at::Tensor& offset_dim_list,
+    const at::Tensor& permute_list,
+    const at::Tensor& inv_offset_dim_list);
+at::Tensor _float_to_bfloat16_permuted_cpu(
+    const at::Tensor& pooled_embs,
+    const at::Tensor& offset_dim_list,
+    const at::Tensor& permute_list,
+    const at::Tensor& inv_offset_dim_list);
 
 at::Tensor _float_to_hfp8_gpu(
     const at::Tensor& input,
@@ -351,6 +432,22 @@ at::Tensor _msfp_to_float_gpu(
     const int64_t ebits,
     const int64_t mbits,
     const int64_t bias);
+at::Tensor _float_or_half_to_mx_gpu(
+    const at::Tensor& input,
+    const int64_t mx_format);
+at::Tensor _mx_to_float_or_half_gpu(
+    const at::Tensor& input,
+    const int64_t mx_format,
+    const int64_t output_columns,
+    const int64_t output_dtype);
+at::Tensor _float_or_half_to_mx_cpu(
+    const at::Tensor& input,
+    const int64_t mx_format);
+at::Tensor _mx_to_float_or_half_cpu(
+    const at::Tensor& input,
+    const int64_t mx_format,
+    const int64_t output_columns,
+    const int64_t output_dtype);
 at::Tensor _fused8bitrowwise_to_float_mixed_dim_gpu(
     const at::Tensor& input,
     const at::Tensor& D_offsets,
@@ -511,6 +608,21 @@ at::Tensor batched_unary_embeddings_backward_cuda(
     const at::Tensor& offsets,
     const at::Tensor& indices);
 
+///@ingroup sparse-data-cpu
+at::Tensor batched_unary_embeddings_forward_cpu(
+    const at::Tensor& weight,
+    const at::Tensor& table_offsets,
+    const at::Tensor& offsets,
+    const at::Tensor& indices);
+
+///@ingroup sparse-data-cpu
+at::Tensor batched_unary_embeddings_backward_cpu(
+    const at::Tensor& grad_output,
+    const at::Tensor& weight,
+    const at::Tensor& table_offsets,
+    const at::Tensor& offsets,
+    const at::Tensor& indices);
+
 ///@ingroup sparse-data-cpu
 std::vector<at::Tensor> stacked_jagged_2d_to_dense_cpu(
     at::Tensor values,
@@ -788,6 +900,15 @@ std::tuple<at::Tensor, at::Tensor> embedding_bag_rowwise_prune(
     const int64_t min_non_pruned_rows,
     const c10::optional<double>& min_save_ratio);
 
+std::tuple<at::Tensor, at::Tensor> embedding_bag_rowwise_prune_out(
+    at::Tensor& pruned_weights,
+    at::Tensor& compressed_indices_mapping,
+    const at::Tensor& weights,
+    const at::Tensor& indicator,
+    const double threshold,
+    const bool abs,
+    const int64_t min_non_pruned_rows);
+
 ///@ingroup sparse-data-cpu
 at::Tensor lengths_range(
     const at::Tensor& t_in,
@@ -22,8 +22,13 @@ enum uvm_cache_stats_index {
   num_unique_misses = 3,
   num_conflict_unique_misses = 4,
   num_conflict_misses = 5,
+  num_rejected_unique_misses = 6,
 };
 
+// Rows of the count-min sketch of the TinyLFU admission filter of the LRU
+// cache populate
+constexpr int32_t kAdmissionSketchDepth = 4;
+
 } // namespace fbgemm_gpu
 
 ///@ingroup table-batched-embed-cuda
@@ -90,6 +95,9 @@ at::Tensor linearize_cache_indices_from_row_idx_cuda(
 ///@ingroup table-batched-embed-cuda
 /// LRU cache: fetch the rows corresponding to `linear_cache_indices` from
 ///`weights`, and insert them into the cache at timestep `time_stamp`.
+/// With an `admission_sketch` (TinyLFU), the accesses are counted in the
+/// [kAdmissionSketchDepth, width] count-min sketch and a missed row only
+/// evicts a row estimated to be less frequently accessed.
 void lru_cache_populate_cuda(
     at::Tensor weights,
     at::Tensor hash_size_cumsum,
@@ -106,7 +114,8 @@ void lru_cache_populate_cuda(
     bool gather_cache_stats,
     c10::optional<at::Tensor> uvm_cache_stats,
     bool lock_cache_line,
-    c10::optional<at::Tensor> lxu_cache_locking_counter);
+    c10::optional<at::Tensor> lxu_cache_locking_counter,
+    c10::optional<at::Tensor> admission_sketch);
 
 ///@ingroup table-batched-embed-cuda
 /// LRU cache: fetch the rows corresponding to `linear_cache_indices` from
@@ -20,6 +20,9 @@ constexpr uint32_t DEFAULT_INFO_B_MASK = (1u << DEFAULT_INFO_B_NUM_BITS) - 1;
 constexpr uint32_t MAX_T =
     (1u << (DEFAULT_INFO_NUM_BITS - DEFAULT_INFO_B_NUM_BITS)) - 1;
 constexpr uint32_t MAX_B = (1u << DEFAULT_INFO_B_NUM_BITS) - 1;
+// Bin b of a segment length histogram counts the runs of [2^b, 2^(b+1))
+// lookups
+constexpr int32_t kSegmentLengthHistogramBins = 32;
 
 /**
  * "Transpose" embedding inputs by sorting indices by their values.
@@ -53,6 +56,65 @@ transpose_embedding_input(
 std::tuple<int64_t, int64_t>
 get_infos_metadata(at::Tensor unused, int64_t B, int64_t T);
 
+/**
+ * Count the runs (unique indices) of every feature by log2 of their length
+ * from the outputs of transpose_embedding_input. Returns an int32 tensor of
+ * shape [T, kSegmentLengthHistogramBins].
+ */
+at::Tensor segment_length_histogram(
+    const at::Tensor& sorted_linear_indices_num_runs,
+    const at::Tensor& sorted_linear_indices_cumulative_run_lengths,
+    const at::Tensor& infos_sorted,
+    const int64_t T,
+    const int64_t info_B_num_bits);
+
+/**
+ * Pick the per-feature segment length from which the TBE backward moves a run
+ * from the warp per row to the CTA per row kernel, from a segment length
+ * histogram. Features with few long runs keep the base threshold, while the
+ * threshold of features with many long runs is raised, up to warps_per_cta
+ * times the base, so that only runs able to fill a CTA use the CTA path.
+ */
+at::Tensor adaptive_max_segment_length_per_warp(
+    const at::Tensor& histogram,
+    const int64_t base_max_segment_length_per_warp,
+    const int64_t warps_per_cta);
+
+/**
+ * Compact the gradient of pooled (SUM) TBE lookups into the rows of the
+ * unique indices touched by the batch, from the sorted outputs of
+ * transpose_embedding_input. Row i of grad_rows is the gradient of the linear
+ * index unique_ids[i], zero padded to max_D. This is meant for exchanging
+ * sparse gradients of data parallel tables instead of dense ones.
+ */
+std::tuple<at::Tensor /*unique_ids*/, at::Tensor /*grad_rows*/>
+compute_sparse_embedding_grad(
+    const at::Tensor& grad_output,
+    const at::Tensor& sorted_linear_indices_run,
+    const at::Tensor& sorted_linear_indices_cumulative_run_lengths,
+    const at::Tensor& sorted_linear_indices_num_runs,
+    const at::Tensor& infos_sorted,
+    const at::Tensor& D_offsets,
+    const int64_t max_D,
+    const int64_t info_B_num_bits,
+    const int64_t info_B_mask);
+
+/**
+ * Accumulate scale * grad_rows into the flat weights (or dense gradient)
+ * buffer at the rows of the linear indices unique_ids, which may repeat, e.g.
+ * after an all-gather of compute_sparse_embedding_grad outputs. The update is
+ * deterministic. hash_size_cumsum must be non-decreasing, i.e. the features
+ * must be ordered by table.
+ */
+void apply_sparse_embedding_grad(
+    at::Tensor& dense,
+    const at::Tensor& weights_offsets,
+    const at::Tensor& D_offsets,
+    const at::Tensor& hash_size_cumsum,
+    const at::Tensor& unique_ids,
+    const at::Tensor& grad_rows,
+    const double scale);
+
 std::tuple<int32_t, uint32_t> adjust_info_B_num_bits(int32_t B, int32_t T);
 
 // Use these functions instead of directly calling cub functions
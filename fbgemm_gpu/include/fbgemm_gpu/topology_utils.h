@@ -17,4 +17,8 @@ using AdjacencyMatrix = std::function<T(Node, Node)>;
 
 namespace fbgemm_gpu {
 AdjacencyMatrix<Links> get_nvlink_matrix();
+
+// Whether the NVLinks of the GPUs go through NVSwitches, which connect every
+// pair of GPUs at full bandwidth so direct copies are always the fastest
+bool has_nvswitch();
 } // namespace fbgemm_gpu
@@ -7,18 +7,80 @@
  */
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <cstring>
 #include <functional>
 
 #include <ATen/ATen.h>
+#include <ATen/Parallel.h>
 #include <torch/library.h>
 
+#include "fbgemm/Utils.h"
 #include "fbgemm_gpu/embedding_inplace_update.h"
 
+#if defined(__x86_64__) || defined(__i386__) || \
+    (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
+#include <emmintrin.h>
+#define FBGEMM_GPU_INPLACE_UPDATE_NON_TEMPORAL
+#endif
+
 using Tensor = at::Tensor;
 
 namespace fbgemm_gpu {
 
+namespace {
+
+// Below this many rows the updates are applied in the order they are given;
+// above it sorting them by address pays for itself in write locality
+constexpr int64_t kInplaceUpdateSortMinRows = 16384;
+
+// Updates larger than the last level cache are written with non-temporal
+// stores, so that they do not evict the rows being served
+constexpr int64_t kInplaceUpdateNonTemporalBytes = 32 * 1024 * 1024;
+
+void run_on_aten_thread_pool(
+    int num_tasks,
+    const std::function<void(int)>& task) {
+  at::parallel_for(0, num_tasks, 1, [&](int64_t begin, int64_t end) {
+    for (const auto t : c10::irange(begin, end)) {
+      task(t);
+    }
+  });
+}
+
+inline void inplace_update_copy_row(
+    uint8_t* dst,
+    const uint8_t* src,
+    const int64_t bytes,
+    const bool non_temporal) {
+  int64_t b = 0;
+#ifdef FBGEMM_GPU_INPLACE_UPDATE_NON_TEMPORAL
+  if (non_temporal) {
+    const int64_t head = std::min<int64_t>(
+        bytes, (16 - reinterpret_cast<uintptr_t>(dst) % 16) % 16);
+    memcpy(dst, src, head);
+    for (b = head; b + 16 <= bytes; b += 16) {
+      _mm_stream_si128(
+          reinterpret_cast<__m128i*>(dst + b),
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + b)));
+    }
+  }
+#endif
+  memcpy(dst + b, src + b, bytes - b);
+}
+
+// Makes the non-temporal stores of this thread visible to other threads
+inline void inplace_update_store_fence(const bool non_temporal) {
+#ifdef FBGEMM_GPU_INPLACE_UPDATE_NON_TEMPORAL
+  if (non_temporal) {
+    _mm_sfence();
+  }
+#endif
+}
+
+} // namespace
+
 template <typename index_t>
 void embedding_inplace_update_cpu_kernel(
     at::TensorAccessor<uint8_t, 1> dev_weights,
@@ -31,39 +93,92 @@ void embedding_inplace_update_cpu_kernel(
     const at::TensorAccessor<int32_t, 1>& update_table_idx,
     const at::TensorAccessor<index_t, 1>& update_row_idx,
     const at::TensorAccessor<int64_t, 1>& update_offsets,
-    int64_t row_alignment) {
-  for (int64_t n = 0; n < update_row_idx.size(0); n++) {
-    int32_t t = update_table_idx[n];
-    auto row_idx = update_row_idx[n];
+    int64_t row_alignment,
+    int64_t* row_versions = nullptr,
+    const int64_t* row_versions_offsets = nullptr) {
+  const int64_t N = update_row_idx.size(0);
+  const int64_t dev_size = dev_weights.size(0);
 
+  // Position of the destination row of update n, with the UVM weights
+  // after the device ones
+  const auto row_position = [&](int64_t n, int32_t* D_bytes) {
+    const int32_t t = update_table_idx[n];
     SparseType weight_ty = static_cast<SparseType>(weights_tys[t]);
-    const int32_t D_start = D_offsets[t];
-    const int32_t D_end = D_offsets[t + 1];
-    const int32_t D = D_end - D_start;
-    const int32_t D_bytes =
-        nbit::padded_row_size_in_bytes(D, weight_ty, row_alignment);
-    int64_t weight_offset = weights_offsets[t];
-
-    uint8_t* __restrict__ weight_row;
+    const int32_t D = D_offsets[t + 1] - D_offsets[t];
+    *D_bytes = nbit::padded_row_size_in_bytes(D, weight_ty, row_alignment);
     const auto placement = static_cast<PlacementType>(weights_placements[t]);
-    if (placement == PlacementType::HOST) {
-      weight_row =
-          &dev_weights
-              [weight_offset +
-               static_cast<int64_t>(D_bytes) * static_cast<int64_t>(row_idx)];
-    } else {
-      weight_row =
-          &uvm_weights
-              [weight_offset +
-               static_cast<int64_t>(D_bytes) * static_cast<int64_t>(row_idx)];
+    return (placement == PlacementType::HOST ? 0 : dev_size) +
+        weights_offsets[t] +
+        static_cast<int64_t>(*D_bytes) *
+        static_cast<int64_t>(update_row_idx[n]);
+  };
+
+  // Large pushes are applied in address order, i.e. by table and row
+  std::vector<int64_t> order;
+  const int64_t* sorted_order = nullptr;
+  if (N >= kInplaceUpdateSortMinRows) {
+    std::vector<int64_t> keys(N), tmp_keys(N), tmp_order(N);
+    order.resize(N);
+    at::parallel_for(0, N, 4096, [&](int64_t n_begin, int64_t n_end) {
+      for (const auto n : c10::irange(n_begin, n_end)) {
+        int32_t D_bytes;
+        keys[n] = row_position(n, &D_bytes);
+        order[n] = n;
+      }
+    });
+    const auto sorted = fbgemm::radix_sort_parallel(
+        keys.data(),
+        order.data(),
+        tmp_keys.data(),
+        tmp_order.data(),
+        N,
+        dev_size + uvm_weights.size(0),
+        /*maybe_with_neg_vals=*/false,
+        at::get_num_threads(),
+        run_on_aten_thread_pool);
+    if (sorted.second != order.data()) {
+      order.swap(tmp_order);
     }
+    sorted_order = order.data();
+  }
+  const bool non_temporal =
+      update_weights.size(0) >= kInplaceUpdateNonTemporalBytes;
 
-    int64_t update_weight_offset = update_offsets[n];
+  // Every row receives at most one update, so the rows are copied in
+  // parallel
+  at::parallel_for(0, N, 64, [&](int64_t i_begin, int64_t i_end) {
+    for (int64_t i = i_begin; i < i_end; i++) {
+      const int64_t n = sorted_order ? sorted_order[i] : i;
+      int32_t D_bytes;
+      const int64_t position = row_position(n, &D_bytes);
+      uint8_t* __restrict__ weight_row = position < dev_size
+          ? &dev_weights[position]
+          : &uvm_weights[position - dev_size];
 
-    const uint8_t* __restrict__ update_weight_row =
-        &update_weights[update_weight_offset];
-    memcpy(weight_row, update_weight_row, D_bytes);
-  }
+      int64_t update_weight_offset = update_offsets[n];
+
+      const uint8_t* __restrict__ update_weight_row =
+          &update_weights[update_weight_offset];
+      if (row_versions == nullptr) {
+        inplace_update_copy_row(
+            weight_row, update_weight_row, D_bytes, non_temporal);
+        continue;
+      }
+
+      // Seqlock write: the version is odd while the row is copied
+      std::atomic_ref<int64_t> version(
+          row_versions
+              [row_versions_offsets[update_table_idx[n]] + update_row_idx[n]]);
+      const int64_t v = version.load(std::memory_order_relaxed);
+      version.store(v + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      inplace_update_copy_row(
+          weight_row, update_weight_row, D_bytes, non_temporal);
+      inplace_update_store_fence(non_temporal);
+      version.store(v + 2, std::memory_order_release);
+    }
+    inplace_update_store_fence(non_temporal);
+  });
 }
 
 void embedding_inplace_update_cpu(
@@ -114,6 +229,81 @@ void embedding_inplace_update_cpu(
       });
 }
 
+void embedding_inplace_update_versioned_cpu(
+    Tensor dev_weights,
+    Tensor uvm_weights,
+    Tensor weights_placements,
+    Tensor weights_offsets,
+    Tensor weights_tys,
+    Tensor D_offsets,
+    Tensor update_weights,
+    Tensor update_table_idx,
+    Tensor update_row_idx,
+    Tensor update_offsets,
+    Tensor row_versions,
+    Tensor row_versions_offsets,
+    const int64_t row_alignment) {
+  TENSOR_ON_CPU(dev_weights);
+  TENSOR_ON_CPU(uvm_weights);
+  TENSOR_ON_CPU(weights_placements);
+  TENSOR_ON_CPU(weights_offsets);
+  TENSOR_ON_CPU(weights_tys);
+  TENSOR_ON_CPU(D_offsets);
+
+  TENSOR_ON_CPU(update_table_idx);
+  TENSOR_ON_CPU(update_row_idx);
+  TENSOR_ON_CPU(update_offsets);
+  TENSOR_ON_CPU(update_weights);
+
+  TENSOR_ON_CPU(row_versions);
+  TENSOR_ON_CPU(row_versions_offsets);
+  TENSOR_CONTIGUOUS(row_versions);
+  TENSOR_CONTIGUOUS(row_versions_offsets);
+  TORCH_CHECK(row_versions.scalar_type() == at::kLong);
+  TORCH_CHECK(row_versions_offsets.scalar_type() == at::kLong);
+  TORCH_CHECK(row_versions_offsets.numel() == D_offsets.numel());
+  const int64_t* row_versions_offsets_ptr =
+      row_versions_offsets.data_ptr<int64_t>();
+  TORCH_CHECK(
+      row_versions_offsets_ptr[row_versions_offsets.numel() - 1] <=
+      row_versions.numel());
+
+  int64_t N = update_row_idx.numel();
+  if (N == 0) {
+    return;
+  }
+
+  AT_DISPATCH_INDEX_TYPES(
+      update_row_idx.scalar_type(),
+      "embedding_inplace_update_versioned_kernel",
+      [&] {
+        const auto table_idx = update_table_idx.accessor<int32_t, 1>();
+        const auto row_idx = update_row_idx.accessor<index_t, 1>();
+        for (const auto n : c10::irange(N)) {
+          const int32_t t = table_idx[n];
+          TORCH_CHECK(t >= 0 && t + 1 < row_versions_offsets.numel());
+          TORCH_CHECK(
+              row_idx[n] >= 0 &&
+              row_versions_offsets_ptr[t] + row_idx[n] <
+                  row_versions_offsets_ptr[t + 1]);
+        }
+        embedding_inplace_update_cpu_kernel(
+            dev_weights.accessor<uint8_t, 1>(),
+            uvm_weights.accessor<uint8_t, 1>(),
+            weights_placements.accessor<int32_t, 1>(),
+            weights_offsets.accessor<int64_t, 1>(),
+            weights_tys.accessor<uint8_t, 1>(),
+            D_offsets.accessor<int32_t, 1>(),
+            update_weights.accessor<uint8_t, 1>(),
+            update_table_idx.accessor<int32_t, 1>(),
+            update_row_idx.accessor<index_t, 1>(),
+            update_offsets.accessor<int64_t, 1>(),
+            row_alignment,
+            row_versions.data_ptr<int64_t>(),
+            row_versions_offsets_ptr);
+      });
+}
+
 Tensor pruned_array_lookup_from_row_idx_cpu(
     const Tensor& update_row_indices,
     const Tensor& update_table_indices,
@@ -165,11 +355,16 @@ Tensor pruned_array_lookup_from_row_idx_cpu(
 TORCH_LIBRARY_FRAGMENT(fbgemm, m) {
   m.def(
       "emb_inplace_update(Tensor(a!) dev_weights, Tensor(b!) uvm_weights, Tensor weights_placements, Tensor weights_offsets, Tensor weights_tys, Tensor D_offsets, Tensor update_weights, Tensor update_table_indices, Tensor update_row_indices, Tensor update_offsets, int row_alignment=1, Tensor(c!)? lxu_cache_weights=None, Tensor? lxu_cache_locations=None) -> ()");
+  m.def(
+      "emb_inplace_update_versioned(Tensor(a!) dev_weights, Tensor(b!) uvm_weights, Tensor weights_placements, Tensor weights_offsets, Tensor weights_tys, Tensor D_offsets, Tensor update_weights, Tensor update_table_indices, Tensor update_row_indices, Tensor update_offsets, Tensor(c!) row_versions, Tensor row_versions_offsets, int row_alignment=1) -> ()");
   m.def(
       "pruned_array_lookup_from_row_idx(Tensor update_row_indices, Tensor update_table_indices, Tensor index_remappings, Tensor index_remappings_offsets) -> Tensor");
 
   DISPATCH_TO_CPU(
       "emb_inplace_update", fbgemm_gpu::embedding_inplace_update_cpu);
+  DISPATCH_TO_CPU(
+      "emb_inplace_update_versioned",
+      fbgemm_gpu::embedding_inplace_update_versioned_cpu);
   DISPATCH_TO_CPU(
       "pruned_array_lookup_from_row_idx",
       fbgemm_gpu::pruned_array_lookup_from_row_idx_cpu);
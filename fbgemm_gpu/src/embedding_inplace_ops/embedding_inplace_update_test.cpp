@@ -8,7 +8,12 @@
 
 #include <folly/Random.h>
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <thread>
 #include "fbgemm_gpu/embedding_inplace_update.h"
+#include "fbgemm_gpu/embedding_row_versions.h"
 
 using namespace ::testing;
 using namespace fbgemm_gpu;
@@ -184,3 +189,141 @@ TEST(EmbeddingInplaceUpdateTest, random_update) {
   // test_embedding_inplace_update<int32_t>();
   test_embedding_inplace_update<int64_t>();
 }
+
+TEST(EmbeddingInplaceUpdateTest, versioned_update_is_never_torn) {
+  // One FP32 table whose rows are rewritten with a single repeated byte, so
+  // a torn row mixes two bytes
+  constexpr int D = 64;
+  constexpr int64_t total_rows = 8;
+  constexpr int num_updates = 200;
+  const int32_t D_bytes =
+      nbit::padded_row_size_in_bytes(D, SparseType::FP32, 1);
+  auto dev_weight = at::zeros({D_bytes * total_rows}, at::kByte);
+  auto uvm_weight = at::empty({0}, at::kByte);
+  auto row_versions = at::zeros({total_rows}, at::kLong);
+  auto row_versions_offsets = at::tensor({int64_t{0}, total_rows}, at::kLong);
+  auto table_idx = at::zeros({total_rows}, at::kInt);
+  auto row_idx = at::arange(total_rows, at::kLong);
+  auto update_offsets = at::arange(total_rows + 1, at::kLong) * D_bytes;
+
+  std::atomic<bool> done{false};
+  int64_t num_validated_reads = 0;
+  std::thread reader([&] {
+    const uint8_t* weights = dev_weight.data_ptr<uint8_t>();
+    int64_t* versions = row_versions.data_ptr<int64_t>();
+    std::vector<uint8_t> row(D_bytes);
+    // Keeps reading after the updates until every row was validated once
+    for (int64_t r = 0; !done.load() || num_validated_reads < total_rows;
+         r = (r + 1) % total_rows) {
+      const int64_t begin = embedding_row_read_begin(&versions[r]);
+      std::memcpy(row.data(), weights + r * D_bytes, D_bytes);
+      if (embedding_row_read_validate(&versions[r], begin)) {
+        EXPECT_EQ(std::count(row.begin(), row.end(), row[0]), D_bytes)
+            << "row " << r << " is torn at version " << begin;
+        num_validated_reads++;
+      }
+    }
+  });
+
+  for (const auto k : c10::irange(1, num_updates + 1)) {
+    auto update_weight = at::full({D_bytes * total_rows}, k, at::kByte);
+    embedding_inplace_update_versioned_cpu(
+        dev_weight,
+        uvm_weight,
+        at::full({1}, static_cast<int32_t>(PlacementType::HOST), at::kInt),
+        at::zeros({1}, at::kLong),
+        at::tensor({uint8_t(SparseType::FP32)}, at::kByte),
+        at::tensor({0, D}, at::kInt),
+        update_weight,
+        table_idx,
+        row_idx,
+        update_offsets,
+        row_versions,
+        row_versions_offsets,
+        /*row_alignment=*/1);
+  }
+  done = true;
+  reader.join();
+
+  EXPECT_TRUE(at::equal(
+      dev_weight, at::full({D_bytes * total_rows}, num_updates, at::kByte)));
+  EXPECT_TRUE(at::equal(
+      row_versions, at::full({total_rows}, 2 * num_updates, at::kLong)));
+}
+
+TEST(EmbeddingInplaceUpdateTest, versioned_update_checks_row_bounds) {
+  // The table has 8 rows but versions only for 4 of them
+  constexpr int D = 4;
+  const int32_t D_bytes =
+      nbit::padded_row_size_in_bytes(D, SparseType::FP32, 1);
+  auto dev_weight = at::zeros({D_bytes * 8}, at::kByte);
+  auto row_versions = at::zeros({4}, at::kLong);
+  EXPECT_THROW(
+      embedding_inplace_update_versioned_cpu(
+          dev_weight,
+          at::empty({0}, at::kByte),
+          at::full({1}, static_cast<int32_t>(PlacementType::HOST), at::kInt),
+          at::zeros({1}, at::kLong),
+          at::tensor({uint8_t(SparseType::FP32)}, at::kByte),
+          at::tensor({0, D}, at::kInt),
+          at::ones({D_bytes}, at::kByte),
+          at::zeros({1}, at::kInt),
+          at::tensor({int64_t{5}}, at::kLong),
+          at::tensor({int64_t{0}, int64_t{D_bytes}}, at::kLong),
+          row_versions,
+          at::tensor({int64_t{0}, int64_t{4}}, at::kLong),
+          /*row_alignment=*/1),
+      c10::Error);
+  EXPECT_TRUE(at::equal(dev_weight, at::zeros({D_bytes * 8}, at::kByte)));
+  EXPECT_TRUE(at::equal(row_versions, at::zeros({4}, at::kLong)));
+}
+
+TEST(EmbeddingInplaceUpdateTest, large_shuffled_update) {
+  // Two FP32 tables, on the host and in UVM, large enough for the updates to
+  // be sorted and written with non-temporal stores
+  constexpr int D = 512;
+  constexpr int64_t rows_per_table = 10000;
+  const int32_t D_bytes =
+      nbit::padded_row_size_in_bytes(D, SparseType::FP32, 1);
+  const int64_t table_bytes = D_bytes * rows_per_table;
+  auto dev_weight = at::zeros({table_bytes}, at::kByte);
+  auto uvm_weight = at::zeros({table_bytes}, at::kByte);
+
+  std::vector<int32_t> update_table_idx;
+  std::vector<int64_t> update_row_idx;
+  for (const auto t : c10::irange(2)) {
+    for (const auto r : c10::irange(rows_per_table)) {
+      update_table_idx.push_back(t);
+      update_row_idx.push_back(r);
+    }
+  }
+  const auto perm = at::randperm(2 * rows_per_table, at::kLong);
+  auto table_idx = at::tensor(update_table_idx, at::kInt).index({perm});
+  auto row_idx = at::tensor(update_row_idx, at::kLong).index({perm});
+  auto update_offsets = at::arange(2 * rows_per_table + 1, at::kLong) * D_bytes;
+  auto update_weight =
+      at::randint(0, 255, {2 * table_bytes}, at::dtype(at::kByte));
+
+  embedding_inplace_update_cpu(
+      dev_weight,
+      uvm_weight,
+      at::tensor(
+          {static_cast<int32_t>(PlacementType::HOST),
+           static_cast<int32_t>(PlacementType::DEVICE)},
+          at::kInt),
+      at::zeros({2}, at::kLong),
+      at::tensor(
+          {uint8_t(SparseType::FP32), uint8_t(SparseType::FP32)}, at::kByte),
+      at::tensor({0, D, 2 * D}, at::kInt),
+      update_weight,
+      table_idx,
+      row_idx,
+      update_offsets,
+      /*row_alignment=*/1);
+
+  const auto updates = update_weight.view({2 * rows_per_table, D_bytes});
+  const auto weights =
+      at::cat({dev_weight, uvm_weight}).view({2 * rows_per_table, D_bytes});
+  const auto positions = table_idx.to(at::kLong) * rows_per_table + row_idx;
+  EXPECT_TRUE(at::equal(weights.index({positions}), updates));
+}
@@ -10,12 +10,16 @@
 #include <ATen/Context.h>
 #include <ATen/Dispatch.h>
 #include <ATen/Functions.h>
+#include <ATen/Parallel.h>
 #include <ATen/TypeDefault.h>
 #include <ATen/core/op_registration/op_registration.h>
 #include <c10/core/ScalarType.h>
 #include <c10/core/TensorOptions.h>
 #include <c10/util/Exception.h>
+#include <c10/util/MaybeOwned.h>
 #include <torch/script.h>
+#include <limits>
+#include <numeric>
 
 #include "fbgemm_gpu/dispatch_macros.h"
 #include "fbgemm_gpu/input_combine.h"
@@ -25,16 +29,12 @@ using Tensor = at::Tensor;
 
 namespace fbgemm_gpu {
 
-Tensor _cat_int_tensors(
+void _cat_int_tensors_out(
+    Tensor& combined_tensors,
     const std::vector<Tensor>& tensor_list,
-    int64_t total_num,
-    bool use_pin_memory) {
-  auto combined_tensors = at::empty(
-      {total_num},
-      at::TensorOptions()
-          .dtype(c10::kInt)
-          .device(tensor_list[0].device())
-          .pinned_memory(use_pin_memory));
+    int64_t total_num) {
+  TORCH_CHECK(combined_tensors.scalar_type() == c10::kInt);
+  at::native::resize_(combined_tensors, {total_num}, c10::nullopt);
 
   auto* combined_tensors_data_ptr =
       combined_tensors.mutable_data_ptr<int32_t>();
@@ -53,6 +53,19 @@ Tensor _cat_int_tensors(
       }
     });
   }
+}
+
+Tensor _cat_int_tensors(
+    const std::vector<Tensor>& tensor_list,
+    int64_t total_num,
+    bool use_pin_memory) {
+  auto combined_tensors = at::empty(
+      {total_num},
+      at::TensorOptions()
+          .dtype(c10::kInt)
+          .device(tensor_list[0].device())
+          .pinned_memory(use_pin_memory));
+  _cat_int_tensors_out(combined_tensors, tensor_list, total_num);
   return combined_tensors;
 }
 
@@ -89,17 +102,14 @@ Tensor _cat_int_tensors_with_padding(
   return combined_tensors;
 }
 
-Tensor _cat_per_sample_weights_list(
+void _cat_per_sample_weights_list_out(
+    Tensor& combined_weights,
     const std::vector<Tensor>& per_sample_weights,
     const std::vector<Tensor>& indices_list,
-    int64_t total_num,
-    bool use_pin_memory) {
-  auto combined_weights = at::ones(
-      {total_num},
-      at::TensorOptions()
-          .dtype(c10::kFloat)
-          .device(per_sample_weights[0].device())
-          .pinned_memory(use_pin_memory));
+    int64_t total_num) {
+  TORCH_CHECK(combined_weights.scalar_type() == c10::kFloat);
+  at::native::resize_(combined_weights, {total_num}, c10::nullopt);
+  combined_weights.fill_(1);
   auto* combined_weights_ptr = combined_weights.mutable_data_ptr<float>();
 
   for (size_t i = 0; i < per_sample_weights.size(); i++) {
@@ -112,10 +122,25 @@ Tensor _cat_per_sample_weights_list(
     }
     combined_weights_ptr += indices_list[i].numel();
   }
+}
+
+Tensor _cat_per_sample_weights_list(
+    const std::vector<Tensor>& per_sample_weights,
+    const std::vector<Tensor>& indices_list,
+    int64_t total_num,
+    bool use_pin_memory) {
+  auto combined_weights = at::empty(
+      {total_num},
+      at::TensorOptions()
+          .dtype(c10::kFloat)
+          .device(per_sample_weights[0].device())
+          .pinned_memory(use_pin_memory));
+  _cat_per_sample_weights_list_out(
+      combined_weights, per_sample_weights, indices_list, total_num);
   return combined_weights;
 }
 
-std::tuple<Tensor, Tensor, Tensor> tbe_input_combine_cpu(
+std::tuple<int64_t, int64_t, int64_t> tbe_input_combine_cpu_output_sizes(
     const std::vector<Tensor>& indices_list,
     const std::vector<Tensor>& offsets_list,
     const std::vector<Tensor>& per_sample_weights,
@@ -130,7 +155,6 @@ std::tuple<Tensor, Tensor, Tensor> tbe_input_combine_cpu(
   int64_t total_indices = 0;
   int64_t total_offsets = 1;
   bool need_weights = false;
-  bool pin_memory = false;
 
   for (size_t i = 0; i < indices_list.size(); i++) {
     TORCH_CHECK(
@@ -155,16 +179,26 @@ std::tuple<Tensor, Tensor, Tensor> tbe_input_combine_cpu(
       need_weights = true;
     }
   }
+  return {total_indices, total_offsets, need_weights ? total_indices : 0};
+}
 
-  auto combined_indices =
-      _cat_int_tensors(indices_list, total_indices, pin_memory);
+std::tuple<Tensor, Tensor, Tensor> tbe_input_combine_cpu_out(
+    Tensor& combined_indices,
+    Tensor& combined_offsets,
+    Tensor& combined_weights,
+    const std::vector<Tensor>& indices_list,
+    const std::vector<Tensor>& offsets_list,
+    const std::vector<Tensor>& per_sample_weights,
+    const Tensor& include_last_offsets) {
+  const auto [total_indices, total_offsets, total_weights] =
+      tbe_input_combine_cpu_output_sizes(
+          indices_list, offsets_list, per_sample_weights, include_last_offsets);
+  auto include_last_offsets_acc = include_last_offsets.accessor<bool, 1>();
 
-  auto combined_offsets = at::empty(
-      {total_offsets},
-      at::TensorOptions()
-          .dtype(c10::kInt)
-          .device(offsets_list[0].device())
-          .pinned_memory(pin_memory));
+  _cat_int_tensors_out(combined_indices, indices_list, total_indices);
+
+  TORCH_CHECK(combined_offsets.scalar_type() == c10::kInt);
+  at::native::resize_(combined_offsets, {total_offsets}, c10::nullopt);
 
   auto combined_offsets_data_ptr = combined_offsets.mutable_data_ptr<int32_t>();
   int32_t offset = 0;
@@ -190,14 +224,35 @@ std::tuple<Tensor, Tensor, Tensor> tbe_input_combine_cpu(
         });
   }
 
-  if (need_weights) {
-    return {
-        std::move(combined_indices),
-        std::move(combined_offsets),
-        _cat_per_sample_weights_list(
-            per_sample_weights, indices_list, total_indices, pin_memory)};
+  if (total_weights > 0) {
+    _cat_per_sample_weights_list_out(
+        combined_weights, per_sample_weights, indices_list, total_indices);
+  } else {
+    TORCH_CHECK(combined_weights.scalar_type() == c10::kFloat);
+    at::native::resize_(combined_weights, {0}, c10::nullopt);
   }
-  return {combined_indices, combined_offsets, at::empty({0})};
+  return {combined_indices, combined_offsets, combined_weights};
+}
+
+std::tuple<Tensor, Tensor, Tensor> tbe_input_combine_cpu(
+    const std::vector<Tensor>& indices_list,
+    const std::vector<Tensor>& offsets_list,
+    const std::vector<Tensor>& per_sample_weights,
+    const Tensor& include_last_offsets) {
+  TORCH_CHECK_GT(indices_list.size(), 0);
+  const auto int_options =
+      at::TensorOptions().dtype(c10::kInt).device(indices_list[0].device());
+  auto combined_indices = at::empty({0}, int_options);
+  auto combined_offsets = at::empty({0}, int_options);
+  auto combined_weights = at::empty({0});
+  return tbe_input_combine_cpu_out(
+      combined_indices,
+      combined_offsets,
+      combined_weights,
+      indices_list,
+      offsets_list,
+      per_sample_weights,
+      include_last_offsets);
 }
 
 std::tuple<Tensor, Tensor, Tensor> tbe_input_combine_with_length_cpu(
@@ -392,6 +447,267 @@ padding_fused_tbe_input_combine_with_length_cpu(
   return {combined_indices, combined_lengths, combined_per_sample_weights};
 }
 
+namespace {
+
+// Bucket and index within the bucket of idx, as assigned by
+// block_bucketize_sparse_features for a block of blk_size rows per rank
+template <typename index_t>
+inline std::pair<int64_t, index_t> block_bucket(
+    const index_t idx,
+    const index_t blk_size,
+    const int64_t my_size) {
+  using uindex_t = std::make_unsigned_t<index_t>;
+  const uindex_t uidx = static_cast<uindex_t>(idx);
+  if (uidx < static_cast<uindex_t>(blk_size * my_size)) {
+    return {uidx / blk_size, uidx % blk_size};
+  }
+  return {uidx % my_size, uidx / my_size};
+}
+
+template <typename offset_t, typename index_t>
+std::tuple<Tensor, Tensor, Tensor, Tensor>
+block_bucketize_permute_tbe_input_combine_kernel(
+    const Tensor& lengths,
+    const Tensor& indices,
+    const Tensor& block_sizes,
+    const int64_t my_size,
+    const std::vector<int32_t>& feature_order,
+    const float* const weights_data) {
+  const int64_t T = block_sizes.numel();
+  const int64_t B = lengths.numel() / T;
+  const int64_t num_output_features = feature_order.size();
+  const auto* const lengths_data = lengths.const_data_ptr<offset_t>();
+  const auto* const indices_data = indices.const_data_ptr<index_t>();
+  const auto* const block_sizes_data = block_sizes.const_data_ptr<index_t>();
+
+  std::vector<int64_t> offsets(T * B + 1, 0);
+  for (const auto tb : c10::irange(T * B)) {
+    offsets[tb + 1] = offsets[tb] + lengths_data[tb];
+  }
+  TORCH_CHECK_EQ(offsets[T * B], indices.numel());
+
+  // Lengths of the bags of every (rank, feature, batch), counted in parallel
+  // since every bag only touches its own lengths
+  const int64_t grain_size = std::max<int64_t>(
+      1,
+      at::internal::GRAIN_SIZE * T * B /
+          std::max<int64_t>(indices.numel(), 1));
+  std::vector<int64_t> rank_lengths(my_size * T * B, 0);
+  at::parallel_for(0, T * B, grain_size, [&](int64_t tb_begin, int64_t tb_end) {
+    for (const auto tb : c10::irange(tb_begin, tb_end)) {
+      const auto blk_size = block_sizes_data[tb / B];
+      for (const auto i : c10::irange(offsets[tb], offsets[tb + 1])) {
+        const int64_t p =
+            block_bucket(indices_data[i], blk_size, my_size).first;
+        rank_lengths[p * T * B + tb]++;
+      }
+    }
+  });
+
+  // Bags of rank r are laid out as a TBE input of the output features
+  auto combined_offsets = at::empty(
+      {my_size, num_output_features * B + 1},
+      lengths.options().dtype(c10::kInt));
+  auto rank_index_offsets =
+      at::empty({my_size + 1}, lengths.options().dtype(c10::kLong));
+  auto* const combined_offsets_data =
+      combined_offsets.mutable_data_ptr<int32_t>();
+  auto* const rank_index_offsets_data =
+      rank_index_offsets.mutable_data_ptr<int64_t>();
+  int64_t total_indices = 0;
+  for (const auto r : c10::irange(my_size)) {
+    rank_index_offsets_data[r] = total_indices;
+    int32_t* const rank_offsets =
+        combined_offsets_data + r * (num_output_features * B + 1);
+    int64_t rank_indices = 0;
+    rank_offsets[0] = 0;
+    for (const auto j : c10::irange(num_output_features)) {
+      for (const auto b : c10::irange(B)) {
+        rank_indices += rank_lengths[(r * T + feature_order[j]) * B + b];
+        rank_offsets[j * B + b + 1] = static_cast<int32_t>(rank_indices);
+      }
+    }
+    TORCH_CHECK(
+        rank_indices <= std::numeric_limits<int32_t>::max(),
+        "the indices of rank ",
+        r,
+        " overflow int32 offsets");
+    total_indices += rank_indices;
+  }
+  rank_index_offsets_data[my_size] = total_indices;
+
+  // Output features of every input feature, usually one
+  std::vector<std::vector<int64_t>> feature_outputs(T);
+  for (const auto j : c10::irange(num_output_features)) {
+    feature_outputs[feature_order[j]].push_back(j);
+  }
+
+  auto combined_indices =
+      at::empty({total_indices}, indices.options().dtype(c10::kInt));
+  auto combined_weights = weights_data != nullptr
+      ? at::empty({total_indices}, indices.options().dtype(c10::kFloat))
+      : at::empty({0});
+  auto* const combined_indices_data =
+      combined_indices.mutable_data_ptr<int32_t>();
+  auto* const combined_weights_data = weights_data != nullptr
+      ? combined_weights.mutable_data_ptr<float>()
+      : nullptr;
+
+  // Scatter every bag into its rank segments, in the order of the input
+  at::parallel_for(0, T * B, grain_size, [&](int64_t tb_begin, int64_t tb_end) {
+    std::vector<int64_t> rank_cursor(my_size, 0);
+    for (const auto tb : c10::irange(tb_begin, tb_end)) {
+      const int64_t t = tb / B;
+      const int64_t b = tb % B;
+      if (feature_outputs[t].empty()) {
+        continue;
+      }
+      const auto blk_size = block_sizes_data[t];
+      for (const auto i : c10::irange(offsets[tb], offsets[tb + 1])) {
+        const auto [p, new_idx] =
+            block_bucket(indices_data[i], blk_size, my_size);
+        const int32_t* const rank_offsets =
+            combined_offsets_data + p * (num_output_features * B + 1);
+        for (const auto j : feature_outputs[t]) {
+          const int64_t pos = rank_index_offsets_data[p] +
+              rank_offsets[j * B + b] + rank_cursor[p];
+          combined_indices_data[pos] = static_cast<int32_t>(new_idx);
+          if (weights_data != nullptr) {
+            combined_weights_data[pos] = weights_data[i];
+          }
+        }
+        rank_cursor[p]++;
+      }
+      for (const auto i : c10::irange(offsets[tb], offsets[tb + 1])) {
+        rank_cursor[block_bucket(indices_data[i], blk_size, my_size).first] =
+            0;
+      }
+    }
+  });
+
+  return {
+      std::move(combined_indices),
+      std::move(combined_offsets),
+      std::move(combined_weights),
+      std::move(rank_index_offsets)};
+}
+
+} // namespace
+
+/// Fuses block_bucketize_sparse_features, permute_2D_sparse_data and
+/// tbe_input_combine: buckets the indices of a [T, B] KJT to my_size ranks,
+/// reorders its features by permute and writes, for every rank, the TBE
+/// input of the permuted features without materializing the intermediate
+/// tensors.
+///
+/// @param lengths [T * B] lengths of the bags
+/// @param indices indices of the bags
+/// @param block_sizes [T] rows per rank of every feature
+/// @param my_size number of ranks
+/// @param permute int32 input feature of every output feature, all the
+///        features in order if not given
+/// @param weights optional float per sample weights of the indices
+/// @return tuple of the int32 indices of all the ranks, the [my_size,
+///         num_output_features * B + 1] int32 offsets of every rank into its
+///         own indices, the per sample weights (empty without weights) and
+///         the [my_size + 1] int64 first index of every rank
+std::tuple<Tensor, Tensor, Tensor, Tensor>
+block_bucketize_permute_tbe_input_combine_cpu(
+    const Tensor& lengths,
+    const Tensor& indices,
+    const Tensor& block_sizes,
+    const int64_t my_size,
+    const c10::optional<Tensor>& permute,
+    const c10::optional<Tensor>& weights) {
+  TENSOR_ON_CPU(lengths);
+  TENSOR_ON_CPU(indices);
+  TENSOR_ON_CPU(block_sizes);
+  TORCH_CHECK_GT(my_size, 0);
+  TORCH_CHECK_EQ(lengths.ndimension(), 1);
+  TORCH_CHECK_EQ(indices.ndimension(), 1);
+  TORCH_CHECK(
+      block_sizes.scalar_type() == indices.scalar_type(),
+      "block_sizes must have the type of indices");
+  const int64_t T = block_sizes.numel();
+  TORCH_CHECK(
+      T > 0 && lengths.numel() % T == 0,
+      "lengths must hold the same number of bags for the ",
+      T,
+      " features");
+  const auto lengths_contig = lengths.expect_contiguous();
+  const auto indices_contig = indices.expect_contiguous();
+  const auto block_sizes_contig = block_sizes.expect_contiguous();
+
+  std::vector<int32_t> feature_order(T);
+  if (permute.has_value()) {
+    TORCH_CHECK(permute->scalar_type() == c10::kInt);
+    const auto permute_contig = permute->expect_contiguous();
+    feature_order.assign(
+        permute_contig->const_data_ptr<int32_t>(),
+        permute_contig->const_data_ptr<int32_t>() + permute_contig->numel());
+    for (const auto t : feature_order) {
+      TORCH_CHECK(0 <= t && t < T, "permute holds feature ", t, " out of ", T);
+    }
+  } else {
+    std::iota(feature_order.begin(), feature_order.end(), 0);
+  }
+
+  c10::MaybeOwned<Tensor> weights_contig;
+  if (weights.has_value()) {
+    TORCH_CHECK(weights->scalar_type() == c10::kFloat);
+    TORCH_CHECK_EQ(weights->numel(), indices.numel());
+    weights_contig = weights->expect_contiguous();
+  }
+  const float* const weights_data = weights.has_value()
+      ? weights_contig->const_data_ptr<float>()
+      : nullptr;
+
+  std::tuple<Tensor, Tensor, Tensor, Tensor> outputs;
+  AT_DISPATCH_INDEX_TYPES(
+      lengths.scalar_type(), "block_bucketize_permute_combine_cpu_1", [&] {
+        using offset_t = index_t;
+        AT_DISPATCH_INDEX_TYPES(
+            indices.scalar_type(),
+            "block_bucketize_permute_combine_cpu_2",
+            [&] {
+              outputs = block_bucketize_permute_tbe_input_combine_kernel<
+                  offset_t,
+                  index_t>(
+                  *lengths_contig,
+                  *indices_contig,
+                  *block_sizes_contig,
+                  my_size,
+                  feature_order,
+                  weights_data);
+            });
+      });
+  return outputs;
+}
+
+namespace {
+
+// tbe_input_combine_out resizes its output arguments in place, and returns
+// nothing so that its schema does not return aliases of the arguments.
+void tbe_input_combine_out_op(
+    Tensor& combined_indices,
+    Tensor& combined_offsets,
+    Tensor& combined_weights,
+    const std::vector<Tensor>& indices_list,
+    const std::vector<Tensor>& offsets_list,
+    const std::vector<Tensor>& per_sample_weights,
+    const Tensor& include_last_offsets) {
+  tbe_input_combine_cpu_out(
+      combined_indices,
+      combined_offsets,
+      combined_weights,
+      indices_list,
+      offsets_list,
+      per_sample_weights,
+      include_last_offsets);
+}
+
+} // namespace
+
 } // namespace fbgemm_gpu
 
 TORCH_LIBRARY_FRAGMENT(fbgemm, m) {
@@ -403,6 +719,10 @@ TORCH_LIBRARY_FRAGMENT(fbgemm, m) {
   m.def(
       "tbe_input_combine(Tensor[] indices_list, Tensor[] offsets_list, Tensor[] per_sample_weights, Tensor include_last_offsets) -> (Tensor, Tensor, Tensor)",
       {PT2_COMPLIANT_TAG});
+  m.def(
+      "tbe_input_combine_out(Tensor(a!) combined_indices, Tensor(b!) combined_offsets, Tensor(c!) combined_weights, Tensor[] indices_list, Tensor[] offsets_list, Tensor[] per_sample_weights, Tensor include_last_offsets) -> ()");
+  m.def(
+      "tbe_input_combine_output_sizes(Tensor[] indices_list, Tensor[] offsets_list, Tensor[] per_sample_weights, Tensor include_last_offsets) -> (int, int, int)");
   m.def(
       "tbe_input_combine_with_length(Tensor[] indices_list, Tensor[] lengths_list, Tensor[] per_sample_weights) -> (Tensor, Tensor, Tensor)",
       {PT2_COMPLIANT_TAG});
@@ -410,7 +730,14 @@ TORCH_LIBRARY_FRAGMENT(fbgemm, m) {
       "padding_fused_tbe_input_combine(Tensor[] indices_list, Tensor[] offsets_list, Tensor[] per_sample_weights, Tensor include_last_offsets, int batch_size) -> (Tensor, Tensor, Tensor)");
   m.def(
       "padding_fused_tbe_input_combine_with_length(Tensor[] indices_list, Tensor[] lengths_list, Tensor[] per_sample_weights, int batch_size) -> (Tensor, Tensor, Tensor)");
+  m.def(
+      "block_bucketize_permute_tbe_input_combine(Tensor lengths, Tensor indices, Tensor block_sizes, int my_size, Tensor? permute=None, Tensor? weights=None) -> (Tensor, Tensor, Tensor, Tensor)");
   DISPATCH_TO_CPU("tbe_input_combine", fbgemm_gpu::tbe_input_combine_cpu);
+  DISPATCH_TO_CPU(
+      "tbe_input_combine_out", fbgemm_gpu::tbe_input_combine_out_op);
+  DISPATCH_TO_CPU(
+      "tbe_input_combine_output_sizes",
+      fbgemm_gpu::tbe_input_combine_cpu_output_sizes);
   DISPATCH_TO_CPU(
       "tbe_input_combine_with_length",
       fbgemm_gpu::tbe_input_combine_with_length_cpu);
@@ -420,4 +747,7 @@ TORCH_LIBRARY_FRAGMENT(fbgemm, m) {
   DISPATCH_TO_CPU(
       "padding_fused_tbe_input_combine_with_length",
       fbgemm_gpu::padding_fused_tbe_input_combine_with_length_cpu);
+  DISPATCH_TO_CPU(
+      "block_bucketize_permute_tbe_input_combine",
+      fbgemm_gpu::block_bucketize_permute_tbe_input_combine_cpu);
 }
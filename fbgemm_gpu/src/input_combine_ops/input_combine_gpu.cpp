@@ -8,6 +8,10 @@
 
 #include <ATen/ATen.h>
 #include <ATen/core/op_registration/op_registration.h>
+#include <ATen/cuda/CUDAContext.h>
+#include <ATen/cuda/CUDAEvent.h>
+#include <c10/cuda/CUDAGuard.h>
+#include <torch/custom_class.h>
 #include <torch/library.h>
 
 #include "fbgemm_gpu/input_combine.h"
@@ -218,6 +222,113 @@ std::tuple<Tensor, Tensor, Tensor> tbe_input_combine_with_length_gpu(
       device.index());
 }
 
+// Combines CPU TBE inputs like tbe_input_combine_cpu, but into a ring of
+// reusable pinned host slots that are copied asynchronously to matching
+// device buffers, so that neither the combined host tensors nor their device
+// copies are allocated per batch. The tensors returned by combine() belong to
+// the slot and are overwritten num_slots calls later; combine() only blocks
+// until the previous H2D copy out of the slot has completed, so the consumer
+// of the device tensors must run on the stream current at combine() time
+class TBEInputRingBuffer : public torch::jit::CustomClassHolder {
+ public:
+  TBEInputRingBuffer(int64_t num_slots, int64_t device_index)
+      : device_(at::kCUDA, static_cast<c10::DeviceIndex>(device_index)) {
+    TORCH_CHECK_GT(num_slots, 0);
+    const auto pinned_int_options =
+        at::TensorOptions().dtype(c10::kInt).pinned_memory(true);
+    const auto pinned_float_options =
+        at::TensorOptions().dtype(c10::kFloat).pinned_memory(true);
+    const auto int_options =
+        at::TensorOptions().dtype(c10::kInt).device(device_);
+    const auto float_options =
+        at::TensorOptions().dtype(c10::kFloat).device(device_);
+    slots_.resize(num_slots);
+    for (auto& slot : slots_) {
+      slot.host_indices = at::empty({0}, pinned_int_options);
+      slot.host_offsets = at::empty({0}, pinned_int_options);
+      slot.host_weights = at::empty({0}, pinned_float_options);
+      slot.indices = at::empty({0}, int_options);
+      slot.offsets = at::empty({0}, int_options);
+      slot.weights = at::empty({0}, float_options);
+    }
+  }
+
+  std::tuple<Tensor, Tensor, Tensor> combine(
+      const std::vector<Tensor>& indices_list,
+      const std::vector<Tensor>& offsets_list,
+      const std::vector<Tensor>& per_sample_weights,
+      const Tensor& include_last_offsets) {
+    for (const auto& indices : indices_list) {
+      TENSOR_ON_CPU(indices);
+    }
+    for (const auto& offsets : offsets_list) {
+      TENSOR_ON_CPU(offsets);
+    }
+
+    auto& slot = slots_[next_slot_];
+    next_slot_ = (next_slot_ + 1) % slots_.size();
+
+    // The host slot is still the source of an in-flight copy until its event
+    // has fired
+    slot.copied.synchronize();
+    tbe_input_combine_cpu_out(
+        slot.host_indices,
+        slot.host_offsets,
+        slot.host_weights,
+        indices_list,
+        offsets_list,
+        per_sample_weights,
+        include_last_offsets);
+
+    at::cuda::CUDAGuard device_guard(device_);
+    auto stream = at::cuda::getCurrentCUDAStream();
+    slot.indices.resize_(slot.host_indices.sizes());
+    slot.offsets.resize_(slot.host_offsets.sizes());
+    slot.weights.resize_(slot.host_weights.sizes());
+    slot.indices.copy_(slot.host_indices, /*non_blocking=*/true);
+    slot.offsets.copy_(slot.host_offsets, /*non_blocking=*/true);
+    if (slot.host_weights.numel() > 0) {
+      slot.weights.copy_(slot.host_weights, /*non_blocking=*/true);
+    }
+    slot.copied.record(stream);
+
+    return {slot.indices, slot.offsets, slot.weights};
+  }
+
+  // Blocks until the H2D copies of all slots have completed
+  void synchronize() {
+    for (auto& slot : slots_) {
+      slot.copied.synchronize();
+    }
+  }
+
+  int64_t num_slots() const {
+    return slots_.size();
+  }
+
+ private:
+  struct Slot {
+    Tensor host_indices;
+    Tensor host_offsets;
+    Tensor host_weights;
+    Tensor indices;
+    Tensor offsets;
+    Tensor weights;
+    at::cuda::CUDAEvent copied;
+  };
+
+  at::Device device_;
+  std::vector<Slot> slots_;
+  size_t next_slot_ = 0;
+};
+
+static auto TBEInputRingBufferRegistry =
+    torch::class_<TBEInputRingBuffer>("fbgemm", "TBEInputRingBuffer")
+        .def(torch::init<int64_t, int64_t>())
+        .def("combine", &TBEInputRingBuffer::combine)
+        .def("synchronize", &TBEInputRingBuffer::synchronize)
+        .def("num_slots", &TBEInputRingBuffer::num_slots);
+
 TORCH_LIBRARY_IMPL(fbgemm, CUDA, m) {
   DISPATCH_TO_CUDA(
       "tbe_input_combine_with_length",
@@ -6,6 +6,9 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <limits>
+#include <numeric>
+
 #include <ATen/ATen.h>
 #include <ATen/AccumulateType.h>
 #include <ATen/core/dispatch/Dispatcher.h>
@@ -13,6 +16,7 @@
 #include <torch/library.h>
 #include "ATen/Parallel.h"
 
+#include "fbgemm/Utils.h"
 #include "fbgemm_gpu/dispatch_macros.h"
 #include "fbgemm_gpu/sparse_ops.h"
 #include "fbgemm_gpu/sparse_ops_utils.h"
@@ -30,34 +34,39 @@ namespace {
 /// The following are Jagged Tensor CPU Operators
 
 // Ref. http://tensor-compiler.org/kjolstad-oopsla17-tensor-compiler.pdf
-template <int NUM_JAGGED_DIM, typename index_t>
-inline bool walk_down_tensor_storage_tree_except_last_(
-    int& offset,
-    const int flattened_jagged_idx,
-    const int64_t* jagged_dims,
-    const std::vector<at::TensorAccessor<index_t, 1>>& x_offsets) {
-  // compute coorindates
-  int jagged_coords[NUM_JAGGED_DIM];
-  int j_temp = flattened_jagged_idx;
-#pragma unroll
-  for (int d = NUM_JAGGED_DIM - 2; d >= 0; --d) {
-    const int jagged_size = jagged_dims[d + 1];
-    jagged_coords[d] = j_temp % jagged_size;
-    j_temp /= jagged_size;
-  }
-
-  bool is_zero = false;
-#pragma unroll
-  for (int d = 0; d < NUM_JAGGED_DIM - 1; ++d) {
-    const int begin = x_offsets[d][offset];
-    const int end = x_offsets[d][offset + 1];
-    if (jagged_coords[d] >= end - begin) {
-      is_zero = true;
-      break;
+// The rows of a jagged tensor padded to the dense sizes [outer_dense_size,
+// jagged dims..., inner_dense_size], with the innermost jagged dimension
+// folded into the rows: the offset of each row into the last x_offsets, or
+// -1 for the rows past the length of an outer jagged dimension. The offsets
+// tree is walked down one level at a time for all the rows, instead of from
+// the root for every row.
+template <typename index_t>
+std::vector<int64_t> jagged_row_offsets_(
+    const std::vector<at::TensorAccessor<index_t, 1>>& x_offsets,
+    const int outer_dense_size,
+    const int64_t* dense_sizes,
+    const int num_jagged_dim) {
+  std::vector<int64_t> row_offsets(outer_dense_size);
+  std::iota(row_offsets.begin(), row_offsets.end(), 0);
+  for (int d = 0; d < num_jagged_dim - 1; ++d) {
+    const int64_t jagged_size = dense_sizes[d + 1];
+    std::vector<int64_t> next_row_offsets(
+        row_offsets.size() * jagged_size, -1);
+    for (const auto i : c10::irange(row_offsets.size())) {
+      const int64_t offset = row_offsets[i];
+      if (offset < 0) {
+        continue;
+      }
+      const int64_t begin = x_offsets[d][offset];
+      const int64_t length =
+          std::min<int64_t>(x_offsets[d][offset + 1] - begin, jagged_size);
+      for (int64_t c = 0; c < length; ++c) {
+        next_row_offsets[i * jagged_size + c] = begin + c;
+      }
     }
-    offset = begin + jagged_coords[d];
+    row_offsets.swap(next_row_offsets);
   }
-  return is_zero;
+  return row_offsets;
 }
 
 template <typename index_t>
@@ -86,6 +95,76 @@ std::vector<at::TensorAccessor<index_t, 1>> collect_offsets_accessors(
   return x_offsets_accessors;
 }
 
+// Contiguous paths of the kernels below for a single jagged dimension: the
+// rows of the outer dense dimension run in parallel, each over contiguous
+// values that the compiler vectorizes. Chunks hold about GRAIN_SIZE values.
+inline int64_t jagged_2d_grain_size(const int64_t max_L, const int64_t D) {
+  return std::max<int64_t>(
+      1, at::internal::GRAIN_SIZE / std::max<int64_t>(max_L * D, 1));
+}
+
+template <typename index_t, typename scalar_t, typename F>
+void jagged_2d_dense_elementwise_dense_output_(
+    const int64_t outer_dense_size,
+    const int64_t max_L,
+    const int64_t D,
+    const index_t* const offsets,
+    const scalar_t* const x,
+    const scalar_t* const y,
+    scalar_t* const output,
+    F f,
+    const scalar_t padding_value) {
+  at::parallel_for(
+      0,
+      outer_dense_size,
+      jagged_2d_grain_size(max_L, D),
+      [&](int64_t b_begin, int64_t b_end) {
+        for (const auto b : c10::irange(b_begin, b_end)) {
+          const int64_t begin = offsets[b];
+          const int64_t L = std::max<int64_t>(
+              std::min<int64_t>(offsets[b + 1] - begin, max_L), 0);
+          const scalar_t* const x_b = x + begin * D;
+          const scalar_t* const y_b = y + b * max_L * D;
+          scalar_t* const output_b = output + b * max_L * D;
+          for (const auto i : c10::irange(L * D)) {
+            output_b[i] = f(x_b[i], y_b[i]);
+          }
+          for (const auto i : c10::irange(L * D, max_L * D)) {
+            output_b[i] = f(padding_value, y_b[i]);
+          }
+        }
+      });
+}
+
+template <typename index_t, typename scalar_t, typename F>
+void jagged_2d_dense_elementwise_jagged_output_(
+    const int64_t outer_dense_size,
+    const int64_t max_L,
+    const int64_t D,
+    const index_t* const offsets,
+    const scalar_t* const x,
+    const scalar_t* const y,
+    scalar_t* const output,
+    F f) {
+  at::parallel_for(
+      0,
+      outer_dense_size,
+      jagged_2d_grain_size(max_L, D),
+      [&](int64_t b_begin, int64_t b_end) {
+        for (const auto b : c10::irange(b_begin, b_end)) {
+          const int64_t begin = offsets[b];
+          const int64_t L = std::max<int64_t>(
+              std::min<int64_t>(offsets[b + 1] - begin, max_L), 0);
+          const scalar_t* const x_b = x + begin * D;
+          const scalar_t* const y_b = y + b * max_L * D;
+          scalar_t* const output_b = output + begin * D;
+          for (const auto i : c10::irange(L * D)) {
+            output_b[i] = f(x_b[i], y_b[i]);
+          }
+        }
+      });
+}
+
 /**
  * @tparam F element wise compute functor
  * @param padding_value instead of zero, can configure the padding
@@ -151,55 +230,79 @@ void jagged_dense_elementwise_dense_output_kernel_(
       collect_offsets_accessors<index_t>(
           x_offsets, outer_dense_size, NUM_JAGGED_DIM);
 
+  if (NUM_JAGGED_DIM == 1 && x_values.is_contiguous() &&
+      y_reshaped.is_contiguous() && output_reshaped.is_contiguous() &&
+      x_offsets[0].is_contiguous()) {
+    jagged_2d_dense_elementwise_dense_output_<index_t, scalar_t>(
+        outer_dense_size,
+        jagged_innermost_size,
+        inner_dense_size,
+        x_offsets[0].data_ptr<index_t>(),
+        x_values.data_ptr<scalar_t>(),
+        y_reshaped.data_ptr<scalar_t>(),
+        output_reshaped.data_ptr<scalar_t>(),
+        f,
+        padding_value);
+    return;
+  }
+
   const at::TensorAccessor<scalar_t, 2> x_accessor =
       x_values.accessor<scalar_t, 2>();
   const at::TensorAccessor<scalar_t, 3> y_accessor =
       y_reshaped.accessor<scalar_t, 3>();
   at::TensorAccessor<scalar_t, 3> output_accessor =
       output_reshaped.accessor<scalar_t, 3>();
-  for (const auto oidx : c10::irange(outer_dense_size)) {
-    for (int joidx = 0; joidx < jagged_folded_size / jagged_innermost_size;
-         ++joidx) {
-      int offset_base = oidx;
-      const bool is_zero =
-          walk_down_tensor_storage_tree_except_last_<NUM_JAGGED_DIM>(
-              offset_base, joidx, y.sizes().data(), x_offsets_accessors);
-
-      // As a perf optimization, a separate loop level for the inner-most
-      // jagged dimension.
-      int jiidx = 0;
-      if (!is_zero) {
-        const int begin = x_offsets_accessors[NUM_JAGGED_DIM - 1][offset_base];
-        const int end =
-            x_offsets_accessors[NUM_JAGGED_DIM - 1][offset_base + 1];
-        for (; jiidx < std::min(end - begin, jagged_innermost_size); ++jiidx) {
-          int jidx = joidx * jagged_innermost_size + jiidx;
-          if (NO_INNER_DENSE) {
-            output_accessor[oidx][jidx][0] =
-                f(x_accessor[begin + jiidx][0], y_accessor[oidx][jidx][0]);
-          } else {
-            for (const auto iidx : c10::irange(inner_dense_size)) {
-              output_accessor[oidx][jidx][iidx] =
-                  f(x_accessor[begin + jiidx][iidx],
-                    y_accessor[oidx][jidx][iidx]);
+  const int num_jagged_rows = jagged_folded_size / jagged_innermost_size;
+  const std::vector<int64_t> row_offsets = jagged_row_offsets_<index_t>(
+      x_offsets_accessors, outer_dense_size, y.sizes().data(), NUM_JAGGED_DIM);
+  at::parallel_for(
+      0,
+      row_offsets.size(),
+      jagged_2d_grain_size(jagged_innermost_size, inner_dense_size),
+      [&](int64_t row_begin, int64_t row_end) {
+        for (const auto row : c10::irange(row_begin, row_end)) {
+          const int oidx = row / num_jagged_rows;
+          const int joidx = row % num_jagged_rows;
+          const int offset_base = row_offsets[row];
+          const bool is_zero = offset_base < 0;
+
+          // As a perf optimization, a separate loop level for the inner-most
+          // jagged dimension.
+          int jiidx = 0;
+          if (!is_zero) {
+            const int begin =
+                x_offsets_accessors[NUM_JAGGED_DIM - 1][offset_base];
+            const int end =
+                x_offsets_accessors[NUM_JAGGED_DIM - 1][offset_base + 1];
+            for (; jiidx < std::min(end - begin, jagged_innermost_size);
+                 ++jiidx) {
+              int jidx = joidx * jagged_innermost_size + jiidx;
+              if (NO_INNER_DENSE) {
+                output_accessor[oidx][jidx][0] =
+                    f(x_accessor[begin + jiidx][0], y_accessor[oidx][jidx][0]);
+              } else {
+                for (const auto iidx : c10::irange(inner_dense_size)) {
+                  output_accessor[oidx][jidx][iidx] =
+                      f(x_accessor[begin + jiidx][iidx],
+                        y_accessor[oidx][jidx][iidx]);
+                }
+              }
             }
           }
-        }
-      }
-      for (; jiidx < jagged_innermost_size; ++jiidx) {
-        int jidx = joidx * jagged_innermost_size + jiidx;
-        if (NO_INNER_DENSE) {
-          output_accessor[oidx][jidx][0] =
-              f(padding_value, y_accessor[oidx][jidx][0]);
-        } else {
-          for (const auto iidx : c10::irange(inner_dense_size)) {
-            output_accessor[oidx][jidx][iidx] =
-                f(padding_value, y_accessor[oidx][jidx][iidx]);
+          for (; jiidx < jagged_innermost_size; ++jiidx) {
+            int jidx = joidx * jagged_innermost_size + jiidx;
+            if (NO_INNER_DENSE) {
+              output_accessor[oidx][jidx][0] =
+                  f(padding_value, y_accessor[oidx][jidx][0]);
+            } else {
+              for (const auto iidx : c10::irange(inner_dense_size)) {
+                output_accessor[oidx][jidx][iidx] =
+                    f(padding_value, y_accessor[oidx][jidx][iidx]);
+              }
+            }
           }
-        }
-      }
-    } // for each joidx
-  } // for each oidx
+        } // for each row
+      });
 }
 
 template <typename scalar_t, typename F>
@@ -297,43 +400,66 @@ void jagged_dense_elementwise_jagged_output_kernel_(
       collect_offsets_accessors<index_t>(
           x_offsets, outer_dense_size, NUM_JAGGED_DIM);
 
+  if (NUM_JAGGED_DIM == 1 && x_values.is_contiguous() &&
+      y_reshaped.is_contiguous() && output_values.is_contiguous() &&
+      x_offsets[0].is_contiguous()) {
+    jagged_2d_dense_elementwise_jagged_output_<index_t, scalar_t>(
+        outer_dense_size,
+        jagged_innermost_size,
+        inner_dense_size,
+        x_offsets[0].data_ptr<index_t>(),
+        x_values.data_ptr<scalar_t>(),
+        y_reshaped.data_ptr<scalar_t>(),
+        output_values.data_ptr<scalar_t>(),
+        f);
+    return;
+  }
+
   const at::TensorAccessor<scalar_t, 2> x_accessor =
       x_values.accessor<scalar_t, 2>();
   const at::TensorAccessor<scalar_t, 3> y_accessor =
       y_reshaped.accessor<scalar_t, 3>();
   at::TensorAccessor<scalar_t, 2> output_accessor =
       output_values.accessor<scalar_t, 2>();
-  for (const auto oidx : c10::irange(outer_dense_size)) {
-    for (int joidx = 0; joidx < jagged_folded_size / jagged_innermost_size;
-         ++joidx) {
-      int offset_base = oidx;
-      bool is_zero = walk_down_tensor_storage_tree_except_last_<NUM_JAGGED_DIM>(
-          offset_base, joidx, y.sizes().data(), x_offsets_accessors);
-
-      // As a perf optimization, a separate loop level for the inner-most
-      // jagged dimension.
-      if (!is_zero) {
-        const int begin = x_offsets_accessors[NUM_JAGGED_DIM - 1][offset_base];
-        const int end =
-            x_offsets_accessors[NUM_JAGGED_DIM - 1][offset_base + 1];
-        for (int jiidx = 0;
-             jiidx < std::min(end - begin, jagged_innermost_size);
-             ++jiidx) {
-          int jidx = joidx * jagged_innermost_size + jiidx;
-          if (NO_INNER_DENSE) {
-            output_accessor[begin + jiidx][0] =
-                f(x_accessor[begin + jiidx][0], y_accessor[oidx][jidx][0]);
-          } else {
-            for (const auto iidx : c10::irange(inner_dense_size)) {
-              output_accessor[begin + jiidx][iidx] =
-                  f(x_accessor[begin + jiidx][iidx],
-                    y_accessor[oidx][jidx][iidx]);
+  const int num_jagged_rows = jagged_folded_size / jagged_innermost_size;
+  const std::vector<int64_t> row_offsets = jagged_row_offsets_<index_t>(
+      x_offsets_accessors, outer_dense_size, y.sizes().data(), NUM_JAGGED_DIM);
+  at::parallel_for(
+      0,
+      row_offsets.size(),
+      jagged_2d_grain_size(jagged_innermost_size, inner_dense_size),
+      [&](int64_t row_begin, int64_t row_end) {
+        for (const auto row : c10::irange(row_begin, row_end)) {
+          const int oidx = row / num_jagged_rows;
+          const int joidx = row % num_jagged_rows;
+          const int offset_base = row_offsets[row];
+          const bool is_zero = offset_base < 0;
+
+          // As a perf optimization, a separate loop level for the inner-most
+          // jagged dimension.
+          if (!is_zero) {
+            const int begin =
+                x_offsets_accessors[NUM_JAGGED_DIM - 1][offset_base];
+            const int end =
+                x_offsets_accessors[NUM_JAGGED_DIM - 1][offset_base + 1];
+            for (int jiidx = 0;
+                 jiidx < std::min(end - begin, jagged_innermost_size);
+                 ++jiidx) {
+              int jidx = joidx * jagged_innermost_size + jiidx;
+              if (NO_INNER_DENSE) {
+                output_accessor[begin + jiidx][0] =
+                    f(x_accessor[begin + jiidx][0], y_accessor[oidx][jidx][0]);
+              } else {
+                for (const auto iidx : c10::irange(inner_dense_size)) {
+                  output_accessor[begin + jiidx][iidx] =
+                      f(x_accessor[begin + jiidx][iidx],
+                        y_accessor[oidx][jidx][iidx]);
+                }
+              }
             }
           }
-        }
-      }
-    } // for each joidx
-  } // for each oidx
+        } // for each row
+      });
 }
 
 template <typename scalar_t, typename F>
@@ -559,47 +685,59 @@ void jagged_jagged_elementwise_dense_output_kernel_(
       y_values.accessor<scalar_t, 2>();
   at::TensorAccessor<scalar_t, 3> output_accessor =
       output_reshaped.accessor<scalar_t, 3>();
-  for (const auto oidx : c10::irange(outer_dense_size)) {
-    for (int joidx = 0; joidx < jagged_folded_size / jagged_innermost_size;
-         ++joidx) {
-      int offset_base = oidx;
-      const bool is_zero =
-          walk_down_tensor_storage_tree_except_last_<NUM_JAGGED_DIM>(
-              offset_base, joidx, output.sizes().data(), x_offsets_accessors);
-
-      // As a perf optimization, a separate loop level for the inner-most
-      // jagged dimension.
-      int jiidx = 0;
-      if (!is_zero) {
-        const int begin = x_offsets_accessors[NUM_JAGGED_DIM - 1][offset_base];
-        const int end =
-            x_offsets_accessors[NUM_JAGGED_DIM - 1][offset_base + 1];
-        for (; jiidx < std::min(end - begin, jagged_innermost_size); ++jiidx) {
-          int jidx = joidx * jagged_innermost_size + jiidx;
-          if (NO_INNER_DENSE) {
-            output_accessor[oidx][jidx][0] =
-                f(x_accessor[begin + jiidx][0], y_accessor[begin + jiidx][0]);
-          } else {
-            for (const auto iidx : c10::irange(inner_dense_size)) {
-              output_accessor[oidx][jidx][iidx] =
-                  f(x_accessor[begin + jiidx][iidx],
-                    y_accessor[begin + jiidx][iidx]);
+  const int num_jagged_rows = jagged_folded_size / jagged_innermost_size;
+  const std::vector<int64_t> row_offsets = jagged_row_offsets_<index_t>(
+      x_offsets_accessors,
+      outer_dense_size,
+      output.sizes().data(),
+      NUM_JAGGED_DIM);
+  at::parallel_for(
+      0,
+      row_offsets.size(),
+      jagged_2d_grain_size(jagged_innermost_size, inner_dense_size),
+      [&](int64_t row_begin, int64_t row_end) {
+        for (const auto row : c10::irange(row_begin, row_end)) {
+          const int oidx = row / num_jagged_rows;
+          const int joidx = row % num_jagged_rows;
+          const int offset_base = row_offsets[row];
+          const bool is_zero = offset_base < 0;
+
+          // As a perf optimization, a separate loop level for the inner-most
+          // jagged dimension.
+          int jiidx = 0;
+          if (!is_zero) {
+            const int begin =
+                x_offsets_accessors[NUM_JAGGED_DIM - 1][offset_base];
+            const int end =
+                x_offsets_accessors[NUM_JAGGED_DIM - 1][offset_base + 1];
+            for (; jiidx < std::min(end - begin, jagged_innermost_size);
+                 ++jiidx) {
+              int jidx = joidx * jagged_innermost_size + jiidx;
+              if (NO_INNER_DENSE) {
+                output_accessor[oidx][jidx][0] =
+                    f(x_accessor[begin + jiidx][0],
+                      y_accessor[begin + jiidx][0]);
+              } else {
+                for (const auto iidx : c10::irange(inner_dense_size)) {
+                  output_accessor[oidx][jidx][iidx] =
+                      f(x_accessor[begin + jiidx][iidx],
+                        y_accessor[begin + jiidx][iidx]);
+                }
+              }
             }
           }
-        }
-      }
-      for (; jiidx < jagged_innermost_size; ++jiidx) {
-        int jidx = joidx * jagged_innermost_size + jiidx;
-        if (NO_INNER_DENSE) {
-          output_accessor[oidx][jidx][0] = padding_value;
-        } else {
-          for (const auto iidx : c10::irange(inner_dense_size)) {
-            output_accessor[oidx][jidx][iidx] = padding_value;
+          for (; jiidx < jagged_innermost_size; ++jiidx) {
+            int jidx = joidx * jagged_innermost_size + jiidx;
+            if (NO_INNER_DENSE) {
+              output_accessor[oidx][jidx][0] = padding_value;
+            } else {
+              for (const auto iidx : c10::irange(inner_dense_size)) {
+                output_accessor[oidx][jidx][iidx] = padding_value;
+              }
+            }
           }
-        }
-      }
-    } // for each joidx
-  } // for each oidx
+        } // for each row
+      });
 }
 
 template <typename scalar_t, typename F>
@@ -684,41 +822,81 @@ jagged_dense_elementwise_add_jagged_output_cpu(
   return {sum_values, x_offsets};
 }
 
+// Segments of the jagged bmm kernels below with at least this many
+// multiply-adds go through a GEMM, the smaller ones through the loops
+constexpr int64_t kJaggedBmmMinGemmWork = 1 << 14;
+
+// Only float and double use the GEMM, the reduced precision types keep the
+// float accumulation of the loops
+template <typename scalar_t>
+constexpr bool jagged_bmm_use_gemm() {
+  return std::is_same_v<scalar_t, float> || std::is_same_v<scalar_t, double>;
+}
+
+// Chunks of the segments hold about GRAIN_SIZE multiply-adds
+inline int64_t jagged_bmm_grain_size(const int64_t B, const int64_t work) {
+  return std::max<int64_t>(
+      1, at::internal::GRAIN_SIZE * B / std::max<int64_t>(work, 1));
+}
+
 template <typename index_t, typename scalar_t>
 void dense_vec_jagged_2d_bmm(
-    const at::TensorAccessor<scalar_t, 2>& v,
-    const at::TensorAccessor<scalar_t, 2>& a_values,
+    const Tensor& v,
+    const Tensor& a_values,
     const at::TensorAccessor<index_t, 1>& a_offsets,
-    at::TensorAccessor<scalar_t, 2> output) {
+    const Tensor& output) {
   const int B = a_offsets.size(0) - 1;
   const int H = v.size(0) / B;
   const int max_L = v.size(1);
   const int D = output.size(1);
-  for (const auto b : c10::irange(B)) {
-    const int row_start = a_offsets[b];
-    const int row_end = a_offsets[b + 1];
-    const int length = std::min(row_end - row_start, max_L);
-    if (length == 0) {
-      for (const auto h : c10::irange(H)) {
-        for (const auto d : c10::irange(D)) {
-          output[b * H + h][d] = 0;
-        }
-      }
-    } else {
-      for (const auto h : c10::irange(H)) {
-        for (const auto d : c10::irange(D)) {
-          // use is_cuda=true because acc_type<float, false> = double is too
-          // conservative
-          at::acc_type<scalar_t, true> acc =
-              v[b * H + h][0] * a_values[row_start][h * D + d];
-          for (const auto l : c10::irange(1, length)) {
-            acc += v[b * H + h][l] * a_values[row_start + l][h * D + d];
-          }
-          output[b * H + h][d] = acc;
-        }
-      }
-    } // length > 0
-  } // for each b
+  const auto v_accessor = v.accessor<scalar_t, 2>();
+  const auto a_values_accessor = a_values.accessor<scalar_t, 2>();
+  auto output_accessor = output.accessor<scalar_t, 2>();
+  const bool use_gemm =
+      jagged_bmm_use_gemm<scalar_t>() && a_values.size(1) == H * D;
+  at::parallel_for(
+      0,
+      B,
+      jagged_bmm_grain_size(B, a_values.numel()),
+      [&](int64_t b_begin, int64_t b_end) {
+        for (const auto b : c10::irange(b_begin, b_end)) {
+          const int row_start = a_offsets[b];
+          const int row_end = a_offsets[b + 1];
+          const int length = std::min(row_end - row_start, max_L);
+          if (length == 0) {
+            for (const auto h : c10::irange(H)) {
+              for (const auto d : c10::irange(D)) {
+                output_accessor[b * H + h][d] = 0;
+              }
+            }
+          } else if (
+              use_gemm &&
+              static_cast<int64_t>(length) * H * D >= kJaggedBmmMinGemmWork) {
+            // [H, 1, L] x [H, L, D] -> [H, 1, D]
+            Tensor output_b = output.narrow(0, b * H, H).unsqueeze(1);
+            at::bmm_out(
+                output_b,
+                v.narrow(0, b * H, H).narrow(1, 0, length).unsqueeze(1),
+                a_values.narrow(0, row_start, length)
+                    .view({length, H, D})
+                    .transpose(0, 1));
+          } else {
+            for (const auto h : c10::irange(H)) {
+              for (const auto d : c10::irange(D)) {
+                // use is_cuda=true because acc_type<float, false> = double is
+                // too conservative
+                at::acc_type<scalar_t, true> acc = v_accessor[b * H + h][0] *
+                    a_values_accessor[row_start][h * D + d];
+                for (const auto l : c10::irange(1, length)) {
+                  acc += v_accessor[b * H + h][l] *
+                      a_values_accessor[row_start + l][h * D + d];
+                }
+                output_accessor[b * H + h][d] = acc;
+              }
+            }
+          } // length > 0
+        } // for each b
+      });
 }
 
 template <typename index_t, typename scalar_t>
@@ -811,10 +989,7 @@ Tensor batched_dense_vec_jagged_2d_mul_forward(
           FBGEMM_DISPATCH_FLOATING_TYPES(
               a_values.scalar_type(), "dense_vec_jagged_2d_bmm_kernel_2", [&] {
                 dense_vec_jagged_2d_bmm<index_t, scalar_t>(
-                    v.accessor<scalar_t, 2>(),
-                    a_values.accessor<scalar_t, 2>(),
-                    a_offsets.accessor<index_t, 1>(),
-                    output.accessor<scalar_t, 2>());
+                    v, a_values, a_offsets.accessor<index_t, 1>(), output);
               });
         });
   }
@@ -967,6 +1142,112 @@ jagged_2d_to_dense_forward_cpu(Tensor values, Tensor offsets, int64_t max_L) {
       /*padding_value=*/0);
 }
 
+namespace {
+
+// The [T, B + 1] offsets of the T features of a stacked jagged tensor from
+// its [T, B] lengths, in one pass; each row starts from 0.
+Tensor stacked_lengths_to_offsets_(const Tensor& lengths) {
+  const auto lengths_contig = lengths.contiguous();
+  const int64_t T = lengths.size(0);
+  const int64_t B = lengths.size(1);
+  auto offsets = at::empty({T, B + 1}, lengths.options());
+  AT_DISPATCH_INDEX_TYPES(
+      lengths_contig.scalar_type(), "length_to_offset_cpu_kernel", [&] {
+        const auto* input_ptr = lengths_contig.data_ptr<index_t>();
+        auto* output_ptr = offsets.data_ptr<index_t>();
+        for (const auto t : c10::irange(T)) {
+          index_t cumsum = 0;
+          output_ptr[t * (B + 1)] = 0;
+          for (const auto b : c10::irange(B)) {
+            cumsum += input_ptr[t * B + b];
+            output_ptr[t * (B + 1) + b + 1] = cumsum;
+          }
+        }
+      });
+  return offsets;
+}
+
+// Pads the T features of a stacked jagged tensor of 1D or 2D values into a
+// single buffer, returning the [B, max_L_t] or [B, max_L_t, D] view of it
+// of every feature t. The output is not tracked by autograd.
+std::vector<Tensor> stacked_jagged_to_dense_single_buffer_(
+    const Tensor& values,
+    const Tensor& offsets,
+    const std::vector<int64_t>& offset_per_key,
+    const std::vector<int64_t>& max_lengths_per_key,
+    int64_t padding_value) {
+  const auto values_contig = values.contiguous();
+  const int64_t T = offsets.size(0);
+  const int64_t B = offsets.size(1) - 1;
+  const int64_t D = values.dim() == 2 ? values.size(1) : 1;
+
+  std::vector<int64_t> output_offsets(T + 1, 0);
+  for (const auto t : c10::irange(T)) {
+    output_offsets[t + 1] =
+        output_offsets[t] + B * max_lengths_per_key[t] * D;
+  }
+  auto padded_values = at::empty({output_offsets[T]}, values.options());
+  const int64_t row_work =
+      std::max<int64_t>(output_offsets[T] / std::max<int64_t>(T * B, 1), 1);
+
+  AT_DISPATCH_INDEX_TYPES(
+      offsets.scalar_type(), "stacked_jagged_to_dense_cpu_kernel", [&] {
+        FBGEMM_DISPATCH_ALL_TYPES(
+            values.scalar_type(), "stacked_jagged_to_dense_cpu_kernel", [&] {
+              const auto* offsets_ptr = offsets.data_ptr<index_t>();
+              const auto* values_ptr = values_contig.data_ptr<scalar_t>();
+              auto* output_ptr = padded_values.data_ptr<scalar_t>();
+              const auto padding = static_cast<scalar_t>(padding_value);
+              at::parallel_for(
+                  0,
+                  T * B,
+                  std::max<int64_t>(
+                      1, at::internal::GRAIN_SIZE / row_work),
+                  [&](int64_t row_begin, int64_t row_end) {
+                    for (const auto row : c10::irange(row_begin, row_end)) {
+                      const int64_t t = row / B;
+                      const int64_t b = row % B;
+                      const int64_t max_L = max_lengths_per_key[t];
+                      const index_t* feature_offsets =
+                          offsets_ptr + t * (B + 1);
+                      const int64_t begin = feature_offsets[b];
+                      const int64_t len = std::min<int64_t>(
+                          feature_offsets[b + 1] - begin, max_L);
+                      scalar_t* dst =
+                          output_ptr + output_offsets[t] + b * max_L * D;
+                      if (len > 0) {
+                        std::copy_n(
+                            values_ptr + (offset_per_key[t] + begin) * D,
+                            len * D,
+                            dst);
+                      }
+                      std::fill(
+                          dst + std::max<int64_t>(len, 0) * D,
+                          dst + max_L * D,
+                          padding);
+                    }
+                  });
+            });
+      });
+
+  std::vector<Tensor> padded_values_per_key;
+  padded_values_per_key.reserve(T);
+  for (const auto t : c10::irange(T)) {
+    const int64_t max_L = max_lengths_per_key[t];
+    auto padded = padded_values.narrow(
+        0, output_offsets[t], output_offsets[t + 1] - output_offsets[t]);
+    padded_values_per_key.push_back(
+        values.dim() == 2 ? padded.view({B, max_L, D})
+                          : padded.view({B, max_L}));
+  }
+  return padded_values_per_key;
+}
+
+} // namespace
+
+// The stacked ops pad all the features into one buffer, unless the values
+// require grad; then every feature goes through jagged_to_padded_dense for
+// its backward.
 std::vector<Tensor> stacked_jagged_1d_to_dense_cpu(
     Tensor values,
     Tensor lengths,
@@ -976,27 +1257,21 @@ std::vector<Tensor> stacked_jagged_1d_to_dense_cpu(
   TORCH_CHECK(values.dim() == 1);
   TORCH_CHECK(lengths.dim() == 2);
 
-  const auto lengths_contig = lengths.contiguous();
-  int32_t B = lengths.size(1);
-  int32_t T = lengths.size(0);
-  auto offsets = at::empty({B + 1}, lengths.options());
-  offsets[0].zero_();
+  const int32_t T = lengths.size(0);
+  TORCH_CHECK(offset_per_key.size() >= static_cast<size_t>(T) + 1);
+  TORCH_CHECK(max_lengths_per_key.size() >= static_cast<size_t>(T));
+  const auto offsets = stacked_lengths_to_offsets_(lengths);
+  if (!(values.requires_grad() && at::GradMode::is_enabled())) {
+    return stacked_jagged_to_dense_single_buffer_(
+        values, offsets, offset_per_key, max_lengths_per_key, padding_value);
+  }
+
   std::vector<Tensor> padded_values_per_key;
   for (const auto t : c10::irange(T)) {
     int64_t max_L = max_lengths_per_key[t];
-    AT_DISPATCH_INDEX_TYPES(
-        lengths_contig.scalar_type(), "length_to_offset_cpu_kernel", [&] {
-          index_t cumsum = 0;
-          const auto* input_ptr = &(lengths_contig.data_ptr<index_t>()[t * B]);
-          auto* output_ptr = offsets.data_ptr<index_t>() + 1;
-          for (const auto i : c10::irange(B)) {
-            cumsum += input_ptr[i];
-            output_ptr[i] = cumsum;
-          }
-        });
     padded_values_per_key.push_back(jagged_to_padded_dense(
         values.slice(0, offset_per_key[t], offset_per_key[t + 1]),
-        {offsets},
+        {offsets[t]},
         {max_L},
         padding_value));
   }
@@ -1014,30 +1289,21 @@ std::vector<Tensor> stacked_jagged_2d_to_dense_cpu(
   TORCH_CHECK(values.dim() == 2);
   TORCH_CHECK(lengths.dim() == 2);
 
-  const auto lengths_contig = lengths.contiguous();
-  int32_t B = lengths.size(1);
-  int32_t T = lengths.size(0);
+  const int32_t T = lengths.size(0);
+  TORCH_CHECK(offset_per_key.size() >= static_cast<size_t>(T) + 1);
+  TORCH_CHECK(max_lengths_per_key.size() >= static_cast<size_t>(T));
+  const auto offsets = stacked_lengths_to_offsets_(lengths);
+  if (!(values.requires_grad() && at::GradMode::is_enabled())) {
+    return stacked_jagged_to_dense_single_buffer_(
+        values, offsets, offset_per_key, max_lengths_per_key, padding_value);
+  }
+
   std::vector<Tensor> padded_values_per_key;
-  std::vector<Tensor> offsets_tensor_per_key;
   for (const auto t : c10::irange(T)) {
     int64_t max_L = max_lengths_per_key[t];
-    auto offsets = at::empty({B + 1}, lengths.options());
-    offsets[0].zero_();
-    AT_DISPATCH_INDEX_TYPES(
-        lengths_contig.scalar_type(), "length_to_offset_cpu_kernel", [&] {
-          index_t cumsum = 0;
-          const auto* input_ptr = &(lengths_contig.data_ptr<index_t>()[t * B]);
-          auto* output_ptr = offsets.data_ptr<index_t>() + 1;
-          for (const auto i : c10::irange(B)) {
-            cumsum += input_ptr[i];
-            output_ptr[i] = cumsum;
-          }
-        });
-    offsets_tensor_per_key.push_back(offsets);
-
     padded_values_per_key.push_back(jagged_to_padded_dense(
         values.slice(0, offset_per_key[t], offset_per_key[t + 1]),
-        {offsets},
+        {offsets[t]},
         {max_L},
         padding_value));
   }
@@ -1055,23 +1321,49 @@ void jagged_index_select_2d_kernel(
   const auto num_output_rows = output_offsets.size(0);
   const auto num_dense_output_rows = output.size(0);
   const auto num_cols = input.size(1);
+  // The rows of a sequence are copied at once when they are contiguous
+  const bool contiguous_rows = input.stride(1) == 1 &&
+      input.stride(0) == num_cols && output.stride(1) == 1 &&
+      output.stride(0) == num_cols;
+  const offset_t* const output_offsets_begin = output_offsets.data();
+  const offset_t* const output_offsets_end =
+      output_offsets_begin + num_output_rows;
   at::parallel_for(
-      0, num_dense_output_rows, 0, [&](int64_t start, int64_t end) {
-        for (const auto dense_output_offset : c10::irange(start, end)) {
-          int index_pos;
-          binary_search_range_cpu(
-              &index_pos,
-              reinterpret_cast<const offset_t*>(&output_offsets[0]),
-              static_cast<offset_t>(dense_output_offset),
-              num_output_rows);
-          const offset_t rel_index = dense_output_offset -
-              (index_pos == 0 ? 0 : output_offsets[index_pos - 1]);
+      0,
+      num_dense_output_rows,
+      std::max<int64_t>(
+          1, at::internal::GRAIN_SIZE / std::max<int64_t>(num_cols, 1)),
+      [&](int64_t start, int64_t end) {
+        // The first sequence ending after start, the next ones follow
+        int64_t index_pos = std::upper_bound(
+                                output_offsets_begin,
+                                output_offsets_end,
+                                static_cast<offset_t>(start)) -
+            output_offsets_begin;
+        for (int64_t row = start; row < end; ++index_pos) {
+          const offset_t seq_start =
+              index_pos == 0 ? 0 : output_offsets[index_pos - 1];
+          const int64_t seq_end =
+              std::min<int64_t>(output_offsets[index_pos], end);
+          if (seq_end <= row) {
+            continue;
+          }
           const index_t index = indices[index_pos];
           const offset_t input_offset =
-              (index == 0 ? 0 : input_offsets[index - 1]) + rel_index;
-          for (const auto i : c10::irange(num_cols)) {
-            output[dense_output_offset][i] = input[input_offset][i];
+              (index == 0 ? 0 : input_offsets[index - 1]) + (row - seq_start);
+          if (contiguous_rows) {
+            std::memcpy(
+                &output[row][0],
+                &input[input_offset][0],
+                (seq_end - row) * num_cols * sizeof(scalar_t));
+          } else {
+            for (const auto r : c10::irange(seq_end - row)) {
+              for (const auto i : c10::irange(num_cols)) {
+                output[row + r][i] = input[input_offset + r][i];
+              }
+            }
           }
+          row = seq_end;
         }
       });
 }
@@ -1190,46 +1482,59 @@ void jagged_index_add_2d_kernel(
     const at::TensorAccessor<offset_t, 1>& output_offsets) {
   const auto num_input_rows = input_offsets.size(0);
   const auto num_dense_input_rows = input.size(0);
+  const auto num_output_seqs = output_offsets.size(0);
   const auto num_cols = input.size(1);
-  // Allocate one lock per row
-  std::atomic_flag* locks = new std::atomic_flag[output.size(0)];
-  // Initialize all locks since before c++20 std::atomic_flag is initialized to
-  // an unspecified state.
-  // https://en.cppreference.com/w/cpp/atomic/atomic_flag/atomic_flag
-  for (auto i = 0; i < output.size(0); i++) {
-    locks[i].clear();
+  // Group the input sequences by output sequence (a stable counting sort),
+  // so that each output sequence is accumulated by a single thread, in the
+  // order of the inputs, without locks
+  std::vector<int64_t> group_offsets(num_output_seqs + 1, 0);
+  for (const auto i : c10::irange(num_input_rows)) {
+    const index_t index = indices[i];
+    TORCH_CHECK(
+        index >= 0 && index < num_output_seqs,
+        "index ",
+        index,
+        " is out of bounds for ",
+        num_output_seqs,
+        " output sequences");
+    ++group_offsets[index + 1];
   }
-
-  at::parallel_for(0, num_dense_input_rows, 0, [&](int64_t start, int64_t end) {
-    for (const auto dense_input_offset : c10::irange(start, end)) {
-      int index_pos;
-      binary_search_range_cpu(
-          &index_pos,
-          reinterpret_cast<const offset_t*>(&input_offsets[0]),
-          static_cast<offset_t>(dense_input_offset),
-          num_input_rows);
-      const offset_t rel_index = dense_input_offset -
-          (index_pos == 0 ? 0 : input_offsets[index_pos - 1]);
-      const index_t index = indices[index_pos];
-      const offset_t output_offset =
-          (index == 0 ? 0 : output_offsets[index - 1]) + rel_index;
-
-      // Spin lock
-      auto& lock = locks[output_offset];
-      while (lock.test_and_set(std::memory_order_acquire)) {
-        // For C++20
-#if defined(__cpp_lib_atomic_flag_test)
-        while (lock.test(std::memory_order_relaxed))
-#endif
-          ;
-      }
-      for (const auto i : c10::irange(num_cols)) {
-        output[output_offset][i] += input[dense_input_offset][i];
-      }
-      // Release lock
-      lock.clear(std::memory_order_release);
+  for (const auto j : c10::irange(num_output_seqs)) {
+    group_offsets[j + 1] += group_offsets[j];
+  }
+  std::vector<int64_t> group_inputs(num_input_rows);
+  {
+    std::vector<int64_t> next(group_offsets.begin(), group_offsets.end() - 1);
+    for (const auto i : c10::irange(num_input_rows)) {
+      group_inputs[next[indices[i]]++] = i;
     }
-  });
+  }
+
+  at::parallel_for(
+      0,
+      num_output_seqs,
+      std::max<int64_t>(
+          1,
+          at::internal::GRAIN_SIZE * num_output_seqs /
+              std::max<int64_t>(num_dense_input_rows * num_cols, 1)),
+      [&](int64_t start, int64_t end) {
+        for (const auto j : c10::irange(start, end)) {
+          const offset_t output_start = j == 0 ? 0 : output_offsets[j - 1];
+          for (const auto g :
+               c10::irange(group_offsets[j], group_offsets[j + 1])) {
+            const int64_t i = group_inputs[g];
+            const offset_t input_start = i == 0 ? 0 : input_offsets[i - 1];
+            const offset_t length = input_offsets[i] - input_start;
+            for (const auto r : c10::irange(length)) {
+              auto output_row = output[output_start + r];
+              const auto input_row = input[input_start + r];
+              for (const auto c : c10::irange(num_cols)) {
+                output_row[c] += input_row[c];
+              }
+            }
+          }
+        }
+      });
 }
 
 /// Add sequences from input jagged tensor to output jagged tensor based on
@@ -1280,31 +1585,50 @@ void jagged_softmax_kernel(
     const int64_t max_L) {
   const int B = offsets.size(0) - 1;
   const int D = values.size(1);
-  for (const auto b : c10::irange(B)) {
-    const int row_start = offsets[b];
-    const int row_end = offsets[b + 1];
-    const int length = std::min(row_end - row_start, (int)max_L);
-
-    if (length == 0)
-      continue;
-    for (const auto d : c10::irange(D)) {
-      // use is_cuda=true because acc_type<float, false> = double is too
-      // conservative
-      scalar_t max_value = values[row_start][d];
-      for (const auto l : c10::irange(1, length)) {
-        max_value = std::max(max_value, values[row_start + l][d]);
-      }
-      at::acc_type<scalar_t, true> acc =
-          std::exp(values[row_start][d] - max_value);
-      for (const auto l : c10::irange(1, length)) {
-        acc += std::exp(values[row_start + l][d] - max_value);
-      }
-      for (const auto l : c10::irange(length)) {
-        output[row_start + l][d] =
-            std::exp(values[row_start + l][d] - max_value) / acc;
-      }
-    } // for each d
-  } // for each b
+  at::parallel_for(
+      0,
+      B,
+      jagged_bmm_grain_size(B, values.size(0) * D),
+      [&](int64_t b_begin, int64_t b_end) {
+        for (const auto b : c10::irange(b_begin, b_end)) {
+          const int row_start = offsets[b];
+          const int row_end = offsets[b + 1];
+          const int length = std::min(row_end - row_start, (int)max_L);
+
+          if (length == 0)
+            continue;
+          if constexpr (std::is_same_v<scalar_t, float>) {
+            if (values.stride(1) == 1 && output.stride(1) == 1) {
+              // Vectorized over the columns, with a vectorized exp
+              fbgemm::column_softmax(
+                  length,
+                  D,
+                  values.data() + row_start * values.stride(0),
+                  values.stride(0),
+                  output.data() + row_start * output.stride(0),
+                  output.stride(0));
+              continue;
+            }
+          }
+          for (const auto d : c10::irange(D)) {
+            // use is_cuda=true because acc_type<float, false> = double is
+            // too conservative
+            scalar_t max_value = values[row_start][d];
+            for (const auto l : c10::irange(1, length)) {
+              max_value = std::max(max_value, values[row_start + l][d]);
+            }
+            at::acc_type<scalar_t, true> acc =
+                std::exp(values[row_start][d] - max_value);
+            for (const auto l : c10::irange(1, length)) {
+              acc += std::exp(values[row_start + l][d] - max_value);
+            }
+            for (const auto l : c10::irange(length)) {
+              output[row_start + l][d] =
+                  std::exp(values[row_start + l][d] - max_value) / acc;
+            }
+          } // for each d
+        } // for each b
+      });
 }
 
 Tensor jagged_softmax_forward(
@@ -1342,25 +1666,47 @@ void jagged_softmax_backward_kernel(
     const int64_t max_L) {
   const int B = offsets.size(0) - 1;
   const int D = grad_output.size(1);
-  for (const auto b : c10::irange(B)) {
-    const int row_start = offsets[b];
-    const int row_end = offsets[b + 1];
-    const int length = std::min(row_end - row_start, (int)max_L);
-    if (length == 0)
-      continue;
-    for (const auto d : c10::irange(D)) {
-      at::acc_type<scalar_t, true> sum_value =
-          grad_output[row_start][d] * output[row_start][d];
-      for (const auto l : c10::irange(1, length)) {
-        sum_value += grad_output[row_start + l][d] * output[row_start + l][d];
-      }
-      for (const auto l : c10::irange(length)) {
-        grad_input[row_start + l][d] =
-            (grad_output[row_start + l][d] - sum_value) *
-            output[row_start + l][d];
-      }
-    }
-  }
+  at::parallel_for(
+      0,
+      B,
+      jagged_bmm_grain_size(B, grad_output.size(0) * D),
+      [&](int64_t b_begin, int64_t b_end) {
+        for (const auto b : c10::irange(b_begin, b_end)) {
+          const int row_start = offsets[b];
+          const int row_end = offsets[b + 1];
+          const int length = std::min(row_end - row_start, (int)max_L);
+          if (length == 0)
+            continue;
+          if constexpr (std::is_same_v<scalar_t, float>) {
+            if (grad_output.stride(1) == 1 && output.stride(1) == 1 &&
+                grad_input.stride(1) == 1) {
+              fbgemm::column_softmax_backward(
+                  length,
+                  D,
+                  grad_output.data() + row_start * grad_output.stride(0),
+                  grad_output.stride(0),
+                  output.data() + row_start * output.stride(0),
+                  output.stride(0),
+                  grad_input.data() + row_start * grad_input.stride(0),
+                  grad_input.stride(0));
+              continue;
+            }
+          }
+          for (const auto d : c10::irange(D)) {
+            at::acc_type<scalar_t, true> sum_value =
+                grad_output[row_start][d] * output[row_start][d];
+            for (const auto l : c10::irange(1, length)) {
+              sum_value +=
+                  grad_output[row_start + l][d] * output[row_start + l][d];
+            }
+            for (const auto l : c10::irange(length)) {
+              grad_input[row_start + l][d] =
+                  (grad_output[row_start + l][d] - sum_value) *
+                  output[row_start + l][d];
+            }
+          }
+        }
+      });
 }
 
 Tensor jagged_softmax_backward(
@@ -1394,30 +1740,195 @@ Tensor jagged_softmax_backward(
   return grad_input;
 }
 
+// Query and key rows of the tiles of jagged_attention_kernel
+constexpr int kJaggedAttentionBlockM = 16;
+constexpr int kJaggedAttentionBlockN = 64;
+
+template <typename index_t, typename scalar_t>
+void jagged_attention_kernel(
+    const at::TensorAccessor<scalar_t, 2>& q_values,
+    const at::TensorAccessor<scalar_t, 2>& k_values,
+    const at::TensorAccessor<scalar_t, 2>& v_values,
+    const at::TensorAccessor<index_t, 1>& offsets,
+    at::TensorAccessor<scalar_t, 2> output,
+    const int64_t max_L,
+    const double scale) {
+  // use is_cuda=true because acc_type<float, false> = double is too
+  // conservative
+  using acc_t = at::acc_type<scalar_t, true>;
+  const int B = offsets.size(0) - 1;
+  const int D = q_values.size(1);
+  const int Dv = v_values.size(1);
+  const int64_t work = static_cast<int64_t>(q_values.size(0)) *
+      std::min<int64_t>(q_values.size(0), max_L) * (D + Dv);
+  at::parallel_for(
+      0,
+      B,
+      jagged_bmm_grain_size(B, work),
+      [&](int64_t b_begin, int64_t b_end) {
+        // The scores of a tile and the running max, sum and output of its
+        // query rows
+        std::vector<acc_t> scores(
+            kJaggedAttentionBlockM * kJaggedAttentionBlockN);
+        std::vector<acc_t> row_max(kJaggedAttentionBlockM);
+        std::vector<acc_t> row_sum(kJaggedAttentionBlockM);
+        std::vector<acc_t> acc(kJaggedAttentionBlockM * Dv);
+        for (const auto b : c10::irange(b_begin, b_end)) {
+          const int row_start = offsets[b];
+          const int row_end = offsets[b + 1];
+          const int length = std::min(row_end - row_start, (int)max_L);
+          for (int i_begin = 0; i_begin < length;
+               i_begin += kJaggedAttentionBlockM) {
+            const int m = std::min(kJaggedAttentionBlockM, length - i_begin);
+            std::fill_n(
+                row_max.begin(), m, -std::numeric_limits<acc_t>::infinity());
+            std::fill_n(row_sum.begin(), m, 0);
+            std::fill_n(acc.begin(), m * Dv, 0);
+            for (int j_begin = 0; j_begin < length;
+                 j_begin += kJaggedAttentionBlockN) {
+              const int n = std::min(kJaggedAttentionBlockN, length - j_begin);
+              for (const auto i : c10::irange(m)) {
+                const auto q = q_values[row_start + i_begin + i];
+                acc_t* const scores_i = &scores[i * kJaggedAttentionBlockN];
+                acc_t tile_max = -std::numeric_limits<acc_t>::infinity();
+                for (const auto j : c10::irange(n)) {
+                  const auto k = k_values[row_start + j_begin + j];
+                  acc_t dot = 0;
+                  for (const auto d : c10::irange(D)) {
+                    dot += static_cast<acc_t>(q[d]) * k[d];
+                  }
+                  scores_i[j] = dot * static_cast<acc_t>(scale);
+                  tile_max = std::max(tile_max, scores_i[j]);
+                }
+                // Rescale the running sums to the new max of the row
+                const acc_t new_max = std::max(row_max[i], tile_max);
+                const acc_t correction = std::exp(row_max[i] - new_max);
+                row_max[i] = new_max;
+                row_sum[i] *= correction;
+                acc_t* const acc_i = &acc[i * Dv];
+                for (const auto d : c10::irange(Dv)) {
+                  acc_i[d] *= correction;
+                }
+                for (const auto j : c10::irange(n)) {
+                  const acc_t p = std::exp(scores_i[j] - new_max);
+                  row_sum[i] += p;
+                  const auto v = v_values[row_start + j_begin + j];
+                  for (const auto d : c10::irange(Dv)) {
+                    acc_i[d] += p * v[d];
+                  }
+                }
+              }
+            } // for each key tile
+            for (const auto i : c10::irange(m)) {
+              const acc_t* const acc_i = &acc[i * Dv];
+              for (const auto d : c10::irange(Dv)) {
+                output[row_start + i_begin + i][d] = acc_i[d] / row_sum[i];
+              }
+            }
+          } // for each query tile
+        } // for each b
+      });
+}
+
+// Attention within each jagged segment, softmax(scale * Q K^T) V, without
+// materializing the scores: the key rows are read in tiles and the softmax
+// is accumulated online, so the memory is proportional to the lengths. The
+// rows past max_L of a segment are neither attended nor attending, and are
+// zero in the output.
+Tensor jagged_attention_forward(
+    const Tensor& q_values,
+    const Tensor& k_values,
+    const Tensor& v_values,
+    const Tensor& offsets,
+    const int64_t max_L,
+    const double scale) {
+  TENSOR_ON_CPU(q_values);
+  TENSOR_ON_CPU(k_values);
+  TENSOR_ON_CPU(v_values);
+  TENSOR_ON_CPU(offsets);
+  TORCH_CHECK(
+      q_values.dim() == 2 && k_values.dim() == 2 && v_values.dim() == 2,
+      "q_values, k_values and v_values must be 2D");
+  TORCH_CHECK(
+      k_values.size(0) == q_values.size(0) &&
+          v_values.size(0) == q_values.size(0),
+      "q_values, k_values and v_values must have the same number of rows");
+  TORCH_CHECK(
+      k_values.size(1) == q_values.size(1),
+      "k_values.size(1), ",
+      k_values.size(1),
+      " != q_values.size(1), ",
+      q_values.size(1));
+  const int B = offsets.numel() - 1;
+  auto output =
+      at::zeros({q_values.size(0), v_values.size(1)}, v_values.options());
+
+  if (B > 0 && v_values.size(1) > 0) {
+    AT_DISPATCH_INDEX_TYPES(
+        offsets.scalar_type(), "jagged_attention_kernel_1", [&] {
+          FBGEMM_DISPATCH_FLOATING_TYPES(
+              q_values.scalar_type(), "jagged_attention_kernel_2", [&] {
+                jagged_attention_kernel<index_t, scalar_t>(
+                    q_values.accessor<scalar_t, 2>(),
+                    k_values.accessor<scalar_t, 2>(),
+                    v_values.accessor<scalar_t, 2>(),
+                    offsets.accessor<index_t, 1>(),
+                    output.accessor<scalar_t, 2>(),
+                    max_L,
+                    scale);
+              });
+        });
+  }
+  return output;
+}
+
 template <typename index_t, typename scalar_t>
 void jagged_jagged_bmm_kernel(
-    const at::TensorAccessor<scalar_t, 2>& x_values,
-    const at::TensorAccessor<scalar_t, 2>& y_values,
+    const Tensor& x_values,
+    const Tensor& y_values,
     const at::TensorAccessor<index_t, 1>& offsets,
-    at::TensorAccessor<scalar_t, 3> output,
+    const Tensor& output,
     const int64_t max_L) {
   const int B = offsets.size(0) - 1;
   const int M = x_values.size(1);
   const int N = y_values.size(1);
-  for (const auto b : c10::irange(B)) {
-    const int row_start = offsets[b];
-    const int row_end = offsets[b + 1];
-    const int length = std::min(row_end - row_start, (int)max_L);
-    for (const auto m : c10::irange(M)) {
-      for (const auto n : c10::irange(N)) {
-        at::acc_type<scalar_t, true> acc = 0;
-        for (const auto l : c10::irange(length)) {
-          acc += x_values[row_start + l][m] * y_values[row_start + l][n];
-        }
-        output[b][m][n] = acc;
-      }
-    }
-  } // for each b
+  const auto x_accessor = x_values.accessor<scalar_t, 2>();
+  const auto y_accessor = y_values.accessor<scalar_t, 2>();
+  auto output_accessor = output.accessor<scalar_t, 3>();
+  at::parallel_for(
+      0,
+      B,
+      jagged_bmm_grain_size(B, x_values.size(0) * M * N),
+      [&](int64_t b_begin, int64_t b_end) {
+        for (const auto b : c10::irange(b_begin, b_end)) {
+          const int row_start = offsets[b];
+          const int row_end = offsets[b + 1];
+          const int length = std::min(row_end - row_start, (int)max_L);
+          if (length <= 0) {
+            continue;
+          }
+          if (jagged_bmm_use_gemm<scalar_t>() &&
+              static_cast<int64_t>(length) * M * N >= kJaggedBmmMinGemmWork) {
+            // [M, L] x [L, N] -> [M, N]
+            Tensor output_b = output[b];
+            at::mm_out(
+                output_b,
+                x_values.narrow(0, row_start, length).t(),
+                y_values.narrow(0, row_start, length));
+            continue;
+          }
+          for (const auto m : c10::irange(M)) {
+            for (const auto n : c10::irange(N)) {
+              at::acc_type<scalar_t, true> acc = 0;
+              for (const auto l : c10::irange(length)) {
+                acc += x_accessor[row_start + l][m] *
+                    y_accessor[row_start + l][n];
+              }
+              output_accessor[b][m][n] = acc;
+            }
+          }
+        } // for each b
+      });
 }
 
 Tensor jagged_jagged_bmm_forward(
@@ -1438,10 +1949,10 @@ Tensor jagged_jagged_bmm_forward(
           FBGEMM_DISPATCH_FLOATING_TYPES(
               x_values.scalar_type(), "jagged_jagged_bmm_kernel_2", [&] {
                 jagged_jagged_bmm_kernel<index_t, scalar_t>(
-                    x_values.accessor<scalar_t, 2>(),
-                    y_values.accessor<scalar_t, 2>(),
+                    x_values,
+                    y_values,
                     offsets.accessor<index_t, 1>(),
-                    output.accessor<scalar_t, 3>(),
+                    output,
                     max_L);
               });
         });
@@ -1452,29 +1963,48 @@ Tensor jagged_jagged_bmm_forward(
 
 template <typename index_t, typename scalar_t>
 void jagged_dense_bmm_kernel(
-    const at::TensorAccessor<scalar_t, 2>& x_values,
+    const Tensor& x_values,
     const at::TensorAccessor<index_t, 1>& x_offsets,
-    const at::TensorAccessor<scalar_t, 3>& y,
-    at::TensorAccessor<scalar_t, 2> output,
+    const Tensor& y,
+    const Tensor& output,
     const int64_t max_L) {
   // [sum_B, K] x [B, K, N] -> [B, L, N] -> [sum_B, N]
   const int B = x_offsets.size(0) - 1;
   const int K = x_values.size(1);
   const int N = y.size(2);
-  for (const auto b : c10::irange(B)) {
-    const int row_start = x_offsets[b];
-    const int row_end = x_offsets[b + 1];
-    const int length = std::min(row_end - row_start, (int)max_L);
-    for (const auto l : c10::irange(length)) {
-      for (const auto n : c10::irange(N)) {
-        at::acc_type<scalar_t, true> acc = 0;
-        for (const auto k : c10::irange(K)) {
-          acc += x_values[row_start + l][k] * y[b][k][n];
-        }
-        output[row_start + l][n] = acc;
-      }
-    }
-  } // for each b
+  const auto x_accessor = x_values.accessor<scalar_t, 2>();
+  const auto y_accessor = y.accessor<scalar_t, 3>();
+  auto output_accessor = output.accessor<scalar_t, 2>();
+  at::parallel_for(
+      0,
+      B,
+      jagged_bmm_grain_size(B, x_values.size(0) * K * N),
+      [&](int64_t b_begin, int64_t b_end) {
+        for (const auto b : c10::irange(b_begin, b_end)) {
+          const int row_start = x_offsets[b];
+          const int row_end = x_offsets[b + 1];
+          const int length = std::min(row_end - row_start, (int)max_L);
+          if (length <= 0) {
+            continue;
+          }
+          if (jagged_bmm_use_gemm<scalar_t>() &&
+              static_cast<int64_t>(length) * K * N >= kJaggedBmmMinGemmWork) {
+            // [L, K] x [K, N] -> [L, N]
+            Tensor output_b = output.narrow(0, row_start, length);
+            at::mm_out(output_b, x_values.narrow(0, row_start, length), y[b]);
+            continue;
+          }
+          for (const auto l : c10::irange(length)) {
+            for (const auto n : c10::irange(N)) {
+              at::acc_type<scalar_t, true> acc = 0;
+              for (const auto k : c10::irange(K)) {
+                acc += x_accessor[row_start + l][k] * y_accessor[b][k][n];
+              }
+              output_accessor[row_start + l][n] = acc;
+            }
+          }
+        } // for each b
+      });
 }
 
 Tensor jagged_dense_bmm_forward(
@@ -1496,10 +2026,10 @@ Tensor jagged_dense_bmm_forward(
           FBGEMM_DISPATCH_FLOATING_TYPES(
               x_values.scalar_type(), "jagged_dense_bmm_kernel_2", [&] {
                 jagged_dense_bmm_kernel<index_t, scalar_t>(
-                    x_values.accessor<scalar_t, 2>(),
+                    x_values,
                     x_offsets.accessor<index_t, 1>(),
-                    y.accessor<scalar_t, 3>(),
-                    output.accessor<scalar_t, 2>(),
+                    y,
+                    output,
                     (int)max_L);
               });
         });
@@ -1589,6 +2119,601 @@ Tensor jagged_slice_forward_cpu(
   return output_values;
 }
 
+namespace {
+
+// Copies the segments [input_starts[p], input_starts[p] + length of p) of
+// input to [output_offsets[p], output_offsets[p + 1]) of output, in parallel
+// over the segments.
+void copy_jagged_segments_(
+    const Tensor& input,
+    Tensor& output,
+    const std::vector<int64_t>& input_starts,
+    const std::vector<int64_t>& output_offsets) {
+  const int64_t num_segments = input_starts.size();
+  if (output.numel() == 0) {
+    return;
+  }
+  const auto input_contig = input.expect_contiguous();
+  FBGEMM_DISPATCH_ALL_TYPES(
+      input.scalar_type(), "copy_jagged_segments_cpu_kernel", [&] {
+        const auto* input_ptr = input_contig->data_ptr<scalar_t>();
+        auto* output_ptr = output.data_ptr<scalar_t>();
+        at::parallel_for(
+            0,
+            num_segments,
+            std::max<int64_t>(
+                1,
+                at::internal::GRAIN_SIZE * num_segments / output.numel()),
+            [&](int64_t p_begin, int64_t p_end) {
+              for (const auto p : c10::irange(p_begin, p_end)) {
+                std::copy_n(
+                    input_ptr + input_starts[p],
+                    output_offsets[p + 1] - output_offsets[p],
+                    output_ptr + output_offsets[p]);
+              }
+            });
+      });
+}
+
+} // namespace
+
+/// Selects the same batch samples `indices` from each of the num_batches
+/// keys of a keyed jagged tensor; the outputs follow those of the CUDA op,
+/// with the inclusive output offsets and the saved data of the backward.
+std::vector<Tensor> keyed_jagged_index_select_dim1_forward_cpu(
+    const Tensor& values,
+    const Tensor& lengths,
+    const Tensor& offsets,
+    const Tensor& indices,
+    const c10::SymInt _batch_size,
+    const c10::optional<Tensor>& weights,
+    const c10::optional<c10::SymInt>& /*selected_lengths_sum*/) {
+  TENSOR_ON_CPU(values);
+  TENSOR_ON_CPU(lengths);
+  TENSOR_ON_CPU(offsets);
+  TENSOR_ON_CPU(indices);
+  TORCH_CHECK(values.dim() == 1, "values must be a 1D tensor");
+  TORCH_CHECK(lengths.dim() == 1, "lengths must be a 1D tensor");
+  TORCH_CHECK(offsets.dim() == 1, "offsets must be a 1D tensor");
+  TORCH_CHECK(indices.dim() == 1, "indices must be a 1D tensor");
+  TORCH_CHECK(
+      offsets.numel() == lengths.numel() + 1,
+      "offsets size must be lengths size + 1");
+  if (weights.has_value()) {
+    TENSOR_ON_CPU(weights.value());
+    TORCH_CHECK(weights.value().dim() == 1, "weights must be a 1D tensor");
+    TENSORS_HAVE_SAME_NUMEL(weights.value(), values);
+  }
+
+  const int64_t batch_size = _batch_size.guard_int(__FILE__, __LINE__);
+  TORCH_CHECK(batch_size > 0 && lengths.numel() % batch_size == 0);
+  const int64_t num_batches = lengths.numel() / batch_size;
+  const int64_t num_indices = indices.numel();
+  const int64_t num_output_lengths = num_batches * num_indices;
+
+  const auto lengths_contig = lengths.expect_contiguous();
+  const auto offsets_contig = offsets.expect_contiguous();
+  const auto indices_contig = indices.expect_contiguous();
+  Tensor output_lengths = at::empty({num_output_lengths}, lengths.options());
+  Tensor output_offsets = at::empty({num_output_lengths}, offsets.options());
+
+  // Start of every selected segment in values, and the complete cumsum of
+  // the output lengths
+  std::vector<int64_t> input_starts(num_output_lengths);
+  std::vector<int64_t> output_starts(num_output_lengths + 1, 0);
+  AT_DISPATCH_INDEX_TYPES(
+      lengths.scalar_type(), "keyed_jagged_index_select_dim1_cpu_1", [&] {
+        using length_t = index_t;
+        AT_DISPATCH_INDEX_TYPES(
+            offsets.scalar_type(), "keyed_jagged_index_select_dim1_cpu_2", [&] {
+              using offset_t = index_t;
+              AT_DISPATCH_INDEX_TYPES(
+                  indices.scalar_type(),
+                  "keyed_jagged_index_select_dim1_cpu_3",
+                  [&] {
+                    const auto* lengths_ptr =
+                        lengths_contig->data_ptr<length_t>();
+                    const auto* offsets_ptr =
+                        offsets_contig->data_ptr<offset_t>();
+                    const auto* indices_ptr =
+                        indices_contig->data_ptr<index_t>();
+                    auto* output_lengths_ptr =
+                        output_lengths.data_ptr<length_t>();
+                    auto* output_offsets_ptr =
+                        output_offsets.data_ptr<offset_t>();
+                    for (const auto j : c10::irange(num_indices)) {
+                      TORCH_CHECK(
+                          indices_ptr[j] >= 0 && indices_ptr[j] < batch_size,
+                          "index ",
+                          indices_ptr[j],
+                          " is out of range [0, ",
+                          batch_size,
+                          ")");
+                    }
+                    for (const auto p : c10::irange(num_output_lengths)) {
+                      const int64_t input_pos = p / num_indices * batch_size +
+                          indices_ptr[p % num_indices];
+                      const length_t length = lengths_ptr[input_pos];
+                      input_starts[p] = offsets_ptr[input_pos];
+                      output_starts[p + 1] = output_starts[p] + length;
+                      output_lengths_ptr[p] = length;
+                      output_offsets_ptr[p] = output_starts[p + 1];
+                    }
+                  });
+            });
+      });
+
+  const int64_t num_outputs = output_starts[num_output_lengths];
+  Tensor output = at::empty({num_outputs}, values.options());
+  copy_jagged_segments_(values, output, input_starts, output_starts);
+  Tensor output_weights;
+  if (weights.has_value()) {
+    output_weights = at::empty({num_outputs}, weights.value().options());
+    copy_jagged_segments_(
+        weights.value(), output_weights, input_starts, output_starts);
+  }
+
+  int64_t saved_data[] = {
+      num_outputs,
+      values.numel(),
+      batch_size,
+      num_batches,
+  };
+  auto saved_data_t = at::empty(
+      {sizeof(saved_data) / sizeof(int64_t)},
+      at::TensorOptions().dtype(at::kLong));
+  memcpy(saved_data_t.data_ptr<int64_t>(), saved_data, sizeof(saved_data));
+
+  if (weights.has_value()) {
+    return {
+        output, output_lengths, output_weights, output_offsets, saved_data_t};
+  }
+  return {output, output_lengths, output_offsets, saved_data_t};
+}
+
+/// Backward of keyed_jagged_index_select_dim1: grad_offsets are the forward
+/// output offsets and output_offsets the forward input offsets. The batch
+/// samples selected several times are summed up per input segment, in
+/// parallel over the input segments without atomics.
+Tensor keyed_jagged_index_select_dim1_backward_cpu(
+    const Tensor& grad,
+    const Tensor& indices,
+    const Tensor& grad_offsets,
+    const Tensor& output_offsets,
+    const Tensor& saved_tensor) {
+  TENSOR_ON_CPU(grad);
+  TENSOR_ON_CPU(indices);
+  const auto saved_data = saved_tensor.accessor<int64_t, 1>();
+  const int64_t num_outputs = saved_data[1]; // saved forward num_inputs
+  const int64_t output_batch_size = saved_data[2];
+  const int64_t num_batches = saved_data[3];
+  const int64_t num_indices = indices.numel();
+
+  Tensor grad_input = at::zeros({num_outputs}, grad.options());
+  if (grad.numel() == 0) {
+    return grad_input;
+  }
+  const auto grad_contig = grad.expect_contiguous();
+  const auto indices_contig = indices.expect_contiguous();
+  const auto grad_offsets_contig = grad_offsets.expect_contiguous();
+  const auto output_offsets_contig = output_offsets.expect_contiguous();
+
+  // The positions j of indices grouped by indices[j], in order, and the
+  // segments of grad and grad_input
+  std::vector<int64_t> index_ptr(output_batch_size + 1, 0);
+  std::vector<int64_t> index_pos(num_indices);
+  std::vector<int64_t> grad_starts(num_batches * num_indices + 1, 0);
+  std::vector<int64_t> grad_input_starts(num_batches * output_batch_size);
+  AT_DISPATCH_INDEX_TYPES(
+      grad_offsets.scalar_type(),
+      "keyed_jagged_index_add_dim1_cpu_1",
+      [&] {
+        using offset_t = index_t;
+        AT_DISPATCH_INDEX_TYPES(
+            indices.scalar_type(), "keyed_jagged_index_add_dim1_cpu_2", [&] {
+              const auto* indices_ptr = indices_contig->data_ptr<index_t>();
+              for (const auto j : c10::irange(num_indices)) {
+                ++index_ptr[indices_ptr[j] + 1];
+              }
+              std::partial_sum(
+                  index_ptr.begin(), index_ptr.end(), index_ptr.begin());
+              std::vector<int64_t> next(
+                  index_ptr.begin(), index_ptr.end() - 1);
+              for (const auto j : c10::irange(num_indices)) {
+                index_pos[next[indices_ptr[j]]++] = j;
+              }
+              const auto* grad_offsets_ptr =
+                  grad_offsets_contig->data_ptr<offset_t>();
+              std::copy_n(
+                  grad_offsets_ptr,
+                  num_batches * num_indices,
+                  grad_starts.begin() + 1);
+              const auto* output_offsets_ptr =
+                  output_offsets_contig->data_ptr<offset_t>();
+              std::copy_n(
+                  output_offsets_ptr,
+                  num_batches * output_batch_size,
+                  grad_input_starts.begin());
+            });
+      });
+
+  FBGEMM_DISPATCH_ALL_TYPES(
+      grad.scalar_type(), "keyed_jagged_index_add_dim1_cpu_3", [&] {
+        const auto* grad_ptr = grad_contig->data_ptr<scalar_t>();
+        auto* grad_input_ptr = grad_input.data_ptr<scalar_t>();
+        at::parallel_for(
+            0,
+            num_batches * output_batch_size,
+            std::max<int64_t>(
+                1,
+                at::internal::GRAIN_SIZE * num_batches * output_batch_size /
+                    grad.numel()),
+            [&](int64_t s_begin, int64_t s_end) {
+              for (const auto s : c10::irange(s_begin, s_end)) {
+                const int64_t bid = s / output_batch_size;
+                const int64_t index = s % output_batch_size;
+                scalar_t* dst = grad_input_ptr + grad_input_starts[s];
+                for (int64_t i = index_ptr[index]; i < index_ptr[index + 1];
+                     ++i) {
+                  const int64_t p = bid * num_indices + index_pos[i];
+                  const scalar_t* src = grad_ptr + grad_starts[p];
+                  for (const auto l :
+                       c10::irange(grad_starts[p + 1] - grad_starts[p])) {
+                    dst[l] += src[l];
+                  }
+                }
+              }
+            });
+      });
+
+  return grad_input;
+}
+
+namespace {
+
+class KeyedJaggedIndexSelectDim1CPUOp
+    : public torch::autograd::Function<KeyedJaggedIndexSelectDim1CPUOp> {
+ public:
+  static torch::autograd::variable_list forward(
+      torch::autograd::AutogradContext* ctx,
+      const Tensor& values,
+      const Tensor& lengths,
+      const Tensor& offsets,
+      const Tensor& indices,
+      const c10::SymInt batch_size,
+      const c10::optional<Tensor>& weights,
+      const c10::optional<c10::SymInt>& selected_lengths_sum) {
+    at::AutoDispatchBelowADInplaceOrView guard;
+    static auto forward_op_impl =
+        c10::Dispatcher::singleton()
+            .findSchemaOrThrow(
+                "fbgemm::keyed_jagged_index_select_dim1_forward", "")
+            .typed<decltype(keyed_jagged_index_select_dim1_forward_cpu)>();
+
+    auto res = forward_op_impl.call(
+        values,
+        lengths,
+        offsets,
+        indices,
+        batch_size,
+        weights,
+        selected_lengths_sum);
+
+    const bool has_weights = weights.has_value();
+    const size_t res_size = has_weights ? 3u : 2u;
+    ctx->saved_data["has_weights"] = has_weights;
+    ctx->save_for_backward(std::vector<Tensor>{
+        offsets,
+        indices,
+        res[res_size + 0], // output_offsets
+        res[res_size + 1], // saved_data_tensor
+    });
+
+    res.resize(res_size);
+    return res;
+  }
+
+  static torch::autograd::variable_list backward(
+      torch::autograd::AutogradContext* ctx,
+      torch::autograd::variable_list grad_outputs) {
+    const bool has_weights = ctx->saved_data["has_weights"].toBool();
+    TORCH_CHECK(
+        (has_weights && grad_outputs.size() == 3) || grad_outputs.size() == 2);
+
+    const auto saved = ctx->get_saved_variables();
+    auto savedItr = std::begin(saved);
+    const Tensor& output_offsets = *savedItr++; // saved forward offsets
+    const Tensor& indices = *savedItr++; // saved forward indices
+    const Tensor& grad_offsets = *savedItr++; // saved forward output_offsets
+    const Tensor& saved_tensor = *savedItr++;
+
+    static auto backward_op =
+        c10::Dispatcher::singleton()
+            .findSchemaOrThrow(
+                "fbgemm::keyed_jagged_index_select_dim1_backward", "")
+            .typed<decltype(keyed_jagged_index_select_dim1_backward_cpu)>();
+
+    auto grad_input = backward_op.call(
+        grad_outputs[0], indices, grad_offsets, output_offsets, saved_tensor);
+
+    return {
+        grad_input,
+        torch::autograd::Variable(), // lengths
+        torch::autograd::Variable(), // offsets
+        torch::autograd::Variable(), // indices
+        torch::autograd::Variable(), // batch_size
+        torch::autograd::Variable(), // weights
+        torch::autograd::Variable(), // selected_lengths_sum
+    };
+  }
+};
+
+} // namespace
+
+std::vector<Tensor> keyed_jagged_index_select_dim_1_cpu(
+    const Tensor& values,
+    const Tensor& lengths,
+    const Tensor& offsets,
+    const Tensor& indices,
+    const c10::SymInt batch_size,
+    const c10::optional<Tensor>& weights,
+    const c10::optional<c10::SymInt> selected_lengths_sum) {
+  return KeyedJaggedIndexSelectDim1CPUOp::apply(
+      values,
+      lengths,
+      offsets,
+      indices,
+      batch_size,
+      weights,
+      selected_lengths_sum);
+}
+
+/// Deduplicates the indices of a keyed jagged tensor, linearized with
+/// hash_size_cumsum, as the CUDA op does: the unique indices are sorted by
+/// linearized index and the features [hash_size_offsets[k],
+/// hash_size_offsets[k + 1]) of every key k share their unique indices.
+/// Every key is deduplicated in parallel, with a direct-address table when
+/// its linearized indices span a small range and a sort otherwise. The
+/// sorted unique indices of the keys are then merged, which is a plain
+/// concatenation unless the hash ranges of the keys overlap.
+std::tuple<Tensor, Tensor, Tensor, Tensor> jagged_unique_indices_cpu(
+    const Tensor& hash_size_cumsum,
+    const Tensor& hash_size_offsets,
+    const Tensor& offsets,
+    const Tensor& indices) {
+  TENSOR_ON_CPU(hash_size_cumsum);
+  TENSOR_ON_CPU(hash_size_offsets);
+  TENSOR_ON_CPU(offsets);
+  TENSOR_ON_CPU(indices);
+  const int64_t T = hash_size_cumsum.numel() - 1;
+  const int64_t total_B = offsets.numel() - 1;
+  TORCH_CHECK(T > 0 && total_B % T == 0);
+  TORCH_CHECK(hash_size_offsets.numel() == T + 1);
+  const int64_t B = total_B / T;
+  const int64_t num_indices = indices.numel();
+
+  const auto hash_size_cumsum_long = hash_size_cumsum.to(at::kLong);
+  const auto hash_size_offsets_long = hash_size_offsets.to(at::kLong);
+  const auto* hsc = hash_size_cumsum_long.data_ptr<int64_t>();
+  const auto* hso = hash_size_offsets_long.data_ptr<int64_t>();
+  const auto offsets_contig = offsets.expect_contiguous();
+  const auto indices_contig = indices.expect_contiguous();
+
+  // The linearized index of every input, replaced by the position of its
+  // unique index within its key and then overall
+  Tensor reverse_index =
+      at::empty({num_indices}, indices.options().dtype(at::kLong));
+  auto* reverse_ptr = reverse_index.data_ptr<int64_t>();
+  Tensor output_lengths = at::zeros({total_B}, offsets.options());
+  Tensor unique_indices;
+
+  AT_DISPATCH_INDEX_TYPES(
+      offsets.scalar_type(), "jagged_unique_indices_cpu_1", [&] {
+        using offset_t = index_t;
+        AT_DISPATCH_INDEX_TYPES(
+            indices.scalar_type(), "jagged_unique_indices_cpu_2", [&] {
+              const auto* offsets_ptr = offsets_contig->data_ptr<offset_t>();
+              const auto* indices_ptr = indices_contig->data_ptr<index_t>();
+
+              // The sorted unique linearized indices of every key, with the
+              // index of their first input
+              std::vector<std::vector<int64_t>> key_unique(T);
+              std::vector<std::vector<index_t>> key_unique_indices(T);
+              at::parallel_for(0, T, 1, [&](int64_t k_begin, int64_t k_end) {
+                for (const auto k : c10::irange(k_begin, k_end)) {
+                  const int64_t i_begin = offsets_ptr[hso[k] * B];
+                  const int64_t i_end = offsets_ptr[hso[k + 1] * B];
+                  if (i_begin >= i_end) {
+                    continue;
+                  }
+                  int64_t min_index = std::numeric_limits<int64_t>::max();
+                  int64_t max_index = std::numeric_limits<int64_t>::min();
+                  for (const auto t : c10::irange(hso[k], hso[k + 1])) {
+                    for (const auto i : c10::irange(
+                             offsets_ptr[t * B], offsets_ptr[(t + 1) * B])) {
+                      const int64_t linear_index = hsc[t] + indices_ptr[i];
+                      reverse_ptr[i] = linear_index;
+                      min_index = std::min(min_index, linear_index);
+                      max_index = std::max(max_index, linear_index);
+                    }
+                  }
+
+                  auto& unique = key_unique[k];
+                  auto& unique_original = key_unique_indices[k];
+                  const int64_t n = i_end - i_begin;
+                  const int64_t range = max_index - min_index + 1;
+                  if (range <= 4 * n) {
+                    // Mark the linearized indices, then rank them
+                    std::vector<int64_t> rank(range, -1);
+                    for (const auto i : c10::irange(i_begin, i_end)) {
+                      rank[reverse_ptr[i] - min_index] = i;
+                    }
+                    for (const auto r : c10::irange(range)) {
+                      if (rank[r] >= 0) {
+                        unique.push_back(min_index + r);
+                        unique_original.push_back(indices_ptr[rank[r]]);
+                        rank[r] = unique.size() - 1;
+                      }
+                    }
+                    for (const auto i : c10::irange(i_begin, i_end)) {
+                      reverse_ptr[i] = rank[reverse_ptr[i] - min_index];
+                    }
+                  } else {
+                    unique.assign(reverse_ptr + i_begin, reverse_ptr + i_end);
+                    std::sort(unique.begin(), unique.end());
+                    unique.erase(
+                        std::unique(unique.begin(), unique.end()),
+                        unique.end());
+                    unique_original.resize(unique.size());
+                    for (const auto i : c10::irange(i_begin, i_end)) {
+                      const int64_t pos =
+                          std::lower_bound(
+                              unique.begin(), unique.end(), reverse_ptr[i]) -
+                          unique.begin();
+                      unique_original[pos] = indices_ptr[i];
+                      reverse_ptr[i] = pos;
+                    }
+                  }
+                }
+              });
+
+              // Merge the keys: the position of the first unique index of
+              // every key when their ranges are in order, otherwise the
+              // sorted union of all the unique indices
+              std::vector<int64_t> unique_offsets(T + 1, 0);
+              bool ordered = true;
+              int64_t last_index = std::numeric_limits<int64_t>::min();
+              for (const auto k : c10::irange(T)) {
+                const auto& unique = key_unique[k];
+                unique_offsets[k + 1] = unique_offsets[k] + unique.size();
+                if (!unique.empty()) {
+                  ordered = ordered && unique.front() > last_index;
+                  last_index = unique.back();
+                }
+              }
+              std::vector<int64_t> all_unique;
+              if (!ordered) {
+                all_unique.reserve(unique_offsets[T]);
+                for (const auto& unique : key_unique) {
+                  all_unique.insert(
+                      all_unique.end(), unique.begin(), unique.end());
+                }
+                std::sort(all_unique.begin(), all_unique.end());
+                all_unique.erase(
+                    std::unique(all_unique.begin(), all_unique.end()),
+                    all_unique.end());
+              }
+              const int64_t num_unique =
+                  ordered ? unique_offsets[T] : all_unique.size();
+              unique_indices = at::empty({num_unique}, indices.options());
+              auto* unique_indices_ptr = unique_indices.data_ptr<index_t>();
+
+              // Map the positions within every key to the overall
+              // positions, which are the reverse index
+              at::parallel_for(0, T, 1, [&](int64_t k_begin, int64_t k_end) {
+                for (const auto k : c10::irange(k_begin, k_end)) {
+                  auto& unique = key_unique[k];
+                  if (unique.empty()) {
+                    continue;
+                  }
+                  for (const auto u : c10::irange(unique.size())) {
+                    unique[u] = ordered
+                        ? unique_offsets[k] + static_cast<int64_t>(u)
+                        : std::lower_bound(
+                              all_unique.begin(), all_unique.end(), unique[u]) -
+                            all_unique.begin();
+                  }
+                  for (const auto i : c10::irange(
+                           offsets_ptr[hso[k] * B],
+                           offsets_ptr[hso[k + 1] * B])) {
+                    reverse_ptr[i] = unique[reverse_ptr[i]];
+                  }
+                  if (ordered) {
+                    std::copy(
+                        key_unique_indices[k].begin(),
+                        key_unique_indices[k].end(),
+                        unique_indices_ptr + unique_offsets[k]);
+                  }
+                }
+              });
+              if (!ordered) {
+                for (const auto k : c10::irange(T)) {
+                  for (const auto u : c10::irange(key_unique[k].size())) {
+                    unique_indices_ptr[key_unique[k][u]] =
+                        key_unique_indices[k][u];
+                  }
+                }
+              }
+
+              // Spread the range of the unique indices of every key over the
+              // lengths of its features, as the CUDA op does
+              auto* output_lengths_ptr = output_lengths.data_ptr<offset_t>();
+              for (const auto k : c10::irange(T)) {
+                const auto& unique = key_unique[k];
+                const int64_t num_lengths = (hso[k + 1] - hso[k]) * B;
+                if (unique.empty() || num_lengths <= 0) {
+                  continue;
+                }
+                const auto [min_pos, max_pos] =
+                    std::minmax_element(unique.begin(), unique.end());
+                const int64_t total_length = *max_pos - *min_pos + 1;
+                const int64_t div_length = total_length / num_lengths;
+                const int64_t r_length = total_length % num_lengths;
+                for (const auto i : c10::irange(num_lengths)) {
+                  output_lengths_ptr[hso[k] * B + i] =
+                      i < r_length ? div_length + 1 : div_length;
+                }
+              }
+            });
+      });
+
+  Tensor output_offsets = asynchronous_complete_cumsum_cpu(output_lengths);
+  return {output_lengths, output_offsets, unique_indices, reverse_index};
+}
+
+/// Hash size of every feature from the max of its indices, as the CUDA op
+/// does, with the hash size offsets of one feature per key.
+std::tuple<Tensor, Tensor> jagged_hash_size_cumsum_cpu(
+    const Tensor& offsets,
+    const Tensor& indices,
+    const int64_t batch_size) {
+  TENSOR_ON_CPU(offsets);
+  TENSOR_ON_CPU(indices);
+  TORCH_CHECK(batch_size > 0);
+  const int64_t T = (offsets.numel() - 1) / batch_size;
+  Tensor hash_size = at::zeros({T}, offsets.options());
+  const auto offsets_contig = offsets.expect_contiguous();
+  const auto indices_contig = indices.expect_contiguous();
+
+  AT_DISPATCH_INDEX_TYPES(
+      offsets.scalar_type(), "jagged_hash_size_cumsum_cpu_1", [&] {
+        using offset_t = index_t;
+        AT_DISPATCH_INDEX_TYPES(
+            indices.scalar_type(), "jagged_hash_size_cumsum_cpu_2", [&] {
+              const auto* offsets_ptr = offsets_contig->data_ptr<offset_t>();
+              const auto* indices_ptr = indices_contig->data_ptr<index_t>();
+              auto* hash_size_ptr = hash_size.data_ptr<offset_t>();
+              at::parallel_for(0, T, 1, [&](int64_t t_begin, int64_t t_end) {
+                for (const auto t : c10::irange(t_begin, t_end)) {
+                  const auto begin = offsets_ptr[t * batch_size];
+                  const auto end = offsets_ptr[(t + 1) * batch_size];
+                  if (begin < end) {
+                    hash_size_ptr[t] =
+                        *std::max_element(
+                            indices_ptr + begin, indices_ptr + end) +
+                        1;
+                  }
+                }
+              });
+            });
+      });
+
+  Tensor hash_size_cumsum = asynchronous_complete_cumsum_cpu(hash_size);
+  Tensor hash_size_offsets =
+      asynchronous_complete_cumsum_cpu(at::ones_like(hash_size));
+  return {hash_size_cumsum, hash_size_offsets};
+}
+
 } // namespace fbgemm_gpu
 
 TORCH_LIBRARY_FRAGMENT(fbgemm, m) {
@@ -1710,6 +2835,9 @@ TORCH_LIBRARY_FRAGMENT(fbgemm, m) {
       "jagged_softmax_forward(Tensor values, Tensor x_offsets, int max_L) -> Tensor");
   m.def(
       "jagged_softmax_backward(Tensor grad_output, Tensor output, Tensor x_offsets, int max_L) -> Tensor");
+  m.def(
+      "jagged_attention_forward(Tensor q_values, Tensor k_values, Tensor v_values, Tensor x_offsets, int max_L, float scale=1.0) -> Tensor",
+      {PT2_COMPLIANT_TAG});
   m.def(
       "jagged_jagged_bmm(Tensor x_values, Tensor y_values, Tensor x_offsets, int max_L) -> Tensor",
       {PT2_COMPLIANT_TAG});
@@ -1791,6 +2919,8 @@ TORCH_LIBRARY_IMPL(fbgemm, CPU, m) {
   DISPATCH_TO_CPU("jagged_softmax_forward", fbgemm_gpu::jagged_softmax_forward);
   DISPATCH_TO_CPU(
       "jagged_softmax_backward", fbgemm_gpu::jagged_softmax_backward);
+  DISPATCH_TO_CPU(
+      "jagged_attention_forward", fbgemm_gpu::jagged_attention_forward);
   DISPATCH_TO_CPU("jagged_jagged_bmm", fbgemm_gpu::jagged_jagged_bmm);
   DISPATCH_TO_CPU(
       "jagged_jagged_bmm_forward", fbgemm_gpu::jagged_jagged_bmm_forward);
@@ -1798,6 +2928,25 @@ TORCH_LIBRARY_IMPL(fbgemm, CPU, m) {
   DISPATCH_TO_CPU(
       "jagged_dense_bmm_forward", fbgemm_gpu::jagged_dense_bmm_forward);
   DISPATCH_TO_CPU("jagged_slice_forward", fbgemm_gpu::jagged_slice_forward_cpu);
+  DISPATCH_TO_CPU(
+      "keyed_jagged_index_select_dim1_forward",
+      fbgemm_gpu::keyed_jagged_index_select_dim1_forward_cpu);
+  DISPATCH_TO_CPU(
+      "keyed_jagged_index_select_dim1_backward",
+      fbgemm_gpu::keyed_jagged_index_select_dim1_backward_cpu);
+  DISPATCH_TO_CPU(
+      "keyed_jagged_index_select_dim1",
+      fbgemm_gpu::keyed_jagged_index_select_dim_1_cpu);
+  DISPATCH_TO_CPU(
+      "jagged_unique_indices", fbgemm_gpu::jagged_unique_indices_cpu);
+  DISPATCH_TO_CPU(
+      "jagged_hash_size_cumsum", fbgemm_gpu::jagged_hash_size_cumsum_cpu);
+}
+
+TORCH_LIBRARY_IMPL(fbgemm, AutogradCPU, m) {
+  m.impl(
+      "keyed_jagged_index_select_dim1",
+      &fbgemm_gpu::keyed_jagged_index_select_dim_1_cpu);
 }
 
 TORCH_LIBRARY_IMPL(fbgemm, CompositeExplicitAutograd, m) {
@@ -13,6 +13,12 @@
 #include "fbgemm_gpu/dispatch_macros.h"
 #include "fbgemm_gpu/sparse_ops_utils.h"
 
+#if defined(__x86_64__) || defined(__i386__) || \
+    (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
+#include <emmintrin.h>
+#define FBGEMM_GPU_RECAT_NON_TEMPORAL
+#endif
+
 using Tensor = at::Tensor;
 
 /// @defgroup layout-transform-cpu Layout Transformation CPU Operators
@@ -20,6 +26,35 @@ using Tensor = at::Tensor;
 
 namespace fbgemm_gpu {
 
+namespace {
+
+// Outputs larger than the last level cache are written with non-temporal
+// stores, so that they do not evict the grad_output still to be read
+constexpr int64_t kRecatNonTemporalBytes = 32 * 1024 * 1024;
+
+inline void recat_copy_row(
+    char* dst,
+    const char* src,
+    const int64_t bytes,
+    const bool non_temporal) {
+  int64_t b = 0;
+#ifdef FBGEMM_GPU_RECAT_NON_TEMPORAL
+  if (non_temporal) {
+    const int64_t head = std::min<int64_t>(
+        bytes, (16 - reinterpret_cast<uintptr_t>(dst) % 16) % 16);
+    memcpy(dst, src, head);
+    for (b = head; b + 16 <= bytes; b += 16) {
+      _mm_stream_si128(
+          reinterpret_cast<__m128i*>(dst + b),
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + b)));
+    }
+  }
+#endif
+  memcpy(dst + b, src + b, bytes - b);
+}
+
+} // namespace
+
 ///@ingroup layout-transform-cpu
 Tensor recat_embedding_grad_output_mixed_D_cpu(
     const Tensor& grad_output, // [B_local][Sum_T_global(D)]
@@ -38,12 +73,20 @@ Tensor recat_embedding_grad_output_mixed_D_cpu(
   const auto global_dim_sum = accum_dim_sum[n];
   TORCH_CHECK(B_local * global_dim_sum == grad_output.numel());
 
+  // Each task copies the rows of a block of samples of a rank, about
+  // GRAIN_SIZE elements
+  const bool non_temporal =
+      grad_output.numel() * grad_output.element_size() >=
+      kRecatNonTemporalBytes;
+  const auto grain_size = std::max<int64_t>(
+      1, at::internal::GRAIN_SIZE * n / std::max<int64_t>(global_dim_sum, 1));
+
   FBGEMM_DISPATCH_FLOAT_AND_HALF(
       grad_output.scalar_type(), "recat_embedding_gradients", [&] {
         const auto go = grad_output.accessor<scalar_t, 2>();
         auto sgo = sharded_grad_output.accessor<scalar_t, 1>();
         at::parallel_for(
-            0, n * B_local, 1, [&](int64_t i_begin, int64_t i_end) {
+            0, n * B_local, grain_size, [&](int64_t i_begin, int64_t i_end) {
               const auto dim_begin = i_begin / B_local;
               const auto dim_end = (i_end + B_local - 1) / B_local;
               for (const auto dim : c10::irange(dim_begin, dim_end)) {
@@ -56,12 +99,18 @@ Tensor recat_embedding_grad_output_mixed_D_cpu(
                     ? i_end % B_local
                     : B_local;
                 for (const auto r : c10::irange(r_begin, r_end)) {
-                  memcpy(
-                      dst + r * dim_sum,
-                      src + r * global_dim_sum,
-                      dim_sum * sizeof(scalar_t));
+                  recat_copy_row(
+                      reinterpret_cast<char*>(dst + r * dim_sum),
+                      reinterpret_cast<const char*>(src + r * global_dim_sum),
+                      dim_sum * sizeof(scalar_t),
+                      non_temporal);
                 }
               }
+#ifdef FBGEMM_GPU_RECAT_NON_TEMPORAL
+              if (non_temporal) {
+                _mm_sfence();
+              }
+#endif
             });
       });
 
@@ -6,6 +6,17 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <ATen/cuda/CUDAContext.h>
+#include <sys/syscall.h>
+#include <algorithm>
+#include <cerrno>
+#include <fstream>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+
 #include "common.cuh"
 #include "fbgemm_gpu/fbgemm_cuda_utils.cuh"
 
@@ -25,6 +36,334 @@ namespace fbgemm_gpu {
 
 namespace {
 
+// Caching pool for the host-mapped (pinned) and managed (UVM) allocations.
+// cudaHostRegister and cudaMallocManaged cost milliseconds per call, which
+// dominates the short lived staging buffers of cache populate and SSD IO.
+// Blocks are rounded up to size classes (a quarter of a power of two) and kept
+// in per device bins when released. A released block is only reused once the
+// work queued on the streams it was used on has completed, unless it is
+// reused on the one stream it was used on by device side accesses, which are
+// ordered by the stream anyway.
+
+enum class PoolKind : uint8_t { HOST_MAPPED = 0, MANAGED = 1 };
+
+constexpr size_t kPoolMinBlockSize = 512;
+
+struct PooledBlock {
+  void* ptr_;
+  size_t size_;
+  int cuda_device_;
+  PoolKind kind_;
+  // Whether the block is used through a CPU tensor, whose host accesses are
+  // not ordered by the streams
+  bool host_accessed_;
+  std::vector<cudaStream_t> streams_;
+  std::vector<cudaEvent_t> events_;
+};
+
+size_t pool_round_size(size_t size) {
+  if (size <= kPoolMinBlockSize) {
+    return kPoolMinBlockSize;
+  }
+  size_t power = size_t(1) << (63 - __builtin_clzll(size));
+  size_t step = power / 4;
+  return (size + step - 1) / step * step;
+}
+
+void prefault_pages(void* ptr, size_t size_bytes) {
+  // Pre-fault/map the pages by setting the first byte of the page
+  // TODO: parallelize the mapping of pages with a threadpool executor
+  const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
+  uintptr_t alignedPtr = (((uintptr_t)ptr + pageSize - 1) & ~(pageSize - 1));
+  for (uintptr_t p = alignedPtr; p < ((uintptr_t)ptr + size_bytes);
+       p += pageSize) {
+    memset((void*)p, 0, 1);
+  }
+}
+
+// Returns the NUMA node of the host memory closest to a CUDA device, read from
+// the sysfs entry of its PCI device, or -1 when unknown (e.g. on a single node
+// host)
+int host_numa_node(int cuda_device) {
+  static std::mutex mutex;
+  static std::map<int, int> numa_nodes;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = numa_nodes.find(cuda_device);
+  if (it != numa_nodes.end()) {
+    return it->second;
+  }
+
+  int node = -1;
+  char pci_bus_id[32];
+  if (cudaDeviceGetPCIBusId(pci_bus_id, sizeof(pci_bus_id), cuda_device) ==
+      cudaSuccess) {
+    std::string bus_id(pci_bus_id);
+    // sysfs uses lowercase hexadecimal digits
+    std::transform(bus_id.begin(), bus_id.end(), bus_id.begin(), ::tolower);
+    std::ifstream file("/sys/bus/pci/devices/" + bus_id + "/numa_node");
+    if (!(file >> node)) {
+      node = -1;
+    }
+  } else {
+    (void)cudaGetLastError();
+  }
+  numa_nodes[cuda_device] = node;
+  return node;
+}
+
+// Places the pages of a host allocation on the NUMA node closest to a CUDA
+// device, moving the pages already faulted. This is a preference rather than a
+// strict binding so that the allocation can spill to other nodes. The pages
+// shared with neighbouring allocations are left alone.
+void place_host_pages_near_device(void* ptr, size_t size, int cuda_device) {
+  const int node = host_numa_node(cuda_device);
+  if (node < 0) {
+    return;
+  }
+  const uintptr_t page_size = (uintptr_t)sysconf(_SC_PAGESIZE);
+  const uintptr_t begin = ((uintptr_t)ptr + page_size - 1) & ~(page_size - 1);
+  const uintptr_t end = ((uintptr_t)ptr + size) & ~(page_size - 1);
+  if (begin >= end) {
+    return;
+  }
+
+  // mbind() is called through syscall to not depend on libnuma
+  constexpr int kMpolPreferred = 1;
+  constexpr unsigned kMpolMfMove = 1 << 1;
+  constexpr size_t kBitsPerWord = 8 * sizeof(unsigned long);
+  std::vector<unsigned long> nodemask(node / kBitsPerWord + 1, 0);
+  nodemask[node / kBitsPerWord] |= 1UL << (node % kBitsPerWord);
+  if (syscall(
+          SYS_mbind,
+          (void*)begin,
+          (unsigned long)(end - begin),
+          kMpolPreferred,
+          nodemask.data(),
+          (unsigned long)(nodemask.size() * kBitsPerWord + 1),
+          kMpolMfMove) != 0) {
+    VLOG(2) << "mbind to NUMA node " << node << " failed: " << strerror(errno);
+  }
+}
+
+// Sets the preferred location of managed memory to the host, on the NUMA node
+// closest to the CUDA device when the runtime supports it
+void set_preferred_location_host(void* ptr, size_t size, int cuda_device) {
+#if !defined(USE_ROCM) && CUDART_VERSION >= 12020
+  const int node = host_numa_node(cuda_device);
+  if (node >= 0) {
+    cudaMemLocation location;
+    location.type = cudaMemLocationTypeHostNuma;
+    location.id = node;
+    if (cudaMemAdvise_v2(
+            ptr, size, cudaMemAdviseSetPreferredLocation, location) ==
+        cudaSuccess) {
+      return;
+    }
+    // Not supported by the driver, fall back to any host node
+    (void)cudaGetLastError();
+  }
+#endif
+  AT_CUDA_CHECK(cudaMemAdvise(
+      ptr, size, cudaMemAdviseSetPreferredLocation, cudaCpuDeviceId));
+}
+
+class CachingMemoryPool {
+ public:
+  PooledBlock* allocate(
+      PoolKind kind,
+      int cuda_device,
+      size_t size,
+      bool host_accessed) {
+    const size_t rounded = pool_round_size(size);
+    cudaStream_t stream = at::cuda::getCurrentCUDAStream(cuda_device).stream();
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      auto& bin = bins_[std::make_tuple(kind, cuda_device, rounded)];
+      for (auto it = bin.begin(); it != bin.end(); ++it) {
+        PooledBlock* block = *it;
+        if (!reusable(block, stream, host_accessed)) {
+          continue;
+        }
+        bin.erase(it);
+        destroy_events(block);
+        block->host_accessed_ = host_accessed;
+        block->streams_.assign(1, stream);
+        cached_bytes_ -= rounded;
+        allocated_bytes_ += rounded;
+        num_reuses_++;
+        return block;
+      }
+    }
+
+    void* ptr = raw_allocate(kind, cuda_device, rounded);
+    if (ptr == nullptr) {
+      // Give the cached blocks back to the driver and retry once
+      empty_cache();
+      ptr = raw_allocate(kind, cuda_device, rounded);
+      TORCH_CHECK(
+          ptr != nullptr,
+          "Failed to allocate ",
+          rounded,
+          " bytes of ",
+          kind == PoolKind::MANAGED ? "managed" : "host-mapped",
+          " memory");
+    }
+
+    auto* block = new PooledBlock{
+        ptr, rounded, cuda_device, kind, host_accessed, {stream}, {}};
+    std::lock_guard<std::mutex> lock(mutex_);
+    allocated_bytes_ += rounded;
+    num_allocs_++;
+    return block;
+  }
+
+  void release(PooledBlock* block) {
+    at::cuda::OptionalCUDAGuard device_guard(block->cuda_device_);
+    for (auto stream : block->streams_) {
+      cudaEvent_t event;
+      AT_CUDA_CHECK(cudaEventCreateWithFlags(&event, cudaEventDisableTiming));
+      AT_CUDA_CHECK(cudaEventRecord(event, stream));
+      block->events_.push_back(event);
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    allocated_bytes_ -= block->size_;
+    cached_bytes_ += block->size_;
+    bins_[std::make_tuple(block->kind_, block->cuda_device_, block->size_)]
+        .push_back(block);
+  }
+
+  void record_stream(PooledBlock* block, cudaStream_t stream) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (std::find(block->streams_.begin(), block->streams_.end(), stream) ==
+        block->streams_.end()) {
+      block->streams_.push_back(stream);
+    }
+  }
+
+  void empty_cache() {
+    std::vector<PooledBlock*> blocks;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (auto& bin : bins_) {
+        blocks.insert(blocks.end(), bin.second.begin(), bin.second.end());
+        cached_bytes_ -= bin.second.size() * std::get<2>(bin.first);
+      }
+      bins_.clear();
+    }
+    for (auto* block : blocks) {
+      at::cuda::OptionalCUDAGuard device_guard(block->cuda_device_);
+      for (auto event : block->events_) {
+        AT_CUDA_CHECK(cudaEventSynchronize(event));
+      }
+      destroy_events(block);
+      if (block->kind_ == PoolKind::MANAGED) {
+        AT_CUDA_CHECK(cudaFree(block->ptr_));
+      } else {
+        AT_CUDA_CHECK(cudaHostUnregister(block->ptr_));
+        free(block->ptr_);
+      }
+      delete block;
+    }
+  }
+
+  std::vector<int64_t> stats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return {allocated_bytes_, cached_bytes_, num_allocs_, num_reuses_};
+  }
+
+ private:
+  static bool reusable(
+      const PooledBlock* block,
+      cudaStream_t stream,
+      bool host_accessed) {
+    if (!host_accessed && !block->host_accessed_ &&
+        block->streams_.size() == 1 && block->streams_[0] == stream) {
+      return true;
+    }
+    for (auto event : block->events_) {
+      const auto err = cudaEventQuery(event);
+      if (err == cudaErrorNotReady) {
+        // Clear the sticky error state left by cudaEventQuery
+        (void)cudaGetLastError();
+        return false;
+      }
+      AT_CUDA_CHECK(err);
+    }
+    return true;
+  }
+
+  static void destroy_events(PooledBlock* block) {
+    for (auto event : block->events_) {
+      AT_CUDA_CHECK(cudaEventDestroy(event));
+    }
+    block->events_.clear();
+  }
+
+  // Returns nullptr on allocation failure so the caller can retry after
+  // emptying the cache
+  static void* raw_allocate(PoolKind kind, int cuda_device, size_t size) {
+    at::cuda::OptionalCUDAGuard device_guard(cuda_device);
+    void* ptr = nullptr;
+    if (kind == PoolKind::MANAGED) {
+      if (cudaMallocManaged(&ptr, size) != cudaSuccess) {
+        (void)cudaGetLastError();
+        return nullptr;
+      }
+      // Same placement as new_managed_tensor, see the comments over there
+      set_preferred_location_host(ptr, size, cuda_device);
+      AT_CUDA_CHECK(
+          cudaMemAdvise(ptr, size, cudaMemAdviseSetAccessedBy, cuda_device));
+      TORCH_CHECK(madvise(ptr, size, MADV_DONTFORK) == 0);
+      return ptr;
+    }
+
+    // Same malloc + cudaHostRegister scheme as new_host_mapped_tensor
+    ptr = malloc(size);
+    if (ptr == nullptr) {
+      return nullptr;
+    }
+    place_host_pages_near_device(ptr, size, cuda_device);
+    prefault_pages(ptr, size);
+    if (cudaHostRegister(
+            ptr, size, cudaHostRegisterMapped | cudaHostRegisterPortable) !=
+        cudaSuccess) {
+      (void)cudaGetLastError();
+      free(ptr);
+      return nullptr;
+    }
+    return ptr;
+  }
+
+  std::mutex mutex_;
+  std::map<std::tuple<PoolKind, int, size_t>, std::list<PooledBlock*>> bins_;
+  int64_t allocated_bytes_ = 0;
+  int64_t cached_bytes_ = 0;
+  int64_t num_allocs_ = 0;
+  int64_t num_reuses_ = 0;
+};
+
+// Intentionally leaked: tensors may be released after static destruction
+CachingMemoryPool& memory_pool() {
+  static auto* pool = new CachingMemoryPool();
+  return *pool;
+}
+
+// Holds a block of the pool that backs either a host-mapped CUDA tensor or a
+// pinned CPU tensor
+struct PooledHostContext {
+  PooledBlock* block_;
+
+  PooledHostContext(PooledBlock* block) : block_(block){};
+
+  ~PooledHostContext() {
+    memory_pool().release(block_);
+  }
+
+  static void release(void* ptr) {
+    delete static_cast<PooledHostContext*>(ptr);
+  }
+};
+
 struct CUDAHostMappedContext {
   void* ptr_;
   int cuda_device_;
@@ -46,11 +385,17 @@ struct CUDAHostMappedContext {
 struct CUDAManagedContext {
   void* ptr_;
   int cuda_device_;
+  // Set when the memory comes from the caching pool, which it is returned to
+  PooledBlock* block_;
 
-  CUDAManagedContext(void* ptr, int cuda_device)
-      : ptr_(ptr), cuda_device_(cuda_device){};
+  CUDAManagedContext(void* ptr, int cuda_device, PooledBlock* block = nullptr)
+      : ptr_(ptr), cuda_device_(cuda_device), block_(block){};
 
   ~CUDAManagedContext() {
+    if (block_ != nullptr) {
+      memory_pool().release(block_);
+      return;
+    }
     at::cuda::OptionalCUDAGuard device_guard(cuda_device_);
     AT_CUDA_CHECK(cudaFree(ptr_));
   }
@@ -83,17 +428,29 @@ std::vector<int64_t> defaultStrides(IntArrayRef sizes) {
   return strides;
 }
 
-// Allocate the ATen Tensor with unified managed memory (UVM)
+// Allocate the ATen Tensor with unified managed memory (UVM), taken from the
+// caching pool if pooled is set
 Tensor new_managed_tensor_internal(
     const Tensor& self,
-    const std::vector<std::int64_t>& sizes) {
+    const std::vector<std::int64_t>& sizes,
+    bool pooled = false) {
   CUDA_DEVICE_GUARD(self);
 
   auto strides = defaultStrides(sizes);
   size_t size_bytes =
       at::detail::computeStorageNbytes(sizes, strides, self.dtype().itemsize());
   void* ptr;
-  AT_CUDA_CHECK(cudaMallocManaged(&ptr, size_bytes));
+  PooledBlock* block = nullptr;
+  if (pooled) {
+    block = memory_pool().allocate(
+        PoolKind::MANAGED,
+        self.get_device(),
+        size_bytes,
+        /*host_accessed=*/false);
+    ptr = block->ptr_;
+  } else {
+    AT_CUDA_CHECK(cudaMallocManaged(&ptr, size_bytes));
+  }
 
   // The memory allocated above can be accessed from CUDA and CPU
   // However Storage requires a specific device and we need to retain the cuda
@@ -108,7 +465,7 @@ Tensor new_managed_tensor_internal(
       size_bytes,
       at::DataPtr(
           ptr,
-          new CUDAManagedContext(ptr, self.get_device()),
+          new CUDAManagedContext(ptr, self.get_device(), block),
           &CUDAManagedContext::release,
           {at::DeviceType::CUDA, self.device().index()}),
       nullptr, /* allocator */
@@ -155,9 +512,9 @@ Tensor new_managed_tensor(
   void* ptr = t.data_ptr();
   size_t size_bytes = t.storage().nbytes();
 
-  // Set preferred memory location to host memory
-  AT_CUDA_CHECK(cudaMemAdvise(
-      ptr, size_bytes, cudaMemAdviseSetPreferredLocation, cudaCpuDeviceId));
+  // Set preferred memory location to host memory, on the NUMA node closest to
+  // the device
+  set_preferred_location_host(ptr, size_bytes, self.get_device());
   // User hints with "accessed by": GPU will establish direct mapping of data
   // in CPU memory, no page faults will be generated
   AT_CUDA_CHECK(cudaMemAdvise(
@@ -205,15 +562,10 @@ Tensor new_host_mapped_tensor(
   // then do cudaHostRegister with GPU mapping flags to lock the pages, so we
   // can minimize the cost while holding this global lock.
   void* const ptr = malloc(size_bytes);
-
-  // Pre-fault/map the pages by setting the first byte of the page
-  // TODO: parallelize the mapping of pages with a threadpool executor
-  const size_t pageSize = (size_t)sysconf(_SC_PAGESIZE);
-  uintptr_t alignedPtr = (((uintptr_t)ptr + pageSize - 1) & ~(pageSize - 1));
-  for (uintptr_t p = alignedPtr; p < ((uintptr_t)ptr + size_bytes);
-       p += pageSize) {
-    memset((void*)p, 0, 1);
-  }
+  // Fault the pages on the NUMA node closest to the device, which halves the
+  // latency of the host fetches compared to the remote node
+  place_host_pages_near_device(ptr, size_bytes, self.get_device());
+  prefault_pages(ptr, size_bytes);
 
   AT_CUDA_CHECK(cudaHostRegister(
       ptr, size_bytes, cudaHostRegisterMapped | cudaHostRegisterPortable));
@@ -247,10 +599,105 @@ Tensor new_unified_tensor(
   }
 }
 
+Tensor new_pooled_managed_tensor(
+    const Tensor& self,
+    const std::vector<std::int64_t>& sizes) {
+  CUDA_DEVICE_GUARD(self);
+
+  // The pool sets the same memory advice as new_managed_tensor when it
+  // allocates the block
+  return new_managed_tensor_internal(self, sizes, /*pooled=*/true);
+}
+
+namespace {
+
+Tensor new_pooled_host_tensor_internal(
+    const Tensor& self,
+    const std::vector<std::int64_t>& sizes,
+    bool on_cpu) {
+  CUDA_DEVICE_GUARD(self);
+
+  auto strides = defaultStrides(sizes);
+  size_t size_bytes =
+      at::detail::computeStorageNbytes(sizes, strides, self.dtype().itemsize());
+
+  auto* block = memory_pool().allocate(
+      PoolKind::HOST_MAPPED, self.get_device(), size_bytes, on_cpu);
+  void* ptr = block->ptr_;
+  if (!on_cpu) {
+    AT_CUDA_CHECK(cudaHostGetDevicePointer(&ptr, block->ptr_, 0));
+  }
+
+  const auto device = on_cpu
+      ? at::Device(at::DeviceType::CPU)
+      : at::Device(at::DeviceType::CUDA, self.device().index());
+  auto storage = Storage(
+      Storage::use_byte_size_t(),
+      size_bytes,
+      at::DataPtr(
+          ptr,
+          new PooledHostContext(block),
+          &PooledHostContext::release,
+          device),
+      nullptr, /* allocator */
+      /*resizable=*/false);
+  return at::empty({0}, self.options().device(device))
+      .set_(std::move(storage), 0, sizes, strides);
+}
+
+PooledBlock* pooled_block(const Tensor& t) {
+  const auto& data_ptr = t.storage().data_ptr();
+  if (auto* context = data_ptr.cast_context<PooledHostContext>(
+          &PooledHostContext::release)) {
+    return context->block_;
+  }
+  if (auto* tcontext = data_ptr.cast_context<CUDAManagedIndirectContext>(
+          &CUDAManagedIndirectContext::release)) {
+    auto* ocontext =
+        tcontext->storage_.data_ptr().cast_context<CUDAManagedContext>(
+            &CUDAManagedContext::release);
+    if (ocontext != nullptr) {
+      return ocontext->block_;
+    }
+  }
+  return nullptr;
+}
+
+} // namespace
+
+Tensor new_pooled_host_mapped_tensor(
+    const Tensor& self,
+    const std::vector<std::int64_t>& sizes) {
+  return new_pooled_host_tensor_internal(self, sizes, /*on_cpu=*/false);
+}
+
+Tensor new_pooled_pinned_tensor(
+    const Tensor& self,
+    const std::vector<std::int64_t>& sizes) {
+  return new_pooled_host_tensor_internal(self, sizes, /*on_cpu=*/true);
+}
+
+void pooled_memory_record_stream(const Tensor& t) {
+  auto* block = pooled_block(t);
+  TORCH_CHECK(block != nullptr, "Tensor is not allocated from the memory pool");
+  memory_pool().record_stream(
+      block, at::cuda::getCurrentCUDAStream(block->cuda_device_).stream());
+}
+
+void pooled_memory_empty_cache() {
+  memory_pool().empty_cache();
+}
+
+std::vector<int64_t> pooled_memory_stats() {
+  return memory_pool().stats();
+}
+
 bool uvm_storage(const Tensor& t) {
   auto deleter = t.storage().data_ptr().get_deleter();
   return deleter == &CUDAManagedIndirectContext::release ||
-      deleter == &CUDAHostMappedContext::release;
+      deleter == &CUDAHostMappedContext::release ||
+      // Pinned CPU staging tensors of the pool are not UVM tensors
+      (deleter == &PooledHostContext::release && !t.is_cpu());
 }
 
 bool is_uvm_tensor(const Tensor& t) {
@@ -349,6 +796,13 @@ void uvm_cuda_mem_advise(const Tensor& t, int64_t cuda_memory_advise) {
 
   device_guard.set_index(cuda_device_index);
 
+  if (hint_device == cudaCpuDeviceId &&
+      cuda_memory_advise == cudaMemAdviseSetPreferredLocation) {
+    set_preferred_location_host(
+        ptr, size_bytes, static_cast<int>(cuda_device_index));
+    return;
+  }
+
   // FIXME: some advanced "cudaMemAdvise" flags are not supported by HIP.
   AT_CUDA_CHECK(cudaMemAdvise(
       ptr,
@@ -24,6 +24,16 @@ TORCH_LIBRARY_FRAGMENT(fbgemm, m) {
   m.def("new_managed_tensor(Tensor self, int[] sizes) -> Tensor");
   m.def("new_host_mapped_tensor(Tensor self, int[] sizes) -> Tensor");
   m.def("new_vanilla_managed_tensor(Tensor self, int[] sizes) -> Tensor");
+  m.def("new_pooled_managed_tensor(Tensor self, int[] sizes) -> Tensor");
+  m.def("new_pooled_host_mapped_tensor(Tensor self, int[] sizes) -> Tensor");
+  m.def("new_pooled_pinned_tensor(Tensor self, int[] sizes) -> Tensor");
+  m.def(
+      "pooled_memory_record_stream(Tensor t) -> ()",
+      TORCH_FN(pooled_memory_record_stream));
+  m.def(
+      "pooled_memory_empty_cache() -> ()",
+      TORCH_FN(pooled_memory_empty_cache));
+  m.def("pooled_memory_stats() -> int[]", TORCH_FN(pooled_memory_stats));
   m.def(
       "cuda_mem_advise(Tensor t, int advice) -> ()",
       TORCH_FN(uvm_cuda_mem_advise));
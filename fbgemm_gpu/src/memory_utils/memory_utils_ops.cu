@@ -20,6 +20,10 @@ TORCH_LIBRARY_FRAGMENT(fbgemm, m) {
   DISPATCH_TO_CUDA("new_host_mapped_tensor", new_host_mapped_tensor);
   DISPATCH_TO_CUDA("new_unified_tensor", new_unified_tensor);
   DISPATCH_TO_CUDA("new_vanilla_managed_tensor", new_vanilla_managed_tensor);
+  DISPATCH_TO_CUDA("new_pooled_managed_tensor", new_pooled_managed_tensor);
+  DISPATCH_TO_CUDA(
+      "new_pooled_host_mapped_tensor", new_pooled_host_mapped_tensor);
+  DISPATCH_TO_CUDA("new_pooled_pinned_tensor", new_pooled_pinned_tensor);
 }
 
 } // namespace fbgemm_gpu
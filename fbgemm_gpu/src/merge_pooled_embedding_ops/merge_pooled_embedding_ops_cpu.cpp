@@ -7,9 +7,14 @@
  */
 
 #include <ATen/ATen.h>
+#include <ATen/AccumulateType.h>
+#include <ATen/Parallel.h>
 #include <ATen/core/op_registration/op_registration.h>
 #include <c10/core/TensorOptions.h>
+#include <c10/util/irange.h>
 #include <torch/library.h>
+#include <algorithm>
+#include <cstring>
 #include "fbgemm_gpu/dispatch_macros.h"
 #include "fbgemm_gpu/ops_utils.h"
 #include "fbgemm_gpu/sparse_ops_utils.h"
@@ -18,11 +23,112 @@ using Tensor = at::Tensor;
 
 namespace fbgemm_gpu {
 
+namespace {
+
+// Whether the 2D tensors can be concatenated by copying their rows
+bool can_cat_rows(
+    const std::vector<Tensor>& tensors,
+    int64_t uncat_dim_size,
+    int64_t cat_dim) {
+  if (tensors.empty() || (cat_dim != 0 && cat_dim != 1)) {
+    return false;
+  }
+  return std::all_of(tensors.begin(), tensors.end(), [&](const Tensor& t) {
+    return t.is_cpu() && t.dim() == 2 &&
+        t.scalar_type() == tensors.front().scalar_type() &&
+        t.size(1 - cat_dim) == uncat_dim_size &&
+        (t.stride(1) == 1 || t.size(1) <= 1);
+  });
+}
+
+// Concatenates the 2D tensors into a new output, each thread copying whole
+// rows of the output so that its pages are first touched on the NUMA node of
+// the thread writing them
+Tensor cat_rows_cpu(
+    const std::vector<Tensor>& tensors,
+    int64_t uncat_dim_size,
+    int64_t cat_dim) {
+  std::vector<int64_t> cumulative_dims = {0};
+  for (const auto& t : tensors) {
+    cumulative_dims.push_back(cumulative_dims.back() + t.size(cat_dim));
+  }
+  const auto total_cat_dim = cumulative_dims.back();
+  auto output = cat_dim == 0
+      ? at::empty({total_cat_dim, uncat_dim_size}, tensors.front().options())
+      : at::empty({uncat_dim_size, total_cat_dim}, tensors.front().options());
+  if (output.numel() == 0) {
+    return output;
+  }
+
+  const auto element_size = output.element_size();
+  auto* output_ptr = static_cast<uint8_t*>(output.data_ptr());
+  const auto output_stride = output.stride(0) * element_size;
+
+  if (cat_dim == 0) {
+    const auto row_bytes = uncat_dim_size * element_size;
+    at::parallel_for(
+        0,
+        total_cat_dim,
+        std::max<int64_t>(1, at::internal::GRAIN_SIZE / row_bytes),
+        [&](int64_t row_begin, int64_t row_end) {
+          // The input holding the first row of the range
+          const auto first = std::upper_bound(
+              cumulative_dims.begin(), cumulative_dims.end(), row_begin);
+          auto t = first - cumulative_dims.begin() - 1;
+          for (auto row = row_begin; row < row_end;) {
+            const auto& input = tensors[t];
+            const auto end = std::min(row_end, cumulative_dims[t + 1]);
+            const auto* input_ptr =
+                static_cast<const uint8_t*>(input.data_ptr());
+            const auto input_stride = input.stride(0) * element_size;
+            for (; row < end; ++row) {
+              std::memcpy(
+                  output_ptr + row * output_stride,
+                  input_ptr + (row - cumulative_dims[t]) * input_stride,
+                  row_bytes);
+            }
+            ++t;
+          }
+        });
+  } else {
+    const auto num_tensors = static_cast<int64_t>(tensors.size());
+    at::parallel_for(
+        0,
+        uncat_dim_size * num_tensors,
+        std::max<int64_t>(
+            1, at::internal::GRAIN_SIZE * num_tensors / total_cat_dim),
+        [&](int64_t block_begin, int64_t block_end) {
+          for (const auto block : c10::irange(block_begin, block_end)) {
+            const auto row = block / num_tensors;
+            const auto t = block % num_tensors;
+            const auto& input = tensors[t];
+            std::memcpy(
+                output_ptr + row * output_stride +
+                    cumulative_dims[t] * element_size,
+                static_cast<const uint8_t*>(input.data_ptr()) +
+                    row * input.stride(0) * element_size,
+                input.size(1) * element_size);
+          }
+        });
+  }
+  return output;
+}
+
+} // namespace
+
 Tensor merge_pooled_embeddings_cpu(
     std::vector<Tensor> pooled_embeddings,
-    int64_t /*uncat_dim_size*/,
+    int64_t uncat_dim_size,
     at::Device target_device,
     int64_t cat_dim = 1) {
+  if (can_cat_rows(pooled_embeddings, uncat_dim_size, cat_dim)) {
+    auto result = cat_rows_cpu(pooled_embeddings, uncat_dim_size, cat_dim);
+    if (!target_device.is_cpu()) {
+      result = result.to(target_device, true);
+    }
+    return result;
+  }
+
   auto cat_host_0 = [&](const std::vector<Tensor>& ts) {
     int64_t n = 0;
     for (auto& t : ts) {
@@ -55,6 +161,47 @@ Tensor sum_reduce_to_one_cpu(
   TORCH_CHECK(input_tensors.size() > 0);
   const auto input_0 = input_tensors[0];
   TENSOR_ON_CPU(input_0);
+
+  const bool same_layout = std::all_of(
+      input_tensors.begin(), input_tensors.end(), [&](const Tensor& t) {
+        return t.is_cpu() && t.is_contiguous() &&
+            t.scalar_type() == input_0.scalar_type() &&
+            t.sizes() == input_0.sizes();
+      });
+  if (same_layout && at::isFloatingType(input_0.scalar_type())) {
+    // Sum all the inputs in one pass over the output, accumulating the
+    // elements of each thread in the accumulation type
+    Tensor result = at::empty_like(input_0, at::MemoryFormat::Contiguous);
+    AT_DISPATCH_FLOATING_TYPES_AND2(
+        at::ScalarType::Half,
+        at::ScalarType::BFloat16,
+        input_0.scalar_type(),
+        "sum_reduce_to_one_cpu",
+        [&] {
+          using acc_t = at::acc_type<scalar_t, /*is_cuda=*/false>;
+          std::vector<const scalar_t*> input_ptrs;
+          input_ptrs.reserve(input_tensors.size());
+          for (const auto& t : input_tensors) {
+            input_ptrs.push_back(t.data_ptr<scalar_t>());
+          }
+          auto* result_ptr = result.data_ptr<scalar_t>();
+          at::parallel_for(
+              0,
+              result.numel(),
+              at::internal::GRAIN_SIZE,
+              [&](int64_t begin, int64_t end) {
+                for (const auto i : c10::irange(begin, end)) {
+                  acc_t sum = 0;
+                  for (const auto* input_ptr : input_ptrs) {
+                    sum += static_cast<acc_t>(input_ptr[i]);
+                  }
+                  result_ptr[i] = static_cast<scalar_t>(sum);
+                }
+              });
+        });
+    return result;
+  }
+
   Tensor result = at::zeros_like(input_0);
   for (auto i = 0UL; i < input_tensors.size(); i++) {
     TENSOR_ON_CPU(input_tensors[i]);
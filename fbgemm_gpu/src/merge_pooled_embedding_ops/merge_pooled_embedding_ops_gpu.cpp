@@ -34,12 +34,57 @@ struct DirectConnectedPeer {
   int32_t peer_transfers;
 };
 
+// The two-hop transfers are split in chunks of rows, the second hop of a
+// chunk overlapping the first hop of the next ones
+constexpr int64_t kTwoHopMinChunkBytes = 1 << 20;
+constexpr int64_t kTwoHopMaxChunks = 8;
+
 struct TwoHopTransferContainer {
   Tensor intermediate_tensor;
   uint64_t output_idx;
-  std::unique_ptr<at::cuda::CUDAEvent> transfer_cuda_event;
+  // Row boundaries of the chunks
+  std::vector<int64_t> chunk_rows;
+  // Completion of the first hop of each chunk
+  std::vector<at::cuda::CUDAEvent> transfer_cuda_events;
 };
 
+std::vector<int64_t> two_hop_chunk_rows(const Tensor& t) {
+  const int64_t rows = t.size(0);
+  const int64_t bytes = rows * t.size(1) * t.element_size();
+  const int64_t num_chunks = std::max<int64_t>(
+      1, std::min({rows, kTwoHopMaxChunks, bytes / kTwoHopMinChunkBytes}));
+  std::vector<int64_t> chunk_rows;
+  chunk_rows.reserve(num_chunks + 1);
+  for (const auto c : c10::irange(num_chunks + 1)) {
+    chunk_rows.push_back(rows * c / num_chunks);
+  }
+  return chunk_rows;
+}
+
+// Copies the rows [begin, end) of the 2D tensor src to dst
+void copy_rows_2d_async(
+    const Tensor& dst,
+    const Tensor& src,
+    int64_t begin,
+    int64_t end,
+    cudaStream_t stream) {
+  AT_CUDA_CHECK(cudaMemcpy2DAsync(
+      static_cast<char*>(dst.data_ptr()) +
+          begin * dst.stride(0) * dst.element_size(),
+      dst.stride(0) * dst.element_size(),
+      static_cast<const char*>(src.data_ptr()) +
+          begin * src.stride(0) * src.element_size(),
+      src.stride(0) * src.element_size(),
+      src.size(1) * src.element_size(),
+      end - begin,
+      cudaMemcpyDeviceToDevice,
+      stream));
+}
+
+void copy_2d_async(const Tensor& dst, const Tensor& src, cudaStream_t stream) {
+  copy_rows_2d_async(dst, src, 0, src.size(0), stream);
+}
+
 AdjacencyMatrix<Node> get_intermediate_node(
     const AdjacencyMatrix<Links>& links) {
   const auto world_size = at::cuda::getNumGPUs();
@@ -109,6 +154,12 @@ AdjacencyMatrix<Node> get_intermediate_node(
       }
     }
   }
+  if (fbgemm_gpu::has_nvswitch()) {
+    // Every pair of GPUs is connected through the NVSwitches, even if the
+    // links do not show it
+    LOG(INFO) << "Detected an NVSwitch configuration, copying directly";
+    return [](Node, Node) { return -1; };
+  }
   if (std::any_of(assignments.begin(), assignments.end(), [](Node n) {
         return n != -1;
       })) {
@@ -170,26 +221,29 @@ void all_to_one(
     auto intermediate_node =
         intermediate_nodes(src_device_id, target_device_index);
     if (intermediate_node != -1) {
+      auto chunk_rows = two_hop_chunk_rows(src);
+      const auto num_chunks = chunk_rows.size() - 1;
       two_hop_transfers.push_back(
           {.intermediate_tensor = at::empty(
                src.sizes(),
                src.options().device(at::Device(at::kCUDA, intermediate_node))),
            .output_idx = i,
-           .transfer_cuda_event =
-               std::make_unique<at::cuda::CUDAEvent>(cudaEventDisableTiming)});
-      auto& dst = two_hop_transfers.back().intermediate_tensor;
+           .chunk_rows = std::move(chunk_rows),
+           .transfer_cuda_events =
+               std::vector<at::cuda::CUDAEvent>(num_chunks)});
+      auto& transfer = two_hop_transfers.back();
+      auto& dst = transfer.intermediate_tensor;
       at::cuda::CUDAStream copy_stream =
           at::cuda::getCurrentCUDAStream(src_device_id);
-      AT_CUDA_CHECK(cudaMemcpy2DAsync(
-          dst.data_ptr(),
-          dst.stride(0) * dst.element_size(),
-          src.data_ptr(),
-          src.stride(0) * src.element_size(),
-          src.size(1) * src.element_size(),
-          src.size(0),
-          cudaMemcpyDeviceToDevice,
-          copy_stream));
-      two_hop_transfers.back().transfer_cuda_event->record(copy_stream);
+      for (const auto c : c10::irange(num_chunks)) {
+        copy_rows_2d_async(
+            dst,
+            src,
+            transfer.chunk_rows[c],
+            transfer.chunk_rows[c + 1],
+            copy_stream);
+        transfer.transfer_cuda_events[c].record(copy_stream);
+      }
       is_two_hop_transfer.push_back(true);
     } else {
       is_two_hop_transfer.push_back(false);
@@ -241,15 +295,7 @@ void all_to_one(
 
       auto& dst = output_tensors[i];
       // on source device, launch memcpy.
-      AT_CUDA_CHECK(cudaMemcpy2DAsync(
-          dst.data_ptr(),
-          dst.stride(0) * dst.element_size(),
-          src.data_ptr(),
-          src.stride(0) * src.element_size(),
-          src.size(1) * src.element_size(),
-          src.size(0),
-          cudaMemcpyDeviceToDevice,
-          copy_stream));
+      copy_2d_async(dst, src, copy_stream);
     }
   }
 
@@ -267,8 +313,6 @@ void all_to_one(
     // intermediate rank stream
     at::cuda::CUDAStream copy_stream =
         at::cuda::getCurrentCUDAStream(src_device_id);
-    // wait on first hop transfer
-    two_hop_transfer.transfer_cuda_event->block(copy_stream);
     // synchronize with target rank
     auto& dst_ready = copy_begin_events[target_device_index][src_device_id];
     device_guard.set_device(target_device);
@@ -278,16 +322,14 @@ void all_to_one(
     // originating tensor output position
     const auto output_index = two_hop_transfer.output_idx;
     auto& dst = output_tensors.at(output_index);
-    // on source device, launch memcpy.
-    AT_CUDA_CHECK(cudaMemcpy2DAsync(
-        dst.data_ptr(),
-        dst.stride(0) * dst.element_size(),
-        src.data_ptr(),
-        src.stride(0) * src.element_size(),
-        src.size(1) * src.element_size(),
-        src.size(0),
-        cudaMemcpyDeviceToDevice,
-        copy_stream));
+    const auto& chunk_rows = two_hop_transfer.chunk_rows;
+    for (const auto c : c10::irange(chunk_rows.size() - 1)) {
+      // wait on first hop transfer of the chunk
+      two_hop_transfer.transfer_cuda_events[c].block(copy_stream);
+      // on source device, launch memcpy.
+      copy_rows_2d_async(
+          dst, src, chunk_rows[c], chunk_rows[c + 1], copy_stream);
+    }
   }
 
   // Do the same-GPU cases.
@@ -299,15 +341,7 @@ void all_to_one(
         // single device memcpy, not that src_device == dst_device.
         at::cuda::CUDAStream copy_stream =
             at::cuda::getCurrentCUDAStream(target_device_index);
-        AT_CUDA_CHECK(cudaMemcpy2DAsync(
-            dst.data_ptr(),
-            dst.stride(0) * dst.element_size(),
-            src.data_ptr(),
-            src.stride(0) * src.element_size(),
-            src.size(1) * src.element_size(),
-            src.size(0),
-            cudaMemcpyDeviceToDevice,
-            copy_stream));
+        copy_2d_async(dst, src, copy_stream);
       }
     }
   }
@@ -378,6 +412,11 @@ Tensor sum_reduce_to_one(
   static auto intermediate_nodes =
       get_intermediate_node(fbgemm_gpu::get_nvlink_matrix());
   std::vector<Tensor> copied_tensors(input_tensors.size());
+  // Row boundaries and first hop completion of the chunks of the copied
+  // tensors, which are reduced at the intermediate GPUs as they arrive
+  std::vector<std::vector<int64_t>> chunk_rows(input_tensors.size());
+  std::vector<std::vector<at::cuda::CUDAEvent>> chunk_events(
+      input_tensors.size());
   for (const auto i : c10::irange(input_tensors.size())) {
     auto& src = input_tensors[i];
     if (!src.has_storage()) {
@@ -398,20 +437,21 @@ Tensor sum_reduce_to_one(
     // creating a temp tensor, dst.
 
     at::cuda::CUDAGuard device_guard(src.device());
-    // on source device, launch memcpy.
-    AT_CUDA_CHECK(cudaMemcpy2DAsync(
-        dst.data_ptr(),
-        dst.stride(0) * dst.element_size(),
-        src.data_ptr(),
-        src.stride(0) * src.element_size(),
-        src.size(1) * src.element_size(),
-        src.size(0),
-        cudaMemcpyDeviceToDevice,
-        at::cuda::getCurrentCUDAStream(src.get_device())));
+    at::cuda::CUDAStream copy_stream =
+        at::cuda::getCurrentCUDAStream(src.get_device());
+    chunk_rows[i] = two_hop_chunk_rows(src);
+    chunk_events[i] =
+        std::vector<at::cuda::CUDAEvent>(chunk_rows[i].size() - 1);
+    for (const auto c : c10::irange(chunk_rows[i].size() - 1)) {
+      // on source device, launch memcpy.
+      copy_rows_2d_async(
+          dst, src, chunk_rows[i][c], chunk_rows[i][c + 1], copy_stream);
+      chunk_events[i][c].record(copy_stream);
+    }
     copied_tensors[i] = dst;
   }
 
-  // Wait for cross-device copies to complete, then reduce
+  // Reduce the chunks as their copies complete
   for (const auto device_id : c10::irange(num_gpus)) {
     auto intermediate_node = intermediate_nodes(device_id, target_device_index);
     if (intermediate_node == -1) {
@@ -420,16 +460,9 @@ Tensor sum_reduce_to_one(
     auto intermediate_device = at::Device(at::kCUDA, intermediate_node);
 
     auto src_device = at::Device(at::kCUDA, device_id);
-    // Still on src_device, record stream event
-    at::cuda::CUDAGuard device_guard(src_device);
-    at::cuda::CUDAStream copy_stream =
-        at::cuda::getCurrentCUDAStream(device_id);
-
-    auto& src_ready = copy_completion_events[target_device_index][device_id];
-    src_ready.record(copy_stream);
-
-    device_guard.set_device(intermediate_device);
-    src_ready.block(at::cuda::getCurrentCUDAStream(intermediate_node));
+    at::cuda::CUDAGuard device_guard(intermediate_device);
+    at::cuda::CUDAStream intermediate_stream =
+        at::cuda::getCurrentCUDAStream(intermediate_node);
 
     // Find any tensor in the intermediate GPU to reduce to.
     Tensor ten_at_intermediate_node;
@@ -449,11 +482,18 @@ Tensor sum_reduce_to_one(
         continue;
       }
       if (ten_at_intermediate_node.has_storage()) {
-        ten_at_intermediate_node.add_(ten);
+        for (const auto c : c10::irange(chunk_events[i].size())) {
+          chunk_events[i][c].block(intermediate_stream);
+          const auto begin = chunk_rows[i][c];
+          const auto rows = chunk_rows[i][c + 1] - begin;
+          ten_at_intermediate_node.narrow(0, begin, rows)
+              .add_(ten.narrow(0, begin, rows));
+        }
         input_tensors[i] = Tensor();
       } else {
         // No tensor to reduce to, so we just replace input_tensors[i] with
         // the version copied to the intermediate GPU.
+        chunk_events[i].back().block(intermediate_stream);
         input_tensors[i] = ten;
       }
     }
@@ -469,15 +509,7 @@ Tensor sum_reduce_to_one(
     Tensor dst = at::empty_like(src, target_device);
 
     at::cuda::CUDAGuard device_guard(src.device());
-    AT_CUDA_CHECK(cudaMemcpy2DAsync(
-        dst.data_ptr(),
-        dst.stride(0) * dst.element_size(),
-        src.data_ptr(),
-        src.stride(0) * src.element_size(),
-        src.size(1) * src.element_size(),
-        src.size(0),
-        cudaMemcpyDeviceToDevice,
-        at::cuda::getCurrentCUDAStream(src.get_device())));
+    copy_2d_async(dst, src, at::cuda::getCurrentCUDAStream(src.get_device()));
     copied_tensors[i] = dst;
   }
 
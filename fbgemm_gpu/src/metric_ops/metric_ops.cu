@@ -12,9 +12,11 @@
 #include <math.h>
 #include <ATen/cuda/Atomic.cuh>
 #include <algorithm>
+#include <limits>
 
 #include "fbgemm_gpu/dispatch_macros.h"
 #include "fbgemm_gpu/fbgemm_cuda_utils.cuh"
+#include "fbgemm_gpu/sparse_ops_utils.h"
 #include "metric_ops.h"
 
 constexpr int MAX_ENTRIES_PER_BLOCK = 512;
@@ -293,4 +295,116 @@ at::Tensor batch_auc(
   return output;
 }
 
+constexpr int AUC_HISTOGRAM_MAX_GRID_X = 1024;
+// The per-block copy of the histogram stays within the smallest shared memory
+// size of the supported devices; larger histograms are updated in place
+constexpr int64_t AUC_HISTOGRAM_MAX_SMEM_BYTES = 32 * 1024;
+
+template <typename label_t, typename weight_t, bool USE_SMEM>
+__global__ void auc_histogram_update_kernel(
+    double* histogram,
+    const weight_t* predictions,
+    const label_t* labels,
+    const weight_t* weights,
+    const int64_t num_entries,
+    const int num_bins) {
+  extern __shared__ double smem_histogram[];
+
+  const int task_id = blockIdx.y;
+  double* task_histogram = histogram + task_id * 2 * num_bins;
+  double* local_histogram = USE_SMEM ? smem_histogram : task_histogram;
+
+  if (USE_SMEM) {
+    for (int i = threadIdx.x; i < 2 * num_bins; i += blockDim.x) {
+      local_histogram[i] = 0.0;
+    }
+    __syncthreads();
+  }
+
+  const int64_t offset = task_id * num_entries;
+  for (int64_t i = blockIdx.x * blockDim.x + threadIdx.x; i < num_entries;
+       i += gridDim.x * blockDim.x) {
+    const double prediction =
+        fmin(fmax(static_cast<double>(predictions[offset + i]), 0.0), 1.0);
+    const int bin =
+        min(static_cast<int>(prediction * num_bins), num_bins - 1);
+    const double weight = weights[offset + i];
+    const double label = labels[offset + i];
+    gpuAtomicAdd(&local_histogram[bin], weight * (1.0 - label));
+    gpuAtomicAdd(&local_histogram[num_bins + bin], weight * label);
+  }
+
+  if (USE_SMEM) {
+    __syncthreads();
+    for (int i = threadIdx.x; i < 2 * num_bins; i += blockDim.x) {
+      const double value = local_histogram[i];
+      if (value != 0.0) {
+        gpuAtomicAdd(&task_histogram[i], value);
+      }
+    }
+  }
+}
+
+void auc_histogram_update(
+    at::Tensor& histogram,
+    const at::Tensor& predictions,
+    const at::Tensor& labels,
+    const at::Tensor& weights) {
+  TENSORS_ON_SAME_CUDA_GPU_IF_NOT_OPTIONAL(
+      histogram, predictions, labels, weights);
+  check_auc_histogram_inputs(histogram, predictions, labels, weights);
+
+  const auto num_tasks = predictions.size(0);
+  const auto num_entries = predictions.size(1);
+  const auto num_bins = histogram.size(2);
+  if (num_tasks == 0 || num_entries == 0) {
+    return;
+  }
+  TORCH_CHECK(num_bins <= std::numeric_limits<int>::max())
+
+  CUDA_DEVICE_GUARD(histogram);
+
+  const auto predictions_contig = predictions.contiguous();
+  const auto labels_contig = labels.contiguous();
+  const auto weights_contig = weights.contiguous();
+
+  const int64_t smem_bytes = 2 * num_bins * sizeof(double);
+  const bool use_smem = smem_bytes <= AUC_HISTOGRAM_MAX_SMEM_BYTES;
+  const dim3 grid_size(
+      std::min<int64_t>(
+          at::ceil_div<int64_t>(num_entries, NUM_THREADS_PER_BLOCK),
+          AUC_HISTOGRAM_MAX_GRID_X),
+      num_tasks);
+
+#define LAUNCH_AUC_HISTOGRAM_KERNEL(use_smem)                         \
+  auc_histogram_update_kernel<label_t, weight_t, use_smem>            \
+      <<<grid_size,                                                   \
+         dim3(NUM_THREADS_PER_BLOCK),                                 \
+         use_smem ? smem_bytes : 0,                                   \
+         at::cuda::getCurrentCUDAStream()>>>(                         \
+          histogram.data_ptr<double>(),                               \
+          predictions_contig.data_ptr<weight_t>(),                    \
+          labels_contig.data_ptr<label_t>(),                          \
+          weights_contig.data_ptr<weight_t>(),                        \
+          num_entries,                                                \
+          static_cast<int>(num_bins));                                \
+  C10_CUDA_KERNEL_LAUNCH_CHECK();
+
+  FBGEMM_DISPATCH_ALL_TYPES(
+      labels.scalar_type(), "auc_histogram_update_1", [&] {
+        using label_t = scalar_t;
+        FBGEMM_DISPATCH_FLOAT_AND_HALF(
+            predictions.scalar_type(), "auc_histogram_update_2", [&] {
+              using weight_t = scalar_t;
+              if (use_smem) {
+                LAUNCH_AUC_HISTOGRAM_KERNEL(true)
+              } else {
+                LAUNCH_AUC_HISTOGRAM_KERNEL(false)
+              }
+            });
+      });
+
+#undef LAUNCH_AUC_HISTOGRAM_KERNEL
+}
+
 } // namespace fbgemm_gpu
@@ -16,4 +16,49 @@ at::Tensor batch_auc(
     const at::Tensor& labels,
     const at::Tensor& weights);
 
+at::Tensor batch_auc_cpu(
+    const int64_t num_tasks,
+    const at::Tensor& indices,
+    const at::Tensor& labels,
+    const at::Tensor& weights);
+
+// Returns the int64 indices that sort each row of the 2D predictions in
+// descending order, with ties in input order, for batch_auc
+at::Tensor batch_auc_argsort_cpu(const at::Tensor& predictions);
+
+// Accumulates the weighted negatives and positives of each task into the
+// [num_tasks, 2, num_bins] float64 histogram, by bins of the [0, 1] range of
+// the predictions. The histograms of the batches and of the ranks add up to
+// the histogram of the whole set, which gives its AUC in O(num_bins) memory.
+void auc_histogram_update(
+    at::Tensor& histogram,
+    const at::Tensor& predictions,
+    const at::Tensor& labels,
+    const at::Tensor& weights);
+
+void auc_histogram_update_cpu(
+    at::Tensor& histogram,
+    const at::Tensor& predictions,
+    const at::Tensor& labels,
+    const at::Tensor& weights);
+
+// Checks the shapes and dtypes of the auc_histogram_update inputs
+inline void check_auc_histogram_inputs(
+    const at::Tensor& histogram,
+    const at::Tensor& predictions,
+    const at::Tensor& labels,
+    const at::Tensor& weights) {
+  TORCH_CHECK(
+      histogram.dim() == 3 && histogram.size(1) == 2 &&
+          histogram.size(2) > 0 && histogram.is_contiguous(),
+      "histogram should be a contiguous [num_tasks, 2, num_bins] tensor")
+  TORCH_CHECK(histogram.scalar_type() == at::kDouble)
+  TORCH_CHECK(predictions.dim() == 2)
+  TORCH_CHECK(predictions.size(0) == histogram.size(0))
+  TORCH_CHECK(
+      labels.sizes() == predictions.sizes() &&
+      weights.sizes() == predictions.sizes())
+  TORCH_CHECK(weights.scalar_type() == predictions.scalar_type())
+}
+
 } // namespace fbgemm_gpu
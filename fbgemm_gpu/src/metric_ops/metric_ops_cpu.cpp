@@ -0,0 +1,351 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <ATen/ATen.h>
+#include <ATen/AccumulateType.h>
+#include <ATen/Parallel.h>
+#include <ATen/core/op_registration/op_registration.h>
+#include <c10/util/irange.h>
+#include <torch/library.h>
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "fbgemm/Utils.h"
+#include "fbgemm_gpu/dispatch_macros.h"
+#include "fbgemm_gpu/sparse_ops_utils.h"
+#include "metric_ops.h"
+
+namespace fbgemm_gpu {
+
+namespace {
+
+// Number of entries of a task that are scanned by one chunk of batch_auc_cpu
+constexpr int64_t AUC_CPU_CHUNK_SIZE = 16384;
+
+// Maps a prediction to an integer key whose ascending order is the
+// descending order of the predictions, so that radix_sort_parallel (which
+// is stable and ascending) yields the indices of torch.sort(descending=True)
+// with ties kept in input order. Float and half keys fit in 32 bits.
+template <typename scalar_t>
+inline int64_t descending_sort_key(const scalar_t value) {
+  const float f = static_cast<float>(value);
+  uint32_t bits;
+  std::memcpy(&bits, &f, sizeof(bits));
+  const uint32_t ascending =
+      (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+  return static_cast<int64_t>(~ascending);
+}
+
+template <>
+inline int64_t descending_sort_key<double>(const double value) {
+  uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  const uint64_t ascending =
+      (bits & 0x8000000000000000ull) ? ~bits : (bits | 0x8000000000000000ull);
+  // Signed keys are sorted with the sign bit pass of radix_sort_parallel
+  return ~static_cast<int64_t>(ascending ^ 0x8000000000000000ull);
+}
+
+void run_on_aten_thread_pool(
+    int num_tasks,
+    const std::function<void(int)>& task) {
+  at::parallel_for(0, num_tasks, 1, [&](int64_t begin, int64_t end) {
+    for (const auto t : c10::irange(begin, end)) {
+      task(t);
+    }
+  });
+}
+
+} // namespace
+
+at::Tensor batch_auc_argsort_cpu(const at::Tensor& predictions) {
+  TENSOR_ON_CPU(predictions);
+  TORCH_CHECK(predictions.dim() == 2)
+
+  const auto num_tasks = predictions.size(0);
+  const auto num_entries = predictions.size(1);
+  auto sorted_indices = at::empty(
+      {num_tasks, num_entries}, predictions.options().dtype(at::kLong));
+  if (num_tasks == 0 || num_entries == 0) {
+    return sorted_indices;
+  }
+
+  const auto predictions_contig = predictions.expect_contiguous();
+  auto* sorted_indices_ptr = sorted_indices.data_ptr<int64_t>();
+  // Sort the tasks concurrently when there are enough of them, otherwise
+  // sort each task with all threads
+  const bool parallel_tasks = num_tasks >= at::get_num_threads();
+
+  AT_DISPATCH_FLOATING_TYPES_AND2(
+      at::ScalarType::Half,
+      at::ScalarType::BFloat16,
+      predictions.scalar_type(),
+      "batch_auc_argsort_cpu",
+      [&] {
+        const auto* predictions_ptr = predictions_contig->data_ptr<scalar_t>();
+        const bool is_double = std::is_same<scalar_t, double>::value;
+        const int64_t max_value =
+            is_double ? std::numeric_limits<int64_t>::max() : UINT32_MAX;
+
+        const auto sort_task = [&](const int64_t t) {
+          std::vector<int64_t> keys(num_entries);
+          std::vector<int64_t> values(num_entries);
+          std::vector<int64_t> tmp_keys(num_entries);
+          auto* tmp_values = sorted_indices_ptr + t * num_entries;
+          const auto* task_predictions = predictions_ptr + t * num_entries;
+          for (const auto i : c10::irange(num_entries)) {
+            keys[i] = descending_sort_key(task_predictions[i]);
+            values[i] = i;
+          }
+          const auto sorted = fbgemm::radix_sort_parallel(
+              keys.data(),
+              values.data(),
+              tmp_keys.data(),
+              tmp_values,
+              num_entries,
+              max_value,
+              /*maybe_with_neg_vals=*/is_double,
+              parallel_tasks ? 1 : at::get_num_threads(),
+              parallel_tasks ? nullptr : run_on_aten_thread_pool);
+          if (sorted.second != tmp_values) {
+            std::copy_n(sorted.second, num_entries, tmp_values);
+          }
+        };
+
+        if (parallel_tasks) {
+          at::parallel_for(0, num_tasks, 1, [&](int64_t begin, int64_t end) {
+            for (const auto t : c10::irange(begin, end)) {
+              sort_task(t);
+            }
+          });
+        } else {
+          for (const auto t : c10::irange(num_tasks)) {
+            sort_task(t);
+          }
+        }
+      });
+
+  return sorted_indices;
+}
+
+at::Tensor batch_auc_cpu(
+    const int64_t num_tasks,
+    const at::Tensor& indices,
+    const at::Tensor& labels,
+    const at::Tensor& weights) {
+  TENSOR_ON_CPU(indices);
+  TENSOR_ON_CPU(labels);
+  TENSOR_ON_CPU(weights);
+
+  const auto dim = indices.dim();
+  const auto num_entries = indices.size(dim - 1);
+  const auto num_entries_all_tasks = indices.numel();
+
+  TORCH_CHECK(labels.dim() == dim && weights.dim() == dim)
+  TORCH_CHECK(num_entries_all_tasks == num_entries * num_tasks)
+  TORCH_CHECK(
+      labels.size(dim - 1) == num_entries &&
+      weights.size(dim - 1) == num_entries &&
+      labels.numel() == num_entries_all_tasks &&
+      weights.numel() == num_entries_all_tasks)
+
+  const auto output_options = weights.scalar_type() == at::ScalarType::Half
+      ? weights.options().dtype(at::kFloat)
+      : weights.options();
+  at::Tensor output = at::empty({num_tasks}, output_options);
+  if (num_tasks == 0) {
+    return output;
+  }
+  if (num_entries == 0) {
+    return output.fill_(0.5);
+  }
+
+  const auto indices_contig = indices.expect_contiguous();
+  const auto labels_contig = labels.expect_contiguous();
+  const auto weights_contig = weights.expect_contiguous();
+
+  // Each task is scanned by chunks, as the blocks of the CUDA kernel: the
+  // chunk sums give the prefix of every chunk, from which the chunks
+  // compute their part of the trapezoidal rule independently
+  const int64_t num_chunks =
+      (num_entries + AUC_CPU_CHUNK_SIZE - 1) / AUC_CPU_CHUNK_SIZE;
+  const int64_t num_work_items = num_tasks * num_chunks;
+
+  AT_DISPATCH_INDEX_TYPES(indices.scalar_type(), "batch_auc_cpu_1", [&] {
+    FBGEMM_DISPATCH_ALL_TYPES(labels.scalar_type(), "batch_auc_cpu_2", [&] {
+      using label_t = scalar_t;
+      FBGEMM_DISPATCH_FLOAT_AND_HALF(
+          weights.scalar_type(), "batch_auc_cpu_3", [&] {
+            // Use is_cuda=true to accumulate as the CUDA kernel does
+            using acc_t = at::acc_type<scalar_t, true>;
+            const auto* indices_ptr = indices_contig->data_ptr<index_t>();
+            const auto* labels_ptr = labels_contig->data_ptr<label_t>();
+            const auto* weights_ptr = weights_contig->data_ptr<scalar_t>();
+
+            // [fp, tp] of every (task, chunk): first the chunk sums, then
+            // the exclusive prefix of the chunk within its task
+            std::vector<acc_t> chunk_prefix(num_work_items * 2);
+            std::vector<acc_t> chunk_area(num_work_items);
+
+            const auto for_each_entry = [&](const int64_t work_item,
+                                            const auto& f) {
+              const auto t = work_item / num_chunks;
+              const auto begin = (work_item % num_chunks) * AUC_CPU_CHUNK_SIZE;
+              const auto end =
+                  std::min(begin + AUC_CPU_CHUNK_SIZE, num_entries);
+              const auto offset = t * num_entries;
+              for (const auto i : c10::irange(begin, end)) {
+                const auto idx = indices_ptr[offset + i];
+                const acc_t weight = weights_ptr[offset + idx];
+                const label_t label = labels_ptr[offset + idx];
+                f(i, static_cast<acc_t>(weight * (1.0 - label)),
+                  static_cast<acc_t>(weight * label));
+              }
+            };
+
+            at::parallel_for(
+                0, num_work_items, 1, [&](int64_t begin, int64_t end) {
+                  for (const auto w : c10::irange(begin, end)) {
+                    acc_t fp = 0, tp = 0;
+                    for_each_entry(w, [&](int64_t, acc_t dfp, acc_t dtp) {
+                      fp += dfp;
+                      tp += dtp;
+                    });
+                    chunk_prefix[2 * w] = fp;
+                    chunk_prefix[2 * w + 1] = tp;
+                  }
+                });
+
+            std::vector<acc_t> task_totals(num_tasks * 2);
+            for (const auto t : c10::irange(num_tasks)) {
+              acc_t fp = 0, tp = 0;
+              for (const auto c : c10::irange(num_chunks)) {
+                const auto w = t * num_chunks + c;
+                const acc_t chunk_fp = chunk_prefix[2 * w];
+                const acc_t chunk_tp = chunk_prefix[2 * w + 1];
+                chunk_prefix[2 * w] = fp;
+                chunk_prefix[2 * w + 1] = tp;
+                fp += chunk_fp;
+                tp += chunk_tp;
+              }
+              task_totals[2 * t] = fp;
+              task_totals[2 * t + 1] = tp;
+            }
+
+            at::parallel_for(
+                0, num_work_items, 1, [&](int64_t begin, int64_t end) {
+                  for (const auto w : c10::irange(begin, end)) {
+                    acc_t fp = chunk_prefix[2 * w];
+                    acc_t tp = chunk_prefix[2 * w + 1];
+                    acc_t area = 0;
+                    for_each_entry(
+                        w, [&](int64_t i, acc_t dfp, acc_t dtp) {
+                          const acc_t prev_fp = fp;
+                          const acc_t prev_tp = tp;
+                          fp += dfp;
+                          tp += dtp;
+                          // The curve starts at the first entry
+                          if (i > 0) {
+                            area += 0.5 * (fp - prev_fp) * (tp + prev_tp);
+                          }
+                        });
+                    chunk_area[w] = area;
+                  }
+                });
+
+            auto* output_ptr = output.data_ptr<acc_t>();
+            for (const auto t : c10::irange(num_tasks)) {
+              const acc_t last_fp = task_totals[2 * t];
+              const acc_t last_tp = task_totals[2 * t + 1];
+              acc_t area = 0;
+              for (const auto c : c10::irange(num_chunks)) {
+                area += chunk_area[t * num_chunks + c];
+              }
+              output_ptr[t] = last_fp * last_tp == 0.0
+                  ? 0.5
+                  : area / last_fp / last_tp;
+            }
+          });
+    });
+  });
+
+  return output;
+}
+
+void auc_histogram_update_cpu(
+    at::Tensor& histogram,
+    const at::Tensor& predictions,
+    const at::Tensor& labels,
+    const at::Tensor& weights) {
+  TENSORS_ON_SAME_DEVICE(histogram, predictions);
+  TENSORS_ON_SAME_DEVICE(histogram, labels);
+  TENSORS_ON_SAME_DEVICE(histogram, weights);
+  check_auc_histogram_inputs(histogram, predictions, labels, weights);
+
+  const auto num_tasks = predictions.size(0);
+  const auto num_entries = predictions.size(1);
+  const auto num_bins = histogram.size(2);
+  const auto predictions_contig = predictions.expect_contiguous();
+  const auto labels_contig = labels.expect_contiguous();
+  const auto weights_contig = weights.expect_contiguous();
+  auto* histogram_ptr = histogram.data_ptr<double>();
+
+  FBGEMM_DISPATCH_FLOAT_AND_HALF(
+      predictions.scalar_type(), "auc_histogram_update_cpu_1", [&] {
+        using weight_t = scalar_t;
+        const auto* predictions_ptr = predictions_contig->data_ptr<weight_t>();
+        const auto* weights_ptr = weights_contig->data_ptr<weight_t>();
+        FBGEMM_DISPATCH_ALL_TYPES(
+            labels.scalar_type(), "auc_histogram_update_cpu_2", [&] {
+              const auto* labels_ptr = labels_contig->data_ptr<scalar_t>();
+              // Tasks go to separate threads so that each histogram is only
+              // updated by one thread
+              at::parallel_for(
+                  0, num_tasks, 1, [&](int64_t task_begin, int64_t task_end) {
+                    for (const auto t : c10::irange(task_begin, task_end)) {
+                      auto* negatives = histogram_ptr + t * 2 * num_bins;
+                      auto* positives = negatives + num_bins;
+                      const auto offset = t * num_entries;
+                      for (const auto i : c10::irange(num_entries)) {
+                        const double prediction = std::min(
+                            std::max(
+                                static_cast<double>(
+                                    predictions_ptr[offset + i]),
+                                0.0),
+                            1.0);
+                        const auto bin = std::min<int64_t>(
+                            static_cast<int64_t>(prediction * num_bins),
+                            num_bins - 1);
+                        const double weight = weights_ptr[offset + i];
+                        const double label = labels_ptr[offset + i];
+                        negatives[bin] += weight * (1.0 - label);
+                        positives[bin] += weight * label;
+                      }
+                    }
+                  });
+            });
+      });
+}
+
+} // namespace fbgemm_gpu
+
+TORCH_LIBRARY_FRAGMENT(fbgemm, m) {
+  m.def(
+      "batch_auc(int num_tasks, Tensor indices, Tensor laebls, Tensor weights) -> Tensor");
+  m.def("batch_auc_argsort(Tensor predictions) -> Tensor");
+  m.def(
+      "auc_histogram_update(Tensor(a!) histogram, Tensor predictions, Tensor labels, Tensor weights) -> ()");
+  DISPATCH_TO_CPU("batch_auc", fbgemm_gpu::batch_auc_cpu);
+  DISPATCH_TO_CPU("batch_auc_argsort", fbgemm_gpu::batch_auc_argsort_cpu);
+  DISPATCH_TO_CPU(
+      "auc_histogram_update", fbgemm_gpu::auc_histogram_update_cpu);
+}
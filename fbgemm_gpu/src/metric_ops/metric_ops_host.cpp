@@ -14,13 +14,9 @@
 
 namespace fbgemm_gpu {
 
-TORCH_LIBRARY_FRAGMENT(fbgemm, m) {
-  m.def(
-      "batch_auc(int num_tasks, Tensor indices, Tensor laebls, Tensor weights) -> Tensor");
-}
-
 TORCH_LIBRARY_IMPL(fbgemm, CUDA, m) {
   DISPATCH_TO_CUDA("batch_auc", fbgemm_gpu::batch_auc);
+  DISPATCH_TO_CUDA("auc_histogram_update", fbgemm_gpu::auc_histogram_update);
 }
 
 } // namespace fbgemm_gpu
@@ -6,7 +6,9 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <ATen/Parallel.h>
 #include <c10/util/irange.h>
+#include <cstring>
 #include <vector>
 #include "fbgemm_gpu/dispatch_macros.h"
 #include "fbgemm_gpu/permute_pooled_embedding_ops.h"
@@ -15,34 +17,146 @@ using Tensor = at::Tensor;
 
 namespace fbgemm_gpu {
 
-Tensor permute_pooled_embs_cpu_impl(
-    const Tensor& pooled_embs, // [B_local][Sum_T_global(D)]
+namespace {
+
+// A run of the output columns of every row copied from contiguous input
+// columns; consecutive permuted features merge into one run
+struct PermutedColumnRun {
+  int64_t input_offset;
+  int64_t output_offset;
+  int64_t length;
+};
+
+std::vector<PermutedColumnRun> permuted_column_runs(
     const Tensor& offset_dim_list,
     const Tensor& permute_list,
-    const Tensor& inv_offset_dim_list,
-    const Tensor& inv_permute_list,
-    const bool& allow_duplicates) {
+    const bool allow_duplicates) {
   TORCH_CHECK(
       offset_dim_list.scalar_type() == at::ScalarType::Long,
       "offset_dim_list needs to have long/int64 type")
   TORCH_CHECK(
       permute_list.scalar_type() == at::ScalarType::Long,
       "permute_list needs to have long/int64 type")
-  auto permute = permute_list.data_ptr<int64_t>();
+  const auto offset_dim_contig = offset_dim_list.expect_contiguous();
+  const auto permute_contig = permute_list.expect_contiguous();
+  const auto* offset_dim = offset_dim_contig->data_ptr<int64_t>();
+  const auto* permute = permute_contig->data_ptr<int64_t>();
   const auto n = permute_list.numel();
-  const auto dims_size = allow_duplicates ? offset_dim_list.numel() : n;
-  std::vector<int64_t> dims;
-  dims.reserve(dims_size - 1);
-  for (const auto i : c10::irange(1, dims_size)) {
-    dims.push_back(offset_dim_list[i].item<int64_t>());
-  }
-  auto ts = pooled_embs.tensor_split(dims, 1);
-  std::vector<Tensor> permuted_ts;
-  permuted_ts.reserve(n);
+  const auto num_features = allow_duplicates ? offset_dim_list.numel() - 1 : n;
+  TORCH_CHECK(offset_dim_list.numel() >= num_features + 1);
+
+  std::vector<PermutedColumnRun> runs;
+  int64_t output_offset = 0;
   for (const auto i : c10::irange(n)) {
-    permuted_ts.push_back(ts[permute[i]]);
+    const auto feature = permute[i];
+    TORCH_CHECK(
+        feature >= 0 && feature < num_features,
+        "permute_list[",
+        i,
+        "] = ",
+        feature,
+        " is out of range [0, ",
+        num_features,
+        ")");
+    const auto length = offset_dim[feature + 1] - offset_dim[feature];
+    if (!runs.empty() &&
+        runs.back().input_offset + runs.back().length ==
+            offset_dim[feature]) {
+      runs.back().length += length;
+    } else if (length > 0) {
+      runs.push_back({offset_dim[feature], output_offset, length});
+    }
+    output_offset += length;
+  }
+  return runs;
+}
+
+int64_t permuted_columns(const std::vector<PermutedColumnRun>& runs) {
+  return runs.empty() ? 0 : runs.back().output_offset + runs.back().length;
+}
+
+// Copies every run of every row with a memcpy, in parallel over the (row,
+// run) blocks
+void permute_pooled_embs_cpu_kernel(
+    const Tensor& pooled_embs,
+    const std::vector<PermutedColumnRun>& runs,
+    Tensor& output) {
+  const auto B = pooled_embs.size(0);
+  const auto num_runs = static_cast<int64_t>(runs.size());
+  if (B == 0 || num_runs == 0) {
+    return;
   }
-  return at::cat(permuted_ts, 1);
+  const auto input = pooled_embs.stride(1) == 1 ? pooled_embs
+                                                : pooled_embs.contiguous();
+  const auto element_size = input.element_size();
+  const auto* input_ptr = static_cast<const char*>(input.data_ptr());
+  auto* output_ptr = static_cast<char*>(output.data_ptr());
+  const auto input_stride = input.stride(0) * element_size;
+  const auto output_stride = output.stride(0) * element_size;
+  const auto row_length = permuted_columns(runs);
+
+  at::parallel_for(
+      0,
+      B * num_runs,
+      std::max<int64_t>(
+          1,
+          at::internal::GRAIN_SIZE * num_runs /
+              std::max<int64_t>(row_length, 1)),
+      [&](int64_t block_begin, int64_t block_end) {
+        for (const auto block : c10::irange(block_begin, block_end)) {
+          const auto b = block / num_runs;
+          const auto& run = runs[block % num_runs];
+          std::memcpy(
+              output_ptr + b * output_stride + run.output_offset * element_size,
+              input_ptr + b * input_stride + run.input_offset * element_size,
+              run.length * element_size);
+        }
+      });
+}
+
+} // namespace
+
+Tensor permute_pooled_embs_cpu_impl(
+    const Tensor& pooled_embs, // [B_local][Sum_T_global(D)]
+    const Tensor& offset_dim_list,
+    const Tensor& permute_list,
+    const Tensor& /* inv_offset_dim_list */,
+    const Tensor& /* inv_permute_list */,
+    const bool& allow_duplicates) {
+  TENSOR_NDIM_EQUALS(pooled_embs, 2);
+  const auto runs =
+      permuted_column_runs(offset_dim_list, permute_list, allow_duplicates);
+  auto output = at::empty(
+      {pooled_embs.size(0), permuted_columns(runs)}, pooled_embs.options());
+  permute_pooled_embs_cpu_kernel(pooled_embs, runs, output);
+  return output;
+}
+
+///@ingroup permute-pooled-embs-cpu
+void permute_pooled_embs_cpu_out(
+    const Tensor& pooled_embs, // [B_local][Sum_T_global(D)]
+    const Tensor& offset_dim_list,
+    const Tensor& permute_list,
+    Tensor& output,
+    const bool allow_duplicates) {
+  TENSOR_NDIM_EQUALS(pooled_embs, 2);
+  TENSOR_NDIM_EQUALS(output, 2);
+  TENSORS_ON_SAME_DEVICE(pooled_embs, output);
+  TORCH_CHECK(
+      output.scalar_type() == pooled_embs.scalar_type(),
+      "output needs to have the type of pooled_embs");
+  TORCH_CHECK(output.stride(1) == 1, "the rows of output must be contiguous");
+  const auto runs =
+      permuted_column_runs(offset_dim_list, permute_list, allow_duplicates);
+  TORCH_CHECK(
+      output.size(0) == pooled_embs.size(0) &&
+          output.size(1) == permuted_columns(runs),
+      "output needs the shape [",
+      pooled_embs.size(0),
+      ", ",
+      permuted_columns(runs),
+      "]");
+  permute_pooled_embs_cpu_kernel(pooled_embs, runs, output);
 }
 
 at::Tensor permute_pooled_embs_cpu(
@@ -133,6 +247,13 @@ at::Tensor permute_pooled_embs_meta(
   return torch::empty_like(pooled_embs);
 }
 
+void permute_pooled_embs_out_meta(
+    const Tensor& /* pooled_embs */,
+    const Tensor& /* offset_dim_list */,
+    const Tensor& /* permute_list */,
+    Tensor& /* output */,
+    const bool /* allow_duplicates */) {}
+
 at::Tensor permute_pooled_embs_auto_grad_meta(
     const Tensor& pooled_embs,
     const Tensor& /* offset_dim_list */,
@@ -155,6 +276,10 @@ TORCH_LIBRARY_FRAGMENT(fbgemm, m) {
       "permute_duplicate_pooled_embs(Tensor pooled_embs, Tensor offset_dim_list, Tensor permute_list, Tensor inv_offset_dim_list, Tensor inv_permute_list) -> Tensor");
   m.def(
       "permute_duplicate_pooled_embs_auto_grad(Tensor pooled_embs, Tensor offset_dim_list, Tensor permute_list, Tensor inv_offset_dim_list, Tensor inv_permute_list) -> Tensor");
+  // Writes the permuted pooled_embs into output, e.g., a column slice of the
+  // input buffer of the next interaction
+  m.def(
+      "permute_pooled_embs_out(Tensor pooled_embs, Tensor offset_dim_list, Tensor permute_list, Tensor(a!) output, bool allow_duplicates=False) -> ()");
 }
 
 FBGEMM_OP_DISPATCH(
@@ -173,6 +298,10 @@ FBGEMM_OP_DISPATCH(
     CPU,
     "permute_duplicate_pooled_embs_auto_grad",
     fbgemm_gpu::permute_duplicate_pooled_embs_auto_grad_cpu);
+FBGEMM_OP_DISPATCH(
+    CPU,
+    "permute_pooled_embs_out",
+    fbgemm_gpu::permute_pooled_embs_cpu_out);
 
 FBGEMM_OP_DISPATCH(
     Meta,
@@ -182,6 +311,10 @@ FBGEMM_OP_DISPATCH(
     Meta,
     "permute_pooled_embs_auto_grad",
     fbgemm_gpu::permute_pooled_embs_auto_grad_meta);
+FBGEMM_OP_DISPATCH(
+    Meta,
+    "permute_pooled_embs_out",
+    fbgemm_gpu::permute_pooled_embs_out_meta);
 
 FBGEMM_OP_DISPATCH(
     Autograd,
@@ -12,6 +12,7 @@
 #include <torch/script.h>
 #include <vector>
 
+#include "fbgemm_gpu/permute_pooled_embedding_ops.h"
 #include "fbgemm_gpu/permute_pooled_embedding_ops_split.h"
 #include "fbgemm_gpu/permute_pooled_embs_function_split.h"
 #include "fbgemm_gpu/sparse_ops_utils.h"
@@ -31,27 +32,13 @@ Tensor permute_pooled_embs_split_cpu_impl(
     const Tensor& inv_offset_dim_list,
     const Tensor& inv_permute_list,
     const bool& allow_duplicates) {
-  TORCH_CHECK(
-      offset_dim_list.scalar_type() == at::ScalarType::Long,
-      "offset_dim_list needs to have long/int64 type")
-  TORCH_CHECK(
-      permute_list.scalar_type() == at::ScalarType::Long,
-      "permute_list needs to have long/int64 type")
-  auto permute = permute_list.data_ptr<int64_t>();
-  const auto n = permute_list.numel();
-  const auto dims_size = allow_duplicates ? offset_dim_list.numel() : n;
-  std::vector<int64_t> dims;
-  dims.reserve(dims_size - 1);
-  for (const auto i : c10::irange(1, dims_size)) {
-    dims.push_back(offset_dim_list[i].item<int64_t>());
-  }
-  auto ts = pooled_embs.tensor_split(dims, 1);
-  std::vector<Tensor> permuted_ts;
-  permuted_ts.reserve(n);
-  for (const auto i : c10::irange(n)) {
-    permuted_ts.push_back(ts[permute[i]]);
-  }
-  return at::cat(permuted_ts, 1);
+  return permute_pooled_embs_cpu_impl(
+      pooled_embs,
+      offset_dim_list,
+      permute_list,
+      inv_offset_dim_list,
+      inv_permute_list,
+      allow_duplicates);
 }
 
 Tensor permute_pooled_embs_split_cpu(
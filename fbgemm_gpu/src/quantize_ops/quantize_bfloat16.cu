@@ -12,6 +12,40 @@ using Tensor = at::Tensor;
 
 namespace fbgemm_gpu {
 
+namespace {
+
+// Same mapping of warps to (table, batch) as permute_pooled_embs_kernel, with
+// the bfloat16 rounding of _float_to_bfloat16_gpu applied on the copy.
+__global__ void _float_to_bfloat16_permuted_cuda_kernel(
+    const pta::PackedTensorAccessor64<float, 2, at::RestrictPtrTraits> input,
+    const pta::PackedTensorAccessor32<int64_t, 1, at::RestrictPtrTraits>
+        offset_dim_list,
+    const pta::PackedTensorAccessor32<int64_t, 1, at::RestrictPtrTraits>
+        permute_list,
+    const pta::PackedTensorAccessor32<int64_t, 1, at::RestrictPtrTraits>
+        inv_offset_dim_list,
+    pta::PackedTensorAccessor64<at::Half, 2, at::RestrictPtrTraits> output) {
+  const int32_t T = permute_list.size(0);
+  const int32_t t =
+      blockIdx.x * (blockDim.x / kWarpSize) + threadIdx.x / kWarpSize;
+  const int64_t b = blockIdx.y + gridDim.y * blockIdx.z;
+  if (b >= input.size(0) || t >= T) {
+    return;
+  }
+  const int64_t permute_idx = permute_list[t];
+  const int64_t input_dim_start = offset_dim_list[permute_idx];
+  const int64_t cur_dim = offset_dim_list[permute_idx + 1] - input_dim_start;
+  const int64_t output_dim_start = inv_offset_dim_list[t];
+  for (int64_t i = threadIdx.x % kWarpSize; i < cur_dim; i += kWarpSize) {
+    fbgemm_gpu::fint32 temp;
+    temp.F = input[b][input_dim_start + i];
+    output[b][output_dim_start + i] =
+        at::Half((temp.I + (1 << 15)) >> 16, at::Half::from_bits());
+  }
+}
+
+} // namespace
+
 /// @ingroup quantize-ops-cuda
 ///
 /// Converts a tensor of `float` values into a tensor of Brain Floating Point
@@ -70,6 +104,75 @@ DLL_PUBLIC at::Tensor _bfloat16_to_float_gpu(const at::Tensor& input) {
   return output;
 }
 
+/// @ingroup quantize-ops-cuda
+///
+/// Converts pooled embeddings to `bfloat16` in the permuted layout of
+/// `permute_pooled_embs`, fusing the permutation that packs the all-to-all
+/// send buffer into the conversion.
+///
+/// @param pooled_embs A 2D tensor of `float` pooled embeddings
+///                    `[B_local][Sum_T_global(D)]`
+/// @param offset_dim_list The offsets of the tables in the columns of
+///                        `pooled_embs`, of size T + 1
+/// @param permute_list The table written at each position of the output
+/// @param inv_offset_dim_list The offsets of the tables in the columns of the
+///                            permuted output, of size T + 1
+///
+/// @return The same tensor as
+/// `FloatToBfloat16Quantized(permute_pooled_embs(pooled_embs, ...))`. The
+/// permutation must not duplicate tables.
+DLL_PUBLIC at::Tensor _float_to_bfloat16_permuted_gpu(
+    const at::Tensor& pooled_embs,
+    const at::Tensor& offset_dim_list,
+    const at::Tensor& permute_list,
+    const at::Tensor& inv_offset_dim_list) {
+  TENSORS_ON_SAME_CUDA_GPU_IF_NOT_OPTIONAL(
+      pooled_embs, offset_dim_list, permute_list, inv_offset_dim_list);
+  TENSOR_NDIM_EQUALS(pooled_embs, 2);
+  TORCH_CHECK(offset_dim_list.numel() == permute_list.numel() + 1);
+  TORCH_CHECK(offset_dim_list.numel() == inv_offset_dim_list.numel());
+  CUDA_DEVICE_GUARD(pooled_embs);
+
+  const auto input = pooled_embs.contiguous();
+  const int64_t B = input.size(0);
+  const int64_t T = permute_list.numel();
+  auto output = at::empty(input.sizes(), input.options().dtype(at::kHalf));
+  if (B == 0 || T == 0) {
+    return output;
+  }
+
+  const auto offset_dim_list_ = offset_dim_list.contiguous();
+  const auto permute_list_ = permute_list.contiguous();
+  const auto inv_offset_dim_list_ = inv_offset_dim_list.contiguous();
+
+  // As permute_pooled_embs_gpu_impl: ( div_round_up(T, warp_per_block), B )
+  // blocks, with the grid z dimension covering B beyond 32768.
+  const int32_t warp_per_block = kMaxThreads / kWarpSize;
+  const int32_t max_grid_dim_y = 32768;
+  const dim3 threads(kMaxThreads);
+  const dim3 blocks(
+      div_round_up(T, warp_per_block),
+      std::min(static_cast<int32_t>(B), max_grid_dim_y),
+      (B + max_grid_dim_y - 1) / max_grid_dim_y);
+
+#ifdef FBGEMM_GPU_MEMCHECK
+  const auto func_name = "_float_to_bfloat16_permuted_cuda_kernel";
+#endif
+  _float_to_bfloat16_permuted_cuda_kernel<<<
+      blocks,
+      threads,
+      0,
+      at::cuda::getCurrentCUDAStream()>>>(
+      MAKE_PTA_WITH_NAME(func_name, input, float, 2, 64),
+      MAKE_PTA_WITH_NAME(func_name, offset_dim_list_, int64_t, 1, 32),
+      MAKE_PTA_WITH_NAME(func_name, permute_list_, int64_t, 1, 32),
+      MAKE_PTA_WITH_NAME(func_name, inv_offset_dim_list_, int64_t, 1, 32),
+      MAKE_PTA_WITH_NAME(func_name, output, at::Half, 2, 64));
+  C10_CUDA_KERNEL_LAUNCH_CHECK();
+
+  return output;
+}
+
 } // namespace fbgemm_gpu
 
 FBGEMM_OP_DISPATCH(
@@ -80,3 +183,7 @@ FBGEMM_OP_DISPATCH(
     CUDA,
     "FloatToBfloat16Quantized",
     fbgemm_gpu::_float_to_bfloat16_gpu);
+FBGEMM_OP_DISPATCH(
+    CUDA,
+    "FloatToBfloat16QuantizedPermuted",
+    fbgemm_gpu::_float_to_bfloat16_permuted_gpu);
@@ -189,6 +189,83 @@ __global__ inline void _FP8rowwise_to_float_cuda_kernel(
   }
 }
 
+// FP32/FP16/BF16 -> FP8 rowwise kernel that writes the rows in the layout of
+// permute_pooled_embs, so the send buffer of the all-to-all is produced
+// without the permuted copy. One warp per row: the scale is reduced over the
+// whole row, which a permutation without duplicates leaves unchanged, then
+// each segment is quantized straight to its permuted offset.
+template <typename input_t>
+__global__ inline void _float_to_FP8rowwise_permuted_cuda_kernel(
+    const pta::PackedTensorAccessor64<input_t, 1, at::RestrictPtrTraits> input,
+    const int64_t nrows,
+    const int64_t ncols,
+    const pta::PackedTensorAccessor32<int64_t, 1, at::RestrictPtrTraits>
+        offset_dim_list,
+    const pta::PackedTensorAccessor32<int64_t, 1, at::RestrictPtrTraits>
+        permute_list,
+    const pta::PackedTensorAccessor32<int64_t, 1, at::RestrictPtrTraits>
+        inv_offset_dim_list,
+    pta::PackedTensorAccessor64<uint8_t, 1, at::RestrictPtrTraits> output,
+    const bool forward) {
+  // Assert if index is out of bound
+  CUDA_KERNEL_ASSERT(nrows * ncols >= 0);
+
+  constexpr float kEpsilon = 1e-20f;
+  const int ebit = forward ? 4 : 5;
+  const int bias = forward ? 15 : 31;
+  const float max_pos = forward ? 0.9375 : 0.875;
+
+  const int64_t ncols_aligned = (ncols + 4 - 1) / 4 * 4;
+  const int64_t output_columns = ncols_aligned + 2 * sizeof(float);
+  const int32_t T = permute_list.size(0);
+
+  // The whole warp leaves together, so the shuffles below are complete
+  const int64_t row =
+      static_cast<int64_t>(blockIdx.x) * blockDim.y + threadIdx.y;
+  if (row >= nrows) {
+    return;
+  }
+  const input_t* input_row = &input[row * ncols];
+  std::uint8_t* output_row = &output[row * output_columns];
+
+  // Same reduction and scale as _get_FP8_qparam_cuda_kernel
+  float maximum_element = kEpsilon;
+  for (int64_t col = threadIdx.x; col < ncols; col += kWarpSize) {
+    maximum_element = fmaxf(maximum_element, fabs(to_float(input_row[col])));
+  }
+  for (int offset = kWarpSize >> 1; offset > 0; offset >>= 1) {
+    maximum_element =
+        fmaxf(maximum_element, shfl_xor(maximum_element, offset, kWarpSize));
+  }
+  const float scale = max_pos / (kEpsilon + maximum_element);
+
+  for (int32_t t = 0; t < T; ++t) {
+    const int64_t permute_idx = permute_list[t];
+    const int64_t input_dim_start = offset_dim_list[permute_idx];
+    const int64_t cur_dim = offset_dim_list[permute_idx + 1] - input_dim_start;
+    std::uint8_t* output_segment = output_row + inv_offset_dim_list[t];
+    for (int64_t i = threadIdx.x; i < cur_dim; i += kWarpSize) {
+      output_segment[i] = float_to_hfp8(
+          to_float(input_row[input_dim_start + i]) * scale,
+          ebit,
+          bias,
+          max_pos);
+    }
+  }
+
+  // Zero the alignment padding and the unused 4 bytes of the qparams so the
+  // send buffer is deterministic
+  if (threadIdx.x < ncols_aligned - ncols) {
+    output_row[ncols + threadIdx.x] = 0;
+  }
+  if (threadIdx.x == 0) {
+    float* output_row_qparams =
+        reinterpret_cast<float*>(output_row + ncols_aligned);
+    output_row_qparams[0] = scale;
+    output_row_qparams[1] = 0.0;
+  }
+}
+
 } // namespace
 
 // revising INT8 rowwise template for FP8 rowwise quantization
@@ -345,6 +422,85 @@ _float_to_FP8rowwise_gpu(const Tensor& input, const bool forward) {
   }
 }
 
+/// @ingroup quantize-ops-cuda
+/// Quantizes pooled embeddings to `fp8` rowwise in the permuted layout of
+/// `permute_pooled_embs`, fusing the permutation that packs the all-to-all
+/// send buffer into the quantization.
+///
+/// @param pooled_embs A 2D tensor of pooled embeddings
+///                    `[B_local][Sum_T_global(D)]`. The dtype can be either
+///                    `SparseType::FP32`, `SparseType::FP16`, or
+///                    `SparseType::BF16`
+/// @param offset_dim_list The offsets of the tables in the columns of
+///                        `pooled_embs`, of size T + 1
+/// @param permute_list The table written at each position of the output
+/// @param inv_offset_dim_list The offsets of the tables in the columns of the
+///                            permuted output, of size T + 1
+/// @param forward
+///
+/// @return The same tensor as
+/// `FloatToFP8RowwiseQuantized(permute_pooled_embs(pooled_embs, ...))`. The
+/// permutation must not duplicate tables.
+DLL_PUBLIC Tensor _float_to_FP8rowwise_permuted_gpu(
+    const Tensor& pooled_embs,
+    const Tensor& offset_dim_list,
+    const Tensor& permute_list,
+    const Tensor& inv_offset_dim_list,
+    const bool forward) {
+  TENSORS_ON_SAME_CUDA_GPU_IF_NOT_OPTIONAL(
+      pooled_embs, offset_dim_list, permute_list, inv_offset_dim_list);
+  TENSOR_NDIM_EQUALS(pooled_embs, 2);
+  TORCH_CHECK(offset_dim_list.numel() == permute_list.numel() + 1);
+  TORCH_CHECK(offset_dim_list.numel() == inv_offset_dim_list.numel());
+  CUDA_DEVICE_GUARD(pooled_embs);
+
+  const auto input = pooled_embs.contiguous();
+  const int64_t nrows = input.size(0);
+  const int64_t ncols = input.size(1);
+  const int64_t ncols_aligned = (ncols + 4 - 1) / 4 * 4;
+  const int64_t output_columns = ncols_aligned + 2 * sizeof(float);
+
+  if (nrows == 0 || ncols == 0) {
+    return at::zeros({nrows, output_columns}, input.options().dtype(at::kByte));
+  }
+
+  auto output =
+      at::empty({nrows, output_columns}, input.options().dtype(at::kByte));
+
+  const auto input_1D = input.flatten();
+  const auto output_1D = output.flatten();
+  const auto offset_dim_list_ = offset_dim_list.contiguous();
+  const auto permute_list_ = permute_list.contiguous();
+  const auto inv_offset_dim_list_ = inv_offset_dim_list.contiguous();
+
+  constexpr int rows_per_block = kMaxThreads / kWarpSize;
+  const auto num_blocks = cuda_calc_xblock_count(nrows, rows_per_block);
+
+  FBGEMM_DISPATCH_FLOATING_TYPES(
+      input.scalar_type(), "_float_to_FP8rowwise_permuted_cuda_kernel", [&] {
+#ifdef FBGEMM_GPU_MEMCHECK
+        const auto func_name = "_float_to_FP8rowwise_permuted_cuda_kernel";
+#endif
+        _float_to_FP8rowwise_permuted_cuda_kernel<scalar_t>
+            <<<num_blocks,
+               dim3(kWarpSize, rows_per_block),
+               0,
+               at::cuda::getCurrentCUDAStream()>>>(
+                MAKE_PTA_WITH_NAME(func_name, input_1D, scalar_t, 1, 64),
+                nrows,
+                ncols,
+                MAKE_PTA_WITH_NAME(func_name, offset_dim_list_, int64_t, 1, 32),
+                MAKE_PTA_WITH_NAME(func_name, permute_list_, int64_t, 1, 32),
+                MAKE_PTA_WITH_NAME(
+                    func_name, inv_offset_dim_list_, int64_t, 1, 32),
+                MAKE_PTA_WITH_NAME(func_name, output_1D, uint8_t, 1, 64),
+                forward);
+        C10_CUDA_KERNEL_LAUNCH_CHECK();
+      });
+
+  return output;
+}
+
 Tensor _FP8rowwise_to_float_gpu_t(
     const Tensor& input,
     bool forward,
@@ -0,0 +1,346 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "common.cuh"
+
+using Tensor = at::Tensor;
+
+namespace fbgemm_gpu {
+
+namespace {
+
+// Same as fbgemm::MXFormat
+enum class MXFormat : int64_t {
+  MXFP8_E4M3 = 0,
+  MXFP8_E5M2 = 1,
+  MXFP4_E2M1 = 2,
+  MXINT8 = 3,
+};
+
+constexpr int kMXBlockSize = 32;
+
+// Element format of an MX block format as a minifloat, except for MXINT8
+struct MXElementFormat {
+  int exponent_bits;
+  int mantissa_bits;
+  int exponent_bias;
+  // Exponent of the largest power of two, emax of the OCP MX specification
+  int emax;
+  float max_pos;
+};
+
+__host__ __device__ inline MXElementFormat mx_element_format(
+    const MXFormat format) {
+  switch (format) {
+    case MXFormat::MXFP8_E4M3:
+      return {4, 3, 7, 8, 448.0f};
+    case MXFormat::MXFP8_E5M2:
+      return {5, 2, 15, 15, 57344.0f};
+    case MXFormat::MXFP4_E2M1:
+      return {2, 1, 1, 2, 6.0f};
+    default:
+      return {0, 6, 0, 0, 127.0f / 64};
+  }
+}
+
+__host__ __device__ inline int mx_element_bytes(
+    const MXFormat format,
+    const int ncols) {
+  return format == MXFormat::MXFP4_E2M1 ? (ncols + 1) / 2 : ncols;
+}
+
+__host__ __device__ inline int mx_row_bytes(
+    const MXFormat format,
+    const int ncols) {
+  return mx_element_bytes(format, ncols) +
+      (ncols + kMXBlockSize - 1) / kMXBlockSize;
+}
+
+// Finite x rounded to nearest even and saturated to the element format, as
+// fbgemm::FloatOrHalfToMXQuantized
+__device__ inline uint8_t float_to_mx_element(
+    const float x,
+    const MXElementFormat& f) {
+  if (f.exponent_bits == 0) {
+    // MXINT8
+    const float q = rintf(ldexpf(x, f.mantissa_bits));
+    return static_cast<int8_t>(fminf(fmaxf(q, -128.0f), 127.0f));
+  }
+  const uint8_t sign =
+      signbit(x) ? 1 << (f.exponent_bits + f.mantissa_bits) : 0;
+  const float abs_x = fminf(fabsf(x), f.max_pos);
+  if (abs_x == 0.0f) {
+    return sign;
+  }
+  const int emin = 1 - f.exponent_bias;
+  int e;
+  frexpf(abs_x, &e);
+  const int exponent = QUANTIZE_OPS_MAX(e - 1, emin);
+  const int significand =
+      static_cast<int>(rintf(ldexpf(abs_x, f.mantissa_bits - exponent)));
+  return sign | (((exponent - emin) << f.mantissa_bits) + significand);
+}
+
+__device__ inline float mx_element_to_float(
+    const uint8_t code,
+    const MXFormat format,
+    const MXElementFormat& f) {
+  if (format == MXFormat::MXINT8) {
+    return ldexpf(static_cast<int8_t>(code), -f.mantissa_bits);
+  }
+  const int magnitude_bits = f.exponent_bits + f.mantissa_bits;
+  const int magnitude = code & ((1 << magnitude_bits) - 1);
+  const int exponent_field = magnitude >> f.mantissa_bits;
+  const int mantissa = magnitude & ((1 << f.mantissa_bits) - 1);
+  float value;
+  if ((format == MXFormat::MXFP8_E4M3 && magnitude == 0x7F) ||
+      (format == MXFormat::MXFP8_E5M2 && exponent_field == 0x1F)) {
+    value = format == MXFormat::MXFP8_E5M2 && mantissa == 0 ? INFINITY : NAN;
+  } else if (exponent_field == 0) {
+    value = ldexpf(mantissa, 1 - f.exponent_bias - f.mantissa_bits);
+  } else {
+    value = ldexpf(
+        mantissa + (1 << f.mantissa_bits),
+        exponent_field - f.exponent_bias - f.mantissa_bits);
+  }
+  return code >> magnitude_bits ? -value : value;
+}
+
+// Each thread quantizes a block of kMXBlockSize elements of a row
+template <typename input_t>
+__global__ inline void _float_to_mx_cuda_kernel(
+    const MXFormat format,
+    const input_t* __restrict__ input,
+    const int nrows,
+    const int ncols,
+    uint8_t* __restrict__ output) {
+  const MXElementFormat f = mx_element_format(format);
+  const bool is_fp4 = format == MXFormat::MXFP4_E2M1;
+  const int element_bytes = mx_element_bytes(format, ncols);
+  const int output_columns = mx_row_bytes(format, ncols);
+  const int blocks_per_row = (ncols + kMXBlockSize - 1) / kMXBlockSize;
+  const int64_t num_blocks = static_cast<int64_t>(nrows) * blocks_per_row;
+
+  for (int64_t block = (int64_t)blockIdx.x * blockDim.x + threadIdx.x;
+       block < num_blocks;
+       block += (int64_t)blockDim.x * gridDim.x) {
+    const int64_t row = block / blocks_per_row;
+    const int begin = (block % blocks_per_row) * kMXBlockSize;
+    const int end = QUANTIZE_OPS_MIN(begin + kMXBlockSize, ncols);
+    const input_t* input_row = input + row * ncols;
+    uint8_t* output_row = output + row * output_columns;
+
+    float amax = 0.0f;
+    bool finite = true;
+    for (int col = begin; col < end; ++col) {
+      const float x = input_row[col];
+      finite = finite && isfinite(x);
+      amax = fmaxf(amax, fabsf(x));
+    }
+
+    int shared_exponent = -127;
+    if (finite && amax > 0.0f) {
+      int e;
+      frexpf(amax, &e);
+      shared_exponent =
+          QUANTIZE_OPS_MIN(QUANTIZE_OPS_MAX(e - 1 - f.emax, -127), 127);
+    }
+    output_row[element_bytes + begin / kMXBlockSize] =
+        finite ? shared_exponent + 127 : 0xFF;
+
+    for (int col = begin; col < end; ++col) {
+      // The elements of a block with a NaN scale are ignored
+      const float x = finite ? static_cast<float>(input_row[col]) : 0.0f;
+      const uint8_t code =
+          float_to_mx_element(ldexpf(x, -shared_exponent), f);
+      if (!is_fp4) {
+        output_row[col] = code;
+      } else if (col % 2 == 0) {
+        output_row[col / 2] = code;
+      } else {
+        output_row[col / 2] |= code << 4;
+      }
+    }
+  }
+}
+
+// Each thread dequantizes one element
+template <typename output_t>
+__global__ inline void _mx_to_float_cuda_kernel(
+    const MXFormat format,
+    const uint8_t* __restrict__ input,
+    const int nrows,
+    const int output_columns,
+    output_t* __restrict__ output) {
+  const MXElementFormat f = mx_element_format(format);
+  const bool is_fp4 = format == MXFormat::MXFP4_E2M1;
+  const int element_bytes = mx_element_bytes(format, output_columns);
+  const int input_columns = mx_row_bytes(format, output_columns);
+
+  int row = (int)blockIdx.y * blockDim.y + threadIdx.y;
+  const int col = (int)blockIdx.x * blockDim.x + threadIdx.x;
+  const int row_incre = blockDim.y * gridDim.y;
+  for (/*row*/; row < nrows; row += row_incre) {
+    if (col < output_columns) {
+      const uint8_t* input_row = input + row * input_columns;
+      const uint8_t scale_code =
+          input_row[element_bytes + col / kMXBlockSize];
+      const float scale =
+          scale_code == 0xFF ? NAN : ldexpf(1.0f, scale_code - 127);
+      const uint8_t code = is_fp4
+          ? (input_row[col / 2] >> (col % 2 * 4)) & 0xF
+          : input_row[col];
+      output[row * output_columns + col] =
+          mx_element_to_float(code, format, f) * scale;
+    }
+  }
+}
+
+MXFormat to_mx_format(const int64_t mx_format) {
+  TORCH_CHECK(
+      mx_format >= static_cast<int64_t>(MXFormat::MXFP8_E4M3) &&
+          mx_format <= static_cast<int64_t>(MXFormat::MXINT8),
+      "Unknown MX format ",
+      mx_format);
+  return static_cast<MXFormat>(mx_format);
+}
+
+} // namespace
+
+/// @ingroup quantize-ops-cuda
+/// Converts a tensor of `float` or `at::Half` values into rows of the OCP
+/// Microscaling (MX) block format `mx_format`, with the element format of one
+/// of MXFP8 E4M3, MXFP8 E5M2, MXFP4 E2M1 or MXINT8. Each block of 32 elements
+/// of a row shares an E8M0 scale, stored at the end of the row.
+///
+/// @param input A 2D tensor of `float` or `at::Half` values
+/// @param mx_format The block format, as the integer value of
+///                  `fbgemm::MXFormat`
+///
+/// @return A new tensor of bytes with the quantized rows, bitwise identical to
+/// the CPU operator.
+DLL_PUBLIC at::Tensor _float_or_half_to_mx_gpu(
+    const at::Tensor& input,
+    const int64_t mx_format) {
+  TENSOR_ON_CUDA_GPU(input);
+  TENSOR_NDIM_EQUALS(input, 2);
+  CUDA_DEVICE_GUARD(input);
+
+  const auto format = to_mx_format(mx_format);
+  const auto input_contig = input.contiguous();
+  const int nrows = input.size(0);
+  const int ncols = input.size(1);
+  auto output = at::empty(
+      {nrows, mx_row_bytes(format, ncols)}, input.options().dtype(at::kByte));
+  if (nrows == 0 || ncols == 0) {
+    return output;
+  }
+
+  constexpr auto threads_per_block = 256;
+  const int64_t num_mx_blocks = static_cast<int64_t>(nrows) *
+      ((ncols + kMXBlockSize - 1) / kMXBlockSize);
+  const auto num_blocks =
+      cuda_calc_xblock_count(num_mx_blocks, threads_per_block);
+
+  FBGEMM_DISPATCH_FLOAT_AND_HALF(
+      input.scalar_type(), "_float_to_mx_cuda_kernel", [&] {
+        _float_to_mx_cuda_kernel<scalar_t>
+            <<<num_blocks,
+               threads_per_block,
+               0,
+               at::cuda::getCurrentCUDAStream()>>>(
+                format,
+                input_contig.data_ptr<scalar_t>(),
+                nrows,
+                ncols,
+                output.data_ptr<uint8_t>());
+        C10_CUDA_KERNEL_LAUNCH_CHECK();
+      });
+
+  return output;
+}
+
+/// @ingroup quantize-ops-cuda
+/// Converts rows of the MX block format `mx_format`, as produced by
+/// `_float_or_half_to_mx_gpu`, into a tensor of `float` or `at::Half` values.
+///
+/// @param input A 2D tensor of bytes with the quantized rows
+/// @param mx_format The block format, as the integer value of
+///                  `fbgemm::MXFormat`
+/// @param output_columns The number of elements of each row
+/// @param output_dtype The target floating point type, specified as integer
+///                     representation of `SparseType` enum
+///
+/// @return A new tensor of `output_columns` columns of dequantized values.
+DLL_PUBLIC at::Tensor _mx_to_float_or_half_gpu(
+    const at::Tensor& input,
+    const int64_t mx_format,
+    const int64_t output_columns,
+    const int64_t output_dtype) {
+  TENSOR_ON_CUDA_GPU(input);
+  TENSOR_NDIM_EQUALS(input, 2);
+  CUDA_DEVICE_GUARD(input);
+
+  const auto format = to_mx_format(mx_format);
+  const auto input_contig = input.contiguous();
+  const int nrows = input.size(0);
+  const int ncols = output_columns;
+  TORCH_CHECK(
+      input.size(1) == mx_row_bytes(format, ncols),
+      "Expected ",
+      mx_row_bytes(format, ncols),
+      " bytes per row for ",
+      ncols,
+      " columns, found ",
+      input.size(1));
+
+  const auto output_sparse_dtype = static_cast<SparseType>(output_dtype);
+  TORCH_CHECK(
+      output_sparse_dtype == SparseType::FP32 ||
+      output_sparse_dtype == SparseType::FP16);
+  auto output = at::empty(
+      {nrows, ncols},
+      input.options().dtype(
+          output_sparse_dtype == SparseType::FP32 ? at::kFloat : at::kHalf));
+  if (nrows == 0 || ncols == 0) {
+    return output;
+  }
+
+  constexpr int threads_per_block = 256;
+
+  const int blockDim_x = std::min(ncols, threads_per_block);
+  const dim3 blockDim(blockDim_x, threads_per_block / blockDim_x);
+  const auto gridDim_x = cuda_calc_xblock_count(ncols, blockDim.x);
+  const auto gridDim_y = cuda_calc_block_count(nrows, blockDim.y);
+  const dim3 gridDim(gridDim_x, gridDim_y);
+
+  FBGEMM_DISPATCH_FLOAT_AND_HALF(
+      output.scalar_type(), "_mx_to_float_cuda_kernel", [&] {
+        _mx_to_float_cuda_kernel<scalar_t>
+            <<<gridDim, blockDim, 0, at::cuda::getCurrentCUDAStream()>>>(
+                format,
+                input_contig.data_ptr<uint8_t>(),
+                nrows,
+                ncols,
+                output.data_ptr<scalar_t>());
+        C10_CUDA_KERNEL_LAUNCH_CHECK();
+      });
+
+  return output;
+}
+
+} // namespace fbgemm_gpu
+
+FBGEMM_OP_DISPATCH(
+    CUDA,
+    "FloatOrHalfToMXQuantized",
+    fbgemm_gpu::_float_or_half_to_mx_gpu);
+FBGEMM_OP_DISPATCH(
+    CUDA,
+    "MXQuantizedToFloatOrHalf",
+    fbgemm_gpu::_mx_to_float_or_half_gpu);
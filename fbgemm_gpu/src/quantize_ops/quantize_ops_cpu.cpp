@@ -11,6 +11,7 @@
 #include <fbgemm_gpu/sparse_ops.h>
 #include <fbgemm_gpu/sparse_ops_utils.h>
 #include <torch/library.h>
+#include "fbgemm/FbgemmConvert.h"
 #include "fbgemm/QuantUtils.h"
 #include "fbgemm_gpu/dispatch_macros.h"
 #include "fbgemm_gpu/embedding_common.h"
@@ -255,6 +256,18 @@ Tensor float_to_FP8rowwise_cpu(const Tensor& input, bool forward) {
   return input;
 }
 
+/// @ingroup quantize-data-cpu
+///
+Tensor float_to_FP8rowwise_permuted_cpu(
+    const Tensor& pooled_embs,
+    const Tensor& offset_dim_list,
+    const Tensor& permute_list,
+    const Tensor& inv_offset_dim_list,
+    bool forward) {
+  TORCH_CHECK(false, "fp8 is not supported by CPU");
+  return pooled_embs;
+}
+
 /// @ingroup quantize-data-cpu
 ///
 Tensor FP8rowwise_to_float_cpu(
@@ -383,19 +396,58 @@ at::Tensor _float_to_hfp8_cpu(
   TENSOR_ON_CPU(input);
   TENSOR_NDIM_EQUALS(input, 2);
 
+  const auto input_contig = input.contiguous();
   const auto input_sizes = input.sizes();
   const int32_t nrows = input_sizes[0];
   const int32_t ncols = input_sizes[1];
   auto output = at::empty({nrows, ncols}, input.options().dtype(at::kByte));
 
-  FloatToFP8Quantized_ref(
-      input.data_ptr<float>(),
-      nrows,
-      ncols,
-      output.data_ptr<uint8_t>(),
-      ebits,
-      exponent_bias,
-      max_pos);
+  const float* input_data = input_contig.data_ptr<float>();
+  uint8_t* output_data = output.data_ptr<uint8_t>();
+  // Largest value of the format, to which the FBGEMM kernels saturate
+  const float format_max_pos = (1 << ((1 << ebits) - 2 - exponent_bias)) *
+      (2 - std::pow(2, ebits - 7));
+  const float max_pos_f = max_pos;
+  if (max_pos_f > format_max_pos) {
+    // Values beyond the format don't have a valid encoding, keep the scalar
+    // conversion as is
+    FloatToFP8Quantized_ref(
+        input_data,
+        nrows,
+        ncols,
+        output_data,
+        ebits,
+        exponent_bias,
+        max_pos);
+    return output;
+  }
+
+  at::parallel_for(0, nrows, 1, [&](int64_t start, int64_t end) {
+    if (max_pos_f == format_max_pos) {
+      fbgemm::FloatToFloat8_simd(
+          input_data + start * ncols,
+          output_data + start * ncols,
+          (end - start) * ncols,
+          ebits,
+          exponent_bias);
+      return;
+    }
+    // Clamp to the smaller max_pos first as float_to_hfp8, including NaNs
+    std::vector<float> clamped_row(ncols);
+    for (const auto row : c10::irange(start, end)) {
+      const float* input_row = input_data + row * ncols;
+      for (const auto col : c10::irange(ncols)) {
+        clamped_row[col] = std::copysign(
+            std::fmin(std::fabs(input_row[col]), max_pos_f), input_row[col]);
+      }
+      fbgemm::FloatToFloat8_simd(
+          clamped_row.data(),
+          output_data + row * ncols,
+          ncols,
+          ebits,
+          exponent_bias);
+    }
+  });
 
   return output;
 }
@@ -407,6 +459,7 @@ at::Tensor _hfp8_to_float_cpu(
   TENSOR_ON_CPU(input);
   TENSOR_NDIM_EQUALS(input, 2);
 
+  const auto input_contig = input.contiguous();
   const auto input_sizes = input.sizes();
   const int32_t nrows = input_sizes[0];
   const int32_t ncols = input_sizes[1];
@@ -415,13 +468,127 @@ at::Tensor _hfp8_to_float_cpu(
       {nrows, output_columns}, // 4 = sizeof(float)
       input.options().dtype(at::kFloat)); //
 
-  FP8QuantizedToFloat_ref(
-      input.data_ptr<uint8_t>(),
-      nrows,
-      ncols,
-      output.data_ptr<float>(),
-      ebits,
-      exponent_bias);
+  const uint8_t* input_data = input_contig.data_ptr<uint8_t>();
+  float* output_data = output.data_ptr<float>();
+  at::parallel_for(0, nrows, 1, [&](int64_t start, int64_t end) {
+    fbgemm::Float8ToFloat_simd(
+        input_data + start * ncols,
+        output_data + start * output_columns,
+        (end - start) * ncols,
+        ebits,
+        exponent_bias);
+  });
+
+  return output;
+}
+
+namespace {
+
+fbgemm::MXFormat to_mx_format(const int64_t mx_format) {
+  TORCH_CHECK(
+      mx_format >= static_cast<int64_t>(fbgemm::MXFormat::MXFP8_E4M3) &&
+          mx_format <= static_cast<int64_t>(fbgemm::MXFormat::MXINT8),
+      "Unknown MX format ",
+      mx_format);
+  return static_cast<fbgemm::MXFormat>(mx_format);
+}
+
+} // namespace
+
+/// @ingroup quantize-data-cpu
+///
+/// Converts a 2D tensor of `float` or `half` values into rows of the MX block
+/// format `mx_format` (see `fbgemm::MXFormat`), with an E8M0 scale for each
+/// block of 32 elements at the end of each row.
+at::Tensor _float_or_half_to_mx_cpu(
+    const at::Tensor& input,
+    const int64_t mx_format) {
+  TENSOR_ON_CPU(input);
+  TENSOR_NDIM_EQUALS(input, 2);
+
+  const auto format = to_mx_format(mx_format);
+  const auto input_contig = input.contiguous();
+  const int64_t nrows = input.size(0);
+  const int32_t ncols = input.size(1);
+  const int64_t output_columns = fbgemm::MXQuantizedRowBytes(format, ncols);
+  auto output =
+      at::empty({nrows, output_columns}, input.options().dtype(at::kByte));
+
+  FBGEMM_DISPATCH_FLOAT_AND_HALF(
+      input.scalar_type(), "float_or_half_to_mx_cpu", [&] {
+        using input_t = std::conditional_t<
+            std::is_same<scalar_t, float>::value,
+            float,
+            fbgemm::float16>;
+        const auto input_data =
+            static_cast<const input_t*>(input_contig.data_ptr());
+        auto output_data = output.data_ptr<uint8_t>();
+        at::parallel_for(0, nrows, 1, [&](int64_t start, int64_t end) {
+          fbgemm::FloatOrHalfToMXQuantized<input_t>(
+              format,
+              input_data + start * ncols,
+              end - start,
+              ncols,
+              output_data + start * output_columns);
+        });
+      });
+
+  return output;
+}
+
+/// @ingroup quantize-data-cpu
+///
+/// Converts rows of the MX block format `mx_format`, as produced by
+/// `_float_or_half_to_mx_cpu`, of `output_columns` elements each into a 2D
+/// tensor of `float` or `half` values as given by `output_dtype`.
+at::Tensor _mx_to_float_or_half_cpu(
+    const at::Tensor& input,
+    const int64_t mx_format,
+    const int64_t output_columns,
+    const int64_t output_dtype) {
+  TENSOR_ON_CPU(input);
+  TENSOR_NDIM_EQUALS(input, 2);
+
+  const auto format = to_mx_format(mx_format);
+  const auto input_contig = input.contiguous();
+  const int64_t nrows = input.size(0);
+  const int64_t input_columns =
+      fbgemm::MXQuantizedRowBytes(format, output_columns);
+  TORCH_CHECK(
+      input.size(1) == input_columns,
+      "Expected ",
+      input_columns,
+      " bytes per row for ",
+      output_columns,
+      " columns, found ",
+      input.size(1));
+
+  const auto output_sparse_dtype = static_cast<SparseType>(output_dtype);
+  TORCH_CHECK(
+      output_sparse_dtype == SparseType::FP32 ||
+      output_sparse_dtype == SparseType::FP16);
+  auto output = at::empty(
+      {nrows, output_columns},
+      input.options().dtype(
+          output_sparse_dtype == SparseType::FP32 ? at::kFloat : at::kHalf));
+
+  const auto input_data = input_contig.data_ptr<uint8_t>();
+  FBGEMM_DISPATCH_FLOAT_AND_HALF(
+      output.scalar_type(), "mx_to_float_or_half_cpu", [&] {
+        using output_t = std::conditional_t<
+            std::is_same<scalar_t, float>::value,
+            float,
+            fbgemm::float16>;
+        auto output_data = static_cast<output_t*>(output.data_ptr());
+        at::parallel_for(0, nrows, 1, [&](int64_t start, int64_t end) {
+          fbgemm::MXQuantizedToFloatOrHalf<output_t>(
+              format,
+              input_data + start * input_columns,
+              end - start,
+              output_columns,
+              output_data + start * output_columns);
+        });
+      });
 
   return output;
 }
@@ -432,6 +599,8 @@ TORCH_LIBRARY_FRAGMENT(fbgemm, m) {
   m.def(
       "FloatToFP8RowwiseQuantized(Tensor t, bool forward) -> Tensor",
       {PT2_COMPLIANT_TAG});
+  m.def(
+      "FloatToFP8RowwiseQuantizedPermuted(Tensor pooled_embs, Tensor offset_dim_list, Tensor permute_list, Tensor inv_offset_dim_list, bool forward) -> Tensor");
   m.def(
       "FloatToPaddedFP8RowwiseQuantized(Tensor t, bool forward, int row_dim) -> Tensor");
   m.def(
@@ -471,6 +640,11 @@ TORCH_LIBRARY_FRAGMENT(fbgemm, m) {
       "MSFPQuantizedToFloat(Tensor input, int ebits, int mbits, int bias) -> Tensor");
   m.def(
       "PaddedFP8RowwiseQuantizedToFloat(Tensor input, bool forward, int row_dim, int output_last_dim=-1, int output_dtype=0) -> Tensor");
+  m.def(
+      "PaddedFP8RowwiseQuantizedToJagged(Tensor input, bool forward, int row_dim, int output_dtype=0) -> (Tensor, Tensor)");
+  m.def("FloatOrHalfToMXQuantized(Tensor input, int mx_format) -> Tensor");
+  m.def(
+      "MXQuantizedToFloatOrHalf(Tensor input, int mx_format, int output_columns, int output_dtype=0) -> Tensor");
 }
 
 TORCH_LIBRARY_IMPL(fbgemm, CPU, m) {
@@ -479,6 +653,9 @@ TORCH_LIBRARY_IMPL(fbgemm, CPU, m) {
       fbgemm_gpu::float_to_fused8bitrowwise_cpu);
   DISPATCH_TO_CPU(
       "FloatToFP8RowwiseQuantized", fbgemm_gpu::float_to_FP8rowwise_cpu);
+  DISPATCH_TO_CPU(
+      "FloatToFP8RowwiseQuantizedPermuted",
+      fbgemm_gpu::float_to_FP8rowwise_permuted_cpu);
   DISPATCH_TO_CPU(
       "HalfToFused8BitRowwiseQuantized",
       fbgemm_gpu::half_to_fused8bitrowwise_cpu);
@@ -522,4 +699,8 @@ TORCH_LIBRARY_IMPL(fbgemm, CPU, m) {
       fbgemm_gpu::fusednbitrowwise_to_float_or_half_cpu);
   DISPATCH_TO_CPU("FloatToHFP8Quantized", fbgemm_gpu::_float_to_hfp8_cpu);
   DISPATCH_TO_CPU("HFP8QuantizedToFloat", fbgemm_gpu::_hfp8_to_float_cpu);
+  DISPATCH_TO_CPU(
+      "FloatOrHalfToMXQuantized", fbgemm_gpu::_float_or_half_to_mx_cpu);
+  DISPATCH_TO_CPU(
+      "MXQuantizedToFloatOrHalf", fbgemm_gpu::_mx_to_float_or_half_cpu);
 }
@@ -24,6 +24,10 @@ FBGEMM_OP_DISPATCH(
     CUDA,
     "FP8RowwiseQuantizedToFloat",
     fbgemm_gpu::_FP8rowwise_to_float_gpu);
+FBGEMM_OP_DISPATCH(
+    CUDA,
+    "FloatToFP8RowwiseQuantizedPermuted",
+    fbgemm_gpu::_float_to_FP8rowwise_permuted_gpu);
 
 FBGEMM_OP_DISPATCH(
     CUDA,
@@ -33,3 +37,7 @@ FBGEMM_OP_DISPATCH(
     CUDA,
     "PaddedFP8RowwiseQuantizedToFloat",
     fbgemm_gpu::_paddedFP8rowwise_to_float_gpu);
+FBGEMM_OP_DISPATCH(
+    CUDA,
+    "PaddedFP8RowwiseQuantizedToJagged",
+    fbgemm_gpu::_paddedFP8rowwise_to_jagged_gpu);
@@ -199,6 +199,61 @@ __global__ inline void _PaddedFP8rowwise_to_float_2d_cuda_kernel(
   }
 }
 
+// Number of valid elements of each bucket of a padded FP8 buffer and whether
+// the bucket ends a quantized row, i.e. carries a non-negative pad value.
+__global__ inline void _get_padded_bucket_lengths_kernel(
+    const int64_t num_buckets,
+    const int row_dim,
+    const std::uint8_t* const __restrict__ input,
+    int64_t* const __restrict__ bucket_lengths,
+    int64_t* const __restrict__ row_ends) {
+  const int64_t bucket =
+      static_cast<int64_t>(blockIdx.x) * blockDim.x + threadIdx.x;
+  if (bucket >= num_buckets) {
+    return;
+  }
+  const int row_ext = row_dim + 8;
+  const int pad =
+      *reinterpret_cast<const int*>(input + bucket * row_ext + row_dim + 4);
+  bucket_lengths[bucket] = row_dim - (pad > 0 ? pad : 0);
+  row_ends[bucket] = pad >= 0 ? 1 : 0;
+}
+
+// One thread block per bucket, as _PaddedFP8rowwise_to_float_1d_cuda_kernel,
+// writing the values at their jagged offset. The bucket ending row r also
+// writes the end offset of r.
+template <typename output_t>
+__global__ inline void _PaddedFP8rowwise_to_jagged_cuda_kernel(
+    const std::uint8_t* const __restrict__ input,
+    const int row_dim,
+    const int64_t* const __restrict__ bucket_offsets,
+    const int64_t* const __restrict__ row_ends,
+    const int64_t* const __restrict__ row_ids,
+    output_t* const __restrict__ values,
+    int64_t* const __restrict__ offsets,
+    const int ebit,
+    const int bias) {
+  const int64_t bucket = blockIdx.x;
+  const int row_ext = row_dim + 8;
+  const std::uint8_t* const input_row = input + bucket * row_ext;
+  const float scale = *reinterpret_cast<const float*>(input_row + row_dim);
+  const int64_t value_offset = bucket_offsets[bucket];
+  const int64_t length = bucket_offsets[bucket + 1] - value_offset;
+  output_t* output_row = values + value_offset;
+  for (int col = threadIdx.x; col < length; col += blockDim.x) {
+    const auto output_ = hfp8_to_float(input_row[col], ebit, bias) / scale;
+    quantize_float_store(&output_row[col], output_);
+  }
+  if (threadIdx.x == 0) {
+    if (bucket == 0) {
+      offsets[0] = 0;
+    }
+    if (row_ends[bucket]) {
+      offsets[row_ids[bucket] + 1] = bucket_offsets[bucket + 1];
+    }
+  }
+}
+
 } // namespace
 
 // revising INT8 rowwise template for FP8 rowwise quantization
@@ -436,4 +491,102 @@ DLL_PUBLIC at::Tensor _paddedFP8rowwise_to_float_gpu(
       input, forward, row_dim, output_last_dim, output_dtype);
 }
 
+
+/// @ingroup quantize-ops-cuda
+///
+/// Converts a buffer of padded `fp8` rowwise values, which may concatenate
+/// the outputs of `FloatToPaddedFP8RowwiseQuantized` for rows of different
+/// lengths, into jagged values and offsets, without the dense intermediate of
+/// `PaddedFP8RowwiseQuantizedToFloat` followed by
+/// `dense_to_jagged_forward`.
+///
+/// @param input A tensor of padded `fp8` rowwise values. The outer dimensions
+///              are flattened, so every quantized row, of every outer row,
+///              is one row of the output
+/// @param forward
+/// @param row_dim
+/// @param output_dtype The target floating point type, specified as integer
+///                     representation of `SparseType` enum
+///
+/// @return A tuple of the 1D jagged values, without padding, and the
+/// `int64` offsets of the rows in them.
+///
+/// @throw c10::Error if `output_dtype` is not one of (`SparseType::FP32`,
+/// `SparseType::FP16`, `SparseType::BF16`).
+DLL_PUBLIC std::tuple<Tensor, Tensor> _paddedFP8rowwise_to_jagged_gpu(
+    const Tensor& input,
+    const bool forward,
+    const int64_t row_dim,
+    const int64_t output_dtype) {
+  TENSOR_CONTIGUOUS_AND_ON_CUDA_GPU(input);
+  CUDA_DEVICE_GUARD(input);
+
+  const int row_ext = row_dim + 8;
+  TORCH_CHECK(
+      input.numel() % row_ext == 0,
+      "input size (",
+      input.numel(),
+      ") must be multiple of ",
+      row_ext)
+  const auto output_sdtype = static_cast<SparseType>(output_dtype);
+  TORCH_CHECK(
+      output_sdtype == SparseType::FP32 || output_sdtype == SparseType::FP16 ||
+      output_sdtype == SparseType::BF16);
+  const auto values_options =
+      input.options().dtype(getScalarType(output_sdtype));
+  const auto offsets_options = input.options().dtype(at::kLong);
+
+  const int64_t num_buckets = input.numel() / row_ext;
+  if (num_buckets == 0) {
+    return {at::empty({0}, values_options), at::zeros({1}, offsets_options)};
+  }
+
+  auto bucket_lengths = at::empty({num_buckets}, offsets_options);
+  auto row_ends = at::empty({num_buckets}, offsets_options);
+  constexpr int threads_per_block = 256;
+  _get_padded_bucket_lengths_kernel<<<
+      cuda_calc_xblock_count(num_buckets, threads_per_block),
+      threads_per_block,
+      0,
+      at::cuda::getCurrentCUDAStream()>>>(
+      num_buckets,
+      row_dim,
+      input.data_ptr<std::uint8_t>(),
+      bucket_lengths.data_ptr<int64_t>(),
+      row_ends.data_ptr<int64_t>());
+  C10_CUDA_KERNEL_LAUNCH_CHECK();
+
+  const auto bucket_offsets = asynchronous_complete_cumsum_gpu(bucket_lengths);
+  const auto row_offsets = asynchronous_complete_cumsum_gpu(row_ends);
+  // One D -> H sync for both output sizes
+  const auto sizes =
+      at::stack({bucket_offsets[-1], row_offsets[-1]}).to(at::kCPU);
+  const int64_t total_length = sizes[0].item<int64_t>();
+  const int64_t num_rows = sizes[1].item<int64_t>();
+
+  auto values = at::empty({total_length}, values_options);
+  auto offsets = at::empty({num_rows + 1}, offsets_options);
+
+  const int ebit = forward ? 4 : 5;
+  const int bias = forward ? 15 : 31;
+  const int threads = std::min<int64_t>(kMaxThreads, row_dim);
+  FBGEMM_DISPATCH_FLOATING_TYPES(
+      values.scalar_type(), "PaddedFP8rowwise_to_jagged_cuda_kernel", [&] {
+        _PaddedFP8rowwise_to_jagged_cuda_kernel<scalar_t>
+            <<<num_buckets, threads, 0, at::cuda::getCurrentCUDAStream()>>>(
+                input.data_ptr<std::uint8_t>(),
+                row_dim,
+                bucket_offsets.data_ptr<int64_t>(),
+                row_ends.data_ptr<int64_t>(),
+                row_offsets.data_ptr<int64_t>(),
+                values.data_ptr<scalar_t>(),
+                offsets.data_ptr<int64_t>(),
+                ebit,
+                bias);
+      });
+  C10_CUDA_KERNEL_LAUNCH_CHECK();
+
+  return {values, offsets};
+}
+
 } // namespace fbgemm_gpu
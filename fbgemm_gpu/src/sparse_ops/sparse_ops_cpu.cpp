@@ -13,6 +13,7 @@
 #include <functional>
 
 #include <ATen/ATen.h>
+#include <ATen/AccumulateType.h>
 #include <ATen/Parallel.h>
 #include <ATen/TypeDefault.h>
 #include <ATen/core/dispatch/Dispatcher.h>
@@ -20,6 +21,7 @@
 #include <torch/csrc/autograd/custom_function.h>
 #include <torch/library.h>
 
+#include "fbgemm_gpu/cpu_utils.h"
 #include "fbgemm_gpu/dispatch_macros.h"
 #include "fbgemm_gpu/sparse_ops.h"
 #include "fbgemm_gpu/sparse_ops_utils.h"
@@ -31,6 +33,102 @@ namespace {
 // int32.
 constexpr int FALSE_SHARING_PAD = 16;
 
+// Logits per chunk of the calibration kernels, which compute an exp and two
+// table lookups per logit
+constexpr int64_t kCalibrationGrainSize = 2048;
+
+// Copies runs of elements, merging a run that continues the previous one in
+// both the source and the destination into a single memcpy
+template <typename scalar_t>
+class RunCopier {
+ public:
+  RunCopier() = default;
+  RunCopier(const RunCopier&) = delete;
+  RunCopier& operator=(const RunCopier&) = delete;
+  ~RunCopier() {
+    flush();
+  }
+
+  void copy(scalar_t* dst, const scalar_t* src, int64_t num_elements) {
+    if (num_elements <= 0) {
+      return;
+    }
+    if (size_ > 0 && dst == dst_ + size_ && src == src_ + size_) {
+      size_ += num_elements;
+      return;
+    }
+    flush();
+    dst_ = dst;
+    src_ = src;
+    size_ = num_elements;
+  }
+
+  void flush() {
+    if (size_ > 0) {
+      std::memcpy(dst_, src_, size_ * sizeof(scalar_t));
+      size_ = 0;
+    }
+  }
+
+ private:
+  scalar_t* dst_ = nullptr;
+  const scalar_t* src_ = nullptr;
+  int64_t size_ = 0;
+};
+
+// Sorted boundaries in Eytzinger (breadth first) order for a branchless
+// lower_bound: the search walks down the implicit binary tree without data
+// dependent branches, and the top levels share a few cache lines
+class EytzingerBoundaries {
+ public:
+  EytzingerBoundaries(const double* const boundaries, const int64_t n)
+      : tree_(n + 1), rank_(n + 1) {
+    build(boundaries, 0, 1);
+    rank_[0] = n;
+  }
+
+  // std::lower_bound(boundaries, boundaries + n, x) - boundaries
+  int64_t lower_bound(const double x) const {
+    const size_t n = tree_.size() - 1;
+    size_t k = 1;
+    while (k <= n) {
+      k = 2 * k + (tree_[k] < x);
+    }
+    // The lower bound is the last node where the search went left, 0 (the
+    // end) if it never did
+    while (k & 1) {
+      k >>= 1;
+    }
+    return rank_[k >> 1];
+  }
+
+ private:
+  int64_t build(const double* const boundaries, int64_t i, const size_t k) {
+    if (k < tree_.size()) {
+      i = build(boundaries, i, 2 * k);
+      tree_[k] = boundaries[i];
+      rank_[k] = i++;
+      i = build(boundaries, i, 2 * k + 1);
+    }
+    return i;
+  }
+
+  std::vector<double> tree_;
+  std::vector<int64_t> rank_;
+};
+
+// Grain size over (batch, table) segments for chunks of about GRAIN_SIZE
+// copied elements, so that the many tiny segments of a small request are
+// not spread over threads
+inline int64_t reorder_segments_grain_size(
+    const int64_t num_segments,
+    const int64_t num_elements) {
+  return std::max<int64_t>(
+      FALSE_SHARING_PAD,
+      at::internal::GRAIN_SIZE * num_segments /
+          std::max<int64_t>(num_elements, 1));
+}
+
 // Converts sparse tensor to dense tensor with few optimizations to be used with
 // histogram binning calibration by feature. (1) Assumes dense_last_dim == 1 (2)
 // Does not update default value when length > 1. HBC by feature has a separate
@@ -139,10 +237,7 @@ Tensor native_empty_like(const Tensor& self) {
 
 template <typename T>
 void prefix_sum(const int length, const T* const array, T* const presum) {
-  presum[0] = 0;
-  for (const auto i : c10::irange(length)) {
-    presum[i + 1] = array[i] + presum[i];
-  }
+  presum[length] = exclusive_scan_ptrs_cpu(length, array, presum);
 }
 
 // NOTE : _permute_indices_weights_kernel_cpu and _permute_lengths_cpu_kernel
@@ -338,103 +433,123 @@ void _block_bucketize_sparse_features_cpu_kernel(
   // count nonzeros
   prefix_sum(lengths_size, lengths_data, offsets_data);
   assert(offsets_data[lengths_size] == indices.numel());
-  int64_t cur_offset = 0;
+
+  // Bags of feature t are [feature_bag_offsets[t], feature_bag_offsets[t + 1])
+  std::vector<int64_t> feature_bag_offsets(T + 1, 0);
   for (const auto t : c10::irange(T)) {
+    feature_bag_offsets[t + 1] = feature_bag_offsets[t] +
+        (variable_batch_size ? batch_sizes_data[t] : B);
+  }
+  const int64_t num_bags = feature_bag_offsets[T];
+  // Every (bucket, bag) pair has its own new length and its own segment of
+  // the output, so both passes run in parallel over bags and keep the order
+  // of the sequential bucketization. Chunks hold about GRAIN_SIZE indices.
+  const int64_t grain_size = std::max<int64_t>(
+      1,
+      at::internal::GRAIN_SIZE * num_bags /
+          std::max<int64_t>(indices.numel(), 1));
+  const auto parallel_for_bags = [&](const auto& bucketize_bag) {
+    at::parallel_for(
+        0, num_bags, grain_size, [&](int64_t bag_begin, int64_t bag_end) {
+          int32_t t = std::upper_bound(
+                          feature_bag_offsets.begin(),
+                          feature_bag_offsets.end(),
+                          bag_begin) -
+              feature_bag_offsets.begin() - 1;
+          for (const auto b_t : c10::irange(bag_begin, bag_end)) {
+            while (b_t >= feature_bag_offsets[t + 1]) {
+              ++t;
+            }
+            bucketize_bag(t, b_t);
+          }
+        });
+  };
+
+  parallel_for_bags([&](const int32_t t, const int64_t b_t) {
     const auto blk_size = block_sizes_data[t];
-    const auto cur_batch_size = variable_batch_size ? batch_sizes_data[t] : B;
     const index_t* bucketize_offset = nullptr;
     int64_t bucket_size = 0;
     if (variable_bucket_sizes) {
       bucketize_offset = block_bucketize_pos.value()[t].data_ptr<index_t>();
       bucket_size = block_bucketize_pos.value()[t].numel();
     }
-    for (const auto b : c10::irange(cur_batch_size)) {
-      const auto b_t = (variable_batch_size ? cur_offset : t * B) + b;
-      const offset_t rowstart = offsets_data[b_t];
-      const offset_t rowend = offsets_data[b_t + 1];
-      for (const auto i : c10::irange(rowstart, rowend)) {
-        // We have use cases using none-hashed raw indices that can be either
-        // negative or larger than embedding table hash_size (blk_size *
-        // my_size). In cases of none-hashed indices we need to ensure
-        // bucketization can distribute them into different ranks and within
-        // range of blk_size, we expect the later embedding module to take care
-        // of hashing indices calculation.
-        uindex_t idx = static_cast<uindex_t>(indices_data[i]);
-        if (variable_bucket_sizes) {
-          int64_t lb = std::upper_bound(
-                           bucketize_offset,
-                           bucketize_offset + static_cast<index_t>(bucket_size),
-                           indices_data[i]) -
-              bucketize_offset - 1;
-          lower_bounds[i] = lb;
-          uindex_t p = lb < my_size ? lb : idx % my_size;
-          new_lengths_data[p * lengths_size + b_t]++;
-        } else {
-          uindex_t p = idx < static_cast<uindex_t>(blk_size * my_size)
-              ? idx / blk_size
-              : idx % my_size;
-          new_lengths_data[p * lengths_size + b_t]++;
-        }
+    const offset_t rowstart = offsets_data[b_t];
+    const offset_t rowend = offsets_data[b_t + 1];
+    for (const auto i : c10::irange(rowstart, rowend)) {
+      // We have use cases using none-hashed raw indices that can be either
+      // negative or larger than embedding table hash_size (blk_size *
+      // my_size). In cases of none-hashed indices we need to ensure
+      // bucketization can distribute them into different ranks and within
+      // range of blk_size, we expect the later embedding module to take care
+      // of hashing indices calculation.
+      uindex_t idx = static_cast<uindex_t>(indices_data[i]);
+      if (variable_bucket_sizes) {
+        int64_t lb = std::upper_bound(
+                         bucketize_offset,
+                         bucketize_offset + static_cast<index_t>(bucket_size),
+                         indices_data[i]) -
+            bucketize_offset - 1;
+        lower_bounds[i] = lb;
+        uindex_t p = lb < my_size ? lb : idx % my_size;
+        new_lengths_data[p * lengths_size + b_t]++;
+      } else {
+        uindex_t p = idx < static_cast<uindex_t>(blk_size * my_size)
+            ? idx / blk_size
+            : idx % my_size;
+        new_lengths_data[p * lengths_size + b_t]++;
       }
     }
-    cur_offset += cur_batch_size;
-  }
+  });
 
   // bucketize nonzeros
   prefix_sum(new_lengths_size, new_lengths_data, new_offsets_data);
   assert(new_offsets_data[new_lengths_size] == new_indices.numel());
-  cur_offset = 0;
-  for (const auto t : c10::irange(T)) {
+  parallel_for_bags([&](const int32_t t, const int64_t b_t) {
     const auto blk_size = block_sizes_data[t];
-    const auto cur_batch_size = variable_batch_size ? batch_sizes_data[t] : B;
     const index_t* bucketize_offset = nullptr;
     if (variable_bucket_sizes) {
       bucketize_offset = block_bucketize_pos.value()[t].data_ptr<index_t>();
     }
-    for (const auto b : c10::irange(cur_batch_size)) {
-      const auto b_t = (variable_batch_size ? cur_offset : t * B) + b;
-      const offset_t rowstart = offsets_data[b_t];
-      const offset_t rowend = offsets_data[b_t + 1];
-      for (const auto i : c10::irange(rowstart, rowend)) {
-        // We have use cases using none-hashed raw indices that can be either
-        // negative or larger than embedding table hash_size (blk_size *
-        // my_size). In cases of none-hashed indices we need to ensure
-        // bucketization can distribute them into different ranks and within
-        // range of blk_size, we expect the later embedding module to take care
-        // of hashing indices calculation.
-        const uindex_t idx = static_cast<uindex_t>(indices_data[i]);
-        uindex_t p, new_idx;
-        if (variable_bucket_sizes) {
-          int64_t lb = lower_bounds[i];
-          p = lb < my_size ? lb : idx % my_size;
-          new_idx = lb < my_size ? idx - bucketize_offset[lb] : idx / my_size;
+    const offset_t rowstart = offsets_data[b_t];
+    const offset_t rowend = offsets_data[b_t + 1];
+    for (const auto i : c10::irange(rowstart, rowend)) {
+      // We have use cases using none-hashed raw indices that can be either
+      // negative or larger than embedding table hash_size (blk_size *
+      // my_size). In cases of none-hashed indices we need to ensure
+      // bucketization can distribute them into different ranks and within
+      // range of blk_size, we expect the later embedding module to take care
+      // of hashing indices calculation.
+      const uindex_t idx = static_cast<uindex_t>(indices_data[i]);
+      uindex_t p, new_idx;
+      if (variable_bucket_sizes) {
+        int64_t lb = lower_bounds[i];
+        p = lb < my_size ? lb : idx % my_size;
+        new_idx = lb < my_size ? idx - bucketize_offset[lb] : idx / my_size;
 
-        } else {
-          p = idx < static_cast<uindex_t>(blk_size * my_size) ? idx / blk_size
-                                                              : idx % my_size;
-          new_idx = idx < static_cast<uindex_t>(blk_size * my_size)
-              ? idx % blk_size
-              : idx / my_size;
-        }
-        const uoffset_t pos = new_offsets_data[p * lengths_size + b_t];
-        new_indices_data[pos] = new_idx;
-        if (sequence) {
-          unbucketize_permute_data[i] = pos;
-          if constexpr (return_bucket_mapping) {
-            bag_mapping_data[i] = p;
-          }
-        }
-        new_offsets_data[p * lengths_size + b_t]++;
-        if (has_weight) {
-          new_weights_data[pos] = weights_data[i];
-        }
-        if (bucketize_pos) {
-          new_pos_data[pos] = i - rowstart;
+      } else {
+        p = idx < static_cast<uindex_t>(blk_size * my_size) ? idx / blk_size
+                                                            : idx % my_size;
+        new_idx = idx < static_cast<uindex_t>(blk_size * my_size)
+            ? idx % blk_size
+            : idx / my_size;
+      }
+      const uoffset_t pos = new_offsets_data[p * lengths_size + b_t];
+      new_indices_data[pos] = new_idx;
+      if (sequence) {
+        unbucketize_permute_data[i] = pos;
+        if constexpr (return_bucket_mapping) {
+          bag_mapping_data[i] = p;
         }
       }
+      new_offsets_data[p * lengths_size + b_t]++;
+      if (has_weight) {
+        new_weights_data[pos] = weights_data[i];
+      }
+      if (bucketize_pos) {
+        new_pos_data[pos] = i - rowstart;
+      }
     }
-    cur_offset += cur_batch_size;
-  }
+  });
 }
 
 void FloatToBFloat16Quantized_ref(
@@ -481,6 +596,49 @@ at::Tensor _float_to_bfloat16_cpu(const at::Tensor& input) {
   return output;
 }
 
+// Quantizes each table of the pooled embeddings straight to its offset in the
+// layout of permute_pooled_embs, which packs the all-to-all send buffer.
+// TODO: replace Half by BFloat16, after BFloat16 is supported by Nvidia NCCL
+at::Tensor _float_to_bfloat16_permuted_cpu(
+    const at::Tensor& pooled_embs, // [B_local][Sum_T_global(D)]
+    const at::Tensor& offset_dim_list,
+    const at::Tensor& permute_list,
+    const at::Tensor& inv_offset_dim_list) {
+  TENSOR_ON_CPU(pooled_embs);
+  TENSOR_NDIM_EQUALS(pooled_embs, 2);
+  TORCH_CHECK(offset_dim_list.numel() == permute_list.numel() + 1);
+  TORCH_CHECK(offset_dim_list.numel() == inv_offset_dim_list.numel());
+
+  const auto input = pooled_embs.contiguous();
+  const auto offset_dim_list_ = offset_dim_list.contiguous();
+  const auto permute_list_ = permute_list.contiguous();
+  const auto inv_offset_dim_list_ = inv_offset_dim_list.contiguous();
+  const int64_t B = input.size(0);
+  const int64_t T = permute_list.numel();
+  const int64_t dim_sum = input.size(1);
+
+  auto output = at::empty({B, dim_sum}, input.options().dtype(at::kHalf));
+
+  const auto* offsets = offset_dim_list_.data_ptr<int64_t>();
+  const auto* permute = permute_list_.data_ptr<int64_t>();
+  const auto* inv_offsets = inv_offset_dim_list_.data_ptr<int64_t>();
+  const auto* input_data = input.data_ptr<float>();
+  auto* output_data = reinterpret_cast<uint16_t*>(output.data_ptr<at::Half>());
+  at::parallel_for(0, B, 1, [&](int64_t start, int64_t end) {
+    for (const auto b : c10::irange(start, end)) {
+      for (const auto t : c10::irange(T)) {
+        const auto input_dim_start = offsets[permute[t]];
+        FloatToBFloat16Quantized_ref(
+            input_data + b * dim_sum + input_dim_start,
+            offsets[permute[t] + 1] - input_dim_start,
+            output_data + b * dim_sum + inv_offsets[t]);
+      }
+    }
+  });
+
+  return output;
+}
+
 // TODO: replace Half by BFloat16, after BFloat16 is supported by Nvidia NCCL
 at::Tensor _bfloat16_to_float_cpu(const at::Tensor& input) {
   TENSOR_ON_CPU(input);
@@ -542,10 +700,25 @@ void _bucketize_sparse_features_cpu(
   if (bucketize_pos) {
     new_pos_data = new_pos.value().data_ptr<index_t>();
   }
+  // Every (bucket, row) pair has its own new length and its own segment of
+  // the output, so both passes run in parallel over rows. Chunks hold about
+  // GRAIN_SIZE indices.
+  const int64_t grain_size = std::max<int64_t>(
+      1,
+      at::internal::GRAIN_SIZE * lengths_size /
+          std::max<int64_t>(indices.numel(), 1));
+  const auto parallel_for_rows = [&](const auto& bucketize_row) {
+    at::parallel_for(
+        0, lengths_size, grain_size, [&](int64_t r_begin, int64_t r_end) {
+          for (const auto r : c10::irange(r_begin, r_end)) {
+            bucketize_row(r);
+          }
+        });
+  };
   // count nonzeros
   prefix_sum(lengths_size, lengths_data, offsets_data);
   assert(offsets_data[lengths_size] == indices.numel());
-  for (const auto r : c10::irange(lengths_size)) {
+  parallel_for_rows([&](const int64_t r) {
     const index_t rowstart = offsets_data[r];
     const index_t rowend = offsets_data[r + 1];
     for (const auto i : c10::irange(rowstart, rowend)) {
@@ -555,11 +728,11 @@ void _bucketize_sparse_features_cpu(
       const uindex_t p = idx % my_size;
       new_lengths_data[p * lengths_size + r]++;
     }
-  }
+  });
   // bucketize nonzeros
   prefix_sum(new_lengths_size, new_lengths_data, new_offsets_data);
   assert(new_offsets_data[new_lengths_size] == new_indices.numel());
-  for (const auto r : c10::irange(lengths_size)) {
+  parallel_for_rows([&](const int64_t r) {
     const index_t rowstart = offsets_data[r];
     const index_t rowend = offsets_data[r + 1];
     for (const auto i : c10::irange(rowstart, rowend)) {
@@ -578,10 +751,36 @@ void _bucketize_sparse_features_cpu(
         new_pos_data[pos] = i - rowstart;
       }
     }
-  }
+  });
 }
 
-std::tuple<Tensor, Tensor, c10::optional<Tensor>> permute_2D_sparse_data_cpu(
+int64_t permute_2D_sparse_data_cpu_output_size(
+    const Tensor& permute,
+    const Tensor& lengths) {
+  TENSOR_ON_CPU(permute);
+  TENSOR_ON_CPU(lengths);
+  TORCH_CHECK(lengths.dim() == 2);
+  const auto permute_contig = permute.expect_contiguous();
+  const auto lengths_contig = lengths.expect_contiguous();
+  const auto B = lengths.size(1);
+  const auto* const permute_data = permute_contig->data_ptr<int32_t>();
+  int64_t output_size = 0;
+  AT_DISPATCH_INDEX_TYPES(
+      lengths.scalar_type(), "permute_2D_sparse_data_output_size", [&] {
+        const auto* const lengths_data = lengths_contig->data_ptr<index_t>();
+        for (const auto t : c10::irange(permute.numel())) {
+          const index_t* const row = lengths_data + permute_data[t] * B;
+          output_size += c10::sum_integers(row, row + B);
+        }
+      });
+  return output_size;
+}
+
+std::tuple<Tensor, Tensor, c10::optional<Tensor>>
+permute_2D_sparse_data_cpu_out(
+    Tensor& permuted_lengths,
+    Tensor& permuted_indices,
+    Tensor& permuted_weights_out,
     const Tensor& permute,
     const Tensor& lengths,
     const Tensor& indices,
@@ -590,10 +789,16 @@ std::tuple<Tensor, Tensor, c10::optional<Tensor>> permute_2D_sparse_data_cpu(
   TENSOR_ON_CPU(permute);
   TENSOR_ON_CPU(lengths);
   TENSOR_ON_CPU(indices);
+  TENSOR_ON_CPU(permuted_lengths);
+  TENSOR_ON_CPU(permuted_indices);
   if (weights) {
     TENSOR_ON_CPU(weights);
+    TENSOR_ON_CPU(permuted_weights_out);
+    TORCH_CHECK(permuted_weights_out.scalar_type() == weights->scalar_type());
   }
   TORCH_CHECK(lengths.dim() == 2);
+  TORCH_CHECK(permuted_lengths.scalar_type() == lengths.scalar_type());
+  TORCH_CHECK(permuted_indices.scalar_type() == indices.scalar_type());
 
   const auto permute_contig = permute.expect_contiguous();
   const auto lengths_contig = lengths.expect_contiguous();
@@ -603,11 +808,9 @@ std::tuple<Tensor, Tensor, c10::optional<Tensor>> permute_2D_sparse_data_cpu(
   const auto T = permute.numel();
   const auto B = lengths.size(1);
 
-  Tensor permuted_lengths;
-  Tensor permuted_indices;
   c10::optional<Tensor> permuted_weights;
 
-  permuted_lengths = at::empty({T, B}, lengths.options());
+  at::native::resize_(permuted_lengths, {T, B}, c10::nullopt);
 
   const auto lengths_size = lengths.numel();
   auto input_offsets = at::empty({lengths_size + 1}, lengths.options());
@@ -636,7 +839,7 @@ std::tuple<Tensor, Tensor, c10::optional<Tensor>> permute_2D_sparse_data_cpu(
     permuted_indices_size =
         output_offsets_per_thread_cumsum[num_threads * FALSE_SHARING_PAD];
   }
-  permuted_indices = at::empty(permuted_indices_size, indices.options());
+  at::native::resize_(permuted_indices, {permuted_indices_size}, c10::nullopt);
   AT_DISPATCH_INDEX_TYPES(
       input_offsets.scalar_type(), "permute_2D_indices_weights_kernel_1", [&] {
         using offsets_t = index_t;
@@ -652,8 +855,11 @@ std::tuple<Tensor, Tensor, c10::optional<Tensor>> permute_2D_sparse_data_cpu(
                     if (weights.has_value()) {
                       const auto weights_value_contig =
                           weights.value().expect_contiguous();
-                      permuted_weights = at::empty(
-                          permuted_indices_size, weights.value().options());
+                      at::native::resize_(
+                          permuted_weights_out,
+                          {permuted_indices_size},
+                          c10::nullopt);
+                      permuted_weights = permuted_weights_out;
                       _permute_2D_indices_weights_kernel_cpu<
                           true,
                           index_t,
@@ -692,6 +898,27 @@ std::tuple<Tensor, Tensor, c10::optional<Tensor>> permute_2D_sparse_data_cpu(
   return {permuted_lengths, permuted_indices, permuted_weights};
 }
 
+std::tuple<Tensor, Tensor, c10::optional<Tensor>> permute_2D_sparse_data_cpu(
+    const Tensor& permute,
+    const Tensor& lengths,
+    const Tensor& indices,
+    const c10::optional<Tensor>& weights,
+    const c10::optional<int64_t>& permuted_lengths_sum) {
+  auto permuted_lengths = at::empty({0}, lengths.options());
+  auto permuted_indices = at::empty({0}, indices.options());
+  auto permuted_weights =
+      weights.has_value() ? at::empty({0}, weights->options()) : Tensor();
+  return permute_2D_sparse_data_cpu_out(
+      permuted_lengths,
+      permuted_indices,
+      permuted_weights,
+      permute,
+      lengths,
+      indices,
+      weights,
+      permuted_lengths_sum);
+}
+
 // specialization for variable B and T,
 // the permute here maps to all items in length.
 template <typename index_t>
@@ -753,7 +980,30 @@ void _permute_1D_indices_weights_kernel_cpu(
       }); // parallel_for T x B, different B across T
 }
 
-std::tuple<Tensor, Tensor, c10::optional<Tensor>> permute_1D_sparse_data_cpu(
+int64_t permute_1D_sparse_data_cpu_output_size(
+    const Tensor& permute,
+    const Tensor& lengths) {
+  TENSOR_ON_CPU(permute);
+  TENSOR_ON_CPU(lengths);
+  const auto permute_contig = permute.expect_contiguous();
+  const auto lengths_contig = lengths.expect_contiguous();
+  const auto* const permute_data = permute_contig->data_ptr<int32_t>();
+  int64_t output_size = 0;
+  AT_DISPATCH_INDEX_TYPES(
+      lengths.scalar_type(), "permute_1D_sparse_data_output_size", [&] {
+        const auto* const lengths_data = lengths_contig->data_ptr<index_t>();
+        for (const auto i : c10::irange(permute.numel())) {
+          output_size += lengths_data[permute_data[i]];
+        }
+      });
+  return output_size;
+}
+
+std::tuple<Tensor, Tensor, c10::optional<Tensor>>
+permute_1D_sparse_data_cpu_out(
+    Tensor& permuted_lengths,
+    Tensor& permuted_indices,
+    Tensor& permuted_weights_out,
     const Tensor& permute,
     const Tensor& lengths,
     const Tensor& indices,
@@ -763,18 +1013,24 @@ std::tuple<Tensor, Tensor, c10::optional<Tensor>> permute_1D_sparse_data_cpu(
   TENSOR_ON_CPU(lengths);
   TENSOR_ON_CPU(indices);
   TENSOR_ON_CPU(weights);
+  TENSOR_ON_CPU(permuted_lengths);
+  TENSOR_ON_CPU(permuted_indices);
+  if (weights) {
+    TENSOR_ON_CPU(permuted_weights_out);
+    TORCH_CHECK(permuted_weights_out.scalar_type() == weights->scalar_type());
+  }
+  TORCH_CHECK(permuted_lengths.scalar_type() == lengths.scalar_type());
+  TORCH_CHECK(permuted_indices.scalar_type() == indices.scalar_type());
 
   const auto permute_contig = permute.expect_contiguous();
   const auto lengths_contig = lengths.expect_contiguous();
   const auto indices_contig = indices.expect_contiguous();
   // the data to permute over can be less or more with or without
   // repetitions
-  Tensor permuted_lengths;
-  Tensor permuted_indices;
-  Tensor permuted_weights;
+  c10::optional<Tensor> permuted_weights;
 
   const auto permuted_lengths_size = permute.numel();
-  permuted_lengths = at::empty({permuted_lengths_size}, lengths.options());
+  at::native::resize_(permuted_lengths, {permuted_lengths_size}, c10::nullopt);
 
   int num_threads = at::get_num_threads();
   std::vector<int64_t> output_offsets_per_thread_cumsum(
@@ -801,7 +1057,7 @@ std::tuple<Tensor, Tensor, c10::optional<Tensor>> permute_1D_sparse_data_cpu(
         output_offsets[permuted_lengths_size].item<int64_t>();
   }
 
-  permuted_indices = at::empty(permuted_indices_size, indices.options());
+  at::native::resize_(permuted_indices, {permuted_indices_size}, c10::nullopt);
   AT_DISPATCH_INDEX_TYPES(
       input_offsets.scalar_type(), "permute_1D_indices_weights_kernel_1", [&] {
         using offsets_t = index_t;
@@ -817,8 +1073,11 @@ std::tuple<Tensor, Tensor, c10::optional<Tensor>> permute_1D_sparse_data_cpu(
                     if (weights.has_value()) {
                       const auto weights_value_contig =
                           weights.value().expect_contiguous();
-                      permuted_weights = at::empty(
-                          permuted_indices_size, weights.value().options());
+                      at::native::resize_(
+                          permuted_weights_out,
+                          {permuted_indices_size},
+                          c10::nullopt);
+                      permuted_weights = permuted_weights_out;
                       _permute_1D_indices_weights_kernel_cpu<
                           true,
                           index_t,
@@ -832,7 +1091,7 @@ std::tuple<Tensor, Tensor, c10::optional<Tensor>> permute_1D_sparse_data_cpu(
                           permuted_lengths.data_ptr<offsets_t>(),
                           output_offsets.data_ptr<offsets_t>(),
                           permuted_indices.data_ptr<indices_t>(),
-                          permuted_weights.data_ptr<weights_t>());
+                          permuted_weights->data_ptr<weights_t>());
                     } else {
                       _permute_1D_indices_weights_kernel_cpu<
                           false,
@@ -856,6 +1115,27 @@ std::tuple<Tensor, Tensor, c10::optional<Tensor>> permute_1D_sparse_data_cpu(
   return {permuted_lengths, permuted_indices, permuted_weights};
 }
 
+std::tuple<Tensor, Tensor, c10::optional<Tensor>> permute_1D_sparse_data_cpu(
+    const Tensor& permute,
+    const Tensor& lengths,
+    const Tensor& indices,
+    const c10::optional<Tensor>& weights,
+    const c10::optional<int64_t>& permuted_lengths_sum) {
+  auto permuted_lengths = at::empty({0}, lengths.options());
+  auto permuted_indices = at::empty({0}, indices.options());
+  auto permuted_weights =
+      weights.has_value() ? at::empty({0}, weights->options()) : Tensor();
+  return permute_1D_sparse_data_cpu_out(
+      permuted_lengths,
+      permuted_indices,
+      permuted_weights,
+      permute,
+      lengths,
+      indices,
+      weights,
+      permuted_lengths_sum);
+}
+
 template <typename index_t, typename offsets_t>
 void _expand_into_jagged_permute_cpu_kernel(
     const offsets_t* const __restrict__ input_offsets,
@@ -876,7 +1156,8 @@ void _expand_into_jagged_permute_cpu_kernel(
       }); // parallel_for T
 }
 
-Tensor expand_into_jagged_permute_cpu(
+Tensor& expand_into_jagged_permute_cpu_out(
+    Tensor& output_permute,
     const Tensor& permute,
     const Tensor& input_offsets,
     const Tensor& output_offsets,
@@ -884,15 +1165,17 @@ Tensor expand_into_jagged_permute_cpu(
   TENSOR_ON_CPU(permute);
   TENSOR_ON_CPU(input_offsets);
   TENSOR_ON_CPU(output_offsets);
+  TENSOR_ON_CPU(output_permute);
   TORCH_CHECK(permute.numel() > 0);
   TORCH_CHECK(permute.numel() == input_offsets.numel() - 1);
   TORCH_CHECK(permute.numel() == output_offsets.numel() - 1);
+  TORCH_CHECK(output_permute.scalar_type() == input_offsets.scalar_type());
 
   const auto permute_contig = permute.contiguous();
 
   const auto permute_size = permute.numel();
 
-  Tensor output_permute = at::empty({output_size}, input_offsets.options());
+  at::native::resize_(output_permute, {output_size}, c10::nullopt);
 
   AT_DISPATCH_INDEX_TYPES(
       permute.scalar_type(), "expand_into_jagged_permute_cpu", [&] {
@@ -908,6 +1191,16 @@ Tensor expand_into_jagged_permute_cpu(
   return output_permute;
 }
 
+Tensor expand_into_jagged_permute_cpu(
+    const Tensor& permute,
+    const Tensor& input_offsets,
+    const Tensor& output_offsets,
+    int64_t output_size) {
+  Tensor output_permute = at::empty({0}, input_offsets.options());
+  return expand_into_jagged_permute_cpu_out(
+      output_permute, permute, input_offsets, output_offsets, output_size);
+}
+
 template <typename index_t>
 void _invert_permute_cpu_kernel(
     const int64_t permute_size,
@@ -1280,21 +1573,6 @@ bucketize_sparse_features_cpu(
   return {new_lengths, new_indices, new_weights, new_pos};
 }
 
-// 1D exclusive scan: output[i] = input[i-1] + input[i-2] + input[i-3]
-// Used as a helper to several functions below.
-template <class T, class U>
-U exclusive_scan_ptrs_cpu(
-    const int64_t N,
-    const T* const input,
-    U* const output) {
-  U cumsum = 0;
-  for (const auto i : c10::irange(N)) {
-    output[i] = cumsum;
-    cumsum += input[i];
-  }
-  return cumsum;
-}
-
 Tensor asynchronous_exclusive_cumsum_cpu(const Tensor& t_in) {
   TENSOR_ON_CPU(t_in);
 
@@ -1517,9 +1795,13 @@ void reorder_batched_ad_indices_cpu_(
   const auto* cat_ad_indices_data = cat_ad_indices.data_ptr<scalar_t>();
   auto* output_data = output.data_ptr<scalar_t>();
   at::parallel_for(
-      0, nB * nT, FALSE_SHARING_PAD, [&](int64_t tb_begin, int64_t tb_end) {
+      0,
+      nB * nT,
+      reorder_segments_grain_size(nB * nT, output.numel()),
+      [&](int64_t tb_begin, int64_t tb_end) {
         auto b_begin = tb_begin / nT;
         auto b_end = (tb_end + nT - 1) / nT;
+        RunCopier<scalar_t> copier;
 
         for (const auto b : c10::irange(b_begin, b_end)) {
           const auto num_ads_b =
@@ -1546,16 +1828,16 @@ void reorder_batched_ad_indices_cpu_(
 
             if (broadcast_indices) {
               for (auto j : c10::irange(num_ads_b)) {
-                for (auto i : c10::irange(num_elements)) {
-                  output_data[output_segment_start + j * num_elements + i] =
-                      cat_ad_indices_data[input_segment_start + i];
-                }
+                copier.copy(
+                    output_data + output_segment_start + j * num_elements,
+                    cat_ad_indices_data + input_segment_start,
+                    num_elements);
               }
             } else {
-              for (auto i : c10::irange(num_elements)) {
-                output_data[output_segment_start + i] =
-                    cat_ad_indices_data[input_segment_start + i];
-              }
+              copier.copy(
+                  output_data + output_segment_start,
+                  cat_ad_indices_data + input_segment_start,
+                  num_elements);
             }
           }
         }
@@ -1584,9 +1866,13 @@ void cat_reorder_batched_ad_indices_cpu_(
       reordered_cat_ad_offsets.data_ptr<index_t>();
   auto* output_data = output.data_ptr<scalar_t>();
   at::parallel_for(
-      0, nB * nT, FALSE_SHARING_PAD, [&](int64_t tb_begin, int64_t tb_end) {
+      0,
+      nB * nT,
+      reorder_segments_grain_size(nB * nT, output.numel()),
+      [&](int64_t tb_begin, int64_t tb_end) {
         auto b_begin = tb_begin / nT;
         auto b_end = (tb_end + nT - 1) / nT;
+        RunCopier<scalar_t> copier;
         for (auto b : c10::irange(b_begin, b_end)) {
           const auto* ad_indices_data = ad_indices[b].data_ptr<scalar_t>();
           const auto num_ads_b =
@@ -1613,19 +1899,18 @@ void cat_reorder_batched_ad_indices_cpu_(
             const auto input_segment_end =
                 cat_ad_offsets_data[input_segment_offset_end] - based_segment;
             const auto num_elements = input_segment_end - input_segment_start;
-            const auto data_size = num_elements * sizeof(scalar_t);
             if (broadcast_indices) {
               for (auto j : c10::irange(num_ads_b)) {
-                std::memcpy(
+                copier.copy(
                     output_data + output_segment_start + j * num_elements,
                     ad_indices_data + input_segment_start,
-                    data_size);
+                    num_elements);
               }
             } else {
-              std::memcpy(
+              copier.copy(
                   output_data + output_segment_start,
                   ad_indices_data + input_segment_start,
-                  data_size);
+                  num_elements);
             }
           }
         }
@@ -1881,8 +2166,8 @@ Tensor offsets_range_cpu(const Tensor& offsets, int64_t range_size) {
 /// `weight` -- it is caller's responsibility to keep it in sync with `weight`.
 /// Visualization of op semantics: https://fburl.com/9a4uktmb
 ///
-/// This version is only for numerical verification so not optimized for
-/// performance.
+/// The bags run in parallel, and the indices of a bag are read once for all
+/// the tasks.
 ///
 /// @param weight        - Weight for the embeddings.
 /// @param table_offsets - Index offsets for each table entry in `weight`.
@@ -1913,42 +2198,185 @@ Tensor batched_unary_embeddings_forward_cpu(
   TORCH_CHECK(table_offsets.scalar_type() == indices.scalar_type());
 
   auto output = at::empty({N, B, T}, weight.options());
+  const auto weight_contig = weight.expect_contiguous();
+  const auto table_offsets_contig = table_offsets.expect_contiguous();
+  const auto offsets_contig = offsets.expect_contiguous();
+  const auto indices_contig = indices.expect_contiguous();
 
   AT_DISPATCH_INDEX_TYPES(table_offsets.scalar_type(), "unary_indices", [&] {
     FBGEMM_DISPATCH_FLOATING_TYPES(
         weight.scalar_type(), "batched_unary_embeddings_forward_cpu", [&] {
-          const index_t* table_offsets_data = table_offsets.data_ptr<index_t>();
-          const index_t* offsets_data = offsets.data_ptr<index_t>();
-          const index_t* indices_data = indices.data_ptr<index_t>();
+          const index_t* table_offsets_data =
+              table_offsets_contig->data_ptr<index_t>();
+          const index_t* offsets_data = offsets_contig->data_ptr<index_t>();
+          const index_t* indices_data = indices_contig->data_ptr<index_t>();
           const index_t sum_E = table_offsets_data[T];
           auto* output_data = output.data_ptr<scalar_t>();
-          const auto* weight_data = weight.data_ptr<scalar_t>();
-
-          for (const auto n : c10::irange(N)) {
-            for (const auto b : c10::irange(B)) {
-              for (const auto t : c10::irange(T)) {
-                const index_t indices_start = offsets_data[t * B + b];
-                const index_t indices_end = offsets_data[t * B + b + 1];
-                float sum = 0;
-                for (const auto l : c10::irange(indices_start, indices_end)) {
-                  const index_t idx =
-                      n * sum_E + table_offsets_data[t] + indices_data[l];
-                  // Since we don't care about the performance of CPU impl,
-                  // adding the boundary check here. OOB will result in
-                  // undefined behavior for GPU impl.
-                  TORCH_CHECK(idx < weight.numel());
-                  sum += weight_data[idx];
+          const auto* weight_data = weight_contig->data_ptr<scalar_t>();
+          const int64_t num_weights = weight.numel();
+
+          // Chunks of bags (t, b) hold about GRAIN_SIZE indices of all the
+          // tasks
+          const int64_t grain_size = std::max<int64_t>(
+              1,
+              at::internal::GRAIN_SIZE * T * B /
+                  std::max<int64_t>(N * indices.numel(), 1));
+          at::parallel_for(
+              0, T * B, grain_size, [&](int64_t tb_begin, int64_t tb_end) {
+                for (const auto tb : c10::irange(tb_begin, tb_end)) {
+                  const auto t = tb / B;
+                  const auto b = tb % B;
+                  const index_t indices_start = offsets_data[tb];
+                  const index_t indices_end = offsets_data[tb + 1];
+                  for (const auto n : c10::irange(N)) {
+                    // use is_cuda=true because acc_type<float, false> =
+                    // double is too conservative
+                    at::acc_type<scalar_t, true> sum = 0;
+                    for (const auto l :
+                         c10::irange(indices_start, indices_end)) {
+                      const int64_t idx = n * sum_E + table_offsets_data[t] +
+                          indices_data[l];
+                      // OOB results in undefined behavior for the GPU impl
+                      TORCH_CHECK(idx < num_weights);
+                      sum += weight_data[idx];
+                    }
+                    output_data[(n * B + b) * T + t] = sum;
+                  }
                 }
-                output_data[(n * B + b) * T + t] = sum;
-              }
-            }
-          }
+              });
         });
   });
 
   return output;
 }
 
+/// CPU version of batched_unary_embeddings backward pass.
+///
+/// Accumulates `grad_output` [N, B, T] into the rows of a zero [N, sum_E, 1]
+/// gradient of `weight`. Tasks and tables own disjoint gradient rows, so they
+/// run in parallel; the indices of table t must be within [0, E_t).
+Tensor batched_unary_embeddings_backward_cpu(
+    const Tensor& grad_output,
+    const Tensor& weight,
+    const Tensor& table_offsets,
+    const Tensor& offsets,
+    const Tensor& indices) {
+  TENSOR_ON_CPU(grad_output);
+  TENSOR_ON_CPU(weight);
+  TENSOR_ON_CPU(table_offsets);
+  TENSOR_ON_CPU(offsets);
+  TENSOR_ON_CPU(indices);
+
+  // N: number of tasks, T: number of tables, B: batch size
+  const int32_t N = grad_output.size(0);
+  const int32_t B = grad_output.size(1);
+  const int32_t T = grad_output.size(2);
+  TORCH_CHECK(N > 0);
+  TORCH_CHECK(B > 0);
+  TORCH_CHECK(T > 0);
+  TORCH_CHECK(table_offsets.numel() == T + 1);
+  TORCH_CHECK(offsets.numel() == T * B + 1);
+  TORCH_CHECK(grad_output.scalar_type() == weight.scalar_type());
+
+  auto grad_weight = at::zeros_like(weight, at::MemoryFormat::Contiguous);
+  const auto grad_output_contig = grad_output.expect_contiguous();
+  const auto table_offsets_contig = table_offsets.expect_contiguous();
+  const auto offsets_contig = offsets.expect_contiguous();
+  const auto indices_contig = indices.expect_contiguous();
+
+  AT_DISPATCH_INDEX_TYPES(table_offsets.scalar_type(), "unary_indices", [&] {
+    FBGEMM_DISPATCH_FLOATING_TYPES(
+        grad_output.scalar_type(),
+        "batched_unary_embeddings_backward_cpu",
+        [&] {
+          const index_t* table_offsets_data =
+              table_offsets_contig->data_ptr<index_t>();
+          const index_t* offsets_data = offsets_contig->data_ptr<index_t>();
+          const index_t* indices_data = indices_contig->data_ptr<index_t>();
+          const index_t sum_E = table_offsets_data[T];
+          TORCH_CHECK(grad_weight.numel() == int64_t(N) * sum_E);
+          const auto* grad_output_data =
+              grad_output_contig->data_ptr<scalar_t>();
+          auto* grad_weight_data = grad_weight.data_ptr<scalar_t>();
+          using acc_t = at::acc_type<scalar_t, true>;
+
+          at::parallel_for(
+              0, N * T, 1, [&](int64_t nt_begin, int64_t nt_end) {
+                std::vector<acc_t> grad_acc;
+                for (const auto nt : c10::irange(nt_begin, nt_end)) {
+                  const auto n = nt / T;
+                  const auto t = nt % T;
+                  const index_t E =
+                      table_offsets_data[t + 1] - table_offsets_data[t];
+                  grad_acc.assign(E, 0);
+                  for (const auto b : c10::irange(B)) {
+                    const acc_t grad = grad_output_data[(n * B + b) * T + t];
+                    const index_t indices_start = offsets_data[t * B + b];
+                    const index_t indices_end = offsets_data[t * B + b + 1];
+                    for (const auto l :
+                         c10::irange(indices_start, indices_end)) {
+                      const index_t idx = indices_data[l];
+                      TORCH_CHECK(
+                          0 <= idx && idx < E,
+                          "Index ",
+                          idx,
+                          " of table ",
+                          t,
+                          " is out of bounds [0, ",
+                          E,
+                          ")");
+                      grad_acc[idx] += grad;
+                    }
+                  }
+                  auto* table_grad_weight =
+                      grad_weight_data + n * sum_E + table_offsets_data[t];
+                  for (const auto e : c10::irange(E)) {
+                    table_grad_weight[e] = grad_acc[e];
+                  }
+                }
+              });
+        });
+  });
+
+  return grad_weight;
+}
+
+class LookupFunctionBatchedUnaryEmbeddingCPUOp
+    : public torch::autograd::Function<
+          LookupFunctionBatchedUnaryEmbeddingCPUOp> {
+ public:
+  static torch::autograd::variable_list forward(
+      torch::autograd::AutogradContext* ctx,
+      const Tensor& weight,
+      const Tensor& table_offsets,
+      const Tensor& offsets,
+      const Tensor& indices) {
+    at::AutoDispatchBelowADInplaceOrView guard;
+    ctx->save_for_backward({weight, table_offsets, offsets, indices});
+    return {batched_unary_embeddings_forward_cpu(
+        weight, table_offsets, offsets, indices)};
+  }
+
+  static torch::autograd::variable_list backward(
+      torch::autograd::AutogradContext* ctx,
+      torch::autograd::variable_list grad_outputs) {
+    const auto saved = ctx->get_saved_variables();
+    TORCH_CHECK(grad_outputs.size() == 1);
+    auto grad_weight = batched_unary_embeddings_backward_cpu(
+        grad_outputs[0], saved[0], saved[1], saved[2], saved[3]);
+    return {grad_weight, Tensor(), Tensor(), Tensor()};
+  }
+};
+
+Tensor lookup_batched_unary_embedding_function_cpu(
+    const Tensor& weight,
+    const Tensor& table_offsets,
+    const Tensor& offsets,
+    const Tensor& indices) {
+  return LookupFunctionBatchedUnaryEmbeddingCPUOp::apply(
+      weight, table_offsets, offsets, indices)[0];
+}
+
 template <typename T>
 void _histogram_binning_calibration_cpu_kernel(
     const int64_t num_logits,
@@ -1961,22 +2389,31 @@ void _histogram_binning_calibration_cpu_kernel(
     const double* const bin_num_positives_data,
     T* const calibrated_prediction_data,
     int64_t* const bin_ids_data) {
-  for (const auto i : c10::irange(num_logits)) {
-    const T pre_sigmoid = logit_data[i] + recalibrate_value;
-    const double uncalibrated = 1.0 / (1.0 + std::exp(-pre_sigmoid));
-
-    bin_ids_data[i] = std::ceil(uncalibrated / step) - 1;
-
-    const auto curr_bin_num_examples = bin_num_examples_data[bin_ids_data[i]];
-    if (curr_bin_num_examples > bin_ctr_in_use_after) {
-      const auto curr_bin_ctr =
-          bin_num_positives_data[bin_ids_data[i]] / curr_bin_num_examples;
-      calibrated_prediction_data[i] = curr_bin_ctr * bin_ctr_weight_value +
-          uncalibrated * (1.0 - bin_ctr_weight_value);
-    } else {
-      calibrated_prediction_data[i] = uncalibrated;
-    }
-  }
+  at::parallel_for(
+      0,
+      num_logits,
+      kCalibrationGrainSize,
+      [&](int64_t logit_begin, int64_t logit_end) {
+        for (const auto i : c10::irange(logit_begin, logit_end)) {
+          const T pre_sigmoid = logit_data[i] + recalibrate_value;
+          const double uncalibrated = 1.0 / (1.0 + std::exp(-pre_sigmoid));
+
+          bin_ids_data[i] = std::ceil(uncalibrated / step) - 1;
+
+          const auto curr_bin_num_examples =
+              bin_num_examples_data[bin_ids_data[i]];
+          if (curr_bin_num_examples > bin_ctr_in_use_after) {
+            const auto curr_bin_ctr =
+                bin_num_positives_data[bin_ids_data[i]] /
+                curr_bin_num_examples;
+            calibrated_prediction_data[i] =
+                curr_bin_ctr * bin_ctr_weight_value +
+                uncalibrated * (1.0 - bin_ctr_weight_value);
+          } else {
+            calibrated_prediction_data[i] = uncalibrated;
+          }
+        }
+      });
 }
 
 std::tuple<Tensor, Tensor> histogram_binning_calibration_cpu(
@@ -2031,27 +2468,37 @@ void _histogram_binning_calibration_by_feature_cpu_kernel(
     const double* const bin_num_positives_data,
     LogitType* const calibrated_prediction_data,
     int64_t* const bin_ids_data) {
-  for (const auto i : c10::irange(num_logits)) {
-    const LogitType pre_sigmoid = logit_data[i] + recalibrate_value;
-    const double uncalibrated = 1.0 / (1.0 + std::exp(-pre_sigmoid));
-
-    const int64_t curr_segment_value =
-        dense_segment_value_data[i] > num_segments
-        ? 0
-        : std::max(0L, dense_segment_value_data[i] * num_bins);
-
-    bin_ids_data[i] = (std::ceil(uncalibrated / step) - 1) + curr_segment_value;
-
-    const auto curr_bin_num_examples = bin_num_examples_data[bin_ids_data[i]];
-    if (curr_bin_num_examples > bin_ctr_in_use_after) {
-      const auto curr_bin_ctr =
-          bin_num_positives_data[bin_ids_data[i]] / curr_bin_num_examples;
-      calibrated_prediction_data[i] = curr_bin_ctr * bin_ctr_weight_value +
-          uncalibrated * (1.0 - bin_ctr_weight_value);
-    } else {
-      calibrated_prediction_data[i] = uncalibrated;
-    }
-  }
+  at::parallel_for(
+      0,
+      num_logits,
+      kCalibrationGrainSize,
+      [&](int64_t logit_begin, int64_t logit_end) {
+        for (const auto i : c10::irange(logit_begin, logit_end)) {
+          const LogitType pre_sigmoid = logit_data[i] + recalibrate_value;
+          const double uncalibrated = 1.0 / (1.0 + std::exp(-pre_sigmoid));
+
+          const int64_t curr_segment_value =
+              dense_segment_value_data[i] > num_segments
+              ? 0
+              : std::max(0L, dense_segment_value_data[i] * num_bins);
+
+          bin_ids_data[i] =
+              (std::ceil(uncalibrated / step) - 1) + curr_segment_value;
+
+          const auto curr_bin_num_examples =
+              bin_num_examples_data[bin_ids_data[i]];
+          if (curr_bin_num_examples > bin_ctr_in_use_after) {
+            const auto curr_bin_ctr =
+                bin_num_positives_data[bin_ids_data[i]] /
+                curr_bin_num_examples;
+            calibrated_prediction_data[i] =
+                curr_bin_ctr * bin_ctr_weight_value +
+                uncalibrated * (1.0 - bin_ctr_weight_value);
+          } else {
+            calibrated_prediction_data[i] = uncalibrated;
+          }
+        }
+      });
 }
 
 std::tuple<Tensor, Tensor> histogram_binning_calibration_by_feature_cpu(
@@ -2143,32 +2590,39 @@ void _generic_histogram_binning_calibration_by_feature_cpu_kernel(
     const double* const bin_boundaries,
     LogitType* const calibrated_prediction_data,
     int64_t* const bin_ids_data) {
-  for (const auto i : c10::irange(num_logits)) {
-    const LogitType pre_sigmoid = logit_data[i] + recalibrate_value;
-    const double uncalibrated = 1.0 / (1.0 + std::exp(-pre_sigmoid));
-
-    const int curr_bin_id =
-        std::lower_bound(
-            bin_boundaries, bin_boundaries + num_bins - 1, uncalibrated) -
-        bin_boundaries;
-
-    const int64_t curr_segment_value =
-        dense_segment_value_data[i] > num_segments
-        ? 0
-        : std::max(0L, dense_segment_value_data[i] * num_bins);
-
-    bin_ids_data[i] = curr_bin_id + curr_segment_value;
-
-    const auto curr_bin_num_examples = bin_num_examples_data[bin_ids_data[i]];
-    if (curr_bin_num_examples > bin_ctr_in_use_after) {
-      const auto curr_bin_ctr =
-          bin_num_positives_data[bin_ids_data[i]] / curr_bin_num_examples;
-      calibrated_prediction_data[i] = curr_bin_ctr * bin_ctr_weight_value +
-          uncalibrated * (1.0 - bin_ctr_weight_value);
-    } else {
-      calibrated_prediction_data[i] = uncalibrated;
-    }
-  }
+  const EytzingerBoundaries boundaries(bin_boundaries, num_bins - 1);
+  at::parallel_for(
+      0,
+      num_logits,
+      kCalibrationGrainSize,
+      [&](int64_t logit_begin, int64_t logit_end) {
+        for (const auto i : c10::irange(logit_begin, logit_end)) {
+          const LogitType pre_sigmoid = logit_data[i] + recalibrate_value;
+          const double uncalibrated = 1.0 / (1.0 + std::exp(-pre_sigmoid));
+
+          const int curr_bin_id = boundaries.lower_bound(uncalibrated);
+
+          const int64_t curr_segment_value =
+              dense_segment_value_data[i] > num_segments
+              ? 0
+              : std::max(0L, dense_segment_value_data[i] * num_bins);
+
+          bin_ids_data[i] = curr_bin_id + curr_segment_value;
+
+          const auto curr_bin_num_examples =
+              bin_num_examples_data[bin_ids_data[i]];
+          if (curr_bin_num_examples > bin_ctr_in_use_after) {
+            const auto curr_bin_ctr =
+                bin_num_positives_data[bin_ids_data[i]] /
+                curr_bin_num_examples;
+            calibrated_prediction_data[i] =
+                curr_bin_ctr * bin_ctr_weight_value +
+                uncalibrated * (1.0 - bin_ctr_weight_value);
+          } else {
+            calibrated_prediction_data[i] = uncalibrated;
+          }
+        }
+      });
 }
 
 std::tuple<Tensor, Tensor> generic_histogram_binning_calibration_by_feature_cpu(
@@ -2252,15 +2706,38 @@ void _segment_sum_csr_cpu_kernel(
     const int* const csr_seg_data,
     const scalar_t* const values_data,
     scalar_t* const output_data) {
-  for (const auto i : c10::irange(num_segments)) {
-    const int seg_start = csr_seg_data[i] * batch_size;
-    const int seg_end = csr_seg_data[i + 1] * batch_size;
-    scalar_t v = 0;
-    for (const auto j : c10::irange(seg_start, seg_end)) {
-      v += values_data[j];
-    }
-    output_data[i] = v;
-  }
+  // Segments are summed in kLanes independent partial sums that the compiler
+  // keeps in a vector register, and chunks of segments hold about GRAIN_SIZE
+  // values
+  constexpr int kLanes = 8;
+  const int64_t num_values =
+      num_segments > 0 ? int64_t(csr_seg_data[num_segments]) * batch_size : 0;
+  const int64_t grain_size = std::max<int64_t>(
+      1,
+      at::internal::GRAIN_SIZE * num_segments /
+          std::max<int64_t>(num_values, 1));
+  at::parallel_for(
+      0, num_segments, grain_size, [&](int64_t seg_begin, int64_t seg_end) {
+        for (const auto i : c10::irange(seg_begin, seg_end)) {
+          const int64_t start = int64_t(csr_seg_data[i]) * batch_size;
+          const int64_t end = int64_t(csr_seg_data[i + 1]) * batch_size;
+          scalar_t lanes[kLanes] = {};
+          int64_t j = start;
+          for (; j + kLanes <= end; j += kLanes) {
+            for (const auto k : c10::irange(kLanes)) {
+              lanes[k] += values_data[j + k];
+            }
+          }
+          scalar_t v = 0;
+          for (const auto k : c10::irange(kLanes)) {
+            v += lanes[k];
+          }
+          for (; j < end; ++j) {
+            v += values_data[j];
+          }
+          output_data[i] = v;
+        }
+      });
 }
 
 Tensor segment_sum_csr_cpu(
@@ -2305,6 +2782,147 @@ bool should_prune(
       min_save_ratio * original_size;
 }
 
+void check_rowwise_prune_inputs(
+    const Tensor& weights,
+    const Tensor& indicator,
+    const double threshold,
+    const at::ScalarType compressed_indices_dtype) {
+  TENSOR_ON_CPU(weights);
+  TENSOR_ON_CPU(indicator);
+  TENSOR_NDIM_EQUALS(weights, 2);
+  TORCH_CHECK(
+      indicator.numel() == weights.sizes()[0],
+      "Number of elements in 'indicator' should be equivalent to "
+      "number of rows in 'weights'.")
+  TORCH_CHECK(
+      threshold >= 0.0, "Threshold should be greater than or equal to zero.");
+  TORCH_CHECK(
+      compressed_indices_dtype == at::ScalarType::Int ||
+          compressed_indices_dtype == at::ScalarType::Long,
+      "'compressed_indices_dtype' should be Int/Long.");
+}
+
+// embedding_bag_rowwise_prune without the min_save_ratio check, into
+// pruned_weights and compressed_indices_mapping (whose dtype is the
+// compressed indices dtype). Outputs whose storage has room for the unpruned
+// sizes, e.g. from torch.from_file over a memory mapped file, are written in
+// place without reallocation.
+std::tuple<Tensor, Tensor> embedding_bag_rowwise_prune_out(
+    Tensor& pruned_weights,
+    Tensor& compressed_indices_mapping,
+    const Tensor& weights,
+    const Tensor& indicator,
+    const double threshold,
+    const bool abs,
+    const int64_t min_non_pruned_rows) {
+  check_rowwise_prune_inputs(
+      weights, indicator, threshold, compressed_indices_mapping.scalar_type());
+  TENSOR_ON_CPU(pruned_weights);
+  TENSOR_ON_CPU(compressed_indices_mapping);
+  TORCH_CHECK(pruned_weights.scalar_type() == weights.scalar_type());
+
+  const auto weights_contig = weights.expect_contiguous();
+  const auto indicator_contig = indicator.expect_contiguous();
+  const auto* const indicator_data = indicator_contig->data_ptr<float>();
+  const int64_t num_rows = weights.size(0);
+  const auto keep_row = [&](const int64_t i) {
+    const float val = abs ? std::abs(indicator_data[i]) : indicator_data[i];
+    return val > threshold;
+  };
+
+  // The rows are split into one chunk per thread: the kept rows of every
+  // chunk are counted, then each chunk is compacted from the number of rows
+  // kept before it
+  constexpr int64_t kMinChunkSize = 1 << 14;
+  const int64_t num_chunks = std::max<int64_t>(
+      1,
+      std::min<int64_t>(
+          at::get_num_threads(),
+          (num_rows + kMinChunkSize - 1) / kMinChunkSize));
+  const int64_t chunk_size = (num_rows + num_chunks - 1) / num_chunks;
+  const auto chunk_begin = [&](const int64_t c) {
+    return std::min(c * chunk_size, num_rows);
+  };
+  std::vector<int64_t> chunk_kept(num_chunks + 1, 0);
+  at::parallel_for(0, num_chunks, 1, [&](int64_t c_begin, int64_t c_end) {
+    for (const auto c : c10::irange(c_begin, c_end)) {
+      int64_t kept = 0;
+      for (const auto i : c10::irange(chunk_begin(c), chunk_begin(c + 1))) {
+        kept += keep_row(i);
+      }
+      chunk_kept[c + 1] = kept;
+    }
+  });
+  for (const auto c : c10::irange(num_chunks)) {
+    chunk_kept[c + 1] += chunk_kept[c];
+  }
+
+  // The total number of rows post-pruning should be greater than or equal
+  // to 'min_non_pruned_rows', so all the rows from the first row i where the
+  // rows kept before i and the rows left from i are at most
+  // 'min_non_pruned_rows' are kept. The rows kept before i plus the rows
+  // left never increase with i.
+  const auto must_keep_rest = [&](const int64_t kept_before, const int64_t i) {
+    return kept_before + (num_rows - i) <= min_non_pruned_rows;
+  };
+  int64_t keep_all_from = num_rows;
+  int64_t kept_before_keep_all = chunk_kept[num_chunks];
+  for (const auto c : c10::irange(num_chunks)) {
+    if (!must_keep_rest(chunk_kept[c + 1], chunk_begin(c + 1))) {
+      continue;
+    }
+    int64_t kept = chunk_kept[c];
+    for (auto i = chunk_begin(c); i <= chunk_begin(c + 1); ++i) {
+      if (must_keep_rest(kept, i)) {
+        keep_all_from = i;
+        kept_before_keep_all = kept;
+        break;
+      }
+      kept += keep_row(i);
+    }
+    break;
+  }
+  const int64_t num_kept = kept_before_keep_all + (num_rows - keep_all_from);
+
+  const int64_t num_cols = weights.size(1);
+  at::native::resize_(pruned_weights, {num_kept, num_cols}, c10::nullopt);
+  at::native::resize_(compressed_indices_mapping, {num_rows}, c10::nullopt);
+  const auto row_bytes = num_cols * weights.element_size();
+  const auto* const weights_data =
+      static_cast<const char*>(weights_contig->data_ptr());
+  auto* const pruned_weights_data =
+      static_cast<char*>(pruned_weights.data_ptr());
+  AT_DISPATCH_INDEX_TYPES(
+      compressed_indices_mapping.scalar_type(),
+      "embedding_bag_rowwise_prune_out",
+      [&] {
+        auto* const mapping_data =
+            compressed_indices_mapping.data_ptr<index_t>();
+        at::parallel_for(
+            0, num_chunks, 1, [&](int64_t c_begin, int64_t c_end) {
+              for (const auto c : c10::irange(c_begin, c_end)) {
+                const auto begin = chunk_begin(c);
+                int64_t pos = begin <= keep_all_from
+                    ? chunk_kept[c]
+                    : kept_before_keep_all + (begin - keep_all_from);
+                for (const auto i : c10::irange(begin, chunk_begin(c + 1))) {
+                  if (i >= keep_all_from || keep_row(i)) {
+                    std::memcpy(
+                        pruned_weights_data + pos * row_bytes,
+                        weights_data + i * row_bytes,
+                        row_bytes);
+                    mapping_data[i] = pos++;
+                  } else {
+                    mapping_data[i] = -1;
+                  }
+                }
+              }
+            });
+      });
+
+  return {pruned_weights, compressed_indices_mapping};
+}
+
 // This operator introduces sparsity to a weight matrix by applying
 // magnitude based pruning at a row level. The importance level of a row is
 // specified using an 'indicator' vector which contains a single value per
@@ -2352,42 +2970,8 @@ std::tuple<Tensor, Tensor> embedding_bag_rowwise_prune(
     const bool abs,
     const int64_t min_non_pruned_rows,
     const c10::optional<double>& min_save_ratio) {
-  TENSOR_ON_CPU(weights);
-  TENSOR_ON_CPU(indicator);
-  TENSOR_NDIM_EQUALS(weights, 2);
-  TORCH_CHECK(
-      indicator.numel() == weights.sizes()[0],
-      "Number of elements in 'indicator' should be equivalent to "
-      "number of rows in 'weights'.")
-  TORCH_CHECK(
-      threshold >= 0.0, "Threshold should be greater than or equal to zero.");
-  TORCH_CHECK(
-      compressed_indices_dtype == at::ScalarType::Int ||
-          compressed_indices_dtype == at::ScalarType::Long,
-      "'compressed_indices_dtype' should be Int/Long.");
-
-  const auto indicator_contig = indicator.expect_contiguous();
-  const auto indicator_data = indicator_contig->data_ptr<float>();
-  auto rowwise_prune_mask = at::empty({indicator.numel()}, at::kBool);
-  int num_kept = 0;
-  for (const auto i : c10::irange(indicator.numel())) {
-    const float val = abs ? std::abs(indicator_data[i]) : indicator_data[i];
-    bool should_keep_row = val > threshold;
-
-    // The total number of rows post-pruning should be greater than or equal
-    // to 'min_non_pruned_rows'.
-    // Skip pruning the current row to satisfy the above criteria.
-    if (num_kept < min_non_pruned_rows &&
-        num_kept + (indicator.numel() - i) <= min_non_pruned_rows) {
-      should_keep_row = true;
-    }
-    if (!should_keep_row) {
-      rowwise_prune_mask[i] = false;
-      continue;
-    }
-    rowwise_prune_mask[i] = true;
-    num_kept++;
-  }
+  check_rowwise_prune_inputs(
+      weights, indicator, threshold, compressed_indices_dtype);
 
   if (min_save_ratio.has_value() &&
       !should_prune(weights, min_non_pruned_rows, min_save_ratio.value())) {
@@ -2396,8 +2980,16 @@ std::tuple<Tensor, Tensor> embedding_bag_rowwise_prune(
     return std::tuple<Tensor, Tensor>(weights, compressed_indices_mapping);
   }
 
-  return at::native::_rowwise_prune(
-      weights, rowwise_prune_mask, compressed_indices_dtype);
+  auto pruned_weights = at::empty({0, weights.size(1)}, weights.options());
+  auto compressed_indices_mapping = at::empty({0}, compressed_indices_dtype);
+  return embedding_bag_rowwise_prune_out(
+      pruned_weights,
+      compressed_indices_mapping,
+      weights,
+      indicator,
+      threshold,
+      abs,
+      min_non_pruned_rows);
 }
 
 Tensor& lengths_range_out(
@@ -3017,6 +3609,48 @@ Tensor bottom_k_per_row(
   return use_fixed_k ? output.reshape({input.size(0), -1, fixed_k}) : output;
 }
 
+// The permute out ops resize their output arguments in place, and return
+// nothing so that their schemas do not return aliases of the arguments.
+void permute_2D_sparse_data_out_op(
+    Tensor& permuted_lengths,
+    Tensor& permuted_indices,
+    Tensor& permuted_weights,
+    const Tensor& permute,
+    const Tensor& lengths,
+    const Tensor& indices,
+    const c10::optional<Tensor>& weights,
+    const c10::optional<int64_t>& permuted_lengths_sum) {
+  permute_2D_sparse_data_cpu_out(
+      permuted_lengths,
+      permuted_indices,
+      permuted_weights,
+      permute,
+      lengths,
+      indices,
+      weights,
+      permuted_lengths_sum);
+}
+
+void permute_1D_sparse_data_out_op(
+    Tensor& permuted_lengths,
+    Tensor& permuted_indices,
+    Tensor& permuted_weights,
+    const Tensor& permute,
+    const Tensor& lengths,
+    const Tensor& indices,
+    const c10::optional<Tensor>& weights,
+    const c10::optional<int64_t>& permuted_lengths_sum) {
+  permute_1D_sparse_data_cpu_out(
+      permuted_lengths,
+      permuted_indices,
+      permuted_weights,
+      permute,
+      lengths,
+      indices,
+      weights,
+      permuted_lengths_sum);
+}
+
 } // namespace
 
 } // namespace fbgemm_gpu
@@ -3035,10 +3669,20 @@ TORCH_LIBRARY_FRAGMENT(fbgemm, m) {
   m.def(
       "permute_1D_sparse_data(Tensor permute, Tensor lengths, Tensor values, Tensor? weights=None, SymInt? permuted_lengths_sum=None) -> (Tensor, Tensor, Tensor?)",
       {PT2_COMPLIANT_TAG});
+  m.def(
+      "permute_2D_sparse_data_out(Tensor(a!) permuted_lengths, Tensor(b!) permuted_values, Tensor(c!) permuted_weights, Tensor permute, Tensor lengths, Tensor values, Tensor? weights=None, SymInt? permuted_lengths_sum=None) -> ()");
+  m.def(
+      "permute_1D_sparse_data_out(Tensor(a!) permuted_lengths, Tensor(b!) permuted_values, Tensor(c!) permuted_weights, Tensor permute, Tensor lengths, Tensor values, Tensor? weights=None, SymInt? permuted_lengths_sum=None) -> ()");
+  m.def(
+      "permute_2D_sparse_data_output_size(Tensor permute, Tensor lengths) -> int");
+  m.def(
+      "permute_1D_sparse_data_output_size(Tensor permute, Tensor lengths) -> int");
   m.def("invert_permute(Tensor permute) -> Tensor");
   m.def(
       "expand_into_jagged_permute(Tensor permute, Tensor input_offset, Tensor output_offset, SymInt output_size) -> Tensor",
       {PT2_COMPLIANT_TAG});
+  m.def(
+      "expand_into_jagged_permute_out(Tensor(a!) output_permute, Tensor permute, Tensor input_offset, Tensor output_offset, SymInt output_size) -> Tensor(a!)");
   m.def(
       "populate_bucketized_permute(Tensor lengths, Tensor bucketized_lengths, Tensor bucket_mapping) -> Tensor");
   m.def(
@@ -3087,6 +3731,8 @@ TORCH_LIBRARY_FRAGMENT(fbgemm, m) {
       {PT2_COMPLIANT_TAG});
   m.def("Bfloat16QuantizedToFloat(Tensor input) -> Tensor");
   m.def("FloatToBfloat16Quantized(Tensor input) -> Tensor");
+  m.def(
+      "FloatToBfloat16QuantizedPermuted(Tensor pooled_embs, Tensor offset_dim_list, Tensor permute_list, Tensor inv_offset_dim_list) -> Tensor");
   m.def(
       "permute102_baddbmm_permute102(Tensor bias, Tensor A, Tensor B) -> Tensor");
   m.def(
@@ -3144,9 +3790,22 @@ TORCH_LIBRARY_IMPL(fbgemm, CPU, m) {
       "permute_2D_sparse_data", fbgemm_gpu::permute_2D_sparse_data_cpu);
   DISPATCH_TO_CPU(
       "permute_1D_sparse_data", fbgemm_gpu::permute_1D_sparse_data_cpu);
+  DISPATCH_TO_CPU(
+      "permute_2D_sparse_data_out", fbgemm_gpu::permute_2D_sparse_data_out_op);
+  DISPATCH_TO_CPU(
+      "permute_1D_sparse_data_out", fbgemm_gpu::permute_1D_sparse_data_out_op);
+  DISPATCH_TO_CPU(
+      "permute_2D_sparse_data_output_size",
+      fbgemm_gpu::permute_2D_sparse_data_cpu_output_size);
+  DISPATCH_TO_CPU(
+      "permute_1D_sparse_data_output_size",
+      fbgemm_gpu::permute_1D_sparse_data_cpu_output_size);
   DISPATCH_TO_CPU("invert_permute", fbgemm_gpu::invert_permute_cpu);
   DISPATCH_TO_CPU(
       "expand_into_jagged_permute", fbgemm_gpu::expand_into_jagged_permute_cpu);
+  DISPATCH_TO_CPU(
+      "expand_into_jagged_permute_out",
+      fbgemm_gpu::expand_into_jagged_permute_cpu_out);
   DISPATCH_TO_CPU(
       "populate_bucketized_permute",
       fbgemm_gpu::populate_bucketized_permute_cpu);
@@ -3199,6 +3858,9 @@ TORCH_LIBRARY_IMPL(fbgemm, CPU, m) {
       "permute_sparse_features", fbgemm_gpu::permute_sparse_features_cpu);
   DISPATCH_TO_CPU(
       "FloatToBfloat16Quantized", fbgemm_gpu::_float_to_bfloat16_cpu);
+  DISPATCH_TO_CPU(
+      "FloatToBfloat16QuantizedPermuted",
+      fbgemm_gpu::_float_to_bfloat16_permuted_cpu);
   DISPATCH_TO_CPU(
       "Bfloat16QuantizedToFloat", fbgemm_gpu::_bfloat16_to_float_cpu);
   DISPATCH_TO_CPU(
@@ -3228,6 +3890,9 @@ TORCH_LIBRARY_IMPL(fbgemm, Autograd, m) {
 
 TORCH_LIBRARY_IMPL(fbgemm, AutogradCPU, m) {
   m.impl("group_index_select_dim0", &fbgemm_gpu::group_index_select_dim0);
+  m.impl(
+      "batched_unary_embeddings",
+      &fbgemm_gpu::lookup_batched_unary_embedding_function_cpu);
 }
 
 TORCH_LIBRARY_IMPL(fbgemm, Meta, m) {
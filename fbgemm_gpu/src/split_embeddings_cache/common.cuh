@@ -71,6 +71,16 @@ cache_slot(const int64_t h_in, const int32_t C) {
   return h % (uint32_t)C;
 }
 
+// Column of idx in the row of the count-min sketch of the TinyLFU admission
+// filter, each row hashing idx with a different seed
+__host__ DEVICE_INLINE uint32_t admission_sketch_column(
+    const int64_t idx,
+    const int32_t row,
+    const int32_t width) {
+  return cache_slot(
+      idx ^ static_cast<int64_t>(0x9e3779b97f4a7c15ULL * (row + 1)), width);
+}
+
 // Experiments showed that performance of lru/lxu_cache_find_uncached_kernel is
 // not sensitive to grid size as long as the number thread blocks per SM is not
 // too small nor too big.
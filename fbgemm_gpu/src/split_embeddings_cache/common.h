@@ -87,6 +87,38 @@ void lfu_cache_populate_byte_cpu(
     Tensor lfu_state,
     int64_t row_alignment);
 
+void lru_cache_populate_cpu(
+    Tensor weights,
+    Tensor cache_hash_size_cumsum,
+    int64_t total_cache_hash_size,
+    Tensor cache_index_table_map,
+    Tensor weights_offsets,
+    Tensor D_offsets,
+    Tensor linear_cache_indices,
+    Tensor lxu_cache_state,
+    Tensor lxu_cache_weights,
+    int64_t time_stamp,
+    Tensor lru_state,
+    bool stochastic_rounding,
+    bool gather_cache_stats,
+    c10::optional<Tensor> uvm_cache_stats,
+    bool lock_cache_line,
+    c10::optional<Tensor> lxu_cache_locking_counter,
+    c10::optional<Tensor> admission_sketch);
+
+void lfu_cache_populate_cpu(
+    Tensor weights,
+    Tensor cache_hash_size_cumsum,
+    int64_t total_cache_hash_size,
+    Tensor cache_index_table_map,
+    Tensor weights_offsets,
+    Tensor D_offsets,
+    Tensor linear_cache_indices,
+    Tensor lxu_cache_state,
+    Tensor lxu_cache_weights,
+    Tensor lfu_state,
+    bool stochastic_rounding);
+
 Tensor lxu_cache_lookup_cpu(
     Tensor linear_cache_indices,
     Tensor lxu_cache_state,
@@ -103,4 +135,15 @@ Tensor direct_mapped_lxu_cache_lookup_cpu(
     bool gather_cache_stats,
     c10::optional<Tensor> uvm_cache_stats);
 
+void lxu_cache_flush_cpu(
+    Tensor uvm_weights,
+    Tensor cache_hash_size_cumsum,
+    Tensor cache_index_table_map,
+    Tensor weights_offsets,
+    Tensor D_offsets,
+    int64_t total_D,
+    Tensor lxu_cache_state,
+    Tensor lxu_cache_weights,
+    bool stochastic_rounding);
+
 } // namespace fbgemm_gpu
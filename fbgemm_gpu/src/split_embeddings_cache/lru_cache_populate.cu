@@ -13,6 +13,45 @@ using namespace fbgemm_gpu;
 
 namespace {
 
+// Counts the accesses of the unique indices in the count-min sketch
+__global__ __launch_bounds__(kMaxThreads) void admission_sketch_update_kernel(
+    const pta::PackedTensorAccessor32<int64_t, 1, at::RestrictPtrTraits>
+        unique_indices,
+    const int32_t* __restrict__ N_unique,
+    const int64_t max_indices,
+    pta::PackedTensorAccessor32<int32_t, 2, at::RestrictPtrTraits>
+        admission_sketch) {
+  const int32_t width = admission_sketch.size(1);
+  for (int32_t n = blockIdx.x * blockDim.x + threadIdx.x; n < *N_unique;
+       n += gridDim.x * blockDim.x) {
+    const int64_t idx = unique_indices[n];
+    if (idx == max_indices) {
+      continue;
+    }
+#pragma unroll
+    for (int32_t row = 0; row < kAdmissionSketchDepth; ++row) {
+      gpuAtomicAdd(
+          &admission_sketch[row][admission_sketch_column(idx, row, width)], 1);
+    }
+  }
+}
+
+// Estimated number of accesses of idx, the minimum of its counters
+DEVICE_INLINE int32_t admission_sketch_estimate(
+    const pta::PackedTensorAccessor32<int32_t, 2, at::RestrictPtrTraits>&
+        admission_sketch,
+    const int64_t idx) {
+  const int32_t width = admission_sketch.size(1);
+  int32_t estimate = admission_sketch[0][admission_sketch_column(idx, 0, width)];
+#pragma unroll
+  for (int32_t row = 1; row < kAdmissionSketchDepth; ++row) {
+    estimate = min(
+        estimate,
+        admission_sketch[row][admission_sketch_column(idx, row, width)]);
+  }
+  return estimate;
+}
+
 template <typename emb_t, typename cache_t>
 __global__ __launch_bounds__(kMaxThreads) void lru_cache_insert_kernel(
     pta::PackedTensorAccessor64<emb_t, 1, at::RestrictPtrTraits> weights,
@@ -42,9 +81,13 @@ __global__ __launch_bounds__(kMaxThreads) void lru_cache_insert_kernel(
         uvm_cache_stats,
     const bool lock_cache_line,
     pta::PackedTensorAccessor32<int32_t, 2, at::RestrictPtrTraits>
-        lxu_cache_locking_counter) {
+        lxu_cache_locking_counter,
+    const bool admission_filter,
+    const pta::PackedTensorAccessor32<int32_t, 2, at::RestrictPtrTraits>
+        admission_sketch) {
   const int32_t C = lxu_cache_state.size(0);
   int32_t n_conflict_misses = 0;
+  int32_t n_rejected_misses = 0;
   for (int32_t n = blockIdx.x * blockDim.y + threadIdx.y; n < *N_unique;
        n += gridDim.x * blockDim.y) {
     // check if this warp is responsible for this whole segment.
@@ -66,7 +109,8 @@ __global__ __launch_bounds__(kMaxThreads) void lru_cache_insert_kernel(
     while (n + SL < *N_unique && sorted_cache_sets[n + SL] == cache_set) {
       SL += 1;
     }
-    int32_t n_inserted = 0; // also used as index to insert
+    int32_t n_inserted = 0;
+    int32_t n_rejected = 0; // n_inserted + n_rejected is the index to insert
 
     // now, we need to insert the (unique!) values in indices[n:n + SL] into
     // our slots.
@@ -94,7 +138,8 @@ __global__ __launch_bounds__(kMaxThreads) void lru_cache_insert_kernel(
       if (insert_current_lru_cost == time_stamp) {
         break;
       }
-      const int64_t insert_idx = cache_set_sorted_indices[n + n_inserted];
+      const int64_t insert_idx =
+          cache_set_sorted_indices[n + n_inserted + n_rejected];
       const int32_t t_insert = cache_index_table_map[insert_idx];
       const int64_t idx_insert = insert_idx - cache_hash_size_cumsum[t_insert];
       const int64_t weights_offset_insert = weights_offsets[t_insert];
@@ -108,6 +153,21 @@ __global__ __launch_bounds__(kMaxThreads) void lru_cache_insert_kernel(
           threadIdx.x == 0 ? lxu_cache_state[cache_set][insert_slot] : 0;
       current_idx = shfl_sync(current_idx, 0);
 
+      // TinyLFU: only admit the row if it is more frequently accessed than
+      // the row it would evict
+      if (admission_filter &&
+          current_idx != static_cast<int64_t>(kCacheStateInvalid)) {
+        int32_t admit = 0;
+        if (threadIdx.x == 0) {
+          admit = admission_sketch_estimate(admission_sketch, insert_idx) >
+              admission_sketch_estimate(admission_sketch, current_idx);
+        }
+        if (!shfl_sync(admit, 0)) {
+          n_rejected++;
+          continue;
+        }
+      }
+
       // not empty
       if (current_idx != static_cast<int64_t>(kCacheStateInvalid)) {
         // evict from slot to backing storage
@@ -161,13 +221,19 @@ __global__ __launch_bounds__(kMaxThreads) void lru_cache_insert_kernel(
 
       n_inserted++;
     }
-    n_conflict_misses += (SL - n_inserted);
+    n_conflict_misses += (SL - n_inserted - n_rejected);
+    n_rejected_misses += n_rejected;
   }
   if (gather_cache_stats && n_conflict_misses > 0 && threadIdx.x == 0) {
     atomicAdd(
         &uvm_cache_stats[uvm_cache_stats_index::num_conflict_unique_misses],
         n_conflict_misses);
   }
+  if (gather_cache_stats && n_rejected_misses > 0 && threadIdx.x == 0) {
+    atomicAdd(
+        &uvm_cache_stats[uvm_cache_stats_index::num_rejected_unique_misses],
+        n_rejected_misses);
+  }
 }
 
 void lru_cache_insert_cuda(
@@ -187,7 +253,9 @@ void lru_cache_insert_cuda(
     bool gather_cache_stats,
     Tensor uvm_cache_stats,
     bool lock_cache_line,
-    Tensor lxu_cache_locking_counter) {
+    Tensor lxu_cache_locking_counter,
+    bool admission_filter,
+    Tensor admission_sketch) {
   TENSORS_ON_SAME_CUDA_GPU_IF_NOT_OPTIONAL(
       weights,
       cache_hash_size_cumsum,
@@ -201,7 +269,8 @@ void lru_cache_insert_cuda(
       lxu_cache_weights,
       lru_state,
       uvm_cache_stats,
-      lxu_cache_locking_counter);
+      lxu_cache_locking_counter,
+      admission_sketch);
 
   CUDA_DEVICE_GUARD(weights);
 
@@ -265,7 +334,10 @@ void lru_cache_insert_cuda(
                 MAKE_PTA_WITH_NAME(func_name, uvm_cache_stats, int32_t, 1, 32),
                 lock_cache_line,
                 MAKE_PTA_WITH_NAME(
-                    func_name, lxu_cache_locking_counter, int32_t, 2, 32));
+                    func_name, lxu_cache_locking_counter, int32_t, 2, 32),
+                admission_filter,
+                MAKE_PTA_WITH_NAME(
+                    func_name, admission_sketch, int32_t, 2, 32));
         C10_CUDA_KERNEL_LAUNCH_CHECK();
       }));
 }
@@ -288,7 +360,8 @@ DLL_PUBLIC void lru_cache_populate_cuda(
     bool gather_cache_stats,
     c10::optional<Tensor> uvm_cache_stats,
     bool lock_cache_line,
-    c10::optional<Tensor> lxu_cache_locking_counter) {
+    c10::optional<Tensor> lxu_cache_locking_counter,
+    c10::optional<Tensor> admission_sketch) {
   TENSORS_ON_SAME_CUDA_GPU_IF_NOT_OPTIONAL(
       weights,
       cache_hash_size_cumsum,
@@ -315,6 +388,26 @@ DLL_PUBLIC void lru_cache_populate_cuda(
     TENSOR_ON_CUDA_GPU(lxu_cache_locking_counter_);
   }
 
+  const bool admission_filter = admission_sketch.has_value();
+  Tensor admission_sketch_ = at::empty(
+      {kAdmissionSketchDepth, 0}, lxu_cache_state.options().dtype(at::kInt));
+  if (admission_filter) {
+    admission_sketch_ = admission_sketch.value();
+    TENSOR_ON_CUDA_GPU(admission_sketch_);
+    TENSOR_NDIM_EQUALS(admission_sketch_, 2);
+    TORCH_CHECK(
+        admission_sketch_.size(0) == kAdmissionSketchDepth &&
+            admission_sketch_.size(1) > 0,
+        "admission_sketch must be [",
+        kAdmissionSketchDepth,
+        ", width], got ",
+        admission_sketch_.sizes());
+    TORCH_CHECK(
+        !gather_cache_stats ||
+        uvm_cache_stats_.numel() >
+            uvm_cache_stats_index::num_rejected_unique_misses);
+  }
+
   CUDA_DEVICE_GUARD(weights);
 
   TORCH_CHECK(
@@ -331,6 +424,22 @@ DLL_PUBLIC void lru_cache_populate_cuda(
           total_cache_hash_size,
           /*compute_count=*/false);
 
+  if (admission_filter) {
+#ifdef FBGEMM_GPU_MEMCHECK
+    const char* func_name = "admission_sketch_update_kernel";
+#endif
+    admission_sketch_update_kernel<<<
+        div_round_up(linear_cache_indices.numel(), kMaxThreads),
+        kMaxThreads,
+        0,
+        at::cuda::getCurrentCUDAStream()>>>(
+        MAKE_PTA_WITH_NAME(func_name, unique_indices, int64_t, 1, 32),
+        unique_indices_length.data_ptr<int32_t>(),
+        total_cache_hash_size,
+        MAKE_PTA_WITH_NAME(func_name, admission_sketch_, int32_t, 2, 32));
+    C10_CUDA_KERNEL_LAUNCH_CHECK();
+  }
+
   auto
       [sorted_cache_sets,
        cache_set_sorted_unique_indices,
@@ -366,5 +475,7 @@ DLL_PUBLIC void lru_cache_populate_cuda(
       gather_cache_stats,
       uvm_cache_stats_,
       lock_cache_line,
-      lxu_cache_locking_counter_);
+      lxu_cache_locking_counter_,
+      admission_filter,
+      admission_sketch_);
 }
@@ -6,22 +6,296 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <ATen/Parallel.h>
+#include <c10/util/llvmMathExtras.h>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <numeric>
+#include <type_traits>
+
 #include "common.h"
+#include "fbgemm_gpu/split_embeddings_cache_cuda.cuh"
 
 using Tensor = at::Tensor;
 
 namespace fbgemm_gpu {
 
+namespace {
+
+constexpr int32_t kCacheLocationMissing = -1;
+constexpr int64_t kCacheStateInvalid = -1;
+
+// The ways of a set are probed with one 64-bit mask
+constexpr int64_t kMaxCacheWays = 64;
+
+// MurmurHash3 64-bit mixing function, the same as cache_slot of the CUDA
+// kernels so that a cache state can be moved between devices
+inline int64_t lxu_cache_set(const int64_t h_in, const int64_t C) {
+  uint64_t h = static_cast<uint64_t>(h_in);
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccd;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53;
+  h ^= h >> 33;
+  return static_cast<int64_t>(h % static_cast<uint32_t>(C));
+}
+
+// Column of idx in the row of the count-min sketch of the TinyLFU admission
+// filter, the same as admission_sketch_column of the CUDA kernels
+inline int64_t admission_sketch_column(
+    const int64_t idx,
+    const int32_t row,
+    const int64_t width) {
+  return lxu_cache_set(
+      idx ^ static_cast<int64_t>(0x9e3779b97f4a7c15ULL * (row + 1)), width);
+}
+
+// Estimated number of accesses of idx, the minimum of its counters
+inline int32_t admission_sketch_estimate(
+    const int32_t* sketch,
+    const int64_t width,
+    const int64_t idx) {
+  int32_t estimate = sketch[admission_sketch_column(idx, 0, width)];
+  for (const auto row : c10::irange(1, kAdmissionSketchDepth)) {
+    estimate = std::min(
+        estimate,
+        sketch[row * width + admission_sketch_column(idx, row, width)]);
+  }
+  return estimate;
+}
+
+// Returns the first way of the set holding idx, or -1. The ways are compared
+// without branching so that the comparisons are vectorized, as the lanes of
+// a warp compare them on GPU
+inline int32_t lxu_cache_find_way(
+    const int64_t* set_state,
+    const int64_t ways,
+    const int64_t idx) {
+  uint64_t found = 0;
+  for (int64_t way = 0; way < ways; ++way) {
+    found |= static_cast<uint64_t>(set_state[way] == idx) << way;
+  }
+  return found ? static_cast<int32_t>(c10::llvm::countTrailingZeros(found))
+               : -1;
+}
+
+void check_lxu_cache_state(const Tensor& lxu_cache_state) {
+  TENSOR_CONTIGUOUS_AND_ON_CPU(lxu_cache_state);
+  TENSOR_NDIM_EQUALS(lxu_cache_state, 2);
+  TORCH_CHECK(
+      lxu_cache_state.size(1) <= kMaxCacheWays,
+      "lxu_cache_state must have at most ",
+      kMaxCacheWays,
+      " ways, got ",
+      lxu_cache_state.size(1));
+}
+
+// Copies rows between the backing weights and the cache. Rows are converted
+// with round to nearest: as the CPU backward pass, the CPU cache does not
+// implement stochastic rounding.
+template <typename emb_t, typename cache_t>
+struct LXUCacheRows {
+  emb_t* weights;
+  const int64_t* cache_hash_size_cumsum;
+  const int32_t* cache_index_table_map;
+  const int64_t* weights_offsets;
+  const int32_t* D_offsets;
+  cache_t* cache_weights;
+  int64_t cache_row_stride;
+
+  template <typename dst_t, typename src_t>
+  static void copy_row(dst_t* dst, const src_t* src, const int32_t D) {
+    if constexpr (std::is_same_v<dst_t, src_t>) {
+      std::memcpy(dst, src, D * sizeof(dst_t));
+    } else {
+      for (const auto d : c10::irange(D)) {
+        dst[d] = static_cast<dst_t>(static_cast<float>(src[d]));
+      }
+    }
+  }
+
+  emb_t* weights_row(const int64_t linear_idx, int32_t& D) const {
+    const int32_t t = cache_index_table_map[linear_idx];
+    D = D_offsets[t + 1] - D_offsets[t];
+    return weights + weights_offsets[t] +
+        (linear_idx - cache_hash_size_cumsum[t]) * D;
+  }
+
+  void evict(const int64_t cache_row, const int64_t linear_idx) const {
+    int32_t D;
+    emb_t* row = weights_row(linear_idx, D);
+    copy_row(row, cache_weights + cache_row * cache_row_stride, D);
+  }
+
+  void insert(const int64_t cache_row, const int64_t linear_idx) const {
+    int32_t D;
+    const emb_t* row = weights_row(linear_idx, D);
+    copy_row(cache_weights + cache_row * cache_row_stride, row, D);
+  }
+};
+
+template <typename emb_t, typename cache_t>
+LXUCacheRows<emb_t, cache_t> make_lxu_cache_rows(
+    Tensor& weights,
+    const Tensor& cache_hash_size_cumsum,
+    const Tensor& cache_index_table_map,
+    const Tensor& weights_offsets,
+    const Tensor& D_offsets,
+    Tensor& lxu_cache_weights) {
+  return {
+      weights.data_ptr<emb_t>(),
+      cache_hash_size_cumsum.data_ptr<int64_t>(),
+      cache_index_table_map.data_ptr<int32_t>(),
+      weights_offsets.data_ptr<int64_t>(),
+      D_offsets.data_ptr<int32_t>(),
+      lxu_cache_weights.data_ptr<cache_t>(),
+      lxu_cache_weights.size(1)};
+}
+
+void check_lxu_cache_rows(
+    const Tensor& weights,
+    const Tensor& cache_hash_size_cumsum,
+    const Tensor& cache_index_table_map,
+    const Tensor& weights_offsets,
+    const Tensor& D_offsets,
+    const Tensor& lxu_cache_weights) {
+  TENSOR_CONTIGUOUS_AND_ON_CPU(weights);
+  TENSOR_CONTIGUOUS_AND_ON_CPU(cache_hash_size_cumsum);
+  TENSOR_CONTIGUOUS_AND_ON_CPU(cache_index_table_map);
+  TENSOR_CONTIGUOUS_AND_ON_CPU(weights_offsets);
+  TENSOR_CONTIGUOUS_AND_ON_CPU(D_offsets);
+  TENSOR_CONTIGUOUS_AND_ON_CPU(lxu_cache_weights);
+}
+
+// The sorted distinct linear indices, with their number of occurrences when
+// counts is not null
+std::vector<int64_t> lxu_cache_unique_indices(
+    const Tensor& linear_cache_indices,
+    std::vector<int32_t>* counts) {
+  const auto indices = linear_cache_indices.contiguous().to(at::kLong);
+  const auto* indices_data = indices.data_ptr<int64_t>();
+  std::vector<int64_t> unique(indices_data, indices_data + indices.numel());
+  std::sort(unique.begin(), unique.end());
+  if (counts == nullptr) {
+    unique.erase(std::unique(unique.begin(), unique.end()), unique.end());
+    return unique;
+  }
+  size_t num_unique = 0;
+  for (size_t i = 0; i < unique.size();) {
+    size_t j = i + 1;
+    while (j < unique.size() && unique[j] == unique[i]) {
+      ++j;
+    }
+    unique[num_unique++] = unique[i];
+    counts->push_back(static_cast<int32_t>(j - i));
+    i = j;
+  }
+  unique.resize(num_unique);
+  return unique;
+}
+
+// Runs insert_set(set, begin, end) in parallel over the runs of equal sets
+// of the sorted (set, index) misses
+template <typename F>
+void for_each_missed_set(
+    const std::vector<std::pair<int64_t, int64_t>>& misses,
+    const int64_t ways,
+    const F& insert_set) {
+  std::vector<int64_t> set_begins;
+  for (const auto n : c10::irange(misses.size())) {
+    if (n == 0 || misses[n - 1].first != misses[n].first) {
+      set_begins.push_back(n);
+    }
+  }
+  set_begins.push_back(misses.size());
+  const int64_t num_sets = set_begins.size() - 1;
+  at::parallel_for(
+      0,
+      num_sets,
+      std::max<int64_t>(1, at::internal::GRAIN_SIZE / (ways * 64)),
+      [&](int64_t s_begin, int64_t s_end) {
+        for (const auto s : c10::irange(s_begin, s_end)) {
+          insert_set(
+              misses[set_begins[s]].first, set_begins[s], set_begins[s + 1]);
+        }
+      });
+}
+
+} // namespace
+
+/// Lookup the cache locations for each linear cache indices in
+/// linear_cache_indices, see lxu_cache_lookup_cuda
 DLL_PUBLIC Tensor lxu_cache_lookup_cpu(
     Tensor linear_cache_indices,
-    Tensor /* lxu_cache_state */,
-    int64_t /* invalid_index */,
-    bool /* gather_cache_stats */,
-    c10::optional<Tensor> /* uvm_cache_stats */,
-    c10::optional<Tensor> /* num_uniq_cache_indices */,
+    Tensor lxu_cache_state,
+    int64_t invalid_index,
+    bool gather_cache_stats,
+    c10::optional<Tensor> uvm_cache_stats,
+    c10::optional<Tensor> num_uniq_cache_indices,
     c10::optional<Tensor> lxu_cache_locations_output) {
-  return lxu_cache_locations_output.value_or(empty_like(
+  const auto uniq_lookup = num_uniq_cache_indices.has_value();
+  TORCH_CHECK(
+      !uniq_lookup || !gather_cache_stats,
+      "Unique lxu_cache_locations generation does not support gather_cache_stats=true");
+  TENSOR_ON_CPU(linear_cache_indices);
+  check_lxu_cache_state(lxu_cache_state);
+  if (gather_cache_stats) {
+    TORCH_CHECK(uvm_cache_stats.has_value());
+    TENSOR_CONTIGUOUS_AND_ON_CPU(uvm_cache_stats.value());
+  }
+
+  auto lxu_cache_locations = lxu_cache_locations_output.value_or(empty_like(
       linear_cache_indices, linear_cache_indices.options().dtype(at::kInt)));
+  TENSOR_CONTIGUOUS_AND_ON_CPU(lxu_cache_locations);
+  const int64_t N = uniq_lookup
+      ? num_uniq_cache_indices.value().item<int64_t>()
+      : linear_cache_indices.numel();
+  if (N == 0) {
+    // nothing to do
+    return lxu_cache_locations;
+  }
+
+  const auto C = lxu_cache_state.size(0);
+  const auto ways = lxu_cache_state.size(1);
+  const auto* state = lxu_cache_state.data_ptr<int64_t>();
+  auto* locations = lxu_cache_locations.data_ptr<int32_t>();
+  std::atomic<int64_t> num_conflict_misses{0};
+
+  const auto indices = linear_cache_indices.contiguous();
+  AT_DISPATCH_INDEX_TYPES(
+      indices.scalar_type(), "lxu_cache_lookup_cpu", [&] {
+        const auto* indices_data = indices.data_ptr<index_t>();
+        at::parallel_for(
+            0,
+            N,
+            std::max<int64_t>(1, at::internal::GRAIN_SIZE / ways),
+            [&](int64_t n_begin, int64_t n_end) {
+              int64_t misses = 0;
+              for (const auto n : c10::irange(n_begin, n_end)) {
+                const int64_t idx = indices_data[n];
+                locations[n] = kCacheLocationMissing;
+                if (idx == invalid_index) {
+                  continue;
+                }
+                const auto cache_set = lxu_cache_set(idx, C);
+                const auto way =
+                    lxu_cache_find_way(state + cache_set * ways, ways, idx);
+                if (way < 0) {
+                  ++misses;
+                  continue;
+                }
+                locations[n] = static_cast<int32_t>(cache_set * ways + way);
+              }
+              num_conflict_misses += misses;
+            });
+      });
+
+  if (gather_cache_stats) {
+    uvm_cache_stats.value().data_ptr<int32_t>()
+        [uvm_cache_stats_index::num_conflict_misses] += num_conflict_misses;
+  }
+  return lxu_cache_locations;
 }
 
 DLL_PUBLIC Tensor direct_mapped_lxu_cache_lookup_cpu(
@@ -30,8 +304,403 @@ DLL_PUBLIC Tensor direct_mapped_lxu_cache_lookup_cpu(
     int64_t invalid_index,
     bool gather_cache_stats,
     c10::optional<Tensor> uvm_cache_stats) {
-  return empty_like(
-      linear_cache_indices, linear_cache_indices.options().dtype(at::kInt));
+  // A direct mapped cache is a set associative cache of one way
+  TORCH_CHECK(
+      lxu_cache_state.dim() == 2 && lxu_cache_state.size(1) >= 1,
+      "lxu_cache_state must be 2D with at least one slot per set");
+  return lxu_cache_lookup_cpu(
+      linear_cache_indices,
+      lxu_cache_state.narrow(1, 0, 1).contiguous(),
+      invalid_index,
+      gather_cache_stats,
+      uvm_cache_stats,
+      c10::nullopt,
+      c10::nullopt);
+}
+
+/// LRU cache: fetch the rows of linear_cache_indices not in the cache,
+/// evicting the least recently used rows of their sets, see
+/// lru_cache_populate_cuda
+DLL_PUBLIC void lru_cache_populate_cpu(
+    Tensor weights,
+    Tensor cache_hash_size_cumsum,
+    const int64_t total_cache_hash_size,
+    Tensor cache_index_table_map,
+    Tensor weights_offsets,
+    Tensor D_offsets,
+    Tensor linear_cache_indices,
+    Tensor lxu_cache_state,
+    Tensor lxu_cache_weights,
+    const int64_t time_stamp,
+    Tensor lru_state,
+    const bool /* stochastic_rounding */,
+    bool gather_cache_stats,
+    c10::optional<Tensor> uvm_cache_stats,
+    bool lock_cache_line,
+    c10::optional<Tensor> lxu_cache_locking_counter,
+    c10::optional<Tensor> admission_sketch) {
+  check_lxu_cache_rows(
+      weights,
+      cache_hash_size_cumsum,
+      cache_index_table_map,
+      weights_offsets,
+      D_offsets,
+      lxu_cache_weights);
+  TENSOR_ON_CPU(linear_cache_indices);
+  check_lxu_cache_state(lxu_cache_state);
+  TENSOR_CONTIGUOUS_AND_ON_CPU(lru_state);
+  int32_t* stats = nullptr;
+  if (gather_cache_stats) {
+    TORCH_CHECK(uvm_cache_stats.has_value());
+    TENSOR_CONTIGUOUS_AND_ON_CPU(uvm_cache_stats.value());
+    stats = uvm_cache_stats.value().data_ptr<int32_t>();
+  }
+  int32_t* locking_counter = nullptr;
+  if (lock_cache_line) {
+    TORCH_CHECK(lxu_cache_locking_counter.has_value());
+    TENSOR_CONTIGUOUS_AND_ON_CPU(lxu_cache_locking_counter.value());
+    locking_counter = lxu_cache_locking_counter.value().data_ptr<int32_t>();
+  }
+  int32_t* sketch = nullptr;
+  int64_t sketch_width = 0;
+  if (admission_sketch.has_value()) {
+    const auto& admission_sketch_ = admission_sketch.value();
+    TENSOR_CONTIGUOUS_AND_ON_CPU(admission_sketch_);
+    TENSOR_NDIM_EQUALS(admission_sketch_, 2);
+    TORCH_CHECK(
+        admission_sketch_.size(0) == kAdmissionSketchDepth &&
+            admission_sketch_.size(1) > 0,
+        "admission_sketch must be [",
+        kAdmissionSketchDepth,
+        ", width], got ",
+        admission_sketch_.sizes());
+    sketch = admission_sketch_.data_ptr<int32_t>();
+    sketch_width = admission_sketch_.size(1);
+    TORCH_CHECK(
+        !gather_cache_stats ||
+        uvm_cache_stats.value().numel() >
+            uvm_cache_stats_index::num_rejected_unique_misses);
+  }
+
+  TORCH_CHECK(
+      linear_cache_indices.numel() < std::numeric_limits<int32_t>::max());
+  if (linear_cache_indices.numel() == 0) {
+    // nothing to do
+    return;
+  }
+
+  const auto C = lxu_cache_state.size(0);
+  const auto ways = lxu_cache_state.size(1);
+  auto* state = lxu_cache_state.data_ptr<int64_t>();
+  auto* lru = lru_state.data_ptr<int64_t>();
+  const auto unique_indices =
+      lxu_cache_unique_indices(linear_cache_indices, nullptr);
+  if (sketch != nullptr) {
+    for (const auto idx : unique_indices) {
+      if (idx == total_cache_hash_size) {
+        continue;
+      }
+      for (const auto row : c10::irange(kAdmissionSketchDepth)) {
+        sketch[row * sketch_width +
+               admission_sketch_column(idx, row, sketch_width)] += 1;
+      }
+    }
+  }
+
+  // Mark the cached rows as recently used and collect the (set, index) of
+  // the others, sorted by set then index
+  const int64_t num_unique = unique_indices.size();
+  std::vector<int64_t> cache_sets(num_unique, C);
+  at::parallel_for(
+      0,
+      num_unique,
+      std::max<int64_t>(1, at::internal::GRAIN_SIZE / ways),
+      [&](int64_t n_begin, int64_t n_end) {
+        for (const auto n : c10::irange(n_begin, n_end)) {
+          const int64_t idx = unique_indices[n];
+          if (idx == total_cache_hash_size) {
+            continue;
+          }
+          const auto cache_set = lxu_cache_set(idx, C);
+          const auto way =
+              lxu_cache_find_way(state + cache_set * ways, ways, idx);
+          if (way < 0) {
+            cache_sets[n] = cache_set;
+            continue;
+          }
+          // Don't lock the line one more time if it was locked in the same
+          // batch (timestamp)
+          const auto slot = cache_set * ways + way;
+          if (lock_cache_line && lru[slot] != time_stamp) {
+            locking_counter[slot] += 1;
+          }
+          lru[slot] = time_stamp;
+        }
+      });
+  std::vector<std::pair<int64_t, int64_t>> misses;
+  for (const auto n : c10::irange(num_unique)) {
+    if (cache_sets[n] != C) {
+      misses.emplace_back(cache_sets[n], unique_indices[n]);
+    }
+  }
+  std::sort(misses.begin(), misses.end());
+  if (stats != nullptr) {
+    stats[uvm_cache_stats_index::num_calls] += 1;
+    stats[uvm_cache_stats_index::num_requested_indices] +=
+        linear_cache_indices.numel();
+    stats[uvm_cache_stats_index::num_unique_indices] += num_unique;
+    stats[uvm_cache_stats_index::num_unique_misses] += misses.size();
+  }
+
+  std::atomic<int64_t> num_conflict_misses{0};
+  std::atomic<int64_t> num_rejected_misses{0};
+  DISPATCH_EMB_CACHE_TYPES(
+      weights.scalar_type(),
+      lxu_cache_weights.scalar_type(),
+      "lru_cache_populate_cpu",
+      ([&] {
+        const auto rows = make_lxu_cache_rows<emb_t, cache_t>(
+            weights,
+            cache_hash_size_cumsum,
+            cache_index_table_map,
+            weights_offsets,
+            D_offsets,
+            lxu_cache_weights);
+        for_each_missed_set(
+            misses, ways, [&](int64_t cache_set, int64_t begin, int64_t end) {
+              // Fill the ways from the least recently used
+              int64_t* set_state = state + cache_set * ways;
+              int64_t* set_lru = lru + cache_set * ways;
+              int64_t sorted_ways[kMaxCacheWays];
+              std::iota(sorted_ways, sorted_ways + ways, 0);
+              std::stable_sort(
+                  sorted_ways, sorted_ways + ways, [&](int64_t a, int64_t b) {
+                    return set_lru[a] < set_lru[b];
+                  });
+
+              int64_t n_inserted = 0;
+              int64_t n_rejected = 0;
+              for (const auto l :
+                   c10::irange(std::min<int64_t>(end - begin, ways))) {
+                const auto way = sorted_ways[l];
+                const auto slot = cache_set * ways + way;
+                if (lock_cache_line && locking_counter[slot] > 0) {
+                  continue; // cache slot is in use
+                }
+                if (set_lru[way] == time_stamp) {
+                  break;
+                }
+                const int64_t insert_idx =
+                    misses[begin + n_inserted + n_rejected].second;
+                // TinyLFU: only admit the row if it is more frequently
+                // accessed than the row it would evict
+                if (sketch != nullptr &&
+                    set_state[way] != kCacheStateInvalid &&
+                    admission_sketch_estimate(
+                        sketch, sketch_width, insert_idx) <=
+                        admission_sketch_estimate(
+                            sketch, sketch_width, set_state[way])) {
+                  ++n_rejected;
+                  continue;
+                }
+                if (set_state[way] != kCacheStateInvalid) {
+                  rows.evict(slot, set_state[way]);
+                }
+                rows.insert(slot, insert_idx);
+                set_state[way] = insert_idx;
+                set_lru[way] = time_stamp;
+                if (lock_cache_line) {
+                  locking_counter[slot] += 1;
+                }
+                ++n_inserted;
+              }
+              num_conflict_misses += end - begin - n_inserted - n_rejected;
+              num_rejected_misses += n_rejected;
+            });
+      }));
+  if (stats != nullptr) {
+    stats[uvm_cache_stats_index::num_conflict_unique_misses] +=
+        num_conflict_misses;
+    stats[uvm_cache_stats_index::num_rejected_unique_misses] +=
+        num_rejected_misses;
+  }
+}
+
+/// LFU cache: count the accesses of linear_cache_indices and fetch the rows
+/// not in the cache that are more frequently used than the least frequently
+/// used rows of their sets, see lfu_cache_populate_cuda
+DLL_PUBLIC void lfu_cache_populate_cpu(
+    Tensor weights,
+    Tensor cache_hash_size_cumsum,
+    const int64_t total_cache_hash_size,
+    Tensor cache_index_table_map,
+    Tensor weights_offsets,
+    Tensor D_offsets,
+    Tensor linear_cache_indices,
+    Tensor lxu_cache_state,
+    Tensor lxu_cache_weights,
+    Tensor lfu_state,
+    const bool /* stochastic_rounding */) {
+  check_lxu_cache_rows(
+      weights,
+      cache_hash_size_cumsum,
+      cache_index_table_map,
+      weights_offsets,
+      D_offsets,
+      lxu_cache_weights);
+  TENSOR_ON_CPU(linear_cache_indices);
+  check_lxu_cache_state(lxu_cache_state);
+  TENSOR_CONTIGUOUS_AND_ON_CPU(lfu_state);
+
+  TORCH_CHECK(
+      linear_cache_indices.numel() < std::numeric_limits<int32_t>::max());
+  if (linear_cache_indices.numel() == 0) {
+    // nothing to do
+    return;
+  }
+
+  const auto C = lxu_cache_state.size(0);
+  const auto ways = lxu_cache_state.size(1);
+  auto* state = lxu_cache_state.data_ptr<int64_t>();
+  auto* lfu = lfu_state.data_ptr<int64_t>();
+  std::vector<int32_t> counts;
+  const auto unique_indices =
+      lxu_cache_unique_indices(linear_cache_indices, &counts);
+  for (const auto n : c10::irange(unique_indices.size())) {
+    lfu[unique_indices[n]] += counts[n];
+  }
+
+  // The (set, index) of the rows not in the cache, sorted by set then from
+  // the most frequently used
+  const int64_t num_unique = unique_indices.size();
+  std::vector<int64_t> cache_sets(num_unique, C);
+  at::parallel_for(
+      0,
+      num_unique,
+      std::max<int64_t>(1, at::internal::GRAIN_SIZE / ways),
+      [&](int64_t n_begin, int64_t n_end) {
+        for (const auto n : c10::irange(n_begin, n_end)) {
+          const int64_t idx = unique_indices[n];
+          if (idx == total_cache_hash_size) {
+            continue;
+          }
+          const auto cache_set = lxu_cache_set(idx, C);
+          if (lxu_cache_find_way(state + cache_set * ways, ways, idx) < 0) {
+            cache_sets[n] = cache_set;
+          }
+        }
+      });
+  std::vector<std::pair<int64_t, int64_t>> misses;
+  for (const auto n : c10::irange(num_unique)) {
+    if (cache_sets[n] != C) {
+      misses.emplace_back(cache_sets[n], unique_indices[n]);
+    }
+  }
+  std::stable_sort(
+      misses.begin(),
+      misses.end(),
+      [&](const std::pair<int64_t, int64_t>& a,
+          const std::pair<int64_t, int64_t>& b) {
+        return a.first != b.first ? a.first < b.first
+                                  : lfu[a.second] > lfu[b.second];
+      });
+
+  DISPATCH_EMB_CACHE_TYPES(
+      weights.scalar_type(),
+      lxu_cache_weights.scalar_type(),
+      "lfu_cache_populate_cpu",
+      ([&] {
+        const auto rows = make_lxu_cache_rows<emb_t, cache_t>(
+            weights,
+            cache_hash_size_cumsum,
+            cache_index_table_map,
+            weights_offsets,
+            D_offsets,
+            lxu_cache_weights);
+        for_each_missed_set(
+            misses, ways, [&](int64_t cache_set, int64_t begin, int64_t end) {
+              // Replace the least frequently used ways, empty ways first
+              int64_t* set_state = state + cache_set * ways;
+              int64_t costs[kMaxCacheWays];
+              int64_t sorted_ways[kMaxCacheWays];
+              for (const auto way : c10::irange(ways)) {
+                costs[way] = set_state[way] != kCacheStateInvalid
+                    ? lfu[set_state[way]]
+                    : -1;
+              }
+              std::iota(sorted_ways, sorted_ways + ways, 0);
+              std::stable_sort(
+                  sorted_ways, sorted_ways + ways, [&](int64_t a, int64_t b) {
+                    return costs[a] < costs[b];
+                  });
+
+              for (const auto l :
+                   c10::irange(std::min<int64_t>(end - begin, ways))) {
+                const auto way = sorted_ways[l];
+                const int64_t insert_idx = misses[begin + l].second;
+                // The next ways are more and the next rows less frequently
+                // used
+                if (costs[way] > lfu[insert_idx]) {
+                  break;
+                }
+                const auto slot = cache_set * ways + way;
+                if (costs[way] != -1) {
+                  rows.evict(slot, set_state[way]);
+                }
+                rows.insert(slot, insert_idx);
+                set_state[way] = insert_idx;
+              }
+            });
+      }));
+}
+
+/// Write all the cached rows back to uvm_weights, see lxu_cache_flush_cuda
+DLL_PUBLIC void lxu_cache_flush_cpu(
+    Tensor uvm_weights,
+    Tensor cache_hash_size_cumsum,
+    Tensor cache_index_table_map,
+    Tensor weights_offsets,
+    Tensor D_offsets,
+    int64_t /* total_D */,
+    Tensor lxu_cache_state,
+    Tensor lxu_cache_weights,
+    bool /* stochastic_rounding */) {
+  check_lxu_cache_rows(
+      uvm_weights,
+      cache_hash_size_cumsum,
+      cache_index_table_map,
+      weights_offsets,
+      D_offsets,
+      lxu_cache_weights);
+  check_lxu_cache_state(lxu_cache_state);
+
+  const auto* state = lxu_cache_state.data_ptr<int64_t>();
+  const auto num_slots = lxu_cache_state.numel();
+  DISPATCH_EMB_CACHE_TYPES(
+      uvm_weights.scalar_type(),
+      lxu_cache_weights.scalar_type(),
+      "lxu_cache_flush_cpu",
+      ([&] {
+        const auto rows = make_lxu_cache_rows<emb_t, cache_t>(
+            uvm_weights,
+            cache_hash_size_cumsum,
+            cache_index_table_map,
+            weights_offsets,
+            D_offsets,
+            lxu_cache_weights);
+        at::parallel_for(
+            0,
+            num_slots,
+            std::max<int64_t>(
+                1, at::internal::GRAIN_SIZE / lxu_cache_weights.size(1)),
+            [&](int64_t slot_begin, int64_t slot_end) {
+              for (const auto slot : c10::irange(slot_begin, slot_end)) {
+                if (state[slot] != kCacheStateInvalid) {
+                  rows.evict(slot, state[slot]);
+                }
+              }
+            });
+      }));
 }
 
 } // namespace fbgemm_gpu
@@ -0,0 +1,186 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "fbgemm_gpu/embedding_backward_template_helpers.cuh" // @manual
+#include "fbgemm_gpu/fbgemm_tensor_accessor.h" // @manual
+#include "fbgemm_gpu/ops_utils.h" // @manual
+#include "fbgemm_gpu/split_embeddings_utils.cuh" // @manual
+
+using Tensor = at::Tensor;
+using namespace fbgemm_gpu;
+
+namespace {
+
+template <typename info_pta_t, typename info_t, bool nobag>
+__global__ __launch_bounds__(kMaxThreads) void segment_length_histogram_kernel(
+    const pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits>
+        sorted_linear_indices_num_runs,
+    const pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits>
+        sorted_linear_indices_cumulative_run_lengths,
+    const pta::PackedTensorAccessor32<info_pta_t, 1, at::RestrictPtrTraits>
+        sorted_infos,
+    const int32_t info_B_num_bits,
+    pta::PackedTensorAccessor32<int32_t, 2, at::RestrictPtrTraits> histogram) {
+  const int32_t num_runs = sorted_linear_indices_num_runs[0];
+  const auto T = histogram.size(0);
+  for (auto run_id = blockIdx.x * blockDim.x + threadIdx.x; run_id < num_runs;
+       run_id += blockDim.x * gridDim.x) {
+    const auto segment_start =
+        sorted_linear_indices_cumulative_run_lengths[run_id];
+    const int32_t SL =
+        sorted_linear_indices_cumulative_run_lengths[run_id + 1] -
+        segment_start;
+    const auto info =
+        reinterpret_cast<const info_t*>(&sorted_infos[0])[segment_start];
+    const auto t = nobag ? (info % T) : (info >> info_B_num_bits);
+    // Runs are never empty, so bin = floor(log2(SL)) is well defined
+    const auto bin = 31 - __clz(SL);
+    gpuAtomicAdd(&histogram[t][bin], 1);
+  }
+}
+
+__global__ __launch_bounds__(kMaxThreads) void
+adaptive_max_segment_length_per_warp_kernel(
+    const pta::PackedTensorAccessor32<int32_t, 2, at::RestrictPtrTraits>
+        histogram,
+    const int32_t base_log2,
+    const int32_t max_log2,
+    const int32_t warps_per_cta,
+    pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits>
+        max_segment_length_per_warp) {
+  const auto t = blockIdx.x * blockDim.x + threadIdx.x;
+  if (t >= histogram.size(0)) {
+    return;
+  }
+
+  int64_t num_runs = 0;
+  for (auto bin = 0; bin < kSegmentLengthHistogramBins; ++bin) {
+    num_runs += histogram[t][bin];
+  }
+
+  // Runs of at least 2^k lookups go to the CTA path. Start from the default k
+  // and raise it while those runs are too common for one CTA each to pay off,
+  // i.e. while they outnumber the other runs of the table warps_per_cta times
+  // over; at max_log2 a run fills every warp of its CTA anyway
+  int64_t num_long_runs = 0;
+  for (auto bin = base_log2; bin < kSegmentLengthHistogramBins; ++bin) {
+    num_long_runs += histogram[t][bin];
+  }
+  auto k = base_log2;
+  while (k < max_log2 && num_long_runs * warps_per_cta > num_runs) {
+    num_long_runs -= histogram[t][k];
+    ++k;
+  }
+  max_segment_length_per_warp[t] = 1 << k;
+}
+
+} // namespace
+
+DLL_PUBLIC Tensor segment_length_histogram(
+    const Tensor& sorted_linear_indices_num_runs,
+    const Tensor& sorted_linear_indices_cumulative_run_lengths,
+    const Tensor& infos_sorted,
+    const int64_t T,
+    const int64_t info_B_num_bits) {
+  TENSORS_ON_SAME_CUDA_GPU_IF_NOT_OPTIONAL(
+      sorted_linear_indices_num_runs,
+      sorted_linear_indices_cumulative_run_lengths,
+      infos_sorted);
+  CUDA_DEVICE_GUARD(infos_sorted);
+
+  auto histogram = at::zeros(
+      {T, kSegmentLengthHistogramBins},
+      sorted_linear_indices_num_runs.options().dtype(at::kInt));
+  const auto max_num_runs =
+      sorted_linear_indices_cumulative_run_lengths.numel() - 1;
+  if (T == 0 || max_num_runs <= 0) {
+    return histogram;
+  }
+
+  // infos are int64 (l * T + t) for nobag and index_select, and int32
+  // ((t << info_B_num_bits) | b) for pooled lookups
+#define INVOKE_SEGMENT_LENGTH_HISTOGRAM_KERNEL(INFO_PTA_T, INFO_T, NOBAG)      \
+  {                                                                           \
+    [[maybe_unused]] const auto func_name = "segment_length_histogram_kernel"; \
+    segment_length_histogram_kernel<INFO_PTA_T, INFO_T, NOBAG><<<             \
+        div_round_up(max_num_runs, kMaxThreads),                              \
+        kMaxThreads,                                                          \
+        0,                                                                    \
+        at::cuda::getCurrentCUDAStream()>>>(                                  \
+        MAKE_PTA_WITH_NAME(                                                   \
+            func_name, sorted_linear_indices_num_runs, int32_t, 1, 32),       \
+        MAKE_PTA_WITH_NAME(                                                   \
+            func_name,                                                        \
+            sorted_linear_indices_cumulative_run_lengths,                     \
+            int32_t,                                                          \
+            1,                                                                \
+            32),                                                              \
+        MAKE_PTA_WITH_NAME(func_name, infos_sorted, INFO_PTA_T, 1, 32),       \
+        info_B_num_bits,                                                      \
+        MAKE_PTA_WITH_NAME(func_name, histogram, int32_t, 2, 32));            \
+    C10_CUDA_KERNEL_LAUNCH_CHECK();                                           \
+  }
+
+  if (infos_sorted.scalar_type() == at::kLong) {
+    INVOKE_SEGMENT_LENGTH_HISTOGRAM_KERNEL(int64_t, int64_t, true);
+  } else {
+    TORCH_CHECK(infos_sorted.scalar_type() == at::kInt);
+    INVOKE_SEGMENT_LENGTH_HISTOGRAM_KERNEL(int32_t, uint32_t, false);
+  }
+
+#undef INVOKE_SEGMENT_LENGTH_HISTOGRAM_KERNEL
+
+  return histogram;
+}
+
+DLL_PUBLIC Tensor adaptive_max_segment_length_per_warp(
+    const Tensor& histogram,
+    const int64_t base_max_segment_length_per_warp,
+    const int64_t warps_per_cta) {
+  TENSOR_ON_CUDA_GPU(histogram);
+  CUDA_DEVICE_GUARD(histogram);
+  TORCH_CHECK(
+      histogram.dim() == 2 && histogram.size(1) == kSegmentLengthHistogramBins);
+  TORCH_CHECK(
+      base_max_segment_length_per_warp > 0 &&
+          (base_max_segment_length_per_warp &
+           (base_max_segment_length_per_warp - 1)) == 0,
+      "base_max_segment_length_per_warp must be a power of two");
+  TORCH_CHECK(
+      warps_per_cta > 0 && (warps_per_cta & (warps_per_cta - 1)) == 0,
+      "warps_per_cta must be a power of two");
+
+  const auto T = histogram.size(0);
+  auto max_segment_length_per_warp =
+      at::empty({T}, histogram.options().dtype(at::kInt));
+  if (T == 0) {
+    return max_segment_length_per_warp;
+  }
+  const int32_t base_log2 = __builtin_ctzll(base_max_segment_length_per_warp);
+  const int32_t max_log2 = std::min<int32_t>(
+      base_log2 + __builtin_ctzll(warps_per_cta),
+      kSegmentLengthHistogramBins - 1);
+
+#ifdef FBGEMM_GPU_MEMCHECK
+  const auto func_name = "adaptive_max_segment_length_per_warp_kernel";
+#endif
+  adaptive_max_segment_length_per_warp_kernel<<<
+      div_round_up(T, kMaxThreads),
+      kMaxThreads,
+      0,
+      at::cuda::getCurrentCUDAStream()>>>(
+      MAKE_PTA_WITH_NAME(func_name, histogram, int32_t, 2, 32),
+      base_log2,
+      max_log2,
+      warps_per_cta,
+      MAKE_PTA_WITH_NAME(
+          func_name, max_segment_length_per_warp, int32_t, 1, 32));
+  C10_CUDA_KERNEL_LAUNCH_CHECK();
+
+  return max_segment_length_per_warp;
+}
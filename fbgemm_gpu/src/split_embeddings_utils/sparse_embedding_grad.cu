@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "fbgemm_gpu/embedding_backward_template_helpers.cuh" // @manual
+#include "fbgemm_gpu/fbgemm_tensor_accessor.h" // @manual
+#include "fbgemm_gpu/ops_utils.h" // @manual
+#include "fbgemm_gpu/split_embeddings_utils.cuh" // @manual
+
+using Tensor = at::Tensor;
+using namespace fbgemm_gpu;
+
+namespace {
+
+// One warp per unique index: sum the gradient rows of its segment in sorted
+// order, so the result does not depend on the scheduling
+template <typename grad_t>
+__global__ __launch_bounds__(kMaxThreads) void compute_sparse_grad_kernel(
+    const pta::PackedTensorAccessor64<grad_t, 2, at::RestrictPtrTraits>
+        grad_output,
+    const pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits>
+        sorted_infos,
+    const pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits>
+        cumulative_run_lengths,
+    const pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits>
+        D_offsets,
+    const int32_t num_runs,
+    const int32_t info_B_num_bits,
+    const uint32_t info_B_mask,
+    pta::PackedTensorAccessor64<grad_t, 2, at::RestrictPtrTraits> grad_rows) {
+  const int32_t run_id =
+      blockIdx.x * (blockDim.x / kWarpSize) + threadIdx.x / kWarpSize;
+  if (run_id >= num_runs) {
+    return;
+  }
+  const int32_t lane_id = threadIdx.x % kWarpSize;
+  const int32_t segment_start = cumulative_run_lengths[run_id];
+  const int32_t segment_end = cumulative_run_lengths[run_id + 1];
+
+  // All the lookups of a run hit the same table, hence share D
+  const int32_t t0 =
+      static_cast<uint32_t>(sorted_infos[segment_start]) >> info_B_num_bits;
+  const int32_t D = D_offsets[t0 + 1] - D_offsets[t0];
+  const int32_t max_D = grad_rows.size(1);
+
+  for (int32_t d = lane_id; d < max_D; d += kWarpSize) {
+    at::acc_type<grad_t, true> sum = 0;
+    if (d < D) {
+      for (int32_t sl = segment_start; sl < segment_end; ++sl) {
+        const auto info = static_cast<uint32_t>(sorted_infos[sl]);
+        const int32_t t = info >> info_B_num_bits;
+        const int32_t b = info & info_B_mask;
+        sum += grad_output[b][D_offsets[t] + d];
+      }
+    }
+    // Rows of tables narrower than max_D are zero padded
+    grad_rows[run_id][d] = sum;
+  }
+}
+
+// One warp per run of equal sorted ids, accumulating the rows of the run in
+// their stable sort order before a single non-atomic update of the row
+template <typename emb_t, typename grad_t>
+__global__ __launch_bounds__(kMaxThreads) void apply_sparse_grad_kernel(
+    pta::PackedTensorAccessor64<emb_t, 1, at::RestrictPtrTraits> dense,
+    const pta::PackedTensorAccessor32<int64_t, 1, at::RestrictPtrTraits>
+        weights_offsets,
+    const pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits>
+        D_offsets,
+    const pta::PackedTensorAccessor32<int64_t, 1, at::RestrictPtrTraits>
+        hash_size_cumsum,
+    const pta::PackedTensorAccessor32<int64_t, 1, at::RestrictPtrTraits>
+        ids_sorted,
+    const pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits>
+        positions_sorted,
+    const pta::PackedTensorAccessor64<grad_t, 2, at::RestrictPtrTraits>
+        grad_rows,
+    const float scale) {
+  const int32_t i =
+      blockIdx.x * (blockDim.x / kWarpSize) + threadIdx.x / kWarpSize;
+  const int32_t N = ids_sorted.size(0);
+  if (i >= N) {
+    return;
+  }
+  const int64_t linear_index = ids_sorted[i];
+  if (i > 0 && ids_sorted[i - 1] == linear_index) {
+    // Not the head of its run
+    return;
+  }
+  int32_t run_end = i + 1;
+  while (run_end < N && ids_sorted[run_end] == linear_index) {
+    ++run_end;
+  }
+
+  // Find the feature owning linear_index. Features sharing a table have equal
+  // hash_size_cumsum entries and therefore the same rows, offset and D
+  const int32_t T = hash_size_cumsum.size(0) - 1;
+  int32_t lo = 0;
+  int32_t hi = T;
+  while (hi - lo > 1) {
+    const int32_t mid = (lo + hi) / 2;
+    if (hash_size_cumsum[mid] <= linear_index) {
+      lo = mid;
+    } else {
+      hi = mid;
+    }
+  }
+  const int32_t t = lo;
+  const int64_t idx = linear_index - hash_size_cumsum[t];
+  const int32_t D = D_offsets[t + 1] - D_offsets[t];
+  const int64_t row_offset = weights_offsets[t] + idx * D;
+
+  const int32_t lane_id = threadIdx.x % kWarpSize;
+  for (int32_t d = lane_id; d < D; d += kWarpSize) {
+    at::acc_type<grad_t, true> sum = 0;
+    for (int32_t j = i; j < run_end; ++j) {
+      sum += grad_rows[positions_sorted[j]][d];
+    }
+    dense[row_offset + d] = dense[row_offset + d] + scale * sum;
+  }
+}
+
+} // namespace
+
+DLL_PUBLIC std::tuple<Tensor /*unique_ids*/, Tensor /*grad_rows*/>
+compute_sparse_embedding_grad(
+    const Tensor& grad_output,
+    const Tensor& sorted_linear_indices_run,
+    const Tensor& sorted_linear_indices_cumulative_run_lengths,
+    const Tensor& sorted_linear_indices_num_runs,
+    const Tensor& infos_sorted,
+    const Tensor& D_offsets,
+    const int64_t max_D,
+    const int64_t info_B_num_bits,
+    const int64_t info_B_mask) {
+  TENSORS_ON_SAME_CUDA_GPU_IF_NOT_OPTIONAL(
+      grad_output,
+      sorted_linear_indices_run,
+      sorted_linear_indices_cumulative_run_lengths,
+      sorted_linear_indices_num_runs,
+      infos_sorted,
+      D_offsets);
+  CUDA_DEVICE_GUARD(grad_output);
+
+  TORCH_CHECK(
+      grad_output.dim() == 2,
+      "compute_sparse_embedding_grad supports pooled, non-VBE gradients only");
+  TORCH_CHECK(
+      infos_sorted.scalar_type() == at::kInt,
+      "compute_sparse_embedding_grad expects the int32 infos of pooled TBE");
+  TORCH_CHECK(max_D > 0);
+
+  // The gradient is made compact, which requires the number of unique ids
+  const int32_t num_runs = sorted_linear_indices_num_runs.item<int32_t>();
+  auto unique_ids = sorted_linear_indices_run.slice(0, 0, num_runs);
+  auto grad_rows = at::empty({num_runs, max_D}, grad_output.options());
+  if (num_runs == 0) {
+    return {unique_ids, grad_rows};
+  }
+
+  const auto grad_output_ = grad_output.contiguous();
+  constexpr int32_t kWarpsPerBlock = kMaxThreads / kWarpSize;
+  FBGEMM_DISPATCH_FLOATING_TYPES(
+      grad_output_.scalar_type(), "compute_sparse_embedding_grad", [&] {
+#ifdef FBGEMM_GPU_MEMCHECK
+        const auto func_name = "compute_sparse_grad_kernel";
+#endif
+        compute_sparse_grad_kernel<scalar_t>
+            <<<div_round_up(num_runs, kWarpsPerBlock),
+               kMaxThreads,
+               0,
+               at::cuda::getCurrentCUDAStream()>>>(
+                MAKE_PTA_WITH_NAME(func_name, grad_output_, scalar_t, 2, 64),
+                MAKE_PTA_WITH_NAME(func_name, infos_sorted, int32_t, 1, 32),
+                MAKE_PTA_WITH_NAME(
+                    func_name,
+                    sorted_linear_indices_cumulative_run_lengths,
+                    int32_t,
+                    1,
+                    32),
+                MAKE_PTA_WITH_NAME(func_name, D_offsets, int32_t, 1, 32),
+                num_runs,
+                info_B_num_bits,
+                static_cast<uint32_t>(info_B_mask),
+                MAKE_PTA_WITH_NAME(func_name, grad_rows, scalar_t, 2, 64));
+        C10_CUDA_KERNEL_LAUNCH_CHECK();
+      });
+
+  return {unique_ids, grad_rows};
+}
+
+DLL_PUBLIC void apply_sparse_embedding_grad(
+    Tensor& dense,
+    const Tensor& weights_offsets,
+    const Tensor& D_offsets,
+    const Tensor& hash_size_cumsum,
+    const Tensor& unique_ids,
+    const Tensor& grad_rows,
+    const double scale) {
+  TENSORS_ON_SAME_CUDA_GPU_IF_NOT_OPTIONAL(
+      dense,
+      weights_offsets,
+      D_offsets,
+      hash_size_cumsum,
+      unique_ids,
+      grad_rows);
+  CUDA_DEVICE_GUARD(dense);
+
+  TORCH_CHECK(dense.dim() == 1 && dense.is_contiguous());
+  TORCH_CHECK(grad_rows.dim() == 2);
+  TORCH_CHECK(unique_ids.scalar_type() == at::kLong);
+  TORCH_CHECK(
+      unique_ids.numel() == grad_rows.size(0),
+      "unique_ids and grad_rows must have the same number of rows");
+  const auto N = unique_ids.numel();
+  TORCH_CHECK_LT(N, std::numeric_limits<int32_t>::max());
+  if (N == 0) {
+    return;
+  }
+
+  // The ids gathered from several ranks may repeat. Sort them stably so that
+  // every id is updated once, summing its rows in gather order
+  const auto positions = at::arange(N, unique_ids.options().dtype(at::kInt));
+  auto ids_sorted = at::empty_like(unique_ids);
+  auto positions_sorted = at::empty_like(positions);
+  {
+    size_t temp_storage_bytes = 0;
+    AT_CUDA_CHECK(radix_sort_pairs(
+        nullptr,
+        temp_storage_bytes,
+        unique_ids.data_ptr<int64_t>(),
+        ids_sorted.data_ptr<int64_t>(),
+        positions.data_ptr<int32_t>(),
+        positions_sorted.data_ptr<int32_t>(),
+        N,
+        0,
+        sizeof(int64_t) * 8,
+        at::cuda::getCurrentCUDAStream()));
+    auto temp_storage = at::empty(
+        {static_cast<int64_t>(temp_storage_bytes)},
+        unique_ids.options().dtype(at::kByte));
+    AT_CUDA_CHECK(radix_sort_pairs(
+        temp_storage.data_ptr(),
+        temp_storage_bytes,
+        unique_ids.data_ptr<int64_t>(),
+        ids_sorted.data_ptr<int64_t>(),
+        positions.data_ptr<int32_t>(),
+        positions_sorted.data_ptr<int32_t>(),
+        N,
+        0,
+        sizeof(int64_t) * 8,
+        at::cuda::getCurrentCUDAStream()));
+  }
+
+  const auto grad_rows_ = grad_rows.contiguous();
+  constexpr int32_t kWarpsPerBlock = kMaxThreads / kWarpSize;
+  FBGEMM_DISPATCH_FLOATING_TYPES(
+      dense.scalar_type(), "apply_sparse_embedding_grad_1", [&] {
+        using emb_t = scalar_t;
+        FBGEMM_DISPATCH_FLOATING_TYPES(
+            grad_rows_.scalar_type(), "apply_sparse_embedding_grad_2", [&] {
+#ifdef FBGEMM_GPU_MEMCHECK
+              const auto func_name = "apply_sparse_grad_kernel";
+#endif
+              apply_sparse_grad_kernel<emb_t, scalar_t>
+                  <<<div_round_up(N, kWarpsPerBlock),
+                     kMaxThreads,
+                     0,
+                     at::cuda::getCurrentCUDAStream()>>>(
+                      MAKE_PTA_WITH_NAME(func_name, dense, emb_t, 1, 64),
+                      MAKE_PTA_WITH_NAME(
+                          func_name, weights_offsets, int64_t, 1, 32),
+                      MAKE_PTA_WITH_NAME(func_name, D_offsets, int32_t, 1, 32),
+                      MAKE_PTA_WITH_NAME(
+                          func_name, hash_size_cumsum, int64_t, 1, 32),
+                      MAKE_PTA_WITH_NAME(func_name, ids_sorted, int64_t, 1, 32),
+                      MAKE_PTA_WITH_NAME(
+                          func_name, positions_sorted, int32_t, 1, 32),
+                      MAKE_PTA_WITH_NAME(
+                          func_name, grad_rows_, scalar_t, 2, 64),
+                      static_cast<float>(scale));
+              C10_CUDA_KERNEL_LAUNCH_CHECK();
+            });
+      });
+}
@@ -66,9 +66,52 @@ TORCH_LIBRARY_FRAGMENT(fbgemm, m) {
       "    int info_B_num_bits, "
       "    SymInt total_B"
       ") -> (Tensor, Tensor)");
+  m.def(
+      "segment_length_histogram("
+      "    Tensor sorted_linear_indices_num_runs, "
+      "    Tensor sorted_linear_indices_cumulative_run_lengths, "
+      "    Tensor infos_sorted, "
+      "    int T, "
+      "    int info_B_num_bits=26"
+      ") -> Tensor");
+  m.def(
+      "adaptive_max_segment_length_per_warp("
+      "    Tensor histogram, "
+      "    int base_max_segment_length_per_warp, "
+      "    int warps_per_cta"
+      ") -> Tensor");
+  m.def(
+      "compute_sparse_embedding_grad("
+      "    Tensor grad_output, "
+      "    Tensor sorted_linear_indices_run, "
+      "    Tensor sorted_linear_indices_cumulative_run_lengths, "
+      "    Tensor sorted_linear_indices_num_runs, "
+      "    Tensor infos_sorted, "
+      "    Tensor D_offsets, "
+      "    int max_D, "
+      "    int info_B_num_bits=26, "
+      "    int info_B_mask=0x2FFFFFF"
+      ") -> (Tensor, Tensor)");
+  m.def(
+      "apply_sparse_embedding_grad("
+      "    Tensor(a!) dense, "
+      "    Tensor weights_offsets, "
+      "    Tensor D_offsets, "
+      "    Tensor hash_size_cumsum, "
+      "    Tensor unique_ids, "
+      "    Tensor grad_rows, "
+      "    float scale=1.0"
+      ") -> ()");
   DISPATCH_TO_CUDA("transpose_embedding_input", transpose_embedding_input);
   DISPATCH_TO_CUDA("get_infos_metadata", get_infos_metadata);
   DISPATCH_TO_CUDA("generate_vbe_metadata", generate_vbe_metadata);
+  DISPATCH_TO_CUDA("segment_length_histogram", segment_length_histogram);
+  DISPATCH_TO_CUDA(
+      "adaptive_max_segment_length_per_warp",
+      adaptive_max_segment_length_per_warp);
+  DISPATCH_TO_CUDA(
+      "compute_sparse_embedding_grad", compute_sparse_embedding_grad);
+  DISPATCH_TO_CUDA("apply_sparse_embedding_grad", apply_sparse_embedding_grad);
 }
 
 TORCH_LIBRARY_IMPL(fbgemm, Meta, m) {
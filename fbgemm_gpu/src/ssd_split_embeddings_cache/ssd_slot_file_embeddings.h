@@ -0,0 +1,420 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <folly/ScopeGuard.h>
+#include <folly/container/F14Map.h>
+#include <glog/logging.h>
+
+#include "./ssd_table_batched_embeddings.h"
+
+namespace ssd {
+
+// Offsets, sizes and buffers of the direct I/O calls are multiples of a page.
+constexpr int64_t kSlotFilePageBytes = 4096;
+
+// File of fixed-width rows of one shard of EmbeddingSlotFileDB, with an
+// in-memory hash index from row id to slot. Rows smaller than a page are packed
+// into pages, larger rows take whole pages. Rows are never moved nor deleted:
+// a write overwrites the slot of a row, or appends a slot. The file is opened
+// with O_DIRECT, falling back to buffered I/O on file systems without it.
+// Reads and writes sort the pages of a batch and coalesce the runs of
+// consecutive pages into a single pread or pwrite.
+class SlotFile {
+ public:
+  SlotFile(const std::string& path, int64_t row_bytes)
+      : row_bytes_(row_bytes),
+        rows_per_page_(std::max<int64_t>(1, kSlotFilePageBytes / row_bytes)),
+        page_bytes_(
+            rows_per_page_ > 1 ? kSlotFilePageBytes
+                               : (row_bytes + kSlotFilePageBytes - 1) /
+                    kSlotFilePageBytes * kSlotFilePageBytes) {
+    CHECK_GT(row_bytes_, 0);
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+    if (fd_ < 0 && errno == EINVAL) {
+      LOG(WARNING)
+          << "Warning, Requested DirectIO, but not supported on destination: "
+          << path;
+      fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    }
+    PCHECK(fd_ >= 0) << "Failed to open " << path;
+  }
+
+  ~SlotFile() {
+    ::close(fd_);
+  }
+
+  SlotFile(const SlotFile&) = delete;
+  SlotFile& operator=(const SlotFile&) = delete;
+
+  std::mutex& mutex() {
+    return mutex_;
+  }
+
+  // Returns the slot of key, or -1 if it was never written
+  int64_t find(int64_t key) const {
+    auto it = slots_.find(key);
+    return it == slots_.end() ? -1 : it->second;
+  }
+
+  // Reads the first bytes of the rows of the given (slot, dst) pairs. Each
+  // page is read once, however many of its rows (or copies of a row) are read
+  void read(std::vector<std::pair<int64_t, char*>>& rows, int64_t bytes) {
+    CHECK_LE(bytes, row_bytes_);
+    if (rows.empty()) {
+      return;
+    }
+    std::sort(rows.begin(), rows.end(), [](const auto& lhs, const auto& rhs) {
+      return lhs.first < rhs.first;
+    });
+    std::vector<int64_t> pages;
+    for (const auto& row : rows) {
+      const auto page = row.first / rows_per_page_;
+      if (pages.empty() || pages.back() != page) {
+        pages.push_back(page);
+      }
+    }
+    auto* buffer = allocate_pages(pages.size());
+    SCOPE_EXIT {
+      std::free(buffer);
+    };
+    transfer_pages(pages, std::vector<bool>(pages.size(), true), buffer, false);
+
+    size_t p = 0;
+    for (const auto& row : rows) {
+      const auto page = row.first / rows_per_page_;
+      while (pages[p] != page) {
+        ++p;
+      }
+      std::memcpy(
+          row.second,
+          buffer + p * page_bytes_ + (row.first % rows_per_page_) * row_bytes_,
+          bytes);
+    }
+  }
+
+  // Writes the first bytes of the rows of the given (key, src) pairs, the last
+  // one winning for a duplicated key
+  void write(
+      const std::vector<std::pair<int64_t, const char*>>& rows,
+      int64_t bytes) {
+    CHECK_LE(bytes, row_bytes_);
+    if (rows.empty()) {
+      return;
+    }
+    const auto num_old_slots = num_slots_;
+    std::vector<std::pair<int64_t, const char*>> slot_rows;
+    slot_rows.reserve(rows.size());
+    for (const auto& row : rows) {
+      auto it = slots_.find(row.first);
+      if (it == slots_.end()) {
+        it = slots_.emplace(row.first, num_slots_++).first;
+      }
+      slot_rows.emplace_back(it->second, row.second);
+    }
+    // Stable to keep the last write of a duplicated key last
+    std::stable_sort(
+        slot_rows.begin(),
+        slot_rows.end(),
+        [](const auto& lhs, const auto& rhs) { return lhs.first < rhs.first; });
+
+    // A page holding rows of previous writes is read back first, unless all
+    // its rows are overwritten
+    std::vector<int64_t> pages;
+    std::vector<bool> read_back;
+    int64_t page_slots = 0;
+    for (size_t i = 0; i < slot_rows.size(); ++i) {
+      const auto slot = slot_rows[i].first;
+      const auto page = slot / rows_per_page_;
+      if (pages.empty() || pages.back() != page) {
+        if (!pages.empty()) {
+          read_back.back() = read_back.back() && page_slots < rows_per_page_;
+        }
+        pages.push_back(page);
+        read_back.push_back(page * rows_per_page_ < num_old_slots);
+        page_slots = 0;
+      }
+      if (i == 0 || slot_rows[i - 1].first != slot) {
+        ++page_slots;
+      }
+    }
+    read_back.back() = read_back.back() && page_slots < rows_per_page_;
+
+    auto* buffer = allocate_pages(pages.size());
+    SCOPE_EXIT {
+      std::free(buffer);
+    };
+    for (size_t p = 0; p < pages.size(); ++p) {
+      if (!read_back[p]) {
+        std::memset(buffer + p * page_bytes_, 0, page_bytes_);
+      }
+    }
+    transfer_pages(pages, read_back, buffer, false);
+
+    size_t p = 0;
+    for (const auto& row : slot_rows) {
+      const auto page = row.first / rows_per_page_;
+      while (pages[p] != page) {
+        ++p;
+      }
+      std::memcpy(
+          buffer + p * page_bytes_ + (row.first % rows_per_page_) * row_bytes_,
+          row.second,
+          bytes);
+    }
+    transfer_pages(pages, std::vector<bool>(pages.size(), true), buffer, true);
+  }
+
+  void flush() {
+    PCHECK(::fdatasync(fd_) == 0);
+  }
+
+ private:
+  char* allocate_pages(size_t num_pages) const {
+    auto* buffer = static_cast<char*>(
+        std::aligned_alloc(kSlotFilePageBytes, num_pages * page_bytes_));
+    CHECK(buffer != nullptr);
+    return buffer;
+  }
+
+  // Reads or writes the selected pages of the sorted unique pages, page p
+  // being at buffer + p * page_bytes_. Pages beyond the end of the file read
+  // as zeros.
+  void transfer_pages(
+      const std::vector<int64_t>& pages,
+      const std::vector<bool>& selected,
+      char* buffer,
+      bool is_write) {
+    size_t begin = 0;
+    while (begin < pages.size()) {
+      if (!selected[begin]) {
+        ++begin;
+        continue;
+      }
+      auto end = begin + 1;
+      while (end < pages.size() && selected[end] &&
+             pages[end] == pages[end - 1] + 1) {
+        ++end;
+      }
+      auto* data = buffer + begin * page_bytes_;
+      auto size = static_cast<int64_t>(end - begin) * page_bytes_;
+      auto offset = pages[begin] * page_bytes_;
+      while (size > 0) {
+        const auto n = is_write ? ::pwrite(fd_, data, size, offset)
+                                : ::pread(fd_, data, size, offset);
+        if (n < 0 && errno == EINTR) {
+          continue;
+        }
+        PCHECK(n >= 0) << (is_write ? "pwrite" : "pread") << " failed";
+        if (n == 0) {
+          CHECK(!is_write);
+          std::memset(data, 0, size);
+          break;
+        }
+        data += n;
+        size -= n;
+        offset += n;
+      }
+      begin = end;
+    }
+  }
+
+  const int64_t row_bytes_;
+  const int64_t rows_per_page_;
+  const int64_t page_bytes_;
+  int fd_;
+  folly::F14FastMap<int64_t, int64_t> slots_;
+  int64_t num_slots_{0};
+  std::mutex mutex_;
+};
+
+// SSD store of fixed-width embedding rows, with the get/set interface of
+// EmbeddingRocksDB but without its key/value machinery (bloom filters,
+// memtables, compactions): rows live in the slot files of the shards.
+class EmbeddingSlotFileDB
+    : public std::enable_shared_from_this<EmbeddingSlotFileDB> {
+ public:
+  EmbeddingSlotFileDB(
+      std::string path,
+      int64_t num_shards,
+      int64_t max_D,
+      float uniform_init_lower,
+      float uniform_init_upper,
+      int64_t row_storage_bitwidth = 32,
+      int64_t init_threads_per_shard = 1) {
+    CHECK_GT(num_shards, 0);
+    for (auto i = 0; i < num_shards; ++i) {
+      shards_.push_back(std::make_unique<SlotFile>(
+          path + std::string("/shard_") + std::to_string(i) + ".slots",
+          max_D * row_storage_bitwidth / 8));
+      auto* gen = at::check_generator<at::CPUGeneratorImpl>(
+          at::detail::getDefaultCPUGenerator());
+      {
+        std::lock_guard<std::mutex> lock(gen->mutex_);
+        initializers_.push_back(std::make_unique<Initializer>(
+            gen->random64(),
+            max_D,
+            uniform_init_lower,
+            uniform_init_upper,
+            row_storage_bitwidth,
+            init_threads_per_shard));
+      }
+    }
+    executor_ = std::make_unique<folly::CPUThreadPoolExecutor>(num_shards);
+    callback_executor_ = std::make_unique<folly::CPUThreadPoolExecutor>(1);
+  }
+
+  void set(Tensor indices, Tensor weights, Tensor count) {
+    RECORD_USER_SCOPE("EmbeddingSlotFileDB::set");
+    std::vector<folly::Future<folly::Unit>> futures;
+    auto count_ = count.item().toLong();
+    for (auto shard = 0; shard < shards_.size(); ++shard) {
+      auto f =
+          folly::via(executor_.get())
+              .thenValue([=, &indices, &weights](folly::Unit) {
+                FBGEMM_DISPATCH_FLOAT_HALF_AND_BYTE(
+                    weights.scalar_type(), "ssd_slot_file_set", [&] {
+                      CHECK(indices.is_contiguous());
+                      CHECK(weights.is_contiguous());
+                      CHECK_EQ(indices.size(0), weights.size(0));
+                      auto indices_data_ptr = indices.data_ptr<int64_t>();
+                      auto weights_data_ptr = weights.data_ptr<scalar_t>();
+                      auto D = weights.size(1);
+                      std::vector<std::pair<int64_t, const char*>> rows;
+                      for (auto i = 0; i < count_; ++i) {
+                        if (db_shard(indices_data_ptr[i], shards_.size()) !=
+                            shard) {
+                          continue;
+                        }
+                        rows.emplace_back(
+                            indices_data_ptr[i],
+                            reinterpret_cast<const char*>(
+                                &(weights_data_ptr[i * D])));
+                      }
+                      auto& slot_file = *shards_[shard];
+                      std::lock_guard<std::mutex> lock(slot_file.mutex());
+                      slot_file.write(rows, D * sizeof(scalar_t));
+                    });
+              });
+      futures.push_back(std::move(f));
+    }
+    folly::collect(futures).wait();
+  }
+
+  void get(Tensor indices, Tensor weights, Tensor count) {
+    RECORD_USER_SCOPE("EmbeddingSlotFileDB::get");
+    std::vector<folly::Future<folly::Unit>> futures;
+    auto count_ = count.item().toLong();
+    for (auto shard = 0; shard < shards_.size(); ++shard) {
+      auto f =
+          folly::via(executor_.get())
+              .thenValue([=, &indices, &weights](folly::Unit) {
+                FBGEMM_DISPATCH_FLOAT_HALF_AND_BYTE(
+                    weights.scalar_type(), "ssd_slot_file_get", [&] {
+                      CHECK(indices.is_contiguous());
+                      CHECK(weights.is_contiguous());
+                      CHECK_EQ(indices.size(0), weights.size(0));
+                      auto indices_data_ptr = indices.data_ptr<int64_t>();
+                      auto weights_data_ptr = weights.data_ptr<scalar_t>();
+                      auto D = weights.size(1);
+                      auto& slot_file = *shards_[shard];
+                      std::lock_guard<std::mutex> lock(slot_file.mutex());
+                      std::vector<std::pair<int64_t, char*>> rows;
+                      // First row of each missing id, duplicated ids
+                      // getting the same initial row
+                      folly::F14FastMap<int64_t, int64_t> missing_rows;
+                      for (auto i = 0; i < count_; ++i) {
+                        if (db_shard(indices_data_ptr[i], shards_.size()) !=
+                            shard) {
+                          continue;
+                        }
+                        const auto slot = slot_file.find(indices_data_ptr[i]);
+                        if (slot >= 0) {
+                          rows.emplace_back(
+                              slot,
+                              reinterpret_cast<char*>(
+                                  &(weights_data_ptr[i * D])));
+                          continue;
+                        }
+                        const auto it =
+                            missing_rows.emplace(indices_data_ptr[i], i).first;
+                        if (it->second == i) {
+                          initializers_[shard]->fill_row(
+                              &(weights_data_ptr[i * D]), D);
+                        } else {
+                          std::copy(
+                              &(weights_data_ptr[it->second * D]),
+                              &(weights_data_ptr[it->second * D + D]),
+                              &(weights_data_ptr[i * D]));
+                        }
+                      }
+                      slot_file.read(rows, D * sizeof(scalar_t));
+                    });
+              });
+      futures.push_back(std::move(f));
+    }
+    folly::collect(futures).wait();
+  }
+
+  void flush() {
+    for (auto& shard : shards_) {
+      std::lock_guard<std::mutex> lock(shard->mutex());
+      shard->flush();
+    }
+  }
+
+  // Waits for the set_cuda() whose callbacks the streams already ran, the
+  // set() running after the stream goes on
+  void wait_for_callbacks() {
+    folly::via(callback_executor_.get()).thenValue([](folly::Unit) {}).wait();
+  }
+
+  void get_cuda(Tensor indices, Tensor weights, Tensor count) {
+    // take reference to self to avoid lifetime issues.
+    addStreamCallback(
+        shared_from_this(),
+        callback_executor_.get(),
+        [=]() { get(indices, weights, count); },
+        /*blocking=*/true);
+  }
+
+  // timestep is unused, slot files having no memtables to flush
+  void set_cuda(
+      Tensor indices,
+      Tensor weights,
+      Tensor count,
+      int64_t /* timestep */) {
+    // take reference to self to avoid lifetime issues.
+    addStreamCallback(
+        shared_from_this(),
+        callback_executor_.get(),
+        [=]() { set(indices, weights, count); },
+        /*blocking=*/false);
+  }
+
+ private:
+  std::vector<std::unique_ptr<SlotFile>> shards_;
+  std::vector<std::unique_ptr<Initializer>> initializers_;
+  std::unique_ptr<folly::CPUThreadPoolExecutor> executor_;
+  // Runs the get_cuda() and set_cuda() of this store in order
+  std::unique_ptr<folly::CPUThreadPoolExecutor> callback_executor_;
+};
+
+} // namespace ssd
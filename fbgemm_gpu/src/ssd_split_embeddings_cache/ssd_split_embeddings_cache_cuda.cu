@@ -138,9 +138,9 @@ __global__ __launch_bounds__(kMaxThreads) void ssd_cache_actions_insert_kernel(
         cache_set_sorted_indices, // [N = \sum_{b} L_{b} total indices, i.e.
                                   // flattened [B][L]
     int64_t time_stamp,
-    int64_t prefetch_dist, // Number of batches we can prefetch ahead of a
-                           // forward call A value of 1 means that entries where
-                           // timestep with insert_time >= time_stamp -
+    int64_t prefetch_dist, // Number of batches prefetched but not yet
+                           // consumed by a forward call, this one included.
+                           // Entries with insert_time > time_stamp -
                            // prefetch_dist are locked, and cannot be evicted.
     pta::PackedTensorAccessor32<int64_t, 2, at::RestrictPtrTraits> lru_state,
     pta::PackedTensorAccessor32<int32_t, 1, at::RestrictPtrTraits>
@@ -234,8 +234,9 @@ __global__ __launch_bounds__(kMaxThreads) void ssd_cache_actions_insert_kernel(
     }
 #endif
 
-    if (current_idx != -1 && insert_time == time_stamp) {
-      // Skip this slot as the inserted row was a cache hit
+    if (current_idx != -1 && insert_time > time_stamp - prefetch_dist) {
+      // Skip this slot as the row in it was a cache hit of this batch or is
+      // used by a batch prefetched earlier that has not run its forward yet
       // This is conflict miss
       evicted_indices[n + l] = -1;
       assigned_cache_slots[n + l] = -1;
@@ -14,6 +14,7 @@
 
 #include <torch/custom_class.h>
 
+#include "./ssd_slot_file_embeddings.h"
 #include "./ssd_table_batched_embeddings.h"
 #include "fbgemm_gpu/sparse_ops_utils.h"
 
@@ -112,7 +113,10 @@ class EmbeddingRocksDBWrapper : public torch::jit::CustomClassHolder {
       int64_t max_write_buffer_num,
       double uniform_init_lower,
       double uniform_init_upper,
-      int64_t row_storage_bitwidth = 32)
+      int64_t row_storage_bitwidth = 32,
+      int64_t dram_cache_rows = 0,
+      int64_t init_threads_per_shard = 1,
+      int64_t row_compression_bit_rate = 0)
       : impl_(std::make_shared<ssd::EmbeddingRocksDB>(
             path,
             num_shards,
@@ -128,7 +132,10 @@ class EmbeddingRocksDBWrapper : public torch::jit::CustomClassHolder {
             max_write_buffer_num,
             uniform_init_lower,
             uniform_init_upper,
-            row_storage_bitwidth)) {}
+            row_storage_bitwidth,
+            dram_cache_rows,
+            init_threads_per_shard,
+            row_compression_bit_rate)) {}
 
   void
   set_cuda(Tensor indices, Tensor weights, Tensor count, int64_t timestep) {
@@ -140,21 +147,56 @@ class EmbeddingRocksDBWrapper : public torch::jit::CustomClassHolder {
   }
 
   void set(Tensor indices, Tensor weights, Tensor count) {
+    impl_->wait_for_callbacks();
     return impl_->set(indices, weights, count);
   }
 
   void get(Tensor indices, Tensor weights, Tensor count) {
+    impl_->wait_for_callbacks();
     return impl_->get(indices, weights, count);
   }
 
+  void set_table_dims(Tensor table_offsets, Tensor table_dims) {
+    impl_->wait_for_callbacks();
+    return impl_->set_table_dims(table_offsets, table_dims);
+  }
+
   void compact() {
+    impl_->wait_for_callbacks();
     return impl_->compact();
   }
 
   void flush() {
+    impl_->wait_for_callbacks();
     return impl_->flush();
   }
 
+  Tensor get_cache_stats() {
+    impl_->wait_for_callbacks();
+    return impl_->get_cache_stats();
+  }
+
+  int64_t create_snapshot() {
+    impl_->wait_for_callbacks();
+    return impl_->create_snapshot();
+  }
+
+  Tensor get_snapshot_ids(int64_t handle) {
+    return impl_->get_snapshot_ids(handle);
+  }
+
+  void get_from_snapshot(
+      int64_t handle,
+      Tensor indices,
+      Tensor weights,
+      Tensor count) {
+    return impl_->get_from_snapshot(handle, indices, weights, count);
+  }
+
+  void release_snapshot(int64_t handle) {
+    return impl_->release_snapshot(handle);
+  }
+
  private:
   // shared pointer since we use shared_from_this() in callbacks.
   std::shared_ptr<ssd::EmbeddingRocksDB> impl_;
@@ -177,13 +219,88 @@ static auto embedding_rocks_db_wrapper =
              int64_t,
              double,
              double,
+             int64_t,
+             int64_t,
+             int64_t,
              int64_t>())
         .def("set_cuda", &EmbeddingRocksDBWrapper::set_cuda)
         .def("get_cuda", &EmbeddingRocksDBWrapper::get_cuda)
+        .def("set_table_dims", &EmbeddingRocksDBWrapper::set_table_dims)
         .def("compact", &EmbeddingRocksDBWrapper::compact)
         .def("flush", &EmbeddingRocksDBWrapper::flush)
         .def("set", &EmbeddingRocksDBWrapper::set)
-        .def("get", &EmbeddingRocksDBWrapper::get);
+        .def("get", &EmbeddingRocksDBWrapper::get)
+        .def("get_cache_stats", &EmbeddingRocksDBWrapper::get_cache_stats)
+        .def("create_snapshot", &EmbeddingRocksDBWrapper::create_snapshot)
+        .def("get_snapshot_ids", &EmbeddingRocksDBWrapper::get_snapshot_ids)
+        .def("get_from_snapshot", &EmbeddingRocksDBWrapper::get_from_snapshot)
+        .def("release_snapshot", &EmbeddingRocksDBWrapper::release_snapshot);
+
+class EmbeddingSlotFileWrapper : public torch::jit::CustomClassHolder {
+ public:
+  EmbeddingSlotFileWrapper(
+      std::string path,
+      int64_t num_shards,
+      int64_t max_D,
+      double uniform_init_lower,
+      double uniform_init_upper,
+      int64_t row_storage_bitwidth = 32,
+      int64_t init_threads_per_shard = 1)
+      : impl_(std::make_shared<ssd::EmbeddingSlotFileDB>(
+            path,
+            num_shards,
+            max_D,
+            uniform_init_lower,
+            uniform_init_upper,
+            row_storage_bitwidth,
+            init_threads_per_shard)) {}
+
+  void
+  set_cuda(Tensor indices, Tensor weights, Tensor count, int64_t timestep) {
+    return impl_->set_cuda(indices, weights, count, timestep);
+  }
+
+  void get_cuda(Tensor indices, Tensor weights, Tensor count) {
+    return impl_->get_cuda(indices, weights, count);
+  }
+
+  void set(Tensor indices, Tensor weights, Tensor count) {
+    impl_->wait_for_callbacks();
+    return impl_->set(indices, weights, count);
+  }
+
+  void get(Tensor indices, Tensor weights, Tensor count) {
+    impl_->wait_for_callbacks();
+    return impl_->get(indices, weights, count);
+  }
+
+  void flush() {
+    impl_->wait_for_callbacks();
+    return impl_->flush();
+  }
+
+ private:
+  // shared pointer since we use shared_from_this() in callbacks.
+  std::shared_ptr<ssd::EmbeddingSlotFileDB> impl_;
+};
+
+static auto embedding_slot_file_wrapper =
+    torch::class_<EmbeddingSlotFileWrapper>(
+        "fbgemm",
+        "EmbeddingSlotFileWrapper")
+        .def(torch::init<
+             std::string,
+             int64_t,
+             int64_t,
+             double,
+             double,
+             int64_t,
+             int64_t>())
+        .def("set_cuda", &EmbeddingSlotFileWrapper::set_cuda)
+        .def("get_cuda", &EmbeddingSlotFileWrapper::get_cuda)
+        .def("flush", &EmbeddingSlotFileWrapper::flush)
+        .def("set", &EmbeddingSlotFileWrapper::set)
+        .def("get", &EmbeddingSlotFileWrapper::get);
 
 TORCH_LIBRARY_FRAGMENT(fbgemm, m) {
   m.def(
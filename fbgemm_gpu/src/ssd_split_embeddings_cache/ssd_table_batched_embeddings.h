@@ -12,12 +12,23 @@
     (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
 #include <mkl.h>
 #endif
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <mutex>
 #include <random>
+#include <thread>
+#include <vector>
 
 #include <ATen/ATen.h>
 #include <ATen/record_function.h>
 
 #include <folly/container/F14Map.h>
+#include <folly/container/F14Set.h>
 #include <glog/logging.h>
 
 #include <folly/Random.h>
@@ -31,12 +42,14 @@
 #include <rocksdb/filter_policy.h>
 #include <rocksdb/rate_limiter.h>
 #include <rocksdb/slice_transform.h>
+#include <rocksdb/statistics.h>
 #include <rocksdb/table.h>
 #include <rocksdb/table_properties.h>
 
 #include <ATen/cuda/CUDAContext.h>
 #include <cuda_runtime.h>
 
+#include "fbgemm/QuantUtils.h"
 #include "fbgemm_gpu/dispatch_macros.h"
 
 namespace ssd {
@@ -48,6 +61,57 @@ void hostAsynchronousThreadPoolExecutor(void (*f)(void*), void* userData) {
   g.add([f, userData]() { f(userData); });
 }
 
+// Drops ref on the hostAsynchronousThreadPoolExecutor thread, so that an SSD
+// store is never destroyed by one of its own threads
+inline void releaseAsynchronously(std::shared_ptr<void> ref) {
+  hostAsynchronousThreadPoolExecutor(
+      [](void* userData) {
+        delete reinterpret_cast<std::shared_ptr<void>*>(userData);
+      },
+      new std::shared_ptr<void>(std::move(ref)));
+}
+
+// Runs work on the serial callback executor of an SSD store once the current
+// stream reaches this point. CUDA runs the host callbacks of all the streams
+// on a single thread, so the callback only waits for work when blocking, e.g.
+// for a get() whose rows the stream reads next; otherwise the stream goes on
+// and stores overlap their IO. The work of a store runs in order, so a get()
+// waits for the set()s enqueued before it. work must not own self.
+inline void addStreamCallback(
+    std::shared_ptr<void> self,
+    folly::Executor* executor,
+    std::function<void()> work,
+    bool blocking) {
+  std::function<void()>* functor = new std::function<void()>([=]() {
+    if (blocking) {
+      folly::via(executor).thenValue([&](folly::Unit) { work(); }).wait();
+    } else {
+      executor->add([self, work]() mutable {
+        work();
+        releaseAsynchronously(std::move(self));
+      });
+    }
+  });
+  auto callFunctor =
+      [](cudaStream_t stream, cudaError_t status, void* userData) -> void {
+    AT_CUDA_CHECK(status);
+    auto* f = reinterpret_cast<std::function<void()>*>(userData);
+    AT_CUDA_CHECK(cudaGetLastError());
+    (*f)();
+    // delete f; // unfortunately, this invoke destructors that call CUDA
+    // API functions (e.g. caching host allocators issue cudaGetDevice(..),
+    // etc)
+    hostAsynchronousThreadPoolExecutor(
+        [](void* userData) {
+          auto* f = reinterpret_cast<std::function<void()>*>(userData);
+          delete f;
+        },
+        userData);
+  };
+  AT_CUDA_CHECK(cudaStreamAddCallback(
+      at::cuda::getCurrentCUDAStream(), callFunctor, functor, 0));
+}
+
 // TODO: does this need to be different from the cache slot hashing function?
 // Probably not right?
 inline size_t db_shard(int64_t id, size_t num_shards) {
@@ -60,6 +124,21 @@ inline size_t db_shard(int64_t id, size_t num_shards) {
 // We can be a bit sloppy with host memory here.
 constexpr size_t kRowInitBufferSize = 32 * 1024;
 
+// The scheduled flushes and compactions of a shard are deferred while the
+// recent get() latency per row exceeds its long run average by this ratio
+constexpr double kBusyGetLatencyRatio = 1.5;
+// but at most this many times in a row, and never when writes stall or when
+// the level 0 files reach twice l0_files_per_compact
+constexpr int64_t kMaxBackgroundWorkDeferrals = 4;
+
+// Ring of randomly initialized rows for the rows of a shard missing from
+// RocksDB. The ring is split between num_threads producers, each with its own
+// PRNG stream and queues, and get() takes its rows from the producers in turn
+// so that they refill their rows in parallel. Rows are initialized natively
+// in the row storage format: uniform floats for 32-bit, uniform halves for
+// 16-bit and rowwise quantized INT8 rows (fp16 scale and bias, then uint8
+// values) for 8-bit. The consumer side (fill_row) is single threaded, as each
+// shard is read by one task at a time.
 class Initializer {
  public:
   Initializer(
@@ -67,11 +146,14 @@ class Initializer {
       int64_t max_D,
       float uniform_init_lower,
       float uniform_init_upper,
-      int64_t row_storage_bitwidth = 32)
-      : producer_queue_(), consumer_queue_() {
+      int64_t row_storage_bitwidth = 32,
+      int64_t num_threads = 1)
+      : max_D_(max_D) {
     CHECK(
         row_storage_bitwidth == 32 || row_storage_bitwidth == 16 ||
         row_storage_bitwidth == 8);
+    CHECK_GT(num_threads, 0);
+    num_threads = std::min<int64_t>(num_threads, kRowInitBufferSize);
     if (row_storage_bitwidth == 32) {
       row_storage_ = at::empty(
           {kRowInitBufferSize, max_D}, at::TensorOptions().dtype(at::kFloat));
@@ -82,76 +164,240 @@ class Initializer {
       row_storage_ = at::empty(
           {kRowInitBufferSize, max_D}, at::TensorOptions().dtype(at::kByte));
     }
-    producer_ = std::make_unique<std::thread>([=] {
+    for (auto t = 0; t < num_threads; ++t) {
+      producers_.push_back(std::make_unique<Producer>());
+    }
+    for (auto t = 0; t < num_threads; ++t) {
+      const int64_t begin = kRowInitBufferSize * t / num_threads;
+      const int64_t end = kRowInitBufferSize * (t + 1) / num_threads;
+      // Decorrelated seeds give each producer its own stream
+      const uint64_t seed = folly::hash::twang_mix64(random_seed + t);
+      auto* producer = producers_[t].get();
+      producer->thread = std::thread([=] {
+        run_producer(
+            producer,
+            seed,
+            begin,
+            end,
+            uniform_init_lower,
+            uniform_init_upper,
+            row_storage_bitwidth);
+      });
+    }
+  }
+
+  ~Initializer() {
+    stop_ = true;
+    for (auto& producer : producers_) {
+      producer->thread.join();
+    }
+  }
+
+  // Copies the first D elements of the next initialized row to dst and hands
+  // the row back to its producer to be reinitialized
+  template <typename scalar_t>
+  void fill_row(scalar_t* dst, int64_t D) {
+    auto* producer = producers_[next_producer_].get();
+    next_producer_ = (next_producer_ + 1) % producers_.size();
+    int64_t row_index;
+    producer->producer_queue.dequeue(row_index);
+    const auto* row = row_storage_.data_ptr<scalar_t>() + row_index * max_D_;
+    std::copy(row, row + D, dst);
+    producer->consumer_queue.enqueue(row_index);
+  }
+
+ private:
+  struct Producer {
+    folly::USPSCQueue<int64_t, true> producer_queue;
+    folly::USPSCQueue<int64_t, true> consumer_queue;
+    std::thread thread;
+  };
+
+  void run_producer(
+      Producer* producer,
+      uint64_t seed,
+      int64_t begin,
+      int64_t end,
+      float uniform_init_lower,
+      float uniform_init_upper,
+      int64_t row_storage_bitwidth) {
 #if defined(__x86_64__) || defined(__i386__) || \
     (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
-      VSLStreamStatePtr stream;
+    VSLStreamStatePtr stream;
+    CHECK_EQ(VSL_ERROR_OK, vslNewStream(&stream, VSL_BRNG_SFMT19937, seed));
+    auto rng_uniform = [&](size_t n, float* ptr) {
       CHECK_EQ(
-          VSL_ERROR_OK, vslNewStream(&stream, VSL_BRNG_SFMT19937, random_seed));
-      auto rng_uniform = [&](size_t n, float* ptr) {
-        CHECK_EQ(
-            VSL_ERROR_OK,
-            vsRngUniform(
-                VSL_RNG_METHOD_UNIFORM_STD,
-                stream,
-                n,
-                ptr,
-                uniform_init_lower,
-                uniform_init_upper));
-      };
-      SCOPE_EXIT {
-        vslDeleteStream(&stream);
-      };
+          VSL_ERROR_OK,
+          vsRngUniform(
+              VSL_RNG_METHOD_UNIFORM_STD,
+              stream,
+              n,
+              ptr,
+              uniform_init_lower,
+              uniform_init_upper));
+    };
+    SCOPE_EXIT {
+      vslDeleteStream(&stream);
+    };
 
 #else
-      folly::Random::DefaultGenerator gen(random_seed);
-      auto rng_uniform = [&](size_t n, float* ptr) {
-        std::uniform_real_distribution<float> dis(
-            uniform_init_lower, uniform_init_upper);
-        for (auto i = 0; i < n; i++) {
-          ptr[i] = dis(gen);
-        }
-      };
+    folly::Random::DefaultGenerator gen(seed);
+    auto rng_uniform = [&](size_t n, float* ptr) {
+      std::uniform_real_distribution<float> dis(
+          uniform_init_lower, uniform_init_upper);
+      for (auto i = 0; i < n; i++) {
+        ptr[i] = dis(gen);
+      }
+    };
 #endif
+    // INT8 rows quantize the range [lower, upper] with a fixed scale and
+    // bias, the values being drawn uniformly
+    constexpr int64_t kQParamBytes = 2 * sizeof(at::Half);
+    const float scale = (uniform_init_upper - uniform_init_lower) / 255.0f;
+    const float inv_scale = scale > 0 ? 1.0f / scale : 0.0f;
+    std::vector<float> scratch(row_storage_bitwidth == 32 ? 0 : max_D_);
+    auto init_row = [&](int64_t i) {
       if (row_storage_bitwidth == 32) {
-        rng_uniform(kRowInitBufferSize * max_D, row_storage_.data_ptr<float>());
-      }
-      for (auto i = 0; i < kRowInitBufferSize; ++i) {
-        producer_queue_.enqueue(i);
-      }
-
-      while (!stop_) {
-        int64_t i;
-        while (!stop_ &&
-               !consumer_queue_.try_dequeue_until(
-                   i,
-                   std::chrono::steady_clock::now() +
-                       std::chrono::milliseconds(100))) {
-          // loop.
+        rng_uniform(max_D_, row_storage_.data_ptr<float>() + i * max_D_);
+      } else if (row_storage_bitwidth == 16) {
+        rng_uniform(max_D_, scratch.data());
+        auto* row = row_storage_.data_ptr<at::Half>() + i * max_D_;
+        for (auto d = 0; d < max_D_; ++d) {
+          row[d] = at::Half(scratch[d]);
         }
-        if (stop_) {
+      } else {
+        auto* row = row_storage_.data_ptr<uint8_t>() + i * max_D_;
+        if (max_D_ < kQParamBytes) {
+          std::fill_n(row, max_D_, 0);
           return;
         }
-        // dequeued a row. Reinitialize and enqueue it.
-        if (row_storage_bitwidth == 32) {
-          rng_uniform(max_D, row_storage_.data_ptr<float>() + i * max_D);
+        const int64_t num_values = max_D_ - kQParamBytes;
+        rng_uniform(num_values, scratch.data());
+        auto* qparams = reinterpret_cast<at::Half*>(row);
+        qparams[0] = at::Half(scale);
+        qparams[1] = at::Half(uniform_init_lower);
+        for (auto d = 0; d < num_values; ++d) {
+          row[kQParamBytes + d] = static_cast<uint8_t>(std::clamp(
+              std::lrintf((scratch[d] - uniform_init_lower) * inv_scale),
+              0L,
+              255L));
         }
-        producer_queue_.enqueue(i);
       }
-    });
-  }
+    };
 
-  ~Initializer() {
-    stop_ = true;
-    producer_->join();
-  }
+    for (auto i = begin; i < end; ++i) {
+      init_row(i);
+      producer->producer_queue.enqueue(i);
+    }
 
-  folly::USPSCQueue<int64_t, true> producer_queue_;
-  folly::USPSCQueue<int64_t, true> consumer_queue_;
+    while (!stop_) {
+      int64_t i;
+      while (!stop_ &&
+             !producer->consumer_queue.try_dequeue_until(
+                 i,
+                 std::chrono::steady_clock::now() +
+                     std::chrono::milliseconds(100))) {
+        // loop.
+      }
+      if (stop_) {
+        return;
+      }
+      // dequeued a row. Reinitialize and enqueue it.
+      init_row(i);
+      producer->producer_queue.enqueue(i);
+    }
+  }
 
+  const int64_t max_D_;
   Tensor row_storage_;
+  std::vector<std::unique_ptr<Producer>> producers_;
+  size_t next_producer_{0};
   std::atomic<bool> stop_{false};
-  std::unique_ptr<std::thread> producer_;
+};
+
+// Host DRAM cache of the rows of one shard of EmbeddingRocksDB, between the
+// HBM/UVM row cache of the SSD TBE and RocksDB. Rows are evicted with the
+// CLOCK algorithm. The cache is written through, so evicted rows are already
+// in RocksDB. A shard is only accessed by the task of its shard, so the lock
+// is not contended within a get or a set.
+class RowCache {
+ public:
+  RowCache(int64_t capacity, int64_t row_bytes)
+      : capacity_(capacity),
+        row_bytes_(row_bytes),
+        rows_(capacity * row_bytes),
+        row_sizes_(capacity, 0),
+        keys_(capacity, -1),
+        referenced_(capacity, 0) {
+    CHECK_GT(capacity_, 0);
+    slots_.reserve(capacity_);
+  }
+
+  int64_t row_bytes() const {
+    return row_bytes_;
+  }
+
+  std::mutex& mutex() {
+    return mutex_;
+  }
+
+  // Copies the cached row of key to dst and returns its size in bytes, or
+  // returns -1 if the row is not cached
+  int64_t get(int64_t key, char* dst) {
+    const auto it = slots_.find(key);
+    if (it == slots_.end()) {
+      return -1;
+    }
+    const auto slot = it->second;
+    referenced_[slot] = 1;
+    std::memcpy(dst, &rows_[slot * row_bytes_], row_sizes_[slot]);
+    return row_sizes_[slot];
+  }
+
+  // Caches a row of at most row_bytes() bytes
+  void put(int64_t key, const char* src, int64_t size) {
+    DCHECK_LE(size, row_bytes_);
+    int64_t slot;
+    const auto it = slots_.find(key);
+    if (it != slots_.end()) {
+      slot = it->second;
+    } else {
+      slot = evict();
+      keys_[slot] = key;
+      slots_.emplace(key, slot);
+    }
+    referenced_[slot] = 1;
+    row_sizes_[slot] = size;
+    std::memcpy(&rows_[slot * row_bytes_], src, size);
+  }
+
+ private:
+  // Returns a free slot, evicting the first row not referenced since the
+  // clock hand last passed it when the cache is full
+  int64_t evict() {
+    if (size_ < capacity_) {
+      return size_++;
+    }
+    while (referenced_[hand_]) {
+      referenced_[hand_] = 0;
+      hand_ = (hand_ + 1) % capacity_;
+    }
+    const auto slot = hand_;
+    slots_.erase(keys_[slot]);
+    hand_ = (hand_ + 1) % capacity_;
+    return slot;
+  }
+
+  const int64_t capacity_;
+  const int64_t row_bytes_;
+  std::vector<char> rows_;
+  std::vector<int64_t> row_sizes_;
+  std::vector<int64_t> keys_;
+  std::vector<uint8_t> referenced_;
+  folly::F14FastMap<int64_t, int64_t> slots_;
+  int64_t size_ = 0;
+  int64_t hand_ = 0;
+  std::mutex mutex_;
 };
 
 class EmbeddingRocksDB : public std::enable_shared_from_this<EmbeddingRocksDB> {
@@ -171,7 +417,14 @@ class EmbeddingRocksDB : public std::enable_shared_from_this<EmbeddingRocksDB> {
       int64_t max_write_buffer_num,
       float uniform_init_lower,
       float uniform_init_upper,
-      int64_t row_storage_bitwidth = 32) {
+      int64_t row_storage_bitwidth = 32,
+      int64_t dram_cache_rows = 0,
+      int64_t init_threads_per_shard = 1,
+      int64_t row_compression_bit_rate = 0)
+      : row_compression_bit_rate_(row_compression_bit_rate) {
+    CHECK(
+        row_compression_bit_rate == 0 || row_compression_bit_rate == 2 ||
+        row_compression_bit_rate == 4 || row_compression_bit_rate == 8);
     // TODO: lots of tunables. NNI or something for this?
     rocksdb::Options options;
     options.create_if_missing = true;
@@ -215,7 +468,8 @@ class EmbeddingRocksDB : public std::enable_shared_from_this<EmbeddingRocksDB> {
     options.rate_limiter = rate_limiter_;
 
     // TODO: use fb303?
-    options.statistics = rocksdb::CreateDBStatistics();
+    statistics_ = rocksdb::CreateDBStatistics();
+    options.statistics = statistics_;
     options.stats_dump_period_sec = 600;
 
     rocksdb::BlockBasedTableOptions table_options;
@@ -257,6 +511,12 @@ class EmbeddingRocksDB : public std::enable_shared_from_this<EmbeddingRocksDB> {
       }
       CHECK(s.ok()) << s.ToString();
       dbs_.emplace_back(db);
+      changed_ids_.push_back(std::make_unique<ChangedIds>());
+      if (dram_cache_rows > 0) {
+        row_caches_.push_back(std::make_unique<RowCache>(
+            (dram_cache_rows + num_shards - 1) / num_shards,
+            max_D * row_storage_bitwidth / 8));
+      }
       auto* gen = at::check_generator<at::CPUGeneratorImpl>(
           at::detail::getDefaultCPUGenerator());
       {
@@ -266,10 +526,12 @@ class EmbeddingRocksDB : public std::enable_shared_from_this<EmbeddingRocksDB> {
             max_D,
             uniform_init_lower,
             uniform_init_upper,
-            row_storage_bitwidth));
+            row_storage_bitwidth,
+            init_threads_per_shard));
       }
     }
     executor_ = std::make_unique<folly::CPUThreadPoolExecutor>(num_shards);
+    callback_executor_ = std::make_unique<folly::CPUThreadPoolExecutor>(1);
     ro_.verify_checksums = false;
     wo_.disableWAL = true;
     wo_.sync = false;
@@ -284,6 +546,8 @@ class EmbeddingRocksDB : public std::enable_shared_from_this<EmbeddingRocksDB> {
           options.min_write_buffer_number_to_merge;
       int64_t period_per_shard = memtable_flush_period_ / num_shards;
       CHECK_GT(period_per_shard, 0);
+      deferral_steps_ = std::max<int64_t>(1, period_per_shard / 4);
+      shard_deferrals_.resize(num_shards, 0);
       // We want to stagger memory flushes (and then later
       // stagger all compactions)
 
@@ -309,6 +573,16 @@ class EmbeddingRocksDB : public std::enable_shared_from_this<EmbeddingRocksDB> {
                       auto indices_acc = indices.accessor<int64_t, 1>();
                       auto D = weights.size(1);
                       CHECK_EQ(indices.size(0), weights.size(0));
+                      auto* row_cache =
+                          shard_row_cache(shard, D * sizeof(scalar_t));
+                      std::unique_lock<std::mutex> row_cache_lock;
+                      if (row_cache) {
+                        row_cache_lock =
+                            std::unique_lock<std::mutex>(row_cache->mutex());
+                      }
+                      const auto compressed_bytes =
+                          compressed_row_bytes<scalar_t>(D);
+                      std::vector<uint8_t> compressed_row(compressed_bytes);
                       {
                         rocksdb::WriteBatch batch(
                             (2 * (count_ + dbs_.size() - 1) / dbs_.size()) *
@@ -317,19 +591,55 @@ class EmbeddingRocksDB : public std::enable_shared_from_this<EmbeddingRocksDB> {
                           if (db_shard(indices_acc[i], dbs_.size()) != shard) {
                             continue;
                           }
+                          const auto row_D = row_dim(indices_acc[i], D);
+                          auto value = rocksdb::Slice(
+                              reinterpret_cast<const char*>(
+                                  &(weights.data_ptr<scalar_t>()[i * D])),
+                              row_D * sizeof(scalar_t));
+                          if constexpr (std::is_same<scalar_t, float>::value) {
+                            if (compressed_bytes > 0) {
+                              const auto row_bytes =
+                                  compressed_row_bytes<scalar_t>(row_D);
+                              fbgemm::
+                                  FloatOrHalfToFusedNBitRowwiseQuantizedSBHalf(
+                                      row_compression_bit_rate_,
+                                      &(weights.data_ptr<float>()[i * D]),
+                                      1,
+                                      row_D,
+                                      compressed_row.data());
+                              value = rocksdb::Slice(
+                                  reinterpret_cast<const char*>(
+                                      compressed_row.data()),
+                                  row_bytes);
+                            }
+                          }
+                          // Put copies the value
                           batch.Put(
                               rocksdb::Slice(
                                   reinterpret_cast<const char*>(
                                       &(indices.data_ptr<int64_t>()[i])),
                                   sizeof(int64_t)),
-                              rocksdb::Slice(
-                                  reinterpret_cast<const char*>(
-                                      &(weights.data_ptr<scalar_t>()[i * D])),
-                                  D * sizeof(scalar_t)));
+                              value);
+                          if (row_cache) {
+                            row_cache->put(
+                                indices_acc[i],
+                                reinterpret_cast<const char*>(
+                                    &(weights.data_ptr<scalar_t>()[i * D])),
+                                row_D * sizeof(scalar_t));
+                          }
                         }
                         auto s = dbs_[shard]->Write(wo_, &batch);
                         CHECK(s.ok());
                       }
+                      if (track_changed_ids_) {
+                        auto& changed = *changed_ids_[shard];
+                        std::lock_guard<std::mutex> lock(changed.mutex);
+                        for (auto i = 0; i < count_; ++i) {
+                          if (db_shard(indices_acc[i], dbs_.size()) == shard) {
+                            changed.ids.insert(indices_acc[i]);
+                          }
+                        }
+                      }
                     });
               });
       futures.push_back(std::move(f));
@@ -337,6 +647,22 @@ class EmbeddingRocksDB : public std::enable_shared_from_this<EmbeddingRocksDB> {
     folly::collect(futures).wait();
   }
 
+  // Stores the rows of table t (the ids in [table_offsets[t],
+  // table_offsets[t + 1])) table_dims[t] elements wide instead of max_D, for
+  // tables of mixed dimensions. get() zero pads them to the width of its
+  // weights. To call before the first set().
+  void set_table_dims(Tensor table_offsets, Tensor table_dims) {
+    CHECK_EQ(table_offsets.numel(), table_dims.numel() + 1);
+    auto offsets = table_offsets.to(at::kLong).contiguous();
+    auto dims = table_dims.to(at::kLong).contiguous();
+    table_offsets_.assign(
+        offsets.data_ptr<int64_t>(),
+        offsets.data_ptr<int64_t>() + offsets.numel());
+    table_dims_.assign(
+        dims.data_ptr<int64_t>(), dims.data_ptr<int64_t>() + dims.numel());
+    CHECK(std::is_sorted(table_offsets_.begin(), table_offsets_.end()));
+  }
+
   void compact() {
     for (auto& db : dbs_) {
       db->CompactRange(rocksdb::CompactRangeOptions(), nullptr, nullptr);
@@ -350,6 +676,302 @@ class EmbeddingRocksDB : public std::enable_shared_from_this<EmbeddingRocksDB> {
 
   void get(Tensor indices, Tensor weights, Tensor count) {
     RECORD_USER_SCOPE("EmbeddingRocksDB::get");
+    const auto start = std::chrono::steady_clock::now();
+    get_impl(indices, weights, count, nullptr);
+    record_get_latency(
+        std::chrono::steady_clock::now() - start, count.item().toLong());
+  }
+
+  // Snapshots of the shards for incremental checkpoints: a snapshot is a
+  // consistent view of the rows as of its creation, read with
+  // get_from_snapshot() while set() goes on, and knows the ids set since the
+  // previous snapshot. The first snapshot has all the ids. Returns a handle to
+  // release with release_snapshot().
+  int64_t create_snapshot() {
+    std::lock_guard<std::mutex> lock(snapshots_mutex_);
+    Snapshot snapshot;
+    snapshot.is_base = !track_changed_ids_;
+    track_changed_ids_ = true;
+    for (auto shard = 0; shard < dbs_.size(); ++shard) {
+      auto& changed = *changed_ids_[shard];
+      std::lock_guard<std::mutex> changed_lock(changed.mutex);
+      // Rows set after the Write of a set() but before it records its ids
+      // are both in this snapshot and in the changed ids of the next one
+      snapshot.shard_snapshots.push_back(dbs_[shard]->GetSnapshot());
+      if (!snapshot.is_base) {
+        snapshot.changed_ids.insert(
+            snapshot.changed_ids.end(),
+            changed.ids.begin(),
+            changed.ids.end());
+      }
+      changed.ids.clear();
+    }
+    const auto handle = next_snapshot_handle_++;
+    snapshots_.emplace(handle, std::move(snapshot));
+    return handle;
+  }
+
+  // Returns the ids set between the previous snapshot and this one, or all
+  // the ids of the first snapshot (by scanning it)
+  Tensor get_snapshot_ids(int64_t handle) {
+    const auto& snapshot = find_snapshot(handle);
+    if (!snapshot.is_base) {
+      auto ids = at::empty(
+          {static_cast<int64_t>(snapshot.changed_ids.size())},
+          at::TensorOptions().dtype(at::kLong));
+      std::copy(
+          snapshot.changed_ids.begin(),
+          snapshot.changed_ids.end(),
+          ids.data_ptr<int64_t>());
+      return ids;
+    }
+    std::vector<int64_t> ids;
+    for (auto shard = 0; shard < dbs_.size(); ++shard) {
+      auto ro = ro_;
+      ro.snapshot = snapshot.shard_snapshots[shard];
+      ro.total_order_seek = true;
+      std::unique_ptr<rocksdb::Iterator> it(dbs_[shard]->NewIterator(ro));
+      for (it->SeekToFirst(); it->Valid(); it->Next()) {
+        CHECK_EQ(it->key().size(), sizeof(int64_t));
+        int64_t id;
+        std::memcpy(&id, it->key().data(), sizeof(int64_t));
+        ids.push_back(id);
+      }
+      CHECK(it->status().ok()) << it->status().ToString();
+    }
+    auto ids_tensor = at::empty(
+        {static_cast<int64_t>(ids.size())},
+        at::TensorOptions().dtype(at::kLong));
+    std::copy(ids.begin(), ids.end(), ids_tensor.data_ptr<int64_t>());
+    return ids_tensor;
+  }
+
+  // get() of the rows as of the snapshot, bypassing the DRAM row cache
+  void get_from_snapshot(
+      int64_t handle,
+      Tensor indices,
+      Tensor weights,
+      Tensor count) {
+    RECORD_USER_SCOPE("EmbeddingRocksDB::get_from_snapshot");
+    get_impl(indices, weights, count, &find_snapshot(handle).shard_snapshots);
+  }
+
+  void release_snapshot(int64_t handle) {
+    std::lock_guard<std::mutex> lock(snapshots_mutex_);
+    auto it = snapshots_.find(handle);
+    CHECK(it != snapshots_.end()) << "Unknown snapshot " << handle;
+    for (auto shard = 0; shard < dbs_.size(); ++shard) {
+      dbs_[shard]->ReleaseSnapshot(it->second.shard_snapshots[shard]);
+    }
+    snapshots_.erase(it);
+  }
+
+  ~EmbeddingRocksDB() {
+    for (auto& snapshot : snapshots_) {
+      for (auto shard = 0; shard < dbs_.size(); ++shard) {
+        dbs_[shard]->ReleaseSnapshot(snapshot.second.shard_snapshots[shard]);
+      }
+    }
+  }
+
+  // Returns the number of rows read by get() from each tier: hits and misses
+  // of the DRAM row cache (zero when disabled), then the unique ids of the
+  // misses found in RocksDB and not found in RocksDB (randomly initialized)
+  Tensor get_cache_stats() {
+    auto stats = at::empty({kNumStats}, at::TensorOptions().dtype(at::kLong));
+    for (auto i = 0; i < kNumStats; ++i) {
+      stats.data_ptr<int64_t>()[i] = stats_[i].load();
+    }
+    return stats;
+  }
+
+  // Waits for the set_cuda() whose callbacks the streams already ran, the
+  // set() running after the stream goes on
+  void wait_for_callbacks() {
+    folly::via(callback_executor_.get()).thenValue([](folly::Unit) {}).wait();
+  }
+
+  void get_cuda(Tensor indices, Tensor weights, Tensor count) {
+    // take reference to self to avoid lifetime issues.
+    addStreamCallback(
+        shared_from_this(),
+        callback_executor_.get(),
+        [=]() { get(indices, weights, count); },
+        /*blocking=*/true);
+  }
+
+  void
+  set_cuda(Tensor indices, Tensor weights, Tensor count, int64_t timestep) {
+    // take reference to self to avoid lifetime issues.
+    addStreamCallback(
+        shared_from_this(),
+        callback_executor_.get(),
+        [=]() {
+          set(indices, weights, count);
+          // Only do manual Flush/Compactions if enabled
+          if (memtable_flush_period_ > 0) {
+            {
+              RECORD_USER_SCOPE("FlushCompactIfNecessary");
+              if (!done_staggered_flushes_) {
+                flush_if_necessary(timestep);
+              } else {
+                compact_if_necessary(timestep);
+              }
+            }
+          }
+        },
+        /*blocking=*/false);
+  }
+
+  void flush_if_necessary(int64_t timestep) {
+    for (int64_t i = 0; i < dbs_.size(); i++) {
+      if (shard_flush_compaction_deadlines_[i] == timestep) {
+        if (defer_background_work(i, timestep, /*urgent=*/false)) {
+          continue;
+        }
+        rocksdb::FlushOptions fo;
+        fo.wait = false;
+        fo.allow_write_stall = false;
+        dbs_[i]->Flush(fo);
+        if (i == dbs_.size() - 1) {
+          done_staggered_flushes_ = true;
+          int64_t period_per_shard = compaction_period_ / dbs_.size();
+          int64_t offset = memtable_flush_offset_ + compaction_period_;
+          for (int64_t j = 0; j < dbs_.size(); j++) {
+            shard_flush_compaction_deadlines_[j] =
+                offset + (j * period_per_shard);
+          }
+        }
+      }
+    }
+  }
+
+  void compact_if_necessary(int64_t timestep) {
+    for (int64_t i = 0; i < dbs_.size(); i++) {
+      if (shard_flush_compaction_deadlines_[i] == timestep) {
+        rocksdb::ColumnFamilyMetaData meta;
+        dbs_[i]->GetColumnFamilyMetaData(&meta);
+        int32_t num_level0 = meta.levels[0].files.size();
+        if (num_level0 >= l0_files_per_compact_ &&
+            defer_background_work(
+                i, timestep, num_level0 >= 2 * l0_files_per_compact_)) {
+          continue;
+        }
+        if (num_level0 >= l0_files_per_compact_) {
+          dbs_[i]->CompactRange(
+              rocksdb::CompactRangeOptions(), nullptr, nullptr);
+        }
+        shard_flush_compaction_deadlines_[i] += compaction_period_;
+      }
+    }
+  }
+
+ private:
+  enum { kDramHits, kDramMisses, kSsdHits, kSsdMisses, kNumStats };
+
+  // The DRAM row cache of shard, or nullptr if disabled or if the rows of
+  // row_bytes bytes do not fit in it
+  RowCache* shard_row_cache(size_t shard, int64_t row_bytes) {
+    if (row_caches_.empty() || row_bytes > row_caches_[shard]->row_bytes()) {
+      return nullptr;
+    }
+    return row_caches_[shard].get();
+  }
+
+  // Elements stored of the rows of key set or read D wide: the width of its
+  // table after set_table_dims(), else D
+  int64_t row_dim(int64_t key, int64_t D) const {
+    if (table_offsets_.empty()) {
+      return D;
+    }
+    const auto it =
+        std::upper_bound(table_offsets_.begin(), table_offsets_.end(), key);
+    CHECK(it != table_offsets_.begin() && it != table_offsets_.end())
+        << "Id " << key << " is out of the tables";
+    return std::min(D, table_dims_[it - table_offsets_.begin() - 1]);
+  }
+
+  // Bytes of a compressed row of D elements, or 0 if the rows of scalar_t
+  // are stored uncompressed: only fp32 rows are quantized on write, with the
+  // fused rowwise quantizer of FBGEMM (fp16 scale and bias at the end)
+  template <typename scalar_t>
+  int64_t compressed_row_bytes(int64_t D) const {
+    if (!std::is_same<scalar_t, float>::value ||
+        row_compression_bit_rate_ == 0) {
+      return 0;
+    }
+    const auto elements_per_byte = 8 / row_compression_bit_rate_;
+    CHECK_EQ(D % elements_per_byte, 0)
+        << "Rows of " << D << " elements cannot be compressed to "
+        << row_compression_bit_rate_ << " bits";
+    return D / elements_per_byte + 2 * sizeof(at::Half);
+  }
+
+  void record_get_latency(
+      std::chrono::steady_clock::duration latency,
+      int64_t num_rows) {
+    if (num_rows == 0) {
+      return;
+    }
+    const double ns_per_row =
+        std::chrono::duration<double, std::nano>(latency).count() / num_rows;
+    std::lock_guard<std::mutex> lock(get_latency_mutex_);
+    if (long_run_get_latency_ == 0) {
+      recent_get_latency_ = long_run_get_latency_ = ns_per_row;
+    } else {
+      recent_get_latency_ += 0.25 * (ns_per_row - recent_get_latency_);
+      long_run_get_latency_ += 0.01 * (ns_per_row - long_run_get_latency_);
+    }
+  }
+
+  // Whether to move the flush or compaction deadline of shard a few steps
+  // later, to an idler window for get(). urgent work is never deferred.
+  bool defer_background_work(size_t shard, int64_t timestep, bool urgent) {
+    const auto stall_micros =
+        statistics_->getTickerCount(rocksdb::STALL_MICROS);
+    const bool writes_stall = stall_micros > last_stall_micros_;
+    last_stall_micros_ = stall_micros;
+    bool reads_busy;
+    {
+      std::lock_guard<std::mutex> lock(get_latency_mutex_);
+      reads_busy =
+          recent_get_latency_ > kBusyGetLatencyRatio * long_run_get_latency_;
+    }
+    if (urgent || writes_stall || !reads_busy ||
+        shard_deferrals_[shard] >= kMaxBackgroundWorkDeferrals) {
+      shard_deferrals_[shard] = 0;
+      return false;
+    }
+    ++shard_deferrals_[shard];
+    shard_flush_compaction_deadlines_[shard] = timestep + deferral_steps_;
+    return true;
+  }
+
+  struct Snapshot {
+    std::vector<const rocksdb::Snapshot*> shard_snapshots;
+    std::vector<int64_t> changed_ids;
+    bool is_base = false;
+  };
+
+  struct ChangedIds {
+    std::mutex mutex;
+    folly::F14FastSet<int64_t> ids;
+  };
+
+  const Snapshot& find_snapshot(int64_t handle) {
+    std::lock_guard<std::mutex> lock(snapshots_mutex_);
+    auto it = snapshots_.find(handle);
+    CHECK(it != snapshots_.end()) << "Unknown snapshot " << handle;
+    // Node map, the snapshot stays put until released
+    return it->second;
+  }
+
+  // Reads from shard_snapshots when given, else the latest rows
+  void get_impl(
+      Tensor indices,
+      Tensor weights,
+      Tensor count,
+      const std::vector<const rocksdb::Snapshot*>* shard_snapshots) {
     std::vector<folly::Future<folly::Unit>> futures;
     auto count_ = count.item().toLong();
 
@@ -367,6 +989,9 @@ class EmbeddingRocksDB : public std::enable_shared_from_this<EmbeddingRocksDB> {
                       auto weights_data_ptr = weights.data_ptr<scalar_t>();
                       FOLLY_DECLARE_REUSED(keys, std::vector<rocksdb::Slice>);
                       FOLLY_DECLARE_REUSED(shard_ids, std::vector<int32_t>);
+                      // shard_ids[key_offsets[j]:key_offsets[j + 1]] are
+                      // the rows of keys[j]
+                      FOLLY_DECLARE_REUSED(key_offsets, std::vector<int32_t>);
                       FOLLY_DECLARE_REUSED(
                           cfs, std::vector<rocksdb::ColumnFamilyHandle*>);
                       FOLLY_DECLARE_REUSED(
@@ -374,6 +999,19 @@ class EmbeddingRocksDB : public std::enable_shared_from_this<EmbeddingRocksDB> {
                       FOLLY_DECLARE_REUSED(
                           statuses, std::vector<rocksdb::Status>);
                       auto* dcf = dbs_[shard]->DefaultColumnFamily();
+                      auto ro = ro_;
+                      if (shard_snapshots) {
+                        ro.snapshot = (*shard_snapshots)[shard];
+                      }
+                      auto* row_cache = shard_snapshots
+                          ? nullptr
+                          : shard_row_cache(shard, D * sizeof(scalar_t));
+                      std::unique_lock<std::mutex> row_cache_lock;
+                      if (row_cache) {
+                        row_cache_lock =
+                            std::unique_lock<std::mutex>(row_cache->mutex());
+                      }
+                      int64_t dram_hits = 0;
                       for (auto i = 0; i < count_; ++i) {
                         // "no-op"/empty evicted tensor
                         if (indices_data_ptr[i] == -1) {
@@ -383,6 +1021,21 @@ class EmbeddingRocksDB : public std::enable_shared_from_this<EmbeddingRocksDB> {
                             shard) {
                           continue;
                         }
+                        if (row_cache) {
+                          const auto cached_bytes = row_cache->get(
+                              indices_data_ptr[i],
+                              reinterpret_cast<char*>(
+                                  &(weights_data_ptr[i * D])));
+                          if (cached_bytes >= 0) {
+                            std::fill(
+                                &(weights_data_ptr[i * D]) +
+                                    cached_bytes / sizeof(scalar_t),
+                                &(weights_data_ptr[i * D + D]),
+                                scalar_t(0));
+                            ++dram_hits;
+                            continue;
+                          }
+                        }
                         shard_ids.push_back(i);
                       }
                       std::sort(
@@ -399,164 +1052,124 @@ class EmbeddingRocksDB : public std::enable_shared_from_this<EmbeddingRocksDB> {
                                 sizeof(int64_t));
                             return lhs_key.compare(rhs_key) < 0;
                           });
-                      for (const auto& i : shard_ids) {
+                      // Duplicated ids are adjacent once sorted, each
+                      // unique id is read once and broadcast to its rows
+                      for (auto k = 0; k < shard_ids.size(); ++k) {
+                        const auto i = shard_ids[k];
+                        if (k > 0 &&
+                            indices_data_ptr[shard_ids[k - 1]] ==
+                                indices_data_ptr[i]) {
+                          continue;
+                        }
                         const auto key = rocksdb::Slice(
                             reinterpret_cast<const char*>(
                                 &(indices_data_ptr[i])),
                             sizeof(int64_t));
                         keys.push_back(key);
                         cfs.push_back(dcf);
+                        key_offsets.push_back(k);
                       }
-                      CHECK_EQ(shard_ids.size(), keys.size());
-                      CHECK_EQ(shard_ids.size(), cfs.size());
+                      key_offsets.push_back(shard_ids.size());
+                      CHECK_EQ(key_offsets.size(), keys.size() + 1);
+                      CHECK_EQ(keys.size(), cfs.size());
 
                       values.resize(keys.size());
                       statuses.resize(keys.size());
                       dbs_[shard]->MultiGet(
-                          ro_,
+                          ro,
                           keys.size(),
                           cfs.data(),
                           keys.data(),
                           values.data(),
                           statuses.data(),
                           /*sorted_input=*/true);
-                      auto row_storage_data_ptr =
-                          initializers_[shard]
-                              ->row_storage_.data_ptr<scalar_t>();
+                      int64_t ssd_hits = 0;
                       for (auto j = 0; j < keys.size(); ++j) {
                         const auto& s = statuses[j];
-                        int64_t i = shard_ids[j];
+                        int64_t i = shard_ids[key_offsets[j]];
                         const auto& value = values[j];
+                        const auto row_D = row_dim(indices_data_ptr[i], D);
                         if (s.ok()) {
-                          if (!std::is_same<scalar_t, uint8_t>::value) {
-                            CHECK_EQ(value.size(), D * sizeof(scalar_t));
+                          const auto compressed_bytes =
+                              compressed_row_bytes<scalar_t>(row_D);
+                          if (compressed_bytes > 0 &&
+                              value.size() == compressed_bytes) {
+                            if constexpr (std::is_same<scalar_t, float>::
+                                              value) {
+                              fbgemm::
+                                  FusedNBitRowwiseQuantizedSBHalfToFloatOrHalf(
+                                      row_compression_bit_rate_,
+                                      reinterpret_cast<const uint8_t*>(
+                                          value.data()),
+                                      1,
+                                      compressed_bytes,
+                                      &(weights_data_ptr[i * D]));
+                            }
+                          } else {
+                            if (!std::is_same<scalar_t, uint8_t>::value) {
+                              CHECK_EQ(value.size(), row_D * sizeof(scalar_t));
+                            }
+                            std::copy(
+                                reinterpret_cast<const scalar_t*>(
+                                    value.data()),
+                                reinterpret_cast<const scalar_t*>(
+                                    value.data() + value.size()),
+                                &(weights_data_ptr[i * D]));
                           }
-                          std::copy(
-                              reinterpret_cast<const scalar_t*>(value.data()),
-                              reinterpret_cast<const scalar_t*>(
-                                  value.data() + value.size()),
-                              &(weights_data_ptr[i * D]));
+                          const auto row_bytes = compressed_bytes > 0
+                              ? row_D * sizeof(scalar_t)
+                              : value.size();
+                          if (row_cache) {
+                            // Rows are cached uncompressed
+                            row_cache->put(
+                                indices_data_ptr[i],
+                                reinterpret_cast<const char*>(
+                                    &(weights_data_ptr[i * D])),
+                                row_bytes);
+                          }
+                          std::fill(
+                              &(weights_data_ptr[i * D]) +
+                                  row_bytes / sizeof(scalar_t),
+                              &(weights_data_ptr[i * D + D]),
+                              scalar_t(0));
+                          ++ssd_hits;
                         } else {
                           CHECK(s.IsNotFound());
-                          int64_t row_index;
-                          initializers_[shard]->producer_queue_.dequeue(
-                              row_index);
+                          initializers_[shard]->fill_row(
+                              &(weights_data_ptr[i * D]), row_D);
+                          std::fill(
+                              &(weights_data_ptr[i * D + row_D]),
+                              &(weights_data_ptr[i * D + D]),
+                              scalar_t(0));
+                        }
+                        for (auto k = key_offsets[j] + 1;
+                             k < key_offsets[j + 1];
+                             ++k) {
                           std::copy(
-                              &(row_storage_data_ptr[row_index * D]),
-                              &(row_storage_data_ptr[row_index * D + D]),
-                              &(weights_data_ptr[i * D]));
-                          initializers_[shard]->consumer_queue_.enqueue(
-                              row_index);
+                              &(weights_data_ptr[i * D]),
+                              &(weights_data_ptr[i * D + D]),
+                              &(weights_data_ptr[shard_ids[k] * D]));
                         }
                       }
+                      if (row_cache) {
+                        stats_[kDramHits] += dram_hits;
+                        stats_[kDramMisses] += shard_ids.size();
+                      }
+                      stats_[kSsdHits] += ssd_hits;
+                      stats_[kSsdMisses] += keys.size() - ssd_hits;
                     });
               });
       futures.push_back(std::move(f));
     }
     folly::collect(futures).wait();
   }
-  void get_cuda(Tensor indices, Tensor weights, Tensor count) {
-    // take reference to self to avoid lifetime issues.
-    auto self = shared_from_this();
-    std::function<void()>* functor = new std::function<void()>(
-        [=]() { self->get(indices, weights, count); });
-    auto callFunctor =
-        [](cudaStream_t stream, cudaError_t status, void* userData) -> void {
-      AT_CUDA_CHECK(status);
-      auto* f = reinterpret_cast<std::function<void()>*>(userData);
-      AT_CUDA_CHECK(cudaGetLastError());
-      (*f)();
-      // delete f; // unfortunately, this invoke destructors that call CUDA
-      // API functions (e.g. caching host allocators issue cudaGetDevice(..),
-      // etc)
-      hostAsynchronousThreadPoolExecutor(
-          [](void* userData) {
-            auto* f = reinterpret_cast<std::function<void()>*>(userData);
-            delete f;
-          },
-          userData);
-    };
-    AT_CUDA_CHECK(cudaStreamAddCallback(
-        at::cuda::getCurrentCUDAStream(), callFunctor, functor, 0));
-  }
-
-  void
-  set_cuda(Tensor indices, Tensor weights, Tensor count, int64_t timestep) {
-    // take reference to self to avoid lifetime issues.
-    auto self = shared_from_this();
-    std::function<void()>* functor = new std::function<void()>([=]() {
-      self->set(indices, weights, count);
-      // Only do manual Flush/Compactions if enabled
-      if (memtable_flush_period_ > 0) {
-        {
-          RECORD_USER_SCOPE("FlushCompactIfNecessary");
-          if (!done_staggered_flushes_) {
-            self->flush_if_necessary(timestep);
-          } else {
-            self->compact_if_necessary(timestep);
-          }
-        }
-      }
-    });
-    auto callFunctor =
-        [](cudaStream_t stream, cudaError_t status, void* userData) -> void {
-      AT_CUDA_CHECK(status);
-      auto* f = reinterpret_cast<std::function<void()>*>(userData);
-      AT_CUDA_CHECK(cudaGetLastError());
-      (*f)();
-      // delete f; // unfortunately, this invoke destructors that call CUDA
-      // API functions (e.g. caching host allocators issue cudaGetDevice(..),
-      // etc)
-      hostAsynchronousThreadPoolExecutor(
-          [](void* userData) {
-            auto* f = reinterpret_cast<std::function<void()>*>(userData);
-            delete f;
-          },
-          userData);
-    };
-    AT_CUDA_CHECK(cudaStreamAddCallback(
-        at::cuda::getCurrentCUDAStream(), callFunctor, functor, 0));
-  }
-
-  void flush_if_necessary(int64_t timestep) {
-    for (int64_t i = 0; i < dbs_.size(); i++) {
-      if (shard_flush_compaction_deadlines_[i] == timestep) {
-        rocksdb::FlushOptions fo;
-        fo.wait = false;
-        fo.allow_write_stall = false;
-        dbs_[i]->Flush(fo);
-        if (i == dbs_.size() - 1) {
-          done_staggered_flushes_ = true;
-          int64_t period_per_shard = compaction_period_ / dbs_.size();
-          int64_t offset = memtable_flush_offset_ + compaction_period_;
-          for (int64_t j = 0; j < dbs_.size(); j++) {
-            shard_flush_compaction_deadlines_[j] =
-                offset + (j * period_per_shard);
-          }
-        }
-      }
-    }
-  }
-
-  void compact_if_necessary(int64_t timestep) {
-    for (int64_t i = 0; i < dbs_.size(); i++) {
-      if (shard_flush_compaction_deadlines_[i] == timestep) {
-        rocksdb::ColumnFamilyMetaData meta;
-        dbs_[i]->GetColumnFamilyMetaData(&meta);
-        int32_t num_level0 = meta.levels[0].files.size();
-        if (num_level0 >= l0_files_per_compact_) {
-          dbs_[i]->CompactRange(
-              rocksdb::CompactRangeOptions(), nullptr, nullptr);
-        }
-        shard_flush_compaction_deadlines_[i] += compaction_period_;
-      }
-    }
-  }
-
- private:
   std::vector<std::unique_ptr<rocksdb::DB>> dbs_;
   std::vector<std::unique_ptr<Initializer>> initializers_;
+  std::vector<std::unique_ptr<RowCache>> row_caches_;
+  std::array<std::atomic<int64_t>, kNumStats> stats_{};
   std::unique_ptr<folly::CPUThreadPoolExecutor> executor_;
+  // Runs the get_cuda() and set_cuda() of this store in order
+  std::unique_ptr<folly::CPUThreadPoolExecutor> callback_executor_;
   rocksdb::ReadOptions ro_{};
   rocksdb::WriteOptions wo_{};
   std::shared_ptr<rocksdb::RateLimiter> rate_limiter_;
@@ -566,6 +1179,29 @@ class EmbeddingRocksDB : public std::enable_shared_from_this<EmbeddingRocksDB> {
   int64_t memtable_flush_period_;
   int64_t compaction_period_;
   int64_t l0_files_per_compact_;
+  // Bits per element of the fp32 rows on SSD, 0 for uncompressed rows
+  const int64_t row_compression_bit_rate_;
+  std::shared_ptr<rocksdb::Statistics> statistics_;
+  uint64_t last_stall_micros_{0};
+  // Steps by which to defer a flush or compaction, and the deferrals in a row
+  // of each shard
+  int64_t deferral_steps_{1};
+  std::vector<int64_t> shard_deferrals_;
+  // Recent and long run get() latency per row averages, in ns
+  std::mutex get_latency_mutex_;
+  double recent_get_latency_{0};
+  double long_run_get_latency_{0};
+  // Guards snapshots_ and next_snapshot_handle_
+  std::mutex snapshots_mutex_;
+  folly::F14NodeMap<int64_t, Snapshot> snapshots_;
+  int64_t next_snapshot_handle_{0};
+  // Whether set() records the ids it sets, from the first snapshot on
+  std::atomic<bool> track_changed_ids_{false};
+  std::vector<std::unique_ptr<ChangedIds>> changed_ids_;
+  // First id of each table followed by the number of ids, and the stored
+  // row width of each table; empty to store the rows max_D wide
+  std::vector<int64_t> table_offsets_;
+  std::vector<int64_t> table_dims_;
 };
 
 } // namespace ssd
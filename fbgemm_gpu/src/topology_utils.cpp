@@ -97,6 +97,11 @@ AdjacencyMatrix<Links> get_nvlink_matrix() {
     return links[i * world_size + j];
   };
 }
+
+bool has_nvswitch() {
+  // The xGMI links are reported peer to peer
+  return false;
+}
 } // namespace fbgemm_gpu
 
 #else // CUDA
@@ -182,6 +187,31 @@ AdjacencyMatrix<Links> get_nvlink_matrix() {
     return links[i * world_size + j];
   };
 }
+
+bool has_nvswitch() {
+  NVML_CHECK(nvmlInit());
+  uint32_t device_count;
+  NVML_CHECK(nvmlDeviceGetCount(&device_count));
+
+  for (const auto i : c10::irange(device_count)) {
+    nvmlDevice_t handle;
+    NVML_CHECK(nvmlDeviceGetHandleByIndex(i, &handle));
+    for (const auto link : c10::irange(NVML_NVLINK_MAX_LINKS)) {
+      nvmlEnableState_t is_active;
+      auto nvmlRet = nvmlDeviceGetNvLinkState(handle, link, &is_active);
+      if (nvmlRet != NVML_SUCCESS || is_active != NVML_FEATURE_ENABLED) {
+        continue;
+      }
+      nvmlIntNvLinkDeviceType_t remote_type;
+      nvmlRet = nvmlDeviceGetNvLinkRemoteDeviceType(handle, link, &remote_type);
+      if (nvmlRet == NVML_SUCCESS &&
+          remote_type == NVML_NVLINK_DEVICE_TYPE_SWITCH) {
+        return true;
+      }
+    }
+  }
+  return false;
+}
 } // namespace fbgemm_gpu
 
 #endif // USE_ROCM
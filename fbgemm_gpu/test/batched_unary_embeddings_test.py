@@ -194,9 +194,6 @@ class TableBatchedEmbeddingsTest(unittest.TestCase):
             rtol=TOLERANCE_REL[emb_dtype],
         )
 
-        # No implementation for CPU backprop yet
-        if not gpu_infer:
-            return
         # FIXME: the following doesn't work
         # with torch.compile-d unary_emb
         if torch_compile:
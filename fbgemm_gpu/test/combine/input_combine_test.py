@@ -7,18 +7,23 @@
 
 # pyre-strict
 import unittest
+from typing import Tuple
 
 import torch
 from fbgemm_gpu import sparse_ops  # noqa: F401
-from hypothesis import given, settings
+from hypothesis import given, settings, strategies as st
 
 from .common import open_source, TBEInputPrepareReference
 
 if open_source:
     # pyre-ignore[21]
-    from test_utils import cpu_and_maybe_gpu, optests
+    from test_utils import cpu_and_maybe_gpu, gpu_unavailable, optests
 else:
-    from fbgemm_gpu.test.test_utils import cpu_and_maybe_gpu, optests
+    from fbgemm_gpu.test.test_utils import (
+        cpu_and_maybe_gpu,
+        gpu_unavailable,
+        optests,
+    )
 
 DEFAULT_DEVICE = torch.device("cpu")
 
@@ -255,6 +260,63 @@ class InputCombineTest(unittest.TestCase):
     def test_input_combine_mix_with_length(self, device: torch.device) -> None:
         self._run_test_with_length((torch.int64, torch.int32), device=device)
 
+    # pyre-fixme[2]: Parameter must be annotated.
+    def _run_out_test(self, dtypes) -> None:
+        (
+            indices_list,
+            offsets_list,
+            per_sample_weights,
+            empty_per_sample_weights,
+            include_last_offsets,
+        ) = self._get_inputs(dtypes)
+        include_last_offsets = torch.BoolTensor(include_last_offsets)
+
+        for weights in (per_sample_weights, empty_per_sample_weights):
+            ref_outputs = torch.ops.fbgemm.tbe_input_combine(
+                indices_list, offsets_list, weights, include_last_offsets
+            )
+            sizes = torch.ops.fbgemm.tbe_input_combine_output_sizes(
+                indices_list, offsets_list, weights, include_last_offsets
+            )
+            self.assertEqual(
+                list(sizes), [ref_output.numel() for ref_output in ref_outputs]
+            )
+
+            # Large enough outputs keep their storage
+            outputs = [
+                torch.empty(sizes[0] + 8, dtype=torch.int32),
+                torch.empty(sizes[1] + 8, dtype=torch.int32),
+                torch.empty(sizes[2] + 8, dtype=torch.float),
+            ]
+            data_ptrs = [output.data_ptr() for output in outputs]
+            torch.ops.fbgemm.tbe_input_combine_out(
+                *outputs, indices_list, offsets_list, weights, include_last_offsets
+            )
+            for output, data_ptr, ref_output in zip(outputs, data_ptrs, ref_outputs):
+                torch.testing.assert_close(output, ref_output)
+                self.assertEqual(output.data_ptr(), data_ptr)
+
+            # Too small outputs are resized
+            outputs = [
+                torch.empty(0, dtype=torch.int32),
+                torch.empty(0, dtype=torch.int32),
+                torch.empty(0, dtype=torch.float),
+            ]
+            torch.ops.fbgemm.tbe_input_combine_out(
+                *outputs, indices_list, offsets_list, weights, include_last_offsets
+            )
+            for output, ref_output in zip(outputs, ref_outputs):
+                torch.testing.assert_close(output, ref_output)
+
+    def test_input_combine_out_int64(self) -> None:
+        self._run_out_test((torch.int64, torch.int64))
+
+    def test_input_combine_out_int32(self) -> None:
+        self._run_out_test((torch.int32, torch.int32))
+
+    def test_input_combine_out_mix(self) -> None:
+        self._run_out_test((torch.int64, torch.int32))
+
     def test_padding_fused_input_combine_int64(self) -> None:
         self._run_padding_fused_test((torch.int64, torch.int64), 64)
 
@@ -273,6 +335,135 @@ class InputCombineTest(unittest.TestCase):
     def test_padding_fused_input_combined_mix_with_length(self) -> None:
         self._run_padding_fused_test_with_length((torch.int64, torch.int32), 64)
 
+    @given(
+        T=st.integers(min_value=1, max_value=5),
+        B=st.integers(min_value=0, max_value=8),
+        my_size=st.integers(min_value=1, max_value=4),
+        index_dtype=st.sampled_from([torch.int32, torch.int64]),
+        weighted=st.booleans(),
+    )
+    @settings(deadline=None)
+    def test_block_bucketize_permute_tbe_input_combine(
+        self,
+        T: int,
+        B: int,
+        my_size: int,
+        index_dtype: torch.dtype,
+        weighted: bool,
+    ) -> None:
+        lengths = torch.randint(0, 5, (T * B,), dtype=index_dtype)
+        block_sizes = torch.randint(1, 10, (T,), dtype=index_dtype)
+        # Some indices fall beyond block_sizes * my_size
+        indices = torch.randint(
+            0, 12 * my_size, (int(lengths.sum().item()),), dtype=index_dtype
+        )
+        weights = torch.rand(indices.numel()) if weighted else None
+        permute = torch.randperm(T, dtype=torch.int32)
+
+        (
+            combined_indices,
+            combined_offsets,
+            combined_weights,
+            rank_index_offsets,
+        ) = torch.ops.fbgemm.block_bucketize_permute_tbe_input_combine(
+            lengths, indices, block_sizes, my_size, permute, weights
+        )
+
+        new_lengths, new_indices, new_weights, _, _ = (
+            torch.ops.fbgemm.block_bucketize_sparse_features(
+                lengths, indices, False, False, block_sizes, my_size, weights
+            )
+        )
+        new_offsets = torch.ops.fbgemm.asynchronous_complete_cumsum(new_lengths)
+        self.assertEqual(combined_offsets.size(), (my_size, T * B + 1))
+        for r in range(my_size):
+            begin = new_offsets[r * T * B]
+            end = new_offsets[(r + 1) * T * B]
+            permuted_lengths, permuted_indices, permuted_weights = (
+                torch.ops.fbgemm.permute_2D_sparse_data(
+                    permute,
+                    new_lengths[r * T * B : (r + 1) * T * B].view(T, B),
+                    new_indices[begin:end],
+                    new_weights[begin:end] if weighted else None,
+                )
+            )
+            rank_begin = rank_index_offsets[r]
+            rank_end = rank_index_offsets[r + 1]
+            torch.testing.assert_close(
+                combined_offsets[r],
+                torch.ops.fbgemm.asynchronous_complete_cumsum(
+                    permuted_lengths.flatten()
+                ).int(),
+            )
+            torch.testing.assert_close(
+                combined_indices[rank_begin:rank_end], permuted_indices.int()
+            )
+            if weighted:
+                torch.testing.assert_close(
+                    combined_weights[rank_begin:rank_end], permuted_weights
+                )
+        self.assertEqual(rank_index_offsets[-1].item(), indices.numel())
+        if not weighted:
+            self.assertEqual(combined_weights.numel(), 0)
+
+    @unittest.skipIf(*gpu_unavailable)
+    @given(
+        dtypes=st.sampled_from(
+            [
+                (torch.int64, torch.int64),
+                (torch.int32, torch.int32),
+                (torch.int64, torch.int32),
+            ]
+        ),
+        num_slots=st.integers(min_value=1, max_value=3),
+        weighted=st.booleans(),
+    )
+    @settings(deadline=None)
+    def test_tbe_input_ring_buffer(
+        self,
+        dtypes: Tuple[torch.dtype, torch.dtype],
+        num_slots: int,
+        weighted: bool,
+    ) -> None:
+        ring_buffer = torch.classes.fbgemm.TBEInputRingBuffer(
+            num_slots, torch.cuda.current_device()
+        )
+        self.assertEqual(ring_buffer.num_slots(), num_slots)
+        outputs = []
+        for i in range(num_slots + 1):
+            (
+                indices_list,
+                offsets_list,
+                per_sample_weights,
+                empty_per_sample_weights,
+                include_last_offsets,
+            ) = self._get_inputs(dtypes)
+            # Make every batch distinct and of a different size so that slot
+            # reuse and resizing are both exercised
+            indices_list[0] = torch.cat([indices_list[0] + i, indices_list[0]])
+            offsets_list[0] = torch.cat([offsets_list[0], offsets_list[0][-1:] + 3])
+            per_sample_weights[0] = torch.cat(
+                [per_sample_weights[0], per_sample_weights[0] * i]
+            )
+            weights = per_sample_weights if weighted else empty_per_sample_weights
+
+            outputs = ring_buffer.combine(
+                indices_list,
+                offsets_list,
+                weights,
+                torch.BoolTensor(include_last_offsets),
+            )
+            ref_outputs = torch.ops.fbgemm.tbe_input_combine(
+                indices_list,
+                offsets_list,
+                weights,
+                torch.BoolTensor(include_last_offsets),
+            )
+            for output, ref_output in zip(outputs, ref_outputs):
+                self.assertTrue(output.is_cuda)
+                torch.testing.assert_close(output.cpu(), ref_output)
+        ring_buffer.synchronize()
+
 
 if __name__ == "__main__":
     unittest.main()
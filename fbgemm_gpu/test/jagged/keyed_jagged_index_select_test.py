@@ -20,14 +20,13 @@ from .common import additional_decorators, open_source
 
 if open_source:
     # pyre-ignore[21]
-    from test_utils import gpu_unavailable, optests
+    from test_utils import cpu_and_maybe_gpu, optests
 else:
-    from fbgemm_gpu.test.test_utils import gpu_unavailable, optests
+    from fbgemm_gpu.test.test_utils import cpu_and_maybe_gpu, optests
 
 
 @optests.generate_opcheck_tests(additional_decorators=additional_decorators)
 class KeyedJaggedIndexSelectTest(unittest.TestCase):
-    @unittest.skipIf(*gpu_unavailable)
     @given(
         max_seq_length=st.integers(5, 10),
         input_batch_size=st.integers(1, 128),
@@ -45,6 +44,7 @@ class KeyedJaggedIndexSelectTest(unittest.TestCase):
         has_weights=st.booleans(),
         check_non_contiguous=st.booleans(),
         use_selected_lengths_sum=st.booleans(),
+        device=cpu_and_maybe_gpu(),
     )
     @settings(max_examples=20, deadline=None)
     def test_keyed_jagged_index_select_dim1(
@@ -58,6 +58,7 @@ class KeyedJaggedIndexSelectTest(unittest.TestCase):
         has_weights: bool,
         check_non_contiguous: bool,
         use_selected_lengths_sum: bool,
+        device: torch.device,
     ) -> None:
         is_float = jagged_tensor_dtype in [torch.float, torch.half, torch.bfloat16]
         lengths = torch.randint(
@@ -65,17 +66,17 @@ class KeyedJaggedIndexSelectTest(unittest.TestCase):
             high=max_seq_length,
             size=(input_batch_size * num_batches,),
             dtype=index_dtype,
-            device="cuda",
+            device=device,
         )
         offsets = torch.concat(
-            [torch.zeros(1, dtype=torch.long, device="cuda"), lengths.cumsum(0)]
+            [torch.zeros(1, dtype=torch.long, device=device), lengths.cumsum(0)]
         )
         indices = torch.randint(
             low=0,
             high=input_batch_size,
             size=(output_batch_size,),
             dtype=index_dtype,
-            device="cuda",
+            device=device,
         )
 
         # If check_non_contiguous=True, create a tensor that is twice as big
@@ -87,14 +88,14 @@ class KeyedJaggedIndexSelectTest(unittest.TestCase):
             values = torch.rand(
                 values_numel,
                 dtype=jagged_tensor_dtype,
-                device="cuda",
+                device=device,
             )
         else:
             values = torch.randint(
                 2**16,
                 (values_numel,),
                 dtype=jagged_tensor_dtype,
-                device="cuda",
+                device=device,
             )
         values_ref = values.detach().clone()
 
@@ -106,7 +107,7 @@ class KeyedJaggedIndexSelectTest(unittest.TestCase):
             weights = torch.rand(
                 int(offsets[-1].item()),
                 dtype=random.choice([torch.float, torch.half]),
-                device="cuda",
+                device=device,
             )
         else:
             weights = None
@@ -200,6 +200,50 @@ class JaggedTensorOpsTest(unittest.TestCase):
 
         torch.testing.assert_close(values.grad, values_ref.grad)
 
+    @given(
+        B=st.integers(1, 32),
+        max_L=st.integers(1, 200),
+        D=st.integers(1, 32),
+        Dv=st.integers(1, 32),
+        dtype=st.sampled_from([torch.float, torch.double]),
+    )
+    @settings(verbosity=Verbosity.verbose, max_examples=20, deadline=None)
+    def test_jagged_attention_forward(
+        self,
+        B: int,
+        max_L: int,
+        D: int,
+        Dv: int,
+        dtype: torch.dtype,
+    ) -> None:
+        lengths = torch.randint(max_L + 1, size=(B,))
+        total_length = int(lengths.sum().item())
+        offsets = torch.ops.fbgemm.asynchronous_complete_cumsum(lengths)
+        q_values = torch.randn((total_length, D), dtype=dtype)
+        k_values = torch.randn((total_length, D), dtype=dtype)
+        v_values = torch.randn((total_length, Dv), dtype=dtype)
+        scale = D**-0.5
+
+        output = torch.ops.fbgemm.jagged_attention_forward(
+            q_values, k_values, v_values, offsets, max_L, scale
+        )
+
+        q, k, v = (
+            torch.ops.fbgemm.jagged_to_padded_dense(
+                values, [offsets], max_lengths=[max_L]
+            )
+            for values in (q_values, k_values, v_values)
+        )
+        scores = torch.bmm(q, k.transpose(1, 2)) * scale
+        key_mask = torch.arange(max_L)[None, None, :] >= lengths[:, None, None]
+        attention = torch.softmax(scores.masked_fill(key_mask, float("-inf")), -1)
+        output_ref, _ = torch.ops.fbgemm.dense_to_jagged(
+            torch.bmm(attention, v), [offsets], total_length
+        )
+
+        torch.testing.assert_close(output, output_ref)
+
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -23,10 +23,10 @@ from .common import additional_decorators, open_source
 
 if open_source:
     # pyre-ignore[21]
-    from test_utils import gpu_unavailable, optests, symint_vector_unsupported
+    from test_utils import cpu_and_maybe_gpu, optests, symint_vector_unsupported
 else:
     from fbgemm_gpu.test.test_utils import (
-        gpu_unavailable,
+        cpu_and_maybe_gpu,
         optests,
         symint_vector_unsupported,
     )
@@ -58,11 +58,11 @@ class UniqueIndicesTest(unittest.TestCase):
         # Turn off static assumption for auto-dynamic
         torch._dynamo.config.assume_static_by_default = False
 
-    @unittest.skipIf(*gpu_unavailable)
     @given(
         B=st.integers(min_value=100, max_value=200),
         F=st.integers(min_value=50, max_value=100),
         max_length=st.integers(min_value=5, max_value=10),
+        device=cpu_and_maybe_gpu(),
     )
     @settings(verbosity=Verbosity.verbose, max_examples=10, deadline=None)
     def test_jagged_unique_indices(
@@ -70,6 +70,7 @@ class UniqueIndicesTest(unittest.TestCase):
         B: int,  # Batch size
         F: int,  # The number of features
         max_length: int,  # The maximum value of pooling factor
+        device: torch.device,
     ) -> None:
         hash_size_list = []
         lengths_list = []
@@ -91,7 +92,6 @@ class UniqueIndicesTest(unittest.TestCase):
                     indices_list.extend(indices)
                     linearized_indices_list.extend(linearized_indices)
 
-        device = torch.device("cuda")
         dtype = torch.int64
         hash_size = torch.as_tensor(hash_size_list, dtype=dtype, device=device)
         hash_size_offsets = torch.as_tensor(
@@ -162,11 +162,11 @@ class UniqueIndicesTest(unittest.TestCase):
                 pos = reverse_index_list[each_offset]
                 self.assertTrue((output_start <= pos) and (pos < output_end))
 
-    @unittest.skipIf(*gpu_unavailable)
     @given(
         B=st.integers(min_value=100, max_value=200),
         F=st.integers(min_value=50, max_value=100),
         max_length=st.integers(min_value=5, max_value=10),
+        device=cpu_and_maybe_gpu(),
     )
     @settings(verbosity=Verbosity.verbose, max_examples=10, deadline=None)
     def test_jagged_unique_indices_multi_keys(
@@ -174,6 +174,7 @@ class UniqueIndicesTest(unittest.TestCase):
         B: int,  # Batch size
         F: int,  # The number of features
         max_length: int,  # The maximum value of pooling factor
+        device: torch.device,
     ) -> None:
         hash_size_list = []
         lengths_list = []
@@ -195,7 +196,6 @@ class UniqueIndicesTest(unittest.TestCase):
                     indices_list.extend(indices)
                     linearized_indices_list.extend(linearized_indices)
 
-        device = torch.device("cuda")
         dtype = torch.int64
         hash_size = torch.as_tensor(hash_size_list, dtype=dtype, device=device)
         lengths = torch.as_tensor(lengths_list, dtype=dtype, device=device)
@@ -235,23 +235,23 @@ class UniqueIndicesTest(unittest.TestCase):
             pos = reverse_index_list[i]
             self.assertTrue(unique_indices_list[pos] == indices_list[i])
 
-    @unittest.skipIf(*gpu_unavailable)
     @given(
         B=st.integers(min_value=100, max_value=200),
         F=st.integers(min_value=50, max_value=100),
+        device=cpu_and_maybe_gpu(),
     )
     @settings(verbosity=Verbosity.verbose, max_examples=2, deadline=None)
     def test_jagged_unique_indices_empty(
         self,
         B: int,  # Batch size
         F: int,  # The number of features
+        device: torch.device,
     ) -> None:
         hash_size_cumsum_list = [0] + list(itertools.accumulate([10] * F))
         hash_size_offsets_list = [0] + list(itertools.accumulate([1] * F))
         offsets_list = [0] * (B * F + 1)
         indices_list = []
 
-        device = torch.device("cuda")
         dtype = torch.int64
         hash_size_cumsum = torch.as_tensor(
             hash_size_cumsum_list, device=device, dtype=dtype
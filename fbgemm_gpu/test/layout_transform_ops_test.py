@@ -19,7 +19,7 @@ try:
     from fbgemm_gpu import open_source  # noqa: F401
 
     # pyre-ignore[21]
-    from test_utils import gpu_unavailable
+    from test_utils import gpu_available, gpu_unavailable
 
 except Exception:
     if torch.version.hip:
@@ -28,7 +28,7 @@ except Exception:
         torch.ops.load_library("//deeplearning/fbgemm/fbgemm_gpu:sparse_ops")
 
     torch.ops.load_library("//deeplearning/fbgemm/fbgemm_gpu:sparse_ops_cpu")
-    from fbgemm_gpu.test.test_utils import gpu_unavailable
+    from fbgemm_gpu.test.test_utils import gpu_available, gpu_unavailable
 
 
 MAX_EXAMPLES = 20
@@ -62,12 +62,11 @@ class LayoutTransformOpsTest(unittest.TestCase):
             sharded_grad_output_impl.cpu(), sharded_grad_output.cpu()
         )
 
-    @unittest.skipIf(*gpu_unavailable)
     # pyre-fixme[56]
     @given(
         B=st.integers(min_value=1, max_value=20),
         W=st.integers(min_value=1, max_value=20),
-        cuda=st.booleans(),
+        cuda=st.booleans() if gpu_available else st.just(False),
     )
     @settings(verbosity=Verbosity.verbose, max_examples=MAX_EXAMPLES, deadline=None)
     def test_recat_embedding_grad_output_mixed_D(
@@ -76,7 +75,7 @@ class LayoutTransformOpsTest(unittest.TestCase):
         num_features_per_rank = np.random.randint(low=1, high=20, size=(W,)).tolist()
         global_T = sum(num_features_per_rank)
         mixed_D_list = np.random.randint(low=1, high=10, size=(global_T,))
-        grad_output = torch.randn(B, sum(mixed_D_list)).float().cuda()
+        grad_output = torch.randn(B, sum(mixed_D_list)).float()
         if cuda:
             grad_output = grad_output.cuda()
         num_feature_offsets_list = torch.tensor(
@@ -9,7 +9,7 @@
 
 
 import unittest
-from typing import Tuple
+from typing import List, Tuple
 
 import hypothesis.strategies as st
 import torch
@@ -124,6 +124,8 @@ class MergePooledEmbeddingsTest(unittest.TestCase):
         num_inputs=st.integers(min_value=1, max_value=10),
         num_gpus=st.integers(min_value=1, max_value=torch.cuda.device_count()),
         r=st.randoms(use_true_random=False),
+        # The large inputs are copied in chunks over two-hop paths
+        rows=st.sampled_from([10, 32768]),
     )
     # Can instantiate 8 contexts which takes a long time.
     @settings(verbosity=Verbosity.verbose, max_examples=40, deadline=None)
@@ -135,10 +137,11 @@ class MergePooledEmbeddingsTest(unittest.TestCase):
         num_gpus,
         # pyre-fixme[2]: Parameter must be annotated.
         r,
+        rows: int,
     ) -> None:
         dst_device = torch.device(f"cuda:{r.randint(0, num_gpus - 1)}")
         with torch.cuda.device(dst_device):
-            inputs = [torch.randn(10, 20) for _ in range(num_inputs)]
+            inputs = [torch.randn(rows, 20) for _ in range(num_inputs)]
             cuda_inputs = [
                 input.to(f"cuda:{i % num_gpus}") for i, input in enumerate(inputs)
             ]
@@ -159,6 +162,39 @@ class MergePooledEmbeddingsTest(unittest.TestCase):
         self.assertFalse(output_meta.is_cpu)
         self.assertTrue(output_meta.is_meta)
 
+    @given(
+        uncat_size=st.integers(min_value=0, max_value=64),
+        dims=st.lists(st.integers(min_value=0, max_value=32), min_size=1, max_size=8),
+        cat_dim=st.integers(min_value=0, max_value=1),
+        dtype=st.sampled_from([torch.float, torch.half, torch.int64]),
+    )
+    @settings(verbosity=Verbosity.verbose, max_examples=40, deadline=None)
+    def test_merge_pooled_embeddings_cpu(
+        self, uncat_size: int, dims: List[int], cat_dim: int, dtype: torch.dtype
+    ) -> None:
+        shapes = [(uncat_size, d) if cat_dim == 1 else (d, uncat_size) for d in dims]
+        pooled_embeddings = [torch.randn(shape).to(dtype) for shape in shapes]
+        output = torch.ops.fbgemm.merge_pooled_embeddings(
+            pooled_embeddings, uncat_size, torch.device("cpu"), cat_dim
+        )
+        torch.testing.assert_close(output, torch.cat(pooled_embeddings, dim=cat_dim))
+
+    @given(
+        num_inputs=st.integers(min_value=1, max_value=10),
+        dtype=st.sampled_from([torch.float, torch.half, torch.bfloat16]),
+    )
+    @settings(verbosity=Verbosity.verbose, max_examples=20, deadline=None)
+    def test_sum_reduce_to_one_cpu(self, num_inputs: int, dtype: torch.dtype) -> None:
+        inputs = [torch.randn(100, 20).to(dtype) for _ in range(num_inputs)]
+        output = torch.ops.fbgemm.sum_reduce_to_one(inputs, torch.device("cpu"))
+        self.assertEqual(output.dtype, dtype)
+        torch.testing.assert_close(
+            output.float(),
+            torch.stack([i.float() for i in inputs]).sum(dim=0),
+            atol=1e-2,
+            rtol=1e-2,
+        )
+
     # pyre-fixme[56]: Pyre was not able to infer the type of argument
     #  `hypothesis.strategies.integers($parameter$min_value = 1, $parameter$max_value =
     #  10)` to decorator factory `hypothesis.given`.
@@ -166,6 +202,8 @@ class MergePooledEmbeddingsTest(unittest.TestCase):
         num_inputs=st.integers(min_value=1, max_value=10),
         num_gpus=st.integers(min_value=1, max_value=torch.cuda.device_count()),
         r=st.randoms(use_true_random=False),
+        # The large inputs are copied in chunks over two-hop paths
+        rows=st.sampled_from([10, 32768]),
     )
     # Can instantiate 8 contexts which takes a long time.
     @settings(verbosity=Verbosity.verbose, max_examples=10, deadline=None)
@@ -177,10 +215,11 @@ class MergePooledEmbeddingsTest(unittest.TestCase):
         num_gpus,
         # pyre-fixme[2]: Parameter must be annotated.
         r,
+        rows: int,
     ) -> None:
         dst_device = torch.device(f"cuda:{r.randint(0, num_gpus - 1)}")
         with torch.cuda.device(dst_device):
-            inputs = [torch.randn(10, 20) for _ in range(num_inputs)]
+            inputs = [torch.randn(rows, 20) for _ in range(num_inputs)]
             cuda_inputs = [
                 input.to(f"cuda:{i % num_gpus}") for i, input in enumerate(inputs)
             ]
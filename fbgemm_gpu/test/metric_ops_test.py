@@ -57,6 +57,93 @@ class MetricOpsTest(unittest.TestCase):
                 atol=1e-2 if dtype == torch.half else None,
             )
 
+    # pyre-ignore [56]
+    @given(
+        n_tasks=st.integers(1, 5),
+        batch_size=st.sampled_from([1, 7, 1024, 40000]),
+        dtype=st.sampled_from([torch.half, torch.float]),
+    )
+    @settings(max_examples=20, deadline=None)
+    def test_auc_cpu(self, n_tasks: int, batch_size: int, dtype: torch.dtype) -> None:
+        # Distinct predictions make the order of the entries unambiguous
+        if dtype == torch.half:
+            batch_size = min(batch_size, 2048)
+        predictions = torch.stack(
+            [torch.randperm(batch_size) for _ in range(n_tasks)]
+        ).to(dtype)
+        labels = torch.randint(0, 1000, (n_tasks, batch_size)).to(dtype) / 1000.0
+        weights = torch.rand(n_tasks, batch_size).to(dtype)
+
+        sorted_indices = torch.ops.fbgemm.batch_auc_argsort(predictions)
+        _, sorted_indices_ref = torch.sort(predictions, descending=True, dim=-1)
+        if dtype == torch.float:
+            torch.testing.assert_close(sorted_indices, sorted_indices_ref)
+
+        output_ref = fbgemm_gpu.metrics.Auc()(
+            n_tasks, predictions.double(), labels.double(), weights.double()
+        )
+        output = fbgemm_gpu.metrics.auc(n_tasks, predictions, labels, weights)
+        self.assertEqual(output.dtype, torch.float)
+        torch.testing.assert_close(
+            output.double(),
+            output_ref,
+            rtol=1e-2 if dtype == torch.half else 1e-4,
+            atol=1e-2 if dtype == torch.half else 1e-4,
+        )
+
+    def test_batch_auc_argsort_ties_and_signs(self) -> None:
+        predictions = torch.tensor(
+            [[0.5, -1.0, 2.0, 0.5, -0.0, 0.0, -3.5]], dtype=torch.double
+        )
+        sorted_indices = torch.ops.fbgemm.batch_auc_argsort(predictions)
+        # Ties keep their input order, and 0.0 is ahead of -0.0
+        self.assertEqual(sorted_indices.tolist(), [[2, 0, 3, 5, 4, 1, 6]])
+
+    # pyre-ignore [56]
+    @given(
+        n_tasks=st.integers(1, 5),
+        batch_size=st.integers(1, 256),
+        num_batches=st.integers(1, 3),
+        use_cpu=st.booleans() if torch.cuda.is_available() else st.just(True),
+    )
+    @settings(max_examples=20, deadline=None)
+    def test_streaming_auc(
+        self, n_tasks: int, batch_size: int, num_batches: int, use_cpu: bool
+    ) -> None:
+        num_bins = 1024
+        device = torch.device("cpu" if use_cpu else "cuda")
+        # Distinct predictions at the bin centers make the histogram AUC exact
+        predictions = (
+            torch.stack(
+                [
+                    torch.randperm(num_bins)[: batch_size * num_batches]
+                    for _ in range(n_tasks)
+                ]
+            ).double()
+            + 0.5
+        ) / num_bins
+        labels = torch.randint(0, 2, predictions.shape).double()
+        weights = torch.rand(predictions.shape, dtype=torch.double)
+
+        compute_auc = fbgemm_gpu.metrics.StreamingAuc(n_tasks, num_bins).to(device)
+        merged_auc = fbgemm_gpu.metrics.StreamingAuc(n_tasks, num_bins).to(device)
+        for i in range(num_batches):
+            batch = slice(i * batch_size, (i + 1) * batch_size)
+            args = [
+                t[:, batch].float().to(device) for t in (predictions, labels, weights)
+            ]
+            # Alternate the batches between the two accumulators and merge them
+            (compute_auc if i % 2 == 0 else merged_auc).update(*args)
+        compute_auc.merge(merged_auc)
+
+        output_ref = fbgemm_gpu.metrics.Auc()(n_tasks, predictions, labels, weights)
+        torch.testing.assert_close(
+            compute_auc.compute().cpu(), output_ref, rtol=1e-5, atol=1e-5
+        )
+
+        compute_auc.reset()
+        self.assertEqual(compute_auc.histogram.abs().sum().item(), 0)
+
 
 if __name__ == "__main__":
     unittest.main()
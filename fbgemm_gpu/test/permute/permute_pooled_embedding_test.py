@@ -84,6 +84,27 @@ class PooledEmbeddingModulesTest(unittest.TestCase):
             [6, 7, 8, 9, 0, 1, 5, 2, 3, 4],
         )
 
+    def test_permutation_out(self) -> None:
+        embs_dims = [2, 3, 1, 4]
+        permute = [3, 0, 2, 1]
+        offset_dim_list = torch.tensor(
+            [0] + list(accumulate(embs_dims)), dtype=torch.int64
+        )
+        permute_list = torch.tensor(permute, dtype=torch.int64)
+        pooled_embs = torch.randn(5, 10)
+        ref = torch.cat(
+            [pooled_embs.split(embs_dims, dim=1)[p] for p in permute], dim=1
+        )
+
+        # Write into the columns [3, 13) of a larger buffer
+        buffer = torch.zeros(5, 16)
+        torch.ops.fbgemm.permute_pooled_embs_out(
+            pooled_embs, offset_dim_list, permute_list, buffer[:, 3:13]
+        )
+        torch.testing.assert_close(buffer[:, 3:13], ref)
+        self.assertEqual(buffer[:, :3].abs().sum().item(), 0)
+        self.assertEqual(buffer[:, 13:].abs().sum().item(), 0)
+
     @unittest.skipIf(*on_arm_platform)
     def test_permutation_autograd(self) -> None:
         net = Net().to(self.device)
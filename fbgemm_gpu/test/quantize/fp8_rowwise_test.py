@@ -10,6 +10,7 @@ import logging
 import os
 import sys
 import unittest
+from typing import List
 
 import hypothesis.strategies as st
 import torch
@@ -230,5 +231,78 @@ class TestFP8RowwiseQuantizationConversion(unittest.TestCase):
         torch.testing.assert_allclose(dqcat, qref, rtol=0.1, atol=0.05)
 
 
+
+class TestPaddedFP8RowwiseToJagged(unittest.TestCase):
+    @unittest.skipIf(*gpu_unavailable)
+    # pyre-fixme[56]:
+    @given(
+        lengths=st.lists(st.integers(min_value=1, max_value=300), max_size=10),
+        row_dim=st.sampled_from([4, 32, 128]),
+        forward=st.booleans(),
+        dtype=st.sampled_from([torch.float, torch.half, torch.bfloat16]),
+    )
+    @settings(verbosity=Verbosity.verbose, max_examples=40, deadline=None)
+    def test_padded_fp8_rowwise_to_jagged(
+        self,
+        lengths: List[int],
+        row_dim: int,
+        forward: bool,
+        dtype: torch.dtype,
+    ) -> None:
+        rows = [torch.rand(length, device="cuda", dtype=dtype) for length in lengths]
+        quantized = [
+            torch.ops.fbgemm.FloatToPaddedFP8RowwiseQuantized(
+                row, forward=forward, row_dim=row_dim
+            )
+            for row in rows
+        ]
+        qcat = torch.cat(
+            quantized + [torch.empty(0, device="cuda", dtype=torch.uint8)]
+        )
+        output_dtype = {
+            torch.float: SparseType.FP32,
+            torch.half: SparseType.FP16,
+            torch.bfloat16: SparseType.BF16,
+        }[dtype].as_int()
+
+        values, offsets = torch.ops.fbgemm.PaddedFP8RowwiseQuantizedToJagged(
+            qcat, forward=forward, row_dim=row_dim, output_dtype=output_dtype
+        )
+        self.assertEqual(values.dtype, dtype)
+        torch.testing.assert_close(
+            offsets.cpu(), torch.tensor([0] + lengths).cumsum(0)
+        )
+        # Same values and rounding as the dense dequantization
+        for row, q in enumerate(quantized):
+            dense = torch.ops.fbgemm.PaddedFP8RowwiseQuantizedToFloat(
+                q, forward=forward, row_dim=row_dim, output_dtype=output_dtype
+            )
+            torch.testing.assert_close(
+                values[offsets[row] : offsets[row + 1]], dense, rtol=0, atol=0
+            )
+
+        # Rows of a 2D input are flattened into rows of the jagged output
+        if lengths:
+            input_2d = torch.rand(3, lengths[0], device="cuda", dtype=dtype)
+            quantized_2d = torch.ops.fbgemm.FloatToPaddedFP8RowwiseQuantized(
+                input_2d, forward=forward, row_dim=row_dim
+            )
+            values, offsets = torch.ops.fbgemm.PaddedFP8RowwiseQuantizedToJagged(
+                quantized_2d,
+                forward=forward,
+                row_dim=row_dim,
+                output_dtype=output_dtype,
+            )
+            dense = torch.ops.fbgemm.PaddedFP8RowwiseQuantizedToFloat(
+                quantized_2d,
+                forward=forward,
+                row_dim=row_dim,
+                output_dtype=output_dtype,
+            )
+            torch.testing.assert_close(
+                offsets.cpu(), torch.arange(4) * lengths[0]
+            )
+            torch.testing.assert_close(values, dense.flatten(), rtol=0, atol=0)
+
 if __name__ == "__main__":
     unittest.main()
@@ -58,6 +58,16 @@ class TestHFP8QuantizationConversion(unittest.TestCase):
         atol: float = 0.0,
         rtol: float = 1e-7,
     ) -> None:
+        quantized_data = torch.ops.fbgemm.FloatToHFP8Quantized(
+            input_data, ebits, exponent_bias, max_pos
+        )
+        dequantized_data = torch.ops.fbgemm.HFP8QuantizedToFloat(
+            quantized_data, ebits, exponent_bias
+        )
+        torch.testing.assert_close(
+            dequantized_data, reference_data, rtol=rtol, atol=atol
+        )
+
         if torch.cuda.is_available():
             input_data_gpu = input_data.cuda()
             quantized_data_gpu = torch.ops.fbgemm.FloatToHFP8Quantized(
@@ -69,6 +79,10 @@ class TestHFP8QuantizationConversion(unittest.TestCase):
             torch.testing.assert_close(
                 dequantized_data_gpu.cpu(), reference_data, rtol=rtol, atol=atol
             )
+            # The vectorized CPU conversion is bitwise identical
+            torch.testing.assert_close(
+                quantized_data_gpu.cpu(), quantized_data, rtol=0, atol=0
+            )
 
     # pyre-ignore [56]
     @given(
@@ -0,0 +1,110 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+# pyre-strict
+
+import unittest
+
+import hypothesis.strategies as st
+import torch
+import torch.nn.functional as F
+from hypothesis import given, HealthCheck, settings
+
+from . import common  # noqa E402
+from .common import open_source
+
+if open_source:
+    # pyre-ignore[21]
+    from test_utils import gpu_available
+else:
+    from fbgemm_gpu.test.test_utils import gpu_available
+
+# Same as fbgemm::MXFormat: (element bytes per column, mantissa bits)
+MX_FORMATS = {
+    0: (1.0, 3),  # MXFP8_E4M3
+    1: (1.0, 2),  # MXFP8_E5M2
+    2: (0.5, 1),  # MXFP4_E2M1
+    3: (1.0, 6),  # MXINT8
+}
+MX_BLOCK_SIZE = 32
+
+
+class TestMXQuantizationConversion(unittest.TestCase):
+    def _block_amax(self, input_data: torch.Tensor) -> torch.Tensor:
+        nrows, ncols = input_data.shape
+        num_blocks = (ncols + MX_BLOCK_SIZE - 1) // MX_BLOCK_SIZE
+        padded = F.pad(input_data.abs(), (0, num_blocks * MX_BLOCK_SIZE - ncols))
+        amax = padded.view(nrows, num_blocks, MX_BLOCK_SIZE).amax(dim=2)
+        return amax.repeat_interleave(MX_BLOCK_SIZE, dim=1)[:, :ncols]
+
+    # pyre-ignore [56]: Invalid decoration, was not able to infer the type of argument
+    @given(
+        nrows=st.integers(min_value=0, max_value=50),
+        ncols=st.integers(min_value=0, max_value=100),
+        mx_format=st.sampled_from(list(MX_FORMATS.keys())),
+        is_half=st.booleans(),
+    )
+    @settings(deadline=10000, suppress_health_check=[HealthCheck.filter_too_much])
+    def test_quantize_op(
+        self, nrows: int, ncols: int, mx_format: int, is_half: bool
+    ) -> None:
+        element_bytes, mbits = MX_FORMATS[mx_format]
+        input_data = torch.randn(nrows, ncols) * 10
+        if is_half:
+            input_data = input_data.half()
+        quantized_data = torch.ops.fbgemm.FloatOrHalfToMXQuantized(
+            input_data, mx_format
+        )
+        num_blocks = (ncols + MX_BLOCK_SIZE - 1) // MX_BLOCK_SIZE
+        self.assertEqual(
+            quantized_data.shape,
+            (nrows, int(ncols * element_bytes + 0.5) + num_blocks),
+        )
+
+        dequantized_data = torch.ops.fbgemm.MXQuantizedToFloatOrHalf(
+            quantized_data, mx_format, ncols, 1 if is_half else 0
+        )
+        self.assertEqual(dequantized_data.dtype, input_data.dtype)
+        # The error, including the saturation of the largest elements, is
+        # bounded by the largest magnitude of the block
+        input_data = input_data.float()
+        error = (dequantized_data.float() - input_data).abs()
+        bound = self._block_amax(input_data) * 2.0 ** (-mbits)
+        self.assertTrue(torch.all(error <= bound))
+
+        if gpu_available:
+            quantized_data_gpu = torch.ops.fbgemm.FloatOrHalfToMXQuantized(
+                input_data.cuda(), mx_format
+            )
+            torch.testing.assert_close(quantized_data_gpu.cpu(), quantized_data)
+            dequantized_data_gpu = torch.ops.fbgemm.MXQuantizedToFloatOrHalf(
+                quantized_data_gpu, mx_format, ncols, 0
+            )
+            torch.testing.assert_close(
+                dequantized_data_gpu.cpu(),
+                torch.ops.fbgemm.MXQuantizedToFloatOrHalf(
+                    quantized_data, mx_format, ncols, 0
+                ),
+                equal_nan=True,
+            )
+
+    def test_nan_block(self) -> None:
+        input_data = torch.ones(2, 64)
+        input_data[0, 3] = float("nan")
+        for mx_format in MX_FORMATS:
+            quantized_data = torch.ops.fbgemm.FloatOrHalfToMXQuantized(
+                input_data, mx_format
+            )
+            dequantized_data = torch.ops.fbgemm.MXQuantizedToFloatOrHalf(
+                quantized_data, mx_format, 64, 0
+            )
+            self.assertTrue(torch.all(dequantized_data[0, :32].isnan()))
+            torch.testing.assert_close(dequantized_data[0, 32:], input_data[0, 32:])
+            torch.testing.assert_close(dequantized_data[1], input_data[1])
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,109 @@
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+# pyre-strict
+
+import random
+import unittest
+from typing import List, Tuple
+
+import hypothesis.strategies as st
+import torch
+from hypothesis import given, settings
+
+from . import common  # noqa E402
+from .common import open_source
+
+if open_source:
+    # pyre-ignore[21]
+    from test_utils import gpu_available, gpu_unavailable
+else:
+    from fbgemm_gpu.test.test_utils import gpu_available, gpu_unavailable
+
+
+def permute_lists(
+    dims: List[int], permute: List[int]
+) -> Tuple[torch.Tensor, torch.Tensor, torch.Tensor, torch.Tensor]:
+    offset_dim_list = torch.tensor([0] + dims).cumsum(0)
+    inv_offset_dim_list = torch.tensor([0] + [dims[p] for p in permute]).cumsum(0)
+    inv_permute = [0] * len(permute)
+    for i, p in enumerate(permute):
+        inv_permute[p] = i
+    return (
+        offset_dim_list,
+        torch.tensor(permute),
+        inv_offset_dim_list,
+        torch.tensor(inv_permute),
+    )
+
+
+class TestPermutedQuantization(unittest.TestCase):
+    def _inputs(
+        self, B: int, T: int, max_dim: int
+    ) -> Tuple[torch.Tensor, List[torch.Tensor]]:
+        dims = [random.randint(1, max_dim) for _ in range(T)]
+        permute = list(range(T))
+        random.shuffle(permute)
+        pooled_embs = torch.randn(B, sum(dims))
+        return pooled_embs, list(permute_lists(dims, permute))
+
+    # pyre-ignore [56]: Invalid decoration, was not able to infer the type of argument
+    @given(
+        B=st.integers(min_value=0, max_value=50),
+        T=st.integers(min_value=1, max_value=8),
+        max_dim=st.integers(min_value=1, max_value=70),
+    )
+    @settings(deadline=10000)
+    def test_bfloat16_permuted(self, B: int, T: int, max_dim: int) -> None:
+        pooled_embs, lists = self._inputs(B, T, max_dim)
+        devices = ["cpu"] + (["cuda"] if gpu_available else [])
+        for device in devices:
+            args = [pooled_embs.to(device)] + [t.to(device) for t in lists]
+            ref = torch.ops.fbgemm.FloatToBfloat16Quantized(
+                torch.ops.fbgemm.permute_pooled_embs(*args)
+            )
+            output = torch.ops.fbgemm.FloatToBfloat16QuantizedPermuted(*args[:4])
+            self.assertTrue(
+                torch.equal(output.view(torch.int16), ref.view(torch.int16))
+            )
+
+    @unittest.skipIf(*gpu_unavailable)
+    # pyre-ignore [56]: Invalid decoration, was not able to infer the type of argument
+    @given(
+        B=st.integers(min_value=0, max_value=50),
+        T=st.integers(min_value=1, max_value=8),
+        max_dim=st.integers(min_value=1, max_value=70),
+        forward=st.booleans(),
+        dtype=st.sampled_from([torch.float, torch.half, torch.bfloat16]),
+    )
+    @settings(deadline=10000)
+    def test_fp8_rowwise_permuted(
+        self, B: int, T: int, max_dim: int, forward: bool, dtype: torch.dtype
+    ) -> None:
+        pooled_embs, lists = self._inputs(B, T, max_dim)
+        args = [pooled_embs.to(dtype).cuda()] + [t.cuda() for t in lists]
+        ref = torch.ops.fbgemm.FloatToFP8RowwiseQuantized(
+            torch.ops.fbgemm.permute_pooled_embs(*args), forward
+        )
+        output = torch.ops.fbgemm.FloatToFP8RowwiseQuantizedPermuted(
+            *args[:4], forward
+        )
+        self.assertEqual(output.shape, ref.shape)
+        # The alignment padding and the unused qparam bytes of the reference
+        # are left uninitialized
+        ncols = pooled_embs.shape[1]
+        ncols_aligned = (ncols + 3) // 4 * 4
+        self.assertTrue(torch.equal(output[:, :ncols], ref[:, :ncols]))
+        self.assertTrue(
+            torch.equal(
+                output[:, ncols_aligned : ncols_aligned + 4],
+                ref[:, ncols_aligned : ncols_aligned + 4],
+            )
+        )
+
+
+if __name__ == "__main__":
+    unittest.main()
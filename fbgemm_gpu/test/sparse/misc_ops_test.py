@@ -176,6 +176,79 @@ class MiscOpsTest(unittest.TestCase):
                 segment_sum_cuda.cpu(), torch.Tensor([10.0, 11.0, 34.0]), rtol=0, atol=0
             )
 
+    @given(
+        batch_size=st.integers(min_value=1, max_value=4),
+        num_segments=st.integers(min_value=1, max_value=100),
+        max_segment_length=st.integers(min_value=0, max_value=100),
+        dtype=st.sampled_from([torch.float, torch.int64]),
+    )
+    @settings(verbosity=Verbosity.verbose, max_examples=20, deadline=None)
+    def test_segment_sum_csr_random(
+        self,
+        batch_size: int,
+        num_segments: int,
+        max_segment_length: int,
+        dtype: torch.dtype,
+    ) -> None:
+        segment_lengths = torch.randint(
+            0, max_segment_length + 1, (num_segments,), dtype=torch.int32
+        )
+        csr_seg = torch.cat(
+            [torch.zeros(1, dtype=torch.int32), segment_lengths.cumsum(0)]
+        ).int()
+        values = torch.randint(
+            -10, 11, (int(csr_seg[-1]) * batch_size,), dtype=torch.int64
+        ).to(dtype)
+        segment_sum_cpu = torch.ops.fbgemm.segment_sum_csr(
+            batch_size, csr_seg, values
+        )
+        segment_sum_ref = torch.stack(
+            [
+                values[csr_seg[i] * batch_size : csr_seg[i + 1] * batch_size].sum()
+                for i in range(num_segments)
+            ]
+        ).to(dtype)
+        torch.testing.assert_close(segment_sum_cpu, segment_sum_ref)
+
+    @given(
+        num_rows=st.integers(min_value=0, max_value=100),
+        use_abs=st.booleans(),
+        min_non_pruned_rows=st.integers(min_value=0, max_value=100),
+        compressed_indices_dtype=st.sampled_from([torch.int32, torch.int64]),
+    )
+    @settings(verbosity=Verbosity.verbose, max_examples=20, deadline=None)
+    def test_embedding_bag_rowwise_prune(
+        self,
+        num_rows: int,
+        use_abs: bool,
+        min_non_pruned_rows: int,
+        compressed_indices_dtype: torch.dtype,
+    ) -> None:
+        weights = torch.randn(num_rows, 8)
+        indicator = torch.randn(num_rows)
+        threshold = 0.5
+        pruned_weights, mapping = torch.ops.fbgemm.embedding_bag_rowwise_prune(
+            weights,
+            indicator,
+            threshold,
+            compressed_indices_dtype,
+            use_abs,
+            min_non_pruned_rows,
+            None,
+        )
+
+        mapping_ref = []
+        num_kept = 0
+        for i, val in enumerate(indicator.tolist()):
+            keep = (abs(val) if use_abs else val) > threshold
+            if num_kept + (num_rows - i) <= min_non_pruned_rows:
+                keep = True
+            mapping_ref.append(num_kept if keep else -1)
+            num_kept += keep
+        mapping_ref = torch.tensor(mapping_ref, dtype=compressed_indices_dtype)
+        torch.testing.assert_close(mapping, mapping_ref)
+        torch.testing.assert_close(pruned_weights, weights[mapping_ref >= 0])
+
     def test_segment_sum_csr_empty_input(self) -> None:
         segment_sum_cpu = torch.ops.fbgemm.segment_sum_csr(
             0,
@@ -0,0 +1,178 @@
+#!/usr/bin/env python3
+# Copyright (c) Meta Platforms, Inc. and affiliates.
+# All rights reserved.
+#
+# This source code is licensed under the BSD-style license found in the
+# LICENSE file in the root directory of this source tree.
+
+# pyre-strict
+
+# pyre-ignore-all-errors[56]
+
+import itertools
+import random
+import unittest
+from typing import Callable, List, Optional, Tuple
+
+import hypothesis.strategies as st
+import torch
+from hypothesis import given, settings, Verbosity
+
+from .common import extend_test_class, open_source
+
+if not open_source:
+    import fbgemm_gpu.sparse_ops  # noqa: F401, E402
+
+
+# Extra elements of the preallocated outputs that are large enough
+SLACK = 8
+
+
+class OutOpsTest(unittest.TestCase):
+    def _check_out(
+        self,
+        # pyre-ignore[24]: Generic type `Callable` expects 2 type parameters.
+        out_op: Callable,
+        outputs: List[torch.Tensor],
+        expected: List[Optional[torch.Tensor]],
+    ) -> None:
+        """
+        Runs out_op(*outputs) with large enough outputs, which must keep their
+        storage, and with empty ones, which must be resized, and compares them
+        with the outputs of the functional op.
+        """
+        data_ptrs = [output.data_ptr() for output in outputs]
+        out_op(*outputs)
+        for output, data_ptr, ref in zip(outputs, data_ptrs, expected):
+            if ref is None:
+                continue
+            torch.testing.assert_close(output, ref)
+            self.assertEqual(output.data_ptr(), data_ptr)
+
+        small_outputs = [output.new_empty(0) for output in outputs]
+        out_op(*small_outputs)
+        for output, ref in zip(small_outputs, expected):
+            if ref is None:
+                continue
+            torch.testing.assert_close(output, ref)
+
+    def _sparse_data(
+        self, lengths: torch.Tensor, has_weight: bool
+    ) -> Tuple[torch.Tensor, Optional[torch.Tensor]]:
+        num_indices = int(lengths.sum().item())
+        indices = torch.randint(low=1, high=int(1e5), size=(num_indices,)).type(
+            lengths.dtype
+        )
+        weights = torch.rand(num_indices).float() if has_weight else None
+        return indices, weights
+
+    @given(
+        B=st.integers(min_value=0, max_value=20),
+        T=st.integers(min_value=0, max_value=20),
+        L=st.integers(min_value=2, max_value=20),
+        long_index=st.booleans(),
+        has_weight=st.booleans(),
+        is_1D=st.booleans(),
+    )
+    @settings(verbosity=Verbosity.verbose, max_examples=20, deadline=None)
+    def test_permute_sparse_data_out(
+        self,
+        B: int,
+        T: int,
+        L: int,
+        long_index: bool,
+        has_weight: bool,
+        is_1D: bool,
+    ) -> None:
+        index_dtype = torch.int64 if long_index else torch.int32
+        if is_1D:
+            lengths = torch.randint(low=1, high=L, size=(T * B,)).type(index_dtype)
+            # with repetitions
+            permute_list = [random.randrange(T * B) for _ in range(T * B)]
+            functional_op = torch.ops.fbgemm.permute_1D_sparse_data
+            out_op = torch.ops.fbgemm.permute_1D_sparse_data_out
+            output_size_op = torch.ops.fbgemm.permute_1D_sparse_data_output_size
+        else:
+            lengths = torch.randint(low=1, high=L, size=(T, B)).type(index_dtype)
+            permute_list = list(range(T))
+            random.shuffle(permute_list)
+            functional_op = torch.ops.fbgemm.permute_2D_sparse_data
+            out_op = torch.ops.fbgemm.permute_2D_sparse_data_out
+            output_size_op = torch.ops.fbgemm.permute_2D_sparse_data_output_size
+        indices, weights = self._sparse_data(lengths, has_weight)
+        permute = torch.IntTensor(permute_list)
+
+        (
+            permuted_lengths_ref,
+            permuted_indices_ref,
+            permuted_weights_ref,
+        ) = functional_op(permute, lengths, indices, weights, None)
+        output_size = output_size_op(permute, lengths)
+        self.assertEqual(output_size, permuted_indices_ref.numel())
+
+        self._check_out(
+            lambda permuted_lengths, permuted_indices, permuted_weights: out_op(
+                permuted_lengths,
+                permuted_indices,
+                permuted_weights,
+                permute,
+                lengths,
+                indices,
+                weights,
+                None,
+            ),
+            [
+                torch.empty(permuted_lengths_ref.numel() + SLACK, dtype=index_dtype),
+                torch.empty(output_size + SLACK, dtype=index_dtype),
+                torch.empty(output_size + SLACK, dtype=torch.float),
+            ],
+            [permuted_lengths_ref, permuted_indices_ref, permuted_weights_ref],
+        )
+
+    @given(
+        T=st.integers(min_value=1, max_value=20),
+        W=st.integers(min_value=1, max_value=8),
+        long_index=st.booleans(),
+    )
+    @settings(verbosity=Verbosity.verbose, max_examples=20, deadline=None)
+    def test_expand_into_jagged_permute_out(
+        self,
+        T: int,
+        W: int,
+        long_index: bool,
+    ) -> None:
+        index_dtype = torch.int64 if long_index else torch.int32
+        lengths = [random.randint(0, 10) for _ in range(T * W)]
+        permute_list = list(range(T * W))
+        random.shuffle(permute_list)
+        permuted_lengths = [lengths[r] for r in permute_list]
+        permute = torch.tensor(permute_list, dtype=index_dtype)
+        offsets = torch.tensor(
+            [0] + list(itertools.accumulate(lengths)), dtype=index_dtype
+        )
+        permuted_offsets = torch.tensor(
+            [0] + list(itertools.accumulate(permuted_lengths)), dtype=index_dtype
+        )
+        output_size = sum(lengths)
+
+        output_permute_ref = torch.ops.fbgemm.expand_into_jagged_permute(
+            permute, offsets, permuted_offsets, output_size
+        )
+
+        def out_op(output_permute: torch.Tensor) -> None:
+            result = torch.ops.fbgemm.expand_into_jagged_permute_out(
+                output_permute, permute, offsets, permuted_offsets, output_size
+            )
+            self.assertEqual(result.data_ptr(), output_permute.data_ptr())
+
+        self._check_out(
+            out_op,
+            [torch.empty(output_size + SLACK, dtype=index_dtype)],
+            [output_permute_ref],
+        )
+
+
+extend_test_class(OutOpsTest)
+
+if __name__ == "__main__":
+    unittest.main()
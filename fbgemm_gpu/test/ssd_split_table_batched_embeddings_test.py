@@ -72,6 +72,241 @@ class SSDSplitTableBatchedEmbeddingsTest(unittest.TestCase):
         torch.cuda.synchronize()
         torch.testing.assert_close(weights, output_weights)
 
+    def test_ssd_dram_cache(self) -> None:
+        import tempfile
+
+        E = int(1e4)
+        D = 128
+        N = 1000
+        indices = torch.as_tensor(np.random.choice(E, replace=False, size=(N,)))
+        weights = torch.randn(N, D)
+        output_weights = torch.empty_like(weights)
+        count = torch.tensor([N])
+
+        emb = SSDTableBatchedEmbeddingBags(
+            embedding_specs=[(E, D)],
+            feature_table_map=[0],
+            ssd_storage_directory=tempfile.mkdtemp(),
+            cache_sets=1,
+            ssd_shards=2,
+            ssd_uniform_init_lower=-0.1,
+            ssd_uniform_init_upper=0.1,
+            ssd_dram_cache_rows=N // 4,
+        )
+        # Rows not yet set are initialized and not cached
+        emb.ssd_db.get(indices, output_weights, count)
+        assert (output_weights.abs() <= 0.1).all().item()
+        dram_hits, dram_misses, ssd_hits, ssd_misses = emb.ssd_db.get_cache_stats()
+        self.assertEqual(dram_hits.item(), 0)
+        self.assertEqual(dram_misses.item(), N)
+        self.assertEqual(ssd_hits.item(), 0)
+        self.assertEqual(ssd_misses.item(), N)
+
+        # Sets are written through, the rows evicted from DRAM are read from
+        # RocksDB
+        for _ in range(2):
+            emb.ssd_db.set(indices, weights, count)
+            emb.ssd_db.get(indices, output_weights, count)
+            torch.testing.assert_close(weights, output_weights)
+        dram_hits, dram_misses, ssd_hits, ssd_misses = emb.ssd_db.get_cache_stats()
+        self.assertGreater(dram_hits.item(), 0)
+        self.assertEqual(dram_hits.item() + dram_misses.item(), 3 * N)
+        self.assertEqual(ssd_hits.item(), dram_misses.item() - N)
+        self.assertEqual(ssd_misses.item(), N)
+
+    def test_ssd_row_compression(self) -> None:
+        import tempfile
+
+        E = int(1e4)
+        D = 128
+        N = 100
+        indices = torch.as_tensor(np.random.choice(E, replace=False, size=(N,)))
+        weights = torch.randn(N, D)
+        output_weights = torch.empty_like(weights)
+        count = torch.tensor([N])
+
+        for bit_rate in [4, 8]:
+            emb = SSDTableBatchedEmbeddingBags(
+                embedding_specs=[(E, D)],
+                feature_table_map=[0],
+                ssd_storage_directory=tempfile.mkdtemp(),
+                cache_sets=1,
+                ssd_row_compression_bit_rate=bit_rate,
+            )
+            emb.ssd_db.set(indices, weights, count)
+            emb.ssd_db.get(indices, output_weights, count)
+            # Rows are dequantized within half a quantization step
+            step = (weights.max(dim=1).values - weights.min(dim=1).values) / (
+                2**bit_rate - 1
+            )
+            self.assertTrue(
+                (
+                    (output_weights - weights).abs()
+                    <= step.unsqueeze(1) / 2 + 1e-2
+                ).all()
+            )
+
+    def test_ssd_mixed_dims(self) -> None:
+        import tempfile
+
+        E = int(1e3)
+        Ds = [16, 64, 128]
+        N = 100
+        emb = SSDTableBatchedEmbeddingBags(
+            embedding_specs=[(E, D) for D in Ds],
+            feature_table_map=list(range(len(Ds))),
+            ssd_storage_directory=tempfile.mkdtemp(),
+            cache_sets=1,
+            ssd_dram_cache_rows=N // 2,
+        )
+        max_D = max(Ds)
+        for t, D in enumerate(Ds):
+            indices = torch.as_tensor(
+                np.random.choice(E, replace=False, size=(N,)) + t * E
+            )
+            weights = torch.randn(N, max_D)
+            output_weights = torch.empty_like(weights)
+            count = torch.tensor([N])
+            # Rows not yet set are initialized D wide
+            emb.ssd_db.get(indices, output_weights, count)
+            self.assertTrue((output_weights[:, D:] == 0).all())
+            # Rows are stored D wide, in the DRAM cache and in RocksDB
+            emb.ssd_db.set(indices, weights, count)
+            for _ in range(2):
+                emb.ssd_db.get(indices, output_weights, count)
+                torch.testing.assert_close(output_weights[:, :D], weights[:, :D])
+                self.assertTrue((output_weights[:, D:] == 0).all())
+
+    def test_ssd_snapshot(self) -> None:
+        import tempfile
+
+        E = int(1e4)
+        D = 128
+        N = 100
+        indices = torch.as_tensor(np.random.choice(E, replace=False, size=(N,)))
+        weights = torch.randn(N, D)
+        output_weights = torch.empty_like(weights)
+        count = torch.tensor([N])
+
+        emb = SSDTableBatchedEmbeddingBags(
+            embedding_specs=[(E, D)],
+            feature_table_map=[0],
+            ssd_storage_directory=tempfile.mkdtemp(),
+            cache_sets=1,
+            ssd_shards=2,
+            ssd_dram_cache_rows=N,
+        )
+        emb.ssd_db.set(indices, weights, count)
+
+        # The first snapshot has all the ids
+        base = emb.ssd_db.create_snapshot()
+        self.assertEqual(
+            sorted(emb.ssd_db.get_snapshot_ids(base).tolist()),
+            sorted(indices.tolist()),
+        )
+
+        # Rows set after a snapshot are not in it, but in the next one
+        updated = indices[: N // 4].contiguous()
+        updated_weights = weights[: N // 4] + 1
+        emb.ssd_db.set(updated, updated_weights, torch.tensor([N // 4]))
+        emb.ssd_db.get_from_snapshot(base, indices, output_weights, count)
+        torch.testing.assert_close(weights, output_weights)
+
+        delta = emb.ssd_db.create_snapshot()
+        self.assertEqual(
+            sorted(emb.ssd_db.get_snapshot_ids(delta).tolist()),
+            sorted(updated.tolist()),
+        )
+        delta_weights = torch.empty_like(updated_weights)
+        emb.ssd_db.get_from_snapshot(
+            delta, updated, delta_weights, torch.tensor([N // 4])
+        )
+        torch.testing.assert_close(updated_weights, delta_weights)
+
+        emb.ssd_db.release_snapshot(base)
+        emb.ssd_db.release_snapshot(delta)
+
+    def test_ssd_duplicate_ids(self) -> None:
+        import tempfile
+
+        E = int(1e4)
+        D = 128
+        N = 100
+        unique_indices = torch.as_tensor(
+            np.random.choice(E, replace=False, size=(N,))
+        )
+        weights = torch.randn(N // 2, D)
+        # Each id read 3 times, half of them being set
+        indices = unique_indices.repeat(3)[torch.randperm(3 * N)]
+        output_weights = torch.empty(3 * N, D)
+
+        for slot_file_backend in [False, True]:
+            emb = SSDTableBatchedEmbeddingBags(
+                embedding_specs=[(E, D)],
+                feature_table_map=[0],
+                ssd_storage_directory=tempfile.mkdtemp(),
+                cache_sets=1,
+                ssd_shards=2,
+                ssd_slot_file_backend=slot_file_backend,
+            )
+            emb.ssd_db.set(
+                unique_indices[: N // 2].contiguous(),
+                weights,
+                torch.tensor([N // 2]),
+            )
+            emb.ssd_db.get(indices, output_weights, torch.tensor([3 * N]))
+            for n in range(N):
+                rows = output_weights[indices == unique_indices[n]]
+                expected_row = weights[n] if n < N // 2 else rows[0]
+                torch.testing.assert_close(rows, expected_row.expand_as(rows))
+            if not slot_file_backend:
+                # Each unique id is read once
+                _, _, ssd_hits, ssd_misses = emb.ssd_db.get_cache_stats()
+                self.assertEqual(ssd_hits.item(), N // 2)
+                self.assertEqual(ssd_misses.item(), N - N // 2)
+
+    def test_ssd_slot_file(self) -> None:
+        import tempfile
+
+        E = int(1e4)
+        # 16 rows per page, so that partial page writes are read back first
+        D = 64
+        N = 1000
+        indices = torch.as_tensor(np.random.choice(E, replace=False, size=(N,)))
+        weights = torch.randn(N, D)
+        output_weights = torch.empty_like(weights)
+        count = torch.tensor([N])
+
+        emb = SSDTableBatchedEmbeddingBags(
+            embedding_specs=[(E, D)],
+            feature_table_map=[0],
+            ssd_storage_directory=tempfile.mkdtemp(),
+            cache_sets=1,
+            ssd_shards=2,
+            ssd_uniform_init_lower=-0.1,
+            ssd_uniform_init_upper=0.1,
+            ssd_slot_file_backend=True,
+        )
+        emb.ssd_db.get_cuda(indices, output_weights, count)
+        torch.cuda.synchronize()
+        assert (output_weights.abs() <= 0.1).all().item()
+
+        emb.ssd_db.set_cuda(indices, weights, count, 1)
+        emb.ssd_db.get_cuda(indices, output_weights, count)
+        torch.cuda.synchronize()
+        torch.testing.assert_close(weights, output_weights)
+
+        # Overwrite every other row, the rows in between are kept
+        updated = torch.arange(0, N, 2)
+        weights[updated] = torch.randn(updated.numel(), D)
+        emb.ssd_db.set(
+            indices[updated].contiguous(),
+            weights[updated].contiguous(),
+            torch.tensor([updated.numel()]),
+        )
+        emb.ssd_db.get(indices, output_weights, count)
+        torch.testing.assert_close(weights, output_weights)
+
     def generate_inputs_(
         self, B: int, L: int, Es: List[int]
     ) -> Tuple[
@@ -116,6 +351,7 @@ class SSDSplitTableBatchedEmbeddingsTest(unittest.TestCase):
         lr: float = 0.01,  # from SSDTableBatchedEmbeddingBags
         eps: float = 1.0e-8,  # from SSDTableBatchedEmbeddingBags
         ssd_shards: int = 1,  # from SSDTableBatchedEmbeddingBags
+        ssd_prefetch_lookahead: int = 0,  # from SSDTableBatchedEmbeddingBags
     ) -> Tuple[SSDTableBatchedEmbeddingBags, List[torch.nn.EmbeddingBag]]:
         """
         Generate embedding modules (i,e., SSDTableBatchedEmbeddingBags and
@@ -147,6 +383,7 @@ class SSDSplitTableBatchedEmbeddingsTest(unittest.TestCase):
             learning_rate=lr,
             eps=eps,
             ssd_shards=ssd_shards,
+            ssd_prefetch_lookahead=ssd_prefetch_lookahead,
         ).cuda()
 
         # Initialize TBE SSD weights
@@ -255,6 +492,77 @@ class SSDSplitTableBatchedEmbeddingsTest(unittest.TestCase):
             weighted,
         )
 
+    @given(
+        T=st.integers(min_value=1, max_value=5),
+        D=st.integers(min_value=2, max_value=128),
+        B=st.integers(min_value=1, max_value=128),
+        log_E=st.integers(min_value=3, max_value=5),
+        L=st.integers(min_value=0, max_value=20),
+        weighted=st.booleans(),
+        lookahead=st.integers(min_value=1, max_value=3),
+    )
+    @settings(verbosity=Verbosity.verbose, max_examples=MAX_EXAMPLES, deadline=None)
+    def test_ssd_prefetch_lookahead(
+        self,
+        T: int,
+        D: int,
+        B: int,
+        log_E: int,
+        L: int,
+        weighted: bool,
+        lookahead: int,
+    ) -> None:
+        num_batches = 2 * lookahead + 2
+
+        # Generate embedding modules
+        (
+            emb,
+            emb_ref,
+        ) = self.generate_ssd_tbes(
+            T,
+            D,
+            B,
+            log_E,
+            L,
+            weighted,
+            ssd_prefetch_lookahead=lookahead,
+        )
+
+        # Generate inputs
+        Es = [emb.embedding_specs[t][0] for t in range(T)]
+        batches = [self.generate_inputs_(B, L, Es) for _ in range(num_batches)]
+
+        # Keep lookahead + 1 batches prefetched ahead of each forward call,
+        # so that the prefetches may evict the rows of every batch but the
+        # ones still waiting for their forward call
+        for i in range(lookahead):
+            emb.prefetch(batches[i][2], batches[i][3])
+        for i in range(num_batches):
+            if i + lookahead < num_batches:
+                emb.prefetch(batches[i + lookahead][2], batches[i + lookahead][3])
+            self.assertLessEqual(len(emb.timesteps_prefetched), lookahead + 1)
+            (
+                indices_list,
+                per_sample_weights_list,
+                indices,
+                offsets,
+                per_sample_weights,
+            ) = batches[i]
+            self.execute_ssd_forward_(
+                emb,
+                emb_ref,
+                indices_list,
+                per_sample_weights_list,
+                indices,
+                offsets,
+                per_sample_weights,
+                B,
+                L,
+                weighted,
+            )
+        self.assertEqual(len(emb.timesteps_prefetched), 0)
+        self.assertEqual(len(emb.ssd_prefetch_events), 0)
+
     @given(
         T=st.integers(min_value=1, max_value=5),
         D=st.integers(min_value=2, max_value=128),
@@ -488,6 +796,34 @@ class SSDIntNBitTableBatchedEmbeddingsTest(unittest.TestCase):
         torch.cuda.synchronize()
         torch.testing.assert_close(weights, output_weights)
 
+    def test_nbit_ssd_init(self) -> None:
+        import tempfile
+
+        E = int(1e4)
+        D = 128
+        N = 1000
+        indices = torch.as_tensor(np.random.choice(E, replace=False, size=(N,)))
+        emb = SSDIntNBitTableBatchedEmbeddingBags(
+            embedding_specs=[("", E, D, SparseType.INT8)],
+            feature_table_map=[0],
+            ssd_storage_directory=tempfile.mkdtemp(),
+            cache_sets=1,
+            ssd_uniform_init_lower=-0.1,
+            ssd_uniform_init_upper=0.1,
+            ssd_init_threads_per_shard=4,
+        )
+        output_weights = torch.empty(N, emb.max_D_cache, dtype=torch.uint8)
+        emb.ssd_db.get(indices, output_weights, torch.tensor([N]))
+
+        # Missing rows are initialized as INT8 rows, fp16 scale and bias first
+        qparams = output_weights[:, :4].contiguous().view(torch.half).float()
+        values = (
+            output_weights[:, 4 : 4 + D].float() * qparams[:, :1] + qparams[:, 1:]
+        )
+        assert (values.abs() <= 0.1 + 1e-3).all().item()
+        # Rows are not all the same
+        self.assertGreater(values.std(dim=0).min().item(), 0)
+
     @given(
         T=st.integers(min_value=1, max_value=10),
         D=st.integers(min_value=2, max_value=128),
@@ -30,6 +30,7 @@ from fbgemm_gpu.split_table_batched_embeddings_ops_common import (
     RecordCacheMetrics,
 )
 from fbgemm_gpu.split_table_batched_embeddings_ops_training import (
+    CacheTelemetryIndex,
     ComputeDevice,
     MultiPassPrefetchConfig,
     SplitTableBatchedEmbeddingBagsCodegen,
@@ -505,6 +506,59 @@ class CacheTest(unittest.TestCase):
             prefetch_stream=torch.cuda.Stream(),
         )
 
+    @optests.dontGenerateOpCheckTests("Serial OOM")
+    @unittest.skipIf(*gpu_unavailable)
+    @skipIfRocm
+    @given(
+        T=st.integers(min_value=1, max_value=5),
+        D=st.integers(min_value=2, max_value=64),
+        B=st.integers(min_value=1, max_value=128),
+        log_E=st.integers(min_value=3, max_value=4),
+        L=st.integers(min_value=1, max_value=20),
+        use_prefetch_stream=st.booleans(),
+    )
+    @settings(verbosity=VERBOSITY, max_examples=MAX_EXAMPLES, deadline=None)
+    def test_cache_prefetch_pipeline_no_grad(
+        self,
+        T: int,
+        D: int,
+        B: int,
+        log_E: int,
+        L: int,
+        use_prefetch_stream: bool,
+    ) -> None:
+        cc, cc_ref, min_Es, _ = generate_cache_tbes(
+            T, D, log_E, mixed=False, prefetch_pipeline=True, use_int_weight=True
+        )
+        requests = generate_requests(5, B, T, L, min_Es, reuse=0.1)
+        cur_stream: torch.cuda.Stream = torch.cuda.current_stream()
+        prefetch_stream = torch.cuda.Stream() if use_prefetch_stream else cur_stream
+
+        def _prefetch(batch: Optional[TBERequest]) -> None:
+            if batch is None:
+                return
+            indices, offsets, _ = batch.unpack_3()
+            with torch.cuda.stream(prefetch_stream):
+                cc.prefetch(
+                    indices,
+                    offsets,
+                    forward_stream=cur_stream if use_prefetch_stream else None,
+                )
+
+        # Without backward passes, the forward passes unlock the lines locked
+        # by the prefetches of their batches
+        with torch.no_grad():
+            _prefetch(requests[0])
+            for i, batch in enumerate(requests):
+                cur_stream.wait_stream(prefetch_stream)
+                _prefetch(requests[i + 1] if i + 1 < len(requests) else None)
+                indices, offsets, _ = batch.unpack_3()
+                output = cc(indices, offsets)
+                output_ref = cc_ref(indices, offsets)
+                torch.testing.assert_close(output, output_ref)
+        torch.cuda.synchronize()
+        self.assertTrue(torch.all(cc.lxu_cache_locking_counter == 0))
+
     @given(
         S=st.sampled_from([0, 7, 100, 1024]),
         mpp_n_passes=st.sampled_from([None, 1, 6, 12]),
@@ -672,5 +726,54 @@ class CacheTest(unittest.TestCase):
                     self.assertEqual(tablewise_cache_miss[i], t_tablewise_cache_miss[i])
 
 
+    @unittest.skipIf(*gpu_unavailable)
+    def test_cache_telemetry(self) -> None:
+        D = 8
+        T = 2
+        E = 10**3
+        cc = SplitTableBatchedEmbeddingBagsCodegen(
+            embedding_specs=[
+                (
+                    E,
+                    D,
+                    EmbeddingLocation.MANAGED_CACHING,
+                    ComputeDevice.CUDA,
+                )
+                for _ in range(T)
+            ],
+            cache_telemetry_sample_period=1,
+        )
+
+        # Table 0 requests [1, 1] then [2, 1], table 1 [3, 4] twice
+        xs = [
+            torch.tensor([[[1], [1]], [[3], [4]]], dtype=torch.int64),
+            torch.tensor([[[2], [1]], [[3], [4]]], dtype=torch.int64),
+        ]
+        for x in xs:
+            (indices, offsets) = get_table_batched_offsets_from_dense(
+                to_device(x, use_cpu=False), use_cpu=False
+            )
+            cc(indices, offsets)
+
+        table_stats, miss_stats, histogram = cc.get_cache_telemetry()
+        # Requested and missed indices per table
+        self.assertEqual(table_stats.cpu().tolist(), [[4, 3], [4, 2]])
+        # The cache being large enough, all the unique misses are cold
+        self.assertEqual(miss_stats[CacheTelemetryIndex.num_sampled_batches], 2)
+        self.assertEqual(miss_stats[CacheTelemetryIndex.num_cold_misses], 4)
+        self.assertEqual(miss_stats[CacheTelemetryIndex.num_capacity_misses], 0)
+        self.assertEqual(miss_stats[CacheTelemetryIndex.num_conflict_misses], 0)
+        # 3 then 4 unique indices
+        expected_histogram = [0] * histogram.numel()
+        expected_histogram[1] = 1
+        expected_histogram[2] = 1
+        self.assertEqual(histogram.cpu().tolist(), expected_histogram)
+
+        cc.reset_cache_telemetry()
+        self.assertEqual(table_stats.sum().item(), 0)
+        self.assertEqual(miss_stats.sum().item(), 0)
+        self.assertEqual(histogram.sum().item(), 0)
+
+
 if __name__ == "__main__":
     unittest.main()
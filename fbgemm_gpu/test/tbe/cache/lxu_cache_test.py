@@ -26,9 +26,9 @@ from ..common import MAX_EXAMPLES, open_source
 
 if open_source:
     # pyre-ignore[21]
-    from test_utils import gpu_unavailable, optests
+    from test_utils import gpu_available, gpu_unavailable, optests
 else:
-    from fbgemm_gpu.test.test_utils import gpu_unavailable, optests
+    from fbgemm_gpu.test.test_utils import gpu_available, gpu_unavailable, optests
 
 
 VERBOSITY: Verbosity = Verbosity.verbose
@@ -36,16 +36,16 @@ VERBOSITY: Verbosity = Verbosity.verbose
 
 @optests.generate_opcheck_tests(fast=True)
 class LXUCacheTest(unittest.TestCase):
-    @unittest.skipIf(*gpu_unavailable)
     @given(
         associativity=st.sampled_from([1, DEFAULT_ASSOC]),
+        use_cpu=st.booleans() if gpu_available else st.just(True),
     )
     @settings(deadline=None)
-    def test_lxu_cache_lookup(self, associativity: int) -> None:
+    def test_lxu_cache_lookup(self, associativity: int, use_cpu: bool) -> None:
         max_index: int = 8000
         # Use single cache set to avoid dealing with cache set hash algorithm.
-        lxu_cache_state_gpu = (
-            torch.arange(associativity, dtype=torch.int64).unsqueeze(0).cuda()
+        lxu_cache_state_gpu = to_device(
+            torch.arange(associativity, dtype=torch.int64).unsqueeze(0), use_cpu
         )
 
         # Testing all miss.
@@ -53,7 +53,8 @@ class LXUCacheTest(unittest.TestCase):
             torch.tensor([32, 33, 34, 35, 36, 100, 1000, 1725])
             if associativity <= 32
             else torch.tensor([64, 65, 66, 67, 68, 100, 1000, 1725])
-        ).cuda()
+        )
+        linear_cache_indices_0 = to_device(linear_cache_indices_0, use_cpu)
         lxu_locations = torch.ops.fbgemm.lxu_cache_lookup(
             linear_cache_indices_0, lxu_cache_state_gpu, max_index
         )
@@ -64,7 +65,7 @@ class LXUCacheTest(unittest.TestCase):
 
         # Testing all hits.
         cache_indices_1 = torch.randint(0, associativity, (associativity,))
-        linear_cache_indices_1 = cache_indices_1.cuda()
+        linear_cache_indices_1 = to_device(cache_indices_1, use_cpu)
         lxu_locations = torch.ops.fbgemm.lxu_cache_lookup(
             linear_cache_indices_1, lxu_cache_state_gpu, max_index
         )
@@ -85,7 +86,8 @@ class LXUCacheTest(unittest.TestCase):
                 miss_cache_indices_1,
                 hit_cache_indices_1,
             ]
-        ).cuda()
+        )
+        linear_cache_indices_2 = to_device(linear_cache_indices_2, use_cpu)
         lxu_locations = torch.ops.fbgemm.lxu_cache_lookup(
             linear_cache_indices_2, lxu_cache_state_gpu, max_index
         )
@@ -103,6 +105,201 @@ class LXUCacheTest(unittest.TestCase):
             expected_result,
         )
 
+    @given(
+        T=st.integers(min_value=1, max_value=5),
+        D=st.integers(min_value=1, max_value=32),
+        log_E=st.integers(min_value=1, max_value=3),
+        N=st.integers(min_value=0, max_value=500),
+        cache_sets=st.integers(min_value=1, max_value=20),
+        lfu=st.booleans(),
+    )
+    @settings(verbosity=VERBOSITY, max_examples=MAX_EXAMPLES, deadline=None)
+    def test_cache_populate_and_flush_cpu(
+        self,
+        T: int,
+        D: int,
+        log_E: int,
+        N: int,
+        cache_sets: int,
+        lfu: bool,
+    ) -> None:
+        E = int(10**log_E)
+        Ds = [D + t for t in range(T)]
+        D_offsets = torch.tensor([0] + list(accumulate(Ds)), dtype=torch.int32)
+        weights_offsets = torch.tensor(
+            [0] + list(accumulate([E * d for d in Ds[:-1]])), dtype=torch.int64
+        )
+        weights = torch.randn(E * sum(Ds))
+        cache_hash_size_cumsum = torch.tensor(
+            [0] + list(accumulate([E] * T)), dtype=torch.int64
+        )
+        total_cache_hash_size = E * T
+        cache_index_table_map = torch.arange(T, dtype=torch.int32).repeat_interleave(
+            E
+        )
+        lxu_cache_state = torch.full(
+            (cache_sets, DEFAULT_ASSOC), -1, dtype=torch.int64
+        )
+        lxu_cache_weights = torch.zeros(cache_sets * DEFAULT_ASSOC, max(Ds))
+        lxu_state = torch.zeros(
+            (total_cache_hash_size + 1,) if lfu else (cache_sets, DEFAULT_ASSOC),
+            dtype=torch.int64,
+        )
+
+        def populate(linear_cache_indices: Tensor, time_stamp: int) -> None:
+            if lfu:
+                torch.ops.fbgemm.lfu_cache_populate(
+                    weights,
+                    cache_hash_size_cumsum,
+                    total_cache_hash_size,
+                    cache_index_table_map,
+                    weights_offsets,
+                    D_offsets,
+                    linear_cache_indices,
+                    lxu_cache_state,
+                    lxu_cache_weights,
+                    lxu_state,
+                    False,
+                )
+            else:
+                torch.ops.fbgemm.lru_cache_populate(
+                    weights,
+                    cache_hash_size_cumsum,
+                    total_cache_hash_size,
+                    cache_index_table_map,
+                    weights_offsets,
+                    D_offsets,
+                    linear_cache_indices,
+                    lxu_cache_state,
+                    lxu_cache_weights,
+                    time_stamp,
+                    lxu_state,
+                    False,
+                )
+
+        def weights_row(w: Tensor, idx: int) -> Tensor:
+            t = idx // E
+            begin = int(weights_offsets[t]) + (idx % E) * Ds[t]
+            return w[begin : begin + Ds[t]]
+
+        def cache_set(idx: int) -> int:
+            # MurmurHash3 64-bit mixing function of the cache kernels
+            mask = (1 << 64) - 1
+            h = idx & mask
+            h ^= h >> 33
+            h = (h * 0xFF51AFD7ED558CCD) & mask
+            h ^= h >> 33
+            h = (h * 0xC4CEB9FE1A85EC53) & mask
+            h ^= h >> 33
+            return h % cache_sets
+
+        # The sentinel total_cache_hash_size marks the pruned indices
+        linear_cache_indices = torch.randint(0, total_cache_hash_size + 1, (N,))
+        populate(linear_cache_indices, 1)
+
+        # An empty cache is filled with the first indices of each set for LRU
+        # and the most frequent ones for LFU
+        indices, counts = linear_cache_indices.unique(return_counts=True)
+        candidates = {}
+        for idx, count in zip(indices.tolist(), counts.tolist()):
+            if idx != total_cache_hash_size:
+                candidates.setdefault(cache_set(idx), []).append((-count, idx))
+        for c in range(cache_sets):
+            expected = sorted(candidates.get(c, []), key=lambda x: x if lfu else x[1])
+            self.assertEqual(
+                {i for i in lxu_cache_state[c].tolist() if i != -1},
+                {idx for _, idx in expected[:DEFAULT_ASSOC]},
+            )
+
+        # The cached rows are found by lookup and copied from the weights
+        lxu_locations = torch.ops.fbgemm.lxu_cache_lookup(
+            linear_cache_indices, lxu_cache_state, total_cache_hash_size
+        )
+        cached = set(lxu_cache_state.flatten().tolist()) - {-1}
+        for idx, location in zip(
+            linear_cache_indices.tolist(), lxu_locations.tolist()
+        ):
+            self.assertEqual(location >= 0, idx in cached)
+            if location >= 0:
+                self.assertEqual(int(lxu_cache_state.flatten()[location]), idx)
+                torch.testing.assert_close(
+                    lxu_cache_weights[location, : Ds[idx // E]],
+                    weights_row(weights, idx),
+                )
+
+        # The updated rows are written back when evicted or flushed
+        lxu_cache_weights += 1
+        weights_ref = weights.clone()
+        for idx in cached:
+            weights_row(weights_ref, idx).add_(1)
+        populate(torch.randint(0, total_cache_hash_size + 1, (N,)), 2)
+        torch.ops.fbgemm.lxu_cache_flush(
+            weights,
+            cache_hash_size_cumsum,
+            cache_index_table_map,
+            weights_offsets,
+            D_offsets,
+            sum(Ds),
+            lxu_cache_state,
+            lxu_cache_weights,
+            False,
+        )
+        torch.testing.assert_close(weights, weights_ref)
+
+    @given(use_cpu=st.booleans() if gpu_available else st.just(True))
+    @settings(verbosity=VERBOSITY, max_examples=MAX_EXAMPLES, deadline=None)
+    def test_lru_cache_populate_admission_filter(self, use_cpu: bool) -> None:
+        E = 100
+        D = 4
+        weights = to_device(torch.randn(E * D), use_cpu)
+        lxu_cache_state = to_device(
+            torch.full((1, DEFAULT_ASSOC), -1, dtype=torch.int64), use_cpu
+        )
+        lxu_cache_weights = to_device(torch.zeros(DEFAULT_ASSOC, D), use_cpu)
+        lru_state = to_device(torch.zeros(1, DEFAULT_ASSOC, dtype=torch.int64), use_cpu)
+        uvm_cache_stats = to_device(torch.zeros(7, dtype=torch.int32), use_cpu)
+        admission_sketch = to_device(torch.zeros(4, 1024, dtype=torch.int32), use_cpu)
+
+        def populate(linear_cache_indices: Tensor, time_stamp: int) -> None:
+            torch.ops.fbgemm.lru_cache_populate(
+                weights,
+                to_device(torch.tensor([0, E], dtype=torch.int64), use_cpu),
+                E,
+                to_device(torch.zeros(E, dtype=torch.int32), use_cpu),
+                to_device(torch.tensor([0], dtype=torch.int64), use_cpu),
+                to_device(torch.tensor([0, D], dtype=torch.int32), use_cpu),
+                to_device(linear_cache_indices, use_cpu),
+                lxu_cache_state,
+                lxu_cache_weights,
+                time_stamp,
+                lru_state,
+                False,
+                True,
+                uvm_cache_stats,
+                admission_sketch=admission_sketch,
+            )
+
+        # Fill the single set with rows accessed in 3 batches
+        hot = torch.arange(DEFAULT_ASSOC, dtype=torch.int64)
+        cold = hot + DEFAULT_ASSOC
+        for time_stamp in range(1, 4):
+            populate(hot, time_stamp)
+        self.assertEqual(set(lxu_cache_state[0].tolist()), set(hot.tolist()))
+
+        # Rows accessed less often than the cached ones are not admitted
+        uvm_cache_stats.zero_()
+        populate(cold, 4)
+        self.assertEqual(set(lxu_cache_state[0].tolist()), set(hot.tolist()))
+        self.assertEqual(
+            uvm_cache_stats.tolist(),
+            [1, DEFAULT_ASSOC, DEFAULT_ASSOC, DEFAULT_ASSOC, 0, 0, DEFAULT_ASSOC],
+        )
+
+        # Until they are accessed more often
+        for time_stamp in range(5, 8):
+            populate(cold, time_stamp)
+        self.assertEqual(set(lxu_cache_state[0].tolist()), set(cold.tolist()))
+
     @unittest.skipIf(*gpu_unavailable)
     @given(
         cache_sets=st.integers(min_value=10, max_value=300),
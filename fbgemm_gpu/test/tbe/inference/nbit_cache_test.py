@@ -18,6 +18,7 @@ import torch
 from fbgemm_gpu.split_embedding_configs import SparseType
 from fbgemm_gpu.split_embedding_utils import get_table_batched_offsets_from_dense
 from fbgemm_gpu.split_table_batched_embeddings_ops_common import (
+    CacheAlgorithm,
     EmbeddingLocation,
     RecordCacheMetrics,
 )
@@ -48,6 +49,9 @@ additional_decorators: Dict[str, List[Callable]] = {
     "test_faketensor__test_nbit_direct_mapped_uvm_cache_stats": [
         unittest.skip("very slow"),
     ],
+    "test_faketensor__test_nbit_cache_warm_start": [
+        unittest.skip("very slow"),
+    ],
 }
 
 
@@ -404,6 +408,63 @@ class NBitCacheTest(unittest.TestCase):
                 accum_num_conflict_miss += e[1]
                 self.assertEqual(num_conflict_miss, accum_num_conflict_miss)
 
+    @unittest.skipIf(*gpu_unavailable)
+    @given(
+        cache_algorithm=st.sampled_from(CacheAlgorithm),
+        direct_mapped=st.booleans(),
+    )
+    @settings(verbosity=VERBOSITY, max_examples=MAX_EXAMPLES, deadline=None)
+    def test_nbit_cache_warm_start(
+        self, cache_algorithm: CacheAlgorithm, direct_mapped: bool
+    ) -> None:
+        if direct_mapped and cache_algorithm != CacheAlgorithm.LRU:
+            return
+        D = 8
+        T = 2
+        E = 10**3
+
+        def make_cc() -> IntNBitTableBatchedEmbeddingBagsCodegen:
+            return IntNBitTableBatchedEmbeddingBagsCodegen(
+                embedding_specs=[
+                    ("", E, D, SparseType.INT8, EmbeddingLocation.MANAGED_CACHING)
+                    for _ in range(T)
+                ],
+                device=torch.cuda.current_device(),
+                cache_algorithm=cache_algorithm,
+                cache_sets=4,
+                cache_assoc=1 if direct_mapped else 32,
+            )
+
+        def cached_rows(
+            cc: IntNBitTableBatchedEmbeddingBagsCodegen,
+        ) -> Dict[int, List[int]]:
+            cache_state = cc.lxu_cache_state.view(-1).tolist()
+            cache_weights = cc.lxu_cache_weights.cpu()
+            return {
+                idx: cache_weights[n].tolist()
+                for n, idx in enumerate(cache_state)
+                if idx != -1
+            }
+
+        cc = make_cc()
+        cc.fill_random_weights()
+        for _ in range(3):
+            x = torch.randint(0, E, (T, 16, 4)).cuda()
+            (indices, offsets) = get_table_batched_offsets_from_dense(x, use_cpu=False)
+            cc(indices.int(), offsets.int())
+        hot_indices = cc.get_cache_hot_indices()
+        self.assertEqual(
+            sorted(hot_indices.tolist()), sorted(cached_rows(cc).keys())
+        )
+
+        # A new module with the same weights and cache sets gets the same
+        # cached rows
+        cc_new = make_cc()
+        cc_new.assign_embedding_weights(cc.split_embedding_weights())
+        self.assertEqual(cached_rows(cc_new), {})
+        cc_new.warm_start_cache(hot_indices)
+        self.assertEqual(cached_rows(cc_new), cached_rows(cc))
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -27,6 +27,7 @@ from fbgemm_gpu.split_embedding_utils import (
     to_device,
 )
 from fbgemm_gpu.split_table_batched_embeddings_ops_common import (
+    BoundsCheckMode,
     CacheAlgorithm,
     EmbeddingLocation,
     PoolingMode,
@@ -97,6 +98,9 @@ additional_decorators: Dict[str, List[Callable]] = {
     "test_faketensor__test_nbit_forward_cpu_gpu_dequantize_parity": [
         unittest.skip("Operator not implemented for Meta tensors"),
     ],
+    "test_faketensor__test_pruned_bitmap_lookup": [
+        unittest.skip("Operator not implemented for Meta tensors"),
+    ],
 }
 
 
@@ -655,6 +659,43 @@ class NBitFowardTest(unittest.TestCase):
             output_dtype=SparseType.FP16,
         )
 
+    @unittest.skipIf(*gpu_unavailable)
+    @given(
+        pooling_mode=st.sampled_from([PoolingMode.SUM, PoolingMode.NONE]),
+        output_dtype=st.sampled_from([SparseType.FP16, SparseType.FP32]),
+    )
+    @settings(
+        verbosity=VERBOSITY,
+        max_examples=MAX_EXAMPLES_LONG_RUNNING,
+        deadline=None,
+    )
+    def test_nbit_forward_gpu_no_cache_many_mixed_tables(
+        self,
+        pooling_mode: PoolingMode,
+        output_dtype: SparseType,
+    ) -> None:
+        # More tables than a thread block scans at once, with the weight
+        # types and dims interleaved, so that the persistent kernels have to
+        # pick their tables out of several chunks
+        self.execute_nbit_forward_(
+            T=random.randint(129, 300),
+            D=random.randint(2, 256),
+            B=random.randint(1, 32),
+            log_E=2,
+            L=random.randint(0, 8),
+            weighted=False,
+            mixed=pooling_mode != PoolingMode.NONE,
+            pooling_mode=pooling_mode,
+            weights_ty=SparseType.INT8,  # don't care as mixed_weights_ty=True
+            use_cache=False,
+            cache_algorithm=CacheAlgorithm.LRU,
+            use_cpu=False,
+            use_array_for_index_remapping=True,
+            do_pruning=False,
+            mixed_weights_ty=True,
+            output_dtype=output_dtype,
+        )
+
     @unittest.skipIf(*gpu_unavailable)
     @given(
         nbit_weights_ty=get_nbit_weights_ty(),
@@ -1066,6 +1107,418 @@ class NBitFowardTest(unittest.TestCase):
             equal_nan=False,
         )
 
+    @given(
+        nbit_weights_ty=st.sampled_from(
+            [SparseType.FP16, SparseType.INT8, SparseType.INT4]
+        ),
+        pooling_mode=st.sampled_from(
+            [PoolingMode.SUM, PoolingMode.MEAN, PoolingMode.NONE]
+        ),
+        weighted=st.booleans(),
+        T=st.integers(min_value=1, max_value=40),
+        B=st.integers(min_value=1, max_value=64),
+    )
+    @settings(
+        verbosity=VERBOSITY,
+        max_examples=MAX_EXAMPLES,
+        deadline=None,
+    )
+    def test_nbit_forward_cpu_num_threads(
+        self,
+        nbit_weights_ty: SparseType,
+        pooling_mode: PoolingMode,
+        weighted: bool,
+        T: int,
+        B: int,
+    ) -> None:
+        """
+        The CPU forward splits the bags of all tables across the intra-op
+        threads; the output must not depend on the number of threads, also
+        when one table has most of the indices.
+        """
+        assume(not weighted or pooling_mode != PoolingMode.NONE)
+        D = 16
+        Es = [np.random.randint(low=10, high=200) for _ in range(T)]
+        cc = IntNBitTableBatchedEmbeddingBagsCodegen(
+            embedding_specs=[
+                ("", E, D, nbit_weights_ty, EmbeddingLocation.HOST) for E in Es
+            ],
+            pooling_mode=pooling_mode,
+            device="cpu",
+            output_dtype=SparseType.FP32,
+        )
+        cc.fill_random_weights()
+        # Skewed pooling factors: table 0 has long bags
+        lengths = torch.cat(
+            [
+                torch.randint(0, 200 if t == 0 else 4, (B,), dtype=torch.int32)
+                for t in range(T)
+            ]
+        )
+        indices = torch.cat(
+            [
+                torch.randint(0, E, (int(lengths[t * B : (t + 1) * B].sum()),))
+                for t, E in enumerate(Es)
+            ]
+        ).int()
+        offsets = torch.ops.fbgemm.asynchronous_complete_cumsum(lengths).int()
+        per_sample_weights = torch.randn(indices.numel()) if weighted else None
+
+        num_threads = torch.get_num_threads()
+        try:
+            torch.set_num_threads(1)
+            output_ref = cc(indices, offsets, per_sample_weights)
+            torch.set_num_threads(max(num_threads, 4))
+            output = cc(indices, offsets, per_sample_weights)
+        finally:
+            torch.set_num_threads(num_threads)
+        torch.testing.assert_close(output, output_ref, rtol=0, atol=0)
+
+    @given(
+        nbit_weights_ty=st.sampled_from(
+            [SparseType.FP16, SparseType.INT8, SparseType.INT4]
+        ),
+        pooling_mode=st.sampled_from(
+            [PoolingMode.SUM, PoolingMode.MEAN, PoolingMode.NONE]
+        ),
+        weighted=st.booleans(),
+        use_hash=st.booleans(),
+        T=st.integers(min_value=1, max_value=10),
+        B=st.integers(min_value=1, max_value=32),
+        L=st.integers(min_value=0, max_value=20),
+    )
+    @settings(
+        verbosity=VERBOSITY,
+        max_examples=MAX_EXAMPLES,
+        deadline=None,
+    )
+    def test_nbit_forward_cpu_fused_remapping(
+        self,
+        nbit_weights_ty: SparseType,
+        pooling_mode: PoolingMode,
+        weighted: bool,
+        use_hash: bool,
+        T: int,
+        B: int,
+        L: int,
+    ) -> None:
+        """
+        The lookup with the index remapping fused in must match the lookup
+        of the indices remapped by pruned_array_lookup; table 0 is not pruned.
+        """
+        assume(not weighted or pooling_mode != PoolingMode.NONE)
+        D = 8
+        E = 100
+        original_E = 2 * E
+        cc = IntNBitTableBatchedEmbeddingBagsCodegen(
+            embedding_specs=[
+                ("", E, D, nbit_weights_ty, EmbeddingLocation.HOST)
+                for _ in range(T)
+            ],
+            pooling_mode=pooling_mode,
+            device="cpu",
+            output_dtype=SparseType.FP32,
+            bounds_check_mode=BoundsCheckMode.NONE,
+        )
+        cc.fill_random_weights()
+        # Half of the original rows are pruned
+        index_remappings = [None] + [
+            torch.cat([torch.randperm(E), torch.full((E,), -1)])[
+                torch.randperm(original_E)
+            ].int()
+            for _ in range(T - 1)
+        ]
+        original_rows = [E] + [original_E] * (T - 1)
+        indices = torch.cat(
+            [torch.randint(0, rows, (B * L,)) for rows in original_rows]
+        ).int()
+        offsets = torch.tensor([L * b_t for b_t in range(B * T + 1)]).int()
+        per_sample_weights = torch.randn(indices.numel()) if weighted else None
+
+        index_remappings_array = torch.cat(
+            [torch.empty(0, dtype=torch.int32)] + index_remappings[1:]
+        )
+        index_remappings_array_offsets = torch.tensor(
+            [0, 0] + [original_E * t for t in range(1, T)]
+        ).long()
+        remapped_indices = torch.ops.fbgemm.pruned_array_lookup(
+            indices, offsets, index_remappings_array, index_remappings_array_offsets
+        )
+        output_ref = cc(remapped_indices, offsets, per_sample_weights)
+
+        if use_hash:
+            hash_table_offsets = torch.tensor(
+                [0, 0] + [original_E * t for t in range(1, T)]
+            ).long()
+            groups, group_offsets = torch.ops.fbgemm.pruned_hashmap_grouped_build(
+                torch.cat([torch.arange(rows) for rows in original_rows]).int(),
+                torch.cat([torch.arange(E).int()] + index_remappings[1:]),
+                torch.tensor(
+                    [0] + np.cumsum(original_rows).tolist()
+                ).int(),
+                hash_table_offsets,
+            )
+            remapping = {
+                "index_remapping_groups": groups,
+                "index_remapping_group_offsets": group_offsets,
+            }
+        else:
+            remapping = {
+                "index_remappings": index_remappings_array,
+                "index_remappings_offsets": index_remappings_array_offsets,
+            }
+        output = torch.ops.fbgemm.int_nbit_split_embedding_codegen_lookup_function_remapped(
+            dev_weights=cc.weights_host,
+            uvm_weights=cc.weights_uvm,
+            weights_placements=cc.weights_placements,
+            weights_offsets=cc.weights_offsets,
+            weights_tys=cc.weights_tys,
+            D_offsets=cc.D_offsets,
+            total_D=cc.total_D,
+            max_int2_D=cc.max_int2_D,
+            max_int4_D=cc.max_int4_D,
+            max_int8_D=cc.max_int8_D,
+            max_float16_D=cc.max_float16_D,
+            max_float32_D=cc.max_float32_D,
+            indices=indices,
+            offsets=offsets,
+            pooling_mode=int(pooling_mode),
+            indice_weights=per_sample_weights,
+            output_dtype=cc.output_dtype,
+            row_alignment=cc.row_alignment,
+            **remapping,
+        )
+        torch.testing.assert_close(output, output_ref, rtol=0, atol=0)
+
+        if not use_hash:
+            # The module fuses array remapping when the bound check allows
+            cc.set_index_remappings_array(index_remappings)
+            torch.testing.assert_close(
+                cc(indices, offsets, per_sample_weights),
+                output_ref,
+                rtol=0,
+                atol=0,
+            )
+
+    @given(
+        T=st.integers(min_value=1, max_value=5),
+        B=st.integers(min_value=1, max_value=32),
+        L=st.integers(min_value=0, max_value=20),
+        E=st.integers(min_value=1, max_value=2000),
+        use_gpu=st.booleans() if not gpu_unavailable[0] else st.just(False),
+    )
+    @settings(
+        verbosity=VERBOSITY,
+        max_examples=MAX_EXAMPLES,
+        deadline=None,
+    )
+    def test_pruned_bitmap_lookup(
+        self,
+        T: int,
+        B: int,
+        L: int,
+        E: int,
+        use_gpu: bool,
+    ) -> None:
+        """
+        The bitmap remapping built from a rank ordered array remapping must
+        look up the same dense indices; the last table is not pruned.
+        """
+        # Kept rows map in increasing order to 0, 1, ...
+        index_remappings = []
+        for _ in range(T - 1):
+            kept = torch.rand(E) < 0.3
+            index_remappings.append(
+                torch.where(kept, torch.cumsum(kept.int(), 0) - 1, -1).int()
+            )
+        index_remappings_array = torch.cat(
+            index_remappings + [torch.empty(0, dtype=torch.int32)]
+        )
+        index_remappings_array_offsets = torch.tensor(
+            [E * t for t in range(T)] + [E * (T - 1)]
+        ).long()
+        indices = torch.randint(0, E, (T * B * L,)).int()
+        offsets = torch.tensor([L * b_t for b_t in range(B * T + 1)]).int()
+
+        bitmap, ranks, bitmap_offsets = torch.ops.fbgemm.pruned_bitmap_build(
+            index_remappings_array, index_remappings_array_offsets
+        )
+        # One bit per original row, padded to whole blocks of 512 rows
+        self.assertEqual(bitmap.numel(), (T - 1) * ((E + 511) // 512) * 16)
+        self.assertEqual(ranks.numel(), bitmap.numel() // 16)
+
+        device = torch.cuda.current_device() if use_gpu else "cpu"
+        dense_indices_ref = torch.ops.fbgemm.pruned_array_lookup(
+            indices.to(device),
+            offsets.to(device),
+            index_remappings_array.to(device),
+            index_remappings_array_offsets.to(device),
+        )
+        dense_indices = torch.ops.fbgemm.pruned_bitmap_lookup(
+            indices.to(device),
+            offsets.to(device),
+            bitmap.to(device),
+            ranks.to(device),
+            bitmap_offsets.to(device),
+        )
+        torch.testing.assert_close(dense_indices, dense_indices_ref)
+
+        if T > 1 and (index_remappings[0] >= 0).sum() > 1:
+            # Dense indices out of order are rejected
+            kept = (index_remappings[0] >= 0).nonzero().flatten()
+            shuffled = index_remappings_array.clone()
+            shuffled[kept] = shuffled[kept].flip(0)
+            with self.assertRaises(RuntimeError):
+                torch.ops.fbgemm.pruned_bitmap_build(
+                    shuffled, index_remappings_array_offsets
+                )
+
+    @given(
+        nbit_weights_ty=st.sampled_from(
+            [SparseType.FP16, SparseType.INT8, SparseType.INT4]
+        ),
+        T=st.integers(min_value=1, max_value=10),
+        B=st.integers(min_value=1, max_value=32),
+        L=st.integers(min_value=0, max_value=20),
+    )
+    @settings(
+        verbosity=VERBOSITY,
+        max_examples=MAX_EXAMPLES,
+        deadline=None,
+    )
+    def test_nbit_forward_cpu_seq_out(
+        self,
+        nbit_weights_ty: SparseType,
+        T: int,
+        B: int,
+        L: int,
+    ) -> None:
+        """
+        The no bag lookup into the caller's output with the row offsets of
+        the permuted features must match permute_sequence_embeddings of the
+        no bag lookup output.
+        """
+        D = 8
+        E = 100
+        cc = IntNBitTableBatchedEmbeddingBagsCodegen(
+            embedding_specs=[
+                ("", E, D, nbit_weights_ty, EmbeddingLocation.HOST)
+                for _ in range(T)
+            ],
+            pooling_mode=PoolingMode.NONE,
+            device="cpu",
+            output_dtype=SparseType.FP32,
+        )
+        cc.fill_random_weights()
+        lengths = torch.randint(0, L + 1, (T, B))
+        offsets = torch.ops.fbgemm.asynchronous_complete_cumsum(
+            lengths.view(-1)
+        ).int()
+        indices = torch.randint(0, E, (int(lengths.sum().item()),)).int()
+        output_ref = cc(indices, offsets)
+
+        permute = torch.randperm(T)
+        _, permuted_output_ref = torch.ops.fbgemm.permute_sequence_embeddings(
+            permute.int(), lengths.int(), output_ref
+        )
+        permuted_rows = lengths.sum(dim=1)[permute]
+        output_row_offsets = torch.empty(T, dtype=torch.int64)
+        output_row_offsets[permute] = (
+            torch.cumsum(permuted_rows, dim=0) - permuted_rows
+        )
+        output = torch.full_like(output_ref, float("nan"))
+        torch.ops.fbgemm.int_nbit_split_embedding_nobag_codegen_lookup_function_out(
+            dev_weights=cc.weights_host,
+            uvm_weights=cc.weights_uvm,
+            weights_placements=cc.weights_placements,
+            weights_offsets=cc.weights_offsets,
+            weights_tys=cc.weights_tys,
+            D=D,
+            indices=indices,
+            offsets=offsets,
+            output=output,
+            output_row_offsets=output_row_offsets,
+            output_dtype=cc.output_dtype,
+            row_alignment=cc.row_alignment,
+        )
+        torch.testing.assert_close(output, permuted_output_ref, rtol=0, atol=0)
+
+    @given(
+        nbit_weights_ty=st.sampled_from(
+            [SparseType.FP16, SparseType.INT8, SparseType.INT4]
+        ),
+        output_dtype=st.sampled_from(
+            [SparseType.FP32, SparseType.FP16, SparseType.BF16]
+        ),
+        weighted=st.booleans(),
+        T=st.integers(min_value=1, max_value=10),
+        B=st.integers(min_value=1, max_value=32),
+        L=st.integers(min_value=0, max_value=20),
+    )
+    @settings(
+        verbosity=VERBOSITY,
+        max_examples=MAX_EXAMPLES,
+        deadline=None,
+    )
+    def test_nbit_forward_cpu_padded_output(
+        self,
+        nbit_weights_ty: SparseType,
+        output_dtype: SparseType,
+        weighted: bool,
+        T: int,
+        B: int,
+        L: int,
+    ) -> None:
+        """
+        The table slices of the output padded to cache lines must match the
+        compact output for tables of mixed D.
+        """
+        E = 100
+        Ds = [8 * np.random.randint(1, 9) for _ in range(T)]
+        cc = IntNBitTableBatchedEmbeddingBagsCodegen(
+            embedding_specs=[
+                ("", E, D, nbit_weights_ty, EmbeddingLocation.HOST) for D in Ds
+            ],
+            pooling_mode=PoolingMode.SUM,
+            device="cpu",
+            output_dtype=output_dtype,
+        )
+        cc.fill_random_weights()
+        indices = torch.randint(0, E, (T * B * L,)).int()
+        offsets = torch.tensor([L * b_t for b_t in range(B * T + 1)]).int()
+        per_sample_weights = torch.randn(indices.numel()) if weighted else None
+        output_ref = cc(indices, offsets, per_sample_weights)
+
+        (
+            output,
+            output_D_offsets,
+        ) = torch.ops.fbgemm.int_nbit_split_embedding_codegen_lookup_function_padded(
+            dev_weights=cc.weights_host,
+            uvm_weights=cc.weights_uvm,
+            weights_placements=cc.weights_placements,
+            weights_offsets=cc.weights_offsets,
+            weights_tys=cc.weights_tys,
+            D_offsets=cc.D_offsets,
+            total_D=cc.total_D,
+            indices=indices,
+            offsets=offsets,
+            pooling_mode=int(PoolingMode.SUM),
+            indice_weights=per_sample_weights,
+            output_dtype=cc.output_dtype,
+            row_alignment=cc.row_alignment,
+        )
+        cache_line_elements = 64 // output.element_size()
+        self.assertEqual(output.size(1), int(output_D_offsets[-1]))
+        for t, D in enumerate(Ds):
+            D_begin = int(output_D_offsets[t])
+            self.assertEqual(D_begin % cache_line_elements, 0)
+            torch.testing.assert_close(
+                output[:, D_begin : D_begin + D],
+                output_ref[:, sum(Ds[:t]) : sum(Ds[: t + 1])],
+                rtol=0,
+                atol=0,
+            )
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -67,6 +67,10 @@ VERBOSITY: Verbosity = Verbosity.verbose
 class BackwardOptimizersTest(unittest.TestCase):
     def assert_close_optim_state(self, test: torch.Tensor, ref: torch.Tensor) -> None:
         tolerance = 1.0e-4 if test.dtype == torch.float else 1.0e-2
+        if test.dtype == torch.uint8:
+            # Rowwise quantized state, dequantize with its qparams
+            test = torch.ops.fbgemm.Fused8BitRowwiseQuantizedToFloat(test.cuda())
+            tolerance = 5.0e-2
 
         torch.testing.assert_close(
             test.float().cpu(),
@@ -832,6 +836,8 @@ class BackwardOptimizersTest(unittest.TestCase):
                 {"momentum1": SparseType.BF16},
                 {"momentum2": SparseType.BF16},
                 {"momentum1": SparseType.BF16, "momentum2": SparseType.BF16},
+                {"momentum1": SparseType.INT8},
+                {"momentum1": SparseType.INT8, "momentum2": SparseType.BF16},
             ]
         ),
     )
@@ -842,7 +848,7 @@ class BackwardOptimizersTest(unittest.TestCase):
         suppress_health_check=[HealthCheck.filter_too_much, HealthCheck.data_too_large],
     )
     @unittest.skipIf(*gpu_unavailable)
-    def test_backward_optimizers_partial_rowwise_adam_bf16_momentum(  # noqa C901
+    def test_backward_optimizers_partial_rowwise_adam_low_precision_momentum(  # noqa C901
         self,
         T: int,
         D: int,
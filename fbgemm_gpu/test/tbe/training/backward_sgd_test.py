@@ -93,7 +93,6 @@ class BackwardSGDTest(unittest.TestCase):
             or (
                 weights_precision != SparseType.INT8
                 and output_dtype != SparseType.INT8
-                and not use_cpu
                 and pooling_mode != PoolingMode.NONE
             )
         )
@@ -378,7 +377,7 @@ class BackwardSGDTest(unittest.TestCase):
             weights_precision,
             weighted,
             mixed,
-            mixed_B if not use_cpu else False,
+            mixed_B,
             use_cache,
             cache_algorithm,
             long_segments,
@@ -436,6 +435,171 @@ class BackwardSGDTest(unittest.TestCase):
             SparseType.FP32,  # output_dtype
         )
 
+    @given(
+        D=st.integers(min_value=2, max_value=10),
+        # The deterministic mode splits runs into 16K-lookup chunks, so 256K
+        # lookups of one row are reduced from 16 thread blocks
+        B=st.sampled_from([1152, 256 * 1024]),
+        weighted=st.booleans(),
+        use_cache=st.booleans(),
+    )
+    @settings(
+        verbosity=VERBOSITY,
+        max_examples=MAX_EXAMPLES_LONG_RUNNING,
+        deadline=None,
+        suppress_health_check=[HealthCheck.filter_too_much, HealthCheck.data_too_large],
+    )
+    @unittest.skipIf(*gpu_unavailable)
+    def test_backward_sgd_really_long_segments_deterministic(  # noqa C901
+        self,
+        D: int,
+        B: int,
+        weighted: bool,
+        use_cache: bool,
+    ) -> None:
+        deterministic = torch.are_deterministic_algorithms_enabled()
+        torch.use_deterministic_algorithms(True)
+        try:
+            self.execute_backward_sgd_(
+                2,  # T
+                D,
+                B,
+                1,  # log_E,
+                1,  # L
+                SparseType.FP32,  # weights_precision
+                weighted,
+                False,  # mixed
+                False,  # mixed_B
+                use_cache,
+                CacheAlgorithm.LRU,
+                True,  # long_segments
+                PoolingMode.SUM,  # pooling_mode
+                False,  # use_cpu
+                SparseType.FP32,  # output_dtype
+            )
+        finally:
+            torch.use_deterministic_algorithms(deterministic)
+
+    @given(
+        B=st.integers(min_value=1, max_value=64),
+        L=st.integers(min_value=0, max_value=20),
+        log_E=st.integers(min_value=1, max_value=5),
+        weighted=st.booleans(),
+        pooling_mode=st.sampled_from([PoolingMode.SUM, PoolingMode.MEAN]),
+    )
+    @settings(
+        verbosity=VERBOSITY,
+        max_examples=MAX_EXAMPLES,
+        deadline=None,
+        suppress_health_check=[HealthCheck.filter_too_much],
+    )
+    def test_backward_sgd_cpu_cache_csc_plan(
+        self,
+        B: int,
+        L: int,
+        log_E: int,
+        weighted: bool,
+        pooling_mode: PoolingMode,
+    ) -> None:
+        # NOTE: MEAN pooling will not work with indice_weights!
+        assume(not weighted or pooling_mode == PoolingMode.SUM)
+        E = int(10**log_E)
+        D = 8
+        # Features 0 and 1 share table 0
+        feature_table_map = [0, 0, 1]
+        T = len(feature_table_map)
+        embs = [
+            SplitTableBatchedEmbeddingBagsCodegen(
+                [(E, D, EmbeddingLocation.HOST, ComputeDevice.CPU)] * 2,
+                feature_table_map=feature_table_map,
+                optimizer=OptimType.EXACT_SGD,
+                learning_rate=0.05,
+                pooling_mode=pooling_mode,
+                cache_csc_plan=cache_csc_plan,
+            )
+            for cache_csc_plan in [False, True]
+        ]
+        for w_ref, w in zip(
+            embs[0].split_embedding_weights(), embs[1].split_embedding_weights()
+        ):
+            w.copy_(w_ref)
+
+        # The backward pass from the plan of the forward pass must update the
+        # weights exactly as the one sorting the indices itself
+        for _ in range(2):
+            lengths = torch.randint(0, L + 1, (T * B,))
+            offsets = torch.cat([torch.zeros(1, dtype=torch.long), lengths.cumsum(0)])
+            indices = torch.randint(0, E, (int(offsets[-1]),))
+            per_sample_weights = torch.rand(indices.numel()) if weighted else None
+            outputs = [emb(indices, offsets, per_sample_weights) for emb in embs]
+            torch.testing.assert_close(outputs[0], outputs[1], atol=0, rtol=0)
+            grad_output = torch.randn_like(outputs[0])
+            for output in outputs:
+                output.backward(grad_output)
+        for w_ref, w in zip(
+            embs[0].split_embedding_weights(), embs[1].split_embedding_weights()
+        ):
+            torch.testing.assert_close(w, w_ref, atol=0, rtol=0)
+
+    @given(
+        B=st.integers(min_value=1, max_value=64),
+        L=st.integers(min_value=0, max_value=20),
+        log_E=st.integers(min_value=1, max_value=5),
+        weighted=st.booleans(),
+        pooling_mode=st.sampled_from([PoolingMode.SUM, PoolingMode.MEAN]),
+    )
+    @settings(
+        verbosity=VERBOSITY,
+        max_examples=MAX_EXAMPLES,
+        deadline=None,
+        suppress_health_check=[HealthCheck.filter_too_much],
+    )
+    def test_backward_sgd_cpu_hogwild(
+        self,
+        B: int,
+        L: int,
+        log_E: int,
+        weighted: bool,
+        pooling_mode: PoolingMode,
+    ) -> None:
+        # NOTE: MEAN pooling will not work with indice_weights!
+        assume(not weighted or pooling_mode == PoolingMode.SUM)
+        E = int(10**log_E)
+        D = 8
+        # Features 0 and 1 share table 0
+        feature_table_map = [0, 0, 1]
+        T = len(feature_table_map)
+        embs = [
+            SplitTableBatchedEmbeddingBagsCodegen(
+                [(E, D, EmbeddingLocation.HOST, ComputeDevice.CPU)] * 2,
+                feature_table_map=feature_table_map,
+                optimizer=OptimType.EXACT_SGD,
+                learning_rate=0.05,
+                pooling_mode=pooling_mode,
+                hogwild_backward=hogwild_backward,
+            )
+            for hogwild_backward in [False, True]
+        ]
+        for w_ref, w in zip(
+            embs[0].split_embedding_weights(), embs[1].split_embedding_weights()
+        ):
+            w.copy_(w_ref)
+
+        # SGD updates of partial gradient sums add up to the exact update, up
+        # to rounding
+        lengths = torch.randint(0, L + 1, (T * B,))
+        offsets = torch.cat([torch.zeros(1, dtype=torch.long), lengths.cumsum(0)])
+        indices = torch.randint(0, E, (int(offsets[-1]),))
+        per_sample_weights = torch.rand(indices.numel()) if weighted else None
+        outputs = [emb(indices, offsets, per_sample_weights) for emb in embs]
+        grad_output = torch.randn_like(outputs[0])
+        for output in outputs:
+            output.backward(grad_output)
+        for w_ref, w in zip(
+            embs[0].split_embedding_weights(), embs[1].split_embedding_weights()
+        ):
+            torch.testing.assert_close(w, w_ref, atol=1e-4, rtol=1e-4)
+
 
 if __name__ == "__main__":
     unittest.main()
@@ -107,7 +107,6 @@ class ForwardTest(unittest.TestCase):
             or (
                 weights_precision != SparseType.INT8
                 and output_dtype != SparseType.INT8
-                and not use_cpu
                 and pooling_mode != PoolingMode.NONE
             )
         )
@@ -773,6 +772,56 @@ class ForwardTest(unittest.TestCase):
             use_experimental_tbe,
         )
 
+    @unittest.skipIf(*gpu_unavailable)
+    @given(
+        T=st.integers(min_value=1, max_value=10),
+        # D = 4 or 8 (D is multiplied by 4 in execute_forward_), which the
+        # pooled forward runs with 2-thread sub-warp groups
+        D=st.integers(min_value=1, max_value=2),
+        B=st.integers(min_value=1, max_value=128),
+        log_E=st.integers(min_value=3, max_value=5),
+        L=st.integers(min_value=0, max_value=20),
+        weights_precision=st.sampled_from([SparseType.FP16, SparseType.FP32]),
+        weighted=st.booleans(),
+        use_cache=st.booleans(),
+        pooling_mode=st.sampled_from([PoolingMode.SUM, PoolingMode.MEAN]),
+    )
+    @settings(
+        verbosity=VERBOSITY,
+        max_examples=MAX_EXAMPLES_LONG_RUNNING,
+        deadline=None,
+        suppress_health_check=[HealthCheck.filter_too_much, HealthCheck.data_too_large],
+    )
+    def test_forward_gpu_tiny_dim(
+        self,
+        T: int,
+        D: int,
+        B: int,
+        log_E: int,
+        L: int,
+        weights_precision: SparseType,
+        weighted: bool,
+        use_cache: bool,
+        pooling_mode: PoolingMode,
+    ) -> None:
+        self.execute_forward_(
+            T,
+            D,
+            B,
+            log_E,
+            L,
+            weights_precision,
+            weighted and pooling_mode == PoolingMode.SUM,
+            False,  # mixed
+            False,  # mixed_B
+            use_cache,
+            CacheAlgorithm.LRU,
+            pooling_mode,
+            False,  # use_cpu
+            SparseType.FP32,  # output_dtype
+            False,  # use_experimental_tbe
+        )
+
     @unittest.skipIf(*gpu_unavailable)
     @given(
         T=st.integers(min_value=1, max_value=10),
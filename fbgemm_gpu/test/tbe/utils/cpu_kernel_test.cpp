@@ -6,6 +6,10 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <algorithm>
+#include <tuple>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include <ATen/ATen.h>
@@ -88,3 +92,72 @@ TEST(CpuKernelTest, csr2csc_test) {
     EXPECT_EQ(expect_weights[i], csc_weighted.weights[i]);
   }
 }
+
+TEST(CpuKernelTest, csr2csc_shared_table_test) {
+  // Two features share the table; small tables are transposed by counting and
+  // large ones by radix sort, which must give the same stable order
+  const int B = 13;
+  const int num_features = 2;
+  for (const int64_t num_embeddings : {50, 1 << 22}) {
+    for (const bool weighted : {false, true}) {
+      at::manual_seed(num_embeddings + weighted);
+      const at::Tensor lengths =
+          at::randint(0, 6, {num_features * B}, at::kLong);
+      const at::Tensor offsets = at::cat(
+          {at::zeros({1}, at::kLong), at::cumsum(lengths, 0)});
+      const int64_t nnz = offsets[-1].item<int64_t>();
+      const at::Tensor indices = at::randint(0, 40, {nnz}, at::kLong);
+      const at::Tensor indice_weights = at::rand({nnz}, at::kFloat);
+      const int64_t pooling_mode = (int64_t)fbgemm_gpu::PoolingMode::MEAN;
+      const int table_to_feature_offset[2] = {0, num_features};
+
+      internal::HyperCompressedSparseColumn csc;
+      ::internal::csr2csc(
+          csc,
+          B,
+          offsets.accessor<int64_t, 1>(),
+          indices.accessor<int64_t, 1>(),
+          weighted ? indice_weights.accessor<at::acc_type<float, true>, 1>()
+                   : at::TensorAccessor<at::acc_type<float, true>, 1>(
+                         nullptr, nullptr, nullptr),
+          pooling_mode,
+          table_to_feature_offset,
+          num_embeddings);
+
+      // {index, bag, weight} in CSR order, stably sorted by index
+      const auto offsets_acc = offsets.accessor<int64_t, 1>();
+      const auto indices_acc = indices.accessor<int64_t, 1>();
+      const auto weights_acc = indice_weights.accessor<float, 1>();
+      std::vector<std::tuple<int64_t, int, float>> expected;
+      for (int bag = 0; bag < num_features * B; ++bag) {
+        const int64_t L = offsets_acc[bag + 1] - offsets_acc[bag];
+        for (int64_t p = offsets_acc[bag]; p < offsets_acc[bag + 1]; ++p) {
+          expected.emplace_back(
+              indices_acc[p],
+              bag,
+              weighted ? weights_acc[p] : static_cast<float>(1.0 / L));
+        }
+      }
+      std::stable_sort(
+          expected.begin(), expected.end(), [](const auto& a, const auto& b) {
+            return std::get<0>(a) < std::get<0>(b);
+          });
+
+      int num_columns = 0;
+      for (int i = 0; i < nnz; ++i) {
+        const auto [index, bag, weight] = expected[i];
+        if (i == 0 || index != std::get<0>(expected[i - 1])) {
+          ASSERT_LT(num_columns, csc.num_non_zero_columns);
+          EXPECT_EQ(index, csc.column_segment_indices[num_columns]);
+          EXPECT_EQ(i, csc.column_segment_ptr[num_columns]);
+          ++num_columns;
+        }
+        EXPECT_EQ(bag % B, csc.row_indices[i]);
+        EXPECT_EQ(bag / B, csc.column_segment_ids[i]);
+        EXPECT_EQ(weight, csc.weights[i]);
+      }
+      EXPECT_EQ(num_columns, csc.num_non_zero_columns);
+      EXPECT_EQ(nnz, csc.column_segment_ptr[num_columns]);
+    }
+  }
+}
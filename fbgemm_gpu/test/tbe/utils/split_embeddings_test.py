@@ -198,6 +198,7 @@ class SplitTableBatchedEmbeddingsTest(unittest.TestCase):
                 n_unique_misses,
                 n_conflict_unique_misses,
                 n_conflict_misses,
+                n_rejected_unique_misses,
             ) = cc.get_uvm_cache_stats()
             self.assertEqual(n_calls, 1)
             self.assertEqual(n_requested_indices, len(indices))
@@ -205,6 +206,7 @@ class SplitTableBatchedEmbeddingsTest(unittest.TestCase):
             self.assertEqual(n_unique_misses, len(set(indices.tolist())))
             self.assertEqual(n_conflict_unique_misses, 0)
             self.assertEqual(n_conflict_misses, 0)
+            self.assertEqual(n_rejected_unique_misses, 0)
 
     @unittest.skipIf(*gpu_unavailable)
     @given(
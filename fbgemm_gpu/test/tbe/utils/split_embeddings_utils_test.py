@@ -207,6 +207,153 @@ class SplitEmbeddingsUtilsTest(unittest.TestCase):
             )
         )
 
+    @unittest.skipIf(*gpu_unavailable)
+    @given(
+        B=st.integers(min_value=1, max_value=25),
+        T=st.integers(min_value=1, max_value=10),
+        E=st.integers(min_value=10, max_value=50),
+        D=st.sampled_from([4, 16, 40]),
+    )
+    @settings(deadline=None, suppress_health_check=[HealthCheck.filter_too_much])
+    def test_sparse_embedding_grad(self, B: int, T: int, E: int, D: int) -> None:
+        hash_sizes = [random.randint(E, 2 * E) for _ in range(T)]
+        total_hash_size = sum(hash_sizes)
+        total_hash_size_bits: int = int(math.log2(total_hash_size) + 1)
+        hash_size_cumsum = torch.tensor(
+            [0] + list(accumulate(hash_sizes)), dtype=torch.int64
+        )
+        D_offsets = torch.arange(0, (T + 1) * D, D, dtype=torch.int32)
+        indices, offsets = gen_inputs(hash_sizes, B, 3 * E)
+        grad_output = torch.randn(B, T * D)
+
+        info_B_num_bits, info_B_mask = torch.ops.fbgemm.get_infos_metadata(
+            hash_size_cumsum.cuda(), B, T
+        )
+        (
+            _,
+            _,
+            infos_sorted,
+            sorted_linear_indices_run,
+            _,
+            sorted_linear_indices_num_runs,
+            sorted_linear_indices_cumulative_run_lengths,
+        ) = torch.ops.fbgemm.transpose_embedding_input(
+            hash_size_cumsum.cuda(),
+            total_hash_size_bits,
+            indices.cuda(),
+            offsets.cuda(),
+            info_B_num_bits=info_B_num_bits,
+            info_B_mask=info_B_mask,
+        )
+        unique_ids, grad_rows = torch.ops.fbgemm.compute_sparse_embedding_grad(
+            grad_output.cuda(),
+            sorted_linear_indices_run,
+            sorted_linear_indices_cumulative_run_lengths,
+            sorted_linear_indices_num_runs,
+            infos_sorted,
+            D_offsets.cuda(),
+            D,
+            info_B_num_bits,
+            info_B_mask,
+        )
+
+        # Dense reference gradient of the pooled SUM lookups
+        dense_grad_ref = torch.zeros(total_hash_size, D)
+        linear_indices = []
+        for t in range(T):
+            for b in range(B):
+                start, end = offsets[t * B + b], offsets[t * B + b + 1]
+                bag_linear_indices = indices[start:end] + hash_size_cumsum[t]
+                dense_grad_ref.index_add_(
+                    0,
+                    bag_linear_indices,
+                    grad_output[b, t * D : (t + 1) * D].expand(end - start, D),
+                )
+                linear_indices.append(bag_linear_indices)
+        unique_ids_ref = torch.unique(torch.cat(linear_indices))
+        torch.testing.assert_close(unique_ids.cpu(), unique_ids_ref)
+        torch.testing.assert_close(grad_rows.cpu(), dense_grad_ref[unique_ids_ref])
+
+        # Applying the gradient gathered from two ranks
+        dense = torch.zeros(total_hash_size * D).cuda()
+        torch.ops.fbgemm.apply_sparse_embedding_grad(
+            dense,
+            (hash_size_cumsum[:-1] * D).cuda(),
+            D_offsets.cuda(),
+            hash_size_cumsum.cuda(),
+            torch.cat([unique_ids, unique_ids]),
+            torch.cat([grad_rows, grad_rows]),
+            0.5,
+        )
+        torch.testing.assert_close(
+            dense.view(total_hash_size, D).cpu(), dense_grad_ref
+        )
+
+    @unittest.skipIf(*gpu_unavailable)
+    @given(
+        B=st.integers(min_value=1, max_value=25),
+        T=st.integers(min_value=1, max_value=10),
+        E=st.integers(min_value=1, max_value=50),
+    )
+    @settings(deadline=None, suppress_health_check=[HealthCheck.filter_too_much])
+    def test_segment_length_histogram(self, B: int, T: int, E: int) -> None:
+        hash_sizes = [random.randint(E, 2 * E) for _ in range(T)]
+        total_hash_size_bits: int = int(math.log2(sum(hash_sizes)) + 1)
+        hash_size_cumsum = torch.tensor(
+            [0] + list(accumulate(hash_sizes)), dtype=torch.int64
+        )
+        indices, offsets = gen_inputs(hash_sizes, B, 3 * E)
+
+        info_B_num_bits, info_B_mask = torch.ops.fbgemm.get_infos_metadata(
+            hash_size_cumsum.cuda(), B, T
+        )
+        (
+            _,
+            _,
+            infos_sorted,
+            _,
+            _,
+            sorted_linear_indices_num_runs,
+            sorted_linear_indices_cumulative_run_lengths,
+        ) = torch.ops.fbgemm.transpose_embedding_input(
+            hash_size_cumsum.cuda(),
+            total_hash_size_bits,
+            indices.cuda(),
+            offsets.cuda(),
+            info_B_num_bits=info_B_num_bits,
+            info_B_mask=info_B_mask,
+        )
+        histogram = torch.ops.fbgemm.segment_length_histogram(
+            sorted_linear_indices_num_runs,
+            sorted_linear_indices_cumulative_run_lengths,
+            infos_sorted,
+            T,
+            info_B_num_bits,
+        )
+
+        # Each run is a unique linear index, and lands in bin floor(log2(SL))
+        # of its table
+        histogram_ref = torch.zeros(T, 32, dtype=torch.int32)
+        for t in range(T):
+            linear_indices = indices[offsets[t * B] : offsets[(t + 1) * B]]
+            _, counts = torch.unique(linear_indices, return_counts=True)
+            for count in counts.tolist():
+                histogram_ref[t, count.bit_length() - 1] += 1
+        torch.testing.assert_close(histogram.cpu(), histogram_ref)
+
+        base, warps_per_cta = 32, 8
+        thresholds = torch.ops.fbgemm.adaptive_max_segment_length_per_warp(
+            histogram, base, warps_per_cta
+        ).cpu()
+        for t in range(T):
+            threshold = thresholds[t].item()
+            self.assertTrue(base <= threshold <= base * warps_per_cta)
+            k = threshold.bit_length() - 1
+            num_runs = histogram_ref[t].sum().item()
+            num_long_runs = histogram_ref[t, k:].sum().item()
+            if threshold < base * warps_per_cta:
+                self.assertLessEqual(num_long_runs * warps_per_cta, num_runs)
+
     @given(
         T=st.integers(min_value=1, max_value=64),
         B=st.integers(min_value=1, max_value=64),
@@ -568,6 +715,55 @@ class SplitEmbeddingsUtilsTest(unittest.TestCase):
                 )
             torch.testing.assert_close(dense_indices.clone().fill_(-1), dense_indices_)
 
+    @given(
+        T=st.integers(min_value=1, max_value=5),
+        B=st.integers(min_value=1, max_value=8),
+        L=st.integers(min_value=0, max_value=40),
+        load_factor=st.sampled_from([0.5, 0.8, 0.95]),
+        unpruned_table=st.booleans(),
+    )
+    @settings(verbosity=VERBOSITY, max_examples=MAX_EXAMPLES, deadline=None)
+    def test_pruning_grouped_hashmap(
+        self,
+        T: int,
+        B: int,
+        L: int,
+        load_factor: float,
+        unpruned_table: bool,
+    ) -> None:
+        E = 1 << 20
+        # One slot more than indices, so that pruned_hashmap_lookup stops
+        capacities = [int(B * L / load_factor) + 1 for _ in range(T)]
+        if unpruned_table:
+            capacities[-1] = 0
+        hash_table_offsets = torch.tensor([0] + np.cumsum(capacities).tolist()).long()
+
+        indices = torch.cat(
+            [torch.randperm(E)[: B * L] for _ in range(T)], dim=0
+        ).int()
+        dense_indices = torch.randint(low=-1, high=E, size=(T * B * L,)).int()
+        offsets = torch.tensor([L * b_t for b_t in range(B * T + 1)]).int()
+
+        hash_table = torch.full((sum(capacities), 2), -1, dtype=torch.int32)
+        torch.ops.fbgemm.pruned_hashmap_insert(
+            indices, dense_indices, offsets, hash_table, hash_table_offsets
+        )
+        groups, group_offsets = torch.ops.fbgemm.pruned_hashmap_grouped_build(
+            indices, dense_indices, offsets, hash_table_offsets
+        )
+
+        # Half of the queries are absent from the tables
+        queries = indices.clone()
+        queries[::2] = torch.randint(low=0, high=2 * E, size=queries[::2].shape).int()
+        torch.testing.assert_close(
+            torch.ops.fbgemm.pruned_hashmap_grouped_lookup(
+                queries, offsets, groups, group_offsets
+            ),
+            torch.ops.fbgemm.pruned_hashmap_lookup(
+                queries, offsets, hash_table, hash_table_offsets
+            ),
+        )
+
     def test_pickle(self) -> None:
         # pyre-ignore[16]
         tensor_queue = torch.classes.fbgemm.TensorQueue(torch.empty(0))
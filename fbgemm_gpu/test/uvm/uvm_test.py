@@ -30,6 +30,12 @@ else:
         skipIfRocmLessThan,
     )
 
+from fbgemm_gpu.split_table_batched_embeddings_ops_common import (
+    plan_uvm_advice,
+    UVMAdvicePolicy,
+    UVMTableAccessStats,
+)
+
 if gpu_available:
     # pyre-ignore[21]
     from fbgemm_gpu.uvm import cudaMemAdvise, cudaMemoryAdvise, cudaMemPrefetchAsync
@@ -224,6 +230,81 @@ class UvmTest(unittest.TestCase):
         cpu_tensor_meta = torch.ops.fbgemm.new_managed_tensor(cpu_tensor, sizes)
         assert cpu_tensor.shape == cpu_tensor_meta.shape
 
+    @unittest.skipIf(*gpu_unavailable)
+    @given(
+        sizes=st.lists(
+            st.integers(min_value=1, max_value=(512)), min_size=1, max_size=3
+        ),
+        uvm_op=st.sampled_from(
+            [
+                torch.ops.fbgemm.new_pooled_managed_tensor,
+                torch.ops.fbgemm.new_pooled_host_mapped_tensor,
+                torch.ops.fbgemm.new_pooled_pinned_tensor,
+            ]
+        ),
+    )
+    @settings(verbosity=Verbosity.verbose, max_examples=MAX_EXAMPLES, deadline=None)
+    # pyre-fixme[2]: Parameter must be annotated.
+    def test_pooled_tensor_reuse(self, sizes: List[int], uvm_op) -> None:
+        prototype = torch.empty(0, device="cuda:0", dtype=torch.float)
+        t = uvm_op(prototype, sizes)
+        assert t.shape == torch.Size(sizes)
+        if uvm_op is torch.ops.fbgemm.new_pooled_pinned_tensor:
+            assert t.is_cpu and t.is_pinned()
+            assert not torch.ops.fbgemm.uvm_storage(t)
+        else:
+            assert torch.ops.fbgemm.is_uvm_tensor(t)
+        t.fill_(1.0)
+        torch.ops.fbgemm.pooled_memory_record_stream(t)
+        ptr = t.data_ptr()
+        del t
+        torch.cuda.synchronize()
+
+        # The released block is reused once its stream work has completed
+        reuses = torch.ops.fbgemm.pooled_memory_stats()[3]
+        t = uvm_op(prototype, sizes)
+        assert t.data_ptr() == ptr
+        assert torch.ops.fbgemm.pooled_memory_stats()[3] == reuses + 1
+        del t
+        torch.ops.fbgemm.pooled_memory_empty_cache()
+        assert torch.ops.fbgemm.pooled_memory_stats()[1] == 0
+
+    def test_plan_uvm_advice(self) -> None:
+        row_bytes = 1024
+        # 8 rows per prefetch chunk
+        policy = UVMAdvicePolicy(
+            device_bytes_budget=64 * row_bytes,
+            prefetch_granularity_bytes=8 * row_bytes,
+            hot_chunk_min_fraction=0.5,
+            max_prefetch_bytes_per_table=16 * row_bytes,
+        )
+        hot_reads = torch.zeros(64, dtype=torch.int64)
+        hot_reads[0:8] = 10
+        hot_reads[8:16] = 5
+        hot_reads[40] = 100
+        cold_reads = torch.ones(128, dtype=torch.int64)
+        cold_reads[0:16] = 2
+        advice = plan_uvm_advice(
+            [row_bytes] * 3,
+            [
+                UVMTableAccessStats(row_reads=hot_reads, num_writes=0),
+                UVMTableAccessStats(row_reads=cold_reads, num_writes=1),
+                None,
+            ],
+            policy,
+        )
+        hot, cold, none = advice
+        assert none is None
+        assert hot is not None and cold is not None
+        # Only the table with the most reads per byte fits in the budget
+        assert hot.prefer_device and not cold.prefer_device
+        assert hot.read_mostly and not cold.read_mostly
+        # Rows 8 to 16 are read less than half of the hottest chunk
+        assert hot.prefetch_row_ranges == [(0, 8), (40, 48)]
+        # The 2 hottest chunks fit in the prefetch bound, adjacent chunks
+        # being merged
+        assert cold.prefetch_row_ranges == [(0, 16)]
+
 
 if __name__ == "__main__":
     unittest.main()
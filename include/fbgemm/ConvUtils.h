@@ -43,6 +43,14 @@ constexpr
   return array_of_zeroes<N, Vals..., 0>();
 }
 
+/**
+ * @brief Memory layout of the input activations of a convolution.
+ */
+enum class conv_layout_t {
+  NHWC, ///< channels last, e.g., N H W C for 2D
+  NCHW, ///< channels first, e.g., N C H W for 2D
+};
+
 /**
  * @brief A struct to conveniently store all convolution parameters.
  */
@@ -69,6 +77,8 @@ struct conv_param_t {
       output_pad; //< Padding (next/bottom/right padding in output buffer)
   bool transposed;
 
+  conv_layout_t input_layout; //< Layout of the input activations
+
   /**
    * @brief Constructor for initializing the convolution parameters.
    */
@@ -83,7 +93,8 @@ struct conv_param_t {
       std::array<int, SPATIAL_DIM * 2> pd,
       std::array<int, SPATIAL_DIM> dilations = array_of_ones<SPATIAL_DIM>(),
       std::array<int, SPATIAL_DIM> otpt_pd = array_of_zeroes<SPATIAL_DIM>(),
-      bool transposed = false)
+      bool transposed = false,
+      conv_layout_t input_layout = conv_layout_t::NHWC)
       : MB(mb),
         IC(ic),
         OC(oc),
@@ -94,7 +105,8 @@ struct conv_param_t {
         pad(pd),
         dilation(dilations),
         output_pad(otpt_pd),
-        transposed(transposed) {
+        transposed(transposed),
+        input_layout(input_layout) {
     if (ic % g != 0) {
       throw std::runtime_error(
           "groups = " + std::to_string(g) +
@@ -188,6 +200,9 @@ struct conv_param_t {
             std::to_string(output_pad[d]) + ", ";
       }
     }
+    if (input_layout == conv_layout_t::NCHW) {
+      out += ", layout:NCHW";
+    }
     return out;
   }
 };
@@ -11,17 +11,21 @@
 /**
  * Top level include file for FBGEMM.
  */
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <cmath>
 #include <limits>
 #include <memory>
 #include <type_traits>
+#include <vector>
 #include "./ConvUtils.h"
 #include "./FbgemmBuild.h"
 #include "./FbgemmEmbedding.h"
 #include "./FbgemmI8DepthwiseAvx2.h"
 #include "./FbgemmI8DirectconvAvx2.h"
 #include "./FbgemmI8Spmdm.h"
+#include "./FbgemmI8Winograd.h"
 #include "./QuantUtilsAvx2.h"
 #include "./Types.h"
 #include "./Utils.h"
@@ -236,10 +240,15 @@ class PackMatrix {
   }
 
   /**
-   * @return The beginning of (rowBlockNum, colBlockNum)th block
+   * @return The beginning of (rowBlockNum, colBlockNum)th block, in the copy
+   *         on the NUMA node of the calling thread if the matrix is
+   *         replicated.
    */
   inpType* getBuf(std::int32_t rowBlockNum = 0, std::int32_t colBlockNum = 0) {
-    return buf_ + blockRowSize() * blockColSize() * rowBlockNum +
+    inpType* buf = numaReplicas_.empty()
+        ? buf_
+        : static_cast<inpType*>(numaReplicas_.local());
+    return buf + blockRowSize() * blockColSize() * rowBlockNum +
         blockRowSize() * blockColSize() * blockCols() * colBlockNum;
   }
 
@@ -268,6 +277,14 @@ class PackMatrix {
     return G_;
   }
 
+  /**
+   * @return The ISA current when the matrix was constructed, which its
+   *         blocking is for.
+   */
+  inst_set_t isa() const {
+    return isa_;
+  }
+
   /**
    * @return True if the last column block has fewer columns than the block
    *         size.
@@ -276,6 +293,15 @@ class PackMatrix {
     return last_bcol_ != blockColSize();
   }
 
+  /**
+   * @return The bytes of the buffers owned by the object: the packed buffer
+   *         if it was allocated here, and its NUMA replicas.
+   */
+  std::size_t memoryFootprint() const {
+    return (bufAllocatedHere_ ? bufBytes_ : 0) +
+        numaReplicas_.memoryFootprint();
+  }
+
   virtual ~PackMatrix() {
     if (bufAllocatedHere_) {
       fbgemmAlignedFree(buf_);
@@ -305,12 +331,15 @@ class PackMatrix {
   std::int32_t nbrow_; ///< the number of blocks along rows
   std::int32_t nbcol_; ///< the number of blocks along columns
   bool bufAllocatedHere_{false};
+  std::size_t bufBytes_{0}; ///< size of buf_ if allocated here
+  NumaReplicas numaReplicas_; ///< per NUMA node copies of buf_, if any
   const BlockingFactors*
       blocking_params; ///< MCB, KCB, NCB, MR, NR, NR_MIN, ROW_INTERLEAVE;
 
  private:
   std::int32_t nrows_, ncols_;
   int G_;
+  inst_set_t isa_;
   block_type_t packedBlock_; ///< The block in the source matrix just packed
   std::int32_t last_brow_, last_bcol_;
 };
@@ -423,6 +452,19 @@ class FBGEMM_API PackBMatrix final
       int groups = 1,
       const BlockingFactors* params = nullptr);
 
+  /**
+   * @brief Uses the packed matrix serialized by serialize() at serialized
+   *        (e.g. a memory-mapped file) in place, without copying or repacking
+   *        it. The buffer is never written and must outlive this object.
+   *        Throws std::runtime_error if it is not a valid serialized matrix or
+   *        was packed with a blocking other than the one fbgemmPacked uses on
+   *        this machine (or with params).
+   */
+  PackBMatrix(
+      const void* serialized,
+      std::size_t size,
+      const BlockingFactors* params = nullptr);
+
   /**
    * Weight matrices are usually constant so worth pre-packing.
    */
@@ -481,6 +523,26 @@ class FBGEMM_API PackBMatrix final
    */
   void unpack(T* origin_buf, const BlockingFactors* params = nullptr);
 
+  /**
+   * @return The size in bytes of the serialized form of the packed matrix.
+   */
+  std::size_t serializedSize() const;
+
+  /**
+   * @brief Writes the packed matrix and its blocking, in the versioned format
+   *        of PackedMatrixHeader, to the serializedSize() bytes at buf, which
+   *        must be kPackedMatrixDataAlignment-byte aligned.
+   */
+  void serialize(void* buf) const;
+
+  /**
+   * @brief Keeps a copy of the packed matrix in the memory of each of the
+   *        first num_nodes NUMA nodes, so that fbgemmPacked reads the copy
+   *        local to each thread. Costs num_nodes times the memory of the
+   *        packed matrix, which must not change afterwards.
+   */
+  void replicateOnNumaNodes(int num_nodes = fbgemmNumaNodeCount());
+
   ~PackBMatrix() {}
 
  private:
@@ -489,6 +551,28 @@ class FBGEMM_API PackBMatrix final
   std::int32_t ld_;
   std::int32_t row_interleave_;
 
+  PackBMatrix(
+      const PackedMatrixHeader& header,
+      const void* serialized,
+      const BlockingFactors* params);
+
+  /**
+   * @brief Sets the block sizes and row interleave from params, or from the
+   *        packing traits of the current instruction set.
+   */
+  void initializeBlocking_(const BlockingFactors* params);
+
+  static constexpr PackedMatrixKind packedKind_() {
+    return std::is_same_v<accT, std::int16_t>
+        ? PackedMatrixKind::PackBMatrixInt8Acc16
+        : PackedMatrixKind::PackBMatrixInt8Acc32;
+  }
+
+  /**
+   * @return The size in bytes of the packed buffer of all groups.
+   */
+  std::size_t packedBufferBytes_() const;
+
   /**
    * @brief Internal function performing both pack & unpack
    */
@@ -554,6 +638,13 @@ class FBGEMM_API PackWeightMatrixForGConv {
     return pdata_;
   }
 
+  /**
+   * @return The bytes of the packed buffer if it was allocated here.
+   */
+  std::size_t memoryFootprint() const {
+    return bufAllocatedHere_ ? bufBytes_ : 0;
+  }
+
   ~PackWeightMatrixForGConv() {
     if (bufAllocatedHere_) {
       fbgemmAlignedFree(pdata_);
@@ -566,6 +657,7 @@ class FBGEMM_API PackWeightMatrixForGConv {
   const T* sdata_;
   T* pdata_;
   bool bufAllocatedHere_{false};
+  std::size_t bufBytes_{0};
   // Number of groups we work at a time to fill the full simd width
   int GTogether_;
 
@@ -585,6 +677,79 @@ class FBGEMM_API PackWeightMatrixForGConv {
   int packed_index_(int t, int r, int s, int k, int g, int c);
 };
 
+/**
+ * @brief Weights of a strided transposed 2D convolution split by output
+ *        phase for the sub-pixel decomposition.
+ *
+ * An output pixel (oh, ow) only reads the filter taps (r, s) with
+ * oh + pad_t - r * dilation_h and ow + pad_l - s * dilation_w divisible by
+ * the strides. The pixels with the same phase
+ * ((oh + pad_t) % stride_h, (ow + pad_l) % stride_w) share the same taps, so
+ * each phase is a regular convolution with (about) 1 / (stride_h * stride_w)
+ * of the filter, packed here as its own PackBMatrix.
+ */
+class FBGEMM_API PackedTransposedConvMatrix {
+ public:
+  /**
+   * @param conv_p the transposed convolution
+   * @param smat the source unpacked weight in G K/G (R S C/G) layout
+   */
+  PackedTransposedConvMatrix(
+      const conv_param_t<2>& conv_p,
+      const std::int8_t* smat,
+      const BlockingFactors* blocking_params = nullptr);
+
+  /**
+   * @brief Phases are numbered (oh + pad_t) % stride_h * stride_w +
+   *        (ow + pad_l) % stride_w.
+   */
+  int numPhases() const {
+    return static_cast<int>(taps_.size());
+  }
+
+  /**
+   * @brief Filter taps r * S + s read by the output pixels of the phase, in
+   *        increasing order.
+   */
+  const std::vector<int>& taps(int phase) const {
+    return taps_[phase];
+  }
+
+  /**
+   * @brief Weights of the taps of the phase, (taps(phase).size() * IC) x
+   *        (OC / G) in G groups. nullptr if the phase reads no taps.
+   */
+  PackBMatrix<std::int8_t, std::int32_t>* packedWeights(int phase) const {
+    return packed_[phase].get();
+  }
+
+  /**
+   * @brief For each output channel, the sum of the weights of the taps the
+   *        phase does not read. Im2col reads those as A_zero_point, so this
+   *        times A_zero_point is added to match its result.
+   */
+  const std::int32_t* skippedWeightSums(int phase) const {
+    return skipped_sums_[phase].data();
+  }
+
+  /**
+   * @brief Recovers the original weights in G K/G (R S C/G) layout.
+   */
+  void unpack(std::int8_t* origin_buf) const;
+
+  /**
+   * @return The bytes of the packed weights and the weight sums of all phases.
+   */
+  std::size_t memoryFootprint() const;
+
+ private:
+  conv_param_t<2> conv_p_;
+  std::vector<std::vector<int>> taps_;
+  std::vector<std::shared_ptr<PackBMatrix<std::int8_t, std::int32_t>>>
+      packed_;
+  std::vector<std::vector<std::int32_t>> skipped_sums_;
+};
+
 /**
  * @brief A container class to keep packed weight tensor for convolution.
  *        The source tensor should already be quantized.
@@ -632,6 +797,14 @@ class FBGEMM_API PackWeightsForConv {
     return W_pointwise_packed_;
   }
 
+  std::shared_ptr<PackedWinogradConvMatrix> getPackedWForWinograd() {
+    return W_winograd_packed_;
+  }
+
+  std::shared_ptr<PackedTransposedConvMatrix> getPackedWForTransposed() {
+    return W_transposed_packed_;
+  }
+
   int inputChannels() {
     return conv_param_.IC;
   }
@@ -648,6 +821,14 @@ class FBGEMM_API PackWeightsForConv {
     return conv_param_.G;
   }
 
+  /**
+   * @brief The implementation the weights were packed for. It is chosen at
+   * packing time, as it may depend on the instruction set in use.
+   */
+  optimized_conv_t convPath() const {
+    return conv_path_;
+  }
+
   /**
    * @brief Returns true if the packed weights would work for the given
    * convolution parameters, and false otherwise
@@ -665,8 +846,14 @@ class FBGEMM_API PackWeightsForConv {
    */
   void unpack(T* origin_buf);
 
+  /**
+   * @return The bytes of the packed weights of the implementation in use.
+   */
+  std::size_t memoryFootprint() const;
+
  private:
   const conv_param_t<SPATIAL_DIM> conv_param_;
+  const optimized_conv_t conv_path_;
   // Packed weights if we use im2col based convolution implementation
   std::shared_ptr<PackBMatrix<T, accT>> W_im2col_packed_;
   // Packed weights if we use depthwise convolution implementation
@@ -679,6 +866,11 @@ class FBGEMM_API PackWeightsForConv {
       W_gconv_packed_;
   // Packed weights if we use direct gemm for pointwise convolution
   std::shared_ptr<PackBMatrix<T, accT>> W_pointwise_packed_;
+  // Packed weights if we use Winograd F(2x2, 3x3) convolution
+  std::shared_ptr<PackedWinogradConvMatrix> W_winograd_packed_;
+  // Packed weights if we use the sub-pixel decomposition of a strided
+  // transposed convolution
+  std::shared_ptr<PackedTransposedConvMatrix> W_transposed_packed_;
 };
 
 /**
@@ -704,6 +896,11 @@ class FBGEMM_API PackAWithIm2Col
    *                   the buffer. The buffer will be populated when pack
    *                   function is called.
    * @param b_symmetric if true we skip row offset computation
+   * @param implicit_gemm if true, pack only records the block and the macro
+   *                      kernel packs it in panels of MR rows right before
+   *                      multiplying them (see packPanel), so the im2col
+   *                      rows stay in L1 instead of round-tripping through
+   *                      a whole packed block.
    */
   PackAWithIm2Col(
       const conv_param_t<SPATIAL_DIM>& conv_param,
@@ -712,7 +909,8 @@ class FBGEMM_API PackAWithIm2Col
       std::int32_t a_zero_pt = 0,
       std::int32_t* row_offset = nullptr,
       bool b_symmetric = false,
-      const BlockingFactors* params = nullptr);
+      const BlockingFactors* params = nullptr,
+      bool implicit_gemm = false);
 
   /**
    * Activation matrices are not constant so cannot amortize the cost of
@@ -731,9 +929,24 @@ class FBGEMM_API PackAWithIm2Col
 
   /**
    * @brief Packs a block of source matrix into pmat buffer.
+   *        With implicit_gemm, only records the block for packPanel.
    */
   void pack(const block_type_t& block);
 
+  /**
+   * @return True if the block is packed by packPanel in the macro kernel.
+   */
+  bool isImplicitGemm() const {
+    return implicit_gemm_;
+  }
+
+  /**
+   * @brief Packs rows [panel_start, panel_start + panel_rows) of the block
+   *        last given to pack, counted from its first row, into out with
+   *        leading dimension blockColSize(), and computes their row offsets.
+   */
+  void packPanel(int panel_start, int panel_rows, inpType* out);
+
   /**
    * @return A pointer to the row offset buffer.
    */
@@ -751,6 +964,15 @@ class FBGEMM_API PackAWithIm2Col
    */
   static int rowOffsetBufferSize(const BlockingFactors* params = nullptr);
 
+  /**
+   * @return The bytes of the buffers owned by the object, including the row
+   *         offset buffer if it was allocated here.
+   */
+  std::size_t memoryFootprint() const {
+    return BaseType::memoryFootprint() +
+        (rowOffsetAllocatedHere ? BaseType::brow_ * sizeof(std::int32_t) : 0);
+  }
+
   ~PackAWithIm2Col() {
     if (rowOffsetAllocatedHere) {
       fbgemmAlignedFree(row_offset_);
@@ -758,12 +980,23 @@ class FBGEMM_API PackAWithIm2Col
   }
 
  private:
+  /**
+   * @brief Packs the rows of block into out, with their row offsets in
+   *        row_offset_buf, both indexed from block.row_start.
+   */
+  void packRows(
+      const block_type_t& block,
+      inpType* out,
+      std::int32_t* row_offset_buf);
+
   const conv_param_t<SPATIAL_DIM> conv_p_;
   const T* sdata_;
   std::int32_t a_zero_pt_;
   std::int32_t* row_offset_{nullptr};
   bool rowOffsetAllocatedHere{false};
   std::int32_t row_interleave_B_;
+  bool implicit_gemm_;
+  block_type_t implicit_block_{0, 0, 0, 0};
 };
 
 /**
@@ -841,6 +1074,15 @@ class FBGEMM_API PackAWithRowOffset final
    */
   static int rowOffsetBufferSize(const BlockingFactors* params = nullptr);
 
+  /**
+   * @return The bytes of the buffers owned by the object, including the row
+   *         offset buffer if it was allocated here.
+   */
+  std::size_t memoryFootprint() const {
+    return BaseType::memoryFootprint() +
+        (rowOffsetAllocatedHere ? BaseType::brow_ * sizeof(std::int32_t) : 0);
+  }
+
   ~PackAWithRowOffset() {
     if (rowOffsetAllocatedHere) {
       fbgemmAlignedFree(row_offset_);
@@ -933,6 +1175,15 @@ class FBGEMM_API PackAWithQuantRowOffset final
    */
   static int rowOffsetBufferSize(const BlockingFactors* params = nullptr);
 
+  /**
+   * @return The bytes of the buffers owned by the object, including the row
+   *         offset buffer if it was allocated here.
+   */
+  std::size_t memoryFootprint() const {
+    return BaseType::memoryFootprint() +
+        (rowOffsetAllocatedHere ? BaseType::brow_ * sizeof(accT) : 0);
+  }
+
   ~PackAWithQuantRowOffset() {
     if (rowOffsetAllocatedHere) {
       fbgemmAlignedFree(row_offset_);
@@ -1060,6 +1311,45 @@ class ReluOutput {
   inpType zero_pt_;
 };
 
+/**
+ * @brief Map each uint8 output through a 256-entry lookup table in place,
+ *        e.g., as the nextOPType of ReQuantizeOutput to apply a nonlinearity
+ *        such as GELU, SiLU or tanh to the requantized output. Every function
+ *        of a uint8 value is such a table; see ComputeActivationLookupTable.
+ */
+template <
+    typename outT = std::uint8_t,
+    typename inT = std::uint8_t,
+    typename nextOPType = DoNothing<outT, outT>>
+class FBGEMM_API LookupTableOutput {
+ public:
+  using outType = outT;
+  using inpType = inT;
+  /**
+   * @param table 256 entries, table[q] is the output for the value q. It is
+   *              copied.
+   */
+  LookupTableOutput(nextOPType& nextop, const std::uint8_t* table)
+      : nextop_(nextop) {
+    std::copy(table, table + table_.size(), table_.begin());
+  }
+
+  /**
+   * The previous op has written the block to out, which is passed as inp.
+   */
+  template <inst_set_t instSet>
+  inline int f(
+      outT* out,
+      inT* inp,
+      const block_type_t& block,
+      int ld_out,
+      int ld_in) const;
+
+ private:
+  nextOPType& nextop_;
+  std::array<std::uint8_t, 256> table_;
+};
+
 /**
  * @brief Perform Dense-Matrix * Sparse-Matrix as a part the of output
  * processing pipeline.
@@ -1261,6 +1551,77 @@ class FBGEMM_API ReQuantizeOutput {
   const float* act_times_w_scale_;
 };
 
+/**
+ * @brief Add a quantized residual tensor to the 32-bit input buffer as a part
+ * of the output processing pipeline.
+ *
+ * The residual R (scale residual_scale, zero point residual_zero_point) is
+ * brought to the scale of the accumulation (act_times_w_scale) and added in
+ * place to inp, i.e., inp += round((R - residual_zero_point) *
+ * residual_scale / act_times_w_scale). The buffer is then passed to the next
+ * op, typically ReQuantizeOutput, so the sum is requantized once without an
+ * extra pass over the output.
+ */
+template <
+    typename outT = std::uint8_t,
+    typename inT = std::int32_t,
+    typename nextOPType = ReQuantizeOutput<false>>
+class FBGEMM_API DoResidualAddOnInpBuffer {
+ public:
+  using outType = outT;
+  using inpType = inT;
+  /**
+   * @param residual The residual matrix with the same shape as the output.
+   *                 Its element (i, j) is residual[i * ld_residual + j].
+   * @param act_times_w_scale activation_scale * weight_scale of the
+   *                          accumulation. The length of this array follows
+   *                          nextOPType::QGRANType in the same way as the
+   *                          C_multiplier of ReQuantizeOutput.
+   * @param groups The number of groups nextop was created with.
+   */
+  DoResidualAddOnInpBuffer(
+      nextOPType& nextop,
+      const std::uint8_t* residual,
+      int ld_residual,
+      std::int32_t residual_zero_point,
+      float residual_scale,
+      const float* act_times_w_scale,
+      int groups = 1)
+      : nextop_(nextop),
+        residual_(residual),
+        ld_residual_(ld_residual),
+        residual_zero_point_(residual_zero_point),
+        multiplier_(nextop.getNCols()) {
+    int ncol_per_group = nextop.getNCols() / groups;
+    for (int j = 0; j < static_cast<int>(multiplier_.size()); ++j) {
+      int idx = 0;
+      if (nextOPType::QGRANType == QuantizationGranularity::GROUP) {
+        idx = j / ncol_per_group;
+      } else if (
+          nextOPType::QGRANType == QuantizationGranularity::OUT_CHANNEL) {
+        idx = j;
+      }
+      multiplier_[j] = residual_scale / act_times_w_scale[idx];
+    }
+  }
+
+  template <inst_set_t instSet>
+  inline int f(
+      outT* out,
+      inT* inp,
+      const block_type_t& block,
+      int ld_out,
+      int ld_in) const;
+
+ private:
+  nextOPType& nextop_;
+  const std::uint8_t* residual_;
+  const int ld_residual_;
+  const std::int32_t residual_zero_point_;
+  // residual_scale / act_times_w_scale for each output column
+  std::vector<float> multiplier_;
+};
+
 /**
  * @brief Requantize to convert accumulated data to be used as float, i.e., the
  *        output would be used as float.
@@ -1316,6 +1677,40 @@ class FBGEMM_API ReQuantizeForFloat {
         ncols_(nCol),
         groups_(groups) {}
 
+  /**
+   * A quantized per row, e.g., by QuantizeRowwiseDynamic.
+   *
+   * @param Aq_row_scales One scale per row of A, indexed by the row of C.
+   * @param Aq_row_zero_points One zero point per row of A.
+   *
+   * The other parameters are as in the per-tensor constructor.
+   */
+  ReQuantizeForFloat(
+      nextOPType& nextop,
+      const float* Aq_row_scales,
+      const float* Bq_scale,
+      const std::int32_t* Aq_row_zero_points,
+      const std::int32_t* Bq_zero_point,
+      const std::int32_t* row_offsets,
+      const std::int32_t* col_offsets,
+      const float* bias,
+      std::uint32_t nCol,
+      int groups = 1)
+      : ReQuantizeForFloat(
+            nextop,
+            0.0f,
+            Bq_scale,
+            0,
+            Bq_zero_point,
+            row_offsets,
+            col_offsets,
+            bias,
+            nCol,
+            groups) {
+    Aq_row_scales_ = Aq_row_scales;
+    Aq_row_zero_points_ = Aq_row_zero_points;
+  }
+
   template <inst_set_t instSet>
   inline int f(
       outT* out,
@@ -1325,6 +1720,15 @@ class FBGEMM_API ReQuantizeForFloat {
       int ld_in) const;
 
  private:
+  /// Vectorized requantization of block with the A parameters in r.
+  inline void requantizeBlockAvx2(
+      outT* out,
+      const inT* inp,
+      const block_type_t& block,
+      int ld_out,
+      int ld_in,
+      const requantizationForFloatParams_t& r) const;
+
   nextOPType& nextop_;
   float Aq_scale_;
   const float* Bq_scale_;
@@ -1335,6 +1739,8 @@ class FBGEMM_API ReQuantizeForFloat {
   const float* bias_;
   std::uint32_t ncols_;
   int groups_;
+  const float* Aq_row_scales_{nullptr};
+  const std::int32_t* Aq_row_zero_points_{nullptr};
 };
 
 // type specialized implementation in an include file
@@ -1357,6 +1763,11 @@ class FBGEMM_API ReQuantizeForFloat {
  *                        e.g.,  pre-multiply by alpha
  * @tparam cT data type of C matrix
  * @tparam processOutputType further processing of outputs, e.g., Relu
+ *
+ * @param scheduler if not nullptr, the num_threads threads calling
+ *                  fbgemmPacked with it take tiles of the GEMM from it as
+ *                  they finish the previous ones, and thread_id is not used.
+ *                  C_buffer must then have the rows of the whole matrix.
  */
 template <
     typename packingAMatrix,
@@ -1378,8 +1789,253 @@ FBGEMM_API void fbgemmPacked(
     const processOutputType& outProcess,
     int thread_id,
     int num_threads,
+    const BlockingFactors* blocking_params = nullptr,
+    GemmTileScheduler* scheduler = nullptr);
+
+/**
+ * @brief The operands of one of the GEMMs run by fbgemmPackedGrouped, as
+ *        passed to fbgemmPacked.
+ */
+template <
+    typename packingAMatrix,
+    typename packingBMatrix,
+    typename cT,
+    typename processOutputType>
+struct PackedGemmArgs {
+  PackMatrix<
+      packingAMatrix,
+      typename packingAMatrix::inpType,
+      typename packingAMatrix::accType>* packA;
+  PackMatrix<
+      packingBMatrix,
+      typename packingBMatrix::inpType,
+      typename packingBMatrix::accType>* packB;
+  cT* C;
+  std::int32_t* C_buffer;
+  std::uint32_t ldc;
+  const processOutputType* outProcess;
+};
+
+/**
+ * Runs num_gemms independent GEMMs, e.g., many small ones with different B
+ * matrices, on the threads calling it with the same scheduler. Each thread
+ * runs whole GEMMs taken from the scheduler until none are left, so there is
+ * one parallel region for all of them instead of one per fbgemmPacked call.
+ * A GEMM is run by a single thread, so its packA and outProcess are not
+ * shared by threads. Ordering the GEMMs by decreasing size balances the
+ * threads best.
+ */
+template <
+    typename packingAMatrix,
+    typename packingBMatrix,
+    typename cT,
+    typename processOutputType>
+void fbgemmPackedGrouped(
+    const PackedGemmArgs<packingAMatrix, packingBMatrix, cT, processOutputType>*
+        gemms,
+    int num_gemms,
+    GemmTileScheduler& scheduler,
+    const BlockingFactors* blocking_params = nullptr) {
+  for (std::int64_t i = scheduler.next(); i < num_gemms;
+       i = scheduler.next()) {
+    const auto& gemm = gemms[i];
+    fbgemmPacked(
+        *gemm.packA,
+        *gemm.packB,
+        gemm.C,
+        gemm.C_buffer,
+        gemm.ldc,
+        *gemm.outProcess,
+        0,
+        1,
+        blocking_params);
+  }
+}
+
+/**
+ * @brief One of the GEMMs run by fbgemmPackedMultiB with the shared A: the
+ *        prepacked B and where and how the product is output, as passed to
+ *        fbgemmPacked.
+ */
+template <typename packingBMatrix, typename cT, typename processOutputType>
+struct PackedGemmOutput {
+  PackMatrix<
+      packingBMatrix,
+      typename packingBMatrix::inpType,
+      typename packingBMatrix::accType>* packB;
+  cT* C;
+  std::int32_t* C_buffer;
+  std::uint32_t ldc;
+  const processOutputType* outProcess;
+};
+
+/**
+ * Multiplies one A with num_outputs prepacked B matrices with the same number
+ * of rows, e.g., the FC layers of several towers applied to the same input.
+ * Each block of A is packed once and multiplied with every B while it is in
+ * cache, instead of being packed again by one fbgemmPacked call per B. The
+ * row offsets packA computes are the same for all the products, so the
+ * outProcess of every output can use packA.getRowOffsetBuffer(). C_buffer
+ * and threading are as for fbgemmPacked.
+ */
+template <
+    typename packingAMatrix,
+    typename packingBMatrix,
+    typename cT,
+    typename processOutputType>
+FBGEMM_API void fbgemmPackedMultiB(
+    PackMatrix<
+        packingAMatrix,
+        typename packingAMatrix::inpType,
+        typename packingAMatrix::accType>& packA,
+    const PackedGemmOutput<packingBMatrix, cT, processOutputType>* outputs,
+    int num_outputs,
+    int thread_id,
+    int num_threads,
     const BlockingFactors* blocking_params = nullptr);
 
+/**
+ * Splits the quantized nRow x nCol B (laid out as for PackBMatrix) so that the
+ * 16-bit accumulation GEMM can multiply it without saturating. The acc16
+ * kernels let vpmaddubsw add the u8 x s8 products of two adjacent rows of a
+ * group in int16, which saturates for A = 255 unless the two elements add up
+ * to a magnitude of at most 128. For every pair that does not, the element of
+ * the larger magnitude is moved from B_dense (same layout and ld as smat) to
+ * B_outliers, which must be a (nRow / groups) x (groups * nCol)
+ * CompressedSparseColumn, as DoSpmdmOnInpBuffer uses it. B_dense + B_outliers
+ * is B.
+ */
+FBGEMM_API void splitOutliersForAcc16(
+    matrix_op_t trans,
+    std::int32_t nRow,
+    std::int32_t nCol,
+    const std::int8_t* smat,
+    std::int32_t ld,
+    std::int8_t* B_dense,
+    CompressedSparseColumn& B_outliers,
+    int groups = 1);
+
+/**
+ * @brief Quantized B packed for whichever of the 16-bit and 32-bit
+ *        accumulation GEMMs is faster, as run by fbgemmPackedWithOutliers.
+ *
+ * The acc16 kernels do about twice the multiply-adds of the acc32 ones per
+ * instruction on AVX2 and AVX512 without VNNI, but need the outliers of B
+ * split off by splitOutliersForAcc16 and added back by DoSpmdmOnInpBuffer,
+ * which is much slower per element. B is packed for acc16 when the CPU has
+ * the acc16 kernels and at most max_outlier_density of B are outliers, and
+ * for acc32 otherwise.
+ */
+class FBGEMM_API PackBMatrixWithOutliers {
+ public:
+  PackBMatrixWithOutliers(
+      matrix_op_t trans,
+      std::int32_t nRow,
+      std::int32_t nCol,
+      const std::int8_t* smat,
+      std::int32_t ld,
+      int groups = 1,
+      float max_outlier_density = 0.01f);
+
+  bool useAcc16() const {
+    return packBAcc16_ != nullptr;
+  }
+  /**
+   * @return nullptr unless useAcc16().
+   */
+  PackBMatrix<std::int8_t, std::int16_t>* packedAcc16() {
+    return packBAcc16_.get();
+  }
+  /**
+   * @return nullptr if useAcc16().
+   */
+  PackBMatrix<std::int8_t, std::int32_t>* packedAcc32() {
+    return packBAcc32_.get();
+  }
+  /**
+   * Empty unless useAcc16().
+   */
+  const CompressedSparseColumn& outliers() const {
+    return outliers_;
+  }
+
+  std::int32_t numRows() const {
+    return nRow_;
+  }
+  std::int32_t numCols() const {
+    return nCol_;
+  }
+  int numGroups() const {
+    return groups_;
+  }
+
+ private:
+  std::int32_t nRow_;
+  std::int32_t nCol_;
+  int groups_;
+  CompressedSparseColumn outliers_;
+  std::unique_ptr<PackBMatrix<std::int8_t, std::int16_t>> packBAcc16_;
+  std::unique_ptr<PackBMatrix<std::int8_t, std::int32_t>> packBAcc32_;
+};
+
+/**
+ * Computes the uint8 m x (packB.numRows()) A times packB, requantized by
+ * outProcess, with the GEMM packB was packed for: the acc16 one followed by
+ * DoSpmdmOnInpBuffer with the outliers, or the acc32 one. A is packed with its
+ * row offsets for the accumulation type, so the row offsets of outProcess are
+ * not used. C_buffer and threading are as for fbgemmPacked.
+ */
+template <
+    bool FUSE_RELU,
+    QuantizationGranularity Q_GRAN = QuantizationGranularity::TENSOR>
+FBGEMM_API void fbgemmPackedWithOutliers(
+    const std::uint8_t* A,
+    int m,
+    int lda,
+    PackBMatrixWithOutliers& packB,
+    std::uint8_t* C,
+    std::int32_t* C_buffer,
+    std::uint32_t ldc,
+    const ReQuantizeOutput<FUSE_RELU, Q_GRAN>& outProcess,
+    int thread_id = 0,
+    int num_threads = 1);
+
+/**
+ * @brief Fully connected layer with dynamically quantized activations,
+ *        C = A * B + bias for fp32 m x k A and the int8 quantized B.
+ *
+ * The quantization parameters of A are chosen from its range, then each block
+ * of A is quantized while it is packed for the GEMM, and the int32 results are
+ * converted back to fp32. This is the FindMinMax, ChooseQuantizationParams,
+ * PackAWithQuantRowOffset, ReQuantizeForFloat and fbgemmPacked pipeline in
+ * one call, reading A twice: once for its range, which the quantization of
+ * every block depends on, and once while packing.
+ *
+ * @param B_scale 1 entry for QuantizationGranularity::TENSOR, n for
+ *                QuantizationGranularity::OUT_CHANNEL.
+ * @param B_zero_point Same length as B_scale.
+ * @param col_offsets Column sums of B minus B_zero_point * k, e.g., from
+ *                    col_offsets_with_zero_pt_s8acc32_ref. The length is n.
+ * @param bias nullptr or n entries.
+ * @param C m x n output with leading dimension ldc, also used as the int32
+ *          buffer of the GEMM.
+ */
+template <
+    bool FUSE_RELU,
+    QuantizationGranularity Q_GRAN = QuantizationGranularity::TENSOR>
+FBGEMM_API void fbgemmDynamicQuantFC(
+    int m,
+    const float* A,
+    PackBMatrix<std::int8_t>& packedB,
+    const float* B_scale,
+    const std::int32_t* B_zero_point,
+    const std::int32_t* col_offsets,
+    const float* bias,
+    float* C,
+    std::uint32_t ldc,
+    int thread_id = 0,
+    int num_threads = 1);
+
 /**
  * @brief Perform small-channels-per-group groupwise convolution
  *        Note: Currently threading is not supported. This function does
@@ -1408,6 +2064,13 @@ FBGEMM_API void fbgemmGroupwiseConv(
     int thread_id,
     int num_threads);
 
+/**
+ * @brief Direct 2D convolution without an im2col buffer.
+ *
+ * Dense non-transposed convolutions support any filter size, stride, dilation
+ * and padding and are split over threads by output rows. Transposed
+ * convolutions use a JIT kernel and run on thread 0 only.
+ */
 template <
     int SPATIAL_DIM,
     QuantizationGranularity Q_GRAN,
@@ -1424,6 +2087,53 @@ FBGEMM_API void fbgemmDirectConv(
     int thread_id,
     int num_threads);
 
+/**
+ * @brief Dense 3x3 stride-1 2D convolution using Winograd F(2x2, 3x3).
+ *
+ * Each 2x2 block of outputs is computed from a 4x4 tile of the input with
+ * 16 instead of 36 multiplications per input channel. The transforms use
+ * integer weights scaled by 4 so the int32 result is exactly the same as
+ * that of the im2col path before requantization.
+ */
+template <
+    QuantizationGranularity Q_GRAN,
+    bool FUSE_RELU,
+    typename BIAS_TYPE = std::int32_t>
+FBGEMM_API void fbgemmWinogradConv(
+    const conv_param_t<2>& conv_p,
+    const std::uint8_t* activations,
+    PackedWinogradConvMatrix& packed_weights,
+    std::uint8_t* out,
+    std::int32_t* outBuffer,
+    ReQuantizeOutput<FUSE_RELU, Q_GRAN, BIAS_TYPE>& outProcess,
+    int thread_id,
+    int num_threads);
+
+/**
+ * @brief Strided transposed 2D convolution by sub-pixel decomposition.
+ *
+ * The output pixels of each phase (see PackedTransposedConvMatrix) are a
+ * regular convolution of the input with the taps of that phase, computed as
+ * a GEMM over only those taps instead of the im2col GEMM over all of them,
+ * most of which read zero points for strides > 1. The int32 results and row
+ * offsets are adjusted for the skipped taps so that the output is exactly
+ * that of the im2col path. The int32 results are kept in a per-thread
+ * scratch buffer.
+ */
+template <
+    QuantizationGranularity Q_GRAN,
+    bool FUSE_RELU,
+    typename BIAS_TYPE = std::int32_t>
+FBGEMM_API void fbgemmTransposedConv(
+    const conv_param_t<2>& conv_p,
+    const std::uint8_t* activations,
+    const PackedTransposedConvMatrix& packed_weights,
+    std::uint8_t* out,
+    ReQuantizeOutput<FUSE_RELU, Q_GRAN, BIAS_TYPE>& outProcess,
+    int thread_id,
+    int num_threads,
+    const BlockingFactors* blocking_params = nullptr);
+
 /**
  * @return Size of row offset buffer in number of elements needed for
  * fbgemmGroupwiseConv
@@ -1438,6 +2148,20 @@ FBGEMM_API int rowOffsetBufferSizeGConv(
 template <int SPATIAL_DIM = 2, typename ACC_T = std::int32_t>
 bool takeDepthWiseFastPath(const conv_param_t<SPATIAL_DIM>& conv_p);
 
+/**
+ * @brief Is this a dense 3x3 stride-1 convolution with enough channels for
+ * the Winograd path to pay off?
+ */
+template <int SPATIAL_DIM = 2, typename ACC_T = std::int32_t>
+bool takeWinogradFastPath(const conv_param_t<SPATIAL_DIM>& conv_p);
+
+/**
+ * @brief Is this a strided transposed 2D convolution for the sub-pixel
+ * decomposition?
+ */
+template <int SPATIAL_DIM = 2, typename ACC_T = std::int32_t>
+bool takeTransposedConvPath(const conv_param_t<SPATIAL_DIM>& conv_p);
+
 /**
  * @brief Is this groupwise convolution supported?
  */
@@ -1481,11 +2205,47 @@ FBGEMM_API int fbgemmConv(
  *
  * @tparam SPATIAL_DIM It's 2 for 2D convolutions and 3 for 3D convolutions.
  *
- * @return optimized_conv_t::depthwise, optimized_conv_t::groupwise or
+ * @return optimized_conv_t::depthwise, optimized_conv_t::groupwise,
+ *         optimized_conv_t::winograd, optimized_conv_t::transposed or
  *         optimized_conv_t::im2col
  *
  */
 template <int SPATIAL_DIM = 2, typename ACC_T = std::int32_t>
 FBGEMM_API optimized_conv_t
 ConvFastPath(const conv_param_t<SPATIAL_DIM>& conv_p);
+
+/**
+ * @brief 2D depthwise convolution followed by a pointwise (1x1) convolution,
+ *        as in a MobileNet depthwise-separable block, without writing the
+ *        intermediate activations to memory.
+ *
+ * The output of the depthwise convolution is computed a band of rows at a
+ * time into a per-thread buffer sized to stay in cache, and the pointwise
+ * GEMM reads the band from there. The result is the same as fbgemmConv with
+ * dw_conv_p followed by fbgemmConv with pw_conv_p.
+ *
+ * @param dw_conv_p Must take the depthwise fast path of fbgemmConv.
+ * @param pw_conv_p Must take the pointwise fast path with G = 1, and its input
+ *                  must be the output of dw_conv_p.
+ * @param dwOutProcess Requantization of the depthwise output, which is the
+ *                     uint8 activation of the pointwise convolution.
+ * @param outBuffer Same as for fbgemmConv with pw_conv_p.
+ * @param pwOutProcess Requantization of the output. Its row offsets are set
+ *                     by this function, so each thread needs its own.
+ * @param thread_id, num_threads Threads split the bands of all images.
+ */
+template <typename dwProcessOutputType, typename pwProcessOutputType>
+FBGEMM_API int fbgemmDepthwiseSeparableConv(
+    const conv_param_t<2>& dw_conv_p,
+    const conv_param_t<2>& pw_conv_p,
+    const std::uint8_t* activations,
+    PackWeightsForConv<2>& dw_packed_weights,
+    PackWeightsForConv<2>& pw_packed_weights,
+    const dwProcessOutputType& dwOutProcess,
+    typename pwProcessOutputType::outType* out,
+    std::int32_t* outBuffer,
+    pwProcessOutputType& pwOutProcess,
+    int thread_id,
+    int num_threads);
+
 } // namespace fbgemm
@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+// GEMM with fp32 activations and bf16 weights, using the same packed layout
+// and cblas_gemm_compute interface as the fp16 GEMM. bf16 keeps the fp32
+// exponent range, so weights do not saturate at the fp16 maximum.
+
+#include "./FbgemmFP16.h"
+#include "./FbgemmPackMatrixB.h"
+#include "./Types.h"
+
+namespace fbgemm {
+
+template <>
+struct TypeConverter<bfloat16_weight> {
+  bfloat16_weight operator()(float src) const {
+    return {cpu_float2bfloat16(src)};
+  }
+};
+
+using PackedGemmMatrixBF16 = PackedGemmMatrixB<bfloat16_weight>;
+
+extern template void cblas_gemm_compute<bfloat16_weight>(
+    const matrix_op_t transa,
+    const int m,
+    const float* A,
+    const PackedGemmMatrixBF16& Bp,
+    const float beta,
+    float* C,
+    int thread_id,
+    int num_threads);
+
+} // namespace fbgemm
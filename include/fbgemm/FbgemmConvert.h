@@ -149,6 +149,64 @@ Float16ToFloat_avx2(const float16* src, float* dst, size_t size);
 FBGEMM_API void
 Float16ToFloat_avx512(const float16* src, float* dst, size_t size);
 
+/**
+ * @brief Transform all entries in a matrix from fp32 to float16 with
+ * stochastic rounding: every value is rounded up with the probability of its
+ * distance to the float16 value below, so that the rounding is unbiased. The
+ * random numbers come from a per thread xoshiro128++ generator: reference
+ * implementation.
+ */
+FBGEMM_API void FloatToFloat16StochasticRounding_ref(
+    const float* src,
+    float16* dst,
+    size_t size);
+
+/**
+ * @brief Transform all entries in a matrix from fp32 to float16 with
+ * stochastic rounding: simd implementation.
+ */
+FBGEMM_API void FloatToFloat16StochasticRounding_simd(
+    const float* src,
+    float16* dst,
+    size_t size);
+
+/**
+ * @brief AVX2 implementation to convert fp32 numbers to fp16 numbers with
+ * stochastic rounding.
+ */
+FBGEMM_API void FloatToFloat16StochasticRounding_avx2(
+    const float* src,
+    float16* dst,
+    size_t size);
+
+/**
+ * @brief Transform all entries in a matrix from fp32 to bfloat16 with
+ * stochastic rounding, as FloatToFloat16StochasticRounding_ref: reference
+ * implementation.
+ */
+FBGEMM_API void FloatToBfloat16StochasticRounding_ref(
+    const float* src,
+    bfloat16* dst,
+    size_t size);
+
+/**
+ * @brief Transform all entries in a matrix from fp32 to bfloat16 with
+ * stochastic rounding: simd implementation.
+ */
+FBGEMM_API void FloatToBfloat16StochasticRounding_simd(
+    const float* src,
+    bfloat16* dst,
+    size_t size);
+
+/**
+ * @brief AVX2 implementation to convert fp32 numbers to bf16 numbers with
+ * stochastic rounding.
+ */
+FBGEMM_API void FloatToBfloat16StochasticRounding_avx2(
+    const float* src,
+    bfloat16* dst,
+    size_t size);
+
 /**
  * @brief Transform all entries in a matrix from fp32 to float16 and back to
  * fp32.
@@ -180,4 +238,73 @@ FBGEMM_API void Float8ToFloat_ref(
     int exponent_bits,
     int exponent_bias);
 
+/**
+ * @brief Transform all entries in a matrix from fp32 to float8 with the
+ * given number of exponent bits (4 for e4m3, 5 for e5m2) and exponent bias,
+ * as FloatToFloat8_ref: simd implementation. Each of the num_threads threads
+ * converts the thread_id-th part of the matrix.
+ */
+FBGEMM_API void FloatToFloat8_simd(
+    const float* src,
+    uint8_t* dst,
+    size_t size,
+    int exponent_bits,
+    int exponent_bias,
+    int thread_id = 0,
+    int num_threads = 1);
+
+/**
+ * @brief Transform all entries in a matrix from float8 to fp32 as
+ * Float8ToFloat_ref: simd implementation. Each of the num_threads threads
+ * converts the thread_id-th part of the matrix.
+ */
+FBGEMM_API void Float8ToFloat_simd(
+    const uint8_t* src,
+    float* dst,
+    size_t size,
+    int exponent_bits,
+    int exponent_bias,
+    int thread_id = 0,
+    int num_threads = 1);
+
+/**
+ * @brief AVX2 implementation to convert fp32 numbers to float8 numbers.
+ */
+FBGEMM_API void FloatToFloat8_avx2(
+    const float* src,
+    uint8_t* dst,
+    size_t size,
+    int exponent_bits,
+    int exponent_bias);
+
+/**
+ * @brief AVX512 implementation to convert fp32 numbers to float8 numbers.
+ */
+FBGEMM_API void FloatToFloat8_avx512(
+    const float* src,
+    uint8_t* dst,
+    size_t size,
+    int exponent_bits,
+    int exponent_bias);
+
+/**
+ * @brief AVX2 implementation to convert float8 numbers to fp32 numbers.
+ */
+FBGEMM_API void Float8ToFloat_avx2(
+    const uint8_t* src,
+    float* dst,
+    size_t size,
+    int exponent_bits,
+    int exponent_bias);
+
+/**
+ * @brief AVX512 implementation to convert float8 numbers to fp32 numbers.
+ */
+FBGEMM_API void Float8ToFloat_avx512(
+    const uint8_t* src,
+    float* dst,
+    size_t size,
+    int exponent_bits,
+    int exponent_bias);
+
 } // namespace fbgemm
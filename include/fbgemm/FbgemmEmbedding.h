@@ -9,8 +9,10 @@
 #pragma once
 #include <cstdint>
 #include <functional>
+#include <string>
 
 #include "fbgemm/FbgemmBuild.h"
+#include "fbgemm/Utils.h"
 
 namespace fbgemm {
 
@@ -49,6 +51,69 @@ class EmbeddingSpMDMKernelSignature {
       OutType* out)>;
 };
 
+/**
+ * Pass as prefetch to the GenerateEmbeddingSpMDM* functions to use the
+ * prefetch distance tuned for the block size, bit rate and instruction set,
+ * see getEmbeddingPrefetchDistance().
+ */
+constexpr int kEmbeddingPrefetchTuned = -1;
+
+/**
+ * Records the best prefetch distance (in rows, 0 disables prefetching) for
+ * kernels with the given block size and bit rate (32 for float, 16 for
+ * float16, 8 for fused 8-bit and 4 or 2 for fused n-bit rows) on isa.
+ */
+FBGEMM_API void setEmbeddingPrefetchDistance(
+    inst_set_t isa,
+    int bit_rate,
+    std::int64_t block_size,
+    int prefetch);
+
+/**
+ * @return The distance recorded for the largest tuned block size not above
+ *         block_size (or the smallest tuned one), 16 if nothing is tuned for
+ *         isa and bit_rate. The table is initialized from the file named by
+ *         the FBGEMM_EMBEDDING_PREFETCH_TABLE environment variable, if set.
+ */
+FBGEMM_API int getEmbeddingPrefetchDistance(
+    inst_set_t isa,
+    int bit_rate,
+    std::int64_t block_size);
+
+/**
+ * Adds the entries of a table written by EmbeddingSpMDMTunableBenchmark: one
+ * "ISA bit_rate block_size prefetch" entry per line, with ISA spelled as in
+ * FBGEMM_ENABLE_INSTRUCTIONS. Lines starting with # are ignored.
+ *
+ * @return false if the file cannot be read or has a malformed line
+ */
+FBGEMM_API bool loadEmbeddingPrefetchTable(const std::string& path);
+
+/**
+ * Sets how many indices of the next table the CPU table batched embedding
+ * operators prefetch the rows of before pooling a table (0, the default,
+ * disables it). The initial value is read from the
+ * FBGEMM_EMBEDDING_CROSS_TABLE_PREFETCH environment variable, if set.
+ */
+FBGEMM_API void setEmbeddingCrossTablePrefetch(int num_indices);
+
+FBGEMM_API int getEmbeddingCrossTablePrefetch();
+
+/**
+ * Prefetches into the cache every cache line of the rows of num_rows rows of
+ * row_bytes bytes each from weights addressed by indices[0, num_indices).
+ * Indices out of [0, num_rows) are skipped.
+ *
+ * @tparam IndexType can be int32_t or int64_t
+ */
+template <typename IndexType>
+FBGEMM_API void prefetchEmbeddingRows(
+    const std::uint8_t* weights,
+    std::int64_t num_rows,
+    std::int64_t row_bytes,
+    const IndexType* indices,
+    std::int64_t num_indices);
+
 /**
  * @tparam InType can be float, float16, or uint8_t
  * @tparam IndexType can be int32_t or int64_t
@@ -116,6 +181,36 @@ GenerateEmbeddingSpMDMWithStrides(
     bool is_bf16_out = false,
     bool is_bf16_in = false);
 
+/**
+ * Weighted (or plain) sum of bfloat16 rows computed with the AVX512-BF16
+ * dot product instruction, two rows per instruction. The weights are rounded
+ * to bfloat16 and pairs of rows are added before being accumulated, so the
+ * results may differ slightly from GenerateEmbeddingSpMDM with
+ * is_bf16_in = true, which this falls back to on CPUs without AVX512-BF16.
+ *
+ * @param input_stride If -1, input_stride is same as block_size
+ * @param output_stride If -1, output_stride is same as block_size
+ */
+template <
+    typename IndexType,
+    typename OffsetType = std::int32_t,
+    typename OutType = float>
+FBGEMM_API typename EmbeddingSpMDMKernelSignature<
+    std::uint16_t,
+    IndexType,
+    OffsetType,
+    OutType>::Type
+GenerateEmbeddingSpMDMBf16Dot(
+    const std::int64_t block_size,
+    bool has_weight,
+    bool normalize_by_lengths,
+    int prefetch = 16,
+    bool is_weight_positional = false,
+    bool use_offsets = true,
+    std::int64_t output_stride = -1,
+    std::int64_t input_stride = -1,
+    bool is_bf16_out = false);
+
 /**
  * @tparam IndexType can be int32_t or int64_t
  * @tparam OffsetType can be int32_t or int64_t
@@ -171,6 +266,41 @@ GenerateEmbeddingSpMDMNBitWithStrides(
     bool scale_bias_last = true,
     bool is_bf16_out = false);
 
+/**
+ * Same as GenerateEmbeddingSpMDMNBitWithStrides for the rows of
+ * FloatOrHalfToFusedNBitGroupwiseQuantizedSBHalf, where every group_size
+ * elements have their own fp16 scale and bias, stored after the packed row.
+ * With group_size == block_size the rows are rowwise ones and the JIT kernel
+ * is used.
+ *
+ * @param group_size must divide block_size and be a multiple of
+ *                   8 / bit_rate
+ * @param input_stride in Bytes. If -1, input_stride is same as
+ *                     block_size / num_elem_per_byte +
+ *                     block_size / group_size * 2 * sizeof(float16)
+ */
+template <
+    typename IndexType,
+    typename OffsetType = std::int32_t,
+    typename OutType = float>
+FBGEMM_API typename EmbeddingSpMDMKernelSignature<
+    std::uint8_t,
+    IndexType,
+    OffsetType,
+    OutType>::Type
+GenerateEmbeddingSpMDMNBitGroupwise(
+    int bit_rate,
+    int group_size,
+    const std::int64_t block_size,
+    bool has_weight,
+    bool normalize_by_lengths,
+    int prefetch = 16,
+    bool is_weight_positional = false,
+    bool use_offsets = true,
+    std::int64_t output_stride = -1,
+    std::int64_t input_stride = -1,
+    bool is_bf16_out = false);
+
 /**
  * @param output_stride If -1, output_stride is same as block_size
  * @param input_stride in Bytes. If -1, input_stride is same as
@@ -200,6 +330,71 @@ GenerateEmbeddingSpMDMFP8WithStrides(
     int exponent_bias = 7,
     bool is_bf16_out = false);
 
+/**
+ * Pools fused 8-bit or n-bit rowwise quantized rows and writes every pooled
+ * row quantized to 8 bits with its float scale and bias last, as
+ * FloatOrHalfToFused8BitRowwiseQuantizedSBFloat would, so the float rows
+ * never leave the cache. Each output row is block_size + 2 * sizeof(float)
+ * bytes.
+ *
+ * @param bit_rate of the input rows: 8 for rows of GenerateEmbeddingSpMDM
+ *                 with uint8_t input, 4 or 2 for rows of
+ *                 GenerateEmbeddingSpMDMNBit
+ * @param output_stride in Bytes. If -1, output_stride is same as
+ *                      block_size + 2 * sizeof(float)
+ * @param input_stride in Bytes. If -1, rows are packed without padding
+ * @param scale_bias_last if false, scale and bias appear at the beginning
+ *        of each input row and are in fp16, as in FBGEMM_GPU TBE
+ */
+template <typename IndexType, typename OffsetType = std::int32_t>
+FBGEMM_API typename EmbeddingSpMDMKernelSignature<
+    std::uint8_t,
+    IndexType,
+    OffsetType,
+    std::uint8_t>::Type
+GenerateEmbeddingSpMDMRowwiseQuantizedOut(
+    int bit_rate,
+    const std::int64_t block_size,
+    bool has_weight,
+    bool normalize_by_lengths,
+    int prefetch = 16,
+    bool is_weight_positional = false,
+    bool use_offsets = true,
+    std::int64_t output_stride = -1,
+    std::int64_t input_stride = -1,
+    bool scale_bias_last = true);
+
+/**
+ * Pools fused 8-bit or n-bit rowwise quantized rows into float for batches
+ * where many bags look up the same rows: the indices of the whole batch are
+ * deduplicated with radix_sort_unique_with_counts, every distinct row is
+ * dequantized once into a scratch buffer and the bags are pooled from there.
+ * This only pays off when rows repeat across the batch, as the sort and the
+ * dequantization pass are extra work otherwise.
+ *
+ * @param bit_rate of the input rows: 8 for rows of GenerateEmbeddingSpMDM
+ *                 with uint8_t input, 4 or 2 for rows of
+ *                 GenerateEmbeddingSpMDMNBit
+ * @param output_stride If -1, output_stride is same as block_size
+ * @param input_stride in Bytes. If -1, rows are packed without padding
+ */
+template <typename IndexType, typename OffsetType = std::int32_t>
+FBGEMM_API typename EmbeddingSpMDMKernelSignature<
+    std::uint8_t,
+    IndexType,
+    OffsetType,
+    float>::Type
+GenerateEmbeddingSpMDMDedup(
+    int bit_rate,
+    const std::int64_t block_size,
+    bool has_weight,
+    bool normalize_by_lengths,
+    int prefetch = 16,
+    bool is_weight_positional = false,
+    bool use_offsets = true,
+    std::int64_t output_stride = -1,
+    std::int64_t input_stride = -1);
+
 template <
     typename InType,
     typename IndexType,
@@ -260,16 +455,17 @@ GenerateEmbeddingSpMDMNBitRowWiseSparse(
     bool use_offsets = true);
 
 /**
+ * @tparam DataType can be float or float16 (uint16_t, bfloat16 if is_bf16)
  * @return The number of rows processed. If smaller than num_rows, an error
  *         must have happened at the last row processed.
  */
-template <typename IndexType>
+template <typename IndexType, typename DataType = float>
 class SparseAdaGradSignature {
  public:
   using Type = std::function<int(
       int num_rows, // number of rows reading
       std::uint64_t param_size, // total number of parameters
-      float* w, // input/output parameters
+      DataType* w, // input/output parameters
       const float* g, // input gradients
       float* h, // input/output momentums
       const IndexType* indices, // indices of each row
@@ -283,13 +479,20 @@ class SparseAdaGradSignature {
       std::int64_t counter_halflife)>; // frequency adjust happens only after
 };
 
-template <typename IndexType>
-FBGEMM_API typename SparseAdaGradSignature<IndexType>::Type
+/**
+ * @param use_stochastic_rounding round 16 bit weights stochastically instead
+ *        of to nearest, ignored for float weights
+ * @param is_bf16 16 bit weights are bfloat16 instead of float16
+ */
+template <typename IndexType, typename DataType = float>
+FBGEMM_API typename SparseAdaGradSignature<IndexType, DataType>::Type
 GenerateSparseAdaGrad(
     int block_size, // number of parameters per row
     bool rowwise = false,
     int prefetch = 16,
-    bool use_weight_decay = false);
+    bool use_weight_decay = false,
+    bool use_stochastic_rounding = true,
+    bool is_bf16 = false);
 
 // RowWiseSparseAdaGrad fused with SLS gradient
 // Weights can be either float or float16
@@ -314,6 +517,17 @@ class RowWiseSparseAdaGradFusedSignature {
 
 /**
  * @param grad_stride If -1, grad_stride is same as block size
+ * @param deduplicate_indices If true, the gradients of all the occurrences
+ *        of a row are summed and the row is updated once with the sum,
+ *        instead of once per occurrence. A call then never updates a row
+ *        twice, and returns false before any update on out of bound indices
+ *        or lengths.
+ * @param num_threads If not 1, the rows are split into num_threads ranges
+ *        updated by as many tasks of the FBGEMM thread pool, <= 0 for
+ *        one per thread of the pool. Each row is
+ *        updated by one thread in the order of its indices, which gives the
+ *        result of a single thread up to stochastic rounding. Out of bound
+ *        indices or lengths are then rejected before any update too.
  */
 template <
     typename IndexType,
@@ -328,8 +542,304 @@ GenerateRowWiseSparseAdaGradFused(
     int prefetch = 16,
     bool use_offsets = true,
     bool use_stochastic_rounding = true,
+    int grad_stride = -1,
+    bool deduplicate_indices = false,
+    int num_threads = 1);
+
+// Element-wise SparseAdaGrad fused with SLS gradient: every row indexed by
+// bag m is updated with the gradient of output m, without expanding the
+// gradients per index first. h holds one momentum per parameter.
+// Weights can be either float or float16, float16 weights are rounded to
+// nearest.
+template <
+    typename IndexType,
+    typename OffsetType = std::int32_t,
+    typename DataType = float>
+class SparseAdaGradFusedSignature {
+ public:
+  using Type = std::function<bool(
+      std::int64_t output_size,
+      std::int64_t index_size,
+      std::int64_t data_size, // number of rows in w
+      DataType* w, // input/output parameters
+      const float* g, // input gradients
+      float* h, // input/output momentums
+      const IndexType* indices, // indices of each row
+      const OffsetType* offsets_or_lengths,
+      float epsilon,
+      float lr)>;
+};
+
+/**
+ * @param grad_stride If -1, grad_stride is same as block size
+ */
+template <
+    typename IndexType,
+    typename OffsetType = std::int32_t,
+    typename DataType = float>
+FBGEMM_API typename SparseAdaGradFusedSignature<
+    IndexType,
+    OffsetType,
+    DataType>::Type
+GenerateSparseAdaGradFused(
+    int block_size, // number of parameters per row
+    int prefetch = 16,
+    bool use_offsets = true,
     int grad_stride = -1);
 
+// Sparse optimizers fused with SLS gradient, with the semantics of the
+// FBGEMM_GPU optimizers of the same name. As for the fused AdaGrad kernels,
+// a row indexed several times is updated once for each time, with the
+// gradient of the output of its bag. Weights can be either float or
+// float16, float16 weights are rounded to nearest.
+//
+// Adam:
+//   m1 = beta1 * m1 + (1 - beta1) * g
+//   m2 = beta2 * m2 + (1 - beta2) * g * g
+//   r = m1 / (1 - beta1^iter) / (sqrt(m2 / (1 - beta2^iter)) + eps)
+//       + weight_decay * w
+//   w -= learning_rate * r
+// LAMB scales the Adam step r of each row by the trust ratio
+// ||w|| / ||r||, or 1 when either norm is zero. With rowwise (partial
+// rowwise Adam and LAMB), momentum2 holds one value per row, updated with
+// the mean of g * g over the row.
+template <
+    typename IndexType,
+    typename OffsetType = std::int32_t,
+    typename DataType = float>
+class SparseAdamFusedSignature {
+ public:
+  using Type = std::function<bool(
+      std::int64_t output_size,
+      std::int64_t index_size,
+      std::int64_t data_size, // number of rows in w
+      DataType* w, // input/output parameters
+      const float* g, // input gradients
+      float* momentum1, // input/output first moments, one per parameter
+      float* momentum2, // input/output second moments
+      const IndexType* indices, // indices of each row
+      const OffsetType* offsets_or_lengths,
+      float learning_rate,
+      float eps,
+      float beta1,
+      float beta2,
+      float weight_decay,
+      std::int64_t iter)>; // step count starting at 1 for bias correction
+};
+
+/**
+ * @param rowwise partial rowwise Adam, with one momentum2 per row
+ * @param grad_stride If -1, grad_stride is same as block size
+ */
+template <
+    typename IndexType,
+    typename OffsetType = std::int32_t,
+    typename DataType = float>
+FBGEMM_API
+    typename SparseAdamFusedSignature<IndexType, OffsetType, DataType>::Type
+    GenerateSparseAdamFused(
+        int block_size, // number of parameters per row
+        bool rowwise = false,
+        int prefetch = 16,
+        bool use_offsets = true,
+        int grad_stride = -1);
+
+/**
+ * @param rowwise partial rowwise LAMB, with one momentum2 per row
+ * @param grad_stride If -1, grad_stride is same as block size
+ */
+template <
+    typename IndexType,
+    typename OffsetType = std::int32_t,
+    typename DataType = float>
+FBGEMM_API
+    typename SparseAdamFusedSignature<IndexType, OffsetType, DataType>::Type
+    GenerateSparseLambFused(
+        int block_size, // number of parameters per row
+        bool rowwise = false,
+        int prefetch = 16,
+        bool use_offsets = true,
+        int grad_stride = -1);
+
+// LARS SGD, whose learning rate is scaled for every row by its norms:
+//   lr' = learning_rate * eta * ||w|| / (||g|| + weight_decay * ||w||),
+//         or learning_rate when either norm is zero
+//   m1 = momentum * m1 + lr' * (g + weight_decay * w)
+//   w -= m1
+template <
+    typename IndexType,
+    typename OffsetType = std::int32_t,
+    typename DataType = float>
+class SparseLarsSGDFusedSignature {
+ public:
+  using Type = std::function<bool(
+      std::int64_t output_size,
+      std::int64_t index_size,
+      std::int64_t data_size, // number of rows in w
+      DataType* w, // input/output parameters
+      const float* g, // input gradients
+      float* momentum1, // input/output momentums, one per parameter
+      const IndexType* indices, // indices of each row
+      const OffsetType* offsets_or_lengths,
+      float learning_rate,
+      float eta,
+      float momentum,
+      float weight_decay)>;
+};
+
+/**
+ * @param grad_stride If -1, grad_stride is same as block size
+ */
+template <
+    typename IndexType,
+    typename OffsetType = std::int32_t,
+    typename DataType = float>
+FBGEMM_API
+    typename SparseLarsSGDFusedSignature<IndexType, OffsetType, DataType>::Type
+    GenerateSparseLarsSGDFused(
+        int block_size, // number of parameters per row
+        int prefetch = 16,
+        bool use_offsets = true,
+        int grad_stride = -1);
+
+/**
+ * One table of a table batched embedding lookup. Rows are laid out as in
+ * table batched embedding (TBE) of FBGEMM_GPU.
+ */
+struct EmbeddingSpMDMTable {
+  const std::uint8_t* weights; // first row of the table
+  std::int64_t num_rows;
+  std::int64_t embedding_dim;
+  // 32 for float, 16 for float16, 8 for fused 8-bit rowwise quantized and
+  // 4 or 2 for fused n-bit rowwise quantized rows
+  int bit_rate;
+  // column of the output where the pooled rows of this table start
+  std::int64_t output_offset;
+  // in Bytes. If -1, rows are packed without padding
+  std::int64_t input_stride = -1;
+};
+
+/**
+ * Pooled embedding lookup over many tables at once, with the TBE layout of
+ * indices, offsets and outputs:
+ *
+ * for t in range(num_tables):
+ *  for b in range(batch_size):
+ *   out[b * output_stride + tables[t].output_offset :][:embedding_dim] =
+ *     pooled rows indices[offsets[t * batch_size + b] :
+ *                         offsets[t * batch_size + b + 1]] of tables[t]
+ *
+ * The bags of all tables are split into num_threads contiguous chunks of
+ * similar memory traffic, so small tables do not leave threads idle. Every
+ * thread calls this function with its thread_id, like fbgemmPacked.
+ *
+ * @tparam IndexType can be int32_t or int64_t
+ * @tparam OffsetType can be int32_t or int64_t
+ * @tparam OutType can be float or float16 (uint16_t, bfloat16 if is_bf16_out)
+ * @param offsets num_tables * batch_size + 1 entries
+ * @param weights optional per sample weights, indexed like indices
+ * @param scale_bias_last if false, scale and bias appear at the beginning
+ *        of each quantized row and are in fp16, as in FBGEMM_GPU TBE
+ * @return false if any index of the chunk of thread_id is out of bounds
+ */
+template <
+    typename IndexType,
+    typename OffsetType = std::int32_t,
+    typename OutType = float>
+FBGEMM_API bool EmbeddingSpMDMTableBatched(
+    int num_tables,
+    const EmbeddingSpMDMTable* tables,
+    std::int64_t batch_size,
+    const IndexType* indices,
+    const OffsetType* offsets,
+    const float* weights, // optional, can be null for non-weighted sum
+    bool normalize_by_lengths,
+    OutType* out,
+    std::int64_t output_stride,
+    int thread_id = 0,
+    int num_threads = 1,
+    bool scale_bias_last = false,
+    bool is_bf16_out = false,
+    int prefetch = 16);
+
+/**
+ * Pooled embedding lookup over many tables followed by the dot product
+ * interaction of DLRM, without materializing the batch_size x F x D pooled
+ * tensor. Feature 0 of sample b is the dense row dense[b * D :][:D] if dense
+ * is given, followed by the pooled rows of the tables in order:
+ *
+ * for b in range(batch_size):
+ *   out[b * output_stride :] = dense row of b (if dense is given), then
+ *     dot(x_i, x_j) for i in range(1, F) for j in range(i)
+ *
+ * The rows of a few samples at a time are pooled into a per-thread tile that
+ * stays in cache for the dot products. Samples are split evenly between the
+ * num_threads threads, each calling this function with its thread_id.
+ *
+ * @param tables all must have the same embedding_dim D; the output_offset of
+ *               the tables is not used
+ * @param offsets num_tables * batch_size + 1 entries, as in
+ *                EmbeddingSpMDMTableBatched
+ * @param dense optional batch_size x D rows, e.g. the bottom MLP output
+ * @param output_stride If -1, output_stride is same as
+ *                      (dense ? D : 0) + F * (F - 1) / 2
+ * @return false if any index of the samples of thread_id is out of bounds
+ */
+template <typename IndexType, typename OffsetType = std::int32_t>
+FBGEMM_API bool EmbeddingSpMDMDotInteraction(
+    int num_tables,
+    const EmbeddingSpMDMTable* tables,
+    std::int64_t batch_size,
+    const IndexType* indices,
+    const OffsetType* offsets,
+    const float* weights, // optional, can be null for non-weighted sum
+    bool normalize_by_lengths,
+    const float* dense,
+    float* out,
+    std::int64_t output_stride = -1,
+    int thread_id = 0,
+    int num_threads = 1,
+    bool scale_bias_last = false,
+    int prefetch = 16);
+
+/**
+ * Runs a kernel returned by GenerateEmbeddingSpMDM* on num_threads threads.
+ * The bags are split into contiguous ranges with about the same number of
+ * indices plus bags, so skewed bag lengths do not leave threads idle.
+ *
+ * @param kernel must have been generated with use_offsets = true
+ * @param output_stride the output_stride the kernel was generated with, or
+ *                      its block_size
+ * @param num_threads number of ranges; if <= 0, fbgemmGetNumThreads()
+ * @param parallel_for runs the ranges; if empty, the FBGEMM thread pool
+ *                     (see fbgemmSetThreadPool)
+ * @param is_weight_positional must match the value used to generate kernel
+ * @return false if any index is out of bounds
+ */
+template <
+    typename InType,
+    typename IndexType,
+    typename OffsetType = std::int32_t,
+    typename OutType = float>
+FBGEMM_API bool EmbeddingSpMDMParallel(
+    const typename EmbeddingSpMDMKernelSignature<
+        InType,
+        IndexType,
+        OffsetType,
+        OutType>::Type& kernel,
+    std::int64_t output_stride,
+    std::int64_t output_size,
+    std::int64_t index_size,
+    std::int64_t data_size,
+    const InType* input,
+    const IndexType* indices,
+    const OffsetType* offsets,
+    const float* weights, // optional, can be null for non-weighted sum
+    OutType* out,
+    int num_threads = 0,
+    const ParallelTasksExecutor& parallel_for = nullptr,
+    bool is_weight_positional = false);
+
 namespace internal {
 // Specialization for block size 1 internally called by GenerateEmbeddingSpMDM
 template <typename InType, typename IndexType, typename OffsetType>
@@ -347,6 +857,141 @@ FBGEMM_API bool EmbeddingSpMDMBlockSize1_(
     bool use_offsets = true,
     bool is_bf16 = false);
 
+// Called by GenerateEmbeddingSpMDMBf16Dot on CPUs with AVX512-BF16
+template <typename IndexType, typename OffsetType, typename OutType>
+FBGEMM_API bool EmbeddingSpMDMBf16Dot_avx512bf16(
+    const std::int64_t block_size,
+    const std::int64_t output_size,
+    const std::int64_t index_size,
+    const std::int64_t data_size,
+    const std::uint16_t* input,
+    const IndexType* indices,
+    const OffsetType* offsets_or_lengths,
+    const float* weights, // optional, can be null for non-weighted sum
+    bool normalize_by_lengths,
+    OutType* out,
+    bool is_weight_positional,
+    bool use_offsets,
+    std::int64_t output_stride,
+    std::int64_t input_stride,
+    bool is_bf16_out,
+    int prefetch);
+
+// Called by GenerateEmbeddingSpMDMFP8WithStrides on CPUs with AVX512
+template <typename IndexType, typename OffsetType, typename OutType>
+FBGEMM_API bool EmbeddingSpMDMFP8_avx512(
+    const std::int64_t block_size,
+    const std::int64_t output_size,
+    const std::int64_t index_size,
+    const std::int64_t data_size,
+    const std::uint8_t* input,
+    const IndexType* indices,
+    const OffsetType* offsets_or_lengths,
+    const float* weights, // optional, can be null for non-weighted sum
+    bool normalize_by_lengths,
+    OutType* out,
+    bool is_weight_positional,
+    bool use_offsets,
+    std::int64_t output_stride,
+    std::int64_t input_stride,
+    int exponent_bits,
+    int exponent_bias,
+    bool is_bf16_out,
+    int prefetch);
+
+// Called by GenerateSparseAdaGrad for 16 bit weights on CPUs with AVX2
+template <typename IndexType>
+FBGEMM_API int SparseAdaGrad16Bit_avx2(
+    int num_rows,
+    int block_size,
+    std::uint64_t param_size,
+    std::uint16_t* w,
+    const float* g,
+    float* h,
+    const IndexType* indices,
+    float epsilon,
+    float lr,
+    bool rowwise,
+    bool use_stochastic_rounding,
+    bool is_bf16,
+    float weight_decay,
+    const double* counter,
+    std::int64_t counter_halflife,
+    int prefetch);
+
+// Called by GenerateSparseAdaGradFused on CPUs with AVX2
+template <typename DataType, typename IndexType, typename OffsetType>
+FBGEMM_API bool SparseAdaGradFused_avx2(
+    std::int64_t block_size,
+    std::int64_t output_size,
+    std::int64_t index_size,
+    std::int64_t data_size,
+    DataType* w,
+    const float* g,
+    float* h,
+    const IndexType* indices,
+    const OffsetType* offsets_or_lengths,
+    float epsilon,
+    float lr,
+    bool use_offsets,
+    std::int64_t grad_stride,
+    int prefetch);
+
+// Called by GenerateSparseAdamFused and GenerateSparseLambFused on CPUs
+// with AVX2
+template <typename DataType, typename IndexType, typename OffsetType>
+FBGEMM_API bool SparseAdamFused_avx2(
+    bool lamb,
+    bool rowwise,
+    std::int64_t block_size,
+    std::int64_t output_size,
+    std::int64_t index_size,
+    std::int64_t data_size,
+    DataType* w,
+    const float* g,
+    float* momentum1,
+    float* momentum2,
+    const IndexType* indices,
+    const OffsetType* offsets_or_lengths,
+    float learning_rate,
+    float eps,
+    float beta1,
+    float beta2,
+    float weight_decay,
+    std::int64_t iter,
+    bool use_offsets,
+    std::int64_t grad_stride,
+    int prefetch);
+
+// Called by GenerateSparseLarsSGDFused on CPUs with AVX2
+template <typename DataType, typename IndexType, typename OffsetType>
+FBGEMM_API bool SparseLarsSGDFused_avx2(
+    std::int64_t block_size,
+    std::int64_t output_size,
+    std::int64_t index_size,
+    std::int64_t data_size,
+    DataType* w,
+    const float* g,
+    float* momentum1,
+    const IndexType* indices,
+    const OffsetType* offsets_or_lengths,
+    float learning_rate,
+    float eta,
+    float momentum,
+    float weight_decay,
+    bool use_offsets,
+    std::int64_t grad_stride,
+    int prefetch);
+
+// Called by pruned_hashmap_grouped_lookup on CPUs with AVX2, for the
+// index_size indices of one table of num_groups groups
+FBGEMM_API void pruned_hashmap_grouped_lookup_avx2(
+    std::int64_t index_size,
+    const std::int32_t* indices,
+    const std::int32_t* groups,
+    std::int64_t num_groups,
+    std::int32_t* dense_indices);
+
 template <typename IndexType, bool HAS_WEIGHTS>
 void compressed_indices_remap_avx512(
     std::int32_t offsets_numel,
@@ -358,6 +1003,44 @@ void compressed_indices_remap_avx512(
     IndexType* out_offsets,
     float* out_weights);
 
+// Called by compressed_indices_remap on CPUs with AVX2 but not AVX512
+template <typename IndexType, bool HAS_WEIGHTS>
+void compressed_indices_remap_avx2(
+    std::int32_t offsets_numel,
+    const IndexType* indices,
+    const int32_t* compressed_indices_mapping,
+    const IndexType* offsets,
+    const float* weights, // optional, can be null,
+    IndexType* out_indices,
+    IndexType* out_offsets,
+    float* out_weights);
+
+// Whether the library has a kernel compiled ahead of time for the embedding
+// dim, one of FBGEMM_PRECOMPILED_EMBEDDING_DIMS at build time
+FBGEMM_API bool isPrecompiledEmbeddingDim(std::int64_t block_size);
+
+// Called by GenerateEmbeddingSpMDM and GenerateEmbeddingSpMDMNBit on CPUs
+// with AVX2 when asmjit is disabled. Rows are float for bit_rate 32 and fused
+// 8, 4 or 2-bit otherwise, and the strides are those of the rows. Returns an
+// empty function when block_size is not precompiled.
+template <typename InType, typename IndexType, typename OffsetType>
+FBGEMM_API typename EmbeddingSpMDMKernelSignature<
+    InType,
+    IndexType,
+    OffsetType,
+    float>::Type
+GenerateEmbeddingSpMDMPrecompiled_avx2(
+    int bit_rate,
+    std::int64_t block_size,
+    bool has_weight,
+    bool normalize_by_lengths,
+    int prefetch,
+    bool is_weight_positional,
+    bool use_offsets,
+    std::int64_t output_stride,
+    std::int64_t input_stride,
+    bool scale_bias_last);
+
 } // namespace internal
 
 template <typename IndexType>
@@ -371,4 +1054,85 @@ FBGEMM_API void compressed_indices_remap(
     IndexType* out_offsets,
     float* out_weights);
 
+/**
+ * @brief Sorts the indices of each bag by row, an optional pass before
+ * pooling, so that the kernels read the rows of a bag in the order of their
+ * addresses and the hardware prefetchers can follow them on large tables.
+ * The pooled sums only change by the order of the float additions.
+ *
+ * The weights, if any, are permuted with their indices. Positional weights
+ * are expanded to one weight per index, so the kernel is then generated with
+ * is_weight_positional = false. out_indices may be indices, and out_weights
+ * may be weights unless they are positional. Bags past index_size are left
+ * unsorted for the kernel to reject.
+ */
+template <typename IndexType, typename OffsetType>
+FBGEMM_API void EmbeddingSortIndicesWithinBags(
+    std::int64_t output_size,
+    std::int64_t index_size,
+    const IndexType* indices,
+    const OffsetType* offsets_or_lengths,
+    const float* weights, // optional, can be null
+    IndexType* out_indices,
+    float* out_weights, // index_size weights if weights is not null
+    bool is_weight_positional = false,
+    bool use_offsets = true);
+
+/**
+ * @brief Map of the pruned rows of TBE inference tables, the grouped
+ * counterpart of the (key, value) table of fbgemm_gpu pruned_hashmap_insert.
+ *
+ * Each table holds a power of two number of groups of
+ * kPrunedHashMapGroupSize slots: the keys of the group followed by their
+ * values, 64 bytes in total. A key hashes to a group whose keys are compared
+ * at once, and probing moves on to the next group only when the group is
+ * full. The empty slots of a group, key and value kPrunedHashMapEmpty, come
+ * after its used slots.
+ */
+constexpr int kPrunedHashMapGroupSize = 8;
+constexpr std::int32_t kPrunedHashMapEmpty = -1;
+
+/**
+ * @brief Computes the offsets in groups of the num_tables + 1 table
+ * boundaries from the slot offsets of pruned_hashmap_insert
+ * (hash_table_offsets). A table gets at least as many slots as before; a
+ * table without slots is not pruned and gets no group.
+ */
+FBGEMM_API void pruned_hashmap_grouped_offsets(
+    int num_tables,
+    const std::int64_t* hash_table_offsets,
+    std::int64_t* group_offsets);
+
+/**
+ * @brief Fills the grouped map from the inputs of pruned_hashmap_insert: the
+ * indices of num_tables * batch_size bags delimited by offsets and their
+ * dense indices, -1 for the rows to prune, which are not inserted.
+ *
+ * @param groups group_offsets[num_tables] * 2 * kPrunedHashMapGroupSize
+ *               values, overwritten
+ * @return false if a table has more distinct kept indices than slots
+ */
+FBGEMM_API bool pruned_hashmap_grouped_build(
+    int num_tables,
+    int batch_size,
+    const std::int32_t* indices,
+    const std::int32_t* dense_indices,
+    const std::int32_t* offsets,
+    const std::int64_t* group_offsets,
+    std::int32_t* groups);
+
+/**
+ * @brief Maps the indices of num_tables * batch_size bags delimited by
+ * offsets to their dense indices, -1 for pruned rows, like
+ * pruned_hashmap_lookup. Indices of tables without groups are copied.
+ */
+FBGEMM_API void pruned_hashmap_grouped_lookup(
+    int num_tables,
+    int batch_size,
+    const std::int32_t* indices,
+    const std::int32_t* offsets,
+    const std::int32_t* groups,
+    const std::int64_t* group_offsets,
+    std::int32_t* dense_indices);
+
 } // namespace fbgemm
@@ -56,4 +56,21 @@ extern template void cblas_gemm_compute<float16>(
     int thread_id,
     int num_threads);
 
+// Same as cblas_gemm_compute, but on CPUs with AVX512-FP16 (and with Bp
+// packed for AVX512) A is rounded to fp16 and multiplied and accumulated in
+// fp16 over each Bp.blockRowSize() rows of B, with fp32 sums across those
+// blocks, for about twice the throughput. The sums saturate at the fp16
+// maximum and lose precision with the block size, so this is only for
+// workloads that tolerate it; a smaller brow when packing B bounds the error.
+// Elsewhere this is cblas_gemm_compute.
+FBGEMM_API void cblas_gemm_compute_fp16_acc(
+    const matrix_op_t transa,
+    const int m,
+    const float* A,
+    const PackedGemmMatrixFP16& Bp,
+    const float beta,
+    float* C,
+    int thread_id = 0,
+    int num_threads = 1);
+
 }; // namespace fbgemm
@@ -8,6 +8,7 @@
 
 #pragma once
 
+#include <fbgemm/FbgemmFP16.h>
 #include <fbgemm/FbgemmPackMatrixB.h>
 #include <fbgemm/SimdUtils.h>
 #include <fbgemm/Types.h>
@@ -41,8 +42,22 @@ template <typename T>
 using funcptr_t = void (*)(GemmParams<T>*);
 template <typename T>
 using kernel_array_t = std::array<funcptr_t<T>, 15>;
+// Computes C = A * B + beta * C for column blocks [jb_begin, jb_end) of B and
+// m <= gemv_max_rows rows of A, reading B once with the sums over all of k
+// kept in registers. nullptr where there is no such kernel.
 template <typename T>
-using isa_descriptor = std::tuple<kernel_array_t<T>, partition_array_t>;
+using gemv_funcptr_t = void (*)(
+    int m,
+    const float* A,
+    const PackedGemmMatrixB<T>& Bp,
+    float beta,
+    float* C,
+    int64_t jb_begin,
+    int64_t jb_end);
+constexpr int gemv_max_rows = 4;
+template <typename T>
+using isa_descriptor =
+    std::tuple<kernel_array_t<T>, partition_array_t, gemv_funcptr_t<T>>;
 
 template <typename T>
 extern const isa_descriptor<T>& getIsaHandlers(inst_set_t isa, T);
@@ -51,7 +66,8 @@ void PackA(int nrow, int ncol, const float* from, int ldim, float* to);
 
 // define this to debug fp16 kernel using a reference C implementation
 // #define FBGEMM_FP16_FALLBACK_TO_REF_KERNEL
-#ifdef FBGEMM_USE_REF_KERNEL
+// The float16 and float specializations are only built with it; the
+// bfloat16_weight one is always built.
 template <typename T>
 FBGEMM_API void ref_kernel(
     int kernel_nrows,
@@ -60,23 +76,13 @@ FBGEMM_API void ref_kernel(
     int m_total,
     int n_total,
     int vlen);
-#endif
-
-template <typename T>
-FBGEMM_API void cblas_gemm_compute(
-    const matrix_op_t transa,
-    const int m,
-    const float* A,
-    const PackedGemmMatrixB<T>& Bp,
-    const float beta,
-    float* C,
-    int thread_id = 0,
-    int num_threads = 1);
 
 #if defined(FBGEMM_EXPORTS)
+// cblas_gemm_compute with the kernels of isaHandlers
 // autotuned kernel splits for various cases m = 1:mb_max
 template <typename T>
-void cblas_gemm_compute(
+void cblas_gemm_compute_with_handlers(
+    const isa_descriptor<T>& isaHandlers,
     const matrix_op_t transa,
     const int m,
     const float* A,
@@ -94,20 +100,36 @@ void cblas_gemm_compute(
   assert(transa == matrix_op_t::NoTranspose);
   (void)transa; // Suppress unused variable warning
 
-  const auto iset = fbgemmInstructionSet();
   // private scratchpad storage
   static thread_local std::unique_ptr<std::array<float, 256 * 1024>> scratchpad(
       new std::array<float, 256 * 1024>());
 
-  const auto& isaHandlers = getIsaHandlers<T>(iset, T());
-
   const auto& kernels = std::get<0>(isaHandlers);
   const auto& partition = std::get<1>(isaHandlers);
 
   // constants
   const int n = Bp.numCols(), k = Bp.numRows(), ldc = n;
+#ifndef FBGEMM_USE_REF_KERNEL
+  // For a few rows of A the GEMM is bound by reading B, which the blocked
+  // kernels read once per block of k with few independent sums.
+  const auto gemv = std::get<2>(isaHandlers);
+  if (m <= gemv_max_rows && gemv != nullptr) {
+    int64_t jb_begin, jb_end;
+    fbgemmPartition1D(
+        thread_id,
+        num_threads,
+        (n + Bp.blockColSize() - 1) / Bp.blockColSize(),
+        jb_begin,
+        jb_end);
+    if (jb_begin < jb_end) {
+      gemv(m, A, Bp, beta, C, jb_begin, jb_end);
+    }
+    return;
+  }
+#endif
   const int mb_max = 120;
 #ifdef FBGEMM_USE_REF_KERNEL
+  const auto iset = fbgemmInstructionSet();
   const int kernel_ncol_blocks = Bp.kernelNumColBlocks();
   // By some reason, if packed B is using packing layout for avx2, we just use
   // avx2 even if avx512 is available.
@@ -119,6 +141,7 @@ void cblas_gemm_compute(
       : simd_info<inst_set_t::avx2>::WIDTH_32BIT_ELEMS;
 #else
       simd_info<inst_set_t::avx2>::WIDTH_32BIT_ELEMS;
+  (void)iset;
   (void)kernel_ncol_blocks;
   (void)kernels;
 #endif
@@ -253,6 +276,28 @@ void cblas_gemm_compute(
     }
   }
 }
+
+template <typename T>
+void cblas_gemm_compute(
+    const matrix_op_t transa,
+    const int m,
+    const float* A,
+    const PackedGemmMatrixB<T>& Bp,
+    const float beta,
+    float* C,
+    int thread_id,
+    int num_threads) {
+  cblas_gemm_compute_with_handlers(
+      getIsaHandlers<T>(fbgemmInstructionSet(), T()),
+      transa,
+      m,
+      A,
+      Bp,
+      beta,
+      C,
+      thread_id,
+      num_threads);
+}
 #endif
 
 #undef FBGEMM_USE_REF_KERNEL
@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "fbgemm/Utils.h"
+
+namespace fbgemm {
+
+/**
+ * @brief Packed k x n weight matrix quantized to 4 bits, two values per byte,
+ *        with a scale and zero point per group of rows.
+ *
+ * The k rows are split into `groups` equal groups, which is groupwise
+ * quantization over the input channels of the n x k weight: the layout
+ * QuantizeGroupwise takes with K = n, C = k, X = 1 and G = groups. Quantize
+ * with scales chosen for the 4-bit range; values outside [-8, 7] saturate.
+ *
+ * Within one block of 16 columns each group is stored as blocks of 8 rows,
+ * 4 bytes per column: byte t holds rows t and t + 4 in its low and high
+ * nibble, offset by 8. The rows past the end of a group are padding holding
+ * the zero point.
+ */
+class FBGEMM_API PackBMatrixI4 {
+ public:
+  static constexpr int kBlockRows = 8;
+  static constexpr int kBlockCols = 16;
+
+  /**
+   * @param trans Transpose if smat is n x k (the QuantizeGroupwise layout)
+   *              rather than k x n.
+   * @param ld Leading dimension of smat.
+   * @param scales groups scales.
+   * @param zero_points groups zero points in [-8, 7].
+   */
+  PackBMatrixI4(
+      matrix_op_t trans,
+      std::int32_t nRow,
+      std::int32_t nCol,
+      const std::int8_t* smat,
+      std::int32_t ld,
+      int groups,
+      const float* scales,
+      const std::int32_t* zero_points);
+
+  ~PackBMatrixI4();
+
+  PackBMatrixI4(const PackBMatrixI4&) = delete;
+  PackBMatrixI4& operator=(const PackBMatrixI4&) = delete;
+
+  std::int32_t numRows() const {
+    return nRow_;
+  }
+  std::int32_t numCols() const {
+    return nCol_;
+  }
+  int numGroups() const {
+    return groups_;
+  }
+  std::int32_t groupSize() const {
+    return nRow_ / groups_;
+  }
+  /// Blocks of kBlockRows rows per group.
+  std::int32_t groupBlocks() const {
+    return groupBlocks_;
+  }
+  /// Blocks of kBlockCols columns.
+  std::int32_t colBlocks() const {
+    return (nCol_ + kBlockCols - 1) / kBlockCols;
+  }
+
+  /// The kBlockRows x kBlockCols values of row block rb of group g in column
+  /// block jb, 64 bytes.
+  const std::uint8_t* block(int jb, int g, int rb) const {
+    return buf_ +
+        ((static_cast<std::int64_t>(jb) * groups_ + g) * groupBlocks_ + rb) *
+        (kBlockRows * kBlockCols / 2);
+  }
+
+  /// Quantized value at (r, c) after saturation.
+  std::int8_t value(std::int32_t r, std::int32_t c) const;
+
+  /// Sums of (value - zero point) over the rows of group g, for the
+  /// colBlocks() * kBlockCols columns (zero past n).
+  const std::int32_t* colSums(int g) const {
+    return colSums_.data() + static_cast<std::int64_t>(g) * colBlocks() *
+        kBlockCols;
+  }
+  const float* scales() const {
+    return scales_.data();
+  }
+  const std::int32_t* zeroPoints() const {
+    return zeroPoints_.data();
+  }
+
+  /// Bytes of the packed blocks, the column sums and the quantization
+  /// parameters.
+  std::size_t memoryFootprint() const {
+    return static_cast<std::size_t>(colBlocks()) * groups_ * groupBlocks_ *
+        kBlockRows * kBlockCols / 2 +
+        colSums_.capacity() * sizeof(std::int32_t) +
+        scales_.capacity() * sizeof(float) +
+        zeroPoints_.capacity() * sizeof(std::int32_t);
+  }
+
+ private:
+  std::uint8_t* block(int jb, int g, int rb) {
+    return const_cast<std::uint8_t*>(
+        static_cast<const PackBMatrixI4*>(this)->block(jb, g, rb));
+  }
+
+  std::int32_t nRow_, nCol_;
+  int groups_;
+  std::int32_t groupBlocks_;
+  std::uint8_t* buf_;
+  std::vector<std::int32_t> colSums_;
+  std::vector<float> scales_;
+  std::vector<std::int32_t> zeroPoints_;
+};
+
+/**
+ * @brief C = A_scale * sum over groups g of B.scales()[g] *
+ *        (A - A_zero_point) * (B_g - B.zeroPoints()[g]) + bias.
+ *
+ * A is m x k uint8 row-major and C m x n fp32. bias has n entries and may be
+ * nullptr. Threads split the column blocks of B. Uses AVX512-VNNI when
+ * available.
+ */
+FBGEMM_API void fbgemmU8I4Gemm(
+    int m,
+    const std::uint8_t* A,
+    int lda,
+    std::int32_t A_zero_point,
+    float A_scale,
+    const PackBMatrixI4& B,
+    const float* bias,
+    float* C,
+    int ldc,
+    int thread_id = 0,
+    int num_threads = 1);
+
+namespace internal {
+
+/// fbgemmU8I4Gemm for column blocks [jb_begin, jb_end) of B.
+void U8I4GemmAvx512Vnni(
+    int m,
+    const std::uint8_t* A,
+    int lda,
+    std::int32_t A_zero_point,
+    float A_scale,
+    const PackBMatrixI4& B,
+    const float* bias,
+    float* C,
+    int ldc,
+    int jb_begin,
+    int jb_end);
+
+} // namespace internal
+
+} // namespace fbgemm
@@ -14,6 +14,64 @@
 
 namespace fbgemm {
 
+/**
+ * @brief K x N matrix B of an int64 GEMM packed once into the cache blocks
+ *        the GEMM kernel reads, for multiplying with many A matrices.
+ */
+class FBGEMM_API PackedGemmMatrixI64 {
+ public:
+  /**
+   * @param trans Transpose if B is stored as N x K with leading dimension ldb.
+   */
+  PackedGemmMatrixI64(
+      matrix_op_t trans,
+      int K,
+      int N,
+      const std::int64_t* B,
+      int ldb);
+  ~PackedGemmMatrixI64();
+
+  PackedGemmMatrixI64(const PackedGemmMatrixI64&) = delete;
+  PackedGemmMatrixI64& operator=(const PackedGemmMatrixI64&) = delete;
+
+  int numRows() const {
+    return nrow_;
+  }
+
+  int numCols() const {
+    return ncol_;
+  }
+
+  int blockRowSize() const {
+    return brow_;
+  }
+
+  int blockColSize() const {
+    return bcol_;
+  }
+
+  /**
+   * The blockRowSize() x blockColSize() block at rows kb * blockRowSize() and
+   * columns jb * blockColSize(), with leading dimension blockColSize() and
+   * zeros past the end of B.
+   */
+  const std::int64_t* block(int kb, int jb) const {
+    return pmat_ +
+        (static_cast<std::int64_t>(kb) * nbcol_ + jb) * brow_ * bcol_;
+  }
+
+ private:
+  int nrow_, ncol_;
+  int brow_, bcol_;
+  int nbrow_, nbcol_;
+  std::int64_t* pmat_;
+};
+
+/**
+ * C = op(A) * op(B), or C += op(A) * op(B) if accumulate, with wrap around on
+ * overflow. With num_threads > 1, the threads thread_id of num_threads
+ * compute disjoint blocks of C.
+ */
 FBGEMM_API void cblas_gemm_i64_i64acc(
     matrix_op_t transa,
     matrix_op_t transb,
@@ -26,6 +84,24 @@ FBGEMM_API void cblas_gemm_i64_i64acc(
     int ldb,
     bool accumulate,
     std::int64_t* C,
-    int ldc);
+    int ldc,
+    int thread_id = 0,
+    int num_threads = 1);
+
+/**
+ * cblas_gemm_i64_i64acc with the M x Bp.numRows() op(A) and prepacked B, so
+ * repeated calls with the same B do not pack it again.
+ */
+FBGEMM_API void cblas_gemm_i64_i64acc(
+    matrix_op_t transa,
+    int M,
+    const std::int64_t* A,
+    int lda,
+    const PackedGemmMatrixI64& Bp,
+    bool accumulate,
+    std::int64_t* C,
+    int ldc,
+    int thread_id = 0,
+    int num_threads = 1);
 
 } // namespace fbgemm
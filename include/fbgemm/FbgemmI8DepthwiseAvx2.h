@@ -48,6 +48,14 @@ class FBGEMM_API PackedDepthWiseConvMatrix {
    */
   int addr(int r, int c);
 
+  /**
+   * @brief returns the bytes of pmat_
+   */
+  std::size_t memoryFootprint() const {
+    return static_cast<std::size_t>((OC_ + 31) / 32) *
+        ((kernel_prod_ + 1) / 2 * 2) * 32 * sizeof(std::int8_t);
+  }
+
  private:
   const int OC_; /**< the number of output channels */
   const int kernel_prod_; /** the product of all kernel dims */
@@ -56,8 +64,8 @@ class FBGEMM_API PackedDepthWiseConvMatrix {
 
 /**
  * Depth-wise convolution that results in the same output feature size as the
- * input feature. That is PAD_T = PAD_B = (R - 1) / 2 and PAD_L = PAD_R =
- * (S - 1) / 2. This function also does requantization.
+ * input feature. That is PAD_T = PAD_B = dilation_h * (R - 1) / 2 and PAD_L =
+ * PAD_R = dilation_w * (S - 1) / 2. This function also does requantization.
  * @param col_offsets nullptr if col_offsets are folded into bias
  * @param act_times_w_scale Only used if BIAS_TYPE is float, i.e., bias is
  *                          unquantized.
@@ -83,7 +91,9 @@ FBGEMM_API void depthwise_2d_same_pad(
     bool fuse_relu = false,
     const float* act_times_w_scale = nullptr,
     int thread_id = 0,
-    int num_threads = 1);
+    int num_threads = 1,
+    int dilation_h = 1,
+    int dilation_w = 1);
 
 /**
  * @param col_offsets nullptr if col_offsets are folded into bias
@@ -25,6 +25,9 @@ class FBGEMM_API PackedDirectConvMatrix {
    * @param kernel_prod the product of all kernels. For example, kernel_prod =
    *                    9 for 3x3 conv, and 27 for 3x3x3 conv.
    * @param smat the source unpacked weight in GRS layout
+   *
+   * The packed weight is in W[oc/8][filter_prod][ic/4][8][4] layout with the
+   * input and output channels zero-padded to multiples of 4 and 8.
    */
   PackedDirectConvMatrix(
       int IC_per_G,
@@ -37,6 +40,30 @@ class FBGEMM_API PackedDirectConvMatrix {
     return pmat_;
   }
 
+  /**
+   * @brief The number of input channels rounded up to a multiple of 4.
+   */
+  int ICPadded() const {
+    return (IC_per_G_ + 3) / 4 * 4;
+  }
+
+  /**
+   * @brief The number of output channels rounded up to a multiple of 8.
+   */
+  int OCPadded() const {
+    return (OC_per_G_ + 7) / 8 * 8;
+  }
+
+  void unpack(std::int8_t* origin_buf) const;
+
+  /**
+   * @brief The bytes of the packed weight.
+   */
+  std::size_t memoryFootprint() const {
+    return static_cast<std::size_t>((OC_per_G_ + 31) / 32 * 32) *
+        ((filter_prod_ + 1) / 2 * 2) * ICPadded() * sizeof(std::int8_t);
+  }
+
   const bool& is_first_call() const {
     return first_call;
   }
@@ -54,6 +81,9 @@ class FBGEMM_API PackedDirectConvMatrix {
       int ncols_per_quant_group);
 
  private:
+  int IC_per_G_;
+  int OC_per_G_;
+  int filter_prod_;
   std::int8_t* pmat_; /** packed weight */
   bool first_call{true};
 };
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "fbgemm/FbgemmBuild.h"
+
+namespace fbgemm {
+
+/**
+ * @brief Weights of a dense 3x3 convolution transformed for Winograd
+ *        F(2x2, 3x3).
+ *
+ * The 3x3 filter g of each (output, input) channel pair is transformed to
+ * the 4x4 tile G' g G'^T with G' = 2 G, so that the transformed weights are
+ * integers. They are at most 9 * 128 in magnitude and are kept in int16.
+ */
+class FBGEMM_API PackedWinogradConvMatrix {
+ public:
+  /**
+   * @param IC the number of input channels
+   * @param OC the number of output channels
+   * @param smat the source unpacked weight in K (R S C) layout
+   */
+  PackedWinogradConvMatrix(int IC, int OC, const std::int8_t* smat);
+  virtual ~PackedWinogradConvMatrix();
+
+  PackedWinogradConvMatrix(const PackedWinogradConvMatrix&) = delete;
+  PackedWinogradConvMatrix& operator=(const PackedWinogradConvMatrix&) =
+      delete;
+
+  /**
+   * @brief Packed weights in [16][ICPadded() / 2][OCPadded()][2] layout:
+   *        for each position of the 4x4 tile, pairs of input channels are
+   *        interleaved for multiply-adds of int16 pairs.
+   */
+  const std::int16_t* PackedMat() const {
+    return pmat_;
+  }
+
+  int IC() const {
+    return IC_;
+  }
+
+  int OC() const {
+    return OC_;
+  }
+
+  /**
+   * @brief The number of input channels rounded up to a multiple of 2.
+   */
+  int ICPadded() const {
+    return (IC_ + 1) / 2 * 2;
+  }
+
+  /**
+   * @brief The number of output channels rounded up to a multiple of 16.
+   */
+  int OCPadded() const {
+    return (OC_ + 15) / 16 * 16;
+  }
+
+  /**
+   * @brief Recovers the original 3x3 weights from the transformed ones.
+   */
+  void unpack(std::int8_t* origin_buf) const;
+
+  /**
+   * @brief The bytes of the packed weights.
+   */
+  std::size_t memoryFootprint() const {
+    return static_cast<std::size_t>(16) * ICPadded() * OCPadded() *
+        sizeof(std::int16_t);
+  }
+
+ private:
+  int IC_;
+  int OC_;
+  std::int16_t* pmat_; /** packed weight */
+};
+
+} // namespace fbgemm
@@ -11,6 +11,7 @@
 #include <assert.h>
 #include <cpuinfo.h>
 #include <array>
+#include <cstring>
 #include <memory>
 #include <stdexcept>
 #include <typeinfo>
@@ -88,14 +89,57 @@ class PackedGemmMatrixB {
     initializeMemory();
   }
 
-  void initializeParam() {
+  // Uses the packed matrix serialized by serialize() at serialized (e.g. a
+  // memory-mapped file) in place, without copying or repacking it. The buffer
+  // must outlive this object, and is only written by packFromSrc and
+  // unpackFromSrc. Throws std::runtime_error if it is not a valid serialized
+  // matrix or was blocked for the kernels of another instruction set.
+  PackedGemmMatrixB(const void* serialized, const std::size_t size)
+      : kernel_ncol_blocks_(2) {
+    const auto& header =
+        readPackedMatrixHeader(serialized, size, packedKind(), sizeof(T));
     if (!cpuinfo_initialize()) {
       throw std::runtime_error("Failed to initialize cpuinfo!");
     }
-    bcol_ = (isZmm(fbgemmInstructionSet())
-                 ? simd_info<inst_set_t::avx512>::WIDTH_32BIT_ELEMS
-                 : simd_info<inst_set_t::avx2>::WIDTH_32BIT_ELEMS) *
+    if (header.aux != kernelNumColBlocks() ||
+        header.bcol != simdBlockColSize() || header.groups != 1 ||
+        header.brow <= 0) {
+      throw std::runtime_error(
+          "Packed matrix was blocked for instruction set " +
+          std::to_string(static_cast<int>(header.isa)) + " (bcol = " +
+          std::to_string(header.bcol) +
+          ") and has to be packed again for bcol = " +
+          std::to_string(simdBlockColSize()));
+    }
+    nrow_ = header.rows;
+    ncol_ = header.cols;
+    brow_ = header.brow;
+    initializeParam();
+    size_ = (blockRowSize() * nbrow_) * (blockColSize() * nbcol_);
+    if (header.data_size != size_ * sizeof(T)) {
+      throw std::runtime_error(
+          "Serialized packed matrix has " + std::to_string(header.data_size) +
+          " bytes of data instead of " + std::to_string(size_ * sizeof(T)));
+    }
+    pmat_ = const_cast<T*>(reinterpret_cast<const T*>(
+        static_cast<const char*>(serialized) + header.data_offset));
+    owns_pmat_ = false;
+    packed_ = true;
+  }
+
+  // The column block size of the kernels of the current instruction set
+  int simdBlockColSize() const {
+    return (isZmm(fbgemmInstructionSet())
+                ? simd_info<inst_set_t::avx512>::WIDTH_32BIT_ELEMS
+                : simd_info<inst_set_t::avx2>::WIDTH_32BIT_ELEMS) *
         kernelNumColBlocks();
+  }
+
+  void initializeParam() {
+    if (!cpuinfo_initialize()) {
+      throw std::runtime_error("Failed to initialize cpuinfo!");
+    }
+    bcol_ = simdBlockColSize();
 
     // set up internal packing parameters
     nbrow_ = (numRows() + blockRowSize() - 1) / blockRowSize();
@@ -129,7 +173,9 @@ class PackedGemmMatrixB {
   }
 
   ~PackedGemmMatrixB() {
-    fbgemmAlignedFree(pmat_);
+    if (owns_pmat_) {
+      fbgemmAlignedFree(pmat_);
+    }
   }
 
   void unpackFromSrc(const matrix_op_t trans, T* src_mat) {
@@ -207,9 +253,62 @@ class PackedGemmMatrixB {
     assert(r < numRows());
     assert(c < numCols());
     assert(static_cast<int64_t>(a) < this->matSize());
+    if (!numa_replicas_.empty()) {
+      return static_cast<const T*>(numa_replicas_.local())[a];
+    }
     return pmat_[a];
   }
 
+  // Keeps a copy of the packed matrix in the memory of each of the first
+  // num_nodes NUMA nodes; cblas_gemm_compute then reads the copy local to
+  // the calling thread. The packed matrix must not change afterwards.
+  void replicateOnNumaNodes(int num_nodes = fbgemmNumaNodeCount()) {
+    assert(packed_);
+    numa_replicas_.replicate(pmat_, matSize() * sizeof(T), num_nodes);
+  }
+
+  // Bytes of the packed matrix if it is owned, and of its NUMA replicas
+  std::size_t memoryFootprint() const {
+    return (owns_pmat_ ? static_cast<std::size_t>(matSize()) * sizeof(T) : 0) +
+        numa_replicas_.memoryFootprint();
+  }
+
+  // Size in bytes of the serialized form of the packed matrix
+  std::size_t serializedSize() const {
+    return kPackedMatrixDataOffset + matSize() * sizeof(T);
+  }
+
+  // Writes the packed matrix and its blocking, in the versioned format of
+  // PackedMatrixHeader, to the serializedSize() bytes at buf, which must be
+  // kPackedMatrixDataAlignment-byte aligned
+  void serialize(void* buf) const {
+    assert(packed_);
+    const auto header = makePackedMatrixHeader(
+        packedKind(),
+        sizeof(T),
+        numRows(),
+        numCols(),
+        1,
+        blockRowSize(),
+        blockColSize(),
+        kernelNumColBlocks(),
+        matSize() * sizeof(T));
+    std::memcpy(buf, &header, sizeof(header));
+    std::memcpy(
+        static_cast<char*>(buf) + header.data_offset, pmat_, header.data_size);
+  }
+
+  static constexpr PackedMatrixKind packedKind() {
+    if constexpr (std::is_same_v<T, float16>) {
+      return PackedMatrixKind::PackedGemmMatrixFP16;
+    } else {
+      static_assert(
+          std::is_same_v<T, bfloat16_weight>,
+          "PackedGemmMatrixB of this type cannot be serialized");
+      return PackedMatrixKind::PackedGemmMatrixBF16;
+    }
+  }
+
   int matSize() const {
     return size_;
   }
@@ -255,7 +354,9 @@ class PackedGemmMatrixB {
   uint64_t size_;
   int kernel_ncol_blocks_;
   T* pmat_;
+  bool owns_pmat_{true};
   bool packed_{false};
+  NumaReplicas numa_replicas_;
 };
 
 } // namespace fbgemm
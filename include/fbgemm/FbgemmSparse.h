@@ -8,12 +8,14 @@
 
 #pragma once
 
+#include <cassert>
 #include <cstdint>
 #include <functional>
 #include <memory>
 #include <vector>
 
 #include "fbgemm/FbgemmBuild.h"
+#include "fbgemm/Utils.h"
 #include "fbgemm/UtilsAvx2.h"
 #include "fbgemm/spmmUtilsAvx2.h"
 
@@ -36,7 +38,7 @@ struct FBGEMM_API BCSRMatrix {
   using DTYPE = T;
   static constexpr int RB = ROW_BLOCK; // Block size for rows
   static constexpr int CB = COL_BLOCK; // Block size for cols
-  // We only tile in column dimension currently
+  // Default column tile size
   // COLTILE must be a multiple of COL_BLOCK
   static constexpr int COLTILE = 4000;
   std::vector<int> rowBPtr; // rowPtr for blocks
@@ -46,10 +48,28 @@ struct FBGEMM_API BCSRMatrix {
   std::vector<int32_t> row_offsets;
   int R;
   int C;
+  // Column tile size the matrix is packed with. It is part of the packed
+  // layout (rowBPtr has one set of row pointers per column tile) so it can
+  // only be chosen at construction. Must be a multiple of CB.
+  int colTile;
+  // Number of rows the kernels process per pass over a column tile. This only
+  // affects the loop order of the kernels and can be changed at any time.
+  // 0 keeps the default order of each kernel.
+  int rowTile;
 
-  BCSRMatrix(int Rows, int Cols) {
+  BCSRMatrix(
+      int Rows,
+      int Cols,
+      int colTileSize = COLTILE,
+      int rowTileSize = 0) {
+    assert(
+        colTileSize > 0 && colTileSize % CB == 0 &&
+        "colTileSize must be a positive multiple of CB");
+    assert(rowTileSize >= 0 && "rowTileSize must be non-negative");
     R = Rows;
     C = Cols;
+    colTile = colTileSize;
+    rowTile = rowTileSize;
     row_offsets.resize(R, 0);
   }
 
@@ -59,8 +79,30 @@ struct FBGEMM_API BCSRMatrix {
    * @param C   number of columns in the matrix
    * @param src is the source matrix with data type DTYPE
    * @param ld is the leading dimension
+   * @param num_threads number of tasks to pack with on the FBGEMM
+   *             thread pool, <= 0 for one per thread
    */
-  void pack(const DTYPE* src, size_t ld);
+  void pack(const DTYPE* src, size_t ld, int num_threads = 1);
+
+  /**
+   * @brief update a packed matrix after some of its rows changed
+   * @param src is the whole new source matrix with data type DTYPE
+   * @param ld is the leading dimension
+   * @param changedRowBlocks indices of the row blocks (rows / RB) that
+   *        changed, in any order. The others must be unchanged since the
+   *        last pack.
+   * @param num_threads number of tasks to pack with on the FBGEMM
+   *             thread pool, <= 0 for one per thread
+   *
+   * Only the changed row blocks are read from src. When their number of
+   * non-zero blocks in each tile is unchanged they are rewritten in place,
+   * otherwise the blocks of the other rows are moved to the new layout.
+   */
+  void repack(
+      const DTYPE* src,
+      size_t ld,
+      const std::vector<int>& changedRowBlocks,
+      int num_threads = 1);
 
   /**
    * @brief pack from dense to tiled block CSR format
@@ -86,19 +128,44 @@ struct FBGEMM_API BCSRMatrix {
    * leading dimension of the matrix is assumed to be equal to C
    */
   void unpack(DTYPE* dst);
+
+  /**
+   * @brief bytes held by the packed arrays
+   */
+  std::size_t memoryFootprint() const {
+    return rowBPtr.capacity() * sizeof(int) + colBIdx.capacity() * sizeof(int) +
+        values.capacity() * sizeof(DTYPE) +
+        row_offsets.capacity() * sizeof(int32_t);
+  }
 };
 
+/**
+ * @param num_threads number of tasks to pack with on the FBGEMM
+ *             thread pool, <= 0 for one per thread
+ */
 template <typename T>
 FBGEMM_API std::unique_ptr<CSRMatrix<T>>
-fbgemmDenseToCSR(int R, int C, const T* inp, int ld);
+fbgemmDenseToCSR(int R, int C, const T* inp, int ld, int num_threads = 1);
 
 template <typename T>
 FBGEMM_API std::unique_ptr<CSRMatrix<T>>
 fbgemmDenseToCSR(int R, int C, const T* inp);
 
+/**
+ * @param colTile column tile size to pack with, see BCSRMatrix::colTile
+ * @param rowTile row tile size used by the kernels, see BCSRMatrix::rowTile
+ * @param num_threads number of tasks to pack with on the FBGEMM
+ *             thread pool, <= 0 for one per thread
+ */
 template <typename T = std::int8_t, int RB = 1, int CB = 4>
-FBGEMM_API std::unique_ptr<BCSRMatrix<T, RB, CB>>
-fbgemmDenseToBCSR(int R, int C, const T* inp, int ld);
+FBGEMM_API std::unique_ptr<BCSRMatrix<T, RB, CB>> fbgemmDenseToBCSR(
+    int R,
+    int C,
+    const T* inp,
+    int ld,
+    int colTile = BCSRMatrix<T, RB, CB>::COLTILE,
+    int rowTile = 0,
+    int num_threads = 1);
 
 template <typename T = std::int8_t, int RB = 1, int CB = 4>
 FBGEMM_API std::unique_ptr<BCSRMatrix<T, RB, CB>>
@@ -126,6 +193,12 @@ fbgemmDenseToBCSR(int R, int C, const T* inp);
  * multiplications, B matrices of subsequent matrices will be already in
  * column-major layout. Refer to SparseDenseMMFP32Benchmark.cc for an example.
  *
+ * Parallelization:
+ *   Called by each of num_threads threads, thread_id computes one block of a
+ * 2D grid over C. Rows of A are split so that the blocks have about the same
+ * number of non-zeros, and columns of B in tiles of the kernels' register
+ * blocking. The same applies to fbgemmSparseDenseInt8MM, which balances the
+ * non-zero blocks counted by rowBPtr.
  */
 FBGEMM_API void SparseDenseMM(
     int M,
@@ -137,7 +210,9 @@ FBGEMM_API void SparseDenseMM(
     int ldb,
     float* C,
     int ldc,
-    bool accum = false);
+    bool accum = false,
+    int thread_id = 0,
+    int num_threads = 1);
 
 template <bool FUSE_RELU, QuantizationGranularity Q_GRAN>
 FBGEMM_API void fbgemmSparseDenseInt8MM(
@@ -153,6 +228,138 @@ FBGEMM_API void fbgemmSparseDenseInt8MM(
     int thread_id = 0,
     int num_threads = 1);
 
+/**
+ * @brief C = A * B for the M x K matrix A and K x N matrix B in CSR format,
+ *        with C in CSR format.
+ *
+ * The products of each row of C are accumulated in a hash table, or for rows
+ * with many products compared to N in a dense array of N values scanned
+ * through a bitmap of the columns hit. Column indices of every row of C are
+ * sorted. Entries that cancel out to zero are kept.
+ *
+ * Rows of C are split into num_threads blocks with about the same number of
+ * products, computed in parallel on the FBGEMM thread pool. num_threads <= 0
+ * uses one block per thread of the pool.
+ */
+template <typename T>
+FBGEMM_API std::unique_ptr<CSRMatrix<T>> fbgemmSparseSparseMM(
+    int M,
+    int N,
+    const CSRMatrix<T>& A,
+    const CSRMatrix<T>& B,
+    int num_threads = 1);
+
+/**
+ * @brief Packed k x n int8 weight matrix with 2:4 structured sparsity along
+ *        k, for fbgemmU8S8Sparse24Gemm.
+ *
+ * Every group of 4 consecutive rows of a column holds at most 2 non-zeros.
+ * Only 2 values per group are stored, with their positions in the group, so
+ * the kernels do half the multiply-adds of a dense GEMM. k is zero-padded to
+ * a multiple of kBlockRows.
+ *
+ * Within one block of 16 columns each block of 16 rows is stored as two
+ * halves of 128 bytes, each covering 2 groups: 4 bytes per column with the
+ * kept values, then 4 bytes per column with their row offsets in the block,
+ * which the kernels use to shuffle the matching values of A.
+ */
+class FBGEMM_API PackBMatrixSparse24 {
+ public:
+  static constexpr int kBlockRows = 16;
+  static constexpr int kBlockCols = 16;
+  static constexpr int kBlockBytes = 2 * 2 * kBlockCols * 4;
+
+  /**
+   * @param trans Transpose if smat is n x k (the PyTorch weight layout)
+   *              rather than k x n.
+   * @param ld Leading dimension of smat.
+   *
+   * Throws if a group of 4 rows has more than 2 non-zeros.
+   */
+  PackBMatrixSparse24(
+      matrix_op_t trans,
+      std::int32_t nRow,
+      std::int32_t nCol,
+      const std::int8_t* smat,
+      std::int32_t ld);
+
+  ~PackBMatrixSparse24();
+
+  PackBMatrixSparse24(const PackBMatrixSparse24&) = delete;
+  PackBMatrixSparse24& operator=(const PackBMatrixSparse24&) = delete;
+
+  std::int32_t numRows() const {
+    return nRow_;
+  }
+  std::int32_t numCols() const {
+    return nCol_;
+  }
+  /// Blocks of kBlockRows rows.
+  std::int32_t rowBlocks() const {
+    return (nRow_ + kBlockRows - 1) / kBlockRows;
+  }
+  /// Blocks of kBlockCols columns.
+  std::int32_t colBlocks() const {
+    return (nCol_ + kBlockCols - 1) / kBlockCols;
+  }
+
+  /// The kBlockBytes bytes of row block kb in column block jb.
+  const std::uint8_t* block(int jb, int kb) const {
+    return buf_ +
+        (static_cast<std::int64_t>(jb) * rowBlocks() + kb) * kBlockBytes;
+  }
+
+  /// Value at (r, c), zero for the pruned positions.
+  std::int8_t value(std::int32_t r, std::int32_t c) const;
+
+  /// Unpack to the original k x n matrix with leading dimension n.
+  void unpack(std::int8_t* origin_buf) const;
+
+  /// Sums of each column, which are the col_offsets ReQuantizeOutput takes
+  /// for a zero weight zero point.
+  const std::int32_t* colOffsets() const {
+    return colOffsets_.data();
+  }
+
+  /// Bytes of the packed blocks and the column offsets.
+  std::size_t memoryFootprint() const {
+    return static_cast<std::size_t>(colBlocks()) * rowBlocks() * kBlockBytes +
+        colOffsets_.capacity() * sizeof(std::int32_t);
+  }
+
+ private:
+  std::uint8_t* block(int jb, int kb) {
+    return const_cast<std::uint8_t*>(
+        static_cast<const PackBMatrixSparse24*>(this)->block(jb, kb));
+  }
+
+  std::int32_t nRow_, nCol_;
+  std::uint8_t* buf_;
+  std::vector<std::int32_t> colOffsets_;
+};
+
+/**
+ * @brief C = outProcess(A * B) with A m x k uint8 row-major and B a 2:4
+ *        structured sparse k x n weight.
+ *
+ * Same output processing as fbgemmPacked: the int32 product goes to
+ * C_buffer (m x n with leading dimension ldc, may alias C for int32 output)
+ * and outProcess writes C. Threads split the column blocks of B. Uses
+ * AVX512-VNNI when available.
+ */
+template <typename outType, typename processOutputType>
+FBGEMM_API void fbgemmU8S8Sparse24Gemm(
+    int m,
+    const std::uint8_t* A,
+    int lda,
+    const PackBMatrixSparse24& B,
+    outType* C,
+    std::int32_t* C_buffer,
+    int ldc,
+    const processOutputType& outProcess,
+    int thread_id = 0,
+    int num_threads = 1);
+
 namespace internal {
 
 void SparseDenseMMAvx2(
@@ -179,6 +386,7 @@ void SparseDenseMMAvx512(
     int ldc,
     bool accum = false);
 
+// The int8 kernels compute rows [row_begin, row_end) of C.
 template <bool FUSE_RELU, QuantizationGranularity Q_GRAN>
 void SparseDenseInt8MMAvx2(
     int N,
@@ -189,9 +397,9 @@ void SparseDenseInt8MMAvx2(
     uint8_t* C_u8,
     int ldc,
     trRequantizationParams_t& rParams,
-    bool accum = false,
-    int thread_id = 0,
-    int num_threads = 1);
+    bool accum,
+    int row_begin,
+    int row_end);
 
 template <bool FUSE_RELU, QuantizationGranularity Q_GRAN>
 void SparseDenseInt8MMAvx512(
@@ -203,9 +411,9 @@ void SparseDenseInt8MMAvx512(
     uint8_t* C_u8,
     int ldc,
     trRequantizationParams_t& rParams,
-    bool accum = false,
-    int thread_id = 0,
-    int num_threads = 1);
+    bool accum,
+    int row_begin,
+    int row_end);
 
 template <bool FUSE_RELU, QuantizationGranularity Q_GRAN>
 void SparseDenseInt8MVAvx512(
@@ -215,9 +423,20 @@ void SparseDenseInt8MVAvx512(
     int32_t* C_i32,
     uint8_t* C_u8,
     trRequantizationParams_t& rParams,
-    bool accum = false,
-    int thread_id = 0,
-    int num_threads = 1);
+    bool accum,
+    int row_begin,
+    int row_end);
+
+/// int32 A * B for column blocks [jb_begin, jb_end) of B.
+void U8S8Sparse24GemmAvx512Vnni(
+    int m,
+    const std::uint8_t* A,
+    int lda,
+    const PackBMatrixSparse24& B,
+    std::int32_t* C,
+    int ldc,
+    int jb_begin,
+    int jb_end);
 
 } // namespace internal
 
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+
+#include "./FbgemmBuild.h"
+
+namespace fbgemm {
+
+/**
+ * @brief One call of a traced FBGEMM entry point.
+ *
+ * Entry points that run on a thread_id/num_threads pair of their caller
+ * (fbgemmPacked, fbgemmConv) report one event per thread; calls made by
+ * another traced entry point (e.g. the fbgemmPacked calls of an im2col
+ * fbgemmConv) are reported as well.
+ */
+struct TraceEvent {
+  /// Name of the entry point, e.g. "fbgemmPacked"; a string literal.
+  const char* kernel;
+  /**
+   * Sizes of the problem, in the order of the entry point:
+   *  - fbgemmPacked: M, N, K, groups
+   *  - fbgemmConv: batch, IC, OC, groups, output pixels, kernel taps
+   *  - embedding lookups and fused optimizers: output_size, index_size,
+   *    data_size, block_size
+   *  - SparseAdaGrad: num_rows, param_size, block_size
+   * Only valid during the callback.
+   */
+  const std::int64_t* shape;
+  int shape_size;
+  /// Start of the call as std::chrono::steady_clock time since epoch.
+  std::int64_t start_ns;
+  std::int64_t duration_ns;
+  /// Estimate of the bytes read and written from the shape, of the whole
+  /// problem for the entry points reporting one event per thread.
+  std::int64_t bytes;
+  int thread_id;
+  int num_threads;
+};
+
+/**
+ * @brief Receives TraceEvent of the calling thread at the end of every call.
+ * It runs on the critical path, may be called concurrently from several
+ * threads and must not throw.
+ */
+using TraceCallback = std::function<void(const TraceEvent& event)>;
+
+/**
+ * @brief Installs the callback receiving trace events; nullptr disables
+ * tracing, which then costs one relaxed atomic load per call. Kernels running
+ * concurrently with the change may still report to the previous callback.
+ * The embedding and fused optimizer kernels are only traced when they are
+ * generated while a callback is installed.
+ * Tracing is compiled out when the library is built with
+ * FBGEMM_DISABLE_TRACING (FBGEMM_ENABLE_TRACING=OFF in CMake), in which case
+ * the callback is never called.
+ */
+FBGEMM_API void fbgemmSetTraceCallback(TraceCallback callback);
+
+/**
+ * @brief Whether a trace callback is installed.
+ */
+FBGEMM_API bool fbgemmTracingEnabled();
+
+} // namespace fbgemm
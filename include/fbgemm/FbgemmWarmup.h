@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <future>
+#include <vector>
+
+#include "./ConvUtils.h"
+#include "./FbgemmBuild.h"
+#include "./Utils.h"
+
+namespace fbgemm {
+
+/**
+ * @brief A uint8 x int8 GEMM shape executed through fbgemmPacked.
+ *
+ * The generated micro-kernels depend on how the output is partitioned over
+ * threads, so num_threads must match the value the model passes to
+ * fbgemmPacked.
+ */
+struct GemmWarmupShape {
+  int M;
+  int N;
+  int K;
+  bool acc16 = false;
+  int num_threads = 1;
+  /// Custom blocking factors or nullptr; must outlive the warmup.
+  const BlockingFactors* blocking_params = nullptr;
+};
+
+/**
+ * @brief An EmbeddingSpMDM kernel configuration.
+ *
+ * bit_rate selects the table type: 32 for float, 16 for float16, 8 for fused
+ * 8-bit rowwise quantized and 4 or 2 for fused n-bit rowwise quantized tables.
+ */
+struct EmbeddingWarmupConfig {
+  std::int64_t block_size;
+  int bit_rate = 32;
+  bool has_weight = false;
+  bool normalize_by_lengths = false;
+  int prefetch = 16;
+  bool is_weight_positional = false;
+  bool use_offsets = true;
+  bool is_index_64bit = true;
+  bool is_offset_64bit = true;
+};
+
+/**
+ * @brief A convolution run through fbgemmConv, with the requantization the
+ * model runs it with.
+ *
+ * The depthwise and groupwise kernels are generated separately for a zero and
+ * a nonzero A_zero_point and B_zero_point, and the output processing is
+ * instantiated per granularity and fuse_relu.
+ */
+template <int SPATIAL_DIM>
+struct ConvWarmupConfig {
+  conv_param_t<SPATIAL_DIM> conv_p;
+  QuantizationGranularity granularity = QuantizationGranularity::TENSOR;
+  bool fuse_relu = false;
+  std::int32_t A_zero_point = 0;
+  /// Zero point of B for every group or output channel
+  std::int32_t B_zero_point = 0;
+};
+
+/**
+ * @brief Everything a model is known to run, used to generate its JIT
+ * kernels before serving traffic.
+ *
+ * conv_num_threads must match the value the model passes to fbgemmConv.
+ */
+struct WarmupManifest {
+  std::vector<GemmWarmupShape> gemms;
+  std::vector<EmbeddingWarmupConfig> embeddings;
+  std::vector<ConvWarmupConfig<2>> convs_2d;
+  std::vector<ConvWarmupConfig<3>> convs_3d;
+  int conv_num_threads = 1;
+};
+
+/**
+ * @brief Pre-populate the JIT code caches with all kernels in manifest.
+ *
+ * GEMMs and convolutions are executed once on zero-filled inputs, which
+ * generates exactly the kernels the same call generates on the hot path.
+ * Embedding kernels are generated without being run. Entries are processed
+ * by num_threads background threads (hardware concurrency when 0).
+ *
+ * @return A future that becomes ready when all kernels are generated. It
+ *         rethrows the first exception raised by any entry.
+ */
+FBGEMM_API std::future<void> fbgemmWarmup(
+    const WarmupManifest& manifest,
+    int num_threads = 0);
+
+} // namespace fbgemm
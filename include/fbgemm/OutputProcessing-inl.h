@@ -58,6 +58,50 @@ inline int DoSConvOnInpBuffer<outT, inT, nextOPType>::f(
   return nextop_.template f<instSet>(out, inp, block, ld_out, ld_in);
 }
 
+template <typename outT, typename inT, typename nextOPType>
+template <inst_set_t instSet>
+inline int DoResidualAddOnInpBuffer<outT, inT, nextOPType>::f(
+    outT* out,
+    inT* inp,
+    const block_type_t& block,
+    int ld_out,
+    int ld_in) const {
+  static_assert(
+      std::is_same<inT, int32_t>::value,
+      "input data type must be of int32_t type");
+  for (int i = block.row_start; i < block.row_start + block.row_size; ++i) {
+    const std::uint8_t* r = residual_ + i * ld_residual_;
+    inT* c = inp + (i - block.row_start) * ld_in;
+    for (int j = block.col_start; j < block.col_start + block.col_size; ++j) {
+      c[j - block.col_start] += std::lrintf(
+          (static_cast<int32_t>(r[j]) - residual_zero_point_) *
+          multiplier_[j]);
+    }
+  }
+  return nextop_.template f<instSet>(out, inp, block, ld_out, ld_in);
+}
+
+template <typename outT, typename inT, typename nextOPType>
+template <inst_set_t instSet>
+inline int LookupTableOutput<outT, inT, nextOPType>::f(
+    outT* out,
+    inT* /* inp */,
+    const block_type_t& block,
+    int ld_out,
+    int /* ld_in */) const {
+  static_assert(
+      std::is_same<outT, std::uint8_t>::value &&
+          std::is_same<inT, std::uint8_t>::value,
+      "input and output data type must be of uint8_t type");
+  for (int i = block.row_start; i < block.row_start + block.row_size; ++i) {
+    std::uint8_t* c = out + i * ld_out + block.col_start;
+    for (int j = 0; j < block.col_size; ++j) {
+      c[j] = table_[c[j]];
+    }
+  }
+  return nextop_.template f<instSet>(out, out, block, ld_out, ld_out);
+}
+
 template <
     bool FUSE_RELU,
     QuantizationGranularity Q_GRAN,
@@ -213,10 +257,13 @@ inline int ReQuantizeForFloat<FUSE_RELU, Q_GRAN, outT, inT, nextOPType>::f(
   int g = block.col_start / ncol_per_group;
   if (instSet == inst_set_t::anyarch || !std::is_same<outT, float>::value) {
     for (int i = block.row_start; i < block.row_start + block.row_size; ++i) {
+      const float Aq_scale = Aq_row_scales_ ? Aq_row_scales_[i] : Aq_scale_;
+      const std::int32_t Aq_zero_point =
+          Aq_row_scales_ ? Aq_row_zero_points_[i] : Aq_zero_point_;
       for (int j = block.col_start; j < block.col_start + block.col_size; ++j) {
         inT raw = inp[(i - block.row_start) * ld_in + j - block.col_start];
-        if (Aq_zero_point_) {
-          raw -= Aq_zero_point_ * q_col_offsets_[j];
+        if (Aq_zero_point) {
+          raw -= Aq_zero_point * q_col_offsets_[j];
         }
         int Bq_zero_point_idx;
         if (Q_GRAN == QuantizationGranularity::TENSOR) {
@@ -232,7 +279,7 @@ inline int ReQuantizeForFloat<FUSE_RELU, Q_GRAN, outT, inT, nextOPType>::f(
           raw -= q_row_offsets_[i - block.row_start] *
               Bq_zero_point_[Bq_zero_point_idx];
         }
-        float res = raw * Aq_scale_ * Bq_scale_[Bq_zero_point_idx];
+        float res = raw * Aq_scale * Bq_scale_[Bq_zero_point_idx];
         if (bias_) {
           res += bias_[j];
         }
@@ -243,10 +290,6 @@ inline int ReQuantizeForFloat<FUSE_RELU, Q_GRAN, outT, inT, nextOPType>::f(
       }
     }
   } else if (instSet == inst_set_t::avx2 || instSet == inst_set_t::avx512) {
-    bool b_symmetric =
-        (Q_GRAN == QuantizationGranularity::TENSOR && Bq_zero_point_[0] == 0) ||
-        q_row_offsets_ == nullptr;
-
     requantizationForFloatParams_t r = {
         Aq_zero_point_,
         Bq_zero_point_,
@@ -258,42 +301,19 @@ inline int ReQuantizeForFloat<FUSE_RELU, Q_GRAN, outT, inT, nextOPType>::f(
         ncols_,
         groups_};
 
-    if (Aq_zero_point_ == 0) {
-      if (b_symmetric) {
-        if (bias_ == nullptr) {
-          requantizeForFloatAvx2<true, true, Q_GRAN, false, FUSE_RELU>(
-              out, inp, block, ld_out, ld_in, r);
-        } else {
-          requantizeForFloatAvx2<true, true, Q_GRAN, true, FUSE_RELU>(
-              out, inp, block, ld_out, ld_in, r);
-        }
-      } else {
-        if (bias_ == nullptr) {
-          requantizeForFloatAvx2<true, false, Q_GRAN, false, FUSE_RELU>(
-              out, inp, block, ld_out, ld_in, r);
-        } else {
-          requantizeForFloatAvx2<true, false, Q_GRAN, true, FUSE_RELU>(
-              out, inp, block, ld_out, ld_in, r);
-        }
+    if (Aq_row_scales_) {
+      // One row at a time so that each row has its own A parameters.
+      for (int i = block.row_start; i < block.row_start + block.row_size; ++i) {
+        const int i_in_block = i - block.row_start;
+        block_type_t row_block = {i, 1, block.col_start, block.col_size};
+        r.A_scale = Aq_row_scales_[i];
+        r.A_zero_point = Aq_row_zero_points_[i];
+        r.row_offsets = q_row_offsets_ ? q_row_offsets_ + i_in_block : nullptr;
+        requantizeBlockAvx2(
+            out, inp + i_in_block * ld_in, row_block, ld_out, ld_in, r);
       }
     } else {
-      if (b_symmetric) {
-        if (bias_ == nullptr) {
-          requantizeForFloatAvx2<false, true, Q_GRAN, false, FUSE_RELU>(
-              out, inp, block, ld_out, ld_in, r);
-        } else {
-          requantizeForFloatAvx2<false, true, Q_GRAN, true, FUSE_RELU>(
-              out, inp, block, ld_out, ld_in, r);
-        }
-      } else {
-        if (bias_ == nullptr) {
-          requantizeForFloatAvx2<false, false, Q_GRAN, false, FUSE_RELU>(
-              out, inp, block, ld_out, ld_in, r);
-        } else {
-          requantizeForFloatAvx2<false, false, Q_GRAN, true, FUSE_RELU>(
-              out, inp, block, ld_out, ld_in, r);
-        }
-      }
+      requantizeBlockAvx2(out, inp, block, ld_out, ld_in, r);
     }
   } else {
     assert(0 && "Not supported yet");
@@ -301,3 +321,60 @@ inline int ReQuantizeForFloat<FUSE_RELU, Q_GRAN, outT, inT, nextOPType>::f(
 
   return nextop_.template f<instSet>(out, out, block, ld_out, ld_out);
 }
+
+template <
+    bool FUSE_RELU,
+    QuantizationGranularity Q_GRAN,
+    typename outT,
+    typename inT,
+    typename nextOPType>
+inline void ReQuantizeForFloat<FUSE_RELU, Q_GRAN, outT, inT, nextOPType>::
+    requantizeBlockAvx2(
+        outT* out,
+        const inT* inp,
+        const block_type_t& block,
+        int ld_out,
+        int ld_in,
+        const requantizationForFloatParams_t& r) const {
+  bool b_symmetric =
+      (Q_GRAN == QuantizationGranularity::TENSOR && Bq_zero_point_[0] == 0) ||
+      r.row_offsets == nullptr;
+
+  if (r.A_zero_point == 0) {
+    if (b_symmetric) {
+      if (bias_ == nullptr) {
+        requantizeForFloatAvx2<true, true, Q_GRAN, false, FUSE_RELU>(
+            out, inp, block, ld_out, ld_in, r);
+      } else {
+        requantizeForFloatAvx2<true, true, Q_GRAN, true, FUSE_RELU>(
+            out, inp, block, ld_out, ld_in, r);
+      }
+    } else {
+      if (bias_ == nullptr) {
+        requantizeForFloatAvx2<true, false, Q_GRAN, false, FUSE_RELU>(
+            out, inp, block, ld_out, ld_in, r);
+      } else {
+        requantizeForFloatAvx2<true, false, Q_GRAN, true, FUSE_RELU>(
+            out, inp, block, ld_out, ld_in, r);
+      }
+    }
+  } else {
+    if (b_symmetric) {
+      if (bias_ == nullptr) {
+        requantizeForFloatAvx2<false, true, Q_GRAN, false, FUSE_RELU>(
+            out, inp, block, ld_out, ld_in, r);
+      } else {
+        requantizeForFloatAvx2<false, true, Q_GRAN, true, FUSE_RELU>(
+            out, inp, block, ld_out, ld_in, r);
+      }
+    } else {
+      if (bias_ == nullptr) {
+        requantizeForFloatAvx2<false, false, Q_GRAN, false, FUSE_RELU>(
+            out, inp, block, ld_out, ld_in, r);
+      } else {
+        requantizeForFloatAvx2<false, false, Q_GRAN, true, FUSE_RELU>(
+            out, inp, block, ld_out, ld_in, r);
+      }
+    }
+  }
+}
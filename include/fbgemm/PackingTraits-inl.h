@@ -509,6 +509,56 @@ struct PackingTraits<
   }
 };
 
+/**
+ * @brief Packing parameter specialization for accumulation into 32-bit/16-bit
+ * integers on CPUs without AVX2, e.g. aarch64.
+ *
+ * int16_t accumulation is redirected to int32_t accumulation here too.
+ *
+ * This is picked when T is of int8 type (signed or unsigned) and instruction
+ * set is anyarch.
+ */
+template <typename T, typename accT>
+struct PackingTraits<
+    T,
+    accT,
+    inst_set_t::anyarch,
+    typename std::enable_if<
+        is_8bit<T>::value && is_16or32bit<accT>::value>::type> {
+  static constexpr int MR{8}; ///< Register block for M dimension.
+  static constexpr int NR_MIN{
+      8}; ///< Minimum register block for N dimension.
+          ///< 8 because the NEON kernel works on 4 pairs of columns.
+  static constexpr int NR{
+      8}; ///< Register block for N dimension.
+          ///< We use MR/2 x NR/2 128-bit registers for C accumulations, each
+          ///< holding a 2x2 block.
+
+  static constexpr int ROW_INTERLEAVE{
+      8}; ///< 8 rows are interleaved so that two columns of B are the 2x8
+          ///< operand of the i8mm usmmla instruction.
+
+  static constexpr int MCB{
+      128}; ///< Cache block for M dimension (multiple of MR).
+  static constexpr int NCB{
+      64}; ///< Cache block for N dimension (multiple of NR).
+  static constexpr int KCB{512}; ///< Cache block for K dimension.
+
+  static std::tuple<int, int, int> getCacheBlockParams() {
+    return std::tuple<int, int, int>(int(MCB), int(KCB), int(MR));
+  }
+  static std::tuple<int, int, int, int> getKernelParams() {
+    return std::tuple<int, int, int, int>(
+        int(MCB), int(NCB), int(NR_MIN), int(NR));
+  }
+  static std::tuple<int, int, int> getMatrixPackAParams() {
+    return std::tuple<int, int, int>(int(MCB), int(KCB), int(ROW_INTERLEAVE));
+  }
+  static std::tuple<int, int, int> getMatrixPackBParams() {
+    return std::tuple<int, int, int>(int(KCB), int(NCB), int(ROW_INTERLEAVE));
+  }
+};
+
 /**
  * @brief Packing parameter specialization for I64 GEMM
  * integers.
@@ -17,6 +17,7 @@
 #include <cassert>
 #include <cmath>
 #include <cstdint>
+#include <functional>
 #include <limits>
 
 /// @defgroup fbgemm-quant-utils-generic Quantization Utilities (Generic)
@@ -112,6 +113,21 @@ FBGEMM_API void Quantize(
     int thread_id = 0,
     int num_threads = 1);
 
+/// @ingroup fbgemm-quant-utils-generic
+///
+/// Quantize the `LEN` floats of `src` as `Quantize<T, LEGACY>` does, for the
+/// hot small vectors (e.g. per-token activations) where the runtime dispatch
+/// and remainder handling of the variable length version dominate. With a
+/// compile-time length the kernel is fully unrolled and has no remainder.
+///
+/// Instantiated for `T` of `std::uint8_t` and `std::int8_t` and `LEN` of 8,
+/// 16, 32, 64, 128 and 256.
+template <int LEN, typename T, bool LEGACY = true>
+FBGEMM_API void QuantizeFixedLength(
+    const float* src,
+    T* dst,
+    const TensorQuantizationParams& qparams);
+
 /// @ingroup fbgemm-quant-utils-generic
 ///
 /// Quantize floating point data in `src` to type `T`.
@@ -148,6 +164,77 @@ FBGEMM_API void QuantizeGroupwise(
     const std::int32_t* zero_points,
     T* dst);
 
+/// @ingroup fbgemm-quant-utils-generic
+///
+/// Per-row (per-token) dynamic quantization of the `rows` x `cols` row-major
+/// matrix `src` to uint8. The parameters of each row are
+/// `ChooseQuantizationParams(min, max, 0, 255)` over the range of that row,
+/// and the row is quantized as `Quantize<std::uint8_t, false>` does right
+/// after its range is found, while it is still in cache.
+///
+/// The results can be fed to ReQuantizeForFloat with per-row A parameters.
+///
+/// @param scales `rows` scales, one per row.
+/// @param zero_points `rows` zero points, one per row.
+/// @param thread_id, num_threads Threads split the rows.
+FBGEMM_API void QuantizeRowwiseDynamic(
+    const float* src,
+    std::uint8_t* dst,
+    std::int64_t rows,
+    int cols,
+    float* scales,
+    std::int32_t* zero_points,
+    int thread_id = 0,
+    int num_threads = 1);
+
+/**
+ * Same as QuantizeRowwiseDynamic but unoptimized and single threaded.
+ * This should not be called directly except in testing.
+ */
+FBGEMM_API void QuantizeRowwiseDynamicRef(
+    const float* src,
+    std::uint8_t* dst,
+    std::int64_t rows,
+    int cols,
+    float* scales,
+    std::int32_t* zero_points);
+
+/// @ingroup fbgemm-quant-utils-generic
+///
+/// Quantize the `rows` x `cols` row-major matrix `src` to uint8 as
+/// `Quantize<std::uint8_t, LEGACY>` does, and write the sum of each quantized
+/// row to `row_offsets` in the same pass.
+///
+/// These are the row offsets PackAWithRowOffset computes when it packs the
+/// quantized matrix, so a quantized activation reused by several GEMMs can be
+/// packed with PackAMatrix and requantized with these offsets instead.
+///
+/// @param row_offsets `rows` sums, one per row.
+/// @param thread_id, num_threads Threads split the rows.
+template <bool LEGACY = true>
+FBGEMM_API void QuantizeWithRowOffsets(
+    const float* src,
+    std::uint8_t* dst,
+    std::int64_t rows,
+    int cols,
+    const TensorQuantizationParams& qparams,
+    std::int32_t* row_offsets,
+    int thread_id = 0,
+    int num_threads = 1);
+
+/**
+ * Same as QuantizeWithRowOffsets but unoptimized and single threaded.
+ * This should not be called directly except in testing.
+ */
+template <bool LEGACY = true>
+FBGEMM_API void QuantizeWithRowOffsetsRef(
+    const float* src,
+    std::uint8_t* dst,
+    std::int64_t rows,
+    int cols,
+    const TensorQuantizationParams& qparams,
+    std::int32_t* row_offsets);
+
 template <typename T>
 float Dequantize(T src, const TensorQuantizationParams& qparams) {
   return qparams.scale * (src - qparams.zero_point);
@@ -168,6 +255,16 @@ void Dequantize(
   }
 }
 
+/// @ingroup fbgemm-quant-utils-generic
+///
+/// Dequantize the `LEN` values of `src`, the counterpart of
+/// `QuantizeFixedLength` with the same instantiations.
+template <int LEN, typename T>
+FBGEMM_API void DequantizeFixedLength(
+    const T* src,
+    float* dst,
+    const TensorQuantizationParams& qparams);
+
 template <typename T>
 float FusedQuantizeDequantize(
     float src,
@@ -193,6 +290,19 @@ FBGEMM_API void FusedQuantizeDequantize(
     int num_threads = 1,
     float noise_ratio = 0.0f);
 
+/// @ingroup fbgemm-quant-utils-generic
+///
+/// Fill the 256 entries of the table of `LookupTableOutput` applying
+/// `activation` to `uint8` values: `table[q]` is `activation` of `q`
+/// dequantized with `in_qparams`, quantized with `out_qparams`. With
+/// `ReQuantizeOutput` requantizing the GEMM output to `in_qparams`, the table
+/// maps it to the activation's output, which fuses e.g. GELU into the GEMM.
+FBGEMM_API void ComputeActivationLookupTable(
+    const std::function<float(float)>& activation,
+    const TensorQuantizationParams& in_qparams,
+    const TensorQuantizationParams& out_qparams,
+    std::uint8_t* table);
+
 ////////////////////////////////////////////////////////////////////////////////
 // Requantization (pure fixed-point)
 
@@ -268,6 +378,78 @@ FBGEMM_API void Requantize(
     int thread_id = 0,
     int num_threads = 1);
 
+////////////////////////////////////////////////////////////////////////////////
+// Per-channel requantization
+
+/// @ingroup fbgemm-quant-utils-generic
+///
+/// Requantizes the `rows` x `channels` row-major matrix of int32 values
+/// `src`, e.g. accumulated outside of FBGEMM, with the multiplier and zero
+/// point of the channel (column) of each value, as `Requantize<T>` with
+/// floats does, clamping to `precision` bits, signed if T is.
+///
+/// @param T std::uint8_t, std::int8_t or std::int16_t
+/// @param multipliers `channels` multipliers
+/// @param zero_points `channels` zero points of the outputs
+/// @param thread_id, num_threads Threads split the rows.
+template <typename T>
+FBGEMM_API void RequantizePerChannel(
+    const std::int32_t* src,
+    T* dst,
+    std::int64_t rows,
+    int channels,
+    const float* multipliers,
+    const std::int32_t* zero_points,
+    int precision = 8 * sizeof(T),
+    int thread_id = 0,
+    int num_threads = 1);
+
+/// @ingroup fbgemm-quant-utils-generic
+///
+/// Pure fixed-point version of RequantizePerChannel, with the multipliers
+/// and right shifts of RequantizationParams, at least 1, for each channel.
+template <typename T>
+FBGEMM_API void RequantizeFixedPointPerChannel(
+    const std::int32_t* src,
+    T* dst,
+    std::int64_t rows,
+    int channels,
+    const std::int32_t* multipliers,
+    const int* right_shifts,
+    const std::int32_t* zero_points,
+    int precision = 8 * sizeof(T),
+    int thread_id = 0,
+    int num_threads = 1);
+
+/**
+ * Same as RequantizePerChannel but unoptimized and single threaded.
+ * This should not be called directly except in testing.
+ */
+template <typename T>
+FBGEMM_API void RequantizePerChannelRef(
+    const std::int32_t* src,
+    T* dst,
+    std::int64_t rows,
+    int channels,
+    const float* multipliers,
+    const std::int32_t* zero_points,
+    int precision = 8 * sizeof(T));
+
+/**
+ * Same as RequantizeFixedPointPerChannel but unoptimized and single threaded.
+ * This should not be called directly except in testing.
+ */
+template <typename T>
+FBGEMM_API void RequantizeFixedPointPerChannelRef(
+    const std::int32_t* src,
+    T* dst,
+    std::int64_t rows,
+    int channels,
+    const std::int32_t* multipliers,
+    const int* right_shifts,
+    const std::int32_t* zero_points,
+    int precision = 8 * sizeof(T));
+
 /**
  * @ingroup fbgemm-quant-utils-generic
  *
@@ -277,6 +459,11 @@ FBGEMM_API void Requantize(
  * the row itself (fused) at the end.
  *
  * @param bit_rate can be 2, 4, or 8
+ * @param thread_id, num_threads Threads split the rows.
+ * @param greedy_range_search quantize each row over the range found by
+ *                            NBitRowwiseRangeSearchGreedy instead of its
+ *                            min and max, which lowers the error but is
+ *                            slower.
  */
 template <typename InputType>
 FBGEMM_API void FloatOrHalfToFusedNBitRowwiseQuantizedSBHalf(
@@ -284,7 +471,10 @@ FBGEMM_API void FloatOrHalfToFusedNBitRowwiseQuantizedSBHalf(
     const InputType* input,
     size_t input_rows,
     int input_columns,
-    std::uint8_t* output);
+    std::uint8_t* output,
+    int thread_id = 0,
+    int num_threads = 1,
+    bool greedy_range_search = false);
 
 /**
  * Convert fused rowwise quantized inputs to float (fp32 or fp16).
@@ -293,6 +483,7 @@ FBGEMM_API void FloatOrHalfToFusedNBitRowwiseQuantizedSBHalf(
  * the row itself (fused) at the end.
  *
  * @param bit_rate can be 2, 4, or 8
+ * @param thread_id, num_threads Threads split the rows.
  */
 template <typename OutputType>
 FBGEMM_API void FusedNBitRowwiseQuantizedSBHalfToFloatOrHalf(
@@ -300,7 +491,59 @@ FBGEMM_API void FusedNBitRowwiseQuantizedSBHalfToFloatOrHalf(
     const uint8_t* input,
     size_t input_rows,
     int input_columns,
-    OutputType* output);
+    OutputType* output,
+    int thread_id = 0,
+    int num_threads = 1);
+
+/**
+ * @ingroup fbgemm-quant-utils-generic
+ *
+ * Same as FloatOrHalfToFusedNBitRowwiseQuantizedSBHalf but with a Scale and
+ * Bias for every group_size consecutive elements of a row instead of one per
+ * row, which keeps wide rows accurate at 4 or 2 bits. Each output row is the
+ * packed row followed by the fp16 Scale and Bias of each group:
+ * input_columns / (8 / bit_rate) +
+ * input_columns / group_size * 2 * sizeof(float16) bytes. With group_size ==
+ * input_columns the output is the same as the rowwise one.
+ *
+ * @param bit_rate can be 2, 4, or 8
+ * @param group_size must divide input_columns and be a multiple of
+ *                   8 / bit_rate
+ * @param thread_id, num_threads Threads split the rows.
+ * @param greedy_range_search as in
+ *                            FloatOrHalfToFusedNBitRowwiseQuantizedSBHalf,
+ *                            applied to each group.
+ */
+template <typename InputType>
+FBGEMM_API void FloatOrHalfToFusedNBitGroupwiseQuantizedSBHalf(
+    int bit_rate,
+    int group_size,
+    const InputType* input,
+    size_t input_rows,
+    int input_columns,
+    std::uint8_t* output,
+    int thread_id = 0,
+    int num_threads = 1,
+    bool greedy_range_search = false);
+
+/**
+ * Convert the rows of FloatOrHalfToFusedNBitGroupwiseQuantizedSBHalf to float
+ * (fp32 or fp16). input_columns is the number of bytes of a fused row.
+ *
+ * @param bit_rate can be 2, 4, or 8
+ * @param group_size number of elements sharing a Scale and Bias
+ * @param thread_id, num_threads Threads split the rows.
+ */
+template <typename OutputType>
+FBGEMM_API void FusedNBitGroupwiseQuantizedSBHalfToFloatOrHalf(
+    int bit_rate,
+    int group_size,
+    const uint8_t* input,
+    size_t input_rows,
+    int input_columns,
+    OutputType* output,
+    int thread_id = 0,
+    int num_threads = 1);
 
 /**
  * Convert float or half inputs to rowwise quantized (8-bit) outputs.
@@ -310,13 +553,17 @@ FBGEMM_API void FusedNBitRowwiseQuantizedSBHalfToFloatOrHalf(
  * This version intentionally supports only 8-bit because we want to discourage
  * the usage of float scale and bias with 2 and 4 bit cases as that diminishes
  * the overall memory savings.
+ *
+ * @param thread_id, num_threads Threads split the rows.
  */
 template <typename InputType>
 FBGEMM_API void FloatOrHalfToFused8BitRowwiseQuantizedSBFloat(
     const InputType* input,
     size_t input_rows,
     int input_columns,
-    std::uint8_t* output);
+    std::uint8_t* output,
+    int thread_id = 0,
+    int num_threads = 1);
 
 /**
  * Convert fused rowwise quantized (8-bit) inputs to float or half outputs.
@@ -325,13 +572,203 @@ FBGEMM_API void FloatOrHalfToFused8BitRowwiseQuantizedSBFloat(
  *
  * This version intentionally supports only 8-bit because
  * the corresponding quantize version only supports 8-bit.
+ *
+ * @param thread_id, num_threads Threads split the rows.
  */
 template <typename OutputType>
 FBGEMM_API void Fused8BitRowwiseQuantizedSBFloatToFloatOrHalf(
     const uint8_t* input,
     size_t input_rows,
     int input_columns,
-    OutputType* output);
+    OutputType* output,
+    int thread_id = 0,
+    int num_threads = 1);
+
+/**
+ * Convert float or half inputs to rowwise quantized float8 outputs with the
+ * given number of exponent bits and exponent bias (see FloatToFloat8_ref).
+ * Each row is scaled to the range of float8 by a float scale, which is stored
+ * in the row itself (fused) at the end, so each output row has
+ * input_columns + sizeof(float) bytes. Each of the num_threads threads
+ * quantizes the thread_id-th part of the rows.
+ */
+template <typename InputType>
+FBGEMM_API void FloatOrHalfToFusedFP8RowwiseQuantized(
+    const InputType* input,
+    size_t input_rows,
+    int input_columns,
+    std::uint8_t* output,
+    int exponent_bits = 4,
+    int exponent_bias = 7,
+    int thread_id = 0,
+    int num_threads = 1);
+
+/**
+ * Convert fused rowwise quantized float8 inputs, as produced by
+ * FloatOrHalfToFusedFP8RowwiseQuantized, to float or half outputs.
+ * input_columns includes the float scale at the end of each row.
+ */
+template <typename OutputType>
+FBGEMM_API void FusedFP8RowwiseQuantizedToFloatOrHalf(
+    const uint8_t* input,
+    size_t input_rows,
+    int input_columns,
+    OutputType* output,
+    int exponent_bits = 4,
+    int exponent_bias = 7,
+    int thread_id = 0,
+    int num_threads = 1);
+
+/**
+ * Element formats of the OCP Microscaling (MX) block formats. Each block of
+ * kMXBlockSize consecutive elements of a row shares a power of two scale,
+ * stored as an E8M0 byte (the biased exponent, 0xFF is NaN).
+ */
+enum class MXFormat {
+  MXFP8_E4M3, // no infinities, largest value 448
+  MXFP8_E5M2, // largest finite value 57344
+  MXFP4_E2M1, // largest value 6, two elements per byte
+  MXINT8, // two's complement with an implicit scale of 2^-6
+};
+
+constexpr int kMXBlockSize = 32;
+
+/**
+ * Bytes of a row of `columns` elements quantized to `format`: the elements,
+ * followed by one E8M0 scale per block of kMXBlockSize elements. The last
+ * block of a row may be partial.
+ */
+FBGEMM_API int MXQuantizedRowBytes(MXFormat format, int columns);
+
+/**
+ * Convert float or half inputs to the MX block format `format`. The scale of
+ * each block is 2^(floor(log2(amax)) - emax) with amax the largest magnitude
+ * in the block and emax the exponent of the largest power of two of the
+ * element format, as in the OCP MX specification. The scaled elements are
+ * rounded to nearest even and saturated to the largest value of the element
+ * format. A block with an infinity or a NaN gets a NaN scale. Each output row
+ * has MXQuantizedRowBytes(format, input_columns) bytes, and fp4 elements are
+ * packed low nibble first. Each of the num_threads threads quantizes the
+ * thread_id-th part of the rows.
+ */
+template <typename InputType>
+FBGEMM_API void FloatOrHalfToMXQuantized(
+    MXFormat format,
+    const InputType* input,
+    size_t input_rows,
+    int input_columns,
+    std::uint8_t* output,
+    int thread_id = 0,
+    int num_threads = 1);
+
+/**
+ * Convert MX quantized inputs, as produced by FloatOrHalfToMXQuantized, to
+ * float or half outputs. Unlike the fused rowwise formats, the size of the
+ * rows is given by the number of output columns, since fp4 rows with an odd
+ * number of elements are padded.
+ */
+template <typename OutputType>
+FBGEMM_API void MXQuantizedToFloatOrHalf(
+    MXFormat format,
+    const std::uint8_t* input,
+    size_t input_rows,
+    int output_columns,
+    OutputType* output,
+    int thread_id = 0,
+    int num_threads = 1);
+
+/**
+ * Greedy search for the range [xmin, xmax] of the n-bit rowwise quantization
+ * of a row that minimizes its L2 error, with the scale and bias rounded to
+ * float16 as FloatOrHalfToFusedNBitRowwiseQuantizedSBHalf stores them.
+ * Starting from the range passed in, normally the min and max of the row,
+ * either end is moved inwards by 1 / num_bins of the range at a time,
+ * whichever lowers the error, until the range is (1 - ratio) of what it
+ * was. The range with the lowest error on the way is returned.
+ * Elements outside of the range get clamped.
+ */
+FBGEMM_API void NBitRowwiseRangeSearchGreedy(
+    int bit_rate,
+    const float* input_row,
+    int input_columns,
+    float& xmin,
+    float& xmax,
+    int num_bins = 200,
+    float ratio = 0.16f);
+
+/**
+ * FloatOrHalfToFusedNBitRowwiseQuantizedSBHalf on num_threads threads, each
+ * quantizing a contiguous range of rows.
+ *
+ * @param num_threads number of ranges; if <= 0, fbgemmGetNumThreads()
+ * @param parallel_for runs the ranges; if empty, the FBGEMM thread pool
+ *                     (see fbgemmSetThreadPool)
+ */
+template <typename InputType>
+FBGEMM_API void FloatOrHalfToFusedNBitRowwiseQuantizedSBHalfParallel(
+    int bit_rate,
+    const InputType* input,
+    size_t input_rows,
+    int input_columns,
+    std::uint8_t* output,
+    int num_threads = 0,
+    const ParallelTasksExecutor& parallel_for = nullptr,
+    bool greedy_range_search = false);
+
+/**
+ * FloatOrHalfToFused8BitRowwiseQuantizedSBFloat on num_threads threads, each
+ * quantizing a contiguous range of rows. See
+ * FloatOrHalfToFusedNBitRowwiseQuantizedSBHalfParallel for the arguments.
+ */
+template <typename InputType>
+FBGEMM_API void FloatOrHalfToFused8BitRowwiseQuantizedSBFloatParallel(
+    const InputType* input,
+    size_t input_rows,
+    int input_columns,
+    std::uint8_t* output,
+    int num_threads = 0,
+    const ParallelTasksExecutor& parallel_for = nullptr);
+
+/**
+ * Receives the quantized rows [row_begin, row_begin + num_rows), e.g. to
+ * write them to a file. output is only valid during the call.
+ */
+using RowwiseQuantizedChunkConsumer = std::function<void(
+    const std::uint8_t* output,
+    size_t row_begin,
+    size_t num_rows)>;
+
+/**
+ * Quantizes the rows as FloatOrHalfToFusedNBitRowwiseQuantizedSBHalfParallel
+ * in chunks of chunk_rows rows, in order, and passes each chunk to consumer,
+ * so only one chunk of the quantized table is in memory at a time. The input
+ * is read once from start to end, so it can be a memory mapped file.
+ */
+template <typename InputType>
+FBGEMM_API void FloatOrHalfToFusedNBitRowwiseQuantizedSBHalfChunked(
+    int bit_rate,
+    const InputType* input,
+    size_t input_rows,
+    int input_columns,
+    const RowwiseQuantizedChunkConsumer& consumer,
+    size_t chunk_rows = 1 << 16,
+    int num_threads = 0,
+    const ParallelTasksExecutor& parallel_for = nullptr,
+    bool greedy_range_search = false);
+
+/**
+ * FloatOrHalfToFused8BitRowwiseQuantizedSBFloat in chunks. See
+ * FloatOrHalfToFusedNBitRowwiseQuantizedSBHalfChunked.
+ */
+template <typename InputType>
+FBGEMM_API void FloatOrHalfToFused8BitRowwiseQuantizedSBFloatChunked(
+    const InputType* input,
+    size_t input_rows,
+    int input_columns,
+    const RowwiseQuantizedChunkConsumer& consumer,
+    size_t chunk_rows = 1 << 16,
+    int num_threads = 0,
+    const ParallelTasksExecutor& parallel_for = nullptr);
 
 /**
  * Same as ToFusedNBitRowwiseQuantizedSBHalf but unoptimized.
@@ -343,7 +780,35 @@ FBGEMM_API void FloatOrHalfToFusedNBitRowwiseQuantizedSBHalfRef(
     const InputType* input,
     size_t input_rows,
     int input_columns,
-    std::uint8_t* output);
+    std::uint8_t* output,
+    bool greedy_range_search = false);
+
+/**
+ * Same as FloatOrHalfToFusedNBitGroupwiseQuantizedSBHalf but unoptimized.
+ * This should not be called directly except in testing.
+ */
+template <typename InputType>
+FBGEMM_API void FloatOrHalfToFusedNBitGroupwiseQuantizedSBHalfRef(
+    int bit_rate,
+    int group_size,
+    const InputType* input,
+    size_t input_rows,
+    int input_columns,
+    std::uint8_t* output,
+    bool greedy_range_search = false);
+
+/**
+ * Same as NBitRowwiseRangeSearchGreedy but unoptimized.
+ * This should not be called directly except in testing.
+ */
+FBGEMM_API void NBitRowwiseRangeSearchGreedyRef(
+    int bit_rate,
+    const float* input_row,
+    int input_columns,
+    float& xmin,
+    float& xmax,
+    int num_bins = 200,
+    float ratio = 0.16f);
 
 /**
  * Same as FloatOrHalfToFused8BitRowwiseQuantizedSBFloat but unoptimized.
@@ -368,6 +833,19 @@ FBGEMM_API void FusedNBitRowwiseQuantizedSBHalfToFloatOrHalfRef(
     int input_columns,
     OutputType* output);
 
+/**
+ * Same as FusedNBitGroupwiseQuantizedSBHalfToFloatOrHalf but unoptimized.
+ * This should not be called directly except in testing.
+ */
+template <typename OutputType>
+FBGEMM_API void FusedNBitGroupwiseQuantizedSBHalfToFloatOrHalfRef(
+    int bit_rate,
+    int group_size,
+    const uint8_t* input,
+    size_t input_rows,
+    int input_columns,
+    OutputType* output);
+
 /**
  * Same as Fused8BitRowwiseQuantizedSBFloatToFloatOrHalf but unoptimized.
  * This should not be called directly except in testing.
@@ -379,4 +857,30 @@ FBGEMM_API void Fused8BitRowwiseQuantizedSBFloatToFloatOrHalfRef(
     int input_columns,
     OutputType* output);
 
+/**
+ * Same as FloatOrHalfToFusedFP8RowwiseQuantized but unoptimized.
+ * This should not be called directly except in testing.
+ */
+template <typename InputType>
+FBGEMM_API void FloatOrHalfToFusedFP8RowwiseQuantizedRef(
+    const InputType* input,
+    size_t input_rows,
+    int input_columns,
+    std::uint8_t* output,
+    int exponent_bits = 4,
+    int exponent_bias = 7);
+
+/**
+ * Same as FusedFP8RowwiseQuantizedToFloatOrHalf but unoptimized.
+ * This should not be called directly except in testing.
+ */
+template <typename OutputType>
+FBGEMM_API void FusedFP8RowwiseQuantizedToFloatOrHalfRef(
+    const uint8_t* input,
+    size_t input_rows,
+    int input_columns,
+    OutputType* output,
+    int exponent_bits = 4,
+    int exponent_bias = 7);
+
 } // namespace fbgemm
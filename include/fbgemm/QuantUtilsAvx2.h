@@ -59,6 +59,18 @@ void QuantizeAvx2(
     int64_t len,
     const TensorQuantizationParams& qparams);
 
+template <int LEN, typename T, bool LEGACY>
+void QuantizeFixedLengthAvx2(
+    const float* src,
+    T* dst,
+    const TensorQuantizationParams& qparams);
+
+template <int LEN, typename T>
+void DequantizeFixedLengthAvx2(
+    const T* src,
+    float* dst,
+    const TensorQuantizationParams& qparams);
+
 template <typename T = std::uint8_t>
 void FusedQuantizeDequantizeAvx2(
     const float* src,
@@ -78,6 +90,30 @@ uint32_t FBGEMM_API Xor128(void);
 /// @brief Find the min and max value in a float matrix.
 void FBGEMM_API FindMinMax(const float* m, float* min, float* max, int64_t len);
 
+/// @ingroup fbgemm-quant-utils-avx2
+///
+/// QuantizeRowwiseDynamic with avx2, finding the range of each row and
+/// quantizing it in one visit of the row.
+void QuantizeRowwiseDynamicAvx2(
+    const float* src,
+    std::uint8_t* dst,
+    int64_t rows,
+    int cols,
+    float* scales,
+    std::int32_t* zero_points);
+
+/// @ingroup fbgemm-quant-utils-avx2
+///
+/// QuantizeWithRowOffsets with avx2, summing each row as it is quantized.
+template <bool LEGACY = true>
+void QuantizeWithRowOffsetsAvx2(
+    const float* src,
+    std::uint8_t* dst,
+    int64_t rows,
+    int cols,
+    const TensorQuantizationParams& qparams,
+    std::int32_t* row_offsets);
+
 void RequantizeFixedPointAvx2(
     const std::int32_t* src,
     std::uint8_t* dst,
@@ -90,6 +126,27 @@ void RequantizeAvx2(
     int len,
     const RequantizationParams& params);
 
+template <typename T>
+void RequantizePerChannelAvx2(
+    const std::int32_t* src,
+    T* dst,
+    std::int64_t rows,
+    int channels,
+    const float* multipliers,
+    const std::int32_t* zero_points,
+    int precision);
+
+template <typename T>
+void RequantizeFixedPointPerChannelAvx2(
+    const std::int32_t* src,
+    T* dst,
+    std::int64_t rows,
+    int channels,
+    const std::int32_t* multipliers,
+    const int* right_shifts,
+    const std::int32_t* zero_points,
+    int precision);
+
 /// @ingroup fbgemm-quant-utils-avx2
 ///
 /// Requantize with avx2 and bias is fused.
@@ -144,7 +201,20 @@ void FloatOrHalfToFusedNBitRowwiseQuantizedSBHalfAvx2(
     const InputType* input,
     size_t input_rows,
     int input_columns,
-    std::uint8_t* output);
+    std::uint8_t* output,
+    bool greedy_range_search = false);
+
+/**
+ * Sum of the squared errors of the n-bit rowwise quantization of a row with
+ * the given bias and scale, as used by NBitRowwiseRangeSearchGreedy.
+ */
+FBGEMM_API float NBitRowwiseQuantizationSquaredErrorAvx2(
+    int bit_rate,
+    const float* input_row,
+    int input_columns,
+    float bias,
+    float scale,
+    float inverse_scale);
 
 template <typename InputType>
 void FloatOrHalfToFused8BitRowwiseQuantizedSBFloatAvx2(
@@ -167,4 +237,22 @@ void Fused8BitRowwiseQuantizedSBFloatToFloatOrHalfAvx2(
     int input_columns,
     OutputType* output);
 
+template <typename InputType>
+void FloatOrHalfToFusedFP8RowwiseQuantizedAvx2(
+    const InputType* input,
+    size_t input_rows,
+    int input_columns,
+    std::uint8_t* output,
+    int exponent_bits,
+    int exponent_bias);
+
+template <typename OutputType>
+void FusedFP8RowwiseQuantizedToFloatOrHalfAvx2(
+    const std::uint8_t* input,
+    size_t input_rows,
+    int input_columns,
+    OutputType* output,
+    int exponent_bits,
+    int exponent_bias);
+
 } // namespace fbgemm
@@ -10,6 +10,7 @@
 
 #include <cstdint>
 #include "./FbgemmBuild.h"
+#include "./QuantUtilsAvx2.h"
 #include "./UtilsAvx2.h"
 
 /// @defgroup fbgemm-quant-utils-avx512 Quantization Utilities (AVX512)
@@ -35,4 +36,55 @@ FBGEMM_API void requantizeOutputProcessingGConvAvx512(
     int ld_out,
     int ld_in,
     const requantizationParams_t<BIAS_TYPE>& r);
+
+/// @ingroup fbgemm-quant-utils-avx512
+///
+/// QuantizeRowwiseDynamic with AVX512.
+void QuantizeRowwiseDynamicAvx512(
+    const float* src,
+    std::uint8_t* dst,
+    int64_t rows,
+    int cols,
+    float* scales,
+    std::int32_t* zero_points);
+
+/// @ingroup fbgemm-quant-utils-avx512
+///
+/// QuantizeWithRowOffsets with AVX512.
+template <bool LEGACY = true>
+void QuantizeWithRowOffsetsAvx512(
+    const float* src,
+    std::uint8_t* dst,
+    int64_t rows,
+    int cols,
+    const TensorQuantizationParams& qparams,
+    std::int32_t* row_offsets);
+
+/// @ingroup fbgemm-quant-utils-avx512
+///
+/// RequantizePerChannel with AVX512.
+template <typename T>
+void RequantizePerChannelAvx512(
+    const std::int32_t* src,
+    T* dst,
+    std::int64_t rows,
+    int channels,
+    const float* multipliers,
+    const std::int32_t* zero_points,
+    int precision);
+
+/// @ingroup fbgemm-quant-utils-avx512
+///
+/// RequantizeFixedPointPerChannel with AVX512.
+template <typename T>
+void RequantizeFixedPointPerChannelAvx512(
+    const std::int32_t* src,
+    T* dst,
+    std::int64_t rows,
+    int channels,
+    const std::int32_t* multipliers,
+    const int* right_shifts,
+    const std::int32_t* zero_points,
+    int precision);
+
 } // namespace fbgemm
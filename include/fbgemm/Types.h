@@ -36,6 +36,12 @@ namespace fbgemm {
 using float16 = std::uint16_t;
 using bfloat16 = std::uint16_t;
 
+// Element of a PackedGemmMatrixB holding bfloat16 weights. bfloat16 itself is
+// the same type as float16, so it cannot select the bf16 kernels.
+struct bfloat16_weight {
+  bfloat16 bits;
+};
+
 // The IEEE754 standard species a binary16 as having the following format:
 // SEEEEEMMMMMMMMMM
 // 0432109876543210
@@ -13,9 +13,15 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <string>
 #include <type_traits>
+#include <vector>
 
 namespace fbgemm {
 
@@ -54,7 +60,9 @@ enum class optimized_conv_t {
   pointwise,
   fastpath1d,
   im2col,
-  directconv
+  directconv,
+  winograd,
+  transposed
 };
 
 /**
@@ -111,6 +119,53 @@ FBGEMM_API void transpose_simd(
     T* dst,
     int64_t ld_dst);
 
+/**
+ * @brief Transpose a large matrix in L2 sized tiles split among threads.
+ *
+ * The tiles are transposed with transpose_simd. When the output is too large
+ * to stay in cache, each tile is transposed into a local buffer and copied
+ * out with non-temporal stores, so the output does not evict the input.
+ * Every thread in [0, num_threads) must be called for the whole transpose.
+ *
+ * @param M the number of rows of input matrix
+ * @param N the number of columns of input matrix
+ */
+template <typename T>
+FBGEMM_API void transpose_simd_parallel(
+    int64_t M,
+    int64_t N,
+    const T* src,
+    int64_t ld_src,
+    T* dst,
+    int64_t ld_dst,
+    int thread_id = 0,
+    int num_threads = 1);
+
+/**
+ * @brief Transpose a batch of matrices of the same shape.
+ *
+ * Matrix b is read at `src + b * stride_src` and written at
+ * `dst + b * stride_dst`. The instruction set is selected and the shape is
+ * checked once for the whole batch, which dominates for small matrices such
+ * as per-head blocks. The batch is split among threads.
+ *
+ * @param M the number of rows of each input matrix
+ * @param N the number of columns of each input matrix
+ */
+template <typename T>
+FBGEMM_API void transpose_simd_batched(
+    int64_t batch_size,
+    int64_t M,
+    int64_t N,
+    const T* src,
+    int64_t ld_src,
+    int64_t stride_src,
+    T* dst,
+    int64_t ld_dst,
+    int64_t stride_dst,
+    int thread_id = 0,
+    int num_threads = 1);
+
 /**
  * @brief Explicitly set instruction set to be used
  */
@@ -121,6 +176,52 @@ FBGEMM_API void fbgemmForceIsa(inst_set_t);
  */
 FBGEMM_API void fbgemmEnableAvx512Ymm(bool);
 
+/**
+ * @brief Overrides fbgemmForceIsa() on the calling thread for the lifetime
+ * of the object, so that latency critical and batch work sharing a process
+ * can run different kernels. Scopes nest, and an ISA the CPU does not support
+ * is ignored, leaving the ISA of the enclosing scope (or of fbgemmForceIsa())
+ * in effect. Matrices are packed for the ISA current when they are packed,
+ * and fbgemmPacked runs under the ISA of its B matrix, narrowed by
+ * fbgemmIsaForWork() for small problems. The scope carries over
+ * to the workers of fbgemmParallelFor, but the caller's own threads (e.g.
+ * OpenMP) each need their scope.
+ */
+class FBGEMM_API FbgemmIsaScope {
+ public:
+  explicit FbgemmIsaScope(inst_set_t isa);
+  ~FbgemmIsaScope();
+  FbgemmIsaScope(const FbgemmIsaScope&) = delete;
+  FbgemmIsaScope& operator=(const FbgemmIsaScope&) = delete;
+
+ private:
+  inst_set_t previous_isa_;
+};
+
+/**
+ * @brief Set the work, in multiply-adds, from which fbgemmIsaForWork() keeps
+ * the 512-bit kernels. The default 0 always keeps them.
+ */
+FBGEMM_API void fbgemmSetZmmMinWork(std::int64_t work);
+
+/**
+ * @brief The threshold set by fbgemmSetZmmMinWork().
+ */
+FBGEMM_API std::int64_t fbgemmGetZmmMinWork();
+
+/**
+ * @brief The ISA for a call of work multiply-adds, e.g. m * n * k of a GEMM
+ * or index_size * block_size of an embedding lookup: fbgemmInstructionSet(),
+ * narrowed to its 256-bit variant below the fbgemmSetZmmMinWork() threshold
+ * so that small calls do not lower the core frequency.
+ *
+ * fbgemmPacked applies it under an FbgemmIsaScope when the 256-bit variant
+ * packs the matrices the same way, and the embedding
+ * lookups of GenerateEmbeddingSpMDM* generated for a 512-bit ISA switch per
+ * call to the AVX2 kernel.
+ */
+FBGEMM_API inst_set_t fbgemmIsaForWork(std::int64_t work);
+
 /**
  * @brief Are we running on a Xeon-D cpu?
  */
@@ -141,6 +242,23 @@ FBGEMM_API bool fbgemmHasAvx2Support();
  */
 FBGEMM_API bool fbgemmHasAvx512VnniSupport();
 
+/**
+ * @brief Are we running on a AVX512_BF16 supported cpu?
+ */
+FBGEMM_API bool fbgemmHasAvx512Bf16Support();
+
+/**
+ * @brief Are we running on a AVX512_FP16 supported cpu?
+ */
+FBGEMM_API bool fbgemmHasAvx512Fp16Support();
+
+/**
+ * @brief Are we running on a AMX_INT8 supported cpu, with the tile registers
+ * enabled for this process? On Linux the first call requests them from the
+ * kernel.
+ */
+FBGEMM_API bool fbgemmHasAmxInt8Support();
+
 /**
  * @brief Are we running on a ARM Neon supported cpu?
  */
@@ -151,6 +269,11 @@ FBGEMM_API bool fbgemmHasArmNeonSupport();
  */
 FBGEMM_API bool fbgemmHasArmSve2Support();
 
+/**
+ * @brief Are we running on a ARM I8MM (int8 matrix multiply) supported cpu?
+ */
+FBGEMM_API bool fbgemmHasArmI8mmSupport();
+
 /**
  * @brief Retrieve current CPU instruction set
  */
@@ -235,6 +358,30 @@ FBGEMM_API thread_type_t fbgemmGetThreadPartition(
     int thread_id,
     int n_align = 64);
 
+/**
+ * @brief Shared by the threads running one fbgemmPacked call, which then take
+ * its (group, row block, column range) tiles one at a time instead of running
+ * a static partition, so that threads slowed down by uneven tiles or by other
+ * work do not hold back the others. fbgemmPackedGrouped takes whole GEMMs
+ * from it. Must be reset before it is used for another call.
+ */
+class FBGEMM_API GemmTileScheduler {
+ public:
+  /**
+   * @return The index of the next tile to run.
+   */
+  std::int64_t next() {
+    return next_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void reset() {
+    next_.store(0, std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<std::int64_t> next_{0};
+};
+
 template <int SIZE, typename T = std::int32_t>
 std::string arrayToString(const std::array<T, SIZE>& inp) {
   std::string out = "[";
@@ -358,13 +505,90 @@ FBGEMM_API void fbgemmPartition1DBlocked(
     std::int64_t& start,
     std::int64_t& end);
 
+/**
+ * @brief Interface of the thread pool that runs the parallel regions of
+ * FBGEMM, i.e. the multi-threaded functions that do not take a
+ * thread_id/num_threads pair from their caller. Applications bind FBGEMM to
+ * their own runtime (folly executor, at::parallel_for, ...) by implementing it
+ * and installing it with fbgemmSetThreadPool, which avoids oversubscribing the
+ * cores with a second pool of OpenMP threads.
+ */
+class FBGEMM_API ThreadPool {
+ public:
+  virtual ~ThreadPool() = default;
+
+  /**
+   * @brief Number of threads of the pool, which FBGEMM uses as the default
+   * number of tasks of its parallel regions.
+   */
+  virtual int getNumThreads() const = 0;
+
+  /**
+   * @brief Calls f(chunk_begin, chunk_end) on disjoint chunks covering
+   * [begin, end), possibly concurrently, and returns once all of them are
+   * done. Chunks should have about grain_size elements or more. f may be
+   * called from the calling thread, and nested calls must not deadlock.
+   */
+  virtual void parallelFor(
+      std::int64_t begin,
+      std::int64_t end,
+      std::int64_t grain_size,
+      const std::function<void(std::int64_t, std::int64_t)>& f) = 0;
+};
+
+/**
+ * @brief Installs the thread pool of the parallel regions of FBGEMM; nullptr
+ * restores the default one, which uses OpenMP when it is available and runs
+ * everything on the calling thread otherwise. It should be called before
+ * FBGEMM is used, as running parallel regions keep the pool they started on.
+ */
+FBGEMM_API void fbgemmSetThreadPool(std::shared_ptr<ThreadPool> pool);
+
+/**
+ * @brief The thread pool installed with fbgemmSetThreadPool or the default
+ * one.
+ */
+FBGEMM_API std::shared_ptr<ThreadPool> fbgemmGetThreadPool();
+
+/**
+ * @brief Number of threads of the current thread pool.
+ */
+FBGEMM_API int fbgemmGetNumThreads();
+
+/**
+ * @brief parallelFor of the current thread pool.
+ */
+FBGEMM_API void fbgemmParallelFor(
+    std::int64_t begin,
+    std::int64_t end,
+    std::int64_t grain_size,
+    const std::function<void(std::int64_t, std::int64_t)>& f);
+
+/**
+ * @brief Runs task(0), ..., task(num_tasks - 1), possibly concurrently, and
+ * returns when all of them are done. Functions that take one let callers
+ * plug in their own thread pool (e.g. at::parallel_for); fbgemmParallelTasks
+ * is the one for the FBGEMM thread pool.
+ */
+using ParallelTasksExecutor = std::function<
+    void(int num_tasks, const std::function<void(int task_id)>& task)>;
+
+/**
+ * @brief Runs task(task_id) for every task_id in [0, num_tasks) on the
+ * current thread pool, one task per chunk.
+ */
+FBGEMM_API void fbgemmParallelTasks(
+    int num_tasks,
+    const std::function<void(int task_id)>& task);
+
 /**
  * @brief A stable sorting algorithm. It sorts 8 bits at a time, hence in a
  * worst-case performing sizeof(K) / 8 passes. Providing meaningful max_value
  * may help reduce the number of passes performed by radix_sort. If
  * maybe_with_neg_vals is set to true, we are performing all possible passes,
  * up to a sign bit. If OpenMP is available in a build system, radix_sort works
- * in parallel.
+ * in parallel; if a thread pool was installed with fbgemmSetThreadPool, it
+ * runs on that pool instead.
  */
 template <typename K, typename V>
 FBGEMM_API std::pair<K*, V*> radix_sort_parallel(
@@ -376,12 +600,102 @@ FBGEMM_API std::pair<K*, V*> radix_sort_parallel(
     const int64_t max_value,
     const bool maybe_with_neg_vals = false);
 
+/**
+ * @brief Same as radix_sort_parallel above, but the work is split into
+ * num_tasks contiguous chunks of the input that are run by executor. Each
+ * pass runs the histogram and the scatter of the chunks as two rounds of
+ * tasks, so the tasks never wait on each other. A null executor runs the
+ * tasks sequentially on the calling thread.
+ */
+template <typename K, typename V>
+FBGEMM_API std::pair<K*, V*> radix_sort_parallel(
+    K* const inp_key_buf,
+    V* const inp_value_buf,
+    K* const tmp_key_buf,
+    V* const tmp_value_buf,
+    const int64_t elements_count,
+    const int64_t max_value,
+    const bool maybe_with_neg_vals,
+    const int num_tasks,
+    const ParallelTasksExecutor& executor);
+
+/**
+ * @brief Sorts elements_count keys with radix_sort_parallel and compacts them
+ * into their distinct values, e.g. to deduplicate embedding indices.
+ * unique_keys receives the distinct keys in ascending order and counts the
+ * number of occurrences of each of them; both must have room for
+ * elements_count entries. If inverse_indices is not null, inverse_indices[i]
+ * is set to the position of keys[i] in unique_keys. max_value,
+ * maybe_with_neg_vals, num_tasks and executor are as in radix_sort_parallel.
+ *
+ * @return the number of distinct keys
+ */
+template <typename K>
+FBGEMM_API int64_t radix_sort_unique_with_counts(
+    const K* const keys,
+    const int64_t elements_count,
+    const int64_t max_value,
+    const bool maybe_with_neg_vals,
+    K* const unique_keys,
+    int64_t* const counts,
+    int64_t* const inverse_indices = nullptr,
+    const int num_tasks = 1,
+    const ParallelTasksExecutor& executor = nullptr);
+
 /**
  * @brief Helper function that allows us to check whether radix_sort is
  * accelerated with OpenMP or not.
  */
 FBGEMM_API bool is_radix_sort_accelerated_with_openmp();
 
+/**
+ * @brief Exclusive prefix sum: output[i] = init + input[0] + ... +
+ * input[i - 1]. It scans in registers with AVX512 or AVX2 when available.
+ * output may be input.
+ *
+ * @tparam T can be int32_t or int64_t
+ * @return init plus the sum of the n inputs
+ */
+template <typename T>
+FBGEMM_API T exclusive_prefix_sum(
+    const int64_t n,
+    const T* const input,
+    T* const output,
+    const T init = 0);
+
+/**
+ * @brief Softmax over the rows of each column of the row-major
+ * [rows, cols] matrix input: output[r][c] = exp(input[r][c] - m[c]) / s[c],
+ * with m[c] the max of column c and s[c] the sum of its exponentials. The
+ * exponential is evaluated in registers with AVX512 or AVX2 when available.
+ * output may not be input.
+ *
+ * @param ld_input distance between the rows of input
+ * @param ld_output distance between the rows of output
+ */
+FBGEMM_API void column_softmax(
+    const int64_t rows,
+    const int64_t cols,
+    const float* const input,
+    const int64_t ld_input,
+    float* const output,
+    const int64_t ld_output);
+
+/**
+ * @brief Backward of column_softmax: grad_input[r][c] = (grad_output[r][c] -
+ * g[c]) * output[r][c], with g[c] the sum over the rows of grad_output *
+ * output in column c.
+ */
+FBGEMM_API void column_softmax_backward(
+    const int64_t rows,
+    const int64_t cols,
+    const float* const grad_output,
+    const int64_t ld_grad_output,
+    const float* const output,
+    const int64_t ld_output,
+    float* const grad_input,
+    const int64_t ld_grad_input);
+
 /**
  * Choosing which kernel (autovec/asmjit/ref) to use for nbit-CPU-TBE
  * Available kernels:
@@ -400,13 +714,20 @@ FBGEMM_API bool is_radix_sort_accelerated_with_openmp();
  *      On non-linux aarch64 we will fall back to ref.
  *   * Set FBGEMM_NO_AUTOVEC: on aarch64 linux we will use ref. On other
  *      platforms this will have no effect.
- *   * Set FBGEMM_NO_ASMJIT: on x86_64 we will use ref. On other
- *      platforms this will have no effect.
+ *   * Set FBGEMM_NO_ASMJIT: on x86_64 we will use ref, except for the
+ *      EmbeddingSpMDM and EmbeddingSpMDMNBit kernels of float output for
+ *      which AVX2 kernels are compiled ahead of time, by default of dims
+ *      32, 64, 128 and 256 (FBGEMM_PRECOMPILED_EMBEDDING_DIMS at build
+ *      time). On other platforms this will have no effect.
  *   * Set FBGEMM_NO_ASMJIT AND FBGEMM_FORCE_AUTOVEC: on x86_64 we will
  *      use autovec if these two variables are set at the same time.
  *      No effect on other platforms.
  *   * FBGEMM_FORCE_AUTOVEC will override FBGEMM_NO_AUTOVEC if they
  *      are set at the same time.
+ *   * Set FBGEMM_AUTOTUNE_EMBEDDING: the EmbeddingSpMDM and
+ *      EmbeddingSpMDMNBit generators time each kernel not disabled above
+ *      (autovec regardless of FBGEMM_FORCE_AUTOVEC) once per type,
+ *      bit rate, block size and weightedness, and use the fastest.
  *   * These variables are considered set as long as they exist regardless
  *      of content. That means assigning values like "1", "true", "y", "0",
  *      "false" or "no" has the same effect. The easiest way of setting a
@@ -415,5 +736,163 @@ FBGEMM_API bool is_radix_sort_accelerated_with_openmp();
 FBGEMM_API bool is_autovec_disabled();
 FBGEMM_API bool is_autovec_forced();
 FBGEMM_API bool is_asmjit_disabled();
+FBGEMM_API bool is_embedding_autotune_enabled();
+
+/**
+ * @brief Set the directory where JIT-generated kernels are persisted so that
+ * later processes can load them instead of generating them again. Kernels are
+ * keyed by kernel family, code cache key, instruction set and library build,
+ * so entries written by an incompatible build are simply regenerated. An empty
+ * string disables the persistent cache. The initial value is taken from the
+ * FBGEMM_JIT_CACHE_DIR environment variable; the directory must exist.
+ */
+FBGEMM_API void setJitCacheDir(const std::string& dir);
+FBGEMM_API std::string getJitCacheDir();
+
+/**
+ * @brief Counters of one JIT code cache.
+ *
+ * Bucket i of generation_time_us_histogram counts kernels whose generation
+ * took [2^i, 2^(i+1)) microseconds (bucket 0 also counts faster ones and the
+ * last bucket also counts slower ones). code_bytes is the executable memory
+ * held by the cache's live kernels.
+ */
+struct CodeCacheStats {
+  static constexpr int kNumHistogramBuckets = 24;
+
+  std::string name;
+  std::uint64_t hits = 0;
+  std::uint64_t misses = 0;
+  std::uint64_t evictions = 0;
+  std::uint64_t num_kernels = 0;
+  std::uint64_t code_bytes = 0;
+  std::array<std::uint64_t, kNumHistogramBuckets>
+      generation_time_us_histogram{};
+};
+
+/**
+ * @brief Snapshot the counters of every shared JIT code cache, one entry per
+ * kernel family ("gemm", "embedding", ...) in name order. The counters of a
+ * family sum all its caches, one per combination of types and instruction
+ * set. Thread local caches (e.g. the THREAD_LOCAL EmbeddingSpMDM kernels)
+ * are not reported.
+ */
+FBGEMM_API std::vector<CodeCacheStats> getCodeCacheStats();
+
+/**
+ * @brief Cap the number of kernels each shared code cache keeps; 0 (the
+ * default) means unlimited. When a cache goes over the cap the least recently
+ * used kernels are dropped from it and regenerated on their next use.
+ *
+ * Dropped kernels stay executable because callers may still hold pointers to
+ * them; their memory is returned by releaseEvictedCode().
+ */
+FBGEMM_API void setCodeCacheCapacity(std::size_t max_kernels);
+
+/**
+ * @brief Free the executable memory of all kernels evicted so far and return
+ * the number of bytes released. The caller must guarantee that no evicted
+ * kernel is running or will be called again, e.g. after unloading a model.
+ */
+FBGEMM_API std::size_t releaseEvictedCode();
+
+/**
+ * @brief Memory owned by the library: the buffers of fbgemmAlignedAlloc that
+ * are not freed yet (packed matrices, scratch buffers) and the NUMA replicas
+ * of packed matrices, and the executable memory of the JIT kernels.
+ *
+ * Buffers are counted with the size the heap reports for them, which can be
+ * a little over the requested one, and mapped buffers with the requested one.
+ * peak_bytes_in_use is the maximum of bytes_in_use since the start of the
+ * process or the last fbgemmResetPeakMemory().
+ */
+struct FbgemmMemoryStats {
+  std::size_t bytes_in_use = 0;
+  std::size_t peak_bytes_in_use = 0;
+  std::size_t num_buffers = 0;
+  std::size_t jit_code_bytes = 0;
+};
+
+FBGEMM_API FbgemmMemoryStats fbgemmGetMemoryStats();
+
+/**
+ * @brief Restart peak_bytes_in_use from the current bytes_in_use.
+ */
+FBGEMM_API void fbgemmResetPeakMemory();
+
+/**
+ * @brief Layouts of prepacked weight matrices with a serialized form.
+ */
+enum class PackedMatrixKind : std::uint32_t {
+  PackBMatrixInt8Acc32 = 1,
+  PackBMatrixInt8Acc16 = 2,
+  PackedGemmMatrixFP16 = 3,
+  PackedGemmMatrixBF16 = 4,
+};
+
+/**
+ * @brief Header of the serialized form of a prepacked weight matrix
+ * (PackBMatrix::serialize, PackedGemmMatrixB::serialize). It is followed by
+ * the packed buffer at data_offset, a multiple of kPackedMatrixDataAlignment,
+ * so that a memory-mapped file holding it can be used as the packed matrix
+ * directly. The blocking (and the instruction set it was chosen for) is part
+ * of the header, and loading rejects a buffer whose blocking differs from the
+ * one the kernels of the loading machine expect.
+ */
+struct PackedMatrixHeader {
+  static constexpr char kMagic[8] = {'F', 'B', 'G', 'E', 'M', 'M', 'P', 'K'};
+  static constexpr std::uint32_t kVersion = 1;
+
+  char magic[8];
+  std::uint32_t version;
+  PackedMatrixKind kind;
+  inst_set_t isa; ///< instruction set the blocking was chosen for
+  /// layout of the source matrix that unpack() restores (PackBMatrix)
+  matrix_op_t trans;
+  std::uint32_t elem_size;
+  std::int32_t rows;
+  std::int32_t cols;
+  std::int32_t groups;
+  std::int32_t brow; ///< block size along rows (KCB)
+  std::int32_t bcol; ///< block size along columns (NCB)
+  /// row interleave for PackBMatrix, kernel column blocks for
+  /// PackedGemmMatrixB
+  std::int32_t aux;
+  std::uint64_t data_offset;
+  std::uint64_t data_size;
+};
+
+constexpr std::size_t kPackedMatrixDataAlignment = 64;
+/// data_offset of the matrices serialized by this version
+constexpr std::size_t kPackedMatrixDataOffset =
+    (sizeof(PackedMatrixHeader) + kPackedMatrixDataAlignment - 1) /
+    kPackedMatrixDataAlignment * kPackedMatrixDataAlignment;
+
+/**
+ * @brief Header of a matrix packed for the current instruction set, with
+ * trans set to NoTranspose and data_offset to kPackedMatrixDataOffset.
+ */
+FBGEMM_API PackedMatrixHeader makePackedMatrixHeader(
+    PackedMatrixKind kind,
+    std::uint32_t elem_size,
+    std::int32_t rows,
+    std::int32_t cols,
+    std::int32_t groups,
+    std::int32_t brow,
+    std::int32_t bcol,
+    std::int32_t aux,
+    std::uint64_t data_size);
+
+/**
+ * @brief Validate the header at the start of the size bytes at buf, the
+ * serialized form of a matrix of the given kind, and return it. Throws
+ * std::runtime_error if the magic, version, kind or element size don't match,
+ * or if the packed data doesn't fit in size bytes or isn't aligned.
+ */
+FBGEMM_API const PackedMatrixHeader& readPackedMatrixHeader(
+    const void* buf,
+    std::size_t size,
+    PackedMatrixKind kind,
+    std::uint32_t elem_size);
 
 } // namespace fbgemm
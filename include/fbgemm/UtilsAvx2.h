@@ -10,8 +10,11 @@
 // This file defines common utilities used in code compiled with avx2/avx512
 // flags.
 
+#include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <string>
+#include <vector>
 
 namespace fbgemm {
 
@@ -89,4 +92,98 @@ fbgemmAlignedAlloc(size_t align, size_t size, bool raiseException = false);
  */
 FBGEMM_API void fbgemmAlignedFree(void* p);
 
+/**
+ * @brief Allocator behind fbgemmAlignedAlloc and fbgemmAlignedFree, which
+ * all buffers owned by the library (packed matrices, scratch buffers) come
+ * from. alloc returns nullptr on failure, and free is passed the size
+ * alloc was called with.
+ */
+struct FbgemmAllocator {
+  std::function<void*(size_t align, size_t size)> alloc;
+  std::function<void(void* p, size_t size)> free;
+};
+
+/**
+ * @brief Makes later fbgemmAlignedAlloc calls use allocator, or the default
+ * aligned malloc if allocator.alloc is empty. Buffers are freed by the
+ * allocator they came from, so this can be called at any time.
+ */
+FBGEMM_API void fbgemmSetAllocator(FbgemmAllocator allocator);
+
+/**
+ * @brief Allocator putting allocations of at least half a page on huge
+ * pages of page_size bytes (2 MB or 1 GB), bound to the memory of numa_node
+ * if it is not -1 (best effort, see fbgemmNumaNodeAllocator). Uses
+ * transparent huge pages if no huge pages of page_size are reserved.
+ * Smaller allocations, and all allocations on platforms other than Linux,
+ * use the default allocator.
+ */
+FBGEMM_API FbgemmAllocator
+fbgemmHugePageAllocator(size_t page_size = 2 << 20, int numa_node = -1);
+
+/**
+ * @brief Allocator binding allocations of at least 64 KB to the memory of
+ * numa_node. Binding is best effort, as with numa_alloc_onnode: the memory
+ * is still returned where the kernel rejects the policy.
+ */
+FBGEMM_API FbgemmAllocator fbgemmNumaNodeAllocator(int numa_node);
+
+/**
+ * @return The number of NUMA nodes of the host, 1 if it is not known.
+ */
+FBGEMM_API int fbgemmNumaNodeCount();
+
+/**
+ * @return The NUMA node of the CPU the calling thread runs on, 0 if it is
+ * not known.
+ */
+FBGEMM_API int fbgemmCurrentNumaNode();
+
+/**
+ * @brief Copies of a read-only buffer, one in the memory of each NUMA node,
+ * so that threads on every socket read their local copy.
+ */
+class FBGEMM_API NumaReplicas {
+ public:
+  NumaReplicas() = default;
+  NumaReplicas(const NumaReplicas&) = delete;
+  NumaReplicas& operator=(const NumaReplicas&) = delete;
+
+  /**
+   * @brief Copies the size bytes at src to the first num_nodes nodes,
+   * replacing earlier copies. Keeps no copies when num_nodes is 1.
+   */
+  void replicate(
+      const void* src,
+      size_t size,
+      int num_nodes = fbgemmNumaNodeCount());
+
+  /**
+   * @return The copy on the node of the calling thread (on node 0 for nodes
+   * without one), or nullptr if there are no copies.
+   */
+  void* local() const;
+
+  bool empty() const {
+    return buffers_.empty();
+  }
+
+  /**
+   * @return The bytes held by the copies.
+   */
+  size_t memoryFootprint() const {
+    return size_ * buffers_.size();
+  }
+
+  void clear();
+
+  ~NumaReplicas() {
+    clear();
+  }
+
+ private:
+  std::vector<void*> buffers_;
+  size_t size_{0};
+};
+
 } // namespace fbgemm
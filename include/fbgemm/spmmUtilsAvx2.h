@@ -35,4 +35,17 @@ FBGEMM_API void trRequantizeOpt(
     int ld_out,
     int ld_in,
     const trRequantizationParams_t& rParams);
+
+namespace internal {
+
+// Nonzero detection for packing dense matrices into the sparse formats.
+// Each writes the indices of the non-zero elements of src[0, n), in order,
+// to nonZeros unless it is null, and returns their number.
+
+/// Elements of 4 bytes, i.e. the 1 x 4 int8 blocks of BCSRMatrix<>.
+FBGEMM_API int findNonZeroWordsAvx2(const void* src, int n, int* nonZeros);
+FBGEMM_API int findNonZerosAvx2(const std::int8_t* src, int n, int* nonZeros);
+FBGEMM_API int findNonZerosAvx2(const float* src, int n, int* nonZeros);
+
+} // namespace internal
 } // namespace fbgemm
@@ -0,0 +1,486 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#define FBGEMM_EXPORTS
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#if defined(__GLIBC__) || defined(__ANDROID__)
+#include <malloc.h>
+#elif defined(__APPLE__)
+#include <malloc/malloc.h>
+#endif
+
+#ifdef __linux__
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+// __GLIBC_PREREQ cannot be used in the same #if as its defined() check: other
+// C libraries do not define it, and the expression would not parse.
+#ifdef __GLIBC_PREREQ
+#if __GLIBC_PREREQ(2, 29)
+#define FBGEMM_HAS_GETCPU
+#endif
+#endif
+#endif
+
+#include "fbgemm/Utils.h"
+
+namespace fbgemm {
+
+namespace {
+
+struct AllocatorState {
+  std::mutex mutex;
+  std::shared_ptr<const FbgemmAllocator> current;
+  // Buffers from allocators other than the default one, with the allocator
+  // freeing them and their size.
+  std::unordered_map<
+      void*,
+      std::pair<std::shared_ptr<const FbgemmAllocator>, size_t>>
+      buffers;
+};
+
+// Never destroyed, so that static objects owning packed matrices can still
+// free them at exit.
+AllocatorState& allocatorState() {
+  static AllocatorState* state = new AllocatorState();
+  return *state;
+}
+
+// Keep the default allocator free of locking until another one is used.
+std::atomic<bool> hasAllocator{false};
+std::atomic<bool> hasAllocatorBuffers{false};
+
+// Counters of fbgemmGetMemoryStats
+std::atomic<size_t> bytesInUse{0};
+std::atomic<size_t> peakBytesInUse{0};
+std::atomic<size_t> numBuffers{0};
+
+void recordAllocation(size_t size) {
+  const size_t in_use =
+      bytesInUse.fetch_add(size, std::memory_order_relaxed) + size;
+  numBuffers.fetch_add(1, std::memory_order_relaxed);
+  size_t peak = peakBytesInUse.load(std::memory_order_relaxed);
+  while (in_use > peak &&
+         !peakBytesInUse.compare_exchange_weak(
+             peak, in_use, std::memory_order_relaxed)) {
+  }
+}
+
+void recordFree(size_t size) {
+  bytesInUse.fetch_sub(size, std::memory_order_relaxed);
+  numBuffers.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void* defaultAlignedAlloc(size_t align, size_t size) {
+  void* aligned_mem = nullptr;
+#ifdef _MSC_VER
+  aligned_mem = _aligned_malloc(size, align);
+#else
+  if (posix_memalign(&aligned_mem, align, size)) {
+    return nullptr;
+  }
+#endif
+  return aligned_mem;
+}
+
+void defaultAlignedFree(void* p) {
+#ifdef _MSC_VER
+  _aligned_free(p);
+#else
+  free(p);
+#endif
+}
+
+// The default allocator's buffers are counted with their size, found without
+// a lookup so that freeing them takes no lock: the heap reports it where it
+// can be asked, and elsewhere it is kept in a header in front of the buffer.
+#if defined(__GLIBC__) || defined(__ANDROID__) || defined(__APPLE__)
+void* defaultCountedAlloc(size_t align, size_t size) {
+  return defaultAlignedAlloc(align, size);
+}
+
+size_t defaultCountedSize(void* p) {
+#ifdef __APPLE__
+  return malloc_size(p);
+#else
+  return malloc_usable_size(p);
+#endif
+}
+
+void defaultCountedFree(void* p) {
+  defaultAlignedFree(p);
+}
+#else
+struct CountedHeader {
+  size_t offset; // from the start of the allocation to the buffer
+  size_t size;
+};
+
+CountedHeader& countedHeader(void* p) {
+  return reinterpret_cast<CountedHeader*>(p)[-1];
+}
+
+void* defaultCountedAlloc(size_t align, size_t size) {
+  // align is a power of 2, so offset is a multiple of it.
+  const size_t offset = std::max(align, sizeof(CountedHeader));
+  if (size > SIZE_MAX - offset) {
+    return nullptr;
+  }
+  char* base = static_cast<char*>(defaultAlignedAlloc(
+      std::max(align, alignof(CountedHeader)), offset + size));
+  if (base == nullptr) {
+    return nullptr;
+  }
+  void* p = base + offset;
+  countedHeader(p) = CountedHeader{offset, size};
+  return p;
+}
+
+size_t defaultCountedSize(void* p) {
+  return countedHeader(p).size;
+}
+
+void defaultCountedFree(void* p) {
+  defaultAlignedFree(static_cast<char*>(p) - countedHeader(p).offset);
+}
+#endif
+
+#ifdef __linux__
+constexpr size_t kNumaMinSize = 64 << 10;
+constexpr int kMpolBind = 2;
+
+size_t roundUp(size_t size, size_t page_size) {
+  return (size + page_size - 1) / page_size * page_size;
+}
+
+void bindToNode(void* p, size_t length, int numa_node) {
+  if (numa_node < 0) {
+    return;
+  }
+  constexpr size_t kBitsPerWord = 8 * sizeof(unsigned long);
+  std::vector<unsigned long> nodemask(numa_node / kBitsPerWord + 1, 0);
+  nodemask[numa_node / kBitsPerWord] = 1UL << (numa_node % kBitsPerWord);
+  // Best effort, as in numa_alloc_onnode: without the policy the pages are
+  // still usable, just placed on first touch.
+  syscall(
+      SYS_mbind,
+      p,
+      length,
+      kMpolBind,
+      nodemask.data(),
+      nodemask.size() * kBitsPerWord + 1,
+      0);
+}
+
+void* mapHugePages(size_t size, size_t page_size, int numa_node) {
+  const size_t length = roundUp(size, page_size);
+  void* p = nullptr;
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+  const int log2_page_size = __builtin_ctzll(page_size);
+  p = mmap(
+      nullptr,
+      length,
+      PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB |
+          (log2_page_size << MAP_HUGE_SHIFT),
+      -1,
+      0);
+  if (p != MAP_FAILED) {
+    bindToNode(p, length, numa_node);
+    return p;
+  }
+#endif
+  // No huge pages of page_size are reserved: map a page more than needed,
+  // keep a page aligned range and ask for transparent huge pages.
+  void* raw = mmap(
+      nullptr,
+      length + page_size,
+      PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS,
+      -1,
+      0);
+  if (raw == MAP_FAILED) {
+    return nullptr;
+  }
+  const std::uintptr_t raw_begin = reinterpret_cast<std::uintptr_t>(raw);
+  const std::uintptr_t begin = roundUp(raw_begin, page_size);
+  if (begin != raw_begin) {
+    munmap(raw, begin - raw_begin);
+  }
+  if (raw_begin + page_size != begin) {
+    munmap(
+        reinterpret_cast<void*>(begin + length),
+        raw_begin + page_size - begin);
+  }
+  p = reinterpret_cast<void*>(begin);
+#ifdef MADV_HUGEPAGE
+  madvise(p, length, MADV_HUGEPAGE);
+#endif
+  bindToNode(p, length, numa_node);
+  return p;
+}
+
+void* mapPages(size_t size, int numa_node) {
+  const size_t length = roundUp(size, sysconf(_SC_PAGESIZE));
+  void* p = mmap(
+      nullptr,
+      length,
+      PROT_READ | PROT_WRITE,
+      MAP_PRIVATE | MAP_ANONYMOUS,
+      -1,
+      0);
+  if (p == MAP_FAILED) {
+    return nullptr;
+  }
+  bindToNode(p, length, numa_node);
+  return p;
+}
+#else
+FbgemmAllocator defaultAllocator() {
+  return FbgemmAllocator{
+      defaultAlignedAlloc, [](void* p, size_t) { defaultAlignedFree(p); }};
+}
+#endif // __linux__
+
+} // namespace
+
+void* fbgemmAlignedAlloc(
+    size_t align,
+    size_t size,
+    bool raiseException /*=false*/) {
+  void* aligned_mem = nullptr;
+  std::shared_ptr<const FbgemmAllocator> allocator;
+  if (hasAllocator.load(std::memory_order_acquire)) {
+    AllocatorState& state = allocatorState();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    allocator = state.current;
+  }
+  if (allocator) {
+    aligned_mem = allocator->alloc(align, size);
+    if (aligned_mem != nullptr) {
+      recordAllocation(size);
+      AllocatorState& state = allocatorState();
+      std::lock_guard<std::mutex> lock(state.mutex);
+      hasAllocatorBuffers.store(true, std::memory_order_release);
+      state.buffers.emplace(
+          aligned_mem, std::make_pair(std::move(allocator), size));
+    }
+  } else {
+    aligned_mem = defaultCountedAlloc(align, size);
+    if (aligned_mem != nullptr) {
+      recordAllocation(defaultCountedSize(aligned_mem));
+    }
+  }
+  // Throw std::bad_alloc in the case of memory allocation failure.
+  if (raiseException || aligned_mem == nullptr) {
+    throw std::bad_alloc();
+  }
+  return aligned_mem;
+}
+
+void fbgemmAlignedFree(void* p) {
+  if (p == nullptr) {
+    return;
+  }
+  if (hasAllocatorBuffers.load(std::memory_order_acquire)) {
+    std::pair<std::shared_ptr<const FbgemmAllocator>, size_t> buffer;
+    bool found = false;
+    {
+      AllocatorState& state = allocatorState();
+      std::lock_guard<std::mutex> lock(state.mutex);
+      auto it = state.buffers.find(p);
+      if (it != state.buffers.end()) {
+        buffer = std::move(it->second);
+        state.buffers.erase(it);
+        found = true;
+      }
+    }
+    if (found) {
+      recordFree(buffer.second);
+      buffer.first->free(p, buffer.second);
+      return;
+    }
+  }
+  recordFree(defaultCountedSize(p));
+  defaultCountedFree(p);
+}
+
+FbgemmMemoryStats fbgemmGetMemoryStats() {
+  FbgemmMemoryStats stats;
+  stats.bytes_in_use = bytesInUse.load(std::memory_order_relaxed);
+  stats.peak_bytes_in_use = peakBytesInUse.load(std::memory_order_relaxed);
+  stats.num_buffers = numBuffers.load(std::memory_order_relaxed);
+  for (const auto& cache : getCodeCacheStats()) {
+    stats.jit_code_bytes += cache.code_bytes;
+  }
+  return stats;
+}
+
+void fbgemmResetPeakMemory() {
+  peakBytesInUse.store(
+      bytesInUse.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void fbgemmSetAllocator(FbgemmAllocator allocator) {
+  if (allocator.alloc && !allocator.free) {
+    throw std::runtime_error("FbgemmAllocator has alloc but no free");
+  }
+  AllocatorState& state = allocatorState();
+  std::lock_guard<std::mutex> lock(state.mutex);
+  if (allocator.alloc) {
+    state.current =
+        std::make_shared<const FbgemmAllocator>(std::move(allocator));
+  } else {
+    state.current.reset();
+  }
+  hasAllocator.store(state.current != nullptr, std::memory_order_release);
+}
+
+FbgemmAllocator fbgemmHugePageAllocator(size_t page_size, int numa_node) {
+#ifdef __linux__
+  if (page_size == 0 || (page_size & (page_size - 1)) ||
+      page_size < static_cast<size_t>(sysconf(_SC_PAGESIZE))) {
+    throw std::runtime_error(
+        "huge page size " + std::to_string(page_size) +
+        " is not a power of 2 multiple of the page size");
+  }
+  return FbgemmAllocator{
+      [=](size_t align, size_t size) {
+        if (size < page_size / 2) {
+          return defaultAlignedAlloc(align, size);
+        }
+        return align <= page_size ? mapHugePages(size, page_size, numa_node)
+                                  : nullptr;
+      },
+      [=](void* p, size_t size) {
+        if (size < page_size / 2) {
+          defaultAlignedFree(p);
+        } else {
+          munmap(p, roundUp(size, page_size));
+        }
+      }};
+#else
+  (void)page_size;
+  (void)numa_node;
+  return defaultAllocator();
+#endif
+}
+
+FbgemmAllocator fbgemmNumaNodeAllocator(int numa_node) {
+#ifdef __linux__
+  return FbgemmAllocator{
+      [=](size_t align, size_t size) {
+        return size < kNumaMinSize ? defaultAlignedAlloc(align, size)
+                                   : mapPages(size, numa_node);
+      },
+      [](void* p, size_t size) {
+        if (size < kNumaMinSize) {
+          defaultAlignedFree(p);
+        } else {
+          munmap(p, roundUp(size, sysconf(_SC_PAGESIZE)));
+        }
+      }};
+#else
+  (void)numa_node;
+  return defaultAllocator();
+#endif
+}
+
+int fbgemmNumaNodeCount() {
+  static const int count = [] {
+    int nodes = 1;
+#ifdef __linux__
+    // A list of ranges such as "0-1,3".
+    std::ifstream online("/sys/devices/system/node/online");
+    std::string range;
+    while (std::getline(online, range, ',')) {
+      const auto dash = range.find('-');
+      const std::string last =
+          dash == std::string::npos ? range : range.substr(dash + 1);
+      try {
+        nodes = std::max(nodes, std::stoi(last) + 1);
+      } catch (const std::exception&) {
+        return 1;
+      }
+    }
+#endif
+    return nodes;
+  }();
+  return count;
+}
+
+int fbgemmCurrentNumaNode() {
+#ifdef __linux__
+  unsigned cpu = 0, node = 0;
+#ifdef FBGEMM_HAS_GETCPU
+  // Goes through the vDSO, without entering the kernel.
+  if (getcpu(&cpu, &node) == 0) {
+    return node;
+  }
+#else
+  if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+    return node;
+  }
+#endif
+#endif
+  return 0;
+}
+
+void NumaReplicas::replicate(const void* src, size_t size, int num_nodes) {
+  clear();
+  if (num_nodes <= 1) {
+    return;
+  }
+  size_ = size;
+  for (int node = 0; node < num_nodes; ++node) {
+    void* p = fbgemmNumaNodeAllocator(node).alloc(64, size);
+    if (p == nullptr) {
+      clear();
+      throw std::bad_alloc();
+    }
+    recordAllocation(size);
+    // Copying after binding places the pages on node, whichever node the
+    // calling thread runs on.
+    std::memcpy(p, src, size);
+    buffers_.push_back(p);
+  }
+}
+
+void* NumaReplicas::local() const {
+  if (buffers_.empty()) {
+    return nullptr;
+  }
+  const size_t node = fbgemmCurrentNumaNode();
+  return buffers_[node < buffers_.size() ? node : 0];
+}
+
+void NumaReplicas::clear() {
+  for (size_t node = 0; node < buffers_.size(); ++node) {
+    fbgemmNumaNodeAllocator(node).free(buffers_[node], size_);
+    recordFree(size_);
+  }
+  buffers_.clear();
+  size_ = 0;
+}
+
+} // namespace fbgemm
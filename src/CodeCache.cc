@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#define FBGEMM_EXPORTS
+#include "./CodeCache.h"
+
+#include <thread>
+
+namespace fbgemm {
+
+namespace {
+
+struct CodeCacheRegistry {
+  std::mutex mutex;
+  std::vector<CodeCacheBase*> caches;
+  std::atomic<std::size_t> capacity{0};
+};
+
+CodeCacheRegistry& codeCacheRegistry() {
+  // Intentionally leaked: code caches are static objects of other translation
+  // units and unregister themselves during static destruction.
+  static CodeCacheRegistry* registry = new CodeCacheRegistry();
+  return *registry;
+}
+
+} // namespace
+
+CodeCacheGeneration*& currentCodeCacheGeneration() {
+  static thread_local CodeCacheGeneration* generation = nullptr;
+  return generation;
+}
+
+CodeCacheBase::CodeCacheBase(const char* name) : name_(name) {
+  CodeCacheRegistry& registry = codeCacheRegistry();
+  std::unique_lock<std::mutex> lock(registry.mutex);
+  registry.caches.push_back(this);
+}
+
+CodeCacheBase::~CodeCacheBase() {
+  CodeCacheRegistry& registry = codeCacheRegistry();
+  std::unique_lock<std::mutex> lock(registry.mutex);
+  registry.caches.erase(
+      std::remove(registry.caches.begin(), registry.caches.end(), this),
+      registry.caches.end());
+}
+
+std::size_t CodeCacheBase::defaultCapacity() {
+  return codeCacheRegistry().capacity.load(std::memory_order_relaxed);
+}
+
+unsigned CodeCacheBase::threadSlot() {
+  static std::atomic<unsigned> nextSlot{0};
+  static thread_local unsigned slot =
+      nextSlot.fetch_add(1, std::memory_order_relaxed);
+  return slot;
+}
+
+void CodeCacheBase::waitForReaders() {
+  // A reader that enters its scope after its counter is seen at zero loads
+  // the new table: the seq_cst loads here follow the store of the table.
+  for (const auto& counter : readers_) {
+    while (counter.value.load(std::memory_order_seq_cst) != 0) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+void CodeCacheBase::recordGeneration(
+    std::chrono::steady_clock::duration elapsed) {
+  misses_.fetch_add(1, std::memory_order_relaxed);
+  const auto us =
+      std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+  int bucket = 0;
+  while (bucket + 1 < CodeCacheStats::kNumHistogramBuckets &&
+         (std::int64_t(2) << bucket) <= us) {
+    ++bucket;
+  }
+  generationTimeHistogram_[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+void CodeCacheBase::fillStats(CodeCacheStats& stats) const {
+  stats.name = name_;
+  for (const auto& counter : hits_) {
+    stats.hits += counter.value.load(std::memory_order_relaxed);
+  }
+  stats.misses = misses_.load(std::memory_order_relaxed);
+  stats.evictions = evictions_.load(std::memory_order_relaxed);
+  for (int i = 0; i < CodeCacheStats::kNumHistogramBuckets; ++i) {
+    stats.generation_time_us_histogram[i] =
+        generationTimeHistogram_[i].load(std::memory_order_relaxed);
+  }
+}
+
+std::vector<CodeCacheStats> getCodeCacheStats() {
+  CodeCacheRegistry& registry = codeCacheRegistry();
+  std::unique_lock<std::mutex> lock(registry.mutex);
+  // Each instantiation of a generator template has its own cache with the
+  // name of the generator, so the caches of a name are summed up. The order
+  // of the names would otherwise depend on the static initialization order.
+  std::map<std::string, CodeCacheStats> stats_by_name;
+  for (CodeCacheBase* cache : registry.caches) {
+    const CodeCacheStats stats = cache->getStats();
+    CodeCacheStats& total = stats_by_name[stats.name];
+    total.name = stats.name;
+    total.hits += stats.hits;
+    total.misses += stats.misses;
+    total.evictions += stats.evictions;
+    total.num_kernels += stats.num_kernels;
+    total.code_bytes += stats.code_bytes;
+    for (int i = 0; i < CodeCacheStats::kNumHistogramBuckets; ++i) {
+      total.generation_time_us_histogram[i] +=
+          stats.generation_time_us_histogram[i];
+    }
+  }
+  std::vector<CodeCacheStats> stats;
+  stats.reserve(stats_by_name.size());
+  for (auto& [name, total] : stats_by_name) {
+    stats.push_back(std::move(total));
+  }
+  return stats;
+}
+
+void setCodeCacheCapacity(std::size_t max_kernels) {
+  CodeCacheRegistry& registry = codeCacheRegistry();
+  std::unique_lock<std::mutex> lock(registry.mutex);
+  registry.capacity.store(max_kernels, std::memory_order_relaxed);
+  for (CodeCacheBase* cache : registry.caches) {
+    cache->setCapacity(max_kernels);
+  }
+}
+
+std::size_t releaseEvictedCode() {
+  CodeCacheRegistry& registry = codeCacheRegistry();
+  std::unique_lock<std::mutex> lock(registry.mutex);
+  std::size_t released = 0;
+  for (CodeCacheBase* cache : registry.caches) {
+    released += cache->releaseEvicted();
+  }
+  return released;
+}
+
+} // namespace fbgemm
@@ -7,21 +7,22 @@
  */
 
 #pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
 #include <future>
 #include <map>
-
-#if __cplusplus >= 201402L && !defined(__APPLE__)
-// For C++14, use shared_timed_mutex.
-// some macOS C++14 compilers don't support shared_timed_mutex.
-#define FBGEMM_USE_SHARED_TIMED_MUTEX
-#endif
-
-#ifdef FBGEMM_USE_SHARED_TIMED_MUTEX
-#include <shared_mutex>
-#else
+#include <memory>
 #include <mutex>
-#endif
+#include <tuple>
+#include <vector>
+
+#include "fbgemm/Utils.h"
 
 #ifdef FBCODE_CAFFE2
 #include <folly/container/F14Map.h>
@@ -29,69 +30,386 @@
 
 namespace fbgemm {
 
+/**
+ * @brief Hash for code cache keys, which are tuples of scalars.
+ */
+template <typename KEY>
+struct CodeCacheKeyHash {
+  std::size_t operator()(const KEY& key) const {
+    return std::hash<KEY>()(key);
+  }
+};
+
+template <typename... ARGS>
+struct CodeCacheKeyHash<std::tuple<ARGS...>> {
+  std::size_t operator()(const std::tuple<ARGS...>& key) const {
+    std::size_t seed = 0;
+    std::apply(
+        [&seed](const auto&... args) {
+          ((seed ^= std::hash<std::decay_t<decltype(args)>>()(args) +
+               0x9e3779b9 + (seed << 6) + (seed >> 2)),
+           ...);
+        },
+        key);
+    return seed;
+  }
+};
+
+/**
+ * @brief What the generator function of a code cache reports back about the
+ * kernel it produced: its size and how to free it.
+ *
+ * getOrCreate installs one of these for the calling thread while the
+ * generator runs; addJitKernel/loadJitKernel fill it in.
+ */
+struct CodeCacheGeneration {
+  std::size_t codeBytes = 0;
+  std::function<void()> release;
+};
+
+/**
+ * @brief The generation record of the calling thread, nullptr outside of a
+ * code cache generator.
+ */
+FBGEMM_API CodeCacheGeneration*& currentCodeCacheGeneration();
+
+/**
+ * @brief Installs a generation record for the calling thread for the lifetime
+ * of the scope.
+ */
+class CodeCacheGenerationScope {
+ public:
+  explicit CodeCacheGenerationScope(CodeCacheGeneration& generation)
+      : outer_(currentCodeCacheGeneration()) {
+    currentCodeCacheGeneration() = &generation;
+  }
+  ~CodeCacheGenerationScope() {
+    currentCodeCacheGeneration() = outer_;
+  }
+
+  CodeCacheGenerationScope(const CodeCacheGenerationScope&) = delete;
+  CodeCacheGenerationScope& operator=(const CodeCacheGenerationScope&) = delete;
+
+ private:
+  CodeCacheGeneration* outer_;
+};
+
+/**
+ * @brief Type erased part of the shared code caches: counters and the global
+ * registry used by getCodeCacheStats() and friends.
+ */
+class FBGEMM_API CodeCacheBase {
+ public:
+  explicit CodeCacheBase(const char* name);
+  virtual ~CodeCacheBase();
+
+  /**
+   * @brief Capacity given to caches at construction, set through
+   * setCodeCacheCapacity().
+   */
+  static std::size_t defaultCapacity();
+
+  CodeCacheBase(const CodeCacheBase&) = delete;
+  CodeCacheBase& operator=(const CodeCacheBase&) = delete;
+
+  virtual CodeCacheStats getStats() = 0;
+  virtual void setCapacity(std::size_t maxKernels) = 0;
+  virtual std::size_t releaseEvicted() = 0;
+
+ protected:
+  static constexpr int kNumHitCounters = 16;
+
+  struct alignas(64) PaddedCounter {
+    std::atomic<std::uint64_t> value{0};
+  };
+
+  void recordHit() {
+    hits_[threadSlot() % kNumHitCounters].value.fetch_add(
+        1, std::memory_order_relaxed);
+  }
+
+  /**
+   * Marks the calling thread as reading the lock-free table for the lifetime
+   * of the scope, so that waitForReaders() does not return under it.
+   */
+  class ReadScope {
+   public:
+    explicit ReadScope(CodeCacheBase& cache)
+        : counter_(cache.readers_[threadSlot() % kNumHitCounters].value) {
+      counter_.fetch_add(1, std::memory_order_seq_cst);
+    }
+    ~ReadScope() {
+      counter_.fetch_sub(1, std::memory_order_release);
+    }
+
+    ReadScope(const ReadScope&) = delete;
+    ReadScope& operator=(const ReadScope&) = delete;
+
+   private:
+    std::atomic<std::uint64_t>& counter_;
+  };
+
+  // Returns once every reader that might have loaded a table unpublished
+  // before the call has left its ReadScope.
+  void waitForReaders();
+
+  void recordGeneration(std::chrono::steady_clock::duration elapsed);
+
+  void fillStats(CodeCacheStats& stats) const;
+
+  const char* name_;
+  std::atomic<std::uint64_t> misses_{0};
+  std::atomic<std::uint64_t> evictions_{0};
+  std::array<std::atomic<std::uint64_t>, CodeCacheStats::kNumHistogramBuckets>
+      generationTimeHistogram_{};
+
+ private:
+  static unsigned threadSlot();
+
+  // Hits are counted on the lock-free path, so they are spread over a few
+  // cache lines to keep concurrent readers from contending on one counter.
+  std::array<PaddedCounter, kNumHitCounters> hits_;
+  // Readers in a ReadScope, spread like the hits.
+  std::array<PaddedCounter, kNumHitCounters> readers_;
+};
+
 /**
  * @brief Thread safe cache for microkernels, ensures single creation per key.
+ *
+ * Lookups of kernels that are already generated do not take any lock: they
+ * probe an open-addressed table of immutable entries that is only modified
+ * under the mutex and published with release semantics. A retired table and
+ * the entries evicted with it are freed once the readers that may still probe
+ * them are done, so the lookups only pay for an uncontended counter. The code
+ * of evicted kernels is kept until releaseEvicted(), since callers may still
+ * run it. Misses
+ * fall back to the mutex protected map of futures, which guarantees that each
+ * kernel is generated exactly once.
+ *
  * @tparam KEY Type of unique key (typically a tuple)
  * @tparam VALUE Type of the microkernel function (Typically a function pointer)
  * @tparam THREAD_LOCAL use thread local and avoid locking (default false)
  */
 template <typename KEY, typename VALUE, bool THREAD_LOCAL = false>
-class CodeCache {
+class CodeCache : public CodeCacheBase {
  private:
+  struct Entry {
+    Entry(const KEY& k, VALUE v) : key(k), value(v) {}
+
+    const KEY key;
+    const VALUE value;
+    // Value of epoch_ when the entry was last used; only maintained when the
+    // cache has a capacity.
+    mutable std::atomic<std::uint64_t> lastUse{0};
+    std::size_t codeBytes = 0;
+    std::function<void()> release;
+  };
+
+  struct Table {
+    explicit Table(std::size_t capacity)
+        : mask(capacity - 1),
+          slots(new std::atomic<const Entry*>[capacity]) {
+      for (std::size_t i = 0; i < capacity; ++i) {
+        slots[i].store(nullptr, std::memory_order_relaxed);
+      }
+    }
+
+    // Only called with mutex_ held; the release store pairs with the acquire
+    // load in lookup_().
+    void insert(const Entry* entry) {
+      std::size_t i = CodeCacheKeyHash<KEY>()(entry->key) & mask;
+      while (slots[i].load(std::memory_order_relaxed) != nullptr) {
+        i = (i + 1) & mask;
+      }
+      slots[i].store(entry, std::memory_order_release);
+    }
+
+    const std::size_t mask;
+    std::unique_ptr<std::atomic<const Entry*>[]> slots;
+  };
+
+  static constexpr std::size_t kInitialCapacity = 16;
+
 #ifdef FBCODE_CAFFE2
   folly::F14FastMap<KEY, std::shared_future<VALUE>> values_;
 #else
   std::map<KEY, std::shared_future<VALUE>> values_;
 #endif
 
-#ifdef FBGEMM_USE_SHARED_TIMED_MUTEX
-  std::shared_timed_mutex mutex_;
-#else
   std::mutex mutex_;
-#endif
+
+  std::atomic<const Table*> table_{nullptr};
+  std::atomic<std::size_t> capacity_{defaultCapacity()};
+  std::atomic<std::uint64_t> epoch_{0};
+  // The current table, guarded by mutex_.
+  std::unique_ptr<Table> ownedTable_;
+  // Published entries, guarded by mutex_.
+  std::vector<std::unique_ptr<Entry>> entries_;
+  // Size and release of the code of evicted entries, guarded by mutex_.
+  std::vector<std::pair<std::size_t, std::function<void()>>> evictedCode_;
+  std::size_t codeBytes_ = 0;
+
+  // Must be called in a ReadScope. The seq_cst load pairs with the seq_cst
+  // increment of the scope and the store in rebuildTable_().
+  const Entry* lookup_(const KEY& key) const {
+    const Table* table = table_.load(std::memory_order_seq_cst);
+    if (table == nullptr) {
+      return nullptr;
+    }
+    for (std::size_t i = CodeCacheKeyHash<KEY>()(key) & table->mask;;
+         i = (i + 1) & table->mask) {
+      const Entry* entry = table->slots[i].load(std::memory_order_acquire);
+      if (entry == nullptr || entry->key == key) {
+        return entry;
+      }
+    }
+  }
+
+  // Replaces the table and frees the old one along with evicted, once no
+  // reader can reach them. Must be called with mutex_ held.
+  void rebuildTable_(
+      std::size_t capacity,
+      std::vector<std::unique_ptr<Entry>> evicted = {}) {
+    auto table = std::make_unique<Table>(capacity);
+    for (const auto& entry : entries_) {
+      table->insert(entry.get());
+    }
+    table_.store(table.get(), std::memory_order_seq_cst);
+    std::unique_ptr<Table> retired = std::move(ownedTable_);
+    ownedTable_ = std::move(table);
+    if (retired || !evicted.empty()) {
+      waitForReaders();
+    }
+  }
+
+  // Drop the least recently used entries until the cache is within its
+  // capacity. Must be called with mutex_ held.
+  void evict_(std::size_t capacity) {
+    if (capacity == 0 || entries_.size() <= capacity) {
+      return;
+    }
+    std::stable_sort(
+        entries_.begin(),
+        entries_.end(),
+        [](const std::unique_ptr<Entry>& a, const std::unique_ptr<Entry>& b) {
+          return a->lastUse.load(std::memory_order_relaxed) >
+              b->lastUse.load(std::memory_order_relaxed);
+        });
+    std::vector<std::unique_ptr<Entry>> evicted;
+    while (entries_.size() > capacity) {
+      std::unique_ptr<Entry>& entry = entries_.back();
+      values_.erase(entry->key);
+      codeBytes_ -= entry->codeBytes;
+      evictions_.fetch_add(1, std::memory_order_relaxed);
+      evictedCode_.emplace_back(entry->codeBytes, std::move(entry->release));
+      evicted.push_back(std::move(entry));
+      entries_.pop_back();
+    }
+    rebuildTable_(ownedTable_->mask + 1, std::move(evicted));
+  }
+
+  // Must be called with mutex_ held.
+  void publish_(const KEY& key, VALUE value, CodeCacheGeneration& generation) {
+    const std::uint64_t epoch =
+        epoch_.fetch_add(1, std::memory_order_relaxed) + 1;
+    entries_.push_back(std::make_unique<Entry>(key, value));
+    Entry* entry = entries_.back().get();
+    entry->lastUse.store(epoch, std::memory_order_relaxed);
+    entry->codeBytes = generation.codeBytes;
+    entry->release = std::move(generation.release);
+    codeBytes_ += entry->codeBytes;
+
+    const Table* table = table_.load(std::memory_order_relaxed);
+    // Keep the load factor at or below 1/2 so probe sequences stay short.
+    if (table == nullptr || 2 * entries_.size() > table->mask + 1) {
+      rebuildTable_(
+          table == nullptr ? kInitialCapacity : 2 * (table->mask + 1));
+    } else {
+      ownedTable_->insert(entry);
+    }
+    evict_(capacity_.load(std::memory_order_relaxed));
+  }
 
  public:
   CodeCache(const CodeCache&) = delete;
   CodeCache& operator=(const CodeCache&) = delete;
 
-  CodeCache() {}
+  explicit CodeCache(const char* name = "unnamed") : CodeCacheBase(name) {}
 
   template <typename GENFUNC>
   VALUE getOrCreate(const KEY& key, GENFUNC generatorFunction) {
-#ifdef FBGEMM_USE_SHARED_TIMED_MUTEX
-    std::shared_lock<std::shared_timed_mutex> sharedLock(mutex_);
-#else
-    std::unique_lock<std::mutex> uniqueLock(mutex_);
-#endif
+    {
+      ReadScope scope(*this);
+      if (const Entry* entry = lookup_(key)) {
+        recordHit();
+        if (capacity_.load(std::memory_order_relaxed) != 0) {
+          // Only write when the epoch moved so hot entries stay read-only.
+          const std::uint64_t epoch = epoch_.load(std::memory_order_relaxed);
+          if (entry->lastUse.load(std::memory_order_relaxed) != epoch) {
+            entry->lastUse.store(epoch, std::memory_order_relaxed);
+          }
+        }
+        return entry->value;
+      }
+    }
 
-    // Check for existence of the key
+    std::unique_lock<std::mutex> uniqueLock(mutex_);
+    // Need to look up again because another thread may be generating the
+    // same kernel, in which case we wait for its result.
     auto it = values_.find(key);
     if (it != values_.end()) {
-      return it->second.get();
-    } else {
-#ifdef FBGEMM_USE_SHARED_TIMED_MUTEX
-      sharedLock.unlock();
-      std::unique_lock<std::shared_timed_mutex> uniqueLock(mutex_);
-
-      // Need to look up again because there could be race condition from
-      // the time gap between sharedLock.unlock() and creating uniqueLock.
-      it = values_.find(key);
-      if (it == values_.end()) {
-#endif
-        std::promise<VALUE> returnPromise;
-        values_[key] = returnPromise.get_future().share();
-
-        uniqueLock.unlock();
-        // The value (code) generation is not happening under a lock
-        VALUE val = generatorFunction();
-        returnPromise.set_value(val);
-        return val;
-#ifdef FBGEMM_USE_SHARED_TIMED_MUTEX
-      } else {
-        return it->second.get();
+      std::shared_future<VALUE> future = it->second;
+      uniqueLock.unlock();
+      recordHit();
+      return future.get();
+    }
+
+    std::promise<VALUE> returnPromise;
+    values_[key] = returnPromise.get_future().share();
+
+    uniqueLock.unlock();
+    // The value (code) generation is not happening under a lock
+    CodeCacheGeneration generation;
+    VALUE val;
+    {
+      CodeCacheGenerationScope scope(generation);
+      const auto start = std::chrono::steady_clock::now();
+      val = generatorFunction();
+      recordGeneration(std::chrono::steady_clock::now() - start);
+    }
+    returnPromise.set_value(val);
+
+    uniqueLock.lock();
+    publish_(key, val, generation);
+    return val;
+  }
+
+  CodeCacheStats getStats() override {
+    CodeCacheStats stats;
+    fillStats(stats);
+    std::unique_lock<std::mutex> lock(mutex_);
+    stats.num_kernels = entries_.size();
+    stats.code_bytes = codeBytes_;
+    return stats;
+  }
+
+  void setCapacity(std::size_t maxKernels) override {
+    std::unique_lock<std::mutex> lock(mutex_);
+    capacity_.store(maxKernels, std::memory_order_relaxed);
+    evict_(maxKernels);
+  }
+
+  std::size_t releaseEvicted() override {
+    std::unique_lock<std::mutex> lock(mutex_);
+    std::size_t released = 0;
+    for (auto& [codeBytes, release] : evictedCode_) {
+      if (release) {
+        release();
+        released += codeBytes;
       }
-#endif
     }
+    evictedCode_.clear();
+    return released;
   }
 };
 
@@ -116,7 +434,7 @@ class CodeCache<KEY, VALUE, /*THREAD_LOCAL=*/true> {
   CodeCache(const CodeCache&) = delete;
   CodeCache& operator=(const CodeCache&) = delete;
 
-  CodeCache() {}
+  explicit CodeCache(const char* /* name */ = "unnamed") {}
 
   template <typename GENFUNC>
   VALUE getOrCreate(const KEY& key, GENFUNC generatorFunction) {
@@ -0,0 +1,200 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#define FBGEMM_EXPORTS
+#include "./CodeStorage.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+// Kernels persisted by one build of the library are never loaded by another
+// one. The CMake build generates the ID from a hash of all the library
+// sources. Other builds can pass their own, e.g. a content hash, and
+// otherwise fall back to the time this file was compiled.
+#ifdef FBGEMM_JIT_CACHE_BUILD_ID_HEADER
+#include FBGEMM_JIT_CACHE_BUILD_ID_HEADER
+#endif
+#ifndef FBGEMM_JIT_CACHE_BUILD_ID
+#define FBGEMM_JIT_CACHE_BUILD_ID __DATE__ " " __TIME__
+#endif
+
+namespace fbgemm {
+
+namespace {
+
+constexpr char kJitCacheMagic[8] = {'F', 'B', 'G', 'E', 'J', 'I', 'T', '2'};
+
+struct JitCacheConfig {
+  std::mutex mutex;
+  std::string dir;
+  std::atomic<bool> enabled{false};
+
+  JitCacheConfig() {
+    const char* env_val = std::getenv("FBGEMM_JIT_CACHE_DIR");
+    if (env_val != nullptr) {
+      dir = env_val;
+      enabled = !dir.empty();
+    }
+  }
+};
+
+JitCacheConfig& jitCacheConfig() {
+  static JitCacheConfig config;
+  return config;
+}
+
+std::string jitCacheFile(const std::string& key) {
+  return getJitCacheDir() + "/" + key + ".bin";
+}
+
+template <typename T>
+bool readPod(std::ifstream& in, T& val) {
+  return static_cast<bool>(
+      in.read(reinterpret_cast<char*>(&val), sizeof(T)));
+}
+
+template <typename T>
+void writePod(std::ofstream& out, const T& val) {
+  out.write(reinterpret_cast<const char*>(&val), sizeof(T));
+}
+
+// Bytes left to read in the file, so that the lengths it stores are not
+// trusted beyond its size
+std::uint64_t remainingBytes(std::ifstream& in, std::uint64_t fileSize) {
+  const auto pos = in.tellg();
+  return pos < 0 || static_cast<std::uint64_t>(pos) > fileSize
+      ? 0
+      : fileSize - static_cast<std::uint64_t>(pos);
+}
+
+bool readString(std::ifstream& in, std::uint64_t fileSize, std::string& str) {
+  std::uint32_t len = 0;
+  if (!readPod(in, len) || len > remainingBytes(in, fileSize)) {
+    return false;
+  }
+  str.resize(len);
+  return static_cast<bool>(in.read(&str[0], len));
+}
+
+// 64-bit FNV-1a of the code, so that a truncated or interleaved file is
+// never executed
+std::uint64_t codeChecksum(const void* code, std::size_t size) {
+  const auto* bytes = static_cast<const std::uint8_t*>(code);
+  std::uint64_t hash = 14695981039346656037ULL;
+  for (std::size_t i = 0; i < size; ++i) {
+    hash = (hash ^ bytes[i]) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+unsigned long processId() {
+#ifdef _WIN32
+  return static_cast<unsigned long>(_getpid());
+#else
+  return static_cast<unsigned long>(getpid());
+#endif
+}
+
+void writeString(std::ofstream& out, const std::string& str) {
+  writePod(out, static_cast<std::uint32_t>(str.size()));
+  out.write(str.data(), str.size());
+}
+
+} // namespace
+
+void setJitCacheDir(const std::string& dir) {
+  JitCacheConfig& config = jitCacheConfig();
+  std::unique_lock<std::mutex> lock(config.mutex);
+  config.dir = dir;
+  config.enabled = !dir.empty();
+}
+
+std::string getJitCacheDir() {
+  JitCacheConfig& config = jitCacheConfig();
+  std::unique_lock<std::mutex> lock(config.mutex);
+  return config.dir;
+}
+
+bool isJitCacheEnabled() {
+  return jitCacheConfig().enabled.load(std::memory_order_relaxed);
+}
+
+bool loadJitCode(const std::string& key, std::vector<std::uint8_t>& code) {
+  std::ifstream in(jitCacheFile(key), std::ios::binary | std::ios::ate);
+  if (!in) {
+    return false;
+  }
+  const auto end = in.tellg();
+  if (end < 0 || !in.seekg(0)) {
+    return false;
+  }
+  const std::uint64_t fileSize = static_cast<std::uint64_t>(end);
+  char magic[sizeof(kJitCacheMagic)];
+  if (!in.read(magic, sizeof(magic)) ||
+      std::memcmp(magic, kJitCacheMagic, sizeof(magic)) != 0) {
+    return false;
+  }
+  std::string buildId, storedKey;
+  if (!readString(in, fileSize, buildId) ||
+      buildId != FBGEMM_JIT_CACHE_BUILD_ID ||
+      !readString(in, fileSize, storedKey) || storedKey != key) {
+    return false;
+  }
+  std::uint64_t size = 0, checksum = 0;
+  if (!readPod(in, size) || !readPod(in, checksum) || size == 0 ||
+      size != remainingBytes(in, fileSize)) {
+    return false;
+  }
+  code.resize(size);
+  if (!in.read(reinterpret_cast<char*>(code.data()), size) ||
+      codeChecksum(code.data(), code.size()) != checksum) {
+    code.clear();
+    return false;
+  }
+  return true;
+}
+
+void storeJitCode(const std::string& key, const void* code, std::size_t size) {
+  const std::string file = jitCacheFile(key);
+  // Unique to the thread across the processes sharing the directory
+  const std::string tmpFile = file + ".tmp" + std::to_string(processId()) +
+      "." +
+      std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+  {
+    std::ofstream out(tmpFile, std::ios::binary | std::ios::trunc);
+    if (!out) {
+      return;
+    }
+    out.write(kJitCacheMagic, sizeof(kJitCacheMagic));
+    writeString(out, FBGEMM_JIT_CACHE_BUILD_ID);
+    writeString(out, key);
+    writePod(out, static_cast<std::uint64_t>(size));
+    writePod(out, codeChecksum(code, size));
+    out.write(static_cast<const char*>(code), size);
+    if (!out) {
+      out.close();
+      std::remove(tmpFile.c_str());
+      return;
+    }
+  }
+  if (std::rename(tmpFile.c_str(), file.c_str()) != 0) {
+    std::remove(tmpFile.c_str());
+  }
+}
+
+} // namespace fbgemm
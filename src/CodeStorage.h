@@ -0,0 +1,153 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+#include <asmjit/asmjit.h>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "./CodeCache.h"
+#include "fbgemm/Utils.h"
+
+namespace fbgemm {
+
+/**
+ * @brief Returns true if JIT-generated kernels should be persisted to and
+ * loaded from the directory returned by getJitCacheDir().
+ */
+bool isJitCacheEnabled();
+
+/**
+ * @brief Load the machine code stored for key. Returns false if there is no
+ * entry for key, if the entry was written by a different build of the
+ * library, or if it is truncated or its code does not match its checksum.
+ */
+bool loadJitCode(const std::string& key, std::vector<std::uint8_t>& code);
+
+/**
+ * @brief Store size bytes of machine code starting at code under key. The
+ * file is written to a temporary name first and renamed so that concurrent
+ * processes sharing a cache directory never observe partial entries.
+ */
+void storeJitCode(const std::string& key, const void* code, std::size_t size);
+
+/**
+ * @brief Build the persistent cache key of a kernel from its family name,
+ * instruction set and the key tuple of its CodeCache.
+ */
+template <typename KEY>
+std::string
+getJitCacheKey(const char* family, inst_set_t instSet, const KEY& key) {
+  std::ostringstream oss;
+  oss << family << "_isa-" << static_cast<int>(instSet);
+  std::apply([&oss](const auto&... args) { ((oss << '_' << args), ...); }, key);
+  return oss.str();
+}
+
+/**
+ * @brief Report a kernel added to rt to the code cache generating it, so the
+ * cache can account for its size and free it when it gets evicted.
+ */
+template <typename FN>
+void recordJitKernel(
+    asmjit::JitRuntime& rt,
+    std::mutex& rtMutex,
+    FN fn,
+    std::size_t codeBytes) {
+  CodeCacheGeneration* generation = currentCodeCacheGeneration();
+  if (generation == nullptr) {
+    return;
+  }
+  generation->codeBytes = codeBytes;
+  generation->release = [&rt, &rtMutex, fn]() {
+    std::unique_lock<std::mutex> lock(rtMutex);
+    rt.release(fn);
+  };
+}
+
+/**
+ * @brief Try to materialize a kernel persisted under key into rt.
+ *
+ * The generated kernels only use rip-relative addressing for their constants
+ * and labels, so the stored bytes can be copied into freshly allocated
+ * executable memory without relocation. Kernels that embed absolute
+ * addresses (e.g. GenRowWiseSparseAdagradFused, whose mask table pointer is
+ * part of its key) must not be persisted.
+ */
+template <typename FN>
+bool loadJitKernel(
+    asmjit::JitRuntime& rt,
+    std::mutex& rtMutex,
+    const std::string& key,
+    FN* fn) {
+  if (!isJitCacheEnabled()) {
+    return false;
+  }
+  std::vector<std::uint8_t> bytes;
+  if (!loadJitCode(key, bytes)) {
+    return false;
+  }
+  asmjit::CodeHolder code;
+  code.init(rt.environment());
+  asmjit::x86::Assembler assembler(&code);
+  if (assembler.embed(bytes.data(), bytes.size()) != asmjit::kErrorOk) {
+    return false;
+  }
+  {
+    std::unique_lock<std::mutex> lock(rtMutex);
+    if (rt.add(fn, &code) != asmjit::kErrorOk) {
+      return false;
+    }
+  }
+  recordJitKernel(rt, rtMutex, *fn, bytes.size());
+  return true;
+}
+
+/**
+ * @brief Add the generated code to rt without persisting it.
+ */
+template <typename FN>
+asmjit::Error addJitKernel(
+    asmjit::JitRuntime& rt,
+    std::mutex& rtMutex,
+    FN* fn,
+    asmjit::CodeHolder& code) {
+  asmjit::Error err;
+  {
+    std::unique_lock<std::mutex> lock(rtMutex);
+    err = rt.add(fn, &code);
+  }
+  if (!err) {
+    recordJitKernel(rt, rtMutex, *fn, code.codeSize());
+  }
+  return err;
+}
+
+/**
+ * @brief Add the generated code to rt and, if the persistent cache is
+ * enabled, store the relocated code under key.
+ */
+template <typename FN>
+asmjit::Error addJitKernel(
+    asmjit::JitRuntime& rt,
+    std::mutex& rtMutex,
+    FN* fn,
+    asmjit::CodeHolder& code,
+    const std::string& key) {
+  asmjit::Error err = addJitKernel(rt, rtMutex, fn, code);
+  if (!err && isJitCacheEnabled()) {
+    storeJitCode(key, reinterpret_cast<const void*>(*fn), code.codeSize());
+  }
+  return err;
+}
+
+} // namespace fbgemm
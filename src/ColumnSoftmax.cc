@@ -0,0 +1,159 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#define FBGEMM_EXPORTS
+#include "./ColumnSoftmax.h"
+
+#include <cpuinfo.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "fbgemm/Utils.h"
+
+namespace fbgemm {
+
+namespace {
+
+void columnSoftmaxRef(
+    std::int64_t rows,
+    std::int64_t cols,
+    const float* input,
+    std::int64_t ld_input,
+    float* output,
+    std::int64_t ld_output) {
+  for (std::int64_t c = 0; c < cols; ++c) {
+    float max_value = input[c];
+    for (std::int64_t r = 1; r < rows; ++r) {
+      max_value = std::max(max_value, input[r * ld_input + c]);
+    }
+    float sum = 0;
+    for (std::int64_t r = 0; r < rows; ++r) {
+      const float e = std::exp(input[r * ld_input + c] - max_value);
+      output[r * ld_output + c] = e;
+      sum += e;
+    }
+    for (std::int64_t r = 0; r < rows; ++r) {
+      output[r * ld_output + c] /= sum;
+    }
+  }
+}
+
+void columnSoftmaxBackwardRef(
+    std::int64_t rows,
+    std::int64_t cols,
+    const float* grad_output,
+    std::int64_t ld_grad_output,
+    const float* output,
+    std::int64_t ld_output,
+    float* grad_input,
+    std::int64_t ld_grad_input) {
+  for (std::int64_t c = 0; c < cols; ++c) {
+    float sum = 0;
+    for (std::int64_t r = 0; r < rows; ++r) {
+      sum += grad_output[r * ld_grad_output + c] * output[r * ld_output + c];
+    }
+    for (std::int64_t r = 0; r < rows; ++r) {
+      grad_input[r * ld_grad_input + c] =
+          (grad_output[r * ld_grad_output + c] - sum) *
+          output[r * ld_output + c];
+    }
+  }
+}
+
+#if CPUINFO_ARCH_X86 || CPUINFO_ARCH_X86_64
+// Checked once rather than on every call, segments are often short
+bool useAvx512() {
+  static const bool use_avx512 =
+      cpuinfo_initialize() && fbgemmHasAvx512Support();
+  return use_avx512;
+}
+
+bool useAvx2() {
+  static const bool use_avx2 = cpuinfo_initialize() && fbgemmHasAvx2Support();
+  return use_avx2;
+}
+#endif
+
+} // namespace
+
+void column_softmax(
+    const int64_t rows,
+    const int64_t cols,
+    const float* const input,
+    const int64_t ld_input,
+    float* const output,
+    const int64_t ld_output) {
+  if (rows <= 0 || cols <= 0) {
+    return;
+  }
+#if CPUINFO_ARCH_X86 || CPUINFO_ARCH_X86_64
+  if (useAvx512()) {
+    internal::column_softmax_avx512(
+        rows, cols, input, ld_input, output, ld_output);
+    return;
+  }
+  if (useAvx2()) {
+    internal::column_softmax_avx2(
+        rows, cols, input, ld_input, output, ld_output);
+    return;
+  }
+#endif
+  columnSoftmaxRef(rows, cols, input, ld_input, output, ld_output);
+}
+
+void column_softmax_backward(
+    const int64_t rows,
+    const int64_t cols,
+    const float* const grad_output,
+    const int64_t ld_grad_output,
+    const float* const output,
+    const int64_t ld_output,
+    float* const grad_input,
+    const int64_t ld_grad_input) {
+  if (rows <= 0 || cols <= 0) {
+    return;
+  }
+#if CPUINFO_ARCH_X86 || CPUINFO_ARCH_X86_64
+  if (useAvx512()) {
+    internal::column_softmax_backward_avx512(
+        rows,
+        cols,
+        grad_output,
+        ld_grad_output,
+        output,
+        ld_output,
+        grad_input,
+        ld_grad_input);
+    return;
+  }
+  if (useAvx2()) {
+    internal::column_softmax_backward_avx2(
+        rows,
+        cols,
+        grad_output,
+        ld_grad_output,
+        output,
+        ld_output,
+        grad_input,
+        ld_grad_input);
+    return;
+  }
+#endif
+  columnSoftmaxBackwardRef(
+      rows,
+      cols,
+      grad_output,
+      ld_grad_output,
+      output,
+      ld_output,
+      grad_input,
+      ld_grad_input);
+}
+
+} // namespace fbgemm
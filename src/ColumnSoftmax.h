@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace fbgemm {
+
+namespace internal {
+
+/**
+ * @brief Column softmax using Intel AVX2, called by column_softmax on CPUs
+ * with AVX2 support.
+ */
+void column_softmax_avx2(
+    std::int64_t rows,
+    std::int64_t cols,
+    const float* input,
+    std::int64_t ld_input,
+    float* output,
+    std::int64_t ld_output);
+
+/**
+ * @brief Column softmax using Intel AVX512, called by column_softmax on CPUs
+ * with AVX512 support.
+ */
+void column_softmax_avx512(
+    std::int64_t rows,
+    std::int64_t cols,
+    const float* input,
+    std::int64_t ld_input,
+    float* output,
+    std::int64_t ld_output);
+
+/**
+ * @brief Column softmax backward using Intel AVX2, called by
+ * column_softmax_backward on CPUs with AVX2 support.
+ */
+void column_softmax_backward_avx2(
+    std::int64_t rows,
+    std::int64_t cols,
+    const float* grad_output,
+    std::int64_t ld_grad_output,
+    const float* output,
+    std::int64_t ld_output,
+    float* grad_input,
+    std::int64_t ld_grad_input);
+
+/**
+ * @brief Column softmax backward using Intel AVX512, called by
+ * column_softmax_backward on CPUs with AVX512 support.
+ */
+void column_softmax_backward_avx512(
+    std::int64_t rows,
+    std::int64_t cols,
+    const float* grad_output,
+    std::int64_t ld_grad_output,
+    const float* output,
+    std::int64_t ld_output,
+    float* grad_input,
+    std::int64_t ld_grad_input);
+
+} // namespace internal
+
+} // namespace fbgemm
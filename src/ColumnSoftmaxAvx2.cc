@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <immintrin.h>
+#include <cstdint>
+
+#include "./ColumnSoftmax.h"
+
+namespace fbgemm {
+
+namespace internal {
+
+namespace {
+
+// exp(x) as 2^n * p(r) with x = n * ln(2) + r, |r| <= ln(2) / 2 and the
+// Cephes polynomial p, within 2 ulp of std::exp. Inputs below -87.3 give 0.
+inline __m256 expAvx2(__m256 x) {
+  x = _mm256_min_ps(x, _mm256_set1_ps(88.3762626647949f));
+  x = _mm256_max_ps(x, _mm256_set1_ps(-88.3762626647949f));
+  const __m256 n = _mm256_round_ps(
+      _mm256_mul_ps(x, _mm256_set1_ps(1.44269504088896341f)),
+      _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  // ln(2) split in two for an exact n * ln(2)
+  __m256 r = _mm256_fnmadd_ps(n, _mm256_set1_ps(0.693359375f), x);
+  r = _mm256_fnmadd_ps(n, _mm256_set1_ps(-2.12194440e-4f), r);
+  __m256 p = _mm256_set1_ps(1.9875691500e-4f);
+  p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.3981999507e-3f));
+  p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(8.3334519073e-3f));
+  p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(4.1665795894e-2f));
+  p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(1.6666665459e-1f));
+  p = _mm256_fmadd_ps(p, r, _mm256_set1_ps(5.0000001201e-1f));
+  p = _mm256_fmadd_ps(p, _mm256_mul_ps(r, r), r);
+  p = _mm256_add_ps(p, _mm256_set1_ps(1.0f));
+  // 2^n from the exponent bits, 0 for n = -127
+  const __m256i pow2n = _mm256_slli_epi32(
+      _mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+  return _mm256_mul_ps(p, _mm256_castsi256_ps(pow2n));
+}
+
+// Mask of the first n < 8 lanes
+inline __m256i tailMask(std::int64_t n) {
+  return _mm256_cmpgt_epi32(
+      _mm256_set1_epi32(static_cast<int>(n)),
+      _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+
+// Loop over the 8 column blocks, the last one masked
+template <typename F>
+inline void forEachColumnBlock(std::int64_t cols, F f) {
+  std::int64_t c = 0;
+  for (; c + 8 <= cols; c += 8) {
+    f(c, _mm256_set1_epi32(-1));
+  }
+  if (c < cols) {
+    f(c, tailMask(cols - c));
+  }
+}
+
+} // namespace
+
+void column_softmax_avx2(
+    const std::int64_t rows,
+    const std::int64_t cols,
+    const float* const input,
+    const std::int64_t ld_input,
+    float* const output,
+    const std::int64_t ld_output) {
+  forEachColumnBlock(cols, [&](std::int64_t c, __m256i mask) {
+    __m256 max_value = _mm256_maskload_ps(input + c, mask);
+    for (std::int64_t r = 1; r < rows; ++r) {
+      max_value = _mm256_max_ps(
+          max_value, _mm256_maskload_ps(input + r * ld_input + c, mask));
+    }
+    __m256 sum = _mm256_setzero_ps();
+    for (std::int64_t r = 0; r < rows; ++r) {
+      const __m256 e = expAvx2(_mm256_sub_ps(
+          _mm256_maskload_ps(input + r * ld_input + c, mask), max_value));
+      _mm256_maskstore_ps(output + r * ld_output + c, mask, e);
+      sum = _mm256_add_ps(sum, e);
+    }
+    for (std::int64_t r = 0; r < rows; ++r) {
+      float* const out = output + r * ld_output + c;
+      _mm256_maskstore_ps(
+          out, mask, _mm256_div_ps(_mm256_maskload_ps(out, mask), sum));
+    }
+  });
+}
+
+void column_softmax_backward_avx2(
+    const std::int64_t rows,
+    const std::int64_t cols,
+    const float* const grad_output,
+    const std::int64_t ld_grad_output,
+    const float* const output,
+    const std::int64_t ld_output,
+    float* const grad_input,
+    const std::int64_t ld_grad_input) {
+  forEachColumnBlock(cols, [&](std::int64_t c, __m256i mask) {
+    __m256 sum = _mm256_setzero_ps();
+    for (std::int64_t r = 0; r < rows; ++r) {
+      sum = _mm256_fmadd_ps(
+          _mm256_maskload_ps(grad_output + r * ld_grad_output + c, mask),
+          _mm256_maskload_ps(output + r * ld_output + c, mask),
+          sum);
+    }
+    for (std::int64_t r = 0; r < rows; ++r) {
+      const __m256 g =
+          _mm256_maskload_ps(grad_output + r * ld_grad_output + c, mask);
+      const __m256 o = _mm256_maskload_ps(output + r * ld_output + c, mask);
+      _mm256_maskstore_ps(
+          grad_input + r * ld_grad_input + c,
+          mask,
+          _mm256_mul_ps(_mm256_sub_ps(g, sum), o));
+    }
+  });
+}
+
+} // namespace internal
+
+} // namespace fbgemm
@@ -0,0 +1,116 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <immintrin.h>
+#include <cstdint>
+
+#include "./ColumnSoftmax.h"
+
+namespace fbgemm {
+
+namespace internal {
+
+namespace {
+
+// exp(x) as 2^n * p(r) with x = n * ln(2) + r, |r| <= ln(2) / 2 and the
+// Cephes polynomial p, as in the AVX2 version
+inline __m512 expAvx512(__m512 x) {
+  x = _mm512_min_ps(x, _mm512_set1_ps(88.3762626647949f));
+  x = _mm512_max_ps(x, _mm512_set1_ps(-88.3762626647949f));
+  const __m512 n = _mm512_roundscale_ps(
+      _mm512_mul_ps(x, _mm512_set1_ps(1.44269504088896341f)),
+      _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  __m512 r = _mm512_fnmadd_ps(n, _mm512_set1_ps(0.693359375f), x);
+  r = _mm512_fnmadd_ps(n, _mm512_set1_ps(-2.12194440e-4f), r);
+  __m512 p = _mm512_set1_ps(1.9875691500e-4f);
+  p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(1.3981999507e-3f));
+  p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(8.3334519073e-3f));
+  p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(4.1665795894e-2f));
+  p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(1.6666665459e-1f));
+  p = _mm512_fmadd_ps(p, r, _mm512_set1_ps(5.0000001201e-1f));
+  p = _mm512_fmadd_ps(p, _mm512_mul_ps(r, r), r);
+  p = _mm512_add_ps(p, _mm512_set1_ps(1.0f));
+  const __m512i pow2n = _mm512_slli_epi32(
+      _mm512_add_epi32(_mm512_cvtps_epi32(n), _mm512_set1_epi32(127)), 23);
+  return _mm512_mul_ps(p, _mm512_castsi512_ps(pow2n));
+}
+
+// Loop over the 16 column blocks, the last one masked
+template <typename F>
+inline void forEachColumnBlock(std::int64_t cols, F f) {
+  std::int64_t c = 0;
+  for (; c + 16 <= cols; c += 16) {
+    f(c, static_cast<__mmask16>(0xffff));
+  }
+  if (c < cols) {
+    f(c, static_cast<__mmask16>((1u << (cols - c)) - 1));
+  }
+}
+
+} // namespace
+
+void column_softmax_avx512(
+    const std::int64_t rows,
+    const std::int64_t cols,
+    const float* const input,
+    const std::int64_t ld_input,
+    float* const output,
+    const std::int64_t ld_output) {
+  forEachColumnBlock(cols, [&](std::int64_t c, __mmask16 mask) {
+    __m512 max_value = _mm512_maskz_loadu_ps(mask, input + c);
+    for (std::int64_t r = 1; r < rows; ++r) {
+      max_value = _mm512_max_ps(
+          max_value, _mm512_maskz_loadu_ps(mask, input + r * ld_input + c));
+    }
+    __m512 sum = _mm512_setzero_ps();
+    for (std::int64_t r = 0; r < rows; ++r) {
+      const __m512 e = expAvx512(_mm512_sub_ps(
+          _mm512_maskz_loadu_ps(mask, input + r * ld_input + c), max_value));
+      _mm512_mask_storeu_ps(output + r * ld_output + c, mask, e);
+      sum = _mm512_add_ps(sum, e);
+    }
+    for (std::int64_t r = 0; r < rows; ++r) {
+      float* const out = output + r * ld_output + c;
+      _mm512_mask_storeu_ps(
+          out, mask, _mm512_div_ps(_mm512_maskz_loadu_ps(mask, out), sum));
+    }
+  });
+}
+
+void column_softmax_backward_avx512(
+    const std::int64_t rows,
+    const std::int64_t cols,
+    const float* const grad_output,
+    const std::int64_t ld_grad_output,
+    const float* const output,
+    const std::int64_t ld_output,
+    float* const grad_input,
+    const std::int64_t ld_grad_input) {
+  forEachColumnBlock(cols, [&](std::int64_t c, __mmask16 mask) {
+    __m512 sum = _mm512_setzero_ps();
+    for (std::int64_t r = 0; r < rows; ++r) {
+      sum = _mm512_fmadd_ps(
+          _mm512_maskz_loadu_ps(mask, grad_output + r * ld_grad_output + c),
+          _mm512_maskz_loadu_ps(mask, output + r * ld_output + c),
+          sum);
+    }
+    for (std::int64_t r = 0; r < rows; ++r) {
+      const __m512 g =
+          _mm512_maskz_loadu_ps(mask, grad_output + r * ld_grad_output + c);
+      const __m512 o = _mm512_maskz_loadu_ps(mask, output + r * ld_output + c);
+      _mm512_mask_storeu_ps(
+          grad_input + r * ld_grad_input + c,
+          mask,
+          _mm512_mul_ps(_mm512_sub_ps(g, sum), o));
+    }
+  });
+}
+
+} // namespace internal
+
+} // namespace fbgemm
@@ -32,6 +32,24 @@ namespace x86 = asmjit::x86;
  */
 void initCRegs(x86::Emitter* a, int rowRegs, int colRegs);
 
+/**
+ * @brief Direct convolution of a dense (G == 1), non-transposed 2D conv with
+ *        any filter size, stride, dilation and padding.
+ *
+ * Computes the int32 output and the row offsets (sums over the filter window
+ * with padding read as A_zero_point) of the output rows [row_begin, row_end)
+ * of the MB * OUT_DIM[0] rows. C and row_offsets start at row_begin.
+ */
+void directConvAvx2(
+    const conv_param_t<2>& conv_p,
+    const std::uint8_t* A,
+    std::int32_t A_zero_point,
+    const PackedDirectConvMatrix& B,
+    int row_begin,
+    int row_end,
+    std::int32_t* C,
+    std::int32_t* row_offsets);
+
 template <typename TA, typename TB, typename TC, typename accT>
 class DirectConvCodeGenBase {
  public:
@@ -216,12 +234,13 @@ template <typename TA, typename TB, typename TC, typename accT>
 CodeCache<
     std::tuple<bool, int, int, int, int, int, int>,
     typename DirectConvCodeGenBase<TA, TB, TC, accT>::jit_micro_kernel_fp>
-    DirectConvCodeGenBase<TA, TB, TC, accT>::codeCache_;
+    DirectConvCodeGenBase<TA, TB, TC, accT>::codeCache_("directconv");
 
 template <typename TA, typename TB, typename TC, typename accT>
 CodeCache<
     std::tuple<bool, int, int, int>,
     typename DirectConvCodeGenBase<TA, TB, TC, accT>::jit_micro_kernel_fp_convT>
-    DirectConvCodeGenBase<TA, TB, TC, accT>::codeCacheT_;
+    DirectConvCodeGenBase<TA, TB, TC, accT>::codeCacheT_(
+        "directconv_transposed");
 
 } // namespace fbgemm
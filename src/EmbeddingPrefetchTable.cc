@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#define FBGEMM_EXPORTS
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+
+#include "fbgemm/FbgemmEmbedding.h"
+
+#ifdef _WIN32
+#include <xmmintrin.h>
+#endif
+
+namespace fbgemm {
+
+namespace {
+
+constexpr int kDefaultPrefetchDistance = 16;
+
+struct PrefetchTable {
+  std::mutex mutex;
+  // (isa, bit_rate, block_size) -> prefetch distance
+  std::map<std::tuple<inst_set_t, int, std::int64_t>, int> distances;
+};
+
+bool parsePrefetchTable(std::istream& in, PrefetchTable& table);
+
+std::atomic<int>& crossTablePrefetch() {
+  static std::atomic<int> num_indices([]() {
+    const char* value = std::getenv("FBGEMM_EMBEDDING_CROSS_TABLE_PREFETCH");
+    return value != nullptr ? std::max(std::atoi(value), 0) : 0;
+  }());
+  return num_indices;
+}
+
+PrefetchTable& prefetchTable() {
+  static PrefetchTable* table = []() {
+    auto* t = new PrefetchTable();
+    const char* path = std::getenv("FBGEMM_EMBEDDING_PREFETCH_TABLE");
+    if (path != nullptr && path[0] != '\0') {
+      std::ifstream in(path);
+      parsePrefetchTable(in, *t);
+    }
+    return t;
+  }();
+  return *table;
+}
+
+bool parsePrefetchTable(std::istream& in, PrefetchTable& table) {
+  static const std::unordered_map<std::string, inst_set_t> isaMap = {
+      {"AVX2", inst_set_t::avx2},
+      {"AVX512", inst_set_t::avx512},
+      {"AVX512_E1", inst_set_t::avx512_vnni},
+      {"AVX512_256", inst_set_t::avx512_ymm},
+      {"AVX512_E1_256", inst_set_t::avx512_vnni_ymm},
+  };
+  if (!in) {
+    return false;
+  }
+  bool success = true;
+  std::string line;
+  while (std::getline(in, line)) {
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    std::istringstream fields(line);
+    std::string isa;
+    int bit_rate = 0;
+    std::int64_t block_size = 0;
+    int prefetch = 0;
+    if (!(fields >> isa >> bit_rate >> block_size >> prefetch) ||
+        prefetch < 0) {
+      success = false;
+      continue;
+    }
+    std::transform(isa.begin(), isa.end(), isa.begin(), ::toupper);
+    auto it = isaMap.find(isa);
+    if (it == isaMap.end()) {
+      success = false;
+      continue;
+    }
+    std::unique_lock<std::mutex> lock(table.mutex);
+    table.distances[std::make_tuple(it->second, bit_rate, block_size)] =
+        prefetch;
+  }
+  return success;
+}
+
+} // namespace
+
+void setEmbeddingPrefetchDistance(
+    inst_set_t isa,
+    int bit_rate,
+    std::int64_t block_size,
+    int prefetch) {
+  PrefetchTable& table = prefetchTable();
+  std::unique_lock<std::mutex> lock(table.mutex);
+  table.distances[std::make_tuple(isa, bit_rate, block_size)] = prefetch;
+}
+
+int getEmbeddingPrefetchDistance(
+    inst_set_t isa,
+    int bit_rate,
+    std::int64_t block_size) {
+  PrefetchTable& table = prefetchTable();
+  std::unique_lock<std::mutex> lock(table.mutex);
+  auto& distances = table.distances;
+  // Entries of one (isa, bit_rate) are contiguous and sorted by block size.
+  auto begin = distances.lower_bound(std::make_tuple(isa, bit_rate, 0));
+  auto end = distances.upper_bound(std::make_tuple(isa, bit_rate, INT64_MAX));
+  if (begin == end) {
+    return kDefaultPrefetchDistance;
+  }
+  auto it = distances.upper_bound(std::make_tuple(isa, bit_rate, block_size));
+  return it == begin ? begin->second : std::prev(it)->second;
+}
+
+bool loadEmbeddingPrefetchTable(const std::string& path) {
+  std::ifstream in(path);
+  return parsePrefetchTable(in, prefetchTable());
+}
+
+void setEmbeddingCrossTablePrefetch(int num_indices) {
+  crossTablePrefetch().store(std::max(num_indices, 0));
+}
+
+int getEmbeddingCrossTablePrefetch() {
+  return crossTablePrefetch().load(std::memory_order_relaxed);
+}
+
+template <typename IndexType>
+void prefetchEmbeddingRows(
+    const std::uint8_t* weights,
+    std::int64_t num_rows,
+    std::int64_t row_bytes,
+    const IndexType* indices,
+    std::int64_t num_indices) {
+  constexpr std::int64_t kCacheLineBytes = 64;
+  for (std::int64_t i = 0; i < num_indices; ++i) {
+    const std::int64_t idx = indices[i];
+    if (idx < 0 || idx >= num_rows) {
+      continue;
+    }
+    const std::uint8_t* row = weights + idx * row_bytes;
+    for (std::int64_t byte = 0; byte < row_bytes; byte += kCacheLineBytes) {
+#ifdef _WIN32
+      _mm_prefetch(reinterpret_cast<const char*>(row + byte), _MM_HINT_T0);
+#else
+      __builtin_prefetch(row + byte, 0, 3);
+#endif
+    }
+  }
+}
+
+#define INSTANTIATE_PREFETCH_ROWS(INDEX_TYPE)                 \
+  template FBGEMM_API void prefetchEmbeddingRows<INDEX_TYPE>( \
+      const std::uint8_t* weights,                            \
+      std::int64_t num_rows,                                  \
+      std::int64_t row_bytes,                                 \
+      const INDEX_TYPE* indices,                              \
+      std::int64_t num_indices);
+
+INSTANTIATE_PREFETCH_ROWS(std::int32_t)
+INSTANTIATE_PREFETCH_ROWS(std::int64_t)
+
+#undef INSTANTIATE_PREFETCH_ROWS
+
+} // namespace fbgemm
@@ -6,9 +6,12 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <algorithm>
 #include <cstdint>
 #include <stdexcept>
 #include <type_traits>
+#include <utility>
+#include <vector>
 #define FBGEMM_EXPORTS
 
 #include "fbgemm/FbgemmEmbedding.h"
@@ -23,9 +26,12 @@
 #include <string>
 #include <tuple>
 #include "./CodeCache.h"
+#include "./CodeStorage.h"
+#include "./EmbeddingSpMDMAutotune.h"
 #include "./EmbeddingSpMDMAutovec.h"
 #include "./MaskAvx2.h"
 #include "./RefImplementations.h"
+#include "./TraceScope.h"
 #include "fbgemm/FbgemmConvert.h"
 #include "fbgemm/SimdUtils.h"
 
@@ -180,7 +186,7 @@ CodeCache<
         outType,
         instSet,
         ROWWISE_SPARSE,
-        THREAD_LOCAL>::codeCache_;
+        THREAD_LOCAL>::codeCache_("embedding");
 
 template <
     typename inType,
@@ -237,6 +243,27 @@ GenEmbeddingSpMDMLookup<
                 offsetType,
                 outType,
                 ROWWISE_SPARSE>::jit_embedding_kernel {
+        typename ReturnFunctionSignature<
+            inType,
+            indxType,
+            offsetType,
+            outType,
+            ROWWISE_SPARSE>::jit_embedding_kernel fn;
+        const std::string jitKey = getJitCacheKey(
+            "embedding",
+            instSet,
+            std::tuple_cat(
+                std::make_tuple(
+                    sizeof(inType),
+                    sizeof(indxType),
+                    sizeof(offsetType),
+                    sizeof(outType),
+                    ROWWISE_SPARSE),
+                kernelSig));
+        if (loadJitKernel(runtime(), rtMutex_, jitKey, &fn)) {
+          return fn;
+        }
+
         bool is_8bit_in = std::is_same<inType, uint8_t>::value;
         bool is_16bit_in = std::is_same<inType, uint16_t>::value;
         bool is_16bit_out = std::is_same<outType, uint16_t>::value;
@@ -985,18 +1012,8 @@ GenEmbeddingSpMDMLookup<
 
         a->emitEpilog(frame);
 
-        // jit_fused8bitembedding_kernel fn;
-        typename ReturnFunctionSignature<
-            inType,
-            indxType,
-            offsetType,
-            outType,
-            ROWWISE_SPARSE>::jit_embedding_kernel fn;
-        asmjit::Error err;
-        {
-          std::unique_lock<std::mutex> lock(rtMutex_);
-          err = runtime().add(&fn, &code);
-        }
+        asmjit::Error err =
+            addJitKernel(runtime(), rtMutex_, &fn, code, jitKey);
         if (err) {
           std::cout << "Error: in fn add" << std::endl;
           return nullptr;
@@ -1010,8 +1027,6 @@ GenEmbeddingSpMDMLookup<
       });
 }
 
-} // namespace
-
 template <
     typename inType,
     typename indxType,
@@ -1020,7 +1035,7 @@ template <
     bool THREAD_LOCAL>
 typename EmbeddingSpMDMKernelSignature<inType, indxType, offsetType, outType>::
     Type
-    GenerateEmbeddingSpMDMWithStrides(
+    generateEmbeddingSpMDMWithStrides(
         const int64_t block_size,
         [[maybe_unused]] bool has_weight,
         bool normalize_by_lengths,
@@ -1032,10 +1047,16 @@ typename EmbeddingSpMDMKernelSignature<inType, indxType, offsetType, outType>::
         bool scale_bias_last /*=true*/,
         bool no_bag /*=false*/,
         bool is_bf16_out /*=false*/,
-        bool is_bf16_in /*=false*/) {
+        bool is_bf16_in /*=false*/,
+        internal::EmbeddingSpMDMImpl impl =
+            internal::EmbeddingSpMDMImpl::kDefault) {
   if (!cpuinfo_initialize()) {
     throw std::runtime_error("Failed to initialize cpuinfo!");
   }
+  if (prefetch == kEmbeddingPrefetchTuned) {
+    prefetch = getEmbeddingPrefetchDistance(
+        fbgemmInstructionSet(), 8 * sizeof(inType), block_size);
+  }
 #if defined(__APPLE__) || defined(_WIN32)
   if (std::is_same<inType, uint16_t>::value && is_bf16_in &&
       std::is_same<outType, float>::value) {
@@ -1057,7 +1078,14 @@ typename EmbeddingSpMDMKernelSignature<inType, indxType, offsetType, outType>::
   }
 #if CPUINFO_ARCH_X86 || CPUINFO_ARCH_X86_64
   const inst_set_t isa = fbgemmInstructionSet();
+  const bool use_asmjit = impl == internal::EmbeddingSpMDMImpl::kDefault
+      ? !is_asmjit_disabled()
+      : impl == internal::EmbeddingSpMDMImpl::kAsmjit;
 #endif
+  const bool use_autovec = impl == internal::EmbeddingSpMDMImpl::kDefault
+      ? (is_autovec_forced() || fbgemmHasArmSve2Support()) &&
+          !is_autovec_disabled()
+      : impl == internal::EmbeddingSpMDMImpl::kAutovec;
   if (no_bag == true) {
     return [=](int64_t output_size,
                int64_t index_size,
@@ -1089,12 +1117,95 @@ typename EmbeddingSpMDMKernelSignature<inType, indxType, offsetType, outType>::
     };
   }
 
+  if (impl == internal::EmbeddingSpMDMImpl::kDefault &&
+      is_embedding_autotune_enabled()) {
+    std::vector<internal::EmbeddingSpMDMImpl> candidates;
+#if CPUINFO_ARCH_X86 || CPUINFO_ARCH_X86_64
+    if ((isYmm(isa) || isZmm(isa)) && !is_asmjit_disabled()) {
+      candidates.push_back(internal::EmbeddingSpMDMImpl::kAsmjit);
+    }
+    if ((std::is_same<inType, float>::value ||
+         std::is_same<inType, uint8_t>::value) &&
+        std::is_same<outType, float>::value && fbgemmHasAvx2Support() &&
+        internal::isPrecompiledEmbeddingDim(block_size)) {
+      candidates.push_back(internal::EmbeddingSpMDMImpl::kPrecompiled);
+    }
+#endif
+    if (std::is_same<inType, uint8_t>::value && !is_autovec_disabled()) {
+      candidates.push_back(internal::EmbeddingSpMDMImpl::kAutovec);
+    }
+    candidates.push_back(internal::EmbeddingSpMDMImpl::kRef);
+    return internal::
+        autotuneEmbeddingSpMDM<inType, indxType, offsetType, outType>(
+            candidates,
+            [=](internal::EmbeddingSpMDMImpl candidate) {
+              return generateEmbeddingSpMDMWithStrides<
+                  inType,
+                  indxType,
+                  offsetType,
+                  outType,
+                  THREAD_LOCAL>(
+                  block_size,
+                  has_weight,
+                  normalize_by_lengths,
+                  prefetch,
+                  is_weight_positional,
+                  use_offsets,
+                  output_stride,
+                  input_stride,
+                  scale_bias_last,
+                  no_bag,
+                  is_bf16_out,
+                  is_bf16_in,
+                  candidate);
+            },
+            8 * sizeof(inType),
+            is_bf16_in,
+            is_bf16_out,
+            block_size,
+            has_weight,
+            use_offsets,
+            input_stride,
+            output_stride,
+            normalize_by_lengths,
+            prefetch,
+            is_weight_positional,
+            scale_bias_last);
+  }
+
 #if CPUINFO_ARCH_X86 || CPUINFO_ARCH_X86_64
+  if constexpr (
+      (std::is_same<inType, float>::value ||
+       std::is_same<inType, uint8_t>::value) &&
+      std::is_same<outType, float>::value) {
+    // Without asmjit, the hot dims have a kernel compiled ahead of time
+    const bool use_precompiled = impl == internal::EmbeddingSpMDMImpl::kDefault
+        ? !use_asmjit && !use_autovec
+        : impl == internal::EmbeddingSpMDMImpl::kPrecompiled;
+    if (use_precompiled && fbgemmHasAvx2Support()) {
+      auto kernel = internal::
+          GenerateEmbeddingSpMDMPrecompiled_avx2<inType, indxType, offsetType>(
+              8 * sizeof(inType),
+              block_size,
+              has_weight,
+              normalize_by_lengths,
+              prefetch,
+              is_weight_positional,
+              use_offsets,
+              output_stride,
+              input_stride,
+              scale_bias_last);
+      if (kernel) {
+        return kernel;
+      }
+    }
+  }
+
   if ((std::is_same<inType, float>::value ||
        std::is_same<inType, uint16_t>::value) &&
       block_size == 1 && isYmm(isa) && output_stride == block_size &&
       input_stride == block_size && std::is_same<outType, float>::value &&
-      !is_asmjit_disabled()) {
+      use_asmjit) {
     return
         [=](int64_t output_size,
             int64_t index_size,
@@ -1118,7 +1229,7 @@ typename EmbeddingSpMDMKernelSignature<inType, indxType, offsetType, outType>::
               use_offsets,
               is_bf16_out);
         };
-  } else if (isZmm(isa) && !is_asmjit_disabled()) {
+  } else if (isZmm(isa) && use_asmjit) {
     static GenEmbeddingSpMDMLookup<
         inType,
         indxType,
@@ -1140,6 +1251,32 @@ typename EmbeddingSpMDMKernelSignature<inType, indxType, offsetType, outType>::
         scale_bias_last,
         is_bf16_out,
         is_bf16_in);
+    // Calls below fbgemmSetZmmMinWork() run the AVX2 kernel, to not lower
+    // the core frequency
+    static GenEmbeddingSpMDMLookup<
+        inType,
+        indxType,
+        offsetType,
+        outType,
+        inst_set_t::avx2,
+        /*ROWWISE_SPARSE=*/false,
+        THREAD_LOCAL>
+        ymm_kernel_generator;
+    const int64_t zmm_min_work = fbgemmGetZmmMinWork();
+    const auto ymm_func = zmm_min_work > 0
+        ? ymm_kernel_generator.getOrCreate(
+              block_size,
+              has_weight,
+              is_weight_positional,
+              normalize_by_lengths,
+              prefetch,
+              use_offsets,
+              output_stride,
+              input_stride,
+              scale_bias_last,
+              is_bf16_out,
+              is_bf16_in)
+        : nullptr;
     return [=](int64_t output_size,
                int64_t index_size,
                int64_t data_size,
@@ -1148,6 +1285,18 @@ typename EmbeddingSpMDMKernelSignature<inType, indxType, offsetType, outType>::
                const offsetType* offsets_or_lengths,
                const float* weights,
                outType* out) {
+      if (ymm_func && index_size * block_size < zmm_min_work) {
+        return ymm_func(
+            output_size,
+            index_size,
+            data_size,
+            input,
+            indices,
+            offsets_or_lengths,
+            weights,
+            out,
+            internal::avx2_ps_or_epi32_combined_mask);
+      }
       return original_func(
           output_size,
           index_size,
@@ -1159,7 +1308,7 @@ typename EmbeddingSpMDMKernelSignature<inType, indxType, offsetType, outType>::
           out,
           nullptr /* mask not used in avx512 */);
     };
-  } else if (isYmm(isa) && !is_asmjit_disabled()) {
+  } else if (isYmm(isa) && use_asmjit) {
     static GenEmbeddingSpMDMLookup<
         inType,
         indxType,
@@ -1204,9 +1353,7 @@ typename EmbeddingSpMDMKernelSignature<inType, indxType, offsetType, outType>::
 #else
   if (
 #endif // CPUINFO_ARCH_X86 || CPUINFO_ARCH_X86_64
-      std::is_same<inType, uint8_t>::value &&
-      (is_autovec_forced() || fbgemmHasArmSve2Support()) &&
-      !is_autovec_disabled()) {
+      std::is_same<inType, uint8_t>::value && use_autovec) {
     return [=](int64_t output_size,
                int64_t index_size,
                int64_t data_size,
@@ -1270,6 +1417,57 @@ typename EmbeddingSpMDMKernelSignature<inType, indxType, offsetType, outType>::
   }
 }
 
+} // namespace
+
+template <
+    typename inType,
+    typename indxType,
+    typename offsetType,
+    typename outType,
+    bool THREAD_LOCAL>
+typename EmbeddingSpMDMKernelSignature<inType, indxType, offsetType, outType>::
+    Type
+    GenerateEmbeddingSpMDMWithStrides(
+        const int64_t block_size,
+        bool has_weight,
+        bool normalize_by_lengths,
+        int prefetch,
+        bool is_weight_positional,
+        bool use_offsets,
+        int64_t output_stride /*=-1*/,
+        int64_t input_stride /*=-1*/,
+        bool scale_bias_last /*=true*/,
+        bool no_bag /*=false*/,
+        bool is_bf16_out /*=false*/,
+        bool is_bf16_in /*=false*/) {
+  const int64_t row_bytes = std::is_same<inType, uint8_t>::value
+      ? block_size + 2 * (scale_bias_last ? sizeof(float) : sizeof(uint16_t))
+      : block_size * sizeof(inType);
+  return internal::traceKernel(
+      "EmbeddingSpMDM",
+      generateEmbeddingSpMDMWithStrides<
+          inType,
+          indxType,
+          offsetType,
+          outType,
+          THREAD_LOCAL>(
+          block_size,
+          has_weight,
+          normalize_by_lengths,
+          prefetch,
+          is_weight_positional,
+          use_offsets,
+          output_stride,
+          input_stride,
+          scale_bias_last,
+          no_bag,
+          is_bf16_out,
+          is_bf16_in),
+      block_size,
+      row_bytes + sizeof(indxType) + (has_weight ? sizeof(float) : 0),
+      block_size * sizeof(outType) + sizeof(offsetType));
+}
+
 template <
     typename inType,
     typename indxType,
@@ -1307,10 +1505,12 @@ typename EmbeddingSpMDMKernelSignature<inType, indxType, offsetType, outType>::
       is_bf16_in);
 }
 
+namespace {
+
 template <typename indxType, typename offsetType, typename outType>
 typename EmbeddingSpMDMKernelSignature<uint8_t, indxType, offsetType, outType>::
     Type
-    GenerateEmbeddingSpMDMFP8WithStrides(
+    generateEmbeddingSpMDMFP8WithStrides(
         const int64_t block_size,
         bool normalize_by_lengths,
         bool is_weight_positional,
@@ -1326,7 +1526,48 @@ typename EmbeddingSpMDMKernelSignature<uint8_t, indxType, offsetType, outType>::
   if (input_stride == -1) {
     input_stride = block_size;
   }
-  // There is only the reference implementation for FP8 embedding
+#if CPUINFO_ARCH_X86 || CPUINFO_ARCH_X86_64
+#ifndef NO_AVX512
+  if (!cpuinfo_initialize()) {
+    throw std::runtime_error("Failed to initialize cpuinfo!");
+  }
+  if (isZmm(fbgemmInstructionSet())) {
+    // FP8 rows take as many bytes as fused 8-bit rows
+    const int prefetch =
+        getEmbeddingPrefetchDistance(fbgemmInstructionSet(), 8, block_size);
+    return [=](int64_t output_size,
+               int64_t index_size,
+               int64_t data_size,
+               const uint8_t* input,
+               const indxType* indices,
+               const offsetType* offsets_or_lengths,
+               const float* weights,
+               outType* out) {
+      return internal::EmbeddingSpMDMFP8_avx512(
+          block_size,
+          output_size,
+          index_size,
+          data_size,
+          input,
+          indices,
+          offsets_or_lengths,
+          weights,
+          normalize_by_lengths,
+          out,
+          is_weight_positional,
+          use_offsets,
+          output_stride,
+          input_stride,
+          exponent_bits,
+          exponent_bias,
+          is_bf16_out,
+          prefetch);
+    };
+  }
+#endif // NO_AVX512
+#endif // CPUINFO_ARCH_X86 || CPUINFO_ARCH_X86_64
+
+  // Reference implementation on the other CPUs
   return [=](int64_t output_size,
              int64_t index_size,
              int64_t data_size,
@@ -1356,12 +1597,46 @@ typename EmbeddingSpMDMKernelSignature<uint8_t, indxType, offsetType, outType>::
   };
 }
 
+} // namespace
+
+template <typename indxType, typename offsetType, typename outType>
+typename EmbeddingSpMDMKernelSignature<uint8_t, indxType, offsetType, outType>::
+    Type
+    GenerateEmbeddingSpMDMFP8WithStrides(
+        const int64_t block_size,
+        bool normalize_by_lengths,
+        bool is_weight_positional,
+        bool use_offsets,
+        int64_t output_stride /*=-1*/,
+        int64_t input_stride /*=-1*/,
+        int exponent_bits,
+        int exponent_bias,
+        bool is_bf16_out) {
+  return internal::traceKernel(
+      "EmbeddingSpMDMFP8",
+      generateEmbeddingSpMDMFP8WithStrides<indxType, offsetType, outType>(
+          block_size,
+          normalize_by_lengths,
+          is_weight_positional,
+          use_offsets,
+          output_stride,
+          input_stride,
+          exponent_bits,
+          exponent_bias,
+          is_bf16_out),
+      block_size,
+      block_size + sizeof(indxType),
+      block_size * sizeof(outType) + sizeof(offsetType));
+}
+
+namespace {
+
 template <typename inType, typename indxType, typename offsetType>
 typename EmbeddingSpMDMRowWiseSparseKernelSignature<
     inType,
     indxType,
     offsetType>::Type
-GenerateEmbeddingSpMDMRowWiseSparse(
+generateEmbeddingSpMDMRowWiseSparse(
     const int64_t block_size,
     bool has_weight,
     bool normalize_by_lengths,
@@ -1371,6 +1646,10 @@ GenerateEmbeddingSpMDMRowWiseSparse(
   if (!cpuinfo_initialize()) {
     throw std::runtime_error("Failed to initialize cpuinfo!");
   }
+  if (prefetch == kEmbeddingPrefetchTuned) {
+    prefetch = getEmbeddingPrefetchDistance(
+        fbgemmInstructionSet(), 8 * sizeof(inType), block_size);
+  }
   int64_t input_stride = block_size;
   if (std::is_same<inType, uint8_t>::value) {
     const auto scale_bias_offset = 2 * sizeof(float);
@@ -1494,6 +1773,39 @@ GenerateEmbeddingSpMDMRowWiseSparse(
   }
 }
 
+} // namespace
+
+template <typename inType, typename indxType, typename offsetType>
+typename EmbeddingSpMDMRowWiseSparseKernelSignature<
+    inType,
+    indxType,
+    offsetType>::Type
+GenerateEmbeddingSpMDMRowWiseSparse(
+    const int64_t block_size,
+    bool has_weight,
+    bool normalize_by_lengths,
+    int prefetch,
+    bool is_weight_positional,
+    bool use_offsets) {
+  const int64_t row_bytes = std::is_same<inType, uint8_t>::value
+      ? block_size + 2 * sizeof(float)
+      : block_size * sizeof(inType);
+  // An index also reads its entry of the compressed indices table
+  return internal::traceKernel(
+      "EmbeddingSpMDMRowWiseSparse",
+      generateEmbeddingSpMDMRowWiseSparse<inType, indxType, offsetType>(
+          block_size,
+          has_weight,
+          normalize_by_lengths,
+          prefetch,
+          is_weight_positional,
+          use_offsets),
+      block_size,
+      row_bytes + sizeof(indxType) + sizeof(int32_t) +
+          (has_weight ? sizeof(float) : 0),
+      block_size * sizeof(float) + sizeof(offsetType));
+}
+
 #define INSTANTIATE_SPMDM_BASE(                               \
     IN_TYPE, INDEX_TYPE, OFFSET_TYPE, OUT_TYPE, THREAD_LOCAL) \
   template FBGEMM_API typename EmbeddingSpMDMKernelSignature< \
@@ -1623,6 +1935,119 @@ INSTANTIATE_SPMDM_INDEX_T(uint8_t)
 #undef INSTANTIATE_SPMDM_NOSTRIDE_BASE
 #undef INSTANTIATE_SPMDM_ROWWISE_BASE
 
+template <typename indxType, typename offsetType, typename outType>
+typename EmbeddingSpMDMKernelSignature<
+    uint16_t,
+    indxType,
+    offsetType,
+    outType>::Type
+GenerateEmbeddingSpMDMBf16Dot(
+    const int64_t block_size,
+    bool has_weight,
+    bool normalize_by_lengths,
+    int prefetch,
+    bool is_weight_positional,
+    bool use_offsets,
+    int64_t output_stride,
+    int64_t input_stride,
+    bool is_bf16_out) {
+  if (!cpuinfo_initialize()) {
+    throw std::runtime_error("Failed to initialize cpuinfo!");
+  }
+  if (prefetch == kEmbeddingPrefetchTuned) {
+    prefetch =
+        getEmbeddingPrefetchDistance(fbgemmInstructionSet(), 16, block_size);
+  }
+#if CPUINFO_ARCH_X86 || CPUINFO_ARCH_X86_64
+#ifndef NO_AVX512
+  if (isZmm(fbgemmInstructionSet()) && fbgemmHasAvx512Bf16Support()) {
+    if (output_stride == -1) {
+      output_stride = block_size;
+    }
+    if (input_stride == -1) {
+      input_stride = block_size;
+    }
+    return [=](int64_t output_size,
+               int64_t index_size,
+               int64_t data_size,
+               const uint16_t* input,
+               const indxType* indices,
+               const offsetType* offsets_or_lengths,
+               const float* weights,
+               outType* out) {
+      return internal::EmbeddingSpMDMBf16Dot_avx512bf16(
+          block_size,
+          output_size,
+          index_size,
+          data_size,
+          input,
+          indices,
+          offsets_or_lengths,
+          has_weight ? weights : nullptr,
+          normalize_by_lengths,
+          out,
+          is_weight_positional,
+          use_offsets,
+          output_stride,
+          input_stride,
+          is_bf16_out,
+          prefetch);
+    };
+  }
+#endif // NO_AVX512
+#endif // CPUINFO_ARCH_X86 || CPUINFO_ARCH_X86_64
+
+  return GenerateEmbeddingSpMDMWithStrides<
+      uint16_t,
+      indxType,
+      offsetType,
+      outType>(
+      block_size,
+      has_weight,
+      normalize_by_lengths,
+      prefetch,
+      is_weight_positional,
+      use_offsets,
+      output_stride,
+      input_stride,
+      /*scale_bias_last=*/true,
+      /*no_bag=*/false,
+      is_bf16_out,
+      /*is_bf16_in=*/true);
+}
+
+#define INSTANTIATE_SPMDM_BF16_DOT_BASE(INDEX_TYPE, OFFSET_TYPE, OUT_TYPE) \
+  template FBGEMM_API typename EmbeddingSpMDMKernelSignature<               \
+      uint16_t,                                                             \
+      INDEX_TYPE,                                                           \
+      OFFSET_TYPE,                                                          \
+      OUT_TYPE>::Type                                                       \
+  GenerateEmbeddingSpMDMBf16Dot<INDEX_TYPE, OFFSET_TYPE, OUT_TYPE>(         \
+      const int64_t block_size,                                             \
+      bool has_weight,                                                      \
+      bool normalize_by_lengths,                                            \
+      int prefetch,                                                         \
+      bool is_weight_positional,                                            \
+      bool use_offsets,                                                     \
+      int64_t output_stride,                                                \
+      int64_t input_stride,                                                 \
+      bool is_bf16_out);
+
+#define INSTANTIATE_SPMDM_BF16_DOT_OUT_T(INDEX_TYPE, OFFSET_TYPE) \
+  INSTANTIATE_SPMDM_BF16_DOT_BASE(INDEX_TYPE, OFFSET_TYPE, float) \
+  INSTANTIATE_SPMDM_BF16_DOT_BASE(INDEX_TYPE, OFFSET_TYPE, uint16_t)
+
+#define INSTANTIATE_SPMDM_BF16_DOT_OFFSET_T(INDEX_TYPE) \
+  INSTANTIATE_SPMDM_BF16_DOT_OUT_T(INDEX_TYPE, int32_t) \
+  INSTANTIATE_SPMDM_BF16_DOT_OUT_T(INDEX_TYPE, int64_t)
+
+INSTANTIATE_SPMDM_BF16_DOT_OFFSET_T(int32_t)
+INSTANTIATE_SPMDM_BF16_DOT_OFFSET_T(int64_t)
+
+#undef INSTANTIATE_SPMDM_BF16_DOT_OFFSET_T
+#undef INSTANTIATE_SPMDM_BF16_DOT_OUT_T
+#undef INSTANTIATE_SPMDM_BF16_DOT_BASE
+
 template <typename IndexType>
 void compressed_indices_remap(
     std::int32_t offsets_len,
@@ -1638,8 +2063,8 @@ void compressed_indices_remap(
   }
 
 #if CPUINFO_ARCH_X86 || CPUINFO_ARCH_X86_64
-#ifndef NO_AVX512
   const inst_set_t isa = fbgemmInstructionSet();
+#ifndef NO_AVX512
   if (isZmm(isa)) {
 #ifndef USE_ROCM
     if (weights == nullptr) {
@@ -1668,6 +2093,32 @@ void compressed_indices_remap(
 #endif // USE_ROCM
   }
 #endif // NO_AVX512
+#ifndef USE_ROCM
+  if (isYmm(isa)) {
+    if (weights == nullptr) {
+      internal::compressed_indices_remap_avx2<IndexType, false>(
+          offsets_len,
+          indices,
+          compressed_indices_mapping,
+          offsets,
+          weights,
+          out_indices,
+          out_offsets,
+          out_weights);
+    } else {
+      internal::compressed_indices_remap_avx2<IndexType, true>(
+          offsets_len,
+          indices,
+          compressed_indices_mapping,
+          offsets,
+          weights,
+          out_indices,
+          out_offsets,
+          out_weights);
+    }
+    return;
+  }
+#endif // USE_ROCM
 #endif // CPUINFO_ARCH_X86 || CPUINFO_ARCH_X86_64
 
   // Non-vectorized fallback implementation
@@ -1698,4 +2149,75 @@ INSTANTIATE_REMAP_BASE(int64_t)
 
 #undef INSTANTIATE_REMAP_BASE
 
+template <typename IndexType, typename OffsetType>
+void EmbeddingSortIndicesWithinBags(
+    std::int64_t output_size,
+    std::int64_t index_size,
+    const IndexType* indices,
+    const OffsetType* offsets_or_lengths,
+    const float* weights,
+    IndexType* out_indices,
+    float* out_weights,
+    bool is_weight_positional,
+    bool use_offsets) {
+  if (out_indices != indices) {
+    std::copy(indices, indices + index_size, out_indices);
+  }
+  if (weights && !is_weight_positional && out_weights != weights) {
+    std::copy(weights, weights + index_size, out_weights);
+  }
+  static thread_local std::vector<std::pair<IndexType, float>> bag;
+  std::int64_t current = 0;
+  for (std::int64_t m = 0; m < output_size; ++m) {
+    const std::int64_t len = use_offsets
+        ? offsets_or_lengths[m + 1] - offsets_or_lengths[m]
+        : offsets_or_lengths[m];
+    if (len < 0 || current + len > index_size) {
+      // Left for the kernel to reject
+      return;
+    }
+    IndexType* bag_indices = out_indices + current;
+    if (!weights) {
+      std::sort(bag_indices, bag_indices + len);
+    } else {
+      bag.resize(len);
+      for (std::int64_t i = 0; i < len; ++i) {
+        bag[i] = {
+            bag_indices[i],
+            is_weight_positional ? weights[i] : out_weights[current + i]};
+      }
+      std::sort(bag.begin(), bag.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+      });
+      for (std::int64_t i = 0; i < len; ++i) {
+        bag_indices[i] = bag[i].first;
+        out_weights[current + i] = bag[i].second;
+      }
+    }
+    current += len;
+  }
+}
+
+#define INSTANTIATE_SORT_BAGS_BASE(INDEX_TYPE, OFFSET_TYPE) \
+  template FBGEMM_API void EmbeddingSortIndicesWithinBags(  \
+      std::int64_t output_size,                             \
+      std::int64_t index_size,                              \
+      const INDEX_TYPE* indices,                            \
+      const OFFSET_TYPE* offsets_or_lengths,                \
+      const float* weights,                                 \
+      INDEX_TYPE* out_indices,                              \
+      float* out_weights,                                   \
+      bool is_weight_positional,                            \
+      bool use_offsets);
+
+#define INSTANTIATE_SORT_BAGS_OFFSET_T(INDEX_TYPE) \
+  INSTANTIATE_SORT_BAGS_BASE(INDEX_TYPE, int32_t)  \
+  INSTANTIATE_SORT_BAGS_BASE(INDEX_TYPE, int64_t)
+
+INSTANTIATE_SORT_BAGS_OFFSET_T(int32_t)
+INSTANTIATE_SORT_BAGS_OFFSET_T(int64_t)
+
+#undef INSTANTIATE_SORT_BAGS_OFFSET_T
+#undef INSTANTIATE_SORT_BAGS_BASE
+
 } // namespace fbgemm
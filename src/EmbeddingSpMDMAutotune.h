@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <random>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "fbgemm/FbgemmEmbedding.h"
+
+namespace fbgemm::internal {
+
+/**
+ * The implementations the EmbeddingSpMDM generators can return. kDefault is
+ * the usual choice by instruction set and the FBGEMM_NO_ASMJIT,
+ * FBGEMM_NO_AUTOVEC and FBGEMM_FORCE_AUTOVEC flags; the others force one.
+ * kPrecompiled is the AVX2 kernel compiled ahead of time for the dims of
+ * FBGEMM_PRECOMPILED_EMBEDDING_DIMS, the default when asmjit is disabled.
+ */
+enum class EmbeddingSpMDMImpl {
+  kDefault,
+  kAsmjit,
+  kPrecompiled,
+  kAutovec,
+  kRef
+};
+
+/**
+ * Times the candidates as described at autotuneEmbeddingSpMDM and returns the
+ * fastest, with its kernel in kernel_out.
+ */
+template <
+    typename inType,
+    typename indxType,
+    typename offsetType,
+    typename outType,
+    typename Generate>
+EmbeddingSpMDMImpl tuneEmbeddingSpMDM(
+    const std::vector<EmbeddingSpMDMImpl>& candidates,
+    const Generate& generate,
+    bool has_weight,
+    bool use_offsets,
+    std::int64_t input_stride,
+    std::int64_t output_stride,
+    typename EmbeddingSpMDMKernelSignature<
+        inType,
+        indxType,
+        offsetType,
+        outType>::Type& kernel_out) {
+  if (candidates.size() == 1) {
+    return candidates[0];
+  }
+
+  // 256 bags of 32 lookups into about 4 MB of table, so that most lookups
+  // miss in cache as in production
+  constexpr std::int64_t kOutputSize = 256;
+  constexpr std::int64_t kPoolingFactor = 32;
+  constexpr int kRepetitions = 5;
+  const std::int64_t row_bytes = input_stride * sizeof(inType);
+  const std::int64_t data_size = std::clamp<std::int64_t>(
+      (std::int64_t{4} << 20) / std::max<std::int64_t>(row_bytes, 1),
+      64,
+      1 << 16);
+  const std::int64_t index_size = kOutputSize * kPoolingFactor;
+  // Zeros rather than random bits so no implementation hits NaN or denormal
+  // scales and biases
+  const std::vector<inType> input(data_size * input_stride);
+  std::vector<indxType> indices(index_size);
+  std::minstd_rand generator(0);
+  std::uniform_int_distribution<std::int64_t> index_dist(0, data_size - 1);
+  for (auto& index : indices) {
+    index = static_cast<indxType>(index_dist(generator));
+  }
+  std::vector<offsetType> offsets_or_lengths(
+      use_offsets ? kOutputSize + 1 : kOutputSize);
+  for (std::int64_t i = 0; i < std::int64_t(offsets_or_lengths.size()); ++i) {
+    offsets_or_lengths[i] = use_offsets ? i * kPoolingFactor : kPoolingFactor;
+  }
+  const std::vector<float> weights(index_size, 1.0f);
+  std::vector<outType> out(kOutputSize * output_stride);
+
+  EmbeddingSpMDMImpl best = candidates.back();
+  std::remove_reference_t<decltype(kernel_out)> best_kernel;
+  double best_time = std::numeric_limits<double>::max();
+  for (const auto impl : candidates) {
+    auto kernel = generate(impl);
+    double time = std::numeric_limits<double>::max();
+    // The first run warms up the caches and TLB. A kernel failing on valid
+    // input is never chosen.
+    for (int r = 0; r <= kRepetitions; ++r) {
+      const auto start = std::chrono::steady_clock::now();
+      const bool success = kernel(
+          kOutputSize,
+          index_size,
+          data_size,
+          input.data(),
+          indices.data(),
+          offsets_or_lengths.data(),
+          has_weight ? weights.data() : nullptr,
+          out.data());
+      const auto end = std::chrono::steady_clock::now();
+      if (!success) {
+        time = std::numeric_limits<double>::max();
+        break;
+      }
+      if (r > 0) {
+        time = std::min(
+            time, std::chrono::duration<double>(end - start).count());
+      }
+    }
+    if (time < best_time) {
+      best = impl;
+      best_kernel = std::move(kernel);
+      best_time = time;
+    }
+  }
+  kernel_out = std::move(best_kernel);
+  return best;
+}
+
+/**
+ * Returns the fastest of the candidate implementations of an EmbeddingSpMDM
+ * kernel, as generated by generate(impl). The candidates are timed on a
+ * synthetic batch of random lookups into a zero table with the strides of
+ * the kernel, once per combination of the types and of all the arguments
+ * below, since the strides and flags change the relative speed of the
+ * implementations; later calls generate the cached winner.
+ *
+ * @param bit_rate the bits per element of the table.
+ */
+template <
+    typename inType,
+    typename indxType,
+    typename offsetType,
+    typename outType,
+    typename Generate>
+typename EmbeddingSpMDMKernelSignature<inType, indxType, offsetType, outType>::
+    Type
+    autotuneEmbeddingSpMDM(
+        const std::vector<EmbeddingSpMDMImpl>& candidates,
+        const Generate& generate,
+        int bit_rate,
+        bool is_bf16_in,
+        bool is_bf16_out,
+        std::int64_t block_size,
+        bool has_weight,
+        bool use_offsets,
+        std::int64_t input_stride,
+        std::int64_t output_stride,
+        bool normalize_by_lengths,
+        int prefetch,
+        bool is_weight_positional,
+        bool scale_bias_last) {
+  using Kernel = typename EmbeddingSpMDMKernelSignature<
+      inType,
+      indxType,
+      offsetType,
+      outType>::Type;
+  using Key = std::tuple<
+      int,
+      bool,
+      bool,
+      std::int64_t,
+      bool,
+      bool,
+      std::int64_t,
+      std::int64_t,
+      bool,
+      int,
+      bool,
+      bool>;
+  // The mutex only guards the map. Each key is tuned once, under its own
+  // once_flag, so that lookups and the tuning of other keys do not wait for
+  // it; map nodes do not move, so the entries can be used unlocked.
+  struct Winner {
+    std::once_flag tuned;
+    EmbeddingSpMDMImpl impl;
+  };
+  static std::mutex mutex;
+  static std::map<Key, Winner> winners;
+
+  const Key key{
+      bit_rate,
+      is_bf16_in,
+      is_bf16_out,
+      block_size,
+      has_weight,
+      use_offsets,
+      input_stride,
+      output_stride,
+      normalize_by_lengths,
+      prefetch,
+      is_weight_positional,
+      scale_bias_last};
+  Winner* winner;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    winner = &winners.try_emplace(key).first->second;
+  }
+  Kernel tuned_kernel;
+  std::call_once(winner->tuned, [&] {
+    winner->impl = tuneEmbeddingSpMDM<inType, indxType, offsetType, outType>(
+        candidates,
+        generate,
+        has_weight,
+        use_offsets,
+        input_stride,
+        output_stride,
+        tuned_kernel);
+  });
+  return tuned_kernel ? tuned_kernel : generate(winner->impl);
+}
+} // namespace fbgemm::internal
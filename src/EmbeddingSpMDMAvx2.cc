@@ -7,7 +7,9 @@
  */
 
 #define FBGEMM_EXPORTS
+#include <immintrin.h>
 #include <cmath>
+#include <type_traits>
 #include "RefImplementations.h"
 #include "fbgemm/FbgemmEmbedding.h"
 
@@ -160,5 +162,127 @@ INSTANTIATE_SPMDM_INDEX_T(std::uint8_t)
 #undef INSTANTIATE_SPMDM_OFFSET_T
 #undef INSTANTIATE_SPMDM_BASE
 
+namespace {
+
+// AVX2 has no vpcompress, so the kept lanes are moved to the front with
+// vpermd: row m lists the set bits of the 8-bit mask m, lowest first.
+struct CompressPermutations {
+  alignas(32) std::int32_t perm[256][8];
+};
+
+constexpr CompressPermutations makeCompressPermutations() {
+  CompressPermutations table{};
+  for (int mask = 0; mask < 256; ++mask) {
+    int n = 0;
+    for (int lane = 0; lane < 8; ++lane) {
+      if (mask & (1 << lane)) {
+        table.perm[mask][n++] = lane;
+      }
+    }
+  }
+  return table;
+}
+
+constexpr CompressPermutations kCompressPermutations =
+    makeCompressPermutations();
+
+} // namespace
+
+template <typename IndexType, bool HAS_WEIGHTS>
+void compressed_indices_remap_avx2(
+    std::int32_t offsets_len,
+    const IndexType* indices,
+    const int32_t* compressed_indices_mapping,
+    const IndexType* offsets,
+    const float* weights, // optional, can be null,
+    IndexType* out_indices,
+    IndexType* out_offsets,
+    float* out_weights) {
+  constexpr bool is_64bit = std::is_same<IndexType, std::int64_t>::value;
+  constexpr int VLEN = is_64bit ? 4 : 8;
+  const __m256i minus1_v = _mm256_set1_epi32(-1);
+  out_offsets[0] = offsets[0];
+  IndexType j = 0;
+  for (int i = 1; i < offsets_len; ++i) {
+    IndexType k = offsets[i - 1];
+    // Whole vectors are stored at j, which is at most k, so the stores stay
+    // within the first offsets[i] entries of the outputs
+    for (; k + VLEN <= offsets[i]; k += VLEN) {
+      const __m256i indices_v =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + k));
+      __m256i remapped_v;
+      if constexpr (is_64bit) {
+        remapped_v = _mm256_castsi128_si256(
+            _mm256_i64gather_epi32(compressed_indices_mapping, indices_v, 4));
+      } else {
+        remapped_v =
+            _mm256_i32gather_epi32(compressed_indices_mapping, indices_v, 4);
+      }
+      // The upper lanes of 64-bit indices are undefined and masked off
+      const int keep = ~_mm256_movemask_ps(_mm256_castsi256_ps(
+                           _mm256_cmpeq_epi32(remapped_v, minus1_v))) &
+          ((1 << VLEN) - 1);
+      const __m256i perm_v = _mm256_load_si256(
+          reinterpret_cast<const __m256i*>(kCompressPermutations.perm[keep]));
+      remapped_v = _mm256_permutevar8x32_epi32(remapped_v, perm_v);
+      if constexpr (is_64bit) {
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(out_indices + j),
+            _mm256_cvtepi32_epi64(_mm256_castsi256_si128(remapped_v)));
+      } else {
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(out_indices + j), remapped_v);
+      }
+      if constexpr (HAS_WEIGHTS) {
+        if constexpr (is_64bit) {
+          const __m256 weights_v =
+              _mm256_castps128_ps256(_mm_loadu_ps(weights + k));
+          _mm_storeu_ps(
+              out_weights + j,
+              _mm256_castps256_ps128(
+                  _mm256_permutevar8x32_ps(weights_v, perm_v)));
+        } else {
+          _mm256_storeu_ps(
+              out_weights + j,
+              _mm256_permutevar8x32_ps(_mm256_loadu_ps(weights + k), perm_v));
+        }
+      }
+      j += __builtin_popcount(keep);
+    }
+    for (; k < offsets[i]; ++k) {
+      const int32_t remapped = compressed_indices_mapping[indices[k]];
+      if (remapped != -1) {
+        out_indices[j] = remapped;
+        if constexpr (HAS_WEIGHTS) {
+          out_weights[j] = weights[k];
+        }
+        ++j;
+      }
+    }
+    out_offsets[i] = j;
+  }
+}
+
+#define INSTANTIATE_REMAP_BASE(INDEX_TYPE, HAS_WEIGHTS)                 \
+  template void compressed_indices_remap_avx2<INDEX_TYPE, HAS_WEIGHTS>( \
+      std::int32_t offsets_numel,                                       \
+      const INDEX_TYPE* indices,                                        \
+      const int32_t* compressed_indices_mapping,                        \
+      const INDEX_TYPE* offsets,                                        \
+      const float* weights,                                             \
+      INDEX_TYPE* out_indices,                                          \
+      INDEX_TYPE* out_offsets,                                          \
+      float* out_weights);
+
+#define INSTANTIATE_REMAP_WEIGHTS(INDEX_TYPE) \
+  INSTANTIATE_REMAP_BASE(INDEX_TYPE, false)   \
+  INSTANTIATE_REMAP_BASE(INDEX_TYPE, true)
+
+INSTANTIATE_REMAP_WEIGHTS(std::int32_t)
+INSTANTIATE_REMAP_WEIGHTS(std::int64_t)
+
+#undef INSTANTIATE_REMAP_WEIGHTS
+#undef INSTANTIATE_REMAP_BASE
+
 } // namespace internal
 } // namespace fbgemm
@@ -0,0 +1,298 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#define FBGEMM_EXPORTS
+#include "fbgemm/FbgemmEmbedding.h"
+
+#if defined(__x86_64__) || defined(__i386__) || \
+    (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
+#include <immintrin.h>
+#endif
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// AVX512-BF16 is only enabled in the dot-product kernels
+#if defined(_MSC_VER) && !defined(__clang__)
+#define FBGEMM_TARGET_AVX512_BF16
+#else
+#define FBGEMM_TARGET_AVX512_BF16 \
+  __attribute__((target("avx512f,avx512bw,avx512vl,avx512bf16")))
+#endif
+
+namespace fbgemm {
+namespace internal {
+
+namespace {
+
+// bfloat16 elements per zmm register and chunks of them pooled per pass
+// over the indices of a bag (two accumulators per chunk).
+constexpr int kBf16PerVec = 32;
+constexpr int kMaxChunks = 4;
+
+inline std::uint16_t floatToBf16Rne(float f) {
+  std::uint32_t u;
+  std::memcpy(&u, &f, sizeof(u));
+  u += 0x7fff + ((u >> 16) & 1);
+  return static_cast<std::uint16_t>(u >> 16);
+}
+
+// vdpbf16ps on two rows interleaved by vpunpck{l,h}wd accumulates, within
+// each 128-bit lane L, elements 8L..8L+3 into lo and 8L+4..8L+7 into hi.
+// Restores the order of the 32 elements as two vectors of 16 floats.
+FBGEMM_TARGET_AVX512_BF16 inline void
+unpermute(__m512 lo, __m512 hi, __m512& first, __m512& second) {
+  const __m512i first_idx = _mm512_set_epi32(
+      23, 22, 21, 20, 7, 6, 5, 4, 19, 18, 17, 16, 3, 2, 1, 0);
+  const __m512i second_idx = _mm512_set_epi32(
+      31, 30, 29, 28, 15, 14, 13, 12, 27, 26, 25, 24, 11, 10, 9, 8);
+  first = _mm512_permutex2var_ps(lo, first_idx, hi);
+  second = _mm512_permutex2var_ps(lo, second_idx, hi);
+}
+
+// Accumulates weight_pair-weighted rows a and b (b may be null for a zero
+// row) into the interleaved accumulators of unpermute.
+template <int NUM_CHUNKS>
+FBGEMM_TARGET_AVX512_BF16 inline void accumulatePair(
+    __m512* lo,
+    __m512* hi,
+    const std::uint16_t* a,
+    const std::uint16_t* b,
+    __mmask32 last_mask,
+    std::uint32_t weight_pair) {
+  const __m512bh w = (__m512bh)_mm512_set1_epi32(weight_pair);
+  for (int c = 0; c < NUM_CHUNKS; ++c) {
+    const __mmask32 mask =
+        c == NUM_CHUNKS - 1 ? last_mask : static_cast<__mmask32>(-1);
+    const __m512i va = _mm512_maskz_loadu_epi16(mask, a + c * kBf16PerVec);
+    const __m512i vb = b == nullptr
+        ? _mm512_setzero_si512()
+        : _mm512_maskz_loadu_epi16(mask, b + c * kBf16PerVec);
+    lo[c] =
+        _mm512_dpbf16_ps(lo[c], (__m512bh)_mm512_unpacklo_epi16(va, vb), w);
+    hi[c] =
+        _mm512_dpbf16_ps(hi[c], (__m512bh)_mm512_unpackhi_epi16(va, vb), w);
+  }
+}
+
+template <typename OutType>
+FBGEMM_TARGET_AVX512_BF16 inline void
+store(OutType* dst, __m512 v, __mmask16 mask, bool is_bf16_out) {
+  if constexpr (std::is_same_v<OutType, float>) {
+    (void)is_bf16_out;
+    _mm512_mask_storeu_ps(dst, mask, v);
+  } else if (is_bf16_out) {
+    // Same rounding as the JIT kernels: add 2^15 and truncate. The maskz
+    // forms avoid GCC's maybe-uninitialized false positives on the
+    // _mm512_undefined_* pass-through of the unmasked intrinsics.
+    const __m512i u = _mm512_add_epi32(
+        _mm512_castps_si512(v), _mm512_set1_epi32(1 << 15));
+    _mm512_mask_cvtepi32_storeu_epi16(
+        dst, mask, _mm512_maskz_srli_epi32(mask, u, 16));
+  } else {
+    _mm256_mask_storeu_epi16(
+        dst,
+        mask,
+        _mm512_maskz_cvtps_ph(
+            mask, v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+  }
+}
+
+// Pools NUM_CHUNKS * 32 elements starting at column col of the rows of one
+// bag, two rows per vdpbf16ps. Indices must have been checked.
+template <int NUM_CHUNKS, typename IndexType, typename OutType>
+FBGEMM_TARGET_AVX512_BF16 void poolChunks(
+    std::int64_t block_size,
+    std::int64_t col,
+    int len,
+    const std::uint16_t* input,
+    std::int64_t input_stride,
+    const IndexType* indices,
+    const float* weights,
+    float scale,
+    OutType* out,
+    bool is_bf16_out,
+    int prefetch) {
+  __m512 lo[NUM_CHUNKS], hi[NUM_CHUNKS];
+  for (int c = 0; c < NUM_CHUNKS; ++c) {
+    lo[c] = _mm512_setzero_ps();
+    hi[c] = _mm512_setzero_ps();
+  }
+  const std::int64_t last_len =
+      std::min<std::int64_t>(block_size - col, NUM_CHUNKS * kBf16PerVec) -
+      (NUM_CHUNKS - 1) * kBf16PerVec;
+  const __mmask32 last_mask = last_len >= kBf16PerVec
+      ? static_cast<__mmask32>(-1)
+      : (static_cast<__mmask32>(1) << last_len) - 1;
+  constexpr std::uint32_t kOnePair = 0x3f803f80; // (1.0, 1.0) in bfloat16
+
+  int j = 0;
+  for (; j + 1 < len; j += 2) {
+    if (prefetch && j + prefetch + 1 < len) {
+      for (int p = 0; p < 2; ++p) {
+        const char* row = reinterpret_cast<const char*>(
+            input + indices[j + prefetch + p] * input_stride + col);
+        for (int c = 0; c < NUM_CHUNKS; ++c) {
+          _mm_prefetch(row + c * kBf16PerVec * sizeof(std::uint16_t),
+                       _MM_HINT_T0);
+        }
+      }
+    }
+    const std::uint32_t weight_pair = weights == nullptr
+        ? kOnePair
+        : floatToBf16Rne(weights[j]) |
+            (static_cast<std::uint32_t>(floatToBf16Rne(weights[j + 1])) << 16);
+    accumulatePair<NUM_CHUNKS>(
+        lo,
+        hi,
+        input + indices[j] * input_stride + col,
+        input + indices[j + 1] * input_stride + col,
+        last_mask,
+        weight_pair);
+  }
+  if (j < len) {
+    accumulatePair<NUM_CHUNKS>(
+        lo,
+        hi,
+        input + indices[j] * input_stride + col,
+        nullptr,
+        last_mask,
+        weights == nullptr ? kOnePair : floatToBf16Rne(weights[j]));
+  }
+
+  const __m512 scale_v = _mm512_set1_ps(scale);
+  for (int c = 0; c < NUM_CHUNKS; ++c) {
+    __m512 first, second;
+    unpermute(lo[c], hi[c], first, second);
+    first = _mm512_mul_ps(first, scale_v);
+    second = _mm512_mul_ps(second, scale_v);
+    const std::int64_t n = std::min<std::int64_t>(
+        block_size - col - c * kBf16PerVec, kBf16PerVec);
+    const __mmask16 first_mask =
+        n >= 16 ? 0xffff : static_cast<__mmask16>((1 << n) - 1);
+    const __mmask16 second_mask = n >= 32
+        ? 0xffff
+        : static_cast<__mmask16>(n > 16 ? (1 << (n - 16)) - 1 : 0);
+    OutType* dst = out + col + c * kBf16PerVec;
+    store(dst, first, first_mask, is_bf16_out);
+    store(dst + 16, second, second_mask, is_bf16_out);
+  }
+}
+
+} // namespace
+
+template <typename IndexType, typename OffsetType, typename OutType>
+FBGEMM_TARGET_AVX512_BF16 bool EmbeddingSpMDMBf16Dot_avx512bf16(
+    const std::int64_t block_size,
+    const std::int64_t output_size,
+    const std::int64_t index_size,
+    const std::int64_t data_size,
+    const std::uint16_t* input,
+    const IndexType* indices,
+    const OffsetType* offsets_or_lengths,
+    const float* weights,
+    bool normalize_by_lengths,
+    OutType* out,
+    bool is_weight_positional,
+    bool use_offsets,
+    std::int64_t output_stride,
+    std::int64_t input_stride,
+    bool is_bf16_out,
+    int prefetch) {
+  std::int64_t current = 0;
+  for (std::int64_t m = 0; m < output_size; ++m) {
+    const int len = use_offsets
+        ? offsets_or_lengths[m + 1] - offsets_or_lengths[m]
+        : offsets_or_lengths[m];
+    if (current + len > index_size) {
+      return false;
+    }
+    const IndexType* bag_indices = indices + current;
+    for (int j = 0; j < len; ++j) {
+      if (bag_indices[j] < 0 || bag_indices[j] >= data_size) {
+        return false;
+      }
+    }
+    const float* bag_weights = nullptr;
+    if (weights != nullptr) {
+      bag_weights = is_weight_positional ? weights : weights + current;
+    }
+    const float scale =
+        normalize_by_lengths && len > 0 ? 1.0f / len : 1.0f;
+    OutType* bag_out = out + m * output_stride;
+
+    constexpr std::int64_t kGroup = kMaxChunks * kBf16PerVec;
+    for (std::int64_t col = 0; col < block_size; col += kGroup) {
+      const int num_chunks = static_cast<int>(std::min<std::int64_t>(
+          (block_size - col + kBf16PerVec - 1) / kBf16PerVec, kMaxChunks));
+      switch (num_chunks) {
+#define FBGEMM_POOL_CHUNKS(N)                   \
+  case N:                                       \
+    poolChunks<N>(                              \
+        block_size,                             \
+        col,                                    \
+        len,                                    \
+        input,                                  \
+        input_stride,                           \
+        bag_indices,                            \
+        bag_weights,                            \
+        scale,                                  \
+        bag_out,                                \
+        is_bf16_out,                            \
+        prefetch);                              \
+    break;
+        FBGEMM_POOL_CHUNKS(1)
+        FBGEMM_POOL_CHUNKS(2)
+        FBGEMM_POOL_CHUNKS(3)
+        FBGEMM_POOL_CHUNKS(4)
+#undef FBGEMM_POOL_CHUNKS
+      }
+    }
+    current += len;
+  }
+  return current == index_size;
+}
+
+#define INSTANTIATE_SPMDM_BF16_DOT_BASE(INDEX_TYPE, OFFSET_TYPE, OUT_TYPE) \
+  template FBGEMM_API bool                                                  \
+  EmbeddingSpMDMBf16Dot_avx512bf16<INDEX_TYPE, OFFSET_TYPE, OUT_TYPE>(       \
+      const std::int64_t block_size,                                        \
+      const std::int64_t output_size,                                       \
+      const std::int64_t index_size,                                        \
+      const std::int64_t data_size,                                         \
+      const std::uint16_t* input,                                           \
+      const INDEX_TYPE* indices,                                            \
+      const OFFSET_TYPE* offsets_or_lengths,                                \
+      const float* weights,                                                 \
+      bool normalize_by_lengths,                                            \
+      OUT_TYPE* out,                                                        \
+      bool is_weight_positional,                                            \
+      bool use_offsets,                                                     \
+      std::int64_t output_stride,                                           \
+      std::int64_t input_stride,                                            \
+      bool is_bf16_out,                                                     \
+      int prefetch);
+
+#define INSTANTIATE_SPMDM_BF16_DOT_OUT_T(INDEX_TYPE, OFFSET_TYPE) \
+  INSTANTIATE_SPMDM_BF16_DOT_BASE(INDEX_TYPE, OFFSET_TYPE, float) \
+  INSTANTIATE_SPMDM_BF16_DOT_BASE(INDEX_TYPE, OFFSET_TYPE, std::uint16_t)
+
+#define INSTANTIATE_SPMDM_BF16_DOT_OFFSET_T(INDEX_TYPE)     \
+  INSTANTIATE_SPMDM_BF16_DOT_OUT_T(INDEX_TYPE, std::int32_t) \
+  INSTANTIATE_SPMDM_BF16_DOT_OUT_T(INDEX_TYPE, std::int64_t)
+
+INSTANTIATE_SPMDM_BF16_DOT_OFFSET_T(std::int32_t)
+INSTANTIATE_SPMDM_BF16_DOT_OFFSET_T(std::int64_t)
+
+#undef INSTANTIATE_SPMDM_BF16_DOT_OFFSET_T
+#undef INSTANTIATE_SPMDM_BF16_DOT_OUT_T
+#undef INSTANTIATE_SPMDM_BF16_DOT_BASE
+
+} // namespace internal
+} // namespace fbgemm
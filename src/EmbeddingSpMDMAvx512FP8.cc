@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#define FBGEMM_EXPORTS
+#include "fbgemm/FbgemmEmbedding.h"
+
+#if defined(__x86_64__) || defined(__i386__) || \
+    (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
+#include <immintrin.h>
+#endif
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+
+namespace fbgemm {
+namespace internal {
+
+namespace {
+
+// FP8 elements per zmm register of floats and chunks of them pooled per pass
+// over the indices of a bag.
+constexpr int kFP8PerVec = 16;
+constexpr int kMaxChunks = 4;
+
+// Decodes 16 FP8 values with bit manipulation as Float8ToFloat_ref: the
+// exponent and mantissa bits are moved to the positions of fp32 and the
+// difference of the exponent biases is applied with a multiplication, which
+// also handles denormals.
+struct FP8Decoder {
+  FP8Decoder(int exponent_bits, int exponent_bias)
+      : mantissa_shift(_mm_cvtsi32_si128(24 - (8 - exponent_bits))),
+        multiplier_v(_mm512_castsi512_ps(
+            _mm512_set1_epi32((127 + (127 - exponent_bias)) << 23))) {}
+
+  __m512 decode(__m128i x) const {
+    const __m512i x_v = _mm512_cvtepu8_epi32(x);
+    const __m512i sign_v =
+        _mm512_slli_epi32(_mm512_and_si512(x_v, _mm512_set1_epi32(0x80)), 24);
+    const __m512i val_v = _mm512_sll_epi32(
+        _mm512_and_si512(x_v, _mm512_set1_epi32(0x7F)), mantissa_shift);
+    const __m512 out_v =
+        _mm512_mul_ps(_mm512_castsi512_ps(val_v), multiplier_v);
+    return _mm512_castsi512_ps(
+        _mm512_or_si512(_mm512_castps_si512(out_v), sign_v));
+  }
+
+  const __m128i mantissa_shift;
+  const __m512 multiplier_v;
+};
+
+template <typename OutType>
+inline void store(OutType* dst, __m512 v, __mmask16 mask, bool is_bf16_out) {
+  if constexpr (std::is_same_v<OutType, float>) {
+    (void)is_bf16_out;
+    _mm512_mask_storeu_ps(dst, mask, v);
+  } else if (is_bf16_out) {
+    // Same rounding as the reference: add 2^15 and truncate
+    const __m512i u = _mm512_add_epi32(
+        _mm512_castps_si512(v), _mm512_set1_epi32(1 << 15));
+    _mm512_mask_cvtepi32_storeu_epi16(
+        dst, mask, _mm512_maskz_srli_epi32(mask, u, 16));
+  } else {
+    _mm256_mask_storeu_epi16(
+        dst,
+        mask,
+        _mm512_maskz_cvtps_ph(
+            mask, v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+  }
+}
+
+// Pools NUM_CHUNKS * 16 elements starting at column col of the rows of one
+// bag. Indices must have been checked.
+template <int NUM_CHUNKS, typename IndexType, typename OutType>
+void poolChunks(
+    std::int64_t block_size,
+    std::int64_t col,
+    int len,
+    const std::uint8_t* input,
+    std::int64_t input_stride,
+    const IndexType* indices,
+    const float* weights,
+    float scale,
+    OutType* out,
+    const FP8Decoder& decoder,
+    bool is_bf16_out,
+    int prefetch) {
+  __m512 acc[NUM_CHUNKS];
+  __mmask16 masks[NUM_CHUNKS];
+  for (int c = 0; c < NUM_CHUNKS; ++c) {
+    acc[c] = _mm512_setzero_ps();
+    const std::int64_t n = std::min<std::int64_t>(
+        block_size - col - c * kFP8PerVec, kFP8PerVec);
+    masks[c] = n >= kFP8PerVec ? 0xffff : static_cast<__mmask16>((1 << n) - 1);
+  }
+
+  for (int j = 0; j < len; ++j) {
+    if (prefetch && j + prefetch < len) {
+      // A chunk group is at most one cache line of FP8 elements
+      _mm_prefetch(
+          reinterpret_cast<const char*>(
+              input + indices[j + prefetch] * input_stride + col),
+          _MM_HINT_T0);
+    }
+    const __m512 w_v = _mm512_set1_ps(weights ? weights[j] : 1.0f);
+    const std::uint8_t* row = input + indices[j] * input_stride + col;
+    for (int c = 0; c < NUM_CHUNKS; ++c) {
+      const __m128i x = _mm_maskz_loadu_epi8(masks[c], row + c * kFP8PerVec);
+      acc[c] = _mm512_fmadd_ps(w_v, decoder.decode(x), acc[c]);
+    }
+  }
+
+  for (int c = 0; c < NUM_CHUNKS; ++c) {
+    __m512 v = acc[c];
+    if (scale != 1.0f) {
+      v = _mm512_mul_ps(v, _mm512_set1_ps(scale));
+    }
+    store(out + col + c * kFP8PerVec, v, masks[c], is_bf16_out);
+  }
+}
+
+} // namespace
+
+template <typename IndexType, typename OffsetType, typename OutType>
+bool EmbeddingSpMDMFP8_avx512(
+    const std::int64_t block_size,
+    const std::int64_t output_size,
+    const std::int64_t index_size,
+    const std::int64_t data_size,
+    const std::uint8_t* input,
+    const IndexType* indices,
+    const OffsetType* offsets_or_lengths,
+    const float* weights,
+    bool normalize_by_lengths,
+    OutType* out,
+    bool is_weight_positional,
+    bool use_offsets,
+    std::int64_t output_stride,
+    std::int64_t input_stride,
+    int exponent_bits,
+    int exponent_bias,
+    bool is_bf16_out,
+    int prefetch) {
+  const FP8Decoder decoder(exponent_bits, exponent_bias);
+  std::int64_t current = 0;
+  for (std::int64_t m = 0; m < output_size; ++m) {
+    const int len = use_offsets
+        ? offsets_or_lengths[m + 1] - offsets_or_lengths[m]
+        : offsets_or_lengths[m];
+    if (current + len > index_size) {
+      return false;
+    }
+    const IndexType* bag_indices = indices + current;
+    for (int j = 0; j < len; ++j) {
+      if (bag_indices[j] < 0 || bag_indices[j] >= data_size) {
+        return false;
+      }
+    }
+    const float* bag_weights = nullptr;
+    if (weights != nullptr) {
+      bag_weights = is_weight_positional ? weights : weights + current;
+    }
+    const float scale = normalize_by_lengths && len > 0 ? 1.0f / len : 1.0f;
+    OutType* bag_out = out + m * output_stride;
+
+    constexpr std::int64_t kGroup = kMaxChunks * kFP8PerVec;
+    for (std::int64_t col = 0; col < block_size; col += kGroup) {
+      const int num_chunks = static_cast<int>(std::min<std::int64_t>(
+          (block_size - col + kFP8PerVec - 1) / kFP8PerVec, kMaxChunks));
+      switch (num_chunks) {
+#define FBGEMM_POOL_CHUNKS(N) \
+  case N:                     \
+    poolChunks<N>(            \
+        block_size,           \
+        col,                  \
+        len,                  \
+        input,                \
+        input_stride,         \
+        bag_indices,          \
+        bag_weights,          \
+        scale,                \
+        bag_out,              \
+        decoder,              \
+        is_bf16_out,          \
+        prefetch);            \
+    break;
+        FBGEMM_POOL_CHUNKS(1)
+        FBGEMM_POOL_CHUNKS(2)
+        FBGEMM_POOL_CHUNKS(3)
+        FBGEMM_POOL_CHUNKS(4)
+#undef FBGEMM_POOL_CHUNKS
+      }
+    }
+    current += len;
+  }
+  return current == index_size;
+}
+
+#define INSTANTIATE_SPMDM_FP8_BASE(INDEX_TYPE, OFFSET_TYPE, OUT_TYPE) \
+  template FBGEMM_API bool                                            \
+  EmbeddingSpMDMFP8_avx512<INDEX_TYPE, OFFSET_TYPE, OUT_TYPE>(        \
+      const std::int64_t block_size,                                  \
+      const std::int64_t output_size,                                 \
+      const std::int64_t index_size,                                  \
+      const std::int64_t data_size,                                   \
+      const std::uint8_t* input,                                      \
+      const INDEX_TYPE* indices,                                      \
+      const OFFSET_TYPE* offsets_or_lengths,                          \
+      const float* weights,                                           \
+      bool normalize_by_lengths,                                      \
+      OUT_TYPE* out,                                                  \
+      bool is_weight_positional,                                      \
+      bool use_offsets,                                               \
+      std::int64_t output_stride,                                     \
+      std::int64_t input_stride,                                      \
+      int exponent_bits,                                              \
+      int exponent_bias,                                              \
+      bool is_bf16_out,                                               \
+      int prefetch);
+
+#define INSTANTIATE_SPMDM_FP8_OUT_T(INDEX_TYPE, OFFSET_TYPE) \
+  INSTANTIATE_SPMDM_FP8_BASE(INDEX_TYPE, OFFSET_TYPE, float) \
+  INSTANTIATE_SPMDM_FP8_BASE(INDEX_TYPE, OFFSET_TYPE, std::uint16_t)
+
+#define INSTANTIATE_SPMDM_FP8_OFFSET_T(INDEX_TYPE)     \
+  INSTANTIATE_SPMDM_FP8_OUT_T(INDEX_TYPE, std::int32_t) \
+  INSTANTIATE_SPMDM_FP8_OUT_T(INDEX_TYPE, std::int64_t)
+
+INSTANTIATE_SPMDM_FP8_OFFSET_T(std::int32_t)
+INSTANTIATE_SPMDM_FP8_OFFSET_T(std::int64_t)
+
+#undef INSTANTIATE_SPMDM_FP8_OFFSET_T
+#undef INSTANTIATE_SPMDM_FP8_OUT_T
+#undef INSTANTIATE_SPMDM_FP8_BASE
+
+} // namespace internal
+} // namespace fbgemm
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace fbgemm {
+
+namespace internal {
+
+/**
+ * Runs an EmbeddingSpMDM kernel on bags [begin, end) whose indices start at
+ * index_begin. The kernels only look at differences of offsets, so the
+ * offsets (or lengths) of the bags are passed as they are, with the indices
+ * and, unless they are positional, the weights rebased to index_begin.
+ */
+template <
+    typename Kernel,
+    typename InType,
+    typename IndexType,
+    typename OffsetType,
+    typename OutType>
+bool runEmbeddingBags(
+    const Kernel& kernel,
+    std::int64_t begin,
+    std::int64_t end,
+    std::int64_t index_begin,
+    std::int64_t index_size,
+    std::int64_t data_size,
+    const InType* input,
+    const IndexType* indices,
+    const OffsetType* offsets_or_lengths,
+    const float* weights,
+    bool is_weight_positional,
+    OutType* out) {
+  return kernel(
+      end - begin,
+      index_size,
+      data_size,
+      input,
+      indices + index_begin,
+      offsets_or_lengths + begin,
+      weights != nullptr && !is_weight_positional ? weights + index_begin
+                                                  : weights,
+      out);
+}
+
+} // namespace internal
+
+} // namespace fbgemm
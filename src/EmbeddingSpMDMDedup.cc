@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#define FBGEMM_EXPORTS
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "fbgemm/FbgemmEmbedding.h"
+#include "fbgemm/QuantUtils.h"
+#include "fbgemm/Utils.h"
+
+namespace fbgemm {
+
+template <typename IndexType, typename OffsetType>
+typename EmbeddingSpMDMKernelSignature<
+    std::uint8_t,
+    IndexType,
+    OffsetType,
+    float>::Type
+GenerateEmbeddingSpMDMDedup(
+    int bit_rate,
+    const std::int64_t block_size,
+    bool has_weight,
+    bool normalize_by_lengths,
+    int prefetch,
+    bool is_weight_positional,
+    bool use_offsets,
+    std::int64_t output_stride,
+    std::int64_t input_stride) {
+  if (bit_rate != 8 && bit_rate != 4 && bit_rate != 2) {
+    throw std::runtime_error(
+        "bit_rate = " + std::to_string(bit_rate) +
+        " is not supported, must be 8, 4 or 2");
+  }
+  // The dequantized rows have a multiple of 8 / bit_rate elements, so they
+  // are laid out at the stride of the packed row
+  std::int64_t row_bytes, row_floats;
+  if (bit_rate == 8) {
+    row_bytes = block_size + 2 * sizeof(float);
+    row_floats = block_size;
+  } else {
+    const int num_elem_per_byte = 8 / bit_rate;
+    const std::int64_t packed_bytes =
+        (block_size + num_elem_per_byte - 1) / num_elem_per_byte;
+    row_bytes = packed_bytes + 2 * sizeof(float16);
+    row_floats = packed_bytes * num_elem_per_byte;
+  }
+  if (input_stride == -1) {
+    input_stride = row_bytes;
+  }
+
+  // Pools the dequantized distinct rows, indexed by their rank
+  const auto pool =
+      GenerateEmbeddingSpMDMWithStrides<float, IndexType, OffsetType, float>(
+          block_size,
+          has_weight,
+          normalize_by_lengths,
+          prefetch,
+          is_weight_positional,
+          use_offsets,
+          output_stride,
+          /*input_stride=*/row_floats);
+
+  return [=](std::int64_t output_size,
+             std::int64_t index_size,
+             std::int64_t data_size,
+             const std::uint8_t* input,
+             const IndexType* indices,
+             const OffsetType* offsets_or_lengths,
+             const float* weights,
+             float* out) {
+    for (std::int64_t i = 0; i < index_size; ++i) {
+      if (indices[i] < 0 || indices[i] >= data_size) {
+        return false;
+      }
+    }
+
+    static thread_local std::vector<IndexType> unique_indices;
+    static thread_local std::vector<std::int64_t> counts;
+    static thread_local std::vector<std::int64_t> inverse_indices;
+    static thread_local std::vector<IndexType> remapped_indices;
+    static thread_local std::vector<float> rows;
+    unique_indices.resize(index_size);
+    counts.resize(index_size);
+    inverse_indices.resize(index_size);
+    remapped_indices.resize(index_size);
+    const std::int64_t num_unique = radix_sort_unique_with_counts(
+        indices,
+        index_size,
+        data_size - 1,
+        /*maybe_with_neg_vals=*/false,
+        unique_indices.data(),
+        counts.data(),
+        inverse_indices.data());
+    for (std::int64_t i = 0; i < index_size; ++i) {
+      remapped_indices[i] = static_cast<IndexType>(inverse_indices[i]);
+    }
+
+    // Every distinct row is read and dequantized once, in ascending order
+    rows.resize(num_unique * row_floats);
+    for (std::int64_t u = 0; u < num_unique; ++u) {
+      const std::uint8_t* row = input + unique_indices[u] * input_stride;
+      if (bit_rate == 8) {
+        Fused8BitRowwiseQuantizedSBFloatToFloatOrHalf<float>(
+            row, 1, row_bytes, rows.data() + u * row_floats);
+      } else {
+        FusedNBitRowwiseQuantizedSBHalfToFloatOrHalf<float>(
+            bit_rate, row, 1, row_bytes, rows.data() + u * row_floats);
+      }
+    }
+
+    return pool(
+        output_size,
+        index_size,
+        num_unique,
+        rows.data(),
+        remapped_indices.data(),
+        offsets_or_lengths,
+        weights,
+        out);
+  };
+}
+
+#define INSTANTIATE_SPMDM_DEDUP_BASE(INDEX_TYPE, OFFSET_TYPE) \
+  template FBGEMM_API typename EmbeddingSpMDMKernelSignature< \
+      std::uint8_t,                                           \
+      INDEX_TYPE,                                             \
+      OFFSET_TYPE,                                            \
+      float>::Type                                            \
+  GenerateEmbeddingSpMDMDedup<INDEX_TYPE, OFFSET_TYPE>(       \
+      int bit_rate,                                           \
+      const std::int64_t block_size,                          \
+      bool has_weight,                                        \
+      bool normalize_by_lengths,                              \
+      int prefetch,                                           \
+      bool is_weight_positional,                              \
+      bool use_offsets,                                       \
+      std::int64_t output_stride,                             \
+      std::int64_t input_stride);
+
+#define INSTANTIATE_SPMDM_DEDUP_OFFSET_T(INDEX_TYPE) \
+  INSTANTIATE_SPMDM_DEDUP_BASE(INDEX_TYPE, int32_t)  \
+  INSTANTIATE_SPMDM_DEDUP_BASE(INDEX_TYPE, int64_t)
+
+INSTANTIATE_SPMDM_DEDUP_OFFSET_T(int32_t)
+INSTANTIATE_SPMDM_DEDUP_OFFSET_T(int64_t)
+
+#undef INSTANTIATE_SPMDM_DEDUP_OFFSET_T
+#undef INSTANTIATE_SPMDM_DEDUP_BASE
+
+} // namespace fbgemm
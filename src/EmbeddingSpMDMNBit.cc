@@ -20,9 +20,12 @@
 #include <string>
 #include <tuple>
 #include "./CodeCache.h"
+#include "./CodeStorage.h"
+#include "./EmbeddingSpMDMAutotune.h"
 #include "./EmbeddingSpMDMAutovec.h"
 #include "./MaskAvx2.h"
 #include "./RefImplementations.h"
+#include "./TraceScope.h"
 #include "fbgemm/SimdUtils.h"
 #include "fbgemm/Types.h"
 
@@ -167,7 +170,7 @@ CodeCache<
         outType,
         instSet,
         ROWWISE_SPARSE,
-        THREAD_LOCAL>::codeCache_;
+        THREAD_LOCAL>::codeCache_("embedding_nbit");
 
 template <
     typename indxType,
@@ -220,6 +223,25 @@ GenEmbeddingSpMDMNBitLookup<
                 offsetType,
                 outType,
                 ROWWISE_SPARSE>::jit_embedding_kernel {
+        typename ReturnFunctionSignature<
+            indxType,
+            offsetType,
+            outType,
+            ROWWISE_SPARSE>::jit_embedding_kernel fn;
+        const string jitKey = getJitCacheKey(
+            "embedding_nbit",
+            instSet,
+            tuple_cat(
+                make_tuple(
+                    sizeof(indxType),
+                    sizeof(offsetType),
+                    sizeof(outType),
+                    ROWWISE_SPARSE),
+                kernelSig));
+        if (loadJitKernel(runtime(), rtMutex_, jitKey, &fn)) {
+          return fn;
+        }
+
         // TODO: Make this tunable
         int pref_dist = prefetch;
         bool areIndices64b = is_same<indxType, int64_t>::value;
@@ -988,17 +1010,8 @@ GenEmbeddingSpMDMNBitLookup<
 
         a->emitEpilog(frame);
 
-        // jit_fused8bitembedding_kernel fn;
-        typename ReturnFunctionSignature<
-            indxType,
-            offsetType,
-            outType,
-            ROWWISE_SPARSE>::jit_embedding_kernel fn;
-        asmjit::Error err;
-        {
-          unique_lock<mutex> lock(rtMutex_);
-          err = runtime().add(&fn, &code);
-        }
+        asmjit::Error err =
+            addJitKernel(runtime(), rtMutex_, &fn, code, jitKey);
         if (err) {
           cout << "Error: in fn add" << endl;
           return nullptr;
@@ -1012,8 +1025,6 @@ GenEmbeddingSpMDMNBitLookup<
       });
 }
 
-} // namespace
-
 template <
     typename indxType,
     typename offsetType,
@@ -1021,7 +1032,7 @@ template <
     bool THREAD_LOCAL>
 typename EmbeddingSpMDMKernelSignature<uint8_t, indxType, offsetType, outType>::
     Type
-    GenerateEmbeddingSpMDMNBitWithStrides(
+    generateEmbeddingSpMDMNBitWithStrides(
         int bit_rate,
         const int64_t block_size,
         bool has_weight,
@@ -1032,12 +1043,18 @@ typename EmbeddingSpMDMKernelSignature<uint8_t, indxType, offsetType, outType>::
         int64_t output_stride /*=-1*/,
         int64_t input_stride /*=-1*/,
         bool scale_bias_last /*=true*/,
-        bool is_bf16_out) {
+        bool is_bf16_out,
+        internal::EmbeddingSpMDMImpl impl =
+            internal::EmbeddingSpMDMImpl::kDefault) {
   assert((bit_rate == 2 || bit_rate == 4) && "bit_rate must be 2 or 4");
 
   if (!cpuinfo_initialize()) {
     throw runtime_error("Failed to initialize cpuinfo!");
   }
+  if (prefetch == kEmbeddingPrefetchTuned) {
+    prefetch = getEmbeddingPrefetchDistance(
+        fbgemmInstructionSet(), bit_rate, block_size);
+  }
   if (output_stride == -1) {
     output_stride = block_size;
   }
@@ -1046,7 +1063,100 @@ typename EmbeddingSpMDMKernelSignature<uint8_t, indxType, offsetType, outType>::
     input_stride =
         ceil_div(block_size, num_elem_per_byte) + 2 * sizeof(uint16_t);
   }
-  if (fbgemmHasAvx512Support() && !is_asmjit_disabled()) {
+  const bool use_asmjit = impl == internal::EmbeddingSpMDMImpl::kDefault
+      ? !is_asmjit_disabled()
+      : impl == internal::EmbeddingSpMDMImpl::kAsmjit;
+#ifdef __linux__
+  const bool use_autovec = impl == internal::EmbeddingSpMDMImpl::kDefault
+      ? (fbgemmHasArmSve2Support() && !is_autovec_disabled()) ||
+          is_autovec_forced()
+      : impl == internal::EmbeddingSpMDMImpl::kAutovec;
+#endif
+
+  if (impl == internal::EmbeddingSpMDMImpl::kDefault &&
+      is_embedding_autotune_enabled()) {
+    std::vector<internal::EmbeddingSpMDMImpl> candidates;
+    if (fbgemmHasAvx2Support() && !is_asmjit_disabled()) {
+      candidates.push_back(internal::EmbeddingSpMDMImpl::kAsmjit);
+    }
+    if constexpr (std::is_same<outType, float>::value) {
+      if (fbgemmHasAvx2Support() &&
+          internal::isPrecompiledEmbeddingDim(block_size)) {
+        candidates.push_back(internal::EmbeddingSpMDMImpl::kPrecompiled);
+      }
+    }
+#ifdef __linux__
+    if (!is_autovec_disabled()) {
+      candidates.push_back(internal::EmbeddingSpMDMImpl::kAutovec);
+    }
+#endif
+    candidates.push_back(internal::EmbeddingSpMDMImpl::kRef);
+    return internal::
+        autotuneEmbeddingSpMDM<uint8_t, indxType, offsetType, outType>(
+            candidates,
+            [=](internal::EmbeddingSpMDMImpl candidate) {
+              return generateEmbeddingSpMDMNBitWithStrides<
+                  indxType,
+                  offsetType,
+                  outType,
+                  THREAD_LOCAL>(
+                  bit_rate,
+                  block_size,
+                  has_weight,
+                  normalize_by_lengths,
+                  prefetch,
+                  is_weight_positional,
+                  use_offsets,
+                  output_stride,
+                  input_stride,
+                  scale_bias_last,
+                  is_bf16_out,
+                  candidate);
+            },
+            bit_rate,
+            /*is_bf16_in=*/false,
+            is_bf16_out,
+            block_size,
+            has_weight,
+            use_offsets,
+            input_stride,
+            output_stride,
+            normalize_by_lengths,
+            prefetch,
+            is_weight_positional,
+            scale_bias_last);
+  }
+
+  if constexpr (std::is_same<outType, float>::value) {
+    // Without asmjit, the hot dims have a kernel compiled ahead of time
+#ifdef __linux__
+    const bool use_default_precompiled = !use_asmjit && !use_autovec;
+#else
+    const bool use_default_precompiled = !use_asmjit;
+#endif
+    const bool use_precompiled = impl == internal::EmbeddingSpMDMImpl::kDefault
+        ? use_default_precompiled
+        : impl == internal::EmbeddingSpMDMImpl::kPrecompiled;
+    if (use_precompiled && fbgemmHasAvx2Support()) {
+      auto kernel = internal::
+          GenerateEmbeddingSpMDMPrecompiled_avx2<uint8_t, indxType, offsetType>(
+              bit_rate,
+              block_size,
+              has_weight,
+              normalize_by_lengths,
+              prefetch,
+              is_weight_positional,
+              use_offsets,
+              output_stride,
+              input_stride,
+              scale_bias_last);
+      if (kernel) {
+        return kernel;
+      }
+    }
+  }
+
+  if (isZmm(fbgemmInstructionSet()) && use_asmjit) {
     static GenEmbeddingSpMDMNBitLookup<
         indxType,
         offsetType,
@@ -1067,6 +1177,31 @@ typename EmbeddingSpMDMKernelSignature<uint8_t, indxType, offsetType, outType>::
         input_stride,
         scale_bias_last,
         is_bf16_out);
+    // Calls below fbgemmSetZmmMinWork() run the AVX2 kernel, to not lower
+    // the core frequency
+    static GenEmbeddingSpMDMNBitLookup<
+        indxType,
+        offsetType,
+        outType,
+        inst_set_t::avx2,
+        /*ROWWISE_SPARSE=*/false,
+        THREAD_LOCAL>
+        ymm_kernel_generator;
+    const int64_t zmm_min_work = fbgemmGetZmmMinWork();
+    const auto ymm_func = zmm_min_work > 0
+        ? ymm_kernel_generator.getOrCreate(
+              bit_rate,
+              block_size,
+              has_weight,
+              is_weight_positional,
+              normalize_by_lengths,
+              prefetch,
+              use_offsets,
+              output_stride,
+              input_stride,
+              scale_bias_last,
+              is_bf16_out)
+        : nullptr;
     return [=](int64_t output_size,
                int64_t index_size,
                int64_t data_size,
@@ -1075,6 +1210,18 @@ typename EmbeddingSpMDMKernelSignature<uint8_t, indxType, offsetType, outType>::
                const offsetType* offsets_or_lengths,
                const float* weights,
                outType* out) {
+      if (ymm_func && index_size * block_size < zmm_min_work) {
+        return ymm_func(
+            output_size,
+            index_size,
+            data_size,
+            input,
+            indices,
+            offsets_or_lengths,
+            weights,
+            out,
+            internal::avx2_ps_or_epi32_combined_mask);
+      }
       return original_func(
           output_size,
           index_size,
@@ -1086,7 +1233,7 @@ typename EmbeddingSpMDMKernelSignature<uint8_t, indxType, offsetType, outType>::
           out,
           nullptr /* mask not used in avx512 */);
     };
-  } else if (fbgemmHasAvx2Support() && !is_asmjit_disabled()) {
+  } else if (fbgemmHasAvx2Support() && use_asmjit) {
     static GenEmbeddingSpMDMNBitLookup<
         indxType,
         offsetType,
@@ -1127,9 +1274,7 @@ typename EmbeddingSpMDMKernelSignature<uint8_t, indxType, offsetType, outType>::
           internal::avx2_ps_or_epi32_combined_mask);
     };
 #ifdef __linux__
-  } else if (
-      (fbgemmHasArmSve2Support() && !is_autovec_disabled()) ||
-      is_autovec_forced()) {
+  } else if (use_autovec) {
     return [=](int64_t output_size,
                int64_t index_size,
                int64_t data_size,
@@ -1192,6 +1337,52 @@ typename EmbeddingSpMDMKernelSignature<uint8_t, indxType, offsetType, outType>::
   }
 }
 
+} // namespace
+
+template <
+    typename indxType,
+    typename offsetType,
+    typename outType,
+    bool THREAD_LOCAL>
+typename EmbeddingSpMDMKernelSignature<uint8_t, indxType, offsetType, outType>::
+    Type
+    GenerateEmbeddingSpMDMNBitWithStrides(
+        int bit_rate,
+        const int64_t block_size,
+        bool has_weight,
+        bool normalize_by_lengths,
+        int prefetch,
+        bool is_weight_positional,
+        bool use_offsets,
+        int64_t output_stride /*=-1*/,
+        int64_t input_stride /*=-1*/,
+        bool scale_bias_last /*=true*/,
+        bool is_bf16_out) {
+  const int64_t row_bytes =
+      ceil_div<int64_t>(block_size * bit_rate, 8) + 2 * sizeof(uint16_t);
+  return internal::traceKernel(
+      "EmbeddingSpMDMNBit",
+      generateEmbeddingSpMDMNBitWithStrides<
+          indxType,
+          offsetType,
+          outType,
+          THREAD_LOCAL>(
+          bit_rate,
+          block_size,
+          has_weight,
+          normalize_by_lengths,
+          prefetch,
+          is_weight_positional,
+          use_offsets,
+          output_stride,
+          input_stride,
+          scale_bias_last,
+          is_bf16_out),
+      block_size,
+      row_bytes + sizeof(indxType) + (has_weight ? sizeof(float) : 0),
+      block_size * sizeof(outType) + sizeof(offsetType));
+}
+
 template <typename IndexType, typename OffsetType, typename OutType>
 FBGEMM_API typename EmbeddingSpMDMKernelSignature<
     std::uint8_t,
@@ -1216,12 +1407,92 @@ GenerateEmbeddingSpMDMNBit(
       use_offsets);
 }
 
+template <typename IndexType, typename OffsetType, typename OutType>
+typename EmbeddingSpMDMKernelSignature<uint8_t, IndexType, OffsetType, OutType>::
+    Type
+    GenerateEmbeddingSpMDMNBitGroupwise(
+        int bit_rate,
+        int group_size,
+        const int64_t block_size,
+        bool has_weight,
+        bool normalize_by_lengths,
+        int prefetch,
+        bool is_weight_positional,
+        bool use_offsets,
+        int64_t output_stride /*=-1*/,
+        int64_t input_stride /*=-1*/,
+        bool is_bf16_out /*=false*/) {
+  assert((bit_rate == 2 || bit_rate == 4) && "bit_rate must be 2 or 4");
+  assert(
+      group_size > 0 && block_size % group_size == 0 &&
+      group_size % (8 / bit_rate) == 0 && "unsupported group_size");
+  if (group_size == block_size) {
+    // A single group is a rowwise row with its scale and bias last
+    return GenerateEmbeddingSpMDMNBitWithStrides<
+        IndexType,
+        OffsetType,
+        OutType>(
+        bit_rate,
+        block_size,
+        has_weight,
+        normalize_by_lengths,
+        prefetch,
+        is_weight_positional,
+        use_offsets,
+        output_stride,
+        input_stride,
+        /*scale_bias_last=*/true,
+        is_bf16_out);
+  }
+
+  const int64_t row_bytes = block_size * bit_rate / 8 +
+      block_size / group_size * 2 * sizeof(uint16_t);
+  return internal::traceKernel(
+      "EmbeddingSpMDMNBitGroupwise",
+      typename EmbeddingSpMDMKernelSignature<
+          uint8_t,
+          IndexType,
+          OffsetType,
+          OutType>::Type([=](int64_t output_size,
+                             int64_t index_size,
+                             int64_t data_size,
+                             const uint8_t* input,
+                             const IndexType* indices,
+                             const OffsetType* offsets_or_lengths,
+                             const float* weights,
+                             OutType* out) {
+        return EmbeddingSpMDMNBitGroupwise_ref(
+            bit_rate,
+            group_size,
+            block_size,
+            output_size,
+            index_size,
+            data_size,
+            input,
+            indices,
+            offsets_or_lengths,
+            weights,
+            normalize_by_lengths,
+            out,
+            is_weight_positional,
+            use_offsets,
+            output_stride,
+            input_stride,
+            is_bf16_out);
+      }),
+      block_size,
+      row_bytes + sizeof(IndexType) + (has_weight ? sizeof(float) : 0),
+      block_size * sizeof(OutType) + sizeof(OffsetType));
+}
+
+namespace {
+
 template <typename indxType, typename offsetType>
 typename EmbeddingSpMDMRowWiseSparseKernelSignature<
     uint8_t,
     indxType,
     offsetType>::Type
-GenerateEmbeddingSpMDMNBitRowWiseSparse(
+generateEmbeddingSpMDMNBitRowWiseSparse(
     int bit_rate,
     const int64_t block_size,
     bool has_weight,
@@ -1234,6 +1505,10 @@ GenerateEmbeddingSpMDMNBitRowWiseSparse(
   if (!cpuinfo_initialize()) {
     throw runtime_error("Failed to initialize cpuinfo!");
   }
+  if (prefetch == kEmbeddingPrefetchTuned) {
+    prefetch = getEmbeddingPrefetchDistance(
+        fbgemmInstructionSet(), bit_rate, block_size);
+  }
   int64_t num_elem_per_byte = 8 / bit_rate;
   int64_t input_stride =
       ceil_div(block_size, num_elem_per_byte) + 2 * sizeof(uint16_t);
@@ -1352,6 +1627,40 @@ GenerateEmbeddingSpMDMNBitRowWiseSparse(
   }
 }
 
+} // namespace
+
+template <typename indxType, typename offsetType>
+typename EmbeddingSpMDMRowWiseSparseKernelSignature<
+    uint8_t,
+    indxType,
+    offsetType>::Type
+GenerateEmbeddingSpMDMNBitRowWiseSparse(
+    int bit_rate,
+    const int64_t block_size,
+    bool has_weight,
+    bool normalize_by_lengths,
+    int prefetch,
+    bool is_weight_positional,
+    bool use_offsets) {
+  const int64_t row_bytes =
+      ceil_div<int64_t>(block_size * bit_rate, 8) + 2 * sizeof(uint16_t);
+  // An index also reads its entry of the compressed indices table
+  return internal::traceKernel(
+      "EmbeddingSpMDMNBitRowWiseSparse",
+      generateEmbeddingSpMDMNBitRowWiseSparse<indxType, offsetType>(
+          bit_rate,
+          block_size,
+          has_weight,
+          normalize_by_lengths,
+          prefetch,
+          is_weight_positional,
+          use_offsets),
+      block_size,
+      row_bytes + sizeof(indxType) + sizeof(int32_t) +
+          (has_weight ? sizeof(float) : 0),
+      block_size * sizeof(float) + sizeof(offsetType));
+}
+
 #define INSTANTIATE_SPMDM_BASE(                               \
     INDEX_TYPE, OFFSET_TYPE, OUT_TYPE, THREAD_LOCAL)          \
   template FBGEMM_API typename EmbeddingSpMDMKernelSignature< \
@@ -1391,7 +1700,24 @@ GenerateEmbeddingSpMDMNBitRowWiseSparse(
       bool normalize_by_lengths,                                          \
       int prefetch,                                                       \
       bool is_weight_positional,                                          \
-      bool use_offsets);
+      bool use_offsets);                                                  \
+  template FBGEMM_API typename EmbeddingSpMDMKernelSignature<             \
+      uint8_t,                                                            \
+      INDEX_TYPE,                                                         \
+      OFFSET_TYPE,                                                        \
+      OUT_TYPE>::Type                                                     \
+  GenerateEmbeddingSpMDMNBitGroupwise<INDEX_TYPE, OFFSET_TYPE, OUT_TYPE>( \
+      int bit_rate,                                                       \
+      int group_size,                                                     \
+      const int64_t block_size,                                           \
+      bool has_weight,                                                    \
+      bool normalize_by_lengths,                                          \
+      int prefetch,                                                       \
+      bool is_weight_positional,                                          \
+      bool use_offsets,                                                   \
+      int64_t output_stride,                                              \
+      int64_t input_stride,                                               \
+      bool is_bf16_out);
 
 #define INSTANTIATE_SPMDM_OUT_T(INDEX_TYPE, OFFSET_TYPE)                   \
   INSTANTIATE_SPMDM_THREAD_LOCAL(INDEX_TYPE, OFFSET_TYPE, float)           \
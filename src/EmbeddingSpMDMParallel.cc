@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#define FBGEMM_EXPORTS
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "./EmbeddingSpMDMBags.h"
+#include "fbgemm/FbgemmEmbedding.h"
+#include "fbgemm/Types.h"
+
+namespace fbgemm {
+
+namespace {
+
+// Each bag costs its number of indices plus one for writing its output, so
+// empty bags are accounted for and the cost of the first b bags is strictly
+// increasing in b.
+template <typename OffsetType>
+std::int64_t firstBagWithCost(
+    const OffsetType* offsets,
+    std::int64_t output_size,
+    std::int64_t cost) {
+  std::int64_t lo = 0, hi = output_size;
+  while (lo < hi) {
+    const std::int64_t mid = lo + (hi - lo) / 2;
+    if (offsets[mid] - offsets[0] + mid >= cost) {
+      hi = mid;
+    } else {
+      lo = mid + 1;
+    }
+  }
+  return lo;
+}
+
+} // namespace
+
+template <
+    typename InType,
+    typename IndexType,
+    typename OffsetType,
+    typename OutType>
+bool EmbeddingSpMDMParallel(
+    const typename EmbeddingSpMDMKernelSignature<
+        InType,
+        IndexType,
+        OffsetType,
+        OutType>::Type& kernel,
+    std::int64_t output_stride,
+    std::int64_t output_size,
+    std::int64_t index_size,
+    std::int64_t data_size,
+    const InType* input,
+    const IndexType* indices,
+    const OffsetType* offsets,
+    const float* weights,
+    OutType* out,
+    int num_threads,
+    const ParallelTasksExecutor& parallel_for,
+    bool is_weight_positional) {
+  if (num_threads <= 0) {
+    num_threads = fbgemmGetNumThreads();
+  }
+  num_threads = static_cast<int>(std::min<std::int64_t>(
+      num_threads, std::max<std::int64_t>(output_size, 1)));
+  if (num_threads == 1) {
+    return kernel(
+        output_size,
+        index_size,
+        data_size,
+        input,
+        indices,
+        offsets,
+        weights,
+        out);
+  }
+
+  const std::int64_t total_cost =
+      offsets[output_size] - offsets[0] + output_size;
+  // Written by different threads, so no vector<bool>.
+  std::vector<std::uint8_t> success(num_threads, 1);
+  auto task = [&](int task_id) {
+    const std::int64_t begin = firstBagWithCost(
+        offsets, output_size, total_cost * task_id / num_threads);
+    const std::int64_t end = firstBagWithCost(
+        offsets, output_size, total_cost * (task_id + 1) / num_threads);
+    if (begin == end) {
+      return;
+    }
+    const std::int64_t index_begin = offsets[begin] - offsets[0];
+    const std::int64_t index_end =
+        std::min<std::int64_t>(offsets[end] - offsets[0], index_size);
+    success[task_id] = internal::runEmbeddingBags(
+        kernel,
+        begin,
+        end,
+        index_begin,
+        std::max<std::int64_t>(index_end - index_begin, 0),
+        data_size,
+        input,
+        indices,
+        offsets,
+        weights,
+        is_weight_positional,
+        out + begin * output_stride);
+  };
+  if (parallel_for) {
+    parallel_for(num_threads, task);
+  } else {
+    fbgemmParallelTasks(num_threads, task);
+  }
+  return std::all_of(
+      success.begin(), success.end(), [](std::uint8_t s) { return s != 0; });
+}
+
+#define INSTANTIATE_SPMDM_PARALLEL_BASE(                          \
+    IN_TYPE, INDEX_TYPE, OFFSET_TYPE, OUT_TYPE)                   \
+  template FBGEMM_API bool EmbeddingSpMDMParallel(                \
+      const typename EmbeddingSpMDMKernelSignature<               \
+          IN_TYPE,                                                \
+          INDEX_TYPE,                                             \
+          OFFSET_TYPE,                                            \
+          OUT_TYPE>::Type& kernel,                                \
+      std::int64_t output_stride,                                 \
+      std::int64_t output_size,                                   \
+      std::int64_t index_size,                                    \
+      std::int64_t data_size,                                     \
+      const IN_TYPE* input,                                       \
+      const INDEX_TYPE* indices,                                  \
+      const OFFSET_TYPE* offsets,                                 \
+      const float* weights,                                       \
+      OUT_TYPE* out,                                              \
+      int num_threads,                                            \
+      const ParallelTasksExecutor& parallel_for,                  \
+      bool is_weight_positional);
+
+#define INSTANTIATE_SPMDM_PARALLEL_OUT_T(IN_TYPE, INDEX_TYPE, OFFSET_TYPE) \
+  INSTANTIATE_SPMDM_PARALLEL_BASE(IN_TYPE, INDEX_TYPE, OFFSET_TYPE, float) \
+  INSTANTIATE_SPMDM_PARALLEL_BASE(                                         \
+      IN_TYPE, INDEX_TYPE, OFFSET_TYPE, uint16_t)
+
+#define INSTANTIATE_SPMDM_PARALLEL_OFFSET_T(IN_TYPE, INDEX_TYPE) \
+  INSTANTIATE_SPMDM_PARALLEL_OUT_T(IN_TYPE, INDEX_TYPE, int32_t) \
+  INSTANTIATE_SPMDM_PARALLEL_OUT_T(IN_TYPE, INDEX_TYPE, int64_t)
+
+#define INSTANTIATE_SPMDM_PARALLEL_INDEX_T(IN_TYPE)     \
+  INSTANTIATE_SPMDM_PARALLEL_OFFSET_T(IN_TYPE, int32_t) \
+  INSTANTIATE_SPMDM_PARALLEL_OFFSET_T(IN_TYPE, int64_t)
+
+INSTANTIATE_SPMDM_PARALLEL_INDEX_T(float)
+INSTANTIATE_SPMDM_PARALLEL_INDEX_T(uint16_t)
+INSTANTIATE_SPMDM_PARALLEL_INDEX_T(uint8_t)
+
+#undef INSTANTIATE_SPMDM_PARALLEL_INDEX_T
+#undef INSTANTIATE_SPMDM_PARALLEL_OFFSET_T
+#undef INSTANTIATE_SPMDM_PARALLEL_OUT_T
+#undef INSTANTIATE_SPMDM_PARALLEL_BASE
+
+} // namespace fbgemm
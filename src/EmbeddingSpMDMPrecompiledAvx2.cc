@@ -0,0 +1,328 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#define FBGEMM_EXPORTS
+#include <immintrin.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+
+#include "fbgemm/FbgemmEmbedding.h"
+#include "fbgemm/Types.h"
+
+// The embedding dims with a kernel compiled ahead of time, for hosts where
+// asmjit is disabled. Each must be a multiple of 8.
+#ifndef FBGEMM_PRECOMPILED_EMBEDDING_DIMS
+#define FBGEMM_PRECOMPILED_EMBEDDING_DIMS 32, 64, 128, 256
+#endif
+
+namespace fbgemm {
+namespace internal {
+
+namespace {
+
+using PrecompiledDims =
+    std::integer_sequence<int, FBGEMM_PRECOMPILED_EMBEDDING_DIMS>;
+
+// Converts the 8 elements of a fused row starting at element j to float
+template <int BIT_RATE>
+inline __m256 loadElements(const std::uint8_t* row, int j) {
+  if constexpr (BIT_RATE == 8) {
+    return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(row + j))));
+  } else if constexpr (BIT_RATE == 4) {
+    std::int32_t packed;
+    std::memcpy(&packed, row + j / 2, sizeof(packed));
+    __m128i bytes = _mm_cvtsi32_si128(packed);
+    // Every byte twice, shifted to its low and then its high nibble
+    bytes = _mm_unpacklo_epi8(bytes, bytes);
+    const __m256i elements = _mm256_srlv_epi32(
+        _mm256_cvtepu8_epi32(bytes), _mm256_setr_epi32(0, 4, 0, 4, 0, 4, 0, 4));
+    return _mm256_cvtepi32_ps(
+        _mm256_and_si256(elements, _mm256_set1_epi32(0x0f)));
+  } else {
+    static_assert(BIT_RATE == 2, "bit_rate must be 8, 4 or 2");
+    std::uint16_t packed;
+    std::memcpy(&packed, row + j / 4, sizeof(packed));
+    __m128i bytes = _mm_cvtsi32_si128(packed);
+    bytes = _mm_unpacklo_epi8(bytes, bytes);
+    bytes = _mm_unpacklo_epi16(bytes, bytes);
+    const __m256i elements = _mm256_srlv_epi32(
+        _mm256_cvtepu8_epi32(bytes), _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6));
+    return _mm256_cvtepi32_ps(
+        _mm256_and_si256(elements, _mm256_set1_epi32(0x03)));
+  }
+}
+
+// As EmbeddingSpMDM_ref and EmbeddingSpMDMNBit_ref with float output, with
+// the loops over a row unrolled into BLOCK_SIZE / 8 accumulators. BIT_RATE
+// 32 reads float rows.
+template <
+    int BLOCK_SIZE,
+    int BIT_RATE,
+    typename InType,
+    typename IndexType,
+    typename OffsetType>
+bool EmbeddingSpMDMPrecompiled_(
+    const std::int64_t output_size,
+    const std::int64_t index_size,
+    const std::int64_t data_size,
+    const InType* input,
+    const IndexType* indices,
+    const OffsetType* offsets_or_lengths,
+    const float* weights,
+    bool normalize_by_lengths,
+    float* out,
+    bool is_weight_positional,
+    bool use_offsets,
+    std::int64_t output_stride,
+    std::int64_t input_stride,
+    bool scale_bias_last,
+    int prefetch) {
+  static_assert(
+      BLOCK_SIZE > 0 && BLOCK_SIZE % 8 == 0,
+      "precompiled embedding dims must be multiples of 8");
+  constexpr int kNumVecs = BLOCK_SIZE / 8;
+  constexpr bool kIsFloat = BIT_RATE == 32;
+  constexpr int kRowBytes = BLOCK_SIZE * BIT_RATE / 8;
+  constexpr int CACHE_LINE_LEN = 64;
+  // Only 8-bit rows with the scale and bias last store them in float
+  const bool is_fp16_scale_bias = BIT_RATE != 8 || !scale_bias_last;
+  const int scale_bias_offset = scale_bias_last ? kRowBytes : 0;
+  const int elements_offset = scale_bias_last ? 0 : 2 * sizeof(float16);
+
+  std::int64_t current = 0;
+  for (std::int64_t m = 0; m < output_size; ++m) {
+    const int len = use_offsets
+        ? offsets_or_lengths[m + 1] - offsets_or_lengths[m]
+        : offsets_or_lengths[m];
+    if (current + len > index_size) {
+      return false;
+    }
+    __m256 acc[kNumVecs];
+    for (int v = 0; v < kNumVecs; ++v) {
+      acc[v] = _mm256_setzero_ps();
+    }
+    for (int i = 0; i < len; ++i, ++current) {
+      const std::int64_t idx = indices[current];
+      if (!kIsFloat && !scale_bias_last && idx == -1) {
+        // Pruned row of table batched embedding, as in the reference
+        continue;
+      }
+      if (idx < 0 || idx >= data_size) {
+        return false;
+      }
+      if (prefetch) {
+        const std::int64_t prefetch_idx =
+            indices[std::min<std::int64_t>(current + prefetch, index_size - 1)];
+        const char* prefetch_row =
+            reinterpret_cast<const char*>(input + input_stride * prefetch_idx);
+        for (int b = 0; b < kRowBytes; b += CACHE_LINE_LEN) {
+          _mm_prefetch(prefetch_row + b, _MM_HINT_T0);
+        }
+      }
+
+      const float weight =
+          weights ? weights[is_weight_positional ? i : current] : 1.0f;
+      const InType* row = input + input_stride * idx;
+      if constexpr (kIsFloat) {
+        const __m256 w = _mm256_set1_ps(weight);
+        for (int v = 0; v < kNumVecs; ++v) {
+          acc[v] = _mm256_fmadd_ps(w, _mm256_loadu_ps(row + 8 * v), acc[v]);
+        }
+      } else {
+        float scale, bias;
+        if (is_fp16_scale_bias) {
+          float16 scale_bias[2];
+          std::memcpy(scale_bias, row + scale_bias_offset, sizeof(scale_bias));
+          scale = cpu_half2float(scale_bias[0]);
+          bias = cpu_half2float(scale_bias[1]);
+        } else {
+          float scale_bias[2];
+          std::memcpy(scale_bias, row + scale_bias_offset, sizeof(scale_bias));
+          scale = scale_bias[0];
+          bias = scale_bias[1];
+        }
+        const __m256 scale_v = _mm256_set1_ps(weight * scale);
+        const __m256 bias_v = _mm256_set1_ps(weight * bias);
+        const std::uint8_t* elements = row + elements_offset;
+        for (int v = 0; v < kNumVecs; ++v) {
+          acc[v] = _mm256_fmadd_ps(
+              scale_v,
+              loadElements<BIT_RATE>(elements, 8 * v),
+              _mm256_add_ps(acc[v], bias_v));
+        }
+      }
+    }
+    if (normalize_by_lengths && len) {
+      const __m256 scale = _mm256_set1_ps(1.0f / len);
+      for (int v = 0; v < kNumVecs; ++v) {
+        acc[v] = _mm256_mul_ps(acc[v], scale);
+      }
+    }
+    for (int v = 0; v < kNumVecs; ++v) {
+      _mm256_storeu_ps(out + 8 * v, acc[v]);
+    }
+    out += output_stride;
+  }
+  return current == index_size;
+}
+
+template <
+    int BIT_RATE,
+    typename InType,
+    typename IndexType,
+    typename OffsetType,
+    int... DIMS>
+typename EmbeddingSpMDMKernelSignature<InType, IndexType, OffsetType, float>::
+    Type
+    selectPrecompiledKernel(
+        std::integer_sequence<int, DIMS...>,
+        std::int64_t block_size,
+        bool has_weight,
+        bool normalize_by_lengths,
+        int prefetch,
+        bool is_weight_positional,
+        bool use_offsets,
+        std::int64_t output_stride,
+        std::int64_t input_stride,
+        bool scale_bias_last) {
+  typename EmbeddingSpMDMKernelSignature<InType, IndexType, OffsetType, float>::
+      Type kernel;
+  const auto make = [&](auto dim) {
+    constexpr int BLOCK_SIZE = decltype(dim)::value;
+    kernel = [=](std::int64_t output_size,
+                 std::int64_t index_size,
+                 std::int64_t data_size,
+                 const InType* input,
+                 const IndexType* indices,
+                 const OffsetType* offsets_or_lengths,
+                 const float* weights,
+                 float* out) {
+      return EmbeddingSpMDMPrecompiled_<
+          BLOCK_SIZE,
+          BIT_RATE,
+          InType,
+          IndexType,
+          OffsetType>(
+          output_size,
+          index_size,
+          data_size,
+          input,
+          indices,
+          offsets_or_lengths,
+          has_weight ? weights : nullptr,
+          normalize_by_lengths,
+          out,
+          is_weight_positional,
+          use_offsets,
+          output_stride,
+          input_stride,
+          scale_bias_last,
+          prefetch);
+    };
+    return true;
+  };
+  ((block_size == DIMS && make(std::integral_constant<int, DIMS>{})) || ...);
+  return kernel;
+}
+
+template <int... DIMS>
+constexpr bool hasDim(std::integer_sequence<int, DIMS...>, std::int64_t dim) {
+  return ((dim == DIMS) || ...);
+}
+
+} // namespace
+
+bool isPrecompiledEmbeddingDim(std::int64_t block_size) {
+  return hasDim(PrecompiledDims{}, block_size);
+}
+
+template <typename InType, typename IndexType, typename OffsetType>
+typename EmbeddingSpMDMKernelSignature<InType, IndexType, OffsetType, float>::
+    Type
+    GenerateEmbeddingSpMDMPrecompiled_avx2(
+        int bit_rate,
+        std::int64_t block_size,
+        bool has_weight,
+        bool normalize_by_lengths,
+        int prefetch,
+        bool is_weight_positional,
+        bool use_offsets,
+        std::int64_t output_stride,
+        std::int64_t input_stride,
+        bool scale_bias_last) {
+#define SELECT_PRECOMPILED_KERNEL(BIT_RATE)                                \
+  return selectPrecompiledKernel<BIT_RATE, InType, IndexType, OffsetType>( \
+      PrecompiledDims{},                                                   \
+      block_size,                                                          \
+      has_weight,                                                          \
+      normalize_by_lengths,                                                \
+      prefetch,                                                            \
+      is_weight_positional,                                                \
+      use_offsets,                                                         \
+      output_stride,                                                       \
+      input_stride,                                                        \
+      scale_bias_last)
+  if constexpr (std::is_same_v<InType, float>) {
+    if (bit_rate == 32) {
+      SELECT_PRECOMPILED_KERNEL(32);
+    }
+  } else {
+    if (bit_rate == 8) {
+      SELECT_PRECOMPILED_KERNEL(8);
+    } else if (bit_rate == 4) {
+      SELECT_PRECOMPILED_KERNEL(4);
+    } else if (bit_rate == 2) {
+      SELECT_PRECOMPILED_KERNEL(2);
+    }
+  }
+#undef SELECT_PRECOMPILED_KERNEL
+  return {};
+}
+
+#define INSTANTIATE_SPMDM_BASE(IN_TYPE, INDEX_TYPE, OFFSET_TYPE) \
+  template FBGEMM_API typename EmbeddingSpMDMKernelSignature<    \
+      IN_TYPE,                                                   \
+      INDEX_TYPE,                                                \
+      OFFSET_TYPE,                                               \
+      float>::Type                                               \
+  GenerateEmbeddingSpMDMPrecompiled_avx2<                        \
+      IN_TYPE,                                                   \
+      INDEX_TYPE,                                                \
+      OFFSET_TYPE>(                                              \
+      int bit_rate,                                              \
+      std::int64_t block_size,                                   \
+      bool has_weight,                                           \
+      bool normalize_by_lengths,                                 \
+      int prefetch,                                              \
+      bool is_weight_positional,                                 \
+      bool use_offsets,                                          \
+      std::int64_t output_stride,                                \
+      std::int64_t input_stride,                                 \
+      bool scale_bias_last);
+
+#define INSTANTIATE_SPMDM_OFFSET_T(IN_TYPE, INDEX_TYPE) \
+  INSTANTIATE_SPMDM_BASE(IN_TYPE, INDEX_TYPE, int32_t)  \
+  INSTANTIATE_SPMDM_BASE(IN_TYPE, INDEX_TYPE, int64_t)
+
+#define INSTANTIATE_SPMDM_INDEX_T(IN_TYPE)     \
+  INSTANTIATE_SPMDM_OFFSET_T(IN_TYPE, int32_t) \
+  INSTANTIATE_SPMDM_OFFSET_T(IN_TYPE, int64_t)
+
+INSTANTIATE_SPMDM_INDEX_T(float)
+INSTANTIATE_SPMDM_INDEX_T(std::uint8_t)
+
+#undef INSTANTIATE_SPMDM_INDEX_T
+#undef INSTANTIATE_SPMDM_OFFSET_T
+#undef INSTANTIATE_SPMDM_BASE
+
+} // namespace internal
+} // namespace fbgemm
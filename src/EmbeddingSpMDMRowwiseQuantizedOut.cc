@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#define FBGEMM_EXPORTS
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "./EmbeddingSpMDMBags.h"
+#include "fbgemm/FbgemmEmbedding.h"
+#include "fbgemm/QuantUtils.h"
+
+namespace fbgemm {
+
+namespace {
+
+// Float rows pooled before they are quantized: small enough to stay in L1,
+// large enough to amortize calling the pooling kernel.
+constexpr std::int64_t kScratchFloats = 4096;
+
+} // namespace
+
+template <typename IndexType, typename OffsetType>
+typename EmbeddingSpMDMKernelSignature<
+    std::uint8_t,
+    IndexType,
+    OffsetType,
+    std::uint8_t>::Type
+GenerateEmbeddingSpMDMRowwiseQuantizedOut(
+    int bit_rate,
+    const std::int64_t block_size,
+    bool has_weight,
+    bool normalize_by_lengths,
+    int prefetch,
+    bool is_weight_positional,
+    bool use_offsets,
+    std::int64_t output_stride,
+    std::int64_t input_stride,
+    bool scale_bias_last) {
+  if (bit_rate != 8 && bit_rate != 4 && bit_rate != 2) {
+    throw std::runtime_error(
+        "bit_rate = " + std::to_string(bit_rate) +
+        " is not supported, must be 8, 4 or 2");
+  }
+  const std::int64_t output_row_size = block_size + 2 * sizeof(float);
+  if (output_stride == -1) {
+    output_stride = output_row_size;
+  }
+
+  typename EmbeddingSpMDMKernelSignature<
+      std::uint8_t,
+      IndexType,
+      OffsetType,
+      float>::Type pool;
+  if (bit_rate == 8) {
+    pool = GenerateEmbeddingSpMDMWithStrides<
+        std::uint8_t,
+        IndexType,
+        OffsetType,
+        float>(
+        block_size,
+        has_weight,
+        normalize_by_lengths,
+        prefetch,
+        is_weight_positional,
+        use_offsets,
+        /*output_stride=*/-1,
+        input_stride,
+        scale_bias_last);
+  } else {
+    pool = GenerateEmbeddingSpMDMNBitWithStrides<IndexType, OffsetType, float>(
+        bit_rate,
+        block_size,
+        has_weight,
+        normalize_by_lengths,
+        prefetch,
+        is_weight_positional,
+        use_offsets,
+        /*output_stride=*/-1,
+        input_stride,
+        scale_bias_last);
+  }
+
+  const std::int64_t chunk_size = std::max<std::int64_t>(
+      kScratchFloats / std::max<std::int64_t>(block_size, 1), 1);
+  return [=](std::int64_t output_size,
+             std::int64_t index_size,
+             std::int64_t data_size,
+             const std::uint8_t* input,
+             const IndexType* indices,
+             const OffsetType* offsets_or_lengths,
+             const float* weights,
+             std::uint8_t* out) {
+    static thread_local std::vector<float> pooled;
+    pooled.resize(chunk_size * block_size);
+
+    std::int64_t index_begin = 0;
+    for (std::int64_t begin = 0; begin < output_size; begin += chunk_size) {
+      const std::int64_t end = std::min(begin + chunk_size, output_size);
+      std::int64_t chunk_index_size;
+      if (end == output_size) {
+        chunk_index_size = index_size - index_begin;
+      } else if (use_offsets) {
+        chunk_index_size = offsets_or_lengths[end] - offsets_or_lengths[begin];
+      } else {
+        chunk_index_size = 0;
+        for (std::int64_t b = begin; b < end; ++b) {
+          chunk_index_size += offsets_or_lengths[b];
+        }
+      }
+      if (chunk_index_size < 0 || index_begin + chunk_index_size > index_size) {
+        return false;
+      }
+      if (!internal::runEmbeddingBags(
+              pool,
+              begin,
+              end,
+              index_begin,
+              chunk_index_size,
+              data_size,
+              input,
+              indices,
+              offsets_or_lengths,
+              weights,
+              is_weight_positional,
+              pooled.data())) {
+        return false;
+      }
+
+      std::uint8_t* chunk_out = out + begin * output_stride;
+      if (output_stride == output_row_size) {
+        FloatOrHalfToFused8BitRowwiseQuantizedSBFloat<float>(
+            pooled.data(), end - begin, block_size, chunk_out);
+      } else {
+        for (std::int64_t b = 0; b < end - begin; ++b) {
+          FloatOrHalfToFused8BitRowwiseQuantizedSBFloat<float>(
+              pooled.data() + b * block_size,
+              1,
+              block_size,
+              chunk_out + b * output_stride);
+        }
+      }
+      index_begin += chunk_index_size;
+    }
+    return true;
+  };
+}
+
+#define INSTANTIATE_SPMDM_ROWWISE_QUANTIZED_OUT_BASE(INDEX_TYPE, OFFSET_TYPE) \
+  template FBGEMM_API typename EmbeddingSpMDMKernelSignature<                 \
+      std::uint8_t,                                                           \
+      INDEX_TYPE,                                                             \
+      OFFSET_TYPE,                                                            \
+      std::uint8_t>::Type                                                     \
+  GenerateEmbeddingSpMDMRowwiseQuantizedOut<INDEX_TYPE, OFFSET_TYPE>(         \
+      int bit_rate,                                                           \
+      const std::int64_t block_size,                                          \
+      bool has_weight,                                                        \
+      bool normalize_by_lengths,                                              \
+      int prefetch,                                                           \
+      bool is_weight_positional,                                              \
+      bool use_offsets,                                                       \
+      std::int64_t output_stride,                                             \
+      std::int64_t input_stride,                                              \
+      bool scale_bias_last);
+
+#define INSTANTIATE_SPMDM_ROWWISE_QUANTIZED_OUT_OFFSET_T(INDEX_TYPE) \
+  INSTANTIATE_SPMDM_ROWWISE_QUANTIZED_OUT_BASE(INDEX_TYPE, int32_t)  \
+  INSTANTIATE_SPMDM_ROWWISE_QUANTIZED_OUT_BASE(INDEX_TYPE, int64_t)
+
+INSTANTIATE_SPMDM_ROWWISE_QUANTIZED_OUT_OFFSET_T(int32_t)
+INSTANTIATE_SPMDM_ROWWISE_QUANTIZED_OUT_OFFSET_T(int64_t)
+
+#undef INSTANTIATE_SPMDM_ROWWISE_QUANTIZED_OUT_OFFSET_T
+#undef INSTANTIATE_SPMDM_ROWWISE_QUANTIZED_OUT_BASE
+
+} // namespace fbgemm
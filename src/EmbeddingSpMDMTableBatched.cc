@@ -0,0 +1,512 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#define FBGEMM_EXPORTS
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "./EmbeddingSpMDMBags.h"
+#include "fbgemm/FbgemmEmbedding.h"
+#include "fbgemm/Types.h"
+#include "fbgemm/Utils.h"
+
+namespace fbgemm {
+
+namespace {
+
+// Floats of pooled rows kept per thread by EmbeddingSpMDMDotInteraction:
+// small enough to stay in L2 between the pooling and the dot products.
+constexpr std::int64_t kInteractionTileFloats = 16384;
+
+// Bytes read from the table per index, the dominant cost of a lookup.
+std::int64_t rowCost(
+    const EmbeddingSpMDMTable& table,
+    bool scale_bias_last) {
+  const std::int64_t data_bytes =
+      (table.embedding_dim * table.bit_rate + 7) / 8;
+  if (table.bit_rate > 8) {
+    return data_bytes;
+  }
+  // scale and bias of quantized rows, in fp16 except for 8-bit rows with
+  // scale_bias_last
+  const std::int64_t scale_bias_bytes = table.bit_rate == 8 && scale_bias_last
+      ? 2 * sizeof(float)
+      : 2 * sizeof(float16);
+  return data_bytes + scale_bias_bytes;
+}
+
+// Bytes written per bag. Never 0, so positions of bags have strictly
+// increasing costs.
+std::int64_t bagCost(const EmbeddingSpMDMTable& table) {
+  return std::max<std::int64_t>(table.embedding_dim * sizeof(float), 1);
+}
+
+/**
+ * Splits the num_tables * batch_size bags, enumerated table by table, into
+ * chunks of similar cost. Bag positions are global: bag b of table t is at
+ * t * batch_size + b.
+ */
+template <typename OffsetType>
+class TableBatchedPartition {
+ public:
+  TableBatchedPartition(
+      int num_tables,
+      const EmbeddingSpMDMTable* tables,
+      std::int64_t batch_size,
+      const OffsetType* offsets,
+      bool scale_bias_last)
+      : tables_(tables),
+        batch_size_(batch_size),
+        offsets_(offsets),
+        scale_bias_last_(scale_bias_last),
+        table_cost_(num_tables + 1, 0) {
+    for (int t = 0; t < num_tables; ++t) {
+      table_cost_[t + 1] = table_cost_[t] + cost(t, batch_size_);
+    }
+  }
+
+  std::int64_t totalCost() const {
+    return table_cost_.back();
+  }
+
+  // First bag position whose cost prefix is at least c.
+  std::int64_t locate(std::int64_t c) const {
+    const int num_tables = static_cast<int>(table_cost_.size()) - 1;
+    const int t = static_cast<int>(
+        std::upper_bound(table_cost_.begin(), table_cost_.end(), c) -
+        table_cost_.begin() - 1);
+    if (t >= num_tables) {
+      return num_tables * batch_size_;
+    }
+    std::int64_t lo = 0, hi = batch_size_;
+    while (lo < hi) {
+      const std::int64_t mid = lo + (hi - lo) / 2;
+      if (table_cost_[t] + cost(t, mid) >= c) {
+        hi = mid;
+      } else {
+        lo = mid + 1;
+      }
+    }
+    return t * batch_size_ + lo;
+  }
+
+ private:
+  // Cost of the first num_bags bags of table t.
+  std::int64_t cost(int t, std::int64_t num_bags) const {
+    const OffsetType* table_offsets = offsets_ + t * batch_size_;
+    const std::int64_t num_indices = table_offsets[num_bags] - table_offsets[0];
+    return num_indices * rowCost(tables_[t], scale_bias_last_) +
+        num_bags * bagCost(tables_[t]);
+  }
+
+  const EmbeddingSpMDMTable* tables_;
+  const std::int64_t batch_size_;
+  const OffsetType* offsets_;
+  const bool scale_bias_last_;
+  std::vector<std::int64_t> table_cost_;
+};
+
+template <
+    typename InType,
+    typename IndexType,
+    typename OffsetType,
+    typename OutType>
+typename EmbeddingSpMDMKernelSignature<InType, IndexType, OffsetType, OutType>::
+    Type
+generateTableKernel(
+    const EmbeddingSpMDMTable& table,
+    bool has_weight,
+    bool normalize_by_lengths,
+    int prefetch,
+    std::int64_t output_stride,
+    bool scale_bias_last,
+    bool is_bf16_out) {
+  if constexpr (std::is_same_v<InType, std::uint8_t>) {
+    if (table.bit_rate != 8) {
+      return GenerateEmbeddingSpMDMNBitWithStrides<
+          IndexType,
+          OffsetType,
+          OutType>(
+          table.bit_rate,
+          table.embedding_dim,
+          has_weight,
+          normalize_by_lengths,
+          prefetch,
+          /*is_weight_positional=*/false,
+          /*use_offsets=*/true,
+          output_stride,
+          table.input_stride,
+          scale_bias_last,
+          is_bf16_out);
+    }
+  }
+  return GenerateEmbeddingSpMDMWithStrides<
+      InType,
+      IndexType,
+      OffsetType,
+      OutType>(
+      table.embedding_dim,
+      has_weight,
+      normalize_by_lengths,
+      prefetch,
+      /*is_weight_positional=*/false,
+      /*use_offsets=*/true,
+      output_stride,
+      table.input_stride == -1
+          ? -1
+          : table.input_stride / static_cast<std::int64_t>(sizeof(InType)),
+      scale_bias_last,
+      /*no_bag=*/false,
+      is_bf16_out);
+}
+
+// Pools bags [begin, end) of one table.
+template <
+    typename InType,
+    typename IndexType,
+    typename OffsetType,
+    typename OutType>
+bool runTable(
+    const EmbeddingSpMDMTable& table,
+    std::int64_t begin,
+    std::int64_t end,
+    const IndexType* indices,
+    const OffsetType* offsets,
+    const float* weights,
+    bool normalize_by_lengths,
+    OutType* out,
+    std::int64_t output_stride,
+    bool scale_bias_last,
+    bool is_bf16_out,
+    int prefetch) {
+  const auto kernel =
+      generateTableKernel<InType, IndexType, OffsetType, OutType>(
+          table,
+          weights != nullptr,
+          normalize_by_lengths,
+          prefetch,
+          output_stride,
+          scale_bias_last,
+          is_bf16_out);
+  return internal::runEmbeddingBags(
+      kernel,
+      begin,
+      end,
+      offsets[begin],
+      offsets[end] - offsets[begin],
+      table.num_rows,
+      reinterpret_cast<const InType*>(table.weights),
+      indices,
+      offsets,
+      weights,
+      /*is_weight_positional=*/false,
+      out);
+}
+
+// Pools bags [begin, end) of one table into out, with the kernel generated
+// once for all calls.
+using TableRunner =
+    std::function<bool(std::int64_t begin, std::int64_t end, float* out)>;
+
+template <typename InType, typename IndexType, typename OffsetType>
+TableRunner makeTableRunner(
+    const EmbeddingSpMDMTable& table,
+    const IndexType* indices,
+    const OffsetType* offsets,
+    const float* weights,
+    bool normalize_by_lengths,
+    std::int64_t output_stride,
+    bool scale_bias_last,
+    int prefetch) {
+  const auto kernel =
+      generateTableKernel<InType, IndexType, OffsetType, float>(
+          table,
+          weights != nullptr,
+          normalize_by_lengths,
+          prefetch,
+          output_stride,
+          scale_bias_last,
+          /*is_bf16_out=*/false);
+  return [=](std::int64_t begin, std::int64_t end, float* out) {
+    return internal::runEmbeddingBags(
+        kernel,
+        begin,
+        end,
+        offsets[begin],
+        offsets[end] - offsets[begin],
+        table.num_rows,
+        reinterpret_cast<const InType*>(table.weights),
+        indices,
+        offsets,
+        weights,
+        /*is_weight_positional=*/false,
+        out);
+  };
+}
+
+void checkBitRates(
+    const char* caller,
+    int num_tables,
+    const EmbeddingSpMDMTable* tables) {
+  for (int t = 0; t < num_tables; ++t) {
+    const int bit_rate = tables[t].bit_rate;
+    if (bit_rate != 32 && bit_rate != 16 && bit_rate != 8 && bit_rate != 4 &&
+        bit_rate != 2) {
+      throw std::runtime_error(
+          std::string(caller) + ": unsupported bit_rate " +
+          std::to_string(bit_rate) + " for table " + std::to_string(t));
+    }
+  }
+}
+
+} // namespace
+
+template <typename IndexType, typename OffsetType, typename OutType>
+bool EmbeddingSpMDMTableBatched(
+    int num_tables,
+    const EmbeddingSpMDMTable* tables,
+    std::int64_t batch_size,
+    const IndexType* indices,
+    const OffsetType* offsets,
+    const float* weights,
+    bool normalize_by_lengths,
+    OutType* out,
+    std::int64_t output_stride,
+    int thread_id,
+    int num_threads,
+    bool scale_bias_last,
+    bool is_bf16_out,
+    int prefetch) {
+  if (num_tables <= 0 || batch_size <= 0) {
+    return true;
+  }
+  checkBitRates("EmbeddingSpMDMTableBatched", num_tables, tables);
+
+  const TableBatchedPartition<OffsetType> partition(
+      num_tables, tables, batch_size, offsets, scale_bias_last);
+  const std::int64_t total_cost = partition.totalCost();
+  const std::int64_t begin =
+      partition.locate(total_cost * thread_id / num_threads);
+  const std::int64_t end =
+      partition.locate(total_cost * (thread_id + 1) / num_threads);
+
+  bool success = true;
+  for (std::int64_t pos = begin; pos < end && success;) {
+    const int t = static_cast<int>(pos / batch_size);
+    const std::int64_t table_end = std::min(end, (t + 1) * batch_size);
+    const EmbeddingSpMDMTable& table = tables[t];
+    OutType* table_out =
+        out + (pos - t * batch_size) * output_stride + table.output_offset;
+
+#define FBGEMM_RUN_TABLE(IN_TYPE)                                   \
+  runTable<IN_TYPE, IndexType, OffsetType, OutType>(                \
+      table,                                                        \
+      pos,                                                          \
+      table_end,                                                    \
+      indices,                                                      \
+      offsets,                                                      \
+      weights,                                                      \
+      normalize_by_lengths,                                         \
+      table_out,                                                    \
+      output_stride,                                                \
+      scale_bias_last,                                              \
+      is_bf16_out,                                                  \
+      prefetch)
+
+    if (table.bit_rate == 32) {
+      success = FBGEMM_RUN_TABLE(float);
+    } else if (table.bit_rate == 16) {
+      success = FBGEMM_RUN_TABLE(float16);
+    } else {
+      success = FBGEMM_RUN_TABLE(std::uint8_t);
+    }
+#undef FBGEMM_RUN_TABLE
+    pos = table_end;
+  }
+  return success;
+}
+
+template <typename IndexType, typename OffsetType>
+bool EmbeddingSpMDMDotInteraction(
+    int num_tables,
+    const EmbeddingSpMDMTable* tables,
+    std::int64_t batch_size,
+    const IndexType* indices,
+    const OffsetType* offsets,
+    const float* weights,
+    bool normalize_by_lengths,
+    const float* dense,
+    float* out,
+    std::int64_t output_stride,
+    int thread_id,
+    int num_threads,
+    bool scale_bias_last,
+    int prefetch) {
+  if (num_tables <= 0 || batch_size <= 0) {
+    return true;
+  }
+  checkBitRates("EmbeddingSpMDMDotInteraction", num_tables, tables);
+  const std::int64_t dim = tables[0].embedding_dim;
+  for (int t = 1; t < num_tables; ++t) {
+    if (tables[t].embedding_dim != dim) {
+      throw std::runtime_error(
+          "EmbeddingSpMDMDotInteraction: table " + std::to_string(t) +
+          " has embedding_dim " + std::to_string(tables[t].embedding_dim) +
+          " instead of " + std::to_string(dim));
+    }
+  }
+  const int dense_features = dense != nullptr;
+  const int num_features = num_tables + dense_features;
+  const std::int64_t dense_size = dense_features * dim;
+  if (output_stride == -1) {
+    output_stride =
+        dense_size + std::int64_t{num_features} * (num_features - 1) / 2;
+  }
+
+  // The pooled rows of a sample are the consecutive rows of its F x dim tile
+  const std::int64_t tile_size = num_features * dim;
+  std::vector<TableRunner> runners;
+  runners.reserve(num_tables);
+  for (int t = 0; t < num_tables; ++t) {
+    const OffsetType* table_offsets = offsets + t * batch_size;
+#define FBGEMM_MAKE_TABLE_RUNNER(IN_TYPE)          \
+  makeTableRunner<IN_TYPE, IndexType, OffsetType>( \
+      tables[t],                                   \
+      indices,                                     \
+      table_offsets,                               \
+      weights,                                     \
+      normalize_by_lengths,                        \
+      tile_size,                                   \
+      scale_bias_last,                             \
+      prefetch)
+
+    if (tables[t].bit_rate == 32) {
+      runners.push_back(FBGEMM_MAKE_TABLE_RUNNER(float));
+    } else if (tables[t].bit_rate == 16) {
+      runners.push_back(FBGEMM_MAKE_TABLE_RUNNER(float16));
+    } else {
+      runners.push_back(FBGEMM_MAKE_TABLE_RUNNER(std::uint8_t));
+    }
+#undef FBGEMM_MAKE_TABLE_RUNNER
+  }
+
+  std::int64_t sample_begin = 0, sample_end = 0;
+  fbgemmPartition1D(
+      thread_id, num_threads, batch_size, sample_begin, sample_end);
+  const std::int64_t chunk_size =
+      std::max<std::int64_t>(kInteractionTileFloats / tile_size, 1);
+  static thread_local std::vector<float> tile;
+  tile.resize(chunk_size * tile_size);
+
+  for (std::int64_t begin = sample_begin; begin < sample_end;
+       begin += chunk_size) {
+    const std::int64_t end = std::min(begin + chunk_size, sample_end);
+    if (dense_features) {
+      for (std::int64_t b = begin; b < end; ++b) {
+        std::copy(
+            dense + b * dim,
+            dense + (b + 1) * dim,
+            tile.data() + (b - begin) * tile_size);
+      }
+    }
+    for (int t = 0; t < num_tables; ++t) {
+      if (!runners[t](
+              begin, end, tile.data() + (dense_features + t) * dim)) {
+        return false;
+      }
+    }
+
+    // Strictly lower triangle of each tile times its transpose, row by row
+    for (std::int64_t b = begin; b < end; ++b) {
+      const float* x = tile.data() + (b - begin) * tile_size;
+      float* out_row = out + b * output_stride;
+      std::copy(x, x + dense_size, out_row);
+      float* z = out_row + dense_size;
+      for (int i = 1; i < num_features; ++i) {
+        const float* x_i = x + i * dim;
+        for (int j = 0; j < i; ++j) {
+          const float* x_j = x + j * dim;
+          float dot = 0.0f;
+          for (std::int64_t d = 0; d < dim; ++d) {
+            dot += x_i[d] * x_j[d];
+          }
+          *z++ = dot;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+#define INSTANTIATE_SPMDM_TBE_BASE(INDEX_TYPE, OFFSET_TYPE, OUT_TYPE)   \
+  template FBGEMM_API bool                                              \
+  EmbeddingSpMDMTableBatched<INDEX_TYPE, OFFSET_TYPE, OUT_TYPE>(        \
+      int num_tables,                                                   \
+      const EmbeddingSpMDMTable* tables,                                \
+      std::int64_t batch_size,                                          \
+      const INDEX_TYPE* indices,                                        \
+      const OFFSET_TYPE* offsets,                                       \
+      const float* weights,                                             \
+      bool normalize_by_lengths,                                        \
+      OUT_TYPE* out,                                                    \
+      std::int64_t output_stride,                                       \
+      int thread_id,                                                    \
+      int num_threads,                                                  \
+      bool scale_bias_last,                                             \
+      bool is_bf16_out,                                                 \
+      int prefetch);
+
+#define INSTANTIATE_SPMDM_TBE_OUT_T(INDEX_TYPE, OFFSET_TYPE)     \
+  INSTANTIATE_SPMDM_TBE_BASE(INDEX_TYPE, OFFSET_TYPE, float)     \
+  INSTANTIATE_SPMDM_TBE_BASE(INDEX_TYPE, OFFSET_TYPE, uint16_t)
+
+#define INSTANTIATE_SPMDM_TBE_OFFSET_T(INDEX_TYPE) \
+  INSTANTIATE_SPMDM_TBE_OUT_T(INDEX_TYPE, int32_t) \
+  INSTANTIATE_SPMDM_TBE_OUT_T(INDEX_TYPE, int64_t)
+
+INSTANTIATE_SPMDM_TBE_OFFSET_T(int32_t)
+INSTANTIATE_SPMDM_TBE_OFFSET_T(int64_t)
+
+#undef INSTANTIATE_SPMDM_TBE_OFFSET_T
+#undef INSTANTIATE_SPMDM_TBE_OUT_T
+#undef INSTANTIATE_SPMDM_TBE_BASE
+
+#define INSTANTIATE_DOT_INTERACTION_BASE(INDEX_TYPE, OFFSET_TYPE) \
+  template FBGEMM_API bool                                        \
+  EmbeddingSpMDMDotInteraction<INDEX_TYPE, OFFSET_TYPE>(          \
+      int num_tables,                                             \
+      const EmbeddingSpMDMTable* tables,                          \
+      std::int64_t batch_size,                                    \
+      const INDEX_TYPE* indices,                                  \
+      const OFFSET_TYPE* offsets,                                 \
+      const float* weights,                                       \
+      bool normalize_by_lengths,                                  \
+      const float* dense,                                         \
+      float* out,                                                 \
+      std::int64_t output_stride,                                 \
+      int thread_id,                                              \
+      int num_threads,                                            \
+      bool scale_bias_last,                                       \
+      int prefetch);
+
+#define INSTANTIATE_DOT_INTERACTION_OFFSET_T(INDEX_TYPE) \
+  INSTANTIATE_DOT_INTERACTION_BASE(INDEX_TYPE, int32_t)  \
+  INSTANTIATE_DOT_INTERACTION_BASE(INDEX_TYPE, int64_t)
+
+INSTANTIATE_DOT_INTERACTION_OFFSET_T(int32_t)
+INSTANTIATE_DOT_INTERACTION_OFFSET_T(int64_t)
+
+#undef INSTANTIATE_DOT_INTERACTION_OFFSET_T
+#undef INSTANTIATE_DOT_INTERACTION_BASE
+
+} // namespace fbgemm
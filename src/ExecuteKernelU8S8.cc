@@ -9,6 +9,8 @@
 #include "./ExecuteKernelU8S8.h"
 #include <cpuinfo.h>
 #include <chrono>
+#include "./FbgemmI8Amx.h"
+#include "./FbgemmI8Neon.h"
 
 #ifdef FBGEMM_MEASURE_TIME_BREAKDOWN
 double kernel_time = 0.0;
@@ -17,6 +19,17 @@ double postprocessing_time = 0.0;
 
 namespace fbgemm {
 
+namespace {
+
+template <typename packingAMatrix>
+struct is_im2col_pack_a : std::false_type {};
+
+template <typename T, typename accT, int SPATIAL_DIM>
+struct is_im2col_pack_a<PackAWithIm2Col<T, accT, SPATIAL_DIM>>
+    : std::true_type {};
+
+} // namespace
+
 template <typename packingAMatrix, typename cT, typename processOutputType>
 ExecuteKernel<
     packingAMatrix,
@@ -49,8 +62,9 @@ ExecuteKernel<
     throw std::runtime_error("Failed to initialize cpuinfo!");
   }
   if (params) {
-    if (fbgemmHasAvx2Support()) {
+    if (fbgemmHasAvx2Support() || fbgemmHasArmNeonSupport()) {
       mbSize_ = params->MCB;
+      mrSize_ = params->MR;
       nbSize_ = params->NCB;
       nrMinSize_ = params->NR_MIN;
       nrSize_ = params->NR;
@@ -67,6 +81,10 @@ ExecuteKernel<
             typename packingAMatrix::inpType,
             typename packingAMatrix::accType,
             inst_set_t::avx512_vnni>::getKernelParams();
+        mrSize_ = PackingTraits<
+            typename packingAMatrix::inpType,
+            typename packingAMatrix::accType,
+            inst_set_t::avx512_vnni>::MR;
         break;
 
       case inst_set_t::avx512_vnni_ymm:
@@ -74,6 +92,10 @@ ExecuteKernel<
             typename packingAMatrix::inpType,
             typename packingAMatrix::accType,
             inst_set_t::avx512_vnni_ymm>::getKernelParams();
+        mrSize_ = PackingTraits<
+            typename packingAMatrix::inpType,
+            typename packingAMatrix::accType,
+            inst_set_t::avx512_vnni_ymm>::MR;
         break;
 
       case inst_set_t::avx512:
@@ -81,6 +103,10 @@ ExecuteKernel<
             typename packingAMatrix::inpType,
             typename packingAMatrix::accType,
             inst_set_t::avx512>::getKernelParams();
+        mrSize_ = PackingTraits<
+            typename packingAMatrix::inpType,
+            typename packingAMatrix::accType,
+            inst_set_t::avx512>::MR;
         break;
 
       case inst_set_t::avx512_ymm:
@@ -88,6 +114,10 @@ ExecuteKernel<
             typename packingAMatrix::inpType,
             typename packingAMatrix::accType,
             inst_set_t::avx512_ymm>::getKernelParams();
+        mrSize_ = PackingTraits<
+            typename packingAMatrix::inpType,
+            typename packingAMatrix::accType,
+            inst_set_t::avx512_ymm>::MR;
         break;
 
       case inst_set_t::avx2:
@@ -95,6 +125,21 @@ ExecuteKernel<
             typename packingAMatrix::inpType,
             typename packingAMatrix::accType,
             inst_set_t::avx2>::getKernelParams();
+        mrSize_ = PackingTraits<
+            typename packingAMatrix::inpType,
+            typename packingAMatrix::accType,
+            inst_set_t::avx2>::MR;
+        break;
+
+      case inst_set_t::anyarch:
+        std::tie(mbSize_, nbSize_, nrMinSize_, nrSize_) = PackingTraits<
+            typename packingAMatrix::inpType,
+            typename packingAMatrix::accType,
+            inst_set_t::anyarch>::getKernelParams();
+        mrSize_ = PackingTraits<
+            typename packingAMatrix::inpType,
+            typename packingAMatrix::accType,
+            inst_set_t::anyarch>::MR;
         break;
 
       default:
@@ -139,76 +184,134 @@ void ExecuteKernel<
     return;
   }
 
-  typename BaseType::jit_micro_kernel_fp fn;
-
   const inst_set_t isa = fbgemmInstructionSet();
-  switch (isa) {
-    case inst_set_t::avx512_vnni:
-      if (std::is_same<typename packingAMatrix::accType, std::int16_t>::value) {
-        // For AVX512VNNI, we redirect int16_t to int32_t accumulation.
-        CodeGenBase<uint8_t, int8_t, int32_t, int32_t> codeObj;
-        fn = codeObj.getOrCreate<inst_set_t::avx512_vnni>(
-            accum,
-            packed_rows_A,
-            packedB_.blockColSize(),
-            packedA_.numPackedCols());
-      } else {
-        fn = BaseType::template getOrCreate<inst_set_t::avx512_vnni>(
-            accum,
-            packed_rows_A,
-            packedB_.blockColSize(),
-            packedA_.numPackedCols());
-      }
-      break;
-
-    case inst_set_t::avx512_vnni_ymm:
-      if (std::is_same<typename packingAMatrix::accType, std::int16_t>::value) {
-        // For AVX512VNNI, we redirect int16_t to int32_t accumulation.
-        CodeGenBase<uint8_t, int8_t, int32_t, int32_t> codeObj;
-        fn = codeObj.getOrCreate<inst_set_t::avx512_vnni_ymm>(
-            accum,
-            packed_rows_A,
-            packedB_.blockColSize(),
-            packedA_.numPackedCols());
-      } else {
-        fn = BaseType::template getOrCreate<inst_set_t::avx512_vnni_ymm>(
-            accum,
-            packed_rows_A,
-            packedB_.blockColSize(),
-            packedA_.numPackedCols());
-      }
-      break;
+  // The default avx512_vnni packing of A and B is also the layout of AMX
+  // tiles, so on AMX hosts the blocks are multiplied with tile instructions
+  // instead of the JIT kernel.
+  const bool useAmx = isa == inst_set_t::avx512_vnni &&
+      !BaseType::blocking_params && fbgemmHasAmxInt8Support();
+  // Without AVX2 there is no JIT kernel; the blocks are multiplied by the
+  // NEON kernel, which takes any nc.
+  const bool useNeon = isa == inst_set_t::anyarch;
+
+  // Returns the JIT kernel multiplying mc rows of A with nc columns of B. The
+  // AMX and NEON kernels take any mc and nc, so there is none for them.
+  auto getKernel = [&](int mc, int nc) {
+    typename BaseType::jit_micro_kernel_fp kernel = nullptr;
+    if (useAmx || useNeon) {
+      return kernel;
+    }
+    switch (isa) {
+      case inst_set_t::avx512_vnni:
+        if (std::is_same<typename packingAMatrix::accType, std::int16_t>::
+                value) {
+          // For AVX512VNNI, we redirect int16_t to int32_t accumulation.
+          CodeGenBase<uint8_t, int8_t, int32_t, int32_t> codeObj;
+          kernel = codeObj.getOrCreate<inst_set_t::avx512_vnni>(
+              accum, mc, nc, packedA_.numPackedCols());
+        } else {
+          kernel = BaseType::template getOrCreate<inst_set_t::avx512_vnni>(
+              accum, mc, nc, packedA_.numPackedCols());
+        }
+        break;
 
-    case inst_set_t::avx512:
-      fn = BaseType::template getOrCreate<inst_set_t::avx512>(
-          accum,
-          packed_rows_A,
-          packedB_.blockColSize(),
-          packedA_.numPackedCols());
-      break;
+      case inst_set_t::avx512_vnni_ymm:
+        if (std::is_same<typename packingAMatrix::accType, std::int16_t>::
+                value) {
+          // For AVX512VNNI, we redirect int16_t to int32_t accumulation.
+          CodeGenBase<uint8_t, int8_t, int32_t, int32_t> codeObj;
+          kernel = codeObj.getOrCreate<inst_set_t::avx512_vnni_ymm>(
+              accum, mc, nc, packedA_.numPackedCols());
+        } else {
+          kernel =
+              BaseType::template getOrCreate<inst_set_t::avx512_vnni_ymm>(
+                  accum, mc, nc, packedA_.numPackedCols());
+        }
+        break;
 
-    case inst_set_t::avx512_ymm:
-      fn = BaseType::template getOrCreate<inst_set_t::avx512_ymm>(
-          accum,
-          packed_rows_A,
-          packedB_.blockColSize(),
-          packedA_.numPackedCols());
-      break;
+      case inst_set_t::avx512:
+        kernel = BaseType::template getOrCreate<inst_set_t::avx512>(
+            accum, mc, nc, packedA_.numPackedCols());
+        break;
 
-    case inst_set_t::avx2:
-      fn = BaseType::template getOrCreate<inst_set_t::avx2>(
-          accum,
-          packed_rows_A,
-          packedB_.blockColSize(),
-          packedA_.numPackedCols());
-      break;
+      case inst_set_t::avx512_ymm:
+        kernel = BaseType::template getOrCreate<inst_set_t::avx512_ymm>(
+            accum, mc, nc, packedA_.numPackedCols());
+        break;
 
-    default:
-      // TODO: Have default slower path
-      assert(0 && "unsupported architecture");
-      throw std::runtime_error("unsupported architecure");
+      case inst_set_t::avx2:
+        kernel = BaseType::template getOrCreate<inst_set_t::avx2>(
+            accum, mc, nc, packedA_.numPackedCols());
+        break;
+
+      default:
+        // TODO: Have default slower path
+        assert(0 && "unsupported architecture");
+        throw std::runtime_error("unsupported architecure");
+    }
+    return kernel;
+  };
+
+  // Multiplies mc rows of packed A starting at a with the block of B at b.
+  auto runKernel = [&](typename BaseType::jit_micro_kernel_fp kernel,
+                       const uint8_t* a,
+                       int mc,
+                       int nc,
+                       int8_t* b,
+                       int8_t* b_pf,
+                       int32_t* c,
+                       int32_t ldc) {
+    if (useAmx) {
+      using traits = PackingTraits<
+          typename packingAMatrix::inpType,
+          typename packingAMatrix::accType,
+          inst_set_t::avx512_vnni>;
+      gemmKernelU8S8S32ACC32Amx(
+          a,
+          traits::KCB,
+          b,
+          traits::NCB * traits::ROW_INTERLEAVE,
+          c,
+          ldc,
+          mc,
+          nc,
+          packedA_.numPackedCols(),
+          accum);
+    } else if (useNeon) {
+      const int row_interleave = BaseType::blocking_params
+          ? BaseType::blocking_params->ROW_INTERLEAVE
+          : PackingTraits<
+                typename packingAMatrix::inpType,
+                typename packingAMatrix::accType,
+                inst_set_t::anyarch>::ROW_INTERLEAVE;
+      gemmKernelU8S8S32ACC32Neon(
+          a,
+          packedA_.blockColSize(),
+          b,
+          packedB_.blockColSize() * row_interleave,
+          row_interleave,
+          c,
+          ldc,
+          mc,
+          nc,
+          packedA_.numPackedCols(),
+          accum);
+    } else {
+      kernel(a, b, b_pf, c, packedA_.numPackedCols(), ldc);
+    }
+  };
+
+  // An implicit-GEMM im2col A is packed by this kernel, one panel of mrSize_
+  // rows right before the panel is multiplied with the first column block,
+  // so the rows are still in cache for the multiplication.
+  bool implicitA = false;
+  if constexpr (is_im2col_pack_a<packingAMatrix>::value) {
+    implicitA = static_cast<packingAMatrix&>(packedA_).isImplicitGemm();
   }
 
+  typename BaseType::jit_micro_kernel_fp fn =
+      getKernel(packed_rows_A, packedB_.blockColSize());
+
 #ifdef FBGEMM_MEASURE_TIME_BREAKDOWN
   std::chrono::time_point<std::chrono::high_resolution_clock> t_start, t_end;
   double dt;
@@ -216,56 +319,11 @@ void ExecuteKernel<
 #endif
 
   for (int jb = jb_begin; jb < jb_end; ++jb) {
+    int nc = nbSize_;
     if (jb == bColBlocks - 1) {
-      int nc = ((packedB_.lastBcol() - 1) / nrMinSize_ + 1) * nrMinSize_;
+      nc = ((packedB_.lastBcol() - 1) / nrMinSize_ + 1) * nrMinSize_;
       if (nc != nbSize_) {
-        switch (isa) {
-          case inst_set_t::avx512_vnni:
-            if (std::is_same<typename packingAMatrix::accType, std::int16_t>::
-                    value) {
-              // For AVX512VNNI, we redirect int16_t to int32_t accumulation.
-              CodeGenBase<uint8_t, int8_t, int32_t, int32_t> codeObj;
-              fn = codeObj.getOrCreate<inst_set_t::avx512_vnni>(
-                  accum, packed_rows_A, nc, packedA_.numPackedCols());
-            } else {
-              fn = BaseType::template getOrCreate<inst_set_t::avx512_vnni>(
-                  accum, packed_rows_A, nc, packedA_.numPackedCols());
-            }
-            break;
-
-          case inst_set_t::avx512_vnni_ymm:
-            if (std::is_same<typename packingAMatrix::accType, std::int16_t>::
-                    value) {
-              // For AVX512VNNI, we redirect int16_t to int32_t accumulation.
-              CodeGenBase<uint8_t, int8_t, int32_t, int32_t> codeObj;
-              fn = codeObj.getOrCreate<inst_set_t::avx512_vnni_ymm>(
-                  accum, packed_rows_A, nc, packedA_.numPackedCols());
-            } else {
-              fn = BaseType::template getOrCreate<inst_set_t::avx512_vnni_ymm>(
-                  accum, packed_rows_A, nc, packedA_.numPackedCols());
-            }
-            break;
-
-          case inst_set_t::avx512:
-            fn = BaseType::template getOrCreate<inst_set_t::avx512>(
-                accum, packed_rows_A, nc, packedA_.numPackedCols());
-            break;
-
-          case inst_set_t::avx512_ymm:
-            fn = BaseType::template getOrCreate<inst_set_t::avx512_ymm>(
-                accum, packed_rows_A, nc, packedA_.numPackedCols());
-            break;
-
-          case inst_set_t::avx2:
-            fn = BaseType::template getOrCreate<inst_set_t::avx2>(
-                accum, packed_rows_A, nc, packedA_.numPackedCols());
-            break;
-
-          default:
-            // TODO: Have default slower path
-            assert(0 && "unsupported architecture");
-            throw std::runtime_error("unsupported architecure");
-        }
+        fn = getKernel(packed_rows_A, nc);
       }
     }
 
@@ -299,12 +357,50 @@ void ExecuteKernel<
       leadingDim = nbSize_;
     }
 
-    fn(aBuf,
-       bBuf,
-       bBuf_pf,
-       C_buffer_start,
-       packedA_.numPackedCols(),
-       leadingDim);
+    bool packedInKernel = false;
+    if constexpr (is_im2col_pack_a<packingAMatrix>::value) {
+      if (implicitA && jb == jb_begin) {
+        // The panels only have to be kept when the thread multiplies them
+        // with more column blocks; otherwise they share one small buffer.
+        const bool keepPanels = jb_end - jb_begin > 1;
+        static thread_local std::vector<uint8_t> A_panel_;
+        if (!keepPanels) {
+          A_panel_.resize(mrSize_ * packedA_.blockColSize());
+        }
+        auto& packA = static_cast<packingAMatrix&>(packedA_);
+        typename BaseType::jit_micro_kernel_fp panelFn = nullptr;
+        for (int i = 0; i < packed_rows_A; i += mrSize_) {
+          const int panelRows = std::min(mrSize_, packed_rows_A - i);
+          if (i == 0 || panelRows != mrSize_) {
+            panelFn = getKernel(panelRows, nc);
+          }
+          uint8_t* panel = keepPanels ? aBuf + i * packedA_.blockColSize()
+                                      : A_panel_.data();
+          packA.packPanel(i, panelRows, panel);
+          runKernel(
+              panelFn,
+              panel,
+              panelRows,
+              nc,
+              bBuf,
+              bBuf_pf,
+              C_buffer_start + i * leadingDim,
+              leadingDim);
+        }
+        packedInKernel = true;
+      }
+    }
+    if (!packedInKernel) {
+      runKernel(
+          fn,
+          aBuf,
+          packed_rows_A,
+          nc,
+          bBuf,
+          bBuf_pf,
+          C_buffer_start,
+          leadingDim);
+    }
 
 #ifdef FBGEMM_MEASURE_TIME_BREAKDOWN
     t_end = std::chrono::high_resolution_clock::now();
@@ -336,9 +432,15 @@ void ExecuteKernel<
               ldc_,
               ldc_);
         } else {
-          // TODO: Have default slower path
-          assert(0 && "unsupported architecure");
-          throw std::runtime_error("unsupported architecure");
+          outputProcess_.template f<inst_set_t::anyarch>(
+              matC_,
+              C_buffer_row_start + jb_begin * nbSize_,
+              {row_start_A,
+               packed_rows_A,
+               static_cast<int>(NDim * group + jb_begin * nbSize_),
+               nSize},
+              ldc_,
+              ldc_);
         }
       }
 
@@ -358,9 +460,15 @@ void ExecuteKernel<
               ldc_,
               leadingDim);
         } else {
-          // TODO: Have default slower path
-          assert(0 && "unsupported architecure");
-          throw std::runtime_error("unsupported architecure");
+          outputProcess_.template f<inst_set_t::anyarch>(
+              matC_,
+              C_tile_.data(),
+              {row_start_A,
+               packed_rows_A,
+               NDim * group + jb * nbSize_,
+               packedB_.lastBcol()},
+              ldc_,
+              leadingDim);
         }
       }
     } // output processing
@@ -568,6 +676,106 @@ template class ExecuteKernel<
     float,
     DoSpmdmOnInpBuffer<float, int32_t, ReQuantizeForFloat<false>>>;
 
+////////////////////////////////////////////////////////////////////////////////
+// ReQuantizeOutput followed by LookupTableOutput
+#define INSTANTIATE_REQUANT_LUT_BASE(PACK_A, Q_GRAN, BIAS_TYPE) \
+  template class ExecuteKernel<                                 \
+      PACK_A<uint8_t, int32_t>,                                 \
+      PackBMatrix<int8_t, int32_t>,                             \
+      uint8_t,                                                  \
+      ReQuantizeOutput<                                         \
+          false,                                                \
+          Q_GRAN,                                               \
+          BIAS_TYPE,                                            \
+          uint8_t,                                              \
+          int32_t,                                              \
+          LookupTableOutput<>>>;
+
+#define INSTANTIATE_REQUANT_LUT_BIAS_T(PACK_A, Q_GRAN) \
+  INSTANTIATE_REQUANT_LUT_BASE(PACK_A, Q_GRAN, float); \
+  INSTANTIATE_REQUANT_LUT_BASE(PACK_A, Q_GRAN, int32_t);
+
+#define INSTANTIATE_REQUANT_LUT_Q_GRANS(PACK_A)                            \
+  INSTANTIATE_REQUANT_LUT_BIAS_T(PACK_A, QuantizationGranularity::TENSOR); \
+  INSTANTIATE_REQUANT_LUT_BIAS_T(PACK_A, QuantizationGranularity::GROUP);  \
+  INSTANTIATE_REQUANT_LUT_BIAS_T(PACK_A, QuantizationGranularity::OUT_CHANNEL);
+
+INSTANTIATE_REQUANT_LUT_Q_GRANS(PackAMatrix);
+INSTANTIATE_REQUANT_LUT_Q_GRANS(PackAWithRowOffset);
+
+#undef INSTANTIATE_REQUANT_LUT_Q_GRANS
+#undef INSTANTIATE_REQUANT_LUT_BIAS_T
+#undef INSTANTIATE_REQUANT_LUT_BASE
+
+////////////////////////////////////////////////////////////////////////////////
+// DoResidualAddOnInpBuffer
+#define INSTANTIATE_RESIDUAL_BASE(PACK_A, RELU, Q_GRAN, BIAS_TYPE) \
+  template class ExecuteKernel<                                    \
+      PACK_A<uint8_t, int32_t>,                                    \
+      PackBMatrix<int8_t, int32_t>,                                \
+      uint8_t,                                                     \
+      DoResidualAddOnInpBuffer<                                    \
+          uint8_t,                                                 \
+          int32_t,                                                 \
+          ReQuantizeOutput<RELU, Q_GRAN, BIAS_TYPE>>>;
+
+#define INSTANTIATE_RESIDUAL_BIAS_T(PACK_A, RELU, Q_GRAN) \
+  INSTANTIATE_RESIDUAL_BASE(PACK_A, RELU, Q_GRAN, float); \
+  INSTANTIATE_RESIDUAL_BASE(PACK_A, RELU, Q_GRAN, int32_t);
+
+#define INSTANTIATE_RESIDUAL_Q_GRANS(PACK_A, RELU)                           \
+  INSTANTIATE_RESIDUAL_BIAS_T(PACK_A, RELU, QuantizationGranularity::TENSOR); \
+  INSTANTIATE_RESIDUAL_BIAS_T(PACK_A, RELU, QuantizationGranularity::GROUP);  \
+  INSTANTIATE_RESIDUAL_BIAS_T(                                                \
+      PACK_A, RELU, QuantizationGranularity::OUT_CHANNEL);
+
+#define INSTANTIATE_RESIDUAL_RELU(PACK_A)      \
+  INSTANTIATE_RESIDUAL_Q_GRANS(PACK_A, false); \
+  INSTANTIATE_RESIDUAL_Q_GRANS(PACK_A, true);
+
+INSTANTIATE_RESIDUAL_RELU(PackAMatrix);
+INSTANTIATE_RESIDUAL_RELU(PackAWithRowOffset);
+
+#undef INSTANTIATE_RESIDUAL_RELU
+#undef INSTANTIATE_RESIDUAL_Q_GRANS
+#undef INSTANTIATE_RESIDUAL_BIAS_T
+#undef INSTANTIATE_RESIDUAL_BASE
+
+#define INSTANTIATE_IM2COL_RESIDUAL_BASE(RELU, SPATIAL_DIM, Q_GRAN, BIAS_TYPE) \
+  template class ExecuteKernel<                                              \
+      PackAWithIm2Col<uint8_t, int32_t, SPATIAL_DIM>,                        \
+      PackBMatrix<int8_t, int32_t>,                                          \
+      uint8_t,                                                               \
+      DoResidualAddOnInpBuffer<                                              \
+          uint8_t,                                                           \
+          int32_t,                                                           \
+          ReQuantizeOutput<RELU, Q_GRAN, BIAS_TYPE>>>;
+
+#define INSTANTIATE_IM2COL_RESIDUAL_BIAS_T(RELU, SPATIAL_DIM, Q_GRAN) \
+  INSTANTIATE_IM2COL_RESIDUAL_BASE(RELU, SPATIAL_DIM, Q_GRAN, float); \
+  INSTANTIATE_IM2COL_RESIDUAL_BASE(RELU, SPATIAL_DIM, Q_GRAN, int32_t);
+
+#define INSTANTIATE_IM2COL_RESIDUAL_Q_GRANS(RELU, SPATIAL_DIM) \
+  INSTANTIATE_IM2COL_RESIDUAL_BIAS_T(                          \
+      RELU, SPATIAL_DIM, QuantizationGranularity::TENSOR);     \
+  INSTANTIATE_IM2COL_RESIDUAL_BIAS_T(                          \
+      RELU, SPATIAL_DIM, QuantizationGranularity::GROUP);      \
+  INSTANTIATE_IM2COL_RESIDUAL_BIAS_T(                          \
+      RELU, SPATIAL_DIM, QuantizationGranularity::OUT_CHANNEL);
+
+#define INSTANTIATE_IM2COL_RESIDUAL_SPATIAL_DIM(RELU) \
+  INSTANTIATE_IM2COL_RESIDUAL_Q_GRANS(RELU, 1);       \
+  INSTANTIATE_IM2COL_RESIDUAL_Q_GRANS(RELU, 2);       \
+  INSTANTIATE_IM2COL_RESIDUAL_Q_GRANS(RELU, 3);
+
+INSTANTIATE_IM2COL_RESIDUAL_SPATIAL_DIM(false);
+INSTANTIATE_IM2COL_RESIDUAL_SPATIAL_DIM(true);
+
+#undef INSTANTIATE_IM2COL_RESIDUAL_SPATIAL_DIM
+#undef INSTANTIATE_IM2COL_RESIDUAL_Q_GRANS
+#undef INSTANTIATE_IM2COL_RESIDUAL_BIAS_T
+#undef INSTANTIATE_IM2COL_RESIDUAL_BASE
+
 ////////////////////////////////////////////////////////////////////////////////
 // memCopy
 #define INSTANTIATE_MEMCPY_BASE(PACK_A, ACC_T) \
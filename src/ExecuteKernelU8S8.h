@@ -65,6 +65,7 @@ class ExecuteKernel<
       th_info_; ///<< the thread partition information (thread id and the number
                 ///< of threads across the group, m, n dimensions.
   int mbSize_; ///< block size in the m dimension.
+  int mrSize_; ///< register size in the m dimension.
   int nbSize_; ///< block size in the n dimension.
   int nrMinSize_; ///< minimum register size in the n dimension.
   int nrSize_; ///< register size in the n dimension.
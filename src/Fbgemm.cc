@@ -10,8 +10,12 @@
 #include "fbgemm/Fbgemm.h"
 #include <cpuinfo.h>
 #include <functional>
+#include <memory>
 #include <stdexcept>
+#include <tuple>
+#include <vector>
 #include "./ExecuteKernel.h"
+#include "./TraceScope.h"
 
 #ifdef FBGEMM_MEASURE_TIME_BREAKDOWN
 double packing_time = 0.0;
@@ -21,39 +25,19 @@ double run_time = 0.0;
 
 namespace fbgemm {
 
-template <
-    typename packingAMatrix,
-    typename packingBMatrix,
-    typename cT,
-    typename processOutputType>
-void fbgemmPacked(
-    PackMatrix<
-        packingAMatrix,
-        typename packingAMatrix::inpType,
-        typename packingAMatrix::accType>& packA,
-    PackMatrix<
-        packingBMatrix,
-        typename packingBMatrix::inpType,
-        typename packingBMatrix::accType>& packB,
-    cT* C,
-    int32_t* C_buffer,
-    uint32_t ldc,
-    const processOutputType& outProcess,
-    int thread_id,
-    int num_threads,
-    const BlockingFactors* blocking_params) {
-  static_assert(
-      std::is_same<
-          typename packingAMatrix::accType,
-          typename packingBMatrix::accType>::value,
-      "Accumulation type of both matrices should be the same");
+namespace {
 
+// MCB, KCB and MR of the GEMM with A packed by packingAMatrix, from
+// blocking_params if not nullptr and else for the current ISA.
+template <typename packingAMatrix>
+std::tuple<int64_t, int, int> gemmCacheBlockParams(
+    const BlockingFactors* blocking_params) {
   // Run time CPU detection
   if (!cpuinfo_initialize()) {
     throw std::runtime_error("Failed to initialize cpuinfo!");
   }
   if ((!fbgemmHasAvx512VnniSupport() && !fbgemmHasAvx512Support() &&
-       !fbgemmHasAvx2Support())) {
+       !fbgemmHasAvx2Support() && !fbgemmHasArmNeonSupport())) {
     assert(0 && "unknown architecure");
     throw std::runtime_error("unknown architecure");
   }
@@ -104,12 +88,124 @@ void fbgemmPacked(
             inst_set_t::avx2>::getCacheBlockParams();
         break;
 
+      case inst_set_t::anyarch:
+        std::tie(MCB, KCB, MR) = PackingTraits<
+            typename packingAMatrix::inpType,
+            typename packingAMatrix::accType,
+            inst_set_t::anyarch>::getCacheBlockParams();
+        break;
+
       default:
         assert(0 && "unknown architecure");
         throw std::runtime_error("unknown architecure");
     }
   }
 
+  return std::make_tuple(MCB, KCB, MR);
+}
+
+// Whether the 256-bit variant YMM_ISA of ZMM_ISA packs A and B the same way,
+// so that matrices packed for one can be multiplied by the kernels of the
+// other.
+template <
+    typename packingAMatrix,
+    typename packingBMatrix,
+    inst_set_t ZMM_ISA,
+    inst_set_t YMM_ISA>
+bool isSamePacking() {
+  using TA = typename packingAMatrix::inpType;
+  using TB = typename packingBMatrix::inpType;
+  using accT = typename packingAMatrix::accType;
+  return PackingTraits<TA, accT, ZMM_ISA>::getMatrixPackAParams() ==
+      PackingTraits<TA, accT, YMM_ISA>::getMatrixPackAParams() &&
+      PackingTraits<TB, accT, ZMM_ISA>::getMatrixPackBParams() ==
+      PackingTraits<TB, accT, YMM_ISA>::getMatrixPackBParams();
+}
+
+// The ISA to run a GEMM of work multiply-adds with, for matrices packed for
+// isa: fbgemmIsaForWork() when it packs them the same way, and else isa.
+template <typename packingAMatrix, typename packingBMatrix>
+inst_set_t gemmIsaForWork(inst_set_t isa, int64_t work) {
+  FbgemmIsaScope isa_scope(isa);
+  const inst_set_t work_isa = fbgemmIsaForWork(work);
+  switch (work_isa) {
+    case inst_set_t::avx512_ymm:
+      return isSamePacking<
+                 packingAMatrix,
+                 packingBMatrix,
+                 inst_set_t::avx512,
+                 inst_set_t::avx512_ymm>()
+          ? work_isa
+          : isa;
+
+    case inst_set_t::avx512_vnni_ymm:
+      return isSamePacking<
+                 packingAMatrix,
+                 packingBMatrix,
+                 inst_set_t::avx512_vnni,
+                 inst_set_t::avx512_vnni_ymm>()
+          ? work_isa
+          : isa;
+
+    default:
+      return isa;
+  }
+}
+
+} // namespace
+
+template <
+    typename packingAMatrix,
+    typename packingBMatrix,
+    typename cT,
+    typename processOutputType>
+void fbgemmPacked(
+    PackMatrix<
+        packingAMatrix,
+        typename packingAMatrix::inpType,
+        typename packingAMatrix::accType>& packA,
+    PackMatrix<
+        packingBMatrix,
+        typename packingBMatrix::inpType,
+        typename packingBMatrix::accType>& packB,
+    cT* C,
+    int32_t* C_buffer,
+    uint32_t ldc,
+    const processOutputType& outProcess,
+    int thread_id,
+    int num_threads,
+    const BlockingFactors* blocking_params,
+    GemmTileScheduler* scheduler) {
+  static_assert(
+      std::is_same<
+          typename packingAMatrix::accType,
+          typename packingBMatrix::accType>::value,
+      "Accumulation type of both matrices should be the same");
+
+  // The blocking of the matrices is for the ISA they were packed under,
+  // which may differ from the current one.
+  if (!blocking_params && packA.isa() != packB.isa()) {
+    throw std::runtime_error(
+        "A and B are packed for different ISAs: " +
+        std::to_string(static_cast<int>(packA.isa())) + " and " +
+        std::to_string(static_cast<int>(packB.isa())));
+  }
+  // Small GEMMs run the 256-bit kernels of the ISA when the packing allows
+  // it, to not lower the core frequency.
+  const inst_set_t isa = blocking_params
+      ? packB.isa()
+      : gemmIsaForWork<packingAMatrix, packingBMatrix>(
+            packB.isa(),
+            static_cast<int64_t>(packA.numRows()) * packB.numCols() *
+                packB.numRows());
+  FbgemmIsaScope isa_scope(isa);
+
+  int64_t MCB;
+  int KCB;
+  int MR;
+  std::tie(MCB, KCB, MR) =
+      gemmCacheBlockParams<packingAMatrix>(blocking_params);
+
   if (!packB.isPrePacked()) {
     throw std::runtime_error("B matrix must be prepacked");
   }
@@ -124,6 +220,20 @@ void fbgemmPacked(
   int KDimPerGroup = packB.numRows() / G;
   int NDim = packB.numCols();
 
+  FBGEMM_TRACE_SCOPE(
+      "fbgemmPacked",
+      static_cast<int64_t>(MDim) * KDimPerGroup * G *
+              sizeof(typename packingAMatrix::inpType) +
+          static_cast<int64_t>(KDimPerGroup) * G * NDim *
+              sizeof(typename packingBMatrix::inpType) +
+          static_cast<int64_t>(MDim) * NDim * sizeof(cT),
+      thread_id,
+      num_threads,
+      MDim,
+      NDim,
+      KDimPerGroup * G,
+      G);
+
   int kBlocks = (KDimPerGroup + KCB - 1) / KCB;
 
   // remainders
@@ -133,6 +243,54 @@ void fbgemmPacked(
 
   block_type_t blockA{0, 0, 0, 0};
 
+  if (scheduler) {
+    // Each tile packs its rows of A again, so columns are only split as
+    // much as needed for a few tiles per thread.
+    constexpr int64_t kTilesPerThread = 4;
+    const int64_t mBlocks = (MDim + MCB - 1) / MCB;
+    const int64_t nBlocks = packB.blockCols();
+    const int64_t nChunks = std::max<int64_t>(
+        std::min<int64_t>(
+            nBlocks,
+            (kTilesPerThread * num_threads + G * mBlocks - 1) /
+                (G * mBlocks)),
+        1);
+    const int64_t numTiles = G * mBlocks * nChunks;
+    for (int64_t tile = scheduler->next(); tile < numTiles;
+         tile = scheduler->next()) {
+      const int g = tile / (mBlocks * nChunks);
+      const int64_t mBlock = tile / nChunks % mBlocks;
+      // A tile runs as thread (mBlock, nChunk) of a static partition with
+      // one row block per thread, so it writes its own rows of C_buffer.
+      const thread_type_t th_info{
+          1,
+          static_cast<int>(mBlocks),
+          static_cast<int>(nChunks),
+          0,
+          static_cast<int>(mBlock),
+          static_cast<int>(tile % nChunks)};
+      ExecuteKernel<packingAMatrix, packingBMatrix, cT, processOutputType>
+          exeKernelObj(
+              packA,
+              packB,
+              C,
+              C_buffer,
+              ldc,
+              outProcess,
+              th_info,
+              blocking_params);
+      const int i = mBlock * MCB;
+      mc = std::min<int64_t>(MDim - i, MCB);
+      for (int kb = 0; kb < kBlocks; ++kb) {
+        kc = (kb != kBlocks - 1 || _kc == 0) ? KCB : _kc;
+        blockA = {i, mc, g * KDimPerGroup + kb * KCB, kc};
+        packA.pack(blockA);
+        exeKernelObj.execute(g * kBlocks + kb);
+      }
+    }
+    return;
+  }
+
 #ifdef FBGEMM_MEASURE_TIME_BREAKDOWN
   std::chrono::time_point<std::chrono::high_resolution_clock> t_very_start,
       t_start, t_end;
@@ -207,6 +365,122 @@ void fbgemmPacked(
 #endif
 }
 
+template <
+    typename packingAMatrix,
+    typename packingBMatrix,
+    typename cT,
+    typename processOutputType>
+void fbgemmPackedMultiB(
+    PackMatrix<
+        packingAMatrix,
+        typename packingAMatrix::inpType,
+        typename packingAMatrix::accType>& packA,
+    const PackedGemmOutput<packingBMatrix, cT, processOutputType>* outputs,
+    int num_outputs,
+    int thread_id,
+    int num_threads,
+    const BlockingFactors* blocking_params) {
+  static_assert(
+      std::is_same<
+          typename packingAMatrix::accType,
+          typename packingBMatrix::accType>::value,
+      "Accumulation type of both matrices should be the same");
+
+  if (num_outputs <= 0) {
+    return;
+  }
+
+  int64_t MCB;
+  int KCB;
+  int MR;
+  std::tie(MCB, KCB, MR) =
+      gemmCacheBlockParams<packingAMatrix>(blocking_params);
+
+  int G = packA.numGroups();
+  int MDim = packA.numRows();
+  int KDimPerGroup = outputs[0].packB->numRows() / G;
+  // The threads are partitioned for the widest B. Each output splits its own
+  // column blocks among the threads with the same rows of A.
+  int NDim = 0;
+  for (int o = 0; o < num_outputs; ++o) {
+    const auto& packB = *outputs[o].packB;
+    if (!packB.isPrePacked()) {
+      throw std::runtime_error("B matrix must be prepacked");
+    }
+    if (G != packB.numGroups()) {
+      throw std::runtime_error(
+          "A.groups = " + std::to_string(G) + " and B.groups = " +
+          std::to_string(packB.numGroups()) + " are not the same");
+    }
+    if (packB.numRows() != outputs[0].packB->numRows()) {
+      throw std::runtime_error(
+          "B matrices have " + std::to_string(outputs[0].packB->numRows()) +
+          " and " + std::to_string(packB.numRows()) + " rows");
+    }
+    NDim = std::max(NDim, packB.numCols());
+  }
+
+  FBGEMM_TRACE_SCOPE(
+      "fbgemmPackedMultiB",
+      static_cast<int64_t>(MDim) * KDimPerGroup * G *
+              sizeof(typename packingAMatrix::inpType) +
+          static_cast<int64_t>(KDimPerGroup) * G * NDim * num_outputs *
+              sizeof(typename packingBMatrix::inpType) +
+          static_cast<int64_t>(MDim) * NDim * num_outputs * sizeof(cT),
+      thread_id,
+      num_threads,
+      MDim,
+      NDim,
+      KDimPerGroup * G,
+      G);
+
+  int kBlocks = (KDimPerGroup + KCB - 1) / KCB;
+
+  // remainders
+  int _kc = KDimPerGroup % KCB;
+
+  thread_type_t th_info =
+      fbgemmGetThreadPartition(G, MDim, NDim, thread_id, num_threads);
+
+  int64_t g_begin, g_end, i_begin, i_end;
+  fbgemmPartition1D(
+      th_info.g_thread_id, th_info.g_num_threads, G, g_begin, g_end);
+  fbgemmPartition1DBlocked(
+      th_info.m_thread_id, th_info.m_num_threads, MDim, MR, i_begin, i_end);
+
+  using ExecuteKernelType =
+      ExecuteKernel<packingAMatrix, packingBMatrix, cT, processOutputType>;
+  for (int g = g_begin; g < g_end; ++g) {
+    std::vector<std::unique_ptr<ExecuteKernelType>> exeKernelObjs;
+    exeKernelObjs.reserve(num_outputs);
+    for (int o = 0; o < num_outputs; ++o) {
+      const auto& output = outputs[o];
+      exeKernelObjs.push_back(std::make_unique<ExecuteKernelType>(
+          packA,
+          *output.packB,
+          output.C,
+          output.C_buffer,
+          output.ldc,
+          *output.outProcess,
+          th_info,
+          blocking_params));
+    }
+    for (int i = i_begin; i < i_end; i += MCB) {
+      int mc = std::min<int64_t>(i_end - i, MCB);
+      for (int kb = 0; kb < kBlocks; ++kb) {
+        int kc = (kb != kBlocks - 1 || _kc == 0) ? KCB : _kc;
+        // The block of A is packed once and multiplied with every B while it
+        // is still in cache
+        block_type_t blockA{i, mc, g * KDimPerGroup + kb * KCB, kc};
+        packA.pack(blockA);
+        for (auto& exeKernelObj : exeKernelObjs) {
+          exeKernelObj->execute(g * kBlocks + kb);
+        }
+      }
+    }
+  }
+}
+
 template <int SPATIAL_DIM>
 bool fbgemmOptimizedGConv(const conv_param_t<SPATIAL_DIM>& conv_p) {
   if (SPATIAL_DIM == 1)
@@ -220,22 +494,34 @@ bool fbgemmOptimizedGConv(const conv_param_t<SPATIAL_DIM>& conv_p) {
 
   auto areEqual = [](int a, int b) { return a == b; };
 
+  // The JIT'ed kernels work on the height and width dimensions. A 3D conv
+  // runs them once per temporal tap and accumulates, so the temporal kernel
+  // size, padding, stride and dilation can be anything.
+  auto hw_begin = [](const auto& a) { return a.begin() + SPATIAL_DIM - 2; };
+  auto hw_pad_begin = [&conv_p](int side) {
+    return conv_p.pad.begin() + side * SPATIAL_DIM + SPATIAL_DIM - 2;
+  };
+
   return (C_per_G == K_per_G) &&
       (C_per_G == 2 || C_per_G == 4 || C_per_G == 8 || C_per_G == 16) &&
       (conv_p.G >= G_together) &&
 
       std::all_of(
-             conv_p.K.begin(),
+             hw_begin(conv_p.K),
              conv_p.K.end(),
              std::bind(areEqual, std::placeholders::_1, 3)) &&
 
       std::all_of(
-             conv_p.pad.begin(),
-             conv_p.pad.end(),
+             hw_pad_begin(0),
+             hw_pad_begin(0) + 2,
+             std::bind(areEqual, std::placeholders::_1, 1)) &&
+      std::all_of(
+             hw_pad_begin(1),
+             hw_pad_begin(1) + 2,
              std::bind(areEqual, std::placeholders::_1, 1)) &&
 
       std::all_of(
-             conv_p.dilation.begin(),
+             hw_begin(conv_p.dilation),
              conv_p.dilation.end(),
              std::bind(areEqual, std::placeholders::_1, 1)) &&
 
@@ -243,11 +529,11 @@ bool fbgemmOptimizedGConv(const conv_param_t<SPATIAL_DIM>& conv_p) {
       // should be either 1 or 2
       // Temporal stride can be anything.
       (std::all_of(
-           conv_p.stride.begin() + SPATIAL_DIM - 2,
+           hw_begin(conv_p.stride),
            conv_p.stride.end(),
            std::bind(areEqual, std::placeholders::_1, 1)) ||
        std::all_of(
-           conv_p.stride.begin() + SPATIAL_DIM - 2,
+           hw_begin(conv_p.stride),
            conv_p.stride.end(),
            std::bind(areEqual, std::placeholders::_1, 2))) &&
       !conv_p.transposed;
@@ -329,6 +615,28 @@ INSTANTIATE_Q_GRAN(true)
 #undef INSTANTIATE_BIAS_T
 #undef INSTANTIATE_BASE
 
+template class FBGEMM_API LookupTableOutput<>;
+
+#define INSTANTIATE_BASE(Q_GRAN, BIAS_TYPE)   \
+  template class FBGEMM_API ReQuantizeOutput< \
+      false,                                  \
+      Q_GRAN,                                 \
+      BIAS_TYPE,                              \
+      std::uint8_t,                           \
+      std::int32_t,                           \
+      LookupTableOutput<>>;
+
+#define INSTANTIATE_Q_GRAN(BIAS_TYPE)                          \
+  INSTANTIATE_BASE(QuantizationGranularity::TENSOR, BIAS_TYPE) \
+  INSTANTIATE_BASE(QuantizationGranularity::GROUP, BIAS_TYPE)  \
+  INSTANTIATE_BASE(QuantizationGranularity::OUT_CHANNEL, BIAS_TYPE)
+
+INSTANTIATE_Q_GRAN(std::int32_t)
+INSTANTIATE_Q_GRAN(float)
+
+#undef INSTANTIATE_Q_GRAN
+#undef INSTANTIATE_BASE
+
 // ReQuantizeOutput
 #define INSTANTIATE_BASE(PACK_A, ACC_T, RELU, Q_GRAN, BIAS_TYPE)    \
   template FBGEMM_API void fbgemmPacked(                            \
@@ -340,7 +648,8 @@ INSTANTIATE_Q_GRAN(true)
       const ReQuantizeOutput<RELU, Q_GRAN, BIAS_TYPE>& outProcess,  \
       int thread_id,                                                \
       int num_threads,                                              \
-      const BlockingFactors* blocking_params);
+      const BlockingFactors* blocking_params,                       \
+      GemmTileScheduler* scheduler);
 
 #define INSTANTIATE_BIAS_T(PACK_A, ACC_T, RELU, Q_GRAN) \
   INSTANTIATE_BASE(PACK_A, ACC_T, RELU, Q_GRAN, float)  \
@@ -381,7 +690,8 @@ INSTANTIATE_ACC_T(PackAWithRowOffset)
       const ReQuantizeOutput<RELU, Q_GRAN, BIAS_TYPE>& outProcess,    \
       int thread_id,                                                  \
       int num_threads,                                                \
-      const BlockingFactors* blocking_params);
+      const BlockingFactors* blocking_params,                         \
+      GemmTileScheduler* scheduler);
 
 #define INSTANTIATE_BIAS_T(ACC_T, RELU, SPATIAL_DIM, Q_GRAN) \
   INSTANTIATE_BASE(ACC_T, RELU, SPATIAL_DIM, Q_GRAN, float)  \
@@ -412,6 +722,145 @@ INSTANTIATE_RELU(int16_t)
 #undef INSTANTIATE_BIAS_T
 #undef INSTANTIATE_BASE
 
+////////////////////////////////////////////////////////////////////////////////
+// ReQuantizeOutput followed by LookupTableOutput
+#define INSTANTIATE_BASE(PACK_A, Q_GRAN, BIAS_TYPE)                     \
+  template FBGEMM_API void fbgemmPacked(                                \
+      PackMatrix<PACK_A<uint8_t, int32_t>, uint8_t, int32_t>& packA,    \
+      PackMatrix<PackBMatrix<int8_t, int32_t>, int8_t, int32_t>& packB, \
+      uint8_t* C,                                                       \
+      int32_t* C_buffer,                                                \
+      uint32_t ldc,                                                     \
+      const ReQuantizeOutput<                                           \
+          false,                                                        \
+          Q_GRAN,                                                       \
+          BIAS_TYPE,                                                    \
+          uint8_t,                                                      \
+          int32_t,                                                      \
+          LookupTableOutput<>>& outProcess,                             \
+      int thread_id,                                                    \
+      int num_threads,                                                  \
+      const BlockingFactors* blocking_params,                           \
+      GemmTileScheduler* scheduler);
+
+#define INSTANTIATE_BIAS_T(PACK_A, Q_GRAN) \
+  INSTANTIATE_BASE(PACK_A, Q_GRAN, float)  \
+  INSTANTIATE_BASE(PACK_A, Q_GRAN, int32_t)
+
+#define INSTANTIATE_Q_GRANS(PACK_A)                           \
+  INSTANTIATE_BIAS_T(PACK_A, QuantizationGranularity::TENSOR) \
+  INSTANTIATE_BIAS_T(PACK_A, QuantizationGranularity::GROUP)  \
+  INSTANTIATE_BIAS_T(PACK_A, QuantizationGranularity::OUT_CHANNEL)
+
+INSTANTIATE_Q_GRANS(PackAMatrix)
+INSTANTIATE_Q_GRANS(PackAWithRowOffset)
+
+#undef INSTANTIATE_Q_GRANS
+#undef INSTANTIATE_BIAS_T
+#undef INSTANTIATE_BASE
+
+////////////////////////////////////////////////////////////////////////////////
+// DoResidualAddOnInpBuffer
+#define INSTANTIATE_BASE(RELU, Q_GRAN, BIAS_TYPE)     \
+  template class FBGEMM_API DoResidualAddOnInpBuffer< \
+      std::uint8_t,                                   \
+      std::int32_t,                                   \
+      ReQuantizeOutput<RELU, Q_GRAN, BIAS_TYPE>>;
+
+#define INSTANTIATE_BIAS_T(RELU, Q_GRAN)       \
+  INSTANTIATE_BASE(RELU, Q_GRAN, std::int32_t) \
+  INSTANTIATE_BASE(RELU, Q_GRAN, float)
+
+#define INSTANTIATE_Q_GRAN(RELU)                            \
+  INSTANTIATE_BIAS_T(RELU, QuantizationGranularity::TENSOR) \
+  INSTANTIATE_BIAS_T(RELU, QuantizationGranularity::GROUP)  \
+  INSTANTIATE_BIAS_T(RELU, QuantizationGranularity::OUT_CHANNEL)
+
+INSTANTIATE_Q_GRAN(false)
+INSTANTIATE_Q_GRAN(true)
+
+#undef INSTANTIATE_Q_GRAN
+#undef INSTANTIATE_BIAS_T
+#undef INSTANTIATE_BASE
+
+#define INSTANTIATE_BASE(PACK_A, RELU, Q_GRAN, BIAS_TYPE)               \
+  template FBGEMM_API void fbgemmPacked(                                \
+      PackMatrix<PACK_A<uint8_t, int32_t>, uint8_t, int32_t>& packA,    \
+      PackMatrix<PackBMatrix<int8_t, int32_t>, int8_t, int32_t>& packB, \
+      uint8_t* C,                                                       \
+      int32_t* C_buffer,                                                \
+      uint32_t ldc,                                                     \
+      const DoResidualAddOnInpBuffer<                                   \
+          uint8_t,                                                      \
+          int32_t,                                                      \
+          ReQuantizeOutput<RELU, Q_GRAN, BIAS_TYPE>>& outProcess,       \
+      int thread_id,                                                    \
+      int num_threads,                                                  \
+      const BlockingFactors* blocking_params,                           \
+      GemmTileScheduler* scheduler);
+
+#define INSTANTIATE_BIAS_T(PACK_A, RELU, Q_GRAN) \
+  INSTANTIATE_BASE(PACK_A, RELU, Q_GRAN, float)  \
+  INSTANTIATE_BASE(PACK_A, RELU, Q_GRAN, int32_t)
+
+#define INSTANTIATE_Q_GRANS(PACK_A, RELU)                           \
+  INSTANTIATE_BIAS_T(PACK_A, RELU, QuantizationGranularity::TENSOR) \
+  INSTANTIATE_BIAS_T(PACK_A, RELU, QuantizationGranularity::GROUP)  \
+  INSTANTIATE_BIAS_T(PACK_A, RELU, QuantizationGranularity::OUT_CHANNEL)
+
+#define INSTANTIATE_RELU(PACK_A)     \
+  INSTANTIATE_Q_GRANS(PACK_A, false) \
+  INSTANTIATE_Q_GRANS(PACK_A, true)
+
+INSTANTIATE_RELU(PackAMatrix)
+INSTANTIATE_RELU(PackAWithRowOffset)
+
+#undef INSTANTIATE_RELU
+#undef INSTANTIATE_Q_GRANS
+#undef INSTANTIATE_BIAS_T
+#undef INSTANTIATE_BASE
+
+#define INSTANTIATE_BASE(RELU, SPATIAL_DIM, Q_GRAN, BIAS_TYPE)          \
+  template FBGEMM_API void fbgemmPacked(                                \
+      PackMatrix<                                                       \
+          PackAWithIm2Col<uint8_t, int32_t, SPATIAL_DIM>,               \
+          uint8_t,                                                      \
+          int32_t>& packA,                                              \
+      PackMatrix<PackBMatrix<int8_t, int32_t>, int8_t, int32_t>& packB, \
+      uint8_t* C,                                                       \
+      int32_t* C_buffer,                                                \
+      uint32_t ldc,                                                     \
+      const DoResidualAddOnInpBuffer<                                   \
+          uint8_t,                                                      \
+          int32_t,                                                      \
+          ReQuantizeOutput<RELU, Q_GRAN, BIAS_TYPE>>& outProcess,       \
+      int thread_id,                                                    \
+      int num_threads,                                                  \
+      const BlockingFactors* blocking_params,                           \
+      GemmTileScheduler* scheduler);
+
+#define INSTANTIATE_BIAS_T(RELU, SPATIAL_DIM, Q_GRAN) \
+  INSTANTIATE_BASE(RELU, SPATIAL_DIM, Q_GRAN, float)  \
+  INSTANTIATE_BASE(RELU, SPATIAL_DIM, Q_GRAN, int32_t)
+
+#define INSTANTIATE_Q_GRANS(RELU, SPATIAL_DIM)                           \
+  INSTANTIATE_BIAS_T(RELU, SPATIAL_DIM, QuantizationGranularity::TENSOR) \
+  INSTANTIATE_BIAS_T(RELU, SPATIAL_DIM, QuantizationGranularity::GROUP)  \
+  INSTANTIATE_BIAS_T(RELU, SPATIAL_DIM, QuantizationGranularity::OUT_CHANNEL)
+
+#define INSTANTIATE_SPATIAL_DIM(RELU) \
+  INSTANTIATE_Q_GRANS(RELU, 1)        \
+  INSTANTIATE_Q_GRANS(RELU, 2)        \
+  INSTANTIATE_Q_GRANS(RELU, 3)
+
+INSTANTIATE_SPATIAL_DIM(false)
+INSTANTIATE_SPATIAL_DIM(true)
+
+#undef INSTANTIATE_SPATIAL_DIM
+#undef INSTANTIATE_Q_GRANS
+#undef INSTANTIATE_BIAS_T
+#undef INSTANTIATE_BASE
+
 ////////////////////////////////////////////////////////////////////////////////
 // ReQuantizeForFloat
 #define INSTANTIATE_BASE(PACK_A, RELU, Q_GRAN)                          \
@@ -424,7 +873,8 @@ INSTANTIATE_RELU(int16_t)
       const ReQuantizeForFloat<RELU, Q_GRAN>& outProcess,               \
       int thread_id,                                                    \
       int num_threads,                                                  \
-      const BlockingFactors* blocking_params);
+      const BlockingFactors* blocking_params,                           \
+      GemmTileScheduler* scheduler);
 
 #define INSTANTIATE_Q_GRANS(PACK_A, RELU)                         \
   INSTANTIATE_BASE(PACK_A, RELU, QuantizationGranularity::TENSOR) \
@@ -455,7 +905,8 @@ INSTANTIATE_RELU(PackAWithQuantRowOffset);
       const ReQuantizeForFloat<RELU, Q_GRAN>& outProcess,           \
       int thread_id,                                                \
       int num_threads,                                              \
-      const BlockingFactors* blocking_params);
+      const BlockingFactors* blocking_params,                       \
+      GemmTileScheduler* scheduler);
 
 #define INSTANTIATE_Q_GRANS(ACC_T, RELU, SPATIAL_DIM)                         \
   INSTANTIATE_BASE(ACC_T, RELU, SPATIAL_DIM, QuantizationGranularity::TENSOR) \
@@ -489,7 +940,8 @@ template FBGEMM_API void fbgemmPacked(
     const ReQuantizeForFloat<false>& outProcess,
     int thread_id,
     int num_threads,
-    const BlockingFactors* blocking_params);
+    const BlockingFactors* blocking_params,
+    GemmTileScheduler* scheduler);
 
 ////////////////////////////////////////////////////////////////////////////////
 // DoSpmdmOnInpBuffer
@@ -506,7 +958,8 @@ template FBGEMM_API void fbgemmPacked(
           ReQuantizeOutput<RELU, Q_GRAN>>& outProcess,                  \
       int thread_id,                                                    \
       int num_threads,                                                  \
-      const BlockingFactors* blocking_params);
+      const BlockingFactors* blocking_params,                           \
+      GemmTileScheduler* scheduler);
 
 #define INSTANTIATE_Q_GRANS(PACK_A, RELU)                         \
   INSTANTIATE_BASE(PACK_A, RELU, QuantizationGranularity::TENSOR) \
@@ -537,7 +990,8 @@ INSTANTIATE_RELU(PackAWithRowOffset)
           ReQuantizeOutput<RELU, Q_GRAN>>& outProcess,                        \
       int thread_id,                                                          \
       int num_threads,                                                        \
-      const BlockingFactors* blocking_params);
+      const BlockingFactors* blocking_params,                                 \
+      GemmTileScheduler* scheduler);
 
 #define INSTANTIATE_Q_GRANS(RELU)                         \
   INSTANTIATE_BASE(RELU, QuantizationGranularity::TENSOR) \
@@ -560,7 +1014,8 @@ template FBGEMM_API void fbgemmPacked(
         outProcess,
     int thread_id,
     int num_threads,
-    const BlockingFactors* blocking_params);
+    const BlockingFactors* blocking_params,
+    GemmTileScheduler* scheduler);
 
 ////////////////////////////////////////////////////////////////////////////////
 // memCopy
@@ -574,7 +1029,8 @@ template FBGEMM_API void fbgemmPacked(
       const memCopy<>& outProcess,                                  \
       int thread_id,                                                \
       int num_threads,                                              \
-      const BlockingFactors* blocking_params);
+      const BlockingFactors* blocking_params,                       \
+      GemmTileScheduler* scheduler);
 
 #define INSTANTIATE_ACC_T(PACK_A)   \
   INSTANTIATE_BASE(PACK_A, int32_t) \
@@ -599,7 +1055,8 @@ INSTANTIATE_ACC_T(PackAWithRowOffset)
       const memCopy<>& outProcess,                                  \
       int thread_id,                                                \
       int num_threads,                                              \
-      const BlockingFactors* blocking_params);
+      const BlockingFactors* blocking_params,                       \
+      GemmTileScheduler* scheduler);
 
 #define INSTANTIATE_SPATIAL_DIM(ACC_T) \
   INSTANTIATE_BASE(ACC_T, 1)           \
@@ -622,7 +1079,8 @@ template FBGEMM_API void fbgemmPacked(
     const memCopy<>& outProcess,
     int thread_id,
     int num_threads,
-    const BlockingFactors* blocking_params);
+    const BlockingFactors* blocking_params,
+    GemmTileScheduler* scheduler);
 
 template FBGEMM_API void fbgemmPacked(
     PackMatrix<PackAMatrix<uint8_t, int16_t>, uint8_t, int16_t>& packA,
@@ -633,6 +1091,75 @@ template FBGEMM_API void fbgemmPacked(
     const DoNothing<int32_t, int32_t>& outProcess,
     int thread_id,
     int num_threads,
-    const BlockingFactors* blocking_params);
+    const BlockingFactors* blocking_params,
+    GemmTileScheduler* scheduler);
+
+////////////////////////////////////////////////////////////////////////////////
+// fbgemmPackedMultiB
+#define INSTANTIATE_BASE(PACK_A, ACC_T, RELU, Q_GRAN, BIAS_TYPE)       \
+  template FBGEMM_API void fbgemmPackedMultiB(                         \
+      PackMatrix<PACK_A<uint8_t, ACC_T>, uint8_t, ACC_T>& packA,       \
+      const PackedGemmOutput<                                          \
+          PackBMatrix<int8_t, ACC_T>,                                  \
+          uint8_t,                                                     \
+          ReQuantizeOutput<RELU, Q_GRAN, BIAS_TYPE>>* outputs,         \
+      int num_outputs,                                                 \
+      int thread_id,                                                   \
+      int num_threads,                                                 \
+      const BlockingFactors* blocking_params);
+
+#define INSTANTIATE_BIAS_T(PACK_A, ACC_T, RELU, Q_GRAN) \
+  INSTANTIATE_BASE(PACK_A, ACC_T, RELU, Q_GRAN, float)  \
+  INSTANTIATE_BASE(PACK_A, ACC_T, RELU, Q_GRAN, int32_t)
+
+#define INSTANTIATE_Q_GRANS(PACK_A, ACC_T, RELU)                           \
+  INSTANTIATE_BIAS_T(PACK_A, ACC_T, RELU, QuantizationGranularity::TENSOR) \
+  INSTANTIATE_BIAS_T(PACK_A, ACC_T, RELU, QuantizationGranularity::GROUP)  \
+  INSTANTIATE_BIAS_T(PACK_A, ACC_T, RELU, QuantizationGranularity::OUT_CHANNEL)
+
+#define INSTANTIATE_RELU(PACK_A, ACC_T)     \
+  INSTANTIATE_Q_GRANS(PACK_A, ACC_T, false) \
+  INSTANTIATE_Q_GRANS(PACK_A, ACC_T, true)
+
+#define INSTANTIATE_ACC_T(PACK_A)   \
+  INSTANTIATE_RELU(PACK_A, int32_t) \
+  INSTANTIATE_RELU(PACK_A, int16_t)
+
+INSTANTIATE_ACC_T(PackAMatrix)
+INSTANTIATE_ACC_T(PackAWithRowOffset)
+
+#undef INSTANTIATE_ACC_T
+#undef INSTANTIATE_RELU
+#undef INSTANTIATE_Q_GRANS
+#undef INSTANTIATE_BIAS_T
+#undef INSTANTIATE_BASE
+
+#define INSTANTIATE_BASE(PACK_A, RELU, Q_GRAN)                       \
+  template FBGEMM_API void fbgemmPackedMultiB(                       \
+      PackMatrix<PACK_A<uint8_t, int32_t>, uint8_t, int32_t>& packA, \
+      const PackedGemmOutput<                                        \
+          PackBMatrix<int8_t, int32_t>,                              \
+          float,                                                     \
+          ReQuantizeForFloat<RELU, Q_GRAN>>* outputs,                \
+      int num_outputs,                                               \
+      int thread_id,                                                 \
+      int num_threads,                                               \
+      const BlockingFactors* blocking_params);
+
+#define INSTANTIATE_Q_GRANS(PACK_A, RELU)                         \
+  INSTANTIATE_BASE(PACK_A, RELU, QuantizationGranularity::TENSOR) \
+  INSTANTIATE_BASE(PACK_A, RELU, QuantizationGranularity::GROUP)  \
+  INSTANTIATE_BASE(PACK_A, RELU, QuantizationGranularity::OUT_CHANNEL)
+
+#define INSTANTIATE_RELU(PACK_A)     \
+  INSTANTIATE_Q_GRANS(PACK_A, false) \
+  INSTANTIATE_Q_GRANS(PACK_A, true)
+
+INSTANTIATE_RELU(PackAWithRowOffset)
+INSTANTIATE_RELU(PackAWithQuantRowOffset)
+
+#undef INSTANTIATE_RELU
+#undef INSTANTIATE_Q_GRANS
+#undef INSTANTIATE_BASE
 
 } // namespace fbgemm
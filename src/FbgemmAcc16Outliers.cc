@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#define FBGEMM_EXPORTS
+#include <cstdlib>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include "fbgemm/Fbgemm.h"
+
+namespace fbgemm {
+
+namespace {
+
+// 255 * 128 is the largest u8 x s8 pair sum that fits in int16
+constexpr int kMaxAcc16PairSum = 128;
+
+} // namespace
+
+void splitOutliersForAcc16(
+    matrix_op_t trans,
+    std::int32_t nRow,
+    std::int32_t nCol,
+    const std::int8_t* smat,
+    std::int32_t ld,
+    std::int8_t* B_dense,
+    CompressedSparseColumn& B_outliers,
+    int groups) {
+  if (groups <= 0 || nRow % groups != 0) {
+    throw std::runtime_error("nRow must be a multiple of groups");
+  }
+  const std::int32_t k_per_group = nRow / groups;
+  if (static_cast<std::int32_t>(B_outliers.NumOfRows()) != k_per_group ||
+      static_cast<std::int32_t>(B_outliers.NumOfCols()) != groups * nCol) {
+    throw std::runtime_error(
+        "B_outliers must be (nRow / groups) x (groups * nCol)");
+  }
+  const bool tr = trans == matrix_op_t::Transpose;
+  // Same indexing as PackBMatrix::pack_unpack_
+  auto idx = [&](int g, int i, int j) {
+    return tr ? i + (g * nCol + j) * ld : (g * k_per_group + i) * ld + j;
+  };
+
+  std::vector<std::int32_t>& colptr = B_outliers.ColPtr();
+  std::vector<std::int16_t>& rowidx = B_outliers.RowIdx();
+  std::vector<std::int8_t>& values = B_outliers.Values();
+  rowidx.clear();
+  values.clear();
+  colptr[0] = 0;
+  for (int g = 0; g < groups; ++g) {
+    for (int j = 0; j < nCol; ++j) {
+      for (int i = 0; i < k_per_group; ++i) {
+        B_dense[idx(g, i, j)] = smat[idx(g, i, j)];
+      }
+      // An odd last row is paired with the zero padding and never saturates
+      for (int i = 0; i + 1 < k_per_group; i += 2) {
+        std::int8_t& b0 = B_dense[idx(g, i, j)];
+        std::int8_t& b1 = B_dense[idx(g, i + 1, j)];
+        // Only elements of the same sign can add up to more than 128, and
+        // the one of them left in B_dense is then at most 127
+        if (std::abs(b0 + b1) > kMaxAcc16PairSum) {
+          const bool first = std::abs(b0) >= std::abs(b1);
+          std::int8_t& outlier = first ? b0 : b1;
+          rowidx.push_back(first ? i : i + 1);
+          values.push_back(outlier);
+          outlier = 0;
+        }
+      }
+      colptr[g * nCol + j + 1] = rowidx.size();
+    }
+  }
+}
+
+PackBMatrixWithOutliers::PackBMatrixWithOutliers(
+    matrix_op_t trans,
+    std::int32_t nRow,
+    std::int32_t nCol,
+    const std::int8_t* smat,
+    std::int32_t ld,
+    int groups,
+    float max_outlier_density)
+    : nRow_(nRow),
+      nCol_(nCol),
+      groups_(groups),
+      outliers_(nRow / groups, groups * nCol) {
+  // AVX512-VNNI has no acc16 kernels; int16 accumulation is redirected to the
+  // vpdpbusd based acc32 ones there.
+  bool useAcc16 = fbgemmHasAvx2Support() && !fbgemmHasAvx512VnniSupport();
+  std::vector<std::int8_t> B_dense;
+  if (useAcc16) {
+    B_dense.resize(
+        trans == matrix_op_t::Transpose ? groups * nCol * ld : nRow * ld);
+    splitOutliersForAcc16(
+        trans, nRow, nCol, smat, ld, B_dense.data(), outliers_, groups);
+    useAcc16 = outliers_.NumOfNonZeros() <=
+        max_outlier_density * static_cast<double>(nRow) * nCol;
+  }
+
+  if (useAcc16) {
+    packBAcc16_ = std::make_unique<PackBMatrix<std::int8_t, std::int16_t>>(
+        trans, nRow, nCol, B_dense.data(), ld, nullptr, groups);
+  } else {
+    outliers_.ColPtr().assign(groups * nCol + 1, 0);
+    outliers_.RowIdx().clear();
+    outliers_.Values().clear();
+    packBAcc32_ = std::make_unique<PackBMatrix<std::int8_t, std::int32_t>>(
+        trans, nRow, nCol, smat, ld, nullptr, groups);
+  }
+}
+
+template <bool FUSE_RELU, QuantizationGranularity Q_GRAN>
+void fbgemmPackedWithOutliers(
+    const std::uint8_t* A,
+    int m,
+    int lda,
+    PackBMatrixWithOutliers& packB,
+    std::uint8_t* C,
+    std::int32_t* C_buffer,
+    std::uint32_t ldc,
+    const ReQuantizeOutput<FUSE_RELU, Q_GRAN>& outProcess,
+    int thread_id,
+    int num_threads) {
+  const int k = packB.numRows();
+  const int groups = packB.numGroups();
+  ReQuantizeOutput<FUSE_RELU, Q_GRAN> requantObj = outProcess;
+
+  if (packB.useAcc16()) {
+    PackAWithRowOffset<std::uint8_t, std::int16_t> packA(
+        matrix_op_t::NoTranspose, m, k, A, lda, nullptr, groups);
+    requantObj.setRowOffsets(packA.getRowOffsetBuffer());
+    DoSpmdmOnInpBuffer<
+        std::uint8_t,
+        std::int32_t,
+        ReQuantizeOutput<FUSE_RELU, Q_GRAN>>
+        spmdmObj(requantObj, A, lda, packB.outliers(), groups);
+    fbgemmPacked(
+        packA,
+        *packB.packedAcc16(),
+        C,
+        C_buffer,
+        ldc,
+        spmdmObj,
+        thread_id,
+        num_threads);
+  } else {
+    PackAWithRowOffset<std::uint8_t, std::int32_t> packA(
+        matrix_op_t::NoTranspose, m, k, A, lda, nullptr, groups);
+    requantObj.setRowOffsets(packA.getRowOffsetBuffer());
+    fbgemmPacked(
+        packA,
+        *packB.packedAcc32(),
+        C,
+        C_buffer,
+        ldc,
+        requantObj,
+        thread_id,
+        num_threads);
+  }
+}
+
+#define INSTANTIATE_BASE(RELU, Q_GRAN)                             \
+  template FBGEMM_API void fbgemmPackedWithOutliers<RELU, Q_GRAN>( \
+      const std::uint8_t* A,                                       \
+      int m,                                                       \
+      int lda,                                                     \
+      PackBMatrixWithOutliers& packB,                              \
+      std::uint8_t* C,                                             \
+      std::int32_t* C_buffer,                                      \
+      std::uint32_t ldc,                                           \
+      const ReQuantizeOutput<RELU, Q_GRAN>& outProcess,            \
+      int thread_id,                                               \
+      int num_threads);
+
+#define INSTANTIATE_Q_GRANS(RELU)                         \
+  INSTANTIATE_BASE(RELU, QuantizationGranularity::TENSOR) \
+  INSTANTIATE_BASE(RELU, QuantizationGranularity::GROUP)  \
+  INSTANTIATE_BASE(RELU, QuantizationGranularity::OUT_CHANNEL)
+
+INSTANTIATE_Q_GRANS(false)
+INSTANTIATE_Q_GRANS(true)
+
+#undef INSTANTIATE_Q_GRANS
+#undef INSTANTIATE_BASE
+
+} // namespace fbgemm
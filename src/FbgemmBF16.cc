@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#define FBGEMM_EXPORTS
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <utility>
+
+#include "./FbgemmBF16UKernelsAvx2.h"
+#include "./FbgemmBF16UKernelsAvx512.h"
+#include "fbgemm/Fbgemm.h"
+#include "fbgemm/FbgemmFPCommon.h"
+
+namespace fbgemm {
+
+namespace {
+// Same register layouts as the fp16 kernels. The bf16 weights are widened to
+// fp32 in registers and multiplied with fp32 A, so A keeps its precision; the
+// AVX512-BF16 dot products would need A rounded to bf16 as well. There are no
+// aarch64 kernels; builds there need FBGEMM_FP16_FALLBACK_TO_REF_KERNEL.
+constexpr kernel_array_t<bfloat16_weight> kernel_bf16_avx2 = {
+#ifndef __aarch64__
+    nullptr,
+    gemmkernel_1x2_Avx2_bf16_fA0fB0fC0,
+    gemmkernel_2x2_Avx2_bf16_fA0fB0fC0,
+    gemmkernel_3x2_Avx2_bf16_fA0fB0fC0,
+    gemmkernel_4x2_Avx2_bf16_fA0fB0fC0,
+    gemmkernel_5x2_Avx2_bf16_fA0fB0fC0,
+    gemmkernel_6x2_Avx2_bf16_fA0fB0fC0
+#else
+    nullptr
+#endif
+};
+
+constexpr kernel_array_t<bfloat16_weight> kernel_bf16_avx512 = {
+#ifndef __aarch64__
+    nullptr,
+    gemmkernel_1x2_Avx512_bf16_fA0fB0fC0,
+    gemmkernel_2x2_Avx512_bf16_fA0fB0fC0,
+    gemmkernel_3x2_Avx512_bf16_fA0fB0fC0,
+    gemmkernel_4x2_Avx512_bf16_fA0fB0fC0,
+    gemmkernel_5x2_Avx512_bf16_fA0fB0fC0,
+    gemmkernel_6x2_Avx512_bf16_fA0fB0fC0,
+    gemmkernel_7x2_Avx512_bf16_fA0fB0fC0,
+    gemmkernel_8x2_Avx512_bf16_fA0fB0fC0,
+    gemmkernel_9x2_Avx512_bf16_fA0fB0fC0,
+    gemmkernel_10x2_Avx512_bf16_fA0fB0fC0,
+    gemmkernel_11x2_Avx512_bf16_fA0fB0fC0,
+    gemmkernel_12x2_Avx512_bf16_fA0fB0fC0,
+    gemmkernel_13x2_Avx512_bf16_fA0fB0fC0,
+    gemmkernel_14x2_Avx512_bf16_fA0fB0fC0
+#else
+    nullptr
+#endif
+};
+
+} // namespace
+
+template <>
+const isa_descriptor<bfloat16_weight>& getIsaHandlers(
+    inst_set_t isa,
+    bfloat16_weight) {
+  static isa_descriptor<bfloat16_weight> avx2_descriptor =
+      std::make_tuple(kernel_bf16_avx2, partition_avx2, nullptr);
+  static isa_descriptor<bfloat16_weight> avx512_descriptor =
+      std::make_tuple(kernel_bf16_avx512, partition_avx512, nullptr);
+
+  switch (isa) {
+    case inst_set_t::anyarch:
+    case inst_set_t::avx2:
+    // The ymm layout packs B like avx2, and there are no 7..14 row kernels
+    // for it.
+    case inst_set_t::avx512_ymm:
+    case inst_set_t::avx512_vnni_ymm:
+      return avx2_descriptor;
+
+    case inst_set_t::avx512:
+    case inst_set_t::avx512_vnni:
+      return avx512_descriptor;
+  }
+
+  throw std::runtime_error("Unsupported uArch");
+}
+
+// Built in every configuration so the tests can check it on x86 hosts.
+template <>
+FBGEMM_API void ref_kernel<bfloat16_weight>(
+    int kernel_nrows,
+    GemmParams<bfloat16_weight>* gp,
+    const float* C_base,
+    int m_total,
+    int n_total,
+    int simd_len) {
+  int kernel_ncol_blocks = 2;
+  int block_col_size = simd_len * kernel_ncol_blocks;
+  for (uint64_t jb = 0; jb < gp->b_block_cols; ++jb) {
+    for (uint64_t k = 0; k < gp->k; ++k) {
+      for (int i = 0; i < kernel_nrows; ++i) {
+        float a = gp->A[i + k * kernel_nrows];
+        for (int j = 0; j < block_col_size; ++j) {
+          float* C_ptr =
+              gp->C + i * (gp->ldc / sizeof(float)) + jb * block_col_size + j;
+          assert(C_ptr < C_base + m_total * n_total);
+          float b = cpu_bf162float(
+              gp->B[(jb * gp->k + k) * block_col_size + j].bits);
+          if (k == 0) {
+            if (gp->beta) {
+              *C_ptr = std::fma(a, b, (gp->beta) * (*C_ptr));
+            } else {
+              *C_ptr = a * b;
+            }
+          } else {
+            *C_ptr = std::fma(a, b, *C_ptr);
+          }
+        }
+      }
+    }
+  }
+}
+
+template FBGEMM_API void cblas_gemm_compute(
+    const matrix_op_t transa,
+    const int m,
+    const float* A,
+    const PackedGemmMatrixB<bfloat16_weight>& Bp,
+    const float beta,
+    float* C,
+    int thread_id,
+    int num_threads);
+
+} // namespace fbgemm
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <immintrin.h>
+
+#include "./FbgemmBF16UKernelsAvx2.h"
+
+namespace fbgemm {
+
+namespace {
+
+constexpr int kVLen = 8;
+
+// bf16 is the upper half of fp32, so widening is a zero extend and a shift.
+inline __m256 loadBf16(const bfloat16_weight* p) {
+  return _mm256_castsi256_ps(_mm256_slli_epi32(
+      _mm256_cvtepu16_epi32(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(p))),
+      16));
+}
+
+// Same computation as the fp16 kernels: ROWS x 2 vectors of C per block
+// column, with A packed column-major by PackA.
+template <int ROWS>
+void gemmkernelAvx2Bf16(GemmParamsBF16* gp) {
+  const uint64_t ldc = gp->ldc / sizeof(float);
+  const bool accumulate = gp->beta != 0.f;
+  const __m256 beta = _mm256_set1_ps(gp->beta);
+  const bfloat16_weight* B = gp->B;
+  float* C = gp->C;
+  for (uint64_t jb = 0; jb < gp->b_block_cols; ++jb) {
+    __m256 sum[ROWS][2];
+    for (int r = 0; r < ROWS; ++r) {
+      for (int v = 0; v < 2; ++v) {
+        sum[r][v] = accumulate
+            ? _mm256_mul_ps(beta, _mm256_loadu_ps(C + r * ldc + v * kVLen))
+            : _mm256_setzero_ps();
+      }
+    }
+    const float* A = gp->A;
+    for (uint64_t kk = 0; kk < gp->k; ++kk) {
+      const __m256 b0 = loadBf16(B);
+      const __m256 b1 = loadBf16(B + kVLen);
+      B += 2 * kVLen;
+      for (int r = 0; r < ROWS; ++r) {
+        const __m256 a = _mm256_broadcast_ss(A + r);
+        sum[r][0] = _mm256_fmadd_ps(a, b0, sum[r][0]);
+        sum[r][1] = _mm256_fmadd_ps(a, b1, sum[r][1]);
+      }
+      A += ROWS;
+    }
+    for (int r = 0; r < ROWS; ++r) {
+      _mm256_storeu_ps(C + r * ldc, sum[r][0]);
+      _mm256_storeu_ps(C + r * ldc + kVLen, sum[r][1]);
+    }
+    C += 2 * kVLen;
+  }
+}
+
+} // namespace
+
+void NOINLINE gemmkernel_1x2_Avx2_bf16_fA0fB0fC0(GemmParamsBF16* gp) {
+  gemmkernelAvx2Bf16<1>(gp);
+}
+void NOINLINE gemmkernel_2x2_Avx2_bf16_fA0fB0fC0(GemmParamsBF16* gp) {
+  gemmkernelAvx2Bf16<2>(gp);
+}
+void NOINLINE gemmkernel_3x2_Avx2_bf16_fA0fB0fC0(GemmParamsBF16* gp) {
+  gemmkernelAvx2Bf16<3>(gp);
+}
+void NOINLINE gemmkernel_4x2_Avx2_bf16_fA0fB0fC0(GemmParamsBF16* gp) {
+  gemmkernelAvx2Bf16<4>(gp);
+}
+void NOINLINE gemmkernel_5x2_Avx2_bf16_fA0fB0fC0(GemmParamsBF16* gp) {
+  gemmkernelAvx2Bf16<5>(gp);
+}
+void NOINLINE gemmkernel_6x2_Avx2_bf16_fA0fB0fC0(GemmParamsBF16* gp) {
+  gemmkernelAvx2Bf16<6>(gp);
+}
+
+} // namespace fbgemm
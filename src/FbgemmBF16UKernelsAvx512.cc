@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <immintrin.h>
+
+#include "./FbgemmBF16UKernelsAvx512.h"
+
+namespace fbgemm {
+
+namespace {
+
+constexpr int kVLen = 16;
+
+// bf16 is the upper half of fp32, so widening is a zero extend and a shift.
+// The maskz forms avoid GCC's maybe-uninitialized false positives on the
+// _mm512_undefined_* pass-through of the unmasked intrinsics.
+inline __m512 loadBf16(const bfloat16_weight* p) {
+  return _mm512_castsi512_ps(_mm512_maskz_slli_epi32(
+      0xffff,
+      _mm512_maskz_cvtepu16_epi32(
+          0xffff, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p))),
+      16));
+}
+
+// Same computation as the fp16 kernels: ROWS x 2 vectors of C per block
+// column, with A packed column-major by PackA.
+template <int ROWS>
+void gemmkernelAvx512Bf16(GemmParamsBF16* gp) {
+  const uint64_t ldc = gp->ldc / sizeof(float);
+  const bool accumulate = gp->beta != 0.f;
+  const __m512 beta = _mm512_set1_ps(gp->beta);
+  const bfloat16_weight* B = gp->B;
+  float* C = gp->C;
+  for (uint64_t jb = 0; jb < gp->b_block_cols; ++jb) {
+    __m512 sum[ROWS][2];
+    for (int r = 0; r < ROWS; ++r) {
+      for (int v = 0; v < 2; ++v) {
+        sum[r][v] = accumulate
+            ? _mm512_mul_ps(beta, _mm512_loadu_ps(C + r * ldc + v * kVLen))
+            : _mm512_setzero_ps();
+      }
+    }
+    const float* A = gp->A;
+    for (uint64_t kk = 0; kk < gp->k; ++kk) {
+      const __m512 b0 = loadBf16(B);
+      const __m512 b1 = loadBf16(B + kVLen);
+      B += 2 * kVLen;
+      for (int r = 0; r < ROWS; ++r) {
+        const __m512 a = _mm512_set1_ps(A[r]);
+        sum[r][0] = _mm512_fmadd_ps(a, b0, sum[r][0]);
+        sum[r][1] = _mm512_fmadd_ps(a, b1, sum[r][1]);
+      }
+      A += ROWS;
+    }
+    for (int r = 0; r < ROWS; ++r) {
+      _mm512_storeu_ps(C + r * ldc, sum[r][0]);
+      _mm512_storeu_ps(C + r * ldc + kVLen, sum[r][1]);
+    }
+    C += 2 * kVLen;
+  }
+}
+
+} // namespace
+
+void NOINLINE gemmkernel_1x2_Avx512_bf16_fA0fB0fC0(GemmParamsBF16* gp) {
+  gemmkernelAvx512Bf16<1>(gp);
+}
+void NOINLINE gemmkernel_2x2_Avx512_bf16_fA0fB0fC0(GemmParamsBF16* gp) {
+  gemmkernelAvx512Bf16<2>(gp);
+}
+void NOINLINE gemmkernel_3x2_Avx512_bf16_fA0fB0fC0(GemmParamsBF16* gp) {
+  gemmkernelAvx512Bf16<3>(gp);
+}
+void NOINLINE gemmkernel_4x2_Avx512_bf16_fA0fB0fC0(GemmParamsBF16* gp) {
+  gemmkernelAvx512Bf16<4>(gp);
+}
+void NOINLINE gemmkernel_5x2_Avx512_bf16_fA0fB0fC0(GemmParamsBF16* gp) {
+  gemmkernelAvx512Bf16<5>(gp);
+}
+void NOINLINE gemmkernel_6x2_Avx512_bf16_fA0fB0fC0(GemmParamsBF16* gp) {
+  gemmkernelAvx512Bf16<6>(gp);
+}
+void NOINLINE gemmkernel_7x2_Avx512_bf16_fA0fB0fC0(GemmParamsBF16* gp) {
+  gemmkernelAvx512Bf16<7>(gp);
+}
+void NOINLINE gemmkernel_8x2_Avx512_bf16_fA0fB0fC0(GemmParamsBF16* gp) {
+  gemmkernelAvx512Bf16<8>(gp);
+}
+void NOINLINE gemmkernel_9x2_Avx512_bf16_fA0fB0fC0(GemmParamsBF16* gp) {
+  gemmkernelAvx512Bf16<9>(gp);
+}
+void NOINLINE gemmkernel_10x2_Avx512_bf16_fA0fB0fC0(GemmParamsBF16* gp) {
+  gemmkernelAvx512Bf16<10>(gp);
+}
+void NOINLINE gemmkernel_11x2_Avx512_bf16_fA0fB0fC0(GemmParamsBF16* gp) {
+  gemmkernelAvx512Bf16<11>(gp);
+}
+void NOINLINE gemmkernel_12x2_Avx512_bf16_fA0fB0fC0(GemmParamsBF16* gp) {
+  gemmkernelAvx512Bf16<12>(gp);
+}
+void NOINLINE gemmkernel_13x2_Avx512_bf16_fA0fB0fC0(GemmParamsBF16* gp) {
+  gemmkernelAvx512Bf16<13>(gp);
+}
+void NOINLINE gemmkernel_14x2_Avx512_bf16_fA0fB0fC0(GemmParamsBF16* gp) {
+  gemmkernelAvx512Bf16<14>(gp);
+}
+
+} // namespace fbgemm
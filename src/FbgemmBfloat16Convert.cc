@@ -61,6 +61,23 @@ void FloatToBfloat16_simd(const float* src, bfloat16* dst, size_t size) {
   }
 }
 
+void FloatToBfloat16StochasticRounding_simd(
+    const float* src,
+    bfloat16* dst,
+    size_t size) {
+  // Run time CPU detection
+  if (cpuinfo_initialize()) {
+    // The conversion is bound by memory bandwidth so AVX512 would not help
+    if (fbgemmHasAvx2Support()) {
+      FloatToBfloat16StochasticRounding_avx2(src, dst, size);
+    } else {
+      FloatToBfloat16StochasticRounding_ref(src, dst, size);
+    }
+  } else {
+    throw std::runtime_error("Failed to initialize cpuinfo!");
+  }
+}
+
 void Bfloat16ToFloat_simd(const bfloat16* src, float* dst, size_t size) {
   // Run time CPU detection
   if (cpuinfo_initialize()) {
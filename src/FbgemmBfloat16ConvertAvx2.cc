@@ -13,6 +13,10 @@
 #define FBGEMM_EXPORTS
 #include "fbgemm/FbgemmConvert.h"
 
+#include <cstring>
+
+#include "./StochasticRoundingAvx2.h"
+
 namespace fbgemm {
 
 namespace {
@@ -57,6 +61,28 @@ void FloatToBfloat16_avx2(const float* src, bfloat16* dst, size_t size) {
   FloatToBfloat16_ref(src + i, dst + i, size - i);
 }
 
+void FloatToBfloat16StochasticRounding_avx2(
+    const float* src,
+    bfloat16* dst,
+    size_t size) {
+  internal::StochasticRoundingAvx2 rounding;
+  size_t i = 0;
+  for (i = 0; i + 8 <= size; i += 8) {
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(dst + i),
+        rounding.toBfloat16(_mm256_loadu_ps(src + i)));
+  }
+  if (i < size) {
+    float buf[8] = {};
+    bfloat16 buf_out[8];
+    std::memcpy(buf, src + i, (size - i) * sizeof(float));
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(buf_out),
+        rounding.toBfloat16(_mm256_loadu_ps(buf)));
+    std::memcpy(dst + i, buf_out, (size - i) * sizeof(bfloat16));
+  }
+}
+
 void Bfloat16ToFloat_avx2(const bfloat16* src, float* dst, size_t size) {
   size_t i = 0;
   for (i = 0; i + 8 <= size; i += 8) {
@@ -7,11 +7,13 @@
  */
 
 #define FBGEMM_EXPORTS
+#include <cpuinfo.h>
 #include <algorithm>
 #include <functional>
 #include <numeric>
 #include <stdexcept> // for logic_error
 #include <vector>
+#include "./TraceScope.h"
 #include "fbgemm/Fbgemm.h"
 
 namespace fbgemm {
@@ -20,7 +22,7 @@ template <int SPATIAL_DIM, typename ACC_T>
 bool takeDepthWiseFastPath(const conv_param_t<SPATIAL_DIM>& conv_p) {
   // Note: Depthwise convolutions (both 2D and 3D) are optimized for the most
   // common case.
-  // 3x3 or 5x5 2D
+  // 3x3, 5x5 or 7x7 2D, optionally dilated
   // (3 or 5)x(3x3 or 5x5) 3D
   bool ret = std::is_same<ACC_T, std::int32_t>::value &&
       conv_p.G == conv_p.IC &&
@@ -36,15 +38,17 @@ bool takeDepthWiseFastPath(const conv_param_t<SPATIAL_DIM>& conv_p) {
                  conv_p.K.begin(),
                  conv_p.K.end(),
                  [](int i) { return i == 3 || i == 5 || i == 7; }) &&
-      std::all_of(
-                 conv_p.dilation.begin(),
-                 conv_p.dilation.end(),
-                 [](int i) { return i == 1; }) &&
+      // Only the 2D kernels support dilation
+      (SPATIAL_DIM == 2 ||
+       std::all_of(
+           conv_p.dilation.begin(),
+           conv_p.dilation.end(),
+           [](int i) { return i == 1; })) &&
       !conv_p.transposed;
 
   // Check pads result in same input and output spatial dim
   for (int i = 0; i < SPATIAL_DIM; ++i) {
-    if (conv_p.pad[i] != (conv_p.K[i] - 1) / 2 ||
+    if (conv_p.pad[i] != conv_p.dilation[i] * (conv_p.K[i] - 1) / 2 ||
         conv_p.pad[i] != conv_p.pad[SPATIAL_DIM + i]) {
       ret = false;
     }
@@ -64,6 +68,44 @@ bool takePointWiseFastPath(const conv_param_t<SPATIAL_DIM>& conv_p) {
       !conv_p.transposed;
 }
 
+template <int SPATIAL_DIM, typename ACC_T>
+bool takeWinogradFastPath(const conv_param_t<SPATIAL_DIM>& conv_p) {
+  // Note: Winograd F(2x2, 3x3) replaces the 9 multiplications per output
+  // and input channel by 4 int16 ones, which only pays off over the
+  // transforms with enough channels. The int16 products are accumulated in
+  // int32, which limits the number of input channels.
+  // The kernel uses 256-bit vpmaddwd, which is slower than the AVX512 GEMM,
+  // so it is only taken on AVX2 hosts.
+  return std::is_same<ACC_T, std::int32_t>::value && SPATIAL_DIM == 2 &&
+      conv_p.G == 1 && conv_p.IC >= 16 && conv_p.IC <= 1024 &&
+      conv_p.OC >= 16 &&
+      std::all_of(
+             conv_p.K.begin(), conv_p.K.end(), [](int i) { return i == 3; }) &&
+      std::all_of(
+             conv_p.stride.begin(),
+             conv_p.stride.end(),
+             [](int i) { return i == 1; }) &&
+      std::all_of(
+             conv_p.dilation.begin(),
+             conv_p.dilation.end(),
+             [](int i) { return i == 1; }) &&
+      !conv_p.transposed && cpuinfo_initialize() &&
+      fbgemmInstructionSet() == inst_set_t::avx2;
+}
+
+template <int SPATIAL_DIM, typename ACC_T>
+bool takeTransposedConvPath(const conv_param_t<SPATIAL_DIM>& conv_p) {
+  // Note: With strides > 1, most im2col entries of a transposed conv read
+  // zero points. The sub-pixel decomposition multiplies each output phase
+  // by its taps only.
+  return std::is_same<ACC_T, std::int32_t>::value && SPATIAL_DIM == 2 &&
+      conv_p.transposed &&
+      std::any_of(
+             conv_p.stride.begin(),
+             conv_p.stride.end(),
+             [](int i) { return i > 1; });
+}
+
 template <int SPATIAL_DIM>
 bool take1DFastPath(const conv_param_t<SPATIAL_DIM>& conv_p) {
   return false && !conv_p.transposed;
@@ -71,43 +113,39 @@ bool take1DFastPath(const conv_param_t<SPATIAL_DIM>& conv_p) {
 
 template <int SPATIAL_DIM, typename ACC_T>
 bool takeDirectConvPath(const conv_param_t<SPATIAL_DIM>& conv_p) {
-  // Note: Direct convolutions (2D) are optimized for
-  // filter size: 2 x 1 to 2 x 6,  transposed conv,
-  // in_channel % 8 == 0, out_channel % 8 == 0
-  // stride = 1 or 2
-  // padding = 0 ( non-zero padding will be supported soon)
-  bool ret = std::is_same<ACC_T, std::int32_t>::value && conv_p.transposed &&
-      conv_p.G == 1 && conv_p.IC % 8 == 0 && conv_p.OC % 8 == 0 &&
-      std::all_of(
-                 conv_p.stride.begin(),
-                 conv_p.stride.end(),
-                 [](int i) { return i == 1 || i == 2; }) &&
-      SPATIAL_DIM == 2 && conv_p.K[SPATIAL_DIM - 2] == 2 &&
-      conv_p.K[SPATIAL_DIM - 1] <= 6 &&
-      std::all_of(conv_p.dilation.begin(), conv_p.dilation.end(), [](int i) {
-               return i == 1;
-             });
-
-  // Check pads: zero padding
-  for (int i = 0; i < SPATIAL_DIM; ++i) {
-    if (conv_p.pad[i] != 0) {
-      ret = false;
-    }
-  }
-  ret = false;
-  return ret;
+  // Note: Direct convolutions (2D) handle dense (G == 1), non-transposed
+  // convolutions with any filter size, stride, dilation and padding, so
+  // they don't need the im2col buffer.
+  // The kernel uses vpmaddubsw as the AVX2 GEMM does, so it is only taken
+  // on AVX2 hosts: the AVX512 GEMM is wider and with VNNI its vpdpbusd
+  // does not saturate the pair sums to int16.
+  // The JIT kernel for transposed convs (filter size 2 x 1 to 2 x 6,
+  // in_channel % 8 == 0, out_channel % 8 == 0, stride = 1 or 2,
+  // padding = 0) is not integrated yet.
+  return std::is_same<ACC_T, std::int32_t>::value && SPATIAL_DIM == 2 &&
+      !conv_p.transposed && conv_p.G == 1 && cpuinfo_initialize() &&
+      fbgemmInstructionSet() == inst_set_t::avx2;
 }
 
 template <int SPATIAL_DIM, typename ACC_T>
 optimized_conv_t ConvFastPath(const conv_param_t<SPATIAL_DIM>& conv_p) {
+  // The fast paths load all channels of an input pixel at once, so NCHW
+  // activations are gathered by the im2col packing instead.
+  if (conv_p.input_layout == conv_layout_t::NCHW) {
+    return optimized_conv_t::im2col;
+  }
   if (takeDepthWiseFastPath<SPATIAL_DIM, ACC_T>(conv_p)) {
     return optimized_conv_t::depthwise;
   } else if (fbgemmOptimizedGConv<SPATIAL_DIM>(conv_p)) {
     return optimized_conv_t::groupwise;
   } else if (takePointWiseFastPath<SPATIAL_DIM>(conv_p)) {
     return optimized_conv_t::pointwise;
+  } else if (takeWinogradFastPath<SPATIAL_DIM, ACC_T>(conv_p)) {
+    return optimized_conv_t::winograd;
   } else if (takeDirectConvPath<SPATIAL_DIM, ACC_T>(conv_p)) {
     return optimized_conv_t::directconv;
+  } else if (takeTransposedConvPath<SPATIAL_DIM, ACC_T>(conv_p)) {
+    return optimized_conv_t::transposed;
   } else if (take1DFastPath<SPATIAL_DIM>(conv_p)) {
     return optimized_conv_t::fastpath1d;
   } else {
@@ -137,7 +175,36 @@ int fbgemmConv(
     throw std::logic_error(msg);
   }
 
-  switch (ConvFastPath<SPATIAL_DIM, ACC_T>(conv_p)) {
+  [[maybe_unused]] const int64_t in_pixels = std::accumulate(
+      conv_p.IN_DIM.begin(),
+      conv_p.IN_DIM.end(),
+      int64_t{1},
+      std::multiplies<>());
+  [[maybe_unused]] const int64_t out_pixels = std::accumulate(
+      conv_p.OUT_DIM.begin(),
+      conv_p.OUT_DIM.end(),
+      int64_t{1},
+      std::multiplies<>());
+  [[maybe_unused]] const int64_t kernel_taps = std::accumulate(
+      conv_p.K.begin(), conv_p.K.end(), int64_t{1}, std::multiplies<>());
+  FBGEMM_TRACE_SCOPE(
+      "fbgemmConv",
+      conv_p.MB * in_pixels * conv_p.IC +
+          kernel_taps * conv_p.IC / conv_p.G * conv_p.OC +
+          conv_p.MB * out_pixels * conv_p.OC *
+              sizeof(typename processOutputType::outType),
+      thread_id,
+      num_threads,
+      conv_p.MB,
+      conv_p.IC,
+      conv_p.OC,
+      conv_p.G,
+      out_pixels,
+      kernel_taps);
+
+  // The path is the one the weights were packed for, which can differ from
+  // ConvFastPath when the instruction set was changed since.
+  switch (packed_weights.convPath()) {
     case optimized_conv_t::depthwise: {
       // 2D and 3D depthwise fast path
       // std::cout << "Depthwise fast path" << std::endl;
@@ -229,7 +296,9 @@ int fbgemmConv(
               outProcess.RELU_FUSED, // fuse_relu
               act_times_w_scale,
               thread_id,
-              num_threads);
+              num_threads,
+              conv_p.dilation[0], // dilation_h
+              conv_p.dilation[SPATIAL_DIM - 1]); // dilation_w
         } else if (
             processOutputType::QGRANType == QuantizationGranularity::GROUP) {
           depthwise_2d_same_pad<QuantizationGranularity::GROUP>(
@@ -252,7 +321,9 @@ int fbgemmConv(
               outProcess.RELU_FUSED, // fuse_relu
               act_times_w_scale, // act_scale * weight_scale
               thread_id,
-              num_threads);
+              num_threads,
+              conv_p.dilation[0], // dilation_h
+              conv_p.dilation[SPATIAL_DIM - 1]); // dilation_w
         } else if (
             processOutputType::QGRANType ==
             QuantizationGranularity::OUT_CHANNEL) {
@@ -277,7 +348,9 @@ int fbgemmConv(
               outProcess.RELU_FUSED, // fuse_relu
               act_times_w_scale, // act_scale * weight_scale
               thread_id,
-              num_threads);
+              num_threads,
+              conv_p.dilation[0], // dilation_h
+              conv_p.dilation[SPATIAL_DIM - 1]); // dilation_w
         } else {
           std::string msg =
               "[FBGEMM_CONV_ERROR] This quantization granularity is "
@@ -311,6 +384,8 @@ int fbgemmConv(
       break;
     }
     case optimized_conv_t::pointwise: {
+      // A is packed for the ISA the weights were packed for
+      FbgemmIsaScope isa_scope(packed_weights.getPackedWForPointwise()->isa());
       std::vector<int32_t> row_offset_buf(
           PackAWithRowOffset<uint8_t>::rowOffsetBufferSize(blocking_params));
       int image_dim = std::accumulate(
@@ -358,12 +433,37 @@ int fbgemmConv(
           num_threads);
       break;
     }
+    case optimized_conv_t::winograd: {
+      fbgemmWinogradConv(
+          *reinterpret_cast<const conv_param_t<2>*>(&conv_p),
+          activations,
+          *(packed_weights.getPackedWForWinograd()),
+          out,
+          outBuffer,
+          outProcess,
+          thread_id,
+          num_threads);
+      break;
+    }
+    case optimized_conv_t::transposed: {
+      fbgemmTransposedConv(
+          *reinterpret_cast<const conv_param_t<2>*>(&conv_p),
+          activations,
+          *(packed_weights.getPackedWForTransposed()),
+          out,
+          outProcess,
+          thread_id,
+          num_threads,
+          blocking_params);
+      break;
+    }
     case optimized_conv_t::fastpath1d: {
       break;
     }
     case optimized_conv_t::im2col: {
       // All other convolutions go through im2col-based implementation
       // std::cout << "Im2col path" << std::endl;
+      FbgemmIsaScope isa_scope(packed_weights.getPackedWForIm2col()->isa());
       std::vector<int32_t> row_offset_buf(
           PackAWithIm2Col<uint8_t, ACC_T, SPATIAL_DIM>::rowOffsetBufferSize(
               blocking_params));
@@ -398,7 +498,8 @@ int fbgemmConv(
           outProcess.getAZeroPoint(),
           row_offset_buf.data(),
           b_symmetric,
-          blocking_params);
+          blocking_params,
+          true /* implicit_gemm */);
 
       outProcess.setRowOffsets(row_offset_buf.data());
       fbgemmPacked(
@@ -465,6 +566,16 @@ template bool takeDepthWiseFastPath<2, std::int16_t>(
 template bool takeDepthWiseFastPath<3, std::int16_t>(
     const conv_param_t<3>& conv_p);
 
+template bool takeWinogradFastPath<2, std::int32_t>(
+    const conv_param_t<2>& conv_p);
+template bool takeWinogradFastPath<2, std::int16_t>(
+    const conv_param_t<2>& conv_p);
+
+template bool takeTransposedConvPath<2, std::int32_t>(
+    const conv_param_t<2>& conv_p);
+template bool takeTransposedConvPath<2, std::int16_t>(
+    const conv_param_t<2>& conv_p);
+
 template bool takeDirectConvPath<2, std::int32_t>(
     const conv_param_t<2>& conv_p);
 template bool takeDirectConvPath<3, std::int32_t>(
@@ -0,0 +1,188 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#define FBGEMM_EXPORTS
+#include <algorithm>
+#include <stdexcept> // for logic_error
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "fbgemm/Fbgemm.h"
+
+namespace fbgemm {
+
+namespace {
+
+// Bytes of depthwise output per band of rows. The pointwise GEMM packs its A
+// blocks from the band, so it should stay in L2 until the GEMM is done.
+constexpr int kBandBytes = 128 * 1024;
+
+} // namespace
+
+template <typename dwProcessOutputType, typename pwProcessOutputType>
+int fbgemmDepthwiseSeparableConv(
+    const conv_param_t<2>& dw_conv_p,
+    const conv_param_t<2>& pw_conv_p,
+    const std::uint8_t* activations,
+    PackWeightsForConv<2>& dw_packed_weights,
+    PackWeightsForConv<2>& pw_packed_weights,
+    const dwProcessOutputType& dwOutProcess,
+    typename pwProcessOutputType::outType* out,
+    std::int32_t* outBuffer,
+    pwProcessOutputType& pwOutProcess,
+    int thread_id,
+    int num_threads) {
+  static_assert(
+      std::is_same<typename dwProcessOutputType::outType, std::uint8_t>::value,
+      "For depthwise, only requantized output is supported");
+  if (!dw_packed_weights.isPackingCompliant(dw_conv_p) ||
+      !pw_packed_weights.isPackingCompliant(pw_conv_p)) {
+    std::string msg =
+        "[FBGEMM_CONV_ERROR] Convolution parameters "
+        "mismatch between pre-packed weights and conv invocation! ";
+    msg += dw_packed_weights.mismatchingParams(dw_conv_p);
+    msg += pw_packed_weights.mismatchingParams(pw_conv_p);
+    throw std::logic_error(msg);
+  }
+  if (dw_packed_weights.convPath() != optimized_conv_t::depthwise ||
+      pw_packed_weights.convPath() != optimized_conv_t::pointwise ||
+      pw_conv_p.G != 1 || pw_conv_p.MB != dw_conv_p.MB ||
+      pw_conv_p.IC != dw_conv_p.OC || pw_conv_p.IN_DIM != dw_conv_p.OUT_DIM) {
+    throw std::logic_error(
+        "[FBGEMM_CONV_ERROR] Expected a depthwise convolution followed by a "
+        "pointwise convolution of its output");
+  }
+
+  const int H = dw_conv_p.IN_DIM[0];
+  const int W = dw_conv_p.IN_DIM[1];
+  const int C = dw_conv_p.OC;
+  const int H_OUT = dw_conv_p.OUT_DIM[0];
+  const int W_OUT = dw_conv_p.OUT_DIM[1];
+  // Rows spanned by the dilated filter
+  const int R = dw_conv_p.dilation[0] * (dw_conv_p.K[0] - 1) + 1;
+  const int stride_h = dw_conv_p.stride[0];
+  const int pad = dw_conv_p.pad[0];
+  const int OC = pw_conv_p.OC;
+
+  const int band_rows =
+      std::max(1, std::min(H_OUT, kBandBytes / (W_OUT * C)));
+  const int num_bands = (H_OUT + band_rows - 1) / band_rows;
+  // The band of output rows [h0, h1) is a same-padded depthwise convolution
+  // of just the input rows it reads. If those do not start at the top of the
+  // image, the first halo output rows see padding in place of the rows above
+  // and are dropped. Likewise for the rows past the bottom of the band.
+  const int halo = (pad + stride_h - 1) / stride_h;
+
+  int64_t band_begin, band_end;
+  fbgemmPartition1D(
+      thread_id,
+      num_threads,
+      static_cast<int64_t>(dw_conv_p.MB) * num_bands,
+      band_begin,
+      band_end);
+
+  std::vector<std::uint8_t> dw_out;
+  std::vector<std::int32_t> row_offset_buf(
+      PackAWithRowOffset<std::uint8_t>::rowOffsetBufferSize());
+  for (int64_t band = band_begin; band < band_end; ++band) {
+    const int n = band / num_bands;
+    const int h0 = band % num_bands * band_rows;
+    const int h1 = std::min(h0 + band_rows, H_OUT);
+    const int in_begin = std::max(0, (h0 - halo) * stride_h);
+    const int in_end = std::min(H, (h1 - 1) * stride_h - pad + R);
+    const int skip = in_begin == 0 ? h0 : halo;
+    const int band_h_out = (in_end - in_begin + 2 * pad - R) / stride_h + 1;
+
+    dw_out.resize(static_cast<size_t>(band_h_out) * W_OUT * C);
+    depthwise_2d_same_pad<dwProcessOutputType::QGRANType>(
+        1, // mini batch
+        in_end - in_begin, // H
+        W,
+        dw_conv_p.IC,
+        C,
+        stride_h,
+        dw_conv_p.stride[1], // stride_w
+        dwOutProcess.getAZeroPoint(),
+        activations +
+            (static_cast<int64_t>(n) * H + in_begin) * W * dw_conv_p.IC,
+        dwOutProcess.getBZeroPoint(),
+        *(dw_packed_weights.getPackedWForDepthwise()),
+        dwOutProcess.getCMultiplier(),
+        dwOutProcess.getCZeroPoint(),
+        dw_out.data(),
+        dwOutProcess.getColOffsets(),
+        dwOutProcess.getBias(),
+        dwOutProcess.RELU_FUSED, // fuse_relu
+        dwOutProcess.getActWScale(),
+        0, // thread_id
+        1, // num_threads
+        dw_conv_p.dilation[0], // dilation_h
+        dw_conv_p.dilation[1]); // dilation_w
+
+    const int64_t out_row = (static_cast<int64_t>(n) * H_OUT + h0) * W_OUT;
+    PackAWithRowOffset<std::uint8_t> packA(
+        matrix_op_t::NoTranspose,
+        (h1 - h0) * W_OUT,
+        C,
+        dw_out.data() + static_cast<int64_t>(skip) * W_OUT * C,
+        C,
+        nullptr,
+        1,
+        row_offset_buf.data());
+
+    pwOutProcess.setRowOffsets(row_offset_buf.data());
+    fbgemmPacked(
+        packA,
+        *(pw_packed_weights.getPackedWForPointwise()),
+        out + out_row * OC,
+        outBuffer + out_row * OC,
+        OC,
+        pwOutProcess,
+        0,
+        1);
+  }
+
+  return 0;
+}
+
+#define INSTANTIATE_BASE(DW_RELU, PW_RELU, Q_GRAN, BIAS_TYPE)           \
+  template FBGEMM_API int fbgemmDepthwiseSeparableConv(                 \
+      const conv_param_t<2>& dw_conv_p,                                 \
+      const conv_param_t<2>& pw_conv_p,                                 \
+      const std::uint8_t* activations,                                  \
+      PackWeightsForConv<2>& dw_packed_weights,                         \
+      PackWeightsForConv<2>& pw_packed_weights,                         \
+      const ReQuantizeOutput<DW_RELU, Q_GRAN, BIAS_TYPE>& dwOutProcess, \
+      std::uint8_t* out,                                                \
+      std::int32_t* outBuffer,                                          \
+      ReQuantizeOutput<PW_RELU, Q_GRAN, BIAS_TYPE>& pwOutProcess,       \
+      int thread_id,                                                    \
+      int num_threads);
+
+#define INSTANTIATE_BIAS_T(DW_RELU, PW_RELU, Q_GRAN) \
+  INSTANTIATE_BASE(DW_RELU, PW_RELU, Q_GRAN, float)  \
+  INSTANTIATE_BASE(DW_RELU, PW_RELU, Q_GRAN, std::int32_t)
+
+#define INSTANTIATE_Q_GRANS(DW_RELU, PW_RELU)                           \
+  INSTANTIATE_BIAS_T(DW_RELU, PW_RELU, QuantizationGranularity::TENSOR) \
+  INSTANTIATE_BIAS_T(DW_RELU, PW_RELU, QuantizationGranularity::GROUP)  \
+  INSTANTIATE_BIAS_T(DW_RELU, PW_RELU, QuantizationGranularity::OUT_CHANNEL)
+
+#define INSTANTIATE_RELU(DW_RELU)    \
+  INSTANTIATE_Q_GRANS(DW_RELU, true) \
+  INSTANTIATE_Q_GRANS(DW_RELU, false)
+
+INSTANTIATE_RELU(true)
+INSTANTIATE_RELU(false)
+
+#undef INSTANTIATE_RELU
+#undef INSTANTIATE_Q_GRANS
+#undef INSTANTIATE_BIAS_T
+#undef INSTANTIATE_BASE
+
+} // namespace fbgemm
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#define FBGEMM_EXPORTS
+#include <cassert>
+#include <vector>
+
+#include "fbgemm/Fbgemm.h"
+#include "fbgemm/QuantUtils.h"
+#include "fbgemm/QuantUtilsAvx2.h"
+
+namespace fbgemm {
+
+template <bool FUSE_RELU, QuantizationGranularity Q_GRAN>
+void fbgemmDynamicQuantFC(
+    int m,
+    const float* A,
+    PackBMatrix<std::int8_t>& packedB,
+    const float* B_scale,
+    const std::int32_t* B_zero_point,
+    const std::int32_t* col_offsets,
+    const float* bias,
+    float* C,
+    std::uint32_t ldc,
+    int thread_id,
+    int num_threads) {
+  assert(packedB.numGroups() == 1);
+  const std::int32_t k = packedB.numRows();
+  const std::int32_t n = packedB.numCols();
+
+  // Every thread finds the range of the whole A itself instead of waiting on
+  // the others, so the quantization does not depend on the thread count.
+  float min, max;
+  FindMinMax(A, &min, &max, static_cast<std::int64_t>(m) * k);
+  const TensorQuantizationParams A_qparams =
+      ChooseQuantizationParams(min, max, 0, 255);
+
+  std::vector<std::int32_t> row_offset_buf(
+      PackAWithQuantRowOffset<std::uint8_t>::rowOffsetBufferSize());
+  PackAWithQuantRowOffset<std::uint8_t> packA(
+      matrix_op_t::NoTranspose,
+      m,
+      k,
+      A,
+      k,
+      nullptr, /*buffer for packed matrix*/
+      A_qparams.scale,
+      A_qparams.zero_point,
+      1, /*groups*/
+      row_offset_buf.data());
+
+  DoNothing<float, float> doNothingObj{};
+  ReQuantizeForFloat<FUSE_RELU, Q_GRAN> outputProcObj(
+      doNothingObj,
+      A_qparams.scale,
+      B_scale,
+      A_qparams.zero_point,
+      B_zero_point,
+      packA.getRowOffsetBuffer(),
+      col_offsets,
+      bias,
+      n);
+
+  fbgemmPacked(
+      packA,
+      packedB,
+      C,
+      reinterpret_cast<std::int32_t*>(C),
+      ldc,
+      outputProcObj,
+      thread_id,
+      num_threads);
+}
+
+#define INSTANTIATE_BASE(RELU, Q_GRAN)                         \
+  template FBGEMM_API void fbgemmDynamicQuantFC<RELU, Q_GRAN>( \
+      int m,                                                   \
+      const float* A,                                          \
+      PackBMatrix<std::int8_t>& packedB,                       \
+      const float* B_scale,                                    \
+      const std::int32_t* B_zero_point,                        \
+      const std::int32_t* col_offsets,                         \
+      const float* bias,                                       \
+      float* C,                                                \
+      std::uint32_t ldc,                                       \
+      int thread_id,                                           \
+      int num_threads);
+
+#define INSTANTIATE_Q_GRANS(RELU)                         \
+  INSTANTIATE_BASE(RELU, QuantizationGranularity::TENSOR) \
+  INSTANTIATE_BASE(RELU, QuantizationGranularity::OUT_CHANNEL)
+
+INSTANTIATE_Q_GRANS(false)
+INSTANTIATE_Q_GRANS(true)
+
+#undef INSTANTIATE_Q_GRANS
+#undef INSTANTIATE_BASE
+
+} // namespace fbgemm
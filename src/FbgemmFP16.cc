@@ -11,8 +11,10 @@
 #include <cmath>
 #include <utility>
 
+#include "./FbgemmFP16Gemv.h"
 #include "./FbgemmFP16UKernelsAvx2.h"
 #include "./FbgemmFP16UKernelsAvx512.h"
+#include "./FbgemmFP16UKernelsAvx512Fp16.h"
 #include "./FbgemmFP16UKernelsAvx512_256.h"
 #include "fbgemm/Fbgemm.h"
 #include "fbgemm/FbgemmFPCommon.h"
@@ -72,16 +74,42 @@ constexpr kernel_array_t<float16> kernel_fp16_avx512 = {
 #endif
 };
 
+#ifdef FBGEMM_HAS_AVX512FP16_KERNELS
+constexpr kernel_array_t<float16> kernel_fp16acc_avx512fp16 = {
+    nullptr,
+    gemmkernel_1x2_Avx512Fp16_fp16acc_fA0fB0fC0,
+    gemmkernel_2x2_Avx512Fp16_fp16acc_fA0fB0fC0,
+    gemmkernel_3x2_Avx512Fp16_fp16acc_fA0fB0fC0,
+    gemmkernel_4x2_Avx512Fp16_fp16acc_fA0fB0fC0,
+    gemmkernel_5x2_Avx512Fp16_fp16acc_fA0fB0fC0,
+    gemmkernel_6x2_Avx512Fp16_fp16acc_fA0fB0fC0,
+    gemmkernel_7x2_Avx512Fp16_fp16acc_fA0fB0fC0,
+    gemmkernel_8x2_Avx512Fp16_fp16acc_fA0fB0fC0,
+    gemmkernel_9x2_Avx512Fp16_fp16acc_fA0fB0fC0,
+    gemmkernel_10x2_Avx512Fp16_fp16acc_fA0fB0fC0,
+    gemmkernel_11x2_Avx512Fp16_fp16acc_fA0fB0fC0,
+    gemmkernel_12x2_Avx512Fp16_fp16acc_fA0fB0fC0,
+    gemmkernel_13x2_Avx512Fp16_fp16acc_fA0fB0fC0,
+    gemmkernel_14x2_Avx512Fp16_fp16acc_fA0fB0fC0};
+#endif
+
 } // namespace
 
 template <>
 const isa_descriptor<float16>& getIsaHandlers(inst_set_t isa, float16) {
+#ifndef __aarch64__
+  constexpr gemv_funcptr_t<float16> gemv_avx2 = gemvFp16Avx2;
+  constexpr gemv_funcptr_t<float16> gemv_avx512 = gemvFp16Avx512;
+#else
+  constexpr gemv_funcptr_t<float16> gemv_avx2 = nullptr;
+  constexpr gemv_funcptr_t<float16> gemv_avx512 = nullptr;
+#endif
   static isa_descriptor<float16> avx2_descriptor =
-      std::make_tuple(kernel_fp16_avx2, partition_avx2);
+      std::make_tuple(kernel_fp16_avx2, partition_avx2, gemv_avx2);
   static isa_descriptor<float16> avx512_descriptor =
-      std::make_tuple(kernel_fp16_avx512, partition_avx512);
+      std::make_tuple(kernel_fp16_avx512, partition_avx512, gemv_avx512);
   static isa_descriptor<float16> avx512_256_descriptor =
-      std::make_tuple(kernel_fp16_avx512_256, partition_avx512);
+      std::make_tuple(kernel_fp16_avx512_256, partition_avx512, gemv_avx2);
 
   switch (isa) {
     case inst_set_t::anyarch:
@@ -147,4 +175,40 @@ template FBGEMM_API void cblas_gemm_compute(
     int thread_id,
     int num_threads);
 
+FBGEMM_API void cblas_gemm_compute_fp16_acc(
+    const matrix_op_t transa,
+    const int m,
+    const float* A,
+    const PackedGemmMatrixB<float16>& Bp,
+    const float beta,
+    float* C,
+    int thread_id,
+    int num_threads) {
+#if defined(FBGEMM_HAS_AVX512FP16_KERNELS) && \
+    !defined(FBGEMM_FP16_FALLBACK_TO_REF_KERNEL)
+  static const bool has_avx512fp16 =
+      isZmm(fbgemmInstructionSet()) && fbgemmHasAvx512Fp16Support();
+  // A few rows of A are bound by reading B, so those keep the fp32 GEMV
+  static isa_descriptor<float16> avx512fp16_descriptor = std::make_tuple(
+      kernel_fp16acc_avx512fp16, partition_avx512, gemvFp16Avx512);
+  if (has_avx512fp16 &&
+      Bp.blockColSize() ==
+          simd_info<inst_set_t::avx512>::WIDTH_32BIT_ELEMS *
+              Bp.kernelNumColBlocks()) {
+    cblas_gemm_compute_with_handlers(
+        avx512fp16_descriptor,
+        transa,
+        m,
+        A,
+        Bp,
+        beta,
+        C,
+        thread_id,
+        num_threads);
+    return;
+  }
+#endif
+  cblas_gemm_compute(transa, m, A, Bp, beta, C, thread_id, num_threads);
+}
+
 } // namespace fbgemm
@@ -0,0 +1,35 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+#include <cstdint>
+#include "fbgemm/FbgemmBuild.h"
+#include "fbgemm/FbgemmFPCommon.h"
+
+namespace fbgemm {
+
+// gemv_funcptr_t kernels. The block columns of Bp must be a multiple of 8
+// floats for Avx2 and of 16 for Avx512.
+void NOINLINE gemvFp16Avx2(
+    int m,
+    const float* A,
+    const PackedGemmMatrixB<float16>& Bp,
+    float beta,
+    float* C,
+    int64_t jb_begin,
+    int64_t jb_end);
+void NOINLINE gemvFp16Avx512(
+    int m,
+    const float* A,
+    const PackedGemmMatrixB<float16>& Bp,
+    float beta,
+    float* C,
+    int64_t jb_begin,
+    int64_t jb_end);
+
+} // namespace fbgemm
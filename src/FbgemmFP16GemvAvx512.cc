@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#define FBGEMM_EXPORTS
+#include <immintrin.h>
+#include <algorithm>
+
+#include "./FbgemmFP16Gemv.h"
+
+namespace fbgemm {
+
+namespace {
+
+constexpr int kVLen = 16;
+
+// Lanes of the 16 floats at column c that are inside the n columns of C.
+__mmask16 columnMask(int64_t c, int n) {
+  return (1U << (n - c)) - 1;
+}
+
+// C rows [0, ROWS) times the NVEC vectors of columns from column col.
+template <int ROWS, int NVEC>
+void gemvVectors(
+    const float* A,
+    const PackedGemmMatrixB<float16>& Bp,
+    float beta,
+    float* C,
+    int64_t col) {
+  const int n = Bp.numCols(), k = Bp.numRows();
+  const int brow = Bp.blockRowSize(), bcol = Bp.blockColSize();
+  __m512 sum[ROWS][NVEC];
+  // Like the blocked kernels, start from beta * C so that the results are
+  // rounded the same.
+  const __m512 vbeta = _mm512_set1_ps(beta);
+  for (int r = 0; r < ROWS; ++r) {
+    for (int v = 0; v < NVEC; ++v) {
+      const int64_t c = col + v * kVLen;
+      if (beta == 0.f || c >= n) {
+        sum[r][v] = _mm512_setzero_ps();
+      } else if (c + kVLen <= n) {
+        sum[r][v] = _mm512_mul_ps(vbeta, _mm512_loadu_ps(C + r * n + c));
+      } else {
+        sum[r][v] = _mm512_mul_ps(
+            vbeta, _mm512_maskz_loadu_ps(columnMask(c, n), C + r * n + c));
+      }
+    }
+  }
+
+  for (int k_ind = 0; k_ind < k; k_ind += brow) {
+    const int kb = std::min(brow, k - k_ind);
+    // Blocks of kb x bcol halfs, each row of one after the other.
+    const float16* Bk = &Bp(k_ind, 0);
+    const float16* B[NVEC];
+    for (int v = 0; v < NVEC; ++v) {
+      const int64_t c = col + v * kVLen;
+      B[v] = Bk + c / bcol * kb * bcol + c % bcol;
+    }
+    for (int kk = 0; kk < kb; ++kk) {
+      __m512 b[NVEC];
+      for (int v = 0; v < NVEC; ++v) {
+        // maskz avoids GCC's maybe-uninitialized false positive on the
+        // pass-through of the unmasked conversion.
+        b[v] = _mm512_maskz_cvtph_ps(
+            0xffff,
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(B[v])));
+        B[v] += bcol;
+      }
+      for (int r = 0; r < ROWS; ++r) {
+        const __m512 a = _mm512_set1_ps(A[r * k + k_ind + kk]);
+        for (int v = 0; v < NVEC; ++v) {
+          sum[r][v] = _mm512_fmadd_ps(a, b[v], sum[r][v]);
+        }
+      }
+    }
+  }
+
+  for (int r = 0; r < ROWS; ++r) {
+    for (int v = 0; v < NVEC; ++v) {
+      const int64_t c = col + v * kVLen;
+      if (c + kVLen <= n) {
+        _mm512_storeu_ps(C + r * n + c, sum[r][v]);
+      } else if (c < n) {
+        _mm512_mask_storeu_ps(C + r * n + c, columnMask(c, n), sum[r][v]);
+      }
+    }
+  }
+}
+
+template <int ROWS>
+void gemvRows(
+    const float* A,
+    const PackedGemmMatrixB<float16>& Bp,
+    float beta,
+    float* C,
+    int64_t jb_begin,
+    int64_t jb_end) {
+  // With 32 zmm registers the sums of 4 vectors fit for up to 4 rows.
+  constexpr int kMaxVectors = 4;
+  const int64_t vectorsPerBlock = Bp.blockColSize() / kVLen;
+  int64_t v = jb_begin * vectorsPerBlock;
+  const int64_t v_end = jb_end * vectorsPerBlock;
+  for (; v + kMaxVectors <= v_end; v += kMaxVectors) {
+    gemvVectors<ROWS, kMaxVectors>(A, Bp, beta, C, v * kVLen);
+  }
+  for (; v + 2 <= v_end; v += 2) {
+    gemvVectors<ROWS, 2>(A, Bp, beta, C, v * kVLen);
+  }
+  for (; v < v_end; ++v) {
+    gemvVectors<ROWS, 1>(A, Bp, beta, C, v * kVLen);
+  }
+}
+
+} // namespace
+
+void NOINLINE gemvFp16Avx512(
+    int m,
+    const float* A,
+    const PackedGemmMatrixB<float16>& Bp,
+    float beta,
+    float* C,
+    int64_t jb_begin,
+    int64_t jb_end) {
+  static_assert(gemv_max_rows == 4, "missing cases for the number of rows");
+  switch (m) {
+    case 1:
+      gemvRows<1>(A, Bp, beta, C, jb_begin, jb_end);
+      break;
+    case 2:
+      gemvRows<2>(A, Bp, beta, C, jb_begin, jb_end);
+      break;
+    case 3:
+      gemvRows<3>(A, Bp, beta, C, jb_begin, jb_end);
+      break;
+    case 4:
+      gemvRows<4>(A, Bp, beta, C, jb_begin, jb_end);
+      break;
+    default:
+      break;
+  }
+}
+
+} // namespace fbgemm
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include "./FbgemmFP16UKernelsAvx512Fp16.h"
+
+#ifdef FBGEMM_HAS_AVX512FP16_KERNELS
+#include <immintrin.h>
+#include <vector>
+
+#define FBGEMM_TARGET_AVX512_FP16 \
+  __attribute__((target("avx512f,avx512bw,avx512dq,avx512vl,avx512fp16")))
+
+namespace fbgemm {
+
+namespace {
+
+// Converts the n floats of the packed A block to fp16
+FBGEMM_TARGET_AVX512_FP16 void
+convertPackedAToFp16(const float* src, float16* dst, int64_t n) {
+  constexpr auto kRound = _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC;
+  int64_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(dst + i),
+        _mm512_cvtps_ph(_mm512_loadu_ps(src + i), kRound));
+  }
+  if (i < n) {
+    const __mmask16 mask = (1 << (n - i)) - 1;
+    _mm256_mask_storeu_epi16(
+        dst + i,
+        mask,
+        _mm512_cvtps_ph(_mm512_maskz_loadu_ps(mask, src + i), kRound));
+  }
+}
+
+// A block of B columns is 32 fp16s, i.e. a single zmm register, so each
+// row of A takes one fp16 FMA per k instead of the two fp32 FMAs (after
+// converting B) of the fp32 kernels. The sums are kept in fp16 over the k
+// of the block and added to C in fp32.
+template <int kernel_nrows>
+FBGEMM_TARGET_AVX512_FP16 void gemmkernel_Avx512Fp16_fp16acc(
+    GemmParamsFP16* gp) {
+  static_assert(kernel_nrows >= 1 && kernel_nrows <= 14);
+  static thread_local std::vector<float16> A_fp16;
+  const int64_t A_size = kernel_nrows * gp->k;
+  if (static_cast<int64_t>(A_fp16.size()) < A_size) {
+    A_fp16.resize(A_size);
+  }
+  convertPackedAToFp16(gp->A, A_fp16.data(), A_size);
+  const auto* A = reinterpret_cast<const _Float16*>(A_fp16.data());
+
+  const uint64_t ldc_floatsize = gp->ldc / sizeof(float);
+  const __m512 zmmBeta = _mm512_set1_ps(gp->beta);
+  const float16* B = gp->B;
+  float* C = gp->C;
+  for (uint64_t ii = 0; ii < gp->b_block_cols; ++ii) {
+    __m512h zmmSum[kernel_nrows];
+    __m512h zmmB = _mm512_loadu_ph(B);
+    // Unrolled so that the sums stay in registers
+#pragma GCC unroll 14
+    for (int i = 0; i < kernel_nrows; ++i) {
+      zmmSum[i] = _mm512_mul_ph(_mm512_set1_ph(A[i]), zmmB);
+    }
+    B += 32;
+    for (uint64_t kk = 1; kk < gp->k; ++kk) {
+      zmmB = _mm512_loadu_ph(B);
+#pragma GCC unroll 14
+      for (int i = 0; i < kernel_nrows; ++i) {
+        zmmSum[i] = _mm512_fmadd_ph(
+            _mm512_set1_ph(A[kk * kernel_nrows + i]), zmmB, zmmSum[i]);
+      }
+      B += 32;
+    }
+
+#pragma GCC unroll 14
+    for (int i = 0; i < kernel_nrows; ++i) {
+      const __m512i sum = _mm512_castph_si512(zmmSum[i]);
+      __m512 sum0 = _mm512_cvtph_ps(_mm512_castsi512_si256(sum));
+      __m512 sum1 = _mm512_cvtph_ps(_mm512_extracti64x4_epi64(sum, 1));
+      float* C_row = C + i * ldc_floatsize;
+      if (gp->beta != 0) {
+        // C = A * B + beta * C
+        sum0 = _mm512_fmadd_ps(zmmBeta, _mm512_loadu_ps(C_row), sum0);
+        sum1 = _mm512_fmadd_ps(zmmBeta, _mm512_loadu_ps(C_row + 16), sum1);
+      }
+      _mm512_storeu_ps(C_row, sum0);
+      _mm512_storeu_ps(C_row + 16, sum1);
+    }
+    C += 32;
+  }
+}
+
+} // namespace
+
+void NOINLINE gemmkernel_1x2_Avx512Fp16_fp16acc_fA0fB0fC0(GemmParamsFP16* gp) {
+  gemmkernel_Avx512Fp16_fp16acc<1>(gp);
+}
+void NOINLINE gemmkernel_2x2_Avx512Fp16_fp16acc_fA0fB0fC0(GemmParamsFP16* gp) {
+  gemmkernel_Avx512Fp16_fp16acc<2>(gp);
+}
+void NOINLINE gemmkernel_3x2_Avx512Fp16_fp16acc_fA0fB0fC0(GemmParamsFP16* gp) {
+  gemmkernel_Avx512Fp16_fp16acc<3>(gp);
+}
+void NOINLINE gemmkernel_4x2_Avx512Fp16_fp16acc_fA0fB0fC0(GemmParamsFP16* gp) {
+  gemmkernel_Avx512Fp16_fp16acc<4>(gp);
+}
+void NOINLINE gemmkernel_5x2_Avx512Fp16_fp16acc_fA0fB0fC0(GemmParamsFP16* gp) {
+  gemmkernel_Avx512Fp16_fp16acc<5>(gp);
+}
+void NOINLINE gemmkernel_6x2_Avx512Fp16_fp16acc_fA0fB0fC0(GemmParamsFP16* gp) {
+  gemmkernel_Avx512Fp16_fp16acc<6>(gp);
+}
+void NOINLINE gemmkernel_7x2_Avx512Fp16_fp16acc_fA0fB0fC0(GemmParamsFP16* gp) {
+  gemmkernel_Avx512Fp16_fp16acc<7>(gp);
+}
+void NOINLINE gemmkernel_8x2_Avx512Fp16_fp16acc_fA0fB0fC0(GemmParamsFP16* gp) {
+  gemmkernel_Avx512Fp16_fp16acc<8>(gp);
+}
+void NOINLINE gemmkernel_9x2_Avx512Fp16_fp16acc_fA0fB0fC0(GemmParamsFP16* gp) {
+  gemmkernel_Avx512Fp16_fp16acc<9>(gp);
+}
+void NOINLINE gemmkernel_10x2_Avx512Fp16_fp16acc_fA0fB0fC0(GemmParamsFP16* gp) {
+  gemmkernel_Avx512Fp16_fp16acc<10>(gp);
+}
+void NOINLINE gemmkernel_11x2_Avx512Fp16_fp16acc_fA0fB0fC0(GemmParamsFP16* gp) {
+  gemmkernel_Avx512Fp16_fp16acc<11>(gp);
+}
+void NOINLINE gemmkernel_12x2_Avx512Fp16_fp16acc_fA0fB0fC0(GemmParamsFP16* gp) {
+  gemmkernel_Avx512Fp16_fp16acc<12>(gp);
+}
+void NOINLINE gemmkernel_13x2_Avx512Fp16_fp16acc_fA0fB0fC0(GemmParamsFP16* gp) {
+  gemmkernel_Avx512Fp16_fp16acc<13>(gp);
+}
+void NOINLINE gemmkernel_14x2_Avx512Fp16_fp16acc_fA0fB0fC0(GemmParamsFP16* gp) {
+  gemmkernel_Avx512Fp16_fp16acc<14>(gp);
+}
+
+} // namespace fbgemm
+
+#endif // FBGEMM_HAS_AVX512FP16_KERNELS
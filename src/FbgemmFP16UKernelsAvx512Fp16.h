@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+#include <cstdint>
+#include "fbgemm/FbgemmBuild.h"
+#include "fbgemm/FbgemmFPCommon.h"
+#include "fbgemm/Types.h"
+
+// The AVX512-FP16 intrinsics need GCC 12 or clang 14
+#if !defined(_MSC_VER) && (defined(__x86_64__) || defined(__i386__)) && \
+    ((defined(__clang__) && __clang_major__ >= 14) ||                    \
+     (!defined(__clang__) && defined(__GNUC__) && __GNUC__ >= 12))
+#define FBGEMM_HAS_AVX512FP16_KERNELS
+#endif
+
+namespace fbgemm {
+
+#ifdef FBGEMM_HAS_AVX512FP16_KERNELS
+using GemmParamsFP16 = GemmParams<float16>;
+
+// Kernels multiplying and accumulating in fp16 with AVX512-FP16, for
+// cblas_gemm_compute_fp16_acc
+void NOINLINE gemmkernel_1x2_Avx512Fp16_fp16acc_fA0fB0fC0(GemmParamsFP16* gp);
+void NOINLINE gemmkernel_2x2_Avx512Fp16_fp16acc_fA0fB0fC0(GemmParamsFP16* gp);
+void NOINLINE gemmkernel_3x2_Avx512Fp16_fp16acc_fA0fB0fC0(GemmParamsFP16* gp);
+void NOINLINE gemmkernel_4x2_Avx512Fp16_fp16acc_fA0fB0fC0(GemmParamsFP16* gp);
+void NOINLINE gemmkernel_5x2_Avx512Fp16_fp16acc_fA0fB0fC0(GemmParamsFP16* gp);
+void NOINLINE gemmkernel_6x2_Avx512Fp16_fp16acc_fA0fB0fC0(GemmParamsFP16* gp);
+void NOINLINE gemmkernel_7x2_Avx512Fp16_fp16acc_fA0fB0fC0(GemmParamsFP16* gp);
+void NOINLINE gemmkernel_8x2_Avx512Fp16_fp16acc_fA0fB0fC0(GemmParamsFP16* gp);
+void NOINLINE gemmkernel_9x2_Avx512Fp16_fp16acc_fA0fB0fC0(GemmParamsFP16* gp);
+void NOINLINE gemmkernel_10x2_Avx512Fp16_fp16acc_fA0fB0fC0(GemmParamsFP16* gp);
+void NOINLINE gemmkernel_11x2_Avx512Fp16_fp16acc_fA0fB0fC0(GemmParamsFP16* gp);
+void NOINLINE gemmkernel_12x2_Avx512Fp16_fp16acc_fA0fB0fC0(GemmParamsFP16* gp);
+void NOINLINE gemmkernel_13x2_Avx512Fp16_fp16acc_fA0fB0fC0(GemmParamsFP16* gp);
+void NOINLINE gemmkernel_14x2_Avx512Fp16_fp16acc_fA0fB0fC0(GemmParamsFP16* gp);
+#endif
+
+} // namespace fbgemm
@@ -52,6 +52,23 @@ void FloatToFloat16_simd(
   }
 }
 
+void FloatToFloat16StochasticRounding_simd(
+    const float* src,
+    float16* dst,
+    size_t size) {
+  // Run time CPU detection
+  if (cpuinfo_initialize()) {
+    // The conversion is bound by memory bandwidth so AVX512 would not help
+    if (fbgemmHasAvx2Support()) {
+      FloatToFloat16StochasticRounding_avx2(src, dst, size);
+    } else {
+      FloatToFloat16StochasticRounding_ref(src, dst, size);
+    }
+  } else {
+    throw std::runtime_error("Failed to initialize cpuinfo!");
+  }
+}
+
 void Float16ToFloat_simd(const float16* src, float* dst, size_t size) {
   // Run time CPU detection
   if (cpuinfo_initialize()) {
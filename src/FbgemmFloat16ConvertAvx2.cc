@@ -13,6 +13,10 @@
 #define FBGEMM_EXPORTS
 #include "fbgemm/FbgemmConvert.h"
 
+#include <cstring>
+
+#include "./StochasticRoundingAvx2.h"
+
 namespace fbgemm {
 
 namespace {
@@ -68,6 +72,28 @@ void FloatToFloat16_avx2(
   }
 }
 
+void FloatToFloat16StochasticRounding_avx2(
+    const float* src,
+    float16* dst,
+    size_t size) {
+  internal::StochasticRoundingAvx2 rounding;
+  size_t i = 0;
+  for (i = 0; i + 8 <= size; i += 8) {
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(dst + i),
+        rounding.toFloat16(_mm256_loadu_ps(src + i)));
+  }
+  if (i < size) {
+    float buf[8] = {};
+    float16 buf_out[8];
+    std::memcpy(buf, src + i, (size - i) * sizeof(float));
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(buf_out),
+        rounding.toFloat16(_mm256_loadu_ps(buf)));
+    std::memcpy(dst + i, buf_out, (size - i) * sizeof(float16));
+  }
+}
+
 void Float16ToFloat_avx2(const float16* src, float* dst, size_t size) {
   size_t i = 0;
   for (i = 0; i + 8 <= size; i += 8) {
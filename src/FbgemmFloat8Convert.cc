@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#define FBGEMM_EXPORTS
+#include "fbgemm/FbgemmConvert.h"
+
+#include <cpuinfo.h>
+#include <stdexcept>
+
+#include "fbgemm/Utils.h"
+
+namespace fbgemm {
+
+void FloatToFloat8_simd(
+    const float* src,
+    uint8_t* dst,
+    size_t size,
+    int exponent_bits,
+    int exponent_bias,
+    int thread_id,
+    int num_threads) {
+  std::int64_t i_begin, i_end;
+  fbgemmPartition1D(thread_id, num_threads, size, i_begin, i_end);
+  src += i_begin;
+  dst += i_begin;
+  size = i_end - i_begin;
+
+  // Run time CPU detection
+  if (cpuinfo_initialize()) {
+#ifndef __aarch64__
+    if (fbgemmHasAvx512Support()) {
+      FloatToFloat8_avx512(src, dst, size, exponent_bits, exponent_bias);
+    } else
+#endif
+        if (fbgemmHasAvx2Support()) {
+      FloatToFloat8_avx2(src, dst, size, exponent_bits, exponent_bias);
+    } else {
+      for (size_t i = 0; i < size; ++i) {
+        FloatToFloat8_ref(src[i], dst + i, exponent_bits, exponent_bias);
+      }
+    }
+  } else {
+    throw std::runtime_error("Failed to initialize cpuinfo!");
+  }
+}
+
+void Float8ToFloat_simd(
+    const uint8_t* src,
+    float* dst,
+    size_t size,
+    int exponent_bits,
+    int exponent_bias,
+    int thread_id,
+    int num_threads) {
+  std::int64_t i_begin, i_end;
+  fbgemmPartition1D(thread_id, num_threads, size, i_begin, i_end);
+  src += i_begin;
+  dst += i_begin;
+  size = i_end - i_begin;
+
+  // Run time CPU detection
+  if (cpuinfo_initialize()) {
+#ifndef __aarch64__
+    if (fbgemmHasAvx512Support()) {
+      Float8ToFloat_avx512(src, dst, size, exponent_bits, exponent_bias);
+    } else
+#endif
+        if (fbgemmHasAvx2Support()) {
+      Float8ToFloat_avx2(src, dst, size, exponent_bits, exponent_bias);
+    } else {
+      for (size_t i = 0; i < size; ++i) {
+        Float8ToFloat_ref(src[i], dst + i, exponent_bits, exponent_bias);
+      }
+    }
+  } else {
+    throw std::runtime_error("Failed to initialize cpuinfo!");
+  }
+}
+
+} // namespace fbgemm
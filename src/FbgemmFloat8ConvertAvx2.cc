@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#if defined(__x86_64__) || defined(__i386__) || \
+    (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
+#include <immintrin.h>
+#endif
+#define FBGEMM_EXPORTS
+#include "fbgemm/FbgemmConvert.h"
+
+#include "./Float8ConvertAvx2.h"
+
+namespace fbgemm {
+
+void FloatToFloat8_avx2(
+    const float* src,
+    uint8_t* dst,
+    size_t size,
+    int exponent_bits,
+    int exponent_bias) {
+  const internal::Float8ConvertAvx2 fp8(exponent_bits, exponent_bias);
+  size_t i = 0;
+  for (i = 0; i + 8 <= size; i += 8) {
+    fp8.store(dst + i, fp8.fromFloat(_mm256_loadu_ps(src + i)));
+  }
+  for (; i < size; ++i) {
+    FloatToFloat8_ref(src[i], dst + i, exponent_bits, exponent_bias);
+  }
+}
+
+void Float8ToFloat_avx2(
+    const uint8_t* src,
+    float* dst,
+    size_t size,
+    int exponent_bits,
+    int exponent_bias) {
+  const internal::Float8ConvertAvx2 fp8(exponent_bits, exponent_bias);
+  size_t i = 0;
+  for (i = 0; i + 8 <= size; i += 8) {
+    _mm256_storeu_ps(dst + i, fp8.toFloat(fp8.load(src + i)));
+  }
+  for (; i < size; ++i) {
+    Float8ToFloat_ref(src[i], dst + i, exponent_bits, exponent_bias);
+  }
+}
+
+} // namespace fbgemm
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#if defined(__x86_64__) || defined(__i386__) || \
+    (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
+#include <immintrin.h>
+#endif
+#define FBGEMM_EXPORTS
+#include "fbgemm/FbgemmConvert.h"
+
+#include <cmath>
+
+namespace fbgemm {
+
+// Same algorithm as Float8ConvertAvx2 for 16 floats at a time
+void FloatToFloat8_avx512(
+    const float* src,
+    uint8_t* dst,
+    size_t size,
+    int exponent_bits,
+    int exponent_bias) {
+  const int mantissa_bits = 7 - exponent_bits;
+  const float max_pos = (1 << ((1 << exponent_bits) - 2 - exponent_bias)) *
+      (2 - std::pow(2, exponent_bits - 7));
+  const __m512 max_pos_v = _mm512_set1_ps(max_pos);
+  const __m512 smallest_normal_v = _mm512_castsi512_ps(
+      _mm512_set1_epi32((127 - exponent_bias + 1) << 23));
+  const __m512i bouncer_exponent_v =
+      _mm512_set1_epi32((23 - mantissa_bits) << 23);
+  const __m512i exponent_rebias_v =
+      _mm512_set1_epi32((127 - exponent_bias) << 23);
+  const __m128i exponent_shift = _mm_cvtsi32_si128(8 - exponent_bits);
+  const __m512 denormal_bouncer_v = _mm512_castsi512_ps(_mm512_set1_epi32(
+      (127 + (23 + (1 - exponent_bias - mantissa_bits))) << 23));
+  const __m512i sign_mask_v = _mm512_set1_epi32(0x80000000);
+
+  size_t i = 0;
+  for (i = 0; i + 16 <= size; i += 16) {
+    const __m512i x_v = _mm512_loadu_si512(src + i);
+    const __m512i sign_v = _mm512_and_si512(x_v, sign_mask_v);
+    // NaNs become max_pos as with fminf
+    const __m512 val_v = _mm512_min_ps(
+        _mm512_castsi512_ps(_mm512_andnot_si512(sign_mask_v, x_v)),
+        max_pos_v);
+    const __m512i val_i = _mm512_castps_si512(val_v);
+
+    const __m512 bouncer_v = _mm512_castsi512_ps(_mm512_add_epi32(
+        _mm512_and_si512(val_i, _mm512_set1_epi32(0xFF800000)),
+        bouncer_exponent_v));
+    __m512i normal_v = _mm512_castps_si512(
+        _mm512_sub_ps(_mm512_add_ps(bouncer_v, val_v), bouncer_v));
+    normal_v = _mm512_sll_epi32(
+        _mm512_sub_epi32(normal_v, exponent_rebias_v), exponent_shift);
+    normal_v = _mm512_srli_epi32(_mm512_or_si512(normal_v, sign_v), 24);
+
+    __m512i denormal_v =
+        _mm512_castps_si512(_mm512_add_ps(denormal_bouncer_v, val_v));
+    denormal_v = _mm512_or_si512(denormal_v, _mm512_srli_epi32(sign_v, 24));
+
+    const __m512i out_v = _mm512_mask_blend_epi32(
+        _mm512_cmp_ps_mask(val_v, smallest_normal_v, _CMP_GE_OQ),
+        denormal_v,
+        normal_v);
+    // Truncates to the low byte of each lane
+    _mm_storeu_si128(
+        reinterpret_cast<__m128i*>(dst + i), _mm512_cvtepi32_epi8(out_v));
+  }
+  FloatToFloat8_avx2(src + i, dst + i, size - i, exponent_bits, exponent_bias);
+}
+
+void Float8ToFloat_avx512(
+    const uint8_t* src,
+    float* dst,
+    size_t size,
+    int exponent_bits,
+    int exponent_bias) {
+  const __m128i mantissa_shift = _mm_cvtsi32_si128(24 - (8 - exponent_bits));
+  const __m512 multiplier_v = _mm512_castsi512_ps(
+      _mm512_set1_epi32((127 + (127 - exponent_bias)) << 23));
+
+  size_t i = 0;
+  for (i = 0; i + 16 <= size; i += 16) {
+    const __m512i x_v = _mm512_cvtepu8_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+    const __m512i sign_v =
+        _mm512_slli_epi32(_mm512_and_si512(x_v, _mm512_set1_epi32(0x80)), 24);
+    const __m512i val_v = _mm512_sll_epi32(
+        _mm512_and_si512(x_v, _mm512_set1_epi32(0x7F)), mantissa_shift);
+    const __m512 out_v =
+        _mm512_mul_ps(_mm512_castsi512_ps(val_v), multiplier_v);
+    _mm512_storeu_ps(
+        dst + i,
+        _mm512_castsi512_ps(
+            _mm512_or_si512(_mm512_castps_si512(out_v), sign_v)));
+  }
+  Float8ToFloat_avx2(src + i, dst + i, size - i, exponent_bits, exponent_bias);
+}
+
+} // namespace fbgemm
@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#define FBGEMM_EXPORTS
+#include "fbgemm/FbgemmI4.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace fbgemm {
+
+PackBMatrixI4::PackBMatrixI4(
+    matrix_op_t trans,
+    std::int32_t nRow,
+    std::int32_t nCol,
+    const std::int8_t* smat,
+    std::int32_t ld,
+    int groups,
+    const float* scales,
+    const std::int32_t* zero_points)
+    : nRow_(nRow),
+      nCol_(nCol),
+      groups_(groups),
+      scales_(scales, scales + groups),
+      zeroPoints_(zero_points, zero_points + groups) {
+  if (groups <= 0 || nRow % groups != 0) {
+    throw std::runtime_error("k must be a multiple of the number of groups");
+  }
+  for (auto zp : zeroPoints_) {
+    if (zp < -8 || zp > 7) {
+      throw std::runtime_error("int4 zero points must be in [-8, 7]");
+    }
+  }
+  const std::int32_t group_size = groupSize();
+  groupBlocks_ = (group_size + kBlockRows - 1) / kBlockRows;
+  const std::int32_t ncols_padded = colBlocks() * kBlockCols;
+  const std::int64_t size = static_cast<std::int64_t>(colBlocks()) * groups_ *
+      groupBlocks_ * kBlockRows * kBlockCols / 2;
+  buf_ = static_cast<std::uint8_t*>(fbgemmAlignedAlloc(64, size));
+  colSums_.assign(static_cast<std::int64_t>(groups_) * ncols_padded, 0);
+
+  for (int g = 0; g < groups_; ++g) {
+    const std::int32_t zp = zeroPoints_[g];
+    std::int32_t* col_sums = colSums_.data() +
+        static_cast<std::int64_t>(g) * ncols_padded;
+    for (std::int32_t c = 0; c < ncols_padded; ++c) {
+      for (std::int32_t rb = 0; rb < groupBlocks_; ++rb) {
+        std::uint8_t* dst = block(c / kBlockCols, g, rb) + c % kBlockCols * 4;
+        for (int t = 0; t < kBlockRows; ++t) {
+          const std::int32_t r = rb * kBlockRows + t;
+          std::int32_t q = zp;
+          if (r < group_size && c < nCol_) {
+            const std::int64_t k = static_cast<std::int64_t>(g) * group_size +
+                r;
+            q = trans == matrix_op_t::Transpose ? smat[c * ld + k]
+                                                : smat[k * ld + c];
+            q = std::min(std::max(q, -8), 7);
+          }
+          col_sums[c] += q - zp;
+          const std::uint8_t nibble = q + 8;
+          if (t < 4) {
+            dst[t] = nibble;
+          } else {
+            dst[t - 4] |= nibble << 4;
+          }
+        }
+      }
+    }
+  }
+}
+
+PackBMatrixI4::~PackBMatrixI4() {
+  fbgemmAlignedFree(buf_);
+}
+
+std::int8_t PackBMatrixI4::value(std::int32_t r, std::int32_t c) const {
+  const std::int32_t g = r / groupSize();
+  const std::int32_t rg = r % groupSize();
+  const std::uint8_t byte = block(c / kBlockCols, g, rg / kBlockRows)
+      [c % kBlockCols * 4 + rg % 4];
+  const int nibble = rg % kBlockRows < 4 ? byte & 0xf : byte >> 4;
+  return nibble - 8;
+}
+
+namespace {
+
+// Same order of operations as the AVX512-VNNI kernel: exact int32 sums per
+// group, folded into fp32 with fma.
+void U8I4GemmRef(
+    int m,
+    const std::uint8_t* A,
+    int lda,
+    std::int32_t A_zero_point,
+    float A_scale,
+    const PackBMatrixI4& B,
+    const float* bias,
+    float* C,
+    int ldc,
+    int jb_begin,
+    int jb_end) {
+  const std::int32_t group_size = B.groupSize();
+  const int n_begin = jb_begin * PackBMatrixI4::kBlockCols;
+  const int n_end =
+      std::min(jb_end * PackBMatrixI4::kBlockCols, B.numCols());
+  for (int i = 0; i < m; ++i) {
+    for (int j = n_begin; j < n_end; ++j) {
+      float acc = 0.f;
+      for (int g = 0; g < B.numGroups(); ++g) {
+        std::int32_t sum = 0;
+        for (std::int32_t r = 0; r < group_size; ++r) {
+          const std::int32_t k = g * group_size + r;
+          sum += A[i * lda + k] * (B.value(k, j) - B.zeroPoints()[g]);
+        }
+        sum -= A_zero_point * B.colSums(g)[j];
+        acc = std::fma(B.scales()[g], static_cast<float>(sum), acc);
+      }
+      C[i * ldc + j] = bias ? std::fma(A_scale, acc, bias[j]) : A_scale * acc;
+    }
+  }
+}
+
+} // namespace
+
+void fbgemmU8I4Gemm(
+    int m,
+    const std::uint8_t* A,
+    int lda,
+    std::int32_t A_zero_point,
+    float A_scale,
+    const PackBMatrixI4& B,
+    const float* bias,
+    float* C,
+    int ldc,
+    int thread_id,
+    int num_threads) {
+  int64_t jb_begin, jb_end;
+  fbgemmPartition1D(thread_id, num_threads, B.colBlocks(), jb_begin, jb_end);
+  if (jb_begin >= jb_end) {
+    return;
+  }
+  static const auto iset = fbgemmInstructionSet();
+  // Run time CPU detection
+  if (iset == inst_set_t::avx512_vnni || iset == inst_set_t::avx512_vnni_ymm) {
+    internal::U8I4GemmAvx512Vnni(
+        m,
+        A,
+        lda,
+        A_zero_point,
+        A_scale,
+        B,
+        bias,
+        C,
+        ldc,
+        jb_begin,
+        jb_end);
+  } else {
+    U8I4GemmRef(
+        m,
+        A,
+        lda,
+        A_zero_point,
+        A_scale,
+        B,
+        bias,
+        C,
+        ldc,
+        jb_begin,
+        jb_end);
+  }
+}
+
+} // namespace fbgemm
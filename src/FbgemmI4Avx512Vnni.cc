@@ -0,0 +1,192 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#define FBGEMM_EXPORTS
+#include "fbgemm/FbgemmI4.h"
+
+#if defined(__x86_64__) || defined(__i386__) || \
+    (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
+#include <immintrin.h>
+#endif
+#include <algorithm>
+#include <cstring>
+
+// VNNI is only enabled in the functions using it
+#if defined(_MSC_VER) && !defined(__clang__)
+#define FBGEMM_TARGET_AVX512_VNNI
+#else
+#define FBGEMM_TARGET_AVX512_VNNI __attribute__((target("avx512vnni")))
+#endif
+
+namespace fbgemm {
+namespace internal {
+
+namespace {
+
+constexpr int kBlockRows = PackBMatrixI4::kBlockRows;
+constexpr int kBlockCols = PackBMatrixI4::kBlockCols;
+// Rows of A and column blocks of B per tile: 8 int32 and 8 fp32 sums, and
+// 4 unpacked vectors of B.
+constexpr int kMaxRows = 4;
+constexpr int kMaxColBlocks = 2;
+
+// The 8 values of A at k, as two int32 of 4 bytes each to broadcast. Values
+// past the group are multiplied with zeros but must not be read past the
+// end of A.
+inline void loadA(const std::uint8_t* A, int valid, std::int32_t a[2]) {
+  if (valid >= kBlockRows) {
+    std::memcpy(a, A, kBlockRows);
+  } else {
+    std::uint8_t tmp[kBlockRows] = {0};
+    std::memcpy(tmp, A, valid);
+    std::memcpy(a, tmp, kBlockRows);
+  }
+}
+
+// C rows [0, ROWS) and column blocks [jb, jb + NCB).
+template <int ROWS, int NCB>
+FBGEMM_TARGET_AVX512_VNNI void kernel(
+    const std::uint8_t* A,
+    int lda,
+    std::int32_t A_zero_point,
+    float A_scale,
+    const PackBMatrixI4& B,
+    const float* bias,
+    float* C,
+    int ldc,
+    int jb) {
+  const std::int32_t group_size = B.groupSize();
+  const __m512i nibble_mask = _mm512_set1_epi8(0x0f);
+  __m512 facc[ROWS][NCB];
+  for (int r = 0; r < ROWS; ++r) {
+    for (int v = 0; v < NCB; ++v) {
+      facc[r][v] = _mm512_setzero_ps();
+    }
+  }
+
+  for (int g = 0; g < B.numGroups(); ++g) {
+    // Nibbles hold value + 8; subtracting 8 + zero point gives value - zero
+    // point, which is in [-15, 15].
+    const __m512i offset = _mm512_set1_epi8(8 + B.zeroPoints()[g]);
+    const std::uint8_t* Ag = A + g * group_size;
+    __m512i acc[ROWS][NCB];
+    for (int r = 0; r < ROWS; ++r) {
+      for (int v = 0; v < NCB; ++v) {
+        acc[r][v] = _mm512_setzero_si512();
+      }
+    }
+    for (int rb = 0; rb < B.groupBlocks(); ++rb) {
+      __m512i lo[NCB], hi[NCB];
+      for (int v = 0; v < NCB; ++v) {
+        const __m512i w = _mm512_load_si512(B.block(jb + v, g, rb));
+        lo[v] = _mm512_sub_epi8(_mm512_and_si512(w, nibble_mask), offset);
+        hi[v] = _mm512_sub_epi8(
+            _mm512_and_si512(_mm512_srli_epi16(w, 4), nibble_mask), offset);
+      }
+      const int k = rb * kBlockRows;
+      for (int r = 0; r < ROWS; ++r) {
+        std::int32_t a[2];
+        loadA(Ag + r * lda + k, group_size - k, a);
+        const __m512i a_lo = _mm512_set1_epi32(a[0]);
+        const __m512i a_hi = _mm512_set1_epi32(a[1]);
+        for (int v = 0; v < NCB; ++v) {
+          acc[r][v] = _mm512_dpbusd_epi32(acc[r][v], a_lo, lo[v]);
+          acc[r][v] = _mm512_dpbusd_epi32(acc[r][v], a_hi, hi[v]);
+        }
+      }
+    }
+
+    const __m512 scale = _mm512_set1_ps(B.scales()[g]);
+    for (int v = 0; v < NCB; ++v) {
+      const __m512i zp_col_sums = _mm512_mullo_epi32(
+          _mm512_set1_epi32(A_zero_point),
+          _mm512_loadu_si512(B.colSums(g) + (jb + v) * kBlockCols));
+      for (int r = 0; r < ROWS; ++r) {
+        // The unmasked conversion trips a GCC maybe-uninitialized warning.
+        facc[r][v] = _mm512_fmadd_ps(
+            scale,
+            _mm512_maskz_cvtepi32_ps(
+                0xffff, _mm512_sub_epi32(acc[r][v], zp_col_sums)),
+            facc[r][v]);
+      }
+    }
+  }
+
+  const __m512 a_scale = _mm512_set1_ps(A_scale);
+  for (int v = 0; v < NCB; ++v) {
+    const int col = (jb + v) * kBlockCols;
+    const int valid = std::min(kBlockCols, B.numCols() - col);
+    const __mmask16 mask = (1u << valid) - 1;
+    const __m512 b = bias ? _mm512_maskz_loadu_ps(mask, bias + col)
+                          : _mm512_setzero_ps();
+    for (int r = 0; r < ROWS; ++r) {
+      _mm512_mask_storeu_ps(
+          C + r * ldc + col, mask, _mm512_fmadd_ps(a_scale, facc[r][v], b));
+    }
+  }
+}
+
+template <int NCB>
+void rows(
+    int m,
+    const std::uint8_t* A,
+    int lda,
+    std::int32_t A_zero_point,
+    float A_scale,
+    const PackBMatrixI4& B,
+    const float* bias,
+    float* C,
+    int ldc,
+    int jb) {
+  int i = 0;
+  for (; i + kMaxRows <= m; i += kMaxRows) {
+    kernel<kMaxRows, NCB>(
+        A + i * lda, lda, A_zero_point, A_scale, B, bias, C + i * ldc, ldc, jb);
+  }
+  const std::uint8_t* Ai = A + i * lda;
+  float* Ci = C + i * ldc;
+  switch (m - i) {
+    case 3:
+      kernel<3, NCB>(Ai, lda, A_zero_point, A_scale, B, bias, Ci, ldc, jb);
+      break;
+    case 2:
+      kernel<2, NCB>(Ai, lda, A_zero_point, A_scale, B, bias, Ci, ldc, jb);
+      break;
+    case 1:
+      kernel<1, NCB>(Ai, lda, A_zero_point, A_scale, B, bias, Ci, ldc, jb);
+      break;
+    default:
+      break;
+  }
+}
+
+} // namespace
+
+void U8I4GemmAvx512Vnni(
+    int m,
+    const std::uint8_t* A,
+    int lda,
+    std::int32_t A_zero_point,
+    float A_scale,
+    const PackBMatrixI4& B,
+    const float* bias,
+    float* C,
+    int ldc,
+    int jb_begin,
+    int jb_end) {
+  int jb = jb_begin;
+  for (; jb + kMaxColBlocks <= jb_end; jb += kMaxColBlocks) {
+    rows<kMaxColBlocks>(m, A, lda, A_zero_point, A_scale, B, bias, C, ldc, jb);
+  }
+  if (jb < jb_end) {
+    rows<1>(m, A, lda, A_zero_point, A_scale, B, bias, C, ldc, jb);
+  }
+}
+
+} // namespace internal
+} // namespace fbgemm
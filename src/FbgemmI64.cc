@@ -13,10 +13,14 @@
     (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
 #include <immintrin.h>
 #endif
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstring>
 #include <iostream>
 #include <vector>
 
+#include "./CodeStorage.h"
 #include "./GenerateKernel.h"
 #include "./RefImplementations.h"
 #include "fbgemm/PackingTraits-inl.h"
@@ -142,6 +146,12 @@ CodeGenBase<int64_t, int64_t, int64_t, int64_t>::getOrCreate(
       make_tuple(accum, mc, nc, nBlock, kBlock, mRegBlockSize, nRegBlockSize);
 
   return codeCache_.getOrCreate(kernelSig, [&]() -> jit_micro_kernel_fp {
+    jit_micro_kernel_fp fn;
+    const std::string jitKey = getJitCacheKey("gemm_i64", instSet, kernelSig);
+    if (loadJitKernel(runtime(), rtMutex_, jitKey, &fn)) {
+      return fn;
+    }
+
     asmjit::CodeHolder code;
     code.init(runtime().environment());
     x86::Assembler assembler(&code);
@@ -376,12 +386,7 @@ CodeGenBase<int64_t, int64_t, int64_t, int64_t>::getOrCreate(
 
     a->emitEpilog(frame);
 
-    jit_micro_kernel_fp fn;
-    asmjit::Error err;
-    {
-      unique_lock<mutex> lock(rtMutex_);
-      err = runtime().add(&fn, &code);
-    }
+    asmjit::Error err = addJitKernel(runtime(), rtMutex_, &fn, code, jitKey);
     if (err) {
       cout << "Error: in fn add" << endl;
       return nullptr;
@@ -403,32 +408,96 @@ template CodeGenBase<int64_t, int64_t, int64_t, int64_t>::jit_micro_kernel_fp
 CodeGenBase<int64_t, int64_t, int64_t, int64_t>::getOrCreate<
     inst_set_t::avx512>(bool accum, int32_t mc, int32_t nc, int32_t kc);
 
-// Expected to have overflows
-NO_SANITIZE("undefined")
-void cblas_gemm_i64_i64acc(
-    matrix_op_t transa,
-    matrix_op_t transb,
+namespace {
+
+using I64Traits = PackingTraits<int64_t, int64_t, inst_set_t::avx512>;
+
+// Copies rows [r0, r0 + nr) x columns [c0, c0 + nc) of op(src) to dst with
+// leading dimension ld_dst.
+void packI64Block(
+    matrix_op_t trans,
+    const int64_t* src,
+    int ld_src,
+    int r0,
+    int nr,
+    int c0,
+    int nc,
+    int64_t* dst,
+    int ld_dst) {
+  if (trans == matrix_op_t::NoTranspose) {
+    for (int r = 0; r < nr; ++r) {
+      memcpy(
+          dst + r * ld_dst,
+          src + static_cast<int64_t>(r0 + r) * ld_src + c0,
+          nc * sizeof(int64_t));
+    }
+  } else {
+    for (int r = 0; r < nr; ++r) {
+      for (int c = 0; c < nc; ++c) {
+        dst[r * ld_dst + c] =
+            src[(r0 + r) + static_cast<int64_t>(c0 + c) * ld_src];
+      }
+    }
+  }
+}
+
+// Rows [i_begin, i_end) and columns [j_begin, j_end) of the thread's part of
+// the M x N C, in blocks of MCB rows and NCB columns. Empty for threads
+// without work.
+void partitionI64Gemm(
     int M,
     int N,
+    int thread_id,
+    int num_threads,
+    int64_t& i_begin,
+    int64_t& i_end,
+    int64_t& j_begin,
+    int64_t& j_end) {
+  const thread_type_t th_info =
+      fbgemmGetThreadPartition(1, M, N, thread_id, num_threads, I64Traits::NCB);
+  if (th_info.m_num_threads == 0) {
+    i_begin = i_end = j_begin = j_end = 0;
+    return;
+  }
+  fbgemmPartition1DBlocked(
+      th_info.m_thread_id,
+      th_info.m_num_threads,
+      M,
+      I64Traits::MCB,
+      i_begin,
+      i_end);
+  fbgemmPartition1DBlocked(
+      th_info.n_thread_id,
+      th_info.n_num_threads,
+      N,
+      I64Traits::NCB,
+      j_begin,
+      j_end);
+}
+
+// Computes rows [i_begin, i_end) x columns [j_begin, j_end) of C with the
+// AVX512 kernel. getBBlock(kc, jc, kcb, ncb) returns the KCB x NCB block of B
+// at row kc and column jc, of which kcb x ncb are in B.
+template <typename GetBBlock>
+NO_SANITIZE("undefined")
+void gemmI64Avx512(
+    matrix_op_t transa,
     int K,
     const int64_t* A,
     int lda,
-    const int64_t* B,
-    int ldb,
+    const GetBBlock& getBBlock,
     bool accumulate,
     int64_t* C,
-    int ldc) {
-  cpuinfo_initialize();
-  if (!fbgemmHasAvx512Support()) {
-    cblas_gemm_i64_i64acc_ref(
-        transa, transb, M, N, K, A, lda, B, ldb, accumulate, C, ldc);
-    return;
-  }
-  constexpr int MCB = PackingTraits<int64_t, int64_t, inst_set_t::avx512>::MCB;
-  constexpr int NCB = PackingTraits<int64_t, int64_t, inst_set_t::avx512>::NCB;
-  constexpr int KCB = PackingTraits<int64_t, int64_t, inst_set_t::avx512>::KCB;
-  constexpr int MR = PackingTraits<int64_t, int64_t, inst_set_t::avx512>::MR;
-  constexpr int NR = PackingTraits<int64_t, int64_t, inst_set_t::avx512>::NR;
+    int ldc,
+    int i_begin,
+    int i_end,
+    int j_begin,
+    int j_end) {
+  constexpr int MCB = I64Traits::MCB;
+  constexpr int NCB = I64Traits::NCB;
+  constexpr int KCB = I64Traits::KCB;
+  constexpr int MR = I64Traits::MR;
+  constexpr int NR = I64Traits::NR;
   static_assert(MCB % MR == 0, "MR must divide MCB");
   static_assert(NCB % NR == 0, "NR must divide NCB");
   constexpr int VLEN =
@@ -445,98 +514,54 @@ void cblas_gemm_i64_i64acc(
         false /* accum */, MCB, NCB, KCB);
   }
 
-  vector<int64_t> At, Bt;
-  // TODO: handle transpose during packing
-  if (transa == matrix_op_t::Transpose) {
-    At.resize(M * K);
-    for (int i = 0; i < M; ++i) {
-      for (int k = 0; k < K; ++k) {
-        At.at(i * K + k) = A[i + k * lda];
-      }
-    }
-    A = At.data();
-    lda = K;
-  }
-  if (transb == matrix_op_t::Transpose) {
-    Bt.resize(K * N);
-    for (int k = 0; k < K; ++k) {
-      for (int j = 0; j < N; ++j) {
-        Bt.at(k * N + j) = B[k + j * ldb];
-      }
-    }
-    B = Bt.data();
-    ldb = N;
-  }
-
   alignas(64) array<int64_t, MCB * KCB> packA;
-  alignas(64) array<int64_t, KCB * NCB> packB;
   alignas(64) array<int64_t, MCB * NCB> packC;
 
-  for (int ic = 0; ic < M; ic += MCB) {
+  for (int ic = i_begin; ic < i_end; ic += MCB) {
+    const int mcb = std::min(MCB, i_end - ic);
     for (int kc = 0; kc < K; kc += KCB) {
-      // pack A
-      for (int i = 0; i < std::min(MCB, M - ic); ++i) {
-        memcpy(
-            &packA[i * KCB],
-            A + (ic + i) * lda + kc,
-            std::min(K - kc, KCB) * sizeof(int64_t));
-      }
+      const int kcb = std::min(KCB, K - kc);
+      packI64Block(transa, A, lda, ic, mcb, kc, kcb, packA.data(), KCB);
 
-      for (int jc = 0; jc < N; jc += NCB) {
-        // pack B
-        for (int i = 0; i < std::min(KCB, K - kc); ++i) {
-          memcpy(
-              &packB[i * NCB],
-              B + (kc + i) * ldb + jc,
-              std::min(NCB, N - jc) * sizeof(int64_t));
-        }
+      for (int jc = j_begin; jc < j_end; jc += NCB) {
+        const int ncb = std::min(NCB, j_end - jc);
+        const int64_t* packB = getBBlock(kc, jc, kcb, ncb);
 
-        if (M - ic >= MCB && N - jc >= NCB) {
+        if (mcb == MCB && ncb == NCB) {
           if (kc == 0 && !accumulate) {
             fn_noacc(
                 packA.data(),
-                packB.data(),
-                packB.data(),
-                C + ic * ldc + jc,
-                std::min(KCB, K - kc),
+                packB,
+                packB,
+                C + static_cast<int64_t>(ic) * ldc + jc,
+                kcb,
                 ldc);
           } else {
             fn(packA.data(),
-               packB.data(),
-               packB.data(),
-               C + ic * ldc + jc,
-               std::min(KCB, K - kc),
+               packB,
+               packB,
+               C + static_cast<int64_t>(ic) * ldc + jc,
+               kcb,
                ldc);
           }
         } else {
           // remainder
           if (kc == 0 && !accumulate) {
-            fn_noacc(
-                packA.data(),
-                packB.data(),
-                packB.data(),
-                packC.data(),
-                std::min(KCB, K - kc),
-                NCB);
+            fn_noacc(packA.data(), packB, packB, packC.data(), kcb, NCB);
           } else {
-            for (int i = 0; i < std::min(MCB, M - ic); ++i) {
+            for (int i = 0; i < mcb; ++i) {
               memcpy(
                   &packC[i * NCB],
-                  C + (ic + i) * ldc + jc,
-                  std::min(NCB, N - jc) * sizeof(int64_t));
+                  C + static_cast<int64_t>(ic + i) * ldc + jc,
+                  ncb * sizeof(int64_t));
             }
-            fn(packA.data(),
-               packB.data(),
-               packB.data(),
-               packC.data(),
-               std::min(KCB, K - kc),
-               NCB);
+            fn(packA.data(), packB, packB, packC.data(), kcb, NCB);
           }
-          for (int i = 0; i < std::min(MCB, M - ic); ++i) {
+          for (int i = 0; i < mcb; ++i) {
             memcpy(
-                C + (ic + i) * ldc + jc,
+                C + static_cast<int64_t>(ic + i) * ldc + jc,
                 &packC[i * NCB],
-                std::min(NCB, N - jc) * sizeof(int64_t));
+                ncb * sizeof(int64_t));
           }
         }
       } // jc
@@ -544,4 +569,168 @@ void cblas_gemm_i64_i64acc(
   } // ic
 }
 
+} // namespace
+
+PackedGemmMatrixI64::PackedGemmMatrixI64(
+    matrix_op_t trans,
+    int K,
+    int N,
+    const int64_t* B,
+    int ldb)
+    : nrow_(K),
+      ncol_(N),
+      brow_(I64Traits::KCB),
+      bcol_(I64Traits::NCB),
+      nbrow_((K + I64Traits::KCB - 1) / I64Traits::KCB),
+      nbcol_((N + I64Traits::NCB - 1) / I64Traits::NCB) {
+  const size_t size = static_cast<size_t>(nbrow_) * nbcol_ * brow_ * bcol_;
+  pmat_ = static_cast<int64_t*>(
+      fbgemmAlignedAlloc(64, std::max<size_t>(size, 1) * sizeof(int64_t)));
+  memset(pmat_, 0, size * sizeof(int64_t));
+  for (int kb = 0; kb < nbrow_; ++kb) {
+    for (int jb = 0; jb < nbcol_; ++jb) {
+      packI64Block(
+          trans,
+          B,
+          ldb,
+          kb * brow_,
+          std::min(brow_, K - kb * brow_),
+          jb * bcol_,
+          std::min(bcol_, N - jb * bcol_),
+          const_cast<int64_t*>(block(kb, jb)),
+          bcol_);
+    }
+  }
+}
+
+PackedGemmMatrixI64::~PackedGemmMatrixI64() {
+  fbgemmAlignedFree(pmat_);
+}
+
+// Expected to have overflows
+NO_SANITIZE("undefined")
+void cblas_gemm_i64_i64acc(
+    matrix_op_t transa,
+    matrix_op_t transb,
+    int M,
+    int N,
+    int K,
+    const int64_t* A,
+    int lda,
+    const int64_t* B,
+    int ldb,
+    bool accumulate,
+    int64_t* C,
+    int ldc,
+    int thread_id,
+    int num_threads) {
+  int64_t i_begin, i_end, j_begin, j_end;
+  partitionI64Gemm(
+      M, N, thread_id, num_threads, i_begin, i_end, j_begin, j_end);
+  if (i_begin >= i_end || j_begin >= j_end) {
+    return;
+  }
+
+  cpuinfo_initialize();
+  if (!fbgemmHasAvx512Support()) {
+    const bool ta = transa == matrix_op_t::Transpose;
+    const bool tb = transb == matrix_op_t::Transpose;
+    cblas_gemm_i64_i64acc_ref(
+        transa,
+        transb,
+        i_end - i_begin,
+        j_end - j_begin,
+        K,
+        A + (ta ? i_begin : i_begin * lda),
+        lda,
+        B + (tb ? j_begin * ldb : j_begin),
+        ldb,
+        accumulate,
+        C + i_begin * ldc + j_begin,
+        ldc);
+    return;
+  }
+
+  // Each block of B is packed again for every block of rows of A
+  alignas(64) array<int64_t, I64Traits::KCB * I64Traits::NCB> packB;
+  gemmI64Avx512(
+      transa,
+      K,
+      A,
+      lda,
+      [&](int kc, int jc, int kcb, int ncb) {
+        packI64Block(
+            transb, B, ldb, kc, kcb, jc, ncb, packB.data(), I64Traits::NCB);
+        return packB.data();
+      },
+      accumulate,
+      C,
+      ldc,
+      i_begin,
+      i_end,
+      j_begin,
+      j_end);
+}
+
+NO_SANITIZE("undefined")
+void cblas_gemm_i64_i64acc(
+    matrix_op_t transa,
+    int M,
+    const int64_t* A,
+    int lda,
+    const PackedGemmMatrixI64& Bp,
+    bool accumulate,
+    int64_t* C,
+    int ldc,
+    int thread_id,
+    int num_threads) {
+  const int N = Bp.numCols();
+  const int K = Bp.numRows();
+  int64_t i_begin, i_end, j_begin, j_end;
+  partitionI64Gemm(
+      M, N, thread_id, num_threads, i_begin, i_end, j_begin, j_end);
+  if (i_begin >= i_end || j_begin >= j_end) {
+    return;
+  }
+
+  cpuinfo_initialize();
+  if (!fbgemmHasAvx512Support()) {
+    const bool ta = transa == matrix_op_t::Transpose;
+    for (int kc = 0; kc < K; kc += Bp.blockRowSize()) {
+      for (int jc = j_begin; jc < j_end; jc += Bp.blockColSize()) {
+        cblas_gemm_i64_i64acc_ref(
+            transa,
+            matrix_op_t::NoTranspose,
+            i_end - i_begin,
+            std::min<int>(Bp.blockColSize(), j_end - jc),
+            std::min(Bp.blockRowSize(), K - kc),
+            A + (ta ? i_begin + kc * lda : i_begin * lda + kc),
+            lda,
+            Bp.block(kc / Bp.blockRowSize(), jc / Bp.blockColSize()),
+            Bp.blockColSize(),
+            accumulate || kc > 0,
+            C + i_begin * ldc + jc,
+            ldc);
+      }
+    }
+    return;
+  }
+
+  gemmI64Avx512(
+      transa,
+      K,
+      A,
+      lda,
+      [&](int kc, int jc, int /* kcb */, int /* ncb */) {
+        return Bp.block(kc / I64Traits::KCB, jc / I64Traits::NCB);
+      },
+      accumulate,
+      C,
+      ldc,
+      i_begin,
+      i_end,
+      j_begin,
+      j_end);
+}
+
 } // namespace fbgemm
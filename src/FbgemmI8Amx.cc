@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#define FBGEMM_EXPORTS
+#include "./FbgemmI8Amx.h"
+
+#if defined(__x86_64__) || defined(__i386__) || \
+    (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
+#include <immintrin.h>
+#endif
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <vector>
+
+// AMX is only enabled in the tile kernels
+#if defined(_MSC_VER) && !defined(__clang__)
+#define FBGEMM_TARGET_AMX_INT8
+#else
+#define FBGEMM_TARGET_AMX_INT8 __attribute__((target("amx-tile,amx-int8")))
+#endif
+
+namespace fbgemm {
+
+namespace {
+
+// A tile is at most 16 rows of 64 bytes: 16 rows x 64 k of A, 16 groups of
+// 4 k x 16 columns of B and 16 x 16 int32 of C.
+constexpr int kTileRows = 16;
+constexpr int kTileK = 64;
+constexpr int kTileN = 16;
+// C tiles per pass over k. tmm0-2 hold C, tmm3 A and tmm4-6 B.
+constexpr int kMaxNTiles = 3;
+
+struct alignas(64) TileConfig {
+  std::uint8_t palette_id;
+  std::uint8_t start_row;
+  std::uint8_t reserved[14];
+  std::uint16_t colsb[16];
+  std::uint8_t rows[16];
+};
+
+FBGEMM_TARGET_AMX_INT8 void configureTiles(int rows) {
+  TileConfig cfg;
+  std::memset(&cfg, 0, sizeof(cfg));
+  cfg.palette_id = 1;
+  for (int t = 0; t < kMaxNTiles; ++t) {
+    cfg.colsb[t] = kTileN * sizeof(std::int32_t);
+    cfg.rows[t] = rows;
+  }
+  cfg.colsb[kMaxNTiles] = kTileK;
+  cfg.rows[kMaxNTiles] = rows;
+  for (int t = kMaxNTiles + 1; t < 2 * kMaxNTiles + 1; ++t) {
+    cfg.colsb[t] = kTileN * 4;
+    cfg.rows[t] = kTileK / 4;
+  }
+  _tile_loadconfig(&cfg);
+}
+
+// Accumulates 64 k of A (tmm3) times NUM_N_TILES tiles of B into tmm0-2.
+template <int NUM_N_TILES>
+FBGEMM_TARGET_AMX_INT8 inline void dotTiles(
+    const std::uint8_t* a,
+    int lda,
+    const std::int8_t* b,
+    int ldb) {
+  _tile_loadd(3, a, lda);
+  _tile_loadd(4, b, ldb);
+  _tile_dpbusd(0, 3, 4);
+  if constexpr (NUM_N_TILES > 1) {
+    _tile_loadd(5, b + kTileN * 4, ldb);
+    _tile_dpbusd(1, 3, 5);
+  }
+  if constexpr (NUM_N_TILES > 2) {
+    _tile_loadd(6, b + 2 * kTileN * 4, ldb);
+    _tile_dpbusd(2, 3, 6);
+  }
+}
+
+// Computes up to 16 rows x NUM_N_TILES * 16 columns of C. The last kc % 64
+// of k come from the zero padded copies a_tail and b_tail.
+template <int NUM_N_TILES>
+FBGEMM_TARGET_AMX_INT8 void computeTileRow(
+    const std::uint8_t* A,
+    int lda,
+    const std::int8_t* B,
+    int ldb,
+    std::int32_t* C,
+    int ldc,
+    int kc,
+    bool accum,
+    const std::uint8_t* a_tail,
+    const std::int8_t* b_tail,
+    int ldb_tail) {
+  const int ldc_bytes = ldc * sizeof(std::int32_t);
+  if (accum) {
+    _tile_loadd(0, C, ldc_bytes);
+    if constexpr (NUM_N_TILES > 1) {
+      _tile_loadd(1, C + kTileN, ldc_bytes);
+    }
+    if constexpr (NUM_N_TILES > 2) {
+      _tile_loadd(2, C + 2 * kTileN, ldc_bytes);
+    }
+  } else {
+    _tile_zero(0);
+    if constexpr (NUM_N_TILES > 1) {
+      _tile_zero(1);
+    }
+    if constexpr (NUM_N_TILES > 2) {
+      _tile_zero(2);
+    }
+  }
+
+  const int k_full = kc / kTileK * kTileK;
+  for (int k = 0; k < k_full; k += kTileK) {
+    dotTiles<NUM_N_TILES>(A + k, lda, B + k / 4 * ldb, ldb);
+  }
+  if (k_full < kc) {
+    dotTiles<NUM_N_TILES>(a_tail, kTileK, b_tail, ldb_tail);
+  }
+
+  _tile_stored(0, C, ldc_bytes);
+  if constexpr (NUM_N_TILES > 1) {
+    _tile_stored(1, C + kTileN, ldc_bytes);
+  }
+  if constexpr (NUM_N_TILES > 2) {
+    _tile_stored(2, C + 2 * kTileN, ldc_bytes);
+  }
+}
+
+} // namespace
+
+FBGEMM_TARGET_AMX_INT8 void gemmKernelU8S8S32ACC32Amx(
+    const std::uint8_t* A,
+    int lda,
+    const std::int8_t* B,
+    int ldb,
+    std::int32_t* C,
+    int ldc,
+    int mc,
+    int nc,
+    int kc,
+    bool accum) {
+  assert(nc % kTileN == 0 && "nc must be a multiple of 16");
+  assert(kc % 4 == 0 && "kc must be a multiple of 4");
+
+  // Tile loads read whole rows of 64 k, so the remainder of k is copied
+  // into zero padded buffers: B once per call and A once per row tile.
+  const int k_full = kc / kTileK * kTileK;
+  const int k_tail = kc - k_full;
+  static thread_local std::vector<std::uint8_t> a_tail;
+  static thread_local std::vector<std::int8_t> b_tail;
+  const int ldb_tail = nc * 4;
+  if (k_tail) {
+    a_tail.assign(kTileRows * kTileK, 0);
+    b_tail.assign(kTileK / 4 * ldb_tail, 0);
+    for (int r = 0; r < k_tail / 4; ++r) {
+      std::memcpy(
+          b_tail.data() + r * ldb_tail,
+          B + (k_full / 4 + r) * ldb,
+          ldb_tail);
+    }
+  }
+
+  int configured_rows = 0;
+  for (int i = 0; i < mc; i += kTileRows) {
+    const int rows = std::min(kTileRows, mc - i);
+    if (rows != configured_rows) {
+      // Loading a configuration zeroes the tiles, so this is only done
+      // between row tiles.
+      configureTiles(rows);
+      configured_rows = rows;
+    }
+    if (k_tail) {
+      for (int r = 0; r < rows; ++r) {
+        std::memcpy(
+            a_tail.data() + r * kTileK,
+            A + static_cast<std::int64_t>(i + r) * lda + k_full,
+            k_tail);
+      }
+    }
+    for (int j = 0; j < nc; j += kMaxNTiles * kTileN) {
+      const std::uint8_t* a = A + static_cast<std::int64_t>(i) * lda;
+      const std::int8_t* b = B + j * 4;
+      std::int32_t* c = C + static_cast<std::int64_t>(i) * ldc + j;
+      const std::int8_t* bt = b_tail.data() + j * 4;
+      switch (std::min((nc - j) / kTileN, kMaxNTiles)) {
+        case 1:
+          computeTileRow<1>(
+              a, lda, b, ldb, c, ldc, kc, accum, a_tail.data(), bt, ldb_tail);
+          break;
+        case 2:
+          computeTileRow<2>(
+              a, lda, b, ldb, c, ldc, kc, accum, a_tail.data(), bt, ldb_tail);
+          break;
+        default:
+          computeTileRow<3>(
+              a, lda, b, ldb, c, ldc, kc, accum, a_tail.data(), bt, ldb_tail);
+          break;
+      }
+    }
+  }
+  _tile_release();
+}
+
+} // namespace fbgemm
@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include "fbgemm/FbgemmBuild.h"
+
+namespace fbgemm {
+
+/**
+ * @brief uint8 x int8 -> int32 macro-kernel on AMX tiles (tdpbusd), used in
+ * place of the AVX512-VNNI JIT kernel when fbgemmHasAmxInt8Support().
+ *
+ * A and B are in the layout packed for avx512_vnni, which already is the AMX
+ * tile layout: A is row major with leading dimension lda (KCB), and B keeps
+ * groups of 4 consecutive k for each column, so a block row of 4 k is one
+ * tile row of ldb (NCB * 4) bytes.
+ *
+ * @param mc number of rows of A and C
+ * @param nc number of columns of C, a multiple of 16
+ * @param kc number of columns of A, a multiple of 4
+ * @param accum if true, adds to C instead of overwriting it
+ */
+FBGEMM_API void gemmKernelU8S8S32ACC32Amx(
+    const std::uint8_t* A,
+    int lda,
+    const std::int8_t* B,
+    int ldb,
+    std::int32_t* C,
+    int ldc,
+    int mc,
+    int nc,
+    int kc,
+    bool accum);
+
+} // namespace fbgemm
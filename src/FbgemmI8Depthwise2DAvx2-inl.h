@@ -16,6 +16,12 @@
 
 namespace fbgemm {
 
+// Returns how many of the S filter taps, dilation input pixels apart, read
+// the overhang input pixels past the border, i.e., fall into the padding.
+static inline int numSkippedTaps(int overhang, int dilation, int S) {
+  return std::min(std::max((overhang + dilation - 1) / dilation, 0), S);
+}
+
 template <
     int S,
     bool FUSE_RELU,
@@ -33,6 +39,8 @@ static ALWAYS_INLINE void depthwise_2d_kernel_(
     int w,
     int stride_h,
     int stride_w,
+    int dilation_h,
+    int dilation_w,
     std::int32_t A_zero_point,
     const std::uint8_t* A,
     const std::int32_t* B_zero_point,
@@ -46,8 +54,9 @@ static ALWAYS_INLINE void depthwise_2d_kernel_(
     const BIAS_TYPE* bias,
     const float* act_times_w_scale,
     GenI8Depthwise::jit_kernel_signature* pregenerated_kernel = nullptr) {
-  constexpr int PAD_T = (S - 1) / 2, PAD_L = (S - 1) / 2, PAD_R = (S - 1) / 2;
-  int W_OUT = (W + PAD_L + PAD_R - S) / stride_w + 1;
+  const int PAD_T = dilation_h * (S - 1) / 2, PAD_L = dilation_w * (S - 1) / 2,
+            PAD_R = PAD_L;
+  int W_OUT = (W + PAD_L + PAD_R - dilation_w * (S - 1) - 1) / stride_w + 1;
   int h_in = -PAD_T + h * stride_h;
   int w_in = -PAD_L + w * stride_w;
 
@@ -66,10 +75,13 @@ static ALWAYS_INLINE void depthwise_2d_kernel_(
             remainder,
             0,
             0,
-            /*top_skip=*/std::max(-h_in, 0),
-            /*bottom_skip=*/std::max(h_in + S - H, 0),
-            /*left_skip=*/std::max(-w_in, 0),
-            /*right_skip=*/std::max(w_in + S - W, 0));
+            /*top_skip=*/numSkippedTaps(-h_in, dilation_h, S),
+            /*bottom_skip=*/
+            numSkippedTaps(h_in + dilation_h * (S - 1) + 1 - H, dilation_h, S),
+            /*left_skip=*/numSkippedTaps(-w_in, dilation_w, S),
+            /*right_skip=*/
+            numSkippedTaps(w_in + dilation_w * (S - 1) + 1 - W, dilation_w, S),
+            {1, dilation_h, dilation_w});
 
   kernel(
       A + (h_in * W + w_in) * IC,
@@ -131,6 +143,8 @@ static ALWAYS_INLINE void depthwise_2d_(
     int OC,
     int stride_h,
     int stride_w,
+    int dilation_h,
+    int dilation_w,
     std::int32_t A_zero_point,
     const std::uint8_t* A,
     const std::int32_t* B_zero_point,
@@ -146,10 +160,10 @@ static ALWAYS_INLINE void depthwise_2d_(
     int num_threads) {
   assert(IC % 8 == 0);
   constexpr int R = S;
-  constexpr int64_t PAD_T = (R - 1) / 2, PAD_B = PAD_T, PAD_L = (S - 1) / 2,
-                    PAD_R = PAD_L;
-  int H_OUT = (H + PAD_T + PAD_B - R) / stride_h + 1;
-  int W_OUT = (W + PAD_L + PAD_R - S) / stride_w + 1;
+  const int64_t PAD_T = dilation_h * (R - 1) / 2, PAD_B = PAD_T,
+                PAD_L = dilation_w * (S - 1) / 2, PAD_R = PAD_L;
+  int H_OUT = (H + PAD_T + PAD_B - dilation_h * (R - 1) - 1) / stride_h + 1;
+  int W_OUT = (W + PAD_L + PAD_R - dilation_w * (S - 1) - 1) / stride_w + 1;
   const std::int8_t* Bp = B.PackedMat();
 
   int32_t* row_offsets = static_cast<int32_t*>(
@@ -196,6 +210,8 @@ static ALWAYS_INLINE void depthwise_2d_(
             w,
             stride_h,
             stride_w,
+            dilation_h,
+            dilation_w,
             A_zero_point,
             A_base,
             B_zero_point,
@@ -226,6 +242,8 @@ static ALWAYS_INLINE void depthwise_2d_(
             w,
             stride_h,
             stride_w,
+            dilation_h,
+            dilation_w,
             A_zero_point,
             A_base,
             B_zero_point,
@@ -256,6 +274,8 @@ static ALWAYS_INLINE void depthwise_2d_(
             w,
             stride_h,
             stride_w,
+            dilation_h,
+            dilation_w,
             A_zero_point,
             A_base,
             B_zero_point,
@@ -300,6 +320,8 @@ static ALWAYS_INLINE void depthwise_2d_(
             w,
             stride_h,
             stride_w,
+            dilation_h,
+            dilation_w,
             A_zero_point,
             A_base,
             B_zero_point,
@@ -331,7 +353,8 @@ static ALWAYS_INLINE void depthwise_2d_(
               0,
               0,
               0,
-              0);
+              0,
+              {1, dilation_h, dilation_w});
         }
         depthwise_2d_kernel_<
             S,
@@ -348,6 +371,8 @@ static ALWAYS_INLINE void depthwise_2d_(
             w,
             stride_h,
             stride_w,
+            dilation_h,
+            dilation_w,
             A_zero_point,
             A_base,
             B_zero_point,
@@ -379,6 +404,8 @@ static ALWAYS_INLINE void depthwise_2d_(
             w,
             stride_h,
             stride_w,
+            dilation_h,
+            dilation_w,
             A_zero_point,
             A_base,
             B_zero_point,
@@ -411,6 +438,8 @@ static ALWAYS_INLINE void depthwise_2d_(
             w,
             stride_h,
             stride_w,
+            dilation_h,
+            dilation_w,
             A_zero_point,
             A_base,
             B_zero_point,
@@ -441,6 +470,8 @@ static ALWAYS_INLINE void depthwise_2d_(
             w,
             stride_h,
             stride_w,
+            dilation_h,
+            dilation_w,
             A_zero_point,
             A_base,
             B_zero_point,
@@ -471,6 +502,8 @@ static ALWAYS_INLINE void depthwise_2d_(
             w,
             stride_h,
             stride_w,
+            dilation_h,
+            dilation_w,
             A_zero_point,
             A_base,
             B_zero_point,
@@ -505,6 +538,8 @@ static void depthwise_2d_(
     int OC,
     int stride_h,
     int stride_w,
+    int dilation_h,
+    int dilation_w,
     std::int32_t A_zero_point,
     const std::uint8_t* A,
     const std::int32_t* B_zero_point,
@@ -535,6 +570,8 @@ static void depthwise_2d_(
           OC,
           stride_h,
           stride_w,
+          dilation_h,
+          dilation_w,
           A_zero_point,
           A,
           B_zero_point,
@@ -563,6 +600,8 @@ static void depthwise_2d_(
           OC,
           stride_h,
           stride_w,
+          dilation_h,
+          dilation_w,
           A_zero_point,
           A,
           B_zero_point,
@@ -593,6 +632,8 @@ static void depthwise_2d_(
           OC,
           stride_h,
           stride_w,
+          dilation_h,
+          dilation_w,
           A_zero_point,
           A,
           B_zero_point,
@@ -621,6 +662,8 @@ static void depthwise_2d_(
           OC,
           stride_h,
           stride_w,
+          dilation_h,
+          dilation_w,
           A_zero_point,
           A,
           B_zero_point,
@@ -653,6 +696,8 @@ static void depthwise_2d_(
     int OC,
     int stride_h,
     int stride_w,
+    int dilation_h,
+    int dilation_w,
     std::int32_t A_zero_point,
     const std::uint8_t* A,
     const std::int32_t* B_zero_point,
@@ -674,6 +719,8 @@ static void depthwise_2d_(
         OC,
         stride_h,
         stride_w,
+        dilation_h,
+        dilation_w,
         A_zero_point,
         A,
         B_zero_point,
@@ -695,6 +742,8 @@ static void depthwise_2d_(
         OC,
         stride_h,
         stride_w,
+        dilation_h,
+        dilation_w,
         A_zero_point,
         A,
         B_zero_point,
@@ -40,7 +40,9 @@ void depthwise_2d_same_pad(
     bool fuse_relu,
     const float* act_times_w_scale,
     int thread_id,
-    int num_threads) {
+    int num_threads,
+    int dilation_h,
+    int dilation_w) {
   if (B.GetKernelProduct() == 3 * 3) {
     if (fuse_relu) {
       depthwise_2d_<3, true /* FUSE_RELU */, Q_GRAN>(
@@ -51,6 +53,8 @@ void depthwise_2d_same_pad(
           OC,
           stride_h,
           stride_w,
+          dilation_h,
+          dilation_w,
           A_zero_point,
           A,
           B_zero_point,
@@ -72,6 +76,8 @@ void depthwise_2d_same_pad(
           OC,
           stride_h,
           stride_w,
+          dilation_h,
+          dilation_w,
           A_zero_point,
           A,
           B_zero_point,
@@ -98,6 +104,8 @@ void depthwise_2d_same_pad(
           OC,
           stride_h,
           stride_w,
+          dilation_h,
+          dilation_w,
           A_zero_point,
           A,
           B_zero_point,
@@ -119,6 +127,8 @@ void depthwise_2d_same_pad(
           OC,
           stride_h,
           stride_w,
+          dilation_h,
+          dilation_w,
           A_zero_point,
           A,
           B_zero_point,
@@ -151,6 +161,8 @@ void depthwise_2d_same_pad(
         OC,
         stride_h,
         stride_w,
+        dilation_h,
+        dilation_w,
         A_zero_point,
         A,
         B_zero_point,
@@ -172,6 +184,8 @@ void depthwise_2d_same_pad(
         OC,
         stride_h,
         stride_w,
+        dilation_h,
+        dilation_w,
         A_zero_point,
         A,
         B_zero_point,
@@ -209,7 +223,9 @@ void depthwise_2d_same_pad(
       bool fuse_relu,                                     \
       const float* act_times_w_scale,                     \
       int thread_id,                                      \
-      int num_threads);
+      int num_threads,                                    \
+      int dilation_h,                                     \
+      int dilation_w);
 
 #define INSTANTIATE_BIAS_T(Q_GRAN)  \
   INSTANTIATE_BASE(Q_GRAN, int32_t) \
@@ -0,0 +1,217 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#define FBGEMM_EXPORTS
+#include "./DirectConv.h"
+
+#include <immintrin.h>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "./MaskAvx2.h"
+#include "./OptimizedKernelsAvx2.h"
+
+namespace fbgemm {
+
+namespace {
+
+// Computes ROWS output pixels x (8 * NCB) output channels. a_ptrs holds, for
+// each of the ROWS pixels, the filter_prod input pixels its window reads; a
+// pixel in the padding points to a buffer filled with the A zero point. B
+// points to the first 8-channel block in W[oc/8][f][ic/4][8][4] layout.
+template <int ROWS, int NCB>
+inline void directConvBlockAvx2(
+    const std::uint8_t* const* a_ptrs,
+    int filter_prod,
+    int IC,
+    int IC_padded,
+    const std::int8_t* B,
+    std::int32_t* C,
+    int ldc,
+    int oc_remainder) {
+  const __m256i ones = _mm256_set1_epi16(1);
+  const int ic_full = IC / 4 * 4;
+  const int b_block_stride = filter_prod * IC_padded * 8;
+
+  __m256i acc[ROWS][NCB];
+  for (int r = 0; r < ROWS; ++r) {
+    for (int j = 0; j < NCB; ++j) {
+      acc[r][j] = _mm256_setzero_si256();
+    }
+  }
+
+  for (int f = 0; f < filter_prod; ++f) {
+    const std::int8_t* Bf = B + f * IC_padded * 8;
+    for (int c = 0; c < ic_full; c += 4) {
+      __m256i b[NCB];
+      for (int j = 0; j < NCB; ++j) {
+        b[j] = _mm256_load_si256(
+            reinterpret_cast<const __m256i*>(Bf + j * b_block_stride + c * 8));
+      }
+      for (int r = 0; r < ROWS; ++r) {
+        std::int32_t a_quad;
+        std::memcpy(&a_quad, a_ptrs[r * filter_prod + f] + c, sizeof(a_quad));
+        __m256i a = _mm256_set1_epi32(a_quad);
+        for (int j = 0; j < NCB; ++j) {
+          acc[r][j] = _mm256_add_epi32(
+              acc[r][j],
+              _mm256_madd_epi16(_mm256_maddubs_epi16(a, b[j]), ones));
+        }
+      }
+    }
+    if (ic_full < IC) {
+      // The weights of the padded input channels are zero, so only the
+      // activations need to stay within the pixel.
+      __m256i b[NCB];
+      for (int j = 0; j < NCB; ++j) {
+        b[j] = _mm256_load_si256(reinterpret_cast<const __m256i*>(
+            Bf + j * b_block_stride + ic_full * 8));
+      }
+      for (int r = 0; r < ROWS; ++r) {
+        std::int32_t a_quad = 0;
+        std::memcpy(
+            &a_quad, a_ptrs[r * filter_prod + f] + ic_full, IC - ic_full);
+        __m256i a = _mm256_set1_epi32(a_quad);
+        for (int j = 0; j < NCB; ++j) {
+          acc[r][j] = _mm256_add_epi32(
+              acc[r][j],
+              _mm256_madd_epi16(_mm256_maddubs_epi16(a, b[j]), ones));
+        }
+      }
+    }
+  }
+
+  for (int r = 0; r < ROWS; ++r) {
+    for (int j = 0; j < NCB; ++j) {
+      std::int32_t* c_ptr = C + r * ldc + j * 8;
+      if (j == NCB - 1 && oc_remainder) {
+        __m256i mask = _mm256_load_si256(reinterpret_cast<const __m256i*>(
+            internal::avx2_ps_or_epi32_masks[oc_remainder]));
+        _mm256_maskstore_epi32(c_ptr, mask, acc[r][j]);
+      } else {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(c_ptr), acc[r][j]);
+      }
+    }
+  }
+}
+
+template <int ROWS>
+inline void directConvBlockAvx2(
+    int num_col_blocks,
+    const std::uint8_t* const* a_ptrs,
+    int filter_prod,
+    int IC,
+    int IC_padded,
+    const std::int8_t* B,
+    std::int32_t* C,
+    int ldc,
+    int oc_remainder) {
+  if (num_col_blocks == 2) {
+    directConvBlockAvx2<ROWS, 2>(
+        a_ptrs, filter_prod, IC, IC_padded, B, C, ldc, oc_remainder);
+  } else {
+    directConvBlockAvx2<ROWS, 1>(
+        a_ptrs, filter_prod, IC, IC_padded, B, C, ldc, oc_remainder);
+  }
+}
+
+} // namespace
+
+void directConvAvx2(
+    const conv_param_t<2>& conv_p,
+    const std::uint8_t* A,
+    std::int32_t A_zero_point,
+    const PackedDirectConvMatrix& B,
+    int row_begin,
+    int row_end,
+    std::int32_t* C,
+    std::int32_t* row_offsets) {
+  constexpr int kRows = 6;
+
+  const int IC = conv_p.IC;
+  const int OC = conv_p.OC;
+  const int IH = conv_p.IN_DIM[0];
+  const int IW = conv_p.IN_DIM[1];
+  const int OH = conv_p.OUT_DIM[0];
+  const int OW = conv_p.OUT_DIM[1];
+  const int KH = conv_p.K[0];
+  const int KW = conv_p.K[1];
+  const int filter_prod = KH * KW;
+  const int IC_padded = B.ICPadded();
+  const int OC_padded = B.OCPadded();
+
+  std::vector<std::uint8_t> zero_pixel(
+      IC_padded, static_cast<std::uint8_t>(A_zero_point));
+  std::vector<const std::uint8_t*> a_ptrs(OW * filter_prod);
+  const std::int32_t zero_pixel_sum = reduceAvx2(zero_pixel.data(), IC);
+
+  for (int row = row_begin; row < row_end; ++row) {
+    const int n = row / OH;
+    const int oh = row % OH;
+    std::int32_t* C_row = C + (row - row_begin) * OW * OC;
+    std::int32_t* row_offsets_row = row_offsets + (row - row_begin) * OW;
+
+    // Gather the input pixels of every output pixel in the row and their
+    // sums over the whole filter window.
+    for (int ow = 0; ow < OW; ++ow) {
+      std::int32_t sum = 0;
+      for (int r = 0; r < KH; ++r) {
+        const int ih =
+            oh * conv_p.stride[0] - conv_p.pad[0] + r * conv_p.dilation[0];
+        for (int s = 0; s < KW; ++s) {
+          const int iw =
+              ow * conv_p.stride[1] - conv_p.pad[1] + s * conv_p.dilation[1];
+          const std::uint8_t* a_ptr;
+          if (ih < 0 || ih >= IH || iw < 0 || iw >= IW) {
+            a_ptr = zero_pixel.data();
+            sum += zero_pixel_sum;
+          } else {
+            a_ptr = A + ((n * IH + ih) * IW + iw) * IC;
+            sum += reduceAvx2(a_ptr, IC);
+          }
+          a_ptrs[ow * filter_prod + r * KW + s] = a_ptr;
+        }
+      }
+      row_offsets_row[ow] = sum;
+    }
+
+    for (int k = 0; k < OC_padded; k += 16) {
+      const int num_col_blocks = std::min(OC_padded - k, 16) / 8;
+      const int oc_remainder = k + num_col_blocks * 8 > OC ? OC % 8 : 0;
+      const std::int8_t* B_k = B.PackedMat() + k * filter_prod * IC_padded;
+      int ow = 0;
+      for (; ow + kRows <= OW; ow += kRows) {
+        directConvBlockAvx2<kRows>(
+            num_col_blocks,
+            a_ptrs.data() + ow * filter_prod,
+            filter_prod,
+            IC,
+            IC_padded,
+            B_k,
+            C_row + ow * OC + k,
+            OC,
+            oc_remainder);
+      }
+      for (; ow < OW; ++ow) {
+        directConvBlockAvx2<1>(
+            num_col_blocks,
+            a_ptrs.data() + ow * filter_prod,
+            filter_prod,
+            IC,
+            IC_padded,
+            B_k,
+            C_row + ow * OC + k,
+            OC,
+            oc_remainder);
+      }
+    }
+  }
+}
+
+} // namespace fbgemm
@@ -0,0 +1,310 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#define FBGEMM_EXPORTS
+#include "./FbgemmI8Neon.h"
+
+#include <algorithm>
+#include <cassert>
+#include "fbgemm/Utils.h"
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+
+// The library is built for the baseline armv8-a, so i8mm is enabled per
+// function.
+#if defined(__clang__)
+#define FBGEMM_TARGET_I8MM __attribute__((target("i8mm")))
+#else
+#define FBGEMM_TARGET_I8MM __attribute__((target("arch=armv8.2-a+i8mm")))
+#endif
+#endif
+
+namespace fbgemm {
+
+namespace {
+
+void gemmKernelRef(
+    const std::uint8_t* A,
+    int lda,
+    const std::int8_t* B,
+    int ldb,
+    int row_interleave,
+    std::int32_t* C,
+    int ldc,
+    int mc,
+    int nc,
+    int kc,
+    bool accum) {
+  for (int i = 0; i < mc; ++i) {
+    const std::uint8_t* a = A + static_cast<std::int64_t>(i) * lda;
+    std::int32_t* c = C + static_cast<std::int64_t>(i) * ldc;
+    for (int j = 0; j < nc; ++j) {
+      std::int32_t sum = accum ? c[j] : 0;
+      for (int k = 0; k < kc; ++k) {
+        sum += static_cast<std::int32_t>(a[k]) *
+            B[k / row_interleave * ldb + j * row_interleave +
+              k % row_interleave];
+      }
+      c[j] = sum;
+    }
+  }
+}
+
+#if defined(__aarch64__)
+
+// usmmla multiplies a 2x8 block of A (two rows of 8 k) by an 8x2 block of B
+// (two columns of 8 k), which is exactly what a packed B with
+// row_interleave 8 holds in 16 consecutive bytes.
+constexpr int kNeonRowInterleave = 8;
+// 8 rows x 8 columns of C per block, in 16 accumulators of 2x2.
+constexpr int kBlockRowPairs = 4;
+constexpr int kBlockColPairs = 4;
+
+// Computes 2 * ROW_PAIRS rows x 8 columns of C. When rows is odd the last
+// row of A is paired with a row of zeros and only its first half is stored.
+template <int ROW_PAIRS>
+FBGEMM_TARGET_I8MM void computeBlockI8mm(
+    const std::uint8_t* A,
+    int lda,
+    const std::int8_t* B,
+    int ldb,
+    std::int32_t* C,
+    int ldc,
+    int rows,
+    int kc,
+    bool accum) {
+  static const std::uint8_t zero_row[kNeonRowInterleave] = {};
+  const std::uint8_t* a_rows[2 * ROW_PAIRS];
+  for (int r = 0; r < 2 * ROW_PAIRS; ++r) {
+    a_rows[r] = r < rows ? A + static_cast<std::int64_t>(r) * lda : nullptr;
+  }
+
+  int32x4_t acc[ROW_PAIRS][kBlockColPairs];
+  for (int p = 0; p < ROW_PAIRS; ++p) {
+    for (int q = 0; q < kBlockColPairs; ++q) {
+      acc[p][q] = vdupq_n_s32(0);
+    }
+  }
+
+  for (int k = 0; k < kc; k += kNeonRowInterleave) {
+    const std::int8_t* b = B + k / kNeonRowInterleave * ldb;
+    int8x16_t bv[kBlockColPairs];
+    for (int q = 0; q < kBlockColPairs; ++q) {
+      bv[q] = vld1q_s8(b + q * 2 * kNeonRowInterleave);
+    }
+    for (int p = 0; p < ROW_PAIRS; ++p) {
+      const std::uint8_t* a1 = a_rows[2 * p + 1];
+      const uint8x16_t av = vcombine_u8(
+          vld1_u8(a_rows[2 * p] + k), vld1_u8(a1 ? a1 + k : zero_row));
+      for (int q = 0; q < kBlockColPairs; ++q) {
+        acc[p][q] = vusmmlaq_s32(acc[p][q], av, bv[q]);
+      }
+    }
+  }
+
+  // Each accumulator is [c(i, j), c(i, j + 1), c(i + 1, j), c(i + 1, j + 1)].
+  for (int p = 0; p < ROW_PAIRS; ++p) {
+    for (int half = 0; half < 2 && 2 * p + half < rows; ++half) {
+      std::int32_t* c = C + static_cast<std::int64_t>(2 * p + half) * ldc;
+      for (int q = 0; q < kBlockColPairs; q += 2) {
+        int32x4_t v = half == 0
+            ? vcombine_s32(vget_low_s32(acc[p][q]), vget_low_s32(acc[p][q + 1]))
+            : vcombine_s32(
+                  vget_high_s32(acc[p][q]), vget_high_s32(acc[p][q + 1]));
+        if (accum) {
+          v = vaddq_s32(v, vld1q_s32(c + 2 * q));
+        }
+        vst1q_s32(c + 2 * q, v);
+      }
+    }
+  }
+}
+
+FBGEMM_TARGET_I8MM void gemmKernelI8mm(
+    const std::uint8_t* A,
+    int lda,
+    const std::int8_t* B,
+    int ldb,
+    std::int32_t* C,
+    int ldc,
+    int mc,
+    int nc,
+    int kc,
+    bool accum) {
+  constexpr int block_rows = 2 * kBlockRowPairs;
+  constexpr int block_cols = 2 * kBlockColPairs;
+  const int nc_full = nc / block_cols * block_cols;
+  for (int i = 0; i < mc; i += block_rows) {
+    const int rows = std::min(block_rows, mc - i);
+    const std::uint8_t* a = A + static_cast<std::int64_t>(i) * lda;
+    std::int32_t* c = C + static_cast<std::int64_t>(i) * ldc;
+    for (int j = 0; j < nc_full; j += block_cols) {
+      const std::int8_t* b = B + j * kNeonRowInterleave;
+      switch ((rows + 1) / 2) {
+        case 1:
+          computeBlockI8mm<1>(a, lda, b, ldb, c + j, ldc, rows, kc, accum);
+          break;
+        case 2:
+          computeBlockI8mm<2>(a, lda, b, ldb, c + j, ldc, rows, kc, accum);
+          break;
+        case 3:
+          computeBlockI8mm<3>(a, lda, b, ldb, c + j, ldc, rows, kc, accum);
+          break;
+        default:
+          computeBlockI8mm<4>(a, lda, b, ldb, c + j, ldc, rows, kc, accum);
+          break;
+      }
+    }
+  }
+  if (nc_full < nc) {
+    gemmKernelRef(
+        A,
+        lda,
+        B + nc_full * kNeonRowInterleave,
+        ldb,
+        kNeonRowInterleave,
+        C + nc_full,
+        ldc,
+        mc,
+        nc - nc_full,
+        kc,
+        accum);
+  }
+}
+
+// Without i8mm: 8 products of each group of k are computed exactly in int16
+// (|255 * -128| < 2^15) and added pairwise into int32 lanes.
+constexpr int kNeonBlockRows = 4;
+constexpr int kNeonBlockCols = 4;
+
+// Computes ROWS rows x 4 columns of C.
+template <int ROWS>
+void computeBlockNeon(
+    const std::uint8_t* A,
+    int lda,
+    const std::int8_t* B,
+    int ldb,
+    std::int32_t* C,
+    int ldc,
+    int kc,
+    bool accum) {
+  int32x4_t acc[ROWS][kNeonBlockCols];
+  for (int r = 0; r < ROWS; ++r) {
+    for (int q = 0; q < kNeonBlockCols; ++q) {
+      acc[r][q] = vdupq_n_s32(0);
+    }
+  }
+
+  for (int k = 0; k < kc; k += kNeonRowInterleave) {
+    const std::int8_t* b = B + k / kNeonRowInterleave * ldb;
+    int16x8_t bv[kNeonBlockCols];
+    for (int q = 0; q < kNeonBlockCols; ++q) {
+      bv[q] = vmovl_s8(vld1_s8(b + q * kNeonRowInterleave));
+    }
+    for (int r = 0; r < ROWS; ++r) {
+      const int16x8_t av = vreinterpretq_s16_u16(
+          vmovl_u8(vld1_u8(A + static_cast<std::int64_t>(r) * lda + k)));
+      for (int q = 0; q < kNeonBlockCols; ++q) {
+        acc[r][q] = vpadalq_s16(acc[r][q], vmulq_s16(av, bv[q]));
+      }
+    }
+  }
+
+  for (int r = 0; r < ROWS; ++r) {
+    std::int32_t* c = C + static_cast<std::int64_t>(r) * ldc;
+    int32x4_t v = vpaddq_s32(
+        vpaddq_s32(acc[r][0], acc[r][1]), vpaddq_s32(acc[r][2], acc[r][3]));
+    if (accum) {
+      v = vaddq_s32(v, vld1q_s32(c));
+    }
+    vst1q_s32(c, v);
+  }
+}
+
+void gemmKernelNeon(
+    const std::uint8_t* A,
+    int lda,
+    const std::int8_t* B,
+    int ldb,
+    std::int32_t* C,
+    int ldc,
+    int mc,
+    int nc,
+    int kc,
+    bool accum) {
+  const int nc_full = nc / kNeonBlockCols * kNeonBlockCols;
+  for (int i = 0; i < mc; i += kNeonBlockRows) {
+    const int rows = std::min(kNeonBlockRows, mc - i);
+    const std::uint8_t* a = A + static_cast<std::int64_t>(i) * lda;
+    std::int32_t* c = C + static_cast<std::int64_t>(i) * ldc;
+    for (int j = 0; j < nc_full; j += kNeonBlockCols) {
+      const std::int8_t* b = B + j * kNeonRowInterleave;
+      switch (rows) {
+        case 1:
+          computeBlockNeon<1>(a, lda, b, ldb, c + j, ldc, kc, accum);
+          break;
+        case 2:
+          computeBlockNeon<2>(a, lda, b, ldb, c + j, ldc, kc, accum);
+          break;
+        case 3:
+          computeBlockNeon<3>(a, lda, b, ldb, c + j, ldc, kc, accum);
+          break;
+        default:
+          computeBlockNeon<4>(a, lda, b, ldb, c + j, ldc, kc, accum);
+          break;
+      }
+    }
+  }
+  if (nc_full < nc) {
+    gemmKernelRef(
+        A,
+        lda,
+        B + nc_full * kNeonRowInterleave,
+        ldb,
+        kNeonRowInterleave,
+        C + nc_full,
+        ldc,
+        mc,
+        nc - nc_full,
+        kc,
+        accum);
+  }
+}
+
+#endif // __aarch64__
+
+} // namespace
+
+void gemmKernelU8S8S32ACC32Neon(
+    const std::uint8_t* A,
+    int lda,
+    const std::int8_t* B,
+    int ldb,
+    int row_interleave,
+    std::int32_t* C,
+    int ldc,
+    int mc,
+    int nc,
+    int kc,
+    bool accum) {
+  assert(kc % row_interleave == 0 && "kc must be a multiple of row_interleave");
+#if defined(__aarch64__)
+  if (row_interleave == kNeonRowInterleave) {
+    if (fbgemmHasArmI8mmSupport()) {
+      gemmKernelI8mm(A, lda, B, ldb, C, ldc, mc, nc, kc, accum);
+    } else {
+      gemmKernelNeon(A, lda, B, ldb, C, ldc, mc, nc, kc, accum);
+    }
+    return;
+  }
+#endif
+  gemmKernelRef(A, lda, B, ldb, row_interleave, C, ldc, mc, nc, kc, accum);
+}
+
+} // namespace fbgemm
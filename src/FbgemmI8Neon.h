@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include "fbgemm/FbgemmBuild.h"
+
+namespace fbgemm {
+
+/**
+ * @brief uint8 x int8 -> int32 macro-kernel for the anyarch packing, used by
+ * fbgemmPacked on CPUs without AVX2 such as aarch64. When row_interleave is 8
+ * it uses the i8mm usmmla instruction if fbgemmHasArmI8mmSupport(), and NEON
+ * widening multiply-adds otherwise; other layouts use a portable loop.
+ *
+ * @param A packed block of A, row major with leading dimension lda (KCB)
+ * @param B packed block of B: row_interleave consecutive k of each column are
+ *          next to each other, and consecutive groups of k are ldb bytes
+ *          (NCB * row_interleave) apart
+ * @param mc number of rows of A and C
+ * @param nc number of columns of C
+ * @param kc number of columns of A, a multiple of row_interleave
+ * @param accum if true, adds to C instead of overwriting it
+ */
+FBGEMM_API void gemmKernelU8S8S32ACC32Neon(
+    const std::uint8_t* A,
+    int lda,
+    const std::int8_t* B,
+    int ldb,
+    int row_interleave,
+    std::int32_t* C,
+    int ldc,
+    int mc,
+    int nc,
+    int kc,
+    bool accum);
+
+} // namespace fbgemm
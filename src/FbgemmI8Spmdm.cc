@@ -309,7 +309,114 @@ void CompressedSparseColumn::SparseConv(
   t_start = std::chrono::high_resolution_clock::now();
 #endif
 
-  // TODO: if not hyper sparse, transpose a block of A matrix as in SpMDM.
+  if (!IsHyperSparse() && fbgemmHasAvx2Support()) {
+    // As in SpMDM, C = (C^T + B^T * A^T)^T with A^T built 32 output pixels at
+    // a time. Only the im2col rows of A used by the non-zeros of the block
+    // are gathered, so the rows of B are renumbered in order of first use.
+    const int k_begin = colptr_[block.col_start];
+    const int k_end = colptr_[block.col_start + N];
+    vector<int32_t> local_colptr(N + 1);
+    for (int j = 0; j <= N; ++j) {
+      local_colptr[j] = colptr_[block.col_start + j] - k_begin;
+    }
+    static thread_local vector<int> local_row_of;
+    local_row_of.resize(conv_p.K[0] * conv_p.K[1] * conv_p.IC, -1);
+    vector<int16_t> local_rowidx(k_end - k_begin);
+    vector<int> used_rows;
+    for (int k = k_begin; k < k_end; ++k) {
+      const int row = (kh_[k] * conv_p.K[1] + kw_[k]) * conv_p.IC + ic_[k];
+      if (local_row_of[row] < 0) {
+        local_row_of[row] = static_cast<int>(used_rows.size());
+        used_rows.push_back(k);
+      }
+      local_rowidx[k - k_begin] = local_row_of[row];
+    }
+    for (int k : used_rows) {
+      local_row_of[(kh_[k] * conv_p.K[1] + kw_[k]) * conv_p.IC + ic_[k]] = -1;
+    }
+    // At least one row so that A_buffer is never empty
+    const int num_used_rows = std::max<int>(used_rows.size(), 1);
+
+#ifdef _MSC_VER
+    uint8_t* A_buffer = static_cast<uint8_t*>(
+        fbgemmAlignedAlloc(64, num_used_rows * 32 * sizeof(uint8_t)));
+    int32_t* C_buffer =
+        static_cast<int32_t*>(fbgemmAlignedAlloc(64, N * 32 * sizeof(int32_t)));
+#else
+    alignas(64) uint8_t A_buffer[num_used_rows * 32];
+    alignas(64) int32_t C_buffer[N * 32];
+#endif
+    array<int, 32> n_of, ih_of, iw_of;
+    const int i_end = block.row_start + block.row_size;
+    for (int i1 = block.row_start; i1 < i_end; i1 += 32) {
+      const int rows = std::min(32, i_end - i1);
+      for (int i2 = 0; i2 < rows; ++i2) {
+        const int i = i1 + i2;
+        const int ow = i % conv_p.OUT_DIM[1];
+        const int oh = i / conv_p.OUT_DIM[1] % conv_p.OUT_DIM[0];
+        n_of[i2] = i / conv_p.OUT_DIM[1] / conv_p.OUT_DIM[0];
+        assert(n_of[i2] < conv_p.MB);
+        ih_of[i2] = -conv_p.pad[0] + oh * conv_p.stride[0];
+        iw_of[i2] = -conv_p.pad[1] + ow * conv_p.stride[1];
+      }
+      for (int r = 0; r < num_used_rows; ++r) {
+        const int k = used_rows[r];
+        uint8_t* A_row = A_buffer + r * 32;
+        for (int i2 = 0; i2 < rows; ++i2) {
+          const int ih = ih_of[i2] + kh_[k];
+          const int iw = iw_of[i2] + kw_[k];
+          A_row[i2] = ih >= 0 && ih < conv_p.IN_DIM[0] && iw >= 0 &&
+                  iw < conv_p.IN_DIM[1]
+              ? A[((n_of[i2] * conv_p.IN_DIM[0] + ih) * conv_p.IN_DIM[1] + iw) *
+                      conv_p.IC +
+                  ic_[k]]
+              : A_zero_point;
+        }
+        memset(A_row + rows, 0, 32 - rows);
+      }
+
+      int32_t* C_block = C + (i1 - block.row_start) * ldc;
+      if (accumulation) {
+        transpose_simd(
+            rows,
+            N,
+            reinterpret_cast<const float*>(C_block),
+            ldc,
+            reinterpret_cast<float*>(C_buffer),
+            32);
+      } else {
+        memset(C_buffer, 0, N * 32 * sizeof(int32_t));
+      }
+      spmdmKernelAvx2(
+          N,
+          A_buffer,
+          local_colptr.data(),
+          values_.data() + k_begin,
+          local_rowidx.data(),
+          C_buffer);
+      transpose_simd(
+          N,
+          rows,
+          reinterpret_cast<const float*>(C_buffer),
+          32,
+          reinterpret_cast<float*>(C_block),
+          ldc);
+    }
+#ifdef _MSC_VER
+    fbgemmAlignedFree(A_buffer);
+    fbgemmAlignedFree(C_buffer);
+#endif
+
+#ifdef FBGEMM_MEASURE_TIME_BREAKDOWN
+    t_end = std::chrono::high_resolution_clock::now();
+    dt = std::chrono::duration_cast<std::chrono::nanoseconds>(t_end - t_start)
+             .count();
+    sconv_run_time += (dt);
+#endif
+    return;
+  }
+
+  // Hyper sparse B: the products are computed straight from A
   if (!accumulation) {
     for (int i = block.row_start; i < block.row_start + block.row_size; ++i) {
       for (int j = block.col_start; j < block.col_start + block.col_size; ++j) {
@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#define FBGEMM_EXPORTS
+#include "fbgemm/FbgemmSparse.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "fbgemm/Fbgemm.h"
+
+namespace fbgemm {
+
+namespace {
+
+constexpr int kBlockRows = PackBMatrixSparse24::kBlockRows;
+constexpr int kBlockCols = PackBMatrixSparse24::kBlockCols;
+
+// Byte offsets in a block of the values and row offsets for column l of
+// group t (of 4 rows) in the block.
+inline int valueOffset(int l, int t) {
+  return t / 2 * 2 * kBlockCols * 4 + l * 4 + t % 2 * 2;
+}
+inline int indexOffset(int l, int t) {
+  return valueOffset(l, t) + kBlockCols * 4;
+}
+
+} // namespace
+
+PackBMatrixSparse24::PackBMatrixSparse24(
+    matrix_op_t trans,
+    std::int32_t nRow,
+    std::int32_t nCol,
+    const std::int8_t* smat,
+    std::int32_t ld)
+    : nRow_(nRow), nCol_(nCol), colOffsets_(nCol, 0) {
+  const std::int64_t size =
+      static_cast<std::int64_t>(colBlocks()) * rowBlocks() * kBlockBytes;
+  buf_ = static_cast<std::uint8_t*>(fbgemmAlignedAlloc(64, size));
+
+  for (std::int32_t jb = 0; jb < colBlocks(); ++jb) {
+    for (std::int32_t kb = 0; kb < rowBlocks(); ++kb) {
+      std::uint8_t* dst = block(jb, kb);
+      for (int l = 0; l < kBlockCols; ++l) {
+        const std::int32_t c = jb * kBlockCols + l;
+        for (int t = 0; t < kBlockRows / 4; ++t) {
+          // Keep the non-zeros of the group, then fill up with the first
+          // zero positions so the two stored offsets are distinct.
+          int pos[2];
+          int kept = 0;
+          bool is_nonzero[4] = {false, false, false, false};
+          for (int p = 0; p < 4; ++p) {
+            const std::int32_t r = kb * kBlockRows + t * 4 + p;
+            if (r < nRow_ && c < nCol_) {
+              is_nonzero[p] = (trans == matrix_op_t::Transpose
+                                   ? smat[c * ld + r]
+                                   : smat[r * ld + c]) != 0;
+            }
+            if (is_nonzero[p]) {
+              if (kept == 2) {
+                throw std::runtime_error(
+                    "weights are not 2:4 sparse: more than 2 non-zeros in a "
+                    "group of 4");
+              }
+              pos[kept++] = p;
+            }
+          }
+          for (int p = 0; kept < 2; ++p) {
+            if (!is_nonzero[p]) {
+              pos[kept++] = p;
+            }
+          }
+          std::sort(pos, pos + 2);
+          for (int e = 0; e < 2; ++e) {
+            const std::int32_t r = kb * kBlockRows + t * 4 + pos[e];
+            std::int8_t v = 0;
+            if (is_nonzero[pos[e]]) {
+              v = trans == matrix_op_t::Transpose ? smat[c * ld + r]
+                                                  : smat[r * ld + c];
+              colOffsets_[c] += v;
+            }
+            dst[valueOffset(l, t) + e] = static_cast<std::uint8_t>(v);
+            dst[indexOffset(l, t) + e] = t * 4 + pos[e];
+          }
+        }
+      }
+    }
+  }
+}
+
+PackBMatrixSparse24::~PackBMatrixSparse24() {
+  fbgemmAlignedFree(buf_);
+}
+
+std::int8_t PackBMatrixSparse24::value(std::int32_t r, std::int32_t c) const {
+  const std::uint8_t* src = block(c / kBlockCols, r / kBlockRows);
+  const int rb = r % kBlockRows;
+  const int l = c % kBlockCols;
+  for (int e = 0; e < 2; ++e) {
+    if (src[indexOffset(l, rb / 4) + e] == rb) {
+      return static_cast<std::int8_t>(src[valueOffset(l, rb / 4) + e]);
+    }
+  }
+  return 0;
+}
+
+void PackBMatrixSparse24::unpack(std::int8_t* origin_buf) const {
+  for (std::int32_t r = 0; r < nRow_; ++r) {
+    for (std::int32_t c = 0; c < nCol_; ++c) {
+      origin_buf[r * nCol_ + c] = value(r, c);
+    }
+  }
+}
+
+namespace {
+
+void U8S8Sparse24GemmRef(
+    int m,
+    const std::uint8_t* A,
+    int lda,
+    const PackBMatrixSparse24& B,
+    std::int32_t* C,
+    int ldc,
+    int jb_begin,
+    int jb_end) {
+  const std::int32_t k = B.numRows();
+  for (int jb = jb_begin; jb < jb_end; ++jb) {
+    const int n_valid = std::min(kBlockCols, B.numCols() - jb * kBlockCols);
+    for (int i = 0; i < m; ++i) {
+      std::int32_t* Ci = C + i * ldc + jb * kBlockCols;
+      std::fill(Ci, Ci + n_valid, 0);
+      for (int kb = 0; kb < B.rowBlocks(); ++kb) {
+        const std::uint8_t* src = B.block(jb, kb);
+        for (int l = 0; l < n_valid; ++l) {
+          for (int t = 0; t < kBlockRows / 4; ++t) {
+            for (int e = 0; e < 2; ++e) {
+              const std::int32_t r =
+                  kb * kBlockRows + src[indexOffset(l, t) + e];
+              if (r < k) {
+                Ci[l] += static_cast<std::int32_t>(A[i * lda + r]) *
+                    static_cast<std::int8_t>(src[valueOffset(l, t) + e]);
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+} // namespace
+
+template <typename outType, typename processOutputType>
+void fbgemmU8S8Sparse24Gemm(
+    int m,
+    const std::uint8_t* A,
+    int lda,
+    const PackBMatrixSparse24& B,
+    outType* C,
+    std::int32_t* C_buffer,
+    int ldc,
+    const processOutputType& outProcess,
+    int thread_id,
+    int num_threads) {
+  int64_t jb_begin, jb_end;
+  fbgemmPartition1D(thread_id, num_threads, B.colBlocks(), jb_begin, jb_end);
+  if (jb_begin >= jb_end || m == 0) {
+    return;
+  }
+  static const auto iset = fbgemmInstructionSet();
+  // Run time CPU detection
+  if (iset == inst_set_t::avx512_vnni || iset == inst_set_t::avx512_vnni_ymm) {
+    internal::U8S8Sparse24GemmAvx512Vnni(
+        m, A, lda, B, C_buffer, ldc, jb_begin, jb_end);
+  } else {
+    U8S8Sparse24GemmRef(m, A, lda, B, C_buffer, ldc, jb_begin, jb_end);
+  }
+
+  const int col_begin = jb_begin * kBlockCols;
+  const int col_end = std::min<int>(jb_end * kBlockCols, B.numCols());
+  block_type_t block{0, m, col_begin, col_end - col_begin};
+  if (fbgemmHasAvx512Support() || fbgemmHasAvx2Support()) {
+    outProcess.template f<inst_set_t::avx2>(
+        C, C_buffer + col_begin, block, ldc, ldc);
+  } else {
+    outProcess.template f<inst_set_t::anyarch>(
+        C, C_buffer + col_begin, block, ldc, ldc);
+  }
+}
+
+#define INSTANTIATE_BASE(RELU, Q_GRAN, BIAS_TYPE)                  \
+  template FBGEMM_API void fbgemmU8S8Sparse24Gemm(                 \
+      int m,                                                       \
+      const std::uint8_t* A,                                       \
+      int lda,                                                     \
+      const PackBMatrixSparse24& B,                                \
+      std::uint8_t* C,                                             \
+      std::int32_t* C_buffer,                                      \
+      int ldc,                                                     \
+      const ReQuantizeOutput<RELU, Q_GRAN, BIAS_TYPE>& outProcess, \
+      int thread_id,                                               \
+      int num_threads);
+
+#define INSTANTIATE_BIAS_T(RELU, Q_GRAN) \
+  INSTANTIATE_BASE(RELU, Q_GRAN, float)  \
+  INSTANTIATE_BASE(RELU, Q_GRAN, std::int32_t)
+
+#define INSTANTIATE_Q_GRANS(RELU)                           \
+  INSTANTIATE_BIAS_T(RELU, QuantizationGranularity::TENSOR) \
+  INSTANTIATE_BIAS_T(RELU, QuantizationGranularity::GROUP)  \
+  INSTANTIATE_BIAS_T(RELU, QuantizationGranularity::OUT_CHANNEL)
+
+INSTANTIATE_Q_GRANS(false)
+INSTANTIATE_Q_GRANS(true)
+
+#undef INSTANTIATE_Q_GRANS
+#undef INSTANTIATE_BIAS_T
+#undef INSTANTIATE_BASE
+
+template FBGEMM_API void fbgemmU8S8Sparse24Gemm(
+    int m,
+    const std::uint8_t* A,
+    int lda,
+    const PackBMatrixSparse24& B,
+    std::int32_t* C,
+    std::int32_t* C_buffer,
+    int ldc,
+    const memCopy<>& outProcess,
+    int thread_id,
+    int num_threads);
+
+} // namespace fbgemm
@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#define FBGEMM_EXPORTS
+#include "fbgemm/FbgemmSparse.h"
+
+#if defined(__x86_64__) || defined(__i386__) || \
+    (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
+#include <immintrin.h>
+#endif
+#include <algorithm>
+
+// Only the kernels below are compiled for VNNI
+#if defined(_MSC_VER) && !defined(__clang__)
+#define FBGEMM_TARGET_AVX512_VNNI
+#else
+#define FBGEMM_TARGET_AVX512_VNNI __attribute__((target("avx512vnni")))
+#endif
+
+namespace fbgemm {
+namespace internal {
+
+namespace {
+
+constexpr int kBlockRows = PackBMatrixSparse24::kBlockRows;
+constexpr int kBlockCols = PackBMatrixSparse24::kBlockCols;
+// Rows of A and column blocks of B per tile: 8 int32 sums, and the values
+// and row offsets of 2 halves of 2 blocks of B.
+constexpr int kMaxRows = 4;
+constexpr int kMaxColBlocks = 2;
+
+// C rows [0, ROWS) and column blocks [jb, jb + NCB).
+//
+// The 16 values of A in a row block are broadcast to every 128-bit lane and
+// shuffled with the row offsets of B, which gathers for each column the 4
+// values of A matching the 4 kept values of B in one int32 lane. One
+// vpdpbusd then covers 8 rows of k.
+template <int ROWS, int NCB>
+FBGEMM_TARGET_AVX512_VNNI void kernel(
+    const std::uint8_t* A,
+    int lda,
+    const PackBMatrixSparse24& B,
+    std::int32_t* C,
+    int ldc,
+    int jb) {
+  const std::int32_t k = B.numRows();
+  __m512i acc[ROWS][NCB];
+  for (int r = 0; r < ROWS; ++r) {
+    for (int v = 0; v < NCB; ++v) {
+      acc[r][v] = _mm512_setzero_si512();
+    }
+  }
+
+  for (int kb = 0; kb < B.rowBlocks(); ++kb) {
+    __m512i w[NCB][2], idx[NCB][2];
+    for (int v = 0; v < NCB; ++v) {
+      const std::uint8_t* src = B.block(jb + v, kb);
+      for (int h = 0; h < 2; ++h) {
+        w[v][h] = _mm512_load_si512(src + h * 2 * kBlockCols * 4);
+        idx[v][h] =
+            _mm512_load_si512(src + h * 2 * kBlockCols * 4 + kBlockCols * 4);
+      }
+    }
+    const int k_begin = kb * kBlockRows;
+    const int valid = std::min(kBlockRows, k - k_begin);
+    const __mmask16 mask = valid == kBlockRows ? 0xffff : (1u << valid) - 1;
+    for (int r = 0; r < ROWS; ++r) {
+      // Rows past k are masked: their offsets come with zero values of B
+      // but must not be read past the end of A.
+      const __m512i a = _mm512_broadcast_i32x4(
+          _mm_maskz_loadu_epi8(mask, A + r * lda + k_begin));
+      for (int v = 0; v < NCB; ++v) {
+        for (int h = 0; h < 2; ++h) {
+          acc[r][v] = _mm512_dpbusd_epi32(
+              acc[r][v], _mm512_shuffle_epi8(a, idx[v][h]), w[v][h]);
+        }
+      }
+    }
+  }
+
+  for (int v = 0; v < NCB; ++v) {
+    const int col = (jb + v) * kBlockCols;
+    const int valid = std::min(kBlockCols, B.numCols() - col);
+    const __mmask16 mask = (1u << valid) - 1;
+    for (int r = 0; r < ROWS; ++r) {
+      _mm512_mask_storeu_epi32(C + r * ldc + col, mask, acc[r][v]);
+    }
+  }
+}
+
+template <int NCB>
+void rows(
+    int m,
+    const std::uint8_t* A,
+    int lda,
+    const PackBMatrixSparse24& B,
+    std::int32_t* C,
+    int ldc,
+    int jb) {
+  int i = 0;
+  for (; i + kMaxRows <= m; i += kMaxRows) {
+    kernel<kMaxRows, NCB>(A + i * lda, lda, B, C + i * ldc, ldc, jb);
+  }
+  const std::uint8_t* Ai = A + i * lda;
+  std::int32_t* Ci = C + i * ldc;
+  switch (m - i) {
+    case 3:
+      kernel<3, NCB>(Ai, lda, B, Ci, ldc, jb);
+      break;
+    case 2:
+      kernel<2, NCB>(Ai, lda, B, Ci, ldc, jb);
+      break;
+    case 1:
+      kernel<1, NCB>(Ai, lda, B, Ci, ldc, jb);
+      break;
+    default:
+      break;
+  }
+}
+
+} // namespace
+
+void U8S8Sparse24GemmAvx512Vnni(
+    int m,
+    const std::uint8_t* A,
+    int lda,
+    const PackBMatrixSparse24& B,
+    std::int32_t* C,
+    int ldc,
+    int jb_begin,
+    int jb_end) {
+  int jb = jb_begin;
+  for (; jb + kMaxColBlocks <= jb_end; jb += kMaxColBlocks) {
+    rows<kMaxColBlocks>(m, A, lda, B, C, ldc, jb);
+  }
+  if (jb < jb_end) {
+    rows<1>(m, A, lda, B, C, ldc, jb);
+  }
+}
+
+} // namespace internal
+} // namespace fbgemm
@@ -14,8 +14,10 @@
 #include <cassert>
 #include <cstdio>
 #include <cstring>
+#include <functional>
 #include <memory>
 #include <sstream>
+#include <type_traits>
 #include <vector>
 
 #include "fbgemm/Utils.h"
@@ -25,22 +27,121 @@ using namespace std;
 
 namespace fbgemm {
 
+namespace {
+
+// Number of tasks to pack num_rows rows with, num_threads <= 0 meaning one
+// per thread of the pool.
+int getNumPackTasks(int num_threads, int num_rows) {
+  if (num_threads <= 0) {
+    num_threads = fbgemmGetNumThreads();
+  }
+  return std::max(1, std::min(num_threads, num_rows));
+}
+
+// Runs task(begin, end) over num_tasks even ranges of [0, num_rows).
+void parallelForRows(
+    int num_tasks,
+    int num_rows,
+    const std::function<void(int begin, int end)>& task) {
+  fbgemmParallelTasks(num_tasks, [&](int task_id) {
+    int64_t begin = 0, end = 0;
+    fbgemmPartition1D(task_id, num_tasks, num_rows, begin, end);
+    task(static_cast<int>(begin), static_cast<int>(end));
+  });
+}
+
+// Indices of the non-zeros of src[0, n), written to nonZeros unless it is
+// null. Returns their number.
+template <typename T>
+int findNonZeros(const T* src, int n, int* nonZeros) {
+  static const bool useAvx2 = fbgemmHasAvx2Support();
+  if constexpr (is_same_v<T, int8_t> || is_same_v<T, float>) {
+    if (useAvx2) {
+      return internal::findNonZerosAvx2(src, n, nonZeros);
+    }
+  }
+  int count = 0;
+  for (int j = 0; j < n; ++j) {
+    if (src[j] != 0) {
+      if (nonZeros) {
+        nonZeros[count] = j;
+      }
+      ++count;
+    }
+  }
+  return count;
+}
+
+// Column block indices of the non-zero RB x CB blocks of the rows x cols
+// matrix src, written to nonZeros unless it is null. Returns their number.
+// Blocks are cut at rows and cols.
+template <typename T, int RB, int CB>
+int findNonZeroBlocks(
+    const T* src,
+    size_t ld,
+    int rows,
+    int cols,
+    int* nonZeros) {
+  static const bool useAvx2 = fbgemmHasAvx2Support();
+  int count = 0;
+  int j = 0;
+  if constexpr (RB == 1 && CB * sizeof(T) == sizeof(int32_t)) {
+    // A block is a single word
+    if (useAvx2) {
+      j = cols / CB;
+      count = internal::findNonZeroWordsAvx2(src, j, nonZeros);
+    }
+  }
+  for (; j * CB < cols; ++j) {
+    bool isNonZero = false;
+    for (int ib = 0; ib < rows && !isNonZero; ++ib) {
+      for (int jb = j * CB; jb < min((j + 1) * CB, cols); ++jb) {
+        if (src[ib * ld + jb] != 0) {
+          isNonZero = true;
+          break;
+        }
+      }
+    }
+    if (isNonZero) {
+      if (nonZeros) {
+        nonZeros[count] = j;
+      }
+      ++count;
+    }
+  }
+  return count;
+}
+
+} // namespace
+
+// Packing counts the non-zeros of every row first, so that each task can
+// then scatter its rows straight to their final place.
 template <typename T>
 FBGEMM_API std::unique_ptr<CSRMatrix<T>>
-fbgemmDenseToCSR(int R, int C, const T* inp, int ld) {
+fbgemmDenseToCSR(int R, int C, const T* inp, int ld, int num_threads) {
   unique_ptr<CSRMatrix<T>> csr(new CSRMatrix<T>());
-  csr->rowPtr.push_back(0);
-  int nnz = 0;
+  csr->rowPtr.assign(R + 1, 0);
+  const int num_tasks = getNumPackTasks(num_threads, R);
+  parallelForRows(num_tasks, R, [&](int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+      csr->rowPtr[i + 1] = findNonZeros(inp + i * ld, C, nullptr);
+    }
+  });
   for (int i = 0; i < R; ++i) {
-    for (int j = 0; j < C; ++j) {
-      if (inp[i * ld + j] != 0) {
-        csr->values.push_back(inp[i * ld + j]);
-        csr->colIdx.push_back(j);
-        nnz++;
+    csr->rowPtr[i + 1] += csr->rowPtr[i];
+  }
+  csr->colIdx.resize(csr->rowPtr[R]);
+  csr->values.resize(csr->rowPtr[R]);
+  parallelForRows(num_tasks, R, [&](int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+      int* colIdx = csr->colIdx.data() + csr->rowPtr[i];
+      T* values = csr->values.data() + csr->rowPtr[i];
+      const int nnz = findNonZeros(inp + i * ld, C, colIdx);
+      for (int r = 0; r < nnz; ++r) {
+        values[r] = inp[i * ld + colIdx[r]];
       }
     }
-    csr->rowPtr.push_back(nnz);
-  }
+  });
   return csr;
 }
 
@@ -55,15 +156,23 @@ template FBGEMM_API std::unique_ptr<CSRMatrix<float>>
 fbgemmDenseToCSR(int R, int C, const float* inp);
 
 template FBGEMM_API std::unique_ptr<CSRMatrix<int8_t>>
-fbgemmDenseToCSR(int R, int C, const int8_t* inp, int ld);
+fbgemmDenseToCSR(int R, int C, const int8_t* inp, int ld, int num_threads);
 template FBGEMM_API std::unique_ptr<CSRMatrix<float>>
-fbgemmDenseToCSR(int R, int C, const float* inp, int ld);
+fbgemmDenseToCSR(int R, int C, const float* inp, int ld, int num_threads);
 
 template <typename T, int RB, int CB>
 FBGEMM_API std::unique_ptr<BCSRMatrix<T, RB, CB>>
-fbgemmDenseToBCSR(int R, int C, const T* inp, int ld) {
-  unique_ptr<BCSRMatrix<T, RB, CB>> bcsr(new BCSRMatrix<T, RB, CB>(R, C));
-  bcsr->pack(inp, ld);
+fbgemmDenseToBCSR(
+    int R,
+    int C,
+    const T* inp,
+    int ld,
+    int colTile,
+    int rowTile,
+    int num_threads) {
+  unique_ptr<BCSRMatrix<T, RB, CB>> bcsr(
+      new BCSRMatrix<T, RB, CB>(R, C, colTile, rowTile));
+  bcsr->pack(inp, ld, num_threads);
   return bcsr;
 }
 
@@ -86,69 +195,199 @@ constexpr int BCSRMatrix<T, RB, CB>::COLTILE;
 
 #endif
 
+namespace {
+
+// Number of non-zero blocks of row block i in every column tile jt, stored
+// at counts[jt * countsStride].
 template <typename T, int RB, int CB>
-void BCSRMatrix<T, RB, CB>::pack(const DTYPE* src, size_t ld) {
-  rowBPtr.push_back(0);
-  int nnzb = 0;
-  int numCOLTILEs = (C + COLTILE - 1) / COLTILE;
-  int rowBlocks = (R + RB - 1) / RB;
-  for (int jt = 0; jt < numCOLTILEs; ++jt) {
-    for (int i = 0; i < rowBlocks; ++i) {
-      int curCols = min(C - jt * COLTILE, COLTILE);
-      int curColBlocks = (curCols + CB - 1) / CB;
-      std::array<int32_t, RB> rowSum = {0};
-      for (int j = 0; j < curColBlocks; ++j) {
-        // is the whole block zero?
-        bool isCurrentBlockNonZero = false;
-        for (int ib = 0; ib < RB; ++ib) {
-          // break if already found a non-zero element or
-          // out of bounds
-          if (isCurrentBlockNonZero || (i * RB + ib) >= R) {
-            break;
-          }
-          for (int jb = 0; jb < CB; ++jb) {
-            // within bound?
-            if ((jt * COLTILE + j * CB + jb) >= C) {
-              continue;
-            } else {
-              if (src[(i * RB + ib) * ld + jt * COLTILE + j * CB + jb] != 0) {
-                isCurrentBlockNonZero = true;
-                break;
-              }
-            }
-          }
-        }
-        if (isCurrentBlockNonZero) {
-          for (int ib = 0; ib < RB; ++ib) {
-            for (int jb = 0; jb < CB; ++jb) {
-              if ((i * RB + ib) >= R || (jt * COLTILE + j * CB + jb) >= C) {
-                // zero fill
-                values.push_back(0);
-              } else {
-                DTYPE val =
-                    src[(i * RB + ib) * ld + jt * COLTILE + j * CB + jb];
-                values.push_back(val);
-                rowSum[ib] += static_cast<int32_t>(val);
-              }
-            }
+void countRowBlock(
+    const BCSRMatrix<T, RB, CB>& bcsr,
+    const T* src,
+    size_t ld,
+    int i,
+    int* counts,
+    int countsStride) {
+  const int numColTiles = (bcsr.C + bcsr.colTile - 1) / bcsr.colTile;
+  const int rows = min(RB, bcsr.R - i * RB);
+  for (int jt = 0; jt < numColTiles; ++jt) {
+    const int curCols = min(bcsr.C - jt * bcsr.colTile, bcsr.colTile);
+    counts[jt * countsStride] = findNonZeroBlocks<T, RB, CB>(
+        src + i * RB * ld + jt * bcsr.colTile, ld, rows, curCols, nullptr);
+  }
+}
+
+// Writes the blocks and the row offsets of row block i, whose place is
+// already given by rowBPtr.
+template <typename T, int RB, int CB>
+void scatterRowBlock(
+    BCSRMatrix<T, RB, CB>& bcsr,
+    const T* src,
+    size_t ld,
+    int i) {
+  const int numColTiles = (bcsr.C + bcsr.colTile - 1) / bcsr.colTile;
+  const int rowBlocks = (bcsr.R + RB - 1) / RB;
+  const int rows = min(RB, bcsr.R - i * RB);
+  std::array<int32_t, RB> rowSum = {0};
+  for (int jt = 0; jt < numColTiles; ++jt) {
+    const int curCols = min(bcsr.C - jt * bcsr.colTile, bcsr.colTile);
+    const T* tile = src + i * RB * ld + jt * bcsr.colTile;
+    const int r0 = bcsr.rowBPtr[jt * rowBlocks + i];
+    int* colBIdx = bcsr.colBIdx.data() + r0;
+    const int nnzb =
+        findNonZeroBlocks<T, RB, CB>(tile, ld, rows, curCols, colBIdx);
+    assert(nnzb == bcsr.rowBPtr[jt * rowBlocks + i + 1] - r0);
+    for (int r = 0; r < nnzb; ++r) {
+      T* block = bcsr.values.data() + (r0 + r) * RB * CB;
+      for (int ib = 0; ib < RB; ++ib) {
+        for (int jb = 0; jb < CB; ++jb) {
+          const int col = colBIdx[r] * CB + jb;
+          if (ib >= rows || col >= curCols) {
+            // zero fill
+            block[ib * CB + jb] = 0;
+          } else {
+            T val = tile[ib * ld + col];
+            block[ib * CB + jb] = val;
+            rowSum[ib] += static_cast<int32_t>(val);
           }
-          colBIdx.push_back(j);
-          nnzb++;
         }
       }
-      rowBPtr.push_back(nnzb);
-      // Note: in row_offsets we don't need to subtract the constant term
-      // weight_zero_point * C because it's 0 as weight_zero_point is always 0
-      // for sparse kernels.
-      for (int ib = 0; ib < RB; ++ib) {
-        if (jt) {
-          row_offsets[i * RB + ib] += rowSum[ib];
-        } else {
-          row_offsets[i * RB + ib] = rowSum[ib];
-        }
+    }
+  }
+  // Note: in row_offsets we don't need to subtract the constant term
+  // weight_zero_point * C because it's 0 as weight_zero_point is always 0
+  // for sparse kernels.
+  for (int ib = 0; ib < rows; ++ib) {
+    bcsr.row_offsets[i * RB + ib] = rowSum[ib];
+  }
+}
+
+} // namespace
+
+template <typename T, int RB, int CB>
+void BCSRMatrix<T, RB, CB>::pack(
+    const DTYPE* src,
+    size_t ld,
+    int num_threads) {
+  const int numColTiles = (C + colTile - 1) / colTile;
+  const int rowBlocks = (R + RB - 1) / RB;
+  const int num_tasks = getNumPackTasks(num_threads, rowBlocks);
+
+  // Count the blocks of every row in every tile, then scatter each row
+  // block to its place.
+  rowBPtr.assign(numColTiles * rowBlocks + 1, 0);
+  parallelForRows(num_tasks, rowBlocks, [&](int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+      countRowBlock(*this, src, ld, i, rowBPtr.data() + i + 1, rowBlocks);
+    }
+  });
+  for (int r = 0; r < numColTiles * rowBlocks; ++r) {
+    rowBPtr[r + 1] += rowBPtr[r];
+  }
+  const int nnzb = rowBPtr.back();
+  colBIdx.resize(nnzb);
+  values.resize(nnzb * RB * CB);
+  parallelForRows(num_tasks, rowBlocks, [&](int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+      scatterRowBlock(*this, src, ld, i);
+    }
+  });
+}
+
+template <typename T, int RB, int CB>
+void BCSRMatrix<T, RB, CB>::repack(
+    const DTYPE* src,
+    size_t ld,
+    const std::vector<int>& changedRowBlocks,
+    int num_threads) {
+  const int numColTiles = (C + colTile - 1) / colTile;
+  const int rowBlocks = (R + RB - 1) / RB;
+  if (static_cast<int>(rowBPtr.size()) != numColTiles * rowBlocks + 1) {
+    // Not packed yet
+    pack(src, ld, num_threads);
+    return;
+  }
+
+  vector<int> changed(changedRowBlocks);
+  sort(changed.begin(), changed.end());
+  changed.erase(unique(changed.begin(), changed.end()), changed.end());
+  const int numChanged = static_cast<int>(changed.size());
+  assert(
+      numChanged == 0 || (changed.front() >= 0 && changed.back() < rowBlocks));
+
+  // New block counts of the changed row blocks, per tile
+  vector<int> newCounts(numColTiles * numChanged);
+  int num_tasks = getNumPackTasks(num_threads, numChanged);
+  parallelForRows(num_tasks, numChanged, [&](int begin, int end) {
+    for (int c = begin; c < end; ++c) {
+      countRowBlock(
+          *this, src, ld, changed[c], newCounts.data() + c, numChanged);
+    }
+  });
+
+  bool sameLayout = true;
+  for (int jt = 0; jt < numColTiles && sameLayout; ++jt) {
+    for (int c = 0; c < numChanged; ++c) {
+      const int r = jt * rowBlocks + changed[c];
+      if (rowBPtr[r + 1] - rowBPtr[r] != newCounts[jt * numChanged + c]) {
+        sameLayout = false;
+        break;
+      }
+    }
+  }
+  if (sameLayout) {
+    // The changed rows fit in their current place
+    parallelForRows(num_tasks, numChanged, [&](int begin, int end) {
+      for (int c = begin; c < end; ++c) {
+        scatterRowBlock(*this, src, ld, changed[c]);
       }
+    });
+    return;
+  }
+
+  // Recompute the layout, copying the blocks of the unchanged row blocks
+  // from the old arrays.
+  vector<int> oldRowBPtr(numColTiles * rowBlocks + 1, 0);
+  oldRowBPtr.swap(rowBPtr);
+  vector<int> oldColBIdx;
+  oldColBIdx.swap(colBIdx);
+  vector<DTYPE> oldValues;
+  oldValues.swap(values);
+  vector<char> isChanged(rowBlocks, 0);
+  for (int c = 0; c < numChanged; ++c) {
+    isChanged[changed[c]] = 1;
+  }
+  for (int jt = 0; jt < numColTiles; ++jt) {
+    // newCounts of the tile, in the order of the changed row blocks
+    const int* tileCounts = newCounts.data() + jt * numChanged;
+    for (int i = 0; i < rowBlocks; ++i) {
+      const int r = jt * rowBlocks + i;
+      rowBPtr[r + 1] = rowBPtr[r] +
+          (isChanged[i] ? *tileCounts++ : oldRowBPtr[r + 1] - oldRowBPtr[r]);
     }
   }
+  const int nnzb = rowBPtr.back();
+  colBIdx.resize(nnzb);
+  values.resize(nnzb * RB * CB);
+  num_tasks = getNumPackTasks(num_threads, rowBlocks);
+  parallelForRows(num_tasks, rowBlocks, [&](int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+      if (isChanged[i]) {
+        scatterRowBlock(*this, src, ld, i);
+        continue;
+      }
+      for (int jt = 0; jt < numColTiles; ++jt) {
+        const int r = jt * rowBlocks + i;
+        copy(
+            oldColBIdx.begin() + oldRowBPtr[r],
+            oldColBIdx.begin() + oldRowBPtr[r + 1],
+            colBIdx.begin() + rowBPtr[r]);
+        copy(
+            oldValues.begin() + oldRowBPtr[r] * RB * CB,
+            oldValues.begin() + oldRowBPtr[r + 1] * RB * CB,
+            values.begin() + rowBPtr[r] * RB * CB);
+      }
+    }
+  });
 }
 
 template <typename T, int RB, int CB>
@@ -161,9 +400,9 @@ void BCSRMatrix<T, RB, CB>::unpack(T* dst, size_t ld) {
   // zero out destination
   memset(dst, 0, R * C * sizeof(T));
 
-  int numCOLTILEs = (C + COLTILE - 1) / COLTILE;
+  int numColTiles = (C + colTile - 1) / colTile;
   int rowBlocks = (R + RB - 1) / RB;
-  for (int jt = 0; jt < numCOLTILEs; ++jt) {
+  for (int jt = 0; jt < numColTiles; ++jt) {
     for (int i = 0; i < rowBlocks; ++i) {
       // For the current tile, rowBPtr starts from currentTileIdx (i.e., jt) * R
       for (int r = rowBPtr[jt * R + i]; r < rowBPtr[jt * R + i + 1]; ++r) {
@@ -171,8 +410,8 @@ void BCSRMatrix<T, RB, CB>::unpack(T* dst, size_t ld) {
         for (int ib = 0; ib < RB; ++ib) {
           for (int jb = 0; jb < CB; ++jb) {
             // Are we within bounds of destination matrix?
-            if ((i * RB + ib) < R && (jt * COLTILE + curColIdx * CB + jb) < C) {
-              dst[(i * RB + ib) * ld + jt * COLTILE + curColIdx * CB + jb] =
+            if ((i * RB + ib) < R && (jt * colTile + curColIdx * CB + jb) < C) {
+              dst[(i * RB + ib) * ld + jt * colTile + curColIdx * CB + jb] =
                   values[r * RB * CB + ib * CB + jb];
             }
           }
@@ -196,7 +435,76 @@ template FBGEMM_API std::unique_ptr<BCSRMatrix<int8_t, 1, 4>>
 fbgemmDenseToBCSR(int R, int C, const int8_t* inp);
 
 template FBGEMM_API std::unique_ptr<BCSRMatrix<int8_t, 1, 4>>
-fbgemmDenseToBCSR(int R, int C, const int8_t* inp, int ld);
+fbgemmDenseToBCSR(
+    int R,
+    int C,
+    const int8_t* inp,
+    int ld,
+    int colTile,
+    int rowTile,
+    int num_threads);
+
+namespace {
+
+// First row i in [0, M] with prefix(i) >= target, for a non-decreasing
+// prefix.
+template <typename Prefix>
+int lowerBoundRow(int M, int64_t target, const Prefix& prefix) {
+  int lo = 0;
+  int hi = M;
+  while (lo < hi) {
+    int mid = lo + (hi - lo) / 2;
+    if (prefix(mid) < target) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+// Block [row_begin, row_end) x [col_begin, col_end) of the M x N output done
+// by thread_id. The threads form a 2D grid over the output. Rows are split
+// so that every range has about the same number of non-zeros, counting one
+// more per row for the per row overhead, given the number of non-zeros
+// nnzPrefix(i) in rows [0, i). Columns are split in multiples of colAlign.
+// Returns false when the thread has no work.
+template <typename Prefix>
+bool getThreadBlock(
+    int M,
+    int N,
+    const Prefix& nnzPrefix,
+    int colAlign,
+    int thread_id,
+    int num_threads,
+    int& row_begin,
+    int& row_end,
+    int& col_begin,
+    int& col_end) {
+  thread_type_t th_info =
+      fbgemmGetThreadPartition(1, M, N, thread_id, num_threads, colAlign);
+  if (th_info.m_num_threads == 0) {
+    return false;
+  }
+
+  auto costPrefix = [&](int i) {
+    return static_cast<int64_t>(nnzPrefix(i)) + i;
+  };
+  const int64_t total = costPrefix(M);
+  row_begin = lowerBoundRow(
+      M, total * th_info.m_thread_id / th_info.m_num_threads, costPrefix);
+  row_end = lowerBoundRow(
+      M, total * (th_info.m_thread_id + 1) / th_info.m_num_threads, costPrefix);
+
+  int64_t j_begin, j_end;
+  fbgemmPartition1DBlocked(
+      th_info.n_thread_id, th_info.n_num_threads, N, colAlign, j_begin, j_end);
+  col_begin = j_begin;
+  col_end = j_end;
+  return row_begin < row_end && col_begin < col_end;
+}
+
+} // namespace
 
 void SparseDenseMM(
     int M,
@@ -208,17 +516,44 @@ void SparseDenseMM(
     int ldb,
     float* C,
     int ldc,
-    bool accum) {
+    bool accum,
+    int thread_id,
+    int num_threads) {
+  // Two AVX512 registers of C per row and column tile
+  constexpr int colAlign = 32;
+  int row_begin, row_end, col_begin, col_end;
+  if (!getThreadBlock(
+          M,
+          N,
+          [&](int i) { return row_ptr[i] - row_ptr[0]; },
+          colAlign,
+          thread_id,
+          num_threads,
+          row_begin,
+          row_end,
+          col_begin,
+          col_end)) {
+    return;
+  }
+  // The kernels compute a sub-block through offset pointers. row_ptr keeps
+  // indexing col_idx and values from their start.
+  const int M_t = row_end - row_begin;
+  const int N_t = col_end - col_begin;
+  const int* row_ptr_t = row_ptr + row_begin;
+  const float* B_t = B + col_begin;
+  float* C_t = C + static_cast<int64_t>(row_begin) * ldc + col_begin;
+
   static const auto iset = fbgemmInstructionSet();
   // Run time CPU detection
   if (isZmm(iset)) {
     internal::SparseDenseMMAvx512(
-        M, N, row_ptr, col_idx, values, B, ldb, C, ldc, accum);
+        M_t, N_t, row_ptr_t, col_idx, values, B_t, ldb, C_t, ldc, accum);
   } else if (isYmm(iset)) {
     internal::SparseDenseMMAvx2(
-        M, N, row_ptr, col_idx, values, B, ldb, C, ldc, accum);
+        M_t, N_t, row_ptr_t, col_idx, values, B_t, ldb, C_t, ldc, accum);
   } else {
-    sparseDenseMMRef(M, N, row_ptr, col_idx, values, B, ldb, C, ldc, accum);
+    sparseDenseMMRef(
+        M_t, N_t, row_ptr_t, col_idx, values, B_t, ldb, C_t, ldc, accum);
   }
 }
 
@@ -236,52 +571,82 @@ FBGEMM_API void fbgemmSparseDenseInt8MM(
     int thread_id,
     int num_threads) {
   static const auto iset = fbgemmInstructionSet();
-  // No parallelization currently
-  // All work is done by thread 0
-  if (thread_id > 0) {
+  if (!isZmm(iset) && !isYmm(iset)) {
+    // The reference implementation is not parallelized, all work is done by
+    // thread 0
+    if (thread_id == 0) {
+      sparseDenseInt8MMRef<FUSE_RELU, Q_GRAN>(
+          N, bcsr, B, ldb, C_i32, C_u8, ldc, rParams, accum);
+    }
     return;
   }
 
+  // A 64 column panel of B is interleaved at once by the AVX512 kernel. It
+  // also keeps its partial sums in the first 64 columns of its block of
+  // C_i32, which stay within the block with this alignment.
+  constexpr int colAlign = 64;
+  const int M = bcsr->R;
+  const int kTiles = (bcsr->C + bcsr->colTile - 1) / bcsr->colTile;
+  const int* rowBPtr = bcsr->rowBPtr.data();
+  int row_begin, row_end, col_begin, col_end;
+  if (!getThreadBlock(
+          M,
+          N,
+          [&](int i) {
+            // The row pointers of column tile kt start at kt * M
+            int nnz = 0;
+            for (int kt = 0; kt < kTiles; ++kt) {
+              nnz += rowBPtr[kt * M + i] - rowBPtr[kt * M];
+            }
+            return nnz;
+          },
+          colAlign,
+          thread_id,
+          num_threads,
+          row_begin,
+          row_end,
+          col_begin,
+          col_end)) {
+    return;
+  }
+  // The kernels take the rows to compute and the columns through offset
+  // pointers. Column offsets are indexed relative to the block.
+  const int N_t = col_end - col_begin;
+  const uint8_t* B_t = B + col_begin;
+  int32_t* C_i32_t = C_i32 + col_begin;
+  uint8_t* C_u8_t = C_u8 + col_begin;
+  trRequantizationParams_t rParams_t = rParams;
+  if (rParams_t.act_col_offsets) {
+    rParams_t.act_col_offsets += col_begin;
+  }
+
   // Run time CPU detection
   if (isZmm(iset)) {
     internal::SparseDenseInt8MMAvx512<FUSE_RELU, Q_GRAN>(
-        N,
+        N_t,
         bcsr,
-        B,
+        B_t,
         ldb,
-        C_i32,
-        C_u8,
+        C_i32_t,
+        C_u8_t,
         ldc,
-        rParams,
+        rParams_t,
         accum,
-        thread_id,
-        num_threads);
-  } else if (isYmm(iset)) {
-    internal::SparseDenseInt8MMAvx2<FUSE_RELU, Q_GRAN>(
-        N,
-        bcsr,
-        B,
-        ldb,
-        C_i32,
-        C_u8,
-        ldc,
-        rParams,
-        accum,
-        thread_id,
-        num_threads);
+        row_begin,
+        row_end);
   } else {
-    sparseDenseInt8MMRef<FUSE_RELU, Q_GRAN>(
-        N,
+    internal::SparseDenseInt8MMAvx2<FUSE_RELU, Q_GRAN>(
+        N_t,
         bcsr,
-        B,
+        B_t,
         ldb,
-        C_i32,
-        C_u8,
+        C_i32_t,
+        C_u8_t,
         ldc,
-        rParams,
+        rParams_t,
         accum,
-        thread_id,
-        num_threads);
+        row_begin,
+        row_end);
   }
 }
 
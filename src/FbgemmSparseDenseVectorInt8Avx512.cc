@@ -37,7 +37,8 @@ template <
 static inline void requantizeForMV(
     uint8_t* dst,
     int32_t* src,
-    int len,
+    int begin,
+    int end,
     trRequantizationParams_t& rParams) {
   constexpr int VLEN_INT32 = 16;
   __m512i C_zero_point_epi8_v = _mm512_set1_epi8(rParams.C_zero_point);
@@ -49,8 +50,8 @@ static inline void requantizeForMV(
       0x0D, 0x09, 0x05, 0x01,
       0x0C, 0x08, 0x04, 0x00);
   // clang-format on
-  int i = 0;
-  for (; i < len / VLEN_INT32 * VLEN_INT32; i += VLEN_INT32) {
+  int i = begin;
+  for (; i + VLEN_INT32 <= end; i += VLEN_INT32) {
     __m512i x_v = _mm512_loadu_si512(src + i);
     if (!ACT_ZP_0) {
       __m512i weight_row_offset_v =
@@ -88,11 +89,11 @@ static inline void requantizeForMV(
     }
     x_clamped_v = _mm512_permutexvar_epi32(permute_mask_v, x_clamped_v);
 
-    _mm_store_si128(
+    _mm_storeu_si128(
         reinterpret_cast<__m128i*>(dst + i),
         _mm512_castsi512_si128(x_clamped_v));
   }
-  int rem_int32 = len - i;
+  int rem_int32 = end - i;
   if (rem_int32 > 0) {
     __mmask64 mask_int8_v = (1ULL << rem_int32) - 1;
     __mmask16 mask_int32_v = (1ULL << rem_int32) - 1;
@@ -150,20 +151,13 @@ void SparseDenseInt8MVAvx512(
     uint8_t* C_u8,
     trRequantizationParams_t& rParams,
     bool accum,
-    int thread_id,
-    int num_threads) {
-  (void)num_threads; // Suppress unused variable warning
+    int row_begin,
+    int row_end) {
   // Calcualtes accum ? C += A * B : C = A * B
   constexpr int VLEN_INT32 = 16;
 
   constexpr int block_size = BCSRMatrix<>::CB;
-  constexpr int colTileSize = BCSRMatrix<>::COLTILE;
-
-  // all work is done by thread 0 for now
-  assert(num_threads > 0 && "Numbers of threads should be > 0");
-  if (thread_id > 0) {
-    return;
-  }
+  const int colTileSize = bcsr->colTile;
 
   assert(ldb == 1 && "ldb should be 1");
   __m512i one_16bit_v = _mm512_set1_epi16(1);
@@ -180,7 +174,7 @@ void SparseDenseInt8MVAvx512(
     const int* cur_row_ptr = row_ptr + kt * M;
     const uint8_t* cur_B = B + kt * colTileSize * ldb;
     // TODO: unroll this loop?
-    for (int i = 0; i < M; ++i) {
+    for (int i = row_begin; i < row_end; ++i) {
       __m512i res = _mm512_set1_epi32(0);
       int r = cur_row_ptr[i];
       int r_end_aligned = cur_row_ptr[i] +
@@ -227,15 +221,19 @@ void SparseDenseInt8MVAvx512(
   }
   if (rParams.bias == nullptr) {
     if (rParams.act_zero_point) {
-      requantizeForMV<FUSE_RELU, false, false, Q_GRAN>(C_u8, C_i32, M, rParams);
+      requantizeForMV<FUSE_RELU, false, false, Q_GRAN>(
+          C_u8, C_i32, row_begin, row_end, rParams);
     } else {
-      requantizeForMV<FUSE_RELU, true, false, Q_GRAN>(C_u8, C_i32, M, rParams);
+      requantizeForMV<FUSE_RELU, true, false, Q_GRAN>(
+          C_u8, C_i32, row_begin, row_end, rParams);
     }
   } else {
     if (rParams.act_zero_point) {
-      requantizeForMV<FUSE_RELU, false, true, Q_GRAN>(C_u8, C_i32, M, rParams);
+      requantizeForMV<FUSE_RELU, false, true, Q_GRAN>(
+          C_u8, C_i32, row_begin, row_end, rParams);
     } else {
-      requantizeForMV<FUSE_RELU, true, true, Q_GRAN>(C_u8, C_i32, M, rParams);
+      requantizeForMV<FUSE_RELU, true, true, Q_GRAN>(
+          C_u8, C_i32, row_begin, row_end, rParams);
     }
   }
 }
@@ -249,8 +247,8 @@ void SparseDenseInt8MVAvx512(
       uint8_t* C_u8,                                       \
       trRequantizationParams_t& rParams,                   \
       bool accum,                                          \
-      int thread_id,                                       \
-      int num_threads);
+      int row_begin,                                       \
+      int row_end);
 CREATE_INSTANCE(true, QuantizationGranularity::TENSOR)
 CREATE_INSTANCE(true, QuantizationGranularity::OUT_CHANNEL)
 CREATE_INSTANCE(false, QuantizationGranularity::TENSOR)
@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#define FBGEMM_EXPORTS
+#include "fbgemm/FbgemmSparse.h"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <vector>
+
+namespace fbgemm {
+
+namespace {
+
+// First row i in [0, M] whose cost prefix reaches cost. The prefix is
+// strictly increasing since every row costs at least one.
+int firstRowWithCost(
+    const std::vector<std::int64_t>& costPrefix,
+    std::int64_t cost) {
+  return static_cast<int>(
+      std::lower_bound(costPrefix.begin(), costPrefix.end(), cost) -
+      costPrefix.begin());
+}
+
+// Accumulators of one row of C at a time. Both reset the entries of a row
+// when it is extracted, so they are only cleared once.
+//
+// Open addressing hash table from column index to value, for rows with few
+// products compared to N.
+template <typename T>
+class HashAccumulator {
+ public:
+  // Sized for rows of C with up to maxRowProducts products, which bounds the
+  // number of distinct columns.
+  explicit HashAccumulator(std::int64_t maxRowProducts) {
+    std::size_t size = 16;
+    while (size < 2 * static_cast<std::size_t>(maxRowProducts)) {
+      size *= 2;
+    }
+    keys_.assign(size, -1);
+    values_.resize(size);
+  }
+
+  void accumulate(int col, T value) {
+    const std::size_t mask = keys_.size() - 1;
+    std::size_t slot = hash(col) & mask;
+    while (keys_[slot] != col) {
+      if (keys_[slot] == -1) {
+        keys_[slot] = col;
+        values_[slot] = value;
+        used_.push_back(slot);
+        return;
+      }
+      slot = (slot + 1) & mask;
+    }
+    values_[slot] += value;
+  }
+
+  // Appends the row sorted by column.
+  void extract(std::vector<int>& colIdx, std::vector<T>& values) {
+    // Sorting plain integers, the column above the slot, is much faster than
+    // sorting the slots by their keys.
+    for (std::uint64_t& entry : used_) {
+      entry |= static_cast<std::uint64_t>(keys_[entry]) << 32;
+    }
+    std::sort(used_.begin(), used_.end());
+    for (std::uint64_t entry : used_) {
+      const std::size_t slot = entry & 0xffffffff;
+      colIdx.push_back(keys_[slot]);
+      values.push_back(values_[slot]);
+      keys_[slot] = -1;
+    }
+    used_.clear();
+  }
+
+ private:
+  static std::size_t hash(int col) {
+    return static_cast<std::uint32_t>(col) * 2654435761u;
+  }
+
+  std::vector<int> keys_;
+  std::vector<T> values_;
+  // Slots of the row
+  std::vector<std::uint64_t> used_;
+};
+
+// Dense array of the N columns with a bitmap of the columns hit, for rows
+// with enough products that scanning the bitmap costs less than sorting the
+// row. The scan visits the set bits in column order.
+template <typename T>
+class DenseAccumulator {
+ public:
+  explicit DenseAccumulator(int N)
+      : values_(N, 0), occupied_((N + 63) / 64, 0) {}
+
+  void accumulate(int col, T value) {
+    values_[col] += value;
+    occupied_[col / 64] |= std::uint64_t(1) << (col % 64);
+    firstWord_ = std::min(firstWord_, col / 64);
+    lastWord_ = std::max(lastWord_, col / 64);
+  }
+
+  // Appends the row sorted by column.
+  void extract(std::vector<int>& colIdx, std::vector<T>& values) {
+    for (int w = firstWord_; w <= lastWord_; ++w) {
+      std::uint64_t bits = occupied_[w];
+      while (bits) {
+        const int col = w * 64 + std::countr_zero(bits);
+        colIdx.push_back(col);
+        values.push_back(values_[col]);
+        values_[col] = 0;
+        bits &= bits - 1;
+      }
+      occupied_[w] = 0;
+    }
+    firstWord_ = std::numeric_limits<int>::max();
+    lastWord_ = -1;
+  }
+
+ private:
+  std::vector<T> values_;
+  std::vector<std::uint64_t> occupied_;
+  int firstWord_{std::numeric_limits<int>::max()};
+  int lastWord_{-1};
+};
+
+} // namespace
+
+template <typename T>
+std::unique_ptr<CSRMatrix<T>> fbgemmSparseSparseMM(
+    int M,
+    int N,
+    const CSRMatrix<T>& A,
+    const CSRMatrix<T>& B,
+    int num_threads) {
+  assert(static_cast<int>(A.rowPtr.size()) == M + 1);
+  if (num_threads <= 0) {
+    num_threads = fbgemmGetNumThreads();
+  }
+  num_threads = std::max(1, std::min(num_threads, M));
+
+  // Each row of C costs its number of products plus one, which balances the
+  // row blocks of the tasks and picks the accumulator of each row.
+  std::vector<std::int64_t> costPrefix(M + 1, 0);
+  std::int64_t maxRowProducts = 0;
+  for (int i = 0; i < M; ++i) {
+    std::int64_t products = 0;
+    for (int r = A.rowPtr[i]; r < A.rowPtr[i + 1]; ++r) {
+      const int k = A.colIdx[r];
+      products += B.rowPtr[k + 1] - B.rowPtr[k];
+    }
+    maxRowProducts = std::max(maxRowProducts, products);
+    costPrefix[i + 1] = costPrefix[i] + products + 1;
+  }
+
+  std::unique_ptr<CSRMatrix<T>> C(new CSRMatrix<T>());
+  C->rowPtr.assign(M + 1, 0);
+
+  // Each task computes its rows into its own buffers, which are then copied
+  // to C once the offsets of the rows are known.
+  std::vector<std::vector<int>> taskColIdx(num_threads);
+  std::vector<std::vector<T>> taskValues(num_threads);
+  std::vector<int> rowBegin(num_threads + 1, M);
+  for (int t = 0; t < num_threads; ++t) {
+    rowBegin[t] = firstRowWithCost(costPrefix, costPrefix[M] * t / num_threads);
+  }
+
+  // Rows with at least N / kDenseRowRatio products use the dense accumulator,
+  // whose scan over N / 64 words then costs less than sorting the row, unless
+  // N is too large to keep the N values of every task.
+  constexpr int kDenseRowRatio = 1024;
+  constexpr int kMaxDenseCols = 1 << 22;
+  fbgemmParallelTasks(num_threads, [&](int task_id) {
+    std::vector<int>& colIdx = taskColIdx[task_id];
+    std::vector<T>& values = taskValues[task_id];
+    HashAccumulator<T> hashAcc(std::min<std::int64_t>(
+        maxRowProducts, N <= kMaxDenseCols ? N / kDenseRowRatio : N));
+    std::unique_ptr<DenseAccumulator<T>> denseAcc;
+    auto computeRow = [&](int i, auto& acc) {
+      for (int r = A.rowPtr[i]; r < A.rowPtr[i + 1]; ++r) {
+        const int k = A.colIdx[r];
+        const T a = A.values[r];
+        for (int rb = B.rowPtr[k]; rb < B.rowPtr[k + 1]; ++rb) {
+          assert(B.colIdx[rb] < N);
+          acc.accumulate(B.colIdx[rb], a * B.values[rb]);
+        }
+      }
+      acc.extract(colIdx, values);
+    };
+    for (int i = rowBegin[task_id]; i < rowBegin[task_id + 1]; ++i) {
+      const int nnzBefore = static_cast<int>(colIdx.size());
+      const std::int64_t products = costPrefix[i + 1] - costPrefix[i] - 1;
+      if (N <= kMaxDenseCols && products * kDenseRowRatio >= N) {
+        if (!denseAcc) {
+          denseAcc.reset(new DenseAccumulator<T>(N));
+        }
+        computeRow(i, *denseAcc);
+      } else {
+        computeRow(i, hashAcc);
+      }
+      C->rowPtr[i + 1] = static_cast<int>(colIdx.size()) - nnzBefore;
+    }
+  });
+
+  for (int i = 0; i < M; ++i) {
+    C->rowPtr[i + 1] += C->rowPtr[i];
+  }
+  C->colIdx.resize(C->rowPtr[M]);
+  C->values.resize(C->rowPtr[M]);
+  fbgemmParallelTasks(num_threads, [&](int task_id) {
+    const int offset = C->rowPtr[rowBegin[task_id]];
+    std::copy(
+        taskColIdx[task_id].begin(),
+        taskColIdx[task_id].end(),
+        C->colIdx.begin() + offset);
+    std::copy(
+        taskValues[task_id].begin(),
+        taskValues[task_id].end(),
+        C->values.begin() + offset);
+  });
+  return C;
+}
+
+template FBGEMM_API std::unique_ptr<CSRMatrix<float>> fbgemmSparseSparseMM(
+    int M,
+    int N,
+    const CSRMatrix<float>& A,
+    const CSRMatrix<float>& B,
+    int num_threads);
+
+} // namespace fbgemm
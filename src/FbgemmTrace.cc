@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#define FBGEMM_EXPORTS
+#include "fbgemm/FbgemmTrace.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "./TraceScope.h"
+
+namespace fbgemm {
+
+namespace {
+
+std::mutex trace_mutex;
+std::shared_ptr<const TraceCallback> trace_callback;
+// Bumped on every change of trace_callback, so threads refresh their copy
+// without taking trace_mutex on every event
+std::atomic<std::uint64_t> trace_generation{0};
+
+} // namespace
+
+namespace internal {
+
+std::atomic<bool> trace_enabled{false};
+
+void emitTraceEvent(const TraceEvent& event) {
+  thread_local std::shared_ptr<const TraceCallback> callback;
+  thread_local std::uint64_t generation = 0;
+  if (trace_generation.load(std::memory_order_acquire) != generation) {
+    std::lock_guard<std::mutex> lock(trace_mutex);
+    callback = trace_callback;
+    generation = trace_generation.load(std::memory_order_relaxed);
+  }
+  if (callback) {
+    (*callback)(event);
+  }
+}
+
+} // namespace internal
+
+void fbgemmSetTraceCallback(TraceCallback callback) {
+  std::lock_guard<std::mutex> lock(trace_mutex);
+  trace_callback = callback
+      ? std::make_shared<const TraceCallback>(std::move(callback))
+      : nullptr;
+  trace_generation.fetch_add(1, std::memory_order_release);
+  internal::trace_enabled.store(
+      trace_callback != nullptr, std::memory_order_release);
+}
+
+bool fbgemmTracingEnabled() {
+  return internal::trace_enabled.load(std::memory_order_relaxed);
+}
+
+} // namespace fbgemm
@@ -0,0 +1,286 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#define FBGEMM_EXPORTS
+#include "fbgemm/FbgemmWarmup.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include "fbgemm/Fbgemm.h"
+#include "fbgemm/FbgemmEmbedding.h"
+#include "fbgemm/Types.h"
+
+namespace fbgemm {
+
+namespace {
+
+template <typename ACC_T>
+void warmupGemm(const GemmWarmupShape& shape) {
+  const int M = shape.M;
+  const int N = shape.N;
+  const int K = shape.K;
+  const BlockingFactors* params = shape.blocking_params;
+
+  std::vector<std::uint8_t> A(static_cast<std::size_t>(M) * K, 0);
+  std::vector<std::int8_t> B(static_cast<std::size_t>(K) * N, 0);
+  std::vector<std::int32_t> C_buffer(static_cast<std::size_t>(M) * N);
+  std::vector<std::uint8_t> C(C_buffer.size());
+  std::vector<std::int32_t> col_offsets(N, 0);
+  std::int32_t B_zero_point = 0;
+  float C_multiplier = 1.0f;
+
+  PackBMatrix<std::int8_t, ACC_T> packedB(
+      matrix_op_t::NoTranspose, K, N, B.data(), N, nullptr, 1, params);
+
+  for (int thread_id = 0; thread_id < shape.num_threads; ++thread_id) {
+    PackAWithRowOffset<std::uint8_t, ACC_T> packA(
+        matrix_op_t::NoTranspose,
+        M,
+        K,
+        A.data(),
+        K,
+        nullptr,
+        1,
+        nullptr,
+        params);
+    DoNothing<> doNothingObj{};
+    ReQuantizeOutput<false> outputProcObj(
+        doNothingObj,
+        &C_multiplier,
+        0,
+        0,
+        &B_zero_point,
+        packA.getRowOffsetBuffer(),
+        col_offsets.data(),
+        nullptr,
+        N);
+    fbgemmPacked(
+        packA,
+        packedB,
+        C.data(),
+        C_buffer.data(),
+        N,
+        outputProcObj,
+        thread_id,
+        shape.num_threads,
+        params);
+  }
+}
+
+template <typename IndexType, typename OffsetType>
+void warmupEmbedding(const EmbeddingWarmupConfig& config) {
+  switch (config.bit_rate) {
+    case 32:
+      GenerateEmbeddingSpMDM<float, IndexType, OffsetType>(
+          config.block_size,
+          config.has_weight,
+          config.normalize_by_lengths,
+          config.prefetch,
+          config.is_weight_positional,
+          config.use_offsets);
+      break;
+    case 16:
+      GenerateEmbeddingSpMDM<float16, IndexType, OffsetType>(
+          config.block_size,
+          config.has_weight,
+          config.normalize_by_lengths,
+          config.prefetch,
+          config.is_weight_positional,
+          config.use_offsets);
+      break;
+    case 8:
+      GenerateEmbeddingSpMDM<std::uint8_t, IndexType, OffsetType>(
+          config.block_size,
+          config.has_weight,
+          config.normalize_by_lengths,
+          config.prefetch,
+          config.is_weight_positional,
+          config.use_offsets);
+      break;
+    case 4:
+    case 2:
+      GenerateEmbeddingSpMDMNBit<IndexType, OffsetType>(
+          config.bit_rate,
+          config.block_size,
+          config.has_weight,
+          config.normalize_by_lengths,
+          config.prefetch,
+          config.is_weight_positional,
+          config.use_offsets);
+      break;
+    default:
+      throw std::invalid_argument(
+          "fbgemmWarmup: unsupported embedding bit_rate " +
+          std::to_string(config.bit_rate));
+  }
+}
+
+void warmupEmbedding(const EmbeddingWarmupConfig& config) {
+  if (config.is_index_64bit) {
+    if (config.is_offset_64bit) {
+      warmupEmbedding<std::int64_t, std::int64_t>(config);
+    } else {
+      warmupEmbedding<std::int64_t, std::int32_t>(config);
+    }
+  } else {
+    if (config.is_offset_64bit) {
+      warmupEmbedding<std::int32_t, std::int64_t>(config);
+    } else {
+      warmupEmbedding<std::int32_t, std::int32_t>(config);
+    }
+  }
+}
+
+template <int SPATIAL_DIM, bool FUSE_RELU, QuantizationGranularity Q_GRAN>
+void warmupConv(const ConvWarmupConfig<SPATIAL_DIM>& config, int num_threads) {
+  const conv_param_t<SPATIAL_DIM>& conv_p = config.conv_p;
+  std::size_t in_size = static_cast<std::size_t>(conv_p.MB) * conv_p.IC;
+  std::size_t out_size = static_cast<std::size_t>(conv_p.MB) * conv_p.OC;
+  std::size_t w_size =
+      static_cast<std::size_t>(conv_p.IC / conv_p.G) * conv_p.OC;
+  for (int d = 0; d < SPATIAL_DIM; ++d) {
+    in_size *= conv_p.IN_DIM[d];
+    out_size *= conv_p.OUT_DIM[d];
+    w_size *= conv_p.K[d];
+  }
+
+  std::vector<std::uint8_t> A(in_size, 0);
+  std::vector<std::int8_t> B(w_size, 0);
+  std::vector<std::int32_t> C_buffer(out_size);
+  std::vector<std::uint8_t> C(out_size);
+  std::vector<std::int32_t> col_offsets(conv_p.OC, 0);
+  // Sized for OUT_CHANNEL, the largest granularity
+  std::vector<std::int32_t> B_zero_point(conv_p.OC, config.B_zero_point);
+  std::vector<float> C_multiplier(conv_p.OC, 1.0f);
+
+  PackWeightsForConv<SPATIAL_DIM> packedWeights(conv_p, B.data());
+  DoNothing<> doNothingObj{};
+  ReQuantizeOutput<FUSE_RELU, Q_GRAN> outputProcObj(
+      doNothingObj,
+      C_multiplier.data(),
+      0,
+      config.A_zero_point,
+      B_zero_point.data(),
+      nullptr, // row offsets
+      col_offsets.data(),
+      nullptr, // bias
+      conv_p.OC,
+      conv_p.G);
+
+  for (int thread_id = 0; thread_id < num_threads; ++thread_id) {
+    fbgemmConv(
+        conv_p,
+        A.data(),
+        packedWeights,
+        C.data(),
+        C_buffer.data(),
+        outputProcObj,
+        thread_id,
+        num_threads);
+  }
+}
+
+template <int SPATIAL_DIM, bool FUSE_RELU>
+void warmupConv(const ConvWarmupConfig<SPATIAL_DIM>& config, int num_threads) {
+  switch (config.granularity) {
+    case QuantizationGranularity::TENSOR:
+      warmupConv<SPATIAL_DIM, FUSE_RELU, QuantizationGranularity::TENSOR>(
+          config, num_threads);
+      break;
+    case QuantizationGranularity::GROUP:
+      warmupConv<SPATIAL_DIM, FUSE_RELU, QuantizationGranularity::GROUP>(
+          config, num_threads);
+      break;
+    case QuantizationGranularity::OUT_CHANNEL:
+      warmupConv<SPATIAL_DIM, FUSE_RELU, QuantizationGranularity::OUT_CHANNEL>(
+          config, num_threads);
+      break;
+  }
+}
+
+template <int SPATIAL_DIM>
+void warmupConv(const ConvWarmupConfig<SPATIAL_DIM>& config, int num_threads) {
+  if (config.fuse_relu) {
+    warmupConv<SPATIAL_DIM, true>(config, num_threads);
+  } else {
+    warmupConv<SPATIAL_DIM, false>(config, num_threads);
+  }
+}
+
+} // namespace
+
+std::future<void> fbgemmWarmup(
+    const WarmupManifest& manifest,
+    int num_threads) {
+  std::vector<std::function<void()>> tasks;
+  for (const auto& shape : manifest.gemms) {
+    if (shape.acc16) {
+      tasks.emplace_back([shape]() { warmupGemm<std::int16_t>(shape); });
+    } else {
+      tasks.emplace_back([shape]() { warmupGemm<std::int32_t>(shape); });
+    }
+  }
+  for (const auto& config : manifest.embeddings) {
+    tasks.emplace_back([config]() { warmupEmbedding(config); });
+  }
+  const int conv_num_threads = manifest.conv_num_threads;
+  for (const auto& config : manifest.convs_2d) {
+    tasks.emplace_back(
+        [config, conv_num_threads]() { warmupConv(config, conv_num_threads); });
+  }
+  for (const auto& config : manifest.convs_3d) {
+    tasks.emplace_back(
+        [config, conv_num_threads]() { warmupConv(config, conv_num_threads); });
+  }
+
+  if (num_threads <= 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  num_threads = std::min<int>(num_threads, std::max<int>(tasks.size(), 1));
+
+  return std::async(
+      std::launch::async, [tasks = std::move(tasks), num_threads]() {
+        std::atomic<std::size_t> next{0};
+        std::mutex error_mutex;
+        std::exception_ptr error;
+
+        auto worker = [&]() {
+          for (std::size_t i = next++; i < tasks.size(); i = next++) {
+            try {
+              tasks[i]();
+            } catch (...) {
+              std::unique_lock<std::mutex> lock(error_mutex);
+              if (!error) {
+                error = std::current_exception();
+              }
+            }
+          }
+        };
+
+        std::vector<std::thread> workers;
+        for (int t = 1; t < num_threads; ++t) {
+          workers.emplace_back(worker);
+        }
+        worker();
+        for (auto& w : workers) {
+          w.join();
+        }
+        if (error) {
+          std::rethrow_exception(error);
+        }
+      });
+}
+
+} // namespace fbgemm
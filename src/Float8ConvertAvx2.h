@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+#include <immintrin.h>
+#include <cmath>
+#include <cstdint>
+
+namespace fbgemm {
+
+namespace internal {
+
+// Conversions of 8 floats at a time from and to float8 with the given number
+// of exponent bits and exponent bias, bitwise identical to FloatToFloat8_ref
+// and Float8ToFloat_ref. See them for the details of the algorithm.
+class Float8ConvertAvx2 {
+ public:
+  Float8ConvertAvx2(int exponent_bits, int exponent_bias) {
+    const int mantissa_bits = 7 - exponent_bits;
+    max_pos_ = (1 << ((1 << exponent_bits) - 2 - exponent_bias)) *
+        (2 - std::pow(2, exponent_bits - 7));
+    max_pos_v_ = _mm256_set1_ps(max_pos_);
+    smallest_normal_v_ = _mm256_castsi256_ps(
+        _mm256_set1_epi32((127 - exponent_bias + 1) << 23));
+    bouncer_exponent_v_ = _mm256_set1_epi32((23 - mantissa_bits) << 23);
+    exponent_rebias_v_ = _mm256_set1_epi32((127 - exponent_bias) << 23);
+    exponent_shift_ = _mm_cvtsi32_si128(8 - exponent_bits);
+    denormal_bouncer_v_ = _mm256_castsi256_ps(_mm256_set1_epi32(
+        (127 + (23 + (1 - exponent_bias - mantissa_bits))) << 23));
+    mantissa_shift_ = _mm_cvtsi32_si128(24 - (8 - exponent_bits));
+    multiplier_v_ = _mm256_castsi256_ps(
+        _mm256_set1_epi32((127 + (127 - exponent_bias)) << 23));
+  }
+
+  // Largest finite float8 value
+  float maxPos() const {
+    return max_pos_;
+  }
+
+  // float8 values in the low byte of each 32 bit lane
+  __m256i fromFloat(__m256 x) const {
+    const __m256i sign_mask_v = _mm256_set1_epi32(0x80000000);
+    const __m256i sign_v =
+        _mm256_and_si256(_mm256_castps_si256(x), sign_mask_v);
+    // NaNs become max_pos as with fminf
+    const __m256 val_v = _mm256_min_ps(
+        _mm256_andnot_ps(_mm256_castsi256_ps(sign_mask_v), x), max_pos_v_);
+    const __m256i val_i = _mm256_castps_si256(val_v);
+
+    // Normal numbers are rounded to nearest even by adding and subtracting a
+    // bouncer, then the exponent is rebiased
+    const __m256 bouncer_v = _mm256_castsi256_ps(_mm256_add_epi32(
+        _mm256_and_si256(val_i, _mm256_set1_epi32(0xFF800000)),
+        bouncer_exponent_v_));
+    __m256i normal_v = _mm256_castps_si256(
+        _mm256_sub_ps(_mm256_add_ps(bouncer_v, val_v), bouncer_v));
+    normal_v = _mm256_sll_epi32(
+        _mm256_sub_epi32(normal_v, exponent_rebias_v_), exponent_shift_);
+    normal_v = _mm256_srli_epi32(_mm256_or_si256(normal_v, sign_v), 24);
+
+    // Denormal numbers are fixed point, whose bits are in the low byte after
+    // adding the bouncer
+    __m256i denormal_v =
+        _mm256_castps_si256(_mm256_add_ps(denormal_bouncer_v_, val_v));
+    denormal_v = _mm256_and_si256(
+        _mm256_or_si256(denormal_v, _mm256_srli_epi32(sign_v, 24)),
+        _mm256_set1_epi32(0xFF));
+
+    return _mm256_blendv_epi8(
+        denormal_v,
+        normal_v,
+        _mm256_castps_si256(
+            _mm256_cmp_ps(val_v, smallest_normal_v_, _CMP_GE_OQ)));
+  }
+
+  // x holds float8 values in the low byte of each 32 bit lane
+  __m256 toFloat(__m256i x) const {
+    const __m256i sign_v =
+        _mm256_slli_epi32(_mm256_and_si256(x, _mm256_set1_epi32(0x80)), 24);
+    const __m256i val_v = _mm256_sll_epi32(
+        _mm256_and_si256(x, _mm256_set1_epi32(0x7F)), mantissa_shift_);
+    return _mm256_or_ps(
+        _mm256_mul_ps(_mm256_castsi256_ps(val_v), multiplier_v_),
+        _mm256_castsi256_ps(sign_v));
+  }
+
+  static __m256i load(const std::uint8_t* src) {
+    return _mm256_cvtepu8_epi32(
+        _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src)));
+  }
+
+  static void store(std::uint8_t* dst, __m256i x) {
+    // clang-format off
+    const __m256i shuffle_mask_v = _mm256_set_epi8(
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 12, 8, 4, 0,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 12, 8, 4, 0);
+    // clang-format on
+    const __m256i packed_v = _mm256_shuffle_epi8(x, shuffle_mask_v);
+    _mm_storel_epi64(
+        reinterpret_cast<__m128i*>(dst),
+        _mm_unpacklo_epi32(
+            _mm256_castsi256_si128(packed_v),
+            _mm256_extracti128_si256(packed_v, 1)));
+  }
+
+ private:
+  float max_pos_;
+  __m256 max_pos_v_;
+  __m256 smallest_normal_v_;
+  __m256i bouncer_exponent_v_;
+  __m256i exponent_rebias_v_;
+  __m128i exponent_shift_;
+  __m256 denormal_bouncer_v_;
+  __m128i mantissa_shift_;
+  __m256 multiplier_v_;
+};
+
+} // namespace internal
+
+} // namespace fbgemm
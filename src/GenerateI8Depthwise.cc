@@ -15,6 +15,7 @@
 
 #include "./CodeCache.h"
 #include "./CodeGenHelpers.h"
+#include "./CodeStorage.h"
 #include "fbgemm/Utils.h"
 
 namespace fbgemm {
@@ -32,13 +33,28 @@ asmjit::JitRuntime& runtime() {
 std::mutex rtMutex_;
 
 // The hash depends on D, K_T, K_H, K_W, oc_per_g, compute_a_sum,
-// remainder, prev_skip, next_skip, top_skip, bottom_skip, left_skip, and
-// right_skip.
+// remainder, prev_skip, next_skip, top_skip, bottom_skip, left_skip,
+// right_skip, and the dilations.
 CodeCache<
-    std::
-        tuple<int, int, int, int, int, bool, int, int, int, int, int, int, int>,
+    std::tuple<
+        int,
+        int,
+        int,
+        int,
+        int,
+        bool,
+        int,
+        int,
+        int,
+        int,
+        int,
+        int,
+        int,
+        int,
+        int,
+        int>,
     GenI8Depthwise::jit_kernel_signature>
-    codeCache_;
+    codeCache_("depthwise");
 } // namespace
 
 namespace x86 = asmjit::x86;
@@ -186,8 +202,25 @@ GenI8Depthwise::jit_kernel_signature GenI8Depthwise::getOrCreate(
     int top_skip,
     int bottom_skip,
     int left_skip,
-    int right_skip) {
-  std::tuple<int, int, int, int, int, bool, int, int, int, int, int, int, int>
+    int right_skip,
+    std::array<int, 3> dilation) {
+  std::tuple<
+      int,
+      int,
+      int,
+      int,
+      int,
+      bool,
+      int,
+      int,
+      int,
+      int,
+      int,
+      int,
+      int,
+      int,
+      int,
+      int>
       kernelSig = std::make_tuple(
           D,
           F[0],
@@ -201,9 +234,19 @@ GenI8Depthwise::jit_kernel_signature GenI8Depthwise::getOrCreate(
           top_skip,
           bottom_skip,
           left_skip,
-          right_skip);
+          right_skip,
+          dilation[0],
+          dilation[1],
+          dilation[2]);
 
   return codeCache_.getOrCreate(kernelSig, [&]() -> jit_kernel_signature {
+    jit_kernel_signature fn;
+    const std::string jitKey =
+        getJitCacheKey("depthwise", inst_set_t::avx2, kernelSig);
+    if (loadJitKernel(runtime(), rtMutex_, jitKey, &fn)) {
+      return fn;
+    }
+
     asmjit::CodeHolder code;
     code.init(runtime().environment());
     x86::Assembler assembler(&code);
@@ -241,6 +284,12 @@ GenI8Depthwise::jit_kernel_signature GenI8Depthwise::getOrCreate(
     if (right_skip) {
       filename += "_right_skip" + std::to_string(right_skip);
     }
+    for (int i = 3 - D; i < 3; ++i) {
+      if (dilation[i] > 1) {
+        filename += "_dilation" + std::to_string(i) + "_" +
+            std::to_string(dilation[i]);
+      }
+    }
     filename += ".txt";
     FILE* codeLogFile = fopen(filename.c_str(), "w");
     asmjit::FileLogger* codeLogger = new asmjit::FileLogger(codeLogFile);
@@ -259,6 +308,9 @@ GenI8Depthwise::jit_kernel_signature GenI8Depthwise::getOrCreate(
     x86::Gp b_zero_point_addr = e->gpz(13);
     x86::Gp ic_loop_count = e->gpz(14);
     x86::Gp a_addr_save = e->gpz(15);
+    // Distance between the input pixels of horizontally adjacent filter
+    // taps. Without dilation, this is just ic.
+    x86::Gp pixel_stride = dilation[2] > 1 ? e->zax() : ic;
 
     asmjit::FuncDetail func;
     func.init(
@@ -370,13 +422,24 @@ GenI8Depthwise::jit_kernel_signature GenI8Depthwise::getOrCreate(
     e->imul(w, ic);
     e->imul(h, w);
     if (D >= 3) {
+      if (dilation[0] > 1) {
+        e->imul(h, dilation[0]);
+      }
       e->mov(a_addr_save, w);
-      e->imul(a_addr_save, F[1]);
-      e->sub(h, a_addr_save); // h * w * ic - F[1] * w * ic
+      e->imul(a_addr_save, F[1] * dilation[1]);
+      // d_t * h * w * ic - F[1] * d_h * w * ic
+      e->sub(h, a_addr_save);
+    }
+    if (dilation[1] > 1) {
+      e->imul(w, dilation[1]);
     }
     e->mov(a_addr_save, ic);
-    e->imul(a_addr_save, F[2]);
-    e->sub(w, a_addr_save); // w * ic - F[2] * ic
+    e->imul(a_addr_save, F[2] * dilation[2]);
+    e->sub(w, a_addr_save); // d_h * w * ic - F[2] * d_w * ic
+    if (dilation[2] > 1) {
+      e->mov(pixel_stride, ic);
+      e->imul(pixel_stride, dilation[2]);
+    }
 
     e->mov(ic_loop_count, ic);
     e->add(ic_loop_count, asmjit::Imm(32 / oc_per_g - 1));
@@ -483,7 +546,7 @@ GenI8Depthwise::jit_kernel_signature GenI8Depthwise::getOrCreate(
               }
             }
             if (i != K - 1) {
-              e->add(a_addr, ic); // advance to next pixel
+              e->add(a_addr, pixel_stride); // advance to next pixel
             }
           }
           if (i != K - 1) {
@@ -557,12 +620,7 @@ GenI8Depthwise::jit_kernel_signature GenI8Depthwise::getOrCreate(
 
     e->emitEpilog(frame);
 
-    jit_kernel_signature fn;
-    asmjit::Error err;
-    {
-      std::unique_lock<std::mutex> lock(rtMutex_);
-      err = runtime().add(&fn, &code);
-    }
+    asmjit::Error err = addJitKernel(runtime(), rtMutex_, &fn, code, jitKey);
     if (err) {
       std::cout << "Error: in fn add" << std::endl;
       return nullptr;
@@ -37,7 +37,9 @@ class GenI8Depthwise {
       int top_skip,
       int bottom_skip,
       int left_skip,
-      int right_skip);
+      int right_skip,
+      // dilation (dilation_t, dilation_h, dilation_w)
+      std::array<int, 3> dilation = {1, 1, 1});
 };
 
 } // namespace fbgemm
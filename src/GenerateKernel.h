@@ -156,6 +156,6 @@ template <typename TA, typename TB, typename TC, typename accT>
 CodeCache<
     std::tuple<bool, int, int, int, int, int, int>,
     typename CodeGenBase<TA, TB, TC, accT>::jit_micro_kernel_fp>
-    CodeGenBase<TA, TB, TC, accT>::codeCache_;
+    CodeGenBase<TA, TB, TC, accT>::codeCache_("gemm");
 
 } // namespace fbgemm
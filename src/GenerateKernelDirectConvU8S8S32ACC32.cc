@@ -8,6 +8,7 @@
 
 #include <iostream>
 #include "./CodeGenHelpers.h"
+#include "./CodeStorage.h"
 #include "./DirectConv.h"
 
 namespace fbgemm {
@@ -403,11 +404,7 @@ DirectConvCodeGenBase<uint8_t, int8_t, int32_t, int32_t>::getOrCreateDirectConv(
     a->emitEpilog(frame);
 
     jit_micro_kernel_fp fn;
-    asmjit::Error err;
-    {
-      std::unique_lock<std::mutex> lock(rtMutex_);
-      err = runtime().add(&fn, &code);
-    }
+    asmjit::Error err = addJitKernel(runtime(), rtMutex_, &fn, code);
     if (err) {
       std::cout << "Error: in fn add" << std::endl;
       return nullptr;
@@ -773,11 +770,7 @@ DirectConvCodeGenBase<uint8_t, int8_t, int32_t, int32_t>::
     a->emitEpilog(frame);
 
     jit_micro_kernel_fp_convT fn;
-    asmjit::Error err;
-    {
-      std::unique_lock<std::mutex> lock(rtMutex_);
-      err = runtime().add(&fn, &code);
-    }
+    asmjit::Error err = addJitKernel(runtime(), rtMutex_, &fn, code);
     if (err) {
       std::cout << "Error: in fn add" << std::endl;
       return nullptr;
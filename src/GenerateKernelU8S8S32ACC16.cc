@@ -8,6 +8,7 @@
 
 #include <iostream>
 #include "./CodeGenHelpers.h"
+#include "./CodeStorage.h"
 #include "./GenerateKernel.h"
 
 namespace fbgemm {
@@ -138,6 +139,13 @@ CodeGenBase<uint8_t, int8_t, int32_t, int16_t>::getOrCreate<inst_set_t::avx2>(
       accum, mc, nc, nBlock, kBlock, mRegBlockSize, nRegBlockSize);
 
   return codeCache_.getOrCreate(kernelSig, [&]() -> jit_micro_kernel_fp {
+    jit_micro_kernel_fp fn;
+    const std::string jitKey =
+        getJitCacheKey("gemm_acc16", inst_set_t::avx2, kernelSig);
+    if (loadJitKernel(runtime(), rtMutex_, jitKey, &fn)) {
+      return fn;
+    }
+
     asmjit::CodeHolder code;
     code.init(runtime().environment());
     x86::Assembler assembler(&code);
@@ -323,12 +331,7 @@ CodeGenBase<uint8_t, int8_t, int32_t, int16_t>::getOrCreate<inst_set_t::avx2>(
 
     a->emitEpilog(frame);
 
-    jit_micro_kernel_fp fn;
-    asmjit::Error err;
-    {
-      std::unique_lock<std::mutex> lock(rtMutex_);
-      err = runtime().add(&fn, &code);
-    }
+    asmjit::Error err = addJitKernel(runtime(), rtMutex_, &fn, code, jitKey);
     if (err) {
       std::cout << "Error: in fn add" << std::endl;
       return nullptr;
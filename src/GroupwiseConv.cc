@@ -17,6 +17,7 @@
 #include <tuple>
 #include <type_traits>
 #include "./CodeGenHelpers.h"
+#include "./CodeStorage.h"
 #include "./RefImplementations.h"
 #include "./TransposeUtils.h"
 #include "fbgemm/Fbgemm.h"
@@ -301,11 +302,8 @@ jit_conv_kernel_fp GenConvKernel<SPATIAL_DIM, INST_SET>::getOrCreate() {
   a->emitEpilog(frame_);
 
   jit_conv_kernel_fp fn;
-  asmjit::Error err;
-  {
-    unique_lock<mutex> lock(this->rtMutex_);
-    err = this->runtime().add(&fn, &code);
-  }
+  asmjit::Error err =
+      addJitKernel(this->runtime(), this->rtMutex_, &fn, code);
 
   if (err) {
     cout << "Error: in fn add" << endl;
@@ -971,6 +969,60 @@ void dispatchOutputProcessing(
 #undef REQUANTIZE_BIAS
 #undef REQUANTIZE_BASE
 
+namespace {
+
+// Splits the work of a groupwise convolution between threads. The work is
+// split over whole images when there are at least as many images as
+// threads, then over (image, group block) pairs. Only when that still
+// leaves threads idle, e.g., batch-1 inference with few groups, are the
+// output rows of each pair split as well. The JIT'ed kernels handle any
+// band of output rows and read the halo input rows above and below it, so
+// no input is copied. Calls f(image, g_begin, g_end, oh_start, oh_end) for
+// each contiguous piece of work assigned to thread_id.
+template <typename F>
+void forEachGConvPartition(
+    int thread_id,
+    int num_threads,
+    int MB,
+    int G,
+    int G_together,
+    int OH,
+    F&& f) {
+  int g_parts = 1;
+  int oh_parts = 1;
+  if (MB < num_threads && G % G_together == 0) {
+    g_parts = G / G_together;
+  }
+  if (static_cast<int64_t>(MB) * g_parts < num_threads) {
+    oh_parts = OH;
+  }
+
+  int64_t item_begin, item_end;
+  fbgemmPartition1D(
+      thread_id,
+      num_threads,
+      static_cast<int64_t>(MB) * g_parts * oh_parts,
+      item_begin,
+      item_end);
+
+  int g_per_part = G / g_parts;
+  for (int64_t item = item_begin; item < item_end;) {
+    int64_t pair = item / oh_parts;
+    int i = pair / g_parts;
+    int g_begin = pair % g_parts * g_per_part;
+    int oh = item % oh_parts;
+    int64_t pair_end = std::min(item_end, (pair + 1) * oh_parts);
+    if (oh_parts == 1) {
+      f(i, g_begin, g_begin + g_per_part, 0, OH);
+    } else {
+      f(i, g_begin, g_begin + g_per_part, oh, oh + (pair_end - item));
+    }
+    item = pair_end;
+  }
+}
+
+} // namespace
+
 template <
     typename packed_W,
     typename outType,
@@ -1029,123 +1081,121 @@ void fbgemmGroupwiseConv(
     throw std::runtime_error("Groupwise 1D not implemented!");
   }
   if (SPATIAL_DIM == 2) {
-    // Parallelization:
-    int64_t batch_start = 0;
-    int64_t batch_end = MB;
-    int64_t oh_start = 0;
-    int64_t oh_end = OH;
-    if (MB >= num_threads) {
-      fbgemmPartition1D(thread_id, num_threads, MB, batch_start, batch_end);
-    } else {
-      fbgemmPartition1D(thread_id, num_threads, OH, oh_start, oh_end);
-    }
-
-    if (batch_start >= batch_end || oh_start >= oh_end) {
-      // There is no work for this thread
-      return;
-    }
-
+    forEachGConvPartition(
+        thread_id,
+        num_threads,
+        MB,
+        G,
+        G_together,
+        OH,
+        [&](int i, int g_begin, int g_end, int oh_start, int oh_end) {
 #if defined(__x86_64__) || defined(__i386__) || \
     (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
-    // generate convolution  + rowOffset kernel
-    bool calculateRowOffset = !b_symmetric;
-    bool isTopEdgeIncluded = oh_start == 0;
-    bool isBottomEdgeIncluded = oh_end == OH;
-    bool isTopBottomEdgeSame =
-        isTopEdgeIncluded && isBottomEdgeIncluded && oh_end == oh_start + 1;
-    jit_conv_kernel_fp fpConv = getOrCreateConvKernel<SPATIAL_DIM>(
-        conv_param,
-        a_zero_point,
-        calculateRowOffset,
-        isTopEdgeIncluded,
-        isBottomEdgeIncluded,
-        isTopBottomEdgeSame,
-        false);
+          // generate convolution  + rowOffset kernel
+          bool calculateRowOffset = !b_symmetric;
+          bool isTopEdgeIncluded = oh_start == 0;
+          bool isBottomEdgeIncluded = oh_end == OH;
+          bool isTopBottomEdgeSame = isTopEdgeIncluded &&
+              isBottomEdgeIncluded && oh_end == oh_start + 1;
+          jit_conv_kernel_fp fpConv = getOrCreateConvKernel<SPATIAL_DIM>(
+              conv_param,
+              a_zero_point,
+              calculateRowOffset,
+              isTopEdgeIncluded,
+              isBottomEdgeIncluded,
+              isTopBottomEdgeSame,
+              false);
 #endif
 
-    int ih_start = 0;
-    if (oh_start > 0) {
-      ih_start = -conv_param.pad[SPATIAL_DIM - 2] +
-          oh_start * conv_param.stride[SPATIAL_DIM - 2];
-    }
-    int32_t* out_start = outBuffer + oh_start * OW * OC;
-    const uint8_t* in_start = activations + ih_start * IW * IC;
-    int32_t* rowOffsetBuf_start =
-        rowOffsetBuf ? rowOffsetBuf + oh_start * OW * G_together : nullptr;
-    for (int i = batch_start; i < batch_end; ++i) {
-      const uint8_t* in_start_batch = in_start + i * IH_IW * conv_param.IC;
-      int32_t* out_start_batch = out_start + i * OH_OW * OC;
-      int32_t* rowOffsetBuf_start_batch =
-          rowOffsetBuf ? rowOffsetBuf_start + i * OH_OW * G_together : nullptr;
-      for (int g = 0; g < G; g += G_together) {
-        const uint8_t* in_start_group = in_start_batch + g * C_per_G;
-        int8_t* weight_start =
-            packed_weights.getBuf() + g * R * S * K_per_G * paddedCPerG;
-        int32_t* out_start_group = out_start_batch;
-        int32_t* rowOffsetBuf_start_group = rowOffsetBuf_start_batch;
-        // Uncomment the following two lines to stop
-        // reuse of output and rowoffset buffer
-        // out_start_group = out_start_batch + g * K_per_G;
-        // rowOffsetBuf_start_group = rowOffsetBuf_start_batch + g * MB * OH_OW;
-
-        // exactly the same compute as the JIT'ed below
-        // kernel_compute(
-        //    conv_param,
-        //    in_start_group,
-        //    weight_start,
-        //    out_start_group,
-        //    a_zero_point,
-        //    oh_start,
-        //    oh_end,
-        //    OW,
-        //    rowOffsetBuf_start_group);
+          int ih_start = 0;
+          if (oh_start > 0) {
+            ih_start = -conv_param.pad[SPATIAL_DIM - 2] +
+                oh_start * conv_param.stride[SPATIAL_DIM - 2];
+          }
+          int32_t* out_start = outBuffer + oh_start * OW * OC;
+          const uint8_t* in_start = activations + ih_start * IW * IC;
+          int32_t* rowOffsetBuf_start = rowOffsetBuf
+              ? rowOffsetBuf + oh_start * OW * G_together
+              : nullptr;
+          const uint8_t* in_start_batch =
+              in_start + i * IH_IW * conv_param.IC;
+          int32_t* out_start_batch = out_start + i * OH_OW * OC;
+          int32_t* rowOffsetBuf_start_batch = rowOffsetBuf
+              ? rowOffsetBuf_start + i * OH_OW * G_together
+              : nullptr;
+          // Other threads may work on the other groups of the same rows.
+          bool reuseBuffers = g_begin == 0 && g_end == G;
+          for (int g = g_begin; g < g_end; g += G_together) {
+            const uint8_t* in_start_group = in_start_batch + g * C_per_G;
+            int8_t* weight_start =
+                packed_weights.getBuf() + g * R * S * K_per_G * paddedCPerG;
+            int32_t* out_start_group = out_start_batch;
+            int32_t* rowOffsetBuf_start_group = rowOffsetBuf_start_batch;
+            if (!reuseBuffers) {
+              out_start_group = out_start_batch + g * K_per_G;
+              rowOffsetBuf_start_group = rowOffsetBuf
+                  ? rowOffsetBuf_start_batch + g * MB * OH_OW
+                  : nullptr;
+            }
+
+            // exactly the same compute as the JIT'ed below
+            // kernel_compute(
+            //    conv_param,
+            //    in_start_group,
+            //    weight_start,
+            //    out_start_group,
+            //    a_zero_point,
+            //    oh_start,
+            //    oh_end,
+            //    OW,
+            //    rowOffsetBuf_start_group);
 #if defined(__x86_64__) || defined(__i386__) || \
     (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
-        fpConv(
-            in_start_group,
-            weight_start,
-            out_start_group,
-            a_zero_point,
-            oh_start,
-            oh_end,
-            OW,
-            rowOffsetBuf_start_group);
+            fpConv(
+                in_start_group,
+                weight_start,
+                out_start_group,
+                a_zero_point,
+                oh_start,
+                oh_end,
+                OW,
+                rowOffsetBuf_start_group);
 #else
-        kernel_compute(
-            conv_param,
-            in_start_group,
-            weight_start,
-            out_start_group,
-            a_zero_point,
-            oh_start,
-            oh_end,
-            OW,
-            rowOffsetBuf_start_group,
-            false);
+            kernel_compute(
+                conv_param,
+                in_start_group,
+                weight_start,
+                out_start_group,
+                a_zero_point,
+                oh_start,
+                oh_end,
+                OW,
+                rowOffsetBuf_start_group,
+                false);
 #endif
 
-        const int32_t* inp = out_start_group;
-        block_type_t block{
-            static_cast<int>(i * OT_OH_OW + oh_start * OW),
-            static_cast<int>((oh_end - oh_start) * OW),
-            g * K_per_G,
-            G_together * K_per_G};
-        int ld_out = G * K_per_G;
-        int ld_in = G * K_per_G;
-
-        dispatchOutputProcessing(
-            outProcess,
-            rowOffsetBuf_start_group,
-            out,
-            inp,
-            block,
-            ld_out,
-            ld_in,
-            G,
-            C_per_G,
-            is_requantization<processOutputType>());
-      } // for each g
-    } // for each i
+            const int32_t* inp = out_start_group;
+            block_type_t block{
+                static_cast<int>(i * OT_OH_OW + oh_start * OW),
+                static_cast<int>((oh_end - oh_start) * OW),
+                g * K_per_G,
+                G_together * K_per_G};
+            int ld_out = G * K_per_G;
+            int ld_in = G * K_per_G;
+
+            dispatchOutputProcessing(
+                outProcess,
+                rowOffsetBuf_start_group,
+                out,
+                inp,
+                block,
+                ld_out,
+                ld_in,
+                G,
+                C_per_G,
+                is_requantization<processOutputType>());
+          } // for each g
+        });
   } else {
     assert(SPATIAL_DIM == 3 && "Unsupported SPATIAL_DIM");
 
@@ -1164,153 +1214,150 @@ void fbgemmGroupwiseConv(
          conv_param.pad[4],
          conv_param.pad[5]});
 
-    // Parallelization:
-    int64_t batch_start = 0;
-    int64_t batch_end = MB;
-    int64_t oh_start = 0;
-    int64_t oh_end = OH;
-    if (MB >= num_threads) {
-      fbgemmPartition1D(thread_id, num_threads, MB, batch_start, batch_end);
-    } else {
-      fbgemmPartition1D(thread_id, num_threads, OH, oh_start, oh_end);
-    }
-
-    if (batch_start >= batch_end || oh_start >= oh_end) {
-      // There is no work for this thread
-      return;
-    }
-
+    vector<uint8_t> zero_points(IH * IW * IC, a_zero_point);
+    forEachGConvPartition(
+        thread_id,
+        num_threads,
+        MB,
+        G,
+        G_together,
+        OH,
+        [&](int i, int g_begin, int g_end, int oh_start, int oh_end) {
 #if defined(__x86_64__) || defined(__i386__) || \
     (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
-    // generate convolution  + rowOffset kernel
-    bool calculateRowOffset = !b_symmetric;
-    bool isTopEdgeIncluded = oh_start == 0;
-    bool isBottomEdgeIncluded = oh_end == OH;
-    bool isTopBottomEdgeSame =
-        isTopEdgeIncluded && isBottomEdgeIncluded && oh_end == oh_start + 1;
-    jit_conv_kernel_fp fpConvNoAccum = getOrCreateConvKernel<2>(
-        conv_p_2d,
-        a_zero_point,
-        calculateRowOffset,
-        isTopEdgeIncluded,
-        isBottomEdgeIncluded,
-        isTopBottomEdgeSame,
-        false);
-    jit_conv_kernel_fp fpConvAccum = getOrCreateConvKernel<2>(
-        conv_p_2d,
-        a_zero_point,
-        calculateRowOffset,
-        isTopEdgeIncluded,
-        isBottomEdgeIncluded,
-        isTopBottomEdgeSame,
-        true);
-    jit_conv_kernel_fp fpConv;
+          // generate convolution  + rowOffset kernel
+          bool calculateRowOffset = !b_symmetric;
+          bool isTopEdgeIncluded = oh_start == 0;
+          bool isBottomEdgeIncluded = oh_end == OH;
+          bool isTopBottomEdgeSame = isTopEdgeIncluded &&
+              isBottomEdgeIncluded && oh_end == oh_start + 1;
+          jit_conv_kernel_fp fpConvNoAccum = getOrCreateConvKernel<2>(
+              conv_p_2d,
+              a_zero_point,
+              calculateRowOffset,
+              isTopEdgeIncluded,
+              isBottomEdgeIncluded,
+              isTopBottomEdgeSame,
+              false);
+          jit_conv_kernel_fp fpConvAccum = getOrCreateConvKernel<2>(
+              conv_p_2d,
+              a_zero_point,
+              calculateRowOffset,
+              isTopEdgeIncluded,
+              isBottomEdgeIncluded,
+              isTopBottomEdgeSame,
+              true);
+          jit_conv_kernel_fp fpConv;
 #endif
 
-    int ih_start = 0;
-    if (oh_start > 0) {
-      ih_start = -conv_p_2d.pad[0] + oh_start * conv_p_2d.stride[0];
-    }
+          int ih_start = 0;
+          if (oh_start > 0) {
+            ih_start = -conv_p_2d.pad[0] + oh_start * conv_p_2d.stride[0];
+          }
 
-    vector<uint8_t> zero_points(IH * IW * IC, a_zero_point);
-    int32_t* out_start = outBuffer + oh_start * OW * OC;
-    const uint8_t* in_start = activations + ih_start * IW * IC;
-    int32_t* rowOffsetBuf_start =
-        rowOffsetBuf ? rowOffsetBuf + oh_start * OW * G_together : nullptr;
-    for (int i = batch_start; i < batch_end; ++i) {
-      const uint8_t* in_start_batch = in_start + i * IT_IH_IW * IC;
-      int32_t* out_start_batch = out_start + i * OT_OH_OW * OC;
-      int32_t* rowOffsetBuf_start_batch = rowOffsetBuf
-          ? rowOffsetBuf_start + i * OT_OH_OW * G_together
-          : nullptr;
-      for (int g = 0; g < G; g += G_together) {
-        const uint8_t* in_start_group = in_start_batch + g * C_per_G;
-        int8_t* weight_start =
-            packed_weights.getBuf() + g * T * R * S * K_per_G * paddedCPerG;
-        int32_t* out_start_group = out_start_batch;
-        int32_t* rowOffsetBuf_start_group = rowOffsetBuf_start_batch;
-        // Uncomment the following two lines to stop
-        // reuse of output and rowoffset buffer
-        // out_start_group = out_start_batch + g * K_per_G;
-        // rowOffsetBuf_start_group = rowOffsetBuf_start_batch + g * MB *
-        // OT_OH_OW;
-
-        for (int ot = 0; ot < OT; ++ot) {
-          int32_t* out_start_t = out_start_group + ot * OH_OW * OC;
-          int32_t* rowOffsetBuf_start_t = rowOffsetBuf
-              ? rowOffsetBuf_start_group + ot * OH_OW * G_together
+          int32_t* out_start = outBuffer + oh_start * OW * OC;
+          const uint8_t* in_start = activations + ih_start * IW * IC;
+          int32_t* rowOffsetBuf_start = rowOffsetBuf
+              ? rowOffsetBuf + oh_start * OW * G_together
+              : nullptr;
+          const uint8_t* in_start_batch = in_start + i * IT_IH_IW * IC;
+          int32_t* out_start_batch = out_start + i * OT_OH_OW * OC;
+          int32_t* rowOffsetBuf_start_batch = rowOffsetBuf
+              ? rowOffsetBuf_start + i * OT_OH_OW * G_together
               : nullptr;
-          for (int t = 0; t < T; ++t) {
-            int t_in = -conv_param.pad[0] + ot * conv_param.stride[0] + t;
-            const uint8_t* in_start_t = in_start_group + t_in * IH_IW * IC;
-            int8_t* weight_start_t =
-                weight_start + t * R * S * K_per_G * G_together * paddedCPerG;
-            if (t_in < 0 || t_in >= IT) {
-              in_start_t = zero_points.data();
+          // Other threads may work on the other groups of the same rows.
+          bool reuseBuffers = g_begin == 0 && g_end == G;
+          for (int g = g_begin; g < g_end; g += G_together) {
+            const uint8_t* in_start_group = in_start_batch + g * C_per_G;
+            int8_t* weight_start = packed_weights.getBuf() +
+                g * T * R * S * K_per_G * paddedCPerG;
+            int32_t* out_start_group = out_start_batch;
+            int32_t* rowOffsetBuf_start_group = rowOffsetBuf_start_batch;
+            if (!reuseBuffers) {
+              out_start_group = out_start_batch + g * K_per_G;
+              rowOffsetBuf_start_group = rowOffsetBuf
+                  ? rowOffsetBuf_start_batch + g * MB * OT_OH_OW
+                  : nullptr;
             }
-            // exactly the same compute as the JIT'ed below
-            // kernel_compute(
-            // conv_p_2d,
-            // in_start_t,
-            // weight_start_t,
-            // out_start_t,
-            // a_zero_point,
-            // oh_start,
-            // oh_end,
-            // OW,
-            // rowOffsetBuf_start_t,
-            // t > 0);
+
+            for (int ot = 0; ot < OT; ++ot) {
+              int32_t* out_start_t = out_start_group + ot * OH_OW * OC;
+              int32_t* rowOffsetBuf_start_t = rowOffsetBuf
+                  ? rowOffsetBuf_start_group + ot * OH_OW * G_together
+                  : nullptr;
+              for (int t = 0; t < T; ++t) {
+                int t_in = -conv_param.pad[0] + ot * conv_param.stride[0] +
+                    t * conv_param.dilation[0];
+                const uint8_t* in_start_t =
+                    in_start_group + t_in * IH_IW * IC;
+                int8_t* weight_start_t = weight_start +
+                    t * R * S * K_per_G * G_together * paddedCPerG;
+                if (t_in < 0 || t_in >= IT) {
+                  in_start_t = zero_points.data();
+                }
+                // exactly the same compute as the JIT'ed below
+                // kernel_compute(
+                // conv_p_2d,
+                // in_start_t,
+                // weight_start_t,
+                // out_start_t,
+                // a_zero_point,
+                // oh_start,
+                // oh_end,
+                // OW,
+                // rowOffsetBuf_start_t,
+                // t > 0);
 
 #if defined(__x86_64__) || defined(__i386__) || \
     (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
-            fpConv = t > 0 ? fpConvAccum : fpConvNoAccum;
-            fpConv(
-                in_start_t,
-                weight_start_t,
-                out_start_t,
-                a_zero_point,
-                oh_start,
-                oh_end,
-                OW,
-                rowOffsetBuf_start_t);
+                fpConv = t > 0 ? fpConvAccum : fpConvNoAccum;
+                fpConv(
+                    in_start_t,
+                    weight_start_t,
+                    out_start_t,
+                    a_zero_point,
+                    oh_start,
+                    oh_end,
+                    OW,
+                    rowOffsetBuf_start_t);
 #else
-            kernel_compute(
-                conv_p_2d,
-                in_start_t,
-                weight_start_t,
-                out_start_t,
-                a_zero_point,
-                oh_start,
-                oh_end,
-                OW,
-                rowOffsetBuf_start_t,
-                t > 0);
+                kernel_compute(
+                    conv_p_2d,
+                    in_start_t,
+                    weight_start_t,
+                    out_start_t,
+                    a_zero_point,
+                    oh_start,
+                    oh_end,
+                    OW,
+                    rowOffsetBuf_start_t,
+                    t > 0);
 #endif
-          }
+              }
 
-          const int32_t* inp = out_start_t;
-          block_type_t block{
-              static_cast<int>(i * OT_OH_OW + oh_start * OW),
-              static_cast<int>((oh_end - oh_start) * OW),
-              g * K_per_G,
-              G_together * K_per_G};
-          int ld_out = G * K_per_G;
-          int ld_in = G * K_per_G;
-
-          dispatchOutputProcessing(
-              outProcess,
-              rowOffsetBuf_start_t,
-              out + ot * OH_OW * OC,
-              inp,
-              block,
-              ld_out,
-              ld_in,
-              G,
-              C_per_G,
-              is_requantization<processOutputType>());
-        } // for each ot
-      } // for each g
-    } // for each i
+              const int32_t* inp = out_start_t;
+              block_type_t block{
+                  static_cast<int>(i * OT_OH_OW + oh_start * OW),
+                  static_cast<int>((oh_end - oh_start) * OW),
+                  g * K_per_G,
+                  G_together * K_per_G};
+              int ld_out = G * K_per_G;
+              int ld_in = G * K_per_G;
+
+              dispatchOutputProcessing(
+                  outProcess,
+                  rowOffsetBuf_start_t,
+                  out + ot * OH_OW * OC,
+                  inp,
+                  block,
+                  ld_out,
+                  ld_in,
+                  G,
+                  C_per_G,
+                  is_requantization<processOutputType>());
+            } // for each ot
+          } // for each g
+        });
   } // SPATIAL_DIM == 3
 }
 
@@ -38,7 +38,7 @@ PackAMatrix<T, accT>::PackAMatrix(
     throw std::runtime_error("Failed to initialize cpuinfo!");
   }
   if ((!fbgemmHasAvx512VnniSupport() && !fbgemmHasAvx512Support() &&
-       !fbgemmHasAvx2Support())) {
+       !fbgemmHasAvx2Support() && !fbgemmHasArmNeonSupport())) {
     assert(0 && "unknown architecure");
   }
 
@@ -77,6 +77,11 @@ PackAMatrix<T, accT>::PackAMatrix(
             PackingTraits<T, accT, inst_set_t::avx2>::getMatrixPackAParams();
         break;
 
+      case inst_set_t::anyarch:
+        std::tie(BaseType::brow_, BaseType::bcol_, row_interleave_B_) =
+            PackingTraits<T, accT, inst_set_t::anyarch>::getMatrixPackAParams();
+        break;
+
       default:
         assert(0 && "unknown architecure");
         throw std::runtime_error("unknown architecure");
@@ -92,8 +97,9 @@ PackAMatrix<T, accT>::PackAMatrix(
     BaseType::buf_ = pmat;
   } else {
     BaseType::bufAllocatedHere_ = true;
-    BaseType::buf_ = static_cast<T*>(
-        fbgemmAlignedAlloc(64, BaseType::brow_ * BaseType::bcol_ * sizeof(T)));
+    BaseType::bufBytes_ = BaseType::brow_ * BaseType::bcol_ * sizeof(T);
+    BaseType::buf_ =
+        static_cast<T*>(fbgemmAlignedAlloc(64, BaseType::bufBytes_));
   }
 }
 
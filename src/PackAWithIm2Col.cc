@@ -27,7 +27,8 @@ PackAWithIm2Col<T, accT, SPATIAL_DIM>::PackAWithIm2Col(
     int32_t a_zero_pt,
     int32_t* row_offset,
     bool b_symmetric,
-    const BlockingFactors* params)
+    const BlockingFactors* params,
+    bool implicit_gemm)
     : PackMatrix<PackAWithIm2Col<T, accT, SPATIAL_DIM>, T, accT>(
           conv_p.MB *
               std::accumulate(
@@ -46,12 +47,13 @@ PackAWithIm2Col<T, accT, SPATIAL_DIM>::PackAWithIm2Col(
           params),
       conv_p_(conv_p),
       sdata_(sdata),
-      a_zero_pt_(a_zero_pt) {
+      a_zero_pt_(a_zero_pt),
+      implicit_gemm_(implicit_gemm) {
   if (!cpuinfo_initialize()) {
     throw std::runtime_error("Failed to initialize cpuinfo!");
   }
   if ((!fbgemmHasAvx512VnniSupport() && !fbgemmHasAvx512Support() &&
-       !fbgemmHasAvx2Support())) {
+       !fbgemmHasAvx2Support() && !fbgemmHasArmNeonSupport())) {
     assert(0 && "unknown architecure");
   }
 
@@ -90,6 +92,11 @@ PackAWithIm2Col<T, accT, SPATIAL_DIM>::PackAWithIm2Col(
             PackingTraits<T, accT, inst_set_t::avx2>::getMatrixPackAParams();
         break;
 
+      case inst_set_t::anyarch:
+        std::tie(BaseType::brow_, BaseType::bcol_, row_interleave_B_) =
+            PackingTraits<T, accT, inst_set_t::anyarch>::getMatrixPackAParams();
+        break;
+
       default:
         assert(0 && "unknown architecure");
         throw std::runtime_error("unknown architecure");
@@ -105,8 +112,9 @@ PackAWithIm2Col<T, accT, SPATIAL_DIM>::PackAWithIm2Col(
     BaseType::buf_ = pmat;
   } else {
     BaseType::bufAllocatedHere_ = true;
-    BaseType::buf_ = static_cast<T*>(
-        fbgemmAlignedAlloc(64, BaseType::brow_ * BaseType::bcol_ * sizeof(T)));
+    BaseType::bufBytes_ = BaseType::brow_ * BaseType::bcol_ * sizeof(T);
+    BaseType::buf_ =
+        static_cast<T*>(fbgemmAlignedAlloc(64, BaseType::bufBytes_));
     // aligned_alloc(64, BaseType::brow_ * BaseType::bcol_ * sizeof(T)));
   }
   if (!b_symmetric) {
@@ -218,6 +226,78 @@ void pack_a_with_im2col_opt(
   }
 }
 
+// Fills columns [col_start, col_start + col_size) of im2col row i from an
+// NCHW input. Each run of IC / G columns reads one channel per input plane, so
+// it is gathered with a stride of the plane size.
+template <typename T, int SPATIAL_DIM>
+void pack_a_with_im2col_nchw_row(
+    const conv_param_t<SPATIAL_DIM>& conv_p,
+    int i,
+    int col_start,
+    int col_size,
+    const T* sdata,
+    T* out,
+    int32_t a_zero_pt) {
+  const int ic_per_group = conv_p.IC / conv_p.G;
+  int64_t plane = 1;
+  for (int d = 0; d < SPATIAL_DIM; ++d) {
+    plane *= conv_p.IN_DIM[d];
+  }
+
+  std::array<int, SPATIAL_DIM> o;
+  int n = i;
+  for (int d = SPATIAL_DIM - 1; d >= 0; --d) {
+    o[d] = n % conv_p.OUT_DIM[d];
+    n /= conv_p.OUT_DIM[d];
+  }
+
+  for (int j = col_start; j < col_start + col_size;) {
+    const int c_begin = j % ic_per_group;
+    const int len =
+        std::min(ic_per_group - c_begin, col_start + col_size - j);
+
+    // j = ((g * K[0] + k[0]) * K[1] + k[1] ...) * IC / G + c
+    int g = j / ic_per_group;
+    std::array<int, SPATIAL_DIM> k;
+    for (int d = SPATIAL_DIM - 1; d >= 0; --d) {
+      k[d] = g % conv_p.K[d];
+      g /= conv_p.K[d];
+    }
+
+    bool in_image = true;
+    int64_t pixel = 0;
+    for (int d = 0; d < SPATIAL_DIM; ++d) {
+      int in;
+      if (conv_p.transposed) {
+        const int x = o[d] + conv_p.pad[d] - k[d] * conv_p.dilation[d];
+        in = x / conv_p.stride[d];
+        in_image = in_image && in * conv_p.stride[d] == x;
+      } else {
+        in = -conv_p.pad[d] + o[d] * conv_p.stride[d] +
+            k[d] * conv_p.dilation[d];
+      }
+      in_image = in_image && in >= 0 && in < conv_p.IN_DIM[d];
+      pixel = pixel * conv_p.IN_DIM[d] + in;
+    }
+
+    T* dst = out + (j - col_start);
+    if (in_image) {
+      const T* src = sdata +
+          (static_cast<int64_t>(n) * conv_p.IC + g * ic_per_group + c_begin) *
+              plane +
+          pixel;
+      for (int c = 0; c < len; ++c) {
+        dst[c] = src[c * plane];
+      }
+    } else {
+      // Please note that padding for convolution should be filled with
+      // zero_pt
+      std::memset(dst, a_zero_pt, sizeof(T) * len);
+    }
+    j += len;
+  }
+}
+
 template <typename T, typename accT, int SPATIAL_DIM>
 void PackAWithIm2Col<T, accT, SPATIAL_DIM>::pack(const block_type_t& block) {
   block_type_t block_p = {
@@ -227,11 +307,75 @@ void PackAWithIm2Col<T, accT, SPATIAL_DIM>::pack(const block_type_t& block) {
       (block.col_size + row_interleave_B_ - 1) / row_interleave_B_ *
           row_interleave_B_};
   BaseType::packedBlock(block_p);
-  T* out = BaseType::getBuf();
+  if (implicit_gemm_) {
+    // The macro kernel packs the rows with packPanel.
+    implicit_block_ = block;
+    return;
+  }
+  packRows(block, BaseType::getBuf(), getRowOffsetBuffer());
+}
+
+template <typename T, typename accT, int SPATIAL_DIM>
+void PackAWithIm2Col<T, accT, SPATIAL_DIM>::packPanel(
+    int panel_start,
+    int panel_rows,
+    inpType* out) {
+  assert(panel_start + panel_rows <= implicit_block_.row_size);
+  block_type_t panel = {
+      implicit_block_.row_start + panel_start,
+      panel_rows,
+      implicit_block_.col_start,
+      implicit_block_.col_size};
+  int32_t* row_offset_buf = getRowOffsetBuffer();
+  packRows(
+      panel, out, row_offset_buf ? row_offset_buf + panel_start : nullptr);
+}
+
+template <typename T, typename accT, int SPATIAL_DIM>
+void PackAWithIm2Col<T, accT, SPATIAL_DIM>::packRows(
+    const block_type_t& block,
+    inpType* out,
+    int32_t* row_offset_buf) {
+  block_type_t block_p = {
+      block.row_start,
+      block.row_size,
+      block.col_start,
+      (block.col_size + row_interleave_B_ - 1) / row_interleave_B_ *
+          row_interleave_B_};
   // accumulate into row offset?
   bool row_offset_acc =
       (block.col_start % (this->numCols() / this->numGroups())) != 0;
-  int32_t* row_offset_buf = getRowOffsetBuffer();
+
+  if (conv_p_.input_layout == conv_layout_t::NCHW) {
+    for (int i = block.row_start; i < block.row_start + block.row_size; ++i) {
+      T* out_row = out + (i - block.row_start) * BaseType::blockColSize();
+      pack_a_with_im2col_nchw_row(
+          conv_p_,
+          i,
+          block.col_start,
+          block.col_size,
+          sdata_,
+          out_row,
+          a_zero_pt_);
+
+      // zero fill
+      // Please see the comment in PackAMatrix.cc for zero vs zero_pt fill.
+      if (block_p.col_size > block.col_size) {
+        std::memset(
+            out_row + block.col_size,
+            0,
+            sizeof(T) * (block_p.col_size - block.col_size));
+      }
+
+      if (row_offset_buf) {
+        int32_t row_sum =
+            row_offset_acc ? row_offset_buf[i - block.row_start] : 0;
+        row_sum += reduceAvx2(out_row, block.col_size);
+        row_offset_buf[i - block.row_start] = row_sum;
+      }
+    }
+    return;
+  }
 
   bool point_wise = true;
   for (int d = 0; d < SPATIAL_DIM; ++d) {
@@ -735,6 +879,8 @@ int PackAWithIm2Col<T, accT, SPATIAL_DIM>::rowOffsetBufferSize(
         return PackingTraits<T, accT, inst_set_t::avx512>::MCB;
       } else if (fbgemmHasAvx2Support()) {
         return PackingTraits<T, accT, inst_set_t::avx2>::MCB;
+      } else if (fbgemmHasArmNeonSupport()) {
+        return PackingTraits<T, accT, inst_set_t::anyarch>::MCB;
       } else {
         // TODO: Have default slower path
         assert(0 && "unsupported architecture");
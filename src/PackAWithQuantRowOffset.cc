@@ -55,7 +55,7 @@ PackAWithQuantRowOffset<T, accT>::PackAWithQuantRowOffset(
     throw std::runtime_error("scale's reciprocal cannot be infinity");
   }
   if ((!fbgemmHasAvx512VnniSupport() && !fbgemmHasAvx512Support() &&
-       !fbgemmHasAvx2Support())) {
+       !fbgemmHasAvx2Support() && !fbgemmHasArmNeonSupport())) {
     assert(0 && "unknown architecure");
   }
 
@@ -94,6 +94,11 @@ PackAWithQuantRowOffset<T, accT>::PackAWithQuantRowOffset(
             PackingTraits<T, accT, inst_set_t::avx2>::getMatrixPackAParams();
         break;
 
+      case inst_set_t::anyarch:
+        std::tie(BaseType::brow_, BaseType::bcol_, row_interleave_B_) =
+            PackingTraits<T, accT, inst_set_t::anyarch>::getMatrixPackAParams();
+        break;
+
       default:
         assert(0 && "unknown architecure");
         throw std::runtime_error("unknown architecure");
@@ -111,8 +116,9 @@ PackAWithQuantRowOffset<T, accT>::PackAWithQuantRowOffset(
     BaseType::buf_ = pmat;
   } else {
     BaseType::bufAllocatedHere_ = true;
-    BaseType::buf_ = static_cast<T*>(
-        fbgemmAlignedAlloc(64, BaseType::brow_ * BaseType::bcol_ * sizeof(T)));
+    BaseType::bufBytes_ = BaseType::brow_ * BaseType::bcol_ * sizeof(T);
+    BaseType::buf_ =
+        static_cast<T*>(fbgemmAlignedAlloc(64, BaseType::bufBytes_));
   }
   if (!row_offset_) {
     rowOffsetAllocatedHere = true;
@@ -163,20 +169,21 @@ void PackAWithQuantRowOffset<T, accT>::pack(const block_type_t& block) {
       std::is_same<T, uint8_t>::value,
       "PackAWithQuantRowOffset<T, accT>::pack only works for T == uint8_t");
 
-  // Only scale and zero points are used in QuantizeAvx2
+  // Only scale and zero points are used in QuantizeWithRowOffsetsAvx2
   TensorQuantizationParams qparams;
   qparams.scale = scale_;
   qparams.zero_point = zero_pt_;
 
   for (int i = 0; i < block.row_size; ++i) {
-    QuantizeAvx2(
+    int32_t row_sum;
+    QuantizeWithRowOffsetsAvx2(
         smat_temp + i * ld_temp,
         out + i * BaseType::blockColSize(),
+        1,
         block.col_size,
-        qparams);
-    int32_t row_sum = row_offset_acc ? row_offset_buf[i] : 0;
-    row_sum += reduceAvx2(out + i * BaseType::blockColSize(), block.col_size);
-    row_offset_buf[i] = row_sum;
+        qparams,
+        &row_sum);
+    row_offset_buf[i] = row_offset_acc ? row_offset_buf[i] + row_sum : row_sum;
 
     // zero fill
     // Please see the comment in PackAMatrix.cc on zero vs zero_pt fill.
@@ -242,6 +249,8 @@ int PackAWithQuantRowOffset<T, accT>::rowOffsetBufferSize(
         return PackingTraits<T, accT, inst_set_t::avx512>::MCB;
       } else if (fbgemmHasAvx2Support()) {
         return PackingTraits<T, accT, inst_set_t::avx2>::MCB;
+      } else if (fbgemmHasArmNeonSupport()) {
+        return PackingTraits<T, accT, inst_set_t::anyarch>::MCB;
       } else {
         assert(0 && "unsupported architecture");
         return -1;
@@ -43,7 +43,7 @@ PackAWithRowOffset<T, accT>::PackAWithRowOffset(
     throw std::runtime_error("Failed to initialize cpuinfo!");
   }
   if ((!fbgemmHasAvx512VnniSupport() && !fbgemmHasAvx512Support() &&
-       !fbgemmHasAvx2Support())) {
+       !fbgemmHasAvx2Support() && !fbgemmHasArmNeonSupport())) {
     assert(0 && "unknown architecure");
   }
 
@@ -82,6 +82,11 @@ PackAWithRowOffset<T, accT>::PackAWithRowOffset(
             PackingTraits<T, accT, inst_set_t::avx2>::getMatrixPackAParams();
         break;
 
+      case inst_set_t::anyarch:
+        std::tie(BaseType::brow_, BaseType::bcol_, row_interleave_B_) =
+            PackingTraits<T, accT, inst_set_t::anyarch>::getMatrixPackAParams();
+        break;
+
       default:
         assert(0 && "unknown architecure");
         throw std::runtime_error("unknown architecure");
@@ -99,8 +104,9 @@ PackAWithRowOffset<T, accT>::PackAWithRowOffset(
     BaseType::buf_ = pmat;
   } else {
     BaseType::bufAllocatedHere_ = true;
-    BaseType::buf_ = static_cast<T*>(
-        fbgemmAlignedAlloc(64, BaseType::brow_ * BaseType::bcol_ * sizeof(T)));
+    BaseType::bufBytes_ = BaseType::brow_ * BaseType::bcol_ * sizeof(T);
+    BaseType::buf_ =
+        static_cast<T*>(fbgemmAlignedAlloc(64, BaseType::bufBytes_));
   }
   if (!row_offset_) {
     rowOffsetAllocatedHere = true;
@@ -221,6 +227,8 @@ int PackAWithRowOffset<T, accT>::rowOffsetBufferSize(
         return PackingTraits<T, accT, inst_set_t::avx512>::MCB;
       } else if (fbgemmHasAvx2Support()) {
         return PackingTraits<T, accT, inst_set_t::avx2>::MCB;
+      } else if (fbgemmHasArmNeonSupport()) {
+        return PackingTraits<T, accT, inst_set_t::anyarch>::MCB;
       } else {
         // TODO: Have default slower path
         assert(0 && "unsupported architecture");
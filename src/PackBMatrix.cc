@@ -9,6 +9,7 @@
 #define FBGEMM_EXPORTS
 #include <cpuinfo.h>
 #include <cassert>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
 #include "fbgemm/Fbgemm.h"
@@ -188,6 +189,83 @@ PackBMatrix<T, accT>::PackBMatrix(
       trans_(trans),
       smat_(smat),
       ld_(ld) {
+  initializeBlocking_(params);
+
+  if (BaseType::numRows() % groups != 0) {
+    throw std::runtime_error(
+        "groups = " + std::to_string(groups) +
+        " does not divide numRows = " + std::to_string(BaseType::numRows()));
+  }
+
+  // blocking for one group
+  block_type_t block{
+      0, BaseType::numRows() / BaseType::numGroups(), 0, BaseType::numCols()};
+  BaseType::packedBlock(block);
+  if (!pmat) {
+    BaseType::bufAllocatedHere_ = true;
+    BaseType::bufBytes_ = packedBufferBytes_();
+    BaseType::buf_ =
+        static_cast<T*>(fbgemmAlignedAlloc(64, BaseType::bufBytes_));
+  }
+  pack(block, params);
+}
+
+template <typename T, typename accT>
+PackBMatrix<T, accT>::PackBMatrix(
+    const void* serialized,
+    std::size_t size,
+    const BlockingFactors* params)
+    : PackBMatrix(
+          readPackedMatrixHeader(serialized, size, packedKind_(), sizeof(T)),
+          serialized,
+          params) {}
+
+template <typename T, typename accT>
+PackBMatrix<T, accT>::PackBMatrix(
+    const PackedMatrixHeader& header,
+    const void* serialized,
+    const BlockingFactors* params)
+    : PackMatrix<PackBMatrix<T, accT>, T, accT>(
+          header.rows,
+          header.cols,
+          // Never written, as the matrix is not packed again
+          const_cast<T*>(reinterpret_cast<const T*>(
+              static_cast<const char*>(serialized) + header.data_offset)),
+          header.groups,
+          params),
+      trans_(header.trans),
+      smat_(nullptr) {
+  initializeBlocking_(params);
+  if (header.groups <= 0 || header.rows % header.groups != 0) {
+    throw std::runtime_error(
+        "groups = " + std::to_string(header.groups) +
+        " does not divide numRows = " + std::to_string(header.rows));
+  }
+  if (header.brow != BaseType::brow_ || header.bcol != BaseType::bcol_ ||
+      header.aux != row_interleave_) {
+    throw std::runtime_error(
+        "Packed matrix was blocked for instruction set " +
+        std::to_string(static_cast<int>(header.isa)) + " (KCB = " +
+        std::to_string(header.brow) + ", NCB = " +
+        std::to_string(header.bcol) + ", ROW_INTERLEAVE = " +
+        std::to_string(header.aux) + ") and has to be packed again for " +
+        "KCB = " + std::to_string(BaseType::brow_) +
+        ", NCB = " + std::to_string(BaseType::bcol_) +
+        ", ROW_INTERLEAVE = " + std::to_string(row_interleave_));
+  }
+
+  const auto group_rows = BaseType::numRows() / BaseType::numGroups();
+  ld_ = trans_ == matrix_op_t::Transpose ? group_rows : BaseType::numCols();
+  BaseType::packedBlock({0, group_rows, 0, BaseType::numCols()});
+  if (header.data_size != packedBufferBytes_()) {
+    throw std::runtime_error(
+        "Serialized packed matrix has " + std::to_string(header.data_size) +
+        " bytes of data instead of " + std::to_string(packedBufferBytes_()));
+  }
+}
+
+template <typename T, typename accT>
+void PackBMatrix<T, accT>::initializeBlocking_(const BlockingFactors* params) {
   if (!cpuinfo_initialize()) {
     throw std::runtime_error("Failed to initialize cpuinfo!");
   }
@@ -226,30 +304,23 @@ PackBMatrix<T, accT>::PackBMatrix(
             PackingTraits<T, accT, inst_set_t::avx2>::getMatrixPackBParams();
         break;
 
+      case inst_set_t::anyarch:
+        std::tie(BaseType::brow_, BaseType::bcol_, row_interleave_) =
+            PackingTraits<T, accT, inst_set_t::anyarch>::getMatrixPackBParams();
+        break;
+
       default:
         assert(0 && "unknown architecure");
         throw std::runtime_error("unknown architecure");
     }
   }
+}
 
-  if (BaseType::numRows() % groups != 0) {
-    throw std::runtime_error(
-        "groups = " + std::to_string(groups) +
-        " does not divide numRows = " + std::to_string(BaseType::numRows()));
-  }
-
-  // blocking for one group
-  block_type_t block{
-      0, BaseType::numRows() / BaseType::numGroups(), 0, BaseType::numCols()};
-  BaseType::packedBlock(block);
-  if (!pmat) {
-    BaseType::bufAllocatedHere_ = true;
-    BaseType::buf_ = static_cast<T*>(fbgemmAlignedAlloc(
-        64,
-        BaseType::numGroups() * BaseType::blockRows() * BaseType::brow_ *
-            BaseType::blockCols() * BaseType::bcol_ * sizeof(T)));
-  }
-  pack(block, params);
+template <typename T, typename accT>
+std::size_t PackBMatrix<T, accT>::packedBufferBytes_() const {
+  return static_cast<std::size_t>(BaseType::numGroups()) *
+      BaseType::blockRows() * BaseType::brow_ * BaseType::blockCols() *
+      BaseType::bcol_ * sizeof(T);
 }
 
 template <typename T, typename accT>
@@ -367,6 +438,15 @@ void PackBMatrix<T, accT>::unpack(
   pack_unpack_(blockB, origin_buf, BaseType::getBuf(), false, params);
 }
 
+template <typename T, typename accT>
+void PackBMatrix<T, accT>::replicateOnNumaNodes(int num_nodes) {
+  BaseType::numaReplicas_.replicate(
+      BaseType::buf_,
+      BaseType::numGroups() * BaseType::blockRows() * BaseType::brow_ *
+          BaseType::blockCols() * BaseType::bcol_ * sizeof(T),
+      num_nodes);
+}
+
 template <typename T, typename accT>
 int32_t PackBMatrix<T, accT>::addr(int32_t r, int32_t c) const {
   int32_t block_row_id = r / BaseType::blockRowSize();
@@ -467,6 +547,31 @@ bool PackBMatrix<T, accT>::equals(const PackBMatrix<T, accT>& that) const {
   return true;
 }
 
+template <typename T, typename accT>
+std::size_t PackBMatrix<T, accT>::serializedSize() const {
+  return kPackedMatrixDataOffset + packedBufferBytes_();
+}
+
+template <typename T, typename accT>
+void PackBMatrix<T, accT>::serialize(void* buf) const {
+  auto header = makePackedMatrixHeader(
+      packedKind_(),
+      sizeof(T),
+      BaseType::numRows(),
+      BaseType::numCols(),
+      BaseType::numGroups(),
+      BaseType::brow_,
+      BaseType::bcol_,
+      row_interleave_,
+      packedBufferBytes_());
+  header.trans = trans_;
+  std::memcpy(buf, &header, sizeof(header));
+  std::memcpy(
+      static_cast<char*>(buf) + header.data_offset,
+      BaseType::buf_,
+      header.data_size);
+}
+
 template class PackBMatrix<int8_t, int32_t>;
 template class PackBMatrix<int8_t, int16_t>;
 } // namespace fbgemm
@@ -29,6 +29,7 @@ PackMatrix<PT, inpType, accType>::PackMatrix(
   if (!cpuinfo_initialize()) {
     throw std::runtime_error("Failed to initialize cpuinfo!");
   }
+  isa_ = fbgemmInstructionSet();
 }
 
 template <typename PT, typename inpType, typename accType>
@@ -40,7 +41,7 @@ int PackMatrix<PT, inpType, accType>::packedBufferSize(
     throw std::runtime_error("Failed to initialize cpuinfo!");
   }
   if ((!fbgemmHasAvx512VnniSupport() && !fbgemmHasAvx512Support() &&
-       !fbgemmHasAvx2Support())) {
+       !fbgemmHasAvx2Support() && !fbgemmHasArmNeonSupport())) {
     assert(0 && "unknown architecure");
   }
 
@@ -82,6 +83,12 @@ int PackMatrix<PT, inpType, accType>::packedBufferSize(
         KCB = PackingTraits<inpType, accType, inst_set_t::avx2>::KCB;
         break;
 
+      case inst_set_t::anyarch:
+        MCB = PackingTraits<inpType, accType, inst_set_t::anyarch>::MCB;
+        NCB = PackingTraits<inpType, accType, inst_set_t::anyarch>::NCB;
+        KCB = PackingTraits<inpType, accType, inst_set_t::anyarch>::KCB;
+        break;
+
       default:
         assert(0 && "unknown architecure");
         throw std::runtime_error("unknown architecure");
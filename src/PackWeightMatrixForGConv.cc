@@ -37,11 +37,12 @@ PackWeightMatrixForGConv<T, accT, SPATIAL_DIM>::PackWeightMatrixForGConv(
         conv_param.K.begin(), conv_param.K.end(), 1, std::multiplies<int>());
     // we make it a multiple of 4
     int paddedICPerG = ((conv_param_.IC / conv_param_.G) + 3) / 4 * 4;
-    pdata_ = static_cast<T*>(fbgemmAlignedAlloc(
-        64,
-        (conv_param_.G + GTogether_ - 1) / GTogether_ * GTogether_ *
-            kernel_prod * (conv_param_.OC / conv_param_.G) * paddedICPerG *
-            sizeof(T)));
+    bufBytes_ = static_cast<std::size_t>(
+                    (conv_param_.G + GTogether_ - 1) / GTogether_ *
+                    GTogether_) *
+        kernel_prod * (conv_param_.OC / conv_param_.G) * paddedICPerG *
+        sizeof(T);
+    pdata_ = static_cast<T*>(fbgemmAlignedAlloc(64, bufBytes_));
   } else {
     bufAllocatedHere_ = false;
     pdata_ = pdata;
@@ -19,10 +19,11 @@ PackWeightsForConv<SPATIAL_DIM, T, accT>::PackWeightsForConv(
     const conv_param_t<SPATIAL_DIM>& conv_p,
     const T* sdata,
     const BlockingFactors* blocking_params)
-    : conv_param_(conv_p) {
+    : conv_param_(conv_p),
+      conv_path_(ConvFastPath<SPATIAL_DIM, accT>(conv_p)) {
   // Note: The following logic should *exactly* match with what we have in
   // FbgemmConv.cc
-  switch (ConvFastPath<SPATIAL_DIM, accT>(conv_p)) {
+  switch (conv_path_) {
     case optimized_conv_t::depthwise: {
       const int kernel_d = SPATIAL_DIM <= 2 ? 1 : conv_p.K[0];
       const int kernel_h = SPATIAL_DIM == 1 ? 1 : conv_p.K[SPATIAL_DIM - 2];
@@ -62,6 +63,18 @@ PackWeightsForConv<SPATIAL_DIM, T, accT>::PackWeightsForConv(
           conv_p.IC, conv_p.OC, K, sdata);
       break;
     }
+    case optimized_conv_t::winograd: {
+      W_winograd_packed_ = std::make_shared<PackedWinogradConvMatrix>(
+          conv_p.IC, conv_p.OC, sdata);
+      break;
+    }
+    case optimized_conv_t::transposed: {
+      W_transposed_packed_ = std::make_shared<PackedTransposedConvMatrix>(
+          *reinterpret_cast<const conv_param_t<2>*>(&conv_p),
+          sdata,
+          blocking_params);
+      break;
+    }
     case optimized_conv_t::fastpath1d: {
       break;
     }
@@ -95,11 +108,44 @@ void PackWeightsForConv<SPATIAL_DIM, T, accT>::unpack(T* origin_buf) {
     W_im2col_packed_->unpack(origin_buf);
   } else if (W_pointwise_packed_) {
     W_pointwise_packed_->unpack(origin_buf);
+  } else if (W_dc_packed_) {
+    W_dc_packed_->unpack(origin_buf);
+  } else if (W_winograd_packed_) {
+    W_winograd_packed_->unpack(origin_buf);
+  } else if (W_transposed_packed_) {
+    W_transposed_packed_->unpack(origin_buf);
   } else {
     assert(false && "At least one packed weights object should exist");
   }
 }
 
+template <int SPATIAL_DIM, typename T, typename accT>
+std::size_t PackWeightsForConv<SPATIAL_DIM, T, accT>::memoryFootprint() const {
+  std::size_t bytes = 0;
+  if (W_im2col_packed_) {
+    bytes += W_im2col_packed_->memoryFootprint();
+  }
+  if (W_dw_packed_) {
+    bytes += W_dw_packed_->memoryFootprint();
+  }
+  if (W_dc_packed_) {
+    bytes += W_dc_packed_->memoryFootprint();
+  }
+  if (W_gconv_packed_) {
+    bytes += W_gconv_packed_->memoryFootprint();
+  }
+  if (W_pointwise_packed_) {
+    bytes += W_pointwise_packed_->memoryFootprint();
+  }
+  if (W_winograd_packed_) {
+    bytes += W_winograd_packed_->memoryFootprint();
+  }
+  if (W_transposed_packed_) {
+    bytes += W_transposed_packed_->memoryFootprint();
+  }
+  return bytes;
+}
+
 template <int SPATIAL_DIM, typename T, typename accT>
 bool PackWeightsForConv<SPATIAL_DIM, T, accT>::isPackingCompliant(
     const conv_param_t<SPATIAL_DIM>& test_conv_p) {
@@ -120,7 +166,8 @@ bool PackWeightsForConv<SPATIAL_DIM, T, accT>::isPackingCompliant(
       std::equal(
              conv_param_.dilation.begin(),
              conv_param_.dilation.end(),
-             test_conv_p.dilation.begin());
+             test_conv_p.dilation.begin()) &&
+      conv_param_.input_layout == test_conv_p.input_layout;
 }
 
 template <int SPATIAL_DIM, typename T, typename accT>
@@ -188,6 +235,16 @@ std::string PackWeightsForConv<SPATIAL_DIM, T, accT>::mismatchingParams(
         arrayToString<SPATIAL_DIM>(test_conv_p.dilation));
   }
 
+  if (conv_param_.input_layout != test_conv_p.input_layout) {
+    auto layoutToString = [](conv_layout_t layout) {
+      return std::string(layout == conv_layout_t::NCHW ? "NCHW" : "NHWC");
+    };
+    msg += combineStr(
+        "input_layout",
+        layoutToString(conv_param_.input_layout),
+        layoutToString(test_conv_p.input_layout));
+  }
+
   return msg;
 }
 
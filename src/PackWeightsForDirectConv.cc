@@ -14,6 +14,8 @@
 #include <immintrin.h>
 #endif
 #include <cassert>
+#include <cstring>
+#include <vector>
 
 #include "./DirectConv.h"
 #include "./ExecuteKernel.h"
@@ -34,13 +36,16 @@ PackedDirectConvMatrix::PackedDirectConvMatrix(
     int IC_per_G,
     int OC_per_G,
     int filter_prod,
-    const int8_t* smat) {
+    const int8_t* smat)
+    : IC_per_G_(IC_per_G), OC_per_G_(OC_per_G), filter_prod_(filter_prod) {
   // Allocate packed arrays
   int kernel_prod_aligned = (filter_prod + 1) / 2 * 2;
-  pmat_ = static_cast<int8_t*>(fbgemmAlignedAlloc(
-      64,
-      ((OC_per_G + 31) / 32 * 32) * kernel_prod_aligned * IC_per_G *
-          sizeof(int8_t)));
+  int IC_padded = ICPadded();
+  size_t packed_size = ((OC_per_G + 31) / 32 * 32) * kernel_prod_aligned *
+      IC_padded * sizeof(int8_t);
+  pmat_ = static_cast<int8_t*>(fbgemmAlignedAlloc(64, packed_size));
+  // padded input and output channels have zero weights
+  std::memset(pmat_, 0, packed_size);
 
   // the transposed weight layout: W[oc/8][r][s][ic/4][8][4]
   for (int g = 0; g < /* G */ 1; ++g) {
@@ -52,8 +57,8 @@ PackedDirectConvMatrix::PackedDirectConvMatrix(
           int icB = c / 4;
           int icb = c % 4;
           pmat_
-              [((((g * (OC_per_G / 8) + ocB) * filter_prod + f) *
-                     (IC_per_G / 4) +
+              [((((g * (OCPadded() / 8) + ocB) * filter_prod + f) *
+                     (IC_padded / 4) +
                  icB) *
                     8 +
                 ocb) *
@@ -66,6 +71,21 @@ PackedDirectConvMatrix::PackedDirectConvMatrix(
   }
 }
 
+void PackedDirectConvMatrix::unpack(int8_t* origin_buf) const {
+  int IC_padded = ICPadded();
+  for (int k = 0; k < OC_per_G_; ++k) {
+    for (int f = 0; f < filter_prod_; ++f) {
+      for (int c = 0; c < IC_per_G_; ++c) {
+        origin_buf[(k * filter_prod_ + f) * IC_per_G_ + c] = pmat_
+            [((((k / 8) * filter_prod_ + f) * (IC_padded / 4) + c / 4) * 8 +
+              k % 8) *
+                 4 +
+             c % 4];
+      }
+    }
+  }
+}
+
 PackedDirectConvMatrix::~PackedDirectConvMatrix() {
   fbgemmAlignedFree(pmat_);
 }
@@ -239,16 +259,15 @@ void fbgemmDirectConv(
     // const int32_t* bias,
     int thread_id,
     int num_threads) {
-  // support for single thread now,
-  // will enable multithread later
-  if (thread_id > 0 || thread_id >= num_threads) {
-    return;
-  }
-
   if (SPATIAL_DIM != 2) {
     assert(false && "1d/3d direct conv not supported");
   } else {
     if (conv_p.transposed) {
+      // support for single thread now,
+      // will enable multithread later
+      if (thread_id > 0 || thread_id >= num_threads) {
+        return;
+      }
       DirectConvCodeGenBase<uint8_t, int8_t, int32_t, int32_t>::
           jit_micro_kernel_fp_convT fn;
       DirectConvCodeGenBase<uint8_t, int8_t, int32_t, int32_t> codeObj;
@@ -456,7 +475,45 @@ void fbgemmDirectConv(
       fbgemmAlignedFree(rowSum);
     } // transposed conv
     else { // non-transposed conv
-      assert(false && "non-transposed direct conv not integrated yet.");
+      const conv_param_t<2>& conv_p_2d =
+          *reinterpret_cast<const conv_param_t<2>*>(&conv_p);
+      const int OW = conv_p_2d.OUT_DIM[1];
+      const int OC = conv_p_2d.OC;
+
+      // Threads split the output rows of all images.
+      int64_t work_begin, work_end;
+      fbgemmPartition1D(
+          thread_id,
+          num_threads,
+          static_cast<int64_t>(conv_p_2d.MB) * conv_p_2d.OUT_DIM[0],
+          work_begin,
+          work_end);
+      if (work_begin >= work_end) {
+        return;
+      }
+      const int row_begin = static_cast<int>(work_begin);
+      const int row_end = static_cast<int>(work_end);
+
+      std::vector<int32_t> row_offsets((row_end - row_begin) * OW);
+      int32_t* C_buffer_start = C_buffer + row_begin * OW * OC;
+      directConvAvx2(
+          conv_p_2d,
+          Aint8,
+          outProcess.getAZeroPoint(),
+          Bint8_tr,
+          row_begin,
+          row_end,
+          C_buffer_start,
+          row_offsets.data());
+
+      ReQuantizeOutput<FUSE_RELU, Q_GRAN, BIAS_TYPE> reqObj = outProcess;
+      reqObj.setRowOffsets(row_offsets.data());
+      reqObj.template f<inst_set_t::avx2>(
+          C,
+          C_buffer_start,
+          {row_begin * OW, (row_end - row_begin) * OW, 0, OC},
+          OC,
+          OC);
     }
   } // else SPATIAL_DIM
 }
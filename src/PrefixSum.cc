@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#define FBGEMM_EXPORTS
+#include "./PrefixSum.h"
+
+#include <cpuinfo.h>
+#include <cstdint>
+
+#include "fbgemm/Utils.h"
+
+namespace fbgemm {
+
+namespace {
+
+template <typename T>
+T exclusivePrefixSumRef(
+    std::int64_t n,
+    const T* input,
+    T* output,
+    T init) {
+  T sum = init;
+  for (std::int64_t i = 0; i < n; ++i) {
+    // Read before writing, output may alias input
+    const T x = input[i];
+    output[i] = sum;
+    sum += x;
+  }
+  return sum;
+}
+
+} // namespace
+
+template <typename T>
+T exclusive_prefix_sum(
+    const std::int64_t n,
+    const T* const input,
+    T* const output,
+    const T init) {
+#if CPUINFO_ARCH_X86 || CPUINFO_ARCH_X86_64
+  // Checked once rather than on every call, scans are often short
+  static const bool use_avx512 =
+      cpuinfo_initialize() && fbgemmHasAvx512Support();
+  static const bool use_avx2 = cpuinfo_initialize() && fbgemmHasAvx2Support();
+  if (use_avx512) {
+    return internal::exclusive_prefix_sum_avx512(n, input, output, init);
+  }
+  if (use_avx2) {
+    return internal::exclusive_prefix_sum_avx2(n, input, output, init);
+  }
+#endif
+  return exclusivePrefixSumRef(n, input, output, init);
+}
+
+#define INSTANTIATE_PREFIX_SUM(T)                \
+  template FBGEMM_API T exclusive_prefix_sum<T>( \
+      const std::int64_t n,                      \
+      const T* const input,                      \
+      T* const output,                           \
+      const T init);
+
+INSTANTIATE_PREFIX_SUM(std::int32_t)
+INSTANTIATE_PREFIX_SUM(std::int64_t)
+
+#undef INSTANTIATE_PREFIX_SUM
+
+} // namespace fbgemm
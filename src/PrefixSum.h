@@ -0,0 +1,41 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+namespace fbgemm {
+
+namespace internal {
+
+/**
+ * @brief Exclusive prefix sum using Intel AVX2, called by
+ * exclusive_prefix_sum on CPUs with AVX2 support.
+ */
+template <typename T>
+T exclusive_prefix_sum_avx2(
+    std::int64_t n,
+    const T* input,
+    T* output,
+    T init);
+
+/**
+ * @brief Exclusive prefix sum using Intel AVX512, called by
+ * exclusive_prefix_sum on CPUs with AVX512 support.
+ */
+template <typename T>
+T exclusive_prefix_sum_avx512(
+    std::int64_t n,
+    const T* input,
+    T* output,
+    T init);
+
+} // namespace internal
+
+} // namespace fbgemm
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <immintrin.h>
+#include <cstdint>
+
+#include "./PrefixSum.h"
+
+namespace fbgemm {
+
+namespace internal {
+
+namespace {
+
+// Inclusive scan of the 8 lanes of x
+inline __m256i inclusiveScanEpi32(__m256i x) {
+  x = _mm256_add_epi32(x, _mm256_slli_si256(x, 4));
+  x = _mm256_add_epi32(x, _mm256_slli_si256(x, 8));
+  // Add the last lane of the low half to the high half
+  const __m256i low_sum = _mm256_shuffle_epi32(x, 0xff);
+  return _mm256_add_epi32(x, _mm256_permute2x128_si256(low_sum, low_sum, 0x08));
+}
+
+// Inclusive scan of the 4 lanes of x
+inline __m256i inclusiveScanEpi64(__m256i x) {
+  x = _mm256_add_epi64(x, _mm256_slli_si256(x, 8));
+  const __m256i low_sum = _mm256_shuffle_epi32(x, 0xee);
+  return _mm256_add_epi64(x, _mm256_permute2x128_si256(low_sum, low_sum, 0x08));
+}
+
+} // namespace
+
+template <>
+std::int32_t exclusive_prefix_sum_avx2(
+    const std::int64_t n,
+    const std::int32_t* const input,
+    std::int32_t* const output,
+    const std::int32_t init) {
+  __m256i carry = _mm256_set1_epi32(init);
+  std::int64_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m256i x =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i));
+    const __m256i sum = _mm256_add_epi32(carry, inclusiveScanEpi32(x));
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(output + i), _mm256_sub_epi32(sum, x));
+    carry = _mm256_permutevar8x32_epi32(sum, _mm256_set1_epi32(7));
+  }
+  std::int32_t total = _mm256_cvtsi256_si32(carry);
+  for (; i < n; ++i) {
+    const std::int32_t x = input[i];
+    output[i] = total;
+    total += x;
+  }
+  return total;
+}
+
+template <>
+std::int64_t exclusive_prefix_sum_avx2(
+    const std::int64_t n,
+    const std::int64_t* const input,
+    std::int64_t* const output,
+    const std::int64_t init) {
+  __m256i carry = _mm256_set1_epi64x(init);
+  std::int64_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const __m256i x =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i));
+    const __m256i sum = _mm256_add_epi64(carry, inclusiveScanEpi64(x));
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(output + i), _mm256_sub_epi64(sum, x));
+    carry = _mm256_permute4x64_epi64(sum, 0xff);
+  }
+  std::int64_t total = _mm256_extract_epi64(carry, 0);
+  for (; i < n; ++i) {
+    const std::int64_t x = input[i];
+    output[i] = total;
+    total += x;
+  }
+  return total;
+}
+
+} // namespace internal
+
+} // namespace fbgemm
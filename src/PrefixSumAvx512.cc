@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <immintrin.h>
+#include <cstdint>
+
+#include "./PrefixSum.h"
+
+namespace fbgemm {
+
+namespace internal {
+
+namespace {
+
+// Inclusive scan of the 16 lanes of x: Alignr with zeros shifts x up by k
+// lanes
+inline __m512i inclusiveScanEpi32(__m512i x) {
+  const __m512i zero = _mm512_setzero_si512();
+  x = _mm512_add_epi32(x, _mm512_alignr_epi32(x, zero, 15));
+  x = _mm512_add_epi32(x, _mm512_alignr_epi32(x, zero, 14));
+  x = _mm512_add_epi32(x, _mm512_alignr_epi32(x, zero, 12));
+  return _mm512_add_epi32(x, _mm512_alignr_epi32(x, zero, 8));
+}
+
+// Inclusive scan of the 8 lanes of x
+inline __m512i inclusiveScanEpi64(__m512i x) {
+  const __m512i zero = _mm512_setzero_si512();
+  x = _mm512_add_epi64(x, _mm512_alignr_epi64(x, zero, 7));
+  x = _mm512_add_epi64(x, _mm512_alignr_epi64(x, zero, 6));
+  return _mm512_add_epi64(x, _mm512_alignr_epi64(x, zero, 4));
+}
+
+} // namespace
+
+template <>
+std::int32_t exclusive_prefix_sum_avx512(
+    const std::int64_t n,
+    const std::int32_t* const input,
+    std::int32_t* const output,
+    const std::int32_t init) {
+  const __m512i last = _mm512_set1_epi32(15);
+  __m512i carry = _mm512_set1_epi32(init);
+  std::int64_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    const __m512i x = _mm512_loadu_si512(input + i);
+    const __m512i sum = _mm512_add_epi32(carry, inclusiveScanEpi32(x));
+    _mm512_storeu_si512(output + i, _mm512_sub_epi32(sum, x));
+    carry = _mm512_permutexvar_epi32(last, sum);
+  }
+  std::int32_t total = _mm512_cvtsi512_si32(carry);
+  for (; i < n; ++i) {
+    const std::int32_t x = input[i];
+    output[i] = total;
+    total += x;
+  }
+  return total;
+}
+
+template <>
+std::int64_t exclusive_prefix_sum_avx512(
+    const std::int64_t n,
+    const std::int64_t* const input,
+    std::int64_t* const output,
+    const std::int64_t init) {
+  const __m512i last = _mm512_set1_epi64(7);
+  __m512i carry = _mm512_set1_epi64(init);
+  std::int64_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    const __m512i x = _mm512_loadu_si512(input + i);
+    const __m512i sum = _mm512_add_epi64(carry, inclusiveScanEpi64(x));
+    _mm512_storeu_si512(output + i, _mm512_sub_epi64(sum, x));
+    carry = _mm512_permutexvar_epi64(last, sum);
+  }
+  std::int64_t total = _mm_cvtsi128_si64(_mm512_castsi512_si128(carry));
+  for (; i < n; ++i) {
+    const std::int64_t x = input[i];
+    output[i] = total;
+    total += x;
+  }
+  return total;
+}
+
+} // namespace internal
+
+} // namespace fbgemm
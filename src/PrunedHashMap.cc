@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#define FBGEMM_EXPORTS
+#include "./PrunedHashMap.h"
+
+#include <cpuinfo.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include "fbgemm/Utils.h"
+
+namespace fbgemm {
+
+namespace {
+
+std::int64_t nextPowerOfTwo(std::int64_t n) {
+  std::int64_t p = 1;
+  while (p < n) {
+    p *= 2;
+  }
+  return p;
+}
+
+void prunedHashMapLookupRef(
+    std::int64_t index_size,
+    const std::int32_t* indices,
+    const std::int32_t* groups,
+    std::int64_t num_groups,
+    std::int32_t* dense_indices) {
+  for (std::int64_t i = 0; i < index_size; ++i) {
+    const std::int32_t idx = indices[i];
+    dense_indices[i] = internal::prunedHashMapProbe(
+        idx,
+        internal::prunedHash(static_cast<std::uint32_t>(idx)) &
+            (num_groups - 1),
+        groups,
+        num_groups);
+  }
+}
+
+} // namespace
+
+void pruned_hashmap_grouped_offsets(
+    int num_tables,
+    const std::int64_t* hash_table_offsets,
+    std::int64_t* group_offsets) {
+  group_offsets[0] = 0;
+  for (int t = 0; t < num_tables; ++t) {
+    const std::int64_t capacity =
+        hash_table_offsets[t + 1] - hash_table_offsets[t];
+    const std::int64_t num_groups = capacity == 0
+        ? 0
+        : nextPowerOfTwo(
+              (capacity + kPrunedHashMapGroupSize - 1) /
+              kPrunedHashMapGroupSize);
+    group_offsets[t + 1] = group_offsets[t] + num_groups;
+  }
+}
+
+bool pruned_hashmap_grouped_build(
+    int num_tables,
+    int batch_size,
+    const std::int32_t* indices,
+    const std::int32_t* dense_indices,
+    const std::int32_t* offsets,
+    const std::int64_t* group_offsets,
+    std::int32_t* groups) {
+  std::fill_n(
+      groups,
+      group_offsets[num_tables] * internal::kPrunedHashMapGroupStride,
+      kPrunedHashMapEmpty);
+
+  for (int t = 0; t < num_tables; ++t) {
+    const std::int64_t num_groups = group_offsets[t + 1] - group_offsets[t];
+    if (num_groups == 0) {
+      continue;
+    }
+    std::int32_t* table_groups =
+        groups + group_offsets[t] * internal::kPrunedHashMapGroupStride;
+    const std::int64_t begin = offsets[static_cast<std::int64_t>(t) * batch_size];
+    const std::int64_t end =
+        offsets[static_cast<std::int64_t>(t + 1) * batch_size];
+    for (std::int64_t i = begin; i < end; ++i) {
+      const std::int32_t idx = indices[i];
+      const std::int32_t dense_idx = dense_indices[i];
+      if (dense_idx == -1) {
+        // -1 means this row has been pruned, do not insert it.
+        continue;
+      }
+      std::int64_t group =
+          internal::prunedHash(static_cast<std::uint32_t>(idx)) &
+          (num_groups - 1);
+      bool inserted = false;
+      for (std::int64_t probe = 0; probe < num_groups && !inserted; ++probe) {
+        std::int32_t* keys =
+            table_groups + group * internal::kPrunedHashMapGroupStride;
+        for (int s = 0; s < kPrunedHashMapGroupSize; ++s) {
+          // Empty slot, or the index was already inserted
+          if (keys[s] == kPrunedHashMapEmpty || keys[s] == idx) {
+            keys[s] = idx;
+            keys[kPrunedHashMapGroupSize + s] = dense_idx;
+            inserted = true;
+            break;
+          }
+        }
+        group = (group + 1) & (num_groups - 1);
+      }
+      if (!inserted) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+void pruned_hashmap_grouped_lookup(
+    int num_tables,
+    int batch_size,
+    const std::int32_t* indices,
+    const std::int32_t* offsets,
+    const std::int32_t* groups,
+    const std::int64_t* group_offsets,
+    std::int32_t* dense_indices) {
+  if (!cpuinfo_initialize()) {
+    throw std::runtime_error("Failed to initialize cpuinfo!");
+  }
+  const bool use_avx2 = fbgemmHasAvx2Support();
+
+  for (int t = 0; t < num_tables; ++t) {
+    const std::int64_t begin = offsets[static_cast<std::int64_t>(t) * batch_size];
+    const std::int64_t end =
+        offsets[static_cast<std::int64_t>(t + 1) * batch_size];
+    const std::int64_t num_groups = group_offsets[t + 1] - group_offsets[t];
+    if (num_groups == 0) {
+      std::memcpy(
+          dense_indices + begin,
+          indices + begin,
+          (end - begin) * sizeof(std::int32_t));
+      continue;
+    }
+    const std::int32_t* table_groups =
+        groups + group_offsets[t] * internal::kPrunedHashMapGroupStride;
+    if (use_avx2) {
+      internal::pruned_hashmap_grouped_lookup_avx2(
+          end - begin,
+          indices + begin,
+          table_groups,
+          num_groups,
+          dense_indices + begin);
+    } else {
+      prunedHashMapLookupRef(
+          end - begin,
+          indices + begin,
+          table_groups,
+          num_groups,
+          dense_indices + begin);
+    }
+  }
+}
+
+} // namespace fbgemm
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "fbgemm/FbgemmEmbedding.h"
+
+namespace fbgemm {
+
+namespace internal {
+
+// Values of a group: its keys then their dense indices
+constexpr int kPrunedHashMapGroupStride = 2 * kPrunedHashMapGroupSize;
+
+// Indices hashed and prefetched ahead of the probes of a lookup
+constexpr int kPrunedHashMapLookupBatch = 16;
+
+// MurmurHash3 32-bit mixing function, also used by pruned_hashmap_insert
+inline std::uint32_t prunedHash(std::uint32_t h) {
+  h ^= h >> 16;
+  h *= 0x85ebca6b;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35;
+  h ^= h >> 16;
+  return h;
+}
+
+// Probes the groups of a table from the group of idx, num_groups being a
+// power of two
+inline std::int32_t prunedHashMapProbe(
+    std::int32_t idx,
+    std::int64_t group,
+    const std::int32_t* groups,
+    std::int64_t num_groups) {
+  for (std::int64_t probe = 0; probe < num_groups; ++probe) {
+    const std::int32_t* keys = groups + group * kPrunedHashMapGroupStride;
+    for (int s = 0; s < kPrunedHashMapGroupSize; ++s) {
+      if (keys[s] == idx) {
+        return keys[kPrunedHashMapGroupSize + s];
+      }
+      if (keys[s] == kPrunedHashMapEmpty) {
+        return -1;
+      }
+    }
+    group = (group + 1) & (num_groups - 1);
+  }
+  return -1;
+}
+
+} // namespace internal
+
+} // namespace fbgemm
@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#define FBGEMM_EXPORTS
+#include <immintrin.h>
+#include <algorithm>
+#include <cstdint>
+
+#include "./PrunedHashMap.h"
+
+namespace fbgemm {
+namespace internal {
+
+namespace {
+
+static_assert(
+    kPrunedHashMapGroupSize == 8,
+    "A group must fill one 256-bit register");
+static_assert(
+    kPrunedHashMapLookupBatch % 8 == 0,
+    "Batches are hashed 8 indices at a time");
+
+inline __m256i prunedHashAvx2(__m256i h) {
+  h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+  h = _mm256_mullo_epi32(h, _mm256_set1_epi32(0x85ebca6b));
+  h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 13));
+  h = _mm256_mullo_epi32(h, _mm256_set1_epi32(0xc2b2ae35));
+  return _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+}
+
+// Computes the groups of the n <= kPrunedHashMapLookupBatch indices and
+// prefetches their first group
+inline void hashBatch(
+    const std::int32_t* indices,
+    int n,
+    const std::int32_t* groups,
+    std::int64_t num_groups,
+    std::uint32_t* batch_groups) {
+  const std::uint32_t group_mask = static_cast<std::uint32_t>(num_groups - 1);
+  int i = 0;
+  if (n == kPrunedHashMapLookupBatch) {
+    const __m256i mask_v = _mm256_set1_epi32(group_mask);
+    for (; i < n; i += 8) {
+      const __m256i idx = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(indices + i));
+      _mm256_storeu_si256(
+          reinterpret_cast<__m256i*>(batch_groups + i),
+          _mm256_and_si256(prunedHashAvx2(idx), mask_v));
+    }
+  }
+  for (; i < n; ++i) {
+    batch_groups[i] =
+        prunedHash(static_cast<std::uint32_t>(indices[i])) & group_mask;
+  }
+  for (i = 0; i < n; ++i) {
+    _mm_prefetch(
+        reinterpret_cast<const char*>(
+            groups +
+            static_cast<std::int64_t>(batch_groups[i]) *
+                kPrunedHashMapGroupStride),
+        _MM_HINT_T0);
+  }
+}
+
+inline std::int32_t probeAvx2(
+    std::int32_t idx,
+    std::int64_t group,
+    const std::int32_t* groups,
+    std::int64_t num_groups) {
+  const __m256i key = _mm256_set1_epi32(idx);
+  for (std::int64_t probe = 0; probe < num_groups; ++probe) {
+    const std::int32_t* keys = groups + group * kPrunedHashMapGroupStride;
+    const __m256i keys_v =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys));
+    const int match = _mm256_movemask_ps(
+        _mm256_castsi256_ps(_mm256_cmpeq_epi32(keys_v, key)));
+    if (match) {
+      return keys[kPrunedHashMapGroupSize + __builtin_ctz(match)];
+    }
+    // Empty slots come last, so a group that is not full ends the probing
+    if (keys[kPrunedHashMapGroupSize - 1] == kPrunedHashMapEmpty) {
+      return -1;
+    }
+    group = (group + 1) & (num_groups - 1);
+  }
+  return -1;
+}
+
+} // namespace
+
+void pruned_hashmap_grouped_lookup_avx2(
+    std::int64_t index_size,
+    const std::int32_t* indices,
+    const std::int32_t* groups,
+    std::int64_t num_groups,
+    std::int32_t* dense_indices) {
+  // The groups of a batch are hashed and prefetched while the previous batch
+  // is probed
+  alignas(32) std::uint32_t batch_groups[2][kPrunedHashMapLookupBatch];
+  int current = 0;
+  hashBatch(
+      indices,
+      static_cast<int>(
+          std::min<std::int64_t>(index_size, kPrunedHashMapLookupBatch)),
+      groups,
+      num_groups,
+      batch_groups[current]);
+  for (std::int64_t begin = 0; begin < index_size;
+       begin += kPrunedHashMapLookupBatch) {
+    const int n = static_cast<int>(std::min<std::int64_t>(
+        index_size - begin, kPrunedHashMapLookupBatch));
+    const std::int64_t next = begin + kPrunedHashMapLookupBatch;
+    if (next < index_size) {
+      hashBatch(
+          indices + next,
+          static_cast<int>(std::min<std::int64_t>(
+              index_size - next, kPrunedHashMapLookupBatch)),
+          groups,
+          num_groups,
+          batch_groups[current ^ 1]);
+    }
+    for (int i = 0; i < n; ++i) {
+      dense_indices[begin + i] = probeAvx2(
+          indices[begin + i],
+          batch_groups[current][i],
+          groups,
+          num_groups);
+    }
+    current ^= 1;
+  }
+}
+
+} // namespace internal
+} // namespace fbgemm
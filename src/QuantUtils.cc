@@ -8,15 +8,18 @@
 
 #define FBGEMM_EXPORTS
 #include <algorithm>
+#include <cstring>
 #include <iterator>
 #include <numeric>
 #include <type_traits>
 
 #include "fbgemm/QuantUtils.h"
+#include "fbgemm/QuantUtilsAvx512.h"
 
 #include <cpuinfo.h>
 
 #include "fbgemm/Fbgemm.h"
+#include "fbgemm/FbgemmConvert.h"
 
 #include "fbgemm/Types.h"
 
@@ -259,6 +262,64 @@ FBGEMM_SPECIALIZED_QUANTIZE(uint8_t, false)
 #undef FBGEMM_SPECIALIZED_QUANTIZE
 #undef FBGEMM_SPECIALIZED_QUANTIZE_AVX2
 
+template <int LEN, typename T, bool LEGACY>
+void QuantizeFixedLength(
+    const float* src,
+    T* dst,
+    const TensorQuantizationParams& qparams) {
+#if CPUINFO_ARCH_X86 || CPUINFO_ARCH_X86_64
+  // Checked once rather than on every call of these tiny kernels
+  static const bool use_avx2 = cpuinfo_initialize() &&
+      fbgemmHasAvx2Support() && cpuinfo_has_x86_fma3();
+  if (use_avx2 && qparams.precision == 8) {
+    QuantizeFixedLengthAvx2<LEN, T, LEGACY>(src, dst, qparams);
+    return;
+  }
+#endif
+  for (int i = 0; i < LEN; ++i) {
+    dst[i] = Quantize<T, LEGACY>(src[i], qparams);
+  }
+}
+
+template <int LEN, typename T>
+void DequantizeFixedLength(
+    const T* src,
+    float* dst,
+    const TensorQuantizationParams& qparams) {
+#if CPUINFO_ARCH_X86 || CPUINFO_ARCH_X86_64
+  static const bool use_avx2 = cpuinfo_initialize() && fbgemmHasAvx2Support();
+  if (use_avx2) {
+    DequantizeFixedLengthAvx2<LEN, T>(src, dst, qparams);
+    return;
+  }
+#endif
+  for (int i = 0; i < LEN; ++i) {
+    dst[i] = Dequantize(src[i], qparams);
+  }
+}
+
+#define INSTANTIATE_FIXED_LENGTH_BASE(LEN, T)                             \
+  template FBGEMM_API void QuantizeFixedLength<LEN, T, true>(             \
+      const float* src, T* dst, const TensorQuantizationParams& qparams); \
+  template FBGEMM_API void QuantizeFixedLength<LEN, T, false>(            \
+      const float* src, T* dst, const TensorQuantizationParams& qparams); \
+  template FBGEMM_API void DequantizeFixedLength<LEN, T>(                 \
+      const T* src, float* dst, const TensorQuantizationParams& qparams);
+
+#define INSTANTIATE_FIXED_LENGTH(LEN)         \
+  INSTANTIATE_FIXED_LENGTH_BASE(LEN, uint8_t) \
+  INSTANTIATE_FIXED_LENGTH_BASE(LEN, int8_t)
+
+INSTANTIATE_FIXED_LENGTH(8)
+INSTANTIATE_FIXED_LENGTH(16)
+INSTANTIATE_FIXED_LENGTH(32)
+INSTANTIATE_FIXED_LENGTH(64)
+INSTANTIATE_FIXED_LENGTH(128)
+INSTANTIATE_FIXED_LENGTH(256)
+
+#undef INSTANTIATE_FIXED_LENGTH
+#undef INSTANTIATE_FIXED_LENGTH_BASE
+
 #define FBGEMM_SPECIALIZED_FUSED_QUANTIZE_DEQUANTIZE(T)             \
   template <>                                                       \
   FBGEMM_API void FusedQuantizeDequantize<T>(                       \
@@ -313,6 +374,17 @@ FBGEMM_SPECIALIZED_FUSED_QUANTIZE_DEQUANTIZE(uint8_t)
 #undef FBGEMM_SPECIALIZED_FUSED_QUANTIZE_DEQUANTIZE
 #undef FBGEMM_SPECIALIZED_FUSED_QUANTIZE_DEQUANTIZE_AVX2
 
+void ComputeActivationLookupTable(
+    const std::function<float(float)>& activation,
+    const TensorQuantizationParams& in_qparams,
+    const TensorQuantizationParams& out_qparams,
+    uint8_t* table) {
+  for (int q = 0; q < 256; ++q) {
+    table[q] = Quantize<uint8_t>(
+        activation(Dequantize<uint8_t>(q, in_qparams)), out_qparams);
+  }
+}
+
 #define FBGEMM_SPECIALIZED_QUANTIZEGROUPWISEKCX(T)                       \
   template <>                                                            \
   FBGEMM_API void QuantizeGroupwise<T, layout_t::KCX>(                   \
@@ -539,13 +611,477 @@ FBGEMM_API void RequantizeFixedPoint<uint8_t>(
   }
 }
 
+template <typename T>
+void RequantizePerChannelRef(
+    const int32_t* src,
+    T* dst,
+    int64_t rows,
+    int channels,
+    const float* multipliers,
+    const int32_t* zero_points,
+    int precision) {
+  for (int64_t r = 0; r < rows; ++r) {
+    for (int c = 0; c < channels; ++c) {
+      dst[r * channels + c] = Requantize<T>(
+          src[r * channels + c],
+          zero_points[c],
+          multipliers[c],
+          precision,
+          is_signed<T>::value);
+    }
+  }
+}
+
+template <typename T>
+void RequantizeFixedPointPerChannelRef(
+    const int32_t* src,
+    T* dst,
+    int64_t rows,
+    int channels,
+    const int32_t* multipliers,
+    const int* right_shifts,
+    const int32_t* zero_points,
+    int precision) {
+  for (int64_t r = 0; r < rows; ++r) {
+    for (int c = 0; c < channels; ++c) {
+      dst[r * channels + c] = Requantize<T>(
+          src[r * channels + c],
+          zero_points[c],
+          multipliers[c],
+          right_shifts[c],
+          precision,
+          is_signed<T>::value);
+    }
+  }
+}
+
+template <typename T>
+void RequantizePerChannel(
+    const int32_t* src,
+    T* dst,
+    int64_t rows,
+    int channels,
+    const float* multipliers,
+    const int32_t* zero_points,
+    int precision,
+    int thread_id,
+    int num_threads) {
+  int64_t r_begin, r_end;
+  fbgemmPartition1D(thread_id, num_threads, rows, r_begin, r_end);
+  src += r_begin * channels;
+  dst += r_begin * channels;
+#if CPUINFO_ARCH_X86 || CPUINFO_ARCH_X86_64
+  if (cpuinfo_initialize() && fbgemmHasAvx512Support()) {
+    RequantizePerChannelAvx512(
+        src,
+        dst,
+        r_end - r_begin,
+        channels,
+        multipliers,
+        zero_points,
+        precision);
+    return;
+  }
+  if (fbgemmHasAvx2Support()) {
+    RequantizePerChannelAvx2(
+        src,
+        dst,
+        r_end - r_begin,
+        channels,
+        multipliers,
+        zero_points,
+        precision);
+    return;
+  }
+#endif
+  RequantizePerChannelRef(
+      src, dst, r_end - r_begin, channels, multipliers, zero_points, precision);
+}
+
+template <typename T>
+void RequantizeFixedPointPerChannel(
+    const int32_t* src,
+    T* dst,
+    int64_t rows,
+    int channels,
+    const int32_t* multipliers,
+    const int* right_shifts,
+    const int32_t* zero_points,
+    int precision,
+    int thread_id,
+    int num_threads) {
+  int64_t r_begin, r_end;
+  fbgemmPartition1D(thread_id, num_threads, rows, r_begin, r_end);
+  src += r_begin * channels;
+  dst += r_begin * channels;
+#if CPUINFO_ARCH_X86 || CPUINFO_ARCH_X86_64
+  if (cpuinfo_initialize() && fbgemmHasAvx512Support()) {
+    RequantizeFixedPointPerChannelAvx512(
+        src,
+        dst,
+        r_end - r_begin,
+        channels,
+        multipliers,
+        right_shifts,
+        zero_points,
+        precision);
+    return;
+  }
+  if (fbgemmHasAvx2Support()) {
+    RequantizeFixedPointPerChannelAvx2(
+        src,
+        dst,
+        r_end - r_begin,
+        channels,
+        multipliers,
+        right_shifts,
+        zero_points,
+        precision);
+    return;
+  }
+#endif
+  RequantizeFixedPointPerChannelRef(
+      src,
+      dst,
+      r_end - r_begin,
+      channels,
+      multipliers,
+      right_shifts,
+      zero_points,
+      precision);
+}
+
+#define INSTANTIATE_REQUANTIZE_PER_CHANNEL(T)                    \
+  template FBGEMM_API void RequantizePerChannelRef<T>(           \
+      const int32_t* src,                                        \
+      T* dst,                                                    \
+      int64_t rows,                                              \
+      int channels,                                              \
+      const float* multipliers,                                  \
+      const int32_t* zero_points,                                \
+      int precision);                                            \
+  template FBGEMM_API void RequantizeFixedPointPerChannelRef<T>( \
+      const int32_t* src,                                        \
+      T* dst,                                                    \
+      int64_t rows,                                              \
+      int channels,                                              \
+      const int32_t* multipliers,                                \
+      const int* right_shifts,                                   \
+      const int32_t* zero_points,                                \
+      int precision);                                            \
+  template FBGEMM_API void RequantizePerChannel<T>(              \
+      const int32_t* src,                                        \
+      T* dst,                                                    \
+      int64_t rows,                                              \
+      int channels,                                              \
+      const float* multipliers,                                  \
+      const int32_t* zero_points,                                \
+      int precision,                                             \
+      int thread_id,                                             \
+      int num_threads);                                          \
+  template FBGEMM_API void RequantizeFixedPointPerChannel<T>(    \
+      const int32_t* src,                                        \
+      T* dst,                                                    \
+      int64_t rows,                                              \
+      int channels,                                              \
+      const int32_t* multipliers,                                \
+      const int* right_shifts,                                   \
+      const int32_t* zero_points,                                \
+      int precision,                                             \
+      int thread_id,                                             \
+      int num_threads);
+INSTANTIATE_REQUANTIZE_PER_CHANNEL(uint8_t)
+INSTANTIATE_REQUANTIZE_PER_CHANNEL(int8_t)
+INSTANTIATE_REQUANTIZE_PER_CHANNEL(int16_t)
+#undef INSTANTIATE_REQUANTIZE_PER_CHANNEL
+
+void QuantizeRowwiseDynamicRef(
+    const float* src,
+    std::uint8_t* dst,
+    int64_t rows,
+    int cols,
+    float* scales,
+    int32_t* zero_points) {
+  for (int64_t r = 0; r < rows; ++r) {
+    const float* src_row = src + r * cols;
+    float min = cols > 0 ? src_row[0] : 0.0f;
+    float max = min;
+    for (int c = 1; c < cols; ++c) {
+      min = std::min(min, src_row[c]);
+      max = std::max(max, src_row[c]);
+    }
+    TensorQuantizationParams qparams =
+        ChooseQuantizationParams(min, max, 0, 255);
+    qparams.precision = 8;
+    scales[r] = qparams.scale;
+    zero_points[r] = qparams.zero_point;
+    for (int c = 0; c < cols; ++c) {
+      dst[r * cols + c] = Quantize<uint8_t, false>(src_row[c], qparams);
+    }
+  }
+}
+
+void QuantizeRowwiseDynamic(
+    const float* src,
+    std::uint8_t* dst,
+    int64_t rows,
+    int cols,
+    float* scales,
+    int32_t* zero_points,
+    int thread_id,
+    int num_threads) {
+  int64_t r_begin, r_end;
+  fbgemmPartition1D(thread_id, num_threads, rows, r_begin, r_end);
+  src += r_begin * cols;
+  dst += r_begin * cols;
+  scales += r_begin;
+  zero_points += r_begin;
+#if CPUINFO_ARCH_X86 || CPUINFO_ARCH_X86_64
+  if (cpuinfo_initialize() && fbgemmHasAvx512Support()) {
+    QuantizeRowwiseDynamicAvx512(
+        src, dst, r_end - r_begin, cols, scales, zero_points);
+    return;
+  }
+  if (fbgemmHasAvx2Support() && cpuinfo_has_x86_fma3()) {
+    QuantizeRowwiseDynamicAvx2(
+        src, dst, r_end - r_begin, cols, scales, zero_points);
+    return;
+  }
+#endif
+  QuantizeRowwiseDynamicRef(
+      src, dst, r_end - r_begin, cols, scales, zero_points);
+}
+
+template <bool LEGACY>
+void QuantizeWithRowOffsetsRef(
+    const float* src,
+    std::uint8_t* dst,
+    int64_t rows,
+    int cols,
+    const TensorQuantizationParams& qparams,
+    int32_t* row_offsets) {
+  for (int64_t r = 0; r < rows; ++r) {
+    int32_t sum = 0;
+    for (int c = 0; c < cols; ++c) {
+      dst[r * cols + c] = Quantize<uint8_t, LEGACY>(src[r * cols + c], qparams);
+      sum += dst[r * cols + c];
+    }
+    row_offsets[r] = sum;
+  }
+}
+
+template <bool LEGACY>
+void QuantizeWithRowOffsets(
+    const float* src,
+    std::uint8_t* dst,
+    int64_t rows,
+    int cols,
+    const TensorQuantizationParams& qparams,
+    int32_t* row_offsets,
+    int thread_id,
+    int num_threads) {
+  int64_t r_begin, r_end;
+  fbgemmPartition1D(thread_id, num_threads, rows, r_begin, r_end);
+  src += r_begin * cols;
+  dst += r_begin * cols;
+  row_offsets += r_begin;
+#if CPUINFO_ARCH_X86 || CPUINFO_ARCH_X86_64
+  if (qparams.precision == 8) {
+    if (cpuinfo_initialize() && fbgemmHasAvx512Support()) {
+      QuantizeWithRowOffsetsAvx512<LEGACY>(
+          src, dst, r_end - r_begin, cols, qparams, row_offsets);
+      return;
+    }
+    if (fbgemmHasAvx2Support() && cpuinfo_has_x86_fma3()) {
+      QuantizeWithRowOffsetsAvx2<LEGACY>(
+          src, dst, r_end - r_begin, cols, qparams, row_offsets);
+      return;
+    }
+  }
+#endif
+  QuantizeWithRowOffsetsRef<LEGACY>(
+      src, dst, r_end - r_begin, cols, qparams, row_offsets);
+}
+
+#define INSTANTIATE_QUANTIZE_WITH_ROW_OFFSETS(LEGACY)         \
+  template FBGEMM_API void QuantizeWithRowOffsetsRef<LEGACY>( \
+      const float* src,                                       \
+      std::uint8_t* dst,                                      \
+      int64_t rows,                                           \
+      int cols,                                               \
+      const TensorQuantizationParams& qparams,                \
+      int32_t* row_offsets);                                  \
+  template FBGEMM_API void QuantizeWithRowOffsets<LEGACY>(    \
+      const float* src,                                       \
+      std::uint8_t* dst,                                      \
+      int64_t rows,                                           \
+      int cols,                                               \
+      const TensorQuantizationParams& qparams,                \
+      int32_t* row_offsets,                                   \
+      int thread_id,                                          \
+      int num_threads);
+
+INSTANTIATE_QUANTIZE_WITH_ROW_OFFSETS(true)
+INSTANTIATE_QUANTIZE_WITH_ROW_OFFSETS(false)
+
+#undef INSTANTIATE_QUANTIZE_WITH_ROW_OFFSETS
+
+namespace {
+
+// Scale and bias of the n-bit rowwise quantization of the range [xmin, xmax]
+// after rounding to float16, as FloatOrHalfToFusedNBitRowwiseQuantizedSBHalf
+// computes them
+void nbitRowwiseScaleBias(
+    int bit_rate,
+    float xmin,
+    float xmax,
+    float& bias,
+    float& scale,
+    float& inverse_scale) {
+  bias = cpu_half2float(cpu_float2half_rn(xmin));
+  const float range = xmax - bias;
+  scale = range == 0 ? 1.0f : range / ((1 << bit_rate) - 1);
+  scale = cpu_half2float(cpu_float2half_rn(scale));
+  if (scale == 0) {
+    scale = 1.0f;
+  }
+  inverse_scale = 1.0f / scale;
+  if (std::isinf(inverse_scale)) {
+    scale = 1.0f;
+    inverse_scale = 1.0f;
+  }
+}
+
+float nbitRowwiseQuantizationSquaredErrorRef(
+    int bit_rate,
+    const float* input_row,
+    int input_columns,
+    float bias,
+    float scale,
+    float inverse_scale) {
+  const int qmax = (1 << bit_rate) - 1;
+  float error = 0.0f;
+  for (int col = 0; col < input_columns; ++col) {
+    const float X = input_row[col];
+    const int quantized = std::max(
+        0, std::min<int>(std::lrintf((X - bias) * inverse_scale), qmax));
+    const float diff = X - (scale * quantized + bias);
+    error += diff * diff;
+  }
+  return error;
+}
+
+template <typename SquaredErrorFn>
+void rangeSearchGreedy(
+    int bit_rate,
+    const float* input_row,
+    int input_columns,
+    float& xmin,
+    float& xmax,
+    int num_bins,
+    float ratio,
+    const SquaredErrorFn& squared_error) {
+  const float stepsize = (xmax - xmin) / num_bins;
+  // Constant rows have nothing to search, nor do rows with infinities or NaNs
+  if (!(stepsize > 0.0f) || !std::isfinite(stepsize)) {
+    return;
+  }
+  auto error = [&](int lo_steps, int hi_steps) {
+    float bias, scale, inverse_scale;
+    nbitRowwiseScaleBias(
+        bit_rate,
+        xmin + lo_steps * stepsize,
+        xmax - hi_steps * stepsize,
+        bias,
+        scale,
+        inverse_scale);
+    return squared_error(
+        bit_rate, input_row, input_columns, bias, scale, inverse_scale);
+  };
+
+  const int num_steps =
+      num_bins - static_cast<int>(num_bins * (1.0f - ratio));
+  float best_error = error(0, 0);
+  int best_lo = 0, best_hi = 0;
+  // Steps moved in from each end
+  int lo = 0, hi = 0;
+  for (int step = 0; step < num_steps; ++step) {
+    const float error_lo = error(lo + 1, hi);
+    const float error_hi = error(lo, hi + 1);
+    float current_error;
+    if (error_lo < error_hi) {
+      ++lo;
+      current_error = error_lo;
+    } else {
+      ++hi;
+      current_error = error_hi;
+    }
+    if (current_error < best_error) {
+      best_error = current_error;
+      best_lo = lo;
+      best_hi = hi;
+    }
+  }
+  const float range_min = xmin + best_lo * stepsize;
+  xmax -= best_hi * stepsize;
+  xmin = range_min;
+}
+
+} // namespace
+
+void NBitRowwiseRangeSearchGreedyRef(
+    int bit_rate,
+    const float* input_row,
+    int input_columns,
+    float& xmin,
+    float& xmax,
+    int num_bins,
+    float ratio) {
+  rangeSearchGreedy(
+      bit_rate,
+      input_row,
+      input_columns,
+      xmin,
+      xmax,
+      num_bins,
+      ratio,
+      nbitRowwiseQuantizationSquaredErrorRef);
+}
+
+void NBitRowwiseRangeSearchGreedy(
+    int bit_rate,
+    const float* input_row,
+    int input_columns,
+    float& xmin,
+    float& xmax,
+    int num_bins,
+    float ratio) {
+  if (cpuinfo_initialize() && fbgemmHasAvx2Support()) {
+#if CPUINFO_ARCH_X86 || CPUINFO_ARCH_X86_64
+    rangeSearchGreedy(
+        bit_rate,
+        input_row,
+        input_columns,
+        xmin,
+        xmax,
+        num_bins,
+        ratio,
+        NBitRowwiseQuantizationSquaredErrorAvx2);
+#endif
+  } else {
+    NBitRowwiseRangeSearchGreedyRef(
+        bit_rate, input_row, input_columns, xmin, xmax, num_bins, ratio);
+  }
+}
+
 template <typename InputType>
 void FloatOrHalfToFusedNBitRowwiseQuantizedSBHalfRef(
     int bit_rate,
     const InputType* input,
     size_t input_rows,
     int input_columns,
-    std::uint8_t* output) {
+    std::uint8_t* output,
+    bool greedy_range_search) {
   if (input_rows == 0 || input_columns == 0) {
     return;
   }
@@ -581,6 +1117,14 @@ void FloatOrHalfToFusedNBitRowwiseQuantizedSBHalfRef(
         *std::min_element(input_row_float.begin(), input_row_float.end());
     float maximum_element =
         *std::max_element(input_row_float.begin(), input_row_float.end());
+    if (greedy_range_search) {
+      NBitRowwiseRangeSearchGreedyRef(
+          bit_rate,
+          input_row_float.data(),
+          input_columns,
+          minimum_element,
+          maximum_element);
+    }
     // Truncate since bias will be represented by fp16. Keep higher precision
     // max untouched.
     float16 minimum_element_fp16 = cpu_float2half_rn(minimum_element);
@@ -626,7 +1170,10 @@ void FloatOrHalfToFusedNBitRowwiseQuantizedSBHalf(
     const InputType* input,
     size_t input_rows,
     int input_columns,
-    std::uint8_t* output) {
+    std::uint8_t* output,
+    int thread_id,
+    int num_threads,
+    bool greedy_range_search) {
   // Currenlty we can only dequantize if the number of input columns
   // is a multiple of number of elements_per_byte
 
@@ -635,29 +1182,46 @@ void FloatOrHalfToFusedNBitRowwiseQuantizedSBHalf(
     throw std::runtime_error("Unsupported number of columns");
   }
 
+  int64_t row_begin, row_end;
+  fbgemmPartition1D(thread_id, num_threads, input_rows, row_begin, row_end);
+  input += row_begin * input_columns;
+  output += row_begin *
+      (input_columns / num_elem_per_byte + 2 * sizeof(float16));
+  input_rows = row_end - row_begin;
+
   if (cpuinfo_initialize() && fbgemmHasAvx2Support()) {
 #if CPUINFO_ARCH_X86 || CPUINFO_ARCH_X86_64
     switch (bit_rate) {
       case 2:
         FloatOrHalfToFusedNBitRowwiseQuantizedSBHalfAvx2<InputType, 2>(
-            input, input_rows, input_columns, output);
+            input, input_rows, input_columns, output, greedy_range_search);
         break;
       case 4:
         FloatOrHalfToFusedNBitRowwiseQuantizedSBHalfAvx2<InputType, 4>(
-            input, input_rows, input_columns, output);
+            input, input_rows, input_columns, output, greedy_range_search);
         break;
       case 8:
         FloatOrHalfToFusedNBitRowwiseQuantizedSBHalfAvx2<InputType, 8>(
-            input, input_rows, input_columns, output);
+            input, input_rows, input_columns, output, greedy_range_search);
         break;
       default:
         FloatOrHalfToFusedNBitRowwiseQuantizedSBHalfRef<InputType>(
-            bit_rate, input, input_rows, input_columns, output);
+            bit_rate,
+            input,
+            input_rows,
+            input_columns,
+            output,
+            greedy_range_search);
     }
 #endif
   } else {
     FloatOrHalfToFusedNBitRowwiseQuantizedSBHalfRef<InputType>(
-        bit_rate, input, input_rows, input_columns, output);
+        bit_rate,
+        input,
+        input_rows,
+        input_columns,
+        output,
+        greedy_range_search);
   }
 }
 
@@ -711,7 +1275,14 @@ void FloatOrHalfToFused8BitRowwiseQuantizedSBFloat(
     const InputType* input,
     size_t input_rows,
     int input_columns,
-    std::uint8_t* output) {
+    std::uint8_t* output,
+    int thread_id,
+    int num_threads) {
+  int64_t row_begin, row_end;
+  fbgemmPartition1D(thread_id, num_threads, input_rows, row_begin, row_end);
+  input += row_begin * input_columns;
+  output += row_begin * (input_columns + 2 * sizeof(float));
+  input_rows = row_end - row_begin;
   if (cpuinfo_initialize() && fbgemmHasAvx2Support()) {
 #if CPUINFO_ARCH_X86 || CPUINFO_ARCH_X86_64
     FloatOrHalfToFused8BitRowwiseQuantizedSBFloatAvx2<InputType>(
@@ -767,7 +1338,14 @@ void FusedNBitRowwiseQuantizedSBHalfToFloatOrHalf(
     const uint8_t* input,
     size_t input_rows,
     int input_columns,
-    OutputType* output) {
+    OutputType* output,
+    int thread_id,
+    int num_threads) {
+  int64_t row_begin, row_end;
+  fbgemmPartition1D(thread_id, num_threads, input_rows, row_begin, row_end);
+  input += row_begin * input_columns;
+  output += row_begin * (input_columns - 2 * sizeof(float16)) * (8 / bit_rate);
+  input_rows = row_end - row_begin;
   if (cpuinfo_initialize() && fbgemmHasAvx2Support()) {
 #if CPUINFO_ARCH_X86 || CPUINFO_ARCH_X86_64
     switch (bit_rate) {
@@ -794,6 +1372,239 @@ void FusedNBitRowwiseQuantizedSBHalfToFloatOrHalf(
   }
 }
 
+namespace {
+
+// The groupwise rows are handled as one rowwise row of group_size elements
+// per group, with its scale and bias last. These move num_rows rows between
+// the two layouts.
+void FusedNBitGroupsToGroupwiseRows(
+    const std::uint8_t* group_rows,
+    size_t num_rows,
+    int num_groups,
+    int group_bytes,
+    std::uint8_t* output) {
+  const int64_t group_row_bytes = group_bytes + 2 * sizeof(float16);
+  const int64_t row_bytes = num_groups * group_row_bytes;
+  for (size_t row = 0; row < num_rows; ++row) {
+    std::uint8_t* output_row = output + row * row_bytes;
+    for (int g = 0; g < num_groups; ++g) {
+      const std::uint8_t* group_row =
+          group_rows + (row * num_groups + g) * group_row_bytes;
+      memcpy(output_row + g * group_bytes, group_row, group_bytes);
+      memcpy(
+          output_row + num_groups * group_bytes + g * 2 * sizeof(float16),
+          group_row + group_bytes,
+          2 * sizeof(float16));
+    }
+  }
+}
+
+void GroupwiseRowsToFusedNBitGroups(
+    const std::uint8_t* input,
+    size_t num_rows,
+    int num_groups,
+    int group_bytes,
+    std::uint8_t* group_rows) {
+  const int64_t group_row_bytes = group_bytes + 2 * sizeof(float16);
+  const int64_t row_bytes = num_groups * group_row_bytes;
+  for (size_t row = 0; row < num_rows; ++row) {
+    const std::uint8_t* input_row = input + row * row_bytes;
+    for (int g = 0; g < num_groups; ++g) {
+      std::uint8_t* group_row =
+          group_rows + (row * num_groups + g) * group_row_bytes;
+      memcpy(group_row, input_row + g * group_bytes, group_bytes);
+      memcpy(
+          group_row + group_bytes,
+          input_row + num_groups * group_bytes + g * 2 * sizeof(float16),
+          2 * sizeof(float16));
+    }
+  }
+}
+
+void CheckNBitGroupSize(int bit_rate, int group_size, int64_t columns) {
+  if (group_size <= 0 || columns % group_size != 0 ||
+      group_size % (8 / bit_rate) != 0) {
+    throw std::runtime_error("Unsupported group size");
+  }
+}
+
+// Rows quantized or dequantized at once, to bound the scratch buffer
+constexpr int64_t kNBitGroupwiseScratchBytes = 1 << 16;
+
+} // namespace
+
+template <typename InputType>
+void FloatOrHalfToFusedNBitGroupwiseQuantizedSBHalfRef(
+    int bit_rate,
+    int group_size,
+    const InputType* input,
+    size_t input_rows,
+    int input_columns,
+    std::uint8_t* output,
+    bool greedy_range_search) {
+  if (input_rows == 0 || input_columns == 0) {
+    return;
+  }
+  CheckNBitGroupSize(bit_rate, group_size, input_columns);
+  const int num_groups = input_columns / group_size;
+  const int group_bytes = group_size / (8 / bit_rate);
+
+  // Quantize each group as a row of its own
+  std::vector<std::uint8_t> group_rows(
+      num_groups * (group_bytes + 2 * sizeof(float16)));
+  for (size_t row = 0; row < input_rows; ++row) {
+    for (int g = 0; g < num_groups; ++g) {
+      FloatOrHalfToFusedNBitRowwiseQuantizedSBHalfRef<InputType>(
+          bit_rate,
+          input + row * input_columns + g * group_size,
+          1,
+          group_size,
+          group_rows.data() + g * (group_bytes + 2 * sizeof(float16)),
+          greedy_range_search);
+    }
+    FusedNBitGroupsToGroupwiseRows(
+        group_rows.data(),
+        1,
+        num_groups,
+        group_bytes,
+        output + row * num_groups * (group_bytes + 2 * sizeof(float16)));
+  }
+}
+
+template <typename InputType>
+void FloatOrHalfToFusedNBitGroupwiseQuantizedSBHalf(
+    int bit_rate,
+    int group_size,
+    const InputType* input,
+    size_t input_rows,
+    int input_columns,
+    std::uint8_t* output,
+    int thread_id,
+    int num_threads,
+    bool greedy_range_search) {
+  CheckNBitGroupSize(bit_rate, group_size, input_columns);
+  const int num_groups = input_columns / group_size;
+  const int group_bytes = group_size / (8 / bit_rate);
+  const int64_t row_bytes = num_groups * (group_bytes + 2 * sizeof(float16));
+
+  int64_t row_begin, row_end;
+  fbgemmPartition1D(thread_id, num_threads, input_rows, row_begin, row_end);
+  if (row_begin >= row_end) {
+    return;
+  }
+
+  // Rows are contiguous, so a chunk of rows is also a chunk of
+  // rows * num_groups rows of group_size elements, which the rowwise kernel
+  // quantizes in one call
+  const int64_t chunk_rows =
+      std::max<int64_t>(1, kNBitGroupwiseScratchBytes / row_bytes);
+  std::vector<std::uint8_t> group_rows(
+      std::min(chunk_rows, row_end - row_begin) * row_bytes);
+  for (int64_t row = row_begin; row < row_end; row += chunk_rows) {
+    const int64_t rows = std::min(chunk_rows, row_end - row);
+    FloatOrHalfToFusedNBitRowwiseQuantizedSBHalf<InputType>(
+        bit_rate,
+        input + row * input_columns,
+        rows * num_groups,
+        group_size,
+        group_rows.data(),
+        /*thread_id=*/0,
+        /*num_threads=*/1,
+        greedy_range_search);
+    FusedNBitGroupsToGroupwiseRows(
+        group_rows.data(),
+        rows,
+        num_groups,
+        group_bytes,
+        output + row * row_bytes);
+  }
+}
+
+template <typename OutputType>
+void FusedNBitGroupwiseQuantizedSBHalfToFloatOrHalfRef(
+    int bit_rate,
+    int group_size,
+    const uint8_t* input,
+    size_t input_rows,
+    int input_columns,
+    OutputType* output) {
+  const int num_elem_per_byte = 8 / bit_rate;
+  // Each group takes group_size / num_elem_per_byte bytes of data and 4 bytes
+  // of scale and bias
+  const int64_t group_row_bytes =
+      group_size / num_elem_per_byte + 2 * sizeof(float16);
+  if (group_size <= 0 || group_size % num_elem_per_byte != 0 ||
+      input_columns % group_row_bytes != 0) {
+    throw std::runtime_error("Unsupported group size");
+  }
+  const int num_groups = input_columns / group_row_bytes;
+  const int group_bytes = group_size / num_elem_per_byte;
+
+  std::vector<std::uint8_t> group_rows(input_columns);
+  for (size_t row = 0; row < input_rows; ++row) {
+    GroupwiseRowsToFusedNBitGroups(
+        input + row * input_columns,
+        1,
+        num_groups,
+        group_bytes,
+        group_rows.data());
+    FusedNBitRowwiseQuantizedSBHalfToFloatOrHalfRef<OutputType>(
+        bit_rate,
+        group_rows.data(),
+        num_groups,
+        group_row_bytes,
+        output + row * num_groups * group_size);
+  }
+}
+
+template <typename OutputType>
+void FusedNBitGroupwiseQuantizedSBHalfToFloatOrHalf(
+    int bit_rate,
+    int group_size,
+    const uint8_t* input,
+    size_t input_rows,
+    int input_columns,
+    OutputType* output,
+    int thread_id,
+    int num_threads) {
+  const int num_elem_per_byte = 8 / bit_rate;
+  const int64_t group_row_bytes =
+      group_size / num_elem_per_byte + 2 * sizeof(float16);
+  if (group_size <= 0 || group_size % num_elem_per_byte != 0 ||
+      input_columns % group_row_bytes != 0) {
+    throw std::runtime_error("Unsupported group size");
+  }
+  const int num_groups = input_columns / group_row_bytes;
+  const int group_bytes = group_size / num_elem_per_byte;
+  const int64_t output_columns = static_cast<int64_t>(num_groups) * group_size;
+
+  int64_t row_begin, row_end;
+  fbgemmPartition1D(thread_id, num_threads, input_rows, row_begin, row_end);
+  if (row_begin >= row_end) {
+    return;
+  }
+
+  const int64_t chunk_rows =
+      std::max<int64_t>(1, kNBitGroupwiseScratchBytes / input_columns);
+  std::vector<std::uint8_t> group_rows(
+      std::min(chunk_rows, row_end - row_begin) * input_columns);
+  for (int64_t row = row_begin; row < row_end; row += chunk_rows) {
+    const int64_t rows = std::min(chunk_rows, row_end - row);
+    GroupwiseRowsToFusedNBitGroups(
+        input + row * input_columns,
+        rows,
+        num_groups,
+        group_bytes,
+        group_rows.data());
+    FusedNBitRowwiseQuantizedSBHalfToFloatOrHalf<OutputType>(
+        bit_rate,
+        group_rows.data(),
+        rows * num_groups,
+        group_row_bytes,
+        output + row * output_columns);
+  }
+}
+
 template <typename OutputType>
 void Fused8BitRowwiseQuantizedSBFloatToFloatOrHalfRef(
     const std::uint8_t* input,
@@ -825,7 +1636,14 @@ void Fused8BitRowwiseQuantizedSBFloatToFloatOrHalf(
     const std::uint8_t* input,
     size_t input_rows,
     int input_columns,
-    OutputType* output) {
+    OutputType* output,
+    int thread_id,
+    int num_threads) {
+  int64_t row_begin, row_end;
+  fbgemmPartition1D(thread_id, num_threads, input_rows, row_begin, row_end);
+  input += row_begin * input_columns;
+  output += row_begin * (input_columns - 2 * sizeof(float));
+  input_rows = row_end - row_begin;
   if (cpuinfo_initialize() && fbgemmHasAvx2Support()) {
 #if CPUINFO_ARCH_X86 || CPUINFO_ARCH_X86_64
     Fused8BitRowwiseQuantizedSBFloatToFloatOrHalfAvx2<OutputType>(
@@ -837,6 +1655,524 @@ void Fused8BitRowwiseQuantizedSBFloatToFloatOrHalf(
   }
 }
 
+template <typename InputType>
+void FloatOrHalfToFusedFP8RowwiseQuantizedRef(
+    const InputType* input,
+    size_t input_rows,
+    int input_columns,
+    std::uint8_t* output,
+    int exponent_bits,
+    int exponent_bias) {
+  static_assert(
+      std::is_same<InputType, float>() || std::is_same<InputType, float16>(),
+      "Only float and float16 types are allowed.");
+  // Largest float8 value as in FloatToFloat8_ref
+  const float max_pos = (1 << ((1 << exponent_bits) - 2 - exponent_bias)) *
+      (2 - std::pow(2, exponent_bits - 7));
+  const int64_t output_columns =
+      static_cast<int64_t>(input_columns) + sizeof(float);
+  std::vector<float> input_row_float(input_columns);
+  for (size_t row = 0; row < input_rows; ++row) {
+    const InputType* input_row = input + row * input_columns;
+    std::uint8_t* output_row = output + row * output_columns;
+    float* output_row_scale =
+        reinterpret_cast<float*>(output_row + input_columns);
+
+    float maximum_element = 0.0f;
+    for (int col = 0; col < input_columns; ++col) {
+      if (std::is_same<InputType, float>()) {
+        input_row_float[col] = input_row[col];
+      } else {
+        input_row_float[col] = cpu_half2float(input_row[col]);
+      }
+      maximum_element =
+          std::max(maximum_element, std::abs(input_row_float[col]));
+    }
+
+    const float scale =
+        maximum_element > 0.0f ? maximum_element / max_pos : 1.0f;
+    output_row_scale[0] = scale;
+    const float inverse_scale = 1.0f / scale;
+    for (int col = 0; col < input_columns; ++col) {
+      FloatToFloat8_ref(
+          input_row_float[col] * inverse_scale,
+          output_row + col,
+          exponent_bits,
+          exponent_bias);
+    }
+  } // for each row
+}
+
+template <typename InputType>
+void FloatOrHalfToFusedFP8RowwiseQuantized(
+    const InputType* input,
+    size_t input_rows,
+    int input_columns,
+    std::uint8_t* output,
+    int exponent_bits,
+    int exponent_bias,
+    int thread_id,
+    int num_threads) {
+  int64_t row_begin, row_end;
+  fbgemmPartition1D(thread_id, num_threads, input_rows, row_begin, row_end);
+  input += row_begin * input_columns;
+  output += row_begin * (input_columns + sizeof(float));
+  if (cpuinfo_initialize() && fbgemmHasAvx2Support()) {
+#if CPUINFO_ARCH_X86 || CPUINFO_ARCH_X86_64
+    FloatOrHalfToFusedFP8RowwiseQuantizedAvx2<InputType>(
+        input,
+        row_end - row_begin,
+        input_columns,
+        output,
+        exponent_bits,
+        exponent_bias);
+#endif
+  } else {
+    FloatOrHalfToFusedFP8RowwiseQuantizedRef<InputType>(
+        input,
+        row_end - row_begin,
+        input_columns,
+        output,
+        exponent_bits,
+        exponent_bias);
+  }
+}
+
+template <typename OutputType>
+void FusedFP8RowwiseQuantizedToFloatOrHalfRef(
+    const std::uint8_t* input,
+    size_t input_rows,
+    int input_columns,
+    OutputType* output,
+    int exponent_bits,
+    int exponent_bias) {
+  static_assert(
+      std::is_same<OutputType, float>() || std::is_same<OutputType, float16>(),
+      "Only float and float16 types are allowed.");
+  int output_columns = input_columns - sizeof(float);
+
+  for (size_t row = 0; row < input_rows; ++row) {
+    const std::uint8_t* input_row = input + row * input_columns;
+    const float scale =
+        *reinterpret_cast<const float*>(input_row + output_columns);
+    OutputType* output_row = output + row * output_columns;
+
+    for (int col = 0; col < output_columns; ++col) {
+      float output_value;
+      Float8ToFloat_ref(
+          input_row[col], &output_value, exponent_bits, exponent_bias);
+      output_value *= scale;
+      if (std::is_same<OutputType, float>()) {
+        output_row[col] = output_value;
+      } else {
+        output_row[col] = cpu_float2half_rn(output_value);
+      }
+    }
+  }
+}
+
+template <typename OutputType>
+void FusedFP8RowwiseQuantizedToFloatOrHalf(
+    const std::uint8_t* input,
+    size_t input_rows,
+    int input_columns,
+    OutputType* output,
+    int exponent_bits,
+    int exponent_bias,
+    int thread_id,
+    int num_threads) {
+  int64_t row_begin, row_end;
+  fbgemmPartition1D(thread_id, num_threads, input_rows, row_begin, row_end);
+  input += row_begin * input_columns;
+  output += row_begin * (input_columns - static_cast<int64_t>(sizeof(float)));
+  if (cpuinfo_initialize() && fbgemmHasAvx2Support()) {
+#if CPUINFO_ARCH_X86 || CPUINFO_ARCH_X86_64
+    FusedFP8RowwiseQuantizedToFloatOrHalfAvx2<OutputType>(
+        input,
+        row_end - row_begin,
+        input_columns,
+        output,
+        exponent_bits,
+        exponent_bias);
+#endif
+  } else {
+    FusedFP8RowwiseQuantizedToFloatOrHalfRef<OutputType>(
+        input,
+        row_end - row_begin,
+        input_columns,
+        output,
+        exponent_bits,
+        exponent_bias);
+  }
+}
+
+namespace {
+
+// Element format of an MX block format as a minifloat, except for MXINT8
+struct MXElementFormat {
+  int exponent_bits;
+  int mantissa_bits;
+  int exponent_bias;
+  // Exponent of the largest power of two, emax of the OCP MX specification
+  int emax;
+  float max_pos;
+};
+
+MXElementFormat mxElementFormat(MXFormat format) {
+  switch (format) {
+    case MXFormat::MXFP8_E4M3:
+      return {4, 3, 7, 8, 448.0f};
+    case MXFormat::MXFP8_E5M2:
+      return {5, 2, 15, 15, 57344.0f};
+    case MXFormat::MXFP4_E2M1:
+      return {2, 1, 1, 2, 6.0f};
+    case MXFormat::MXINT8:
+      return {0, 6, 0, 0, 127.0f / 64};
+  }
+  assert(false && "unknown MX format");
+  return {};
+}
+
+// Finite x rounded to nearest even and saturated to the element format
+std::uint8_t floatToMXElement(float x, const MXElementFormat& f) {
+  if (f.exponent_bits == 0) {
+    // MXINT8
+    const float q = std::nearbyint(std::ldexp(x, f.mantissa_bits));
+    return static_cast<std::int8_t>(std::min(std::max(q, -128.0f), 127.0f));
+  }
+  const std::uint8_t sign = std::signbit(x)
+      ? 1 << (f.exponent_bits + f.mantissa_bits)
+      : 0;
+  const float abs_x = std::min(std::abs(x), f.max_pos);
+  if (abs_x == 0.0f) {
+    return sign;
+  }
+  const int emin = 1 - f.exponent_bias;
+  int e;
+  std::frexp(abs_x, &e);
+  // Denormals are fixed point with the exponent of the smallest normal
+  const int exponent = std::max(e - 1, emin);
+  // The leading bit and the mantissa, which may round up to the next power
+  // of two, which carries into the exponent field as it should
+  const int significand = static_cast<int>(
+      std::nearbyint(std::ldexp(abs_x, f.mantissa_bits - exponent)));
+  return sign | (((exponent - emin) << f.mantissa_bits) + significand);
+}
+
+// Values of all the codes of the element format
+std::vector<float> mxElementTable(MXFormat format) {
+  const MXElementFormat f = mxElementFormat(format);
+  if (format == MXFormat::MXINT8) {
+    std::vector<float> table(256);
+    for (int code = 0; code < 256; ++code) {
+      table[code] =
+          std::ldexp(static_cast<std::int8_t>(code), -f.mantissa_bits);
+    }
+    return table;
+  }
+  const int magnitude_bits = f.exponent_bits + f.mantissa_bits;
+  std::vector<float> table(2 << magnitude_bits);
+  for (int code = 0; code < static_cast<int>(table.size()); ++code) {
+    const int magnitude = code & ((1 << magnitude_bits) - 1);
+    const int exponent_field = magnitude >> f.mantissa_bits;
+    const int mantissa = magnitude & ((1 << f.mantissa_bits) - 1);
+    float value;
+    if (format == MXFormat::MXFP8_E4M3 && magnitude == 0x7F) {
+      value = std::numeric_limits<float>::quiet_NaN();
+    } else if (format == MXFormat::MXFP8_E5M2 && exponent_field == 0x1F) {
+      value = mantissa ? std::numeric_limits<float>::quiet_NaN()
+                       : std::numeric_limits<float>::infinity();
+    } else if (exponent_field == 0) {
+      value = std::ldexp(mantissa, 1 - f.exponent_bias - f.mantissa_bits);
+    } else {
+      value = std::ldexp(
+          mantissa + (1 << f.mantissa_bits),
+          exponent_field - f.exponent_bias - f.mantissa_bits);
+    }
+    table[code] = code >> magnitude_bits ? -value : value;
+  }
+  return table;
+}
+
+int mxElementBytes(MXFormat format, int columns) {
+  return format == MXFormat::MXFP4_E2M1 ? (columns + 1) / 2 : columns;
+}
+
+} // namespace
+
+int MXQuantizedRowBytes(MXFormat format, int columns) {
+  return mxElementBytes(format, columns) +
+      (columns + kMXBlockSize - 1) / kMXBlockSize;
+}
+
+template <typename InputType>
+void FloatOrHalfToMXQuantized(
+    MXFormat format,
+    const InputType* input,
+    size_t input_rows,
+    int input_columns,
+    std::uint8_t* output,
+    int thread_id,
+    int num_threads) {
+  static_assert(
+      std::is_same<InputType, float>() || std::is_same<InputType, float16>(),
+      "Only float and float16 types are allowed.");
+  const MXElementFormat f = mxElementFormat(format);
+  const bool is_fp4 = format == MXFormat::MXFP4_E2M1;
+  const int element_bytes = mxElementBytes(format, input_columns);
+  const int64_t output_columns = MXQuantizedRowBytes(format, input_columns);
+
+  int64_t row_begin, row_end;
+  fbgemmPartition1D(thread_id, num_threads, input_rows, row_begin, row_end);
+  float block[kMXBlockSize];
+  for (int64_t row = row_begin; row < row_end; ++row) {
+    const InputType* input_row = input + row * input_columns;
+    std::uint8_t* output_row = output + row * output_columns;
+    std::uint8_t* output_row_scales = output_row + element_bytes;
+
+    for (int begin = 0; begin < input_columns; begin += kMXBlockSize) {
+      const int len = std::min(input_columns - begin, kMXBlockSize);
+      float amax = 0.0f;
+      bool finite = true;
+      for (int i = 0; i < len; ++i) {
+        if (std::is_same<InputType, float>()) {
+          block[i] = input_row[begin + i];
+        } else {
+          block[i] = cpu_half2float(input_row[begin + i]);
+        }
+        finite = finite && std::isfinite(block[i]);
+        amax = std::max(amax, std::abs(block[i]));
+      }
+
+      int shared_exponent = -127;
+      if (!finite) {
+        // NaN scale, the elements are ignored
+        output_row_scales[begin / kMXBlockSize] = 0xFF;
+        std::fill_n(block, len, 0.0f);
+      } else {
+        if (amax > 0.0f) {
+          int e;
+          std::frexp(amax, &e);
+          shared_exponent = std::min(std::max(e - 1 - f.emax, -127), 127);
+        }
+        output_row_scales[begin / kMXBlockSize] = shared_exponent + 127;
+      }
+
+      for (int i = 0; i < len; ++i) {
+        const std::uint8_t code =
+            floatToMXElement(std::ldexp(block[i], -shared_exponent), f);
+        const int col = begin + i;
+        if (!is_fp4) {
+          output_row[col] = code;
+        } else if (col % 2 == 0) {
+          output_row[col / 2] = code;
+        } else {
+          output_row[col / 2] |= code << 4;
+        }
+      }
+    }
+  }
+}
+
+template <typename OutputType>
+void MXQuantizedToFloatOrHalf(
+    MXFormat format,
+    const std::uint8_t* input,
+    size_t input_rows,
+    int output_columns,
+    OutputType* output,
+    int thread_id,
+    int num_threads) {
+  static_assert(
+      std::is_same<OutputType, float>() || std::is_same<OutputType, float16>(),
+      "Only float and float16 types are allowed.");
+  const std::vector<float> table = mxElementTable(format);
+  const bool is_fp4 = format == MXFormat::MXFP4_E2M1;
+  const int element_bytes = mxElementBytes(format, output_columns);
+  const int64_t input_columns = MXQuantizedRowBytes(format, output_columns);
+
+  int64_t row_begin, row_end;
+  fbgemmPartition1D(thread_id, num_threads, input_rows, row_begin, row_end);
+  for (int64_t row = row_begin; row < row_end; ++row) {
+    const std::uint8_t* input_row = input + row * input_columns;
+    const std::uint8_t* input_row_scales = input_row + element_bytes;
+    OutputType* output_row = output + row * output_columns;
+
+    for (int begin = 0; begin < output_columns; begin += kMXBlockSize) {
+      const int end = std::min(begin + kMXBlockSize, output_columns);
+      const std::uint8_t scale_code = input_row_scales[begin / kMXBlockSize];
+      const float scale = scale_code == 0xFF
+          ? std::numeric_limits<float>::quiet_NaN()
+          : std::ldexp(1.0f, scale_code - 127);
+      for (int col = begin; col < end; ++col) {
+        const std::uint8_t code = is_fp4
+            ? (input_row[col / 2] >> (col % 2 * 4)) & 0xF
+            : input_row[col];
+        const float output_value = table[code] * scale;
+        if (std::is_same<OutputType, float>()) {
+          output_row[col] = output_value;
+        } else {
+          output_row[col] = cpu_float2half_rn(output_value);
+        }
+      }
+    }
+  }
+}
+
+namespace {
+
+// Runs quantize(thread_id, num_threads) for each of the row ranges
+void forEachRowRange(
+    size_t rows,
+    int num_threads,
+    const ParallelTasksExecutor& parallel_for,
+    const std::function<void(int thread_id, int num_threads)>& quantize) {
+  if (num_threads <= 0) {
+    num_threads = fbgemmGetNumThreads();
+  }
+  num_threads = static_cast<int>(
+      std::min<size_t>(num_threads, std::max<size_t>(rows, 1)));
+  if (num_threads == 1) {
+    quantize(0, 1);
+    return;
+  }
+  auto task = [&](int task_id) { quantize(task_id, num_threads); };
+  if (parallel_for) {
+    parallel_for(num_threads, task);
+  } else {
+    fbgemmParallelTasks(num_threads, task);
+  }
+}
+
+// Quantizes chunk_rows rows at a time into one buffer of output, handing each
+// chunk to consumer
+template <typename InputType>
+void quantizeInChunks(
+    const InputType* input,
+    size_t input_rows,
+    int input_columns,
+    int64_t output_columns,
+    const RowwiseQuantizedChunkConsumer& consumer,
+    size_t chunk_rows,
+    const std::function<void(
+        const InputType* input,
+        size_t rows,
+        std::uint8_t* output)>& quantize) {
+  if (chunk_rows == 0) {
+    throw std::runtime_error("chunk_rows must be positive");
+  }
+  chunk_rows = std::min(chunk_rows, input_rows);
+  std::vector<std::uint8_t> buffer(chunk_rows * output_columns);
+  for (size_t row_begin = 0; row_begin < input_rows; row_begin += chunk_rows) {
+    const size_t rows = std::min(chunk_rows, input_rows - row_begin);
+    quantize(input + row_begin * input_columns, rows, buffer.data());
+    consumer(buffer.data(), row_begin, rows);
+  }
+}
+
+} // namespace
+
+template <typename InputType>
+void FloatOrHalfToFusedNBitRowwiseQuantizedSBHalfParallel(
+    int bit_rate,
+    const InputType* input,
+    size_t input_rows,
+    int input_columns,
+    std::uint8_t* output,
+    int num_threads,
+    const ParallelTasksExecutor& parallel_for,
+    bool greedy_range_search) {
+  // Checked here since the threads cannot throw
+  if (input_columns % (8 / bit_rate) != 0) {
+    throw std::runtime_error("Unsupported number of columns");
+  }
+  forEachRowRange(
+      input_rows, num_threads, parallel_for, [&](int tid, int nthreads) {
+        FloatOrHalfToFusedNBitRowwiseQuantizedSBHalf<InputType>(
+            bit_rate,
+            input,
+            input_rows,
+            input_columns,
+            output,
+            tid,
+            nthreads,
+            greedy_range_search);
+      });
+}
+
+template <typename InputType>
+void FloatOrHalfToFused8BitRowwiseQuantizedSBFloatParallel(
+    const InputType* input,
+    size_t input_rows,
+    int input_columns,
+    std::uint8_t* output,
+    int num_threads,
+    const ParallelTasksExecutor& parallel_for) {
+  forEachRowRange(
+      input_rows, num_threads, parallel_for, [&](int tid, int nthreads) {
+        FloatOrHalfToFused8BitRowwiseQuantizedSBFloat<InputType>(
+            input, input_rows, input_columns, output, tid, nthreads);
+      });
+}
+
+template <typename InputType>
+void FloatOrHalfToFusedNBitRowwiseQuantizedSBHalfChunked(
+    int bit_rate,
+    const InputType* input,
+    size_t input_rows,
+    int input_columns,
+    const RowwiseQuantizedChunkConsumer& consumer,
+    size_t chunk_rows,
+    int num_threads,
+    const ParallelTasksExecutor& parallel_for,
+    bool greedy_range_search) {
+  const int num_elem_per_byte = 8 / bit_rate;
+  const int64_t output_columns =
+      (static_cast<int64_t>(input_columns) + num_elem_per_byte - 1) /
+          num_elem_per_byte +
+      2 * sizeof(float16);
+  quantizeInChunks<InputType>(
+      input,
+      input_rows,
+      input_columns,
+      output_columns,
+      consumer,
+      chunk_rows,
+      [&](const InputType* chunk, size_t rows, std::uint8_t* output) {
+        FloatOrHalfToFusedNBitRowwiseQuantizedSBHalfParallel<InputType>(
+            bit_rate,
+            chunk,
+            rows,
+            input_columns,
+            output,
+            num_threads,
+            parallel_for,
+            greedy_range_search);
+      });
+}
+
+template <typename InputType>
+void FloatOrHalfToFused8BitRowwiseQuantizedSBFloatChunked(
+    const InputType* input,
+    size_t input_rows,
+    int input_columns,
+    const RowwiseQuantizedChunkConsumer& consumer,
+    size_t chunk_rows,
+    int num_threads,
+    const ParallelTasksExecutor& parallel_for) {
+  quantizeInChunks<InputType>(
+      input,
+      input_rows,
+      input_columns,
+      static_cast<int64_t>(input_columns) + 2 * sizeof(float),
+      consumer,
+      chunk_rows,
+      [&](const InputType* chunk, size_t rows, std::uint8_t* output) {
+        FloatOrHalfToFused8BitRowwiseQuantizedSBFloatParallel<InputType>(
+            chunk, rows, input_columns, output, num_threads, parallel_for);
+      });
+}
+
 #define INSTANTIATE_QuantizationFunctions(type)                                \
   template FBGEMM_API void                                                     \
   FloatOrHalfToFusedNBitRowwiseQuantizedSBHalfRef<type>(                       \
@@ -844,13 +2180,17 @@ void Fused8BitRowwiseQuantizedSBFloatToFloatOrHalf(
       const type* input,                                                       \
       size_t input_rows,                                                       \
       int input_columns,                                                       \
-      std::uint8_t* output);                                                   \
+      std::uint8_t* output,                                                    \
+      bool greedy_range_search);                                               \
   template FBGEMM_API void FloatOrHalfToFusedNBitRowwiseQuantizedSBHalf<type>( \
       int bit_rate,                                                            \
       const type* input,                                                       \
       size_t input_rows,                                                       \
       int input_columns,                                                       \
-      std::uint8_t* output);                                                   \
+      std::uint8_t* output,                                                    \
+      int thread_id,                                                           \
+      int num_threads,                                                         \
+      bool greedy_range_search);                                               \
   template FBGEMM_API void                                                     \
   FusedNBitRowwiseQuantizedSBHalfToFloatOrHalfRef<type>(                       \
       int bit_rate,                                                            \
@@ -863,8 +2203,48 @@ void Fused8BitRowwiseQuantizedSBFloatToFloatOrHalf(
       const uint8_t* input,                                                    \
       size_t input_rows,                                                       \
       int input_columns,                                                       \
+      type* output,                                                            \
+      int thread_id,                                                           \
+      int num_threads);                                                        \
+  template FBGEMM_API void                                                     \
+  FloatOrHalfToFusedNBitGroupwiseQuantizedSBHalfRef<type>(                     \
+      int bit_rate,                                                            \
+      int group_size,                                                          \
+      const type* input,                                                       \
+      size_t input_rows,                                                       \
+      int input_columns,                                                       \
+      std::uint8_t* output,                                                    \
+      bool greedy_range_search);                                               \
+  template FBGEMM_API void                                                     \
+  FloatOrHalfToFusedNBitGroupwiseQuantizedSBHalf<type>(                        \
+      int bit_rate,                                                            \
+      int group_size,                                                          \
+      const type* input,                                                       \
+      size_t input_rows,                                                       \
+      int input_columns,                                                       \
+      std::uint8_t* output,                                                    \
+      int thread_id,                                                           \
+      int num_threads,                                                         \
+      bool greedy_range_search);                                               \
+  template FBGEMM_API void                                                     \
+  FusedNBitGroupwiseQuantizedSBHalfToFloatOrHalfRef<type>(                     \
+      int bit_rate,                                                            \
+      int group_size,                                                          \
+      const uint8_t* input,                                                    \
+      size_t input_rows,                                                       \
+      int input_columns,                                                       \
       type* output);                                                           \
   template FBGEMM_API void                                                     \
+  FusedNBitGroupwiseQuantizedSBHalfToFloatOrHalf<type>(                        \
+      int bit_rate,                                                            \
+      int group_size,                                                          \
+      const uint8_t* input,                                                    \
+      size_t input_rows,                                                       \
+      int input_columns,                                                       \
+      type* output,                                                            \
+      int thread_id,                                                           \
+      int num_threads);                                                        \
+  template FBGEMM_API void                                                     \
   FloatOrHalfToFused8BitRowwiseQuantizedSBFloatRef<type>(                      \
       const type* input,                                                       \
       size_t input_rows,                                                       \
@@ -875,7 +2255,9 @@ void Fused8BitRowwiseQuantizedSBFloatToFloatOrHalf(
       const type* input,                                                       \
       size_t input_rows,                                                       \
       int input_columns,                                                       \
-      std::uint8_t* output);                                                   \
+      std::uint8_t* output,                                                    \
+      int thread_id,                                                           \
+      int num_threads);                                                        \
   template FBGEMM_API void                                                     \
   Fused8BitRowwiseQuantizedSBFloatToFloatOrHalfRef<type>(                      \
       const uint8_t* input,                                                    \
@@ -887,7 +2269,95 @@ void Fused8BitRowwiseQuantizedSBFloatToFloatOrHalf(
       const uint8_t* input,                                                    \
       size_t input_rows,                                                       \
       int input_columns,                                                       \
-      type* output);
+      type* output,                                                            \
+      int thread_id,                                                           \
+      int num_threads);                                                        \
+  template FBGEMM_API void FloatOrHalfToFusedFP8RowwiseQuantizedRef<type>(     \
+      const type* input,                                                       \
+      size_t input_rows,                                                       \
+      int input_columns,                                                       \
+      std::uint8_t* output,                                                    \
+      int exponent_bits,                                                       \
+      int exponent_bias);                                                      \
+  template FBGEMM_API void FloatOrHalfToFusedFP8RowwiseQuantized<type>(        \
+      const type* input,                                                       \
+      size_t input_rows,                                                       \
+      int input_columns,                                                       \
+      std::uint8_t* output,                                                    \
+      int exponent_bits,                                                       \
+      int exponent_bias,                                                       \
+      int thread_id,                                                           \
+      int num_threads);                                                        \
+  template FBGEMM_API void FusedFP8RowwiseQuantizedToFloatOrHalfRef<type>(     \
+      const uint8_t* input,                                                    \
+      size_t input_rows,                                                       \
+      int input_columns,                                                       \
+      type* output,                                                            \
+      int exponent_bits,                                                       \
+      int exponent_bias);                                                      \
+  template FBGEMM_API void FusedFP8RowwiseQuantizedToFloatOrHalf<type>(        \
+      const uint8_t* input,                                                    \
+      size_t input_rows,                                                       \
+      int input_columns,                                                       \
+      type* output,                                                            \
+      int exponent_bits,                                                       \
+      int exponent_bias,                                                       \
+      int thread_id,                                                           \
+      int num_threads);                                                        \
+  template FBGEMM_API void FloatOrHalfToMXQuantized<type>(                     \
+      MXFormat format,                                                         \
+      const type* input,                                                       \
+      size_t input_rows,                                                       \
+      int input_columns,                                                       \
+      std::uint8_t* output,                                                    \
+      int thread_id,                                                           \
+      int num_threads);                                                        \
+  template FBGEMM_API void MXQuantizedToFloatOrHalf<type>(                     \
+      MXFormat format,                                                         \
+      const std::uint8_t* input,                                               \
+      size_t input_rows,                                                       \
+      int output_columns,                                                      \
+      type* output,                                                            \
+      int thread_id,                                                           \
+      int num_threads);                                                        \
+  template FBGEMM_API void                                                     \
+  FloatOrHalfToFusedNBitRowwiseQuantizedSBHalfParallel<type>(                  \
+      int bit_rate,                                                            \
+      const type* input,                                                       \
+      size_t input_rows,                                                       \
+      int input_columns,                                                       \
+      std::uint8_t* output,                                                    \
+      int num_threads,                                                         \
+      const ParallelTasksExecutor& parallel_for,                               \
+      bool greedy_range_search);                                               \
+  template FBGEMM_API void                                                     \
+  FloatOrHalfToFused8BitRowwiseQuantizedSBFloatParallel<type>(                 \
+      const type* input,                                                       \
+      size_t input_rows,                                                       \
+      int input_columns,                                                       \
+      std::uint8_t* output,                                                    \
+      int num_threads,                                                         \
+      const ParallelTasksExecutor& parallel_for);                              \
+  template FBGEMM_API void                                                     \
+  FloatOrHalfToFusedNBitRowwiseQuantizedSBHalfChunked<type>(                   \
+      int bit_rate,                                                            \
+      const type* input,                                                       \
+      size_t input_rows,                                                       \
+      int input_columns,                                                       \
+      const RowwiseQuantizedChunkConsumer& consumer,                           \
+      size_t chunk_rows,                                                       \
+      int num_threads,                                                         \
+      const ParallelTasksExecutor& parallel_for,                               \
+      bool greedy_range_search);                                               \
+  template FBGEMM_API void                                                     \
+  FloatOrHalfToFused8BitRowwiseQuantizedSBFloatChunked<type>(                  \
+      const type* input,                                                       \
+      size_t input_rows,                                                       \
+      int input_columns,                                                       \
+      const RowwiseQuantizedChunkConsumer& consumer,                           \
+      size_t chunk_rows,                                                       \
+      int num_threads,                                                         \
+      const ParallelTasksExecutor& parallel_for);
 
 // clang-format off
 INSTANTIATE_QuantizationFunctions(float)
@@ -18,7 +18,12 @@
 #include <cmath> //for nearbyint
 #include <cstring> //for memcpy
 #include <limits> //for numeric_limits
+#include <type_traits>
+#include <utility>
+#include "./Float8ConvertAvx2.h"
 #include "./MaskAvx2.h"
+#include "fbgemm/FbgemmConvert.h"
+#include "fbgemm/QuantUtils.h"
 #include "fbgemm/Types.h"
 
 namespace fbgemm {
@@ -132,6 +137,143 @@ void QuantizeAvx2(
 #endif
 }
 
+namespace {
+
+// Calls f(0), ..., f(N - 1) with the calls expanded at compile time
+template <typename F, int... Is>
+ALWAYS_INLINE void unrollAvx2(F&& f, std::integer_sequence<int, Is...>) {
+  (f(Is), ...);
+}
+
+} // namespace
+
+template <int LEN, typename T, bool LEGACY>
+void QuantizeFixedLengthAvx2(
+    const float* src,
+    T* dst,
+    const TensorQuantizationParams& qparams) {
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+  static_assert(LEN % 8 == 0, "LEN must be a multiple of 8");
+  constexpr int VLEN = 8;
+  // The largest int32 value less than int32_max exactly representable in float
+  constexpr int32_t int32_float_max_val =
+      std::numeric_limits<int32_t>::max() - 127;
+  const __m256 inverse_scale_v = _mm256_set1_ps(1.f / qparams.scale);
+  const __m256 zero_point_v_legacy = _mm256_set1_ps(qparams.zero_point);
+  const __m256i zero_point_v_non_legacy =
+      _mm256_set1_epi32(qparams.zero_point);
+
+  // Same arithmetic as QuantizeAvx2, up to the rounding to int32
+  const auto quantize_v = [&](int i) {
+    const __m256 src_v = _mm256_loadu_ps(src + i * VLEN);
+    __m256 transformed_v;
+    if constexpr (LEGACY) {
+      transformed_v =
+          _mm256_fmadd_ps(src_v, inverse_scale_v, zero_point_v_legacy);
+    } else {
+      transformed_v = _mm256_mul_ps(src_v, inverse_scale_v);
+    }
+    transformed_v =
+        _mm256_min_ps(transformed_v, _mm256_set1_ps(int32_float_max_val));
+    __m256i rounded_v = _mm256_cvtps_epi32(transformed_v);
+    if constexpr (!LEGACY) {
+      rounded_v = _mm256_add_epi32(rounded_v, zero_point_v_non_legacy);
+    }
+    return rounded_v;
+  };
+
+  // Four vectors are packed per 32 bytes stored; the saturation of the packs
+  // is the clamp to the range of T.
+  const __m256i permute_mask_v = _mm256_set_epi32(7, 3, 6, 2, 5, 1, 4, 0);
+  constexpr int NUM_PACKED = LEN / (4 * VLEN);
+  unrollAvx2(
+      [&](int j) {
+        const __m256i ab_v =
+            _mm256_packs_epi32(quantize_v(4 * j), quantize_v(4 * j + 1));
+        const __m256i cd_v =
+            _mm256_packs_epi32(quantize_v(4 * j + 2), quantize_v(4 * j + 3));
+        __m256i abcd_v;
+        if constexpr (std::is_signed_v<T>) {
+          abcd_v = _mm256_packs_epi16(ab_v, cd_v);
+        } else {
+          abcd_v = _mm256_packus_epi16(ab_v, cd_v);
+        }
+        _mm256_storeu_si256(
+            reinterpret_cast<__m256i*>(dst + j * 4 * VLEN),
+            _mm256_permutevar8x32_epi32(abcd_v, permute_mask_v));
+      },
+      std::make_integer_sequence<int, NUM_PACKED>{});
+  unrollAvx2(
+      [&](int j) {
+        const int i = NUM_PACKED * 4 + j;
+        const __m256i x_v = quantize_v(i);
+        const __m128i x_16 = _mm_packs_epi32(
+            _mm256_castsi256_si128(x_v), _mm256_extracti128_si256(x_v, 1));
+        __m128i x_8;
+        if constexpr (std::is_signed_v<T>) {
+          x_8 = _mm_packs_epi16(x_16, x_16);
+        } else {
+          x_8 = _mm_packus_epi16(x_16, x_16);
+        }
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i * VLEN), x_8);
+      },
+      std::make_integer_sequence<int, LEN / VLEN % 4>{});
+#endif
+}
+
+template <int LEN, typename T>
+void DequantizeFixedLengthAvx2(
+    const T* src,
+    float* dst,
+    const TensorQuantizationParams& qparams) {
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+  static_assert(LEN % 8 == 0, "LEN must be a multiple of 8");
+  constexpr int VLEN = 8;
+  const __m256 scale_v = _mm256_set1_ps(qparams.scale);
+  const __m256i zero_point_v = _mm256_set1_epi32(qparams.zero_point);
+  unrollAvx2(
+      [&](int i) {
+        const __m128i x_8 =
+            _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i * VLEN));
+        __m256i x_v;
+        if constexpr (std::is_signed_v<T>) {
+          x_v = _mm256_cvtepi8_epi32(x_8);
+        } else {
+          x_v = _mm256_cvtepu8_epi32(x_8);
+        }
+        // Same as Dequantize: the integer difference is exact in float
+        _mm256_storeu_ps(
+            dst + i * VLEN,
+            _mm256_mul_ps(
+                scale_v,
+                _mm256_cvtepi32_ps(_mm256_sub_epi32(x_v, zero_point_v))));
+      },
+      std::make_integer_sequence<int, LEN / VLEN>{});
+#endif
+}
+
+#define INSTANTIATE_FIXED_LENGTH_AVX2_BASE(LEN, T)                        \
+  template void QuantizeFixedLengthAvx2<LEN, T, true>(                    \
+      const float* src, T* dst, const TensorQuantizationParams& qparams); \
+  template void QuantizeFixedLengthAvx2<LEN, T, false>(                   \
+      const float* src, T* dst, const TensorQuantizationParams& qparams); \
+  template void DequantizeFixedLengthAvx2<LEN, T>(                        \
+      const T* src, float* dst, const TensorQuantizationParams& qparams);
+
+#define INSTANTIATE_FIXED_LENGTH_AVX2(LEN)         \
+  INSTANTIATE_FIXED_LENGTH_AVX2_BASE(LEN, uint8_t) \
+  INSTANTIATE_FIXED_LENGTH_AVX2_BASE(LEN, int8_t)
+
+INSTANTIATE_FIXED_LENGTH_AVX2(8)
+INSTANTIATE_FIXED_LENGTH_AVX2(16)
+INSTANTIATE_FIXED_LENGTH_AVX2(32)
+INSTANTIATE_FIXED_LENGTH_AVX2(64)
+INSTANTIATE_FIXED_LENGTH_AVX2(128)
+INSTANTIATE_FIXED_LENGTH_AVX2(256)
+
+#undef INSTANTIATE_FIXED_LENGTH_AVX2
+#undef INSTANTIATE_FIXED_LENGTH_AVX2_BASE
+
 uint32_t Xor128(void) {
   /* library-local */ static uint32_t x = 123456789;
   /* library-local */ static uint32_t y = 362436069;
@@ -319,6 +461,129 @@ void FindMinMax(const float* a, float* min, float* max, int64_t len) {
   *max = temp_max;
 }
 
+void QuantizeRowwiseDynamicAvx2(
+    const float* src,
+    uint8_t* dst,
+    int64_t rows,
+    int cols,
+    float* scales,
+    int32_t* zero_points) {
+  for (int64_t r = 0; r < rows; ++r) {
+    const float* src_row = src + r * cols;
+    // Finding the range brings the row into cache for its quantization.
+    float min, max;
+    FindMinMax(src_row, &min, &max, cols);
+    TensorQuantizationParams qparams =
+        ChooseQuantizationParams(min, max, 0, 255);
+    qparams.precision = 8;
+    scales[r] = qparams.scale;
+    zero_points[r] = qparams.zero_point;
+    QuantizeAvx2<uint8_t, false>(src_row, dst + r * cols, cols, qparams);
+  }
+}
+
+template <bool LEGACY>
+void QuantizeWithRowOffsetsAvx2(
+    const float* src,
+    uint8_t* dst,
+    int64_t rows,
+    int cols,
+    const TensorQuantizationParams& qparams,
+    int32_t* row_offsets) {
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+  constexpr int VLEN = 8;
+  // The largest int32 value less than int32_max exactly representable in float
+  constexpr int32_t int32_float_max_val =
+      std::numeric_limits<int32_t>::max() - 127;
+  const __m256 inverse_scale_v = _mm256_set1_ps(1.f / qparams.scale);
+  const __m256 zero_point_v_legacy = _mm256_set1_ps(qparams.zero_point);
+  const __m256i zero_point_v_non_legacy =
+      _mm256_set1_epi32(qparams.zero_point);
+  // clang-format off
+  const __m256i shuffle_mask_v = _mm256_set_epi8(
+      0xff, 0xff, 0xff, 0xff,
+      0xff, 0xff, 0xff, 0xff,
+      0xff, 0xff, 0xff, 0xff,
+      0x0c, 0x08, 0x04, 0x00,
+      0xff, 0xff, 0xff, 0xff,
+      0xff, 0xff, 0xff, 0xff,
+      0xff, 0xff, 0xff, 0xff,
+      0x0c, 0x08, 0x04, 0x00);
+  // clang-format on
+  const __m256i permute_mask_v =
+      _mm256_set_epi32(0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00);
+  const int rem = cols % VLEN;
+  const __m256i rem_mask_v = _mm256_load_si256(
+      reinterpret_cast<const __m256i*>(internal::avx2_ps_or_epi32_masks[rem]));
+
+  // Same arithmetic as QuantizeAvx2<uint8_t, LEGACY>, with the quantized
+  // values summed while they are in registers
+  const auto quantize_v = [&](__m256 src_v) {
+    __m256 transformed_v;
+    if constexpr (LEGACY) {
+      transformed_v =
+          _mm256_fmadd_ps(src_v, inverse_scale_v, zero_point_v_legacy);
+    } else {
+      transformed_v = _mm256_mul_ps(src_v, inverse_scale_v);
+    }
+    transformed_v =
+        _mm256_min_ps(transformed_v, _mm256_set1_ps(int32_float_max_val));
+    __m256i rounded_v = _mm256_cvtps_epi32(transformed_v);
+    if constexpr (!LEGACY) {
+      rounded_v = _mm256_add_epi32(rounded_v, zero_point_v_non_legacy);
+    }
+    return _mm256_min_epi32(
+        _mm256_max_epi32(rounded_v, _mm256_setzero_si256()),
+        _mm256_set1_epi32(255));
+  };
+  const auto to_bytes = [&](__m256i x_v) {
+    return _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(
+        _mm256_shuffle_epi8(x_v, shuffle_mask_v), permute_mask_v));
+  };
+
+  for (int64_t r = 0; r < rows; ++r) {
+    const float* src_row = src + r * cols;
+    uint8_t* dst_row = dst + r * cols;
+    __m256i sum_v = _mm256_setzero_si256();
+    int c = 0;
+    for (; c < cols - rem; c += VLEN) {
+      const __m256i x_v = quantize_v(_mm256_loadu_ps(src_row + c));
+      sum_v = _mm256_add_epi32(sum_v, x_v);
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(dst_row + c), to_bytes(x_v));
+    }
+    if (rem) {
+      // The masked out lanes quantize 0, so they are masked out of the sum
+      const __m256i x_v =
+          quantize_v(_mm256_maskload_ps(src_row + c, rem_mask_v));
+      sum_v = _mm256_add_epi32(sum_v, _mm256_and_si256(x_v, rem_mask_v));
+      const __m128i x_8 = to_bytes(x_v);
+      memcpy(dst_row + c, &x_8, rem);
+    }
+    // Horizontal sum of the 8 lanes
+    __m128i sum_128 = _mm_add_epi32(
+        _mm256_castsi256_si128(sum_v), _mm256_extracti128_si256(sum_v, 1));
+    sum_128 = _mm_add_epi32(sum_128, _mm_srli_si128(sum_128, 8));
+    sum_128 = _mm_add_epi32(sum_128, _mm_srli_si128(sum_128, 4));
+    row_offsets[r] = _mm_cvtsi128_si32(sum_128);
+  }
+#endif
+}
+
+template void QuantizeWithRowOffsetsAvx2<true>(
+    const float* src,
+    uint8_t* dst,
+    int64_t rows,
+    int cols,
+    const TensorQuantizationParams& qparams,
+    int32_t* row_offsets);
+template void QuantizeWithRowOffsetsAvx2<false>(
+    const float* src,
+    uint8_t* dst,
+    int64_t rows,
+    int cols,
+    const TensorQuantizationParams& qparams,
+    int32_t* row_offsets);
+
 ////////////////////////////////////////////////////////////////////////////////
 // Requantization (with floats)
 
@@ -451,6 +716,175 @@ void RequantizeFixedPointAvx2(
     dst[i] = std::min<int64_t>(std::max<int64_t>(quantized_down, 0l), 255l);
   }
 }
+
+namespace {
+
+// Stores 8 int32 values, which are within the range of T, as T
+template <typename T>
+inline void storeRequantizedAvx2(T* dst, __m256i x) {
+  // Exact since the values are within the range of int16
+  const __m128i x_16 = _mm256_castsi256_si128(
+      _mm256_permute4x64_epi64(_mm256_packs_epi32(x, x), 0xd8));
+  if constexpr (is_same<T, int16_t>::value) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), x_16);
+  } else if constexpr (is_same<T, int8_t>::value) {
+    _mm_storel_epi64(
+        reinterpret_cast<__m128i*>(dst), _mm_packs_epi16(x_16, x_16));
+  } else {
+    _mm_storel_epi64(
+        reinterpret_cast<__m128i*>(dst), _mm_packus_epi16(x_16, x_16));
+  }
+}
+
+// (ab + 2^(shift - 1)) >> shift for 64-bit lanes, saturated to +-2^30
+inline __m256i roundingShiftAvx2(__m256i ab, __m256i shift) {
+  const __m256i nudge = _mm256_sllv_epi64(
+      _mm256_set1_epi64x(1), _mm256_sub_epi64(shift, _mm256_set1_epi64x(1)));
+  // AVX2 doesn't support arithmetic right shift of 64-bit integers, so the
+  // value is offset by 2^63, shifted logically and the offset is removed
+  const __m256i offset = _mm256_set1_epi64x(numeric_limits<int64_t>::min());
+  __m256i r = _mm256_sub_epi64(
+      _mm256_srlv_epi64(
+          _mm256_add_epi64(_mm256_add_epi64(ab, nudge), offset), shift),
+      _mm256_srlv_epi64(offset, shift));
+  const __m256i hi = _mm256_set1_epi64x(1 << 30);
+  const __m256i lo = _mm256_set1_epi64x(-(1 << 30));
+  r = _mm256_blendv_epi8(r, hi, _mm256_cmpgt_epi64(r, hi));
+  return _mm256_blendv_epi8(r, lo, _mm256_cmpgt_epi64(lo, r));
+}
+
+} // namespace
+
+template <typename T>
+void RequantizePerChannelAvx2(
+    const int32_t* src,
+    T* dst,
+    int64_t rows,
+    int channels,
+    const float* multipliers,
+    const int32_t* zero_points,
+    int precision) {
+  constexpr int VLEN = 8;
+  constexpr bool is_signed_output = is_signed<T>::value;
+  const __m256i min_v = _mm256_set1_epi32(
+      is_signed_output ? -(1 << (precision - 1)) : 0);
+  const __m256i max_v = _mm256_set1_epi32(
+      is_signed_output ? (1 << (precision - 1)) - 1 : (1 << precision) - 1);
+  // Anything beyond is clamped anyway, and stays within int32 after adding
+  // the zero point
+  const __m256 bound_v = _mm256_set1_ps(1 << 30);
+
+  for (int64_t r = 0; r < rows; ++r) {
+    const int32_t* src_row = src + r * channels;
+    T* dst_row = dst + r * channels;
+    int c = 0;
+    for (; c + VLEN <= channels; c += VLEN) {
+      const __m256i src_v =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_row + c));
+      const __m256 x_v = _mm256_mul_ps(
+          _mm256_cvtepi32_ps(src_v), _mm256_loadu_ps(multipliers + c));
+      __m256i q_v = _mm256_cvtps_epi32(_mm256_min_ps(
+          _mm256_max_ps(x_v, _mm256_sub_ps(_mm256_setzero_ps(), bound_v)),
+          bound_v));
+      q_v = _mm256_add_epi32(
+          q_v,
+          _mm256_loadu_si256(
+              reinterpret_cast<const __m256i*>(zero_points + c)));
+      q_v = _mm256_min_epi32(_mm256_max_epi32(q_v, min_v), max_v);
+      storeRequantizedAvx2(dst_row + c, q_v);
+    }
+    for (; c < channels; ++c) {
+      dst_row[c] = Requantize<T>(
+          src_row[c],
+          zero_points[c],
+          multipliers[c],
+          precision,
+          is_signed_output);
+    }
+  }
+}
+
+template <typename T>
+void RequantizeFixedPointPerChannelAvx2(
+    const int32_t* src,
+    T* dst,
+    int64_t rows,
+    int channels,
+    const int32_t* multipliers,
+    const int* right_shifts,
+    const int32_t* zero_points,
+    int precision) {
+  constexpr int VLEN = 8;
+  constexpr bool is_signed_output = is_signed<T>::value;
+  const __m256i min_v = _mm256_set1_epi32(
+      is_signed_output ? -(1 << (precision - 1)) : 0);
+  const __m256i max_v = _mm256_set1_epi32(
+      is_signed_output ? (1 << (precision - 1)) - 1 : (1 << precision) - 1);
+  const __m256i low_mask_v = _mm256_set1_epi64x(0xffffffff);
+
+  for (int64_t r = 0; r < rows; ++r) {
+    const int32_t* src_row = src + r * channels;
+    T* dst_row = dst + r * channels;
+    int c = 0;
+    for (; c + VLEN <= channels; c += VLEN) {
+      const __m256i a_v =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src_row + c));
+      const __m256i b_v =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i*>(multipliers + c));
+      const __m256i shift_v = _mm256_loadu_si256(
+          reinterpret_cast<const __m256i*>(right_shifts + c));
+
+      // The products of the even and the odd 32-bit lanes in 64-bit lanes
+      const __m256i even_v = roundingShiftAvx2(
+          _mm256_mul_epi32(a_v, b_v), _mm256_and_si256(shift_v, low_mask_v));
+      const __m256i odd_v = roundingShiftAvx2(
+          _mm256_mul_epi32(
+              _mm256_srli_epi64(a_v, 32), _mm256_srli_epi64(b_v, 32)),
+          _mm256_srli_epi64(shift_v, 32));
+      // The saturated results are in the low 32 bits of each 64-bit lane
+      __m256i q_v = _mm256_blend_epi32(
+          even_v, _mm256_slli_epi64(odd_v, 32), 0xaa);
+      q_v = _mm256_add_epi32(
+          q_v,
+          _mm256_loadu_si256(
+              reinterpret_cast<const __m256i*>(zero_points + c)));
+      q_v = _mm256_min_epi32(_mm256_max_epi32(q_v, min_v), max_v);
+      storeRequantizedAvx2(dst_row + c, q_v);
+    }
+    for (; c < channels; ++c) {
+      dst_row[c] = Requantize<T>(
+          src_row[c],
+          zero_points[c],
+          multipliers[c],
+          right_shifts[c],
+          precision,
+          is_signed_output);
+    }
+  }
+}
+
+#define INSTANTIATE_REQUANTIZE_PER_CHANNEL_AVX2(T)     \
+  template void RequantizePerChannelAvx2<T>(           \
+      const int32_t* src,                              \
+      T* dst,                                          \
+      int64_t rows,                                    \
+      int channels,                                    \
+      const float* multipliers,                        \
+      const int32_t* zero_points,                      \
+      int precision);                                  \
+  template void RequantizeFixedPointPerChannelAvx2<T>( \
+      const int32_t* src,                              \
+      T* dst,                                          \
+      int64_t rows,                                    \
+      int channels,                                    \
+      const int32_t* multipliers,                      \
+      const int* right_shifts,                         \
+      const int32_t* zero_points,                      \
+      int precision);
+INSTANTIATE_REQUANTIZE_PER_CHANNEL_AVX2(uint8_t)
+INSTANTIATE_REQUANTIZE_PER_CHANNEL_AVX2(int8_t)
+INSTANTIATE_REQUANTIZE_PER_CHANNEL_AVX2(int16_t)
+#undef INSTANTIATE_REQUANTIZE_PER_CHANNEL_AVX2
 #endif
 
 template <
@@ -1571,7 +2005,8 @@ void FloatOrHalfToFusedNBitRowwiseQuantizedSBHalfAvx2(
     const InputType* input,
     size_t input_rows,
     int input_columns,
-    std::uint8_t* output) {
+    std::uint8_t* output,
+    bool greedy_range_search) {
   static_assert(
       std::is_same<InputType, float>() || std::is_same<InputType, float16>(),
       "Only float and float16 types are allowed.");
@@ -1644,6 +2079,15 @@ void FloatOrHalfToFusedNBitRowwiseQuantizedSBHalfAvx2(
       }
     }
 
+    if (greedy_range_search) {
+      NBitRowwiseRangeSearchGreedy(
+          BIT_RATE,
+          input_row_float,
+          input_columns,
+          minimum_element,
+          maximum_element);
+    }
+
     output_row_scale_bias[1] = floatToHalf(minimum_element);
     minimum_element = halfToFloat(output_row_scale_bias[1]);
     const float range = maximum_element - minimum_element;
@@ -1761,6 +2205,49 @@ void FloatOrHalfToFusedNBitRowwiseQuantizedSBHalfAvx2(
   }
 }
 
+float NBitRowwiseQuantizationSquaredErrorAvx2(
+    int bit_rate,
+    const float* input_row,
+    int input_columns,
+    float bias,
+    float scale,
+    float inverse_scale) {
+  constexpr int VLEN = 8;
+  const int qmax = (1 << bit_rate) - 1;
+  const __m256 bias_v = _mm256_set1_ps(bias);
+  const __m256 scale_v = _mm256_set1_ps(scale);
+  const __m256 inverse_scale_v = _mm256_set1_ps(inverse_scale);
+  const __m256 qmax_v = _mm256_set1_ps(qmax);
+
+  __m256 error_v = _mm256_setzero_ps();
+  int col = 0;
+  for (; col + VLEN <= input_columns; col += VLEN) {
+    const __m256 x_v = _mm256_loadu_ps(input_row + col);
+    __m256 q_v = _mm256_round_ps(
+        _mm256_mul_ps(_mm256_sub_ps(x_v, bias_v), inverse_scale_v),
+        _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    q_v = _mm256_min_ps(_mm256_max_ps(q_v, _mm256_setzero_ps()), qmax_v);
+    const __m256 diff_v =
+        _mm256_sub_ps(x_v, _mm256_fmadd_ps(q_v, scale_v, bias_v));
+    error_v = _mm256_fmadd_ps(diff_v, diff_v, error_v);
+  }
+  alignas(32) float error_buf[VLEN];
+  _mm256_store_ps(error_buf, error_v);
+  float error = 0.0f;
+  for (int i = 0; i < VLEN; ++i) {
+    error += error_buf[i];
+  }
+
+  for (; col < input_columns; ++col) {
+    const float X = input_row[col];
+    const int quantized = std::max(
+        0, std::min<int>(std::lrintf((X - bias) * inverse_scale), qmax));
+    const float diff = X - (scale * quantized + bias);
+    error += diff * diff;
+  }
+  return error;
+}
+
 template <typename InputType>
 void FloatOrHalfToFused8BitRowwiseQuantizedSBFloatAvx2(
     const InputType* input,
@@ -2183,13 +2670,134 @@ void Fused8BitRowwiseQuantizedSBFloatToFloatOrHalfAvx2(
   } // for each row
 }
 
+template <typename InputType>
+void FloatOrHalfToFusedFP8RowwiseQuantizedAvx2(
+    const InputType* input,
+    size_t input_rows,
+    int input_columns,
+    std::uint8_t* output,
+    int exponent_bits,
+    int exponent_bias) {
+  constexpr int VLEN = 8;
+  const internal::Float8ConvertAvx2 fp8(exponent_bits, exponent_bias);
+  const int64_t output_columns = input_columns + sizeof(float);
+
+  auto load = [](const InputType* p) {
+    if constexpr (std::is_same<InputType, float>()) {
+      return _mm256_loadu_ps(p);
+    } else {
+      return _mm256_cvtph_ps(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+    }
+  };
+  auto toFloat = [](InputType x) {
+    if constexpr (std::is_same<InputType, float>()) {
+      return x;
+    } else {
+      return cpu_half2float(x);
+    }
+  };
+
+  for (size_t row = 0; row < input_rows; ++row) {
+    const InputType* input_row = input + row * input_columns;
+    std::uint8_t* output_row = output + row * output_columns;
+    float* output_row_scale =
+        reinterpret_cast<float*>(output_row + input_columns);
+
+    const __m256 abs_mask_v =
+        _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+    __m256 max_v = _mm256_setzero_ps();
+    int col;
+    for (col = 0; col < input_columns / VLEN * VLEN; col += VLEN) {
+      max_v = _mm256_max_ps(
+          _mm256_and_ps(load(input_row + col), abs_mask_v), max_v);
+    }
+    alignas(64) float max_buf[VLEN];
+    _mm256_store_ps(max_buf, max_v);
+    float maximum_element = 0.0f;
+    for (int i = 0; i < VLEN; ++i) {
+      maximum_element = std::max(maximum_element, max_buf[i]);
+    }
+    for (; col < input_columns; ++col) {
+      maximum_element =
+          std::max(maximum_element, std::abs(toFloat(input_row[col])));
+    }
+
+    const float scale =
+        maximum_element > 0.0f ? maximum_element / fp8.maxPos() : 1.0f;
+    output_row_scale[0] = scale;
+    const float inverse_scale = 1.0f / scale;
+    const __m256 inverse_scale_v = _mm256_set1_ps(inverse_scale);
+
+    for (col = 0; col < input_columns / VLEN * VLEN; col += VLEN) {
+      fp8.store(
+          output_row + col,
+          fp8.fromFloat(_mm256_mul_ps(load(input_row + col), inverse_scale_v)));
+    }
+    for (; col < input_columns; ++col) {
+      FloatToFloat8_ref(
+          toFloat(input_row[col]) * inverse_scale,
+          output_row + col,
+          exponent_bits,
+          exponent_bias);
+    }
+  } // for each row
+}
+
+template <typename OutputType>
+void FusedFP8RowwiseQuantizedToFloatOrHalfAvx2(
+    const std::uint8_t* input,
+    size_t input_rows,
+    int input_columns,
+    OutputType* output,
+    int exponent_bits,
+    int exponent_bias) {
+  constexpr int VLEN = 8;
+  const internal::Float8ConvertAvx2 fp8(exponent_bits, exponent_bias);
+  const int64_t output_columns = input_columns - sizeof(float);
+
+  for (size_t row = 0; row < input_rows; ++row) {
+    const std::uint8_t* input_row = input + row * input_columns;
+    const float scale =
+        *reinterpret_cast<const float*>(input_row + output_columns);
+    OutputType* output_row = output + row * output_columns;
+    const __m256 scale_v = _mm256_set1_ps(scale);
+
+    int64_t col;
+    for (col = 0; col < output_columns / VLEN * VLEN; col += VLEN) {
+      __m256 dequantized_v =
+          _mm256_mul_ps(fp8.toFloat(fp8.load(input_row + col)), scale_v);
+      if constexpr (std::is_same<OutputType, float>()) {
+        _mm256_storeu_ps(output_row + col, dequantized_v);
+      } else {
+        _mm_storeu_si128(
+            reinterpret_cast<__m128i*>(output_row + col),
+            _mm256_cvtps_ph(
+                dequantized_v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+      }
+    }
+    for (; col < output_columns; ++col) {
+      float output_value;
+      Float8ToFloat_ref(
+          input_row[col], &output_value, exponent_bits, exponent_bias);
+      output_value *= scale;
+      if constexpr (std::is_same<OutputType, float>()) {
+        output_row[col] = output_value;
+      } else {
+        output_row[col] = cpu_float2half_rn(output_value);
+      }
+    }
+  } // for each row
+}
+
 #define INSTANTIATE_QuantizationAvx2FunctionsNBits(type, bit_rate)  \
   template void                                                     \
   FloatOrHalfToFusedNBitRowwiseQuantizedSBHalfAvx2<type, bit_rate>( \
       const type* input,                                            \
       size_t input_rows,                                            \
       int input_columns,                                            \
-      std::uint8_t* output);                                        \
+      std::uint8_t* output,                                         \
+      bool greedy_range_search);                                    \
   template void                                                     \
   FusedNBitRowwiseQuantizedSBHalfToFloatOrHalfAvx2<type, bit_rate>( \
       const std::uint8_t* input,                                    \
@@ -2217,7 +2825,21 @@ INSTANTIATE_QuantizationAvx2FunctionsNBits(float16, 8)
       const std::uint8_t* input,                                         \
       size_t input_rows,                                                 \
       int input_columns,                                                 \
-      type* output);
+      type* output);                                                     \
+  template void FloatOrHalfToFusedFP8RowwiseQuantizedAvx2<type>(         \
+      const type* input,                                                 \
+      size_t input_rows,                                                 \
+      int input_columns,                                                 \
+      std::uint8_t* output,                                              \
+      int exponent_bits,                                                 \
+      int exponent_bias);                                                \
+  template void FusedFP8RowwiseQuantizedToFloatOrHalfAvx2<type>(         \
+      const std::uint8_t* input,                                         \
+      size_t input_rows,                                                 \
+      int input_columns,                                                 \
+      type* output,                                                      \
+      int exponent_bits,                                                 \
+      int exponent_bias);
 
     // clang-format off
 INSTANTIATE_QuantizationAvx2Functions8Bits(float)
@@ -16,6 +16,8 @@
 #include <cassert>
 #include <cmath> //for nearbyint
 #include <limits> //for numeric_limits
+#include <type_traits>
+#include "fbgemm/QuantUtils.h"
 
 namespace fbgemm {
 
@@ -475,4 +477,293 @@ INSTANTIATE_BIAS(false)
 #undef INSTANTIATE_B_SYM
 #undef INSTANTIATE_Q_GRANS
 #undef INSTANTIATE_BIAS
+
+void QuantizeRowwiseDynamicAvx512(
+    const float* src,
+    uint8_t* dst,
+    int64_t rows,
+    int cols,
+    float* scales,
+    int32_t* zero_points) {
+  constexpr int VLEN = 16;
+  const int rem = cols % VLEN;
+  const __mmask16 rem_mask = (1u << rem) - 1;
+  for (int64_t r = 0; r < rows; ++r) {
+    const float* src_row = src + r * cols;
+    uint8_t* dst_row = dst + r * cols;
+
+    float min = 0.0f, max = 0.0f;
+    if (cols > 0) {
+      __m512 min_v = _mm512_set1_ps(src_row[0]);
+      __m512 max_v = min_v;
+      int c = 0;
+      for (; c < cols - rem; c += VLEN) {
+        const __m512 x_v = _mm512_loadu_ps(src_row + c);
+        min_v = _mm512_min_ps(min_v, x_v);
+        max_v = _mm512_max_ps(max_v, x_v);
+      }
+      if (rem) {
+        const __m512 x_v = _mm512_maskz_loadu_ps(rem_mask, src_row + c);
+        min_v = _mm512_mask_min_ps(min_v, rem_mask, min_v, x_v);
+        max_v = _mm512_mask_max_ps(max_v, rem_mask, max_v, x_v);
+      }
+      min = _mm512_reduce_min_ps(min_v);
+      max = _mm512_reduce_max_ps(max_v);
+    }
+
+    TensorQuantizationParams qparams =
+        ChooseQuantizationParams(min, max, 0, 255);
+    qparams.precision = 8;
+    scales[r] = qparams.scale;
+    zero_points[r] = qparams.zero_point;
+
+    // Same arithmetic as QuantizeAvx2<uint8_t, false>: round src / scale,
+    // then add the zero point and clamp. The row is still in cache.
+    const __m512 inverse_scale_v = _mm512_set1_ps(1.f / qparams.scale);
+    // The largest int32 value below int32_max that is exact in float, so
+    // the conversion does not overflow to negative values.
+    const __m512 int32_float_max_v =
+        _mm512_set1_ps(numeric_limits<int32_t>::max() - 127);
+    const __m512i zero_point_v = _mm512_set1_epi32(qparams.zero_point);
+    const __m512i min_val_v = _mm512_setzero_si512();
+    const __m512i max_val_v = _mm512_set1_epi32(255);
+    auto quantize = [&](__mmask16 mask, int c) {
+      const __m512 transformed_v = _mm512_min_ps(
+          _mm512_mul_ps(
+              _mm512_maskz_loadu_ps(mask, src_row + c), inverse_scale_v),
+          int32_float_max_v);
+      const __m512i rounded_v =
+          _mm512_add_epi32(_mm512_cvtps_epi32(transformed_v), zero_point_v);
+      const __m512i clipped_v =
+          _mm512_min_epi32(_mm512_max_epi32(rounded_v, min_val_v), max_val_v);
+      _mm512_mask_cvtepi32_storeu_epi8(dst_row + c, mask, clipped_v);
+    };
+    int c = 0;
+    for (; c < cols - rem; c += VLEN) {
+      quantize(0xffff, c);
+    }
+    if (rem) {
+      quantize(rem_mask, c);
+    }
+  }
+}
+
+template <bool LEGACY>
+void QuantizeWithRowOffsetsAvx512(
+    const float* src,
+    uint8_t* dst,
+    int64_t rows,
+    int cols,
+    const TensorQuantizationParams& qparams,
+    int32_t* row_offsets) {
+  constexpr int VLEN = 16;
+  const int rem = cols % VLEN;
+  const __mmask16 rem_mask = (1u << rem) - 1;
+  const __m512 inverse_scale_v = _mm512_set1_ps(1.f / qparams.scale);
+  const __m512 int32_float_max_v =
+      _mm512_set1_ps(numeric_limits<int32_t>::max() - 127);
+  const __m512 zero_point_v_legacy = _mm512_set1_ps(qparams.zero_point);
+  const __m512i zero_point_v_non_legacy = _mm512_set1_epi32(qparams.zero_point);
+  const __m512i min_val_v = _mm512_setzero_si512();
+  const __m512i max_val_v = _mm512_set1_epi32(255);
+  for (int64_t r = 0; r < rows; ++r) {
+    const float* src_row = src + r * cols;
+    uint8_t* dst_row = dst + r * cols;
+    __m512i sum_v = _mm512_setzero_si512();
+    // Same arithmetic as QuantizeAvx2<uint8_t, LEGACY>. The masked out lanes
+    // are left out of the sum, as they would quantize to the zero point.
+    auto quantize = [&](__mmask16 mask, int c) {
+      const __m512 src_v = _mm512_maskz_loadu_ps(mask, src_row + c);
+      __m512 transformed_v;
+      if constexpr (LEGACY) {
+        transformed_v =
+            _mm512_fmadd_ps(src_v, inverse_scale_v, zero_point_v_legacy);
+      } else {
+        transformed_v = _mm512_mul_ps(src_v, inverse_scale_v);
+      }
+      __m512i rounded_v =
+          _mm512_cvtps_epi32(_mm512_min_ps(transformed_v, int32_float_max_v));
+      if constexpr (!LEGACY) {
+        rounded_v = _mm512_add_epi32(rounded_v, zero_point_v_non_legacy);
+      }
+      const __m512i clipped_v =
+          _mm512_min_epi32(_mm512_max_epi32(rounded_v, min_val_v), max_val_v);
+      sum_v = _mm512_mask_add_epi32(sum_v, mask, sum_v, clipped_v);
+      _mm512_mask_cvtepi32_storeu_epi8(dst_row + c, mask, clipped_v);
+    };
+    int c = 0;
+    for (; c < cols - rem; c += VLEN) {
+      quantize(0xffff, c);
+    }
+    if (rem) {
+      quantize(rem_mask, c);
+    }
+    row_offsets[r] = _mm512_reduce_add_epi32(sum_v);
+  }
+}
+
+template void QuantizeWithRowOffsetsAvx512<true>(
+    const float* src,
+    uint8_t* dst,
+    int64_t rows,
+    int cols,
+    const TensorQuantizationParams& qparams,
+    int32_t* row_offsets);
+template void QuantizeWithRowOffsetsAvx512<false>(
+    const float* src,
+    uint8_t* dst,
+    int64_t rows,
+    int cols,
+    const TensorQuantizationParams& qparams,
+    int32_t* row_offsets);
+
+
+namespace {
+
+template <typename T>
+inline void storeRequantizedAvx512(T* dst, __mmask16 mask, __m512i x) {
+  if constexpr (is_same<T, int16_t>::value) {
+    _mm512_mask_cvtepi32_storeu_epi16(dst, mask, x);
+  } else {
+    _mm512_mask_cvtepi32_storeu_epi8(dst, mask, x);
+  }
+}
+
+} // namespace
+
+template <typename T>
+void RequantizePerChannelAvx512(
+    const int32_t* src,
+    T* dst,
+    int64_t rows,
+    int channels,
+    const float* multipliers,
+    const int32_t* zero_points,
+    int precision) {
+  constexpr int VLEN = 16;
+  constexpr bool is_signed_output = is_signed<T>::value;
+  const int rem = channels % VLEN;
+  const __mmask16 rem_mask = (1u << rem) - 1;
+  const __m512i min_v = _mm512_set1_epi32(
+      is_signed_output ? -(1 << (precision - 1)) : 0);
+  const __m512i max_v = _mm512_set1_epi32(
+      is_signed_output ? (1 << (precision - 1)) - 1 : (1 << precision) - 1);
+  // Anything beyond is clamped anyway, and stays within int32 after adding
+  // the zero point
+  const __m512 bound_v = _mm512_set1_ps(1 << 30);
+  const __m512 neg_bound_v = _mm512_set1_ps(-(1 << 30));
+
+  for (int64_t r = 0; r < rows; ++r) {
+    const int32_t* src_row = src + r * channels;
+    T* dst_row = dst + r * channels;
+    auto requantize = [&](__mmask16 mask, int c) {
+      const __m512 x_v = _mm512_mul_ps(
+          _mm512_cvtepi32_ps(_mm512_maskz_loadu_epi32(mask, src_row + c)),
+          _mm512_maskz_loadu_ps(mask, multipliers + c));
+      __m512i q_v = _mm512_cvtps_epi32(
+          _mm512_min_ps(_mm512_max_ps(x_v, neg_bound_v), bound_v));
+      q_v = _mm512_add_epi32(
+          q_v, _mm512_maskz_loadu_epi32(mask, zero_points + c));
+      q_v = _mm512_min_epi32(_mm512_max_epi32(q_v, min_v), max_v);
+      storeRequantizedAvx512(dst_row + c, mask, q_v);
+    };
+    int c = 0;
+    for (; c < channels - rem; c += VLEN) {
+      requantize(0xffff, c);
+    }
+    if (rem) {
+      requantize(rem_mask, c);
+    }
+  }
+}
+
+template <typename T>
+void RequantizeFixedPointPerChannelAvx512(
+    const int32_t* src,
+    T* dst,
+    int64_t rows,
+    int channels,
+    const int32_t* multipliers,
+    const int* right_shifts,
+    const int32_t* zero_points,
+    int precision) {
+  constexpr int VLEN = 16;
+  constexpr bool is_signed_output = is_signed<T>::value;
+  const int rem = channels % VLEN;
+  const __mmask16 rem_mask = (1u << rem) - 1;
+  const __m512i min_v = _mm512_set1_epi32(
+      is_signed_output ? -(1 << (precision - 1)) : 0);
+  const __m512i max_v = _mm512_set1_epi32(
+      is_signed_output ? (1 << (precision - 1)) - 1 : (1 << precision) - 1);
+  const __m512i low_mask_v = _mm512_set1_epi64(0xffffffff);
+  const __m512i one_v = _mm512_set1_epi64(1);
+  const __m512i hi_v = _mm512_set1_epi64(1 << 30);
+  const __m512i lo_v = _mm512_set1_epi64(-(1 << 30));
+
+  // (ab + 2^(shift - 1)) >> shift for 64-bit lanes, saturated to +-2^30
+  auto rounding_shift = [&](__m512i ab, __m512i shift) {
+    const __m512i nudge =
+        _mm512_sllv_epi64(one_v, _mm512_sub_epi64(shift, one_v));
+    const __m512i r = _mm512_srav_epi64(_mm512_add_epi64(ab, nudge), shift);
+    return _mm512_min_epi64(_mm512_max_epi64(r, lo_v), hi_v);
+  };
+
+  for (int64_t r = 0; r < rows; ++r) {
+    const int32_t* src_row = src + r * channels;
+    T* dst_row = dst + r * channels;
+    auto requantize = [&](__mmask16 mask, int c) {
+      const __m512i a_v = _mm512_maskz_loadu_epi32(mask, src_row + c);
+      const __m512i b_v = _mm512_maskz_loadu_epi32(mask, multipliers + c);
+      // Masked out lanes get a shift of 1 to keep the nudge defined
+      const __m512i shift_v = _mm512_mask_loadu_epi32(
+          _mm512_set1_epi32(1), mask, right_shifts + c);
+
+      // The products of the even and the odd 32-bit lanes in 64-bit lanes
+      const __m512i even_v = rounding_shift(
+          _mm512_mul_epi32(a_v, b_v), _mm512_and_si512(shift_v, low_mask_v));
+      const __m512i odd_v = rounding_shift(
+          _mm512_mul_epi32(
+              _mm512_srli_epi64(a_v, 32), _mm512_srli_epi64(b_v, 32)),
+          _mm512_srli_epi64(shift_v, 32));
+      // The saturated results are in the low 32 bits of each 64-bit lane
+      __m512i q_v = _mm512_mask_blend_epi32(
+          0xaaaa, even_v, _mm512_slli_epi64(odd_v, 32));
+      q_v = _mm512_add_epi32(
+          q_v, _mm512_maskz_loadu_epi32(mask, zero_points + c));
+      q_v = _mm512_min_epi32(_mm512_max_epi32(q_v, min_v), max_v);
+      storeRequantizedAvx512(dst_row + c, mask, q_v);
+    };
+    int c = 0;
+    for (; c < channels - rem; c += VLEN) {
+      requantize(0xffff, c);
+    }
+    if (rem) {
+      requantize(rem_mask, c);
+    }
+  }
+}
+
+#define INSTANTIATE_REQUANTIZE_PER_CHANNEL_AVX512(T)     \
+  template void RequantizePerChannelAvx512<T>(           \
+      const int32_t* src,                                \
+      T* dst,                                            \
+      int64_t rows,                                      \
+      int channels,                                      \
+      const float* multipliers,                          \
+      const int32_t* zero_points,                        \
+      int precision);                                    \
+  template void RequantizeFixedPointPerChannelAvx512<T>( \
+      const int32_t* src,                                \
+      T* dst,                                            \
+      int64_t rows,                                      \
+      int channels,                                      \
+      const int32_t* multipliers,                        \
+      const int* right_shifts,                           \
+      const int32_t* zero_points,                        \
+      int precision);
+INSTANTIATE_REQUANTIZE_PER_CHANNEL_AVX512(uint8_t)
+INSTANTIATE_REQUANTIZE_PER_CHANNEL_AVX512(int8_t)
+INSTANTIATE_REQUANTIZE_PER_CHANNEL_AVX512(int16_t)
+#undef INSTANTIATE_REQUANTIZE_PER_CHANNEL_AVX512
+
 } // namespace fbgemm
@@ -100,6 +100,25 @@ void FloatToFloat16_ref(
   }
 }
 
+// Random bits to add to the num_bits low bits of the mantissa of x before
+// truncating them, none for infinities and NaNs
+inline uint32_t stochasticRoundingBits(uint32_t x, int idx, int num_bits) {
+  const uint32_t r = rnd128_next(idx, 8) >> (32 - num_bits);
+  return (x & 0x7f800000U) == 0x7f800000U ? 0 : r;
+}
+
+void FloatToFloat16StochasticRounding_ref(
+    const float* src,
+    float16* dst,
+    size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    fint32 x;
+    x.F = src[i];
+    x.I += stochasticRoundingBits(x.I, i % 8, 13);
+    dst[i] = cpu_float2half_rz(x.F);
+  }
+}
+
 void Float16ToFloat_ref(const float16* src, float* dst, size_t size) {
   for (size_t i = 0; i < size; i++) {
     dst[i] = cpu_half2float(src[i]);
@@ -113,6 +132,17 @@ void FloatToBfloat16_ref(const float* src, bfloat16* dst, size_t size) {
   }
 }
 
+void FloatToBfloat16StochasticRounding_ref(
+    const float* src,
+    bfloat16* dst,
+    size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    fint32 x;
+    x.F = src[i];
+    dst[i] = (x.I + stochasticRoundingBits(x.I, i % 8, 16)) >> 16;
+  }
+}
+
 void Bfloat16ToFloat_ref(const bfloat16* src, float* dst, size_t size) {
   for (size_t i = 0; i < size; i++) {
     uint32_t val_fp32 =
@@ -1501,6 +1531,91 @@ bool EmbeddingSpMDMNBit_ref(
   return current == index_size;
 }
 
+template <typename IndexType, typename OffsetType, typename OutType>
+bool EmbeddingSpMDMNBitGroupwise_ref(
+    int bit_rate,
+    int group_size,
+    const int64_t block_size,
+    const int64_t output_size,
+    const int64_t index_size,
+    const int64_t data_size,
+    const uint8_t* input,
+    const IndexType* indices,
+    const OffsetType* offsets_or_lengths,
+    const float* weights, // optional, can be null for non-weighted sum
+    bool normalize_by_lengths,
+    OutType* out,
+    bool is_weight_positional /*=false*/,
+    bool use_offsets /*=true*/,
+    int64_t output_stride /*=-1*/,
+    int64_t input_stride /*=-1*/,
+    bool is_bf16_out /*=false*/) {
+  assert((bit_rate == 2 || bit_rate == 4) && "bit_rate must be 2 or 4");
+  int num_elem_per_byte = 8 / bit_rate;
+  assert(
+      group_size > 0 && block_size % group_size == 0 &&
+      group_size % num_elem_per_byte == 0 && "unsupported group_size");
+
+  if (output_stride == -1) {
+    output_stride = block_size;
+  }
+
+  // The packed row is followed by the fp16 scale and bias of each group
+  const int64_t num_groups = block_size / group_size;
+  const int64_t data_bytes = block_size / num_elem_per_byte;
+  if (input_stride == -1) {
+    input_stride = data_bytes + num_groups * 2 * sizeof(float16);
+  }
+  int64_t current = 0;
+  vector<float> buf(block_size);
+  for (int m = 0; m < output_size; ++m) {
+    memset(buf.data(), 0, sizeof(float) * block_size);
+    int len = use_offsets ? offsets_or_lengths[m + 1] - offsets_or_lengths[m]
+                          : offsets_or_lengths[m];
+    if (current + len > index_size) {
+      return false;
+    }
+    for (int i = 0; i < len; ++i, ++current) {
+      int64_t idx = indices[current];
+      if (idx < 0 || idx >= data_size) {
+        return false;
+      }
+
+      const uint8_t* input_row = input + input_stride * idx;
+      const float16* scale_bias =
+          reinterpret_cast<const float16*>(input_row + data_bytes);
+
+      float weight = 1.0f;
+      if (weights) {
+        weight = weights[is_weight_positional ? i : current];
+      }
+
+      for (int64_t g = 0; g < num_groups; ++g) {
+        const float scale = weight * cpu_half2float(scale_bias[2 * g]);
+        const float bias = weight * cpu_half2float(scale_bias[2 * g + 1]);
+        for (int64_t j = g * group_size; j < (g + 1) * group_size; ++j) {
+          uint8_t quantized = input_row[j / num_elem_per_byte];
+          quantized >>= (j % num_elem_per_byte) * bit_rate;
+          quantized &= (1 << bit_rate) - 1;
+
+          buf[j] = std::fma(scale, quantized, buf[j] + bias);
+        }
+      }
+    }
+    if (normalize_by_lengths && len) {
+      float scale = 1.f / len;
+      for (int j = 0; j < block_size; ++j) {
+        buf[j] *= scale;
+      }
+    }
+    for (int j = 0; j < block_size; ++j) {
+      out[j] = convert_from_float_ref<OutType>(buf[j], is_bf16_out);
+    }
+    out += output_stride;
+  }
+  return current == index_size;
+}
+
 template <typename IndexType, typename OffsetType, typename OutType>
 bool EmbeddingSpMDMFP8_ref(
     const int64_t block_size,
@@ -1891,6 +2006,96 @@ int rowwise_sparse_adagrad_ref(
   return num_rows;
 }
 
+template <typename IndexType>
+int sparse_adagrad_16bit_ref(
+    int num_rows, // number of rows reading
+    int block_size, // number of parameters per rows
+    uint64_t param_size, // total number of parameters
+    uint16_t* w, // input parameters
+    const float* g, // input gradients
+    float* h, // input momentums
+    const IndexType* indices, // indices of each row
+    float epsilon,
+    float lr,
+    bool rowwise,
+    bool use_stochastic_rounding,
+    bool is_bf16,
+    float weight_decay,
+    const double* counter,
+    const int64_t counter_halflife) {
+  auto load = [is_bf16](uint16_t x) {
+    if (is_bf16) {
+      fint32 y;
+      y.I = static_cast<uint32_t>(x) << 16;
+      return y.F;
+    }
+    return cpu_half2float(x);
+  };
+  auto store = [=](float x, int j) -> uint16_t {
+    fint32 y;
+    y.F = x;
+    if (is_bf16) {
+      if (use_stochastic_rounding) {
+        return (y.I + stochasticRoundingBits(y.I, j % 8, 16)) >> 16;
+      }
+      // Add 2^15 and right shift 16 to do round-nearest
+      return (y.I + (1 << 15)) >> 16;
+    }
+    if (use_stochastic_rounding) {
+      y.I += stochasticRoundingBits(y.I, j % 8, 13);
+      return cpu_float2half_rz(y.F);
+    }
+    return cpu_float2half_rn(y.F);
+  };
+
+  for (auto i = 0; i < num_rows; ++i) {
+    uint64_t idx = indices[i];
+    auto offsetI = i * block_size;
+    auto offsetIdx = idx * block_size;
+
+    if (block_size + offsetIdx > param_size) {
+      return i;
+    }
+
+    float freq =
+        (counter && counter[idx] > 0) ? counter_halflife / counter[idx] : 1.0;
+
+    const float* g_ = g + offsetI;
+    uint16_t* w_ = w + offsetIdx;
+    if (rowwise) {
+      // Same order of the sums as rowwise_sparse_adagrad_ref
+      constexpr int VLEN = 8;
+      array<float, VLEN> partial_sum = {0.0f};
+      for (auto j = 0; j < block_size; ++j) {
+        float gj = std::fma(weight_decay * freq, load(w_[j]), g_[j]);
+        partial_sum[j % VLEN] += gj * gj;
+      }
+      float final_sum = ((partial_sum[0] + partial_sum[1]) +
+                         (partial_sum[2] + partial_sum[3])) +
+          ((partial_sum[4] + partial_sum[5]) +
+           (partial_sum[6] + partial_sum[7]));
+      final_sum /= block_size;
+      float hi = h[idx] = h[idx] + final_sum;
+      float float_step = lr / (std::sqrt(hi) + epsilon);
+
+      for (auto j = 0; j < block_size; ++j) {
+        float wj = load(w_[j]);
+        float gj = std::fma(weight_decay * freq, wj, g_[j]);
+        w_[j] = store(wj + gj * float_step, j);
+      }
+    } else {
+      float* h_ = h + offsetIdx;
+      for (auto j = 0; j < block_size; ++j) {
+        float wj = load(w_[j]);
+        float gj = std::fma(weight_decay * freq, wj, g_[j]);
+        float hj = h_[j] = h_[j] + gj * gj;
+        w_[j] = store(wj + lr * gj / (std::sqrt(hj) + epsilon), j);
+      }
+    }
+  }
+  return num_rows;
+}
+
 template <typename DataType, typename IndexType, typename OffsetType>
 int rowwise_sparse_adagrad_fused_ref(
     int64_t block_size,
@@ -2033,6 +2238,244 @@ int rowwise_sparse_adagrad_fused_ref(
   return current == index_size;
 }
 
+template <typename DataType, typename IndexType, typename OffsetType>
+bool sparse_adagrad_fused_ref(
+    int64_t block_size,
+    int64_t output_size,
+    int64_t index_size,
+    int64_t data_size,
+    DataType* w,
+    const float* g,
+    float* h,
+    const IndexType* indices,
+    const OffsetType* offsets_or_lengths,
+    float epsilon,
+    float lr,
+    bool use_offsets,
+    int64_t grad_stride) {
+  if (grad_stride == -1) {
+    grad_stride = block_size;
+  }
+
+  int64_t current = 0;
+  for (int m = 0; m < output_size; ++m) {
+    int len = use_offsets ? offsets_or_lengths[m + 1] - offsets_or_lengths[m]
+                          : offsets_or_lengths[m];
+    if (current + len > index_size) {
+      return false;
+    }
+    const float* g_ = g + m * grad_stride;
+    for (int i = 0; i < len; ++i, ++current) {
+      int64_t idx = indices[current];
+      if (idx < 0 || idx >= data_size) {
+        return false;
+      }
+
+      float* h_ = h + idx * block_size;
+      DataType* w_ = w + idx * block_size;
+      for (int64_t j = 0; j < block_size; ++j) {
+        float gj = g_[j];
+        float hj = h_[j] + gj * gj;
+        h_[j] = hj;
+        float step = lr * gj / (std::sqrt(hj) + epsilon);
+        if constexpr (std::is_same_v<DataType, float16>) {
+          w_[j] = cpu_float2half_rn(cpu_half2float(w_[j]) + step);
+        } else {
+          w_[j] += step;
+        }
+      }
+    }
+  }
+
+  return current == index_size;
+}
+
+namespace {
+
+template <typename DataType>
+float loadWeight(const DataType& w) {
+  if constexpr (std::is_same_v<DataType, float16>) {
+    return cpu_half2float(w);
+  } else {
+    return w;
+  }
+}
+
+template <typename DataType>
+void storeWeight(DataType& w, float value) {
+  if constexpr (std::is_same_v<DataType, float16>) {
+    w = cpu_float2half_rn(value);
+  } else {
+    w = value;
+  }
+}
+
+} // namespace
+
+template <typename DataType, typename IndexType, typename OffsetType>
+bool sparse_adam_fused_ref(
+    bool lamb,
+    bool rowwise,
+    int64_t block_size,
+    int64_t output_size,
+    int64_t index_size,
+    int64_t data_size,
+    DataType* w,
+    const float* g,
+    float* momentum1,
+    float* momentum2,
+    const IndexType* indices,
+    const OffsetType* offsets_or_lengths,
+    float learning_rate,
+    float eps,
+    float beta1,
+    float beta2,
+    float weight_decay,
+    int64_t iter,
+    bool use_offsets,
+    int64_t grad_stride) {
+  if (grad_stride == -1) {
+    grad_stride = block_size;
+  }
+  const float bias_correction1 = 1.0f - std::pow(beta1, iter);
+  const float bias_correction2 = 1.0f - std::pow(beta2, iter);
+  vector<float> r(lamb ? block_size : 0);
+
+  int64_t current = 0;
+  for (int m = 0; m < output_size; ++m) {
+    int len = use_offsets ? offsets_or_lengths[m + 1] - offsets_or_lengths[m]
+                          : offsets_or_lengths[m];
+    if (current + len > index_size) {
+      return false;
+    }
+    const float* g_ = g + m * grad_stride;
+    float g_avg_square = 0.0f;
+    if (rowwise) {
+      for (int64_t j = 0; j < block_size; ++j) {
+        g_avg_square += g_[j] * g_[j];
+      }
+      g_avg_square /= block_size;
+    }
+
+    for (int i = 0; i < len; ++i, ++current) {
+      int64_t idx = indices[current];
+      if (idx < 0 || idx >= data_size) {
+        return false;
+      }
+
+      DataType* w_ = w + idx * block_size;
+      float* m1_ = momentum1 + idx * block_size;
+      float* m2_ = momentum2 + (rowwise ? idx : idx * block_size);
+      float row_denom = 0.0f;
+      if (rowwise) {
+        float v = beta2 * m2_[0] + (1.0f - beta2) * g_avg_square;
+        m2_[0] = v;
+        row_denom = std::sqrt(v / bias_correction2) + eps;
+      }
+
+      float weight_sum_sq = 0.0f;
+      float r_sum_sq = 0.0f;
+      for (int64_t j = 0; j < block_size; ++j) {
+        float gj = g_[j];
+        float m1 = beta1 * m1_[j] + (1.0f - beta1) * gj;
+        m1_[j] = m1;
+        float denom = row_denom;
+        if (!rowwise) {
+          float v = beta2 * m2_[j] + (1.0f - beta2) * (gj * gj);
+          m2_[j] = v;
+          denom = std::sqrt(v / bias_correction2) + eps;
+        }
+        float wj = loadWeight(w_[j]);
+        float rj = m1 / bias_correction1 / denom + weight_decay * wj;
+        if (lamb) {
+          r[j] = rj;
+          weight_sum_sq += wj * wj;
+          r_sum_sq += rj * rj;
+        } else {
+          storeWeight(w_[j], wj - learning_rate * rj);
+        }
+      }
+      if (lamb) {
+        float trust_ratio = weight_sum_sq > 0.0f && r_sum_sq > 0.0f
+            ? std::sqrt(weight_sum_sq) / std::sqrt(r_sum_sq)
+            : 1.0f;
+        float step = learning_rate * trust_ratio;
+        for (int64_t j = 0; j < block_size; ++j) {
+          storeWeight(w_[j], loadWeight(w_[j]) - step * r[j]);
+        }
+      }
+    }
+  }
+
+  return current == index_size;
+}
+
+template <typename DataType, typename IndexType, typename OffsetType>
+bool sparse_lars_sgd_fused_ref(
+    int64_t block_size,
+    int64_t output_size,
+    int64_t index_size,
+    int64_t data_size,
+    DataType* w,
+    const float* g,
+    float* momentum1,
+    const IndexType* indices,
+    const OffsetType* offsets_or_lengths,
+    float learning_rate,
+    float eta,
+    float momentum,
+    float weight_decay,
+    bool use_offsets,
+    int64_t grad_stride) {
+  if (grad_stride == -1) {
+    grad_stride = block_size;
+  }
+
+  int64_t current = 0;
+  for (int m = 0; m < output_size; ++m) {
+    int len = use_offsets ? offsets_or_lengths[m + 1] - offsets_or_lengths[m]
+                          : offsets_or_lengths[m];
+    if (current + len > index_size) {
+      return false;
+    }
+    const float* g_ = g + m * grad_stride;
+    float grad_sum_sq = 0.0f;
+    for (int64_t j = 0; j < block_size; ++j) {
+      grad_sum_sq += g_[j] * g_[j];
+    }
+    const float grad_norm = std::sqrt(grad_sum_sq);
+
+    for (int i = 0; i < len; ++i, ++current) {
+      int64_t idx = indices[current];
+      if (idx < 0 || idx >= data_size) {
+        return false;
+      }
+
+      DataType* w_ = w + idx * block_size;
+      float* m1_ = momentum1 + idx * block_size;
+      float weight_sum_sq = 0.0f;
+      for (int64_t j = 0; j < block_size; ++j) {
+        float wj = loadWeight(w_[j]);
+        weight_sum_sq += wj * wj;
+      }
+      const float weight_norm = std::sqrt(weight_sum_sq);
+      const float adjusted_lr = weight_norm > 0.0f && grad_norm > 0.0f
+          ? learning_rate * eta * weight_norm /
+              (grad_norm + weight_decay * weight_norm)
+          : learning_rate;
+      for (int64_t j = 0; j < block_size; ++j) {
+        float wj = loadWeight(w_[j]);
+        float m1 =
+            momentum * m1_[j] + adjusted_lr * (g_[j] + weight_decay * wj);
+        m1_[j] = m1;
+        storeWeight(w_[j], wj - m1);
+      }
+    }
+  }
+
+  return current == index_size;
+}
+
 template FBGEMM_API void transposeConvWeights(
     const conv_param_t<1>& conv_p,
     const std::int8_t* src,
@@ -2124,6 +2567,24 @@ INSTANTIATE_SPMDM_INDEX_T(std::uint8_t)
       int64_t input_stride,                                       \
       bool scale_bias_last,                                       \
       bool is_bf16_out);                                          \
+  template FBGEMM_API bool EmbeddingSpMDMNBitGroupwise_ref(       \
+      int bit_rate,                                               \
+      int group_size,                                             \
+      const int64_t block_size,                                   \
+      const int64_t output_size,                                  \
+      const int64_t index_size,                                   \
+      const int64_t data_size,                                    \
+      const uint8_t* input,                                       \
+      const INDEX_TYPE* indices,                                  \
+      const OFFSET_TYPE* offsets_or_lengths,                      \
+      const float* weights,                                       \
+      bool normalize_by_lengths,                                  \
+      OUT_TYPE* out,                                              \
+      bool is_weight_positional,                                  \
+      bool use_offsets,                                           \
+      int64_t output_stride,                                      \
+      int64_t input_stride,                                       \
+      bool is_bf16_out);                                          \
   template FBGEMM_API bool EmbeddingSpMDMFP8_ref(                 \
       const int64_t block_size,                                   \
       const int64_t output_size,                                  \
@@ -2229,6 +2690,40 @@ template FBGEMM_API int rowwise_sparse_adagrad_ref(
     const double* counter,
     const int64_t counter_halflife);
 
+template FBGEMM_API int sparse_adagrad_16bit_ref(
+    int num_rows, // number of rows reading
+    int block_size, // number of parameters per rows
+    std::uint64_t param_size, // total number of parameters
+    std::uint16_t* w, // input parameters
+    const float* g, // input gradients
+    float* h, // input momentums
+    const std::int64_t* indices, // indices of each row
+    float epsilon,
+    float lr,
+    bool rowwise,
+    bool use_stochastic_rounding,
+    bool is_bf16,
+    float weight_decay,
+    const double* counter,
+    const int64_t counter_halflife);
+
+template FBGEMM_API int sparse_adagrad_16bit_ref(
+    int num_rows, // number of rows reading
+    int block_size, // number of parameters per rows
+    std::uint64_t param_size, // total number of parameters
+    std::uint16_t* w, // input parameters
+    const float* g, // input gradients
+    float* h, // input momentums
+    const std::int32_t* indices, // indices of each row
+    float epsilon,
+    float lr,
+    bool rowwise,
+    bool use_stochastic_rounding,
+    bool is_bf16,
+    float weight_decay,
+    const double* counter,
+    const int64_t counter_halflife);
+
 #define INSTANTIATE_SPMDM_BASE(DATA_TYPE, INDEX_TYPE, OFFSET_TYPE) \
   template FBGEMM_API int rowwise_sparse_adagrad_fused_ref(        \
       int64_t block_size,                                          \
@@ -2245,6 +2740,57 @@ template FBGEMM_API int rowwise_sparse_adagrad_ref(
       bool use_offsets,                                            \
       bool use_stochastic_rounding,                                \
       int emu_vector_size,                                         \
+      int64_t grad_stride);                                        \
+  template FBGEMM_API bool sparse_adagrad_fused_ref(               \
+      int64_t block_size,                                          \
+      int64_t output_size,                                         \
+      int64_t index_size,                                          \
+      int64_t data_size,                                           \
+      DATA_TYPE* w,                                                \
+      const float* g,                                              \
+      float* h,                                                    \
+      const INDEX_TYPE* indices,                                   \
+      const OFFSET_TYPE* offsets_or_lengths,                       \
+      float epsilon,                                               \
+      float lr,                                                    \
+      bool use_offsets,                                            \
+      int64_t grad_stride);                                        \
+  template FBGEMM_API bool sparse_adam_fused_ref(                  \
+      bool lamb,                                                   \
+      bool rowwise,                                                \
+      int64_t block_size,                                          \
+      int64_t output_size,                                         \
+      int64_t index_size,                                          \
+      int64_t data_size,                                           \
+      DATA_TYPE* w,                                                \
+      const float* g,                                              \
+      float* momentum1,                                            \
+      float* momentum2,                                            \
+      const INDEX_TYPE* indices,                                   \
+      const OFFSET_TYPE* offsets_or_lengths,                       \
+      float learning_rate,                                         \
+      float eps,                                                   \
+      float beta1,                                                 \
+      float beta2,                                                 \
+      float weight_decay,                                          \
+      int64_t iter,                                                \
+      bool use_offsets,                                            \
+      int64_t grad_stride);                                        \
+  template FBGEMM_API bool sparse_lars_sgd_fused_ref(              \
+      int64_t block_size,                                          \
+      int64_t output_size,                                         \
+      int64_t index_size,                                          \
+      int64_t data_size,                                           \
+      DATA_TYPE* w,                                                \
+      const float* g,                                              \
+      float* momentum1,                                            \
+      const INDEX_TYPE* indices,                                   \
+      const OFFSET_TYPE* offsets_or_lengths,                       \
+      float learning_rate,                                         \
+      float eta,                                                   \
+      float momentum,                                              \
+      float weight_decay,                                          \
+      bool use_offsets,                                            \
       int64_t grad_stride);
 
 #define INSTANTIATE_SPMDM_OFFSET_T(DATA_TYPE, INDEX_TYPE) \
@@ -264,6 +264,34 @@ FBGEMM_API bool EmbeddingSpMDMNBit_ref(
     bool scale_bias_last = true,
     bool is_bf16_out = false);
 
+/**
+ * Same as EmbeddingSpMDMNBit_ref with scale_bias_last for the rows of
+ * FloatOrHalfToFusedNBitGroupwiseQuantizedSBHalf, with an fp16 scale and bias
+ * for every group_size elements after the packed row.
+ */
+template <
+    typename IndexType = std::int64_t,
+    typename OffsetType = std::int32_t,
+    typename OutType = float>
+FBGEMM_API bool EmbeddingSpMDMNBitGroupwise_ref(
+    int bit_rate,
+    int group_size,
+    const std::int64_t block_size,
+    const std::int64_t output_size,
+    const std::int64_t index_size,
+    const std::int64_t data_size,
+    const std::uint8_t* input,
+    const IndexType* indices,
+    const OffsetType* offsets_or_lengths,
+    const float* weights, // optional, can be null for non-weighted sum
+    bool normalize_by_lengths,
+    OutType* out,
+    bool is_weight_positional = false,
+    bool use_offsets = true,
+    std::int64_t output_stride = -1,
+    std::int64_t input_stride = -1,
+    bool is_bf16_out = false);
+
 template <
     typename IndexType = std::int64_t,
     typename OffsetType = std::int32_t,
@@ -383,6 +411,28 @@ FBGEMM_API int rowwise_sparse_adagrad_ref(
     const double* counter = nullptr,
     const int64_t counter_halflife = 0);
 
+/**
+ * SparseAdaGrad, rowwise or not, of float16 or bfloat16 weights, which are
+ * updated in float and rounded to nearest or stochastically.
+ */
+template <typename IndexType>
+FBGEMM_API int sparse_adagrad_16bit_ref(
+    int num_rows,
+    int block_size,
+    std::uint64_t param_size,
+    std::uint16_t* w,
+    const float* g,
+    float* h,
+    const IndexType* indices,
+    float epsilon,
+    float lr,
+    bool rowwise,
+    bool use_stochastic_rounding,
+    bool is_bf16,
+    float weight_decay = 0.f,
+    const double* counter = nullptr,
+    const int64_t counter_halflife = 0);
+
 template <typename DataType, typename IndexType, typename OffsetType>
 FBGEMM_API int rowwise_sparse_adagrad_fused_ref(
     std::int64_t block_size,
@@ -401,6 +451,74 @@ FBGEMM_API int rowwise_sparse_adagrad_fused_ref(
     int emu_vector_size = 8,
     std::int64_t grad_stride = -1);
 
+/**
+ * Element-wise SparseAdaGrad fused with the SLS gradient: every row indexed
+ * by bag m is updated with the gradient of output m.
+ */
+template <typename DataType, typename IndexType, typename OffsetType>
+FBGEMM_API bool sparse_adagrad_fused_ref(
+    std::int64_t block_size,
+    std::int64_t output_size,
+    std::int64_t index_size,
+    std::int64_t data_size,
+    DataType* w, // input/output parameters
+    const float* g, // input gradients
+    float* h, // input/output momentums, one per parameter
+    const IndexType* indices,
+    const OffsetType* offsets_or_lengths,
+    float epsilon,
+    float lr,
+    bool use_offsets = true,
+    std::int64_t grad_stride = -1);
+
+/**
+ * Adam or LAMB fused with the SLS gradient, see GenerateSparseAdamFused and
+ * GenerateSparseLambFused. momentum2 has one value per row when rowwise.
+ */
+template <typename DataType, typename IndexType, typename OffsetType>
+FBGEMM_API bool sparse_adam_fused_ref(
+    bool lamb,
+    bool rowwise,
+    std::int64_t block_size,
+    std::int64_t output_size,
+    std::int64_t index_size,
+    std::int64_t data_size,
+    DataType* w, // input/output parameters
+    const float* g, // input gradients
+    float* momentum1,
+    float* momentum2,
+    const IndexType* indices,
+    const OffsetType* offsets_or_lengths,
+    float learning_rate,
+    float eps,
+    float beta1,
+    float beta2,
+    float weight_decay,
+    std::int64_t iter,
+    bool use_offsets = true,
+    std::int64_t grad_stride = -1);
+
+/**
+ * LARS SGD fused with the SLS gradient, see GenerateSparseLarsSGDFused.
+ */
+template <typename DataType, typename IndexType, typename OffsetType>
+FBGEMM_API bool sparse_lars_sgd_fused_ref(
+    std::int64_t block_size,
+    std::int64_t output_size,
+    std::int64_t index_size,
+    std::int64_t data_size,
+    DataType* w, // input/output parameters
+    const float* g, // input gradients
+    float* momentum1,
+    const IndexType* indices,
+    const OffsetType* offsets_or_lengths,
+    float learning_rate,
+    float eta,
+    float momentum,
+    float weight_decay,
+    bool use_offsets = true,
+    std::int64_t grad_stride = -1);
+
 template <typename IndexType>
 FBGEMM_API void compressed_indices_remap_ref(
     std::int32_t offsets_len,
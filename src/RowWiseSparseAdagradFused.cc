@@ -11,12 +11,17 @@
 
 #include <asmjit/asmjit.h>
 #include <cpuinfo.h>
+#include <algorithm>
 #include <cassert>
 #include <iostream>
 #include <mutex>
+#include <tuple>
+#include <vector>
 #include "./CodeCache.h"
+#include "./CodeStorage.h"
 #include "./MaskAvx2.h"
 #include "./RefImplementations.h"
+#include "./TraceScope.h"
 #include "fbgemm/SimdUtils.h"
 #include "fbgemm/Utils.h"
 
@@ -98,7 +103,7 @@ CodeCache<
     typename ReturnFunctionSignature<indxType, offsetType, dataType>::
         jit_sparse_adagrad_kernel>
     GenRowWiseSparseAdagradFused<indxType, offsetType, dataType, instSet>::
-        codeCache_;
+        codeCache_("rowwise_sparse_adagrad_fused");
 
 template <
     typename indxType,
@@ -754,11 +759,7 @@ typename ReturnFunctionSignature<indxType, offsetType, dataType>::
         // jit_fused8bitembedding_kernel fn;
         typename ReturnFunctionSignature<indxType, offsetType, dataType>::
             jit_sparse_adagrad_kernel fn;
-        asmjit::Error err;
-        {
-          unique_lock<mutex> lock(rtMutex_);
-          err = runtime().add(&fn, &code);
-        }
+        asmjit::Error err = addJitKernel(runtime(), rtMutex_, &fn, code);
         if (err) {
           cout << "Error: in fn add" << endl;
           return nullptr;
@@ -799,25 +800,290 @@ void rand_initialize() {
   }
 }
 
-} // namespace
+// Sorts the indices with the bag of each occurrence and sums the gradients
+// of the bags of every unique row into unique_g. Returns false without
+// touching the outputs when lengths or indices are out of bound.
+template <typename IndexType, typename OffsetType>
+bool deduplicateIndices(
+    int64_t block_size,
+    int64_t output_size,
+    int64_t index_size,
+    int64_t data_size,
+    const float* g,
+    const IndexType* indices,
+    const OffsetType* offsets_or_lengths,
+    bool use_offsets,
+    int64_t grad_stride,
+    vector<IndexType>& unique_indices,
+    vector<float>& unique_g) {
+  vector<IndexType> keys(index_size), tmp_keys(index_size);
+  vector<int64_t> bags(index_size), tmp_bags(index_size);
+  int64_t current = 0;
+  for (int64_t m = 0; m < output_size; ++m) {
+    int64_t len = use_offsets
+        ? offsets_or_lengths[m + 1] - offsets_or_lengths[m]
+        : offsets_or_lengths[m];
+    if (current + len > index_size) {
+      return false;
+    }
+    for (int64_t i = 0; i < len; ++i, ++current) {
+      IndexType idx = indices[current];
+      if (idx < 0 || idx >= data_size) {
+        return false;
+      }
+      keys[current] = idx;
+      bags[current] = m;
+    }
+  }
+  if (current != index_size) {
+    return false;
+  }
+
+  // The sort is stable so the bags of a row stay in order, which keeps the
+  // sums deterministic
+  IndexType* sorted_keys = keys.data();
+  int64_t* sorted_bags = bags.data();
+  if (index_size > 0) {
+    tie(sorted_keys, sorted_bags) = radix_sort_parallel(
+        keys.data(),
+        bags.data(),
+        tmp_keys.data(),
+        tmp_bags.data(),
+        index_size,
+        data_size - 1);
+  }
+
+  vector<int64_t> row_begin;
+  for (int64_t i = 0; i < index_size; ++i) {
+    if (i == 0 || sorted_keys[i] != sorted_keys[i - 1]) {
+      row_begin.push_back(i);
+    }
+  }
+  const int64_t num_unique = row_begin.size();
+  row_begin.push_back(index_size);
+
+  unique_indices.resize(num_unique);
+  unique_g.assign(num_unique * block_size, 0.0f);
+#ifdef _OPENMP
+#pragma omp parallel for
+#endif
+  for (int64_t u = 0; u < num_unique; ++u) {
+    unique_indices[u] = sorted_keys[row_begin[u]];
+    float* g_u = unique_g.data() + u * block_size;
+    for (int64_t i = row_begin[u]; i < row_begin[u + 1]; ++i) {
+      const float* g_ = g + sorted_bags[i] * grad_stride;
+      for (int64_t j = 0; j < block_size; ++j) {
+        g_u[j] += g_[j];
+      }
+    }
+  }
+  return true;
+}
+
+// Splits the rows into num_shards ranges and lists the indices of each range
+// in their original order, with the lengths of their bags. Shard s has the
+// indices shard_indices[shard_begin[s], shard_begin[s + 1]), and its bag m
+// has shard_lengths[s * output_size + m] of them. Returns false when lengths
+// or indices are out of bound.
+template <typename IndexType, typename OffsetType>
+bool shardIndices(
+    int num_shards,
+    int64_t output_size,
+    int64_t index_size,
+    int64_t data_size,
+    const IndexType* indices,
+    const OffsetType* offsets_or_lengths,
+    bool use_offsets,
+    vector<IndexType>& shard_indices,
+    vector<int64_t>& shard_begin,
+    vector<OffsetType>& shard_lengths) {
+  auto shardOf = [&](int64_t idx) {
+    return static_cast<int>(idx * num_shards / data_size);
+  };
+
+  shard_begin.assign(num_shards + 1, 0);
+  shard_lengths.assign(num_shards * output_size, 0);
+  int64_t current = 0;
+  for (int64_t m = 0; m < output_size; ++m) {
+    int64_t len = use_offsets
+        ? offsets_or_lengths[m + 1] - offsets_or_lengths[m]
+        : offsets_or_lengths[m];
+    if (current + len > index_size) {
+      return false;
+    }
+    for (int64_t i = 0; i < len; ++i, ++current) {
+      int64_t idx = indices[current];
+      if (idx < 0 || idx >= data_size) {
+        return false;
+      }
+      const int shard = shardOf(idx);
+      ++shard_begin[shard + 1];
+      ++shard_lengths[shard * output_size + m];
+    }
+  }
+  if (current != index_size) {
+    return false;
+  }
+
+  for (int s = 0; s < num_shards; ++s) {
+    shard_begin[s + 1] += shard_begin[s];
+  }
+  shard_indices.resize(index_size);
+  vector<int64_t> next(shard_begin.begin(), shard_begin.end() - 1);
+  for (int64_t i = 0; i < index_size; ++i) {
+    shard_indices[next[shardOf(indices[i])]++] = indices[i];
+  }
+  return true;
+}
 
 template <typename IndexType, typename OffsetType, typename DataType>
-FBGEMM_API typename RowWiseSparseAdaGradFusedSignature<
+typename RowWiseSparseAdaGradFusedSignature<
     IndexType,
     OffsetType,
     DataType>::Type
-GenerateRowWiseSparseAdaGradFused(
+generateRowWiseSparseAdaGradFused(
     int block_size, // number of parameters per row
     int prefetch,
     bool use_offsets,
     bool use_stochastic_rounding,
-    int grad_stride) {
+    int grad_stride,
+    bool deduplicate_indices,
+    int num_threads) {
   if (!cpuinfo_initialize()) {
     throw std::runtime_error("Failed to initialize cpuinfo!");
   }
   if (grad_stride == -1) {
     grad_stride = block_size;
   }
+  if (num_threads <= 0) {
+    num_threads = fbgemmGetNumThreads();
+  }
+
+  if (deduplicate_indices) {
+    // Bags of one index with the aggregated gradients, so that every row is
+    // updated once
+    const auto update =
+        GenerateRowWiseSparseAdaGradFused<IndexType, OffsetType, DataType>(
+            block_size,
+            prefetch,
+            false /* use_offsets */,
+            use_stochastic_rounding,
+            -1 /* grad_stride */,
+            false /* deduplicate_indices */,
+            num_threads);
+    return [=](int64_t output_size,
+               int64_t index_size,
+               int64_t data_size,
+               DataType* w,
+               const float* g,
+               float* h,
+               const IndexType* indices,
+               const OffsetType* offsets_or_lengths,
+               float epsilon,
+               float lr) {
+      vector<IndexType> unique_indices;
+      vector<float> unique_g;
+      if (!deduplicateIndices(
+              block_size,
+              output_size,
+              index_size,
+              data_size,
+              g,
+              indices,
+              offsets_or_lengths,
+              use_offsets,
+              grad_stride,
+              unique_indices,
+              unique_g)) {
+        return false;
+      }
+      const int64_t num_unique = unique_indices.size();
+      const vector<OffsetType> lengths(num_unique, 1);
+      return update(
+          num_unique,
+          num_unique,
+          data_size,
+          w,
+          unique_g.data(),
+          h,
+          unique_indices.data(),
+          lengths.data(),
+          epsilon,
+          lr);
+    };
+  }
+
+  if (num_threads > 1) {
+    // Every thread updates the rows of its range, visiting their indices in
+    // the original order, which gives the sequential result
+    const auto update =
+        GenerateRowWiseSparseAdaGradFused<IndexType, OffsetType, DataType>(
+            block_size,
+            prefetch,
+            false /* use_offsets */,
+            use_stochastic_rounding,
+            grad_stride);
+    return [=](int64_t output_size,
+               int64_t index_size,
+               int64_t data_size,
+               DataType* w,
+               const float* g,
+               float* h,
+               const IndexType* indices,
+               const OffsetType* offsets_or_lengths,
+               float epsilon,
+               float lr) {
+      const int num_shards =
+          static_cast<int>(std::min<int64_t>(num_threads, data_size));
+      if (num_shards <= 1) {
+        return update(
+            output_size,
+            index_size,
+            data_size,
+            w,
+            g,
+            h,
+            indices,
+            offsets_or_lengths,
+            epsilon,
+            lr);
+      }
+      vector<IndexType> shard_indices;
+      vector<int64_t> shard_begin;
+      vector<OffsetType> shard_lengths;
+      if (!shardIndices(
+              num_shards,
+              output_size,
+              index_size,
+              data_size,
+              indices,
+              offsets_or_lengths,
+              use_offsets,
+              shard_indices,
+              shard_begin,
+              shard_lengths)) {
+        return false;
+      }
+      vector<std::uint8_t> shard_success(num_shards);
+      fbgemmParallelTasks(num_shards, [&](int s) {
+        shard_success[s] = update(
+            output_size,
+            shard_begin[s + 1] - shard_begin[s],
+            data_size,
+            w,
+            g,
+            h,
+            shard_indices.data() + shard_begin[s],
+            shard_lengths.data() + s * output_size,
+            epsilon,
+            lr);
+      });
+      return std::all_of(
+          shard_success.begin(),
+          shard_success.end(),
+          [](std::uint8_t s) { return s != 0; });
+    };
+  }
 
   // Use avx512 only for fp16 + stochastic rounding
   if (fbgemmHasAvx512Support() && std::is_same<DataType, float16>::value &&
@@ -940,6 +1206,38 @@ GenerateRowWiseSparseAdaGradFused(
   }
 }
 
+} // namespace
+
+template <typename IndexType, typename OffsetType, typename DataType>
+FBGEMM_API typename RowWiseSparseAdaGradFusedSignature<
+    IndexType,
+    OffsetType,
+    DataType>::Type
+GenerateRowWiseSparseAdaGradFused(
+    int block_size, // number of parameters per row
+    int prefetch,
+    bool use_offsets,
+    bool use_stochastic_rounding,
+    int grad_stride,
+    bool deduplicate_indices,
+    int num_threads) {
+  // An index updates the weights and the momentum of its row, an output
+  // reads its gradients
+  return internal::traceKernel(
+      "RowWiseSparseAdaGradFused",
+      generateRowWiseSparseAdaGradFused<IndexType, OffsetType, DataType>(
+          block_size,
+          prefetch,
+          use_offsets,
+          use_stochastic_rounding,
+          grad_stride,
+          deduplicate_indices,
+          num_threads),
+      block_size,
+      sizeof(IndexType) + 2 * (block_size * sizeof(DataType) + sizeof(float)),
+      block_size * sizeof(float) + sizeof(OffsetType));
+}
+
 template FBGEMM_API
     typename RowWiseSparseAdaGradFusedSignature<int64_t, int32_t, float>::Type
     GenerateRowWiseSparseAdaGradFused<int64_t, int32_t, float>(
@@ -947,7 +1245,9 @@ template FBGEMM_API
         int prefetch,
         bool use_offsets,
         bool use_stochastic_rounding,
-        int grad_stride);
+        int grad_stride,
+        bool deduplicate_indices,
+        int num_threads);
 
 template FBGEMM_API
     typename RowWiseSparseAdaGradFusedSignature<int64_t, int64_t, float>::Type
@@ -956,7 +1256,9 @@ template FBGEMM_API
         int prefetch,
         bool use_offsets,
         bool use_stochastic_rounding,
-        int grad_stride);
+        int grad_stride,
+        bool deduplicate_indices,
+        int num_threads);
 
 template FBGEMM_API
     typename RowWiseSparseAdaGradFusedSignature<int32_t, int32_t, float>::Type
@@ -965,7 +1267,9 @@ template FBGEMM_API
         int prefetch,
         bool use_offsets,
         bool use_stochastic_rounding,
-        int grad_stride);
+        int grad_stride,
+        bool deduplicate_indices,
+        int num_threads);
 
 template FBGEMM_API
     typename RowWiseSparseAdaGradFusedSignature<int32_t, int64_t, float>::Type
@@ -974,7 +1278,9 @@ template FBGEMM_API
         int prefetch,
         bool use_offsets,
         bool use_stochastic_rounding,
-        int grad_stride);
+        int grad_stride,
+        bool deduplicate_indices,
+        int num_threads);
 
 template FBGEMM_API
     typename RowWiseSparseAdaGradFusedSignature<int64_t, int32_t, float16>::Type
@@ -983,7 +1289,9 @@ template FBGEMM_API
         int prefetch,
         bool use_offsets,
         bool use_stochastic_rounding,
-        int grad_stride);
+        int grad_stride,
+        bool deduplicate_indices,
+        int num_threads);
 
 template FBGEMM_API
     typename RowWiseSparseAdaGradFusedSignature<int64_t, int64_t, float16>::Type
@@ -992,7 +1300,9 @@ template FBGEMM_API
         int prefetch,
         bool use_offsets,
         bool use_stochastic_rounding,
-        int grad_stride);
+        int grad_stride,
+        bool deduplicate_indices,
+        int num_threads);
 
 template FBGEMM_API
     typename RowWiseSparseAdaGradFusedSignature<int32_t, int32_t, float16>::Type
@@ -1001,7 +1311,9 @@ template FBGEMM_API
         int prefetch,
         bool use_offsets,
         bool use_stochastic_rounding,
-        int grad_stride);
+        int grad_stride,
+        bool deduplicate_indices,
+        int num_threads);
 
 template FBGEMM_API
     typename RowWiseSparseAdaGradFusedSignature<int32_t, int64_t, float16>::Type
@@ -1010,6 +1322,8 @@ template FBGEMM_API
         int prefetch,
         bool use_offsets,
         bool use_stochastic_rounding,
-        int grad_stride);
+        int grad_stride,
+        bool deduplicate_indices,
+        int num_threads);
 
 } // namespace fbgemm
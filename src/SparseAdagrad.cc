@@ -16,9 +16,12 @@
 #include <mutex>
 #include <string>
 #include <tuple>
+#include <type_traits>
 #include "./CodeCache.h"
+#include "./CodeStorage.h"
 #include "./MaskAvx2.h"
 #include "./RefImplementations.h"
+#include "./TraceScope.h"
 #include "fbgemm/SimdUtils.h"
 #include "fbgemm/Utils.h"
 
@@ -120,7 +123,7 @@ template <typename indxType, inst_set_t instSet>
 CodeCache<
     std::tuple<int, int, bool, bool>,
     typename ReturnFunctionSignature<indxType>::jit_sparse_adagrad_kernel>
-    GenSparseAdagrad<indxType, instSet>::codeCache_;
+    GenSparseAdagrad<indxType, instSet>::codeCache_("sparse_adagrad");
 
 template <typename indxType, inst_set_t instSet>
 void GenSparseAdagrad<indxType, instSet>::genSparseAdagrad(
@@ -454,6 +457,16 @@ GenSparseAdagrad<indxType, instSet>::getOrCreate(
       kernelSig,
       [&]() ->
       typename ReturnFunctionSignature<indxType>::jit_sparse_adagrad_kernel {
+        typename ReturnFunctionSignature<indxType>::jit_sparse_adagrad_kernel
+            fn;
+        const std::string jitKey = getJitCacheKey(
+            "sparse_adagrad",
+            instSet,
+            std::tuple_cat(std::make_tuple(sizeof(indxType)), kernelSig));
+        if (loadJitKernel(runtime(), rtMutex_, jitKey, &fn)) {
+          return fn;
+        }
+
         asmjit::CodeHolder code;
         code.init(runtime().environment());
         x86::Assembler assembler(&code);
@@ -768,13 +781,8 @@ GenSparseAdagrad<indxType, instSet>::getOrCreate(
         a->mov(x86::eax, temp1_.r32());
         a->emitEpilog(frame);
 
-        typename ReturnFunctionSignature<indxType>::jit_sparse_adagrad_kernel
-            fn;
-        asmjit::Error err;
-        {
-          std::unique_lock<std::mutex> lock(rtMutex_);
-          err = runtime().add(&fn, &code);
-        }
+        asmjit::Error err =
+            addJitKernel(runtime(), rtMutex_, &fn, code, jitKey);
         if (err) {
           std::cout << "Error: in fn add" << std::endl;
           return nullptr;
@@ -867,19 +875,92 @@ template int SparseAdaGradBlockSize1_(
     const double* counter,
     std::int64_t counter_halflife);
 
-} // namespace
-
+// SparseAdaGrad of float16 or bfloat16 weights
 template <typename IndexType>
-typename SparseAdaGradSignature<IndexType>::Type GenerateSparseAdaGrad(
+typename SparseAdaGradSignature<IndexType, std::uint16_t>::Type
+GenerateSparseAdaGrad16Bit(
     int block_size,
     bool rowwise,
     int prefetch,
-    bool use_weight_decay) {
+    bool use_weight_decay,
+    bool use_stochastic_rounding,
+    bool is_bf16) {
+  const bool has_avx2 = fbgemmHasAvx2Support();
+  return [=](int num_rows, // number of rows reading
+             std::uint64_t param_size, // total number of parameters
+             std::uint16_t* w, // input/output parameters
+             const float* g, // input gradients
+             float* h, // input/output momentums
+             const IndexType* indices, // indices of each row
+             float epsilon,
+             float lr,
+             float weight_decay,
+             const double* counter,
+             std::int64_t counter_halflife) {
+    if (!use_weight_decay) {
+      weight_decay = 0.0f;
+      counter = nullptr;
+    }
+    if (has_avx2) {
+      return internal::SparseAdaGrad16Bit_avx2(
+          num_rows,
+          block_size,
+          param_size,
+          w,
+          g,
+          h,
+          indices,
+          epsilon,
+          lr,
+          rowwise,
+          use_stochastic_rounding,
+          is_bf16,
+          weight_decay,
+          counter,
+          counter_halflife,
+          prefetch);
+    }
+    return sparse_adagrad_16bit_ref(
+        num_rows,
+        block_size,
+        param_size,
+        w,
+        g,
+        h,
+        indices,
+        epsilon,
+        lr,
+        rowwise,
+        use_stochastic_rounding,
+        is_bf16,
+        weight_decay,
+        counter,
+        counter_halflife);
+  };
+}
+
+template <typename IndexType, typename DataType>
+typename SparseAdaGradSignature<IndexType, DataType>::Type
+generateSparseAdaGrad(
+    int block_size,
+    bool rowwise,
+    int prefetch,
+    bool use_weight_decay,
+    [[maybe_unused]] bool use_stochastic_rounding,
+    [[maybe_unused]] bool is_bf16) {
   if (!cpuinfo_initialize()) {
     throw std::runtime_error("Failed to initialize cpuinfo!");
   }
 
-  if (fbgemmHasAvx512Support() || fbgemmHasAvx2Support()) {
+  if constexpr (!std::is_same_v<DataType, float>) {
+    return GenerateSparseAdaGrad16Bit<IndexType>(
+        block_size,
+        rowwise,
+        prefetch,
+        use_weight_decay,
+        use_stochastic_rounding,
+        is_bf16);
+  } else if (fbgemmHasAvx512Support() || fbgemmHasAvx2Support()) {
     if (block_size == 1) {
       return [=](int num_rows, // number of rows reading
                  std::uint64_t param_size, // total number of parameters
@@ -986,18 +1067,82 @@ typename SparseAdaGradSignature<IndexType>::Type GenerateSparseAdaGrad(
   }
 }
 
-template FBGEMM_API typename SparseAdaGradSignature<std::int64_t>::Type
-GenerateSparseAdaGrad<std::int64_t>(
-    int block_size, // number of parameters per rows
-    bool rowwise,
-    int prefetch,
-    bool use_weight_decay);
+} // namespace
 
-template FBGEMM_API typename SparseAdaGradSignature<std::int32_t>::Type
-GenerateSparseAdaGrad<std::int32_t>(
-    int block_size, // number of parameters per rows
+template <typename IndexType, typename DataType>
+typename SparseAdaGradSignature<IndexType, DataType>::Type
+GenerateSparseAdaGrad(
+    int block_size,
     bool rowwise,
     int prefetch,
-    bool use_weight_decay);
+    bool use_weight_decay,
+    bool use_stochastic_rounding,
+    bool is_bf16) {
+  const auto kernel = generateSparseAdaGrad<IndexType, DataType>(
+      block_size,
+      rowwise,
+      prefetch,
+      use_weight_decay,
+      use_stochastic_rounding,
+      is_bf16);
+#ifdef FBGEMM_DISABLE_TRACING
+  return kernel;
+#else
+  // A row reads its index and gradients and updates its weights and momentums
+  const int64_t bytes_per_row = sizeof(IndexType) +
+      block_size * (sizeof(float) + 2 * sizeof(DataType)) +
+      2 * sizeof(float) * (rowwise ? 1 : block_size);
+  return [=](int num_rows,
+             std::uint64_t param_size,
+             DataType* w,
+             const float* g,
+             float* h,
+             const IndexType* indices,
+             float epsilon,
+             float lr,
+             float weight_decay,
+             const double* counter,
+             std::int64_t counter_halflife) {
+    FBGEMM_TRACE_SCOPE(
+        "SparseAdaGrad",
+        num_rows * bytes_per_row,
+        0,
+        1,
+        num_rows,
+        static_cast<int64_t>(param_size),
+        block_size);
+    return kernel(
+        num_rows,
+        param_size,
+        w,
+        g,
+        h,
+        indices,
+        epsilon,
+        lr,
+        weight_decay,
+        counter,
+        counter_halflife);
+  };
+#endif
+}
+
+#define INSTANTIATE_SPARSE_ADAGRAD(INDEX_TYPE, DATA_TYPE)                 \
+  template FBGEMM_API                                                    \
+      typename SparseAdaGradSignature<INDEX_TYPE, DATA_TYPE>::Type       \
+      GenerateSparseAdaGrad<INDEX_TYPE, DATA_TYPE>(                      \
+          int block_size, /* number of parameters per rows */            \
+          bool rowwise,                                                  \
+          int prefetch,                                                  \
+          bool use_weight_decay,                                         \
+          bool use_stochastic_rounding,                                  \
+          bool is_bf16);
+
+INSTANTIATE_SPARSE_ADAGRAD(std::int64_t, float)
+INSTANTIATE_SPARSE_ADAGRAD(std::int32_t, float)
+INSTANTIATE_SPARSE_ADAGRAD(std::int64_t, std::uint16_t)
+INSTANTIATE_SPARSE_ADAGRAD(std::int32_t, std::uint16_t)
+
+#undef INSTANTIATE_SPARSE_ADAGRAD
 
 } // namespace fbgemm
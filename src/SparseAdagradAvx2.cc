@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#define FBGEMM_EXPORTS
+#include <immintrin.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "./MaskAvx2.h"
+#include "./StochasticRoundingAvx2.h"
+#include "fbgemm/FbgemmEmbedding.h"
+
+namespace fbgemm {
+namespace internal {
+
+namespace {
+
+constexpr int VLEN = 8;
+
+// Loads and stores of n <= VLEN float16 or bfloat16 weights
+inline __m256 load16Bit(const std::uint16_t* w, int n, bool is_bf16) {
+  __m128i w_v;
+  if (n == VLEN) {
+    w_v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(w));
+  } else {
+    // No AVX2 masked load/store for 16 bits
+    std::uint16_t buf[VLEN] = {};
+    std::memcpy(buf, w, n * sizeof(std::uint16_t));
+    w_v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf));
+  }
+  if (is_bf16) {
+    return _mm256_castsi256_ps(
+        _mm256_slli_epi32(_mm256_cvtepu16_epi32(w_v), 16));
+  }
+  return _mm256_cvtph_ps(w_v);
+}
+
+inline void store16Bit(
+    std::uint16_t* w,
+    __m256 w_v,
+    int n,
+    bool is_bf16,
+    StochasticRoundingAvx2* rounding) {
+  __m128i w_16;
+  if (rounding) {
+    w_16 = is_bf16 ? rounding->toBfloat16(w_v) : rounding->toFloat16(w_v);
+  } else if (is_bf16) {
+    // Add 2^15 and right shift 16 to do round-nearest
+    const __m256i y = _mm256_srli_epi32(
+        _mm256_add_epi32(_mm256_castps_si256(w_v), _mm256_set1_epi32(1 << 15)),
+        16);
+    w_16 = _mm_packus_epi32(
+        _mm256_castsi256_si128(y), _mm256_extracti128_si256(y, 1));
+  } else {
+    w_16 = _mm256_cvtps_ph(
+        w_v, (_MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+  }
+  if (n == VLEN) {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(w), w_16);
+  } else {
+    std::uint16_t buf[VLEN];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(buf), w_16);
+    std::memcpy(w, buf, n * sizeof(std::uint16_t));
+  }
+}
+
+inline __m256 loadPartial(const float* p, int n, __m256i mask) {
+  return n == VLEN ? _mm256_loadu_ps(p) : _mm256_maskload_ps(p, mask);
+}
+
+inline void storePartial(float* p, __m256 v, int n, __m256i mask) {
+  if (n == VLEN) {
+    _mm256_storeu_ps(p, v);
+  } else {
+    _mm256_maskstore_ps(p, mask, v);
+  }
+}
+
+} // namespace
+
+template <typename IndexType>
+int SparseAdaGrad16Bit_avx2(
+    int num_rows,
+    int block_size,
+    std::uint64_t param_size,
+    std::uint16_t* w,
+    const float* g,
+    float* h,
+    const IndexType* indices,
+    float epsilon,
+    float lr,
+    bool rowwise,
+    bool use_stochastic_rounding,
+    bool is_bf16,
+    float weight_decay,
+    const double* counter,
+    std::int64_t counter_halflife,
+    int prefetch) {
+  constexpr int CACHE_LINE_LEN = 64;
+  const int remainder = block_size % VLEN;
+  const __m256i mask_v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+      &avx2_ps_or_epi32_combined_mask[(VLEN - remainder) % VLEN]));
+  const __m256 epsilon_v = _mm256_set1_ps(epsilon);
+  const __m256 lr_v = _mm256_set1_ps(lr);
+
+  StochasticRoundingAvx2 rounding;
+  StochasticRoundingAvx2* rounding_ptr =
+      use_stochastic_rounding ? &rounding : nullptr;
+
+  for (int i = 0; i < num_rows; ++i) {
+    const std::uint64_t idx = indices[i];
+    const std::uint64_t offsetIdx = idx * block_size;
+    if (block_size + offsetIdx > param_size) {
+      return i;
+    }
+    if (prefetch && i + prefetch < num_rows) {
+      const std::uint64_t offsetPref =
+          static_cast<std::uint64_t>(indices[i + prefetch]) * block_size;
+      if (block_size + offsetPref <= param_size) {
+        const char* w_pref = reinterpret_cast<const char*>(w + offsetPref);
+        for (int b = 0; b < block_size * 2; b += CACHE_LINE_LEN) {
+          _mm_prefetch(w_pref + b, _MM_HINT_T0);
+        }
+        if (!rowwise) {
+          const char* h_pref = reinterpret_cast<const char*>(h + offsetPref);
+          for (int b = 0; b < block_size * 4; b += CACHE_LINE_LEN) {
+            _mm_prefetch(h_pref + b, _MM_HINT_T0);
+          }
+        }
+      }
+    }
+
+    const float freq = (counter && counter[idx] > 0)
+        ? counter_halflife / counter[idx]
+        : 1.0f;
+    const __m256 weight_decay_v = _mm256_set1_ps(weight_decay * freq);
+    const float* g_ = g + static_cast<std::int64_t>(i) * block_size;
+    std::uint16_t* w_ = w + offsetIdx;
+
+    if (rowwise) {
+      // Lane j % VLEN sums the squares of the gradients j, in the order of
+      // rowwise_sparse_adagrad_ref
+      __m256 partial_sum_v = _mm256_setzero_ps();
+      for (int j = 0; j < block_size; j += VLEN) {
+        const int n = std::min(VLEN, block_size - j);
+        __m256 g_v = _mm256_fmadd_ps(
+            weight_decay_v,
+            load16Bit(w_ + j, n, is_bf16),
+            loadPartial(g_ + j, n, mask_v));
+        partial_sum_v = _mm256_add_ps(partial_sum_v, _mm256_mul_ps(g_v, g_v));
+      }
+      alignas(32) float partial_sum[VLEN];
+      _mm256_store_ps(partial_sum, partial_sum_v);
+      const float final_sum = (((partial_sum[0] + partial_sum[1]) +
+                                (partial_sum[2] + partial_sum[3])) +
+                               ((partial_sum[4] + partial_sum[5]) +
+                                (partial_sum[6] + partial_sum[7]))) /
+          block_size;
+      const float hi = h[idx] = h[idx] + final_sum;
+      const __m256 step_v = _mm256_set1_ps(lr / (std::sqrt(hi) + epsilon));
+
+      for (int j = 0; j < block_size; j += VLEN) {
+        const int n = std::min(VLEN, block_size - j);
+        __m256 w_v = load16Bit(w_ + j, n, is_bf16);
+        __m256 g_v = _mm256_fmadd_ps(
+            weight_decay_v, w_v, loadPartial(g_ + j, n, mask_v));
+        store16Bit(
+            w_ + j,
+            _mm256_add_ps(w_v, _mm256_mul_ps(g_v, step_v)),
+            n,
+            is_bf16,
+            rounding_ptr);
+      }
+    } else {
+      float* h_ = h + offsetIdx;
+      for (int j = 0; j < block_size; j += VLEN) {
+        const int n = std::min(VLEN, block_size - j);
+        __m256 w_v = load16Bit(w_ + j, n, is_bf16);
+        __m256 g_v = _mm256_fmadd_ps(
+            weight_decay_v, w_v, loadPartial(g_ + j, n, mask_v));
+        __m256 h_v = _mm256_add_ps(
+            loadPartial(h_ + j, n, mask_v), _mm256_mul_ps(g_v, g_v));
+        storePartial(h_ + j, h_v, n, mask_v);
+        __m256 step_v = _mm256_div_ps(
+            _mm256_mul_ps(lr_v, g_v),
+            _mm256_add_ps(_mm256_sqrt_ps(h_v), epsilon_v));
+        store16Bit(
+            w_ + j, _mm256_add_ps(w_v, step_v), n, is_bf16, rounding_ptr);
+      }
+    }
+  }
+  return num_rows;
+}
+
+#define INSTANTIATE_SPARSE_ADAGRAD(INDEX_TYPE)                  \
+  template FBGEMM_API int SparseAdaGrad16Bit_avx2(              \
+      int num_rows,                                             \
+      int block_size,                                           \
+      std::uint64_t param_size,                                 \
+      std::uint16_t* w,                                         \
+      const float* g,                                           \
+      float* h,                                                 \
+      const INDEX_TYPE* indices,                                \
+      float epsilon,                                            \
+      float lr,                                                 \
+      bool rowwise,                                             \
+      bool use_stochastic_rounding,                             \
+      bool is_bf16,                                             \
+      float weight_decay,                                       \
+      const double* counter,                                    \
+      std::int64_t counter_halflife,                            \
+      int prefetch);
+
+INSTANTIATE_SPARSE_ADAGRAD(std::int32_t)
+INSTANTIATE_SPARSE_ADAGRAD(std::int64_t)
+
+#undef INSTANTIATE_SPARSE_ADAGRAD
+
+} // namespace internal
+} // namespace fbgemm
@@ -0,0 +1,423 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#define FBGEMM_EXPORTS
+#include "fbgemm/FbgemmEmbedding.h"
+
+#include <cpuinfo.h>
+#include <cstdint>
+#include <stdexcept>
+
+#include "./RefImplementations.h"
+#include "./TraceScope.h"
+#include "fbgemm/Utils.h"
+
+namespace fbgemm {
+
+namespace {
+
+template <typename IndexType, typename OffsetType, typename DataType>
+typename SparseAdaGradFusedSignature<IndexType, OffsetType, DataType>::Type
+generateSparseAdaGradFused(
+    int block_size, // number of parameters per row
+    int prefetch,
+    bool use_offsets,
+    int grad_stride) {
+  if (!cpuinfo_initialize()) {
+    throw std::runtime_error("Failed to initialize cpuinfo!");
+  }
+  if (grad_stride == -1) {
+    grad_stride = block_size;
+  }
+
+  // The update is bound by memory bandwidth so AVX512 would not help
+  if (fbgemmHasAvx2Support()) {
+    return [=](std::int64_t output_size,
+               std::int64_t index_size,
+               std::int64_t data_size,
+               DataType* w,
+               const float* g,
+               float* h,
+               const IndexType* indices,
+               const OffsetType* offsets_or_lengths,
+               float epsilon,
+               float lr) {
+      return internal::SparseAdaGradFused_avx2(
+          block_size,
+          output_size,
+          index_size,
+          data_size,
+          w,
+          g,
+          h,
+          indices,
+          offsets_or_lengths,
+          epsilon,
+          lr,
+          use_offsets,
+          grad_stride,
+          prefetch);
+    };
+  } else {
+    return [=](std::int64_t output_size,
+               std::int64_t index_size,
+               std::int64_t data_size,
+               DataType* w,
+               const float* g,
+               float* h,
+               const IndexType* indices,
+               const OffsetType* offsets_or_lengths,
+               float epsilon,
+               float lr) {
+      return sparse_adagrad_fused_ref(
+          block_size,
+          output_size,
+          index_size,
+          data_size,
+          w,
+          g,
+          h,
+          indices,
+          offsets_or_lengths,
+          epsilon,
+          lr,
+          use_offsets,
+          grad_stride);
+    };
+  }
+}
+
+} // namespace
+
+template <typename IndexType, typename OffsetType, typename DataType>
+FBGEMM_API typename SparseAdaGradFusedSignature<
+    IndexType,
+    OffsetType,
+    DataType>::Type
+GenerateSparseAdaGradFused(
+    int block_size, // number of parameters per row
+    int prefetch,
+    bool use_offsets,
+    int grad_stride) {
+  // An index updates the weights and the momentums of its row, an output
+  // reads its gradients
+  return internal::traceKernel(
+      "SparseAdaGradFused",
+      generateSparseAdaGradFused<IndexType, OffsetType, DataType>(
+          block_size, prefetch, use_offsets, grad_stride),
+      block_size,
+      sizeof(IndexType) + 2 * block_size * (sizeof(DataType) + sizeof(float)),
+      block_size * sizeof(float) + sizeof(OffsetType));
+}
+
+namespace {
+
+// Adam and LAMB share their kernels
+template <typename IndexType, typename OffsetType, typename DataType>
+typename SparseAdamFusedSignature<IndexType, OffsetType, DataType>::Type
+generateSparseAdamOrLambFused(
+    bool lamb,
+    int block_size,
+    bool rowwise,
+    int prefetch,
+    bool use_offsets,
+    int grad_stride) {
+  if (!cpuinfo_initialize()) {
+    throw std::runtime_error("Failed to initialize cpuinfo!");
+  }
+  if (grad_stride == -1) {
+    grad_stride = block_size;
+  }
+
+  if (fbgemmHasAvx2Support()) {
+    return [=](std::int64_t output_size,
+               std::int64_t index_size,
+               std::int64_t data_size,
+               DataType* w,
+               const float* g,
+               float* momentum1,
+               float* momentum2,
+               const IndexType* indices,
+               const OffsetType* offsets_or_lengths,
+               float learning_rate,
+               float eps,
+               float beta1,
+               float beta2,
+               float weight_decay,
+               std::int64_t iter) {
+      return internal::SparseAdamFused_avx2(
+          lamb,
+          rowwise,
+          block_size,
+          output_size,
+          index_size,
+          data_size,
+          w,
+          g,
+          momentum1,
+          momentum2,
+          indices,
+          offsets_or_lengths,
+          learning_rate,
+          eps,
+          beta1,
+          beta2,
+          weight_decay,
+          iter,
+          use_offsets,
+          grad_stride,
+          prefetch);
+    };
+  } else {
+    return [=](std::int64_t output_size,
+               std::int64_t index_size,
+               std::int64_t data_size,
+               DataType* w,
+               const float* g,
+               float* momentum1,
+               float* momentum2,
+               const IndexType* indices,
+               const OffsetType* offsets_or_lengths,
+               float learning_rate,
+               float eps,
+               float beta1,
+               float beta2,
+               float weight_decay,
+               std::int64_t iter) {
+      return sparse_adam_fused_ref(
+          lamb,
+          rowwise,
+          block_size,
+          output_size,
+          index_size,
+          data_size,
+          w,
+          g,
+          momentum1,
+          momentum2,
+          indices,
+          offsets_or_lengths,
+          learning_rate,
+          eps,
+          beta1,
+          beta2,
+          weight_decay,
+          iter,
+          use_offsets,
+          grad_stride);
+    };
+  }
+}
+
+// An index updates the weights and the moments of its row
+template <typename IndexType, typename DataType>
+std::int64_t adamBytesPerIndex(int block_size, bool rowwise) {
+  return sizeof(IndexType) +
+      2 * block_size * (sizeof(DataType) + sizeof(float)) +
+      2 * sizeof(float) * (rowwise ? 1 : block_size);
+}
+
+} // namespace
+
+template <typename IndexType, typename OffsetType, typename DataType>
+FBGEMM_API
+    typename SparseAdamFusedSignature<IndexType, OffsetType, DataType>::Type
+    GenerateSparseAdamFused(
+        int block_size, // number of parameters per row
+        bool rowwise,
+        int prefetch,
+        bool use_offsets,
+        int grad_stride) {
+  return internal::traceKernel(
+      "SparseAdamFused",
+      generateSparseAdamOrLambFused<IndexType, OffsetType, DataType>(
+          false /* lamb */,
+          block_size,
+          rowwise,
+          prefetch,
+          use_offsets,
+          grad_stride),
+      block_size,
+      adamBytesPerIndex<IndexType, DataType>(block_size, rowwise),
+      block_size * sizeof(float) + sizeof(OffsetType));
+}
+
+template <typename IndexType, typename OffsetType, typename DataType>
+FBGEMM_API
+    typename SparseAdamFusedSignature<IndexType, OffsetType, DataType>::Type
+    GenerateSparseLambFused(
+        int block_size, // number of parameters per row
+        bool rowwise,
+        int prefetch,
+        bool use_offsets,
+        int grad_stride) {
+  return internal::traceKernel(
+      "SparseLambFused",
+      generateSparseAdamOrLambFused<IndexType, OffsetType, DataType>(
+          true /* lamb */,
+          block_size,
+          rowwise,
+          prefetch,
+          use_offsets,
+          grad_stride),
+      block_size,
+      adamBytesPerIndex<IndexType, DataType>(block_size, rowwise),
+      block_size * sizeof(float) + sizeof(OffsetType));
+}
+
+namespace {
+
+template <typename IndexType, typename OffsetType, typename DataType>
+typename SparseLarsSGDFusedSignature<IndexType, OffsetType, DataType>::Type
+generateSparseLarsSGDFused(
+    int block_size, // number of parameters per row
+    int prefetch,
+    bool use_offsets,
+    int grad_stride) {
+  if (!cpuinfo_initialize()) {
+    throw std::runtime_error("Failed to initialize cpuinfo!");
+  }
+  if (grad_stride == -1) {
+    grad_stride = block_size;
+  }
+
+  if (fbgemmHasAvx2Support()) {
+    return [=](std::int64_t output_size,
+               std::int64_t index_size,
+               std::int64_t data_size,
+               DataType* w,
+               const float* g,
+               float* momentum1,
+               const IndexType* indices,
+               const OffsetType* offsets_or_lengths,
+               float learning_rate,
+               float eta,
+               float momentum,
+               float weight_decay) {
+      return internal::SparseLarsSGDFused_avx2(
+          block_size,
+          output_size,
+          index_size,
+          data_size,
+          w,
+          g,
+          momentum1,
+          indices,
+          offsets_or_lengths,
+          learning_rate,
+          eta,
+          momentum,
+          weight_decay,
+          use_offsets,
+          grad_stride,
+          prefetch);
+    };
+  } else {
+    return [=](std::int64_t output_size,
+               std::int64_t index_size,
+               std::int64_t data_size,
+               DataType* w,
+               const float* g,
+               float* momentum1,
+               const IndexType* indices,
+               const OffsetType* offsets_or_lengths,
+               float learning_rate,
+               float eta,
+               float momentum,
+               float weight_decay) {
+      return sparse_lars_sgd_fused_ref(
+          block_size,
+          output_size,
+          index_size,
+          data_size,
+          w,
+          g,
+          momentum1,
+          indices,
+          offsets_or_lengths,
+          learning_rate,
+          eta,
+          momentum,
+          weight_decay,
+          use_offsets,
+          grad_stride);
+    };
+  }
+}
+
+} // namespace
+
+template <typename IndexType, typename OffsetType, typename DataType>
+FBGEMM_API
+    typename SparseLarsSGDFusedSignature<IndexType, OffsetType, DataType>::Type
+    GenerateSparseLarsSGDFused(
+        int block_size, // number of parameters per row
+        int prefetch,
+        bool use_offsets,
+        int grad_stride) {
+  // An index updates the weights and the momentums of its row, an output
+  // reads its gradients
+  return internal::traceKernel(
+      "SparseLarsSGDFused",
+      generateSparseLarsSGDFused<IndexType, OffsetType, DataType>(
+          block_size, prefetch, use_offsets, grad_stride),
+      block_size,
+      sizeof(IndexType) + 2 * block_size * (sizeof(DataType) + sizeof(float)),
+      block_size * sizeof(float) + sizeof(OffsetType));
+}
+
+#define INSTANTIATE_SPMDM_BASE(INDEX_TYPE, OFFSET_TYPE, DATA_TYPE)          \
+  template FBGEMM_API typename SparseAdaGradFusedSignature<                 \
+      INDEX_TYPE,                                                           \
+      OFFSET_TYPE,                                                          \
+      DATA_TYPE>::Type                                                      \
+  GenerateSparseAdaGradFused<INDEX_TYPE, OFFSET_TYPE, DATA_TYPE>(           \
+      int block_size, int prefetch, bool use_offsets, int grad_stride);      \
+  template FBGEMM_API typename SparseAdamFusedSignature<                    \
+      INDEX_TYPE,                                                           \
+      OFFSET_TYPE,                                                          \
+      DATA_TYPE>::Type                                                      \
+  GenerateSparseAdamFused<INDEX_TYPE, OFFSET_TYPE, DATA_TYPE>(              \
+      int block_size,                                                       \
+      bool rowwise,                                                         \
+      int prefetch,                                                         \
+      bool use_offsets,                                                     \
+      int grad_stride);                                                     \
+  template FBGEMM_API typename SparseAdamFusedSignature<                    \
+      INDEX_TYPE,                                                           \
+      OFFSET_TYPE,                                                          \
+      DATA_TYPE>::Type                                                      \
+  GenerateSparseLambFused<INDEX_TYPE, OFFSET_TYPE, DATA_TYPE>(              \
+      int block_size,                                                       \
+      bool rowwise,                                                         \
+      int prefetch,                                                         \
+      bool use_offsets,                                                     \
+      int grad_stride);                                                     \
+  template FBGEMM_API typename SparseLarsSGDFusedSignature<                 \
+      INDEX_TYPE,                                                           \
+      OFFSET_TYPE,                                                          \
+      DATA_TYPE>::Type                                                      \
+  GenerateSparseLarsSGDFused<INDEX_TYPE, OFFSET_TYPE, DATA_TYPE>(           \
+      int block_size, int prefetch, bool use_offsets, int grad_stride);
+
+#define INSTANTIATE_SPMDM_OFFSET_T(INDEX_TYPE, DATA_TYPE)     \
+  INSTANTIATE_SPMDM_BASE(INDEX_TYPE, std::int32_t, DATA_TYPE) \
+  INSTANTIATE_SPMDM_BASE(INDEX_TYPE, std::int64_t, DATA_TYPE)
+
+#define INSTANTIATE_SPMDM_INDEX_T(DATA_TYPE)          \
+  INSTANTIATE_SPMDM_OFFSET_T(std::int32_t, DATA_TYPE) \
+  INSTANTIATE_SPMDM_OFFSET_T(std::int64_t, DATA_TYPE)
+
+INSTANTIATE_SPMDM_INDEX_T(float)
+INSTANTIATE_SPMDM_INDEX_T(float16)
+
+#undef INSTANTIATE_SPMDM_INDEX_T
+#undef INSTANTIATE_SPMDM_OFFSET_T
+#undef INSTANTIATE_SPMDM_BASE
+
+} // namespace fbgemm
@@ -0,0 +1,494 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#define FBGEMM_EXPORTS
+#include <immintrin.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "./MaskAvx2.h"
+#include "fbgemm/FbgemmEmbedding.h"
+#include "fbgemm/Types.h"
+
+namespace fbgemm {
+namespace internal {
+
+namespace {
+
+constexpr int VLEN = 8;
+
+// Loads and stores of the first n <= VLEN lanes, mask selecting them
+inline __m256 loadPartial(const float* p, int n, __m256i mask) {
+  return n == VLEN ? _mm256_loadu_ps(p) : _mm256_maskload_ps(p, mask);
+}
+
+inline void storePartial(float* p, __m256 v, int n, __m256i mask) {
+  if (n == VLEN) {
+    _mm256_storeu_ps(p, v);
+  } else {
+    _mm256_maskstore_ps(p, mask, v);
+  }
+}
+
+template <typename DataType>
+inline __m256 loadWeights(const DataType* w, int n, __m256i mask) {
+  if constexpr (std::is_same_v<DataType, float16>) {
+    if (n == VLEN) {
+      return _mm256_cvtph_ps(
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(w)));
+    }
+    // No AVX2 masked load/store for 16 bits
+    DataType buf[VLEN] = {};
+    std::memcpy(buf, w, n * sizeof(DataType));
+    return _mm256_cvtph_ps(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf)));
+  } else {
+    return loadPartial(w, n, mask);
+  }
+}
+
+template <typename DataType>
+inline void storeWeights(DataType* w, __m256 w_v, int n, __m256i mask) {
+  if constexpr (std::is_same_v<DataType, float16>) {
+    __m128i w_ph = _mm256_cvtps_ph(w_v, _MM_FROUND_TO_NEAREST_INT);
+    if (n == VLEN) {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(w), w_ph);
+    } else {
+      DataType buf[VLEN];
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(buf), w_ph);
+      std::memcpy(w, buf, n * sizeof(DataType));
+    }
+  } else {
+    storePartial(w, w_v, n, mask);
+  }
+}
+
+inline float reduceAdd(__m256 v) {
+  __m128 sum =
+      _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+  sum = _mm_add_ss(sum, _mm_movehdup_ps(sum));
+  return _mm_cvtss_f32(sum);
+}
+
+// Sum of the squares of p[0, n)
+inline float sumSquares(const float* p, int64_t n, __m256i mask) {
+  __m256 sum_v = _mm256_setzero_ps();
+  for (int64_t j = 0; j < n; j += VLEN) {
+    __m256 v = loadPartial(p + j, std::min<int64_t>(VLEN, n - j), mask);
+    sum_v = _mm256_add_ps(sum_v, _mm256_mul_ps(v, v));
+  }
+  return reduceAdd(sum_v);
+}
+
+inline void prefetchBytes(const void* p, int64_t bytes) {
+  constexpr int CACHE_LINE_LEN = 64;
+  const char* c = static_cast<const char*>(p);
+  for (int64_t b = 0; b < bytes; b += CACHE_LINE_LEN) {
+    _mm_prefetch(c + b, _MM_HINT_T0);
+  }
+}
+
+// Calls update(idx, g_) for every index of every bag, with the gradient of
+// its bag, and prefetch(idx) prefetch indices ahead. Returns false on out of
+// bound lengths or indices.
+template <
+    typename IndexType,
+    typename OffsetType,
+    typename Update,
+    typename Prefetch>
+inline bool forEachIndex(
+    int64_t output_size,
+    int64_t index_size,
+    int64_t data_size,
+    const float* g,
+    const IndexType* indices,
+    const OffsetType* offsets_or_lengths,
+    bool use_offsets,
+    int64_t grad_stride,
+    int prefetch,
+    const Update& update,
+    const Prefetch& prefetchRow) {
+  int64_t current = 0;
+  for (int64_t m = 0; m < output_size; ++m) {
+    int len = use_offsets ? offsets_or_lengths[m + 1] - offsets_or_lengths[m]
+                          : offsets_or_lengths[m];
+    if (current + len > index_size) {
+      return false;
+    }
+    const float* g_ = g + m * grad_stride;
+    for (int i = 0; i < len; ++i, ++current) {
+      int64_t idx = indices[current];
+      if (idx < 0 || idx >= data_size) {
+        return false;
+      }
+      if (prefetch && current + prefetch < index_size) {
+        int64_t idx_pref = indices[current + prefetch];
+        if (idx_pref >= 0 && idx_pref < data_size) {
+          prefetchRow(idx_pref);
+        }
+      }
+      update(idx, g_, m);
+    }
+  }
+  return current == index_size;
+}
+
+} // namespace
+
+template <typename DataType, typename IndexType, typename OffsetType>
+bool SparseAdaGradFused_avx2(
+    int64_t block_size,
+    int64_t output_size,
+    int64_t index_size,
+    int64_t data_size,
+    DataType* w,
+    const float* g,
+    float* h,
+    const IndexType* indices,
+    const OffsetType* offsets_or_lengths,
+    float epsilon,
+    float lr,
+    bool use_offsets,
+    int64_t grad_stride,
+    int prefetch) {
+  const int remainder = block_size % VLEN;
+  const __m256i mask_v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+      &avx2_ps_or_epi32_combined_mask[(VLEN - remainder) % VLEN]));
+  const __m256 epsilon_v = _mm256_set1_ps(epsilon);
+  const __m256 lr_v = _mm256_set1_ps(lr);
+
+  return forEachIndex(
+      output_size,
+      index_size,
+      data_size,
+      g,
+      indices,
+      offsets_or_lengths,
+      use_offsets,
+      grad_stride,
+      prefetch,
+      [&](int64_t idx, const float* g_, int64_t) {
+        // h += g * g; w += lr * g / (sqrt(h) + epsilon)
+        float* h_ = h + idx * block_size;
+        DataType* w_ = w + idx * block_size;
+        for (int64_t j = 0; j < block_size; j += VLEN) {
+          const int n = std::min<int64_t>(VLEN, block_size - j);
+          __m256 g_v = loadPartial(g_ + j, n, mask_v);
+          __m256 h_v = _mm256_add_ps(
+              loadPartial(h_ + j, n, mask_v), _mm256_mul_ps(g_v, g_v));
+          storePartial(h_ + j, h_v, n, mask_v);
+          __m256 step_v = _mm256_div_ps(
+              _mm256_mul_ps(lr_v, g_v),
+              _mm256_add_ps(_mm256_sqrt_ps(h_v), epsilon_v));
+          storeWeights(
+              w_ + j,
+              _mm256_add_ps(loadWeights(w_ + j, n, mask_v), step_v),
+              n,
+              mask_v);
+        }
+      },
+      [&](int64_t idx) {
+        prefetchBytes(w + idx * block_size, block_size * sizeof(DataType));
+        prefetchBytes(h + idx * block_size, block_size * sizeof(float));
+      });
+}
+
+template <typename DataType, typename IndexType, typename OffsetType>
+bool SparseAdamFused_avx2(
+    bool lamb,
+    bool rowwise,
+    int64_t block_size,
+    int64_t output_size,
+    int64_t index_size,
+    int64_t data_size,
+    DataType* w,
+    const float* g,
+    float* momentum1,
+    float* momentum2,
+    const IndexType* indices,
+    const OffsetType* offsets_or_lengths,
+    float learning_rate,
+    float eps,
+    float beta1,
+    float beta2,
+    float weight_decay,
+    int64_t iter,
+    bool use_offsets,
+    int64_t grad_stride,
+    int prefetch) {
+  const int remainder = block_size % VLEN;
+  const __m256i mask_v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+      &avx2_ps_or_epi32_combined_mask[(VLEN - remainder) % VLEN]));
+  const float bias_correction2 = 1.0f - std::pow(beta2, iter);
+  const __m256 bias_correction1_v =
+      _mm256_set1_ps(1.0f - std::pow(beta1, iter));
+  const __m256 bias_correction2_v = _mm256_set1_ps(bias_correction2);
+  const __m256 eps_v = _mm256_set1_ps(eps);
+  const __m256 beta1_v = _mm256_set1_ps(beta1);
+  const __m256 one_minus_beta1_v = _mm256_set1_ps(1.0f - beta1);
+  const __m256 beta2_v = _mm256_set1_ps(beta2);
+  const __m256 one_minus_beta2_v = _mm256_set1_ps(1.0f - beta2);
+  const __m256 weight_decay_v = _mm256_set1_ps(weight_decay);
+  const __m256 lr_v = _mm256_set1_ps(learning_rate);
+
+  // Adam steps of the current row for LAMB
+  std::vector<float> r(lamb ? block_size : 0);
+  // Mean of g * g of the current bag for rowwise
+  int64_t g_avg_square_bag = -1;
+  float g_avg_square = 0.0f;
+
+  return forEachIndex(
+      output_size,
+      index_size,
+      data_size,
+      g,
+      indices,
+      offsets_or_lengths,
+      use_offsets,
+      grad_stride,
+      prefetch,
+      [&](int64_t idx, const float* g_, int64_t bag) {
+        DataType* w_ = w + idx * block_size;
+        float* m1_ = momentum1 + idx * block_size;
+        float* m2_ = momentum2 + (rowwise ? idx : idx * block_size);
+        __m256 row_denom_v = _mm256_setzero_ps();
+        if (rowwise) {
+          if (g_avg_square_bag != bag) {
+            g_avg_square = sumSquares(g_, block_size, mask_v) / block_size;
+            g_avg_square_bag = bag;
+          }
+          float v = beta2 * m2_[0] + (1.0f - beta2) * g_avg_square;
+          m2_[0] = v;
+          row_denom_v = _mm256_set1_ps(std::sqrt(v / bias_correction2) + eps);
+        }
+
+        __m256 weight_sum_sq_v = _mm256_setzero_ps();
+        __m256 r_sum_sq_v = _mm256_setzero_ps();
+        for (int64_t j = 0; j < block_size; j += VLEN) {
+          const int n = std::min<int64_t>(VLEN, block_size - j);
+          __m256 g_v = loadPartial(g_ + j, n, mask_v);
+          __m256 m1_v = _mm256_add_ps(
+              _mm256_mul_ps(beta1_v, loadPartial(m1_ + j, n, mask_v)),
+              _mm256_mul_ps(one_minus_beta1_v, g_v));
+          storePartial(m1_ + j, m1_v, n, mask_v);
+          __m256 denom_v = row_denom_v;
+          if (!rowwise) {
+            __m256 m2_v = _mm256_add_ps(
+                _mm256_mul_ps(beta2_v, loadPartial(m2_ + j, n, mask_v)),
+                _mm256_mul_ps(one_minus_beta2_v, _mm256_mul_ps(g_v, g_v)));
+            storePartial(m2_ + j, m2_v, n, mask_v);
+            denom_v = _mm256_add_ps(
+                _mm256_sqrt_ps(_mm256_div_ps(m2_v, bias_correction2_v)),
+                eps_v);
+          }
+          __m256 w_v = loadWeights(w_ + j, n, mask_v);
+          __m256 r_v = _mm256_add_ps(
+              _mm256_div_ps(
+                  _mm256_div_ps(m1_v, bias_correction1_v), denom_v),
+              _mm256_mul_ps(weight_decay_v, w_v));
+          if (lamb) {
+            // The lanes past n are zero in w_v and r_v
+            storePartial(r.data() + j, r_v, n, mask_v);
+            weight_sum_sq_v =
+                _mm256_add_ps(weight_sum_sq_v, _mm256_mul_ps(w_v, w_v));
+            r_sum_sq_v = _mm256_add_ps(r_sum_sq_v, _mm256_mul_ps(r_v, r_v));
+          } else {
+            storeWeights(
+                w_ + j,
+                _mm256_sub_ps(w_v, _mm256_mul_ps(lr_v, r_v)),
+                n,
+                mask_v);
+          }
+        }
+        if (lamb) {
+          const float weight_sum_sq = reduceAdd(weight_sum_sq_v);
+          const float r_sum_sq = reduceAdd(r_sum_sq_v);
+          const float trust_ratio = weight_sum_sq > 0.0f && r_sum_sq > 0.0f
+              ? std::sqrt(weight_sum_sq) / std::sqrt(r_sum_sq)
+              : 1.0f;
+          const __m256 step_v = _mm256_set1_ps(learning_rate * trust_ratio);
+          for (int64_t j = 0; j < block_size; j += VLEN) {
+            const int n = std::min<int64_t>(VLEN, block_size - j);
+            storeWeights(
+                w_ + j,
+                _mm256_sub_ps(
+                    loadWeights(w_ + j, n, mask_v),
+                    _mm256_mul_ps(
+                        step_v, loadPartial(r.data() + j, n, mask_v))),
+                n,
+                mask_v);
+          }
+        }
+      },
+      [&](int64_t idx) {
+        prefetchBytes(w + idx * block_size, block_size * sizeof(DataType));
+        prefetchBytes(momentum1 + idx * block_size, block_size * sizeof(float));
+        if (!rowwise) {
+          prefetchBytes(
+              momentum2 + idx * block_size, block_size * sizeof(float));
+        }
+      });
+}
+
+template <typename DataType, typename IndexType, typename OffsetType>
+bool SparseLarsSGDFused_avx2(
+    int64_t block_size,
+    int64_t output_size,
+    int64_t index_size,
+    int64_t data_size,
+    DataType* w,
+    const float* g,
+    float* momentum1,
+    const IndexType* indices,
+    const OffsetType* offsets_or_lengths,
+    float learning_rate,
+    float eta,
+    float momentum,
+    float weight_decay,
+    bool use_offsets,
+    int64_t grad_stride,
+    int prefetch) {
+  const int remainder = block_size % VLEN;
+  const __m256i mask_v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(
+      &avx2_ps_or_epi32_combined_mask[(VLEN - remainder) % VLEN]));
+  const __m256 momentum_v = _mm256_set1_ps(momentum);
+  const __m256 weight_decay_v = _mm256_set1_ps(weight_decay);
+
+  // Norm of the gradient of the current bag
+  int64_t grad_norm_bag = -1;
+  float grad_norm = 0.0f;
+
+  return forEachIndex(
+      output_size,
+      index_size,
+      data_size,
+      g,
+      indices,
+      offsets_or_lengths,
+      use_offsets,
+      grad_stride,
+      prefetch,
+      [&](int64_t idx, const float* g_, int64_t bag) {
+        if (grad_norm_bag != bag) {
+          grad_norm = std::sqrt(sumSquares(g_, block_size, mask_v));
+          grad_norm_bag = bag;
+        }
+        DataType* w_ = w + idx * block_size;
+        float* m1_ = momentum1 + idx * block_size;
+
+        __m256 weight_sum_sq_v = _mm256_setzero_ps();
+        for (int64_t j = 0; j < block_size; j += VLEN) {
+          const int n = std::min<int64_t>(VLEN, block_size - j);
+          __m256 w_v = loadWeights(w_ + j, n, mask_v);
+          weight_sum_sq_v =
+              _mm256_add_ps(weight_sum_sq_v, _mm256_mul_ps(w_v, w_v));
+        }
+        const float weight_norm = std::sqrt(reduceAdd(weight_sum_sq_v));
+        const __m256 adjusted_lr_v = _mm256_set1_ps(
+            weight_norm > 0.0f && grad_norm > 0.0f
+                ? learning_rate * eta * weight_norm /
+                    (grad_norm + weight_decay * weight_norm)
+                : learning_rate);
+
+        for (int64_t j = 0; j < block_size; j += VLEN) {
+          const int n = std::min<int64_t>(VLEN, block_size - j);
+          __m256 w_v = loadWeights(w_ + j, n, mask_v);
+          __m256 m1_v = _mm256_add_ps(
+              _mm256_mul_ps(momentum_v, loadPartial(m1_ + j, n, mask_v)),
+              _mm256_mul_ps(
+                  adjusted_lr_v,
+                  _mm256_add_ps(
+                      loadPartial(g_ + j, n, mask_v),
+                      _mm256_mul_ps(weight_decay_v, w_v))));
+          storePartial(m1_ + j, m1_v, n, mask_v);
+          storeWeights(w_ + j, _mm256_sub_ps(w_v, m1_v), n, mask_v);
+        }
+      },
+      [&](int64_t idx) {
+        prefetchBytes(w + idx * block_size, block_size * sizeof(DataType));
+        prefetchBytes(momentum1 + idx * block_size, block_size * sizeof(float));
+      });
+}
+
+#define INSTANTIATE_SPMDM_BASE(DATA_TYPE, INDEX_TYPE, OFFSET_TYPE) \
+  template FBGEMM_API bool SparseAdaGradFused_avx2(                \
+      int64_t block_size,                                          \
+      int64_t output_size,                                         \
+      int64_t index_size,                                          \
+      int64_t data_size,                                           \
+      DATA_TYPE* w,                                                \
+      const float* g,                                              \
+      float* h,                                                    \
+      const INDEX_TYPE* indices,                                   \
+      const OFFSET_TYPE* offsets_or_lengths,                       \
+      float epsilon,                                               \
+      float lr,                                                    \
+      bool use_offsets,                                            \
+      int64_t grad_stride,                                         \
+      int prefetch);                                               \
+  template FBGEMM_API bool SparseAdamFused_avx2(                   \
+      bool lamb,                                                   \
+      bool rowwise,                                                \
+      int64_t block_size,                                          \
+      int64_t output_size,                                         \
+      int64_t index_size,                                          \
+      int64_t data_size,                                           \
+      DATA_TYPE* w,                                                \
+      const float* g,                                              \
+      float* momentum1,                                            \
+      float* momentum2,                                            \
+      const INDEX_TYPE* indices,                                   \
+      const OFFSET_TYPE* offsets_or_lengths,                       \
+      float learning_rate,                                         \
+      float eps,                                                   \
+      float beta1,                                                 \
+      float beta2,                                                 \
+      float weight_decay,                                          \
+      int64_t iter,                                                \
+      bool use_offsets,                                            \
+      int64_t grad_stride,                                         \
+      int prefetch);                                               \
+  template FBGEMM_API bool SparseLarsSGDFused_avx2(                \
+      int64_t block_size,                                          \
+      int64_t output_size,                                         \
+      int64_t index_size,                                          \
+      int64_t data_size,                                           \
+      DATA_TYPE* w,                                                \
+      const float* g,                                              \
+      float* momentum1,                                            \
+      const INDEX_TYPE* indices,                                   \
+      const OFFSET_TYPE* offsets_or_lengths,                       \
+      float learning_rate,                                         \
+      float eta,                                                   \
+      float momentum,                                              \
+      float weight_decay,                                          \
+      bool use_offsets,                                            \
+      int64_t grad_stride,                                         \
+      int prefetch);
+
+#define INSTANTIATE_SPMDM_OFFSET_T(DATA_TYPE, INDEX_TYPE) \
+  INSTANTIATE_SPMDM_BASE(DATA_TYPE, INDEX_TYPE, int32_t)  \
+  INSTANTIATE_SPMDM_BASE(DATA_TYPE, INDEX_TYPE, int64_t)
+
+#define INSTANTIATE_SPMDM_INDEX_T(DATA_TYPE)     \
+  INSTANTIATE_SPMDM_OFFSET_T(DATA_TYPE, int32_t) \
+  INSTANTIATE_SPMDM_OFFSET_T(DATA_TYPE, int64_t)
+
+INSTANTIATE_SPMDM_INDEX_T(float)
+INSTANTIATE_SPMDM_INDEX_T(float16)
+
+#undef INSTANTIATE_SPMDM_INDEX_T
+#undef INSTANTIATE_SPMDM_OFFSET_T
+#undef INSTANTIATE_SPMDM_BASE
+
+} // namespace internal
+} // namespace fbgemm
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+#include <immintrin.h>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+namespace fbgemm {
+
+namespace internal {
+
+// Per thread xoshiro128++ state of the 8 lanes of an AVX2 register, seeded
+// from the thread id as the generators of the JIT'ed rowwise Adagrad.
+inline std::uint32_t* rnd128StateAvx2() {
+  alignas(32) static thread_local std::uint32_t state[4 * 8];
+  static thread_local bool initialized = false;
+  if (!initialized) {
+    // Splitmix64: http://prng.di.unimi.it/splitmix64.c
+    auto rnd128_init_next = [](std::uint64_t& x) {
+      std::uint64_t z = (x += 0x9e3779b97f4a7c15);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+      return z ^ (z >> 31);
+    };
+    std::uint64_t h0 = std::hash<std::thread::id>{}(std::this_thread::get_id());
+    for (int i = 0; i < 4; ++i) {
+      state[i * 8] = rnd128_init_next(h0);
+      std::uint64_t h1 = state[i * 8];
+      for (int v = 1; v < 8; ++v) {
+        state[i * 8 + v] = rnd128_init_next(h1);
+      }
+    }
+    initialized = true;
+  }
+  return state;
+}
+
+// Stochastic rounding of 8 floats at a time to float16 or bfloat16: a value
+// is rounded up with the probability of its distance to the 16 bit value
+// below, which makes the rounding unbiased, by adding random bits below the
+// kept mantissa before truncating. Infinities and NaNs are kept as is.
+//
+// The generator state of the calling thread is held in registers for the
+// lifetime of the object, so each thread must use at most one object at a
+// time.
+class StochasticRoundingAvx2 {
+ public:
+  StochasticRoundingAvx2() : state_(rnd128StateAvx2()) {
+    s0_ = _mm256_load_si256(reinterpret_cast<const __m256i*>(state_));
+    s1_ = _mm256_load_si256(reinterpret_cast<const __m256i*>(state_ + 8));
+    s2_ = _mm256_load_si256(reinterpret_cast<const __m256i*>(state_ + 16));
+    s3_ = _mm256_load_si256(reinterpret_cast<const __m256i*>(state_ + 24));
+  }
+
+  ~StochasticRoundingAvx2() {
+    _mm256_store_si256(reinterpret_cast<__m256i*>(state_), s0_);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(state_ + 8), s1_);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(state_ + 16), s2_);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(state_ + 24), s3_);
+  }
+
+  StochasticRoundingAvx2(const StochasticRoundingAvx2&) = delete;
+  StochasticRoundingAvx2& operator=(const StochasticRoundingAvx2&) = delete;
+
+  // 8 random 32 bit integers, xoshiro128++
+  // http://prng.di.unimi.it/xoshiro128plusplus.c
+  __m256i next() {
+    const __m256i result =
+        _mm256_add_epi32(rotl(_mm256_add_epi32(s0_, s3_), 7), s0_);
+    const __m256i t = _mm256_slli_epi32(s1_, 9);
+    s2_ = _mm256_xor_si256(s2_, s0_);
+    s3_ = _mm256_xor_si256(s3_, s1_);
+    s1_ = _mm256_xor_si256(s1_, s2_);
+    s0_ = _mm256_xor_si256(s0_, s3_);
+    s2_ = _mm256_xor_si256(s2_, t);
+    s3_ = rotl(s3_, 11);
+    return result;
+  }
+
+  // Float16 keeps 10 of the 23 bits of the mantissa. Values below the
+  // normal range of float16, whose ulp is larger, are rounded up less often
+  // than they should.
+  __m128i toFloat16(__m256 x) {
+    return _mm256_cvtps_ph(
+        _mm256_castsi256_ps(addRandomBits(x, 13)),
+        (_MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC));
+  }
+
+  // Bfloat16 keeps the upper 16 bits of the float
+  __m128i toBfloat16(__m256 x) {
+    const __m256i y = _mm256_srli_epi32(addRandomBits(x, 16), 16);
+    return _mm_packus_epi32(
+        _mm256_castsi256_si128(y), _mm256_extracti128_si256(y, 1));
+  }
+
+ private:
+  static __m256i rotl(__m256i x, int k) {
+    return _mm256_or_si256(
+        _mm256_slli_epi32(x, k), _mm256_srli_epi32(x, 32 - k));
+  }
+
+  // x with num_bits random bits added to the bits of its mantissa, except
+  // for infinities and NaNs
+  __m256i addRandomBits(__m256 x, int num_bits) {
+    const __m256i x_i = _mm256_castps_si256(x);
+    const __m256i exponent_mask = _mm256_set1_epi32(0x7f800000);
+    const __m256i not_finite = _mm256_cmpeq_epi32(
+        _mm256_and_si256(x_i, exponent_mask), exponent_mask);
+    const __m256i r = _mm256_andnot_si256(
+        not_finite, _mm256_srli_epi32(next(), 32 - num_bits));
+    return _mm256_add_epi32(x_i, r);
+  }
+
+  std::uint32_t* state_;
+  __m256i s0_, s1_, s2_, s3_;
+};
+
+} // namespace internal
+
+} // namespace fbgemm
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+
+#include "fbgemm/FbgemmTrace.h"
+
+namespace fbgemm {
+
+namespace internal {
+
+extern std::atomic<bool> trace_enabled;
+
+void emitTraceEvent(const TraceEvent& event);
+
+/**
+ * Reports the lifetime of the object as a call of kernel to the trace
+ * callback, if one was installed when it was created.
+ */
+class TraceScope {
+ public:
+  static constexpr int kMaxShapeSize = 8;
+
+  TraceScope(
+      const char* kernel,
+      std::int64_t bytes,
+      int thread_id,
+      int num_threads,
+      std::initializer_list<std::int64_t> shape) {
+    if (trace_enabled.load(std::memory_order_relaxed)) {
+      event_.kernel = kernel;
+      event_.shape = shape_;
+      event_.shape_size = std::min<int>(shape.size(), kMaxShapeSize);
+      std::copy_n(shape.begin(), event_.shape_size, shape_);
+      event_.bytes = bytes;
+      event_.thread_id = thread_id;
+      event_.num_threads = num_threads;
+      start_ = std::chrono::steady_clock::now();
+    }
+  }
+
+  ~TraceScope() {
+    if (event_.kernel != nullptr) {
+      const auto end = std::chrono::steady_clock::now();
+      event_.start_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            start_.time_since_epoch())
+                            .count();
+      event_.duration_ns =
+          std::chrono::duration_cast<std::chrono::nanoseconds>(end - start_)
+              .count();
+      emitTraceEvent(event_);
+    }
+  }
+
+  TraceScope(const TraceScope&) = delete;
+  TraceScope& operator=(const TraceScope&) = delete;
+
+ private:
+  TraceEvent event_{};
+  std::int64_t shape_[kMaxShapeSize];
+  std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace internal
+
+} // namespace fbgemm
+
+#define FBGEMM_TRACE_CONCAT_(a, b) a##b
+#define FBGEMM_TRACE_CONCAT(a, b) FBGEMM_TRACE_CONCAT_(a, b)
+
+/**
+ * Traces the rest of the enclosing scope as a call of kernel, with the
+ * problem sizes given after num_threads. The arguments are not evaluated
+ * when tracing is compiled out.
+ */
+#ifdef FBGEMM_DISABLE_TRACING
+#define FBGEMM_TRACE_SCOPE(kernel, bytes, thread_id, num_threads, ...)
+#else
+#define FBGEMM_TRACE_SCOPE(kernel, bytes, thread_id, num_threads, ...) \
+  ::fbgemm::internal::TraceScope FBGEMM_TRACE_CONCAT(                  \
+      fbgemm_trace_scope_, __LINE__)(                                  \
+      kernel, bytes, thread_id, num_threads, {__VA_ARGS__})
+#endif
+
+namespace fbgemm {
+
+namespace internal {
+
+/**
+ * Wraps a generated kernel whose first arguments are output_size,
+ * index_size and data_size (embedding lookups and fused optimizers) to trace
+ * its calls. bytes_per_index and bytes_per_output estimate the memory
+ * traffic of an index and of an output row. The kernel is returned
+ * unwrapped when no trace callback is installed at generation time, so
+ * untraced lookups keep a single indirect call.
+ */
+template <typename R, typename... Args>
+std::function<R(std::int64_t, std::int64_t, std::int64_t, Args...)>
+traceKernel(
+    [[maybe_unused]] const char* kernel_name,
+    std::function<R(std::int64_t, std::int64_t, std::int64_t, Args...)>
+        kernel,
+    [[maybe_unused]] std::int64_t block_size,
+    [[maybe_unused]] std::int64_t bytes_per_index,
+    [[maybe_unused]] std::int64_t bytes_per_output) {
+#ifdef FBGEMM_DISABLE_TRACING
+  return kernel;
+#else
+  if (!trace_enabled.load(std::memory_order_relaxed)) {
+    return kernel;
+  }
+  return [=](std::int64_t output_size,
+             std::int64_t index_size,
+             std::int64_t data_size,
+             Args... args) {
+    FBGEMM_TRACE_SCOPE(
+        kernel_name,
+        index_size * bytes_per_index + output_size * bytes_per_output,
+        0,
+        1,
+        output_size,
+        index_size,
+        data_size,
+        block_size);
+    return kernel(output_size, index_size, data_size, args...);
+  };
+#endif
+}
+
+} // namespace internal
+
+} // namespace fbgemm
@@ -8,7 +8,13 @@
 
 #define FBGEMM_EXPORTS
 #include "./TransposeUtils.h"
+#if defined(__x86_64__) || defined(__i386__) || \
+    (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
+#include <immintrin.h>
+#endif
+#include <algorithm>
 #include <cstring>
+#include <vector>
 #include "fbgemm/Utils.h"
 
 namespace fbgemm {
@@ -57,6 +63,152 @@ void transpose_simd(
   }
 }
 
+namespace {
+
+// Tile side in elements: a tile of the input and of the output take at most
+// 128 KB together, which leaves room in L2 for the next tile.
+template <typename T>
+constexpr int64_t transposeTileSize() {
+  return sizeof(T) == 1 ? 256 : 128;
+}
+
+// Outputs at least this large are written with non-temporal stores
+constexpr int64_t kNonTemporalTransposeBytes = 16 * 1024 * 1024;
+
+// Copies the rows x cols contiguous tile buf to dst, with non-temporal stores
+// for the 16-byte aligned part of each row.
+template <typename T>
+void stream_tile(
+    int64_t rows,
+    int64_t cols,
+    const T* buf,
+    T* dst,
+    int64_t ld_dst) {
+  const int64_t row_bytes = cols * sizeof(T);
+  for (int64_t r = 0; r < rows; ++r) {
+    const char* src_row = reinterpret_cast<const char*>(buf + r * cols);
+    char* dst_row = reinterpret_cast<char*>(dst + r * ld_dst);
+    int64_t b = 0;
+#if defined(__x86_64__) || defined(__i386__) || \
+    (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
+    const int64_t head = std::min<int64_t>(
+        row_bytes, (16 - reinterpret_cast<uintptr_t>(dst_row) % 16) % 16);
+    memcpy(dst_row, src_row, head);
+    for (b = head; b + 16 <= row_bytes; b += 16) {
+      _mm_stream_si128(
+          reinterpret_cast<__m128i*>(dst_row + b),
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(src_row + b)));
+    }
+#endif
+    memcpy(dst_row + b, src_row + b, row_bytes - b);
+  }
+}
+
+} // namespace
+
+template <typename T>
+void transpose_simd_parallel(
+    int64_t M,
+    int64_t N,
+    const T* src,
+    int64_t ld_src,
+    T* dst,
+    int64_t ld_dst,
+    int thread_id,
+    int num_threads) {
+  if (M == 0 || N == 0) {
+    return;
+  }
+  constexpr int64_t kTile = transposeTileSize<T>();
+  const int64_t tiles_m = (M + kTile - 1) / kTile;
+  const int64_t tiles_n = (N + kTile - 1) / kTile;
+  int64_t t_begin, t_end;
+  fbgemmPartition1D(thread_id, num_threads, tiles_m * tiles_n, t_begin, t_end);
+  if (t_begin >= t_end) {
+    return;
+  }
+
+  const bool streaming =
+      static_cast<int64_t>(sizeof(T)) * M * N >= kNonTemporalTransposeBytes;
+  std::vector<T> buf(streaming ? kTile * kTile : 0);
+  for (int64_t t = t_begin; t < t_end; ++t) {
+    // Consecutive tiles go down the columns of src, i.e. along the rows of
+    // dst, so a thread writes a contiguous band of the output.
+    const int64_t i = t % tiles_m * kTile;
+    const int64_t j = t / tiles_m * kTile;
+    const int64_t tile_m = std::min(kTile, M - i);
+    const int64_t tile_n = std::min(kTile, N - j);
+    if (streaming) {
+      transpose_simd<T>(
+          tile_m, tile_n, src + i * ld_src + j, ld_src, buf.data(), tile_m);
+      stream_tile<T>(tile_n, tile_m, buf.data(), dst + j * ld_dst + i, ld_dst);
+    } else {
+      transpose_simd<T>(
+          tile_m,
+          tile_n,
+          src + i * ld_src + j,
+          ld_src,
+          dst + j * ld_dst + i,
+          ld_dst);
+    }
+  }
+#if defined(__x86_64__) || defined(__i386__) || \
+    (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
+  if (streaming) {
+    _mm_sfence();
+  }
+#endif
+}
+
+template <typename T>
+void transpose_simd_batched(
+    int64_t batch_size,
+    int64_t M,
+    int64_t N,
+    const T* src,
+    int64_t ld_src,
+    int64_t stride_src,
+    T* dst,
+    int64_t ld_dst,
+    int64_t stride_dst,
+    int thread_id,
+    int num_threads) {
+  int64_t b_begin, b_end;
+  fbgemmPartition1D(thread_id, num_threads, batch_size, b_begin, b_end);
+  if (M == 0 || N == 0 || b_begin >= b_end) {
+    return;
+  }
+  src += b_begin * stride_src;
+  dst += b_begin * stride_dst;
+  const int64_t count = b_end - b_begin;
+  // The same shortcut as transpose_simd, taken once for the batch
+  if ((M == 1 && ld_dst == 1) || (N == 1 && ld_src == 1)) {
+    for (int64_t b = 0; b < count; ++b) {
+      if (dst + b * stride_dst != src + b * stride_src) {
+        memcpy(dst + b * stride_dst, src + b * stride_src, sizeof(T) * M * N);
+      }
+    }
+    return;
+  }
+  static const auto iset = fbgemmInstructionSet();
+  if (isZmm(iset)) {
+    for (int64_t b = 0; b < count; ++b) {
+      internal::transpose_avx512<T>(
+          M, N, src + b * stride_src, ld_src, dst + b * stride_dst, ld_dst);
+    }
+  } else if (isYmm(iset)) {
+    for (int64_t b = 0; b < count; ++b) {
+      internal::transpose_avx2<T>(
+          M, N, src + b * stride_src, ld_src, dst + b * stride_dst, ld_dst);
+    }
+  } else {
+    for (int64_t b = 0; b < count; ++b) {
+      transpose_ref<T>(
+          M, N, src + b * stride_src, ld_src, dst + b * stride_dst, ld_dst);
+    }
+  }
+}
+
 template void transpose_ref<float>(
     int64_t M,
     int64_t N,
@@ -104,4 +256,40 @@ template FBGEMM_API void transpose_simd<uint16_t>(
     int64_t ld_src,
     uint16_t* dst,
     int64_t ld_dst);
+
+#define INSTANTIATE_TRANSPOSE_PARALLEL(T)              \
+  template FBGEMM_API void transpose_simd_parallel<T>( \
+      int64_t M,                                       \
+      int64_t N,                                       \
+      const T* src,                                    \
+      int64_t ld_src,                                  \
+      T* dst,                                          \
+      int64_t ld_dst,                                  \
+      int thread_id,                                   \
+      int num_threads);
+
+INSTANTIATE_TRANSPOSE_PARALLEL(float)
+INSTANTIATE_TRANSPOSE_PARALLEL(uint16_t)
+INSTANTIATE_TRANSPOSE_PARALLEL(uint8_t)
+
+#define INSTANTIATE_TRANSPOSE_BATCHED(T)              \
+  template FBGEMM_API void transpose_simd_batched<T>( \
+      int64_t batch_size,                             \
+      int64_t M,                                      \
+      int64_t N,                                      \
+      const T* src,                                   \
+      int64_t ld_src,                                 \
+      int64_t stride_src,                             \
+      T* dst,                                         \
+      int64_t ld_dst,                                 \
+      int64_t stride_dst,                             \
+      int thread_id,                                  \
+      int num_threads);
+
+INSTANTIATE_TRANSPOSE_BATCHED(float)
+INSTANTIATE_TRANSPOSE_BATCHED(uint16_t)
+INSTANTIATE_TRANSPOSE_BATCHED(uint8_t)
+
+#undef INSTANTIATE_TRANSPOSE_BATCHED
+#undef INSTANTIATE_TRANSPOSE_PARALLEL
 } // namespace fbgemm
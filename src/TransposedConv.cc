@@ -0,0 +1,356 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#define FBGEMM_EXPORTS
+#include <cpuinfo.h>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept> // for logic_error
+#include <vector>
+#include "fbgemm/Fbgemm.h"
+
+namespace fbgemm {
+
+namespace {
+
+// Bytes of the gathered A matrix per GEMM. It is packed block by block by
+// fbgemmPacked, so it should stay in L2.
+constexpr int kBandBytes = 256 * 1024;
+
+// The first output index of phase q, i.e., with (o + pad) % stride == q.
+int phaseStart(int q, int pad, int stride) {
+  return ((q - pad) % stride + stride) % stride;
+}
+
+// The number of output indices below out_dim in the phase starting at start.
+int phaseSize(int start, int out_dim, int stride) {
+  return start < out_dim ? (out_dim - start + stride - 1) / stride : 0;
+}
+
+} // namespace
+
+PackedTransposedConvMatrix::PackedTransposedConvMatrix(
+    const conv_param_t<2>& conv_p,
+    const std::int8_t* smat,
+    const BlockingFactors* blocking_params)
+    : conv_p_(conv_p) {
+  const int G = conv_p.G;
+  const int IC_per_G = conv_p.IC / G;
+  const int OC_per_G = conv_p.OC / G;
+  const int S = conv_p.K[1];
+  const int kernel_dim = conv_p.K[0] * S;
+  const int num_phases = conv_p.stride[0] * conv_p.stride[1];
+
+  taps_.resize(num_phases);
+  packed_.resize(num_phases);
+  skipped_sums_.resize(num_phases);
+  for (int p = 0; p < num_phases; ++p) {
+    const int qh = p / conv_p.stride[1];
+    const int qw = p % conv_p.stride[1];
+    std::vector<bool> in_phase(kernel_dim);
+    for (int r = 0; r < conv_p.K[0]; ++r) {
+      for (int s = 0; s < S; ++s) {
+        in_phase[r * S + s] =
+            (qh - r * conv_p.dilation[0]) % conv_p.stride[0] == 0 &&
+            (qw - s * conv_p.dilation[1]) % conv_p.stride[1] == 0;
+        if (in_phase[r * S + s]) {
+          taps_[p].push_back(r * S + s);
+        }
+      }
+    }
+
+    skipped_sums_[p].assign(conv_p.OC, 0);
+    for (int k = 0; k < conv_p.OC; ++k) {
+      for (int f = 0; f < kernel_dim; ++f) {
+        if (!in_phase[f]) {
+          const std::int8_t* w = smat + (k * kernel_dim + f) * IC_per_G;
+          for (int c = 0; c < IC_per_G; ++c) {
+            skipped_sums_[p][k] += w[c];
+          }
+        }
+      }
+    }
+
+    const int num_taps = taps_[p].size();
+    if (num_taps == 0) {
+      continue;
+    }
+    // G OC/G (taps C/G) layout for the Transpose packing of each group
+    const int K_per_G = num_taps * IC_per_G;
+    std::vector<std::int8_t> phase_weights(conv_p.OC * K_per_G);
+    for (int k = 0; k < conv_p.OC; ++k) {
+      for (int t = 0; t < num_taps; ++t) {
+        std::memcpy(
+            phase_weights.data() + (k * num_taps + t) * IC_per_G,
+            smat + (k * kernel_dim + taps_[p][t]) * IC_per_G,
+            IC_per_G);
+      }
+    }
+    packed_[p] = std::make_shared<PackBMatrix<std::int8_t, std::int32_t>>(
+        matrix_op_t::Transpose,
+        G * K_per_G,
+        OC_per_G,
+        phase_weights.data(),
+        K_per_G,
+        nullptr,
+        G,
+        blocking_params);
+  }
+}
+
+void PackedTransposedConvMatrix::unpack(std::int8_t* origin_buf) const {
+  const int IC_per_G = conv_p_.IC / conv_p_.G;
+  const int kernel_dim = conv_p_.K[0] * conv_p_.K[1];
+  for (int p = 0; p < numPhases(); ++p) {
+    if (!packed_[p]) {
+      continue;
+    }
+    // Each tap is read by exactly one phase.
+    const int num_taps = taps_[p].size();
+    std::vector<std::int8_t> phase_weights(conv_p_.OC * num_taps * IC_per_G);
+    packed_[p]->unpack(phase_weights.data());
+    for (int k = 0; k < conv_p_.OC; ++k) {
+      for (int t = 0; t < num_taps; ++t) {
+        std::memcpy(
+            origin_buf + (k * kernel_dim + taps_[p][t]) * IC_per_G,
+            phase_weights.data() + (k * num_taps + t) * IC_per_G,
+            IC_per_G);
+      }
+    }
+  }
+}
+
+std::size_t PackedTransposedConvMatrix::memoryFootprint() const {
+  std::size_t bytes = 0;
+  for (int p = 0; p < numPhases(); ++p) {
+    if (packed_[p]) {
+      bytes += packed_[p]->memoryFootprint();
+    }
+    bytes += taps_[p].capacity() * sizeof(int) +
+        skipped_sums_[p].capacity() * sizeof(std::int32_t);
+  }
+  return bytes;
+}
+
+template <QuantizationGranularity Q_GRAN, bool FUSE_RELU, typename BIAS_TYPE>
+void fbgemmTransposedConv(
+    const conv_param_t<2>& conv_p,
+    const std::uint8_t* activations,
+    const PackedTransposedConvMatrix& packed_weights,
+    std::uint8_t* out,
+    ReQuantizeOutput<FUSE_RELU, Q_GRAN, BIAS_TYPE>& outProcess,
+    int thread_id,
+    int num_threads,
+    const BlockingFactors* blocking_params) {
+  if (!takeTransposedConvPath<2, std::int32_t>(conv_p) ||
+      packed_weights.numPhases() != conv_p.stride[0] * conv_p.stride[1]) {
+    throw std::logic_error(
+        "[FBGEMM_CONV_ERROR] Convolution parameters are not supported by "
+        "fbgemmTransposedConv");
+  }
+  if (!cpuinfo_initialize()) {
+    throw std::runtime_error("Failed to initialize cpuinfo!");
+  }
+
+  const int IH = conv_p.IN_DIM[0];
+  const int IW = conv_p.IN_DIM[1];
+  const int OH = conv_p.OUT_DIM[0];
+  const int OW = conv_p.OUT_DIM[1];
+  const int IC = conv_p.IC;
+  const int OC = conv_p.OC;
+  const int G = conv_p.G;
+  const int IC_per_G = IC / G;
+  const int OC_per_G = OC / G;
+  const int S = conv_p.K[1];
+  const int kernel_dim = conv_p.K[0] * S;
+  const int stride_h = conv_p.stride[0];
+  const int stride_w = conv_p.stride[1];
+  const int num_phases = packed_weights.numPhases();
+  const std::int32_t A_zero_point = outProcess.getAZeroPoint();
+
+  // Each work item is a band of the output rows of one phase of one image.
+  std::vector<int> band_rows(num_phases), num_bands(num_phases);
+  std::vector<int64_t> first_work(num_phases + 1, 0);
+  for (int p = 0; p < num_phases; ++p) {
+    const int OH_p = phaseSize(
+        phaseStart(p / stride_w, conv_p.pad[0], stride_h), OH, stride_h);
+    const int OW_p = phaseSize(
+        phaseStart(p % stride_w, conv_p.pad[1], stride_w), OW, stride_w);
+    const int K_p =
+        std::max<int>(1, packed_weights.taps(p).size()) * IC_per_G * G;
+    band_rows[p] = std::max(1, kBandBytes / std::max(1, OW_p * K_p));
+    num_bands[p] = OW_p == 0 ? 0 : (OH_p + band_rows[p] - 1) / band_rows[p];
+    first_work[p + 1] = first_work[p] + num_bands[p];
+  }
+
+  int64_t work_begin, work_end;
+  fbgemmPartition1D(
+      thread_id,
+      num_threads,
+      conv_p.MB * first_work[num_phases],
+      work_begin,
+      work_end);
+  if (work_begin >= work_end) {
+    return;
+  }
+
+  bool use_avx2 = false;
+#if CPUINFO_ARCH_X86 || CPUINFO_ARCH_X86_64
+  use_avx2 = fbgemmHasAvx512Support() || fbgemmHasAvx2Support();
+#endif
+
+  std::vector<std::uint8_t> A;
+  std::vector<std::int32_t> C;
+  std::vector<std::int32_t> row_offsets;
+  DoNothing<std::int32_t, std::int32_t> doNothingObj{};
+  memCopy<> memcopyObj(doNothingObj);
+
+  for (int64_t work = work_begin; work < work_end; ++work) {
+    const int n = work / first_work[num_phases];
+    const int64_t phase_work = work % first_work[num_phases];
+    const int p =
+        std::upper_bound(first_work.begin(), first_work.end(), phase_work) -
+        first_work.begin() - 1;
+    const int oh_start = phaseStart(p / stride_w, conv_p.pad[0], stride_h);
+    const int ow_start = phaseStart(p % stride_w, conv_p.pad[1], stride_w);
+    const int OH_p = phaseSize(oh_start, OH, stride_h);
+    const int OW_p = phaseSize(ow_start, OW, stride_w);
+    const int row_begin = (phase_work - first_work[p]) * band_rows[p];
+    const int rows = std::min(band_rows[p], OH_p - row_begin);
+    const int M = rows * OW_p;
+
+    const std::vector<int>& taps = packed_weights.taps(p);
+    const int num_taps = taps.size();
+    const int K_per_G = num_taps * IC_per_G;
+    // Im2col reads zero points for the taps outside of the phase.
+    const std::int32_t skipped_sum =
+        A_zero_point * (kernel_dim - num_taps) * IC_per_G;
+
+    // Gather the A matrix with padding replaced by the zero point, and the
+    // row offsets of each group.
+    A.resize(static_cast<size_t>(M) * G * K_per_G);
+    row_offsets.assign(static_cast<size_t>(G) * M, skipped_sum);
+    for (int i = 0; i < rows; ++i) {
+      const int oh = oh_start + (row_begin + i) * stride_h;
+      for (int j = 0; j < OW_p; ++j) {
+        const int ow = ow_start + j * stride_w;
+        const int m = i * OW_p + j;
+        for (int t = 0; t < num_taps; ++t) {
+          const int ih = (oh + conv_p.pad[0] -
+                          taps[t] / S * conv_p.dilation[0]) /
+              stride_h;
+          const int iw = (ow + conv_p.pad[1] -
+                          taps[t] % S * conv_p.dilation[1]) /
+              stride_w;
+          // The divisions are exact since the tap is in the phase.
+          const bool in_image = ih >= 0 && ih < IH && iw >= 0 && iw < IW;
+          for (int g = 0; g < G; ++g) {
+            std::uint8_t* dst = A.data() +
+                (static_cast<int64_t>(m) * G + g) * K_per_G + t * IC_per_G;
+            if (in_image) {
+              const std::uint8_t* src = activations +
+                  ((static_cast<int64_t>(n) * IH + ih) * IW + iw) * IC +
+                  g * IC_per_G;
+              std::memcpy(dst, src, IC_per_G);
+              std::int32_t sum = 0;
+              for (int c = 0; c < IC_per_G; ++c) {
+                sum += src[c];
+              }
+              row_offsets[g * M + m] += sum;
+            } else {
+              std::memset(dst, A_zero_point, IC_per_G);
+              row_offsets[g * M + m] += A_zero_point * IC_per_G;
+            }
+          }
+        }
+      }
+    }
+
+    C.resize(static_cast<size_t>(M) * OC);
+    if (num_taps > 0) {
+      PackAMatrix<std::uint8_t, std::int32_t> packA(
+          matrix_op_t::NoTranspose,
+          M,
+          G * K_per_G,
+          A.data(),
+          G * K_per_G,
+          nullptr,
+          G,
+          blocking_params);
+      fbgemmPacked(
+          packA,
+          *packed_weights.packedWeights(p),
+          C.data(),
+          C.data(),
+          OC,
+          memcopyObj,
+          0, // thread_id
+          1, // num_threads
+          blocking_params);
+    } else {
+      std::fill(C.begin(), C.end(), 0);
+    }
+    if (A_zero_point) {
+      const std::int32_t* skipped_weights = packed_weights.skippedWeightSums(p);
+      for (int m = 0; m < M; ++m) {
+        for (int k = 0; k < OC; ++k) {
+          C[m * OC + k] += A_zero_point * skipped_weights[k];
+        }
+      }
+    }
+
+    // Requantize each output row of the phase, whose pixels are stride_w
+    // apart.
+    for (int i = 0; i < rows; ++i) {
+      const int oh = oh_start + (row_begin + i) * stride_h;
+      std::uint8_t* out_row =
+          out + ((static_cast<int64_t>(n) * OH + oh) * OW + ow_start) * OC;
+      for (int g = 0; g < G; ++g) {
+        outProcess.setRowOffsets(row_offsets.data() + g * M + i * OW_p);
+        block_type_t block{0, OW_p, g * OC_per_G, OC_per_G};
+        const std::int32_t* C_row = C.data() + i * OW_p * OC + g * OC_per_G;
+        if (use_avx2) {
+          outProcess.template f<inst_set_t::avx2>(
+              out_row, C_row, block, stride_w * OC, OC);
+        } else {
+          outProcess.template f<inst_set_t::anyarch>(
+              out_row, C_row, block, stride_w * OC, OC);
+        }
+      }
+    }
+  }
+}
+
+#define INSTANTIATE_BASE(Q_GRAN, RELU, BIAS_TYPE)                         \
+  template FBGEMM_API void fbgemmTransposedConv<Q_GRAN, RELU, BIAS_TYPE>( \
+      const conv_param_t<2>& conv_p,                                      \
+      const std::uint8_t* activations,                                    \
+      const PackedTransposedConvMatrix& packed_weights,                   \
+      std::uint8_t* out,                                                  \
+      ReQuantizeOutput<RELU, Q_GRAN, BIAS_TYPE>& outProcess,              \
+      int thread_id,                                                      \
+      int num_threads,                                                    \
+      const BlockingFactors* blocking_params);
+
+#define INSTANTIATE_BIAS_T(Q_GRAN, RELU) \
+  INSTANTIATE_BASE(Q_GRAN, RELU, float)  \
+  INSTANTIATE_BASE(Q_GRAN, RELU, std::int32_t)
+
+#define INSTANTIATE_Q_GRANS(RELU)                           \
+  INSTANTIATE_BIAS_T(QuantizationGranularity::TENSOR, RELU) \
+  INSTANTIATE_BIAS_T(QuantizationGranularity::GROUP, RELU)  \
+  INSTANTIATE_BIAS_T(QuantizationGranularity::OUT_CHANNEL, RELU)
+
+INSTANTIATE_Q_GRANS(true)
+INSTANTIATE_Q_GRANS(false)
+
+#undef INSTANTIATE_Q_GRANS
+#undef INSTANTIATE_BIAS_T
+#undef INSTANTIATE_BASE
+
+} // namespace fbgemm
@@ -11,6 +11,7 @@
 #define FBGEMM_EXPORTS
 #include "fbgemm/Utils.h"
 #include <cpuinfo.h>
+#include <atomic>
 #include <cassert>
 #include <cinttypes>
 #include <cmath>
@@ -19,12 +20,18 @@
 #include <iomanip>
 #include <iostream>
 #include <limits>
+#include <mutex>
 #include <new>
 #include <stdexcept>
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
 
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 #ifdef _OPENMP
 #include <omp.h>
 #else
@@ -185,6 +192,9 @@ template void printMatrix<int32_t>(
 namespace {
 inst_set_t g_forced_isa = inst_set_t::anyarch;
 bool g_Avx512_Ymm_enabled = false;
+// Set by FbgemmIsaScope, overrides g_forced_isa on its thread
+thread_local inst_set_t t_scoped_isa = inst_set_t::anyarch;
+std::atomic<std::int64_t> g_zmm_min_work{0};
 
 inst_set_t fbgemmEnvGetIsa() {
   static const char* isa_env = "FBGEMM_ENABLE_INSTRUCTIONS";
@@ -296,11 +306,52 @@ void fbgemmEnableAvx512Ymm(bool flag) {
   g_Avx512_Ymm_enabled = flag;
 }
 
+FbgemmIsaScope::FbgemmIsaScope(inst_set_t isa) : previous_isa_(t_scoped_isa) {
+#ifdef __aarch64__
+  isa = inst_set_t::anyarch;
+#endif
+  t_scoped_isa = isa;
+  // An ISA the CPU does not support keeps the enclosing override, so that
+  // the matrices packed under it keep their blocking.
+  if (isa != inst_set_t::anyarch && fbgemmInstructionSet() != isa) {
+    t_scoped_isa = previous_isa_;
+  }
+}
+
+FbgemmIsaScope::~FbgemmIsaScope() {
+  t_scoped_isa = previous_isa_;
+}
+
+void fbgemmSetZmmMinWork(std::int64_t work) {
+  g_zmm_min_work.store(work, std::memory_order_relaxed);
+}
+
+std::int64_t fbgemmGetZmmMinWork() {
+  return g_zmm_min_work.load(std::memory_order_relaxed);
+}
+
+inst_set_t fbgemmIsaForWork(std::int64_t work) {
+  const inst_set_t isa = fbgemmInstructionSet();
+  if (work >= g_zmm_min_work.load(std::memory_order_relaxed)) {
+    return isa;
+  }
+  // The 256-bit kernels of the same CPU
+  switch (isa) {
+    case inst_set_t::avx512:
+      return inst_set_t::avx512_ymm;
+    case inst_set_t::avx512_vnni:
+      return inst_set_t::avx512_vnni_ymm;
+    default:
+      return isa;
+  }
+}
+
 /**
  * @brief Determine the best available x86 machine ISA to be used for
  *        GEMM kernels.
- *        FBGEMM_ENABLE_AVX512_256 env. or fbgemmForceIsa() are set
- *        forces to specific architecture if supported by the processor.
+ *        FBGEMM_ENABLE_AVX512_256 env., fbgemmForceIsa() or, on the
+ *        calling thread, an FbgemmIsaScope force a specific architecture
+ *        if supported by the processor.
  *        Enforcing on Skylake to AVX2 will execute AVX2 version of the kernel
  *        However, enforcing AVX512-256 on Broadwell will fail, and AVX2 version
  *        of the kernels will be executed.
@@ -311,6 +362,9 @@ inst_set_t fbgemmInstructionSet() {
 
   inst_set_t forced_isa =
       g_forced_isa != inst_set_t::anyarch ? g_forced_isa : env_forced_isa;
+  if (t_scoped_isa != inst_set_t::anyarch) {
+    forced_isa = t_scoped_isa;
+  }
   static const inst_set_t detected_isa = ([]() {
     inst_set_t isa = inst_set_t::anyarch;
     // Check environment
@@ -381,6 +435,32 @@ bool fbgemmHasAvx512VnniSupport() {
   return cpuinfo_has_x86_avx512vnni();
 }
 
+bool fbgemmHasAvx512Bf16Support() {
+  return cpuinfo_has_x86_avx512bf16();
+}
+
+bool fbgemmHasAvx512Fp16Support() {
+  return cpuinfo_has_x86_avx512fp16();
+}
+
+bool fbgemmHasAmxInt8Support() {
+  static const bool supported = []() {
+    if (!cpuinfo_has_x86_amx_tile() || !cpuinfo_has_x86_amx_int8()) {
+      return false;
+    }
+#if defined(__linux__) && defined(__x86_64__)
+    // Linux only saves the tile data on context switches of processes that
+    // asked for it.
+    constexpr int kArchReqXcompPerm = 0x1023;
+    constexpr int kXfeatureXtiledata = 18;
+    return syscall(SYS_arch_prctl, kArchReqXcompPerm, kXfeatureXtiledata) == 0;
+#else
+    return false;
+#endif
+  }();
+  return supported;
+}
+
 bool fbgemmHasArmNeonSupport() {
   return cpuinfo_has_arm_neon();
 }
@@ -389,6 +469,10 @@ bool fbgemmHasArmSve2Support() {
   return cpuinfo_has_arm_sve2();
 }
 
+bool fbgemmHasArmI8mmSupport() {
+  return cpuinfo_has_arm_i8mm();
+}
+
 void fbgemmPartition1D(
     int thread_id,
     int num_threads,
@@ -426,31 +510,102 @@ void fbgemmPartition1DBlocked(
       : std::min(end_block * block_size, total_work);
 }
 
-void* fbgemmAlignedAlloc(
-    size_t align,
-    size_t size,
-    bool raiseException /*=false*/) {
-  void* aligned_mem = nullptr;
-  int ret;
-#ifdef _MSC_VER
-  aligned_mem = _aligned_malloc(size, align);
-  ret = 0;
-#else
-  ret = posix_memalign(&aligned_mem, align, size);
+namespace {
+
+// Default thread pool: one chunk per OpenMP thread, or a single chunk on the
+// calling thread in builds without OpenMP and in nested parallel regions.
+class DefaultThreadPool final : public ThreadPool {
+ public:
+  int getNumThreads() const override {
+    return omp_get_max_threads();
+  }
+
+  void parallelFor(
+      int64_t begin,
+      int64_t end,
+      int64_t grain_size,
+      const std::function<void(int64_t, int64_t)>& f) override {
+    if (begin >= end) {
+      return;
+    }
+    const int64_t total_work = end - begin;
+    grain_size = std::max<int64_t>(grain_size, 1);
+    const int num_chunks = static_cast<int>(std::min<int64_t>(
+        (total_work + grain_size - 1) / grain_size, getNumThreads()));
+#ifdef _OPENMP
+    if (num_chunks > 1 && !omp_in_parallel()) {
+#pragma omp parallel for schedule(static, 1) num_threads(num_chunks)
+      for (int chunk = 0; chunk < num_chunks; ++chunk) {
+        int64_t chunk_begin = 0, chunk_end = 0;
+        fbgemmPartition1D(
+            chunk, num_chunks, total_work, chunk_begin, chunk_end);
+        if (chunk_begin < chunk_end) {
+          f(begin + chunk_begin, begin + chunk_end);
+        }
+      }
+      return;
+    }
 #endif
-  // Throw std::bad_alloc in the case of memory allocation failure.
-  if (raiseException || ret || aligned_mem == nullptr) {
-    throw std::bad_alloc();
+    (void)num_chunks;
+    f(begin, end);
   }
-  return aligned_mem;
+};
+
+std::mutex thread_pool_mutex;
+std::shared_ptr<ThreadPool> custom_thread_pool;
+
+bool hasCustomThreadPool() {
+  std::lock_guard<std::mutex> lock(thread_pool_mutex);
+  return custom_thread_pool != nullptr;
 }
 
-void fbgemmAlignedFree(void* p) {
-#ifdef _MSC_VER
-  _aligned_free(p);
-#else
-  free(p);
-#endif
+} // namespace
+
+void fbgemmSetThreadPool(std::shared_ptr<ThreadPool> pool) {
+  std::lock_guard<std::mutex> lock(thread_pool_mutex);
+  custom_thread_pool = std::move(pool);
+}
+
+std::shared_ptr<ThreadPool> fbgemmGetThreadPool() {
+  static const auto default_thread_pool = std::make_shared<DefaultThreadPool>();
+  std::lock_guard<std::mutex> lock(thread_pool_mutex);
+  return custom_thread_pool ? custom_thread_pool : default_thread_pool;
+}
+
+int fbgemmGetNumThreads() {
+  return std::max(fbgemmGetThreadPool()->getNumThreads(), 1);
+}
+
+void fbgemmParallelFor(
+    int64_t begin,
+    int64_t end,
+    int64_t grain_size,
+    const std::function<void(int64_t, int64_t)>& f) {
+  const inst_set_t scoped_isa = t_scoped_isa;
+  if (scoped_isa == inst_set_t::anyarch) {
+    fbgemmGetThreadPool()->parallelFor(begin, end, grain_size, f);
+    return;
+  }
+  // The workers run under the FbgemmIsaScope of the caller
+  fbgemmGetThreadPool()->parallelFor(
+      begin, end, grain_size, [&](int64_t chunk_begin, int64_t chunk_end) {
+        FbgemmIsaScope scope(scoped_isa);
+        f(chunk_begin, chunk_end);
+      });
+}
+
+void fbgemmParallelTasks(
+    int num_tasks,
+    const std::function<void(int task_id)>& task) {
+  if (num_tasks == 1) {
+    task(0);
+    return;
+  }
+  fbgemmParallelFor(0, num_tasks, 1, [&](int64_t begin, int64_t end) {
+    for (int64_t task_id = begin; task_id < end; ++task_id) {
+      task(static_cast<int>(task_id));
+    }
+  });
 }
 
 int fbgemmGet2DPartition(
@@ -741,6 +896,68 @@ void radix_sort_kernel(
   }
 }
 
+void run_radix_sort_tasks(
+    const int num_tasks,
+    const ParallelTasksExecutor& executor,
+    const std::function<void(int task_id)>& task) {
+  if (executor && num_tasks > 1) {
+    executor(num_tasks, task);
+  } else {
+    for (int task_id = 0; task_id < num_tasks; ++task_id) {
+      task(task_id);
+    }
+  }
+}
+
+// Same as radix_sort_kernel, but each step is a round of tasks over
+// contiguous chunks of the input. As the chunks are ordered as the tasks, the
+// prefix sum over (bin, task) keeps the sort stable.
+template <typename K, typename V>
+void radix_sort_tasks_kernel(
+    const K* const input_keys,
+    const V* const input_values,
+    K* const output_keys,
+    V* const output_values,
+    const int64_t elements_count,
+    int64_t* const histogram,
+    int64_t* const histogram_ps,
+    const int pass,
+    const bool pass_with_sign_bit,
+    const int num_tasks,
+    const ParallelTasksExecutor& executor) {
+  // Step 1: compute histogram
+  run_radix_sort_tasks(num_tasks, executor, [&](int task_id) {
+    int64_t begin = 0, end = 0;
+    fbgemmPartition1D(task_id, num_tasks, elements_count, begin, end);
+    auto* const local_histogram = &histogram[RDX_HIST_SIZE * task_id];
+    std::fill_n(local_histogram, RDX_HIST_SIZE, 0);
+    for (int64_t i = begin; i < end; ++i) {
+      local_histogram[(input_keys[i] >> (pass * 8)) & 0xFF]++;
+    }
+  });
+
+  // Step 2: prefix sum
+  if (pass_with_sign_bit) {
+    combine_prefix_sum_for_msb(
+        num_tasks, elements_count, histogram, histogram_ps);
+  } else {
+    combine_prefix_sum(num_tasks, elements_count, histogram, histogram_ps);
+  }
+
+  // Step 3: scatter
+  run_radix_sort_tasks(num_tasks, executor, [&](int task_id) {
+    int64_t begin = 0, end = 0;
+    fbgemmPartition1D(task_id, num_tasks, elements_count, begin, end);
+    auto* const local_histogram_ps = &histogram_ps[RDX_HIST_SIZE * task_id];
+    for (int64_t i = begin; i < end; ++i) {
+      const auto key = input_keys[i];
+      const auto pos = local_histogram_ps[(key >> (pass * 8)) & 0xFF]++;
+      output_keys[pos] = key;
+      output_values[pos] = input_values[i];
+    }
+  });
+}
+
 } // namespace
 
 template <typename K, typename V>
@@ -755,6 +972,18 @@ std::pair<K*, V*> radix_sort_parallel(
   if (max_value == 0) {
     return {inp_key_buf, inp_value_buf};
   }
+  if (hasCustomThreadPool()) {
+    return radix_sort_parallel(
+        inp_key_buf,
+        inp_value_buf,
+        tmp_key_buf,
+        tmp_value_buf,
+        elements_count,
+        max_value,
+        maybe_with_neg_vals,
+        fbgemmGetNumThreads(),
+        fbgemmParallelTasks);
+  }
 
   const auto maxthreads = omp_get_max_threads();
 #ifdef _MSC_VER
@@ -840,6 +1069,186 @@ using pair_int_float = std::pair<int, float>;
 INSTANTIATE(int, pair_int_double);
 INSTANTIATE(int, pair_int_float);
 
+template <typename K, typename V>
+std::pair<K*, V*> radix_sort_parallel(
+    K* const inp_key_buf,
+    V* const inp_value_buf,
+    K* const tmp_key_buf,
+    V* const tmp_value_buf,
+    const int64_t elements_count,
+    const int64_t max_value,
+    const bool maybe_with_neg_vals,
+    const int num_tasks,
+    const ParallelTasksExecutor& executor) {
+  if (max_value == 0) {
+    return {inp_key_buf, inp_value_buf};
+  }
+
+  const int ntasks = static_cast<int>(std::max<int64_t>(
+      std::min<int64_t>(num_tasks, elements_count), 1));
+  std::vector<int64_t> histogram(RDX_HIST_SIZE * ntasks);
+  std::vector<int64_t> histogram_ps(RDX_HIST_SIZE * ntasks);
+
+  int num_bits = sizeof(K) * 8;
+  if (!maybe_with_neg_vals)
+    num_bits -= count_leading_zeros(
+        static_cast<typename std::make_unsigned<K>::type>(max_value));
+
+  const unsigned int num_passes = (num_bits + 7) / 8;
+
+  K* input_keys = inp_key_buf;
+  V* input_values = inp_value_buf;
+  K* output_keys = tmp_key_buf;
+  V* output_values = tmp_value_buf;
+
+  for (unsigned int pass = 0; pass < num_passes; pass++) {
+    radix_sort_tasks_kernel(
+        input_keys,
+        input_values,
+        output_keys,
+        output_values,
+        elements_count,
+        histogram.data(),
+        histogram_ps.data(),
+        pass,
+        maybe_with_neg_vals && pass == num_passes - 1,
+        ntasks,
+        executor);
+
+    std::swap(input_keys, output_keys);
+    std::swap(input_values, output_values);
+  }
+  return (
+      num_passes % 2 == 0 ? std::make_pair(inp_key_buf, inp_value_buf)
+                          : std::make_pair(tmp_key_buf, tmp_value_buf));
+}
+
+#define INSTANTIATE_WITH_EXECUTOR(key_t, val_t)                      \
+  template FBGEMM_API std::pair<key_t*, val_t*> radix_sort_parallel( \
+      key_t* const inp_key_buf,                                      \
+      val_t* const inp_value_buf,                                    \
+      key_t* const tmp_key_buf,                                      \
+      val_t* const tmp_value_buf,                                    \
+      const int64_t elements_count,                                  \
+      const int64_t max_value,                                       \
+      const bool maybe_with_neg_vals,                                \
+      const int num_tasks,                                           \
+      const ParallelTasksExecutor& executor)
+
+FORALL_INT_TYPES_AND_KEY(uint8_t, INSTANTIATE_WITH_EXECUTOR);
+FORALL_INT_TYPES_AND_KEY(int8_t, INSTANTIATE_WITH_EXECUTOR);
+FORALL_INT_TYPES_AND_KEY(int16_t, INSTANTIATE_WITH_EXECUTOR);
+FORALL_INT_TYPES_AND_KEY(int, INSTANTIATE_WITH_EXECUTOR);
+FORALL_INT_TYPES_AND_KEY(int64_t, INSTANTIATE_WITH_EXECUTOR);
+
+INSTANTIATE_WITH_EXECUTOR(int, pair_int_double);
+INSTANTIATE_WITH_EXECUTOR(int, pair_int_float);
+
+template <typename K>
+int64_t radix_sort_unique_with_counts(
+    const K* const keys,
+    const int64_t elements_count,
+    const int64_t max_value,
+    const bool maybe_with_neg_vals,
+    K* const unique_keys,
+    int64_t* const counts,
+    int64_t* const inverse_indices,
+    const int num_tasks,
+    const ParallelTasksExecutor& executor) {
+  if (elements_count == 0) {
+    return 0;
+  }
+  const int ntasks = static_cast<int>(std::max<int64_t>(
+      std::min<int64_t>(num_tasks, elements_count), 1));
+
+  // Sort the keys along with their original positions
+  std::vector<K> key_buf(elements_count);
+  std::vector<K> tmp_key_buf(elements_count);
+  std::vector<int64_t> pos_buf(elements_count);
+  std::vector<int64_t> tmp_pos_buf(elements_count);
+  run_radix_sort_tasks(ntasks, executor, [&](int task_id) {
+    int64_t begin = 0, end = 0;
+    fbgemmPartition1D(task_id, ntasks, elements_count, begin, end);
+    for (int64_t i = begin; i < end; ++i) {
+      key_buf[i] = keys[i];
+      pos_buf[i] = i;
+    }
+  });
+  const auto [sorted_keys, sorted_pos] = radix_sort_parallel(
+      key_buf.data(),
+      pos_buf.data(),
+      tmp_key_buf.data(),
+      tmp_pos_buf.data(),
+      elements_count,
+      max_value,
+      maybe_with_neg_vals,
+      ntasks,
+      executor);
+
+  // Count the runs starting in every chunk so that each task knows the index
+  // of its first run
+  std::vector<int64_t> task_unique_offsets(ntasks + 1, 0);
+  run_radix_sort_tasks(ntasks, executor, [&](int task_id) {
+    int64_t begin = 0, end = 0;
+    fbgemmPartition1D(task_id, ntasks, elements_count, begin, end);
+    int64_t num_unique = 0;
+    for (int64_t i = begin; i < end; ++i) {
+      num_unique += i == 0 || sorted_keys[i] != sorted_keys[i - 1];
+    }
+    task_unique_offsets[task_id + 1] = num_unique;
+  });
+  for (int t = 0; t < ntasks; ++t) {
+    task_unique_offsets[t + 1] += task_unique_offsets[t];
+  }
+  const int64_t num_unique = task_unique_offsets[ntasks];
+
+  // Write the distinct keys, where their runs begin and the inverse mapping
+  std::vector<int64_t> run_begin(num_unique + 1);
+  run_begin[num_unique] = elements_count;
+  run_radix_sort_tasks(ntasks, executor, [&](int task_id) {
+    int64_t begin = 0, end = 0;
+    fbgemmPartition1D(task_id, ntasks, elements_count, begin, end);
+    int64_t u = task_unique_offsets[task_id] - 1;
+    for (int64_t i = begin; i < end; ++i) {
+      if (i == 0 || sorted_keys[i] != sorted_keys[i - 1]) {
+        ++u;
+        unique_keys[u] = sorted_keys[i];
+        run_begin[u] = i;
+      }
+      if (inverse_indices) {
+        inverse_indices[sorted_pos[i]] = u;
+      }
+    }
+  });
+
+  run_radix_sort_tasks(ntasks, executor, [&](int task_id) {
+    int64_t begin = 0, end = 0;
+    fbgemmPartition1D(task_id, ntasks, num_unique, begin, end);
+    for (int64_t u = begin; u < end; ++u) {
+      counts[u] = run_begin[u + 1] - run_begin[u];
+    }
+  });
+  return num_unique;
+}
+
+#define INSTANTIATE_UNIQUE(key_t)                                   \
+  template FBGEMM_API int64_t radix_sort_unique_with_counts<key_t>( \
+      const key_t* const keys,                                      \
+      const int64_t elements_count,                                 \
+      const int64_t max_value,                                      \
+      const bool maybe_with_neg_vals,                               \
+      key_t* const unique_keys,                                     \
+      int64_t* const counts,                                        \
+      int64_t* const inverse_indices,                               \
+      const int num_tasks,                                          \
+      const ParallelTasksExecutor& executor)
+
+INSTANTIATE_UNIQUE(int);
+INSTANTIATE_UNIQUE(int64_t);
+
+#undef INSTANTIATE_UNIQUE
+#undef INSTANTIATE_WITH_EXECUTOR
+
 bool is_radix_sort_accelerated_with_openmp() {
 #ifdef _OPENMP
   return true;
@@ -884,4 +1293,87 @@ bool is_asmjit_disabled() {
   return res;
 }
 
+bool is_embedding_autotune_enabled() {
+  static bool res;
+  static bool called_once = false;
+  if (called_once) {
+    return res;
+  }
+  called_once = true;
+  char* env_val = std::getenv("FBGEMM_AUTOTUNE_EMBEDDING");
+  res = (env_val != nullptr);
+  return res;
+}
+
+PackedMatrixHeader makePackedMatrixHeader(
+    PackedMatrixKind kind,
+    std::uint32_t elem_size,
+    std::int32_t rows,
+    std::int32_t cols,
+    std::int32_t groups,
+    std::int32_t brow,
+    std::int32_t bcol,
+    std::int32_t aux,
+    std::uint64_t data_size) {
+  PackedMatrixHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, PackedMatrixHeader::kMagic, sizeof(header.magic));
+  header.version = PackedMatrixHeader::kVersion;
+  header.kind = kind;
+  header.isa = fbgemmInstructionSet();
+  header.trans = matrix_op_t::NoTranspose;
+  header.elem_size = elem_size;
+  header.rows = rows;
+  header.cols = cols;
+  header.groups = groups;
+  header.brow = brow;
+  header.bcol = bcol;
+  header.aux = aux;
+  header.data_offset = kPackedMatrixDataOffset;
+  header.data_size = data_size;
+  return header;
+}
+
+const PackedMatrixHeader& readPackedMatrixHeader(
+    const void* buf,
+    std::size_t size,
+    PackedMatrixKind kind,
+    std::uint32_t elem_size) {
+  if (size < sizeof(PackedMatrixHeader)) {
+    throw std::runtime_error("Serialized packed matrix is truncated");
+  }
+  if (reinterpret_cast<std::uintptr_t>(buf) % alignof(PackedMatrixHeader)) {
+    throw std::runtime_error("Serialized packed matrix is misaligned");
+  }
+  const auto& header = *static_cast<const PackedMatrixHeader*>(buf);
+  if (std::memcmp(
+          header.magic, PackedMatrixHeader::kMagic, sizeof(header.magic))) {
+    throw std::runtime_error("Not a serialized packed matrix");
+  }
+  if (header.version != PackedMatrixHeader::kVersion) {
+    throw std::runtime_error(
+        "Unsupported packed matrix format version " +
+        std::to_string(header.version) + " (expected " +
+        std::to_string(PackedMatrixHeader::kVersion) + ")");
+  }
+  if (header.kind != kind || header.elem_size != elem_size) {
+    throw std::runtime_error(
+        "Serialized packed matrix is of kind " +
+        std::to_string(static_cast<std::uint32_t>(header.kind)) +
+        " instead of " + std::to_string(static_cast<std::uint32_t>(kind)));
+  }
+  if (header.data_offset < sizeof(PackedMatrixHeader) ||
+      header.data_offset > size ||
+      header.data_size > size - header.data_offset) {
+    throw std::runtime_error("Serialized packed matrix is truncated");
+  }
+  if ((reinterpret_cast<std::uintptr_t>(buf) + header.data_offset) %
+      kPackedMatrixDataAlignment) {
+    throw std::runtime_error(
+        "Serialized packed matrix data is not " +
+        std::to_string(kPackedMatrixDataAlignment) + "-byte aligned");
+  }
+  return header;
+}
+
 } // namespace fbgemm
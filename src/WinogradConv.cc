@@ -0,0 +1,334 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#define FBGEMM_EXPORTS
+#include "./WinogradConv.h"
+
+#include <cpuinfo.h>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept> // for logic_error
+#include <vector>
+#include "fbgemm/Fbgemm.h"
+
+namespace fbgemm {
+
+PackedWinogradConvMatrix::PackedWinogradConvMatrix(
+    int IC,
+    int OC,
+    const std::int8_t* smat)
+    : IC_(IC), OC_(OC) {
+  const int IC_padded = ICPadded();
+  const int OC_padded = OCPadded();
+  pmat_ = static_cast<std::int16_t*>(fbgemmAlignedAlloc(
+      64, 16 * IC_padded * OC_padded * sizeof(std::int16_t)));
+  std::memset(pmat_, 0, 16 * IC_padded * OC_padded * sizeof(std::int16_t));
+
+  // G' = 2 * G of F(2x2, 3x3), one row per output position of the tile.
+  constexpr int Gs[4][3] = {{2, 0, 0}, {1, 1, 1}, {1, -1, 1}, {0, 0, 2}};
+  for (int k = 0; k < OC; ++k) {
+    for (int c = 0; c < IC; ++c) {
+      int g[3][3];
+      for (int r = 0; r < 3; ++r) {
+        for (int s = 0; s < 3; ++s) {
+          g[r][s] = smat[((k * 3 + r) * 3 + s) * IC + c];
+        }
+      }
+      // G' g G'^T
+      int tmp[4][3];
+      for (int i = 0; i < 4; ++i) {
+        for (int s = 0; s < 3; ++s) {
+          tmp[i][s] = Gs[i][0] * g[0][s] + Gs[i][1] * g[1][s] +
+              Gs[i][2] * g[2][s];
+        }
+      }
+      for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+          int u = tmp[i][0] * Gs[j][0] + tmp[i][1] * Gs[j][1] +
+              tmp[i][2] * Gs[j][2];
+          int p = i * 4 + j;
+          pmat_[((p * (IC_padded / 2) + c / 2) * OC_padded + k) * 2 + c % 2] =
+              u;
+        }
+      }
+    }
+  }
+}
+
+PackedWinogradConvMatrix::~PackedWinogradConvMatrix() {
+  fbgemmAlignedFree(pmat_);
+}
+
+void PackedWinogradConvMatrix::unpack(std::int8_t* origin_buf) const {
+  const int IC_padded = ICPadded();
+  const int OC_padded = OCPadded();
+  for (int k = 0; k < OC_; ++k) {
+    for (int c = 0; c < IC_; ++c) {
+      auto u = [&](int i, int j) {
+        int p = i * 4 + j;
+        return pmat_
+            [((p * (IC_padded / 2) + c / 2) * OC_padded + k) * 2 + c % 2];
+      };
+      // First and last columns of G' pick a single element scaled by 2, so
+      // G' g is recovered from columns 0, 1 and 3 of G' g G'^T, and g from
+      // rows 0, 1 and 3 of G' g.
+      int tmp[4][3];
+      for (int i = 0; i < 4; ++i) {
+        tmp[i][0] = u(i, 0) / 2;
+        tmp[i][2] = u(i, 3) / 2;
+        tmp[i][1] = u(i, 1) - tmp[i][0] - tmp[i][2];
+      }
+      for (int s = 0; s < 3; ++s) {
+        int g0 = tmp[0][s] / 2;
+        int g2 = tmp[3][s] / 2;
+        int g1 = tmp[1][s] - g0 - g2;
+        origin_buf[((k * 3 + 0) * 3 + s) * IC_ + c] = g0;
+        origin_buf[((k * 3 + 1) * 3 + s) * IC_ + c] = g1;
+        origin_buf[((k * 3 + 2) * 3 + s) * IC_ + c] = g2;
+      }
+    }
+  }
+}
+
+void winogradGemmRef(
+    int num_tiles,
+    int IC_padded,
+    int OC_padded,
+    const std::int16_t* V,
+    const std::int16_t* U,
+    std::int32_t* M) {
+  for (int p = 0; p < 16; ++p) {
+    const std::int16_t* Vp = V + p * num_tiles * IC_padded;
+    const std::int16_t* Up = U + p * IC_padded * OC_padded;
+    std::int32_t* Mp = M + p * num_tiles * OC_padded;
+    for (int t = 0; t < num_tiles; ++t) {
+      for (int k = 0; k < OC_padded; ++k) {
+        std::int32_t sum = 0;
+        for (int c = 0; c < IC_padded; ++c) {
+          sum += Vp[t * IC_padded + c] *
+              Up[((c / 2) * OC_padded + k) * 2 + c % 2];
+        }
+        Mp[t * OC_padded + k] = sum;
+      }
+    }
+  }
+}
+
+template <QuantizationGranularity Q_GRAN, bool FUSE_RELU, typename BIAS_TYPE>
+void fbgemmWinogradConv(
+    const conv_param_t<2>& conv_p,
+    const std::uint8_t* activations,
+    PackedWinogradConvMatrix& packed_weights,
+    std::uint8_t* out,
+    std::int32_t* outBuffer,
+    ReQuantizeOutput<FUSE_RELU, Q_GRAN, BIAS_TYPE>& outProcess,
+    int thread_id,
+    int num_threads) {
+  if (!takeWinogradFastPath<2, std::int32_t>(conv_p) ||
+      packed_weights.IC() != conv_p.IC || packed_weights.OC() != conv_p.OC) {
+    throw std::logic_error(
+        "[FBGEMM_CONV_ERROR] Convolution parameters are not supported by "
+        "fbgemmWinogradConv");
+  }
+  if (!cpuinfo_initialize()) {
+    throw std::runtime_error("Failed to initialize cpuinfo!");
+  }
+
+  const int IH = conv_p.IN_DIM[0];
+  const int IW = conv_p.IN_DIM[1];
+  const int OH = conv_p.OUT_DIM[0];
+  const int OW = conv_p.OUT_DIM[1];
+  const int IC = conv_p.IC;
+  const int OC = conv_p.OC;
+  const int IC_padded = packed_weights.ICPadded();
+  const int OC_padded = packed_weights.OCPadded();
+  const std::int32_t A_zero_point = outProcess.getAZeroPoint();
+
+  // Each step computes a row of 2x2 output tiles from a strip of 4 input
+  // rows.
+  const int tiles_h = (OH + 1) / 2;
+  const int tiles_w = (OW + 1) / 2;
+  const int strip_w = 2 * tiles_w + 2;
+
+  int64_t work_begin, work_end;
+  fbgemmPartition1D(
+      thread_id,
+      num_threads,
+      static_cast<int64_t>(conv_p.MB) * tiles_h,
+      work_begin,
+      work_end);
+  if (work_begin >= work_end) {
+    return;
+  }
+
+  bool use_avx2 = false;
+#if CPUINFO_ARCH_X86 || CPUINFO_ARCH_X86_64
+  use_avx2 = fbgemmHasAvx512Support() || fbgemmHasAvx2Support();
+#endif
+
+  std::vector<std::int16_t> strip(4 * strip_w * IC_padded, 0);
+  std::vector<std::int32_t> strip_sums(4 * strip_w);
+  std::vector<std::int16_t> V(16 * tiles_w * IC_padded);
+  std::vector<std::int32_t> M(16 * tiles_w * OC_padded);
+  std::vector<std::int32_t> row_offsets(2 * OW);
+
+  for (int64_t work = work_begin; work < work_end; ++work) {
+    const int n = work / tiles_h;
+    const int oh_start = work % tiles_h * 2;
+    const int rows = std::min(2, OH - oh_start);
+
+    // Gather the input strip with padding replaced by the zero point, and
+    // the sum over channels of each of its pixels for the row offsets.
+    for (int i = 0; i < 4; ++i) {
+      const int ih = oh_start - conv_p.pad[0] + i;
+      for (int w = 0; w < strip_w; ++w) {
+        const int iw = w - conv_p.pad[1];
+        std::int16_t* dst = strip.data() + (i * strip_w + w) * IC_padded;
+        if (ih < 0 || ih >= IH || iw < 0 || iw >= IW) {
+          for (int c = 0; c < IC; ++c) {
+            dst[c] = A_zero_point;
+          }
+          strip_sums[i * strip_w + w] = A_zero_point * IC;
+        } else {
+          const std::uint8_t* src = activations +
+              ((static_cast<int64_t>(n) * IH + ih) * IW + iw) * IC;
+          std::int32_t sum = 0;
+          for (int c = 0; c < IC; ++c) {
+            dst[c] = src[c];
+            sum += src[c];
+          }
+          strip_sums[i * strip_w + w] = sum;
+        }
+      }
+    }
+
+    // Input transform B^T d B of each tile
+    for (int t = 0; t < tiles_w; ++t) {
+      const std::int16_t* d[4][4];
+      for (int i = 0; i < 4; ++i) {
+        for (int j = 0; j < 4; ++j) {
+          d[i][j] = strip.data() + (i * strip_w + 2 * t + j) * IC_padded;
+        }
+      }
+      std::int16_t* v = V.data() + t * IC_padded;
+      const int v_stride = tiles_w * IC_padded;
+      for (int c = 0; c < IC_padded; ++c) {
+        std::int16_t tmp[4][4];
+        for (int j = 0; j < 4; ++j) {
+          tmp[0][j] = d[0][j][c] - d[2][j][c];
+          tmp[1][j] = d[1][j][c] + d[2][j][c];
+          tmp[2][j] = d[2][j][c] - d[1][j][c];
+          tmp[3][j] = d[1][j][c] - d[3][j][c];
+        }
+        for (int i = 0; i < 4; ++i) {
+          v[(i * 4 + 0) * v_stride + c] = tmp[i][0] - tmp[i][2];
+          v[(i * 4 + 1) * v_stride + c] = tmp[i][1] + tmp[i][2];
+          v[(i * 4 + 2) * v_stride + c] = tmp[i][2] - tmp[i][1];
+          v[(i * 4 + 3) * v_stride + c] = tmp[i][1] - tmp[i][3];
+        }
+      }
+    }
+
+    if (use_avx2) {
+      winogradGemmAvx2(
+          tiles_w,
+          IC_padded,
+          OC_padded,
+          V.data(),
+          packed_weights.PackedMat(),
+          M.data());
+    } else {
+      winogradGemmRef(
+          tiles_w,
+          IC_padded,
+          OC_padded,
+          V.data(),
+          packed_weights.PackedMat(),
+          M.data());
+    }
+
+    // Output transform A^T m A of each tile. The weights were scaled by 4.
+    // The sums are done in 64 bits since only the final result is
+    // guaranteed to fit in 32 bits.
+    const int64_t out_row = (static_cast<int64_t>(n) * OH + oh_start) * OW;
+    std::int32_t* C = outBuffer + out_row * OC;
+    const int m_stride = tiles_w * OC_padded;
+    for (int t = 0; t < tiles_w; ++t) {
+      const int cols = std::min(2, OW - 2 * t);
+      const std::int32_t* m = M.data() + t * OC_padded;
+      for (int k = 0; k < OC; ++k) {
+        int64_t tmp[2][4];
+        for (int j = 0; j < 4; ++j) {
+          int64_t m0 = m[(0 * 4 + j) * m_stride + k];
+          int64_t m1 = m[(1 * 4 + j) * m_stride + k];
+          int64_t m2 = m[(2 * 4 + j) * m_stride + k];
+          int64_t m3 = m[(3 * 4 + j) * m_stride + k];
+          tmp[0][j] = m0 + m1 + m2;
+          tmp[1][j] = m1 - m2 - m3;
+        }
+        for (int r = 0; r < rows; ++r) {
+          int64_t y[2] = {
+              tmp[r][0] + tmp[r][1] + tmp[r][2],
+              tmp[r][1] - tmp[r][2] - tmp[r][3]};
+          for (int s = 0; s < cols; ++s) {
+            C[(r * OW + 2 * t + s) * OC + k] = y[s] / 4;
+          }
+        }
+      }
+    }
+
+    for (int r = 0; r < rows; ++r) {
+      for (int ow = 0; ow < OW; ++ow) {
+        std::int32_t sum = 0;
+        for (int i = r; i < r + 3; ++i) {
+          for (int w = ow; w < ow + 3; ++w) {
+            sum += strip_sums[i * strip_w + w];
+          }
+        }
+        row_offsets[r * OW + ow] = sum;
+      }
+    }
+
+    outProcess.setRowOffsets(row_offsets.data());
+    block_type_t block{static_cast<int>(out_row), rows * OW, 0, OC};
+    if (use_avx2) {
+      outProcess.template f<inst_set_t::avx2>(out, C, block, OC, OC);
+    } else {
+      outProcess.template f<inst_set_t::anyarch>(out, C, block, OC, OC);
+    }
+  }
+}
+
+#define INSTANTIATE_BASE(Q_GRAN, RELU, BIAS_TYPE)                       \
+  template FBGEMM_API void fbgemmWinogradConv<Q_GRAN, RELU, BIAS_TYPE>( \
+      const conv_param_t<2>& conv_p,                                    \
+      const std::uint8_t* activations,                                  \
+      PackedWinogradConvMatrix& packed_weights,                         \
+      std::uint8_t* out,                                                \
+      std::int32_t* outBuffer,                                          \
+      ReQuantizeOutput<RELU, Q_GRAN, BIAS_TYPE>& outProcess,            \
+      int thread_id,                                                    \
+      int num_threads);
+
+#define INSTANTIATE_BIAS_T(Q_GRAN, RELU) \
+  INSTANTIATE_BASE(Q_GRAN, RELU, float)  \
+  INSTANTIATE_BASE(Q_GRAN, RELU, std::int32_t)
+
+#define INSTANTIATE_Q_GRANS(RELU)                           \
+  INSTANTIATE_BIAS_T(QuantizationGranularity::TENSOR, RELU) \
+  INSTANTIATE_BIAS_T(QuantizationGranularity::GROUP, RELU)  \
+  INSTANTIATE_BIAS_T(QuantizationGranularity::OUT_CHANNEL, RELU)
+
+INSTANTIATE_Q_GRANS(true)
+INSTANTIATE_Q_GRANS(false)
+
+#undef INSTANTIATE_Q_GRANS
+#undef INSTANTIATE_BIAS_T
+#undef INSTANTIATE_BASE
+
+} // namespace fbgemm
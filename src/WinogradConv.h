@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include "fbgemm/FbgemmBuild.h"
+
+namespace fbgemm {
+
+/**
+ * @brief The 16 GEMMs of a Winograd F(2x2, 3x3) convolution for a batch of
+ *        tiles. For each tile position p,
+ *        M[p] (num_tiles x OC_padded) = V[p] (num_tiles x IC_padded) *
+ *        U[p] (IC_padded x OC_padded) with V[p] at V + p * num_tiles *
+ *        IC_padded, M[p] at M + p * num_tiles * OC_padded and U in the
+ *        layout of PackedWinogradConvMatrix::PackedMat().
+ */
+void winogradGemmRef(
+    int num_tiles,
+    int IC_padded,
+    int OC_padded,
+    const std::int16_t* V,
+    const std::int16_t* U,
+    std::int32_t* M);
+
+void winogradGemmAvx2(
+    int num_tiles,
+    int IC_padded,
+    int OC_padded,
+    const std::int16_t* V,
+    const std::int16_t* U,
+    std::int32_t* M);
+
+} // namespace fbgemm
@@ -0,0 +1,88 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#define FBGEMM_EXPORTS
+#include "./WinogradConv.h"
+
+#include <immintrin.h>
+
+namespace fbgemm {
+
+namespace {
+
+// Computes ROWS tiles x 16 output channels of one of the 16 GEMMs. Each
+// step multiplies a broadcast pair of input channels of a tile with the
+// interleaved pairs of weights of 16 output channels.
+template <int ROWS>
+inline void winogradGemmBlockAvx2(
+    int IC_padded,
+    int OC_padded,
+    const std::int16_t* V,
+    const std::int16_t* U,
+    std::int32_t* M) {
+  __m256i acc[ROWS][2];
+  for (int r = 0; r < ROWS; ++r) {
+    acc[r][0] = _mm256_setzero_si256();
+    acc[r][1] = _mm256_setzero_si256();
+  }
+  for (int c = 0; c < IC_padded; c += 2) {
+    const std::int16_t* u = U + c * OC_padded;
+    __m256i b0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(u));
+    __m256i b1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(u + 16));
+    for (int r = 0; r < ROWS; ++r) {
+      __m256i a = _mm256_set1_epi32(
+          *reinterpret_cast<const std::int32_t*>(V + r * IC_padded + c));
+      acc[r][0] = _mm256_add_epi32(acc[r][0], _mm256_madd_epi16(a, b0));
+      acc[r][1] = _mm256_add_epi32(acc[r][1], _mm256_madd_epi16(a, b1));
+    }
+  }
+  for (int r = 0; r < ROWS; ++r) {
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(M + r * OC_padded), acc[r][0]);
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(M + r * OC_padded + 8), acc[r][1]);
+  }
+}
+
+} // namespace
+
+void winogradGemmAvx2(
+    int num_tiles,
+    int IC_padded,
+    int OC_padded,
+    const std::int16_t* V,
+    const std::int16_t* U,
+    std::int32_t* M) {
+  constexpr int kRows = 4;
+  for (int p = 0; p < 16; ++p) {
+    const std::int16_t* Vp = V + p * num_tiles * IC_padded;
+    const std::int16_t* Up = U + p * IC_padded * OC_padded;
+    std::int32_t* Mp = M + p * num_tiles * OC_padded;
+    for (int k = 0; k < OC_padded; k += 16) {
+      int t = 0;
+      for (; t + kRows <= num_tiles; t += kRows) {
+        winogradGemmBlockAvx2<kRows>(
+            IC_padded,
+            OC_padded,
+            Vp + t * IC_padded,
+            Up + 2 * k,
+            Mp + t * OC_padded + k);
+      }
+      for (; t < num_tiles; ++t) {
+        winogradGemmBlockAvx2<1>(
+            IC_padded,
+            OC_padded,
+            Vp + t * IC_padded,
+            Up + 2 * k,
+            Mp + t * OC_padded + k);
+      }
+    }
+  }
+}
+
+} // namespace fbgemm
@@ -269,7 +269,7 @@ void sparseDenseInt8MMRef(
   // Calcualtes accum ? C += A * B : C = A * B
   constexpr int rowBlockSize = BCSRMatrix<>::RB;
   constexpr int colBlockSize = BCSRMatrix<>::CB;
-  constexpr int colTileSize = BCSRMatrix<>::COLTILE;
+  const int colTileSize = bcsr->colTile;
   int M = bcsr->R;
   int K = bcsr->C;
   int kTiles = (K + colTileSize - 1) / colTileSize;
@@ -12,7 +12,9 @@
     (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86)))
 #include <immintrin.h>
 #endif
+#include <bit>
 #include <cassert> //for assert
+#include <cstring>
 #include "./MaskAvx2.h"
 
 namespace fbgemm {
@@ -369,4 +371,90 @@ CREATE_INSTANCE(
     QuantizationGranularity::OUT_CHANNEL)
 #undef CREATE_INSTANCE
 
+namespace internal {
+
+namespace {
+
+// Appends the indices base + b of the set bits b of mask.
+inline int appendSetBits(std::uint32_t mask, int base, int count, int* out) {
+  if (out == nullptr) {
+    return count + std::popcount(mask);
+  }
+  while (mask) {
+    out[count++] = base + std::countr_zero(mask);
+    mask &= mask - 1;
+  }
+  return count;
+}
+
+} // namespace
+
+int findNonZeroWordsAvx2(const void* src, int n, int* nonZeros) {
+  const std::uint8_t* src_u8 = static_cast<const std::uint8_t*>(src);
+  const __m256i zero_v = _mm256_setzero_si256();
+  int count = 0;
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256i v = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(src_u8 + i * sizeof(std::int32_t)));
+    std::uint32_t zeros = _mm256_movemask_ps(
+        _mm256_castsi256_ps(_mm256_cmpeq_epi32(v, zero_v)));
+    count = appendSetBits(~zeros & 0xff, i, count, nonZeros);
+  }
+  for (; i < n; ++i) {
+    std::int32_t word;
+    std::memcpy(&word, src_u8 + i * sizeof(std::int32_t), sizeof(word));
+    if (word != 0) {
+      if (nonZeros) {
+        nonZeros[count] = i;
+      }
+      ++count;
+    }
+  }
+  return count;
+}
+
+int findNonZerosAvx2(const std::int8_t* src, int n, int* nonZeros) {
+  const __m256i zero_v = _mm256_setzero_si256();
+  int count = 0;
+  int i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    std::uint32_t zeros = _mm256_movemask_epi8(_mm256_cmpeq_epi8(v, zero_v));
+    count = appendSetBits(~zeros, i, count, nonZeros);
+  }
+  for (; i < n; ++i) {
+    if (src[i] != 0) {
+      if (nonZeros) {
+        nonZeros[count] = i;
+      }
+      ++count;
+    }
+  }
+  return count;
+}
+
+int findNonZerosAvx2(const float* src, int n, int* nonZeros) {
+  const __m256 zero_v = _mm256_setzero_ps();
+  int count = 0;
+  int i = 0;
+  for (; i + 8 <= n; i += 8) {
+    // Ordered compare, so that -0.0f is zero as in the scalar code
+    std::uint32_t zeros = _mm256_movemask_ps(
+        _mm256_cmp_ps(_mm256_loadu_ps(src + i), zero_v, _CMP_EQ_OQ));
+    count = appendSetBits(~zeros & 0xff, i, count, nonZeros);
+  }
+  for (; i < n; ++i) {
+    if (src[i] != 0) {
+      if (nonZeros) {
+        nonZeros[count] = i;
+      }
+      ++count;
+    }
+  }
+  return count;
+}
+
+} // namespace internal
+
 } // namespace fbgemm
@@ -0,0 +1,204 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "fbgemm/Fbgemm.h"
+#include "src/RefImplementations.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+// k x n B with one row pair saturating vpmaddubsw per 256 rows of a column,
+// over a background of +-1 in every 8th row. After the split every block of
+// 256 rows of a column adds up to at most 255 * (64 + 32), so not even the
+// int16 accumulation of the acc16 kernels saturates.
+vector<int8_t> makeB(int k, int n, default_random_engine& generator) {
+  uniform_int_distribution<int> sign(0, 1);
+  uniform_int_distribution<int> large(65, 127);
+  vector<int8_t> B(k * n);
+  for (int i = 0; i < k; ++i) {
+    for (int j = 0; j < n; ++j) {
+      if ((i + j) % 8 == 0) {
+        B[i * n + j] = sign(generator) ? 1 : -1;
+      }
+    }
+  }
+  for (int j = 0; j < n; ++j) {
+    for (int r = 0; r + 1 < k; r += 256) {
+      const int num_pairs = (min(k, r + 256) - r) / 2;
+      const int pair =
+          r + 2 * uniform_int_distribution<int>(0, num_pairs - 1)(generator);
+      const int b0 = large(generator);
+      const int b1 = uniform_int_distribution<int>(129 - b0, 64)(generator);
+      const int s = sign(generator) ? 1 : -1;
+      const bool swap = sign(generator);
+      B[(pair + swap) * n + j] = s * b0;
+      B[(pair + !swap) * n + j] = s * b1;
+    }
+  }
+  return B;
+}
+
+class Acc16OutliersSplitTest
+    : public testing::TestWithParam<tuple<matrix_op_t, int>> {};
+
+class Acc16OutliersGemmTest
+    : public testing::TestWithParam<tuple<int, float>> {};
+
+INSTANTIATE_TEST_SUITE_P(
+    InstantiationName,
+    Acc16OutliersSplitTest,
+    ::testing::Combine(
+        ::testing::Values(matrix_op_t::NoTranspose, matrix_op_t::Transpose),
+        ::testing::Values(1, 3)));
+
+INSTANTIATE_TEST_SUITE_P(
+    InstantiationName,
+    Acc16OutliersGemmTest,
+    ::testing::Combine(
+        ::testing::Values(1, 35, 200), // m
+        ::testing::Values(0.0f, 0.01f))); // max_outlier_density
+
+} // namespace
+
+TEST_P(Acc16OutliersSplitTest, splitsSaturatingPairs) {
+  const auto [trans, groups] = GetParam();
+  const int k_per_group = 37, n = 20, k = groups * k_per_group;
+  default_random_engine generator;
+  uniform_int_distribution<int> dist(-128, 127);
+  // Transposed groups are stacked n x k_per_group blocks
+  const int ld = trans == matrix_op_t::Transpose ? k_per_group : n;
+  vector<int8_t> B(k * n), B_dense(k * n);
+  for (auto& v : B) {
+    v = dist(generator);
+  }
+  CompressedSparseColumn B_outliers(k_per_group, groups * n);
+  splitOutliersForAcc16(
+      trans, k, n, B.data(), ld, B_dense.data(), B_outliers, groups);
+
+  auto idx = [&](int g, int i, int j) {
+    return trans == matrix_op_t::Transpose ? (g * n + j) * ld + i
+                                           : (g * k_per_group + i) * ld + j;
+  };
+  vector<int8_t> B_sum = B_dense;
+  for (int g = 0; g < groups; ++g) {
+    for (int j = 0; j < n; ++j) {
+      const int col = g * n + j;
+      const auto& colptr = B_outliers.ColPtr();
+      for (int nz = colptr[col]; nz < colptr[col + 1]; ++nz) {
+        const int i = B_outliers.RowIdx()[nz];
+        EXPECT_EQ(B_sum[idx(g, i, j)], 0);
+        B_sum[idx(g, i, j)] = B_outliers.Values()[nz];
+      }
+      int num_saturating = 0;
+      for (int i = 0; i + 1 < k_per_group; i += 2) {
+        num_saturating += abs(B[idx(g, i, j)] + B[idx(g, i + 1, j)]) > 128;
+        EXPECT_LE(
+            abs(B_dense[idx(g, i, j)] + B_dense[idx(g, i + 1, j)]), 128);
+      }
+      // One outlier per saturating pair and no others
+      EXPECT_EQ(colptr[col + 1] - colptr[col], num_saturating);
+    }
+  }
+  EXPECT_EQ(B_sum, B);
+}
+
+TEST(Acc16OutliersTest, splitRejectsWrongShape) {
+  vector<int8_t> B(64 * 16), B_dense(64 * 16);
+  CompressedSparseColumn B_outliers(64, 8);
+  EXPECT_THROW(
+      splitOutliersForAcc16(
+          matrix_op_t::NoTranspose,
+          64,
+          16,
+          B.data(),
+          16,
+          B_dense.data(),
+          B_outliers),
+      std::runtime_error);
+}
+
+// Whichever GEMM is chosen, the result is that of the 32-bit accumulation.
+TEST_P(Acc16OutliersGemmTest, matchesAcc32) {
+  const auto [m, max_outlier_density] = GetParam();
+  const int k = 600, n = 70;
+  const int32_t A_zero_point = 4;
+  const int32_t B_zero_point = -3;
+  const int32_t C_zero_point = 10;
+  const float C_multiplier = 2e-4f;
+  default_random_engine generator;
+  uniform_int_distribution<int> a_dist(0, 255);
+  vector<uint8_t> A(m * k);
+  for (auto& v : A) {
+    v = a_dist(generator);
+  }
+  const vector<int8_t> B = makeB(k, n, generator);
+
+  vector<int32_t> row_offsets(m), col_offsets(n), C_ref_int32(m * n);
+  vector<uint8_t> C_ref(m * n), C(m * n);
+  matmul_u8i8acc32_ref(
+      m, n, k, k, n, n, A.data(), B.data(), C_ref_int32.data());
+  row_offsets_u8acc32_ref(m, k, k, A.data(), row_offsets.data());
+  col_offsets_with_zero_pt_s8acc32_ref(
+      k, n, n, B.data(), &B_zero_point, col_offsets.data(), n);
+  requantize_u8acc32_ref(
+      m,
+      n,
+      n,
+      C_ref_int32.data(),
+      C_ref.data(),
+      &C_multiplier,
+      C_zero_point,
+      A_zero_point,
+      &B_zero_point,
+      row_offsets.data(),
+      col_offsets.data(),
+      nullptr,
+      n);
+
+  PackBMatrixWithOutliers packedB(
+      matrix_op_t::NoTranspose,
+      k,
+      n,
+      B.data(),
+      n,
+      1,
+      max_outlier_density);
+  if (max_outlier_density == 0.0f || fbgemmHasAvx512VnniSupport()) {
+    EXPECT_FALSE(packedB.useAcc16());
+  }
+  if (packedB.useAcc16()) {
+    EXPECT_GT(packedB.outliers().NumOfNonZeros(), 0);
+  } else {
+    EXPECT_EQ(packedB.outliers().NumOfNonZeros(), 0);
+  }
+
+  DoNothing<> doNothingObj{};
+  ReQuantizeOutput<false> outputProcObj(
+      doNothingObj,
+      &C_multiplier,
+      C_zero_point,
+      A_zero_point,
+      &B_zero_point,
+      nullptr, // row offsets are computed with A
+      col_offsets.data(),
+      nullptr,
+      n);
+  vector<int32_t> C_buffer(m * n);
+  fbgemmPackedWithOutliers(
+      A.data(), m, k, packedB, C.data(), C_buffer.data(), n, outputProcObj);
+  EXPECT_EQ(C, C_ref);
+}
@@ -0,0 +1,144 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "fbgemm/Fbgemm.h"
+#include "fbgemm/Utils.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+struct AllocationCounts {
+  atomic<int> allocs{0};
+  atomic<int> frees{0};
+};
+
+FbgemmAllocator countingAllocator(shared_ptr<AllocationCounts> counts) {
+  return FbgemmAllocator{
+      [counts](size_t align, size_t size) -> void* {
+        void* p = nullptr;
+#ifdef _MSC_VER
+        p = _aligned_malloc(size, align);
+#else
+        if (posix_memalign(&p, align, size)) {
+          p = nullptr;
+        }
+#endif
+        counts->allocs += p != nullptr;
+        return p;
+      },
+      [counts](void* p, size_t) {
+        ++counts->frees;
+#ifdef _MSC_VER
+        _aligned_free(p);
+#else
+        free(p);
+#endif
+      }};
+}
+
+} // namespace
+
+TEST(AllocatorTest, packingUsesAllocator) {
+  auto counts = make_shared<AllocationCounts>();
+  fbgemmSetAllocator(countingAllocator(counts));
+  {
+    vector<int8_t> B(64 * 32, 1);
+    PackBMatrix<int8_t> packedB(
+        matrix_op_t::NoTranspose, 64, 32, B.data(), 32, nullptr, 1);
+    EXPECT_GT(counts->allocs, 0);
+  }
+  fbgemmSetAllocator({});
+  EXPECT_EQ(counts->frees, counts->allocs);
+}
+
+TEST(AllocatorTest, freedByTheirAllocator) {
+  auto counts = make_shared<AllocationCounts>();
+  void* before = fbgemmAlignedAlloc(64, 256);
+  fbgemmSetAllocator(countingAllocator(counts));
+  void* p = fbgemmAlignedAlloc(64, 256);
+  fbgemmSetAllocator({});
+  void* after = fbgemmAlignedAlloc(64, 256);
+  EXPECT_EQ(counts->allocs, 1);
+
+  fbgemmAlignedFree(before);
+  fbgemmAlignedFree(after);
+  EXPECT_EQ(counts->frees, 0);
+  fbgemmAlignedFree(p);
+  EXPECT_EQ(counts->frees, 1);
+}
+
+TEST(AllocatorTest, hugePageAllocator) {
+  EXPECT_THROW(fbgemmHugePageAllocator(3 << 20), runtime_error);
+
+  constexpr size_t kPageSize = 2 << 20;
+  fbgemmSetAllocator(fbgemmHugePageAllocator(kPageSize));
+  void* large = fbgemmAlignedAlloc(64, 3 * kPageSize + 5);
+  void* small = fbgemmAlignedAlloc(64, 100);
+  fbgemmSetAllocator({});
+#ifdef __linux__
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(large) % kPageSize, 0);
+#endif
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(small) % 64, 0);
+  memset(large, 1, 3 * kPageSize + 5);
+  memset(small, 1, 100);
+  fbgemmAlignedFree(large);
+  fbgemmAlignedFree(small);
+}
+
+TEST(AllocatorTest, numaNodeAllocator) {
+  fbgemmSetAllocator(fbgemmNumaNodeAllocator(0));
+  for (size_t size : {64, 1 << 20}) {
+    void* p = fbgemmAlignedAlloc(64, size);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(p) % 64, 0);
+    memset(p, 1, size);
+    fbgemmAlignedFree(p);
+  }
+  fbgemmSetAllocator({});
+}
+
+TEST(AllocatorTest, memoryStats) {
+  const FbgemmMemoryStats before = fbgemmGetMemoryStats();
+  fbgemmResetPeakMemory();
+  void* p = fbgemmAlignedAlloc(64, 1 << 20);
+  const FbgemmMemoryStats during = fbgemmGetMemoryStats();
+  EXPECT_EQ(during.num_buffers, before.num_buffers + 1);
+  // The heap may report a little more than the requested size
+  EXPECT_GE(during.bytes_in_use, before.bytes_in_use + (1 << 20));
+  EXPECT_LE(during.bytes_in_use, before.bytes_in_use + (1 << 20) + 4096);
+  fbgemmAlignedFree(p);
+  const FbgemmMemoryStats after = fbgemmGetMemoryStats();
+  EXPECT_EQ(after.bytes_in_use, before.bytes_in_use);
+  EXPECT_EQ(after.num_buffers, before.num_buffers);
+  EXPECT_EQ(after.peak_bytes_in_use, during.bytes_in_use);
+
+  fbgemmResetPeakMemory();
+  EXPECT_EQ(fbgemmGetMemoryStats().peak_bytes_in_use, after.bytes_in_use);
+
+  // Buffers of other allocators are counted with the requested size, and
+  // are untallied when freed after the allocator is replaced.
+  auto counts = make_shared<AllocationCounts>();
+  fbgemmSetAllocator(countingAllocator(counts));
+  p = fbgemmAlignedAlloc(64, 1000);
+  fbgemmSetAllocator({});
+  EXPECT_EQ(fbgemmGetMemoryStats().bytes_in_use, before.bytes_in_use + 1000);
+  fbgemmAlignedFree(p);
+  EXPECT_EQ(counts->frees, 1);
+  EXPECT_EQ(fbgemmGetMemoryStats().bytes_in_use, before.bytes_in_use);
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "./FBGemmFPTest.h"
+#include "fbgemm/FbgemmBF16.h"
+#include "fbgemm/FbgemmFPCommon.h"
+
+using FBGemmBF16Test = fbgemm::FBGemmFPTest<fbgemm::bfloat16_weight>;
+
+INSTANTIATE_TEST_CASE_P(
+    InstantiationName,
+    FBGemmBF16Test,
+    ::testing::Values(
+        std::pair<fbgemm::matrix_op_t, fbgemm::matrix_op_t>(
+            fbgemm::matrix_op_t::NoTranspose,
+            fbgemm::matrix_op_t::NoTranspose),
+        std::pair<fbgemm::matrix_op_t, fbgemm::matrix_op_t>(
+            fbgemm::matrix_op_t::NoTranspose,
+            fbgemm::matrix_op_t::Transpose)));
+
+TEST_P(FBGemmBF16Test, Test) {
+  TestRun();
+}
+
+// Weights beyond the fp16 range are kept: multiples of 2^18 with few
+// significant bits are exact in bf16, and so are the fp32 sums here.
+TEST(BF16Test, weightsOutsideFp16Range) {
+  using namespace fbgemm;
+  const int n = 75, k = 600;
+  std::default_random_engine generator;
+  std::uniform_int_distribution<int> dist(-8, 8);
+  for (int m : {1, 5, 20}) {
+    std::vector<float> A(m * k), B(k * n);
+    for (auto& v : A) {
+      v = dist(generator);
+    }
+    for (auto& v : B) {
+      v = dist(generator) * float(1 << 18);
+    }
+    std::vector<float> C_ref(m * n);
+    cblas_sgemm_ref(
+        matrix_op_t::NoTranspose,
+        matrix_op_t::NoTranspose,
+        m,
+        n,
+        k,
+        1.f,
+        A.data(),
+        k,
+        B.data(),
+        n,
+        0.f,
+        C_ref.data(),
+        n);
+
+    PackedGemmMatrixBF16 Bp(matrix_op_t::NoTranspose, k, n, 1.f, B.data());
+    std::vector<float> C(m * n, NAN);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    cblas_gemm_compute(
+        matrix_op_t::NoTranspose,
+        m,
+        A.data(),
+        Bp,
+        0.f,
+        C.data(),
+        fbgemm_get_thread_num(),
+        fbgemm_get_num_threads());
+    EXPECT_EQ(C, C_ref) << "m = " << m;
+  }
+}
+
+// aarch64 builds run ref_kernel in place of the missing bf16 kernels.
+TEST(BF16Test, refKernel) {
+  using namespace fbgemm;
+  // n is a multiple of the avx2 and avx512 column block sizes.
+  const int n = 64, k = 100;
+  std::default_random_engine generator;
+  std::uniform_int_distribution<int> dist(-8, 8);
+  std::vector<float> B(k * n);
+  for (auto& v : B) {
+    v = dist(generator);
+  }
+  PackedGemmMatrixBF16 Bp(matrix_op_t::NoTranspose, k, n, 1.f, B.data());
+  const int simd_len = Bp.blockColSize() / Bp.kernelNumColBlocks();
+  for (int m = 1; m <= 6; ++m) {
+    std::vector<float> A(m * k);
+    for (auto& v : A) {
+      v = dist(generator);
+    }
+    std::vector<float> C_ref(m * n);
+    cblas_sgemm_ref(
+        matrix_op_t::NoTranspose,
+        matrix_op_t::NoTranspose,
+        m,
+        n,
+        k,
+        1.f,
+        A.data(),
+        k,
+        B.data(),
+        n,
+        0.f,
+        C_ref.data(),
+        n);
+
+    // ref_kernel reads A packed column by column.
+    std::vector<float> A_packed(m * k);
+    for (int i = 0; i < m; ++i) {
+      for (int j = 0; j < k; ++j) {
+        A_packed[i + j * m] = A[i * k + j];
+      }
+    }
+    std::vector<float> C(m * n, NAN);
+    GemmParams<bfloat16_weight> gp;
+    gp.k = k;
+    gp.A = A_packed.data();
+    gp.B = &Bp(0, 0);
+    gp.beta = 0.f;
+    gp.C = C.data();
+    gp.ldc = n * sizeof(float);
+    gp.b_block_cols = n / Bp.blockColSize();
+    gp.b_block_size = k * Bp.blockColSize() * sizeof(gp.B[0]);
+    ref_kernel<bfloat16_weight>(m, &gp, C.data(), m, n, simd_len);
+    EXPECT_EQ(C, C_ref) << "m = " << m;
+  }
+}
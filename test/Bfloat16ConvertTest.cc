@@ -8,6 +8,7 @@
 
 #include <gtest/gtest.h>
 #include <cmath>
+#include <limits>
 #include <random>
 
 #include "bench/BenchUtils.h"
@@ -88,3 +89,48 @@ TEST(FBGemmBfloat16Test, Conversion_simd2) {
     }
   }
 }
+
+TEST(FBGemmBfloat16Test, StochasticRounding) {
+  // 1 + 2^-9 lies a quarter of the way between the bfloat16 values 1 and
+  // 1 + 2^-7, -x between -1 and -1 - 2^-7
+  constexpr int N = 1 << 14;
+  constexpr float lo = 1.0f, hi = 1.0f + 1.0f / 128;
+  const float x = 1.0f + 1.0f / 512;
+  vector<float> a(N);
+  for (int i = 0; i < N; ++i) {
+    a[i] = i % 2 ? -x : x;
+  }
+  a[3] = numeric_limits<float>::infinity();
+  a[N - 1] = numeric_limits<float>::quiet_NaN();
+
+  for (bool simd : {false, true}) {
+    SCOPED_TRACE(simd ? "simd" : "ref");
+    vector<bfloat16> b(N);
+    vector<float> c(N);
+    if (simd) {
+      // Split to go through the remainder
+      FloatToBfloat16StochasticRounding_simd(a.data(), b.data(), N - 1);
+      FloatToBfloat16StochasticRounding_simd(
+          a.data() + N - 1, b.data() + N - 1, 1);
+    } else {
+      FloatToBfloat16StochasticRounding_ref(a.data(), b.data(), N);
+    }
+    Bfloat16ToFloat_ref(b.data(), c.data(), N);
+    EXPECT_EQ(c[3], numeric_limits<float>::infinity());
+    EXPECT_TRUE(std::isnan(c[N - 1]));
+
+    double sum = 0;
+    int num_finite = 0;
+    for (int i = 0; i < N; ++i) {
+      if (std::isfinite(a[i])) {
+        const float y = std::abs(c[i]);
+        EXPECT_TRUE(y == lo || y == hi) << "at " << i << ": " << c[i];
+        EXPECT_EQ(std::signbit(c[i]), std::signbit(a[i]));
+        sum += y;
+        ++num_finite;
+      }
+    }
+    // Rounding the magnitude up with probability 1/4 is unbiased
+    EXPECT_NEAR(sum / num_finite, x, (hi - lo) * 0.05);
+  }
+}
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "fbgemm/FbgemmEmbedding.h"
+#include "fbgemm/Utils.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+CodeCacheStats embeddingCacheStats() {
+  for (const auto& stats : getCodeCacheStats()) {
+    if (stats.name == "embedding") {
+      return stats;
+    }
+  }
+  return CodeCacheStats{};
+}
+
+} // namespace
+
+TEST(CodeCacheStatsTest, countsHitsAndMisses) {
+  if (!fbgemmHasAvx2Support() || is_asmjit_disabled()) {
+    GTEST_SKIP() << "embedding kernels are not JIT generated";
+  }
+  const CodeCacheStats before = embeddingCacheStats();
+
+  // An unusual embedding dimension so no other test in this process has
+  // generated the kernel already.
+  GenerateEmbeddingSpMDM<float, int64_t, int64_t>(
+      /*block_size=*/91, /*has_weight=*/false, /*normalize_by_lengths=*/false);
+  const CodeCacheStats generated = embeddingCacheStats();
+  EXPECT_EQ(generated.name, "embedding");
+  EXPECT_EQ(generated.misses, before.misses + 1);
+  EXPECT_EQ(generated.num_kernels, before.num_kernels + 1);
+  EXPECT_GT(generated.code_bytes, before.code_bytes);
+
+  GenerateEmbeddingSpMDM<float, int64_t, int64_t>(
+      /*block_size=*/91, /*has_weight=*/false, /*normalize_by_lengths=*/false);
+  const CodeCacheStats hit = embeddingCacheStats();
+  EXPECT_EQ(hit.misses, generated.misses);
+  EXPECT_EQ(hit.hits, generated.hits + 1);
+
+  uint64_t histogram_total = 0;
+  for (uint64_t count : hit.generation_time_us_histogram) {
+    histogram_total += count;
+  }
+  EXPECT_EQ(histogram_total, hit.misses);
+}
+
+TEST(CodeCacheStatsTest, evictsLeastRecentlyUsed) {
+  if (!fbgemmHasAvx2Support() || is_asmjit_disabled()) {
+    GTEST_SKIP() << "embedding kernels are not JIT generated";
+  }
+  for (int block_size : {97, 98, 99}) {
+    GenerateEmbeddingSpMDM<float, int64_t, int64_t>(
+        block_size, /*has_weight=*/false, /*normalize_by_lengths=*/false);
+  }
+  const CodeCacheStats before = embeddingCacheStats();
+
+  setCodeCacheCapacity(2);
+  const CodeCacheStats evicted = embeddingCacheStats();
+  EXPECT_EQ(evicted.num_kernels, 2);
+  EXPECT_EQ(evicted.evictions, before.evictions + before.num_kernels - 2);
+
+  // The two most recently generated kernels are still cached.
+  GenerateEmbeddingSpMDM<float, int64_t, int64_t>(
+      /*block_size=*/99, /*has_weight=*/false, /*normalize_by_lengths=*/false);
+  EXPECT_EQ(embeddingCacheStats().misses, evicted.misses);
+  GenerateEmbeddingSpMDM<float, int64_t, int64_t>(
+      /*block_size=*/97, /*has_weight=*/false, /*normalize_by_lengths=*/false);
+  EXPECT_EQ(embeddingCacheStats().misses, evicted.misses + 1);
+
+  setCodeCacheCapacity(0);
+  EXPECT_GT(releaseEvictedCode(), 0);
+}
+
+TEST(CodeCacheStatsTest, oneEntryPerName) {
+  // Instantiations of different types add up to the same entry
+  GenerateEmbeddingSpMDM<float, int64_t, int64_t>(
+      /*block_size=*/93, /*has_weight=*/false, /*normalize_by_lengths=*/false);
+  GenerateEmbeddingSpMDM<uint8_t, int32_t, int32_t>(
+      /*block_size=*/93, /*has_weight=*/false, /*normalize_by_lengths=*/false);
+  const vector<CodeCacheStats> stats = getCodeCacheStats();
+  for (size_t i = 1; i < stats.size(); ++i) {
+    EXPECT_LT(stats[i - 1].name, stats[i].name);
+  }
+}
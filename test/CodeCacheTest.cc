@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "src/CodeCache.h"
+
+using namespace std;
+using namespace fbgemm;
+
+// Hits, misses and evictions from several threads at once, with a capacity
+// small enough that most misses evict and replace the lock-free table. Run
+// it with USE_SANITIZER=thread to check the lock-free lookups.
+TEST(CodeCacheTest, concurrentHitsMissesAndEvictions) {
+  constexpr int kNumThreads = 8;
+  constexpr int kNumKeys = 64;
+  constexpr int kCallsPerThread = 20000;
+  constexpr size_t kCapacity = 16;
+
+  CodeCache<int, int> cache("test");
+  cache.setCapacity(kCapacity);
+  atomic<int> generated{0};
+  atomic<int> released{0};
+
+  vector<thread> threads;
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&, t] {
+      minstd_rand generator(t);
+      // Mostly a few hot keys, so there are hits as well as evictions.
+      uniform_int_distribution<int> hot(0, kCapacity / 2 - 1);
+      uniform_int_distribution<int> any(0, kNumKeys - 1);
+      for (int i = 0; i < kCallsPerThread; ++i) {
+        const int key = i % 4 == 0 ? any(generator) : hot(generator);
+        const int value = cache.getOrCreate(key, [&] {
+          generated.fetch_add(1, memory_order_relaxed);
+          CodeCacheGeneration* generation = currentCodeCacheGeneration();
+          generation->codeBytes = 1;
+          generation->release = [&] {
+            released.fetch_add(1, memory_order_relaxed);
+          };
+          return 2 * key + 1;
+        });
+        ASSERT_EQ(value, 2 * key + 1);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  const CodeCacheStats stats = cache.getStats();
+  EXPECT_EQ(stats.hits + stats.misses, kNumThreads * kCallsPerThread);
+  EXPECT_EQ(stats.misses, generated.load());
+  EXPECT_GT(stats.evictions, 0);
+  EXPECT_LE(stats.num_kernels, kCapacity);
+  EXPECT_EQ(stats.num_kernels + stats.evictions, stats.misses);
+  EXPECT_EQ(cache.releaseEvicted(), stats.evictions);
+  EXPECT_EQ(released.load(), stats.evictions);
+}
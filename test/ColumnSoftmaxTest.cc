@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <cpuinfo.h>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "fbgemm/Utils.h"
+#include "src/ColumnSoftmax.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+using SoftmaxFn =
+    void (*)(int64_t, int64_t, const float*, int64_t, float*, int64_t);
+using SoftmaxBackwardFn = void (*)(
+    int64_t,
+    int64_t,
+    const float*,
+    int64_t,
+    const float*,
+    int64_t,
+    float*,
+    int64_t);
+
+void checkColumnSoftmax(SoftmaxFn softmax, SoftmaxBackwardFn backward) {
+  default_random_engine generator(1);
+  uniform_real_distribution<float> value_dist(-20, 20);
+  for (int64_t rows : {1, 2, 7, 64}) {
+    for (int64_t cols : {1, 5, 8, 16, 17, 40}) {
+      // Rows padded to test the leading dimensions
+      const int64_t ld = cols + 3;
+      vector<float> input(rows * ld), grad_output(rows * ld);
+      for (auto& x : input) {
+        x = value_dist(generator);
+      }
+      for (auto& x : grad_output) {
+        x = value_dist(generator);
+      }
+
+      vector<double> expected(rows * cols), expected_grad(rows * cols);
+      for (int64_t c = 0; c < cols; ++c) {
+        double max_value = input[c];
+        for (int64_t r = 1; r < rows; ++r) {
+          max_value = max<double>(max_value, input[r * ld + c]);
+        }
+        double sum = 0;
+        for (int64_t r = 0; r < rows; ++r) {
+          expected[r * cols + c] = exp(input[r * ld + c] - max_value);
+          sum += expected[r * cols + c];
+        }
+        double grad_sum = 0;
+        for (int64_t r = 0; r < rows; ++r) {
+          expected[r * cols + c] /= sum;
+          grad_sum += grad_output[r * ld + c] * expected[r * cols + c];
+        }
+        for (int64_t r = 0; r < rows; ++r) {
+          expected_grad[r * cols + c] =
+              (grad_output[r * ld + c] - grad_sum) * expected[r * cols + c];
+        }
+      }
+
+      // The padding of the rows must be left as is
+      vector<float> output(rows * ld, -1), grad_input(rows * ld, -1);
+      softmax(rows, cols, input.data(), ld, output.data(), ld);
+      backward(
+          rows,
+          cols,
+          grad_output.data(),
+          ld,
+          output.data(),
+          ld,
+          grad_input.data(),
+          ld);
+      for (int64_t r = 0; r < rows; ++r) {
+        for (int64_t c = 0; c < ld; ++c) {
+          if (c >= cols) {
+            EXPECT_EQ(output[r * ld + c], -1);
+            EXPECT_EQ(grad_input[r * ld + c], -1);
+            continue;
+          }
+          // Relative to the output, as the float input - max is rounded
+          const double y = expected[r * cols + c];
+          EXPECT_NEAR(output[r * ld + c], y, 1e-5 * y + 1e-30)
+              << rows << " x " << cols << " at " << r << ", " << c;
+          EXPECT_NEAR(
+              grad_input[r * ld + c], expected_grad[r * cols + c], 1e-4)
+              << rows << " x " << cols << " at " << r << ", " << c;
+        }
+      }
+    }
+  }
+}
+
+} // namespace
+
+TEST(ColumnSoftmaxTest, matchesReference) {
+  checkColumnSoftmax(column_softmax, column_softmax_backward);
+  if (!cpuinfo_initialize()) {
+    return;
+  }
+  if (fbgemmHasAvx2Support()) {
+    checkColumnSoftmax(
+        internal::column_softmax_avx2, internal::column_softmax_backward_avx2);
+  }
+  if (fbgemmHasAvx512Support()) {
+    checkColumnSoftmax(
+        internal::column_softmax_avx512,
+        internal::column_softmax_backward_avx512);
+  }
+}
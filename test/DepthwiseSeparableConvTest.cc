@@ -0,0 +1,212 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <gtest/gtest.h>
+
+#include "./TestUtils.h"
+#include "bench/BenchUtils.h"
+#include "fbgemm/Fbgemm.h"
+#include "src/RefImplementations.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+// {MB, C, OC, H, W, K, stride, per-channel quantization}
+class DepthwiseSeparableConvTest
+    : public testing::TestWithParam<
+          tuple<int, int, int, int, int, int, int, bool>> {};
+
+// Requantization parameters of one convolution.
+struct ConvQuantParams {
+  ConvQuantParams(
+      const conv_param_t<2>& conv_p,
+      const aligned_vector<int8_t>& B,
+      bool per_channel,
+      int32_t A_zero_point_)
+      : A_zero_point(A_zero_point_),
+        B_zero_point(per_channel ? conv_p.OC : 1),
+        C_multiplier(B_zero_point.size()),
+        col_offsets(conv_p.OC),
+        bias(conv_p.OC) {
+    randFill(B_zero_point, -3, 3);
+    randFill(C_multiplier, 0.1234f / 2, 0.1234f * 3 / 2);
+    randFill(bias, -8, 8);
+
+    // col_offsets_with_zero_pt_s8acc32_ref takes each group as K x N.
+    const int G = conv_p.G;
+    const int K = conv_p.K[0] * conv_p.K[1] * conv_p.IC / G;
+    const int N = conv_p.OC / G;
+    aligned_vector<int8_t> B_tr(B.size());
+    transposeConvWeights(conv_p, B.data(), B_tr.data());
+    for (int g = 0; g < G; ++g) {
+      col_offsets_with_zero_pt_s8acc32_ref(
+          K,
+          N,
+          N,
+          B_tr.data() + g * K * N,
+          B_zero_point.data() + (per_channel ? g * N : 0),
+          col_offsets.data() + g * N,
+          per_channel ? 1 : conv_p.OC);
+    }
+  }
+
+  template <bool FUSE_RELU, QuantizationGranularity Q_GRAN>
+  ReQuantizeOutput<FUSE_RELU, Q_GRAN> requantizer(
+      DoNothing<>& doNothingObj,
+      int C_zero_point,
+      int nCol,
+      int groups) const {
+    return ReQuantizeOutput<FUSE_RELU, Q_GRAN>(
+        doNothingObj,
+        C_multiplier.data(),
+        C_zero_point,
+        A_zero_point,
+        B_zero_point.data(),
+        nullptr, /* row offset buffer */
+        col_offsets.data(),
+        bias.data(),
+        nCol,
+        groups);
+  }
+
+  int32_t A_zero_point;
+  aligned_vector<int32_t> B_zero_point;
+  aligned_vector<float> C_multiplier;
+  vector<int32_t> col_offsets;
+  aligned_vector<int32_t> bias;
+};
+
+template <QuantizationGranularity Q_GRAN>
+void runTest(
+    int MB,
+    int C,
+    int OC,
+    int H,
+    int W,
+    int K,
+    int stride,
+    bool per_channel) {
+  conv_param_t<2> dw_conv_p(
+      MB,
+      C,
+      C,
+      {H, W},
+      C,
+      {K, K},
+      {stride, stride},
+      {(K - 1) / 2, (K - 1) / 2, (K - 1) / 2, (K - 1) / 2});
+  conv_param_t<2> pw_conv_p(
+      MB, C, OC, dw_conv_p.OUT_DIM, 1, {1, 1}, {1, 1}, {0, 0, 0, 0});
+  const int OH = dw_conv_p.OUT_DIM[0];
+  const int OW = dw_conv_p.OUT_DIM[1];
+
+  aligned_vector<uint8_t> A(MB * H * W * C);
+  randFill<uint8_t>(A, 0, 255);
+  aligned_vector<int8_t> dw_B(K * K * C);
+  randFill<int8_t>(dw_B, -8, 8);
+  aligned_vector<int8_t> pw_B(C * OC);
+  randFill<int8_t>(pw_B, -8, 8);
+
+  ConvQuantParams dw_q(dw_conv_p, dw_B, per_channel, 43);
+  const int32_t dw_C_zero_point = 5;
+  ConvQuantParams pw_q(pw_conv_p, pw_B, per_channel, dw_C_zero_point);
+  const int32_t pw_C_zero_point = 120;
+
+  PackWeightsForConv<2> dw_packed(dw_conv_p, dw_B.data());
+  PackWeightsForConv<2> pw_packed(pw_conv_p, pw_B.data());
+
+  // Reference: the two convolutions one after the other.
+  aligned_vector<uint8_t> mid(MB * OH * OW * C);
+  aligned_vector<int32_t> mid_int32(mid.size());
+  aligned_vector<uint8_t> C_ref(MB * OH * OW * OC);
+  aligned_vector<int32_t> C_int32(C_ref.size());
+  DoNothing<> doNothingObj{};
+  {
+    auto dw_req =
+        dw_q.requantizer<true, Q_GRAN>(doNothingObj, dw_C_zero_point, C, C);
+    fbgemmConv(
+        dw_conv_p,
+        A.data(),
+        dw_packed,
+        mid.data(),
+        mid_int32.data(),
+        dw_req,
+        0,
+        1);
+    auto pw_req =
+        pw_q.requantizer<false, Q_GRAN>(doNothingObj, pw_C_zero_point, OC, 1);
+    fbgemmConv(
+        pw_conv_p,
+        mid.data(),
+        pw_packed,
+        C_ref.data(),
+        C_int32.data(),
+        pw_req,
+        0,
+        1);
+  }
+
+  aligned_vector<uint8_t> C_fused(C_ref.size());
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  {
+    auto dw_req =
+        dw_q.requantizer<true, Q_GRAN>(doNothingObj, dw_C_zero_point, C, C);
+    auto pw_req =
+        pw_q.requantizer<false, Q_GRAN>(doNothingObj, pw_C_zero_point, OC, 1);
+    fbgemmDepthwiseSeparableConv(
+        dw_conv_p,
+        pw_conv_p,
+        A.data(),
+        dw_packed,
+        pw_packed,
+        dw_req,
+        C_fused.data(),
+        C_int32.data(),
+        pw_req,
+        fbgemm_get_thread_num(),
+        fbgemm_get_num_threads());
+  }
+
+  EXPECT_EQ(C_fused, C_ref);
+}
+
+} // namespace
+
+INSTANTIATE_TEST_CASE_P(
+    InstantiationName,
+    DepthwiseSeparableConvTest,
+    ::testing::Values(
+        make_tuple(1, 32, 64, 14, 14, 3, 1, false),
+        make_tuple(1, 64, 32, 112, 56, 3, 1, true),
+        make_tuple(2, 64, 48, 113, 56, 3, 2, false),
+        make_tuple(1, 256, 64, 28, 28, 5, 1, true),
+        make_tuple(1, 96, 40, 57, 40, 5, 2, true),
+        make_tuple(3, 8, 16, 5, 3, 3, 2, false)));
+
+TEST_P(DepthwiseSeparableConvTest, matchesTwoConvs) {
+  const auto [MB, C, OC, H, W, K, stride, per_channel] = GetParam();
+  if (per_channel) {
+    runTest<QuantizationGranularity::OUT_CHANNEL>(
+        MB, C, OC, H, W, K, stride, per_channel);
+  } else {
+    runTest<QuantizationGranularity::TENSOR>(
+        MB, C, OC, H, W, K, stride, per_channel);
+  }
+}
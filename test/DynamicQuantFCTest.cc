@@ -0,0 +1,184 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <gtest/gtest.h>
+
+#include "bench/BenchUtils.h"
+#include "fbgemm/Fbgemm.h"
+#include "src/RefImplementations.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+// {M, N, K, per-channel B quantization, fuse relu}
+class DynamicQuantFCTest
+    : public testing::TestWithParam<tuple<int, int, int, bool, bool>> {};
+
+template <bool FUSE_RELU>
+void runFC(
+    bool per_channel,
+    int m,
+    const float* A,
+    PackBMatrix<int8_t>& packedB,
+    const float* B_scale,
+    const int32_t* B_zero_point,
+    const int32_t* col_offsets,
+    const float* bias,
+    float* C,
+    int ldc,
+    int thread_id,
+    int num_threads) {
+  if (per_channel) {
+    fbgemmDynamicQuantFC<FUSE_RELU, QuantizationGranularity::OUT_CHANNEL>(
+        m,
+        A,
+        packedB,
+        B_scale,
+        B_zero_point,
+        col_offsets,
+        bias,
+        C,
+        ldc,
+        thread_id,
+        num_threads);
+  } else {
+    fbgemmDynamicQuantFC<FUSE_RELU, QuantizationGranularity::TENSOR>(
+        m,
+        A,
+        packedB,
+        B_scale,
+        B_zero_point,
+        col_offsets,
+        bias,
+        C,
+        ldc,
+        thread_id,
+        num_threads);
+  }
+}
+
+} // namespace
+
+INSTANTIATE_TEST_CASE_P(
+    InstantiationName,
+    DynamicQuantFCTest,
+    ::testing::Values(
+        make_tuple(1, 128, 512, false, false),
+        make_tuple(3, 50, 100, true, false),
+        make_tuple(17, 128, 64, false, true),
+        make_tuple(64, 200, 300, true, true),
+        make_tuple(128, 33, 1024, false, false)));
+
+TEST_P(DynamicQuantFCTest, matchesFloatReference) {
+  const auto [m, n, k, per_channel, fuse_relu] = GetParam();
+  default_random_engine generator;
+  uniform_real_distribution<float> a_dist(-3.f, 5.f);
+  uniform_int_distribution<int> b_dist(-128, 127);
+  uniform_int_distribution<int> zp_dist(-10, 10);
+  uniform_real_distribution<float> scale_dist(0.005f, 0.02f);
+
+  aligned_vector<float> A(m * k);
+  for (auto& v : A) {
+    v = a_dist(generator);
+  }
+  aligned_vector<int8_t> Bint8(k * n);
+  for (auto& v : Bint8) {
+    v = b_dist(generator);
+  }
+  const int nqparams = per_channel ? n : 1;
+  vector<float> B_scale(nqparams);
+  vector<int32_t> B_zero_point(nqparams);
+  for (int j = 0; j < nqparams; ++j) {
+    B_scale[j] = scale_dist(generator);
+    B_zero_point[j] = zp_dist(generator);
+  }
+  vector<float> bias(n);
+  for (auto& v : bias) {
+    v = a_dist(generator);
+  }
+
+  vector<int32_t> col_offsets(n);
+  col_offsets_with_zero_pt_s8acc32_ref(
+      k,
+      n,
+      n,
+      Bint8.data(),
+      B_zero_point.data(),
+      col_offsets.data(),
+      per_channel ? 1 : n);
+  PackBMatrix<int8_t> packedB(
+      matrix_op_t::NoTranspose, k, n, Bint8.data(), n, nullptr, 1);
+
+  // A is quantized to 8 bits over its range, so each product is off by at
+  // most half a quantization step of A times |B|.
+  float A_min = *min_element(A.begin(), A.end());
+  float A_max = *max_element(A.begin(), A.end());
+  const float A_step = (max(A_max, 0.f) - min(A_min, 0.f)) / 255;
+  vector<float> C_ref(m * n), tolerance(m * n);
+  for (int i = 0; i < m; ++i) {
+    for (int j = 0; j < n; ++j) {
+      const int q = per_channel ? j : 0;
+      double acc = bias[j], bound = 0;
+      for (int kk = 0; kk < k; ++kk) {
+        const double b = B_scale[q] * (Bint8[kk * n + j] - B_zero_point[q]);
+        acc += A[i * k + kk] * b;
+        bound += fabs(b);
+      }
+      C_ref[i * n + j] = fuse_relu ? max(acc, 0.0) : acc;
+      tolerance[i * n + j] = A_step / 2 * bound + 1e-3 * fabs(acc) + 1e-3;
+    }
+  }
+
+  vector<float> C_single(m * n);
+  auto run = fuse_relu ? runFC<true> : runFC<false>;
+  run(per_channel,
+      m,
+      A.data(),
+      packedB,
+      B_scale.data(),
+      B_zero_point.data(),
+      col_offsets.data(),
+      bias.data(),
+      C_single.data(),
+      n,
+      0,
+      1);
+  for (int i = 0; i < m * n; ++i) {
+    EXPECT_NEAR(C_single[i], C_ref[i], tolerance[i]) << "at " << i;
+  }
+
+  // The quantization parameters of A do not depend on the thread count.
+  vector<float> C(m * n);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  run(per_channel,
+      m,
+      A.data(),
+      packedB,
+      B_scale.data(),
+      B_zero_point.data(),
+      col_offsets.data(),
+      bias.data(),
+      C.data(),
+      n,
+      fbgemm_get_thread_num(),
+      fbgemm_get_num_threads());
+  EXPECT_EQ(C, C_single);
+}
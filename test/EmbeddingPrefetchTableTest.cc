@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "fbgemm/FbgemmEmbedding.h"
+
+using namespace std;
+using namespace fbgemm;
+
+TEST(EmbeddingPrefetchTableTest, lookupFallsBackToSmallerBlockSize) {
+  EXPECT_EQ(getEmbeddingPrefetchDistance(inst_set_t::avx2, 4, 64), 16);
+
+  setEmbeddingPrefetchDistance(inst_set_t::avx2, 4, 32, 8);
+  setEmbeddingPrefetchDistance(inst_set_t::avx2, 4, 256, 2);
+  EXPECT_EQ(getEmbeddingPrefetchDistance(inst_set_t::avx2, 4, 16), 8);
+  EXPECT_EQ(getEmbeddingPrefetchDistance(inst_set_t::avx2, 4, 32), 8);
+  EXPECT_EQ(getEmbeddingPrefetchDistance(inst_set_t::avx2, 4, 100), 8);
+  EXPECT_EQ(getEmbeddingPrefetchDistance(inst_set_t::avx2, 4, 256), 2);
+  EXPECT_EQ(getEmbeddingPrefetchDistance(inst_set_t::avx2, 4, 1024), 2);
+  // Other bit rates and instruction sets are not affected.
+  EXPECT_EQ(getEmbeddingPrefetchDistance(inst_set_t::avx2, 2, 64), 16);
+  EXPECT_EQ(getEmbeddingPrefetchDistance(inst_set_t::avx512, 4, 64), 16);
+}
+
+TEST(EmbeddingPrefetchTableTest, loadsTableFile) {
+  const filesystem::path path = filesystem::temp_directory_path() /
+      ("fbgemm_prefetch_table_" + to_string(random_device()()));
+  {
+    ofstream out(path);
+    out << "# ISA bit_rate block_size prefetch\n"
+        << "AVX512 32 128 4\n"
+        << "avx512_e1 8 64 0\n";
+  }
+  EXPECT_TRUE(loadEmbeddingPrefetchTable(path.string()));
+  EXPECT_EQ(getEmbeddingPrefetchDistance(inst_set_t::avx512, 32, 512), 4);
+  EXPECT_EQ(getEmbeddingPrefetchDistance(inst_set_t::avx512_vnni, 8, 64), 0);
+
+  {
+    ofstream out(path);
+    out << "AVX512 32\n";
+  }
+  EXPECT_FALSE(loadEmbeddingPrefetchTable(path.string()));
+  filesystem::remove(path);
+  EXPECT_FALSE(loadEmbeddingPrefetchTable(path.string()));
+}
+
+TEST(EmbeddingPrefetchTableTest, crossTablePrefetch) {
+  const int num_indices = getEmbeddingCrossTablePrefetch();
+  setEmbeddingCrossTablePrefetch(4);
+  EXPECT_EQ(getEmbeddingCrossTablePrefetch(), 4);
+  setEmbeddingCrossTablePrefetch(-1);
+  EXPECT_EQ(getEmbeddingCrossTablePrefetch(), 0);
+  setEmbeddingCrossTablePrefetch(num_indices);
+
+  // Out of range indices must not be dereferenced
+  const vector<uint8_t> weights(3 * 100);
+  const vector<int64_t> indices = {2, -1, 3, 0, 1000000};
+  prefetchEmbeddingRows(weights.data(), 3, 100, indices.data(), 5);
+  const vector<int32_t> indices32 = {1, 7};
+  prefetchEmbeddingRows(weights.data(), 3, 100, indices32.data(), 2);
+}
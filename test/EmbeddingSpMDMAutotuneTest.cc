@@ -0,0 +1,187 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "fbgemm/FbgemmEmbedding.h"
+#include "fbgemm/QuantUtils.h"
+#include "fbgemm/Utils.h"
+#include "src/RefImplementations.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+// The flag is read once, so it is set before any test runs
+const bool autotune_set = [] {
+#ifdef _WIN32
+  return _putenv_s("FBGEMM_AUTOTUNE_EMBEDDING", "1") == 0;
+#else
+  return setenv("FBGEMM_AUTOTUNE_EMBEDDING", "1", 1) == 0;
+#endif
+}();
+
+constexpr int64_t kNumRows = 300;
+constexpr int64_t kBatchSize = 40;
+constexpr int kAverageLen = 10;
+
+struct Batch {
+  vector<int64_t> indices;
+  vector<int32_t> offsets;
+  vector<float> weights;
+};
+
+Batch makeBatch(default_random_engine& generator) {
+  Batch batch;
+  uniform_int_distribution<int> length_dist(0, 2 * kAverageLen);
+  uniform_int_distribution<int64_t> index_dist(0, kNumRows - 1);
+  uniform_real_distribution<float> weight_dist(-1.0f, 1.0f);
+  batch.offsets.push_back(0);
+  for (int64_t b = 0; b < kBatchSize; ++b) {
+    batch.offsets.push_back(batch.offsets.back() + length_dist(generator));
+  }
+  for (int32_t i = 0; i < batch.offsets.back(); ++i) {
+    batch.indices.push_back(index_dist(generator));
+    batch.weights.push_back(weight_dist(generator));
+  }
+  return batch;
+}
+
+vector<float> makeTable(int64_t block_size, default_random_engine& generator) {
+  uniform_real_distribution<float> dist(-2.0f, 2.0f);
+  vector<float> table(kNumRows * block_size);
+  for (auto& v : table) {
+    v = dist(generator);
+  }
+  return table;
+}
+
+class EmbeddingSpMDMAutotuneTest
+    : public testing::TestWithParam<tuple<int, int, bool>> {};
+
+INSTANTIATE_TEST_SUITE_P(
+    InstantiationName,
+    EmbeddingSpMDMAutotuneTest,
+    ::testing::Combine(
+        ::testing::Values(32, 8, 4), // bit rate of the table
+        ::testing::Values(1, 16, 67), // block_size
+        ::testing::Bool())); // has_weight
+
+} // namespace
+
+// Whichever implementation wins, the kernels compute what the reference does,
+// also when the winner is taken from the cache.
+TEST_P(EmbeddingSpMDMAutotuneTest, matchesReference) {
+  ASSERT_TRUE(autotune_set);
+  EXPECT_TRUE(is_embedding_autotune_enabled());
+  const auto [bit_rate, block_size, has_weight] = GetParam();
+  default_random_engine generator;
+  const vector<float> table = makeTable(block_size, generator);
+  const Batch batch = makeBatch(generator);
+  const float* weights = has_weight ? batch.weights.data() : nullptr;
+  const int64_t index_size = batch.indices.size();
+
+  vector<float> out_ref(kBatchSize * block_size);
+  for (int call = 0; call < 2; ++call) {
+    vector<float> out(kBatchSize * block_size);
+    bool success, success_ref;
+    if (bit_rate == 32) {
+      auto kernel = GenerateEmbeddingSpMDM<float, int64_t, int32_t>(
+          block_size, has_weight, /*normalize_by_lengths=*/false);
+      success = kernel(
+          kBatchSize,
+          index_size,
+          kNumRows,
+          table.data(),
+          batch.indices.data(),
+          batch.offsets.data(),
+          weights,
+          out.data());
+      success_ref = EmbeddingSpMDM_ref(
+          block_size,
+          kBatchSize,
+          index_size,
+          kNumRows,
+          table.data(),
+          batch.indices.data(),
+          batch.offsets.data(),
+          weights,
+          false,
+          out_ref.data());
+    } else if (bit_rate == 8) {
+      const int64_t row_bytes = block_size + 2 * sizeof(float);
+      vector<uint8_t> fused(kNumRows * row_bytes);
+      FloatOrHalfToFused8BitRowwiseQuantizedSBFloat<float>(
+          table.data(), kNumRows, block_size, fused.data());
+      auto kernel = GenerateEmbeddingSpMDM<uint8_t, int64_t, int32_t>(
+          block_size, has_weight, /*normalize_by_lengths=*/false);
+      success = kernel(
+          kBatchSize,
+          index_size,
+          kNumRows,
+          fused.data(),
+          batch.indices.data(),
+          batch.offsets.data(),
+          weights,
+          out.data());
+      success_ref = EmbeddingSpMDM_ref(
+          block_size,
+          kBatchSize,
+          index_size,
+          kNumRows,
+          fused.data(),
+          batch.indices.data(),
+          batch.offsets.data(),
+          weights,
+          false,
+          out_ref.data());
+    } else {
+      const int64_t row_bytes =
+          (block_size * bit_rate + 7) / 8 + 2 * sizeof(uint16_t);
+      vector<uint8_t> fused(kNumRows * row_bytes);
+      FloatOrHalfToFusedNBitRowwiseQuantizedSBHalf<float>(
+          bit_rate, table.data(), kNumRows, block_size, fused.data());
+      auto kernel = GenerateEmbeddingSpMDMNBit<int64_t, int32_t>(
+          bit_rate, block_size, has_weight, /*normalize_by_lengths=*/false);
+      success = kernel(
+          kBatchSize,
+          index_size,
+          kNumRows,
+          fused.data(),
+          batch.indices.data(),
+          batch.offsets.data(),
+          weights,
+          out.data());
+      success_ref = EmbeddingSpMDMNBit_ref(
+          bit_rate,
+          block_size,
+          kBatchSize,
+          index_size,
+          kNumRows,
+          fused.data(),
+          batch.indices.data(),
+          batch.offsets.data(),
+          weights,
+          false,
+          out_ref.data());
+    }
+    ASSERT_TRUE(success_ref);
+    EXPECT_TRUE(success);
+    for (size_t i = 0; i < out.size(); ++i) {
+      EXPECT_NEAR(out[i], out_ref[i], 1e-3f * (1 + abs(out_ref[i])))
+          << "call " << call << ", element " << i;
+    }
+  }
+}
@@ -0,0 +1,241 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "fbgemm/FbgemmEmbedding.h"
+#include "src/RefImplementations.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+class EmbeddingSpMDMBf16DotTest
+    : public testing::TestWithParam<tuple<int, bool, bool, bool>> {};
+
+} // namespace
+
+INSTANTIATE_TEST_CASE_P(
+    InstantiationName,
+    EmbeddingSpMDMBf16DotTest,
+    ::testing::Combine(
+        ::testing::Values(1, 16, 33, 64, 100, 300), // embedding_dim
+        ::testing::Bool(), // has_weight
+        ::testing::Bool(), // normalize_by_lengths
+        ::testing::Bool())); // is_weight_positional
+
+TEST_P(EmbeddingSpMDMBf16DotTest, matchesReference) {
+  const auto [embedding_dim, has_weight, normalize_by_lengths, positional] =
+      GetParam();
+  const int64_t batch_size = 37;
+  const int64_t num_rows = 1000;
+  const int max_len = 20;
+
+  default_random_engine generator;
+  uniform_real_distribution<float> value_distribution(-2.0f, 2.0f);
+  vector<uint16_t> embedding_table(num_rows * embedding_dim);
+  // Absolute values of the rows and weights, to bound the rounding error.
+  vector<uint16_t> abs_table(embedding_table.size());
+  for (size_t i = 0; i < embedding_table.size(); ++i) {
+    embedding_table[i] = cpu_float2bfloat16(value_distribution(generator));
+    abs_table[i] = embedding_table[i] & 0x7fff;
+  }
+
+  uniform_int_distribution<int> length_distribution(0, max_len);
+  vector<int32_t> offsets(batch_size + 1, 0);
+  for (int64_t b = 0; b < batch_size; ++b) {
+    offsets[b + 1] = offsets[b] + length_distribution(generator);
+  }
+  const int64_t index_size = offsets.back();
+  uniform_int_distribution<int64_t> index_distribution(0, num_rows - 1);
+  vector<int64_t> indices(index_size);
+  for (auto& v : indices) {
+    v = index_distribution(generator);
+  }
+  vector<float> weights(positional ? max_len : index_size);
+  vector<float> abs_weights(weights.size());
+  for (size_t i = 0; i < weights.size(); ++i) {
+    weights[i] = value_distribution(generator);
+    abs_weights[i] = fabs(weights[i]);
+  }
+
+  vector<float> output_ref(batch_size * embedding_dim);
+  vector<float> bound(output_ref.size());
+  for (auto [table, w, o] :
+       {make_tuple(&embedding_table, &weights, &output_ref),
+        make_tuple(&abs_table, &abs_weights, &bound)}) {
+    bool success_ref = EmbeddingSpMDM_ref(
+        embedding_dim,
+        batch_size,
+        index_size,
+        num_rows,
+        table->data(),
+        indices.data(),
+        offsets.data(),
+        has_weight ? w->data() : nullptr,
+        normalize_by_lengths,
+        o->data(),
+        positional,
+        /*use_offsets=*/true,
+        /*output_stride=*/-1,
+        /*input_stride=*/-1,
+        /*scale_bias_last=*/true,
+        /*no_bag=*/false,
+        /*is_bf16_out=*/false,
+        /*is_bf16_in=*/true);
+    ASSERT_TRUE(success_ref);
+  }
+
+  auto kernel = GenerateEmbeddingSpMDMBf16Dot<int64_t>(
+      embedding_dim,
+      has_weight,
+      normalize_by_lengths,
+      /*prefetch=*/16,
+      positional);
+  vector<float> output(output_ref.size(), -1.0f);
+  bool success = kernel(
+      batch_size,
+      index_size,
+      num_rows,
+      embedding_table.data(),
+      indices.data(),
+      offsets.data(),
+      has_weight ? weights.data() : nullptr,
+      output.data());
+  EXPECT_TRUE(success);
+  // Weights are rounded to bfloat16 (relative error 2^-9 per product).
+  for (size_t i = 0; i < output.size(); ++i) {
+    EXPECT_NEAR(output[i], output_ref[i], 1e-2f * bound[i] + 1e-6f)
+        << "results differ at " << i;
+  }
+
+  // Output rows are written with masks, so a larger output_stride must leave
+  // the padding untouched.
+  const int64_t output_stride = embedding_dim + 3;
+  auto strided_kernel = GenerateEmbeddingSpMDMBf16Dot<int64_t>(
+      embedding_dim,
+      has_weight,
+      normalize_by_lengths,
+      /*prefetch=*/16,
+      positional,
+      /*use_offsets=*/true,
+      output_stride);
+  vector<float> strided_output(batch_size * output_stride, -1.0f);
+  success = strided_kernel(
+      batch_size,
+      index_size,
+      num_rows,
+      embedding_table.data(),
+      indices.data(),
+      offsets.data(),
+      has_weight ? weights.data() : nullptr,
+      strided_output.data());
+  EXPECT_TRUE(success);
+  for (int64_t b = 0; b < batch_size; ++b) {
+    for (int64_t d = 0; d < output_stride; ++d) {
+      EXPECT_EQ(
+          strided_output[b * output_stride + d],
+          d < embedding_dim ? output[b * embedding_dim + d] : -1.0f)
+          << "results differ at bag " << b << " column " << d;
+    }
+  }
+
+  if (index_size > 0) {
+    indices[index_size / 2] = num_rows;
+    success = kernel(
+        batch_size,
+        index_size,
+        num_rows,
+        embedding_table.data(),
+        indices.data(),
+        offsets.data(),
+        has_weight ? weights.data() : nullptr,
+        output.data());
+    EXPECT_FALSE(success);
+  }
+}
+
+TEST(EmbeddingSpMDMBf16DotTest, bf16AndFp16Output) {
+  const int64_t embedding_dim = 70;
+  const int64_t batch_size = 9;
+  const int64_t num_rows = 50;
+
+  default_random_engine generator;
+  uniform_real_distribution<float> value_distribution(-1.0f, 1.0f);
+  vector<uint16_t> embedding_table(num_rows * embedding_dim);
+  for (auto& v : embedding_table) {
+    v = cpu_float2bfloat16(value_distribution(generator));
+  }
+  vector<int32_t> offsets(batch_size + 1);
+  for (int64_t b = 0; b <= batch_size; ++b) {
+    offsets[b] = 3 * b;
+  }
+  const int64_t index_size = offsets.back();
+  vector<int32_t> indices(index_size);
+  for (int64_t i = 0; i < index_size; ++i) {
+    indices[i] = (i * 7) % num_rows;
+  }
+
+  vector<float> output_ref(batch_size * embedding_dim);
+  bool success_ref = EmbeddingSpMDM_ref(
+      embedding_dim,
+      batch_size,
+      index_size,
+      num_rows,
+      embedding_table.data(),
+      indices.data(),
+      offsets.data(),
+      /*weights=*/nullptr,
+      /*normalize_by_lengths=*/false,
+      output_ref.data(),
+      /*is_weight_positional=*/false,
+      /*use_offsets=*/true,
+      /*output_stride=*/-1,
+      /*input_stride=*/-1,
+      /*scale_bias_last=*/true,
+      /*no_bag=*/false,
+      /*is_bf16_out=*/false,
+      /*is_bf16_in=*/true);
+  ASSERT_TRUE(success_ref);
+
+  for (bool is_bf16_out : {false, true}) {
+    auto kernel = GenerateEmbeddingSpMDMBf16Dot<int32_t, int32_t, uint16_t>(
+        embedding_dim,
+        /*has_weight=*/false,
+        /*normalize_by_lengths=*/false,
+        /*prefetch=*/16,
+        /*is_weight_positional=*/false,
+        /*use_offsets=*/true,
+        /*output_stride=*/-1,
+        /*input_stride=*/-1,
+        is_bf16_out);
+    vector<uint16_t> output(output_ref.size());
+    bool success = kernel(
+        batch_size,
+        index_size,
+        num_rows,
+        embedding_table.data(),
+        indices.data(),
+        offsets.data(),
+        nullptr,
+        output.data());
+    EXPECT_TRUE(success);
+    for (size_t i = 0; i < output.size(); ++i) {
+      const float actual = is_bf16_out ? cpu_bf162float(output[i])
+                                       : cpu_half2float(output[i]);
+      EXPECT_NEAR(actual, output_ref[i], 1e-2f * (fabs(output_ref[i]) + 1e-2f))
+          << "results differ at " << i << " is_bf16_out " << is_bf16_out;
+    }
+  }
+}
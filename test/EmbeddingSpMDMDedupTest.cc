@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "fbgemm/FbgemmEmbedding.h"
+#include "fbgemm/QuantUtils.h"
+#include "src/RefImplementations.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+class EmbeddingSpMDMDedupTest
+    : public testing::TestWithParam<tuple<int, int, bool, bool, bool>> {};
+
+} // namespace
+
+INSTANTIATE_TEST_CASE_P(
+    InstantiationName,
+    EmbeddingSpMDMDedupTest,
+    ::testing::Combine(
+        ::testing::Values(8, 4, 2), // bit_rate
+        ::testing::Values(4, 32, 100), // embedding_dim
+        ::testing::Bool(), // has_weight
+        ::testing::Bool(), // use_offsets
+        ::testing::Bool())); // padded input rows
+
+// Must match pooling each lookup from the quantized rows, when the bags of the
+// batch share most of their rows.
+TEST_P(EmbeddingSpMDMDedupTest, matchesReference) {
+  const auto [bit_rate, embedding_dim, has_weight, use_offsets, padded] =
+      GetParam();
+  const int64_t batch_size = 150;
+  const int64_t num_rows = 300;
+  const int64_t num_hot_rows = 20;
+
+  default_random_engine generator;
+  uniform_real_distribution<float> value_distribution(-2.0f, 2.0f);
+  vector<float> float_table(num_rows * embedding_dim);
+  for (auto& v : float_table) {
+    v = value_distribution(generator);
+  }
+  int64_t row_bytes;
+  if (bit_rate == 8) {
+    row_bytes = embedding_dim + 2 * sizeof(float);
+  } else {
+    const int num_elem_per_byte = 8 / bit_rate;
+    row_bytes = (embedding_dim + num_elem_per_byte - 1) / num_elem_per_byte +
+        2 * sizeof(float16);
+  }
+  vector<uint8_t> packed_table(num_rows * row_bytes);
+  if (bit_rate == 8) {
+    FloatOrHalfToFused8BitRowwiseQuantizedSBFloat<float>(
+        float_table.data(), num_rows, embedding_dim, packed_table.data());
+  } else {
+    FloatOrHalfToFusedNBitRowwiseQuantizedSBHalf<float>(
+        bit_rate,
+        float_table.data(),
+        num_rows,
+        embedding_dim,
+        packed_table.data());
+  }
+  const int64_t input_stride = padded ? row_bytes + 5 : row_bytes;
+  vector<uint8_t> table(num_rows * input_stride);
+  for (int64_t r = 0; r < num_rows; ++r) {
+    copy(
+        packed_table.begin() + r * row_bytes,
+        packed_table.begin() + (r + 1) * row_bytes,
+        table.begin() + r * input_stride);
+  }
+
+  // Nine in ten lookups go to a few hot rows
+  uniform_int_distribution<int> length_distribution(0, 20);
+  uniform_int_distribution<int> hot_distribution(0, 9);
+  uniform_int_distribution<int64_t> hot_index_distribution(0, num_hot_rows - 1);
+  uniform_int_distribution<int64_t> index_distribution(0, num_rows - 1);
+  vector<int32_t> lengths(batch_size), offsets(batch_size + 1);
+  for (int64_t b = 0; b < batch_size; ++b) {
+    lengths[b] = length_distribution(generator);
+    offsets[b + 1] = offsets[b] + lengths[b];
+  }
+  vector<int64_t> indices(offsets[batch_size]);
+  vector<float> weights(indices.size());
+  for (size_t i = 0; i < indices.size(); ++i) {
+    indices[i] = hot_distribution(generator)
+        ? 3 * hot_index_distribution(generator)
+        : index_distribution(generator);
+    weights[i] = value_distribution(generator);
+  }
+  const int32_t* offsets_or_lengths =
+      use_offsets ? offsets.data() : lengths.data();
+  const float* weights_ptr = has_weight ? weights.data() : nullptr;
+
+  vector<float> out(batch_size * embedding_dim);
+  vector<float> out_ref(batch_size * embedding_dim);
+  auto kernel = GenerateEmbeddingSpMDMDedup<int64_t, int32_t>(
+      bit_rate,
+      embedding_dim,
+      has_weight,
+      /*normalize_by_lengths=*/false,
+      /*prefetch=*/16,
+      /*is_weight_positional=*/false,
+      use_offsets,
+      /*output_stride=*/-1,
+      input_stride);
+  const bool success = kernel(
+      batch_size,
+      indices.size(),
+      num_rows,
+      table.data(),
+      indices.data(),
+      offsets_or_lengths,
+      weights_ptr,
+      out.data());
+  bool success_ref;
+  if (bit_rate == 8) {
+    success_ref = EmbeddingSpMDM_ref(
+        embedding_dim,
+        batch_size,
+        indices.size(),
+        num_rows,
+        table.data(),
+        indices.data(),
+        offsets_or_lengths,
+        weights_ptr,
+        /*normalize_by_lengths=*/false,
+        out_ref.data(),
+        /*is_weight_positional=*/false,
+        use_offsets,
+        /*output_stride=*/-1,
+        input_stride);
+  } else {
+    success_ref = EmbeddingSpMDMNBit_ref(
+        bit_rate,
+        embedding_dim,
+        batch_size,
+        indices.size(),
+        num_rows,
+        table.data(),
+        indices.data(),
+        offsets_or_lengths,
+        weights_ptr,
+        /*normalize_by_lengths=*/false,
+        out_ref.data(),
+        /*is_weight_positional=*/false,
+        use_offsets,
+        /*output_stride=*/-1,
+        input_stride);
+  }
+  ASSERT_TRUE(success_ref);
+  EXPECT_TRUE(success);
+  for (size_t i = 0; i < out.size(); ++i) {
+    EXPECT_NEAR(out[i], out_ref[i], 1e-3f * (1 + abs(out_ref[i])))
+        << "element " << i;
+  }
+}
+
+TEST(EmbeddingSpMDMDedupTest, outOfBoundIndices) {
+  const int64_t embedding_dim = 8, num_rows = 4;
+  vector<float> float_table(num_rows * embedding_dim, 1.0f);
+  vector<uint8_t> table(num_rows * (embedding_dim + 2 * sizeof(float)));
+  FloatOrHalfToFused8BitRowwiseQuantizedSBFloat<float>(
+      float_table.data(), num_rows, embedding_dim, table.data());
+  const vector<int64_t> indices = {0, 3, 4};
+  const vector<int32_t> offsets = {0, 3};
+  vector<float> out(embedding_dim);
+  auto kernel = GenerateEmbeddingSpMDMDedup<int64_t, int32_t>(
+      8, embedding_dim, /*has_weight=*/false, /*normalize_by_lengths=*/false);
+  EXPECT_FALSE(kernel(
+      1,
+      indices.size(),
+      num_rows,
+      table.data(),
+      indices.data(),
+      offsets.data(),
+      nullptr,
+      out.data()));
+}
@@ -0,0 +1,213 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "fbgemm/FbgemmConvert.h"
+#include "fbgemm/FbgemmEmbedding.h"
+#include "src/RefImplementations.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+// {embedding_dim, has_weight, normalize_by_lengths, is_weight_positional,
+// exponent bits}
+class EmbeddingSpMDMFP8Test
+    : public testing::TestWithParam<tuple<int, bool, bool, bool, int>> {};
+
+} // namespace
+
+INSTANTIATE_TEST_CASE_P(
+    InstantiationName,
+    EmbeddingSpMDMFP8Test,
+    ::testing::Combine(
+        ::testing::Values(1, 16, 33, 64, 100, 300), // embedding_dim
+        ::testing::Bool(), // has_weight
+        ::testing::Bool(), // normalize_by_lengths
+        ::testing::Bool(), // is_weight_positional
+        ::testing::Values(4, 5))); // exponent bits
+
+TEST_P(EmbeddingSpMDMFP8Test, matchesReference) {
+  const auto
+      [embedding_dim, has_weight, normalize_by_lengths, positional, ebits] =
+          GetParam();
+  const int exponent_bias = ebits == 4 ? 7 : 15;
+  const int64_t batch_size = 37;
+  const int64_t num_rows = 1000;
+  const int max_len = 20;
+  // Rows padded to check input_stride
+  const int64_t input_stride = embedding_dim + 5;
+
+  default_random_engine generator;
+  uniform_real_distribution<float> value_distribution(-2.0f, 2.0f);
+  vector<uint8_t> embedding_table(num_rows * input_stride);
+  for (auto& v : embedding_table) {
+    FloatToFloat8_ref(value_distribution(generator), &v, ebits, exponent_bias);
+  }
+
+  uniform_int_distribution<int> length_distribution(0, max_len);
+  vector<int32_t> offsets(batch_size + 1, 0);
+  for (int64_t b = 0; b < batch_size; ++b) {
+    offsets[b + 1] = offsets[b] + length_distribution(generator);
+  }
+  const int64_t index_size = offsets.back();
+  uniform_int_distribution<int64_t> index_distribution(0, num_rows - 1);
+  vector<int64_t> indices(index_size);
+  for (auto& v : indices) {
+    v = index_distribution(generator);
+  }
+  vector<float> weights(positional ? max_len : index_size);
+  for (auto& w : weights) {
+    w = value_distribution(generator);
+  }
+
+  // Output rows are written with masks, so a larger output_stride must leave
+  // the padding untouched.
+  for (int64_t output_stride : {embedding_dim, embedding_dim + 3}) {
+    vector<float> output_ref(batch_size * output_stride, -1.0f);
+    vector<float> output(output_ref.size(), -1.0f);
+    bool success_ref = EmbeddingSpMDMFP8_ref(
+        embedding_dim,
+        batch_size,
+        index_size,
+        num_rows,
+        embedding_table.data(),
+        indices.data(),
+        offsets.data(),
+        has_weight ? weights.data() : nullptr,
+        normalize_by_lengths,
+        output_ref.data(),
+        positional,
+        /*use_offsets=*/true,
+        output_stride,
+        input_stride,
+        ebits,
+        exponent_bias);
+    ASSERT_TRUE(success_ref);
+
+    auto kernel = GenerateEmbeddingSpMDMFP8WithStrides<int64_t>(
+        embedding_dim,
+        normalize_by_lengths,
+        positional,
+        /*use_offsets=*/true,
+        output_stride,
+        input_stride,
+        ebits,
+        exponent_bias);
+    bool success = kernel(
+        batch_size,
+        index_size,
+        num_rows,
+        embedding_table.data(),
+        indices.data(),
+        offsets.data(),
+        has_weight ? weights.data() : nullptr,
+        output.data());
+    EXPECT_TRUE(success);
+    // Same decoding and the same fused multiply-adds in the same order
+    EXPECT_EQ(output, output_ref) << "output_stride " << output_stride;
+
+    if (index_size > 0) {
+      indices[index_size / 2] = num_rows;
+      success = kernel(
+          batch_size,
+          index_size,
+          num_rows,
+          embedding_table.data(),
+          indices.data(),
+          offsets.data(),
+          has_weight ? weights.data() : nullptr,
+          output.data());
+      EXPECT_FALSE(success);
+      indices[index_size / 2] = 0;
+
+      success = kernel(
+          batch_size,
+          index_size - 1,
+          num_rows,
+          embedding_table.data(),
+          indices.data(),
+          offsets.data(),
+          has_weight ? weights.data() : nullptr,
+          output.data());
+      EXPECT_FALSE(success);
+    }
+  }
+}
+
+TEST(EmbeddingSpMDMFP8Test, bf16AndFp16Output) {
+  const int64_t embedding_dim = 70;
+  const int64_t batch_size = 9;
+  const int64_t num_rows = 50;
+
+  default_random_engine generator;
+  uniform_real_distribution<float> value_distribution(-1.0f, 1.0f);
+  vector<uint8_t> embedding_table(num_rows * embedding_dim);
+  for (auto& v : embedding_table) {
+    FloatToFloat8_ref(value_distribution(generator), &v, 4, 7);
+  }
+  vector<int32_t> lengths(batch_size, 3);
+  const int64_t index_size = 3 * batch_size;
+  vector<int32_t> indices(index_size);
+  for (int64_t i = 0; i < index_size; ++i) {
+    indices[i] = (i * 7) % num_rows;
+  }
+
+  for (bool is_bf16_out : {false, true}) {
+    vector<uint16_t> output_ref(batch_size * embedding_dim);
+    bool success_ref = EmbeddingSpMDMFP8_ref(
+        embedding_dim,
+        batch_size,
+        index_size,
+        num_rows,
+        embedding_table.data(),
+        indices.data(),
+        lengths.data(),
+        /*weights=*/nullptr,
+        /*normalize_by_lengths=*/true,
+        output_ref.data(),
+        /*is_weight_positional=*/false,
+        /*use_offsets=*/false,
+        /*output_stride=*/-1,
+        /*input_stride=*/-1,
+        /*exponent_bits=*/4,
+        /*exponent_bias=*/7,
+        is_bf16_out);
+    ASSERT_TRUE(success_ref);
+
+    auto kernel =
+        GenerateEmbeddingSpMDMFP8WithStrides<int32_t, int32_t, uint16_t>(
+            embedding_dim,
+            /*normalize_by_lengths=*/true,
+            /*is_weight_positional=*/false,
+            /*use_offsets=*/false,
+            /*output_stride=*/-1,
+            /*input_stride=*/-1,
+            /*exponent_bits=*/4,
+            /*exponent_bias=*/7,
+            is_bf16_out);
+    vector<uint16_t> output(output_ref.size());
+    bool success = kernel(
+        batch_size,
+        index_size,
+        num_rows,
+        embedding_table.data(),
+        indices.data(),
+        lengths.data(),
+        nullptr,
+        output.data());
+    EXPECT_TRUE(success);
+    EXPECT_EQ(output, output_ref) << "is_bf16_out " << is_bf16_out;
+  }
+}
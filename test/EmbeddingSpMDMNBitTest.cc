@@ -17,6 +17,7 @@
 #include "./EmbeddingSpMDMTestUtils.h"
 #include "fbgemm/Fbgemm.h"
 #include "fbgemm/FbgemmConvert.h"
+#include "fbgemm/QuantUtils.h"
 #include "src/RefImplementations.h"
 
 using namespace std;
@@ -635,3 +636,95 @@ TEST_P(FusedNBitRowwiseEmbeddingLookupTest, rowwiseSparseTest) {
     }
   } // end for input
 }
+
+// Groupwise rows pool to the sum of their dequantized rows
+TEST(FusedNBitGroupwiseEmbeddingLookupTest, matchesDequantizedSum) {
+  default_random_engine generator;
+  normal_distribution<float> embedding_distribution;
+
+  const int batch_size = 10;
+  const int num_rows = 400;
+  const int embedding_dim = 128;
+  const int average_len = 20;
+
+  vector<int64_t> lengths, offsets, indices;
+  vector<int32_t> lengths_32, offsets_32, indices_32;
+  vector<float> weights;
+  const int lengths_sum = GenerateLengthsIndicesWeights(
+      lengths,
+      lengths_32,
+      offsets,
+      offsets_32,
+      indices,
+      indices_32,
+      weights,
+      batch_size,
+      num_rows,
+      average_len,
+      NONE);
+
+  vector<float> embedding_table(num_rows * embedding_dim);
+  for (int i = 0; i < num_rows; ++i) {
+    // Groups of very different ranges, which one scale per row would lose
+    for (int j = 0; j < embedding_dim; ++j) {
+      embedding_table[i * embedding_dim + j] =
+          embedding_distribution(generator) * (1 + j / 16);
+    }
+  }
+
+  for (int bit_rate : {2, 4}) {
+    for (int group_size : {8, 32, 64, embedding_dim}) {
+      const int fused_embedding_dim = embedding_dim / (8 / bit_rate) +
+          embedding_dim / group_size * 2 * sizeof(float16);
+      vector<uint8_t> fused_embedding_table(num_rows * fused_embedding_dim);
+      FloatOrHalfToFusedNBitGroupwiseQuantizedSBHalf<float>(
+          bit_rate,
+          group_size,
+          embedding_table.data(),
+          num_rows,
+          embedding_dim,
+          fused_embedding_table.data());
+      vector<float> dequantized_table(num_rows * embedding_dim);
+      FusedNBitGroupwiseQuantizedSBHalfToFloatOrHalf<float>(
+          bit_rate,
+          group_size,
+          fused_embedding_table.data(),
+          num_rows,
+          fused_embedding_dim,
+          dequantized_table.data());
+
+      vector<float> output_ref(batch_size * embedding_dim);
+      for (int m = 0; m < batch_size; ++m) {
+        for (int i = offsets[m]; i < offsets[m + 1]; ++i) {
+          for (int j = 0; j < embedding_dim; ++j) {
+            output_ref[m * embedding_dim + j] += weights[i] *
+                dequantized_table[indices[i] * embedding_dim + j];
+          }
+        }
+      }
+
+      vector<float> output(output_ref.size());
+      auto kernel = GenerateEmbeddingSpMDMNBitGroupwise<int64_t>(
+          bit_rate,
+          group_size,
+          embedding_dim,
+          /*has_weight=*/true,
+          /*normalize_by_lengths=*/false);
+      const bool success = kernel(
+          batch_size,
+          lengths_sum,
+          num_rows,
+          fused_embedding_table.data(),
+          indices.data(),
+          offsets_32.data(),
+          weights.data(),
+          output.data());
+      EXPECT_TRUE(success);
+      for (size_t i = 0; i < output.size(); ++i) {
+        EXPECT_NEAR(output[i], output_ref[i], 1e-3 * (1 + abs(output_ref[i])))
+            << "bit_rate " << bit_rate << " group_size " << group_size
+            << " at " << i;
+      }
+    }
+  }
+}
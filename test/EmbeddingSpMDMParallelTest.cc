@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "fbgemm/FbgemmEmbedding.h"
+#include "src/RefImplementations.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+class EmbeddingSpMDMParallelTest
+    : public testing::TestWithParam<tuple<int, bool, bool>> {};
+
+// Runs every task on its own thread.
+void threadParallelFor(int num_tasks, const function<void(int)>& task) {
+  vector<thread> threads;
+  for (int task_id = 0; task_id < num_tasks; ++task_id) {
+    threads.emplace_back(task, task_id);
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+}
+
+} // namespace
+
+INSTANTIATE_TEST_CASE_P(
+    InstantiationName,
+    EmbeddingSpMDMParallelTest,
+    ::testing::Combine(
+        ::testing::Values(1, 2, 7, 1000), // num_threads
+        ::testing::Bool(), // has_weight
+        ::testing::Bool())); // use custom parallel_for
+
+TEST_P(EmbeddingSpMDMParallelTest, matchesSingleThreaded) {
+  const auto [num_threads, has_weight, custom_parallel_for] = GetParam();
+  const int64_t embedding_dim = 32;
+  const int64_t batch_size = 101;
+  const int64_t num_rows = 500;
+
+  default_random_engine generator;
+  uniform_real_distribution<float> value_distribution(-1.0f, 1.0f);
+  vector<float> embedding_table(num_rows * embedding_dim);
+  for (auto& v : embedding_table) {
+    v = value_distribution(generator);
+  }
+
+  // Skewed bag lengths: a few huge bags and many empty or short ones.
+  uniform_int_distribution<int> length_distribution(0, 4);
+  vector<int64_t> offsets(batch_size + 1, 0);
+  for (int64_t b = 0; b < batch_size; ++b) {
+    offsets[b + 1] =
+        offsets[b] + (b % 25 == 0 ? 400 : length_distribution(generator));
+  }
+  const int64_t index_size = offsets.back();
+  uniform_int_distribution<int64_t> index_distribution(0, num_rows - 1);
+  vector<int64_t> indices(index_size);
+  for (auto& v : indices) {
+    v = index_distribution(generator);
+  }
+  vector<float> weights(index_size);
+  for (auto& v : weights) {
+    v = value_distribution(generator);
+  }
+  const float* weights_ptr = has_weight ? weights.data() : nullptr;
+
+  vector<float> output_ref(batch_size * embedding_dim);
+  bool success_ref = EmbeddingSpMDM_ref(
+      embedding_dim,
+      batch_size,
+      index_size,
+      num_rows,
+      embedding_table.data(),
+      indices.data(),
+      offsets.data(),
+      weights_ptr,
+      /*normalize_by_lengths=*/false,
+      output_ref.data());
+  ASSERT_TRUE(success_ref);
+
+  auto kernel = GenerateEmbeddingSpMDM<float, int64_t, int64_t>(
+      embedding_dim, has_weight, /*normalize_by_lengths=*/false);
+  vector<float> output(output_ref.size(), -1.0f);
+  bool success = EmbeddingSpMDMParallel(
+      kernel,
+      embedding_dim,
+      batch_size,
+      index_size,
+      num_rows,
+      embedding_table.data(),
+      indices.data(),
+      offsets.data(),
+      weights_ptr,
+      output.data(),
+      num_threads,
+      custom_parallel_for ? ParallelTasksExecutor(threadParallelFor) : nullptr);
+  EXPECT_TRUE(success);
+  for (size_t i = 0; i < output.size(); ++i) {
+    EXPECT_NEAR(output[i], output_ref[i], 1e-5f) << "results differ at " << i;
+  }
+
+  indices[offsets[batch_size / 2]] = num_rows;
+  success = EmbeddingSpMDMParallel(
+      kernel,
+      embedding_dim,
+      batch_size,
+      index_size,
+      num_rows,
+      embedding_table.data(),
+      indices.data(),
+      offsets.data(),
+      weights_ptr,
+      output.data(),
+      num_threads,
+      custom_parallel_for ? ParallelTasksExecutor(threadParallelFor) : nullptr);
+  EXPECT_FALSE(success);
+}
@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "fbgemm/FbgemmEmbedding.h"
+#include "fbgemm/QuantUtils.h"
+#include "fbgemm/Utils.h"
+#include "src/RefImplementations.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+class EmbeddingSpMDMPrecompiledTest
+    : public testing::TestWithParam<tuple<int, int, bool, bool, bool, bool>> {
+};
+
+INSTANTIATE_TEST_SUITE_P(
+    InstantiationName,
+    EmbeddingSpMDMPrecompiledTest,
+    ::testing::Combine(
+        ::testing::Values(32, 8, 4, 2), // bit rate of the table
+        ::testing::Values(32, 128), // block_size
+        ::testing::Bool(), // has_weight
+        ::testing::Bool(), // normalize_by_lengths
+        ::testing::Bool(), // use_offsets
+        ::testing::Bool())); // scale_bias_last, or padded float rows
+
+} // namespace
+
+TEST(EmbeddingSpMDMPrecompiledTest, dims) {
+  EXPECT_TRUE(internal::isPrecompiledEmbeddingDim(64));
+  EXPECT_FALSE(internal::isPrecompiledEmbeddingDim(67));
+  if (!fbgemmHasAvx2Support()) {
+    GTEST_SKIP();
+  }
+  const auto kernel =
+      internal::GenerateEmbeddingSpMDMPrecompiled_avx2<float, int64_t, int32_t>(
+          32, 67, false, false, 16, false, true, 67, 67, true);
+  EXPECT_FALSE(kernel);
+}
+
+TEST_P(EmbeddingSpMDMPrecompiledTest, matchesReference) {
+  if (!fbgemmHasAvx2Support()) {
+    GTEST_SKIP();
+  }
+  const auto [bit_rate, block_size, has_weight, normalize, use_offsets, last] =
+      GetParam();
+  // N-bit rows always store the scale and bias in float16
+  const bool scale_bias_last = bit_rate == 32 || last;
+  const int64_t batch_size = 30;
+  const int64_t num_rows = 200;
+  const int64_t output_stride = block_size + 3;
+
+  default_random_engine generator;
+  uniform_real_distribution<float> value_distribution(-2.0f, 2.0f);
+  vector<float> float_table(num_rows * block_size);
+  for (auto& v : float_table) {
+    v = value_distribution(generator);
+  }
+  int64_t input_stride;
+  vector<uint8_t> fused_table;
+  vector<float> padded_table;
+  if (bit_rate == 32) {
+    input_stride = last ? block_size + 8 : block_size;
+    padded_table.resize(num_rows * input_stride);
+    for (int64_t r = 0; r < num_rows; ++r) {
+      copy(
+          float_table.begin() + r * block_size,
+          float_table.begin() + (r + 1) * block_size,
+          padded_table.begin() + r * input_stride);
+    }
+  } else if (bit_rate == 8 && scale_bias_last) {
+    input_stride = block_size + 2 * sizeof(float);
+    fused_table.resize(num_rows * input_stride);
+    FloatOrHalfToFused8BitRowwiseQuantizedSBFloat<float>(
+        float_table.data(), num_rows, block_size, fused_table.data());
+  } else {
+    // Float16 scale and bias, first unless scale_bias_last
+    const int num_elem_per_byte = 8 / bit_rate;
+    const int64_t row_bytes = block_size / num_elem_per_byte;
+    input_stride = row_bytes + 2 * sizeof(float16);
+    fused_table.resize(num_rows * input_stride);
+    uniform_int_distribution<int> element_distribution(0, 255);
+    for (int64_t r = 0; r < num_rows; ++r) {
+      uint8_t* row = fused_table.data() + r * input_stride;
+      float16* scale_bias = reinterpret_cast<float16*>(
+          row + (scale_bias_last ? row_bytes : 0));
+      scale_bias[0] = cpu_float2half_rn(value_distribution(generator) / 8);
+      scale_bias[1] = cpu_float2half_rn(value_distribution(generator));
+      uint8_t* elements = row + (scale_bias_last ? 0 : 2 * sizeof(float16));
+      for (int64_t j = 0; j < row_bytes; ++j) {
+        elements[j] = element_distribution(generator);
+      }
+    }
+  }
+
+  uniform_int_distribution<int> length_distribution(0, 20);
+  uniform_int_distribution<int64_t> index_distribution(0, num_rows - 1);
+  vector<int32_t> lengths(batch_size), offsets(batch_size + 1);
+  for (int64_t b = 0; b < batch_size; ++b) {
+    lengths[b] = length_distribution(generator);
+    offsets[b + 1] = offsets[b] + lengths[b];
+  }
+  vector<int64_t> indices(offsets[batch_size]);
+  vector<float> weights(indices.size());
+  for (size_t i = 0; i < indices.size(); ++i) {
+    indices[i] = index_distribution(generator);
+    weights[i] = value_distribution(generator);
+  }
+  if (!scale_bias_last && !indices.empty()) {
+    // Pruned rows are skipped
+    indices[indices.size() / 2] = -1;
+  }
+  const int32_t* offsets_or_lengths =
+      use_offsets ? offsets.data() : lengths.data();
+  const float* weights_ptr = has_weight ? weights.data() : nullptr;
+
+  vector<float> out(batch_size * output_stride, -1.0f);
+  vector<float> out_ref(batch_size * output_stride, -1.0f);
+  const auto run = [&](auto in_type, const auto* table) {
+    auto kernel = internal::GenerateEmbeddingSpMDMPrecompiled_avx2<
+        decltype(in_type),
+        int64_t,
+        int32_t>(
+        bit_rate,
+        block_size,
+        has_weight,
+        normalize,
+        /*prefetch=*/16,
+        /*is_weight_positional=*/false,
+        use_offsets,
+        output_stride,
+        input_stride,
+        scale_bias_last);
+    EXPECT_TRUE(kernel);
+    if (!kernel) {
+      return false;
+    }
+    return kernel(
+        batch_size,
+        indices.size(),
+        num_rows,
+        table,
+        indices.data(),
+        offsets_or_lengths,
+        weights_ptr,
+        out.data());
+  };
+  const bool success = bit_rate == 32 ? run(float{}, padded_table.data())
+                                      : run(uint8_t{}, fused_table.data());
+  bool success_ref;
+  if (bit_rate == 32) {
+    success_ref = EmbeddingSpMDM_ref(
+        block_size,
+        batch_size,
+        indices.size(),
+        num_rows,
+        padded_table.data(),
+        indices.data(),
+        offsets_or_lengths,
+        weights_ptr,
+        normalize,
+        out_ref.data(),
+        /*is_weight_positional=*/false,
+        use_offsets,
+        output_stride,
+        input_stride);
+  } else if (bit_rate == 8) {
+    success_ref = EmbeddingSpMDM_ref(
+        block_size,
+        batch_size,
+        indices.size(),
+        num_rows,
+        fused_table.data(),
+        indices.data(),
+        offsets_or_lengths,
+        weights_ptr,
+        normalize,
+        out_ref.data(),
+        /*is_weight_positional=*/false,
+        use_offsets,
+        output_stride,
+        input_stride,
+        scale_bias_last);
+  } else {
+    success_ref = EmbeddingSpMDMNBit_ref(
+        bit_rate,
+        block_size,
+        batch_size,
+        indices.size(),
+        num_rows,
+        fused_table.data(),
+        indices.data(),
+        offsets_or_lengths,
+        weights_ptr,
+        normalize,
+        out_ref.data(),
+        /*is_weight_positional=*/false,
+        use_offsets,
+        output_stride,
+        input_stride,
+        scale_bias_last);
+  }
+  ASSERT_TRUE(success_ref);
+  EXPECT_TRUE(success);
+  for (size_t i = 0; i < out.size(); ++i) {
+    EXPECT_NEAR(out[i], out_ref[i], 1e-3f * (1 + abs(out_ref[i])))
+        << "element " << i;
+  }
+
+  // Out of bound indices fail as in the reference
+  indices.back() = num_rows;
+  EXPECT_FALSE(
+      bit_rate == 32 ? run(float{}, padded_table.data())
+                     : run(uint8_t{}, fused_table.data()));
+}
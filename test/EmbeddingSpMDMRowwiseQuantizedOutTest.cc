@@ -0,0 +1,173 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "fbgemm/FbgemmEmbedding.h"
+#include "fbgemm/QuantUtils.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+class EmbeddingSpMDMRowwiseQuantizedOutTest
+    : public testing::TestWithParam<tuple<int, int, bool, bool, bool>> {};
+
+} // namespace
+
+INSTANTIATE_TEST_CASE_P(
+    InstantiationName,
+    EmbeddingSpMDMRowwiseQuantizedOutTest,
+    ::testing::Combine(
+        ::testing::Values(8, 4, 2), // bit_rate
+        ::testing::Values(8, 32, 100, 5000), // embedding_dim
+        ::testing::Bool(), // has_weight
+        ::testing::Bool(), // use_offsets
+        ::testing::Bool())); // padded output rows
+
+// Must match pooling to float with the same kernel and quantizing after.
+TEST_P(EmbeddingSpMDMRowwiseQuantizedOutTest, matchesPoolThenQuantize) {
+  const auto [bit_rate, embedding_dim, has_weight, use_offsets, padded] =
+      GetParam();
+  const int64_t batch_size = 150;
+  const int64_t num_rows = 300;
+
+  default_random_engine generator;
+  uniform_real_distribution<float> value_distribution(-2.0f, 2.0f);
+  vector<float> float_table(num_rows * embedding_dim);
+  for (auto& v : float_table) {
+    v = value_distribution(generator);
+  }
+  vector<uint8_t> table;
+  if (bit_rate == 8) {
+    table.resize(num_rows * (embedding_dim + 2 * sizeof(float)));
+    FloatOrHalfToFused8BitRowwiseQuantizedSBFloat<float>(
+        float_table.data(), num_rows, embedding_dim, table.data());
+  } else {
+    const int num_elem_per_byte = 8 / bit_rate;
+    table.resize(
+        num_rows *
+        ((embedding_dim + num_elem_per_byte - 1) / num_elem_per_byte +
+         2 * sizeof(float16)));
+    FloatOrHalfToFusedNBitRowwiseQuantizedSBHalf<float>(
+        bit_rate, float_table.data(), num_rows, embedding_dim, table.data());
+  }
+
+  uniform_int_distribution<int> length_distribution(0, 12);
+  vector<int32_t> lengths(batch_size);
+  vector<int32_t> offsets(batch_size + 1, 0);
+  for (int64_t b = 0; b < batch_size; ++b) {
+    lengths[b] = length_distribution(generator);
+    offsets[b + 1] = offsets[b] + lengths[b];
+  }
+  const int64_t index_size = offsets.back();
+  const int32_t* offsets_or_lengths =
+      use_offsets ? offsets.data() : lengths.data();
+  uniform_int_distribution<int64_t> index_distribution(0, num_rows - 1);
+  vector<int64_t> indices(index_size);
+  for (auto& v : indices) {
+    v = index_distribution(generator);
+  }
+  vector<float> weights(index_size);
+  for (auto& v : weights) {
+    v = value_distribution(generator);
+  }
+  const float* weights_ptr = has_weight ? weights.data() : nullptr;
+
+  vector<float> pooled(batch_size * embedding_dim);
+  bool success_ref;
+  if (bit_rate == 8) {
+    success_ref = GenerateEmbeddingSpMDM<uint8_t, int64_t>(
+        embedding_dim,
+        has_weight,
+        /*normalize_by_lengths=*/false,
+        /*prefetch=*/16,
+        /*is_weight_positional=*/false,
+        use_offsets)(
+        batch_size,
+        index_size,
+        num_rows,
+        table.data(),
+        indices.data(),
+        offsets_or_lengths,
+        weights_ptr,
+        pooled.data());
+  } else {
+    success_ref = GenerateEmbeddingSpMDMNBit<int64_t>(
+        bit_rate,
+        embedding_dim,
+        has_weight,
+        /*normalize_by_lengths=*/false,
+        /*prefetch=*/16,
+        /*is_weight_positional=*/false,
+        use_offsets)(
+        batch_size,
+        index_size,
+        num_rows,
+        table.data(),
+        indices.data(),
+        offsets_or_lengths,
+        weights_ptr,
+        pooled.data());
+  }
+  ASSERT_TRUE(success_ref);
+  const int64_t row_size = embedding_dim + 2 * sizeof(float);
+  vector<uint8_t> output_ref(batch_size * row_size);
+  FloatOrHalfToFused8BitRowwiseQuantizedSBFloat<float>(
+      pooled.data(), batch_size, embedding_dim, output_ref.data());
+
+  const int64_t output_stride = padded ? row_size + 3 : row_size;
+  auto kernel = GenerateEmbeddingSpMDMRowwiseQuantizedOut<int64_t>(
+      bit_rate,
+      embedding_dim,
+      has_weight,
+      /*normalize_by_lengths=*/false,
+      /*prefetch=*/16,
+      /*is_weight_positional=*/false,
+      use_offsets,
+      padded ? output_stride : -1);
+  vector<uint8_t> output(batch_size * output_stride, 0xab);
+  bool success = kernel(
+      batch_size,
+      index_size,
+      num_rows,
+      table.data(),
+      indices.data(),
+      offsets_or_lengths,
+      weights_ptr,
+      output.data());
+  EXPECT_TRUE(success);
+  for (int64_t b = 0; b < batch_size; ++b) {
+    for (int64_t c = 0; c < output_stride; ++c) {
+      EXPECT_EQ(
+          output[b * output_stride + c],
+          c < row_size ? output_ref[b * row_size + c] : 0xab)
+          << "results differ at bag " << b << " byte " << c;
+    }
+  }
+
+  if (index_size > 0) {
+    indices[index_size - 1] = num_rows;
+    success = kernel(
+        batch_size,
+        index_size,
+        num_rows,
+        table.data(),
+        indices.data(),
+        offsets_or_lengths,
+        weights_ptr,
+        output.data());
+    EXPECT_FALSE(success);
+  }
+}
@@ -0,0 +1,325 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "fbgemm/FbgemmEmbedding.h"
+#include "fbgemm/Types.h"
+#include "src/RefImplementations.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+class EmbeddingSpMDMTableBatchedTest
+    : public testing::TestWithParam<tuple<int, bool>> {};
+
+// Fused rowwise quantized rows with fp16 scale and bias in front, as in TBE.
+vector<uint8_t> quantizedTable(
+    default_random_engine& generator,
+    int bit_rate,
+    int num_rows,
+    int dim) {
+  const int row_bytes = (dim * bit_rate + 7) / 8 + 2 * sizeof(float16);
+  uniform_int_distribution<int> byte_distribution(0, 255);
+  vector<uint8_t> table(num_rows * row_bytes);
+  for (auto& v : table) {
+    v = byte_distribution(generator);
+  }
+  for (int r = 0; r < num_rows; ++r) {
+    float16* scale_bias = reinterpret_cast<float16*>(&table[r * row_bytes]);
+    scale_bias[0] = cpu_float2half_rn(0.25f);
+    scale_bias[1] = cpu_float2half_rn(-1.0f);
+  }
+  return table;
+}
+
+} // namespace
+
+INSTANTIATE_TEST_CASE_P(
+    InstantiationName,
+    EmbeddingSpMDMTableBatchedTest,
+    ::testing::Combine(
+        ::testing::Values(1, 3, 64), // num_threads
+        ::testing::Bool())); // has_weight
+
+TEST_P(EmbeddingSpMDMTableBatchedTest, matchesPerTableLookups) {
+  const auto [num_threads, has_weight] = GetParam();
+  const int num_rows = 100;
+  const int64_t batch_size = 13;
+  const vector<int> dims = {64, 8, 32, 16};
+  const vector<int> bit_rates = {32, 8, 4, 2};
+  const int num_tables = dims.size();
+
+  default_random_engine generator;
+  uniform_real_distribution<float> value_distribution(-1.0f, 1.0f);
+  vector<vector<uint8_t>> data(num_tables);
+  vector<EmbeddingSpMDMTable> tables;
+  int64_t total_dim = 0;
+  for (int t = 0; t < num_tables; ++t) {
+    if (bit_rates[t] == 32) {
+      data[t].resize(num_rows * dims[t] * sizeof(float));
+      float* values = reinterpret_cast<float*>(data[t].data());
+      for (int i = 0; i < num_rows * dims[t]; ++i) {
+        values[i] = value_distribution(generator);
+      }
+    } else {
+      data[t] = quantizedTable(generator, bit_rates[t], num_rows, dims[t]);
+    }
+    tables.push_back(
+        {data[t].data(), num_rows, dims[t], bit_rates[t], total_dim});
+    total_dim += dims[t];
+  }
+
+  // The first table is much larger than the others so the chunks have to
+  // cross table boundaries.
+  uniform_int_distribution<int> length_distribution(0, 10);
+  vector<int64_t> offsets(num_tables * batch_size + 1, 0);
+  for (int i = 0; i < num_tables * batch_size; ++i) {
+    offsets[i + 1] = offsets[i] + length_distribution(generator) +
+        (i < batch_size ? 20 : 0);
+  }
+  uniform_int_distribution<int> index_distribution(0, num_rows - 1);
+  vector<int32_t> indices(offsets.back());
+  for (auto& v : indices) {
+    v = index_distribution(generator);
+  }
+  vector<float> weights(indices.size());
+  for (auto& v : weights) {
+    v = value_distribution(generator);
+  }
+  const float* weights_ptr = has_weight ? weights.data() : nullptr;
+
+  vector<float> output_ref(batch_size * total_dim);
+  for (int t = 0; t < num_tables; ++t) {
+    const int64_t begin = offsets[t * batch_size];
+    const int64_t index_size = offsets[(t + 1) * batch_size] - begin;
+    bool success_ref;
+    if (bit_rates[t] == 32) {
+      success_ref = EmbeddingSpMDM_ref(
+          dims[t],
+          batch_size,
+          index_size,
+          num_rows,
+          reinterpret_cast<const float*>(data[t].data()),
+          indices.data() + begin,
+          offsets.data() + t * batch_size,
+          has_weight ? weights_ptr + begin : nullptr,
+          /*normalize_by_lengths=*/false,
+          output_ref.data() + tables[t].output_offset,
+          /*is_weight_positional=*/false,
+          /*use_offsets=*/true,
+          /*output_stride=*/total_dim);
+    } else if (bit_rates[t] == 8) {
+      success_ref = EmbeddingSpMDM_ref(
+          dims[t],
+          batch_size,
+          index_size,
+          num_rows,
+          data[t].data(),
+          indices.data() + begin,
+          offsets.data() + t * batch_size,
+          has_weight ? weights_ptr + begin : nullptr,
+          /*normalize_by_lengths=*/false,
+          output_ref.data() + tables[t].output_offset,
+          /*is_weight_positional=*/false,
+          /*use_offsets=*/true,
+          /*output_stride=*/total_dim,
+          /*input_stride=*/-1,
+          /*scale_bias_last=*/false);
+    } else {
+      success_ref = EmbeddingSpMDMNBit_ref(
+          bit_rates[t],
+          dims[t],
+          batch_size,
+          index_size,
+          num_rows,
+          data[t].data(),
+          indices.data() + begin,
+          offsets.data() + t * batch_size,
+          has_weight ? weights_ptr + begin : nullptr,
+          /*normalize_by_lengths=*/false,
+          output_ref.data() + tables[t].output_offset,
+          /*is_weight_positional=*/false,
+          /*use_offsets=*/true,
+          /*output_stride=*/total_dim,
+          /*input_stride=*/-1,
+          /*scale_bias_last=*/false);
+    }
+    ASSERT_TRUE(success_ref);
+  }
+
+  vector<float> output(output_ref.size(), -1.0f);
+  for (int thread_id = 0; thread_id < num_threads; ++thread_id) {
+    bool success = EmbeddingSpMDMTableBatched(
+        num_tables,
+        tables.data(),
+        batch_size,
+        indices.data(),
+        offsets.data(),
+        weights_ptr,
+        /*normalize_by_lengths=*/false,
+        output.data(),
+        total_dim,
+        thread_id,
+        num_threads);
+    EXPECT_TRUE(success);
+  }
+  for (size_t i = 0; i < output.size(); ++i) {
+    EXPECT_NEAR(output[i], output_ref[i], 1e-5f) << "results differ at " << i;
+  }
+
+  // An out of bounds index is reported by the thread that processes it.
+  indices[offsets[2 * batch_size]] = num_rows;
+  bool success = true;
+  for (int thread_id = 0; thread_id < num_threads; ++thread_id) {
+    success &= EmbeddingSpMDMTableBatched(
+        num_tables,
+        tables.data(),
+        batch_size,
+        indices.data(),
+        offsets.data(),
+        weights_ptr,
+        /*normalize_by_lengths=*/false,
+        output.data(),
+        total_dim,
+        thread_id,
+        num_threads);
+  }
+  EXPECT_FALSE(success);
+}
+
+TEST_P(EmbeddingSpMDMTableBatchedTest, dotInteractionMatchesPooledDots) {
+  const auto [num_threads, has_weight] = GetParam();
+  const int num_rows = 100;
+  const int64_t batch_size = 13;
+  // Large enough for the samples to be pooled in several tiles
+  const int dim = 520;
+  const vector<int> bit_rates = {32, 8, 4, 2, 32};
+  const int num_tables = bit_rates.size();
+
+  default_random_engine generator;
+  uniform_real_distribution<float> value_distribution(-1.0f, 1.0f);
+  vector<vector<uint8_t>> data(num_tables);
+  vector<EmbeddingSpMDMTable> tables;
+  for (int t = 0; t < num_tables; ++t) {
+    if (bit_rates[t] == 32) {
+      data[t].resize(num_rows * dim * sizeof(float));
+      float* values = reinterpret_cast<float*>(data[t].data());
+      for (int i = 0; i < num_rows * dim; ++i) {
+        values[i] = value_distribution(generator);
+      }
+    } else {
+      data[t] = quantizedTable(generator, bit_rates[t], num_rows, dim);
+    }
+    tables.push_back({data[t].data(), num_rows, dim, bit_rates[t], t * dim});
+  }
+  uniform_int_distribution<int> length_distribution(0, 10);
+  vector<int32_t> offsets(num_tables * batch_size + 1, 0);
+  for (int i = 0; i < num_tables * batch_size; ++i) {
+    offsets[i + 1] = offsets[i] + length_distribution(generator);
+  }
+  uniform_int_distribution<int> index_distribution(0, num_rows - 1);
+  vector<int64_t> indices(offsets.back());
+  for (auto& v : indices) {
+    v = index_distribution(generator);
+  }
+  vector<float> weights(indices.size()), dense(batch_size * dim);
+  for (auto& v : weights) {
+    v = value_distribution(generator);
+  }
+  for (auto& v : dense) {
+    v = value_distribution(generator);
+  }
+  const float* weights_ptr = has_weight ? weights.data() : nullptr;
+
+  // Pooled rows of all tables, as checked by matchesPerTableLookups
+  vector<float> pooled(batch_size * num_tables * dim);
+  ASSERT_TRUE(EmbeddingSpMDMTableBatched(
+      num_tables,
+      tables.data(),
+      batch_size,
+      indices.data(),
+      offsets.data(),
+      weights_ptr,
+      /*normalize_by_lengths=*/false,
+      pooled.data(),
+      num_tables * dim));
+
+  for (bool use_dense : {false, true}) {
+    const int num_features = num_tables + use_dense;
+    const int64_t dense_size = use_dense ? dim : 0;
+    const int64_t output_stride =
+        dense_size + num_features * (num_features - 1) / 2;
+    vector<float> output_ref(batch_size * output_stride);
+    for (int64_t b = 0; b < batch_size; ++b) {
+      auto feature = [&](int f) {
+        return use_dense && f == 0
+            ? &dense[b * dim]
+            : &pooled[(b * num_tables + f - use_dense) * dim];
+      };
+      float* out_row = &output_ref[b * output_stride];
+      for (int d = 0; d < dense_size; ++d) {
+        *out_row++ = dense[b * dim + d];
+      }
+      for (int i = 1; i < num_features; ++i) {
+        for (int j = 0; j < i; ++j) {
+          float dot = 0.0f;
+          for (int d = 0; d < dim; ++d) {
+            dot += feature(i)[d] * feature(j)[d];
+          }
+          *out_row++ = dot;
+        }
+      }
+    }
+
+    vector<float> output(output_ref.size(), -1.0f);
+    for (int thread_id = 0; thread_id < num_threads; ++thread_id) {
+      EXPECT_TRUE(EmbeddingSpMDMDotInteraction(
+          num_tables,
+          tables.data(),
+          batch_size,
+          indices.data(),
+          offsets.data(),
+          weights_ptr,
+          /*normalize_by_lengths=*/false,
+          use_dense ? dense.data() : nullptr,
+          output.data(),
+          /*output_stride=*/-1,
+          thread_id,
+          num_threads));
+    }
+    for (size_t i = 0; i < output.size(); ++i) {
+      EXPECT_NEAR(output[i], output_ref[i], 1e-4f * (1 + abs(output_ref[i])))
+          << "results differ at " << i << " with dense " << use_dense;
+    }
+  }
+
+  // Tables of different dimensions cannot interact
+  tables[1].embedding_dim = dim / 2;
+  vector<float> output(batch_size * num_tables * num_tables);
+  EXPECT_THROW(
+      EmbeddingSpMDMDotInteraction(
+          num_tables,
+          tables.data(),
+          batch_size,
+          indices.data(),
+          offsets.data(),
+          weights_ptr,
+          /*normalize_by_lengths=*/false,
+          nullptr,
+          output.data()),
+      std::runtime_error);
+}
@@ -62,6 +62,10 @@ class rowwiseSparseEmbeddingSpMDMTest
 
 class IndexRemapTest
     : public testing::TestWithParam<tuple<int, int, int, bool, bool>> {};
+
+class SortIndicesWithinBagsTest
+    : public testing::TestWithParam<tuple<EmbeddingSpMDMWeightChoice, bool>> {
+};
 } // namespace
 
 vector<int> prefetch_distances = {0, 16, 1000000};
@@ -108,6 +112,13 @@ INSTANTIATE_TEST_CASE_P(
         ::testing::Bool(), // is index 64 bit?
         ::testing::Bool())); // per sample weights?
 
+INSTANTIATE_TEST_CASE_P(
+    InstantiationName,
+    SortIndicesWithinBagsTest,
+    ::testing::Combine(
+        ::testing::Values(UNWEIGHTED, WEIGHTED, POSITIONAL_WEIGHTED),
+        ::testing::Bool())); // use_offsets
+
 TEST_P(EmbeddingSpMDMTest, basicTest) {
   vector<vector<int>> inputs(GetInputs_());
 
@@ -983,3 +994,190 @@ TEST_P(IndexRemapTest, basicTest) {
     }
   }
 }
+
+// The AVX2 kernel is only dispatched to without AVX512, so it is run directly
+TEST_P(IndexRemapTest, avx2Test) {
+  if (!fbgemmHasAvx2Support()) {
+    return;
+  }
+  int batch_size, num_rows, avg_len;
+  bool isIndex64b, per_sample_weights;
+  tie(batch_size, num_rows, avg_len, isIndex64b, per_sample_weights) =
+      GetParam();
+
+  vector<int64_t> lengths, offsets, indices;
+  vector<int32_t> lengths_32, offsets_32, indices_32;
+  vector<float> weights;
+  GenerateLengthsIndicesWeights(
+      lengths,
+      lengths_32,
+      offsets,
+      offsets_32,
+      indices,
+      indices_32,
+      weights,
+      batch_size,
+      num_rows,
+      avg_len,
+      EmbeddingSpMDMCornerCase::NONE);
+  vector<int32_t> mapping_table;
+  CreateMappingTableForRowWiseSparsity(mapping_table, num_rows, 0.5);
+  const int offset_numel = offsets_32.size();
+  const float* weights_ptr = per_sample_weights ? weights.data() : nullptr;
+
+  auto check = [&](const auto& ind, const auto& offs) {
+    using IndexType = typename decay_t<decltype(ind)>::value_type;
+    vector<IndexType> out_indices(ind.size()), out_indices_ref(ind.size());
+    vector<IndexType> out_offsets(offs.size()), out_offsets_ref(offs.size());
+    vector<float> out_weights(weights.size()), out_weights_ref(weights.size());
+    if (per_sample_weights) {
+      internal::compressed_indices_remap_avx2<IndexType, true>(
+          offset_numel,
+          ind.data(),
+          mapping_table.data(),
+          offs.data(),
+          weights_ptr,
+          out_indices.data(),
+          out_offsets.data(),
+          out_weights.data());
+    } else {
+      internal::compressed_indices_remap_avx2<IndexType, false>(
+          offset_numel,
+          ind.data(),
+          mapping_table.data(),
+          offs.data(),
+          nullptr,
+          out_indices.data(),
+          out_offsets.data(),
+          nullptr);
+    }
+    compressed_indices_remap_ref<IndexType>(
+        offset_numel,
+        ind.data(),
+        mapping_table.data(),
+        offs.data(),
+        weights_ptr,
+        out_indices_ref.data(),
+        out_offsets_ref.data(),
+        out_weights_ref.data());
+
+    EXPECT_EQ(out_offsets, out_offsets_ref) << "offsets don't match";
+    const int len = out_offsets_ref[offset_numel - 1];
+    for (int i = 0; i < len; ++i) {
+      EXPECT_EQ(out_indices[i], out_indices_ref[i])
+          << "indices don't match at " << i;
+      if (per_sample_weights) {
+        EXPECT_EQ(out_weights[i], out_weights_ref[i])
+            << "weights don't match at " << i;
+      }
+    }
+  };
+  if (isIndex64b) {
+    check(indices, offsets);
+  } else {
+    check(indices_32, offsets_32);
+  }
+}
+
+// The bags are sorted and pool to what the unsorted bags do.
+TEST_P(SortIndicesWithinBagsTest, poolsAsUnsorted) {
+  const auto [weight_choice, use_offsets] = GetParam();
+  const int batch_size = 20, num_rows = 4000, embedding_dim = 16;
+  vector<int64_t> lengths, offsets, indices;
+  vector<int32_t> lengths_32, offsets_32, indices_32;
+  vector<float> weights;
+  GenerateLengthsIndicesWeights(
+      lengths,
+      lengths_32,
+      offsets,
+      offsets_32,
+      indices,
+      indices_32,
+      weights,
+      batch_size,
+      num_rows,
+      /*average_len=*/50,
+      EmbeddingSpMDMCornerCase::NONE);
+  const bool is_weight_positional = weight_choice == POSITIONAL_WEIGHTED;
+  const float* weights_ptr = weight_choice == UNWEIGHTED ? nullptr
+                                                         : weights.data();
+  const int32_t* offsets_or_lengths =
+      use_offsets ? offsets_32.data() : lengths_32.data();
+  const int64_t index_size = indices.size();
+  default_random_engine generator;
+  normal_distribution<float> distribution;
+  vector<float> table(num_rows * embedding_dim);
+  for (auto& v : table) {
+    v = distribution(generator);
+  }
+
+  vector<int64_t> sorted_indices(index_size);
+  vector<float> sorted_weights(index_size);
+  EmbeddingSortIndicesWithinBags(
+      batch_size,
+      index_size,
+      indices.data(),
+      offsets_or_lengths,
+      weights_ptr,
+      sorted_indices.data(),
+      sorted_weights.data(),
+      is_weight_positional,
+      use_offsets);
+  for (int b = 0; b < batch_size; ++b) {
+    EXPECT_TRUE(is_sorted(
+        sorted_indices.begin() + offsets[b],
+        sorted_indices.begin() + offsets[b + 1]))
+        << "bag " << b;
+  }
+
+  vector<float> out(batch_size * embedding_dim);
+  vector<float> out_ref(batch_size * embedding_dim);
+  ASSERT_TRUE(EmbeddingSpMDM_ref(
+      embedding_dim,
+      batch_size,
+      index_size,
+      num_rows,
+      table.data(),
+      indices.data(),
+      offsets_or_lengths,
+      weights_ptr,
+      /*normalize_by_lengths=*/false,
+      out_ref.data(),
+      is_weight_positional,
+      use_offsets));
+  ASSERT_TRUE(EmbeddingSpMDM_ref(
+      embedding_dim,
+      batch_size,
+      index_size,
+      num_rows,
+      table.data(),
+      sorted_indices.data(),
+      offsets_or_lengths,
+      weights_ptr ? sorted_weights.data() : nullptr,
+      /*normalize_by_lengths=*/false,
+      out.data(),
+      /*is_weight_positional=*/false,
+      use_offsets));
+  for (size_t i = 0; i < out.size(); ++i) {
+    EXPECT_NEAR(out[i], out_ref[i], 1e-4f * (1 + abs(out_ref[i])))
+        << "element " << i;
+  }
+
+  // In place, the result is the same
+  if (!is_weight_positional) {
+    EmbeddingSortIndicesWithinBags(
+        batch_size,
+        index_size,
+        indices.data(),
+        offsets_or_lengths,
+        weights_ptr,
+        indices.data(),
+        weights.data(),
+        is_weight_positional,
+        use_offsets);
+    EXPECT_EQ(indices, sorted_indices);
+    if (weights_ptr) {
+      EXPECT_EQ(weights, sorted_weights);
+    }
+  }
+}
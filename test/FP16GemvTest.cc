@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <gtest/gtest.h>
+
+#include "bench/BenchUtils.h"
+#include "fbgemm/FbgemmFP16.h"
+#include "src/RefImplementations.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+// {M, N, K, beta}
+class FP16GemvTest
+    : public testing::TestWithParam<tuple<int, int, int, float>> {};
+
+} // namespace
+
+INSTANTIATE_TEST_CASE_P(
+    InstantiationName,
+    FP16GemvTest,
+    ::testing::Combine(
+        ::testing::Values(1, 2, 3, 4),
+        ::testing::Values(1, 16, 40, 200, 1000),
+        ::testing::Values(1, 100, 600, 1300),
+        ::testing::Values(0.f, 1.f, 0.5f)));
+
+// Small integers are exact in fp16 and their sums in fp32, so the results
+// must match the reference exactly.
+TEST_P(FP16GemvTest, matchesReference) {
+  const auto [m, n, k, beta] = GetParam();
+  default_random_engine generator;
+  uniform_int_distribution<int> dist(-3, 3);
+  vector<float> A(m * k), B(k * n), C_init(m * n);
+  for (auto& v : A) {
+    v = dist(generator);
+  }
+  for (auto& v : B) {
+    v = dist(generator);
+  }
+  for (auto& v : C_init) {
+    v = dist(generator);
+  }
+
+  vector<float> C_ref(C_init);
+  cblas_sgemm_ref(
+      matrix_op_t::NoTranspose,
+      matrix_op_t::NoTranspose,
+      m,
+      n,
+      k,
+      1.f,
+      A.data(),
+      k,
+      B.data(),
+      n,
+      beta,
+      C_ref.data(),
+      n);
+
+  PackedGemmMatrixFP16 Bp(matrix_op_t::NoTranspose, k, n, 1.f, B.data());
+  vector<float> C(C_init);
+  if (beta == 0.f) {
+    // Must not be read.
+    fill(C.begin(), C.end(), NAN);
+  }
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  cblas_gemm_compute(
+      matrix_op_t::NoTranspose,
+      m,
+      A.data(),
+      Bp,
+      beta,
+      C.data(),
+      fbgemm_get_thread_num(),
+      fbgemm_get_num_threads());
+  EXPECT_EQ(C, C_ref);
+}
@@ -6,6 +6,9 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <random>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include "./FBGemmFPTest.h"
@@ -33,3 +36,50 @@ TEST_P(FBGemmFP16Test, Test) {
 TEST_P(FBGemmFP16Test, Unpack) {
   UnpackTestRun();
 }
+
+// Products and sums of small integers are exact in fp16 as well, so the fp16
+// accumulation (where supported) has to match cblas_gemm_compute exactly.
+TEST(FBGemmFP16AccTest, matchesFp32OnSmallIntegers) {
+  std::default_random_engine generator;
+  std::uniform_int_distribution<int> dist(-2, 2);
+  const int k = 300;
+  for (const int brow : {64, 512}) {
+    for (const int n : {32, 100}) {
+      for (const int m : {1, 5, 14, 37}) {
+        for (const float beta : {0.f, 1.f}) {
+          std::vector<float> A(m * k), B(k * n), C_init(m * n);
+          for (auto& v : A) {
+            v = dist(generator);
+          }
+          for (auto& v : B) {
+            v = dist(generator);
+          }
+          for (auto& v : C_init) {
+            v = dist(generator);
+          }
+          fbgemm::PackedGemmMatrixFP16 Bp(
+              fbgemm::matrix_op_t::NoTranspose, k, n, 1.0f, B.data(), brow);
+
+          auto C_ref = C_init;
+          fbgemm::cblas_gemm_compute(
+              fbgemm::matrix_op_t::NoTranspose,
+              m,
+              A.data(),
+              Bp,
+              beta,
+              C_ref.data());
+          auto C = C_init;
+          fbgemm::cblas_gemm_compute_fp16_acc(
+              fbgemm::matrix_op_t::NoTranspose,
+              m,
+              A.data(),
+              Bp,
+              beta,
+              C.data());
+          EXPECT_EQ(C, C_ref) << "m = " << m << ", n = " << n
+                              << ", brow = " << brow << ", beta = " << beta;
+        }
+      }
+    }
+  }
+}
@@ -8,6 +8,7 @@
 
 #include <gtest/gtest.h>
 #include <cmath>
+#include <limits>
 #include <random>
 
 #include "bench/BenchUtils.h"
@@ -193,3 +194,42 @@ TEST_P(FBGemmFloat16Test, Conversion_fake_rounding) {
     }
   }
 }
+
+TEST(FBGemmFloat16Test, StochasticRounding) {
+  // 1 + 2^-12 lies a quarter of the way between the float16 values 1 and
+  // 1 + 2^-10
+  constexpr int N = 1 << 14;
+  constexpr float lo = 1.0f, hi = 1.0f + 1.0f / 1024;
+  const float x = 1.0f + 1.0f / 4096;
+  vector<float> a(N, x);
+  a[3] = numeric_limits<float>::infinity();
+  a[5] = -numeric_limits<float>::infinity();
+  a[N - 1] = numeric_limits<float>::quiet_NaN();
+
+  for (bool simd : {false, true}) {
+    SCOPED_TRACE(simd ? "simd" : "ref");
+    vector<float16> b(N);
+    vector<float> c(N);
+    if (simd) {
+      FloatToFloat16StochasticRounding_simd(a.data(), b.data(), N);
+    } else {
+      FloatToFloat16StochasticRounding_ref(a.data(), b.data(), N);
+    }
+    Float16ToFloat_ref(b.data(), c.data(), N);
+    EXPECT_EQ(c[3], numeric_limits<float>::infinity());
+    EXPECT_EQ(c[5], -numeric_limits<float>::infinity());
+    EXPECT_TRUE(std::isnan(c[N - 1]));
+
+    double sum = 0;
+    int num_finite = 0;
+    for (int i = 0; i < N; ++i) {
+      if (std::isfinite(a[i])) {
+        EXPECT_TRUE(c[i] == lo || c[i] == hi) << "at " << i << ": " << c[i];
+        sum += c[i];
+        ++num_finite;
+      }
+    }
+    // Rounding up with probability 1/4 is unbiased
+    EXPECT_NEAR(sum / num_finite, x, (hi - lo) * 0.05);
+  }
+}
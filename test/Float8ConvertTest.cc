@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include "fbgemm/FbgemmConvert.h"
+#include "fbgemm/Utils.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+// {exponent bits, exponent bias}
+class FBGemmFloat8Test : public testing::TestWithParam<tuple<int, int>> {};
+} // namespace
+
+INSTANTIATE_TEST_CASE_P(
+    InstantiationName,
+    FBGemmFloat8Test,
+    ::testing::Values(
+        make_tuple(4, 7), // e4m3
+        make_tuple(4, 8),
+        make_tuple(5, 15), // e5m2
+        make_tuple(5, 16)));
+
+TEST_P(FBGemmFloat8Test, FloatToFloat8MatchesRef) {
+  const auto [exponent_bits, exponent_bias] = GetParam();
+
+  // Values across the normal and denormal ranges of float8, both beyond its
+  // range, and special values
+  default_random_engine generator;
+  uniform_real_distribution<float> mantissa_gen(-1.0f, 1.0f);
+  uniform_int_distribution<int> exponent_gen(-2 * exponent_bias, 20);
+  vector<float> src(1000);
+  for (auto& x : src) {
+    x = std::ldexp(mantissa_gen(generator), exponent_gen(generator));
+  }
+  src[0] = 0.0f;
+  src[1] = -0.0f;
+  src[2] = numeric_limits<float>::infinity();
+  src[3] = -numeric_limits<float>::infinity();
+  src[4] = numeric_limits<float>::quiet_NaN();
+  src[5] = numeric_limits<float>::denorm_min();
+  // float8 values round trip
+  for (int i = 0; i < 256; ++i) {
+    Float8ToFloat_ref(i, &src[100 + i], exponent_bits, exponent_bias);
+  }
+
+  vector<uint8_t> ref(src.size());
+  for (size_t i = 0; i < src.size(); ++i) {
+    FloatToFloat8_ref(src[i], &ref[i], exponent_bits, exponent_bias);
+  }
+  // Up to the largest value, as larger encodings saturate
+  uint8_t max_pos_fp8;
+  FloatToFloat8_ref(
+      numeric_limits<float>::infinity(),
+      &max_pos_fp8,
+      exponent_bits,
+      exponent_bias);
+  float max_pos;
+  Float8ToFloat_ref(max_pos_fp8, &max_pos, exponent_bits, exponent_bias);
+  for (int i = 0; i < 256; ++i) {
+    if (std::abs(src[100 + i]) <= max_pos) {
+      float y;
+      Float8ToFloat_ref(ref[100 + i], &y, exponent_bits, exponent_bias);
+      EXPECT_EQ(y, src[100 + i]) << "float8 " << i;
+    }
+  }
+
+  // Odd sizes and thread partitions go through the remainders
+  for (int num_threads : {1, 3}) {
+    for (size_t size : {src.size(), size_t(7), size_t(29)}) {
+      vector<uint8_t> dst(size);
+      for (int tid = 0; tid < num_threads; ++tid) {
+        FloatToFloat8_simd(
+            src.data(),
+            dst.data(),
+            size,
+            exponent_bits,
+            exponent_bias,
+            tid,
+            num_threads);
+      }
+      for (size_t i = 0; i < size; ++i) {
+        EXPECT_EQ(dst[i], ref[i]) << "at " << i << " for " << src[i];
+      }
+      if (fbgemmHasAvx2Support()) {
+        FloatToFloat8_avx2(
+            src.data(), dst.data(), size, exponent_bits, exponent_bias);
+        EXPECT_TRUE(equal(dst.begin(), dst.end(), ref.begin())) << "avx2";
+      }
+    }
+  }
+}
+
+TEST_P(FBGemmFloat8Test, Float8ToFloatMatchesRef) {
+  const auto [exponent_bits, exponent_bias] = GetParam();
+
+  vector<uint8_t> src(256 + 21);
+  for (size_t i = 0; i < src.size(); ++i) {
+    src[i] = i * 37;
+  }
+  vector<float> ref(src.size());
+  for (size_t i = 0; i < src.size(); ++i) {
+    Float8ToFloat_ref(src[i], &ref[i], exponent_bits, exponent_bias);
+  }
+
+  for (int num_threads : {1, 3}) {
+    vector<float> dst(src.size());
+    for (int tid = 0; tid < num_threads; ++tid) {
+      Float8ToFloat_simd(
+          src.data(),
+          dst.data(),
+          src.size(),
+          exponent_bits,
+          exponent_bias,
+          tid,
+          num_threads);
+    }
+    // Compare the bits to tell -0 from 0
+    EXPECT_EQ(memcmp(dst.data(), ref.data(), dst.size() * sizeof(float)), 0);
+    if (fbgemmHasAvx2Support()) {
+      Float8ToFloat_avx2(
+          src.data(), dst.data(), dst.size(), exponent_bits, exponent_bias);
+      EXPECT_EQ(memcmp(dst.data(), ref.data(), dst.size() * sizeof(float)), 0)
+          << "avx2";
+    }
+  }
+}
@@ -179,6 +179,20 @@ GetShapes_() {
         {2, 2, 2}, {1, 1, 1, 1, 1, 1}),
     conv_param_t<3>(1, 16, 16, {5, 3, 3}, 8, {3, 3, 3},
         {2, 2, 2}, {1, 1, 1, 1, 1, 1}),
+
+    // Temporal kernel size, padding, stride and dilation
+    conv_param_t<3>(1, 16, 16, {4, 5, 5}, 8, {1, 3, 3},
+        {1, 1, 1}, {0, 1, 1, 0, 1, 1}),
+    conv_param_t<3>(2, 16, 16, {4, 6, 6}, 4, {1, 3, 3},
+        {2, 2, 2}, {0, 1, 1, 0, 1, 1}),
+    conv_param_t<3>(1, 16, 16, {6, 5, 5}, 2, {5, 3, 3},
+        {1, 1, 1}, {2, 1, 1, 2, 1, 1}),
+    conv_param_t<3>(1, 16, 16, {5, 5, 5}, 4, {2, 3, 3},
+        {1, 1, 1}, {1, 1, 1, 0, 1, 1}),
+    conv_param_t<3>(1, 32, 32, {5, 5, 5}, 2, {3, 3, 3},
+        {2, 1, 1}, {0, 1, 1, 0, 1, 1}),
+    conv_param_t<3>(1, 16, 16, {6, 5, 5}, 8, {3, 3, 3},
+        {1, 1, 1}, {2, 1, 1, 2, 1, 1}, {2, 1, 1}),
   };
   return shapes;
   // clang-format off
@@ -497,6 +511,108 @@ TEST_P(fbgemmGConvAcc32WithQuantGranularityTest, requantizeTest) {
   runRequantizeTest<3>(atrans, btrans, q_granularity, a_symmetric, b_symmetric);
 }
 
+/**
+ * @brief Runs fbgemmGroupwiseConv for each thread id of a partition in turn
+ * and checks the result does not depend on how the work is split, including
+ * the splits over output rows used when there are fewer images and groups
+ * than threads.
+ */
+template <int SPATIAL_DIM = 2>
+void runThreadPartitionTest() {
+  vector<conv_param_t<SPATIAL_DIM>> shapes(GetShapes_<SPATIAL_DIM>());
+  for (auto conv_p : shapes) {
+    int T = SPATIAL_DIM <= 2 ? 1 : conv_p.K[SPATIAL_DIM - 3];
+    int R = SPATIAL_DIM == 1 ? 1 : conv_p.K[SPATIAL_DIM - 2];
+    int S = conv_p.K[SPATIAL_DIM - 1];
+    int G = conv_p.G;
+    int IC_per_G = conv_p.IC / G;
+    int OC_per_G = conv_p.OC / G;
+    int IN_SIZE = conv_p.MB * conv_p.IC;
+    int OUT_SIZE = conv_p.MB * conv_p.OC;
+    for (int d = 0; d < SPATIAL_DIM; ++d) {
+      IN_SIZE *= conv_p.IN_DIM[d];
+      OUT_SIZE *= conv_p.OUT_DIM[d];
+    }
+
+    aligned_vector<uint8_t> Aint8(IN_SIZE);
+    aligned_vector<int8_t> Bint8(T * R * S * G * IC_per_G * OC_per_G);
+    randFill<uint8_t>(Aint8, 0, 5);
+    randFill<int8_t>(Bint8, -4, 4);
+    int32_t Aint8_zero_point = 4;
+
+    aligned_vector<int32_t> Bint8_zero_point(conv_p.OC);
+    randFill(Bint8_zero_point, -3, -1);
+    aligned_vector<float> C_multiplier(conv_p.OC);
+    randFill(C_multiplier, 0.1234f / 2, 0.1234f * 3 / 2);
+    int32_t C_zero_pt = 5;
+    aligned_vector<int32_t> col_offsets(conv_p.OC);
+    randFill(col_offsets, -100, 100);
+
+    PackWeightMatrixForGConv<int8_t, int32_t, SPATIAL_DIM> packedWeights(
+        matrix_op_t::Transpose, conv_p, Bint8.data(), nullptr);
+
+    aligned_vector<uint8_t> Cint8_single;
+    for (int num_threads : {1, 2, 3, 7, 16, 64}) {
+      aligned_vector<int32_t> Cint32_fb(OUT_SIZE);
+      aligned_vector<uint8_t> Cint8_fb(OUT_SIZE);
+      for (int tid = 0; tid < num_threads; ++tid) {
+        vector<int32_t> row_offset_buf(rowOffsetBufferSizeGConv(conv_p));
+        DoNothing<> doNothingObj{};
+        ReQuantizeOutput<false, QuantizationGranularity::OUT_CHANNEL> reqObj(
+            doNothingObj,
+            C_multiplier.data(),
+            C_zero_pt,
+            Aint8_zero_point,
+            Bint8_zero_point.data(),
+            row_offset_buf.data(),
+            col_offsets.data(),
+            nullptr,
+            conv_p.OC,
+            G);
+
+        fbgemmGroupwiseConv(
+            conv_p,
+            Aint8.data(),
+            Aint8_zero_point,
+            row_offset_buf.data(),
+            packedWeights,
+            Cint8_fb.data(),
+            Cint32_fb.data(),
+            reqObj,
+            tid,
+            num_threads);
+      }
+      if (num_threads == 1) {
+        Cint8_single = Cint8_fb;
+      } else {
+        EXPECT_EQ(Cint8_fb, Cint8_single) << "num_threads " << num_threads;
+      }
+    }
+  } // for each shape
+}
+
+TEST(fbgemmGConvThreadPartitionTest, matchesSingleThread) {
+  runThreadPartitionTest<2>();
+  runThreadPartitionTest<3>();
+}
+
+TEST(fbgemmGConvFastPathTest, temporalDims3D) {
+  // Any temporal kernel size, padding and dilation
+  EXPECT_TRUE(fbgemmOptimizedGConv(conv_param_t<3>(
+      1, 16, 16, {4, 5, 5}, 8, {1, 3, 3}, {1, 1, 1}, {0, 1, 1, 0, 1, 1})));
+  EXPECT_TRUE(fbgemmOptimizedGConv(conv_param_t<3>(
+      1, 16, 16, {6, 5, 5}, 8, {3, 3, 3}, {1, 1, 1}, {2, 1, 1, 2, 1, 1},
+      {2, 1, 1})));
+  // Height and width are as restricted as in 2D
+  EXPECT_FALSE(fbgemmOptimizedGConv(conv_param_t<3>(
+      1, 16, 16, {4, 5, 5}, 8, {3, 1, 1}, {1, 1, 1}, {1, 0, 0, 1, 0, 0})));
+  EXPECT_FALSE(fbgemmOptimizedGConv(conv_param_t<3>(
+      1, 16, 16, {4, 5, 5}, 8, {3, 3, 3}, {1, 1, 1}, {1, 1, 1, 1, 0, 0})));
+  EXPECT_FALSE(fbgemmOptimizedGConv(conv_param_t<3>(
+      1, 16, 16, {4, 9, 9}, 8, {3, 3, 3}, {1, 1, 1}, {1, 2, 2, 1, 2, 2},
+      {1, 2, 2})));
+}
+
 /**
  * @brief Unit test for uint8 activations, int8 weights, and 32-bit
  * accumulation. Output processing: nothing
@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <gtest/gtest.h>
+
+#include "bench/BenchUtils.h"
+#include "fbgemm/Fbgemm.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+// {M, N, K, groups}
+class GemmTileSchedulerTest
+    : public testing::TestWithParam<tuple<int, int, int, int>> {};
+
+} // namespace
+
+INSTANTIATE_TEST_CASE_P(
+    InstantiationName,
+    GemmTileSchedulerTest,
+    ::testing::Values(
+        make_tuple(1, 128, 512, 1),
+        make_tuple(7, 1000, 300, 1),
+        make_tuple(300, 64, 2000, 1),
+        make_tuple(513, 257, 64, 1),
+        make_tuple(100, 96, 96, 3)));
+
+// Taking tiles from a scheduler must give the same results as the static
+// partition.
+TEST_P(GemmTileSchedulerTest, matchesStaticPartition) {
+  const auto [m, n, k, groups] = GetParam();
+  default_random_engine generator;
+  uniform_int_distribution<int> a_dist(0, 255);
+  uniform_int_distribution<int> b_dist(-128, 127);
+  vector<uint8_t> A(m * k * groups);
+  vector<int8_t> B(k * n * groups);
+  for (auto& v : A) {
+    v = a_dist(generator);
+  }
+  for (auto& v : B) {
+    v = b_dist(generator);
+  }
+  const int32_t A_zero_point = 3;
+  vector<int32_t> B_zero_point(1, -2);
+  vector<float> C_multiplier(1, 1e-4f);
+  const int32_t C_zero_point = 5;
+  vector<int32_t> col_offsets(groups * n);
+  for (int g = 0; g < groups; ++g) {
+    for (int j = 0; j < n; ++j) {
+      int32_t sum = 0;
+      for (int kk = 0; kk < k; ++kk) {
+        sum += B[(g * k + kk) * n + j];
+      }
+      col_offsets[g * n + j] = sum - B_zero_point[0] * k;
+    }
+  }
+  PackBMatrix<int8_t> packedB(
+      matrix_op_t::NoTranspose,
+      k * groups,
+      n,
+      B.data(),
+      n,
+      nullptr,
+      groups);
+
+  vector<uint8_t> C_static(m * n * groups), C_dynamic(m * n * groups);
+  vector<int32_t> C_buffer(m * n * groups);
+  GemmTileScheduler scheduler;
+  for (bool dynamic : {false, true}) {
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+    {
+      vector<int32_t> row_offset_buf(
+          PackAWithRowOffset<uint8_t>::rowOffsetBufferSize());
+      PackAWithRowOffset<uint8_t> packA(
+          matrix_op_t::NoTranspose,
+          m,
+          k * groups,
+          A.data(),
+          k * groups,
+          nullptr,
+          groups,
+          row_offset_buf.data());
+      DoNothing<> doNothingObj{};
+      ReQuantizeOutput<false> outputProcObj(
+          doNothingObj,
+          C_multiplier.data(),
+          C_zero_point,
+          A_zero_point,
+          B_zero_point.data(),
+          packA.getRowOffsetBuffer(),
+          col_offsets.data(),
+          nullptr,
+          groups * n,
+          groups);
+      fbgemmPacked(
+          packA,
+          packedB,
+          dynamic ? C_dynamic.data() : C_static.data(),
+          C_buffer.data(),
+          groups * n,
+          outputProcObj,
+          fbgemm_get_thread_num(),
+          fbgemm_get_num_threads(),
+          nullptr,
+          dynamic ? &scheduler : nullptr);
+    }
+  }
+  EXPECT_EQ(C_dynamic, C_static);
+
+  // Tiles taken by a single thread also cover the whole matrix.
+  scheduler.reset();
+  vector<uint8_t> C_single(m * n * groups);
+  {
+    vector<int32_t> row_offset_buf(
+        PackAWithRowOffset<uint8_t>::rowOffsetBufferSize());
+    PackAWithRowOffset<uint8_t> packA(
+        matrix_op_t::NoTranspose,
+        m,
+        k * groups,
+        A.data(),
+        k * groups,
+        nullptr,
+        groups,
+        row_offset_buf.data());
+    DoNothing<> doNothingObj{};
+    ReQuantizeOutput<false> outputProcObj(
+        doNothingObj,
+        C_multiplier.data(),
+        C_zero_point,
+        A_zero_point,
+        B_zero_point.data(),
+        packA.getRowOffsetBuffer(),
+        col_offsets.data(),
+        nullptr,
+        groups * n,
+        groups);
+    fbgemmPacked(
+        packA,
+        packedB,
+        C_single.data(),
+        C_buffer.data(),
+        groups * n,
+        outputProcObj,
+        0,
+        4,
+        nullptr,
+        &scheduler);
+  }
+  EXPECT_EQ(C_single, C_static);
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "fbgemm/Fbgemm.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+struct Gemm {
+  int m, n, k;
+  vector<uint8_t> A;
+  vector<int32_t> row_offsets;
+  vector<int32_t> col_offsets;
+  vector<uint8_t> C, C_ref;
+  vector<int32_t> C_buffer;
+  unique_ptr<PackBMatrix<int8_t>> packB;
+  unique_ptr<PackAWithRowOffset<uint8_t>> packA;
+  unique_ptr<ReQuantizeOutput<false>> outProcess;
+};
+
+DoNothing<> doNothingObj{};
+const int32_t A_zero_point = 2;
+const int32_t B_zero_point = -1;
+const int32_t C_zero_point = 7;
+const float C_multiplier = 2e-4f;
+
+} // namespace
+
+// Each GEMM must give the same results as when it is run by fbgemmPacked.
+TEST(GroupedGemmTest, matchesFbgemmPacked) {
+  default_random_engine generator;
+  uniform_int_distribution<int> m_dist(1, 32);
+  uniform_int_distribution<int> n_dist(1, 200);
+  uniform_int_distribution<int> k_dist(1, 300);
+  uniform_int_distribution<int> a_dist(0, 255);
+  uniform_int_distribution<int> b_dist(-128, 127);
+
+  vector<Gemm> gemms(100);
+  for (auto& gemm : gemms) {
+    gemm.m = m_dist(generator);
+    gemm.n = n_dist(generator);
+    gemm.k = k_dist(generator);
+    gemm.A.resize(gemm.m * gemm.k);
+    for (auto& v : gemm.A) {
+      v = a_dist(generator);
+    }
+    vector<int8_t> B(gemm.k * gemm.n);
+    for (auto& v : B) {
+      v = b_dist(generator);
+    }
+    gemm.col_offsets.assign(gemm.n, -B_zero_point * gemm.k);
+    for (int kk = 0; kk < gemm.k; ++kk) {
+      for (int j = 0; j < gemm.n; ++j) {
+        gemm.col_offsets[j] += B[kk * gemm.n + j];
+      }
+    }
+    gemm.packB = make_unique<PackBMatrix<int8_t>>(
+        matrix_op_t::NoTranspose, gemm.k, gemm.n, B.data(), gemm.n);
+    gemm.row_offsets.resize(
+        PackAWithRowOffset<uint8_t>::rowOffsetBufferSize());
+    gemm.packA = make_unique<PackAWithRowOffset<uint8_t>>(
+        matrix_op_t::NoTranspose,
+        gemm.m,
+        gemm.k,
+        gemm.A.data(),
+        gemm.k,
+        nullptr,
+        1,
+        gemm.row_offsets.data());
+    gemm.outProcess = make_unique<ReQuantizeOutput<false>>(
+        doNothingObj,
+        &C_multiplier,
+        C_zero_point,
+        A_zero_point,
+        &B_zero_point,
+        gemm.packA->getRowOffsetBuffer(),
+        gemm.col_offsets.data(),
+        nullptr,
+        gemm.n);
+    gemm.C.resize(gemm.m * gemm.n);
+    gemm.C_ref.resize(gemm.m * gemm.n);
+    gemm.C_buffer.resize(gemm.m * gemm.n);
+
+    fbgemmPacked(
+        *gemm.packA,
+        *gemm.packB,
+        gemm.C_ref.data(),
+        gemm.C_buffer.data(),
+        gemm.n,
+        *gemm.outProcess,
+        0,
+        1);
+  }
+
+  using Args = PackedGemmArgs<
+      PackAWithRowOffset<uint8_t>,
+      PackBMatrix<int8_t>,
+      uint8_t,
+      ReQuantizeOutput<false>>;
+  vector<Args> args;
+  for (auto& gemm : gemms) {
+    args.push_back(Args{
+        gemm.packA.get(),
+        gemm.packB.get(),
+        gemm.C.data(),
+        gemm.C_buffer.data(),
+        static_cast<uint32_t>(gemm.n),
+        gemm.outProcess.get()});
+  }
+  GemmTileScheduler scheduler;
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  fbgemmPackedGrouped(args.data(), args.size(), scheduler);
+
+  for (size_t i = 0; i < gemms.size(); ++i) {
+    EXPECT_EQ(gemms[i].C, gemms[i].C_ref) << "GEMM " << i << " differs";
+  }
+}
@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <gtest/gtest.h>
+
+#include "bench/BenchUtils.h"
+#include "fbgemm/FbgemmI4.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+// {M, N, K, groups, B transposed}
+class I4GemmTest
+    : public testing::TestWithParam<tuple<int, int, int, int, bool>> {};
+
+} // namespace
+
+INSTANTIATE_TEST_CASE_P(
+    InstantiationName,
+    I4GemmTest,
+    ::testing::Values(
+        make_tuple(1, 16, 8, 1, false),
+        make_tuple(1, 1000, 512, 4, true),
+        make_tuple(3, 40, 300, 1, false),
+        make_tuple(7, 100, 96, 8, true),
+        make_tuple(16, 33, 60, 3, false),
+        make_tuple(37, 64, 128, 2, true)));
+
+// Power of two scales keep the result exact, so it must match the reference.
+TEST_P(I4GemmTest, matchesReference) {
+  const auto [m, n, k, groups, transB] = GetParam();
+  default_random_engine generator;
+  uniform_int_distribution<int> a_dist(0, 255);
+  // Some values are outside the int4 range and saturate.
+  uniform_int_distribution<int> b_dist(-10, 9);
+  uniform_int_distribution<int> zp_dist(-3, 3);
+  uniform_int_distribution<int> scale_dist(0, 2);
+
+  vector<uint8_t> A(m * k);
+  for (auto& v : A) {
+    v = a_dist(generator);
+  }
+  vector<int8_t> B(k * n);
+  for (auto& v : B) {
+    v = b_dist(generator);
+  }
+  vector<float> scales(groups);
+  vector<int32_t> zero_points(groups);
+  for (int g = 0; g < groups; ++g) {
+    scales[g] = 1 << scale_dist(generator);
+    zero_points[g] = zp_dist(generator);
+  }
+  vector<float> bias(n);
+  for (auto& v : bias) {
+    v = b_dist(generator);
+  }
+  const int32_t A_zero_point = 11;
+  const float A_scale = 0.5f;
+
+  // B is k x n, or n x k when transposed.
+  auto b_at = [&](int kk, int j) {
+    return transB ? B[j * k + kk] : B[kk * n + j];
+  };
+  PackBMatrixI4 packedB(
+      transB ? matrix_op_t::Transpose : matrix_op_t::NoTranspose,
+      k,
+      n,
+      B.data(),
+      transB ? k : n,
+      groups,
+      scales.data(),
+      zero_points.data());
+
+  const int group_size = k / groups;
+  vector<float> C_ref(m * n);
+  for (int i = 0; i < m; ++i) {
+    for (int j = 0; j < n; ++j) {
+      double acc = 0;
+      for (int kk = 0; kk < k; ++kk) {
+        const int g = kk / group_size;
+        const int q = min(max<int>(b_at(kk, j), -8), 7);
+        acc += static_cast<double>(scales[g]) * (A[i * k + kk] - A_zero_point) *
+            (q - zero_points[g]);
+      }
+      C_ref[i * n + j] = A_scale * acc + bias[j];
+    }
+  }
+  for (int kk = 0; kk < k; ++kk) {
+    for (int j = 0; j < n; ++j) {
+      ASSERT_EQ(packedB.value(kk, j), min(max<int>(b_at(kk, j), -8), 7));
+    }
+  }
+
+  vector<float> C(m * n);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  fbgemmU8I4Gemm(
+      m,
+      A.data(),
+      k,
+      A_zero_point,
+      A_scale,
+      packedB,
+      bias.data(),
+      C.data(),
+      n,
+      fbgemm_get_thread_num(),
+      fbgemm_get_num_threads());
+  EXPECT_EQ(C, C_ref);
+}
@@ -101,3 +101,86 @@ TEST_F(Int64GemmTest, test) {
     } // transa
   } // for each shape
 }
+
+// The prepacked B and the partitions of the threads must give the same C as
+// the reference.
+TEST_F(Int64GemmTest, prepackedAndThreaded) {
+  const auto shapes = GenParams();
+  for (size_t s = 0; s < shapes.size(); s += 8) {
+    const int m = shapes[s][0];
+    const int n = shapes[s][1] * 3;
+    const int k = shapes[s][2];
+
+    aligned_vector<int64_t> A(m * k);
+    aligned_vector<int64_t> B(k * n);
+    randFill(
+        A, numeric_limits<int64_t>::lowest(), numeric_limits<int64_t>::max());
+    randFill(
+        B, numeric_limits<int64_t>::lowest(), numeric_limits<int64_t>::max());
+
+    for (matrix_op_t transa :
+         {matrix_op_t::NoTranspose, matrix_op_t::Transpose}) {
+      const int lda = transa == matrix_op_t::Transpose ? m : k;
+      for (matrix_op_t transb :
+           {matrix_op_t::NoTranspose, matrix_op_t::Transpose}) {
+        const int ldb = transb == matrix_op_t::Transpose ? k : n;
+        PackedGemmMatrixI64 Bp(transb, k, n, B.data(), ldb);
+
+        for (const bool accumulate : {false, true}) {
+          aligned_vector<int64_t> C_ref(m * n);
+          randFill<int64_t>(C_ref, -100, 100);
+          const aligned_vector<int64_t> C = C_ref;
+          cblas_gemm_i64_i64acc_ref(
+              transa,
+              transb,
+              m,
+              n,
+              k,
+              A.data(),
+              lda,
+              B.data(),
+              ldb,
+              accumulate,
+              C_ref.data(),
+              n);
+
+          for (const int num_threads : {1, 3, 8}) {
+            aligned_vector<int64_t> C_threaded = C, C_packed_threaded = C;
+            for (int tid = 0; tid < num_threads; ++tid) {
+              cblas_gemm_i64_i64acc(
+                  transa,
+                  transb,
+                  m,
+                  n,
+                  k,
+                  A.data(),
+                  lda,
+                  B.data(),
+                  ldb,
+                  accumulate,
+                  C_threaded.data(),
+                  n,
+                  tid,
+                  num_threads);
+              cblas_gemm_i64_i64acc(
+                  transa,
+                  m,
+                  A.data(),
+                  lda,
+                  Bp,
+                  accumulate,
+                  C_packed_threaded.data(),
+                  n,
+                  tid,
+                  num_threads);
+            }
+            compare_validate_buffers<int64_t>(
+                C_ref.data(), C_threaded.data(), m, n, n, 0L);
+            compare_validate_buffers<int64_t>(
+                C_ref.data(), C_packed_threaded.data(), m, n, n, 0L);
+          }
+        }
+      } // transb
+    } // transa
+  } // for each shape
+}
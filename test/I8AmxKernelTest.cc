@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "fbgemm/Utils.h"
+#include "src/FbgemmI8Amx.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+// KCB and NCB of the avx512_vnni int8 packing.
+constexpr int kLda = 512;
+constexpr int kNcb = 48;
+
+class I8AmxKernelTest
+    : public testing::TestWithParam<tuple<int, int, int, bool>> {};
+
+} // namespace
+
+INSTANTIATE_TEST_CASE_P(
+    InstantiationName,
+    I8AmxKernelTest,
+    ::testing::Combine(
+        ::testing::Values(1, 15, 16, 17, 100, 384), // mc
+        ::testing::Values(16, 32, 48), // nc
+        ::testing::Values(4, 60, 64, 68, 256, 512), // kc
+        ::testing::Bool())); // accum
+
+TEST_P(I8AmxKernelTest, matchesReference) {
+  if (!fbgemmHasAmxInt8Support()) {
+    return;
+  }
+  const auto [mc, nc, kc, accum] = GetParam();
+  const int ldb = kNcb * 4;
+  const int ldc = nc + 5;
+
+  default_random_engine generator;
+  uniform_int_distribution<int> a_distribution(0, 255);
+  uniform_int_distribution<int> b_distribution(-128, 127);
+  vector<uint8_t> A(mc * kLda);
+  for (auto& v : A) {
+    v = a_distribution(generator);
+  }
+  // Packed B: 4 consecutive k of each column next to each other. The columns
+  // past nc and the rows past kc are filled too, as in a packed block that
+  // is not the last one.
+  vector<int8_t> B(kLda / 4 * ldb);
+  for (auto& v : B) {
+    v = b_distribution(generator);
+  }
+  vector<int32_t> C(mc * ldc);
+  for (auto& v : C) {
+    v = b_distribution(generator);
+  }
+
+  vector<int32_t> C_ref(C);
+  for (int i = 0; i < mc; ++i) {
+    for (int j = 0; j < nc; ++j) {
+      int32_t sum = accum ? C_ref[i * ldc + j] : 0;
+      for (int k = 0; k < kc; ++k) {
+        sum += A[i * kLda + k] * B[k / 4 * ldb + j * 4 + k % 4];
+      }
+      C_ref[i * ldc + j] = sum;
+    }
+  }
+
+  gemmKernelU8S8S32ACC32Amx(
+      A.data(), kLda, B.data(), ldb, C.data(), ldc, mc, nc, kc, accum);
+  for (size_t i = 0; i < C.size(); ++i) {
+    EXPECT_EQ(C[i], C_ref[i]) << "results differ at " << i;
+  }
+}
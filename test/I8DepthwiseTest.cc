@@ -13,6 +13,7 @@
 
 #include "bench/AlignedVec.h"
 #include "bench/BenchUtils.h"
+#include "fbgemm/Fbgemm.h"
 #include "fbgemm/FbgemmI8DepthwiseAvx2.h"
 #include "src/RefImplementations.h"
 
@@ -76,6 +77,21 @@ static vector<vector<int>> shapes = {
   {   1,  72,  1, 7, 2, 5 },
 };
 
+// Dilated convolutions from segmentation heads
+static vector<vector<int>> shapes_dilated = {
+  // N, G, H_in, W_in, stride, kernel, dilation
+  {   1,   64,  33,  33, 1, 3, 2 },
+  {   1,   64,  33,  33, 1, 3, 6 },
+  {   2,  128,  17,  17, 1, 3, 4 },
+  {   1,   72,  28,  30, 2, 3, 2 },
+  {   1,   32,  24,  24, 1, 5, 2 },
+  {   1,   32,  23,  27, 2, 5, 3 },
+  {   1,   16,  20,  20, 1, 7, 2 },
+  // The dilated filter is larger than the input
+  {   1,   24,   5,   6, 1, 3, 4 },
+  {   1,   24,   5,   6, 2, 7, 2 },
+};
+
 static vector<vector<int>> shapes_3d = {
   // NOTE: clang-format wants to use a different formatting but the current
   // formatting should be easier to read.
@@ -132,7 +148,10 @@ TEST_P(FBGemmDepthWiseTest, Test2D) {
   int oc_per_g;
   tie(a_symmetric, b_symmetric, oc_per_g) = GetParam();
 
-  for (auto shape : shapes) {
+  vector<vector<int>> shapes_2d(shapes);
+  shapes_2d.insert(
+      shapes_2d.end(), shapes_dilated.begin(), shapes_dilated.end());
+  for (auto shape : shapes_2d) {
     int N = shape[0];
     int G = shape[1];
     int H = shape[2];
@@ -141,8 +160,9 @@ TEST_P(FBGemmDepthWiseTest, Test2D) {
     int stride_w = stride_h;
     int R = shape[5];
     int S = R;
-    int PAD_T = (R - 1) / 2, PAD_B = (R - 1) / 2, PAD_L = (S - 1) / 2,
-        PAD_R = (S - 1) / 2;
+    int dilation = shape.size() > 6 ? shape[6] : 1;
+    int PAD_T = dilation * (R - 1) / 2, PAD_B = PAD_T,
+        PAD_L = dilation * (S - 1) / 2, PAD_R = PAD_L;
     int OC = G * oc_per_g;
 
     conv_param_t<2> conv_p(
@@ -153,7 +173,11 @@ TEST_P(FBGemmDepthWiseTest, Test2D) {
         G,
         {R, S},
         {stride_h, stride_w},
-        {PAD_T, PAD_L, PAD_B, PAD_R});
+        {PAD_T, PAD_L, PAD_B, PAD_R},
+        {dilation, dilation});
+    ASSERT_EQ((ConvFastPath<2, int32_t>(conv_p)), optimized_conv_t::depthwise)
+        << "Depthwise " << R << "x" << S << " with dilation " << dilation
+        << " should take the depthwise fast path";
     int H_OUT = conv_p.OUT_DIM[0];
     int W_OUT = conv_p.OUT_DIM[1];
 
@@ -244,7 +268,9 @@ TEST_P(FBGemmDepthWiseTest, Test2D) {
         false, /* fuse_relu */
         nullptr, /* act_scale * w_scale */
         0,
-        1);
+        1,
+        dilation,
+        dilation);
 
     // correctness check
     for (int n = 0; n < N; ++n) {
@@ -255,8 +281,9 @@ TEST_P(FBGemmDepthWiseTest, Test2D) {
                 C_uint8_ref[((n * H_OUT + h) * W_OUT + w) * OC + k];
             int32_t actual = C_uint8[((n * H_OUT + h) * W_OUT + w) * OC + k];
             EXPECT_EQ(actual, expected)
-                << "Depthwise " << R << "x" << S << " results differ at (" << n
-                << ", " << h << ", " << w << ", " << k << ").";
+                << "Depthwise " << R << "x" << S << " dilation " << dilation
+                << " results differ at (" << n << ", " << h << ", " << w
+                << ", " << k << ").";
           }
         }
       }
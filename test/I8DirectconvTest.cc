@@ -11,12 +11,20 @@
 #include <cmath>
 #include <cstdio>
 #include <iomanip>
+#include <memory>
 #include <numeric>
 #include <random>
 #include <vector>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <cpuinfo.h>
 #include <gtest/gtest.h>
 
+#include "./QuantizationHelpers.h"
+#include "./TestUtils.h"
 #include "bench/AlignedVec.h"
 #include "bench/BenchUtils.h"
 #include "fbgemm/Fbgemm.h"
@@ -842,4 +850,248 @@ TEST_P(FBGemmDirectConvTransFbgemmTest, Test2D) {
   } // for each shape
 }
 
+// Non-transposed dense convs taking the direct conv path
+// clang-format off
+vector<conv_param_t<2>> shapes_general = {
+  // MB, IC, OC, {IH, IW}, G, {KH, KW}, {stride_h, stride_w},
+  // {pad_t, pad_l, pad_b, pad_r}, {dilation_h, dilation_w}
+  conv_param_t<>(1, 3, 32, {28, 28}, 1, {7, 7}, {2, 2}, {3, 3, 3, 3}),
+  conv_param_t<>(2, 32, 48, {14, 14}, 1, {3, 3}, {2, 2}, {1, 1, 1, 1}),
+  conv_param_t<>(1, 17, 20, {9, 11}, 1, {5, 5}, {1, 1}, {2, 2, 2, 2}),
+  conv_param_t<>(1, 24, 13, {10, 10}, 1, {3, 3}, {1, 1}, {2, 2, 2, 2}, {2, 2}),
+  conv_param_t<>(1, 64, 40, {12, 7}, 1, {1, 1}, {2, 2}, {0, 0, 0, 0}),
+  conv_param_t<>(1, 8, 16, {13, 13}, 1, {7, 1}, {1, 1}, {3, 0, 3, 0}),
+  conv_param_t<>(3, 16, 8, {10, 15}, 1, {1, 3}, {3, 2}, {0, 1, 2, 0}),
+  conv_param_t<>(1, 5, 7, {6, 6}, 1, {2, 2}, {1, 1}, {0, 0, 1, 1}),
+};
+// clang-format on
+
+namespace {
+class FBGemmDirectConvGeneralTest
+    : public testing::TestWithParam<
+          tuple<QuantizationGranularity, bool, bool>> {};
+} // namespace
+
+INSTANTIATE_TEST_CASE_P(
+    InstantiationName,
+    FBGemmDirectConvGeneralTest,
+    ::testing::Combine(
+        ::testing::Values(
+            QuantizationGranularity::TENSOR,
+            QuantizationGranularity::OUT_CHANNEL),
+        ::testing::Bool(), // a_symmetric
+        ::testing::Bool())); // b_symmetric
+
+template <QuantizationGranularity Q_GRAN>
+void runDirectConvGeneralTest(
+    const conv_param_t<2>& conv_p,
+    bool a_symmetric,
+    bool b_symmetric,
+    bool full_range = false,
+    bool pack_under_avx2_scope = false) {
+  int im_in_dim = accumulate(
+      conv_p.IN_DIM.begin(), conv_p.IN_DIM.end(), 1, multiplies<int>());
+  int im_out_dim = accumulate(
+      conv_p.OUT_DIM.begin(), conv_p.OUT_DIM.end(), 1, multiplies<int>());
+  int kernel_dim =
+      accumulate(conv_p.K.begin(), conv_p.K.end(), 1, multiplies<int>());
+  int MDim = conv_p.MB * im_out_dim;
+  int NDim = conv_p.OC;
+  int KDim = kernel_dim * conv_p.IC;
+  int ncols_per_quant_group =
+      Q_GRAN == QuantizationGranularity::OUT_CHANNEL ? 1 : NDim;
+
+  aligned_vector<uint8_t> Aint8(conv_p.MB * im_in_dim * conv_p.IC);
+  aligned_vector<int8_t> Bint8(KDim * NDim);
+  aligned_vector<int8_t> Bint8_tr(Bint8.size());
+  if (full_range) {
+    randFill<uint8_t>(Aint8, 0, 255);
+    randFill<int8_t>(Bint8, -128, 127);
+  } else {
+    randFill<uint8_t>(Aint8, 0, 5);
+    randFill<int8_t>(Bint8, -4, 4);
+  }
+  int32_t Aint8_zero_point = a_symmetric ? 0 : 4;
+  aligned_vector<int32_t> Bint8_zero_point(NDim / ncols_per_quant_group);
+  randFill(Bint8_zero_point, b_symmetric ? 0 : -3, b_symmetric ? 0 : -1);
+  aligned_vector<float> C_multiplier(Bint8_zero_point.size());
+  randFill(C_multiplier, 0.001234f / 2, 0.001234f * 3 / 2);
+  int32_t C_zero_point = 5;
+  aligned_vector<int32_t> bias(NDim);
+  randFill(bias, -8, 8);
+
+  // reference implementation
+  aligned_vector<int32_t> Cint32_ref(MDim * NDim);
+  aligned_vector<uint8_t> Cint8_ref(Cint32_ref.size());
+  transposeConvWeights<2>(conv_p, Bint8.data(), Bint8_tr.data());
+  vector<int32_t> row_offsets(MDim);
+  vector<uint8_t> Aint8_im2col(MDim * KDim);
+  im2col_ref(conv_p, Aint8.data(), Aint8_zero_point, Aint8_im2col.data());
+  if (full_range) {
+    // vpmaddubsw saturates the sums of pairs of input channels of a tap,
+    // which are pairs of im2col columns when IC is even.
+    assert(conv_p.IC % 2 == 0);
+    avoidOverflow(MDim, NDim, KDim, Aint8_im2col.data(), Bint8_tr.data());
+    for (int k = 0; k < NDim; ++k) {
+      for (int kk = 0; kk < KDim; ++kk) {
+        Bint8[k * KDim + kk] = Bint8_tr[kk * NDim + k];
+      }
+    }
+  }
+  conv_ref(
+      conv_p,
+      Aint8.data(),
+      Aint8_zero_point,
+      Bint8_tr.data(),
+      Cint32_ref.data());
+
+  row_offsets_u8acc32_ref(
+      MDim, KDim, KDim, Aint8_im2col.data(), row_offsets.data());
+
+  vector<int32_t> col_offsets(NDim);
+  col_offsets_with_zero_pt_s8acc32_ref(
+      KDim,
+      NDim,
+      NDim,
+      Bint8_tr.data(),
+      Bint8_zero_point.data(),
+      col_offsets.data(),
+      ncols_per_quant_group);
+
+  requantize_u8acc32_ref(
+      MDim,
+      NDim,
+      NDim,
+      Cint32_ref.data(),
+      Cint8_ref.data(),
+      C_multiplier.data(),
+      C_zero_point,
+      Aint8_zero_point,
+      Bint8_zero_point.data(),
+      row_offsets.data(),
+      col_offsets.data(),
+      bias.data(),
+      ncols_per_quant_group);
+
+  unique_ptr<PackWeightsForConv<2>> packedB_ptr;
+  {
+    unique_ptr<FbgemmIsaScope> scope;
+    if (pack_under_avx2_scope) {
+      scope = make_unique<FbgemmIsaScope>(inst_set_t::avx2);
+    }
+    ASSERT_EQ(ConvFastPath<2>(conv_p), optimized_conv_t::directconv);
+    packedB_ptr = make_unique<PackWeightsForConv<2>>(conv_p, Bint8.data());
+  }
+  PackWeightsForConv<2>& packedB_2D = *packedB_ptr;
+  ASSERT_EQ(packedB_2D.convPath(), optimized_conv_t::directconv);
+
+  aligned_vector<int8_t> Bint8_unpacked(Bint8.size());
+  packedB_2D.unpack(Bint8_unpacked.data());
+  ASSERT_EQ(Bint8_unpacked, Bint8)
+      << "Original and unpacked data elements are not the same";
+
+  aligned_vector<int32_t> Cint32_fb(Cint32_ref.size());
+  aligned_vector<uint8_t> Cint8_fb(Cint32_ref.size());
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  {
+    DoNothing<> doNothingObj{};
+    ReQuantizeOutput<false, Q_GRAN> outputProcObj(
+        doNothingObj,
+        C_multiplier.data(),
+        C_zero_point,
+        Aint8_zero_point,
+        Bint8_zero_point.data(),
+        nullptr, // row offsets
+        col_offsets.data(),
+        bias.data(),
+        NDim);
+
+    fbgemmConv(
+        conv_p,
+        Aint8.data(),
+        packedB_2D,
+        Cint8_fb.data(),
+        Cint32_fb.data(),
+        outputProcObj,
+        fbgemm_get_thread_num(),
+        fbgemm_get_num_threads());
+  }
+
+  compare_validate_buffers(
+      Cint32_ref.data(), Cint32_fb.data(), MDim, NDim, NDim, 0);
+  compare_validate_buffers(
+      Cint8_ref.data(),
+      Cint8_fb.data(),
+      MDim,
+      NDim,
+      NDim,
+      static_cast<uint8_t>(0));
+}
+
+TEST_P(FBGemmDirectConvGeneralTest, Test2D) {
+  if (!cpuinfo_initialize() || fbgemmInstructionSet() != inst_set_t::avx2) {
+    GTEST_SKIP() << "direct conv is only taken on AVX2 hosts";
+  }
+  QuantizationGranularity q_granularity;
+  bool a_symmetric, b_symmetric;
+  tie(q_granularity, a_symmetric, b_symmetric) = GetParam();
+
+  for (const auto& conv_p : shapes_general) {
+    if (q_granularity == QuantizationGranularity::TENSOR) {
+      runDirectConvGeneralTest<QuantizationGranularity::TENSOR>(
+          conv_p, a_symmetric, b_symmetric);
+    } else {
+      runDirectConvGeneralTest<QuantizationGranularity::OUT_CHANNEL>(
+          conv_p, a_symmetric, b_symmetric);
+    }
+  }
+}
+
+// Full range activations and weights, with the weights adjusted as for the
+// GEMM tests so that no pair sum saturates.
+TEST_P(FBGemmDirectConvGeneralTest, Test2DFullRange) {
+  if (!cpuinfo_initialize() || fbgemmInstructionSet() != inst_set_t::avx2) {
+    GTEST_SKIP() << "direct conv is only taken on AVX2 hosts";
+  }
+  QuantizationGranularity q_granularity;
+  bool a_symmetric, b_symmetric;
+  tie(q_granularity, a_symmetric, b_symmetric) = GetParam();
+
+  for (const auto& conv_p : shapes_general) {
+    if (conv_p.IC % 2) {
+      continue;
+    }
+    if (q_granularity == QuantizationGranularity::TENSOR) {
+      runDirectConvGeneralTest<QuantizationGranularity::TENSOR>(
+          conv_p, a_symmetric, b_symmetric, true);
+    } else {
+      runDirectConvGeneralTest<QuantizationGranularity::OUT_CHANNEL>(
+          conv_p, a_symmetric, b_symmetric, true);
+    }
+  }
+}
+
+// Weights packed for the direct conv path under an AVX2 scope run on it
+// outside of the scope, where ConvFastPath picks im2col.
+TEST_P(FBGemmDirectConvGeneralTest, Test2DPackedUnderAvx2Scope) {
+  if (!cpuinfo_initialize() || !fbgemmHasAvx512Support()) {
+    GTEST_SKIP() << "needs an AVX512 host";
+  }
+  QuantizationGranularity q_granularity;
+  bool a_symmetric, b_symmetric;
+  tie(q_granularity, a_symmetric, b_symmetric) = GetParam();
+
+  const auto& conv_p = shapes_general[1];
+  ASSERT_EQ(ConvFastPath<2>(conv_p), optimized_conv_t::im2col);
+  if (q_granularity == QuantizationGranularity::TENSOR) {
+    runDirectConvGeneralTest<QuantizationGranularity::TENSOR>(
+        conv_p, a_symmetric, b_symmetric, false, true);
+  } else {
+    runDirectConvGeneralTest<QuantizationGranularity::OUT_CHANNEL>(
+        conv_p, a_symmetric, b_symmetric, false, true);
+  }
+}
+
 } // fbgemm namespace
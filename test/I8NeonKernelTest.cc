@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "src/FbgemmI8Neon.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+// KCB and NCB of the anyarch int8 packing.
+constexpr int kLda = 512;
+constexpr int kNcb = 64;
+
+class I8NeonKernelTest
+    : public testing::TestWithParam<tuple<int, int, int, int, bool>> {};
+
+} // namespace
+
+INSTANTIATE_TEST_CASE_P(
+    InstantiationName,
+    I8NeonKernelTest,
+    ::testing::Combine(
+        ::testing::Values(1, 3, 8, 9, 17, 128), // mc
+        ::testing::Values(1, 8, 13, 64), // nc
+        ::testing::Values(8, 64, 504, 512), // kc
+        ::testing::Values(4, 8), // row_interleave
+        ::testing::Bool())); // accum
+
+TEST_P(I8NeonKernelTest, matchesReference) {
+  const auto [mc, nc, kc, row_interleave, accum] = GetParam();
+  const int ldb = kNcb * row_interleave;
+  const int ldc = nc + 5;
+
+  default_random_engine generator;
+  uniform_int_distribution<int> a_distribution(0, 255);
+  uniform_int_distribution<int> b_distribution(-128, 127);
+  vector<uint8_t> A(mc * kLda);
+  for (auto& v : A) {
+    v = a_distribution(generator);
+  }
+  // Packed B: row_interleave consecutive k of each column next to each
+  // other. The columns past nc are filled too, as in a packed block that is
+  // not the last one.
+  vector<int8_t> B(kLda / row_interleave * ldb);
+  for (auto& v : B) {
+    v = b_distribution(generator);
+  }
+  vector<int32_t> C(mc * ldc);
+  for (auto& v : C) {
+    v = b_distribution(generator);
+  }
+
+  vector<int32_t> C_ref(C);
+  for (int i = 0; i < mc; ++i) {
+    for (int j = 0; j < nc; ++j) {
+      int32_t sum = accum ? C_ref[i * ldc + j] : 0;
+      for (int k = 0; k < kc; ++k) {
+        sum += A[i * kLda + k] *
+            B[k / row_interleave * ldb + j * row_interleave +
+              k % row_interleave];
+      }
+      C_ref[i * ldc + j] = sum;
+    }
+  }
+
+  gemmKernelU8S8S32ACC32Neon(
+      A.data(),
+      kLda,
+      B.data(),
+      ldb,
+      row_interleave,
+      C.data(),
+      ldc,
+      mc,
+      nc,
+      kc,
+      accum);
+  for (size_t i = 0; i < C.size(); ++i) {
+    EXPECT_EQ(C[i], C_ref[i]) << "results differ at " << i;
+  }
+}
@@ -155,3 +155,102 @@ TEST_P(fbgemmSPMDMTest, TestsSpMDM) {
         static_cast<int32_t>(0));
   } // for each shape
 }
+
+namespace {
+class fbgemmSparseConvTest
+    : public testing::TestWithParam<std::tuple<float, bool, int>> {};
+} // namespace
+
+INSTANTIATE_TEST_CASE_P(
+    Instance0,
+    fbgemmSparseConvTest,
+    ::testing::Combine(
+        ::testing::ValuesIn(densities),
+        ::testing::Bool(), // accumulation
+        ::testing::Values(1, 2))); // groups
+
+// Both the hyper sparse and the blocked path, depending on the density, must
+// give the direct convolution, for a block of rows and columns of C.
+TEST_P(fbgemmSparseConvTest, TestsSparseConv) {
+  float density;
+  bool accumulation;
+  int G;
+  tie(density, accumulation, G) = GetParam();
+  const conv_param_t<> conv_p(
+      2, 8 * G, 6 * G, {9, 11}, G, {3, 3}, {2, 1}, {1, 1, 1, 1});
+  const int M = conv_p.MB * conv_p.OUT_DIM[0] * conv_p.OUT_DIM[1];
+  const int ic_per_group = conv_p.IC / G;
+  const int K = conv_p.K[0] * conv_p.K[1] * ic_per_group;
+  const int N = conv_p.OC;
+  const int32_t A_zero_point = 7;
+
+  aligned_vector<uint8_t> A(
+      conv_p.MB * conv_p.IN_DIM[0] * conv_p.IN_DIM[1] * conv_p.IC);
+  randFill<uint8_t>(A, 0, 255);
+
+  default_random_engine eng;
+  binomial_distribution<> per_col_nnz_dist(K, density);
+  uniform_int_distribution<> value_dist(
+      numeric_limits<int8_t>::min() / 2, numeric_limits<int8_t>::max() / 2);
+  CompressedSparseColumn B_csc(K, N);
+  vector<int> row_indices(K);
+  int total_nnz = 0;
+  for (int j = 0; j < N; ++j) {
+    const int g = j / (N / G);
+    B_csc.ColPtr()[j] = total_nnz;
+    int nnz_of_j = per_col_nnz_dist(eng);
+    total_nnz += nnz_of_j;
+    iota(row_indices.begin(), row_indices.end(), 0);
+    shuffle(row_indices.begin(), row_indices.end(), eng);
+    sort(row_indices.begin(), row_indices.begin() + nnz_of_j);
+    for (int k = 0; k < nnz_of_j; ++k) {
+      const int rowidx = row_indices[k];
+      B_csc.ICs().push_back(g * ic_per_group + rowidx % ic_per_group);
+      B_csc.KWs().push_back(rowidx / ic_per_group % conv_p.K[1]);
+      B_csc.KHs().push_back(rowidx / ic_per_group / conv_p.K[1]);
+      B_csc.Values().push_back(value_dist(eng));
+    }
+  }
+  B_csc.ColPtr()[N] = total_nnz;
+
+  // The block leaves out rows and columns on both sides
+  const block_type_t block = {5, M - 40, 1, N - 3};
+  const int ldc = N;
+  vector<int32_t> C(M * ldc), C_ref(M * ldc);
+  for (int i = 0; i < M * ldc; ++i) {
+    C[i] = C_ref[i] = i % 13 - 6;
+  }
+  for (int i = block.row_start; i < block.row_start + block.row_size; ++i) {
+    const int ow = i % conv_p.OUT_DIM[1];
+    const int oh = i / conv_p.OUT_DIM[1] % conv_p.OUT_DIM[0];
+    const int n = i / conv_p.OUT_DIM[1] / conv_p.OUT_DIM[0];
+    for (int j = block.col_start; j < block.col_start + block.col_size; ++j) {
+      int32_t sum = accumulation ? C_ref[i * ldc + j] : 0;
+      for (int k = B_csc.ColPtr()[j]; k < B_csc.ColPtr()[j + 1]; ++k) {
+        const int ih = -conv_p.pad[0] + oh * conv_p.stride[0] + B_csc.KHs()[k];
+        const int iw = -conv_p.pad[1] + ow * conv_p.stride[1] + B_csc.KWs()[k];
+        const bool inside = ih >= 0 && ih < conv_p.IN_DIM[0] && iw >= 0 &&
+            iw < conv_p.IN_DIM[1];
+        const int a = inside
+            ? A[((n * conv_p.IN_DIM[0] + ih) * conv_p.IN_DIM[1] + iw) *
+                    conv_p.IC +
+                B_csc.ICs()[k]]
+            : A_zero_point;
+        sum += a * B_csc.Values()[k];
+      }
+      C_ref[i * ldc + j] = sum;
+    }
+  }
+
+  B_csc.SparseConv(
+      conv_p,
+      block,
+      A.data(),
+      A_zero_point,
+      accumulation,
+      C.data() + block.row_start * ldc + block.col_start,
+      ldc);
+
+  compare_validate_buffers(
+      C_ref.data(), C.data(), M, N, ldc, static_cast<int32_t>(0));
+}
@@ -61,7 +61,7 @@ static vector<conv_param_t<>> shapes = {
 // clang-format on
 
 template <typename ACC_T, QuantizationGranularity Q_GRAN>
-static void Im2colTest(bool b_symmetric) {
+static void Im2colTest(bool b_symmetric, bool implicit_gemm = false) {
   for (auto conv_p : shapes) {
     for (int groups : {1, 4}) {
       if (conv_p.IC % groups != 0 || conv_p.OC % groups != 0) {
@@ -182,7 +182,9 @@ static void Im2colTest(bool b_symmetric) {
             nullptr,
             Aint8_zero_point,
             row_offset_buf.data(),
-            b_symmetric);
+            b_symmetric,
+            nullptr,
+            implicit_gemm);
 
         DoNothing<> doNothingObj{};
         ReQuantizeOutput<false, Q_GRAN> outputProcObj(
@@ -261,6 +263,20 @@ TEST_P(fbgemmIm2colTest, Acc16Test) {
   }
 }
 
+TEST_P(fbgemmIm2colTest, ImplicitGemmAcc32Test) {
+  QuantizationGranularity q_granularity;
+  bool b_symmetric;
+  tie(q_granularity, b_symmetric) = GetParam();
+  if (q_granularity == QuantizationGranularity::TENSOR) {
+    Im2colTest<int32_t, QuantizationGranularity::TENSOR>(b_symmetric, true);
+  } else if (q_granularity == QuantizationGranularity::GROUP) {
+    Im2colTest<int32_t, QuantizationGranularity::GROUP>(b_symmetric, true);
+  } else {
+    Im2colTest<int32_t, QuantizationGranularity::OUT_CHANNEL>(
+        b_symmetric, true);
+  }
+}
+
 template <QuantizationGranularity Q_GRAN>
 void SConvTest() {
   for (auto conv_p : shapes) {
@@ -560,7 +576,7 @@ static vector<conv_param_t<3>> shapes_3d = {
 };
 
 template <typename ACC_T, QuantizationGranularity Q_GRAN>
-static void Im2col3DTest(bool b_symmetric) {
+static void Im2col3DTest(bool b_symmetric, bool implicit_gemm = false) {
   for (auto conv_p : shapes_3d) {
     for (int groups : {1, 4}) {
       if (conv_p.IC % groups != 0 || conv_p.OC % groups != 0) {
@@ -684,7 +700,9 @@ static void Im2col3DTest(bool b_symmetric) {
             nullptr,
             Aint8_zero_point,
             row_offset_buf.data(),
-            b_symmetric);
+            b_symmetric,
+            nullptr,
+            implicit_gemm);
 
         DoNothing<> doNothingObj{};
         ReQuantizeOutput<false, Q_GRAN> outputProcObj(
@@ -768,3 +786,17 @@ TEST_P(fbgemmIm2colTest, 3DAcc16Test) {
     Im2col3DTest<int16_t, QuantizationGranularity::OUT_CHANNEL>(b_symmetric);
   }
 }
+
+TEST_P(fbgemmIm2colTest, 3DImplicitGemmAcc32Test) {
+  QuantizationGranularity q_granularity;
+  bool b_symmetric;
+  tie(q_granularity, b_symmetric) = GetParam();
+  if (q_granularity == QuantizationGranularity::TENSOR) {
+    Im2col3DTest<int32_t, QuantizationGranularity::TENSOR>(b_symmetric, true);
+  } else if (q_granularity == QuantizationGranularity::GROUP) {
+    Im2col3DTest<int32_t, QuantizationGranularity::GROUP>(b_symmetric, true);
+  } else {
+    Im2col3DTest<int32_t, QuantizationGranularity::OUT_CHANNEL>(
+        b_symmetric, true);
+  }
+}
@@ -0,0 +1,273 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "fbgemm/Fbgemm.h"
+#include "fbgemm/FbgemmEmbedding.h"
+#include "fbgemm/FbgemmTrace.h"
+#include "fbgemm/Utils.h"
+
+using namespace std;
+using namespace fbgemm;
+
+TEST(IsaScopeTest, overridesOnItsThread) {
+  if (!fbgemmHasAvx2Support()) {
+    GTEST_SKIP();
+  }
+  const inst_set_t detected_isa = fbgemmInstructionSet();
+  {
+    FbgemmIsaScope scope(inst_set_t::avx2);
+    EXPECT_EQ(fbgemmInstructionSet(), inst_set_t::avx2);
+    inst_set_t other_thread_isa = inst_set_t::anyarch;
+    thread([&] { other_thread_isa = fbgemmInstructionSet(); }).join();
+    EXPECT_EQ(other_thread_isa, detected_isa);
+    {
+      // Unsupported ISAs are ignored and keep the enclosing scope's ISA
+      FbgemmIsaScope inner_scope(
+          fbgemmHasAvx512VnniSupport() ? inst_set_t::avx512_vnni_ymm
+                                       : inst_set_t::avx512_vnni);
+      EXPECT_EQ(
+          fbgemmInstructionSet(),
+          fbgemmHasAvx512VnniSupport() ? inst_set_t::avx512_vnni_ymm
+                                       : inst_set_t::avx2);
+    }
+    EXPECT_EQ(fbgemmInstructionSet(), inst_set_t::avx2);
+  }
+  EXPECT_EQ(fbgemmInstructionSet(), detected_isa);
+}
+
+TEST(IsaScopeTest, reachesParallelForWorkers) {
+  if (!fbgemmHasAvx2Support()) {
+    GTEST_SKIP();
+  }
+  FbgemmIsaScope scope(inst_set_t::avx2);
+  vector<inst_set_t> worker_isas(64, inst_set_t::anyarch);
+  fbgemmParallelFor(0, worker_isas.size(), 1, [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      worker_isas[i] = fbgemmInstructionSet();
+    }
+  });
+  for (const inst_set_t isa : worker_isas) {
+    EXPECT_EQ(isa, inst_set_t::avx2);
+  }
+}
+
+TEST(IsaScopeTest, isaForWork) {
+  const inst_set_t detected_isa = fbgemmInstructionSet();
+  EXPECT_EQ(fbgemmIsaForWork(0), detected_isa);
+  fbgemmSetZmmMinWork(1 << 20);
+  EXPECT_EQ(fbgemmGetZmmMinWork(), 1 << 20);
+  EXPECT_EQ(fbgemmIsaForWork(1 << 20), detected_isa);
+  const inst_set_t small_isa = fbgemmIsaForWork(1000);
+  if (isZmm(detected_isa)) {
+    EXPECT_TRUE(isYmm(small_isa));
+  } else {
+    EXPECT_EQ(small_isa, detected_isa);
+  }
+  {
+    // The narrowing applies to the ISA of the enclosing scope
+    FbgemmIsaScope scope(inst_set_t::avx2);
+    EXPECT_EQ(fbgemmIsaForWork(1000), fbgemmInstructionSet());
+  }
+  fbgemmSetZmmMinWork(0);
+}
+
+namespace {
+
+struct GemmProblem {
+  static constexpr int m = 35, n = 100, k = 300;
+  vector<uint8_t> A = vector<uint8_t>(m * k);
+  vector<int8_t> B = vector<int8_t>(k * n);
+  vector<int32_t> C_ref = vector<int32_t>(m * n, 0);
+
+  GemmProblem() {
+    default_random_engine generator;
+    uniform_int_distribution<int> dist(-10, 10);
+    for (auto& v : A) {
+      v = dist(generator) + 10;
+    }
+    for (auto& v : B) {
+      v = dist(generator);
+    }
+    for (int i = 0; i < m; ++i) {
+      for (int kk = 0; kk < k; ++kk) {
+        for (int j = 0; j < n; ++j) {
+          C_ref[i * n + j] += A[i * k + kk] * B[kk * n + j];
+        }
+      }
+    }
+  }
+};
+
+} // namespace
+
+// A and B are packed under a scope, for each ISA of the CPU, and multiplied
+// outside of it.
+TEST(IsaScopeTest, packedGemm) {
+  if (!fbgemmHasAvx2Support()) {
+    GTEST_SKIP();
+  }
+  const GemmProblem p;
+  const int m = p.m, n = p.n, k = p.k;
+  vector<inst_set_t> isas = {fbgemmInstructionSet(), inst_set_t::avx2};
+  if (fbgemmInstructionSet() == inst_set_t::avx512) {
+    isas.push_back(inst_set_t::avx512_ymm);
+  } else if (fbgemmInstructionSet() == inst_set_t::avx512_vnni) {
+    isas.push_back(inst_set_t::avx512_vnni_ymm);
+  }
+  for (const inst_set_t isa : isas) {
+    unique_ptr<PackBMatrix<int8_t>> packedB;
+    unique_ptr<PackAMatrix<uint8_t>> packA;
+    {
+      FbgemmIsaScope scope(isa);
+      packedB = make_unique<PackBMatrix<int8_t>>(
+          matrix_op_t::NoTranspose, k, n, p.B.data(), n);
+      packA = make_unique<PackAMatrix<uint8_t>>(
+          matrix_op_t::NoTranspose, m, k, p.A.data(), k);
+    }
+    EXPECT_EQ(packedB->isa(), isa);
+    DoNothing<int32_t, int32_t> doNothingObj{};
+    memCopy<> outputProcObj(doNothingObj);
+    vector<int32_t> C(m * n);
+    fbgemmPacked(*packA, *packedB, C.data(), C.data(), n, outputProcObj, 0, 1);
+    EXPECT_EQ(C, p.C_ref) << "isa " << static_cast<int>(isa);
+  }
+}
+
+TEST(IsaScopeTest, rejectsMismatchingPacking) {
+  if (!fbgemmHasAvx2Support() || fbgemmInstructionSet() == inst_set_t::avx2) {
+    GTEST_SKIP();
+  }
+  const GemmProblem p;
+  const int m = p.m, n = p.n, k = p.k;
+  unique_ptr<PackBMatrix<int8_t>> packedB;
+  {
+    FbgemmIsaScope scope(inst_set_t::avx2);
+    packedB = make_unique<PackBMatrix<int8_t>>(
+        matrix_op_t::NoTranspose, k, n, p.B.data(), n);
+  }
+  PackAMatrix<uint8_t> packA(matrix_op_t::NoTranspose, m, k, p.A.data(), k);
+  DoNothing<int32_t, int32_t> doNothingObj{};
+  memCopy<> outputProcObj(doNothingObj);
+  vector<int32_t> C(m * n);
+  EXPECT_THROW(
+      fbgemmPacked(packA, *packedB, C.data(), C.data(), n, outputProcObj, 0, 1),
+      std::runtime_error);
+}
+
+// A GEMM below the fbgemmSetZmmMinWork() threshold runs the 256-bit kernels
+// of the ISA its matrices were packed for, a larger one the 512-bit kernels.
+TEST(IsaScopeTest, gemmIsaForWork) {
+  if (!isZmm(fbgemmInstructionSet())) {
+    GTEST_SKIP();
+  }
+  const GemmProblem p;
+  const int m = p.m, n = p.n, k = p.k;
+  const int small_m = 1;
+  PackBMatrix<int8_t> packedB(matrix_op_t::NoTranspose, k, n, p.B.data(), n);
+
+  // The trace callback runs at the end of fbgemmPacked, under the ISA of its
+  // kernels.
+  mutex isas_mutex;
+  vector<inst_set_t> isas;
+  fbgemmSetTraceCallback([&](const TraceEvent& event) {
+    if (strcmp(event.kernel, "fbgemmPacked") == 0) {
+      lock_guard<mutex> lock(isas_mutex);
+      isas.push_back(fbgemmInstructionSet());
+    }
+  });
+  fbgemmSetZmmMinWork(int64_t(m) * n * k);
+  for (const int rows : {small_m, m}) {
+    PackAMatrix<uint8_t> packA(
+        matrix_op_t::NoTranspose, rows, k, p.A.data(), k);
+    DoNothing<int32_t, int32_t> doNothingObj{};
+    memCopy<> outputProcObj(doNothingObj);
+    vector<int32_t> C(rows * n);
+    fbgemmPacked(packA, packedB, C.data(), C.data(), n, outputProcObj, 0, 1);
+    EXPECT_EQ(C, vector<int32_t>(p.C_ref.begin(), p.C_ref.begin() + rows * n))
+        << "rows " << rows;
+  }
+  fbgemmSetZmmMinWork(0);
+  fbgemmSetTraceCallback(nullptr);
+
+#ifndef FBGEMM_DISABLE_TRACING
+  ASSERT_EQ(isas.size(), 2);
+  EXPECT_TRUE(isYmm(isas[0]));
+  EXPECT_EQ(isas[1], fbgemmInstructionSet());
+#endif
+}
+
+// Embedding lookups generated for a 512-bit ISA run the AVX2 kernel below the
+// fbgemmSetZmmMinWork() threshold, with the same results.
+TEST(IsaScopeTest, embeddingIsaForWork) {
+  if (!isZmm(fbgemmInstructionSet()) || is_asmjit_disabled()) {
+    GTEST_SKIP();
+  }
+  constexpr int block_size = 64, num_rows = 100, output_size = 4;
+  constexpr int small_index_size = 8, large_index_size = 64;
+  default_random_engine generator;
+  uniform_real_distribution<float> value_dist(-1.0f, 1.0f);
+  uniform_int_distribution<int64_t> index_dist(0, num_rows - 1);
+  vector<float> input(num_rows * block_size);
+  for (auto& v : input) {
+    v = value_dist(generator);
+  }
+  vector<int64_t> indices(large_index_size);
+  for (auto& v : indices) {
+    v = index_dist(generator);
+  }
+
+  fbgemmSetZmmMinWork(int64_t(large_index_size) * block_size);
+  const auto kernel = GenerateEmbeddingSpMDM<float, int64_t, int64_t>(
+      block_size,
+      /*has_weight=*/false,
+      /*normalize_by_lengths=*/false,
+      /*prefetch=*/16,
+      /*is_weight_positional=*/false,
+      /*use_offsets=*/true);
+  fbgemmSetZmmMinWork(0);
+
+  for (const int index_size : {small_index_size, large_index_size}) {
+    vector<int64_t> offsets(output_size + 1);
+    for (int i = 0; i <= output_size; ++i) {
+      offsets[i] = int64_t(i) * index_size / output_size;
+    }
+    vector<float> out(output_size * block_size);
+    vector<float> out_ref(output_size * block_size, 0.0f);
+    for (int i = 0; i < output_size; ++i) {
+      for (int64_t j = offsets[i]; j < offsets[i + 1]; ++j) {
+        for (int d = 0; d < block_size; ++d) {
+          out_ref[i * block_size + d] += input[indices[j] * block_size + d];
+        }
+      }
+    }
+    ASSERT_TRUE(kernel(
+        output_size,
+        index_size,
+        num_rows,
+        input.data(),
+        indices.data(),
+        offsets.data(),
+        nullptr,
+        out.data()));
+    for (size_t i = 0; i < out.size(); ++i) {
+      EXPECT_NEAR(out[i], out_ref[i], 1e-5f)
+          << "index_size " << index_size << " at " << i;
+    }
+  }
+}
@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "./EmbeddingSpMDMTestUtils.h"
+#include "fbgemm/FbgemmEmbedding.h"
+#include "fbgemm/Utils.h"
+#include "src/RefImplementations.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+int countCacheEntries(const filesystem::path& dir) {
+  int count = 0;
+  for (const auto& entry : filesystem::directory_iterator(dir)) {
+    if (entry.path().extension() == ".bin") {
+      ++count;
+    }
+  }
+  return count;
+}
+
+// Runs a sum embedding kernel of embedding_dim and checks it against the
+// reference.
+void checkEmbeddingKernel(int embedding_dim) {
+  const int batch_size = 4;
+  const int num_rows = 100;
+
+  default_random_engine generator;
+  normal_distribution<float> embedding_distribution;
+  vector<float> embedding_table(num_rows * embedding_dim);
+  for (auto& v : embedding_table) {
+    v = embedding_distribution(generator);
+  }
+
+  vector<int64_t> lengths, offsets, indices;
+  vector<int32_t> lengths_32, offsets_32, indices_32;
+  vector<float> weights;
+  int lengths_sum = GenerateLengthsIndicesWeights(
+      lengths,
+      lengths_32,
+      offsets,
+      offsets_32,
+      indices,
+      indices_32,
+      weights,
+      batch_size,
+      num_rows,
+      /*average_len=*/10,
+      NONE);
+
+  vector<float> output_ref(batch_size * embedding_dim);
+  vector<float> output(output_ref.size());
+  bool success_ref = EmbeddingSpMDM_ref(
+      embedding_dim,
+      batch_size,
+      lengths_sum,
+      num_rows,
+      embedding_table.data(),
+      indices.data(),
+      offsets.data(),
+      nullptr,
+      false,
+      output_ref.data());
+
+  auto kernel = GenerateEmbeddingSpMDM<float, int64_t, int64_t>(
+      embedding_dim, /*has_weight=*/false, /*normalize_by_lengths=*/false);
+  bool success = kernel(
+      batch_size,
+      lengths_sum,
+      num_rows,
+      embedding_table.data(),
+      indices.data(),
+      offsets.data(),
+      nullptr,
+      output.data());
+
+  EXPECT_EQ(success, success_ref);
+  for (size_t i = 0; i < output.size(); ++i) {
+    EXPECT_FLOAT_EQ(output[i], output_ref[i]) << "results differ at " << i;
+  }
+}
+
+filesystem::path onlyCacheEntry(const filesystem::path& dir) {
+  for (const auto& entry : filesystem::directory_iterator(dir)) {
+    if (entry.path().extension() == ".bin") {
+      return entry.path();
+    }
+  }
+  return {};
+}
+
+} // namespace
+
+TEST(JitCacheTest, persistsEmbeddingKernel) {
+  const filesystem::path dir = filesystem::temp_directory_path() /
+      ("fbgemm_jit_cache_test_" + to_string(random_device()()));
+  filesystem::create_directories(dir);
+  const string prev_dir = getJitCacheDir();
+  setJitCacheDir(dir.string());
+  EXPECT_EQ(getJitCacheDir(), dir.string());
+
+  // An unusual embedding dimension so no other test in this process has
+  // generated the kernel already.
+  checkEmbeddingKernel(83);
+
+  if (fbgemmHasAvx2Support() && !is_asmjit_disabled()) {
+    EXPECT_EQ(countCacheEntries(dir), 1);
+  }
+
+  setJitCacheDir(prev_dir);
+  filesystem::remove_all(dir);
+}
+
+// A kernel dropped from the in-process cache is loaded back from its file,
+// and a corrupted file is regenerated rather than run.
+TEST(JitCacheTest, reloadsEmbeddingKernel) {
+  if (!fbgemmHasAvx2Support() || is_asmjit_disabled()) {
+    GTEST_SKIP() << "kernels are only persisted when they are JIT generated";
+  }
+  const filesystem::path dir = filesystem::temp_directory_path() /
+      ("fbgemm_jit_cache_test_" + to_string(random_device()()));
+  filesystem::create_directories(dir);
+  const string prev_dir = getJitCacheDir();
+  setJitCacheDir(dir.string());
+
+  // Unusual embedding dimensions so no other test in this process has
+  // generated the kernels already.
+  checkEmbeddingKernel(89);
+  const filesystem::path entry = onlyCacheEntry(dir);
+  ASSERT_FALSE(entry.empty());
+
+  // Another kernel pushes the first one out of the in-process cache
+  setCodeCacheCapacity(1);
+  checkEmbeddingKernel(91);
+  EXPECT_EQ(countCacheEntries(dir), 2);
+
+  // A regenerated kernel would be stored again, so the file keeps its
+  // backdated time only if the kernel is loaded from it.
+  const auto old_time =
+      filesystem::last_write_time(entry) - chrono::hours(1);
+  filesystem::last_write_time(entry, old_time);
+  checkEmbeddingKernel(91);
+  checkEmbeddingKernel(89);
+  EXPECT_EQ(filesystem::last_write_time(entry), old_time);
+
+  // Flip the last code byte: the checksum rejects the file and the kernel
+  // is generated and stored again.
+  checkEmbeddingKernel(91);
+  {
+    fstream file(entry, ios::in | ios::out | ios::binary);
+    file.seekg(-1, ios::end);
+    const char last = static_cast<char>(file.get());
+    file.seekp(-1, ios::end);
+    file.put(static_cast<char>(~last));
+  }
+  filesystem::last_write_time(entry, old_time);
+  checkEmbeddingKernel(89);
+  EXPECT_NE(filesystem::last_write_time(entry), old_time);
+
+  setCodeCacheCapacity(0);
+  setJitCacheDir(prev_dir);
+  filesystem::remove_all(dir);
+}
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "fbgemm/Fbgemm.h"
+#include "fbgemm/FbgemmSparse.h"
+#include "fbgemm/Utils.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+// The heap may report a little more than the requested size of each buffer.
+void expectTallied(
+    const FbgemmMemoryStats& before,
+    const FbgemmMemoryStats& after,
+    size_t footprint,
+    size_t num_buffers) {
+  EXPECT_EQ(after.num_buffers - before.num_buffers, num_buffers);
+  EXPECT_GE(after.bytes_in_use - before.bytes_in_use, footprint);
+  EXPECT_LE(
+      after.bytes_in_use - before.bytes_in_use, footprint + 128 * num_buffers);
+}
+
+} // namespace
+
+TEST(MemoryFootprintTest, packedMatrices) {
+  const int m = 20, k = 300, n = 100;
+  default_random_engine generator;
+  uniform_int_distribution<int> dist(-10, 10);
+  vector<uint8_t> A(m * k);
+  vector<int8_t> B(k * n);
+  for (auto& v : A) {
+    v = dist(generator) + 10;
+  }
+  for (auto& v : B) {
+    v = dist(generator);
+  }
+
+  const FbgemmMemoryStats before = fbgemmGetMemoryStats();
+  {
+    PackBMatrix<int8_t> packedB(matrix_op_t::NoTranspose, k, n, B.data(), n);
+    EXPECT_GE(packedB.memoryFootprint(), size_t(k) * n);
+    expectTallied(
+        before, fbgemmGetMemoryStats(), packedB.memoryFootprint(), 1);
+
+    // Buffers passed in are not owned
+    vector<int8_t> buf(packedB.memoryFootprint());
+    PackBMatrix<int8_t> externalB(
+        matrix_op_t::NoTranspose, k, n, B.data(), n, buf.data());
+    EXPECT_EQ(externalB.memoryFootprint(), 0);
+
+    const FbgemmMemoryStats before_a = fbgemmGetMemoryStats();
+    PackAWithRowOffset<uint8_t> packA(
+        matrix_op_t::NoTranspose, m, k, A.data(), k);
+    EXPECT_GT(packA.memoryFootprint(), 0);
+    expectTallied(before_a, fbgemmGetMemoryStats(), packA.memoryFootprint(), 2);
+  }
+  EXPECT_EQ(fbgemmGetMemoryStats().bytes_in_use, before.bytes_in_use);
+}
+
+TEST(MemoryFootprintTest, depthwise) {
+  const int OC = 40, kernel_prod = 9;
+  vector<int8_t> W(OC * kernel_prod, 1);
+  const FbgemmMemoryStats before = fbgemmGetMemoryStats();
+  auto packed =
+      make_unique<PackedDepthWiseConvMatrix>(OC, kernel_prod, W.data());
+  // 2 blocks of 32 channels by 10 (9 rounded to even) taps
+  EXPECT_EQ(packed->memoryFootprint(), 2 * 10 * 32);
+  expectTallied(before, fbgemmGetMemoryStats(), packed->memoryFootprint(), 1);
+  packed.reset();
+  EXPECT_EQ(fbgemmGetMemoryStats().bytes_in_use, before.bytes_in_use);
+}
+
+TEST(MemoryFootprintTest, bcsr) {
+  const int R = 64, C = 128;
+  vector<int8_t> W(R * C, 0);
+  for (int i = 0; i < R * C; i += 7) {
+    W[i] = 1;
+  }
+  auto bcsr = fbgemmDenseToBCSR<int8_t>(R, C, W.data());
+  EXPECT_GE(
+      bcsr->memoryFootprint(),
+      bcsr->values.size() + bcsr->row_offsets.size() * sizeof(int32_t));
+}
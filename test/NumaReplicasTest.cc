@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "bench/BenchUtils.h"
+#include "fbgemm/Fbgemm.h"
+#include "fbgemm/FbgemmFP16.h"
+#include "fbgemm/Utils.h"
+
+using namespace std;
+using namespace fbgemm;
+
+TEST(NumaReplicasTest, copies) {
+  EXPECT_GE(fbgemmNumaNodeCount(), 1);
+  EXPECT_GE(fbgemmCurrentNumaNode(), 0);
+
+  vector<uint8_t> src(100 << 10);
+  for (size_t i = 0; i < src.size(); ++i) {
+    src[i] = i % 251;
+  }
+  NumaReplicas replicas;
+  replicas.replicate(src.data(), src.size(), 1);
+  EXPECT_TRUE(replicas.empty());
+  EXPECT_EQ(replicas.local(), nullptr);
+
+  replicas.replicate(src.data(), src.size(), 2);
+  ASSERT_FALSE(replicas.empty());
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(replicas.local()) % 64, 0);
+  EXPECT_EQ(memcmp(replicas.local(), src.data(), src.size()), 0);
+
+  replicas.replicate(src.data(), 64, 2);
+  EXPECT_EQ(memcmp(replicas.local(), src.data(), 64), 0);
+  replicas.clear();
+  EXPECT_TRUE(replicas.empty());
+}
+
+// The packed buffers are cleared after replicating, so the results are only
+// right if the replicas are read.
+TEST(NumaReplicasTest, packedGemmReadsReplica) {
+  const int m = 35, n = 100, k = 300;
+  default_random_engine generator;
+  uniform_int_distribution<int> dist(-10, 10);
+  vector<uint8_t> A(m * k);
+  vector<int8_t> B(k * n);
+  for (auto& v : A) {
+    v = dist(generator) + 10;
+  }
+  for (auto& v : B) {
+    v = dist(generator);
+  }
+  vector<int32_t> C_ref(m * n, 0);
+  for (int i = 0; i < m; ++i) {
+    for (int kk = 0; kk < k; ++kk) {
+      for (int j = 0; j < n; ++j) {
+        C_ref[i * n + j] += A[i * k + kk] * B[kk * n + j];
+      }
+    }
+  }
+
+  vector<int8_t> Bpacked(PackBMatrix<int8_t>::packedBufferSize(k, n));
+  PackBMatrix<int8_t> packedB(
+      matrix_op_t::NoTranspose, k, n, B.data(), n, Bpacked.data());
+  packedB.replicateOnNumaNodes(2);
+  fill(Bpacked.begin(), Bpacked.end(), 0);
+
+  vector<int32_t> C(m * n);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  {
+    PackAMatrix<uint8_t> packA(matrix_op_t::NoTranspose, m, k, A.data(), k);
+    DoNothing<int32_t, int32_t> doNothingObj{};
+    memCopy<> outputProcObj(doNothingObj);
+    fbgemmPacked(
+        packA,
+        packedB,
+        C.data(),
+        C.data(),
+        n,
+        outputProcObj,
+        fbgemm_get_thread_num(),
+        fbgemm_get_num_threads());
+  }
+  EXPECT_EQ(C, C_ref);
+}
+
+TEST(NumaReplicasTest, fp16GemmReadsReplica) {
+  const int m = 20, n = 64, k = 128;
+  default_random_engine generator;
+  uniform_int_distribution<int> dist(-4, 4);
+  vector<float> A(m * k), B(k * n);
+  for (auto& v : A) {
+    v = dist(generator);
+  }
+  for (auto& v : B) {
+    v = dist(generator);
+  }
+
+  PackedGemmMatrixFP16 Bp(matrix_op_t::NoTranspose, k, n, 1.0f, B.data());
+  vector<float> C_ref(m * n);
+  cblas_gemm_compute(
+      matrix_op_t::NoTranspose, m, A.data(), Bp, 0.f, C_ref.data());
+
+  Bp.replicateOnNumaNodes(2);
+  memset(Bp.pmat(), 0, Bp.matSize() * sizeof(float16));
+  vector<float> C(m * n);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  {
+    cblas_gemm_compute(
+        matrix_op_t::NoTranspose,
+        m,
+        A.data(),
+        Bp,
+        0.f,
+        C.data(),
+        fbgemm_get_thread_num(),
+        fbgemm_get_num_threads());
+  }
+  EXPECT_EQ(C, C_ref);
+}
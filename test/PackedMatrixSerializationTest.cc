@@ -0,0 +1,167 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <gtest/gtest.h>
+
+#include "bench/AlignedVec.h"
+#include "fbgemm/Fbgemm.h"
+#include "fbgemm/FbgemmFP16.h"
+#include "fbgemm/Utils.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+class PackBMatrixSerializationTest
+    : public testing::TestWithParam<tuple<matrix_op_t, int>> {};
+
+INSTANTIATE_TEST_SUITE_P(
+    InstantiationName,
+    PackBMatrixSerializationTest,
+    ::testing::Combine(
+        ::testing::Values(matrix_op_t::NoTranspose, matrix_op_t::Transpose),
+        ::testing::Values(1, 2)));
+
+} // namespace
+
+TEST_P(PackBMatrixSerializationTest, roundTrip) {
+  const auto [trans, groups] = GetParam();
+  const int k = 300, n = 100;
+  default_random_engine generator;
+  uniform_int_distribution<int> dist(-10, 10);
+  vector<int8_t> B(k * n);
+  for (auto& v : B) {
+    v = dist(generator);
+  }
+  // Transposed groups are horizontally concatenated n x (k / groups) blocks
+  const int ld = trans == matrix_op_t::Transpose ? k / groups : n;
+  PackBMatrix<int8_t> packedB(trans, k, n, B.data(), ld, nullptr, groups);
+
+  aligned_vector<uint8_t> buf(packedB.serializedSize());
+  packedB.serialize(buf.data());
+  PackBMatrix<int8_t> loadedB(buf.data(), buf.size());
+  EXPECT_TRUE(loadedB.equals(packedB));
+
+  // The loaded matrix uses the serialized buffer in place
+  const auto& header = *reinterpret_cast<const PackedMatrixHeader*>(buf.data());
+  EXPECT_EQ(
+      reinterpret_cast<const uint8_t*>(loadedB.getBuf()),
+      buf.data() + header.data_offset);
+
+  vector<int8_t> unpacked(k * n);
+  loadedB.unpack(unpacked.data());
+  EXPECT_EQ(unpacked, B);
+}
+
+TEST(PackedMatrixSerializationTest, packBMatrixRejectsInvalid) {
+  const int k = 64, n = 32;
+  vector<int8_t> B(k * n, 1);
+  PackBMatrix<int8_t> packedB(matrix_op_t::NoTranspose, k, n, B.data(), n);
+  aligned_vector<uint8_t> buf(packedB.serializedSize());
+  packedB.serialize(buf.data());
+  auto& header = *reinterpret_cast<PackedMatrixHeader*>(buf.data());
+
+  // Truncated
+  EXPECT_THROW(
+      PackBMatrix<int8_t>(buf.data(), buf.size() - 1), std::runtime_error);
+  // Different accumulation type
+  EXPECT_THROW(
+      (PackBMatrix<int8_t, int16_t>(buf.data(), buf.size())),
+      std::runtime_error);
+  // Blocked for other kernels
+  BlockingFactors params{};
+  params.KCB = header.brow * 2;
+  params.NCB = header.bcol;
+  params.ROW_INTERLEAVE = header.aux;
+  EXPECT_THROW(
+      PackBMatrix<int8_t>(buf.data(), buf.size(), &params), std::runtime_error);
+  // Future version
+  ++header.version;
+  EXPECT_THROW(PackBMatrix<int8_t>(buf.data(), buf.size()), std::runtime_error);
+  --header.version;
+  header.magic[0] = 'X';
+  EXPECT_THROW(PackBMatrix<int8_t>(buf.data(), buf.size()), std::runtime_error);
+}
+
+TEST(PackedMatrixSerializationTest, fp16RoundTrip) {
+  const int m = 20, n = 100, k = 300;
+  default_random_engine generator;
+  uniform_int_distribution<int> dist(-4, 4);
+  vector<float> A(m * k), B(k * n);
+  for (auto& v : A) {
+    v = dist(generator);
+  }
+  for (auto& v : B) {
+    v = dist(generator);
+  }
+
+  PackedGemmMatrixFP16 Bp(matrix_op_t::NoTranspose, k, n, 1.0f, B.data(), 64);
+  aligned_vector<uint8_t> buf(Bp.serializedSize());
+  Bp.serialize(buf.data());
+  PackedGemmMatrixFP16 loadedBp(buf.data(), buf.size());
+  EXPECT_EQ(loadedBp.blockRowSize(), 64);
+  EXPECT_EQ(loadedBp.matSize(), Bp.matSize());
+
+  vector<float> C_ref(m * n), C(m * n);
+  cblas_gemm_compute(
+      matrix_op_t::NoTranspose, m, A.data(), Bp, 0.f, C_ref.data());
+  cblas_gemm_compute(
+      matrix_op_t::NoTranspose, m, A.data(), loadedBp, 0.f, C.data());
+  EXPECT_EQ(C, C_ref);
+
+  // Not a serialized FP16 matrix
+  ++reinterpret_cast<PackedMatrixHeader*>(buf.data())->elem_size;
+  EXPECT_THROW(
+      PackedGemmMatrixFP16(buf.data(), buf.size()), std::runtime_error);
+}
+
+#ifdef __linux__
+TEST(PackedMatrixSerializationTest, fp16FromMappedFile) {
+  const int m = 7, n = 64, k = 128;
+  vector<float> A(m * k, 1.0f), B(k * n);
+  for (int i = 0; i < k * n; ++i) {
+    B[i] = i % 5 - 2;
+  }
+  PackedGemmMatrixFP16 Bp(matrix_op_t::NoTranspose, k, n, 1.0f, B.data());
+  aligned_vector<uint8_t> buf(Bp.serializedSize());
+  Bp.serialize(buf.data());
+
+  char path[] = "/tmp/fbgemm_packed_XXXXXX";
+  const int fd = mkstemp(path);
+  ASSERT_GE(fd, 0);
+  unlink(path);
+  ASSERT_EQ(write(fd, buf.data(), buf.size()), (ssize_t)buf.size());
+  void* mapped = mmap(nullptr, buf.size(), PROT_READ, MAP_SHARED, fd, 0);
+  ASSERT_NE(mapped, MAP_FAILED);
+  {
+    PackedGemmMatrixFP16 mappedBp(mapped, buf.size());
+    vector<float> C_ref(m * n), C(m * n);
+    cblas_gemm_compute(
+        matrix_op_t::NoTranspose, m, A.data(), Bp, 0.f, C_ref.data());
+    cblas_gemm_compute(
+        matrix_op_t::NoTranspose, m, A.data(), mappedBp, 0.f, C.data());
+    EXPECT_EQ(C, C_ref);
+  }
+  munmap(mapped, buf.size());
+  close(fd);
+}
+#endif
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "fbgemm/Fbgemm.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+struct Output {
+  int n;
+  vector<int32_t> col_offsets;
+  vector<uint8_t> C, C_ref;
+  vector<int32_t> C_buffer;
+  unique_ptr<PackBMatrix<int8_t>> packB;
+};
+
+DoNothing<> doNothingObj{};
+const int32_t A_zero_point = 3;
+const int32_t B_zero_point = -2;
+const int32_t C_zero_point = 5;
+const float C_multiplier = 1e-4f;
+
+class PackedMultiBGemmTest
+    : public testing::TestWithParam<tuple<int, int, int>> {};
+
+INSTANTIATE_TEST_SUITE_P(
+    InstantiationName,
+    PackedMultiBGemmTest,
+    ::testing::Combine(
+        ::testing::Values(1, 20, 150), // m
+        ::testing::Values(7, 300, 1100), // k
+        ::testing::Values(1, 3))); // num_threads
+
+} // namespace
+
+// Every output must be the same as when its B is multiplied with A by
+// fbgemmPacked.
+TEST_P(PackedMultiBGemmTest, matchesFbgemmPacked) {
+  const auto [m, k, num_threads] = GetParam();
+  default_random_engine generator;
+  uniform_int_distribution<int> a_dist(0, 255);
+  uniform_int_distribution<int> b_dist(-128, 127);
+
+  vector<uint8_t> A(m * k);
+  for (auto& v : A) {
+    v = a_dist(generator);
+  }
+
+  vector<Output> outputs(4);
+  const int ns[] = {1, 64, 100, 259};
+  for (size_t o = 0; o < outputs.size(); ++o) {
+    auto& output = outputs[o];
+    output.n = ns[o];
+    vector<int8_t> B(k * output.n);
+    for (auto& v : B) {
+      v = b_dist(generator);
+    }
+    output.col_offsets.assign(output.n, -B_zero_point * k);
+    for (int kk = 0; kk < k; ++kk) {
+      for (int j = 0; j < output.n; ++j) {
+        output.col_offsets[j] += B[kk * output.n + j];
+      }
+    }
+    output.packB = make_unique<PackBMatrix<int8_t>>(
+        matrix_op_t::NoTranspose, k, output.n, B.data(), output.n);
+    output.C.resize(m * output.n);
+    output.C_ref.resize(m * output.n);
+    output.C_buffer.resize(m * output.n);
+  }
+
+  // Each thread has its own packed A, whose row offsets its output pipelines
+  // read.
+  for (int tid = 0; tid < num_threads; ++tid) {
+    vector<int32_t> row_offsets(
+        PackAWithRowOffset<uint8_t>::rowOffsetBufferSize());
+    PackAWithRowOffset<uint8_t> packA(
+        matrix_op_t::NoTranspose,
+        m,
+        k,
+        A.data(),
+        k,
+        nullptr,
+        1,
+        row_offsets.data());
+
+    vector<unique_ptr<ReQuantizeOutput<false>>> outProcesses;
+    using OutputArgs = PackedGemmOutput<
+        PackBMatrix<int8_t>,
+        uint8_t,
+        ReQuantizeOutput<false>>;
+    vector<OutputArgs> args;
+    for (auto& output : outputs) {
+      outProcesses.push_back(make_unique<ReQuantizeOutput<false>>(
+          doNothingObj,
+          &C_multiplier,
+          C_zero_point,
+          A_zero_point,
+          &B_zero_point,
+          packA.getRowOffsetBuffer(),
+          output.col_offsets.data(),
+          nullptr,
+          output.n));
+      args.push_back(OutputArgs{
+          output.packB.get(),
+          output.C.data(),
+          output.C_buffer.data(),
+          static_cast<uint32_t>(output.n),
+          outProcesses.back().get()});
+    }
+    fbgemmPackedMultiB(packA, args.data(), args.size(), tid, num_threads);
+
+    for (size_t o = 0; o < outputs.size(); ++o) {
+      fbgemmPacked(
+          packA,
+          *outputs[o].packB,
+          outputs[o].C_ref.data(),
+          outputs[o].C_buffer.data(),
+          outputs[o].n,
+          *outProcesses[o],
+          tid,
+          num_threads);
+    }
+  }
+
+  for (size_t o = 0; o < outputs.size(); ++o) {
+    EXPECT_EQ(outputs[o].C, outputs[o].C_ref) << "output " << o << " differs";
+  }
+}
+
+TEST(PackedMultiBGemmTest, rejectsDifferentK) {
+  const int m = 4, k = 32;
+  vector<uint8_t> A(m * k, 1);
+  vector<int8_t> B(2 * k * 16, 1);
+  PackBMatrix<int8_t> packB0(matrix_op_t::NoTranspose, k, 16, B.data(), 16);
+  PackBMatrix<int8_t> packB1(
+      matrix_op_t::NoTranspose, 2 * k, 16, B.data(), 16);
+  PackAMatrix<uint8_t> packA(matrix_op_t::NoTranspose, m, k, A.data(), k);
+
+  vector<int32_t> col_offsets(16), C_buffer(m * 16);
+  vector<uint8_t> C(m * 16);
+  ReQuantizeOutput<false> outProcess(
+      doNothingObj,
+      &C_multiplier,
+      C_zero_point,
+      0,
+      &B_zero_point,
+      nullptr,
+      col_offsets.data(),
+      nullptr,
+      16);
+  using OutputArgs =
+      PackedGemmOutput<PackBMatrix<int8_t>, uint8_t, ReQuantizeOutput<false>>;
+  const OutputArgs args[] = {
+      {&packB0, C.data(), C_buffer.data(), 16, &outProcess},
+      {&packB1, C.data(), C_buffer.data(), 16, &outProcess}};
+  EXPECT_THROW(fbgemmPackedMultiB(packA, args, 2, 0, 1), std::runtime_error);
+}
@@ -23,6 +23,7 @@
 #include "./TestUtils.h"
 #include "bench/BenchUtils.h"
 #include "fbgemm/Fbgemm.h"
+#include "fbgemm/QuantUtils.h"
 #include "src/RefImplementations.h"
 
 using namespace std;
@@ -372,6 +373,247 @@ TEST_P(fbgemmu8s8acc32WithQuantGranularityTest, Test) {
   } // for each shape
 }
 
+template <QuantizationGranularity Q_GRAN>
+static void runResidualAddTest(
+    matrix_op_t atrans,
+    matrix_op_t btrans,
+    bool test_ld) {
+  for (auto shape : GetShapes_()) {
+    for (int groups : {1, 3, 4}) {
+      int m = shape[0];
+      int n = shape[1];
+      int k = shape[2];
+      if (k % groups != 0) {
+        continue;
+      }
+      int k_per_group = k / groups;
+
+      aligned_vector<uint8_t> Aint8(m * k);
+      aligned_vector<int8_t> Bint8_ref(k * n);
+
+      aligned_vector<int32_t> Cint32_ref(m * n * groups);
+      aligned_vector<uint8_t> Cint8_ref(Cint32_ref.size());
+      aligned_vector<uint8_t> Cint8_fb(Cint32_ref.size());
+      aligned_vector<int32_t> Cint32_buffer(Cint32_ref.size());
+
+      randFill<uint8_t>(Aint8, 0, 255);
+      int32_t Aint8_zero_point = 43;
+
+      randFill<int8_t>(Bint8_ref, -128, 127);
+      for (int g = 0; g < groups; ++g) {
+        avoidOverflow(
+            m,
+            n,
+            k_per_group,
+            Aint8.data() + g * k_per_group,
+            k,
+            Bint8_ref.data() + g * k_per_group * n,
+            n);
+      }
+
+      aligned_vector<int8_t> Bint8(Bint8_ref);
+      if (btrans == matrix_op_t::Transpose) {
+        aligned_vector<int8_t> Bint8_temp(Bint8.size());
+        for (int g = 0; g < groups; ++g) {
+          transpose_matrix(
+              k_per_group,
+              n,
+              Bint8.data() + g * k_per_group * n,
+              n,
+              Bint8_temp.data() + g * k_per_group * n,
+              k_per_group);
+        }
+        Bint8 = Bint8_temp;
+      }
+
+      int n_adjusted = n;
+      if (test_ld && btrans == matrix_op_t::NoTranspose) {
+        n_adjusted = std::max(n / 2, 1);
+      }
+
+      int ncols_per_quant_group = groups * n_adjusted;
+      if (Q_GRAN == QuantizationGranularity::GROUP) {
+        ncols_per_quant_group = n_adjusted;
+      } else if (Q_GRAN == QuantizationGranularity::OUT_CHANNEL) {
+        ncols_per_quant_group = 1;
+      }
+      aligned_vector<int32_t> Bint8_zero_point(
+          groups * n_adjusted / ncols_per_quant_group);
+      randFill(Bint8_zero_point, -50, -10);
+
+      vector<int32_t> col_offsets(groups * n_adjusted);
+      for (int g = 0; g < groups; ++g) {
+        col_offsets_with_zero_pt_s8acc32_ref(
+            k_per_group,
+            n_adjusted,
+            n,
+            Bint8_ref.data() + g * k_per_group * n,
+            Bint8_zero_point.data() + g * n_adjusted / ncols_per_quant_group,
+            col_offsets.data() + g * n_adjusted,
+            ncols_per_quant_group);
+      }
+
+      aligned_vector<float> act_times_w_scale(Bint8_zero_point.size());
+      randFill(act_times_w_scale, 0.0001f, 0.0003f);
+      aligned_vector<float> C_multiplier(act_times_w_scale.size());
+      for (size_t q = 0; q < C_multiplier.size(); ++q) {
+        C_multiplier[q] = act_times_w_scale[q] / 0.1f;
+      }
+      int32_t C_zero_pt = 5;
+
+      // The residual has the shape of C and its own quantization params
+      aligned_vector<uint8_t> residual(Cint32_ref.size());
+      randFill<uint8_t>(residual, 0, 255);
+      int32_t residual_zero_pt = 100;
+      float residual_scale = 0.05f;
+
+      vector<int32_t> row_offsets(m);
+      for (int g = 0; g < groups; ++g) {
+        matmul_u8i8acc32_ref(
+            m,
+            n_adjusted,
+            k_per_group,
+            k,
+            n,
+            groups * n,
+            Aint8.data() + g * k_per_group,
+            Bint8_ref.data() + g * k_per_group * n,
+            Cint32_ref.data() + g * n_adjusted);
+
+        for (int i = 0; i < m; ++i) {
+          for (int j = g * n_adjusted; j < (g + 1) * n_adjusted; ++j) {
+            float multiplier =
+                residual_scale / act_times_w_scale[j / ncols_per_quant_group];
+            Cint32_ref[i * groups * n + j] += std::lrintf(
+                (residual[i * groups * n + j] - residual_zero_pt) *
+                multiplier);
+          }
+        }
+
+        row_offsets_u8acc32_ref(
+            m,
+            k_per_group,
+            k,
+            Aint8.data() + g * k_per_group,
+            row_offsets.data());
+
+        requantize_u8acc32_ref(
+            m,
+            n_adjusted,
+            groups * n,
+            Cint32_ref.data() + g * n_adjusted,
+            Cint8_ref.data() + g * n_adjusted,
+            C_multiplier.data() + g * n_adjusted / ncols_per_quant_group,
+            C_zero_pt,
+            Aint8_zero_point,
+            Bint8_zero_point.data() + g * n_adjusted / ncols_per_quant_group,
+            row_offsets.data(),
+            col_offsets.data() + g * n_adjusted,
+            nullptr,
+            ncols_per_quant_group);
+      }
+
+      if (atrans == matrix_op_t::Transpose) {
+        aligned_vector<uint8_t> Aint8_temp(Aint8.size());
+        transpose_matrix(m, k, Aint8.data(), k, Aint8_temp.data(), m);
+        Aint8 = Aint8_temp;
+      }
+
+      PackBMatrix<int8_t> packedBN(
+          btrans,
+          k,
+          n_adjusted,
+          Bint8.data(),
+          (btrans == matrix_op_t::Transpose) ? k_per_group : n,
+          nullptr,
+          groups);
+
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+      {
+        vector<int32_t> row_offset_buf(
+            PackAWithRowOffset<uint8_t>::rowOffsetBufferSize());
+
+        PackAWithRowOffset<uint8_t> packAN(
+            atrans,
+            m,
+            k,
+            Aint8.data(),
+            (atrans == matrix_op_t::Transpose) ? m : k,
+            nullptr,
+            groups,
+            row_offset_buf.data());
+
+        DoNothing<> doNothingObj{};
+        ReQuantizeOutput<false, Q_GRAN> reqObj(
+            doNothingObj,
+            C_multiplier.data(),
+            C_zero_pt,
+            Aint8_zero_point,
+            Bint8_zero_point.data(),
+            packAN.getRowOffsetBuffer(),
+            col_offsets.data(),
+            nullptr,
+            groups * n_adjusted,
+            groups);
+        DoResidualAddOnInpBuffer<
+            uint8_t,
+            int32_t,
+            ReQuantizeOutput<false, Q_GRAN>>
+            residualObj(
+                reqObj,
+                residual.data(),
+                groups * n,
+                residual_zero_pt,
+                residual_scale,
+                act_times_w_scale.data(),
+                groups);
+
+        fbgemmPacked(
+            packAN,
+            packedBN,
+            Cint8_fb.data(),
+            Cint32_buffer.data(),
+            groups * n,
+            residualObj,
+            fbgemm_get_thread_num(),
+            fbgemm_get_num_threads());
+      }
+
+      compare_validate_buffers(
+          Cint8_ref.data(),
+          Cint8_fb.data(),
+          m,
+          groups * n_adjusted,
+          groups * n,
+          static_cast<uint8_t>(0));
+    } // for each groups
+  } // for each shape
+}
+
+/**
+ * @brief Unit test for uint8 matrix A, int8 matrix B, and 32-bit
+ * accumulation. Output processing: residual add -> requantization -> nothing
+ */
+TEST_P(fbgemmu8s8acc32WithQuantGranularityTest, TestResidualAdd) {
+  matrix_op_t atrans, btrans;
+  bool test_ld;
+  QuantizationGranularity q_granularity;
+  tie(atrans, btrans, test_ld, q_granularity) = GetParam();
+
+  if (q_granularity == QuantizationGranularity::TENSOR) {
+    runResidualAddTest<QuantizationGranularity::TENSOR>(
+        atrans, btrans, test_ld);
+  } else if (q_granularity == QuantizationGranularity::GROUP) {
+    runResidualAddTest<QuantizationGranularity::GROUP>(
+        atrans, btrans, test_ld);
+  } else {
+    runResidualAddTest<QuantizationGranularity::OUT_CHANNEL>(
+        atrans, btrans, test_ld);
+  }
+}
+
 /**
  * @brief Unit test for uint8 matrix A, int8 matrix B, and 32-bit
  * accumulation. Directly output fp32 matrix C. Output processing:
@@ -849,3 +1091,130 @@ TEST_P(fbgemmPackUnpackAcc32Test, TestPackUnpack) {
     }
   }
 }
+
+/**
+ * @brief Unit test for fp32 A quantized per row to uint8 and int8 B quantized
+ * per column, with 32-bit accumulation. Output processing: requantization for
+ * float with per-row A parameters.
+ */
+TEST(fbgemmu8s8acc32PerRowATest, TestFloatInputOutput) {
+  vector<vector<int>> shapes(GetShapes_());
+  for (auto shape : shapes) {
+    for (bool fuse_relu : {false, true}) {
+      int m = shape[0];
+      int n = shape[1];
+      int k = shape[2];
+
+      aligned_vector<float> Afp32(m * k);
+      randFill(Afp32, -4.0f, 6.0f);
+      // Rows with different ranges get different parameters.
+      for (int i = 0; i < m; ++i) {
+        for (int kk = 0; kk < k; ++kk) {
+          Afp32[i * k + kk] *= 1 + i % 5;
+        }
+      }
+      aligned_vector<uint8_t> Aint8(m * k);
+      vector<float> Aint8_scales(m);
+      vector<int32_t> Aint8_zero_points(m);
+      QuantizeRowwiseDynamic(
+          Afp32.data(),
+          Aint8.data(),
+          m,
+          k,
+          Aint8_scales.data(),
+          Aint8_zero_points.data());
+
+      aligned_vector<int8_t> Bint8(k * n);
+      randFill<int8_t>(Bint8, -128, 127);
+      aligned_vector<int32_t> Bint8_zero_point(n);
+      randFill(Bint8_zero_point, -50, -10);
+      aligned_vector<float> Bint8_scale(n);
+      randFill(Bint8_scale, 0.49f / 2, 0.49f * 3 / 2);
+      vector<int32_t> col_offsets(n);
+      col_offsets_with_zero_pt_s8acc32_ref(
+          k, n, n, Bint8.data(), Bint8_zero_point.data(), col_offsets.data(), 1);
+      aligned_vector<float> bias(n);
+      randFill(bias, -8.0f, 8.0f);
+
+      aligned_vector<float> Cfp32_ref(m * n);
+      for (int i = 0; i < m; ++i) {
+        for (int j = 0; j < n; ++j) {
+          int64_t acc = 0;
+          for (int kk = 0; kk < k; ++kk) {
+            acc += (Aint8[i * k + kk] - Aint8_zero_points[i]) *
+                (Bint8[kk * n + j] - Bint8_zero_point[j]);
+          }
+          float res = acc * Aint8_scales[i] * Bint8_scale[j] + bias[j];
+          Cfp32_ref[i * n + j] = fuse_relu ? std::max(res, 0.0f) : res;
+        }
+      }
+
+      PackBMatrix<int8_t> packedBN(
+          matrix_op_t::NoTranspose, k, n, Bint8.data(), n, nullptr, 1);
+
+      aligned_vector<float> Cfp32_fb(m * n);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+      {
+        vector<int32_t> row_offset_buf(
+            PackAWithRowOffset<uint8_t>::rowOffsetBufferSize());
+        PackAWithRowOffset<uint8_t> packAN(
+            matrix_op_t::NoTranspose,
+            m,
+            k,
+            Aint8.data(),
+            k,
+            nullptr,
+            1,
+            row_offset_buf.data());
+
+        int num_threads = fbgemm_get_num_threads();
+        int tid = fbgemm_get_thread_num();
+
+        DoNothing<float, float> doNothingObj{};
+        auto run = [&](auto outputProcObj) {
+          fbgemmPacked(
+              packAN,
+              packedBN,
+              Cfp32_fb.data(),
+              reinterpret_cast<int32_t*>(Cfp32_fb.data()),
+              n,
+              outputProcObj,
+              tid,
+              num_threads);
+        };
+        if (fuse_relu) {
+          run(ReQuantizeForFloat<true, QuantizationGranularity::OUT_CHANNEL>(
+              doNothingObj,
+              Aint8_scales.data(),
+              Bint8_scale.data(),
+              Aint8_zero_points.data(),
+              Bint8_zero_point.data(),
+              packAN.getRowOffsetBuffer(),
+              col_offsets.data(),
+              bias.data(),
+              n));
+        } else {
+          run(ReQuantizeForFloat<false, QuantizationGranularity::OUT_CHANNEL>(
+              doNothingObj,
+              Aint8_scales.data(),
+              Bint8_scale.data(),
+              Aint8_zero_points.data(),
+              Bint8_zero_point.data(),
+              packAN.getRowOffsetBuffer(),
+              col_offsets.data(),
+              bias.data(),
+              n));
+        }
+      }
+
+      float maximum = 0;
+      for (float c : Cfp32_ref) {
+        maximum = std::max(maximum, std::abs(c));
+      }
+      compare_validate_buffers(
+          Cfp32_ref.data(), Cfp32_fb.data(), m, n, n, maximum * 1e-5f);
+    }
+  }
+}
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <cpuinfo.h>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "fbgemm/Utils.h"
+#include "src/PrefixSum.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+template <typename T>
+using PrefixSumFn = function<T(int64_t, const T*, T*, T)>;
+
+template <typename T>
+void checkPrefixSum(const PrefixSumFn<T>& prefix_sum) {
+  default_random_engine generator(1);
+  uniform_int_distribution<int> length_dist(-1000, 1000);
+  for (int64_t n : {0, 1, 3, 4, 7, 8, 15, 16, 17, 31, 33, 100, 1023}) {
+    vector<T> input(n);
+    for (auto& x : input) {
+      x = length_dist(generator);
+    }
+    const T init = length_dist(generator);
+    vector<T> expected(n);
+    T sum = init;
+    for (int64_t i = 0; i < n; ++i) {
+      expected[i] = sum;
+      sum += input[i];
+    }
+
+    vector<T> output(n, -1);
+    EXPECT_EQ(prefix_sum(n, input.data(), output.data(), init), sum) << n;
+    EXPECT_EQ(output, expected) << n;
+
+    // In place
+    EXPECT_EQ(prefix_sum(n, input.data(), input.data(), init), sum) << n;
+    EXPECT_EQ(input, expected) << n;
+  }
+}
+
+template <typename T>
+void checkAllPrefixSums() {
+  checkPrefixSum<T>([](int64_t n, const T* input, T* output, T init) {
+    return exclusive_prefix_sum(n, input, output, init);
+  });
+  if (!cpuinfo_initialize()) {
+    return;
+  }
+  if (fbgemmHasAvx2Support()) {
+    checkPrefixSum<T>([](int64_t n, const T* input, T* output, T init) {
+      return internal::exclusive_prefix_sum_avx2(n, input, output, init);
+    });
+  }
+  if (fbgemmHasAvx512Support()) {
+    checkPrefixSum<T>([](int64_t n, const T* input, T* output, T init) {
+      return internal::exclusive_prefix_sum_avx512(n, input, output, init);
+    });
+  }
+}
+
+} // namespace
+
+TEST(PrefixSumTest, int32) {
+  checkAllPrefixSums<int32_t>();
+}
+
+TEST(PrefixSumTest, int64) {
+  checkAllPrefixSums<int64_t>();
+}
@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "fbgemm/FbgemmEmbedding.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+uint32_t murmurMix(uint32_t h) {
+  h ^= h >> 16;
+  h *= 0x85ebca6b;
+  h ^= h >> 13;
+  h *= 0xc2b2ae35;
+  h ^= h >> 16;
+  return h;
+}
+
+// The [capacity, 2] linear probing table of fbgemm_gpu pruned_hashmap_insert
+// and pruned_hashmap_lookup
+struct LinearProbingTable {
+  vector<int64_t> offsets;
+  vector<int32_t> slots;
+
+  LinearProbingTable(
+      int T,
+      int B,
+      const vector<int64_t>& capacities,
+      const vector<int32_t>& indices,
+      const vector<int32_t>& dense_indices,
+      const vector<int32_t>& bag_offsets)
+      : offsets(T + 1, 0) {
+    for (int t = 0; t < T; ++t) {
+      offsets[t + 1] = offsets[t] + capacities[t];
+    }
+    slots.assign(2 * offsets[T], -1);
+    for (int t = 0; t < T; ++t) {
+      const int64_t capacity = capacities[t];
+      if (capacity == 0) {
+        continue;
+      }
+      for (int i = bag_offsets[t * B]; i < bag_offsets[(t + 1) * B]; ++i) {
+        if (dense_indices[i] == -1) {
+          continue;
+        }
+        int64_t slot = murmurMix(indices[i]) % capacity;
+        while (true) {
+          int32_t* s = &slots[2 * (offsets[t] + slot)];
+          if (s[0] == -1 || s[0] == indices[i]) {
+            s[0] = indices[i];
+            s[1] = dense_indices[i];
+            break;
+          }
+          slot = (slot + 1) % capacity;
+        }
+      }
+    }
+  }
+
+  int32_t lookup(int t, int32_t idx) const {
+    const int64_t capacity = offsets[t + 1] - offsets[t];
+    if (capacity == 0) {
+      return idx;
+    }
+    int64_t slot = murmurMix(idx) % capacity;
+    for (int64_t probe = 0; probe < capacity; ++probe) {
+      const int32_t* s = &slots[2 * (offsets[t] + slot)];
+      if (s[0] == -1) {
+        return -1;
+      }
+      if (s[0] == idx) {
+        return s[1];
+      }
+      slot = (slot + 1) % capacity;
+    }
+    return -1;
+  }
+};
+
+// {number of tables, batch size, bag size, load factor}
+class PrunedHashMapTest
+    : public testing::TestWithParam<tuple<int, int, int, float>> {};
+
+} // namespace
+
+INSTANTIATE_TEST_CASE_P(
+    InstantiationName,
+    PrunedHashMapTest,
+    ::testing::Combine(
+        ::testing::Values(1, 3),
+        ::testing::Values(1, 13, 64),
+        ::testing::Values(1, 7, 40),
+        ::testing::Values(0.5f, 0.8f, 0.95f)));
+
+TEST_P(PrunedHashMapTest, matchesLinearProbing) {
+  const auto [T, B, L, load_factor] = GetParam();
+  const int num_rows = B * L;
+  default_random_engine generator(T * 1000 + B * 10 + L);
+  uniform_int_distribution<int32_t> index_dist(
+      0, numeric_limits<int32_t>::max());
+  bernoulli_distribution pruned_dist(0.3);
+
+  // Distinct indices per table, 30% of them pruned; the last table of
+  // several is not pruned
+  vector<int32_t> indices, dense_indices, bag_offsets = {0};
+  vector<int64_t> capacities;
+  for (int t = 0; t < T; ++t) {
+    const bool unpruned = T > 1 && t == T - 1;
+    capacities.push_back(
+        unpruned ? 0 : static_cast<int64_t>(num_rows / load_factor));
+    vector<int32_t> table_indices;
+    while (static_cast<int>(table_indices.size()) < num_rows) {
+      const int32_t idx = index_dist(generator);
+      if (find(table_indices.begin(), table_indices.end(), idx) ==
+          table_indices.end()) {
+        table_indices.push_back(idx);
+      }
+    }
+    for (int i = 0; i < num_rows; ++i) {
+      indices.push_back(table_indices[i]);
+      dense_indices.push_back(pruned_dist(generator) ? -1 : i);
+    }
+    for (int b = 0; b < B; ++b) {
+      bag_offsets.push_back(bag_offsets.back() + L);
+    }
+  }
+  const LinearProbingTable reference(
+      T, B, capacities, indices, dense_indices, bag_offsets);
+
+  vector<int64_t> group_offsets(T + 1);
+  pruned_hashmap_grouped_offsets(
+      T, reference.offsets.data(), group_offsets.data());
+  for (int t = 0; t < T; ++t) {
+    const int64_t num_groups = group_offsets[t + 1] - group_offsets[t];
+    EXPECT_EQ(num_groups & (num_groups - 1), 0);
+    EXPECT_GE(num_groups * kPrunedHashMapGroupSize, capacities[t]);
+  }
+  vector<int32_t> groups(group_offsets[T] * 2 * kPrunedHashMapGroupSize);
+  ASSERT_TRUE(pruned_hashmap_grouped_build(
+      T,
+      B,
+      indices.data(),
+      dense_indices.data(),
+      bag_offsets.data(),
+      group_offsets.data(),
+      groups.data()));
+
+  // Look up the inserted indices, half of them replaced by absent ones
+  vector<int32_t> queries = indices;
+  for (size_t i = 0; i < queries.size(); i += 2) {
+    queries[i] = index_dist(generator);
+  }
+  queries[0] = -1;
+  vector<int32_t> result(queries.size());
+  pruned_hashmap_grouped_lookup(
+      T,
+      B,
+      queries.data(),
+      bag_offsets.data(),
+      groups.data(),
+      group_offsets.data(),
+      result.data());
+  for (int t = 0; t < T; ++t) {
+    for (int i = bag_offsets[t * B]; i < bag_offsets[(t + 1) * B]; ++i) {
+      EXPECT_EQ(result[i], reference.lookup(t, queries[i]))
+          << "table " << t << " index " << queries[i];
+    }
+  }
+}
+
+TEST(PrunedHashMapTest, fullTable) {
+  // 8 slots for 9 indices, then for the same 8 indices inserted twice
+  const vector<int64_t> hash_table_offsets = {0, 8};
+  vector<int64_t> group_offsets(2);
+  pruned_hashmap_grouped_offsets(
+      1, hash_table_offsets.data(), group_offsets.data());
+  ASSERT_EQ(group_offsets[1], 1);
+  vector<int32_t> groups(2 * kPrunedHashMapGroupSize);
+
+  vector<int32_t> indices = {3, 1, 4, 0, 5, 9, 2, 6, 7};
+  vector<int32_t> dense_indices = {0, 1, 2, 3, 4, 5, 6, 7, 8};
+  const vector<int32_t> offsets = {0, 9};
+  EXPECT_FALSE(pruned_hashmap_grouped_build(
+      1,
+      1,
+      indices.data(),
+      dense_indices.data(),
+      offsets.data(),
+      group_offsets.data(),
+      groups.data()));
+
+  indices[8] = 3;
+  ASSERT_TRUE(pruned_hashmap_grouped_build(
+      1,
+      1,
+      indices.data(),
+      dense_indices.data(),
+      offsets.data(),
+      group_offsets.data(),
+      groups.data()));
+  const vector<int32_t> queries = {3, 1, 0, 8, 6};
+  const vector<int32_t> lookup_offsets = {0, 5};
+  vector<int32_t> result(queries.size());
+  pruned_hashmap_grouped_lookup(
+      1,
+      1,
+      queries.data(),
+      lookup_offsets.data(),
+      groups.data(),
+      group_offsets.data(),
+      result.data());
+  EXPECT_EQ(result, (vector<int32_t>{8, 1, 3, -1, 7}));
+}
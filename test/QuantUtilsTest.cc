@@ -8,13 +8,19 @@
 
 #include <algorithm>
 #include <climits>
+#include <cmath>
+#include <cstring>
+#include <functional>
 #include <limits>
+#include <map>
+#include <numeric>
 #include <random>
 #include <sstream>
 #include <type_traits>
 
 #include "TestUtils.h"
 #include "fbgemm/QuantUtils.h"
+#include "fbgemm/QuantUtilsAvx2.h"
 #include "fbgemm/Types.h"
 #include "fbgemm/Utils.h"
 
@@ -27,7 +33,13 @@ class QuantizeGroupwiseTest
     : public testing::TestWithParam<tuple<int, int, int, int, layout_t>> {};
 
 class QuantizeTest : public testing::TestWithParam<int> {};
+// Parameter is the number of columns
+class QuantizeRowwiseDynamicTest : public testing::TestWithParam<int> {};
+// Parameter is the number of columns
+class QuantizeWithRowOffsetsTest : public testing::TestWithParam<int> {};
 class FusedQuantizeDequantizeTest : public testing::TestWithParam<int> {};
+// Parameter is the number of channels
+class RequantizePerChannelTest : public testing::TestWithParam<int> {};
 
 // Parameter are bit_rate (i.e., the number of bits in quantized values),
 // input rows, and input columns
@@ -39,6 +51,14 @@ class EmbeddingQuantizeTest
 class EmbeddingQuantizeSBFloatTest
     : public testing::TestWithParam<tuple<int, int>> {};
 
+// Parameter are input rows, input columns and exponent bits
+class EmbeddingQuantizeFP8Test
+    : public testing::TestWithParam<tuple<int, int, int>> {};
+
+// Parameter are the MX format and input columns
+class EmbeddingQuantizeMXTest
+    : public testing::TestWithParam<tuple<MXFormat, int>> {};
+
 INSTANTIATE_TEST_CASE_P(
     InstantiationName,
     QuantizeGroupwiseTest,
@@ -54,6 +74,16 @@ INSTANTIATE_TEST_CASE_P(
     QuantizeTest,
     ::testing::Values(1, 2, 5, 8, 9, 16, 20, 28, 32, 33));
 
+INSTANTIATE_TEST_CASE_P(
+    InstantiationName,
+    QuantizeRowwiseDynamicTest,
+    ::testing::Values(1, 5, 16, 17, 33, 64, 100, 511));
+
+INSTANTIATE_TEST_CASE_P(
+    InstantiationName,
+    QuantizeWithRowOffsetsTest,
+    ::testing::Values(1, 5, 8, 16, 17, 33, 64, 100, 511));
+
 INSTANTIATE_TEST_CASE_P(
     InstantiationName,
     FusedQuantizeDequantizeTest,
@@ -74,6 +104,25 @@ INSTANTIATE_TEST_CASE_P(
         ::testing::ValuesIn({1, 2, 3}),
         ::testing::ValuesIn({1, 2, 5, 8, 9, 16, 20, 28, 32, 33, 64, 65})));
 
+INSTANTIATE_TEST_CASE_P(
+    InstantiationName,
+    EmbeddingQuantizeFP8Test,
+    ::testing::Combine(
+        ::testing::ValuesIn({1, 2, 5}),
+        ::testing::ValuesIn({1, 2, 5, 8, 9, 16, 33, 64, 65}),
+        ::testing::ValuesIn({4, 5})));
+
+INSTANTIATE_TEST_CASE_P(
+    InstantiationName,
+    EmbeddingQuantizeMXTest,
+    ::testing::Combine(
+        ::testing::Values(
+            MXFormat::MXFP8_E4M3,
+            MXFormat::MXFP8_E5M2,
+            MXFormat::MXFP4_E2M1,
+            MXFormat::MXINT8),
+        ::testing::ValuesIn({1, 5, 32, 33, 64, 100})));
+
 template <typename T, layout_t LT>
 void ref_impl(
     const vector<float>& src,
@@ -414,6 +463,56 @@ TEST(QuantizeTest, cornerCases) {
   EXPECT_EQ(dst_int16[1], -32768);
 }
 
+template <int LEN, typename T, bool LEGACY>
+void runFixedLengthTest() {
+  default_random_engine generator;
+  uniform_real_distribution<float> distribution(-3.0f, 3.0f);
+  vector<float> src(LEN);
+  generate(src.begin(), src.end(), [&] { return distribution(generator); });
+  // Saturation and a halfway case
+  src[0] = 3.40282e+38;
+  src[1] = -2.16845e+38;
+  src[LEN - 1] = 0.25f;
+
+  TensorQuantizationParams qparams;
+  qparams.scale = 0.02f;
+  qparams.zero_point = is_signed<T>::value ? -5 : 130;
+  qparams.precision = 8;
+
+  vector<T> ref(LEN), dst(LEN);
+  Quantize<T, LEGACY>(src.data(), ref.data(), LEN, qparams);
+  QuantizeFixedLength<LEN, T, LEGACY>(src.data(), dst.data(), qparams);
+  EXPECT_EQ(dst, ref) << "LEN " << LEN << " LEGACY " << LEGACY;
+
+  vector<float> dequant_ref(LEN), dequant(LEN);
+  Dequantize(ref.data(), dequant_ref.data(), LEN, qparams);
+  DequantizeFixedLength<LEN, T>(ref.data(), dequant.data(), qparams);
+  EXPECT_EQ(dequant, dequant_ref) << "LEN " << LEN;
+
+  if (fbgemmHasAvx2Support()) {
+    fill(dst.begin(), dst.end(), 0);
+    QuantizeFixedLengthAvx2<LEN, T, LEGACY>(src.data(), dst.data(), qparams);
+    EXPECT_EQ(dst, ref) << "avx2 LEN " << LEN << " LEGACY " << LEGACY;
+  }
+}
+
+template <typename T, bool LEGACY>
+void runFixedLengthTests() {
+  runFixedLengthTest<8, T, LEGACY>();
+  runFixedLengthTest<16, T, LEGACY>();
+  runFixedLengthTest<32, T, LEGACY>();
+  runFixedLengthTest<64, T, LEGACY>();
+  runFixedLengthTest<128, T, LEGACY>();
+  runFixedLengthTest<256, T, LEGACY>();
+}
+
+TEST(QuantizeTest, fixedLengthMatchesQuantize) {
+  runFixedLengthTests<uint8_t, true>();
+  runFixedLengthTests<uint8_t, false>();
+  runFixedLengthTests<int8_t, true>();
+  runFixedLengthTests<int8_t, false>();
+}
+
 TEST(QuantizeTestQParams, chooseQParamsSymmetric) {
   // Test that symmetric quantization of weights set zero point exactly to 0.
   float min = -1.6165;
@@ -429,6 +528,243 @@ TEST(QuantizeTestQParams, chooseQParamsSymmetric) {
   EXPECT_EQ(result.zero_point, 0);
 }
 
+TEST_P(QuantizeRowwiseDynamicTest, matchesPerRowQuantize) {
+  int cols = GetParam();
+  // Rows with negative, positive, mixed, and all zero values.
+  constexpr int rows = 4;
+  default_random_engine generator;
+  uniform_real_distribution<float> dist(-2.0f, 3.0f);
+  vector<float> src(rows * cols);
+  for (int c = 0; c < cols; ++c) {
+    src[c] = -fabs(dist(generator)) - 0.5f;
+    src[cols + c] = fabs(dist(generator)) + 1.0f;
+    src[2 * cols + c] = 4 * dist(generator);
+    src[3 * cols + c] = 0.0f;
+  }
+
+  vector<uint8_t> dst(src.size()), dst_ref(src.size());
+  vector<float> scales(rows), scales_ref(rows);
+  vector<int32_t> zero_points(rows), zero_points_ref(rows);
+  QuantizeRowwiseDynamic(
+      src.data(), dst.data(), rows, cols, scales.data(), zero_points.data());
+  QuantizeRowwiseDynamicRef(
+      src.data(),
+      dst_ref.data(),
+      rows,
+      cols,
+      scales_ref.data(),
+      zero_points_ref.data());
+  EXPECT_EQ(dst, dst_ref);
+  EXPECT_EQ(scales, scales_ref);
+  EXPECT_EQ(zero_points, zero_points_ref);
+
+  for (int r = 0; r < rows; ++r) {
+    const auto [min, max] =
+        minmax_element(src.begin() + r * cols, src.begin() + (r + 1) * cols);
+    TensorQuantizationParams qparams =
+        ChooseQuantizationParams(*min, *max, 0, 255);
+    qparams.precision = 8;
+    EXPECT_EQ(scales[r], qparams.scale);
+    EXPECT_EQ(zero_points[r], qparams.zero_point);
+    for (int c = 0; c < cols; ++c) {
+      float x = src[r * cols + c];
+      EXPECT_EQ(dst[r * cols + c], (Quantize<uint8_t, false>(x, qparams)));
+    }
+  }
+}
+
+template <bool LEGACY>
+void runQuantizeWithRowOffsetsTests(int cols) {
+  constexpr int rows = 7;
+  default_random_engine generator;
+  // Some of the values saturate at 0 or 255
+  uniform_real_distribution<float> dist(-20.0f, 20.0f);
+  vector<float> src(rows * cols);
+  for (auto& x : src) {
+    x = dist(generator);
+  }
+  TensorQuantizationParams qparams;
+  qparams.scale = 0.11f;
+  qparams.zero_point = 97;
+  qparams.precision = 8;
+
+  vector<uint8_t> dst_ref(src.size());
+  vector<int32_t> row_offsets_ref(rows);
+  Quantize<uint8_t, LEGACY>(src.data(), dst_ref.data(), src.size(), qparams);
+  for (int r = 0; r < rows; ++r) {
+    row_offsets_ref[r] = accumulate(
+        dst_ref.begin() + r * cols, dst_ref.begin() + (r + 1) * cols, 0);
+  }
+
+  vector<uint8_t> dst(src.size());
+  vector<int32_t> row_offsets(rows);
+  QuantizeWithRowOffsetsRef<LEGACY>(
+      src.data(), dst.data(), rows, cols, qparams, row_offsets.data());
+  EXPECT_EQ(dst, dst_ref);
+  EXPECT_EQ(row_offsets, row_offsets_ref);
+
+  // The threads split the rows
+  constexpr int num_threads = 3;
+  fill(dst.begin(), dst.end(), 0);
+  fill(row_offsets.begin(), row_offsets.end(), -1);
+  for (int t = 0; t < num_threads; ++t) {
+    QuantizeWithRowOffsets<LEGACY>(
+        src.data(),
+        dst.data(),
+        rows,
+        cols,
+        qparams,
+        row_offsets.data(),
+        t,
+        num_threads);
+  }
+  EXPECT_EQ(dst, dst_ref);
+  EXPECT_EQ(row_offsets, row_offsets_ref);
+
+  // The AVX2 kernel is not dispatched to on AVX512 machines
+  if (fbgemmHasAvx2Support()) {
+    fill(dst.begin(), dst.end(), 0);
+    fill(row_offsets.begin(), row_offsets.end(), -1);
+    QuantizeWithRowOffsetsAvx2<LEGACY>(
+        src.data(), dst.data(), rows, cols, qparams, row_offsets.data());
+    EXPECT_EQ(dst, dst_ref);
+    EXPECT_EQ(row_offsets, row_offsets_ref);
+  }
+}
+
+TEST_P(QuantizeWithRowOffsetsTest, matchesQuantizeAndRowSum) {
+  int cols = GetParam();
+  runQuantizeWithRowOffsetsTests<true>(cols);
+  runQuantizeWithRowOffsetsTests<false>(cols);
+}
+
+INSTANTIATE_TEST_CASE_P(
+    InstantiationName,
+    RequantizePerChannelTest,
+    ::testing::Values(1, 7, 8, 16, 17, 33, 100));
+
+template <typename T>
+void runRequantizePerChannelTests(int channels, int precision) {
+  constexpr int rows = 13;
+  constexpr bool is_signed_output = is_signed<T>::value;
+  default_random_engine generator;
+  // Large accumulations saturate, small ones round to nearby values
+  uniform_int_distribution<int32_t> src_dist(-(1 << 20), 1 << 20);
+  uniform_real_distribution<float> multiplier_dist(1e-5f, 1e-2f);
+  uniform_int_distribution<int32_t> zero_point_dist(
+      is_signed_output ? -10 : 0, is_signed_output ? 10 : 20);
+  uniform_int_distribution<int32_t> fixed_multiplier_dist(1 << 29, 1 << 30);
+  uniform_int_distribution<int> right_shift_dist(32, 50);
+
+  vector<int32_t> src(rows * channels);
+  for (auto& x : src) {
+    x = src_dist(generator);
+  }
+  src[0] = numeric_limits<int32_t>::max();
+  src[src.size() - 1] = numeric_limits<int32_t>::min();
+  vector<float> multipliers(channels);
+  vector<int32_t> zero_points(channels), fixed_multipliers(channels);
+  vector<int> right_shifts(channels);
+  for (int c = 0; c < channels; ++c) {
+    multipliers[c] = multiplier_dist(generator);
+    zero_points[c] = zero_point_dist(generator);
+    fixed_multipliers[c] = fixed_multiplier_dist(generator);
+    right_shifts[c] = right_shift_dist(generator);
+  }
+
+  vector<T> dst_ref(src.size()), fixed_dst_ref(src.size());
+  RequantizePerChannelRef<T>(
+      src.data(),
+      dst_ref.data(),
+      rows,
+      channels,
+      multipliers.data(),
+      zero_points.data(),
+      precision);
+  RequantizeFixedPointPerChannelRef<T>(
+      src.data(),
+      fixed_dst_ref.data(),
+      rows,
+      channels,
+      fixed_multipliers.data(),
+      right_shifts.data(),
+      zero_points.data(),
+      precision);
+  for (size_t i = 0; i < src.size(); ++i) {
+    const int c = i % channels;
+    EXPECT_EQ(
+        dst_ref[i],
+        Requantize<T>(
+            src[i],
+            zero_points[c],
+            multipliers[c],
+            precision,
+            is_signed_output));
+  }
+
+  for (int num_threads : {1, 4}) {
+    vector<T> dst(src.size()), fixed_dst(src.size());
+    for (int tid = 0; tid < num_threads; ++tid) {
+      RequantizePerChannel<T>(
+          src.data(),
+          dst.data(),
+          rows,
+          channels,
+          multipliers.data(),
+          zero_points.data(),
+          precision,
+          tid,
+          num_threads);
+      RequantizeFixedPointPerChannel<T>(
+          src.data(),
+          fixed_dst.data(),
+          rows,
+          channels,
+          fixed_multipliers.data(),
+          right_shifts.data(),
+          zero_points.data(),
+          precision,
+          tid,
+          num_threads);
+    }
+    EXPECT_EQ(dst, dst_ref) << "num_threads " << num_threads;
+    EXPECT_EQ(fixed_dst, fixed_dst_ref) << "num_threads " << num_threads;
+  }
+
+  if (fbgemmHasAvx2Support()) {
+    vector<T> dst(src.size()), fixed_dst(src.size());
+    RequantizePerChannelAvx2<T>(
+        src.data(),
+        dst.data(),
+        rows,
+        channels,
+        multipliers.data(),
+        zero_points.data(),
+        precision);
+    RequantizeFixedPointPerChannelAvx2<T>(
+        src.data(),
+        fixed_dst.data(),
+        rows,
+        channels,
+        fixed_multipliers.data(),
+        right_shifts.data(),
+        zero_points.data(),
+        precision);
+    EXPECT_EQ(dst, dst_ref) << "avx2";
+    EXPECT_EQ(fixed_dst, fixed_dst_ref) << "avx2";
+  }
+}
+
+TEST_P(RequantizePerChannelTest, matchesRef) {
+  int channels = GetParam();
+  runRequantizePerChannelTests<uint8_t>(channels, 8);
+  runRequantizePerChannelTests<int8_t>(channels, 8);
+  runRequantizePerChannelTests<int16_t>(channels, 16);
+  // Narrower precisions clamp to their range
+  runRequantizePerChannelTests<uint8_t>(channels, 5);
+  runRequantizePerChannelTests<int16_t>(channels, 12);
+}
+
 template <typename T>
 void runFusedQuantizeDequantizeTests(
     const vector<float>& src,
@@ -727,6 +1063,100 @@ TEST_P(EmbeddingQuantizeTest, embeddingHalfTest) {
       pow(2, NumberOfFP16Matissa)));
 }
 
+// The range search only keeps ranges with a lower error than min and max
+TEST_P(EmbeddingQuantizeTest, greedyRangeSearchTest) {
+  int bit_rate, rows, cols;
+  tie(bit_rate, rows, cols) = GetParam();
+
+  // Normally distributed values, whose tails are worth clamping
+  default_random_engine gen;
+  normal_distribution<float> dis(0.0f, 3.0f);
+  vector<float> inpVec(rows * cols);
+  generate(inpVec.begin(), inpVec.end(), [&]() { return dis(gen); });
+
+  const int out_cols =
+      (cols + 8 / bit_rate - 1) / (8 / bit_rate) + 2 * sizeof(float16);
+  // Sum of squared errors of each row of the quantized output
+  auto rowErrors = [&](const vector<uint8_t>& quantized) {
+    vector<float> dequantized(rows * cols);
+    FusedNBitRowwiseQuantizedSBHalfToFloatOrHalfRef<float>(
+        bit_rate, quantized.data(), rows, out_cols, dequantized.data());
+    vector<float> errors(rows, 0.0f);
+    for (int r = 0; r < rows; ++r) {
+      for (int c = 0; c < cols; ++c) {
+        const float diff = dequantized[r * cols + c] - inpVec[r * cols + c];
+        errors[r] += diff * diff;
+      }
+    }
+    return errors;
+  };
+
+  vector<uint8_t> outVecMinMax(rows * out_cols), outVecRef(rows * out_cols),
+      outVecTest(rows * out_cols);
+  FloatOrHalfToFusedNBitRowwiseQuantizedSBHalfRef<float>(
+      bit_rate, inpVec.data(), rows, cols, outVecMinMax.data());
+  FloatOrHalfToFusedNBitRowwiseQuantizedSBHalfRef<float>(
+      bit_rate,
+      inpVec.data(),
+      rows,
+      cols,
+      outVecRef.data(),
+      /*greedy_range_search=*/true);
+  FloatOrHalfToFusedNBitRowwiseQuantizedSBHalf<float>(
+      bit_rate,
+      inpVec.data(),
+      rows,
+      cols,
+      outVecTest.data(),
+      /*thread_id=*/0,
+      /*num_threads=*/1,
+      /*greedy_range_search=*/true);
+
+  const vector<float> errorsMinMax = rowErrors(outVecMinMax);
+  const vector<float> errorsRef = rowErrors(outVecRef);
+  const vector<float> errorsTest = rowErrors(outVecTest);
+  for (int r = 0; r < rows; ++r) {
+    EXPECT_LE(errorsRef[r], errorsMinMax[r]) << "row " << r;
+    // The vectorized errors are summed in another order, which can move
+    // the search along another path when two ranges are about as good
+    EXPECT_LE(errorsTest[r], errorsMinMax[r] * (1 + 1e-4f)) << "row " << r;
+    EXPECT_NEAR(errorsTest[r], errorsRef[r], 0.05f * errorsMinMax[r])
+        << "row " << r;
+  }
+}
+
+TEST(EmbeddingQuantizeGreedyTest, clampsOutlier) {
+  // An outlier stretches the min max range of the other elements
+  vector<float> row(64);
+  for (int i = 0; i < 64; ++i) {
+    row[i] = (i % 16) / 16.0f;
+  }
+  row[7] = 3.0f;
+  const float rowMin = 0.0f, rowMax = 3.0f;
+
+  for (int bit_rate : {2, 4}) {
+    float xmin = rowMin, xmax = rowMax;
+    NBitRowwiseRangeSearchGreedyRef(bit_rate, row.data(), 64, xmin, xmax);
+    EXPECT_GE(xmin, rowMin);
+    EXPECT_LE(xmax, rowMax);
+    EXPECT_LT(xmax - xmin, rowMax - rowMin);
+    // Down to 1 - ratio of the range
+    EXPECT_GE(xmax - xmin, (rowMax - rowMin) * (1 - 0.16f) - 1e-3f);
+
+    float xminTest = rowMin, xmaxTest = rowMax;
+    NBitRowwiseRangeSearchGreedy(bit_rate, row.data(), 64, xminTest, xmaxTest);
+    EXPECT_FLOAT_EQ(xminTest, xmin);
+    EXPECT_FLOAT_EQ(xmaxTest, xmax);
+  }
+
+  // Nothing to search in a constant row
+  vector<float> constant(16, 3.0f);
+  float xmin = 3.0f, xmax = 3.0f;
+  NBitRowwiseRangeSearchGreedy(4, constant.data(), 16, xmin, xmax);
+  EXPECT_EQ(xmin, 3.0f);
+  EXPECT_EQ(xmax, 3.0f);
+}
+
 // Scale and bias are of type float
 TEST_P(EmbeddingQuantizeSBFloatTest, embeddingFloatTest) {
   int rows, cols;
@@ -803,3 +1233,479 @@ TEST_P(EmbeddingQuantizeSBFloatTest, embeddingFloatTest) {
       1e-3,
       pow(2, NumberOfFP16Matissa)));
 }
+
+TEST_P(EmbeddingQuantizeFP8Test, embeddingFloatTest) {
+  const auto [rows, cols, exponent_bits] = GetParam();
+  const int exponent_bias = exponent_bits == 4 ? 7 : 15;
+  const int mantissa_bits = 7 - exponent_bits;
+
+  default_random_engine gen;
+  uniform_real_distribution<float> disFP(-10.0f, 10.0f);
+  vector<float> inpVec(rows * cols);
+  generate(inpVec.begin(), inpVec.end(), [&]() { return disFP(gen); });
+  // An all zero row
+  fill(inpVec.begin(), inpVec.begin() + cols, 0.0f);
+  vector<float16> inpHalfVec(rows * cols);
+  for (int i = 0; i < rows * cols; ++i) {
+    inpHalfVec[i] = cpu_float2half_rn(inpVec[i]);
+    inpVec[i] = cpu_half2float(inpHalfVec[i]);
+  }
+
+  const int out_cols = cols + sizeof(float);
+  vector<uint8_t> outVecRef(rows * out_cols);
+  FloatOrHalfToFusedFP8RowwiseQuantizedRef<float>(
+      inpVec.data(),
+      rows,
+      cols,
+      outVecRef.data(),
+      exponent_bits,
+      exponent_bias);
+
+  // The vectorized quantization matches the reference bit by bit, for each
+  // partition of the rows across threads
+  for (int num_threads : {1, 2, 4}) {
+    vector<uint8_t> outVecTest(rows * out_cols),
+        outVecTestFromHalf(rows * out_cols);
+    for (int tid = 0; tid < num_threads; ++tid) {
+      FloatOrHalfToFusedFP8RowwiseQuantized<float>(
+          inpVec.data(),
+          rows,
+          cols,
+          outVecTest.data(),
+          exponent_bits,
+          exponent_bias,
+          tid,
+          num_threads);
+      FloatOrHalfToFusedFP8RowwiseQuantized<float16>(
+          inpHalfVec.data(),
+          rows,
+          cols,
+          outVecTestFromHalf.data(),
+          exponent_bits,
+          exponent_bias,
+          tid,
+          num_threads);
+    }
+    EXPECT_EQ(outVecTest, outVecRef);
+    EXPECT_EQ(outVecTestFromHalf, outVecRef);
+  }
+
+  vector<float> dequantOutRef(rows * cols), dequantOutTest(rows * cols);
+  vector<float16> dequantOutHalfRef(rows * cols),
+      dequantOutHalfTest(rows * cols);
+  FusedFP8RowwiseQuantizedToFloatOrHalfRef<float>(
+      outVecRef.data(),
+      rows,
+      out_cols,
+      dequantOutRef.data(),
+      exponent_bits,
+      exponent_bias);
+  FusedFP8RowwiseQuantizedToFloatOrHalfRef<float16>(
+      outVecRef.data(),
+      rows,
+      out_cols,
+      dequantOutHalfRef.data(),
+      exponent_bits,
+      exponent_bias);
+  for (int num_threads : {1, 3}) {
+    for (int tid = 0; tid < num_threads; ++tid) {
+      FusedFP8RowwiseQuantizedToFloatOrHalf<float>(
+          outVecRef.data(),
+          rows,
+          out_cols,
+          dequantOutTest.data(),
+          exponent_bits,
+          exponent_bias,
+          tid,
+          num_threads);
+      FusedFP8RowwiseQuantizedToFloatOrHalf<float16>(
+          outVecRef.data(),
+          rows,
+          out_cols,
+          dequantOutHalfTest.data(),
+          exponent_bits,
+          exponent_bias,
+          tid,
+          num_threads);
+    }
+    EXPECT_EQ(dequantOutTest, dequantOutRef);
+    EXPECT_EQ(dequantOutHalfTest, dequantOutHalfRef);
+  }
+
+  // The largest element of each row maps to the largest float8 value, so the
+  // relative error is within half a float8 ulp except for denormals
+  for (int r = 0; r < rows; ++r) {
+    float scale;
+    memcpy(&scale, outVecRef.data() + r * out_cols + cols, sizeof(float));
+    const float denormal_step =
+        scale * std::pow(2.0f, 1 - exponent_bias - mantissa_bits);
+    for (int c = 0; c < cols; ++c) {
+      const float x = inpVec[r * cols + c];
+      EXPECT_NEAR(
+          dequantOutRef[r * cols + c],
+          x,
+          std::abs(x) * std::pow(2.0f, -mantissa_bits - 1) + denormal_step)
+          << "at (" << r << ", " << c << ")";
+    }
+  }
+}
+
+// Parameter is the bit rate, with 0 for 8 bits with float scale and bias
+TEST_P(EmbeddingQuantizeMXTest, roundsToNearest) {
+  const auto [format, cols] = GetParam();
+  constexpr int rows = 5;
+  // Largest magnitude and exponent of its largest power of two
+  const map<MXFormat, pair<float, int>> element_ranges = {
+      {MXFormat::MXFP8_E4M3, {448.0f, 8}},
+      {MXFormat::MXFP8_E5M2, {57344.0f, 15}},
+      {MXFormat::MXFP4_E2M1, {6.0f, 2}},
+      {MXFormat::MXINT8, {127.0f / 64, 0}}};
+  const auto [max_pos, emax] = element_ranges.at(format);
+
+  // Rows of different magnitudes, including an all zero row
+  default_random_engine gen;
+  uniform_real_distribution<float> dis(-1.0f, 1.0f);
+  vector<float> input(rows * cols);
+  for (int row = 0; row < rows; ++row) {
+    for (int col = 0; col < cols; ++col) {
+      input[row * cols + col] = row == 2 ? 0.0f : ldexp(dis(gen), 6 * row - 12);
+    }
+  }
+  vector<float16> input_half(input.size());
+  for (size_t i = 0; i < input.size(); ++i) {
+    input_half[i] = cpu_float2half_rn(input[i]);
+    input[i] = cpu_half2float(input_half[i]);
+  }
+
+  const int row_bytes = MXQuantizedRowBytes(format, cols);
+  const int element_bytes =
+      format == MXFormat::MXFP4_E2M1 ? (cols + 1) / 2 : cols;
+  EXPECT_EQ(row_bytes, element_bytes + (cols + 31) / 32);
+  vector<uint8_t> quantized(rows * row_bytes);
+  FloatOrHalfToMXQuantized<float>(
+      format, input.data(), rows, cols, quantized.data());
+  vector<float> output(input.size());
+  MXQuantizedToFloatOrHalf<float>(
+      format, quantized.data(), rows, cols, output.data());
+
+  // All the values of the element format, from dequantizing a block of each
+  // code with a scale of 1
+  const int num_codes = format == MXFormat::MXFP4_E2M1 ? 16 : 256;
+  vector<float> values;
+  for (int code = 0; code < num_codes; ++code) {
+    const uint8_t block[2] = {static_cast<uint8_t>(code), 127};
+    float value;
+    MXQuantizedToFloatOrHalf<float>(format, block, 1, 1, &value);
+    if (isfinite(value)) {
+      values.push_back(value);
+    }
+  }
+  EXPECT_EQ(*max_element(values.begin(), values.end()), max_pos);
+
+  for (int row = 0; row < rows; ++row) {
+    for (int begin = 0; begin < cols; begin += kMXBlockSize) {
+      const int end = min(begin + kMXBlockSize, cols);
+      float amax = 0.0f;
+      for (int col = begin; col < end; ++col) {
+        amax = max(amax, fabs(input[row * cols + col]));
+      }
+      const int shared_exponent =
+          amax > 0.0f ? static_cast<int>(floor(log2(amax))) - emax : -127;
+      EXPECT_EQ(
+          quantized[row * row_bytes + element_bytes + begin / kMXBlockSize],
+          shared_exponent + 127);
+      // The nearest value of the block, which saturates
+      for (int col = begin; col < end; ++col) {
+        const float x = input[row * cols + col];
+        float best_error = numeric_limits<float>::infinity();
+        for (float value : values) {
+          best_error = min(best_error, fabs(ldexp(value, shared_exponent) - x));
+        }
+        EXPECT_EQ(fabs(output[row * cols + col] - x), best_error)
+            << "row " << row << " col " << col << " value " << x;
+      }
+    }
+  }
+
+  // Half inputs and outputs, and partitions of the rows across threads
+  for (int num_threads : {1, 2, 4}) {
+    vector<uint8_t> quantized_half(rows * row_bytes);
+    vector<float16> output_half(input.size());
+    for (int tid = 0; tid < num_threads; ++tid) {
+      FloatOrHalfToMXQuantized<float16>(
+          format,
+          input_half.data(),
+          rows,
+          cols,
+          quantized_half.data(),
+          tid,
+          num_threads);
+    }
+    for (int tid = 0; tid < num_threads; ++tid) {
+      MXQuantizedToFloatOrHalf<float16>(
+          format,
+          quantized_half.data(),
+          rows,
+          cols,
+          output_half.data(),
+          tid,
+          num_threads);
+    }
+    EXPECT_EQ(quantized_half, quantized);
+    for (size_t i = 0; i < input.size(); ++i) {
+      EXPECT_EQ(output_half[i], cpu_float2half_rn(output[i]));
+    }
+  }
+}
+
+TEST(EmbeddingQuantizeMXTest, encodings) {
+  // MXFP4 with a scale of 1: 6 = 1.5 * 2^2, 0.5 is the denormal, 0.75 is a
+  // tie rounded to the even 1, 7 saturates
+  vector<float> input(kMXBlockSize, 0.0f);
+  input[0] = 6.0f;
+  input[1] = -1.5f;
+  input[2] = 0.5f;
+  input[3] = 0.75f;
+  input[4] = -7.0f;
+  vector<uint8_t> quantized(MXQuantizedRowBytes(MXFormat::MXFP4_E2M1, 32));
+  FloatOrHalfToMXQuantized<float>(
+      MXFormat::MXFP4_E2M1, input.data(), 1, 32, quantized.data());
+  EXPECT_EQ(quantized[0], 0xB7);
+  EXPECT_EQ(quantized[1], 0x21);
+  EXPECT_EQ(quantized[2], 0x0F);
+  EXPECT_EQ(quantized[16], 127);
+
+  // MXFP8 with a scale of 2^-10: the largest values encode as S.1111.110 and
+  // S.11110.11
+  fill(input.begin(), input.end(), 0.0f);
+  input[0] = ldexp(448.0f, -10);
+  input[1] = -ldexp(256.0f, -10);
+  quantized.resize(MXQuantizedRowBytes(MXFormat::MXFP8_E4M3, 32));
+  FloatOrHalfToMXQuantized<float>(
+      MXFormat::MXFP8_E4M3, input.data(), 1, 32, quantized.data());
+  EXPECT_EQ(quantized[0], 0x7E);
+  EXPECT_EQ(quantized[1], 0xF8);
+  EXPECT_EQ(quantized[32], 127 - 10);
+  input[0] = ldexp(57344.0f, -10);
+  FloatOrHalfToMXQuantized<float>(
+      MXFormat::MXFP8_E5M2, input.data(), 1, 32, quantized.data());
+  EXPECT_EQ(quantized[0], 0x7B);
+  EXPECT_EQ(quantized[32], 127 - 10);
+
+  // A block with a NaN gets a NaN scale, the other blocks are unaffected
+  input.resize(2 * kMXBlockSize, 1.0f);
+  input[5] = numeric_limits<float>::quiet_NaN();
+  quantized.resize(MXQuantizedRowBytes(MXFormat::MXINT8, 64));
+  FloatOrHalfToMXQuantized<float>(
+      MXFormat::MXINT8, input.data(), 1, 64, quantized.data());
+  EXPECT_EQ(quantized[64], 0xFF);
+  EXPECT_EQ(quantized[65], 127);
+  EXPECT_EQ(quantized[32], 64);
+  vector<float> output(64);
+  MXQuantizedToFloatOrHalf<float>(
+      MXFormat::MXINT8, quantized.data(), 1, 64, output.data());
+  EXPECT_TRUE(isnan(output[0]));
+  EXPECT_EQ(output[32], 1.0f);
+}
+
+class EmbeddingQuantizeParallelTest : public testing::TestWithParam<int> {};
+
+INSTANTIATE_TEST_CASE_P(
+    InstantiationName,
+    EmbeddingQuantizeParallelTest,
+    ::testing::Values(0, 2, 4, 8));
+
+TEST_P(EmbeddingQuantizeParallelTest, matchesSerial) {
+  const int bit_rate = GetParam();
+  const int rows = 101;
+  const int cols = 24;
+  const int out_cols = bit_rate == 0
+      ? cols + 2 * sizeof(float)
+      : cols / (8 / bit_rate) + 2 * sizeof(float16);
+
+  default_random_engine gen;
+  uniform_real_distribution<float> disFP(-10.0f, 10.0f);
+  vector<float> inpVec(rows * cols);
+  generate(inpVec.begin(), inpVec.end(), [&]() { return disFP(gen); });
+
+  vector<uint8_t> outVecRef(rows * out_cols);
+  if (bit_rate == 0) {
+    FloatOrHalfToFused8BitRowwiseQuantizedSBFloat<float>(
+        inpVec.data(), rows, cols, outVecRef.data());
+  } else {
+    FloatOrHalfToFusedNBitRowwiseQuantizedSBHalf<float>(
+        bit_rate, inpVec.data(), rows, cols, outVecRef.data());
+  }
+
+  // A thread pool of the caller, here recording the tasks it ran
+  vector<int> tasks_run;
+  ParallelTasksExecutor parallel_for =
+      [&](int num_tasks, const function<void(int)>& task) {
+        for (int task_id = num_tasks - 1; task_id >= 0; --task_id) {
+          tasks_run.push_back(task_id);
+          task(task_id);
+        }
+      };
+
+  for (int num_threads : {0, 1, 3, 7}) {
+    for (bool use_parallel_for : {false, true}) {
+      tasks_run.clear();
+      vector<uint8_t> outVecTest(rows * out_cols);
+      if (bit_rate == 0) {
+        FloatOrHalfToFused8BitRowwiseQuantizedSBFloatParallel<float>(
+            inpVec.data(),
+            rows,
+            cols,
+            outVecTest.data(),
+            num_threads,
+            use_parallel_for ? parallel_for : nullptr);
+      } else {
+        FloatOrHalfToFusedNBitRowwiseQuantizedSBHalfParallel<float>(
+            bit_rate,
+            inpVec.data(),
+            rows,
+            cols,
+            outVecTest.data(),
+            num_threads,
+            use_parallel_for ? parallel_for : nullptr);
+      }
+      EXPECT_EQ(outVecTest, outVecRef) << "num_threads " << num_threads;
+      if (use_parallel_for && num_threads > 1) {
+        EXPECT_EQ(tasks_run.size(), num_threads);
+      }
+    }
+  }
+
+  // Chunks are consumed in order and cover all the rows
+  for (size_t chunk_rows : {1, 10, 64, 1000}) {
+    vector<uint8_t> outVecTest;
+    size_t next_row = 0;
+    RowwiseQuantizedChunkConsumer consumer =
+        [&](const uint8_t* output, size_t row_begin, size_t num_rows) {
+          EXPECT_EQ(row_begin, next_row);
+          EXPECT_LE(num_rows, chunk_rows);
+          outVecTest.insert(
+              outVecTest.end(), output, output + num_rows * out_cols);
+          next_row += num_rows;
+        };
+    if (bit_rate == 0) {
+      FloatOrHalfToFused8BitRowwiseQuantizedSBFloatChunked<float>(
+          inpVec.data(), rows, cols, consumer, chunk_rows, 2);
+    } else {
+      FloatOrHalfToFusedNBitRowwiseQuantizedSBHalfChunked<float>(
+          bit_rate, inpVec.data(), rows, cols, consumer, chunk_rows, 2);
+    }
+    EXPECT_EQ(outVecTest, outVecRef) << "chunk_rows " << chunk_rows;
+  }
+
+  // Dequantization split across threads
+  vector<float> dequantOutRef(rows * cols), dequantOutTest(rows * cols);
+  if (bit_rate == 0) {
+    Fused8BitRowwiseQuantizedSBFloatToFloatOrHalf<float>(
+        outVecRef.data(), rows, out_cols, dequantOutRef.data());
+    for (int tid = 0; tid < 3; ++tid) {
+      Fused8BitRowwiseQuantizedSBFloatToFloatOrHalf<float>(
+          outVecRef.data(), rows, out_cols, dequantOutTest.data(), tid, 3);
+    }
+  } else {
+    FusedNBitRowwiseQuantizedSBHalfToFloatOrHalf<float>(
+        bit_rate, outVecRef.data(), rows, out_cols, dequantOutRef.data());
+    for (int tid = 0; tid < 3; ++tid) {
+      FusedNBitRowwiseQuantizedSBHalfToFloatOrHalf<float>(
+          bit_rate,
+          outVecRef.data(),
+          rows,
+          out_cols,
+          dequantOutTest.data(),
+          tid,
+          3);
+    }
+  }
+  EXPECT_EQ(dequantOutTest, dequantOutRef);
+}
+
+class EmbeddingQuantizeGroupwiseTest
+    : public testing::TestWithParam<tuple<int, int>> {};
+
+INSTANTIATE_TEST_CASE_P(
+    InstantiationName,
+    EmbeddingQuantizeGroupwiseTest,
+    ::testing::Combine(
+        ::testing::Values(2, 4, 8), // bit_rate
+        ::testing::Values(8, 16, 64, 128))); // group_size
+
+TEST_P(EmbeddingQuantizeGroupwiseTest, matchesRefAndRowwise) {
+  int bit_rate, group_size;
+  tie(bit_rate, group_size) = GetParam();
+  const int rows = 37;
+  const int cols = 128;
+  const int num_groups = cols / group_size;
+  const int out_cols =
+      cols / (8 / bit_rate) + num_groups * 2 * sizeof(float16);
+
+  // Groups of very different ranges, which one scale per row would lose
+  default_random_engine gen;
+  normal_distribution<float> dis(0.0f, 1.0f);
+  vector<float> inpVec(rows * cols);
+  for (int i = 0; i < rows * cols; ++i) {
+    inpVec[i] = dis(gen) * (1 + (i % cols) / 16);
+  }
+
+  vector<uint8_t> outVecRef(rows * out_cols);
+  vector<uint8_t> outVecTest(rows * out_cols);
+  FloatOrHalfToFusedNBitGroupwiseQuantizedSBHalfRef<float>(
+      bit_rate, group_size, inpVec.data(), rows, cols, outVecRef.data());
+  for (int tid = 0; tid < 3; ++tid) {
+    FloatOrHalfToFusedNBitGroupwiseQuantizedSBHalf<float>(
+        bit_rate,
+        group_size,
+        inpVec.data(),
+        rows,
+        cols,
+        outVecTest.data(),
+        tid,
+        3);
+  }
+  EXPECT_EQ(outVecTest, outVecRef);
+
+  vector<float> dequantOutRef(rows * cols), dequantOutTest(rows * cols);
+  FusedNBitGroupwiseQuantizedSBHalfToFloatOrHalfRef<float>(
+      bit_rate,
+      group_size,
+      outVecRef.data(),
+      rows,
+      out_cols,
+      dequantOutRef.data());
+  FusedNBitGroupwiseQuantizedSBHalfToFloatOrHalf<float>(
+      bit_rate,
+      group_size,
+      outVecRef.data(),
+      rows,
+      out_cols,
+      dequantOutTest.data());
+  EXPECT_EQ(dequantOutTest, dequantOutRef);
+
+  // Against one scale and bias per row: the same rows for a single group,
+  // and a lower error otherwise
+  const int rowwise_cols = cols / (8 / bit_rate) + 2 * sizeof(float16);
+  vector<uint8_t> outVecRowwise(rows * rowwise_cols);
+  FloatOrHalfToFusedNBitRowwiseQuantizedSBHalf<float>(
+      bit_rate, inpVec.data(), rows, cols, outVecRowwise.data());
+  vector<float> dequantOutRowwise(rows * cols);
+  FusedNBitRowwiseQuantizedSBHalfToFloatOrHalf<float>(
+      bit_rate,
+      outVecRowwise.data(),
+      rows,
+      rowwise_cols,
+      dequantOutRowwise.data());
+  if (group_size == cols) {
+    EXPECT_EQ(outVecRef, outVecRowwise);
+  } else {
+    double err = 0, rowwise_err = 0;
+    for (int i = 0; i < rows * cols; ++i) {
+      err += fabs(dequantOutRef[i] - inpVec[i]);
+      rowwise_err += fabs(dequantOutRowwise[i] - inpVec[i]);
+    }
+    EXPECT_LT(err, rowwise_err);
+  }
+}
@@ -7,8 +7,14 @@
  */
 
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <cstdint>
+#include <functional>
 #include <limits>
+#include <map>
+#include <random>
+#include <thread>
+#include <vector>
 
 #include "fbgemm/Utils.h"
 #ifdef _OPENMP
@@ -78,3 +84,105 @@ TEST(cpuKernelTest, raidx_sort_heap_overflow) {
   omp_set_num_threads(orig_threads);
 #endif
 }
+
+namespace {
+// Runs each task on its own thread, as a framework thread pool would
+void thread_executor(int num_tasks, const std::function<void(int)>& task) {
+  std::vector<std::thread> threads;
+  for (int t = 0; t < num_tasks; ++t) {
+    threads.emplace_back(task, t);
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+}
+} // anonymous namespace
+
+TEST(cpuKernelTest, radix_sort_parallel_executor_test) {
+  std::default_random_engine generator;
+  for (const int64_t n : {0, 1, 7, 1000, 10007}) {
+    for (const bool may_be_neg : {false, true}) {
+      std::uniform_int_distribution<int64_t> dist(
+          may_be_neg ? -5000 : 0, 100000);
+      std::vector<int64_t> keys(n);
+      std::vector<int> values(n);
+      for (int64_t i = 0; i < n; ++i) {
+        keys[i] = dist(generator);
+        values[i] = i;
+      }
+      std::vector<int64_t> expected_keys = keys;
+      std::vector<int> expected_values = values;
+      std::stable_sort(
+          expected_values.begin(), expected_values.end(), [&](int a, int b) {
+            return keys[a] < keys[b];
+          });
+      std::sort(expected_keys.begin(), expected_keys.end());
+
+      for (const int num_tasks : {1, 3, 8}) {
+        for (const bool use_threads : {false, true}) {
+          std::vector<int64_t> keys_in = keys, keys_tmp(n);
+          std::vector<int> values_in = values, values_tmp(n);
+          const auto [sorted_keys, sorted_values] = fbgemm::radix_sort_parallel(
+              keys_in.data(),
+              values_in.data(),
+              keys_tmp.data(),
+              values_tmp.data(),
+              n,
+              100000,
+              may_be_neg,
+              num_tasks,
+              use_threads ? thread_executor : fbgemm::ParallelTasksExecutor());
+          EXPECT_EQ(
+              std::vector<int64_t>(sorted_keys, sorted_keys + n),
+              expected_keys);
+          EXPECT_EQ(
+              std::vector<int>(sorted_values, sorted_values + n),
+              expected_values);
+        }
+      }
+    }
+  }
+}
+
+TEST(cpuKernelTest, radix_sort_unique_with_counts_test) {
+  std::default_random_engine generator;
+  for (const int64_t n : {0, 1, 100, 5000}) {
+    for (const bool may_be_neg : {false, true}) {
+      std::uniform_int_distribution<int> dist(may_be_neg ? -50 : 0, 300);
+      std::vector<int> keys(n);
+      std::map<int, int64_t> expected;
+      for (auto& k : keys) {
+        k = dist(generator);
+        ++expected[k];
+      }
+
+      for (const int num_tasks : {1, 4, 7}) {
+        std::vector<int> unique_keys(n);
+        std::vector<int64_t> counts(n);
+        std::vector<int64_t> inverse(n, -1);
+        const int64_t num_unique = fbgemm::radix_sort_unique_with_counts(
+            keys.data(),
+            n,
+            300,
+            may_be_neg,
+            unique_keys.data(),
+            counts.data(),
+            inverse.data(),
+            num_tasks,
+            thread_executor);
+        ASSERT_EQ(num_unique, static_cast<int64_t>(expected.size()));
+        int64_t u = 0;
+        for (const auto& [key, count] : expected) {
+          EXPECT_EQ(unique_keys[u], key);
+          EXPECT_EQ(counts[u], count);
+          ++u;
+        }
+        for (int64_t i = 0; i < n; ++i) {
+          ASSERT_GE(inverse[i], 0);
+          ASSERT_LT(inverse[i], num_unique);
+          EXPECT_EQ(unique_keys[inverse[i]], keys[i]);
+        }
+      }
+    }
+  }
+}
@@ -7,6 +7,7 @@
  */
 
 #include <algorithm>
+#include <cmath>
 #include <functional>
 #include <iostream>
 #include <random>
@@ -18,6 +19,7 @@
 #include "./TestUtils.h"
 #include "bench/BenchUtils.h"
 #include "fbgemm/Fbgemm.h"
+#include "fbgemm/QuantUtils.h"
 
 using namespace std;
 using namespace fbgemm;
@@ -169,3 +171,79 @@ TEST_P(FloatRequantizeTest, floatBiasTest) {
   ASSERT_EQ(output_q_bias, output_f_bias)
       << "Requantization with quantized bias and float bias differs";
 }
+
+/**
+ * Test for an activation applied by a lookup table after requantization
+ */
+TEST(LookupTableRequantizeTest, matchesActivationOfRequantized) {
+  const int rows = 5, cols = 37, col_start = 6, ld = 48;
+  const TensorQuantizationParams in_qparams{0.05f, 128, 8};
+  const TensorQuantizationParams out_qparams{1.0f / 127, 127, 8};
+  uint8_t table[256];
+  ComputeActivationLookupTable(
+      [](float x) { return std::tanh(x); }, in_qparams, out_qparams, table);
+  for (int q = 0; q < 256; ++q) {
+    EXPECT_EQ(
+        table[q],
+        Quantize<uint8_t>(
+            std::tanh(Dequantize<uint8_t>(q, in_qparams)), out_qparams));
+  }
+
+  aligned_vector<int32_t> input(rows * cols);
+  randFill<int32_t>(input, -5000, 5000);
+  aligned_vector<int32_t> col_offsets(col_start + cols);
+  randFill<int32_t>(col_offsets, -8, 8);
+  aligned_vector<int32_t> row_offsets(rows);
+  randFill<int32_t>(row_offsets, -8, 8);
+  const float C_multiplier = 0.04f;
+  const int32_t A_zero_point = 3, B_zero_point = -2;
+
+  DoNothing<> doNothingObj{};
+  LookupTableOutput<> lookupTableObj(doNothingObj, table);
+  ReQuantizeOutput<false> reqObj(
+      doNothingObj,
+      &C_multiplier,
+      in_qparams.zero_point,
+      A_zero_point,
+      &B_zero_point,
+      row_offsets.data(),
+      col_offsets.data(),
+      nullptr,
+      col_start + cols);
+  ReQuantizeOutput<
+      false,
+      QuantizationGranularity::TENSOR,
+      int32_t,
+      uint8_t,
+      int32_t,
+      LookupTableOutput<>>
+      reqLookupObj(
+          lookupTableObj,
+          &C_multiplier,
+          in_qparams.zero_point,
+          A_zero_point,
+          &B_zero_point,
+          row_offsets.data(),
+          col_offsets.data(),
+          nullptr,
+          col_start + cols);
+
+  // The block is not at the start of the output, so that the table must be
+  // applied to the elements the requantization wrote and no others
+  block_type_t block{0, rows, col_start, cols};
+  aligned_vector<uint8_t> expected(rows * ld, 1), output(rows * ld, 1);
+  reqObj.f<inst_set_t::avx2>(expected.data(), input.data(), block, ld, cols);
+  for (int i = 0; i < rows; ++i) {
+    for (int j = col_start; j < col_start + cols; ++j) {
+      expected[i * ld + j] = table[expected[i * ld + j]];
+    }
+  }
+
+  reqLookupObj.f<inst_set_t::avx2>(
+      output.data(), input.data(), block, ld, cols);
+  EXPECT_EQ(output, expected);
+  fill(output.begin(), output.end(), 1);
+  reqLookupObj.f<inst_set_t::anyarch>(
+      output.data(), input.data(), block, ld, cols);
+  EXPECT_EQ(output, expected);
+}
@@ -7,6 +7,7 @@
  */
 
 #include <algorithm>
+#include <map>
 #include <numeric>
 #include <ostream>
 #include <random>
@@ -300,3 +301,305 @@ TEST_P(RowWiseSparseAdagradFusedTest, rowwiseTest) {
     }
   }
 }
+
+namespace {
+
+// {isWeightFp16, isIndex64b, isOffset64b, use_offsets, corner case,
+// grad_stride != block_size}
+class RowWiseSparseAdagradFusedModeTest
+    : public testing::TestWithParam<
+          tuple<bool, bool, bool, bool, EmbeddingSpMDMCornerCase, bool>> {};
+
+} // namespace
+
+INSTANTIATE_TEST_CASE_P(
+    InstantiationName,
+    RowWiseSparseAdagradFusedModeTest,
+    ::testing::Combine(
+        ::testing::Bool(), // isWeightFp16
+        ::testing::Bool(), // isIndex64b
+        ::testing::Bool(), // isOffset64b
+        ::testing::Bool(), // use_offsets
+        ::testing::Values(
+            NONE,
+            EMPTY_INDICES,
+            OUT_OF_BOUND_INDICES,
+            UNMATCHED_NUM_INDICES_AND_LENGTHS_SUM),
+        ::testing::Bool())); // grad_stride != block_size
+
+TEST_P(RowWiseSparseAdagradFusedModeTest, matchesAggregatedGradients) {
+  const auto
+      [isWeightFp16,
+       isIndex64b,
+       isOffset64b,
+       use_offsets,
+       corner_case,
+       use_grad_stride] = GetParam();
+
+  for (auto input : GetInputs_()) {
+    int batch_size = input[0];
+    int num_rows = input[1];
+    int embedding_dim = input[2];
+    int average_len = input[3];
+    int grad_stride = use_grad_stride ? embedding_dim * 2 + 3 : embedding_dim;
+
+    vector<float> w(num_rows * embedding_dim), h(num_rows),
+        g(batch_size * grad_stride);
+    default_random_engine generator;
+    uniform_real_distribution<float> values_gen(0, 2);
+    for (auto* v : {&w, &h, &g}) {
+      for (auto& x : *v) {
+        x = values_gen(generator);
+      }
+    }
+
+    vector<int64_t> lengths, offsets, indices;
+    vector<int32_t> lengths_32, offsets_32, indices_32;
+    vector<float> weights;
+    int lengths_sum = GenerateLengthsIndicesWeights(
+        lengths,
+        lengths_32,
+        offsets,
+        offsets_32,
+        indices,
+        indices_32,
+        weights,
+        batch_size,
+        num_rows,
+        average_len,
+        corner_case);
+
+    // The reference updates every unique row once, in increasing order, with
+    // the sum of the gradients of its occurrences
+    bool valid = corner_case == NONE || corner_case == EMPTY_INDICES;
+    map<int64_t, vector<float>> g_sums;
+    for (int m = 0, current = 0; valid && m < batch_size; ++m) {
+      for (int i = 0; i < lengths[m]; ++i, ++current) {
+        auto& g_sum = g_sums[indices[current]];
+        g_sum.resize(embedding_dim, 0.0f);
+        for (int j = 0; j < embedding_dim; ++j) {
+          g_sum[j] += g[m * grad_stride + j];
+        }
+      }
+    }
+    vector<int64_t> unique_indices;
+    vector<float> unique_g;
+    for (const auto& [idx, g_sum] : g_sums) {
+      unique_indices.push_back(idx);
+      unique_g.insert(unique_g.end(), g_sum.begin(), g_sum.end());
+    }
+    const vector<int64_t> unique_lengths(unique_indices.size(), 1);
+
+    const float epsilon = 1e-5;
+    const float lr = 0.5;
+    auto run = [&](auto weightTag, const auto& idx, const auto& offs) {
+      using WeightType = decltype(weightTag);
+      using IndexType = typename decay_t<decltype(idx)>::value_type;
+      using OffsetType = typename decay_t<decltype(offs)>::value_type;
+      vector<WeightType> w_test(w.size()), w_ref(w.size());
+      for (size_t i = 0; i < w.size(); ++i) {
+        if constexpr (is_same_v<WeightType, float16>) {
+          w_test[i] = w_ref[i] = cpu_float2half_rn(w[i]);
+        } else {
+          w_test[i] = w_ref[i] = w[i];
+        }
+      }
+      vector<float> h_test(h), h_ref(h);
+      if (valid) {
+        rowwise_sparse_adagrad_fused_ref(
+            embedding_dim,
+            static_cast<int64_t>(unique_indices.size()),
+            static_cast<int64_t>(unique_indices.size()),
+            num_rows,
+            w_ref.data(),
+            unique_g.data(),
+            h_ref.data(),
+            unique_indices.data(),
+            unique_lengths.data(),
+            epsilon,
+            lr,
+            false /* use_offsets */,
+            false /* use_stochastic_rounding */);
+      }
+
+      auto kernel =
+          GenerateRowWiseSparseAdaGradFused<IndexType, OffsetType, WeightType>(
+              embedding_dim,
+              16 /* prefetch */,
+              use_offsets,
+              false /* use_stochastic_rounding */,
+              use_grad_stride ? grad_stride : -1,
+              true /* deduplicate_indices */);
+      bool success = kernel(
+          batch_size,
+          lengths_sum,
+          num_rows,
+          w_test.data(),
+          g.data(),
+          h_test.data(),
+          corner_case == EMPTY_INDICES ? nullptr : idx.data(),
+          offs.data(),
+          epsilon,
+          lr);
+      EXPECT_EQ(success, valid);
+      // Invalid inputs are rejected before any update
+      EXPECT_TRUE(floatCloseAll(h_test, h_ref, DEFAULT_TOL, DEFAULT_TOL));
+      if constexpr (is_same_v<WeightType, float16>) {
+        EXPECT_TRUE(floatCloseAll(w_test, w_ref, 1.0e-2, 1.0e-2));
+      } else {
+        EXPECT_TRUE(floatCloseAll(w_test, w_ref, 1.0e-4, 1.0e-4));
+      }
+    };
+    auto runWithOffsets = [&](auto weightTag, const auto& idx) {
+      if (isOffset64b) {
+        run(weightTag, idx, use_offsets ? offsets : lengths);
+      } else {
+        run(weightTag, idx, use_offsets ? offsets_32 : lengths_32);
+      }
+    };
+    auto runWithIndices = [&](auto weightTag) {
+      if (isIndex64b) {
+        runWithOffsets(weightTag, indices);
+      } else {
+        runWithOffsets(weightTag, indices_32);
+      }
+    };
+    if (isWeightFp16) {
+      runWithIndices(float16{});
+    } else {
+      runWithIndices(float{});
+    }
+  }
+}
+
+TEST_P(RowWiseSparseAdagradFusedModeTest, threadsMatchSingleThread) {
+  const auto
+      [isWeightFp16,
+       isIndex64b,
+       isOffset64b,
+       use_offsets,
+       corner_case,
+       use_grad_stride] = GetParam();
+
+  for (auto input : GetInputs_()) {
+    int batch_size = input[0];
+    int num_rows = input[1];
+    int embedding_dim = input[2];
+    int average_len = input[3];
+    int grad_stride = use_grad_stride ? embedding_dim * 2 + 3 : embedding_dim;
+
+    vector<float> w(num_rows * embedding_dim), h(num_rows),
+        g(batch_size * grad_stride);
+    default_random_engine generator;
+    uniform_real_distribution<float> values_gen(0, 2);
+    for (auto* v : {&w, &h, &g}) {
+      for (auto& x : *v) {
+        x = values_gen(generator);
+      }
+    }
+
+    vector<int64_t> lengths, offsets, indices;
+    vector<int32_t> lengths_32, offsets_32, indices_32;
+    vector<float> weights;
+    int lengths_sum = GenerateLengthsIndicesWeights(
+        lengths,
+        lengths_32,
+        offsets,
+        offsets_32,
+        indices,
+        indices_32,
+        weights,
+        batch_size,
+        num_rows,
+        average_len,
+        corner_case);
+    const bool valid = corner_case == NONE || corner_case == EMPTY_INDICES;
+
+    const float epsilon = 1e-5;
+    const float lr = 0.5;
+    auto run = [&](auto weightTag, const auto& idx, const auto& offs) {
+      using WeightType = decltype(weightTag);
+      using IndexType = typename decay_t<decltype(idx)>::value_type;
+      using OffsetType = typename decay_t<decltype(offs)>::value_type;
+      vector<WeightType> w_init(w.size());
+      for (size_t i = 0; i < w.size(); ++i) {
+        if constexpr (is_same_v<WeightType, float16>) {
+          w_init[i] = cpu_float2half_rn(w[i]);
+        } else {
+          w_init[i] = w[i];
+        }
+      }
+
+      for (bool deduplicate_indices : {false, true}) {
+        vector<WeightType> w_ref(w_init);
+        vector<float> h_ref(h);
+        bool success_ref = false;
+        for (int num_threads : {1, 2, 3, 8, 0}) {
+          SCOPED_TRACE(
+              "deduplicate_indices " + to_string(deduplicate_indices) +
+              " num_threads " + to_string(num_threads));
+          vector<WeightType> w_test(w_init);
+          vector<float> h_test(h);
+          auto kernel = GenerateRowWiseSparseAdaGradFused<
+              IndexType,
+              OffsetType,
+              WeightType>(
+              embedding_dim,
+              16 /* prefetch */,
+              use_offsets,
+              false /* use_stochastic_rounding */,
+              use_grad_stride ? grad_stride : -1,
+              deduplicate_indices,
+              num_threads);
+          bool success = kernel(
+              batch_size,
+              lengths_sum,
+              num_rows,
+              w_test.data(),
+              g.data(),
+              h_test.data(),
+              corner_case == EMPTY_INDICES ? nullptr : idx.data(),
+              offs.data(),
+              epsilon,
+              lr);
+          if (num_threads == 1) {
+            success_ref = success;
+            w_ref = w_test;
+            h_ref = h_test;
+            EXPECT_EQ(success, valid);
+            continue;
+          }
+          EXPECT_EQ(success, success_ref);
+          if (valid) {
+            // Each row is updated by one thread in the same order
+            EXPECT_EQ(h_test, h_ref);
+            EXPECT_TRUE(floatCloseAll(w_test, w_ref, 0.0f, 0.0f));
+          } else if (num_threads > 1 || deduplicate_indices) {
+            // Rejected before any update
+            EXPECT_EQ(h_test, h);
+            EXPECT_TRUE(floatCloseAll(w_test, w_init, 0.0f, 0.0f));
+          }
+        }
+      }
+    };
+    auto runWithOffsets = [&](auto weightTag, const auto& idx) {
+      if (isOffset64b) {
+        run(weightTag, idx, use_offsets ? offsets : lengths);
+      } else {
+        run(weightTag, idx, use_offsets ? offsets_32 : lengths_32);
+      }
+    };
+    auto runWithIndices = [&](auto weightTag) {
+      if (isIndex64b) {
+        runWithOffsets(weightTag, indices);
+      } else {
+        runWithOffsets(weightTag, indices_32);
+      }
+    };
+    if (isWeightFp16) {
+      runWithIndices(float16{});
+    } else {
+      runWithIndices(float{});
+    }
+  }
+}
@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <gtest/gtest.h>
+
+#include "bench/BenchUtils.h"
+#include "fbgemm/Fbgemm.h"
+#include "fbgemm/FbgemmSparse.h"
+#include "src/RefImplementations.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+// {M, N, K, B transposed}
+class Sparse24GemmTest
+    : public testing::TestWithParam<tuple<int, int, int, bool>> {};
+
+// k x n weight, or n x k when transposed, with at most 2 non-zeros in each
+// group of 4 consecutive k.
+vector<int8_t> getRandom24Matrix(
+    int k,
+    int n,
+    bool trans,
+    default_random_engine& generator) {
+  uniform_int_distribution<int> v_dist(-128, 127);
+  uniform_int_distribution<int> nnz_dist(0, 2);
+  vector<int8_t> B(k * n, 0);
+  for (int j = 0; j < n; ++j) {
+    for (int g = 0; g < k; g += 4) {
+      int pos[4] = {0, 1, 2, 3};
+      shuffle(pos, pos + 4, generator);
+      const int nnz = nnz_dist(generator);
+      for (int e = 0; e < nnz; ++e) {
+        const int kk = g + pos[e];
+        if (kk < k) {
+          (trans ? B[j * k + kk] : B[kk * n + j]) = v_dist(generator);
+        }
+      }
+    }
+  }
+  return B;
+}
+
+} // namespace
+
+INSTANTIATE_TEST_CASE_P(
+    InstantiationName,
+    Sparse24GemmTest,
+    ::testing::Values(
+        make_tuple(1, 16, 16, false),
+        make_tuple(1, 1000, 512, true),
+        make_tuple(3, 40, 300, false),
+        make_tuple(7, 100, 96, true),
+        make_tuple(16, 33, 61, false),
+        make_tuple(37, 64, 130, true)));
+
+TEST_P(Sparse24GemmTest, int32Output) {
+  const auto [m, n, k, transB] = GetParam();
+  default_random_engine generator;
+  uniform_int_distribution<int> a_dist(0, 255);
+  vector<uint8_t> A(m * k);
+  for (auto& v : A) {
+    v = a_dist(generator);
+  }
+  vector<int8_t> B = getRandom24Matrix(k, n, transB, generator);
+
+  PackBMatrixSparse24 packedB(
+      transB ? matrix_op_t::Transpose : matrix_op_t::NoTranspose,
+      k,
+      n,
+      B.data(),
+      transB ? k : n);
+
+  // unpack always gives k x n
+  vector<int8_t> B_kn(k * n);
+  if (transB) {
+    transpose_matrix(n, k, B.data(), k, B_kn.data(), n);
+  } else {
+    B_kn = B;
+  }
+  vector<int8_t> B_unpacked(k * n);
+  packedB.unpack(B_unpacked.data());
+  ASSERT_EQ(B_unpacked, B_kn);
+
+  vector<int32_t> C_ref(m * n);
+  matmul_u8i8acc32_ref(m, n, k, k, n, n, A.data(), B_kn.data(), C_ref.data());
+
+  vector<int32_t> C(m * n, -1);
+  DoNothing<int32_t, int32_t> doNothingObj{};
+  memCopy<> memcopyObj(doNothingObj);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  fbgemmU8S8Sparse24Gemm(
+      m,
+      A.data(),
+      k,
+      packedB,
+      C.data(),
+      C.data(),
+      n,
+      memcopyObj,
+      fbgemm_get_thread_num(),
+      fbgemm_get_num_threads());
+  EXPECT_EQ(C, C_ref);
+}
+
+TEST_P(Sparse24GemmTest, requantize) {
+  const auto [m, n, k, transB] = GetParam();
+  default_random_engine generator;
+  uniform_int_distribution<int> a_dist(0, 255);
+  vector<uint8_t> A(m * k);
+  for (auto& v : A) {
+    v = a_dist(generator);
+  }
+  vector<int8_t> B = getRandom24Matrix(k, n, transB, generator);
+  vector<int8_t> B_kn(k * n);
+  if (transB) {
+    transpose_matrix(n, k, B.data(), k, B_kn.data(), n);
+  } else {
+    B_kn = B;
+  }
+
+  PackBMatrixSparse24 packedB(
+      transB ? matrix_op_t::Transpose : matrix_op_t::NoTranspose,
+      k,
+      n,
+      B.data(),
+      transB ? k : n);
+
+  const int32_t A_zero_point = 11;
+  const int32_t C_zero_point = 5;
+  vector<int32_t> B_zero_point(n, 0);
+  vector<float> C_multiplier(n);
+  for (auto& v : C_multiplier) {
+    v = 0.001f * (1 + a_dist(generator) % 4);
+  }
+  vector<int32_t> bias(n);
+  for (auto& v : bias) {
+    v = a_dist(generator) - 128;
+  }
+  vector<int32_t> col_offsets(n);
+  col_offsets_with_zero_pt_s8acc32_ref(
+      k, n, n, B_kn.data(), B_zero_point.data(), col_offsets.data(), 1);
+  ASSERT_TRUE(
+      equal(col_offsets.begin(), col_offsets.end(), packedB.colOffsets()));
+
+  vector<int32_t> C_i32_ref(m * n);
+  matmul_u8i8acc32_ref(
+      m, n, k, k, n, n, A.data(), B_kn.data(), C_i32_ref.data());
+  vector<int32_t> row_offsets(m);
+  row_offsets_u8acc32_ref(m, k, k, A.data(), row_offsets.data());
+  vector<uint8_t> C_ref(m * n);
+  requantize_u8acc32_ref(
+      m,
+      n,
+      n,
+      C_i32_ref.data(),
+      C_ref.data(),
+      C_multiplier.data(),
+      C_zero_point,
+      A_zero_point,
+      B_zero_point.data(),
+      row_offsets.data(),
+      col_offsets.data(),
+      bias.data(),
+      1);
+
+  vector<int32_t> C_buffer(m * n);
+  vector<uint8_t> C(m * n);
+  DoNothing<> doNothingObj{};
+  ReQuantizeOutput<false, QuantizationGranularity::OUT_CHANNEL> outputProcObj(
+      doNothingObj,
+      C_multiplier.data(),
+      C_zero_point,
+      A_zero_point,
+      B_zero_point.data(),
+      nullptr, // row offsets are not needed with a zero weight zero point
+      packedB.colOffsets(),
+      bias.data(),
+      n);
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  fbgemmU8S8Sparse24Gemm(
+      m,
+      A.data(),
+      k,
+      packedB,
+      C.data(),
+      C_buffer.data(),
+      n,
+      outputProcObj,
+      fbgemm_get_thread_num(),
+      fbgemm_get_num_threads());
+  EXPECT_EQ(C, C_ref);
+}
+
+TEST(Sparse24GemmPackTest, rejectsDenseGroups) {
+  vector<int8_t> B(8 * 4, 0);
+  // 3 non-zeros in the second group of column 1
+  B[4 * 4 + 1] = 1;
+  B[5 * 4 + 1] = 2;
+  B[7 * 4 + 1] = 3;
+  EXPECT_THROW(
+      PackBMatrixSparse24(matrix_op_t::NoTranspose, 8, 4, B.data(), 4),
+      std::runtime_error);
+  B[5 * 4 + 1] = 0;
+  EXPECT_NO_THROW(
+      PackBMatrixSparse24(matrix_op_t::NoTranspose, 8, 4, B.data(), 4));
+}
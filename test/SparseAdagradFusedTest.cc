@@ -0,0 +1,296 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "./EmbeddingSpMDMTestUtils.h"
+#include "TestUtils.h"
+#include "fbgemm/FbgemmConvert.h"
+#include "fbgemm/FbgemmEmbedding.h"
+#include "src/RefImplementations.h"
+
+using namespace std;
+using namespace fbgemm;
+
+static vector<vector<int>> GetInputs_() {
+  vector<vector<int>> input_dims = {
+      // batch size, number of rows of table, emb dim , avg length
+      {1, 8, 8, 4},
+      {2, 8, 16, 4},
+      {10, 4000, 32, 100},
+      {10, 4000, 64, 100},
+      {4, 400, 256, 10},
+      {10, 40, 1, 10},
+      {10, 40, 4, 10},
+      {10, 40, 85, 10},
+      {10, 40, 163, 10},
+  };
+  return input_dims;
+}
+
+namespace {
+
+// {weights fp16, 64 bit indices, 64 bit offsets, prefetch, use_offsets,
+// corner case, grad_stride != block_size}
+class SparseAdagradFusedTest : public testing::TestWithParam<tuple<
+                                   bool,
+                                   bool,
+                                   bool,
+                                   int,
+                                   bool,
+                                   EmbeddingSpMDMCornerCase,
+                                   bool>> {};
+
+struct Inputs {
+  vector<int64_t> lengths, offsets, indices;
+  vector<int32_t> lengths_32, offsets_32, indices_32;
+  int lengths_sum;
+};
+
+// Runs the kernel and the reference on the same inputs with the index and
+// offset types given by the indices and offsets_or_lengths vectors.
+template <typename DataType, typename IndexType, typename OffsetType>
+void runAndCompare(
+    int block_size,
+    int batch_size,
+    int num_rows,
+    int lengths_sum,
+    int prefetch,
+    bool use_offsets,
+    int grad_stride,
+    const vector<IndexType>& indices,
+    const vector<OffsetType>& offsets_or_lengths,
+    bool empty_indices,
+    const vector<float>& g,
+    vector<float> w_init,
+    const vector<float>& h_init) {
+  vector<DataType> w(w_init.size()), w_ref(w_init.size());
+  for (size_t i = 0; i < w_init.size(); ++i) {
+    if constexpr (is_same_v<DataType, float16>) {
+      w[i] = w_ref[i] = cpu_float2half_rn(w_init[i]);
+    } else {
+      w[i] = w_ref[i] = w_init[i];
+    }
+  }
+  vector<float> h(h_init), h_ref(h_init);
+
+  const float epsilon = 1e-5;
+  const float lr = 0.5;
+  bool success_ref = sparse_adagrad_fused_ref(
+      block_size,
+      batch_size,
+      lengths_sum,
+      num_rows,
+      w_ref.data(),
+      g.data(),
+      h_ref.data(),
+      empty_indices ? nullptr : indices.data(),
+      offsets_or_lengths.data(),
+      epsilon,
+      lr,
+      use_offsets,
+      grad_stride);
+
+  auto kernel = GenerateSparseAdaGradFused<IndexType, OffsetType, DataType>(
+      block_size, prefetch, use_offsets, grad_stride);
+  bool success = kernel(
+      batch_size,
+      lengths_sum,
+      num_rows,
+      w.data(),
+      g.data(),
+      h.data(),
+      empty_indices ? nullptr : indices.data(),
+      offsets_or_lengths.data(),
+      epsilon,
+      lr);
+
+  EXPECT_EQ(success, success_ref)
+      << "return vals differ, reference is: " << success_ref
+      << " ,fbgemm is: " << success;
+  if (success) {
+    EXPECT_TRUE(floatCloseAll(h, h_ref, 1.0e-6, 1.0e-6));
+    if constexpr (is_same_v<DataType, float16>) {
+      EXPECT_TRUE(floatCloseAll(w, w_ref, 1.0e-3, 1.0e-3));
+    } else {
+      EXPECT_TRUE(floatCloseAll(w, w_ref, 1.0e-6, 1.0e-6));
+    }
+  }
+}
+
+} // namespace
+
+INSTANTIATE_TEST_CASE_P(
+    InstantiationName,
+    SparseAdagradFusedTest,
+    ::testing::Combine(
+        ::testing::Bool(), // isWeightFp16
+        ::testing::Bool(), // isIndex64b
+        ::testing::Bool(), // isOffset64b
+        ::testing::Values(0, 16, 1000000), // prefetch
+        ::testing::Bool(), // use_offsets
+        ::testing::Values(
+            NONE,
+            EMPTY_INDICES,
+            OUT_OF_BOUND_INDICES,
+            UNMATCHED_NUM_INDICES_AND_LENGTHS_SUM),
+        ::testing::Bool())); // grad_stride != block_size
+
+TEST_P(SparseAdagradFusedTest, matchesReference) {
+  const auto
+      [isWeightFp16,
+       isIndex64b,
+       isOffset64b,
+       prefetch,
+       use_offsets,
+       corner_case,
+       use_grad_stride] = GetParam();
+
+  for (auto input : GetInputs_()) {
+    int batch_size = input[0];
+    int num_rows = input[1];
+    int embedding_dim = input[2];
+    int average_len = input[3];
+    int grad_stride = use_grad_stride ? embedding_dim * 2 + 3 : -1;
+
+    vector<float> w(num_rows * embedding_dim), h(num_rows * embedding_dim),
+        g(batch_size * (use_grad_stride ? grad_stride : embedding_dim));
+    default_random_engine generator;
+    uniform_real_distribution<float> values_gen(0, 2);
+    for (auto& v : w) {
+      v = values_gen(generator);
+    }
+    for (auto& v : h) {
+      v = values_gen(generator);
+    }
+    for (auto& v : g) {
+      v = values_gen(generator);
+    }
+
+    Inputs in;
+    vector<float> weights;
+    in.lengths_sum = GenerateLengthsIndicesWeights(
+        in.lengths,
+        in.lengths_32,
+        in.offsets,
+        in.offsets_32,
+        in.indices,
+        in.indices_32,
+        weights,
+        batch_size,
+        num_rows,
+        average_len,
+        corner_case);
+    const bool empty_indices = corner_case == EMPTY_INDICES;
+
+    auto run = [&](auto dataTag, const auto& indices, const auto& offsets) {
+      using DataType = decltype(dataTag);
+      using IndexType = typename decay_t<decltype(indices)>::value_type;
+      using OffsetType = typename decay_t<decltype(offsets)>::value_type;
+      runAndCompare<DataType, IndexType, OffsetType>(
+          embedding_dim,
+          batch_size,
+          num_rows,
+          in.lengths_sum,
+          prefetch,
+          use_offsets,
+          grad_stride,
+          indices,
+          offsets,
+          empty_indices,
+          g,
+          w,
+          h);
+    };
+    auto runWithOffsets = [&](auto dataTag, const auto& indices) {
+      if (isOffset64b) {
+        run(dataTag, indices, use_offsets ? in.offsets : in.lengths);
+      } else {
+        run(dataTag, indices, use_offsets ? in.offsets_32 : in.lengths_32);
+      }
+    };
+    auto runWithIndices = [&](auto dataTag) {
+      if (isIndex64b) {
+        runWithOffsets(dataTag, in.indices);
+      } else {
+        runWithOffsets(dataTag, in.indices_32);
+      }
+    };
+    if (isWeightFp16) {
+      runWithIndices(float16{});
+    } else {
+      runWithIndices(float{});
+    }
+  }
+}
+
+TEST(SparseAdagradFusedSemanticsTest, matchesExpandedGradients) {
+  // The fused update is SparseAdaGrad on the gradients expanded per index
+  constexpr int block_size = 19;
+  constexpr int num_rows = 10;
+  const vector<int32_t> lengths = {3, 0, 2, 4};
+  // Duplicated indices within and across bags
+  const vector<int64_t> indices = {1, 7, 1, 0, 9, 7, 7, 3, 2};
+  const int batch_size = lengths.size();
+  const int index_size = indices.size();
+
+  default_random_engine generator;
+  uniform_real_distribution<float> values_gen(0, 2);
+  vector<float> w(num_rows * block_size), h(num_rows * block_size),
+      g(batch_size * block_size);
+  for (auto* v : {&w, &h, &g}) {
+    for (auto& x : *v) {
+      x = values_gen(generator);
+    }
+  }
+  vector<float> w_ref(w), h_ref(h);
+
+  vector<float> g_expanded;
+  for (int m = 0; m < batch_size; ++m) {
+    for (int i = 0; i < lengths[m]; ++i) {
+      g_expanded.insert(
+          g_expanded.end(),
+          g.begin() + m * block_size,
+          g.begin() + (m + 1) * block_size);
+    }
+  }
+  const float epsilon = 1e-5;
+  const float lr = 0.5;
+  EXPECT_EQ(
+      sparse_adagrad_ref(
+          index_size,
+          block_size,
+          w.size(),
+          w_ref.data(),
+          g_expanded.data(),
+          h_ref.data(),
+          indices.data(),
+          epsilon,
+          lr),
+      index_size);
+
+  auto kernel = GenerateSparseAdaGradFused<int64_t, int32_t>(
+      block_size, 16, false /* use_offsets */);
+  EXPECT_TRUE(kernel(
+      batch_size,
+      index_size,
+      num_rows,
+      w.data(),
+      g.data(),
+      h.data(),
+      indices.data(),
+      lengths.data(),
+      epsilon,
+      lr));
+  EXPECT_TRUE(floatCloseAll(h, h_ref, 1.0e-6, 1.0e-6));
+  EXPECT_TRUE(floatCloseAll(w, w_ref, 1.0e-6, 1.0e-6));
+}
@@ -7,6 +7,7 @@
  */
 
 #include <algorithm>
+#include <numeric>
 #include <ostream>
 #include <random>
 #include <stdexcept>
@@ -15,6 +16,7 @@
 
 #include "TestUtils.h"
 #include "fbgemm/Fbgemm.h"
+#include "fbgemm/FbgemmConvert.h"
 #include "src/RefImplementations.h"
 
 using namespace std;
@@ -328,3 +330,107 @@ TEST_P(SparseAdagradTest, rowwiseTest_two_stages) {
     EXPECT_TRUE(floatCloseAll(w, w_ref, DEFAULT_TOL, DEFAULT_TOL));
   }
 }
+
+namespace {
+// {bfloat16, rowwise, stochastic rounding, use weight decay}
+class SparseAdagrad16BitTest
+    : public testing::TestWithParam<tuple<bool, bool, bool, bool>> {};
+} // namespace
+
+INSTANTIATE_TEST_CASE_P(
+    InstantiationName,
+    SparseAdagrad16BitTest,
+    ::testing::Combine(
+        ::testing::Bool(), // bfloat16 weights
+        ::testing::Bool(), // rowwise
+        ::testing::Bool(), // stochastic rounding
+        ::testing::Bool())); // use weight decay
+
+TEST_P(SparseAdagrad16BitTest, matchesReference) {
+  const auto [is_bf16, rowwise, use_stochastic_rounding, use_weight_decay] =
+      GetParam();
+  auto toFloat = [is_bf16 = is_bf16](const vector<uint16_t>& src) {
+    vector<float> dst(src.size());
+    if (is_bf16) {
+      Bfloat16ToFloat_ref(src.data(), dst.data(), src.size());
+    } else {
+      Float16ToFloat_ref(src.data(), dst.data(), src.size());
+    }
+    return dst;
+  };
+
+  for (auto input : GetInputs_()) {
+    int num_rows = input[0];
+    int block_size = input[1];
+    int param_size = num_rows * block_size;
+
+    default_random_engine generator;
+    uniform_real_distribution<float> values_gen(0, 10);
+    vector<float> g(param_size), h(rowwise ? num_rows : param_size),
+        w_fp32(param_size);
+    for (auto* v : {&g, &h, &w_fp32}) {
+      for (auto& x : *v) {
+        x = values_gen(generator);
+      }
+    }
+    vector<uint16_t> w(param_size);
+    if (is_bf16) {
+      FloatToBfloat16_ref(w_fp32.data(), w.data(), param_size);
+    } else {
+      FloatToFloat16_ref(w_fp32.data(), w.data(), param_size);
+    }
+    vector<uint16_t> w_ref(w);
+    vector<float> h_ref(h);
+
+    // Unique indices so that the rounding errors do not accumulate
+    vector<int64_t> indices(num_rows);
+    iota(indices.begin(), indices.end(), 0);
+    shuffle(indices.begin(), indices.end(), generator);
+    const float epsilon = 1e-5;
+    const float lr = 0.5;
+    const float weight_decay = use_weight_decay ? 0.1f : 0.0f;
+
+    int ret_ref = sparse_adagrad_16bit_ref(
+        num_rows,
+        block_size,
+        param_size,
+        w_ref.data(),
+        g.data(),
+        h_ref.data(),
+        indices.data(),
+        epsilon,
+        lr,
+        rowwise,
+        use_stochastic_rounding,
+        is_bf16,
+        weight_decay);
+
+    auto fn_fbgemm = GenerateSparseAdaGrad<int64_t, uint16_t>(
+        block_size,
+        rowwise,
+        16 /* prefetch */,
+        use_weight_decay,
+        use_stochastic_rounding,
+        is_bf16);
+    int ret_fbgemm = fn_fbgemm(
+        num_rows,
+        param_size,
+        w.data(),
+        g.data(),
+        h.data(),
+        indices.data(),
+        epsilon,
+        lr,
+        weight_decay,
+        nullptr,
+        0);
+
+    EXPECT_EQ(ret_fbgemm, ret_ref);
+    EXPECT_TRUE(floatCloseAll(h, h_ref, 1.0e-3, 1.0e-3));
+    // The random bits of stochastic rounding differ, and differences in the
+    // last bit of the fp32 results can round to different 16 bit values, so
+    // compare up to one ulp
+    const float ulp = is_bf16 ? 1.0f / 128 : 1.0f / 1024;
+    EXPECT_TRUE(floatCloseAll(toFloat(w), toFloat(w_ref), 0, 1.01f * ulp));
+  }
+}
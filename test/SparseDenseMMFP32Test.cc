@@ -104,3 +104,50 @@ TEST_F(SparseDenseTest, fp32) {
     }
   } // for each shape
 }
+
+TEST_F(SparseDenseTest, fp32MultiThreaded) {
+  // {M, N, K, fnz} of the sparse M x K times dense K x N
+  for (auto s : vector<tuple<int, int, int, float>>{
+           make_tuple(300, 1, 64, 0.3f),
+           make_tuple(7, 100, 50, 0.2f),
+           make_tuple(200, 130, 256, 0.1f),
+           make_tuple(1000, 33, 24, 0.05f)}) {
+    int m, n, k;
+    float fnz;
+    tie(m, n, k, fnz) = s;
+    auto aData = getRandomSparseVector(m * k, fnz);
+    auto bData = getRandomSparseVector(k * n);
+    unique_ptr<CSRMatrix<float>> csr = fbgemmDenseToCSR(m, k, aData.data());
+
+    auto run = [&](int num_threads, aligned_vector<float>& cData) {
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads)
+#endif
+      for (int t = 0; t < num_threads; ++t) {
+        SparseDenseMM(
+            m,
+            n,
+            csr->rowPtr.data(),
+            csr->colIdx.data(),
+            csr->values.data(),
+            bData.data(),
+            n,
+            cData.data(),
+            n,
+            false /* accum */,
+            t,
+            num_threads);
+      }
+    };
+
+    aligned_vector<float> cDataRef(m * n);
+    run(1, cDataRef);
+    for (int num_threads : {2, 3, 8, 13}) {
+      aligned_vector<float> cData(m * n, -1.0f);
+      run(num_threads, cData);
+      EXPECT_EQ(cDataRef, cData)
+          << "Results differ for " << num_threads << " threads, m " << m
+          << " n " << n << " k " << k;
+    }
+  }
+}
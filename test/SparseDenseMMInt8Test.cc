@@ -6,6 +6,8 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <algorithm>
+#include <array>
 #include <gtest/gtest.h>
 #include <iostream>
 
@@ -185,3 +187,149 @@ TEST_P(SPMMInt8Test, spInt8) {
         << ctDataIntrin_u8[i] << " at " << i;
   }
 }
+
+/**
+ * Test that non-default column and row tile sizes produce the same results
+ * as the default tiling
+ */
+TEST(SPMMInt8TilingTest, tileSizes) {
+  for (auto shape : vector<array<int, 3>>{
+           {7, 13, 24}, {20, 32, 4001}, {64, 70, 300}, {65, 5, 1000}}) {
+    int M = shape[0];
+    int N = shape[1];
+    int K = shape[2];
+    SCOPED_TRACE(
+        "M " + to_string(M) + " N " + to_string(N) + " K " + to_string(K));
+
+    auto aData = getRandomBlockSparseMatrix<uint8_t>(
+        M, K, 1.0, 1 /* rowBlockSize */, 1 /* colBlockSize */);
+    auto bData = getRandomBlockSparseMatrix<int8_t>(K, N, 0.2f);
+
+    aligned_vector<uint8_t> atData(K * M);
+    aligned_vector<int8_t> btData(N * K);
+    transpose_matrix(M, K, aData.data(), K, atData.data(), M);
+    transpose_matrix(K, N, bData.data(), N, btData.data(), K);
+
+    aligned_vector<int32_t> weight_zero_point(N, 0);
+    aligned_vector<float> act_times_w_scale(N);
+    randFill<float>(act_times_w_scale, -8.0f, 8.0f);
+
+    auto run = [&](const unique_ptr<BCSRMatrix<>>& bcsr,
+                   aligned_vector<uint8_t>& ctData_u8) {
+      aligned_vector<int32_t> ctData_i32(N * M);
+      trRequantizationParams_t reqParams = {
+          2 /* act_zero_point */,
+          weight_zero_point.data(),
+          2 /* C_zero_point */,
+          128.0f /* C_scale */,
+          bcsr->row_offsets.data(),
+          nullptr,
+          nullptr,
+          act_times_w_scale.data()};
+      fbgemmSparseDenseInt8MM<false, QuantizationGranularity::OUT_CHANNEL>(
+          M,
+          bcsr,
+          atData.data(),
+          M,
+          ctData_i32.data(),
+          ctData_u8.data(),
+          M,
+          reqParams);
+    };
+
+    aligned_vector<uint8_t> ctDataRef_u8(N * M);
+    run(fbgemmDenseToBCSR(N, K, btData.data()), ctDataRef_u8);
+
+    for (int colTile : {4, 12, 64, 1000}) {
+      unique_ptr<BCSRMatrix<>> bcsr =
+          fbgemmDenseToBCSR(N, K, btData.data(), K, colTile);
+      EXPECT_EQ(bcsr->colTile, colTile);
+
+      vector<int8_t> btUnpacked(N * K);
+      bcsr->unpack(btUnpacked.data());
+      EXPECT_TRUE(equal(btData.begin(), btData.end(), btUnpacked.begin()))
+          << "unpack differs for colTile " << colTile;
+
+      for (int rowTile : {0, 1, 3, 16}) {
+        bcsr->rowTile = rowTile;
+        aligned_vector<uint8_t> ctData_u8(N * M, 11);
+        run(bcsr, ctData_u8);
+        EXPECT_EQ(ctDataRef_u8, ctData_u8)
+            << "Results differ for colTile " << colTile << " rowTile "
+            << rowTile;
+      }
+    }
+  }
+}
+
+/**
+ * Test that splitting the work across threads produces the same results as a
+ * single thread
+ */
+TEST(SPMMInt8ThreadingTest, multiThreaded) {
+  for (auto shape : vector<array<int, 3>>{
+           {1, 300, 64}, {7, 1000, 24}, {100, 200, 500}, {130, 37, 4001}}) {
+    int M = shape[0];
+    int N = shape[1];
+    int K = shape[2];
+    SCOPED_TRACE(
+        "M " + to_string(M) + " N " + to_string(N) + " K " + to_string(K));
+
+    auto aData = getRandomBlockSparseMatrix<uint8_t>(
+        M, K, 1.0, 1 /* rowBlockSize */, 1 /* colBlockSize */);
+    auto bData = getRandomBlockSparseMatrix<int8_t>(K, N, 0.2f);
+
+    aligned_vector<uint8_t> atData(K * M);
+    aligned_vector<int8_t> btData(N * K);
+    transpose_matrix(M, K, aData.data(), K, atData.data(), M);
+    transpose_matrix(K, N, bData.data(), N, btData.data(), K);
+
+    unique_ptr<BCSRMatrix<>> bcsr = fbgemmDenseToBCSR(N, K, btData.data());
+
+    aligned_vector<int32_t> weight_zero_point(N, 0);
+    aligned_vector<float> act_times_w_scale(N);
+    randFill<float>(act_times_w_scale, -8.0f, 8.0f);
+    aligned_vector<float> bias(N);
+    randFill<float>(bias, -64.0f, 64.0f);
+    trRequantizationParams_t reqParams = {
+        2 /* act_zero_point */,
+        weight_zero_point.data(),
+        2 /* C_zero_point */,
+        128.0f /* C_scale */,
+        bcsr->row_offsets.data(),
+        nullptr,
+        bias.data(),
+        act_times_w_scale.data()};
+
+    auto run = [&](int num_threads, aligned_vector<uint8_t>& ctData_u8) {
+      aligned_vector<int32_t> ctData_i32(N * M);
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(num_threads)
+#endif
+      for (int t = 0; t < num_threads; ++t) {
+        fbgemmSparseDenseInt8MM<true, QuantizationGranularity::OUT_CHANNEL>(
+            M,
+            bcsr,
+            atData.data(),
+            M,
+            ctData_i32.data(),
+            ctData_u8.data(),
+            M,
+            reqParams,
+            false /* accum */,
+            t,
+            num_threads);
+      }
+    };
+
+    aligned_vector<uint8_t> ctDataRef_u8(N * M);
+    run(1, ctDataRef_u8);
+
+    for (int num_threads : {2, 3, 8, 13}) {
+      aligned_vector<uint8_t> ctData_u8(N * M, 11);
+      run(num_threads, ctData_u8);
+      EXPECT_EQ(ctDataRef_u8, ctData_u8)
+          << "Results differ for " << num_threads << " threads";
+    }
+  }
+}
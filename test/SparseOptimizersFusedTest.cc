@@ -0,0 +1,363 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "./EmbeddingSpMDMTestUtils.h"
+#include "TestUtils.h"
+#include "fbgemm/FbgemmConvert.h"
+#include "fbgemm/FbgemmEmbedding.h"
+#include "src/RefImplementations.h"
+
+using namespace std;
+using namespace fbgemm;
+
+static vector<vector<int>> GetInputs_() {
+  vector<vector<int>> input_dims = {
+      // batch size, number of rows of table, emb dim , avg length
+      {1, 8, 8, 4},
+      {2, 8, 16, 4},
+      {10, 4000, 32, 100},
+      {4, 400, 256, 10},
+      {10, 40, 1, 10},
+      {10, 40, 4, 10},
+      {10, 40, 85, 10},
+      {10, 40, 163, 10},
+  };
+  return input_dims;
+}
+
+namespace {
+
+enum class Optimizer { ADAM, ROWWISE_ADAM, LAMB, ROWWISE_LAMB, LARS_SGD };
+
+// {optimizer, weights fp16, 64 bit indices, 64 bit offsets, prefetch,
+// use_offsets, corner case, grad_stride != block_size}
+class SparseOptimizersFusedTest : public testing::TestWithParam<tuple<
+                                      Optimizer,
+                                      bool,
+                                      bool,
+                                      bool,
+                                      int,
+                                      bool,
+                                      EmbeddingSpMDMCornerCase,
+                                      bool>> {};
+
+struct Inputs {
+  vector<int64_t> lengths, offsets, indices;
+  vector<int32_t> lengths_32, offsets_32, indices_32;
+  int lengths_sum;
+};
+
+// Runs the kernel and the reference on the same inputs with the index and
+// offset types given by the indices and offsets_or_lengths vectors.
+template <typename DataType, typename IndexType, typename OffsetType>
+void runAndCompare(
+    Optimizer optimizer,
+    int block_size,
+    int batch_size,
+    int num_rows,
+    int lengths_sum,
+    int prefetch,
+    bool use_offsets,
+    int grad_stride,
+    const vector<IndexType>& indices,
+    const vector<OffsetType>& offsets_or_lengths,
+    bool empty_indices,
+    const vector<float>& g,
+    const vector<float>& w_init,
+    const vector<float>& m1_init,
+    const vector<float>& m2_init) {
+  vector<DataType> w(w_init.size()), w_ref(w_init.size());
+  for (size_t i = 0; i < w_init.size(); ++i) {
+    if constexpr (is_same_v<DataType, float16>) {
+      w[i] = w_ref[i] = cpu_float2half_rn(w_init[i]);
+    } else {
+      w[i] = w_ref[i] = w_init[i];
+    }
+  }
+  const bool rowwise = optimizer == Optimizer::ROWWISE_ADAM ||
+      optimizer == Optimizer::ROWWISE_LAMB;
+  vector<float> m1(m1_init), m1_ref(m1_init);
+  vector<float> m2(rowwise ? num_rows : m2_init.size());
+  copy(m2_init.begin(), m2_init.begin() + m2.size(), m2.begin());
+  vector<float> m2_ref(m2);
+  const IndexType* indices_ptr = empty_indices ? nullptr : indices.data();
+
+  const float learning_rate = 0.01;
+  const float weight_decay = 0.01;
+  bool success, success_ref;
+  if (optimizer == Optimizer::LARS_SGD) {
+    const float eta = 0.001;
+    const float momentum = 0.9;
+    success_ref = sparse_lars_sgd_fused_ref(
+        block_size,
+        batch_size,
+        lengths_sum,
+        num_rows,
+        w_ref.data(),
+        g.data(),
+        m1_ref.data(),
+        indices_ptr,
+        offsets_or_lengths.data(),
+        learning_rate,
+        eta,
+        momentum,
+        weight_decay,
+        use_offsets,
+        grad_stride);
+    auto kernel = GenerateSparseLarsSGDFused<IndexType, OffsetType, DataType>(
+        block_size, prefetch, use_offsets, grad_stride);
+    success = kernel(
+        batch_size,
+        lengths_sum,
+        num_rows,
+        w.data(),
+        g.data(),
+        m1.data(),
+        indices_ptr,
+        offsets_or_lengths.data(),
+        learning_rate,
+        eta,
+        momentum,
+        weight_decay);
+  } else {
+    const bool lamb =
+        optimizer == Optimizer::LAMB || optimizer == Optimizer::ROWWISE_LAMB;
+    const float eps = 1e-8;
+    const float beta1 = 0.9;
+    const float beta2 = 0.999;
+    const int64_t iter = 3;
+    success_ref = sparse_adam_fused_ref(
+        lamb,
+        rowwise,
+        block_size,
+        batch_size,
+        lengths_sum,
+        num_rows,
+        w_ref.data(),
+        g.data(),
+        m1_ref.data(),
+        m2_ref.data(),
+        indices_ptr,
+        offsets_or_lengths.data(),
+        learning_rate,
+        eps,
+        beta1,
+        beta2,
+        weight_decay,
+        iter,
+        use_offsets,
+        grad_stride);
+    auto generate = lamb
+        ? GenerateSparseLambFused<IndexType, OffsetType, DataType>
+        : GenerateSparseAdamFused<IndexType, OffsetType, DataType>;
+    auto kernel =
+        generate(block_size, rowwise, prefetch, use_offsets, grad_stride);
+    success = kernel(
+        batch_size,
+        lengths_sum,
+        num_rows,
+        w.data(),
+        g.data(),
+        m1.data(),
+        m2.data(),
+        indices_ptr,
+        offsets_or_lengths.data(),
+        learning_rate,
+        eps,
+        beta1,
+        beta2,
+        weight_decay,
+        iter);
+  }
+
+  EXPECT_EQ(success, success_ref)
+      << "return vals differ, reference is: " << success_ref
+      << " ,fbgemm is: " << success;
+  if (success) {
+    EXPECT_TRUE(floatCloseAll(m1, m1_ref, 1.0e-5, 1.0e-5));
+    EXPECT_TRUE(floatCloseAll(m2, m2_ref, 1.0e-5, 1.0e-5));
+    if constexpr (is_same_v<DataType, float16>) {
+      EXPECT_TRUE(floatCloseAll(w, w_ref, 1.0e-3, 1.0e-3));
+    } else {
+      EXPECT_TRUE(floatCloseAll(w, w_ref, 1.0e-5, 1.0e-5));
+    }
+  }
+}
+
+} // namespace
+
+INSTANTIATE_TEST_CASE_P(
+    InstantiationName,
+    SparseOptimizersFusedTest,
+    ::testing::Combine(
+        ::testing::Values(
+            Optimizer::ADAM,
+            Optimizer::ROWWISE_ADAM,
+            Optimizer::LAMB,
+            Optimizer::ROWWISE_LAMB,
+            Optimizer::LARS_SGD),
+        ::testing::Bool(), // isWeightFp16
+        ::testing::Bool(), // isIndex64b
+        ::testing::Bool(), // isOffset64b
+        ::testing::Values(0, 16), // prefetch
+        ::testing::Bool(), // use_offsets
+        ::testing::Values(
+            NONE,
+            EMPTY_INDICES,
+            OUT_OF_BOUND_INDICES,
+            UNMATCHED_NUM_INDICES_AND_LENGTHS_SUM),
+        ::testing::Bool())); // grad_stride != block_size
+
+TEST_P(SparseOptimizersFusedTest, matchesReference) {
+  const auto
+      [optimizer,
+       isWeightFp16,
+       isIndex64b,
+       isOffset64b,
+       prefetch,
+       use_offsets,
+       corner_case,
+       use_grad_stride] = GetParam();
+
+  for (auto input : GetInputs_()) {
+    int batch_size = input[0];
+    int num_rows = input[1];
+    int embedding_dim = input[2];
+    int average_len = input[3];
+    int grad_stride = use_grad_stride ? embedding_dim * 2 + 3 : -1;
+
+    vector<float> w(num_rows * embedding_dim), m1(num_rows * embedding_dim),
+        m2(num_rows * embedding_dim),
+        g(batch_size * (use_grad_stride ? grad_stride : embedding_dim));
+    default_random_engine generator;
+    uniform_real_distribution<float> values_gen(-1, 1);
+    for (auto* v : {&w, &m1, &g}) {
+      for (auto& x : *v) {
+        x = values_gen(generator);
+      }
+    }
+    // Second moments are non-negative
+    uniform_real_distribution<float> m2_gen(0, 1);
+    for (auto& x : m2) {
+      x = m2_gen(generator);
+    }
+    // Zero rows exercise the zero norm cases of LAMB and LARS
+    fill(w.begin(), w.begin() + embedding_dim, 0.0f);
+
+    Inputs in;
+    vector<float> weights;
+    in.lengths_sum = GenerateLengthsIndicesWeights(
+        in.lengths,
+        in.lengths_32,
+        in.offsets,
+        in.offsets_32,
+        in.indices,
+        in.indices_32,
+        weights,
+        batch_size,
+        num_rows,
+        average_len,
+        corner_case);
+    const bool empty_indices = corner_case == EMPTY_INDICES;
+
+    auto run = [&](auto dataTag, const auto& indices, const auto& offsets) {
+      using DataType = decltype(dataTag);
+      using IndexType = typename decay_t<decltype(indices)>::value_type;
+      using OffsetType = typename decay_t<decltype(offsets)>::value_type;
+      runAndCompare<DataType, IndexType, OffsetType>(
+          optimizer,
+          embedding_dim,
+          batch_size,
+          num_rows,
+          in.lengths_sum,
+          prefetch,
+          use_offsets,
+          grad_stride,
+          indices,
+          offsets,
+          empty_indices,
+          g,
+          w,
+          m1,
+          m2);
+    };
+    auto runWithOffsets = [&](auto dataTag, const auto& indices) {
+      if (isOffset64b) {
+        run(dataTag, indices, use_offsets ? in.offsets : in.lengths);
+      } else {
+        run(dataTag, indices, use_offsets ? in.offsets_32 : in.lengths_32);
+      }
+    };
+    auto runWithIndices = [&](auto dataTag) {
+      if (isIndex64b) {
+        runWithOffsets(dataTag, in.indices);
+      } else {
+        runWithOffsets(dataTag, in.indices_32);
+      }
+    };
+    if (isWeightFp16) {
+      runWithIndices(float16{});
+    } else {
+      runWithIndices(float{});
+    }
+  }
+}
+
+TEST(SparseAdamFusedSemanticsTest, firstStepIsSignOfGradient) {
+  // At iter 1 without weight decay, the Adam step of every parameter is
+  // learning_rate * g / (|g| + eps)
+  constexpr int block_size = 11;
+  constexpr int num_rows = 3;
+  const vector<int32_t> offsets = {0, 1, 2};
+  const vector<int32_t> indices = {0, 2};
+  default_random_engine generator;
+  uniform_real_distribution<float> values_gen(-1, 1);
+  vector<float> w(num_rows * block_size), g(2 * block_size);
+  for (auto* v : {&w, &g}) {
+    for (auto& x : *v) {
+      x = values_gen(generator);
+    }
+  }
+  vector<float> w_init(w), m1(w.size(), 0.0f), m2(w.size(), 0.0f);
+
+  const float learning_rate = 0.1;
+  auto kernel = GenerateSparseAdamFused<int32_t>(block_size);
+  EXPECT_TRUE(kernel(
+      2,
+      indices.size(),
+      num_rows,
+      w.data(),
+      g.data(),
+      m1.data(),
+      m2.data(),
+      indices.data(),
+      offsets.data(),
+      learning_rate,
+      0.0f /* eps */,
+      0.9f,
+      0.999f,
+      0.0f /* weight_decay */,
+      1));
+  for (int m = 0; m < 2; ++m) {
+    for (int j = 0; j < block_size; ++j) {
+      const int k = indices[m] * block_size + j;
+      const float g_mj = g[m * block_size + j];
+      const float step = g_mj > 0 ? learning_rate : -learning_rate;
+      EXPECT_NEAR(w[k], w_init[k] - step, 1e-5);
+    }
+  }
+  for (int j = 0; j < block_size; ++j) {
+    EXPECT_EQ(w[block_size + j], w_init[block_size + j]);
+  }
+}
@@ -63,3 +63,104 @@ TEST_P(packUnpackTest, sparseUnpackTest) {
     }
   }
 }
+
+namespace {
+
+void expectSamePacking(const BCSRMatrix<>& a, const BCSRMatrix<>& b) {
+  EXPECT_EQ(a.rowBPtr, b.rowBPtr);
+  EXPECT_EQ(a.colBIdx, b.colBIdx);
+  EXPECT_EQ(a.values, b.values);
+  EXPECT_EQ(a.row_offsets, b.row_offsets);
+}
+
+} // namespace
+
+TEST_P(packUnpackTest, parallelPackTest) {
+  int N, K;
+  float fnz;
+  tie(N, K, fnz) = GetParam();
+
+  auto wData = getRandomBlockSparseMatrix<int8_t>(N, K, fnz, 1, 4);
+  unique_ptr<BCSRMatrix<>> bcsr = fbgemmDenseToBCSR(N, K, wData.data());
+  for (int num_threads : {2, 3, 8, 0}) {
+    SCOPED_TRACE("num_threads " + to_string(num_threads));
+    unique_ptr<BCSRMatrix<>> bcsrParallel = fbgemmDenseToBCSR(
+        N, K, wData.data(), K, BCSRMatrix<>::COLTILE, 0, num_threads);
+    expectSamePacking(*bcsr, *bcsrParallel);
+  }
+}
+
+TEST(repackTest, matchesPack) {
+  constexpr int N = 37;
+  constexpr int K = 4100; // two column tiles
+  auto wData = getRandomBlockSparseMatrix<int8_t>(N, K, 0.1f, 1, 4);
+  BCSRMatrix<> bcsr(N, K);
+  bcsr.pack(wData.data());
+
+  // Same blocks with new values, which is rewritten in place
+  for (int k = 0; k < K; ++k) {
+    if (wData[3 * K + k] != 0) {
+      wData[3 * K + k] = wData[3 * K + k] == 1 ? 2 : 1;
+    }
+  }
+  bcsr.repack(wData.data(), K, {3});
+  BCSRMatrix<> ref(N, K);
+  ref.pack(wData.data());
+  expectSamePacking(ref, bcsr);
+
+  // New blocks in one row, a row cleared and a dense row
+  for (int k = 1; k < K; k += 9) {
+    wData[10 * K + k] = -3;
+  }
+  fill(wData.begin() + 20 * K, wData.begin() + 21 * K, 0);
+  fill(wData.begin() + 36 * K, wData.begin() + 37 * K, 5);
+  for (int num_threads : {1, 3}) {
+    SCOPED_TRACE("num_threads " + to_string(num_threads));
+    BCSRMatrix<> updated(bcsr);
+    updated.repack(wData.data(), K, {36, 10, 20, 10}, num_threads);
+    BCSRMatrix<> expected(N, K);
+    expected.pack(wData.data());
+    expectSamePacking(expected, updated);
+  }
+}
+
+TEST(denseToCSRTest, parallelPackTest) {
+  for (int C : {1, 7, 8, 31, 32, 33, 100}) {
+    SCOPED_TRACE("C " + to_string(C));
+    constexpr int R = 19;
+    const int ld = C + 3;
+    aligned_vector<float> fData = getRandomSparseVector(R * ld, 0.3f);
+    // -0.0f is a zero
+    fData[ld / 2] = -0.0f;
+    aligned_vector<int8_t> iData(R * ld);
+    for (int i = 0; i < R * ld; ++i) {
+      iData[i] = static_cast<int8_t>(fData[i] * 4.0f);
+    }
+
+    auto checkCSR = [&](const auto& csr, const auto* data) {
+      ASSERT_EQ(csr->rowPtr.size(), R + 1);
+      int nnz = 0;
+      for (int i = 0; i < R; ++i) {
+        EXPECT_EQ(csr->rowPtr[i], nnz);
+        for (int j = 0; j < C; ++j) {
+          if (data[i * ld + j] != 0) {
+            ASSERT_LT(nnz, csr->colIdx.size());
+            EXPECT_EQ(csr->colIdx[nnz], j);
+            EXPECT_EQ(csr->values[nnz], data[i * ld + j]);
+            ++nnz;
+          }
+        }
+      }
+      EXPECT_EQ(csr->rowPtr[R], nnz);
+      EXPECT_EQ(csr->colIdx.size(), nnz);
+      EXPECT_EQ(csr->values.size(), nnz);
+    };
+    for (int num_threads : {1, 2, 4, 0}) {
+      SCOPED_TRACE("num_threads " + to_string(num_threads));
+      checkCSR(
+          fbgemmDenseToCSR(R, C, fData.data(), ld, num_threads), fData.data());
+      checkCSR(
+          fbgemmDenseToCSR(R, C, iData.data(), ld, num_threads), iData.data());
+    }
+  }
+}
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <cmath>
+#include <tuple>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "bench/BenchUtils.h"
+#include "fbgemm/FbgemmSparse.h"
+#include "src/RefImplementations.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+// {M, N, K, fraction of non-zeros of A, fraction of non-zeros of B}
+class SparseSparseMMTest : public testing::TestWithParam<
+                               tuple<int, int, int, float, float>> {};
+
+} // namespace
+
+INSTANTIATE_TEST_CASE_P(
+    InstantiationName,
+    SparseSparseMMTest,
+    ::testing::Values(
+        make_tuple(1, 1, 1, 1.0f, 1.0f),
+        make_tuple(0, 10, 10, 0.5f, 0.5f),
+        make_tuple(10, 10, 0, 0.5f, 0.5f),
+        make_tuple(7, 13, 24, 0.3f, 0.3f),
+        make_tuple(64, 100, 50, 0.1f, 0.5f),
+        make_tuple(300, 2000, 200, 0.02f, 0.01f),
+        make_tuple(100, 30, 1000, 0.05f, 0.0f),
+        make_tuple(50, 200000, 20, 0.2f, 0.0001f),
+        make_tuple(33, 500, 64, 1.0f, 1.0f)));
+
+TEST_P(SparseSparseMMTest, matchesDense) {
+  const auto [m, n, k, fnzA, fnzB] = GetParam();
+  aligned_vector<float> aData = getRandomSparseVector(m * k, fnzA);
+  aligned_vector<float> bData = getRandomSparseVector(k * n, fnzB);
+  unique_ptr<CSRMatrix<float>> A = fbgemmDenseToCSR(m, k, aData.data());
+  unique_ptr<CSRMatrix<float>> B = fbgemmDenseToCSR(k, n, bData.data());
+
+  vector<float> cRef(m * n, 0.0f);
+  if (m > 0 && n > 0 && k > 0) {
+    cblas_sgemm_ref(
+        matrix_op_t::NoTranspose,
+        matrix_op_t::NoTranspose,
+        m,
+        n,
+        k,
+        1.0f,
+        aData.data(),
+        k,
+        bData.data(),
+        n,
+        0.0f,
+        cRef.data(),
+        n);
+  }
+
+  unique_ptr<CSRMatrix<float>> cRefCSR = fbgemmDenseToCSR(m, n, cRef.data());
+
+  for (int num_threads : {1, 2, 3, 8}) {
+    SCOPED_TRACE("num_threads " + to_string(num_threads));
+    unique_ptr<CSRMatrix<float>> C =
+        fbgemmSparseSparseMM(m, n, *A, *B, num_threads);
+
+    ASSERT_EQ(C->rowPtr.size(), m + 1);
+    EXPECT_EQ(C->rowPtr[0], 0);
+    ASSERT_EQ(C->colIdx.size(), C->rowPtr[m]);
+    ASSERT_EQ(C->values.size(), C->rowPtr[m]);
+
+    vector<float> c(m * n, 0.0f);
+    for (int i = 0; i < m; ++i) {
+      for (int r = C->rowPtr[i]; r < C->rowPtr[i + 1]; ++r) {
+        ASSERT_TRUE(C->colIdx[r] >= 0 && C->colIdx[r] < n);
+        if (r > C->rowPtr[i]) {
+          EXPECT_LT(C->colIdx[r - 1], C->colIdx[r]) << "row " << i;
+        }
+        c[i * n + C->colIdx[r]] = C->values[r];
+      }
+    }
+    for (int i = 0; i < m * n; ++i) {
+      EXPECT_NEAR(cRef[i], c[i], 1e-5 * std::abs(cRef[i]) + 1e-6)
+          << "Results differ at (" << i / n << ", " << i % n << ")";
+    }
+    // The random values do not cancel out, so the structure matches too
+    EXPECT_EQ(C->rowPtr, cRefCSR->rowPtr);
+    EXPECT_EQ(C->colIdx, cRefCSR->colIdx);
+  }
+}
+
+TEST(SparseSparseMMCancelTest, keepsCancelledEntries) {
+  // [1 1] x [1 ; -1] cancels out to a structural zero
+  CSRMatrix<float> A{{0, 2}, {0, 1}, {1.0f, 1.0f}};
+  CSRMatrix<float> B{{0, 1, 2}, {0, 0}, {1.0f, -1.0f}};
+  unique_ptr<CSRMatrix<float>> C = fbgemmSparseSparseMM(1, 1, A, B);
+  EXPECT_EQ(C->rowPtr, (vector<int>{0, 1}));
+  EXPECT_EQ(C->colIdx, (vector<int>{0}));
+  EXPECT_EQ(C->values, (vector<float>{0.0f}));
+}
@@ -0,0 +1,135 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "fbgemm/Utils.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+// Runs each chunk of at most grain_size elements on its own thread and counts
+// the calls, as an application pool bound with fbgemmSetThreadPool would.
+class CountingThreadPool final : public ThreadPool {
+ public:
+  int getNumThreads() const override {
+    return 4;
+  }
+
+  void parallelFor(
+      int64_t begin,
+      int64_t end,
+      int64_t grain_size,
+      const function<void(int64_t, int64_t)>& f) override {
+    ++num_calls;
+    grain_size = max<int64_t>(grain_size, 1);
+    vector<thread> threads;
+    for (int64_t b = begin; b < end; b += grain_size) {
+      threads.emplace_back(f, b, min(b + grain_size, end));
+    }
+    for (auto& t : threads) {
+      t.join();
+    }
+  }
+
+  atomic<int> num_calls{0};
+};
+
+// Installs pool for the scope of a test
+class ScopedThreadPool {
+ public:
+  explicit ScopedThreadPool(shared_ptr<ThreadPool> pool) {
+    fbgemmSetThreadPool(std::move(pool));
+  }
+  ~ScopedThreadPool() {
+    fbgemmSetThreadPool(nullptr);
+  }
+};
+
+void checkCoversOnce(int64_t begin, int64_t end, int64_t grain_size) {
+  vector<atomic<int>> hits(end - begin);
+  fbgemmParallelFor(begin, end, grain_size, [&](int64_t b, int64_t e) {
+    EXPECT_LE(begin, b);
+    EXPECT_LT(b, e);
+    EXPECT_LE(e, end);
+    for (int64_t i = b; i < e; ++i) {
+      ++hits[i - begin];
+    }
+  });
+  for (int64_t i = 0; i < end - begin; ++i) {
+    EXPECT_EQ(hits[i], 1) << "element " << begin + i;
+  }
+}
+
+} // namespace
+
+TEST(ThreadPoolTest, defaultPoolCoversRangeOnce) {
+  EXPECT_GE(fbgemmGetNumThreads(), 1);
+  for (int64_t grain_size : {0, 1, 3, 1000}) {
+    checkCoversOnce(0, 0, grain_size);
+    checkCoversOnce(5, 6, grain_size);
+    checkCoversOnce(-7, 1234, grain_size);
+  }
+}
+
+TEST(ThreadPoolTest, customPoolIsUsed) {
+  auto pool = make_shared<CountingThreadPool>();
+  ScopedThreadPool scope(pool);
+  EXPECT_EQ(fbgemmGetThreadPool(), pool);
+  EXPECT_EQ(fbgemmGetNumThreads(), 4);
+
+  checkCoversOnce(3, 100, 7);
+  EXPECT_EQ(pool->num_calls, 1);
+
+  vector<atomic<int>> hits(9);
+  fbgemmParallelTasks(9, [&](int task_id) { ++hits[task_id]; });
+  EXPECT_EQ(pool->num_calls, 2);
+  for (const auto& h : hits) {
+    EXPECT_EQ(h, 1);
+  }
+}
+
+TEST(ThreadPoolTest, radixSortRunsOnCustomPool) {
+  auto pool = make_shared<CountingThreadPool>();
+  ScopedThreadPool scope(pool);
+
+  default_random_engine generator;
+  uniform_int_distribution<int> dist(0, 1 << 20);
+  const int n = 4321;
+  vector<int> keys(n), values(n), keys_tmp(n), values_tmp(n);
+  for (auto& k : keys) {
+    k = dist(generator);
+  }
+  iota(values.begin(), values.end(), 0);
+  vector<int> expected_values = values;
+  stable_sort(
+      expected_values.begin(), expected_values.end(), [&](int a, int b) {
+        return keys[a] < keys[b];
+      });
+
+  const auto [sorted_keys, sorted_values] = radix_sort_parallel(
+      keys.data(),
+      values.data(),
+      keys_tmp.data(),
+      values_tmp.data(),
+      n,
+      1 << 20);
+  EXPECT_GT(pool->num_calls, 0);
+  EXPECT_EQ(vector<int>(sorted_values, sorted_values + n), expected_values);
+  EXPECT_TRUE(is_sorted(sorted_keys, sorted_keys + n));
+}
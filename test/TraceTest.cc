@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "fbgemm/FbgemmEmbedding.h"
+#include "fbgemm/FbgemmTrace.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+struct RecordedEvent {
+  string kernel;
+  vector<int64_t> shape;
+  int64_t duration_ns;
+  int64_t bytes;
+};
+
+// Collects the events reported while it is alive
+class TraceRecorder {
+ public:
+  TraceRecorder() {
+    fbgemmSetTraceCallback([this](const TraceEvent& event) {
+      lock_guard<mutex> lock(mutex_);
+      events_.push_back(
+          {event.kernel,
+           vector<int64_t>(event.shape, event.shape + event.shape_size),
+           event.duration_ns,
+           event.bytes});
+    });
+  }
+  ~TraceRecorder() {
+    fbgemmSetTraceCallback(nullptr);
+  }
+
+  vector<RecordedEvent> events() {
+    lock_guard<mutex> lock(mutex_);
+    return events_;
+  }
+
+ private:
+  mutex mutex_;
+  vector<RecordedEvent> events_;
+};
+
+// Runs an element-wise fused SparseAdaGrad step of 2 bags of 2 rows
+void runSparseAdaGradFused(int block_size) {
+  const auto kernel =
+      GenerateSparseAdaGradFused<int64_t, int32_t>(block_size, 0, true);
+  vector<float> w(8 * block_size, 1.0f), h(8 * block_size, 1.0f);
+  vector<float> g(2 * block_size, 0.5f);
+  const vector<int64_t> indices = {1, 3, 5, 7};
+  const vector<int32_t> offsets = {0, 2, 4};
+  EXPECT_TRUE(kernel(
+      2,
+      4,
+      8,
+      w.data(),
+      g.data(),
+      h.data(),
+      indices.data(),
+      offsets.data(),
+      1e-5f,
+      0.1f));
+}
+
+} // namespace
+
+TEST(TraceTest, reportsKernelCalls) {
+  EXPECT_FALSE(fbgemmTracingEnabled());
+  vector<RecordedEvent> events;
+  {
+    TraceRecorder recorder;
+    EXPECT_TRUE(fbgemmTracingEnabled());
+    runSparseAdaGradFused(16);
+    events = recorder.events();
+  }
+  EXPECT_FALSE(fbgemmTracingEnabled());
+#ifdef FBGEMM_DISABLE_TRACING
+  EXPECT_TRUE(events.empty());
+#else
+  ASSERT_EQ(events.size(), 1);
+  EXPECT_EQ(events[0].kernel, "SparseAdaGradFused");
+  EXPECT_EQ(events[0].shape, (vector<int64_t>{2, 4, 8, 16}));
+  EXPECT_GE(events[0].duration_ns, 0);
+  EXPECT_GT(events[0].bytes, 4 * 16 * 2 * sizeof(float));
+#endif
+}
+
+TEST(TraceTest, noEventsAfterCallbackRemoval) {
+  TraceRecorder recorder;
+  fbgemmSetTraceCallback(nullptr);
+  EXPECT_FALSE(fbgemmTracingEnabled());
+  runSparseAdaGradFused(8);
+  EXPECT_TRUE(recorder.events().empty());
+}
+
+TEST(TraceTest, reportsConcurrentCalls) {
+  constexpr int kNumThreads = 4;
+  constexpr int kCallsPerThread = 10;
+  TraceRecorder recorder;
+  vector<thread> threads;
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([] {
+      for (int i = 0; i < kCallsPerThread; ++i) {
+        runSparseAdaGradFused(4);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+#ifndef FBGEMM_DISABLE_TRACING
+  EXPECT_EQ(recorder.events().size(), kNumThreads * kCallsPerThread);
+#endif
+}
+
+TEST(TraceTest, untracedWhenGeneratedWithoutCallback) {
+  const auto kernel = GenerateSparseAdaGradFused<int64_t, int32_t>(8, 0, true);
+  TraceRecorder recorder;
+  vector<float> w(8 * 8, 1.0f), h(8 * 8, 1.0f), g(2 * 8, 0.5f);
+  const vector<int64_t> indices = {1, 3, 5, 7};
+  const vector<int32_t> offsets = {0, 2, 4};
+  EXPECT_TRUE(kernel(
+      2,
+      4,
+      8,
+      w.data(),
+      g.data(),
+      h.data(),
+      indices.data(),
+      offsets.data(),
+      1e-5f,
+      0.1f));
+  EXPECT_TRUE(recorder.events().empty());
+}
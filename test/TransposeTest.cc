@@ -128,3 +128,95 @@ TEST(TransposeTest, TransposeTest) {
     EXPECT_TRUE(compare_tranpose_results(a_i16, b_i16, m, n, ld_src, ld_dst));
   }
 }
+
+template <typename T>
+void runParallelTransposeTest(int m, int n, int ld_src, int ld_dst) {
+  uniform_int_distribution<int> dist(0, 100);
+  default_random_engine generator;
+  vector<T> a(static_cast<size_t>(m) * ld_src);
+  generate(a.begin(), a.end(), [&dist, &generator] { return dist(generator); });
+  for (int num_threads : {1, 3, 8}) {
+    vector<T> b(static_cast<size_t>(n) * ld_dst);
+    for (int tid = 0; tid < num_threads; ++tid) {
+      transpose_simd_parallel(
+          m, n, a.data(), ld_src, b.data(), ld_dst, tid, num_threads);
+    }
+    EXPECT_TRUE(compare_tranpose_results(a, b, m, n, ld_src, ld_dst))
+        << "num_threads " << num_threads;
+  }
+}
+
+TEST(TransposeTest, ParallelTransposeTest) {
+  // {m, n, ld_src, ld_dst}: partial tiles, padded leading dimensions and
+  // outputs large enough for the non-temporal stores, with rows of dst not
+  // aligned to 16 bytes
+  vector<tuple<int, int, int, int>> shapes = {
+      make_tuple(0, 7, 7, 0),
+      make_tuple(1, 1000, 1000, 1),
+      make_tuple(300, 517, 520, 301),
+      make_tuple(2100, 2050, 2050, 2103)};
+  for (const auto& shape : shapes) {
+    int m, n, ld_src, ld_dst;
+    tie(m, n, ld_src, ld_dst) = shape;
+    runParallelTransposeTest<float>(m, n, ld_src, ld_dst);
+    runParallelTransposeTest<uint16_t>(m, n, ld_src, ld_dst);
+    runParallelTransposeTest<uint8_t>(m, n, ld_src, ld_dst);
+  }
+  // Streams uint8 as well
+  runParallelTransposeTest<uint8_t>(4099, 4103, 4103, 4101);
+}
+
+template <typename T>
+void runBatchedTransposeTest(int m, int n, int ld_src, int ld_dst) {
+  constexpr int batch_size = 37;
+  // Strides larger than the matrices leave gaps that must not be written
+  const int stride_src = m * ld_src + 3;
+  const int stride_dst = n * ld_dst + 5;
+  uniform_int_distribution<int> dist(0, 100);
+  default_random_engine generator;
+  vector<T> a(batch_size * stride_src);
+  generate(a.begin(), a.end(), [&dist, &generator] { return dist(generator); });
+  for (int num_threads : {1, 4}) {
+    vector<T> b(batch_size * stride_dst, 255);
+    for (int tid = 0; tid < num_threads; ++tid) {
+      transpose_simd_batched(
+          batch_size,
+          m,
+          n,
+          a.data(),
+          ld_src,
+          stride_src,
+          b.data(),
+          ld_dst,
+          stride_dst,
+          tid,
+          num_threads);
+    }
+    for (int i = 0; i < batch_size; ++i) {
+      vector<T> a_i(
+          a.begin() + i * stride_src, a.begin() + (i + 1) * stride_src);
+      vector<T> b_i(
+          b.begin() + i * stride_dst, b.begin() + (i + 1) * stride_dst);
+      EXPECT_TRUE(compare_tranpose_results(a_i, b_i, m, n, ld_src, ld_dst))
+          << "matrix " << i << " num_threads " << num_threads;
+      EXPECT_EQ(b_i.back(), 255);
+    }
+  }
+}
+
+TEST(TransposeTest, BatchedTransposeTest) {
+  // {m, n, ld_src, ld_dst}
+  vector<tuple<int, int, int, int>> shapes = {
+      make_tuple(32, 64, 64, 32),
+      make_tuple(32, 64, 70, 40),
+      make_tuple(5, 3, 3, 5),
+      make_tuple(1, 17, 17, 1),
+      make_tuple(0, 4, 4, 0)};
+  for (const auto& shape : shapes) {
+    int m, n, ld_src, ld_dst;
+    tie(m, n, ld_src, ld_dst) = shape;
+    runBatchedTransposeTest<float>(m, n, ld_src, ld_dst);
+    runBatchedTransposeTest<uint16_t>(m, n, ld_src, ld_dst);
+    runBatchedTransposeTest<uint8_t>(m, n, ld_src, ld_dst);
+  }
+}
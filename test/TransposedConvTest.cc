@@ -0,0 +1,288 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <gtest/gtest.h>
+
+#include "./TestUtils.h"
+#include "bench/BenchUtils.h"
+#include "fbgemm/Fbgemm.h"
+#include "src/RefImplementations.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+vector<QuantizationGranularity> qGranularityVals{
+    QuantizationGranularity::TENSOR,
+    QuantizationGranularity::GROUP,
+    QuantizationGranularity::OUT_CHANNEL};
+
+// QuantizationGranularity, A symmetric, B symmetric, float bias
+class TransposedConvQGranTest
+    : public testing::TestWithParam<
+          tuple<QuantizationGranularity, bool, bool, bool>> {};
+
+vector<conv_param_t<2>> shapes() {
+  return {
+      // MB, IC, OC, {IH, IW}, G, {KH, KW}, {stride_h, stride_w},
+      // {pad_t, pad_l, pad_b, pad_r}, {dilation_h, dilation_w},
+      // {output_padding_h, output_padding_w}, transposed
+      conv_param_t<2>(
+          1, 32, 16, {8, 9}, 1, {4, 4}, {2, 2}, {1, 1, 1, 1}, {1, 1}, {0, 0},
+          true),
+      conv_param_t<2>(
+          2, 16, 24, {5, 7}, 1, {3, 3}, {2, 2}, {1, 1, 1, 1}, {1, 1}, {1, 1},
+          true),
+      conv_param_t<2>(
+          1, 24, 32, {6, 5}, 1, {2, 2}, {2, 2}, {0, 0, 0, 0}, {1, 1}, {0, 0},
+          true),
+      // taps not dividing evenly among the phases
+      conv_param_t<2>(
+          1, 16, 16, {7, 6}, 1, {5, 3}, {3, 2}, {2, 1, 2, 1}, {1, 1}, {1, 0},
+          true),
+      // phases without taps
+      conv_param_t<2>(
+          1, 8, 16, {5, 5}, 1, {1, 1}, {2, 2}, {0, 0, 0, 0}, {1, 1}, {1, 1},
+          true),
+      // stride along one dimension only
+      conv_param_t<2>(
+          1, 32, 32, {4, 10}, 8, {3, 3}, {1, 2}, {2, 1, 2, 1}, {1, 1}, {0, 0},
+          true),
+      conv_param_t<2>(
+          1, 32, 32, {10, 4}, 8, {3, 3}, {2, 1}, {1, 2, 1, 2}, {1, 1}, {0, 0},
+          true),
+      // grouped and dilated
+      conv_param_t<2>(
+          2, 32, 16, {6, 6}, 4, {3, 3}, {2, 2}, {2, 2, 2, 2}, {2, 2}, {1, 1},
+          true),
+      conv_param_t<2>(
+          1, 12, 18, {5, 4}, 3, {3, 2}, {2, 3}, {1, 0, 1, 0}, {3, 1}, {0, 2},
+          true),
+  };
+}
+
+} // namespace
+
+INSTANTIATE_TEST_CASE_P(
+    InstantiationName,
+    TransposedConvQGranTest,
+    ::testing::Combine(
+        ::testing::ValuesIn(qGranularityVals),
+        ::testing::Bool(), // A symmetric
+        ::testing::Bool(), // B symmetric
+        ::testing::Bool())); // float bias
+
+template <QuantizationGranularity Q_GRAN, typename BIAS_TYPE>
+static void runTransposedConvTest(
+    const conv_param_t<2>& conv_p,
+    bool a_symmetric,
+    bool b_symmetric) {
+  SCOPED_TRACE(conv_p.toString());
+  const int G = conv_p.G;
+  const int OC = conv_p.OC;
+  const int OC_per_G = OC / G;
+  const int MDim = conv_p.MB * conv_p.OUT_DIM[0] * conv_p.OUT_DIM[1];
+  const int KDimPerGroup = conv_p.K[0] * conv_p.K[1] * conv_p.IC / G;
+  const int KDim = KDimPerGroup * G;
+
+  aligned_vector<uint8_t> Aint8(
+      conv_p.MB * conv_p.IN_DIM[0] * conv_p.IN_DIM[1] * conv_p.IC);
+  randFill<uint8_t>(Aint8, 0, 255);
+  int32_t Aint8_zero_point = a_symmetric ? 0 : 43;
+
+  // The weight matrix is in layout G K/G (R S C/G)
+  aligned_vector<int8_t> Bint8(KDimPerGroup * OC);
+  randFill<int8_t>(Bint8, -128, 127);
+  aligned_vector<int8_t> Bint8_tr(Bint8.size());
+  transposeConvWeights(conv_p, Bint8.data(), Bint8_tr.data());
+
+  int ncols_per_quant_group = OC;
+  if (Q_GRAN == QuantizationGranularity::GROUP) {
+    ncols_per_quant_group = OC_per_G;
+  } else if (Q_GRAN == QuantizationGranularity::OUT_CHANNEL) {
+    ncols_per_quant_group = 1;
+  }
+  aligned_vector<int32_t> Bint8_zero_point(OC / ncols_per_quant_group);
+  randFill(Bint8_zero_point, b_symmetric ? 0 : -3, b_symmetric ? 0 : 3);
+
+  vector<int32_t> col_offsets(OC);
+  for (int g = 0; g < G; ++g) {
+    col_offsets_with_zero_pt_s8acc32_ref(
+        KDimPerGroup,
+        OC_per_G,
+        OC_per_G,
+        Bint8_tr.data() + g * KDimPerGroup * OC_per_G,
+        Bint8_zero_point.data() + g * OC_per_G / ncols_per_quant_group,
+        col_offsets.data() + g * OC_per_G,
+        ncols_per_quant_group);
+  }
+
+  aligned_vector<float> act_times_w_scale(Bint8_zero_point.size());
+  randFill(act_times_w_scale, 0.0001f, 0.0003f);
+  aligned_vector<float> C_multiplier(act_times_w_scale);
+  int32_t C_zero_pt = 120;
+
+  aligned_vector<int32_t> bias_int32(OC);
+  randFill(bias_int32, -8000, 8000);
+  aligned_vector<float> bias_fp32(OC);
+  for (int k = 0; k < OC; ++k) {
+    bias_fp32[k] =
+        bias_int32[k] * act_times_w_scale[k / ncols_per_quant_group];
+  }
+  const BIAS_TYPE* bias = nullptr;
+  if (is_same<BIAS_TYPE, float>::value) {
+    bias = reinterpret_cast<const BIAS_TYPE*>(bias_fp32.data());
+  } else {
+    bias = reinterpret_cast<const BIAS_TYPE*>(bias_int32.data());
+  }
+
+  // reference implementation
+  aligned_vector<int32_t> Cint32_ref(MDim * OC);
+  aligned_vector<uint8_t> Cint8_ref(Cint32_ref.size());
+  conv_ref(
+      conv_p,
+      Aint8.data(),
+      Aint8_zero_point,
+      Bint8_tr.data(),
+      Cint32_ref.data());
+  vector<uint8_t> Aint8_im2col(MDim * KDim);
+  im2col_ref(conv_p, Aint8.data(), Aint8_zero_point, Aint8_im2col.data());
+  vector<int32_t> row_offsets(MDim);
+  for (int g = 0; g < G; ++g) {
+    row_offsets_u8acc32_ref(
+        MDim,
+        KDimPerGroup,
+        KDim,
+        Aint8_im2col.data() + g * KDimPerGroup,
+        row_offsets.data());
+    requantize_u8acc32_ref(
+        MDim,
+        OC_per_G,
+        OC,
+        Cint32_ref.data() + g * OC_per_G,
+        Cint8_ref.data() + g * OC_per_G,
+        C_multiplier.data() + g * OC_per_G / ncols_per_quant_group,
+        C_zero_pt,
+        Aint8_zero_point,
+        Bint8_zero_point.data() + g * OC_per_G / ncols_per_quant_group,
+        row_offsets.data(),
+        col_offsets.data() + g * OC_per_G,
+        bias_int32.data() + g * OC_per_G,
+        ncols_per_quant_group);
+  }
+
+  ASSERT_EQ(ConvFastPath<2>(conv_p), optimized_conv_t::transposed);
+  PackWeightsForConv<2> packedWeights(conv_p, Bint8.data());
+
+  aligned_vector<int8_t> Bint8_unpacked(Bint8.size());
+  packedWeights.unpack(Bint8_unpacked.data());
+  ASSERT_EQ(Bint8_unpacked, Bint8) << "Original and unpacked data elements "
+                                   << "are not the same";
+
+  aligned_vector<int32_t> Cint32_fb(Cint32_ref.size());
+  aligned_vector<uint8_t> Cint8_fb(Cint32_ref.size());
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  {
+    DoNothing<> doNothingObj{};
+    ReQuantizeOutput<false, Q_GRAN, BIAS_TYPE> reqObj(
+        doNothingObj,
+        C_multiplier.data(),
+        C_zero_pt,
+        Aint8_zero_point,
+        Bint8_zero_point.data(),
+        nullptr, /* row offset buffer */
+        col_offsets.data(),
+        bias,
+        OC,
+        G,
+        act_times_w_scale.data());
+
+    fbgemmConv(
+        conv_p,
+        Aint8.data(),
+        packedWeights,
+        Cint8_fb.data(),
+        Cint32_fb.data(),
+        reqObj,
+        fbgemm_get_thread_num(),
+        fbgemm_get_num_threads());
+  }
+
+  compare_validate_buffers(
+      Cint8_ref.data(), Cint8_fb.data(), MDim, OC, OC, static_cast<uint8_t>(0));
+}
+
+TEST_P(TransposedConvQGranTest, requantizeTest) {
+  QuantizationGranularity q_granularity;
+  bool a_symmetric, b_symmetric, float_bias;
+  tie(q_granularity, a_symmetric, b_symmetric, float_bias) = GetParam();
+
+  for (const auto& conv_p : shapes()) {
+    if (q_granularity == QuantizationGranularity::TENSOR) {
+      if (float_bias) {
+        runTransposedConvTest<QuantizationGranularity::TENSOR, float>(
+            conv_p, a_symmetric, b_symmetric);
+      } else {
+        runTransposedConvTest<QuantizationGranularity::TENSOR, int32_t>(
+            conv_p, a_symmetric, b_symmetric);
+      }
+    } else if (q_granularity == QuantizationGranularity::GROUP) {
+      if (float_bias) {
+        runTransposedConvTest<QuantizationGranularity::GROUP, float>(
+            conv_p, a_symmetric, b_symmetric);
+      } else {
+        runTransposedConvTest<QuantizationGranularity::GROUP, int32_t>(
+            conv_p, a_symmetric, b_symmetric);
+      }
+    } else {
+      if (float_bias) {
+        runTransposedConvTest<QuantizationGranularity::OUT_CHANNEL, float>(
+            conv_p, a_symmetric, b_symmetric);
+      } else {
+        runTransposedConvTest<QuantizationGranularity::OUT_CHANNEL, int32_t>(
+            conv_p, a_symmetric, b_symmetric);
+      }
+    }
+  }
+}
+
+TEST(TransposedConvFastPathTest, onlyStrided2D) {
+  EXPECT_EQ(
+      ConvFastPath<2>(conv_param_t<2>(
+          1, 16, 16, {8, 8}, 1, {4, 4}, {2, 2}, {1, 1, 1, 1}, {1, 1}, {0, 0},
+          true)),
+      optimized_conv_t::transposed);
+  // stride 1
+  EXPECT_EQ(
+      ConvFastPath<2>(conv_param_t<2>(
+          1, 16, 16, {8, 8}, 1, {3, 3}, {1, 1}, {1, 1, 1, 1}, {1, 1}, {0, 0},
+          true)),
+      optimized_conv_t::im2col);
+  // 16-bit accumulation
+  EXPECT_EQ(
+      (ConvFastPath<2, int16_t>(conv_param_t<2>(
+          1, 16, 16, {8, 8}, 1, {4, 4}, {2, 2}, {1, 1, 1, 1}, {1, 1}, {0, 0},
+          true))),
+      optimized_conv_t::im2col);
+  // 1D
+  EXPECT_EQ(
+      ConvFastPath<1>(conv_param_t<1>(
+          1, 16, 16, {8}, 1, {4}, {2}, {1, 1}, {1}, {0}, true)),
+      optimized_conv_t::im2col);
+}
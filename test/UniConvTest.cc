@@ -257,6 +257,14 @@ TEST_P(uniConvTest, packingTest) {
           << "im2col packed matrix should be null";
       break;
     }
+    case optimized_conv_t::winograd: {
+      FAIL() << "winograd is only for 2D convolutions";
+      break;
+    }
+    case optimized_conv_t::transposed: {
+      FAIL() << "transposed is only for 2D convolutions";
+      break;
+    }
     case optimized_conv_t::fastpath1d: {
       break;
     }
@@ -343,6 +351,32 @@ TEST_P(uniConvTest, packingTest) {
           << "im2col packed matrix should be null";
       break;
     }
+    case optimized_conv_t::winograd: {
+      ASSERT_EQ(packedB_2D.getPackedWForDepthwise(), nullptr)
+          << "depthwise packed matrix should be null";
+      ASSERT_EQ(packedB_2D.getPackedWForGroupwise(), nullptr)
+          << "groupwise packed matrix should be null";
+      ASSERT_EQ(packedB_2D.getPackedWForPointwise(), nullptr)
+          << "pointwise packed matrix should be null";
+      ASSERT_EQ(packedB_2D.getPackedWForIm2col(), nullptr)
+          << "im2col packed matrix should be null";
+      ASSERT_NE(packedB_2D.getPackedWForWinograd(), nullptr)
+          << "winograd packed matrix is null";
+      break;
+    }
+    case optimized_conv_t::transposed: {
+      ASSERT_EQ(packedB_2D.getPackedWForDepthwise(), nullptr)
+          << "depthwise packed matrix should be null";
+      ASSERT_EQ(packedB_2D.getPackedWForGroupwise(), nullptr)
+          << "groupwise packed matrix should be null";
+      ASSERT_EQ(packedB_2D.getPackedWForPointwise(), nullptr)
+          << "pointwise packed matrix should be null";
+      ASSERT_EQ(packedB_2D.getPackedWForIm2col(), nullptr)
+          << "im2col packed matrix should be null";
+      ASSERT_NE(packedB_2D.getPackedWForTransposed(), nullptr)
+          << "transposed packed matrix is null";
+      break;
+    }
     case optimized_conv_t::fastpath1d: {
       break;
     }
@@ -429,6 +463,14 @@ TEST_P(uniConvTest, packingTest) {
           << "im2col packed matrix should be null";
       break;
     }
+    case optimized_conv_t::winograd: {
+      FAIL() << "winograd is only for 2D convolutions";
+      break;
+    }
+    case optimized_conv_t::transposed: {
+      FAIL() << "transposed is only for 2D convolutions";
+      break;
+    }
     case optimized_conv_t::fastpath1d: {
       break;
     }
@@ -986,3 +1028,173 @@ TEST_P(UniConvQGranTest, requantizeTest) {
   runRequantizeTest<2>(
       q_granularity, a_symmetric, b_symmetric, test_bias, test_float_bias);
 }
+
+template <int SPATIAL_DIM>
+static void runNchwInputTest(const conv_param_t<SPATIAL_DIM>& conv_p_nhwc) {
+  conv_param_t<SPATIAL_DIM> conv_p = conv_p_nhwc;
+  conv_p.input_layout = conv_layout_t::NCHW;
+  SCOPED_TRACE(conv_p.toString());
+  ASSERT_EQ(ConvFastPath<SPATIAL_DIM>(conv_p), optimized_conv_t::im2col);
+
+  const int G = conv_p.G;
+  const int IC_per_G = conv_p.IC / G;
+  const int OC_per_G = conv_p.OC / G;
+  int in_plane = 1, out_plane = 1, kernel_dim = 1;
+  for (int d = 0; d < SPATIAL_DIM; ++d) {
+    in_plane *= conv_p.IN_DIM[d];
+    out_plane *= conv_p.OUT_DIM[d];
+    kernel_dim *= conv_p.K[d];
+  }
+  const int MDim = conv_p.MB * out_plane;
+  const int KDim = kernel_dim * conv_p.IC;
+  const int KDimPerGroup = KDim / G;
+
+  aligned_vector<uint8_t> Aint8(conv_p.MB * in_plane * conv_p.IC);
+  randFill<uint8_t>(Aint8, 0, 80);
+  int32_t Aint8_zero_point = 43;
+  aligned_vector<uint8_t> Aint8_nchw(Aint8.size());
+  for (int n = 0; n < conv_p.MB; ++n) {
+    for (int p = 0; p < in_plane; ++p) {
+      for (int c = 0; c < conv_p.IC; ++c) {
+        Aint8_nchw[(n * conv_p.IC + c) * in_plane + p] =
+            Aint8[(n * in_plane + p) * conv_p.IC + c];
+      }
+    }
+  }
+
+  // The weight matrix is in layout G K/G (R S C/G)
+  aligned_vector<int8_t> Bint8(kernel_dim * IC_per_G * conv_p.OC);
+  randFill<int8_t>(Bint8, -16, 16);
+  aligned_vector<int8_t> Bint8_tr(Bint8.size());
+  transposeConvWeights<SPATIAL_DIM>(conv_p, Bint8.data(), Bint8_tr.data());
+  aligned_vector<int32_t> Bint8_zero_point(1, -3);
+
+  aligned_vector<float> C_multiplier(1);
+  randFill(C_multiplier, 0.001234f / 2, 0.001234f * 3 / 2);
+  int32_t C_zero_pt = 5;
+
+  vector<int32_t> col_offsets(conv_p.OC);
+  for (int g = 0; g < G; ++g) {
+    col_offsets_with_zero_pt_s8acc32_ref(
+        KDimPerGroup,
+        OC_per_G,
+        OC_per_G,
+        Bint8_tr.data() + g * KDimPerGroup * OC_per_G,
+        Bint8_zero_point.data(),
+        col_offsets.data() + g * OC_per_G,
+        conv_p.OC);
+  }
+
+  // reference implementation on the NHWC input
+  aligned_vector<int32_t> Cint32_ref(MDim * conv_p.OC);
+  aligned_vector<uint8_t> Cint8_ref(Cint32_ref.size());
+  conv_ref(
+      conv_p_nhwc,
+      Aint8.data(),
+      Aint8_zero_point,
+      Bint8_tr.data(),
+      Cint32_ref.data());
+  vector<uint8_t> Aint8_im2col(MDim * KDim);
+  im2col_ref(conv_p_nhwc, Aint8.data(), Aint8_zero_point, Aint8_im2col.data());
+  vector<int32_t> row_offsets(MDim);
+  for (int g = 0; g < G; ++g) {
+    row_offsets_u8acc32_ref(
+        MDim,
+        KDimPerGroup,
+        KDim,
+        Aint8_im2col.data() + g * KDimPerGroup,
+        row_offsets.data());
+    requantize_u8acc32_ref(
+        MDim,
+        OC_per_G,
+        conv_p.OC,
+        Cint32_ref.data() + g * OC_per_G,
+        Cint8_ref.data() + g * OC_per_G,
+        C_multiplier.data(),
+        C_zero_pt,
+        Aint8_zero_point,
+        Bint8_zero_point.data(),
+        row_offsets.data(),
+        col_offsets.data() + g * OC_per_G,
+        nullptr,
+        conv_p.OC);
+  }
+
+  PackWeightsForConv<SPATIAL_DIM> packedWeights(conv_p, Bint8.data());
+  EXPECT_FALSE(packedWeights.isPackingCompliant(conv_p_nhwc));
+
+  aligned_vector<int32_t> Cint32_fb(Cint32_ref.size());
+  aligned_vector<uint8_t> Cint8_fb(Cint32_ref.size());
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  {
+    DoNothing<> doNothingObj{};
+    ReQuantizeOutput<false> reqObj(
+        doNothingObj,
+        C_multiplier.data(),
+        C_zero_pt,
+        Aint8_zero_point,
+        Bint8_zero_point.data(),
+        nullptr, /* row offset buffer */
+        col_offsets.data(),
+        nullptr,
+        conv_p.OC,
+        G);
+
+    fbgemmConv(
+        conv_p,
+        Aint8_nchw.data(),
+        packedWeights,
+        Cint8_fb.data(),
+        Cint32_fb.data(),
+        reqObj,
+        fbgemm_get_thread_num(),
+        fbgemm_get_num_threads());
+  }
+
+  compare_validate_buffers(
+      Cint8_ref.data(),
+      Cint8_fb.data(),
+      MDim,
+      conv_p.OC,
+      conv_p.OC,
+      static_cast<uint8_t>(0));
+}
+
+TEST(uniConvTest, nchwInputTest) {
+  // MB, IC, OC, {IW}, G, {KW}, {stride_w}, {pad_l, pad_r}
+  runNchwInputTest<1>(conv_param_t<1>(2, 16, 32, {20}, 1, {3}, {2}, {1, 1}));
+  // MB, IC, OC, {IH, IW}, G, {KH, KW}, {stride_h, stride_w},
+  // {pad_t, pad_l, pad_b, pad_r}, {dilation_h, dilation_w}
+  runNchwInputTest<2>(
+      conv_param_t<2>(1, 32, 48, {14, 13}, 1, {3, 3}, {1, 1}, {1, 1, 1, 1}));
+  runNchwInputTest<2>(
+      conv_param_t<2>(2, 3, 64, {30, 31}, 1, {7, 7}, {2, 2}, {3, 3, 3, 3}));
+  // groupwise
+  runNchwInputTest<2>(
+      conv_param_t<2>(1, 32, 32, {10, 12}, 8, {3, 3}, {1, 1}, {1, 1, 1, 1}));
+  // depthwise, dilated
+  runNchwInputTest<2>(conv_param_t<2>(
+      1, 32, 32, {15, 15}, 32, {3, 3}, {1, 1}, {2, 2, 2, 2}, {2, 2}));
+  // pointwise
+  runNchwInputTest<2>(
+      conv_param_t<2>(2, 24, 40, {7, 9}, 1, {1, 1}, {1, 1}, {0, 0, 0, 0}));
+  // transposed
+  runNchwInputTest<2>(conv_param_t<2>(
+      1,
+      16,
+      24,
+      {6, 7},
+      2,
+      {3, 3},
+      {2, 2},
+      {1, 1, 1, 1},
+      {1, 1},
+      {1, 1},
+      true));
+  // MB, IC, OC, {IT, IH, IW}, G, {KT, KH, KW}, {stride_t, stride_h, stride_w},
+  // {pad_prev, pad_t, pad_l, pad_next, pad_b, pad_r}
+  runNchwInputTest<3>(conv_param_t<3>(
+      1, 16, 32, {4, 7, 8}, 2, {3, 3, 3}, {1, 2, 1}, {1, 1, 1, 1, 1, 1}));
+}
@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "fbgemm/Fbgemm.h"
+#include "fbgemm/FbgemmEmbedding.h"
+#include "fbgemm/FbgemmWarmup.h"
+#include "fbgemm/Utils.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+CodeCacheStats codeCacheStats(const string& name) {
+  for (const auto& stats : getCodeCacheStats()) {
+    if (stats.name == name) {
+      return stats;
+    }
+  }
+  return CodeCacheStats{};
+}
+
+} // namespace
+
+TEST(WarmupTest, generatesManifestKernels) {
+  WarmupManifest manifest;
+  manifest.gemms.push_back({/*M=*/64, /*N=*/128, /*K=*/256});
+  manifest.gemms.push_back(
+      {/*M=*/17, /*N=*/40, /*K=*/64, /*acc16=*/true, /*num_threads=*/2});
+  for (int bit_rate : {32, 16, 8, 4, 2}) {
+    EmbeddingWarmupConfig config{/*block_size=*/64};
+    config.bit_rate = bit_rate;
+    manifest.embeddings.push_back(config);
+  }
+  manifest.embeddings.push_back(
+      {/*block_size=*/32,
+       /*bit_rate=*/32,
+       /*has_weight=*/true,
+       /*normalize_by_lengths=*/false,
+       /*prefetch=*/0,
+       /*is_weight_positional=*/false,
+       /*use_offsets=*/false,
+       /*is_index_64bit=*/false,
+       /*is_offset_64bit=*/false});
+  // groupwise, depthwise and im2col paths
+  manifest.convs_2d.push_back({conv_param_t<2>(
+      1, 32, 32, array<int, 2>{14, 14}, 8, array<int, 2>{3, 3},
+      array<int, 2>{1, 1}, array<int, 4>{1, 1, 1, 1})});
+  manifest.convs_2d.push_back({conv_param_t<2>(
+      1, 64, 64, array<int, 2>{14, 14}, 64, array<int, 2>{3, 3},
+      array<int, 2>{1, 1}, array<int, 4>{1, 1, 1, 1})});
+  manifest.convs_2d.push_back({conv_param_t<2>(
+      1, 16, 24, array<int, 2>{10, 10}, 1, array<int, 2>{3, 3},
+      array<int, 2>{2, 2}, array<int, 4>{1, 1, 1, 1})});
+  manifest.convs_3d.push_back({conv_param_t<3>(
+      1, 32, 32, array<int, 3>{4, 8, 8}, 32, array<int, 3>{3, 3, 3},
+      array<int, 3>{1, 1, 1}, array<int, 6>{1, 1, 1, 1, 1, 1})});
+
+  const bool jit = fbgemmHasAvx2Support() && !is_asmjit_disabled();
+  const CodeCacheStats gemm_before = codeCacheStats("gemm");
+  const CodeCacheStats embedding_before = codeCacheStats("embedding");
+
+  auto done = fbgemmWarmup(manifest, /*num_threads=*/3);
+  EXPECT_NO_THROW(done.get());
+  if (!jit) {
+    return;
+  }
+  const CodeCacheStats gemm_warm = codeCacheStats("gemm");
+  const CodeCacheStats embedding_warm = codeCacheStats("embedding");
+  EXPECT_GT(gemm_warm.misses, gemm_before.misses);
+  EXPECT_GT(embedding_warm.misses, embedding_before.misses);
+
+  // The kernels of the manifest are now cache hits
+  GenerateEmbeddingSpMDM<float, int64_t, int64_t>(
+      /*block_size=*/64,
+      /*has_weight=*/false,
+      /*normalize_by_lengths=*/false,
+      /*prefetch=*/16,
+      /*is_weight_positional=*/false,
+      /*use_offsets=*/true);
+  GenerateEmbeddingSpMDM<float, int32_t, int32_t>(
+      /*block_size=*/32,
+      /*has_weight=*/true,
+      /*normalize_by_lengths=*/false,
+      /*prefetch=*/0,
+      /*is_weight_positional=*/false,
+      /*use_offsets=*/false);
+  const CodeCacheStats embedding_hit = codeCacheStats("embedding");
+  EXPECT_EQ(embedding_hit.misses, embedding_warm.misses);
+  EXPECT_EQ(embedding_hit.hits, embedding_warm.hits + 2);
+}
+
+TEST(WarmupTest, nonTensorConvAfterWarmup) {
+  if (!fbgemmHasAvx2Support() || is_asmjit_disabled()) {
+    GTEST_SKIP();
+  }
+  // groupwise and depthwise, requantized per output channel with a nonzero
+  // A and B zero point and a fused relu
+  const vector<conv_param_t<2>> convs = {
+      conv_param_t<2>(
+          1, 16, 16, {12, 12}, 4, {3, 3}, {1, 1}, {1, 1, 1, 1}),
+      conv_param_t<2>(
+          1, 48, 48, {12, 12}, 48, {3, 3}, {1, 1}, {1, 1, 1, 1})};
+  constexpr int32_t A_zero_point = 3;
+  constexpr int32_t B_zero_point = 1;
+
+  WarmupManifest manifest;
+  for (const auto& conv_p : convs) {
+    ConvWarmupConfig<2> config{conv_p};
+    config.granularity = QuantizationGranularity::OUT_CHANNEL;
+    config.fuse_relu = true;
+    config.A_zero_point = A_zero_point;
+    config.B_zero_point = B_zero_point;
+    manifest.convs_2d.push_back(config);
+  }
+  auto done = fbgemmWarmup(manifest);
+  ASSERT_NO_THROW(done.get());
+
+  const CodeCacheStats groupwise_warm = codeCacheStats("groupwise_conv");
+  const CodeCacheStats depthwise_warm = codeCacheStats("depthwise");
+
+  for (const auto& conv_p : convs) {
+    const int in_size = conv_p.MB * conv_p.IC * conv_p.IN_DIM[0] *
+        conv_p.IN_DIM[1];
+    const int out_size = conv_p.MB * conv_p.OC * conv_p.OUT_DIM[0] *
+        conv_p.OUT_DIM[1];
+    const int w_size =
+        conv_p.IC / conv_p.G * conv_p.OC * conv_p.K[0] * conv_p.K[1];
+    vector<uint8_t> A(in_size, A_zero_point + 1);
+    vector<int8_t> B(w_size, 2);
+    vector<int32_t> C_buffer(out_size);
+    vector<uint8_t> C(out_size);
+    vector<int32_t> col_offsets(conv_p.OC, 0);
+    vector<int32_t> B_zero_points(conv_p.OC, B_zero_point);
+    vector<float> C_multiplier(conv_p.OC, 0.1f);
+
+    PackWeightsForConv<2> packedWeights(conv_p, B.data());
+    DoNothing<> doNothingObj{};
+    ReQuantizeOutput<true, QuantizationGranularity::OUT_CHANNEL> outputProcObj(
+        doNothingObj,
+        C_multiplier.data(),
+        0,
+        A_zero_point,
+        B_zero_points.data(),
+        nullptr,
+        col_offsets.data(),
+        nullptr,
+        conv_p.OC,
+        conv_p.G);
+    fbgemmConv(
+        conv_p,
+        A.data(),
+        packedWeights,
+        C.data(),
+        C_buffer.data(),
+        outputProcObj,
+        0,
+        1);
+  }
+
+  EXPECT_EQ(codeCacheStats("groupwise_conv").misses, groupwise_warm.misses);
+  EXPECT_EQ(codeCacheStats("depthwise").misses, depthwise_warm.misses);
+}
+
+TEST(WarmupTest, propagatesErrors) {
+  WarmupManifest manifest;
+  EmbeddingWarmupConfig config{/*block_size=*/64};
+  config.bit_rate = 3;
+  manifest.embeddings.push_back(config);
+
+  auto done = fbgemmWarmup(manifest);
+  EXPECT_THROW(done.get(), invalid_argument);
+}
+
+TEST(WarmupTest, emptyManifest) {
+  auto done = fbgemmWarmup(WarmupManifest{});
+  EXPECT_NO_THROW(done.get());
+}
@@ -0,0 +1,261 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ * All rights reserved.
+ *
+ * This source code is licensed under the BSD-style license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <cpuinfo.h>
+#include <gtest/gtest.h>
+
+#include "./TestUtils.h"
+#include "bench/BenchUtils.h"
+#include "fbgemm/Fbgemm.h"
+#include "src/RefImplementations.h"
+
+using namespace std;
+using namespace fbgemm;
+
+namespace {
+
+// QuantizationGranularity, A symmetric, B symmetric, float bias
+class WinogradConvQGranTest
+    : public testing::TestWithParam<
+          tuple<QuantizationGranularity, bool, bool, bool>> {};
+
+vector<conv_param_t<2>> shapes() {
+  return {
+      // MB, IC, OC, {IH, IW}, G, {KH, KW}, {stride_h, stride_w},
+      // {pad_t, pad_l, pad_b, pad_r}
+      conv_param_t<2>(1, 16, 32, {10, 10}, 1, {3, 3}, {1, 1}, {1, 1, 1, 1}),
+      conv_param_t<2>(2, 32, 48, {7, 9}, 1, {3, 3}, {1, 1}, {1, 1, 1, 1}),
+      conv_param_t<2>(1, 64, 24, {14, 13}, 1, {3, 3}, {1, 1}, {0, 0, 0, 0}),
+      conv_param_t<2>(1, 17, 33, {5, 6}, 1, {3, 3}, {1, 1}, {2, 1, 0, 2}),
+      conv_param_t<2>(3, 128, 64, {28, 28}, 1, {3, 3}, {1, 1}, {1, 1, 1, 1}),
+      conv_param_t<2>(1, 1024, 16, {3, 3}, 1, {3, 3}, {1, 1}, {1, 1, 1, 1}),
+  };
+}
+
+} // namespace
+
+INSTANTIATE_TEST_CASE_P(
+    InstantiationName,
+    WinogradConvQGranTest,
+    ::testing::Combine(
+        ::testing::Values(
+            QuantizationGranularity::TENSOR,
+            QuantizationGranularity::OUT_CHANNEL),
+        ::testing::Bool(), // A symmetric
+        ::testing::Bool(), // B symmetric
+        ::testing::Bool())); // float bias
+
+template <QuantizationGranularity Q_GRAN, typename BIAS_TYPE>
+static void runWinogradTest(
+    const conv_param_t<2>& conv_p,
+    bool a_symmetric,
+    bool b_symmetric) {
+  const int IC = conv_p.IC;
+  const int OC = conv_p.OC;
+  const int IH = conv_p.IN_DIM[0];
+  const int IW = conv_p.IN_DIM[1];
+  const int OH = conv_p.OUT_DIM[0];
+  const int OW = conv_p.OUT_DIM[1];
+  const int MDim = conv_p.MB * OH * OW;
+  const int KDim = 9 * IC;
+
+  aligned_vector<uint8_t> Aint8(conv_p.MB * IH * IW * IC);
+  // Extreme values check that the transforms do not overflow.
+  randFill<uint8_t>(Aint8, 0, 255);
+  int32_t Aint8_zero_point = a_symmetric ? 0 : 43;
+
+  // The weight matrix is in layout K (R S C)
+  aligned_vector<int8_t> Bint8(OC * KDim);
+  randFill<int8_t>(Bint8, -128, 127);
+  aligned_vector<int8_t> Bint8_tr(Bint8.size());
+  transposeConvWeights(conv_p, Bint8.data(), Bint8_tr.data());
+
+  const int ncols_per_quant_group =
+      Q_GRAN == QuantizationGranularity::OUT_CHANNEL ? 1 : OC;
+  aligned_vector<int32_t> Bint8_zero_point(OC / ncols_per_quant_group);
+  randFill(Bint8_zero_point, b_symmetric ? 0 : -3, b_symmetric ? 0 : 3);
+
+  vector<int32_t> col_offsets(OC);
+  col_offsets_with_zero_pt_s8acc32_ref(
+      KDim,
+      OC,
+      OC,
+      Bint8_tr.data(),
+      Bint8_zero_point.data(),
+      col_offsets.data(),
+      ncols_per_quant_group);
+
+  aligned_vector<float> act_times_w_scale(Bint8_zero_point.size());
+  randFill(act_times_w_scale, 0.0001f, 0.0003f);
+  aligned_vector<float> C_multiplier(act_times_w_scale);
+  int32_t C_zero_pt = 120;
+
+  aligned_vector<int32_t> bias_int32(OC);
+  randFill(bias_int32, -8000, 8000);
+  aligned_vector<float> bias_fp32(OC);
+  for (int k = 0; k < OC; ++k) {
+    bias_fp32[k] =
+        bias_int32[k] * act_times_w_scale[k / ncols_per_quant_group];
+  }
+  const BIAS_TYPE* bias = nullptr;
+  if (is_same<BIAS_TYPE, float>::value) {
+    bias = reinterpret_cast<const BIAS_TYPE*>(bias_fp32.data());
+  } else {
+    bias = reinterpret_cast<const BIAS_TYPE*>(bias_int32.data());
+  }
+
+  // reference implementation
+  aligned_vector<int32_t> Cint32_ref(MDim * OC);
+  aligned_vector<uint8_t> Cint8_ref(Cint32_ref.size());
+  conv_ref(
+      conv_p,
+      Aint8.data(),
+      Aint8_zero_point,
+      Bint8_tr.data(),
+      Cint32_ref.data());
+  vector<uint8_t> Aint8_im2col(MDim * KDim);
+  im2col_ref(conv_p, Aint8.data(), Aint8_zero_point, Aint8_im2col.data());
+  vector<int32_t> row_offsets(MDim);
+  row_offsets_u8acc32_ref(
+      MDim, KDim, KDim, Aint8_im2col.data(), row_offsets.data());
+  requantize_u8acc32_ref(
+      MDim,
+      OC,
+      OC,
+      Cint32_ref.data(),
+      Cint8_ref.data(),
+      C_multiplier.data(),
+      C_zero_pt,
+      Aint8_zero_point,
+      Bint8_zero_point.data(),
+      row_offsets.data(),
+      col_offsets.data(),
+      bias_int32.data(),
+      ncols_per_quant_group);
+
+  ASSERT_EQ(ConvFastPath<2>(conv_p), optimized_conv_t::winograd);
+  PackWeightsForConv<2> packedWeights(conv_p, Bint8.data());
+
+  aligned_vector<int8_t> Bint8_unpacked(Bint8.size());
+  packedWeights.unpack(Bint8_unpacked.data());
+  ASSERT_EQ(Bint8_unpacked, Bint8) << "Original and unpacked data elements "
+                                   << "are not the same";
+
+  aligned_vector<int32_t> Cint32_fb(Cint32_ref.size());
+  aligned_vector<uint8_t> Cint8_fb(Cint32_ref.size());
+#ifdef _OPENMP
+#pragma omp parallel
+#endif
+  {
+    DoNothing<> doNothingObj{};
+    ReQuantizeOutput<false, Q_GRAN, BIAS_TYPE> reqObj(
+        doNothingObj,
+        C_multiplier.data(),
+        C_zero_pt,
+        Aint8_zero_point,
+        Bint8_zero_point.data(),
+        nullptr, /* row offset buffer */
+        col_offsets.data(),
+        bias,
+        OC,
+        1,
+        act_times_w_scale.data());
+
+    fbgemmConv(
+        conv_p,
+        Aint8.data(),
+        packedWeights,
+        Cint8_fb.data(),
+        Cint32_fb.data(),
+        reqObj,
+        fbgemm_get_thread_num(),
+        fbgemm_get_num_threads());
+  }
+
+  // Before requantization the result is exact.
+  compare_validate_buffers(
+      Cint32_ref.data(), Cint32_fb.data(), MDim, OC, OC, 0);
+  compare_validate_buffers(
+      Cint8_ref.data(), Cint8_fb.data(), MDim, OC, OC, static_cast<uint8_t>(0));
+}
+
+TEST_P(WinogradConvQGranTest, requantizeTest) {
+  if (!cpuinfo_initialize() || !fbgemmHasAvx2Support()) {
+    GTEST_SKIP() << "Winograd convolution needs AVX2";
+  }
+  // Winograd is only taken on AVX2 hosts
+  FbgemmIsaScope avx2_scope(inst_set_t::avx2);
+  QuantizationGranularity q_granularity;
+  bool a_symmetric, b_symmetric, float_bias;
+  tie(q_granularity, a_symmetric, b_symmetric, float_bias) = GetParam();
+
+  for (const auto& conv_p : shapes()) {
+    if (q_granularity == QuantizationGranularity::TENSOR) {
+      if (float_bias) {
+        runWinogradTest<QuantizationGranularity::TENSOR, float>(
+            conv_p, a_symmetric, b_symmetric);
+      } else {
+        runWinogradTest<QuantizationGranularity::TENSOR, int32_t>(
+            conv_p, a_symmetric, b_symmetric);
+      }
+    } else {
+      if (float_bias) {
+        runWinogradTest<QuantizationGranularity::OUT_CHANNEL, float>(
+            conv_p, a_symmetric, b_symmetric);
+      } else {
+        runWinogradTest<QuantizationGranularity::OUT_CHANNEL, int32_t>(
+            conv_p, a_symmetric, b_symmetric);
+      }
+    }
+  }
+}
+
+TEST(WinogradConvFastPathTest, onlyDense3x3Stride1) {
+  if (!cpuinfo_initialize() || !fbgemmHasAvx2Support()) {
+    GTEST_SKIP() << "Winograd convolution needs AVX2";
+  }
+  // Winograd is only taken on AVX2 hosts
+  FbgemmIsaScope avx2_scope(inst_set_t::avx2);
+  EXPECT_EQ(
+      ConvFastPath<2>(conv_param_t<2>(
+          1, 64, 64, {14, 14}, 1, {3, 3}, {1, 1}, {1, 1, 1, 1})),
+      optimized_conv_t::winograd);
+  // strided
+  EXPECT_NE(
+      ConvFastPath<2>(conv_param_t<2>(
+          1, 64, 64, {14, 14}, 1, {3, 3}, {2, 2}, {1, 1, 1, 1})),
+      optimized_conv_t::winograd);
+  // grouped
+  EXPECT_NE(
+      ConvFastPath<2>(conv_param_t<2>(
+          1, 64, 64, {14, 14}, 2, {3, 3}, {1, 1}, {1, 1, 1, 1})),
+      optimized_conv_t::winograd);
+  // dilated
+  EXPECT_NE(
+      ConvFastPath<2>(conv_param_t<2>(
+          1, 64, 64, {14, 14}, 1, {3, 3}, {1, 1}, {1, 1, 1, 1}, {2, 2})),
+      optimized_conv_t::winograd);
+  // 5x5
+  EXPECT_NE(
+      ConvFastPath<2>(conv_param_t<2>(
+          1, 64, 64, {14, 14}, 1, {5, 5}, {1, 1}, {2, 2, 2, 2})),
+      optimized_conv_t::winograd);
+  // too few channels
+  EXPECT_NE(
+      ConvFastPath<2>(conv_param_t<2>(
+          1, 8, 64, {14, 14}, 1, {3, 3}, {1, 1}, {1, 1, 1, 1})),
+      optimized_conv_t::winograd);
+}